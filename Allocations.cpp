@@ -0,0 +1,59 @@
+/*
+    Copyright (C) 2021-Present SKALE Labs
+
+    This file is part of sgxwallet.
+
+    sgxwallet is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as published
+    by the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    sgxwallet is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with sgxwallet. If not, see <https://www.gnu.org/licenses/>.
+
+    @file Allocations.cpp
+    @author Stan Kladko
+    @date 2021
+*/
+
+
+#include <cstdlib>
+#include <new>
+
+#include "Allocations.h"
+
+thread_local uint64_t Allocations::threadCount = 0;
+
+// operator new[] and the nothrow variants of libstdc++ call this one
+void *operator new(size_t _size) {
+    Allocations::threadCount++;
+
+    if (_size == 0) {
+        _size = 1;
+    }
+
+    while (true) {
+        auto p = malloc(_size);
+        if (p) {
+            return p;
+        }
+        auto handler = std::get_new_handler();
+        if (!handler) {
+            throw std::bad_alloc();
+        }
+        handler();
+    }
+}
+
+void operator delete(void *_p) noexcept {
+    free(_p);
+}
+
+void operator delete(void *_p, size_t) noexcept {
+    free(_p);
+}
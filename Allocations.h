@@ -0,0 +1,42 @@
+/*
+    Copyright (C) 2021-Present SKALE Labs
+
+    This file is part of sgxwallet.
+
+    sgxwallet is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as published
+    by the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    sgxwallet is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with sgxwallet. If not, see <https://www.gnu.org/licenses/>.
+
+    @file Allocations.h
+    @author Stan Kladko
+    @date 2021
+*/
+
+
+#ifndef SGXWALLET_ALLOCATIONS_H
+#define SGXWALLET_ALLOCATIONS_H
+
+#include <cstdint>
+
+// Counts the operator new calls of each thread. Allocations.cpp replaces the global operator new,
+// which still allocates with malloc, so a faster malloc linked in with ALLOCATOR_LIBS is used by
+// both. COUNT_STATISTICS adds the allocations of a method call to its MethodMetrics.
+class Allocations {
+
+public:
+
+    static thread_local uint64_t threadCount;
+
+    static uint64_t getThreadCount() { return threadCount; }
+};
+
+#endif //SGXWALLET_ALLOCATIONS_H
@@ -21,8 +21,13 @@
     @date 2019
 */
 
+#include <map>
 #include <memory>
+#include <mutex>
+#include <thread>
+#include <openssl/rand.h>
 #include "libff/algebra/curves/alt_bn128/alt_bn128_init.hpp"
+#include "libff/algebra/curves/alt_bn128/alt_bn128_pairing.hpp"
 #include "leveldb/db.h"
 #include <jsonrpccpp/server/connectors/httpserver.h>
 
@@ -37,6 +42,7 @@
 #include "SGXException.h"
 #include "third_party/spdlog/spdlog.h"
 #include "common.h"
+#include "Metrics.h"
 #include "SGXWalletServer.hpp"
 
 #include "SEKManager.h"
@@ -44,6 +50,8 @@
 #include "ServerInit.h"
 #include "BLSCrypto.h"
 #include "CryptoTools.h"
+#include "ScratchBuffer.h"
+#include "DKGCrypto.h"
 
 
 shared_ptr<string> FqToString(libff::alt_bn128_Fq *_fq) {
@@ -63,39 +71,127 @@ shared_ptr<string> FqToString(libff::alt_bn128_Fq *_fq) {
     return make_shared<string>(string(arr));
 }
 
-bool sign_aes(const char *_encryptedKeyHex, const char *_hashHex, size_t _t, size_t _n, char *_sig) {
+// Bls objects only hold the (t, n) parameters, so one instance per pair is shared by all threads
+static shared_ptr<libBLS::Bls> getBlsContext(size_t _t, size_t _n) {
+    static mutex contextsMutex;
+    static map<pair<size_t, size_t>, shared_ptr<libBLS::Bls>> contexts;
 
-    CHECK_STATE(_encryptedKeyHex);
-    CHECK_STATE(_hashHex);
-    CHECK_STATE(_sig);
+    lock_guard<mutex> lock(contextsMutex);
+
+    auto it = contexts.find({_t, _n});
+    if (it != contexts.end()) {
+        return it->second;
+    }
+
+    // (t, n) come from requests, so do not let the map grow without bound
+    if (contexts.size() >= BLS_CONTEXT_CACHE_MAX_ENTRIES) {
+        contexts.clear();
+    }
+
+    auto context = make_shared<libBLS::Bls>(_t, _n);
+    contexts[{_t, _n}] = context;
+    return context;
+}
+
+static pair<libff::alt_bn128_G1, string> hashToG1(const string &_hashHex, size_t _t, size_t _n) {
+    TRACE_SPAN("bls.hashToG1")
+    PERF_STAGE("hashToG1")
 
     auto hash = make_shared < array < uint8_t, 32 >> ();
 
     uint64_t binLen;
 
-    if (!hex2carray(_hashHex, &binLen, hash->data(), hash->size())) {
-        throw SGXException(SIGN_AES_INVALID_HASH, string(__FUNCTION__) +  ":Invalid hash");
+    if (!hex2carray(_hashHex.c_str(), &binLen, hash->data(), hash->size())) {
+        throw SGXException(SIGN_AES_INVALID_HASH, string(__FUNCTION__) + ":Invalid hash");
+    }
+
+    return getBlsContext(_t, _n)->HashtoG1withHint(hash);
+}
+
+// Hashing to G1 is pure host computation, so large batches are split across cores
+// before the single sign ECALL instead of being hashed one by one
+static void hashToG1Batch(const vector<tuple<uint32_t, string, size_t, size_t>> &_requests,
+                          vector<pair<libff::alt_bn128_G1, string>> &_hashes) {
+    _hashes.resize(_requests.size());
+
+    auto hashRange = [&](size_t _begin, size_t _end) {
+        for (size_t i = _begin; i < _end; i++) {
+            _hashes[i] = hashToG1(get<1>(_requests[i]), get<2>(_requests[i]), get<3>(_requests[i]));
+        }
+    };
+
+    size_t numThreads = min<size_t>(thread::hardware_concurrency(), _requests.size() / BLS_HASH_MIN_PARALLEL_BATCH);
+
+    if (numThreads <= 1) {
+        hashRange(0, _requests.size());
+        return;
     }
 
-    shared_ptr <libBLS::Bls> obj;
-    obj = make_shared<libBLS::Bls>(libBLS::Bls(_t, _n));
+    vector<thread> threads;
+    vector<exception_ptr> errors(numThreads);
+    size_t chunk = (_requests.size() + numThreads - 1) / numThreads;
+
+    for (size_t j = 0; j < numThreads; j++) {
+        threads.emplace_back([&, j]() {
+            try {
+                hashRange(j * chunk, min(_requests.size(), (j + 1) * chunk));
+            } catch (...) {
+                errors[j] = current_exception();
+            }
+        });
+    }
 
-    pair <libff::alt_bn128_G1, string> hash_with_hint = obj->HashtoG1withHint(hash);
+    for (auto &&t : threads) {
+        t.join();
+    }
 
-    shared_ptr<string> xStr = FqToString(&(hash_with_hint.first.X));
+    for (auto &&error : errors) {
+        if (error) {
+            rethrow_exception(error);
+        }
+    }
+}
 
-    CHECK_STATE(xStr);
+void g1ToLimbs(const libff::alt_bn128_G1 &_point, uint64_t *_limbs) {
+    CHECK_STATE(_limbs);
 
-    shared_ptr<string> yStr = FqToString(&(hash_with_hint.first.Y));
+    auto x = _point.X.as_bigint();
+    auto y = _point.Y.as_bigint();
 
-    CHECK_STATE(yStr);
+    for (int i = 0; i < BLS_FQ_LIMBS; i++) {
+        _limbs[i] = x.data[i];
+        _limbs[BLS_FQ_LIMBS + i] = y.data[i];
+    }
+}
 
-    vector<char> errMsg(BUF_LEN, 0);
+string limbsToG1String(const uint64_t *_limbs) {
+    CHECK_STATE(_limbs);
 
-    SAFE_CHAR_BUF(xStrArg, BUF_LEN);SAFE_CHAR_BUF(yStrArg, BUF_LEN);SAFE_CHAR_BUF(signature, BUF_LEN);
+    string result;
 
-    strncpy(xStrArg, xStr->c_str(), BUF_LEN);
-    strncpy(yStrArg, yStr->c_str(), BUF_LEN);
+    mpz_t t;
+    mpz_init(t);
+
+    for (int j = 0; j < 2; j++) {
+        mpz_import(t, BLS_FQ_LIMBS, -1, sizeof(uint64_t), 0, 0, _limbs + j * BLS_FQ_LIMBS);
+
+        SAFE_CHAR_BUF(arr, mpz_sizeinbase(t, 10) + 2);
+        mpz_get_str(arr, 10, t);
+
+        if (j > 0) {
+            result.append(":");
+        }
+        result.append(arr);
+    }
+
+    mpz_clear(t);
+
+    return result;
+}
+
+bool sign_aes(const char *_encryptedKeyHex, const char *_hashHex, size_t _t, size_t _n, char *_sig) {
+
+    CHECK_STATE(_encryptedKeyHex);
 
     size_t sz = 0;
 
@@ -107,25 +203,121 @@ bool sign_aes(const char *_encryptedKeyHex, const char *_hashHex, size_t _t, siz
         BOOST_THROW_EXCEPTION(invalid_argument("Invalid hex encrypted key"));
     }
 
+    return bls_sign_decoded(encryptedKey, sz, _hashHex, _t, _n, _sig);
+}
+
+static void signG1(const uint8_t *_encryptedKey, uint64_t _encLen, const libff::alt_bn128_G1 &_point,
+                   const string &_counter, char *_sig);
+
+bool bls_sign_decoded(const uint8_t *_encryptedKey, uint64_t _encLen, const char *_hashHex, size_t _t, size_t _n,
+                      char *_sig) {
+
+    CHECK_STATE(_encryptedKey);
+    CHECK_STATE(_hashHex);
+    CHECK_STATE(_sig);
+
+    pair <libff::alt_bn128_G1, string> hash_with_hint = hashToG1(_hashHex, _t, _n);
+
+    signG1(_encryptedKey, _encLen, hash_with_hint.first, hash_with_hint.second, _sig);
+
+    return true;
+}
+
+// signs a hashed point, _counter is the try and increment counter that ends the hint
+static void signG1(const uint8_t *_encryptedKey, uint64_t _encLen, const libff::alt_bn128_G1 &_point,
+                   const string &_counter, char *_sig) {
+    uint64_t hashLimbs[BLS_G1_LIMBS];
+    uint64_t signature[BLS_G1_LIMBS];
+
+    g1ToLimbs(_point, hashLimbs);
+
+    ScratchBuffer errMsg(ERR_STRING_LEN);
+
     int errStatus = 0;
 
     sgx_status_t status = SGX_SUCCESS;
 
-    status = trustedBlsSignMessage(eid, &errStatus, errMsg.data(), encryptedKey,
-                                      sz, xStrArg, yStrArg, signature);
+    status = ECALL(trustedBlsSignMessage, shardEid(_encryptedKey, _encLen), &errStatus, errMsg.data(),
+                   (uint8_t *) _encryptedKey, _encLen, hashLimbs, signature);
 
     HANDLE_TRUSTED_FUNCTION_ERROR(status, errStatus, errMsg.data());
 
-    string hint = libBLS::ThresholdUtils::fieldElementToString(hash_with_hint.first.Y) + ":" + hash_with_hint.second;
+    string hint = libBLS::ThresholdUtils::fieldElementToString(_point.Y) + ":" + _counter;
 
-    string sig = signature;
+    string sig = limbsToG1String(signature);
 
     sig.append(":");
     sig.append(hint);
 
     strncpy(_sig, sig.c_str(), BUF_LEN);
+}
 
-    return true;
+void bls_sign_batch(const vector<string> &_encryptedKeysHex,
+                    const vector<tuple<uint32_t, string, size_t, size_t>> &_requests, vector<string> &_sigs) {
+
+    CHECK_STATE(!_encryptedKeysHex.empty());
+    CHECK_STATE(!_requests.empty());
+    CHECK_STATE(_requests.size() <= MAX_BLS_SIGN_BATCH_SIZE);
+
+    uint64_t numKeys = _encryptedKeysHex.size();
+    uint64_t numHashes = _requests.size();
+
+    vector<uint8_t> encryptedKeys(numKeys * BLS_BATCH_KEY_SLOT_LEN, 0);
+    vector<uint64_t> encLens(numKeys, 0);
+
+    for (uint64_t i = 0; i < numKeys; i++) {
+        if (!hex2carray(_encryptedKeysHex[i].c_str(), &encLens[i], encryptedKeys.data() + i * BLS_BATCH_KEY_SLOT_LEN,
+                        BLS_BATCH_KEY_SLOT_LEN)) {
+            BOOST_THROW_EXCEPTION(invalid_argument("Invalid hex encrypted key"));
+        }
+    }
+
+    vector<uint32_t> keyIndexes(numHashes, 0);
+    vector<uint64_t> hashes(numHashes * BLS_G1_LIMBS, 0);
+    vector<string> hints(numHashes);
+
+    for (uint64_t i = 0; i < numHashes; i++) {
+        keyIndexes[i] = get<0>(_requests[i]);
+        CHECK_STATE(keyIndexes[i] < numKeys);
+    }
+
+    vector<pair<libff::alt_bn128_G1, string>> hashesWithHints;
+    hashToG1Batch(_requests, hashesWithHints);
+
+    for (uint64_t i = 0; i < numHashes; i++) {
+        auto &hash_with_hint = hashesWithHints[i];
+
+        g1ToLimbs(hash_with_hint.first, hashes.data() + i * BLS_G1_LIMBS);
+
+        hints[i] = libBLS::ThresholdUtils::fieldElementToString(hash_with_hint.first.Y) + ":" + hash_with_hint.second;
+    }
+
+    vector<uint64_t> signatures(numHashes * BLS_G1_LIMBS, 0);
+
+    ScratchBuffer errMsg(ERR_STRING_LEN);
+
+    int errStatus = 0;
+
+    sgx_status_t status = SGX_SUCCESS;
+
+    // a batch is served by one instance, chosen by its first key
+    status = ECALL(trustedBlsSignMessageBatch, shardEid(encryptedKeys.data(), encLens[0]), &errStatus, errMsg.data(),
+                                               numKeys, encryptedKeys.data(),
+                                               encryptedKeys.size(), encLens.data(), numHashes, keyIndexes.data(),
+                                               hashes.data(), hashes.size(),
+                                               signatures.data(), signatures.size());
+
+    HANDLE_TRUSTED_FUNCTION_ERROR(status, errStatus, errMsg.data());
+
+    _sigs.clear();
+    _sigs.reserve(numHashes);
+
+    for (uint64_t i = 0; i < numHashes; i++) {
+        string sig = limbsToG1String(signatures.data() + i * BLS_G1_LIMBS);
+        sig.append(":");
+        sig.append(hints[i]);
+        _sigs.push_back(sig);
+    }
 }
 
 bool bls_sign(const char *_encryptedKeyHex, const char *_hashHex, size_t _t, size_t _n, char *_sig) {
@@ -134,9 +326,52 @@ bool bls_sign(const char *_encryptedKeyHex, const char *_hashHex, size_t _t, siz
     return sign_aes(_encryptedKeyHex, _hashHex, _t, _n, _sig);
 }
 
+// A PoP is a deterministic signature of the public key hash, so after the first request
+// for a key it is served from memory without ECALLs
+static mutex popProvesMutex;
+static map<string, string> popProves;
+
+static void cachePopProve(const string &_encryptedKeyHex, const string &_prove) {
+    if (popProves.size() >= BLS_PUBKEY_CACHE_MAX_ENTRIES) {
+        popProves.clear();
+    }
+
+    popProves[_encryptedKeyHex] = _prove;
+}
+
+// the hash of a "x0:x1:y0:y1" public key that its PoP signs, with the hint of the PoP
+static pair<libff::alt_bn128_G1, string> hashPublicKeyForPoP(const vector<string> &_pubKeyVect) {
+    CHECK_STATE(_pubKeyVect.size() == 4);
+
+    libff::alt_bn128_G2 publicKey;
+    publicKey.Z = libff::alt_bn128_Fq2::one();
+    publicKey.X.c0 = libff::alt_bn128_Fq(_pubKeyVect[0].c_str());
+    publicKey.X.c1 = libff::alt_bn128_Fq(_pubKeyVect[1].c_str());
+    publicKey.Y.c0 = libff::alt_bn128_Fq(_pubKeyVect[2].c_str());
+    publicKey.Y.c1 = libff::alt_bn128_Fq(_pubKeyVect[3].c_str());
+
+    pair <libff::alt_bn128_G1, string> hashPublicKeyWithHint = libBLS::Bls::HashPublicKeyToG1WithHint( publicKey );
+
+    hashPublicKeyWithHint.first.to_affine_coordinates();
+
+    string hint = libBLS::ThresholdUtils::fieldElementToString(hashPublicKeyWithHint.first.Y) + ":" +
+                  hashPublicKeyWithHint.second;
+
+    return {hashPublicKeyWithHint.first, hint};
+}
+
 bool popProveSGX( const char* encryptedKeyHex, char* prove ) {
     CHECK_STATE(encryptedKeyHex);
 
+    {
+        lock_guard<mutex> lock(popProvesMutex);
+        auto it = popProves.find(encryptedKeyHex);
+        if (it != popProves.end()) {
+            strncpy(prove, it->second.c_str(), BUF_LEN);
+            return true;
+        }
+    }
+
     SAFE_UINT8_BUF(encryptedKey, BUF_LEN);
 
     size_t sz = 0;
@@ -147,68 +382,114 @@ bool popProveSGX( const char* encryptedKeyHex, char* prove ) {
 
     sgx_status_t status = SGX_SUCCESS;
 
-    vector<char> errMsg(BUF_LEN, 0);
+    ScratchBuffer errMsg(BUF_LEN);
 
     int errStatus = 0;
 
-    SAFE_CHAR_BUF(pubKey, 320)
+    auto hashWithHint = hashPublicKeyForPoP(getBLSPubKey(encryptedKeyHex));
 
-    status = trustedGetBlsPubKey(eid, &errStatus, errMsg.data(), encryptedKey, sz, pubKey);
+    uint64_t hashLimbs[BLS_G1_LIMBS];
+    uint64_t signature[BLS_G1_LIMBS];
+
+    g1ToLimbs(hashWithHint.first, hashLimbs);
+
+    status = ECALL(trustedBlsSignMessage, shardEid(encryptedKey, sz), &errStatus, errMsg.data(), encryptedKey, sz,
+                   hashLimbs, signature);
 
     HANDLE_TRUSTED_FUNCTION_ERROR(status, errStatus, errMsg.data());
 
-    vector <string> pubKeyVect = splitString(pubKey, ':');
+    string _prove = limbsToG1String(signature);
+
+    _prove.append(":");
+    _prove.append(hashWithHint.second);
 
-    spdlog::debug("pub key is ");
-    for (int i = 0; i < 4; i++)
-        spdlog::debug("{}", pubKeyVect.at(i));
+    strncpy(prove, _prove.c_str(), BUF_LEN);
 
-    libff::alt_bn128_G2 publicKey;
-    publicKey.Z = libff::alt_bn128_Fq2::one();
-    publicKey.X.c0 = libff::alt_bn128_Fq(pubKeyVect[0].c_str());
-    publicKey.X.c1 = libff::alt_bn128_Fq(pubKeyVect[1].c_str());
-    publicKey.Y.c0 = libff::alt_bn128_Fq(pubKeyVect[2].c_str());
-    publicKey.Y.c1 = libff::alt_bn128_Fq(pubKeyVect[3].c_str());
+    lock_guard<mutex> lock(popProvesMutex);
 
-    pair <libff::alt_bn128_G1, string> hashPublicKeyWithHint = libBLS::Bls::HashPublicKeyToG1WithHint( publicKey );
+    cachePopProve(encryptedKeyHex, _prove);
 
-    hashPublicKeyWithHint.first.to_affine_coordinates();
+    return true;
+}
+
+vector<string> popProveBatchSGX(const vector<string> &_encryptedKeysHex, const vector<string> &_pubKeys) {
+    CHECK_STATE(!_encryptedKeysHex.empty() && _encryptedKeysHex.size() <= MAX_BLS_KEY_BATCH_SIZE);
+    CHECK_STATE(_pubKeys.size() == _encryptedKeysHex.size());
+
+    vector<string> proves(_encryptedKeysHex.size());
+    vector<uint64_t> misses;
+
+    {
+        lock_guard<mutex> lock(popProvesMutex);
+        for (uint64_t i = 0; i < _encryptedKeysHex.size(); i++) {
+            auto it = popProves.find(_encryptedKeysHex[i]);
+            if (it != popProves.end()) {
+                proves[i] = it->second;
+            } else {
+                misses.push_back(i);
+            }
+        }
+    }
 
-    shared_ptr<string> xStr = FqToString(&(hashPublicKeyWithHint.first.X));
+    if (misses.empty()) {
+        return proves;
+    }
 
-    CHECK_STATE(xStr);
+    uint64_t numKeys = misses.size();
 
-    shared_ptr<string> yStr = FqToString(&(hashPublicKeyWithHint.first.Y));
+    vector<uint8_t> encryptedKeys(numKeys * BLS_BATCH_KEY_SLOT_LEN, 0);
+    vector<uint64_t> encLens(numKeys, 0);
+    vector<uint32_t> keyIndexes(numKeys, 0);
+    vector<uint64_t> hashes(numKeys * BLS_G1_LIMBS, 0);
+    vector<string> hints(numKeys);
 
-    CHECK_STATE(yStr);
+    for (uint64_t k = 0; k < numKeys; k++) {
+        auto i = misses[k];
 
-    SAFE_CHAR_BUF(xStrArg, BUF_LEN);SAFE_CHAR_BUF(yStrArg, BUF_LEN);
+        if (!hex2carray(_encryptedKeysHex[i].c_str(), &encLens[k], encryptedKeys.data() + k * BLS_BATCH_KEY_SLOT_LEN,
+                        BLS_BATCH_KEY_SLOT_LEN)) {
+            BOOST_THROW_EXCEPTION(invalid_argument("Invalid hex encrypted key"));
+        }
 
-    strncpy(xStrArg, xStr->c_str(), BUF_LEN);
-    strncpy(yStrArg, yStr->c_str(), BUF_LEN);
+        keyIndexes[k] = k;
 
-    errStatus = 0;
+        auto hashWithHint = hashPublicKeyForPoP(splitString(_pubKeys[i].c_str(), ':'));
+        g1ToLimbs(hashWithHint.first, hashes.data() + k * BLS_G1_LIMBS);
+        hints[k] = hashWithHint.second;
+    }
 
-    status = trustedBlsSignMessage(eid, &errStatus, errMsg.data(), encryptedKey, sz, xStrArg, yStrArg, prove);
+    vector<uint64_t> signatures(numKeys * BLS_G1_LIMBS, 0);
 
-    HANDLE_TRUSTED_FUNCTION_ERROR(status, errStatus, errMsg.data());
+    ScratchBuffer errMsg(ERR_STRING_LEN);
 
-    string hint = libBLS::ThresholdUtils::fieldElementToString(hashPublicKeyWithHint.first.Y) + ":" + hashPublicKeyWithHint.second;
+    int errStatus = 0;
 
-    string _prove = prove;
+    sgx_status_t status = SGX_SUCCESS;
 
-    _prove.append(":");
-    _prove.append(hint);
+    // all PoPs are signed by the batch sign ECALL, one hash per key
+    status = ECALL(trustedBlsSignMessageBatch, shardEid(encryptedKeys.data(), encLens[0]), &errStatus, errMsg.data(),
+                                               numKeys, encryptedKeys.data(),
+                                               encryptedKeys.size(), encLens.data(), numKeys, keyIndexes.data(),
+                                               hashes.data(), hashes.size(),
+                                               signatures.data(), signatures.size());
 
-    strncpy(prove, _prove.c_str(), BUF_LEN);
+    HANDLE_TRUSTED_FUNCTION_ERROR(status, errStatus, errMsg.data());
 
-    return true;
+    lock_guard<mutex> lock(popProvesMutex);
+
+    for (uint64_t k = 0; k < numKeys; k++) {
+        auto i = misses[k];
+        proves[i] = limbsToG1String(signatures.data() + k * BLS_G1_LIMBS) + ":" + hints[k];
+        cachePopProve(_encryptedKeysHex[i], proves[i]);
+    }
+
+    return proves;
 }
 
 bool generateBLSPrivateKeyAggegated(const char* blsKeyName) {
     CHECK_STATE(blsKeyName);
 
-    vector<char> errMsg(BUF_LEN, 0);
+    ScratchBuffer errMsg(BUF_LEN);
     int errStatus = 0;
 
     int exportable = 0;
@@ -219,17 +500,53 @@ bool generateBLSPrivateKeyAggegated(const char* blsKeyName) {
 
     SAFE_UINT8_BUF(encrBlsKey, BUF_LEN)
 
-    status = trustedGenerateBLSKey(eid, &errStatus, errMsg.data(), &exportable, encrBlsKey, &encBlsLen);
+    status = ECALL(trustedGenerateBLSKey, eid, &errStatus, errMsg.data(), &exportable, encrBlsKey, &encBlsLen);
 
     HANDLE_TRUSTED_FUNCTION_ERROR(status, errStatus, errMsg.data());
 
     vector<char> hexBLSKey = carray2Hex(encrBlsKey, encBlsLen);
 
-    SGXWalletServer::writeDataToDB(blsKeyName, hexBLSKey.data());
+    SGXWalletServer::writeBatchToDB({{blsKeyName, hexBLSKey.data()},
+                                     {SGXWalletServer::getBLSPubKeyName(blsKeyName),
+                                      getBLSPubKeyString(hexBLSKey.data())}});
 
     return true;
 }
 
+void generateBLSPrivateKeysAggregatedBatch(const vector<string> &_blsKeyNames) {
+    uint64_t numKeys = _blsKeyNames.size();
+
+    CHECK_STATE(numKeys > 0 && numKeys <= MAX_BLS_KEY_BATCH_SIZE);
+
+    ScratchBuffer errMsg(BUF_LEN);
+    int errStatus = 0;
+
+    vector<uint8_t> encryptedKeys(numKeys * BLS_BATCH_KEY_SLOT_LEN, 0);
+    vector<uint64_t> encLens(numKeys, 0);
+    vector<char> pubKeys(numKeys * BLS_KEY_BATCH_PUB_KEY_SLOT_LEN, 0);
+
+    sgx_status_t status = SGX_SUCCESS;
+
+    status = ECALL(trustedGenerateBLSKeyBatch, eid, &errStatus, errMsg.data(), numKeys, encryptedKeys.data(),
+                   encryptedKeys.size(), encLens.data(), pubKeys.data(), pubKeys.size());
+
+    HANDLE_TRUSTED_FUNCTION_ERROR(status, errStatus, errMsg.data());
+
+    vector<pair<string, string>> keyValues;
+    keyValues.reserve(2 * numKeys);
+
+    for (uint64_t i = 0; i < numKeys; i++) {
+        CHECK_STATE(encLens[i] > 0 && encLens[i] <= BLS_BATCH_KEY_SLOT_LEN);
+        auto hexBLSKey = carray2Hex(encryptedKeys.data() + i * BLS_BATCH_KEY_SLOT_LEN, encLens[i]);
+        keyValues.emplace_back(_blsKeyNames[i], hexBLSKey.data());
+        keyValues.emplace_back(SGXWalletServer::getBLSPubKeyName(_blsKeyNames[i]),
+                               string(pubKeys.data() + i * BLS_KEY_BATCH_PUB_KEY_SLOT_LEN));
+    }
+
+    // all keys of the batch are stored or none is
+    SGXWalletServer::writeBatchToDB(keyValues);
+}
+
 string encryptBLSKeyShare2Hex(int *errStatus, char *err_string, const char *_key) {
     CHECK_STATE(errStatus);
     CHECK_STATE(err_string);
@@ -237,7 +554,7 @@ string encryptBLSKeyShare2Hex(int *errStatus, char *err_string, const char *_key
     auto keyArray = make_shared < vector < char >> (BUF_LEN, 0);
     auto encryptedKey = make_shared < vector < uint8_t >> (BUF_LEN, 0);
 
-    vector<char> errMsg(BUF_LEN, 0);
+    ScratchBuffer errMsg(BUF_LEN);
 
     strncpy(keyArray->data(), _key, BUF_LEN);
     *errStatus = 0;
@@ -246,8 +563,8 @@ string encryptBLSKeyShare2Hex(int *errStatus, char *err_string, const char *_key
 
     sgx_status_t status = SGX_SUCCESS;
 
-    status = trustedEncryptKey(eid, errStatus, errMsg.data(), keyArray->data(), encryptedKey->data(),
-                               &encryptedLen);
+    status = ECALL(trustedEncryptKey, eid, errStatus, errMsg.data(), keyArray->data(), encryptedKey->data(),
+                                      &encryptedLen);
 
     HANDLE_TRUSTED_FUNCTION_ERROR(status, *errStatus, errMsg.data());
 
@@ -255,3 +572,182 @@ string encryptBLSKeyShare2Hex(int *errStatus, char *err_string, const char *_key
 
     return string(resultBuf.begin(), resultBuf.end());
 }
+
+vector<string> encryptBLSKeySharesBatch(const vector<string>& _keys, vector<int>& _statuses) {
+    uint64_t numKeys = _keys.size();
+
+    CHECK_STATE(numKeys > 0 && numKeys <= MAX_KEY_IMPORT_BATCH_SIZE);
+
+    vector<char> keys(numKeys * MAX_KEY_LENGTH, 0);
+    for (uint64_t i = 0; i < numKeys; i++) {
+        CHECK_STATE(_keys[i].size() < MAX_KEY_LENGTH);
+        memcpy(keys.data() + i * MAX_KEY_LENGTH, _keys[i].data(), _keys[i].size());
+    }
+
+    vector<uint8_t> encryptedKeys(numKeys * KEY_IMPORT_ENC_KEY_SLOT_LEN, 0);
+    vector<uint64_t> encLens(numKeys, 0);
+    _statuses.assign(numKeys, 0);
+
+    ScratchBuffer errMsg(ERR_STRING_LEN);
+    int errStatus = 0;
+
+    sgx_status_t status = SGX_SUCCESS;
+
+    status = ECALL(trustedEncryptKeysBatch, eid, &errStatus, errMsg.data(), numKeys, keys.data(), keys.size(),
+                   encryptedKeys.data(), encryptedKeys.size(), encLens.data(), _statuses.data(), 0, nullptr, 0);
+
+    memset(keys.data(), 0, keys.size());
+
+    HANDLE_TRUSTED_FUNCTION_ERROR(status, errStatus, errMsg.data());
+
+    vector<string> result(numKeys);
+    for (uint64_t i = 0; i < numKeys; i++) {
+        if (_statuses[i] == 0) {
+            auto hex = carray2Hex(encryptedKeys.data() + i * KEY_IMPORT_ENC_KEY_SLOT_LEN, encLens[i]);
+            result[i] = string(hex.begin(), hex.end());
+        }
+    }
+
+    return result;
+}
+
+// the "X:Y" part of a signature, the hint that follows it is not needed to verify
+static bool parseG1Signature(const string &_sig, libff::alt_bn128_G1 &_point) {
+    auto parts = splitString(_sig.c_str(), ':');
+    if (parts.size() < 2) {
+        return false;
+    }
+
+    _point.Z = libff::alt_bn128_Fq::one();
+    return decToFq(parts[0], _point.X) && decToFq(parts[1], _point.Y) && _point.is_well_formed();
+}
+
+bool bls_sign_hashed_point(const char *_encryptedKeyHex, const string &_hashedPoint, const string &_counter,
+                          char *_sig) {
+    CHECK_STATE(_encryptedKeyHex);
+    CHECK_STATE(_sig);
+
+    // G1 has cofactor 1, so every point on the curve is in G1
+    libff::alt_bn128_G1 point;
+    if (splitString(_hashedPoint.c_str(), ':').size() != 2 || !parseG1Signature(_hashedPoint, point)) {
+        throw SGXException(INVALID_BLS_HASHED_POINT, string(__FUNCTION__) + ":Hashed point is not a G1 point");
+    }
+
+    if (_counter.empty() || _counter.size() > BLS_HINT_COUNTER_MAX_DIGITS ||
+        _counter.find_first_not_of("0123456789") != string::npos) {
+        throw SGXException(INVALID_BLS_HASHED_POINT, string(__FUNCTION__) + ":Invalid hint");
+    }
+
+    size_t sz = 0;
+
+    SAFE_UINT8_BUF(encryptedKey, BUF_LEN);
+
+    if (!hex2carray(_encryptedKeyHex, &sz, encryptedKey, BUF_LEN)) {
+        BOOST_THROW_EXCEPTION(invalid_argument("Invalid hex encrypted key"));
+    }
+
+    signG1(encryptedKey, sz, point, _counter, _sig);
+
+    return true;
+}
+
+// G2 has a cofactor, so a public key also has to be in the order r subgroup
+static bool parseG2PublicKey(const vector<string> &_key, libff::alt_bn128_G2 &_point) {
+    if (_key.size() != 4 || !decToFq(_key[0], _point.X.c0) || !decToFq(_key[1], _point.X.c1) ||
+        !decToFq(_key[2], _point.Y.c0) || !decToFq(_key[3], _point.Y.c1)) {
+        return false;
+    }
+
+    _point.Z = libff::alt_bn128_Fq2::one();
+    return _point.is_well_formed() && (libff::alt_bn128_modulus_r * _point).is_zero();
+}
+
+// prod_i e(P_i, Q_i) == 1 with one Miller loop per pair and a single final exponentiation
+static bool pairingProductIsOne(const vector<libff::alt_bn128_G1> &_ps, const vector<libff::alt_bn128_G2> &_qs) {
+    vector<libff::alt_bn128_Fq12> loops(_ps.size(), libff::alt_bn128_Fq12::one());
+
+    parallelFor(_ps.size(), [&](size_t i) {
+        if (!_ps[i].is_zero() && !_qs[i].is_zero()) {
+            loops[i] = libff::alt_bn128_ate_miller_loop(libff::alt_bn128_ate_precompute_G1(_ps[i]),
+                                                        libff::alt_bn128_ate_precompute_G2(_qs[i]));
+        }
+    }, BLS_VERIFY_MIN_PARALLEL_BATCH);
+
+    auto product = libff::alt_bn128_Fq12::one();
+    for (auto &&loop : loops) {
+        product = product * loop;
+    }
+
+    return libff::alt_bn128_final_exponentiation(product) == libff::alt_bn128_GT::one();
+}
+
+// e(sig_i, G2) == e(H_i, pk_i) for all i is checked as
+// e(sum_i r_i sig_i, G2) * prod_pk e(-sum_{i with pk} r_i H_i, pk) == 1 with random 128 bit r_i,
+// so k signatures cost the Miller loops of at most k + 1 pairs and one final exponentiation.
+// If the combined check fails, each signature is checked on its own to find the bad ones
+vector<bool> bls_verify_batch(const vector<vector<string>> &_publicKeys, const vector<string> &_hashesHex,
+                              const vector<string> &_signatures) {
+    uint64_t count = _signatures.size();
+
+    CHECK_STATE(count > 0 && count <= MAX_BLS_VERIFY_BATCH_SIZE);
+    CHECK_STATE(_publicKeys.size() == count && _hashesHex.size() == count);
+
+    // signatures under the same key share one pair
+    map<vector<string>, size_t> keyIndices;
+    vector<libff::alt_bn128_G2> keys;
+    vector<size_t> keyOf(count);
+    vector<libff::alt_bn128_G1> sigs(count);
+
+    for (uint64_t i = 0; i < count; i++) {
+        if (!parseG1Signature(_signatures[i], sigs[i])) {
+            throw SGXException(INVALID_BLS_VERIFY_BATCH, string(__FUNCTION__) + ":Signature is not a G1 point");
+        }
+
+        auto it = keyIndices.find(_publicKeys[i]);
+        if (it == keyIndices.end()) {
+            libff::alt_bn128_G2 key;
+            if (!parseG2PublicKey(_publicKeys[i], key)) {
+                throw SGXException(INVALID_BLS_VERIFY_BATCH, string(__FUNCTION__) + ":Public key is not a G2 point");
+            }
+            it = keyIndices.emplace(_publicKeys[i], keys.size()).first;
+            keys.push_back(key);
+        }
+        keyOf[i] = it->second;
+    }
+
+    vector<libff::alt_bn128_G1> hashes(count);
+    vector<libff::alt_bn128_G1> weightedSigs(count);
+    vector<libff::alt_bn128_G1> weightedHashes(count);
+
+    vector<libff::bigint<2>> weights(count);
+    for (auto &&weight : weights) {
+        CHECK_STATE(RAND_bytes((uint8_t *) weight.data, sizeof(weight.data)) == 1);
+    }
+
+    parallelFor(count, [&](size_t i) {
+        hashes[i] = hashToG1(_hashesHex[i], 1, 1).first;
+        weightedSigs[i] = weights[i] * sigs[i];
+        weightedHashes[i] = weights[i] * hashes[i];
+    }, BLS_VERIFY_MIN_PARALLEL_BATCH);
+
+    vector<libff::alt_bn128_G1> ps(keys.size() + 1, libff::alt_bn128_G1::zero());
+    vector<libff::alt_bn128_G2> qs(keys.begin(), keys.end());
+    qs.push_back(libff::alt_bn128_G2::one());
+
+    for (uint64_t i = 0; i < count; i++) {
+        ps[keyOf[i]] = ps[keyOf[i]] - weightedHashes[i];
+        ps[keys.size()] = ps[keys.size()] + weightedSigs[i];
+    }
+
+    if (pairingProductIsOne(ps, qs)) {
+        return vector<bool>(count, true);
+    }
+
+    vector<uint8_t> valid(count, 0);
+
+    parallelFor(count, [&](size_t i) {
+        valid[i] = pairingProductIsOne({sigs[i], -hashes[i]}, {libff::alt_bn128_G2::one(), keys[keyOf[i]]});
+    });
+
+    return vector<bool>(valid.begin(), valid.end());
+}
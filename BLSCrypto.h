@@ -34,18 +34,59 @@
 #include "stdint.h"
 #include <memory>
 #include <string>
+#include <tuple>
 #include <vector>
 
 #include "bls.h"
 
 EXTERNC bool bls_sign(const char* encryptedKeyHex, const char* hashHex, size_t t, size_t n, char* _sig);
 
+// bls_sign of an already decoded encrypted key, used for key handles
+bool bls_sign_decoded(const uint8_t* _encryptedKey, uint64_t _encLen, const char* _hashHex, size_t _t, size_t _n,
+                      char* _sig);
+
+// signs a G1 point the client hashed itself, "X:Y" in decimal, with _counter the try and increment
+// counter of the hint. The signature equals the bls_sign one when the point is the hash of the message
+bool bls_sign_hashed_point(const char* _encryptedKeyHex, const std::string& _hashedPoint, const std::string& _counter,
+                          char* _sig);
+
+// signs many hashes in one ECALL. Each request is (index in _encryptedKeysHex, hash hex, t, n),
+// each key is decrypted in the enclave only once
+void bls_sign_batch(const std::vector<std::string>& _encryptedKeysHex,
+                    const std::vector<std::tuple<uint32_t, std::string, size_t, size_t>>& _requests,
+                    std::vector<std::string>& _sigs);
+
 EXTERNC bool popProveSGX( const char* encryptedKeyHex, char* _prove );
 
+// the PoPs of up to MAX_BLS_KEY_BATCH_SIZE keys, signed in one ECALL. _pubKeys are the public keys
+// of the keys as "x0:x1:y0:y1", as they are stored next to the keys
+std::vector<std::string> popProveBatchSGX(const std::vector<std::string>& _encryptedKeysHex,
+                                          const std::vector<std::string>& _pubKeys);
+
 EXTERNC bool generateBLSPrivateKeyAggegated(const char* blsKeyName);
 
+// generates up to MAX_BLS_KEY_BATCH_SIZE keys and their public keys in one ECALL, and stores
+// them in one database write
+void generateBLSPrivateKeysAggregatedBatch(const std::vector<std::string>& _blsKeyNames);
+
 std::shared_ptr<std::string> FqToString(libff::alt_bn128_Fq *_fq);
 
+// affine G1 points cross the enclave boundary as BLS_G1_LIMBS binary limbs, _limbs has to hold that many
+void g1ToLimbs(const libff::alt_bn128_G1 &_point, uint64_t *_limbs);
+
+// formats BLS_G1_LIMBS limbs as the decimal "X:Y" used in signatures
+std::string limbsToG1String(const uint64_t *_limbs);
+
+// checks signature i of hash i against public key i, the four decimal G2 coordinates of the
+// key. All checks share one final exponentiation, see bls_verify_batch in BLSCrypto.cpp
+std::vector<bool> bls_verify_batch(const std::vector<std::vector<std::string>>& _publicKeys,
+                                   const std::vector<std::string>& _hashesHex,
+                                   const std::vector<std::string>& _signatures);
+
 std::string encryptBLSKeyShare2Hex(int *errStatus, char *err_string, const char *_key);
 
+// encrypts up to MAX_KEY_IMPORT_BATCH_SIZE key shares in one ECALL. A key that could not be
+// encrypted gets an empty result and a non zero status
+std::vector<std::string> encryptBLSKeySharesBatch(const std::vector<std::string>& _keys, std::vector<int>& _statuses);
+
 #endif //SGXWALLET_BLSCRYPTO_H
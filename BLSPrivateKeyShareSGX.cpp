@@ -27,6 +27,7 @@
 
 #include "third_party/spdlog/spdlog.h"
 #include "common.h"
+#include "Metrics.h"
 #include "secure_enclave_u.h"
 #include "sgxwallet_common.h"
 #include "sgxwallet.h"
@@ -89,20 +90,12 @@ string BLSPrivateKeyShareSGX::signWithHelperSGXstr(
 
     int errStatus = 0;
 
-    shared_ptr<string> xStr = FqToString(&(hash_with_hint.first.X));
+    uint64_t hashLimbs[BLS_G1_LIMBS];
+    uint64_t signature[BLS_G1_LIMBS];
 
-    CHECK_STATE(xStr);
+    g1ToLimbs(hash_with_hint.first, hashLimbs);
 
-    shared_ptr<string> yStr = FqToString(&(hash_with_hint.first.Y));
-
-    CHECK_STATE(yStr);
-
-    vector<char> errMsg(BUF_LEN, 0);
-
-    SAFE_CHAR_BUF(xStrArg, BUF_LEN)SAFE_CHAR_BUF(yStrArg, BUF_LEN)SAFE_CHAR_BUF(signature, BUF_LEN);
-
-    strncpy(xStrArg, xStr->c_str(), BUF_LEN);
-    strncpy(yStrArg, yStr->c_str(), BUF_LEN);
+    vector<char> errMsg(ERR_STRING_LEN, 0);
 
     size_t sz = 0;
 
@@ -118,22 +111,15 @@ string BLSPrivateKeyShareSGX::signWithHelperSGXstr(
 
     sgx_status_t status = SGX_SUCCESS;
 
-    status = trustedBlsSignMessage(eid, &errStatus, errMsg.data(), encryptedKey,
-                                      encryptedKeyHex->size() / 2, xStrArg, yStrArg, signature);
+    status = ECALL(trustedBlsSignMessage, shardEid(encryptedKey, sz), &errStatus, errMsg.data(), encryptedKey,
+                                             encryptedKeyHex->size() / 2, hashLimbs, signature);
 
     HANDLE_TRUSTED_FUNCTION_ERROR(status, errStatus, errMsg.data());
 
-
-    int sigLen;
-
-    if ((sigLen = strnlen(signature, 10)) < 10) {
-        BOOST_THROW_EXCEPTION(runtime_error("Signature is too short:" + to_string(sigLen)));
-    }
-
     string hint = libBLS::ThresholdUtils::fieldElementToString(hash_with_hint.first.Y) + ":" +
                   hash_with_hint.second;
 
-    string sig = signature;
+    string sig = limbsToG1String(signature);
 
     sig.append(":");
     sig.append(hint);
@@ -0,0 +1,103 @@
+/*
+    Copyright (C) 2021-Present SKALE Labs
+
+    This file is part of sgxwallet.
+
+    sgxwallet is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as published
+    by the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    sgxwallet is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with sgxwallet. If not, see <https://www.gnu.org/licenses/>.
+
+    @file Bulkhead.cpp
+    @author Stan Kladko
+    @date 2021
+*/
+
+#include <chrono>
+
+#include "sgxwallet_common.h"
+#include "SGXException.h"
+#include "third_party/spdlog/spdlog.h"
+
+#include "Bulkhead.h"
+
+Bulkhead::Slots Bulkhead::slots[Bulkhead::NUM_CLASSES] = {{BULKHEAD_DKG_LIMIT}, {BULKHEAD_TE_LIMIT},
+                                                        {BULKHEAD_ADMIN_LIMIT}};
+
+thread_local bool Bulkhead::holding = false;
+
+Bulkhead::Guard::Guard(Class _class) : methodClass(_class), held(false) {
+    if (holding) {
+        return;
+    }
+
+    auto &s = slots[methodClass];
+    unique_lock<mutex> lock(s.m);
+
+    auto hasSlot = [&s]() {
+        auto limit = s.limit.load();
+        return limit == 0 || s.inUse < limit;
+    };
+
+    if (!s.freed.wait_for(lock, chrono::milliseconds(BULKHEAD_MAX_WAIT_MS), hasSlot)) {
+        s.rejected++;
+        throw SGXException(BULKHEAD_FULL, string("Too many concurrent ") + getName(methodClass) +
+                                          " calls, try again later");
+    }
+
+    s.inUse++;
+    held = true;
+    holding = true;
+}
+
+Bulkhead::Guard::~Guard() {
+    if (!held) {
+        return;
+    }
+
+    auto &s = slots[methodClass];
+    {
+        lock_guard<mutex> lock(s.m);
+        s.inUse--;
+    }
+    s.freed.notify_one();
+    holding = false;
+}
+
+void Bulkhead::setLimits(uint64_t _dkg, uint64_t _te, uint64_t _admin) {
+    slots[DKG].limit = _dkg;
+    slots[TE].limit = _te;
+    slots[ADMIN].limit = _admin;
+
+    for (auto &&s : slots) {
+        s.freed.notify_all();
+    }
+
+    spdlog::info("Concurrent call limits set to dkg {}, te {}, admin {}", _dkg, _te, _admin);
+}
+
+uint64_t Bulkhead::getLimit(Class _class) {
+    return slots[_class].limit;
+}
+
+uint64_t Bulkhead::getInUse(Class _class) {
+    lock_guard<mutex> lock(slots[_class].m);
+    return slots[_class].inUse;
+}
+
+uint64_t Bulkhead::getRejected(Class _class) {
+    return slots[_class].rejected;
+}
+
+const char *Bulkhead::getName(Class _class) {
+    static const char *names[NUM_CLASSES] = {"dkg", "te", "admin"};
+    return names[_class];
+}
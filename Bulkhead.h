@@ -0,0 +1,94 @@
+/*
+    Copyright (C) 2021-Present SKALE Labs
+
+    This file is part of sgxwallet.
+
+    sgxwallet is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as published
+    by the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    sgxwallet is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with sgxwallet. If not, see <https://www.gnu.org/licenses/>.
+
+    @file Bulkhead.h
+    @author Stan Kladko
+    @date 2021
+*/
+
+#ifndef SGXWALLET_BULKHEAD_H
+#define SGXWALLET_BULKHEAD_H
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+
+using namespace std;
+
+// Concurrency limits for the slow method classes, shared by the ZMQ and HTTP servers.
+// A DKG, TE or key management call takes a slot of its class before it enters the enclave
+// and waits up to BULKHEAD_MAX_WAIT_MS for one, then fails with BULKHEAD_FULL. Sign calls
+// take no slot, so a burst of DKG calls during rotation leaves the remaining workers and
+// TCS to signing. A call made by a thread that already holds a slot, for example the
+// import of one key of a batch, does not take another one.
+class Bulkhead {
+
+public:
+
+    enum Class {
+        DKG, TE, ADMIN, NUM_CLASSES
+    };
+
+    class Guard {
+        Class methodClass;
+        bool held;
+
+    public:
+
+        explicit Guard(Class _class);
+
+        ~Guard();
+
+        Guard(const Guard &) = delete;
+
+        Guard &operator=(const Guard &) = delete;
+    };
+
+    // 0 removes the limit of a class, set with sgxwallet -z
+    static void setLimits(uint64_t _dkg, uint64_t _te, uint64_t _admin);
+
+    static uint64_t getLimit(Class _class);
+
+    static uint64_t getInUse(Class _class);
+
+    // calls that failed with BULKHEAD_FULL
+    static uint64_t getRejected(Class _class);
+
+    static const char *getName(Class _class);
+
+private:
+
+    struct Slots {
+        mutex m;
+        condition_variable freed;
+        uint64_t inUse = 0;
+        atomic<uint64_t> limit;
+        atomic<uint64_t> rejected;
+
+        Slots(uint64_t _limit) : limit(_limit), rejected(0) {}
+    };
+
+    static Slots slots[NUM_CLASSES];
+
+    static thread_local bool holding;
+};
+
+#define BULKHEAD(__CLASS__) Bulkhead::Guard __BULKHEAD__(Bulkhead::__CLASS__);
+
+#endif //SGXWALLET_BULKHEAD_H
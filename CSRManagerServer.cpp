@@ -27,7 +27,10 @@
 #include <jsonrpccpp/server/connectors/httpserver.h>
 
 #include "CSRManagerServer.h"
+#include "CertSigner.h"
+#include "CryptoTools.h"
 #include "SGXException.h"
+#include "LatencySLO.h"
 #include "sgxwallet_common.h"
 
 #include "Log.h"
@@ -43,9 +46,14 @@ Json::Value getUnsignedCSRsImpl() {
     INIT_RESULT(result)
 
     try {
+        SLO_SHED_LOW_PRIORITY
+
+        static const string CSR_PREFIX = "CSR:HASH:";
         vector<string> hashes_vect = LevelDB::getCsrDb()->writeKeysToVector1(MAX_CSR_NUM);
         for (int i = 0; i < (int) hashes_vect.size(); i++) {
-            result["hashes"][i] = hashes_vect.at(i);
+            // signByHash takes the hash without the key prefix
+            auto &key = hashes_vect.at(i);
+            result["hashes"][i] = key.compare(0, CSR_PREFIX.size(), CSR_PREFIX) == 0 ? key.substr(CSR_PREFIX.size()) : key;
         }
     } HANDLE_SGX_EXCEPTION(result);
 
@@ -56,6 +64,8 @@ Json::Value signByHashImpl(const string &hash, int status) {
     INIT_RESULT(result)
 
     try {
+        SLO_SHED_LOW_PRIORITY
+
         if (!(status == 0 || status == 2)) {
             throw SGXException(-111, "Invalid csr status");
         }
@@ -67,27 +77,21 @@ Json::Value signByHashImpl(const string &hash, int status) {
         }
 
         if (status == 0) {
-            string csr_name = "sgx_data/cert/" + hash + ".csr";
-            ofstream outfile(csr_name);
-            outfile << *csr_ptr << endl;
-            outfile.close();
-            if (access(csr_name.c_str(), F_OK) != 0) {
-                LevelDB::getCsrDb()->deleteKey(csr_db_key);
-                throw SGXException(FILE_NOT_FOUND, "Csr does not exist");
-            }
-
-            string signClientCert = "cd sgx_data/cert && ./create_client_cert " + hash;
+            string cert;
 
-            if (system(signClientCert.c_str()) == 0) {
-                spdlog::info("CLIENT CERTIFICATE IS SUCCESSFULLY GENERATED");
-            } else {
+            try {
+                cert = CertSigner::signCSR(*csr_ptr);
+            } catch (...) {
                 spdlog::info("CLIENT CERTIFICATE GENERATION FAILED");
                 LevelDB::getCsrDb()->deleteKey(csr_db_key);
                 string status_db_key = "CSR:HASH:" + hash + "STATUS:";
                 LevelDB::getCsrStatusDb()->deleteKey(status_db_key);
                 LevelDB::getCsrStatusDb()->writeDataUnique(status_db_key, "-1");
-                throw SGXException(FAIL_TO_CREATE_CERTIFICATE, "CLIENT CERTIFICATE GENERATION FAILED");
+                throw;
             }
+
+            LevelDB::getCsrStatusDb()->writeDataUnique("CSR:HASH:" + hash + "CERT:", cert);
+            spdlog::info("CLIENT CERTIFICATE IS SUCCESSFULLY GENERATED");
         }
 
         LevelDB::getCsrDb()->deleteKey(csr_db_key);
@@ -102,6 +106,37 @@ Json::Value signByHashImpl(const string &hash, int status) {
     RETURN_SUCCESS(result)
 }
 
+// signs or rejects CSRs on up to one thread per core, each entry gets the result signByHash would return
+Json::Value signByHashBatchImpl(const Json::Value &hashes, int status) {
+    INIT_RESULT(result)
+
+    try {
+        SLO_SHED_LOW_PRIORITY
+
+        if (!hashes.isArray() || hashes.empty() || hashes.size() > MAX_CSR_NUM) {
+            throw SGXException(INVALID_CSR_BATCH, "Batch has to contain between 1 and " + to_string(MAX_CSR_NUM) + " hashes");
+        }
+
+        vector<string> names;
+        for (auto &&hash : hashes) {
+            if (!hash.isString()) {
+                throw SGXException(INVALID_CSR_BATCH, "Batch hashes have to be strings");
+            }
+            names.push_back(hash.asString());
+        }
+
+        vector<Json::Value> results(names.size());
+        parallelFor(names.size(), [&](size_t _i) { results[_i] = signByHashImpl(names[_i], status); });
+
+        result["results"] = Json::Value(Json::arrayValue);
+        for (auto &&element : results) {
+            result["results"].append(element);
+        }
+    } HANDLE_SGX_EXCEPTION(result)
+
+    RETURN_SUCCESS(result)
+}
+
 Json::Value CSRManagerServer::getUnsignedCSRs() {
     return getUnsignedCSRsImpl();
 }
@@ -110,8 +145,12 @@ Json::Value CSRManagerServer::signByHash(const string &hash, int status) {
     return signByHashImpl(hash, status);
 }
 
-void CSRManagerServer::initCSRManagerServer() {
-    hs3 = make_shared<jsonrpc::HttpServer>(BASE_PORT + 2);
+Json::Value CSRManagerServer::signByHashBatch(const Json::Value &hashes, int status) {
+    return signByHashBatchImpl(hashes, status);
+}
+
+void CSRManagerServer::initCSRManagerServer(uint64_t _numThreads) {
+    hs3 = make_shared<jsonrpc::HttpServer>(BASE_PORT + 2, "", "", "", false, _numThreads);
     hs3->BindLocalhost();
     cs = make_shared<CSRManagerServer>(*hs3, JSONRPC_SERVER_V2); // server (json-rpc 2.0)
 
@@ -29,6 +29,7 @@
 
 #include <jsonrpccpp/server/connectors/httpserver.h>
 
+#include "sgxwallet_common.h"
 #include "abstractCSRManagerServer.h"
 #include "LevelDB.h"
 
@@ -48,8 +49,9 @@ class CSRManagerServer : public abstractCSRManagerServer {
 
   virtual Json::Value getUnsignedCSRs();
   virtual Json::Value signByHash(const string& hash, int status);
+  virtual Json::Value signByHashBatch(const Json::Value& hashes, int status);
 
-  static void initCSRManagerServer();
+  static void initCSRManagerServer(uint64_t _numThreads = NUM_ADMIN_SERVER_THREADS);
 
   static int exitServer();
 };
@@ -0,0 +1,143 @@
+/*
+    Copyright (C) 2021-Present SKALE Labs
+
+    This file is part of sgxwallet.
+
+    sgxwallet is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as published
+    by the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    sgxwallet is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with sgxwallet. If not, see <https://www.gnu.org/licenses/>.
+
+    @file CertSigner.cpp
+    @author Stan Kladko
+    @date 2021
+*/
+
+#include <cstdio>
+#include <memory>
+
+#include <openssl/bn.h>
+#include <openssl/pem.h>
+
+#include "sgxwallet_common.h"
+#include "SGXException.h"
+#include "third_party/spdlog/spdlog.h"
+#include "common.h"
+
+#include "CertSigner.h"
+
+mutex CertSigner::caMutex;
+X509 *CertSigner::caCert = nullptr;
+EVP_PKEY *CertSigner::caKey = nullptr;
+atomic<uint64_t> CertSigner::signedCerts(0);
+
+void CertSigner::init(const string &_caCertPath, const string &_caKeyPath) {
+    lock_guard<mutex> lock(caMutex);
+
+    if (caCert) {
+        return;
+    }
+
+    auto certFile = fopen(_caCertPath.c_str(), "r");
+    if (!certFile) {
+        throw SGXException(FILE_NOT_FOUND, "Could not open root CA cert " + _caCertPath);
+    }
+    auto cert = PEM_read_X509(certFile, nullptr, nullptr, nullptr);
+    fclose(certFile);
+
+    auto keyFile = fopen(_caKeyPath.c_str(), "r");
+    if (!keyFile) {
+        X509_free(cert);
+        throw SGXException(FILE_NOT_FOUND, "Could not open root CA key " + _caKeyPath);
+    }
+    auto key = PEM_read_PrivateKey(keyFile, nullptr, nullptr, nullptr);
+    fclose(keyFile);
+
+    if (!cert || !key || X509_check_private_key(cert, key) != 1) {
+        X509_free(cert);
+        EVP_PKEY_free(key);
+        throw SGXException(FAIL_TO_CREATE_CERTIFICATE, "Could not load root CA from " + _caCertPath);
+    }
+
+    caCert = cert;
+    caKey = key;
+
+    spdlog::info("Loaded root CA for signing client certs from {}", _caCertPath);
+}
+
+X509_REQ *CertSigner::parseCSR(const string &_csr) {
+    auto bio = BIO_new_mem_buf(_csr.data(), (int) _csr.size());
+    CHECK_STATE(bio);
+    auto req = PEM_read_bio_X509_REQ(bio, nullptr, nullptr, nullptr);
+    BIO_free(bio);
+
+    if (!req) {
+        throw SGXException(FAIL_TO_CREATE_CERTIFICATE, "Incorrect CSR format");
+    }
+
+    auto key = X509_REQ_get0_pubkey(req);
+    auto subject = X509_REQ_get_subject_name(req);
+
+    // the subject needs a common name, as the policy_anything policy of cert/ca.config required
+    if (!key || X509_REQ_verify(req, key) != 1 || !subject ||
+        X509_NAME_get_index_by_NID(subject, NID_commonName, -1) < 0) {
+        X509_REQ_free(req);
+        throw SGXException(FAIL_TO_CREATE_CERTIFICATE, "Incorrect CSR format");
+    }
+
+    return req;
+}
+
+bool CertSigner::isValidCSR(const string &_csr) {
+    try {
+        X509_REQ_free(parseCSR(_csr));
+        return true;
+    } catch (SGXException &) {
+        return false;
+    }
+}
+
+string CertSigner::signCSR(const string &_csr) {
+    CHECK_STATE(caCert && caKey);
+
+    unique_ptr<X509_REQ, decltype(&X509_REQ_free)> req(parseCSR(_csr), X509_REQ_free);
+    unique_ptr<X509, decltype(&X509_free)> cert(X509_new(), X509_free);
+    unique_ptr<BIGNUM, decltype(&BN_free)> serial(BN_new(), BN_free);
+    CHECK_STATE(cert && serial);
+
+    // random serials, so that concurrent signers need no shared counter
+    CHECK_STATE(BN_rand(serial.get(), 159, BN_RAND_TOP_ANY, BN_RAND_BOTTOM_ANY) == 1);
+    CHECK_STATE(BN_to_ASN1_INTEGER(serial.get(), X509_get_serialNumber(cert.get())));
+
+    CHECK_STATE(X509_set_version(cert.get(), 2) == 1);
+    CHECK_STATE(X509_set_issuer_name(cert.get(), X509_get_subject_name(caCert)) == 1);
+    CHECK_STATE(X509_set_subject_name(cert.get(), X509_REQ_get_subject_name(req.get())) == 1);
+    CHECK_STATE(X509_set_pubkey(cert.get(), X509_REQ_get0_pubkey(req.get())) == 1);
+    CHECK_STATE(X509_gmtime_adj(X509_getm_notBefore(cert.get()), 0));
+    CHECK_STATE(X509_gmtime_adj(X509_getm_notAfter(cert.get()), (long) CLIENT_CERT_VALIDITY_DAYS * 86400));
+
+    if (X509_sign(cert.get(), caKey, EVP_sha256()) <= 0) {
+        throw SGXException(FAIL_TO_CREATE_CERTIFICATE, "CLIENT CERTIFICATE GENERATION FAILED");
+    }
+
+    auto bio = BIO_new(BIO_s_mem());
+    CHECK_STATE(bio);
+    CHECK_STATE(PEM_write_bio_X509(bio, cert.get()) == 1);
+
+    char *data = nullptr;
+    auto len = BIO_get_mem_data(bio, &data);
+    string result(data, len);
+    BIO_free(bio);
+
+    signedCerts++;
+
+    return result;
+}
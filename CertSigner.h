@@ -0,0 +1,64 @@
+/*
+    Copyright (C) 2021-Present SKALE Labs
+
+    This file is part of sgxwallet.
+
+    sgxwallet is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as published
+    by the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    sgxwallet is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with sgxwallet. If not, see <https://www.gnu.org/licenses/>.
+
+    @file CertSigner.h
+    @author Stan Kladko
+    @date 2021
+*/
+
+#ifndef SGXWALLET_CERTSIGNER_H
+#define SGXWALLET_CERTSIGNER_H
+
+#include <atomic>
+#include <mutex>
+#include <string>
+
+#include <openssl/evp.h>
+#include <openssl/x509.h>
+
+using namespace std;
+
+// Signs client CSRs with the root CA in process, for the registration and CSR manager servers.
+// The CA cert and key are loaded once by init. Signing only reads them, so CSRs can be signed on
+// several threads at once.
+class CertSigner {
+
+    static mutex caMutex;
+
+    static X509 *caCert;
+
+    static EVP_PKEY *caKey;
+
+    static atomic<uint64_t> signedCerts;
+
+    // throws if the CSR can not be parsed, has no common name or its signature does not verify
+    static X509_REQ *parseCSR(const string &_csr);
+
+public:
+
+    static void init(const string &_caCertPath, const string &_caKeyPath);
+
+    static bool isValidCSR(const string &_csr);
+
+    // returns the PEM of a cert valid for CLIENT_CERT_VALIDITY_DAYS
+    static string signCSR(const string &_csr);
+
+    static uint64_t getSignedCerts() { return signedCerts.load(); }
+};
+
+#endif //SGXWALLET_CERTSIGNER_H
@@ -0,0 +1,90 @@
+/*
+    Copyright (C) 2021-Present SKALE Labs
+
+    This file is part of sgxwallet.
+
+    sgxwallet is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as published
+    by the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    sgxwallet is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with sgxwallet. If not, see <https://www.gnu.org/licenses/>.
+
+    @file ClientRateLimiter.cpp
+    @author Stan Kladko
+    @date 2021
+*/
+
+#include "sgxwallet_common.h"
+#include "SGXException.h"
+#include "common.h"
+
+#include "ClientRateLimiter.h"
+
+uint64_t ClientRateLimiter::requestsPerSecond = 0;
+
+void ClientRateLimiter::setRequestsPerSecond(uint64_t _requestsPerSecond) {
+    if (_requestsPerSecond > MAX_CLIENT_REQUESTS_PER_SECOND) {
+        throw SGXException(INVALID_CLIENT_RATE_LIMIT, string(__FUNCTION__) +
+                           ":Client rate limit can not exceed " + to_string(MAX_CLIENT_REQUESTS_PER_SECOND) +
+                           " requests per second");
+    }
+    requestsPerSecond = _requestsPerSecond;
+}
+
+ClientRateLimiter::ClientRateLimiter(uint64_t _requestsPerSecond) : rate((double) _requestsPerSecond) {
+    CHECK_STATE(_requestsPerSecond > 0);
+}
+
+void ClientRateLimiter::dropFullBuckets(chrono::steady_clock::time_point _now) {
+    for (auto it = buckets.begin(); it != buckets.end();) {
+        chrono::duration<double> idle = _now - it->second.updated;
+        if (it->second.tokens + idle.count() * rate >= rate) {
+            it = buckets.erase(it);
+        } else {
+            it++;
+        }
+    }
+
+    // most clients are over their limit, start over rather than scan the table for every new client
+    if (buckets.size() >= CLIENT_RATE_LIMITER_MAX_ENTRIES / 2) {
+        buckets.clear();
+    }
+}
+
+bool ClientRateLimiter::tryAcquire(const string &_clientId, double _cost) {
+    auto now = chrono::steady_clock::now();
+
+    lock_guard<mutex> lock(m);
+
+    auto it = buckets.find(_clientId);
+
+    if (it == buckets.end()) {
+        if (buckets.size() >= CLIENT_RATE_LIMITER_MAX_ENTRIES) {
+            dropFullBuckets(now);
+        }
+        it = buckets.emplace(_clientId, Bucket{rate, now}).first;
+    } else {
+        chrono::duration<double> elapsed = now - it->second.updated;
+        it->second.tokens = min(rate, it->second.tokens + elapsed.count() * rate);
+        it->second.updated = now;
+    }
+
+    if (it->second.tokens < _cost) {
+        return false;
+    }
+
+    it->second.tokens -= _cost;
+    return true;
+}
+
+uint64_t ClientRateLimiter::size() {
+    lock_guard<mutex> lock(m);
+    return buckets.size();
+}
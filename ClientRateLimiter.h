@@ -0,0 +1,71 @@
+/*
+    Copyright (C) 2021-Present SKALE Labs
+
+    This file is part of sgxwallet.
+
+    sgxwallet is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as published
+    by the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    sgxwallet is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with sgxwallet. If not, see <https://www.gnu.org/licenses/>.
+
+    @file ClientRateLimiter.h
+    @author Stan Kladko
+    @date 2021
+*/
+
+#ifndef SGXWALLET_CLIENTRATELIMITER_H
+#define SGXWALLET_CLIENTRATELIMITER_H
+
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+using namespace std;
+
+// Token bucket per client, shared by the ZMQ and HTTP servers. Each client may make
+// requestsPerSecond requests per second on average and bursts of up to one second worth of
+// requests. A bucket that has refilled holds no state that a new one would not, so full buckets
+// are dropped when the table reaches CLIENT_RATE_LIMITER_MAX_ENTRIES.
+class ClientRateLimiter {
+
+    struct Bucket {
+        double tokens;
+        chrono::steady_clock::time_point updated;
+    };
+
+    // zero means no limit
+    static uint64_t requestsPerSecond;
+
+    const double rate;
+
+    mutex m;
+
+    unordered_map<string, Bucket> buckets;
+
+    void dropFullBuckets(chrono::steady_clock::time_point _now);
+
+public:
+
+    explicit ClientRateLimiter(uint64_t _requestsPerSecond);
+
+    // takes _cost tokens from the bucket of the client, returns false if there are not enough
+    bool tryAcquire(const string &_clientId, double _cost = 1);
+
+    uint64_t size();
+
+    // set with sgxwallet -R, zero disables rate limiting
+    static void setRequestsPerSecond(uint64_t _requestsPerSecond);
+
+    static uint64_t getRequestsPerSecond() { return requestsPerSecond; }
+};
+
+#endif //SGXWALLET_CLIENTRATELIMITER_H
@@ -21,21 +21,39 @@
     @date 2021
 */
 
+#include <algorithm>
+#include <exception>
+#include <thread>
 #include <vector>
 
 #include "common.h"
+#include "HexCodec.h"
 #include "CryptoTools.h"
 
 using std::vector;
 
+// 256-entry lookup table for per character decoding, whole strings go through HexCodec.h
+struct HexTables {
+    int8_t decode[256];
+
+    constexpr HexTables() : decode() {
+        for (int i = 0; i < 256; i++) {
+            decode[i] = -1;
+        }
+        for (int i = 0; i < 10; i++) {
+            decode['0' + i] = i;
+        }
+        for (int i = 0; i < 6; i++) {
+            decode['a' + i] = 10 + i;
+            decode['A' + i] = 10 + i;
+        }
+    }
+};
+
+static constexpr HexTables HEX_TABLES;
+
 int char2int(char _input) {
-    if (_input >= '0' && _input <= '9')
-        return _input - '0';
-    if (_input >= 'A' && _input <= 'F')
-        return _input - 'A' + 10;
-    if (_input >= 'a' && _input <= 'f')
-        return _input - 'a' + 10;
-    return -1;
+    return HEX_TABLES.decode[(uint8_t) _input];
 }
 
 vector<char> carray2Hex(const unsigned char *d, uint64_t _len) {
@@ -44,13 +62,7 @@ vector<char> carray2Hex(const unsigned char *d, uint64_t _len) {
 
     vector<char> _hexArray( 2 * _len + 1);
 
-    char hexval[16] = {'0', '1', '2', '3', '4', '5', '6', '7',
-                       '8', '9', 'a', 'b', 'c', 'd', 'e', 'f'};
-
-    for (uint64_t j = 0; j < _len; j++) {
-        _hexArray[j * 2] = hexval[((d[j] >> 4) & 0xF)];
-        _hexArray[j * 2 + 1] = hexval[(d[j]) & 0x0F];
-    }
+    hexEncode(d, _len, _hexArray.data());
 
     _hexArray[_len * 2] = 0;
 
@@ -74,37 +86,79 @@ bool hex2carray(const char *_hex, uint64_t *_bin_len,
 
     *_bin_len = len / 2;
 
-    for (uint64_t i = 0; i < len / 2; i++) {
-        int high = char2int((char) _hex[i * 2]);
-        int low = char2int((char) _hex[i * 2 + 1]);
+    return hexDecode(_hex, len / 2, _bin);
+}
 
-        if (high < 0 || low < 0) {
-            return false;
-        }
+bool hex2limbs(const char *_hex, uint64_t _hexLen, uint64_t *_limbs, uint64_t _numLimbs) {
+    CHECK_STATE(_hex);
+    CHECK_STATE(_limbs);
+
+    if (_hexLen == 0 || _hexLen > 16 * _numLimbs) {
+        return false;
+    }
+
+    for (uint64_t i = 0; i < _numLimbs; i++) {
+        _limbs[i] = 0;
+    }
+
+    int invalid = 0;
 
-        _bin[i] = (unsigned char) (high * 16 + low);
+    // the last hex digit is the least significant nibble of limb 0
+    for (uint64_t i = 0; i < _hexLen; i++) {
+        int digit = HEX_TABLES.decode[(uint8_t) _hex[_hexLen - 1 - i]];
+        invalid |= digit;
+        _limbs[i / 16] |= ((uint64_t) (digit & 0x0F)) << (4 * (i % 16));
     }
 
-    return true;
+    return invalid >= 0;
 }
 
 vector <std::string> splitString(const char *coeffs, const char symbol) {
     CHECK_STATE(coeffs);
-    std::string str(coeffs);
-    std::string delim;
-    delim.push_back(symbol);
-    vector <std::string> G2Strings;
-    size_t prev = 0, pos = 0;
-    do {
-        pos = str.find(delim, prev);
-        if (pos == std::string::npos) pos = str.length();
-        std::string token = str.substr(prev, pos - prev);
-        if (!token.empty()) {
-            std::string coeff(token.c_str());
-            G2Strings.push_back(coeff);
+
+    vector <std::string> tokens;
+    StringTokenizer tokenizer(coeffs, symbol);
+    std::string_view token;
+
+    while (tokenizer.next(token)) {
+        tokens.emplace_back(token);
+    }
+
+    return tokens;
+}
+
+void parallelFor(size_t _count, const std::function<void(size_t)> &_fn, size_t _minPerThread) {
+    size_t numThreads = std::min<size_t>(std::thread::hardware_concurrency(), _count / std::max<size_t>(_minPerThread, 1));
+
+    if (numThreads <= 1) {
+        for (size_t k = 0; k < _count; k++) {
+            _fn(k);
         }
-        prev = pos + delim.length();
-    } while (pos < str.length() && prev < str.length());
+        return;
+    }
+
+    vector<std::thread> threads;
+    vector<std::exception_ptr> errors(numThreads);
+
+    for (size_t j = 0; j < numThreads; j++) {
+        threads.emplace_back([&, j]() {
+            try {
+                for (size_t k = j; k < _count; k += numThreads) {
+                    _fn(k);
+                }
+            } catch (...) {
+                errors[j] = std::current_exception();
+            }
+        });
+    }
 
-    return G2Strings;
+    for (auto &&t : threads) {
+        t.join();
+    }
+
+    for (auto &&error : errors) {
+        if (error) {
+            std::rethrow_exception(error);
+        }
+    }
 }
@@ -32,7 +32,9 @@
 
 #include "stddef.h"
 #include "stdint.h"
+#include <functional>
 #include <string>
+#include <string_view>
 #include <vector>
 
 EXTERNC int char2int(char _input);
@@ -42,6 +44,36 @@ EXTERNC std::vector<char> carray2Hex(const unsigned char *d, uint64_t _len);
 EXTERNC bool hex2carray(const char * _hex, uint64_t  *_bin_len,
                  uint8_t* _bin, uint64_t _max_length );
 
+// parses a big-endian hex string of up to 16 * _numLimbs digits into little-endian 64-bit limbs
+EXTERNC bool hex2limbs(const char * _hex, uint64_t _hexLen, uint64_t* _limbs, uint64_t _numLimbs);
+
+// copies the non empty tokens, see StringTokenizer for a version that does not allocate
 std::vector<std::string> splitString(const char* coeffs, const char symbol);
 
+// Iterates over the non empty tokens of a string without copying them.
+// The string has to outlive the tokenizer.
+class StringTokenizer {
+    std::string_view rest;
+    char delim;
+
+public:
+    StringTokenizer(std::string_view _str, char _delim) : rest(_str), delim(_delim) {}
+
+    bool next(std::string_view &_token) {
+        while (!rest.empty()) {
+            auto pos = rest.find(delim);
+            _token = rest.substr(0, pos);
+            rest = pos == std::string_view::npos ? std::string_view() : rest.substr(pos + 1);
+            if (!_token.empty()) {
+                return true;
+            }
+        }
+        return false;
+    }
+};
+
+// runs _fn(k) for every k < _count on up to one thread per core with at least _minPerThread
+// items each, rethrows the first exception
+void parallelFor(size_t _count, const std::function<void(size_t)> &_fn, size_t _minPerThread = 1);
+
 #endif // SGXWALLET_CRYPTOTOOLS_H
@@ -22,18 +22,28 @@
 */
 
 
+#include <algorithm>
+#include <atomic>
 #include <iostream>
+#include <map>
 #include <memory>
+#include <mutex>
 
 
+#include <libff/algebra/scalar_multiplication/multiexp.hpp>
+
 #include "third_party/spdlog/spdlog.h"
 #include "common.h"
+#include "Metrics.h"
 #include "sgxwallet.h"
 #include "SGXException.h"
 
 #include "SGXWalletServer.hpp"
 #include "CryptoTools.h"
+#include "ScratchBuffer.h"
 #include "SEKManager.h"
+#include "G2Codec.h"
+#include "ServerDataChecker.h"
 #include "DKGCrypto.h"
 
 template<class T>
@@ -107,16 +117,16 @@ string convertG2ToString(const libff::alt_bn128_G2 &elem, int base, const string
 }
 
 string gen_dkg_poly(int _t) {
-    vector<char> errMsg(BUF_LEN, 0);
+    ScratchBuffer errMsg(BUF_LEN);
     int errStatus = 0;
     uint64_t enc_len = 0;
 
-    vector <uint8_t> encrypted_dkg_secret(BUF_LEN, 0);
+    vector <uint8_t> encrypted_dkg_secret(DKG_MAX_SEALED_LEN, 0);
 
     sgx_status_t status = SGX_SUCCESS;
 
-    status = trustedGenDkgSecret(eid, &errStatus, errMsg.data(), encrypted_dkg_secret.data(),
-                                 &enc_len, _t);
+    status = ECALL(trustedGenDkgSecret, eid, &errStatus, errMsg.data(), encrypted_dkg_secret.data(),
+                                        &enc_len, _t);
 
     HANDLE_TRUSTED_FUNCTION_ERROR(status, errStatus, errMsg.data());
 
@@ -129,46 +139,92 @@ string gen_dkg_poly(int _t) {
     return result;
 }
 
-vector <vector<string>> get_verif_vect(const string &encryptedPolyHex, int t) {
+vector<pair<string, string>> genDkgPolyBatch(uint64_t _numPolys, int _t) {
+    CHECK_STATE(_numPolys > 0 && _numPolys <= MAX_DKG_POLY_BATCH_SIZE);
+    CHECK_STATE(_t > 0 && _t <= MAX_DKG_N);
+
+    ScratchBuffer errMsg(BUF_LEN);
+    int errStatus = 0;
+
+    vector<uint8_t> encryptedPolys(_numPolys * DKG_MAX_SEALED_LEN, 0);
+    vector<uint64_t> encLens(_numPolys, 0);
+    vector<char> publicShares(_numPolys * DKG_PUBLIC_SHARES_SLOT_LEN(_t), 0);
+
+    sgx_status_t status = SGX_SUCCESS;
+
+    status = ECALL(trustedGenDkgSecretBatch, eid, &errStatus, errMsg.data(), _numPolys, encryptedPolys.data(),
+                   encryptedPolys.size(), encLens.data(), publicShares.data(), publicShares.size(), _t);
+
+    HANDLE_TRUSTED_FUNCTION_ERROR(status, errStatus, errMsg.data());
+
+    vector<pair<string, string>> result(_numPolys);
+    for (uint64_t i = 0; i < _numPolys; i++) {
+        CHECK_STATE(encLens[i] > 0 && encLens[i] <= DKG_MAX_SEALED_LEN);
+        auto hex = carray2Hex(encryptedPolys.data() + i * DKG_MAX_SEALED_LEN, encLens[i]);
+        result[i].first = string(hex.data());
+        result[i].second = string(publicShares.data() + i * DKG_PUBLIC_SHARES_SLOT_LEN(_t));
+    }
+
+    return result;
+}
+
+string getVerificationVectorString(const string &encryptedPolyHex, int t) {
 
     auto encryptedPolyHexPtr = encryptedPolyHex.c_str();
 
     CHECK_STATE(encryptedPolyHexPtr);
 
-    vector<char> errMsg(BUF_LEN, 0);
+    ScratchBuffer errMsg(BUF_LEN);
 
     int errStatus = 0;
 
-    vector<char> pubShares(10000, 0);
+    vector<char> pubShares(DKG_PUBLIC_SHARES_LEN, 0);
 
     uint64_t encLen = 0;
 
-    vector <uint8_t> encrDKGPoly(2 * BUF_LEN, 0);
+    vector <uint8_t> encrDKGPoly(DKG_MAX_SEALED_LEN, 0);
 
-    if (!hex2carray(encryptedPolyHexPtr, &encLen, encrDKGPoly.data(), 6100)) {
+    if (!hex2carray(encryptedPolyHexPtr, &encLen, encrDKGPoly.data(), DKG_MAX_SEALED_LEN)) {
         throw SGXException(GET_VV_INVALID_POLY_HEX, ":Invalid encryptedPolyHex");
     }
 
 
     sgx_status_t status = SGX_SUCCESS;
 
-    status = trustedGetPublicShares(eid, &errStatus, errMsg.data(), encrDKGPoly.data(), encLen,
-                                    pubShares.data(), t);
+    status = ECALL(trustedGetPublicShares, eid, &errStatus, errMsg.data(), encrDKGPoly.data(), encLen,
+                                           pubShares.data(), t);
 
     HANDLE_TRUSTED_FUNCTION_ERROR(status, errStatus, errMsg.data());
 
-    vector <string> g2Strings = splitString(pubShares.data(), ',');
-    vector <vector<string>> pubSharesVect(t);
-    for (uint64_t i = 0; i < g2Strings.size(); i++) {
-        vector <string> coeffStr = splitString(g2Strings.at(i).c_str(), ':');
-        pubSharesVect[i] = coeffStr;
+    return pubShares.data();
+}
+
+vector <vector<string>> parseVerificationVector(const string &_verificationVector) {
+    vector <vector<string>> pubSharesVect;
+
+    StringTokenizer g2Strings(_verificationVector, ',');
+    string_view g2String, coord;
+
+    while (g2Strings.next(g2String)) {
+        pubSharesVect.emplace_back();
+        pubSharesVect.back().reserve(4);
+        StringTokenizer coords(g2String, ':');
+        while (coords.next(coord)) {
+            pubSharesVect.back().emplace_back(coord);
+        }
     }
 
     return pubSharesVect;
 }
 
-vector <vector<string>> getVerificationVectorMult(const std::string &encryptedPolyHex, int t, int n, size_t ind) {
-    auto verificationVector = get_verif_vect(encryptedPolyHex, t);
+vector <vector<string>> get_verif_vect(const string &encryptedPolyHex, int t) {
+    auto pubSharesVect = parseVerificationVector(getVerificationVectorString(encryptedPolyHex, t));
+    pubSharesVect.resize(t);
+    return pubSharesVect;
+}
+
+vector <vector<string>> getVerificationVectorMult(const vector <vector<string>> &verificationVector, int t, size_t ind) {
+    CHECK_STATE(verificationVector.size() >= (uint64_t) t);
 
     vector <vector<string>> result(t);
 
@@ -183,9 +239,8 @@ vector <vector<string>> getVerificationVectorMult(const std::string &encryptedPo
         current_coefficient = libff::power(libff::alt_bn128_Fr(ind + 1), i) * current_coefficient;
         current_coefficient.to_affine_coordinates();
 
-        auto g2_str = convertG2ToString(current_coefficient);
-
-        result[i] = splitString(g2_str.c_str(), ':');
+        result[i] = {ConvertToString(current_coefficient.X.c0), ConvertToString(current_coefficient.X.c1),
+                     ConvertToString(current_coefficient.Y.c0), ConvertToString(current_coefficient.Y.c1)};
     }
 
     return result;
@@ -199,13 +254,13 @@ getSecretShares(const string &_polyName, const char *_encryptedPolyHex, const ve
     CHECK_STATE(_encryptedPolyHex);
 
     vector<char> hexEncrKey(BUF_LEN, 0);
-    vector<char> errMsg(BUF_LEN, 0);
-    vector <uint8_t> encrDKGPoly(BUF_LEN, 0);
+    ScratchBuffer errMsg(BUF_LEN);
+    vector <uint8_t> encrDKGPoly(DKG_MAX_SEALED_LEN, 0);
     int errStatus = 0;
     uint64_t encLen = 0;
 
 
-    if (!hex2carray(_encryptedPolyHex, &encLen, encrDKGPoly.data(), BUF_LEN)) {
+    if (!hex2carray(_encryptedPolyHex, &encLen, encrDKGPoly.data(), DKG_MAX_SEALED_LEN)) {
         throw SGXException(GET_SS_INVALID_HEX, string(__FUNCTION__) + ":Invalid encryptedPolyHex");
     }
 
@@ -213,6 +268,7 @@ getSecretShares(const string &_polyName, const char *_encryptedPolyHex, const ve
     READ_LOCK(sgxInitMutex);
 
     string result;
+    vector <pair<string, string>> keyValues;
 
     for (int i = 0; i < _n; i++) {
         vector <uint8_t> encryptedSkey(BUF_LEN, 0);
@@ -229,12 +285,12 @@ getSecretShares(const string &_polyName, const char *_encryptedPolyHex, const ve
         spdlog::debug("pubKeyB is {}", pub_keyB);
 
         sgx_status_t status = SGX_SUCCESS;
-        status = trustedGetEncryptedSecretShare(eid, &errStatus,
-                                                errMsg.data(),
-                                                encrDKGPoly.data(), encLen,
-                                                encryptedSkey.data(), &decLen,
-                                                currentShare.data(), sShareG2.data(), pubKeyB.data(), _t, _n,
-                                                i + 1);
+        status = ECALL(trustedGetEncryptedSecretShare, eid, &errStatus,
+                                                       errMsg.data(),
+                                                       encrDKGPoly.data(), encLen,
+                                                       encryptedSkey.data(), &decLen,
+                                                       currentShare.data(), sShareG2.data(), pubKeyB.data(), _t, _n,
+                                                       i + 1);
 
         HANDLE_TRUSTED_FUNCTION_ERROR(status, errStatus, errMsg.data());
 
@@ -246,12 +302,15 @@ getSecretShares(const string &_polyName, const char *_encryptedPolyHex, const ve
 
         string shareG2_name = "shareG2_" + _polyName + "_" + to_string(i) + ":";
 
-        SGXWalletServer::writeDataToDB(dhKeyName, hexEncrKey.data());
-        SGXWalletServer::writeDataToDB(shareG2_name, sShareG2.data());
+        keyValues.push_back({dhKeyName, hexEncrKey.data()});
+        keyValues.push_back({shareG2_name, sShareG2.data()});
     }
 
     string encryptedSecretShareName = "encryptedSecretShare:" + _polyName;
-    SGXWalletServer::writeDataToDB(encryptedSecretShareName, result);
+    keyValues.push_back({encryptedSecretShareName, result});
+
+    // all 2 * n + 1 keys of this polynomial are written atomically
+    SGXWalletServer::writeBatchToDB(keyValues);
 
     return result;
 }
@@ -262,60 +321,68 @@ getSecretSharesV2(const string &_polyName, const char *_encryptedPolyHex, const
     CHECK_STATE(_encryptedPolyHex);
 
     vector<char> hexEncrKey(BUF_LEN, 0);
-    vector<char> errMsg(BUF_LEN, 0);
-    vector <uint8_t> encrDKGPoly(BUF_LEN, 0);
+    ScratchBuffer errMsg(BUF_LEN);
+    vector <uint8_t> encrDKGPoly(DKG_MAX_SEALED_LEN, 0);
     int errStatus = 0;
     uint64_t encLen = 0;
 
 
-    if (!hex2carray(_encryptedPolyHex, &encLen, encrDKGPoly.data(), BUF_LEN)) {
+    if (!hex2carray(_encryptedPolyHex, &encLen, encrDKGPoly.data(), DKG_MAX_SEALED_LEN)) {
         throw SGXException(GET_SS_V2_INVALID_HEX,
                            string(__FUNCTION__) + ":Invalid encrypted poly Hex");
     }
 
 
-    READ_LOCK(sgxInitMutex);
+    CHECK_STATE(_n > 0 && _n <= MAX_DKG_SHARES_BATCH_SIZE);
+    CHECK_STATE(_publicKeys.size() >= (uint64_t) _n);
 
-    string result;
+    vector<char> pubKeys(_n * DKG_BATCH_PUB_KEY_SLOT_LEN, 0);
 
     for (int i = 0; i < _n; i++) {
-        vector <uint8_t> encryptedSkey(BUF_LEN, 0);
-        uint64_t decLen;
-        vector<char> currentShare(193, 0);
-        vector<char> sShareG2(320, 0);
-
-        string pub_keyB = _publicKeys.at(i);
-        vector<char> pubKeyB(129, 0);
+        spdlog::debug("pubKeyB is {}", _publicKeys.at(i));
+        strncpy(pubKeys.data() + i * DKG_BATCH_PUB_KEY_SLOT_LEN, _publicKeys.at(i).c_str(),
+                DKG_BATCH_PUB_KEY_SLOT_LEN - 1);
+    }
 
-        strncpy(pubKeyB.data(), pub_keyB.c_str(), 128);
-        pubKeyB.at(128) = 0;
+    vector<uint8_t> encryptedSkeys(_n * DKG_BATCH_SKEY_SLOT_LEN, 0);
+    vector<uint64_t> decLens(_n, 0);
+    vector<char> shares(_n * DKG_BATCH_SHARE_SLOT_LEN, 0);
+    vector<char> sharesG2(_n * DKG_BATCH_SHARE_G2_SLOT_LEN, 0);
 
-        spdlog::debug("pubKeyB is {}", pub_keyB);
+    READ_LOCK(sgxInitMutex);
 
-        sgx_status_t status = SGX_SUCCESS;
-        status = trustedGetEncryptedSecretShareV2(eid, &errStatus,
-                                                  errMsg.data(),
-                                                  encrDKGPoly.data(), encLen,
-                                                  encryptedSkey.data(), &decLen,
-                                                  currentShare.data(), sShareG2.data(), pubKeyB.data(), _t, _n,
-                                                  i + 1);
+    // one ECALL decrypts the poly once and computes all n shares
+    sgx_status_t status = SGX_SUCCESS;
+    status = ECALL(trustedGetEncryptedSecretSharesV2, eid, &errStatus, errMsg.data(), encrDKGPoly.data(), encLen, _n,
+                                                      pubKeys.data(), pubKeys.size(),
+                                                      encryptedSkeys.data(), encryptedSkeys.size(), decLens.data(),
+                                                      shares.data(), shares.size(), sharesG2.data(), sharesG2.size(), _t);
 
-        HANDLE_TRUSTED_FUNCTION_ERROR(status, errStatus, errMsg.data());
+    HANDLE_TRUSTED_FUNCTION_ERROR(status, errStatus, errMsg.data());
 
+    // the response and the batch are sized up front, the shares are appended straight from the slots
+    string result;
+    result.reserve(_n * (DKG_BATCH_SHARE_SLOT_LEN - 1));
+    vector <pair<string, string>> keyValues;
+    keyValues.reserve(2 * _n + 1);
 
-        result += string(currentShare.data());
+    for (int i = 0; i < _n; i++) {
+        result.append(shares.data() + i * DKG_BATCH_SHARE_SLOT_LEN);
 
-        hexEncrKey = carray2Hex(encryptedSkey.data(), decLen);
+        hexEncrKey = carray2Hex(encryptedSkeys.data() + i * DKG_BATCH_SKEY_SLOT_LEN, decLens[i]);
         string dhKeyName = "DKG_DH_KEY_" + _polyName + "_" + to_string(i) + ":";
 
         string shareG2_name = "shareG2_" + _polyName + "_" + to_string(i) + ":";
 
-        SGXWalletServer::writeDataToDB(dhKeyName, hexEncrKey.data());
-        SGXWalletServer::writeDataToDB(shareG2_name, sShareG2.data());
+        keyValues.emplace_back(move(dhKeyName), hexEncrKey.data());
+        keyValues.emplace_back(move(shareG2_name), sharesG2.data() + i * DKG_BATCH_SHARE_G2_SLOT_LEN);
     }
 
     string encryptedSecretShareName = "encryptedSecretShare:" + _polyName;
-    SGXWalletServer::writeDataToDB(encryptedSecretShareName, result);
+    keyValues.push_back({encryptedSecretShareName, result});
+
+    // all 2 * n + 1 keys of this polynomial are written atomically
+    SGXWalletServer::writeBatchToDB(keyValues);
 
     return result;
 }
@@ -327,7 +394,7 @@ verifyShares(const char *publicShares, const char *encr_sshare, const char *encr
     CHECK_STATE(encr_sshare);
     CHECK_STATE(encryptedKeyHex);
 
-    vector<char> errMsg(BUF_LEN, 0);
+    ScratchBuffer errMsg(BUF_LEN);
     int errStatus = 0;
     uint64_t decKeyLen = 0;
     int result = 0;
@@ -337,13 +404,10 @@ verifyShares(const char *publicShares, const char *encr_sshare, const char *encr
         throw SGXException(VERIFY_SHARES_INVALID_KEY_HEX, string(__FUNCTION__) + ":Invalid encryptedPolyHex");
     }
 
-    SAFE_CHAR_BUF(pshares, 8193);
-    strncpy(pshares, publicShares, strlen(publicShares));
-
     sgx_status_t status = SGX_SUCCESS;
 
-    status = trustedDkgVerify(eid, &errStatus, errMsg.data(), pshares, encr_sshare, encr_key, decKeyLen, t,
-                              ind, &result);
+    status = ECALL(trustedDkgVerify, eid, &errStatus, errMsg.data(), publicShares, encr_sshare, encr_key, decKeyLen, t,
+                                     ind, &result);
 
     HANDLE_TRUSTED_FUNCTION_ERROR(status, errStatus, errMsg.data());
 
@@ -355,6 +419,69 @@ verifyShares(const char *publicShares, const char *encr_sshare, const char *encr
     return result;
 }
 
+// G2 has a cofactor, so every commitment also has to be in the order r subgroup
+static bool parseCommitment(const char *_share, libff::alt_bn128_G2 &_commitment) {
+    uint8_t coord_length = 64;
+
+    if (!hexToFq(_share, _commitment.X.c0) || !hexToFq(_share + coord_length, _commitment.X.c1) ||
+        !hexToFq(_share + 2 * coord_length, _commitment.Y.c0) || !hexToFq(_share + 3 * coord_length, _commitment.Y.c1)) {
+        return false;
+    }
+
+    _commitment.Z = libff::alt_bn128_Fq2::one();
+
+    return _commitment.is_well_formed() && (libff::alt_bn128_modulus_r * _commitment).is_zero();
+}
+
+// the subgroup check is a full G2 multiplication, so the t commitments are checked in parallel
+static bool parseCommitments(const char *_publicShares, uint64_t _t, vector <libff::alt_bn128_G2> &_commitments) {
+    uint64_t share_length = 256;
+
+    _commitments.resize(_t);
+    atomic<bool> valid(true);
+
+    parallelFor(_t, [&](size_t j) {
+        if (valid && !parseCommitment(_publicShares + share_length * j, _commitments[j])) {
+            valid = false;
+        }
+    });
+
+    return valid;
+}
+
+// sum_j (ind + 1)^j * commitments[j] as one multi-scalar multiplication
+static libff::alt_bn128_G2 evaluateCommitments(const vector <libff::alt_bn128_G2> &_commitments, int _ind) {
+    vector <libff::alt_bn128_Fr> powers(_commitments.size());
+    libff::alt_bn128_Fr x(_ind + 1);
+    libff::alt_bn128_Fr power = libff::alt_bn128_Fr::one();
+
+    for (auto &&p : powers) {
+        p = power;
+        power = power * x;
+    }
+
+    return libff::multi_exp<libff::alt_bn128_G2, libff::alt_bn128_Fr, libff::multi_exp_method_BDLO12>(
+            _commitments.cbegin(), _commitments.cend(), powers.cbegin(), powers.cend(), 1);
+}
+
+static libff::alt_bn128_G2 limbsToG2(const uint64_t *_limbs) {
+    libff::alt_bn128_G2 point;
+    libff::alt_bn128_Fq *coords[4] = {&point.X.c0, &point.X.c1, &point.Y.c0, &point.Y.c1};
+
+    for (int j = 0; j < 4; j++) {
+        libff::bigint<libff::alt_bn128_q_limbs> value;
+        for (int i = 0; i < BLS_FQ_LIMBS; i++) {
+            value.data[i] = _limbs[j * BLS_FQ_LIMBS + i];
+        }
+        *coords[j] = libff::alt_bn128_Fq(value);
+    }
+
+    point.Z = libff::alt_bn128_Fq2::one();
+    return point;
+}
+
+// The enclave only decrypts the share and returns s * G2. Evaluating the commitments is public,
+// so it runs here
 bool
 verifySharesV2(const char *publicShares, const char *encr_sshare, const char *encryptedKeyHex, int t, int n, int ind) {
 
@@ -362,39 +489,124 @@ verifySharesV2(const char *publicShares, const char *encr_sshare, const char *en
     CHECK_STATE(encr_sshare);
     CHECK_STATE(encryptedKeyHex);
 
-    vector<char> errMsg(BUF_LEN, 0);
+    vector <libff::alt_bn128_G2> commitments;
+    if (strlen(publicShares) < 256 * (uint64_t) t || !parseCommitments(publicShares, t, commitments)) {
+        throw SGXException(VERIFY_SHARES_V2_INVALID_PUBLIC_SHARES, string(__FUNCTION__) + ":Invalid public shares");
+    }
+
+    ScratchBuffer errMsg(BUF_LEN);
     int errStatus = 0;
     uint64_t decKeyLen = 0;
-    int result = 0;
+    uint64_t shareG2[BLS_G2_LIMBS];
 
     SAFE_UINT8_BUF(encr_key, BUF_LEN);
     if (!hex2carray(encryptedKeyHex, &decKeyLen, encr_key, BUF_LEN)) {
         throw SGXException(VERIFY_SHARES_V2_INVALID_POLY_HEX, string(__FUNCTION__) + ":Invalid encryptedPolyHex");
     }
 
-    SAFE_CHAR_BUF(pshares, 8193);
-    strncpy(pshares, publicShares, strlen(publicShares));
-
     sgx_status_t status = SGX_SUCCESS;
 
-    status = trustedDkgVerifyV2(eid, &errStatus, errMsg.data(), pshares, encr_sshare, encr_key, decKeyLen, t,
-                                ind, &result);
+    status = ECALL(trustedDkgShareG2, eid, &errStatus, errMsg.data(), encr_sshare, encr_key, decKeyLen, shareG2);
 
     HANDLE_TRUSTED_FUNCTION_ERROR(status, errStatus, errMsg.data());
 
-    if (result == 2) {
-        throw SGXException(VERIFY_SHARES_V2_INVALID_PUBLIC_SHARES, string(__FUNCTION__) + ":Invalid public shares");
+    return evaluateCommitments(commitments, ind) == limbsToG2(shareG2);
+}
+
+void eraseDkgPoly(const char *encryptedPolyHex) {
+    CHECK_STATE(encryptedPolyHex);
+
+    ScratchBuffer errMsg(BUF_LEN);
+    vector <uint8_t> encrDKGPoly(DKG_MAX_SEALED_LEN, 0);
+    int errStatus = 0;
+    uint64_t encLen = 0;
+
+    if (!hex2carray(encryptedPolyHex, &encLen, encrDKGPoly.data(), DKG_MAX_SEALED_LEN)) {
+        throw SGXException(GET_SS_V2_INVALID_HEX, string(__FUNCTION__) + ":Invalid encrypted poly Hex");
     }
 
-    return result;
+    READ_LOCK(sgxInitMutex);
+
+    sgx_status_t status = SGX_SUCCESS;
+    status = ECALL(trustedEraseDkgPoly, eid, &errStatus, errMsg.data(), encrDKGPoly.data(), encLen);
+
+    HANDLE_TRUSTED_FUNCTION_ERROR(status, errStatus, errMsg.data());
+}
+
+vector<bool> verifySharesBatch(const vector<string> &publicShares, const vector<string> &secretShares,
+                               const char *encryptedKeyHex, int t, int ind) {
+    CHECK_STATE(encryptedKeyHex);
+    CHECK_STATE(publicShares.size() == secretShares.size());
+    CHECK_STATE(!publicShares.empty() && publicShares.size() <= MAX_DKG_SHARES_BATCH_SIZE);
+
+    uint64_t numShares = publicShares.size();
+    uint64_t slotLen = 256 * (uint64_t) t;
+
+    ScratchBuffer errMsg(BUF_LEN);
+    int errStatus = 0;
+    uint64_t decKeyLen = 0;
+
+    SAFE_UINT8_BUF(encr_key, BUF_LEN);
+    if (!hex2carray(encryptedKeyHex, &decKeyLen, encr_key, BUF_LEN)) {
+        throw SGXException(VERIFY_SHARES_V2_INVALID_POLY_HEX, string(__FUNCTION__) + ":Invalid encryptedPolyHex");
+    }
+
+    vector<char> sShares(numShares * DKG_BATCH_SHARE_SLOT_LEN, 0);
+
+    for (uint64_t i = 0; i < numShares; i++) {
+        CHECK_STATE(publicShares[i].length() == slotLen);
+        CHECK_STATE(secretShares[i].length() < DKG_BATCH_SHARE_SLOT_LEN);
+        memcpy(sShares.data() + i * DKG_BATCH_SHARE_SLOT_LEN, secretShares[i].data(), secretShares[i].length());
+    }
+
+    // all commitments of all dealers are checked across cores before the ECALL
+    vector <vector<libff::alt_bn128_G2>> commitments(numShares, vector<libff::alt_bn128_G2>(t));
+    vector<int> validCommitments(numShares * t, 0);
+
+    parallelFor(numShares * t, [&](size_t k) {
+        validCommitments[k] = parseCommitment(publicShares[k / t].c_str() + 256 * (k % t), commitments[k / t][k % t]);
+    });
+
+    vector<int> decrypted(numShares, 0);
+    vector<uint64_t> shareG2s(numShares * BLS_G2_LIMBS, 0);
+
+    {
+        READ_LOCK(sgxInitMutex);
+
+        sgx_status_t status = SGX_SUCCESS;
+        status = ECALL(trustedDkgShareG2Batch, eid, &errStatus, errMsg.data(), sShares.data(), sShares.size(),
+                       numShares, encr_key, decKeyLen, shareG2s.data(), shareG2s.size() * sizeof(uint64_t),
+                       decrypted.data());
+
+        HANDLE_TRUSTED_FUNCTION_ERROR(status, errStatus, errMsg.data());
+    }
+
+    // a dealer with bad commitments or a share that does not decrypt fails alone
+    vector<int> valid(numShares, 0);
+
+    parallelFor(numShares, [&](size_t i) {
+        bool parsed = all_of(validCommitments.begin() + i * t, validCommitments.begin() + (i + 1) * t,
+                             [](int _valid) { return _valid == 1; });
+        if (decrypted[i] == 1 && parsed) {
+            valid[i] = evaluateCommitments(commitments[i], ind) == limbsToG2(shareG2s.data() + i * BLS_G2_LIMBS);
+        }
+    });
+
+    return vector<bool>(valid.begin(), valid.end());
 }
 
-bool createBLSShare(const string &blsKeyName, const char *s_shares, const char *encryptedKeyHex) {
+string getBLSPubKeyString(const char *encryptedKeyHex) {
+    auto pubKeyVect = getBLSPubKey(encryptedKeyHex);
+    return pubKeyVect.at(0) + ":" + pubKeyVect.at(1) + ":" + pubKeyVect.at(2) + ":" + pubKeyVect.at(3);
+}
+
+bool createBLSShare(const string &blsKeyName, const char *s_shares, const char *encryptedKeyHex,
+                    const vector<string> &keysToDelete) {
 
     CHECK_STATE(s_shares);
     CHECK_STATE(encryptedKeyHex);
 
-    vector<char> errMsg(BUF_LEN, 0);
+    ScratchBuffer errMsg(BUF_LEN);
     int errStatus = 0;
 
     uint64_t decKeyLen;SAFE_UINT8_BUF(encr_bls_key, BUF_LEN);SAFE_UINT8_BUF(encr_key, BUF_LEN);
@@ -406,25 +618,71 @@ bool createBLSShare(const string &blsKeyName, const char *s_shares, const char *
 
     sgx_status_t status = SGX_SUCCESS;
 
-    status = trustedCreateBlsKey(eid, &errStatus, errMsg.data(), s_shares, encr_key, decKeyLen, encr_bls_key,
-                                 &enc_bls_len);
+    status = ECALL(trustedCreateBlsKey, eid, &errStatus, errMsg.data(), s_shares, encr_key, decKeyLen, encr_bls_key,
+                                        &enc_bls_len);
 
     HANDLE_TRUSTED_FUNCTION_ERROR(status, errStatus, errMsg.data());
 
     vector<char> hexBLSKey = carray2Hex(encr_bls_key, enc_bls_len);
 
-    SGXWalletServer::writeDataToDB(blsKeyName, hexBLSKey.data());
+    SGXWalletServer::writeBatchToDB({{blsKeyName, hexBLSKey.data()},
+                                     {SGXWalletServer::getBLSPubKeyName(blsKeyName),
+                                      getBLSPubKeyString(hexBLSKey.data())}}, keysToDelete);
 
     return true;
 
 }
 
-bool createBLSShareV2(const string &blsKeyName, const char *s_shares, const char *encryptedKeyHex) {
+// secp256k1 is y^2 = x^3 + 7 over p
+static bool isSecp256k1Point(const char *_x, const char *_y) {
+    static const char *P_HEX = "FFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFEFFFFFC2F";
+
+    mpz_t p, x, y, lhs, rhs;
+    mpz_inits(p, x, y, lhs, rhs, NULL);
+
+    bool result = mpz_set_str(p, P_HEX, 16) == 0 && mpz_set_str(x, _x, 16) == 0 && mpz_set_str(y, _y, 16) == 0 &&
+                  mpz_cmp(x, p) < 0 && mpz_cmp(y, p) < 0;
+
+    if (result) {
+        mpz_mul(lhs, y, y);
+        mpz_mod(lhs, lhs, p);
+        mpz_powm_ui(rhs, x, 3, p);
+        mpz_add_ui(rhs, rhs, 7);
+        mpz_mod(rhs, rhs, p);
+        result = mpz_cmp(lhs, rhs) == 0;
+    }
+
+    mpz_clears(p, x, y, lhs, rhs, NULL);
+
+    return result;
+}
+
+bool checkSecretSharesV2(const string &_secretShares, int _n) {
+    if (_n <= 0 || _secretShares.length() != (uint64_t) _n * 192) {
+        return false;
+    }
+
+    atomic<bool> valid(true);
+
+    parallelFor(_n, [&](size_t i) {
+        auto share = _secretShares.substr(192 * i, 192);
+
+        if (!valid || !checkHex(share, 96) ||
+            !isSecp256k1Point(share.substr(64, 64).c_str(), share.substr(128, 64).c_str())) {
+            valid = false;
+        }
+    });
+
+    return valid;
+}
+
+bool createBLSShareV2(const string &blsKeyName, const char *s_shares, const char *encryptedKeyHex,
+                    const vector<string> &keysToDelete) {
 
     CHECK_STATE(s_shares);
     CHECK_STATE(encryptedKeyHex);
 
-    vector<char> errMsg(BUF_LEN, 0);
+    ScratchBuffer errMsg(BUF_LEN);
     int errStatus = 0;
 
     uint64_t decKeyLen;
@@ -439,24 +697,38 @@ bool createBLSShareV2(const string &blsKeyName, const char *s_shares, const char
 
     sgx_status_t status = SGX_SUCCESS;
 
-    status = trustedCreateBlsKeyV2(eid, &errStatus, errMsg.data(), s_shares, encr_key, decKeyLen, encr_bls_key,
-                                 &enc_bls_len);
+    status = ECALL(trustedCreateBlsKeyV2, eid, &errStatus, errMsg.data(), s_shares, encr_key, decKeyLen, encr_bls_key,
+                                        &enc_bls_len);
 
     HANDLE_TRUSTED_FUNCTION_ERROR(status, errStatus, errMsg.data());
 
     vector<char> hexBLSKey = carray2Hex(encr_bls_key, enc_bls_len);
 
-    SGXWalletServer::writeDataToDB(blsKeyName, hexBLSKey.data());
+    SGXWalletServer::writeBatchToDB({{blsKeyName, hexBLSKey.data()},
+                                     {SGXWalletServer::getBLSPubKeyName(blsKeyName),
+                                      getBLSPubKeyString(hexBLSKey.data())}}, keysToDelete);
 
     return true;
 
 }
 
+// the public key is a function of the encrypted key, so it is computed in the enclave only once per key
 vector <string> getBLSPubKey(const char *encryptedKeyHex) {
 
     CHECK_STATE(encryptedKeyHex);
 
-    vector<char> errMsg1(BUF_LEN, 0);
+    static mutex pubKeysMutex;
+    static map<string, vector<string>> pubKeys;
+
+    {
+        lock_guard<mutex> lock(pubKeysMutex);
+        auto it = pubKeys.find(encryptedKeyHex);
+        if (it != pubKeys.end()) {
+            return it->second;
+        }
+    }
+
+    ScratchBuffer errMsg1(BUF_LEN);
 
     int errStatus = 0;
     uint64_t decKeyLen = 0;
@@ -471,7 +743,7 @@ vector <string> getBLSPubKey(const char *encryptedKeyHex) {
 
     sgx_status_t status = SGX_SUCCESS;
 
-    status = trustedGetBlsPubKey(eid, &errStatus, errMsg1.data(), encrKey, decKeyLen, pubKey);
+    status = ECALL(trustedGetBlsPubKey, shardEid(encrKey, decKeyLen), &errStatus, errMsg1.data(), encrKey, decKeyLen, pubKey);
 
     HANDLE_TRUSTED_FUNCTION_ERROR(status, errStatus, errMsg1.data());
 
@@ -481,6 +753,14 @@ vector <string> getBLSPubKey(const char *encryptedKeyHex) {
     for (int i = 0; i < 4; i++)
         spdlog::debug("{}", pubKeyVect.at(i));
 
+    lock_guard<mutex> lock(pubKeysMutex);
+
+    if (pubKeys.size() >= BLS_PUBKEY_CACHE_MAX_ENTRIES) {
+        pubKeys.clear();
+    }
+
+    pubKeys[encryptedKeyHex] = pubKeyVect;
+
     return pubKeyVect;
 }
 
@@ -492,36 +772,62 @@ vector <string> calculateAllBlsPublicKeys(const vector <string> &public_shares)
 
     vector <libff::alt_bn128_G2> public_keys(n, libff::alt_bn128_G2::zero());
 
+    // public_values[j] is the sum of the j-th coefficient commitments of all participants,
+    // each thread owns a set of columns j
     vector <libff::alt_bn128_G2> public_values(t, libff::alt_bn128_G2::zero());
-    for (size_t i = 0; i < n; ++i) {
-        for (size_t j = 0; j < t; ++j) {
+    atomic<bool> invalidShare(false);
+
+    parallelFor(t, [&](size_t j) {
+        for (size_t i = 0; i < n && !invalidShare; ++i) {
             libff::alt_bn128_G2 public_share;
 
-            uint64_t pos0 = share_length * j;
-            string x_c0_str = convertHexToDec(public_shares[i].substr(pos0, coord_length));
-            string x_c1_str = convertHexToDec(public_shares[i].substr(pos0 + coord_length, coord_length));
-            string y_c0_str = convertHexToDec(public_shares[i].substr(pos0 + 2 * coord_length, coord_length));
-            string y_c1_str = convertHexToDec(public_shares[i].substr(pos0 + 3 * coord_length, coord_length));
+            if (public_shares[i].length() < share_length * (j + 1)) {
+                invalidShare = true;
+                return;
+            }
+
+            const char *share = public_shares[i].c_str() + share_length * j;
 
-            if (x_c0_str == "" || x_c1_str == "" || y_c0_str == "" || y_c1_str == "") {
-                return {};
+            if (!hexToFq(share, public_share.X.c0) ||
+                !hexToFq(share + coord_length, public_share.X.c1) ||
+                !hexToFq(share + 2 * coord_length, public_share.Y.c0) ||
+                !hexToFq(share + 3 * coord_length, public_share.Y.c1)) {
+                invalidShare = true;
+                return;
             }
 
-            public_share.X.c0 = libff::alt_bn128_Fq(x_c0_str.c_str());
-            public_share.X.c1 = libff::alt_bn128_Fq(x_c1_str.c_str());
-            public_share.Y.c0 = libff::alt_bn128_Fq(y_c0_str.c_str());
-            public_share.Y.c1 = libff::alt_bn128_Fq(y_c1_str.c_str());
             public_share.Z = libff::alt_bn128_Fq2::one();
 
             public_values[j] = public_values[j] + public_share;
         }
+    });
+
+    if (invalidShare) {
+        return {};
     }
 
-    for (size_t i = 0; i < n; ++i) {
-        for (size_t j = 0; j < t; ++j) {
-            public_keys[i] = public_keys[i] + libff::power(libff::alt_bn128_Fr(i + 1), j) * public_values[j];
+    // Horner evaluation of sum_j (i + 1)^j * public_values[j], the scalar i + 1 is a single small limb
+    if (t > 0) {
+        parallelFor(n, [&](size_t i) {
+            libff::bigint<1> x(i + 1);
+            libff::alt_bn128_G2 acc = public_values[t - 1];
+            for (size_t j = t - 1; j-- > 0;) {
+                acc = x * acc + public_values[j];
+            }
+            public_keys[i] = acc;
+        });
+    }
+
+    // one field inversion for all keys instead of one per key
+    bool allNonZero = all_of(public_keys.begin(), public_keys.end(),
+                             [](const libff::alt_bn128_G2 &_key) { return !_key.is_zero(); });
+
+    if (allNonZero) {
+        libff::alt_bn128_G2::batch_to_special_all_non_zeros(public_keys);
+    } else {
+        for (auto &&key : public_keys) {
+            key.to_affine_coordinates();
         }
-        public_keys[i].to_affine_coordinates();
     }
 
     vector <string> result(n);
@@ -533,7 +839,7 @@ vector <string> calculateAllBlsPublicKeys(const vector <string> &public_shares)
 }
 
 string decryptDHKey(const string &polyName, int ind) {
-    vector<char> errMsg1(BUF_LEN, 0);
+    ScratchBuffer errMsg1(BUF_LEN);
     int errStatus = 0;
 
     string DH_key_name = polyName + "_" + to_string(ind) + ":";
@@ -555,21 +861,183 @@ string decryptDHKey(const string &polyName, int ind) {
 
     sgx_status_t status = SGX_SUCCESS;
 
-    status = trustedDecryptKey(eid, &errStatus, errMsg1.data(), encryptedDHKey, dhEncLen, DHKey);
+    status = ECALL(trustedDecryptKey, eid, &errStatus, errMsg1.data(), encryptedDHKey, dhEncLen, DHKey);
 
     HANDLE_TRUSTED_FUNCTION_ERROR(status, errStatus, errMsg1.data())
 
     return DHKey;
 }
 
+// fixed base window table of the G2 generator, built on first use
+static const libff::window_table<libff::alt_bn128_G2> &getG2GeneratorTable() {
+    static const auto table = libff::get_window_table(libff::alt_bn128_Fr::size_in_bits(), MULT_G2_WINDOW_SIZE,
+                                                      libff::alt_bn128_G2::one());
+    return table;
+}
+
+static libff::alt_bn128_G2 multG2Generator(const string &_x) {
+    libff::alt_bn128_Fr el(_x.c_str());
+    return libff::windowed_exp(libff::alt_bn128_Fr::size_in_bits(), MULT_G2_WINDOW_SIZE, getG2GeneratorTable(), el);
+}
+
+static vector <string> affineG2ToStrings(const libff::alt_bn128_G2 &_point) {
+    return {ConvertToString(_point.X.c0), ConvertToString(_point.X.c1), ConvertToString(_point.Y.c0),
+            ConvertToString(_point.Y.c1)};
+}
+
 vector <string> mult_G2(const string &x) {
-    vector <string> result(4);
-    libff::alt_bn128_Fr el(x.c_str());
-    libff::alt_bn128_G2 elG2 = el * libff::alt_bn128_G2::one();
+    libff::alt_bn128_G2 elG2 = multG2Generator(x);
     elG2.to_affine_coordinates();
-    result[0] = ConvertToString(elG2.X.c0);
-    result[1] = ConvertToString(elG2.X.c1);
-    result[2] = ConvertToString(elG2.Y.c0);
-    result[3] = ConvertToString(elG2.Y.c1);
+    return affineG2ToStrings(elG2);
+}
+
+vector <vector<string>> multG2Batch(const vector <string> &_xs) {
+    vector <libff::alt_bn128_G2> points(_xs.size());
+
+    parallelFor(_xs.size(), [&](size_t i) {
+        points[i] = multG2Generator(_xs[i]);
+    }, MULT_G2_MIN_PARALLEL_BATCH);
+
+    // one field inversion for the batch, zero points have no affine form and are converted one by one
+    bool allNonZero = all_of(points.begin(), points.end(),
+                             [](const libff::alt_bn128_G2 &_point) { return !_point.is_zero(); });
+
+    if (allNonZero) {
+        libff::alt_bn128_G2::batch_to_special_all_non_zeros(points);
+    } else {
+        for (auto &&point : points) {
+            point.to_affine_coordinates();
+        }
+    }
+
+    vector <vector<string>> result(points.size());
+    for (size_t i = 0; i < points.size(); i++) {
+        result[i] = affineG2ToStrings(points[i]);
+    }
+
     return result;
 }
+
+bool decToFq(const string &_dec, libff::alt_bn128_Fq &_result) {
+    if (_dec.empty() || _dec.size() > 78 || !all_of(_dec.begin(), _dec.end(), ::isdigit)) {
+        return false;
+    }
+
+    mpz_t value, modulus;
+    mpz_init_set_str(value, _dec.c_str(), 10);
+    mpz_init(modulus);
+    libff::alt_bn128_modulus_q.to_mpz(modulus);
+
+    bool reduced = mpz_cmp(value, modulus) < 0;
+    if (reduced) {
+        _result = libff::alt_bn128_Fq(libff::bigint<libff::alt_bn128_q_limbs>(value));
+    }
+
+    mpz_clear(value);
+    mpz_clear(modulus);
+
+    return reduced;
+}
+
+// Lagrange coefficients at zero of the sorted 1-based signer indices. A chain keeps signing with the
+// same committee, so the coefficients of recent signer sets are cached.
+static vector <libff::alt_bn128_Fr> getLagrangeCoeffs(const vector <size_t> &_indices) {
+    static mutex coeffsMutex;
+    static map<string, vector<libff::alt_bn128_Fr>> coeffsCache;
+
+    string key;
+    for (auto &&index : _indices) {
+        key += to_string(index) + ",";
+    }
+
+    {
+        lock_guard<mutex> lock(coeffsMutex);
+        auto it = coeffsCache.find(key);
+        if (it != coeffsCache.end()) {
+            return it->second;
+        }
+    }
+
+    // lambda_i = prod_{j != i} x_j / (x_j - x_i)
+    vector <libff::alt_bn128_Fr> coeffs(_indices.size());
+
+    for (size_t i = 0; i < _indices.size(); i++) {
+        libff::alt_bn128_Fr numerator = libff::alt_bn128_Fr::one();
+        libff::alt_bn128_Fr denominator = libff::alt_bn128_Fr::one();
+
+        for (size_t j = 0; j < _indices.size(); j++) {
+            if (j == i) {
+                continue;
+            }
+            libff::alt_bn128_Fr xj((long) _indices[j]);
+            numerator *= xj;
+            denominator *= xj - libff::alt_bn128_Fr((long) _indices[i]);
+        }
+
+        coeffs[i] = numerator * denominator.inverse();
+    }
+
+    lock_guard<mutex> lock(coeffsMutex);
+
+    if (coeffsCache.size() >= LAGRANGE_COEFFS_CACHE_MAX_ENTRIES) {
+        coeffsCache.clear();
+    }
+
+    coeffsCache[key] = coeffs;
+
+    return coeffs;
+}
+
+string aggregateBLSSignatures(const vector <string> &_shares, const vector <size_t> &_signerIndices, int _t, int _n) {
+    CHECK_STATE(_t > 0 && _n >= _t);
+
+    if (_shares.size() != (size_t) _t || _signerIndices.size() != _shares.size()) {
+        throw SGXException(INVALID_BLS_SIG_SHARES, string(__FUNCTION__) + ":Need exactly t signature shares");
+    }
+
+    // sorting makes the cache key independent of the order the shares were collected in
+    vector <size_t> order(_shares.size());
+    for (size_t i = 0; i < order.size(); i++) {
+        order[i] = i;
+    }
+    sort(order.begin(), order.end(), [&](size_t _a, size_t _b) { return _signerIndices[_a] < _signerIndices[_b]; });
+
+    vector <size_t> indices(order.size());
+    vector <libff::alt_bn128_G1> points(order.size());
+    string hint;
+
+    for (size_t i = 0; i < order.size(); i++) {
+        indices[i] = _signerIndices[order[i]];
+
+        if (indices[i] < 1 || indices[i] > (size_t) _n || (i > 0 && indices[i] == indices[i - 1])) {
+            throw SGXException(INVALID_BLS_SIG_SHARES, string(__FUNCTION__) + ":Invalid signer index");
+        }
+
+        // a share is "X:Y:hint", the hint of the hashed message has two parts
+        auto parts = splitString(_shares[order[i]].c_str(), ':');
+        if (parts.size() != 4) {
+            throw SGXException(INVALID_BLS_SIG_SHARES, string(__FUNCTION__) + ":Invalid signature share");
+        }
+
+        auto shareHint = parts[2] + ":" + parts[3];
+        if (i == 0) {
+            hint = shareHint;
+        } else if (shareHint != hint) {
+            throw SGXException(INVALID_BLS_SIG_SHARES, string(__FUNCTION__) + ":Shares sign different hashes");
+        }
+
+        points[i].Z = libff::alt_bn128_Fq::one();
+        if (!decToFq(parts[0], points[i].X) || !decToFq(parts[1], points[i].Y) || !points[i].is_well_formed()) {
+            throw SGXException(INVALID_BLS_SIG_SHARES, string(__FUNCTION__) + ":Signature share is not a G1 point");
+        }
+    }
+
+    auto coeffs = getLagrangeCoeffs(indices);
+
+    auto signature = libff::multi_exp<libff::alt_bn128_G1, libff::alt_bn128_Fr, libff::multi_exp_method_BDLO12>(
+            points.cbegin(), points.cend(), coeffs.cbegin(), coeffs.cend(), 1);
+
+    signature.to_affine_coordinates();
+
+    return ConvertToString(signature.X) + ":" + ConvertToString(signature.Y) + ":" + hint;
+}
@@ -33,9 +33,18 @@ using namespace std;
 
 string gen_dkg_poly( int _t);
 
+// _numPolys encrypted polys of degree _t - 1 as hex, each with its verification vector string,
+// generated in one ECALL
+vector<pair<string, string>> genDkgPolyBatch(uint64_t _numPolys, int _t);
+
+// the t G2 commitments of the poly as "x0:x1:y0:y1,..."
+string getVerificationVectorString(const string& encryptedPolyHex, int t);
+
+vector <vector<string>> parseVerificationVector(const string& _verificationVector);
+
 vector <vector<string>> get_verif_vect(const string& encryptedPolyHex, int t);
 
-vector <vector<string>> getVerificationVectorMult(const std::string& encryptedPolyHex, int t, int n, size_t ind);
+vector <vector<string>> getVerificationVectorMult(const vector <vector<string>>& verificationVector, int t, size_t ind);
 
 string getSecretShares(const string& _polyName, const char* _encryptedPolyHex, const vector<string>& _publicKeys, int _t, int _n);
 
@@ -45,22 +54,47 @@ bool verifyShares(const char* publicShares, const char* encr_sshare, const char
 
 bool verifySharesV2(const char* publicShares, const char* encr_sshare, const char * encryptedKeyHex, int t, int n, int ind);
 
+// drops the decrypted poly from the enclave poly cache once the DKG is complete
+void eraseDkgPoly(const char* encryptedPolyHex);
+
+// verifies the shares of all dealers in one ECALL, result i is true if the share of dealer i is valid
+vector<bool> verifySharesBatch(const vector<string>& publicShares, const vector<string>& secretShares,
+                               const char* encryptedKeyHex, int t, int ind);
+
 string decryptDHKey(const string& polyName, int ind);
 
-bool createBLSShare( const string& blsKeyName, const char * s_shares, const char * encryptedKeyHex);
+bool createBLSShare( const string& blsKeyName, const char * s_shares, const char * encryptedKeyHex,
+                     const vector<string>& keysToDelete = {});
 
-bool createBLSShareV2( const string& blsKeyName, const char * s_shares, const char * encryptedKeyHex);
+// each of the _n 192 digit secret shares is hex and ends with a DH public key on secp256k1,
+// the shares are checked in parallel before the enclave recovers the session keys
+bool checkSecretSharesV2(const string& _secretShares, int _n);
+
+bool createBLSShareV2( const string& blsKeyName, const char * s_shares, const char * encryptedKeyHex,
+                     const vector<string>& keysToDelete = {});
 
 vector<string> getBLSPubKey(const char * encryptedKeyHex);
 
+// public key in the "x0:x1:y0:y1" form stored next to each BLS key
+string getBLSPubKeyString(const char * encryptedKeyHex);
+
 vector<string> mult_G2(const string& x);
 
+// x * G2 for every decimal scalar x, in affine coordinates
+vector<vector<string>> multG2Batch(const vector<string>& _xs);
+
 string convertHexToDec(const string& hex_str);
 
+// parses a decimal coordinate, rejects values that are not reduced mod q
+bool decToFq(const string& _dec, libff::alt_bn128_Fq& _result);
+
 string convertG2ToString(const libff::alt_bn128_G2& elem, int base = 10, const string& delim = ":");
 
 vector<string> calculateAllBlsPublicKeys(const vector<string>& public_shares);
 
+// threshold signature "X:Y:hint" recovered from t shares of the signers with the given 1-based indices
+string aggregateBLSSignatures(const vector<string>& _shares, const vector<size_t>& _signerIndices, int _t, int _n);
+
 bool testCreateBLSShare( const char * s_shares);
 
 #endif //SGXD_DKGCRYPTO_H
@@ -0,0 +1,142 @@
+/*
+    Copyright (C) 2021-Present SKALE Labs
+
+    This file is part of sgxwallet.
+
+    sgxwallet is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as published
+    by the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    sgxwallet is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with sgxwallet. If not, see <https://www.gnu.org/licenses/>.
+
+    @file DKGGarbageCollector.cpp
+    @author Stan Kladko
+    @date 2021
+*/
+
+#include <ctime>
+#include <unistd.h>
+#include <vector>
+
+#include "sgxwallet_common.h"
+#include "SGXException.h"
+#include "ExitHandler.h"
+#include "LevelDB.h"
+#include "zmq_src/KeyOwnerIndex.h"
+#include "zmq_src/ZMQMessage.h"
+#include "LatencySLO.h"
+#include "third_party/spdlog/spdlog.h"
+#include "common.h"
+
+#include "DKGGarbageCollector.h"
+
+uint64_t DKGGarbageCollector::retentionSeconds = 0;
+atomic<bool> DKGGarbageCollector::exitRequested(false);
+shared_ptr<thread> DKGGarbageCollector::gcThread = nullptr;
+mutex DKGGarbageCollector::collectMutex;
+atomic<uint64_t> DKGGarbageCollector::runs(0);
+atomic<uint64_t> DKGGarbageCollector::keysDeleted(0);
+atomic<uint64_t> DKGGarbageCollector::bytesReclaimed(0);
+
+static const vector<string> DKG_INTERMEDIATE_PREFIXES = {"POLY:", "VV_POLY:", "DKG_DH_KEY_POLY:", "shareG2_POLY:",
+                                                         "encryptedSecretShare:POLY:"};
+
+void DKGGarbageCollector::setRetentionHours(uint64_t _retentionHours) {
+    if (_retentionHours > MAX_DKG_GC_RETENTION_HOURS) {
+        throw SGXException(INVALID_DKG_GC_RETENTION,
+                           "DKG garbage collection retention should not exceed " +
+                           to_string(MAX_DKG_GC_RETENTION_HOURS) + " hours");
+    }
+    retentionSeconds = _retentionHours * 3600;
+}
+
+uint64_t DKGGarbageCollector::collect(uint64_t _cutoffTimestamp) {
+    lock_guard<mutex> lock(collectMutex);
+
+    auto db = LevelDB::getLevelDb();
+    auto sizeBefore = db->getApproximateSize();
+    uint64_t deleted = 0;
+
+    while (true) {
+        auto names = db->getKeysCreatedBefore(_cutoffTimestamp, DKG_INTERMEDIATE_PREFIXES, DKG_GC_BATCH_SIZE);
+        if (names.empty()) {
+            break;
+        }
+        db->deleteKeys(names);
+        deleted += names.size();
+
+        // a poly name that is used again must not keep the owner of the deleted poly
+        vector<string> ownedKeys;
+        auto ownerSuffix = KeyOwnerIndex::getOwnerKeyName("");
+        for (auto &&name : names) {
+            if (name.size() > ownerSuffix.size() &&
+                name.compare(name.size() - ownerSuffix.size(), ownerSuffix.size(), ownerSuffix) == 0) {
+                ownedKeys.push_back(name.substr(0, name.size() - ownerSuffix.size()));
+            }
+        }
+        ZMQMessage::forgetKeyOwners(ownedKeys);
+    }
+
+    if (deleted > 0) {
+        db->compact();
+        auto sizeAfter = db->getApproximateSize();
+        if (sizeBefore > sizeAfter) {
+            bytesReclaimed += sizeBefore - sizeAfter;
+        }
+        spdlog::info("DKG garbage collection deleted {} keys", deleted);
+    }
+
+    runs++;
+    keysDeleted += deleted;
+
+    return deleted;
+}
+
+void DKGGarbageCollector::gcLoop() {
+    while (!exitRequested && !ExitHandler::shouldExit()) {
+        // the deletes and the compaction compete with signing for the disk and the CPU
+        if (LatencySLO::deferBackgroundWork("DKG garbage collection")) {
+            sleep(1);
+            continue;
+        }
+
+        try {
+            collect(time(nullptr) - retentionSeconds);
+        } catch (SGXException &e) {
+            spdlog::error("DKG garbage collection failed: {}", e.getMessage());
+        } catch (exception &e) {
+            spdlog::error("DKG garbage collection failed: {}", e.what());
+        }
+
+        for (uint64_t i = 0; i < DKG_GC_INTERVAL_SECONDS && !exitRequested && !ExitHandler::shouldExit(); i++) {
+            sleep(1);
+        }
+    }
+}
+
+void DKGGarbageCollector::initGC() {
+    if (retentionSeconds == 0) {
+        spdlog::info("DKG garbage collection disabled");
+        return;
+    }
+
+    CHECK_STATE(!gcThread);
+
+    spdlog::info("Starting DKG garbage collection, retention {} hours", retentionSeconds / 3600);
+    gcThread = make_shared<thread>(gcLoop);
+}
+
+void DKGGarbageCollector::exitGC() {
+    exitRequested = true;
+    if (gcThread) {
+        gcThread->join();
+        gcThread = nullptr;
+    }
+}
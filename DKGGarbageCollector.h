@@ -0,0 +1,77 @@
+/*
+    Copyright (C) 2021-Present SKALE Labs
+
+    This file is part of sgxwallet.
+
+    sgxwallet is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as published
+    by the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    sgxwallet is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with sgxwallet. If not, see <https://www.gnu.org/licenses/>.
+
+    @file DKGGarbageCollector.h
+    @author Stan Kladko
+    @date 2021
+*/
+
+#ifndef SGXWALLET_DKGGARBAGECOLLECTOR_H
+#define SGXWALLET_DKGGARBAGECOLLECTOR_H
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+using namespace std;
+
+// Background task that removes DKG intermediates (polys, DH keys, shareG2 and
+// encrypted secret shares) older than the retention period. Completed DKGs clean
+// up after themselves in createBLSPrivateKey, so this only reclaims abandoned rounds.
+class DKGGarbageCollector {
+
+    static uint64_t retentionSeconds;
+
+    static atomic<bool> exitRequested;
+
+    static shared_ptr<thread> gcThread;
+
+    static mutex collectMutex;
+
+    static atomic<uint64_t> runs;
+
+    static atomic<uint64_t> keysDeleted;
+
+    static atomic<uint64_t> bytesReclaimed;
+
+    static void gcLoop();
+
+public:
+
+    // zero retention disables the collector
+    static void setRetentionHours(uint64_t _retentionHours);
+
+    static uint64_t getRetentionSeconds() { return retentionSeconds; }
+
+    static void initGC();
+
+    static void exitGC();
+
+    // deletes DKG intermediates created before _cutoffTimestamp and compacts the database,
+    // returns the number of deleted keys
+    static uint64_t collect(uint64_t _cutoffTimestamp);
+
+    static uint64_t getRuns() { return runs; }
+
+    static uint64_t getKeysDeleted() { return keysDeleted; }
+
+    static uint64_t getBytesReclaimed() { return bytesReclaimed; }
+};
+
+#endif //SGXWALLET_DKGGARBAGECOLLECTOR_H
@@ -0,0 +1,195 @@
+/*
+    Copyright (C) 2021-Present SKALE Labs
+
+    This file is part of sgxwallet.
+
+    sgxwallet is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as published
+    by the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    sgxwallet is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with sgxwallet. If not, see <https://www.gnu.org/licenses/>.
+
+    @file DKGTimeline.cpp
+    @author Stan Kladko
+    @date 2021
+*/
+
+
+#include <atomic>
+
+#include "sgxwallet_common.h"
+#include "common.h"
+#include "Metrics.h"
+
+#include "DKGTimeline.h"
+
+thread_local DKGTimeline::Scope *DKGTimeline::current = nullptr;
+mutex DKGTimeline::sessionsMutex;
+unordered_map<string, DKGTimeline::Session> DKGTimeline::sessions;
+deque<string> DKGTimeline::order;
+unordered_map<string, DKGTimeline::PhaseStats> DKGTimeline::pendingVerifications;
+unordered_map<string, string> DKGTimeline::blsKeyPolys;
+
+static MetricsHistogram phaseLatency[DKGTimeline::NUM_PHASES];
+static atomic<uint64_t> phaseEcallUs[DKGTimeline::NUM_PHASES];
+static atomic<uint64_t> phaseDbUs[DKGTimeline::NUM_PHASES];
+
+void DKGTimeline::PhaseStats::add(const PhaseStats &_other) {
+    calls += _other.calls;
+    wallUs += _other.wallUs;
+    ecallUs += _other.ecallUs;
+    dbUs += _other.dbUs;
+}
+
+DKGTimeline::Scope::Scope(Phase _phase, const string &_name, const string *_ethKeyName, const string *_blsKeyName)
+        : phase(_phase), name(_name), ethKeyName(_ethKeyName), blsKeyName(_blsKeyName),
+          start(chrono::steady_clock::now()), outer(current) {
+    stats.calls = 1;
+    // a phase called from another phase, such as the verifications of a batch, is part of the outer one
+    if (!outer) {
+        current = this;
+    }
+}
+
+DKGTimeline::Scope::~Scope() {
+    if (outer) {
+        return;
+    }
+    current = nullptr;
+    stats.wallUs = chrono::duration_cast<chrono::microseconds>(chrono::steady_clock::now() - start).count();
+    try {
+        DKGTimeline::record(*this);
+    } catch (...) {
+    }
+}
+
+DKGTimeline::Session &DKGTimeline::getSession(const string &_polyName, uint64_t _nowMs) {
+    auto it = sessions.find(_polyName);
+    if (it == sessions.end()) {
+        if (sessions.size() >= DKG_TIMELINE_MAX_SESSIONS) {
+            auto evicted = sessions.find(order.front());
+            if (evicted != sessions.end()) {
+                blsKeyPolys.erase(evicted->second.blsKeyName);
+                sessions.erase(evicted);
+            }
+            order.pop_front();
+        }
+        it = sessions.emplace(_polyName, Session()).first;
+        it->second.startMs = _nowMs;
+        order.push_back(_polyName);
+    }
+    it->second.lastMs = _nowMs;
+    return it->second;
+}
+
+void DKGTimeline::record(const Scope &_scope) {
+    auto phase = _scope.phase;
+    CHECK_STATE(phase >= 0 && phase < NUM_PHASES);
+
+    phaseLatency[phase].observeUs(_scope.stats.wallUs);
+    phaseEcallUs[phase].fetch_add(_scope.stats.ecallUs, memory_order_relaxed);
+    phaseDbUs[phase].fetch_add(_scope.stats.dbUs, memory_order_relaxed);
+
+    auto nowMs = (uint64_t) chrono::duration_cast<chrono::milliseconds>(
+            chrono::system_clock::now().time_since_epoch()).count();
+
+    lock_guard<mutex> lock(sessionsMutex);
+
+    switch (phase) {
+        case VERIFICATION: {
+            auto it = pendingVerifications.find(_scope.name);
+            if (it == pendingVerifications.end()) {
+                if (pendingVerifications.size() >= DKG_TIMELINE_MAX_SESSIONS) {
+                    return;
+                }
+                it = pendingVerifications.emplace(_scope.name, PhaseStats()).first;
+            }
+            it->second.add(_scope.stats);
+            return;
+        }
+        case BLS_PUBLIC_KEY_SHARE: {
+            // BLS keys that were not created by a DKG of this run have no session
+            auto it = blsKeyPolys.find(_scope.name);
+            if (it != blsKeyPolys.end()) {
+                getSession(it->second, nowMs).phases[phase].add(_scope.stats);
+            }
+            return;
+        }
+        default:
+            break;
+    }
+
+    auto &session = getSession(_scope.name, nowMs);
+    session.phases[phase].add(_scope.stats);
+
+    if (phase == CREATE_BLS_KEY && _scope.ethKeyName && _scope.blsKeyName) {
+        auto it = pendingVerifications.find(*_scope.ethKeyName);
+        if (it != pendingVerifications.end()) {
+            session.phases[VERIFICATION].add(it->second);
+            pendingVerifications.erase(it);
+        }
+        if (!session.blsKeyName.empty()) {
+            blsKeyPolys.erase(session.blsKeyName);
+        }
+        session.blsKeyName = *_scope.blsKeyName;
+        blsKeyPolys[session.blsKeyName] = _scope.name;
+    }
+}
+
+bool DKGTimeline::get(const string &_polyName, Session &_session) {
+    lock_guard<mutex> lock(sessionsMutex);
+
+    auto it = sessions.find(_polyName);
+    if (it == sessions.end()) {
+        return false;
+    }
+
+    _session = it->second;
+    return true;
+}
+
+uint64_t DKGTimeline::getNumSessions() {
+    lock_guard<mutex> lock(sessionsMutex);
+    return sessions.size();
+}
+
+const char *DKGTimeline::getName(Phase _phase) {
+    switch (_phase) {
+        case GENERATE_POLY:
+            return "generateDKGPoly";
+        case VERIFICATION_VECTOR:
+            return "getVerificationVector";
+        case SECRET_SHARE:
+            return "getSecretShare";
+        case VERIFICATION:
+            return "dkgVerification";
+        case CREATE_BLS_KEY:
+            return "createBLSPrivateKey";
+        case BLS_PUBLIC_KEY_SHARE:
+            return "getBLSPublicKeyShare";
+        default:
+            return "unknown";
+    }
+}
+
+const MetricsHistogram &DKGTimeline::getLatency(Phase _phase) {
+    CHECK_STATE(_phase >= 0 && _phase < NUM_PHASES);
+    return phaseLatency[_phase];
+}
+
+uint64_t DKGTimeline::getTotalEcallUs(Phase _phase) {
+    CHECK_STATE(_phase >= 0 && _phase < NUM_PHASES);
+    return phaseEcallUs[_phase].load(memory_order_relaxed);
+}
+
+uint64_t DKGTimeline::getTotalDbUs(Phase _phase) {
+    CHECK_STATE(_phase >= 0 && _phase < NUM_PHASES);
+    return phaseDbUs[_phase].load(memory_order_relaxed);
+}
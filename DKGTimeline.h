@@ -0,0 +1,146 @@
+/*
+    Copyright (C) 2021-Present SKALE Labs
+
+    This file is part of sgxwallet.
+
+    sgxwallet is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as published
+    by the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    sgxwallet is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with sgxwallet. If not, see <https://www.gnu.org/licenses/>.
+
+    @file DKGTimeline.h
+    @author Stan Kladko
+    @date 2021
+*/
+
+
+#ifndef SGXWALLET_DKGTIMELINE_H
+#define SGXWALLET_DKGTIMELINE_H
+
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+using namespace std;
+
+class MetricsHistogram;
+
+// Timeline of the DKG calls of each poly name: calls, wall time, ECALL time and database write
+// time per phase, answered by getDKGTimeline of the info server and exported per phase as metrics.
+// The last DKG_TIMELINE_MAX_SESSIONS poly names are kept.
+//
+// Verifications name the ECDSA key of the node, not a poly, so they are kept under the key until
+// createBLSPrivateKey names both and moves them into the session of the poly. getBLSPublicKeyShare
+// is added to the session that created the BLS key.
+class DKGTimeline {
+
+public:
+
+    enum Phase {
+        GENERATE_POLY, VERIFICATION_VECTOR, SECRET_SHARE, VERIFICATION, CREATE_BLS_KEY, BLS_PUBLIC_KEY_SHARE,
+        NUM_PHASES
+    };
+
+    struct PhaseStats {
+        uint64_t calls = 0;
+        uint64_t wallUs = 0;
+        uint64_t ecallUs = 0;
+        uint64_t dbUs = 0;
+
+        void add(const PhaseStats &_other);
+    };
+
+    struct Session {
+        // milliseconds since the epoch of the first and the last call
+        uint64_t startMs = 0;
+        uint64_t lastMs = 0;
+        PhaseStats phases[NUM_PHASES];
+        string blsKeyName;
+    };
+
+    // Times one call of a phase while alive. ECALLs and database writes of the thread are added to it.
+    // A scope opened inside another one of the same thread records nothing of its own.
+    class Scope {
+        Phase phase;
+        const string &name;
+        const string *ethKeyName;
+        const string *blsKeyName;
+        chrono::steady_clock::time_point start;
+        PhaseStats stats;
+        Scope *outer;
+
+        friend class DKGTimeline;
+
+    public:
+        // _name is the poly name, the ECDSA key name for VERIFICATION and the BLS key name for
+        // BLS_PUBLIC_KEY_SHARE. CREATE_BLS_KEY also passes the ECDSA and the BLS key names.
+        Scope(Phase _phase, const string &_name, const string *_ethKeyName = nullptr,
+              const string *_blsKeyName = nullptr);
+
+        ~Scope();
+    };
+
+private:
+
+    static thread_local Scope *current;
+
+    static mutex sessionsMutex;
+
+    static unordered_map<string, Session> sessions;
+
+    // poly names, oldest first
+    static deque<string> order;
+
+    static unordered_map<string, PhaseStats> pendingVerifications;
+
+    static unordered_map<string, string> blsKeyPolys;
+
+    static void record(const Scope &_scope);
+
+    static Session &getSession(const string &_polyName, uint64_t _nowMs);
+
+public:
+
+    static bool inPhase() { return current != nullptr; }
+
+    static void addEcallUs(uint64_t _us) {
+        if (current) {
+            current->stats.ecallUs += _us;
+        }
+    }
+
+    static void addDbUs(uint64_t _us) {
+        if (current) {
+            current->stats.dbUs += _us;
+        }
+    }
+
+    // false for a poly name without recorded calls
+    static bool get(const string &_polyName, Session &_session);
+
+    static uint64_t getNumSessions();
+
+    static const char *getName(Phase _phase);
+
+    // all calls of a phase, including those evicted from the timeline
+    static const MetricsHistogram &getLatency(Phase _phase);
+
+    static uint64_t getTotalEcallUs(Phase _phase);
+
+    static uint64_t getTotalDbUs(Phase _phase);
+};
+
+#define DKG_PHASE(__PHASE__, ...) DKGTimeline::Scope __DKG_PHASE__(DKGTimeline::__PHASE__, __VA_ARGS__);
+
+#endif //SGXWALLET_DKGTIMELINE_H
@@ -30,13 +30,18 @@
 
 #include <gmp.h>
 #include <random>
+#include <atomic>
+#include <map>
+#include <mutex>
 
 #include "third_party/spdlog/spdlog.h"
 #include "common.h"
+#include "Metrics.h"
 
 #include "secure_enclave/Verify.h"
 
 #include "CryptoTools.h"
+#include "ScratchBuffer.h"
 
 #include "SEKManager.h"
 #include "ECDSACrypto.h"
@@ -49,11 +54,11 @@ void fillRandomBuffer(vector<unsigned char> &_buffer) {
 }
 
 vector <string> genECDSAKey() {
-    vector<char> errMsg(BUF_LEN, 0);
+    ScratchBuffer errMsg(BUF_LEN);
     int errStatus = 0;
     vector <uint8_t> encr_pr_key(BUF_LEN, 0);
-    vector<char> pub_key_x(BUF_LEN, 0);
-    vector<char> pub_key_y(BUF_LEN, 0);
+    ScratchBuffer pub_key_x(BUF_LEN);
+    ScratchBuffer pub_key_y(BUF_LEN);
 
     uint64_t enc_len = 0;
 
@@ -61,9 +66,9 @@ vector <string> genECDSAKey() {
 
     int exportable = 0;
 
-    status = trustedGenerateEcdsaKey(eid, &errStatus, errMsg.data(),
-                                    &exportable, encr_pr_key.data(), &enc_len,
-                                    pub_key_x.data(), pub_key_y.data());
+    status = ECALL(trustedGenerateEcdsaKey, eid, &errStatus, errMsg.data(),
+                                           &exportable, encr_pr_key.data(), &enc_len,
+                                           pub_key_x.data(), pub_key_y.data());
 
     HANDLE_TRUSTED_FUNCTION_ERROR(status, errStatus,errMsg.data());
 
@@ -85,10 +90,32 @@ vector <string> genECDSAKey() {
     return keys;
 }
 
+static mutex pubKeysMutex;
+static map<string, string> pubKeys;
+
+void cacheECDSAPubKey(const std::string& _encryptedKeyHex, const std::string& _pubKey) {
+    lock_guard<mutex> lock(pubKeysMutex);
+
+    if (pubKeys.size() >= ECDSA_PUBKEY_CACHE_MAX_ENTRIES) {
+        pubKeys.clear();
+    }
+
+    pubKeys[_encryptedKeyHex] = _pubKey;
+}
+
+// d*G is slow in the enclave and never changes for a key
 string getECDSAPubKey(const std::string& _encryptedKeyHex) {
-    vector<char> errMsg(BUF_LEN, 0);
-    vector<char> pubKeyX(BUF_LEN, 0);
-    vector<char> pubKeyY(BUF_LEN, 0);
+    {
+        lock_guard<mutex> lock(pubKeysMutex);
+        auto it = pubKeys.find(_encryptedKeyHex);
+        if (it != pubKeys.end()) {
+            return it->second;
+        }
+    }
+
+    ScratchBuffer errMsg(ERR_STRING_LEN);
+    vector<char> pubKeyX(ECDSA_PUB_KEY_COORD_LEN, 0);
+    vector<char> pubKeyY(ECDSA_PUB_KEY_COORD_LEN, 0);
     vector<uint8_t> encrPrKey(BUF_LEN, 0);
 
     int errStatus = 0;
@@ -101,8 +128,8 @@ string getECDSAPubKey(const std::string& _encryptedKeyHex) {
 
     sgx_status_t status = SGX_SUCCESS;
 
-    status = trustedGetPublicEcdsaKey(eid, &errStatus,
-                                      errMsg.data(), encrPrKey.data(), enc_len, pubKeyX.data(), pubKeyY.data());
+    status = ECALL(trustedGetPublicEcdsaKey, shardEid(encrPrKey.data(), enc_len), &errStatus,
+                                             errMsg.data(), encrPrKey.data(), enc_len, pubKeyX.data(), pubKeyY.data());
 
     HANDLE_TRUSTED_FUNCTION_ERROR(status, errStatus, errMsg.data())
 
@@ -113,6 +140,8 @@ string getECDSAPubKey(const std::string& _encryptedKeyHex) {
         throw SGXException(666, "Incorrect pub key size");
     }
 
+    cacheECDSAPubKey(_encryptedKeyHex, pubKey);
+
     return pubKey;
 }
 
@@ -165,64 +194,154 @@ bool verifyECDSASig(string& pubKeyStr, const char *hashHex, const char *signatur
     return true;
 }
 
-vector <string> ecdsaSignHash(const std::string& encryptedKeyHex, const char *hashHex, int base) {
+// the enclave returns r and s as ECDSA_SIG_LIMBS binary limbs, they are formatted here, outside the enclave
+static string sigLimbsToString(const uint64_t *_limbs, int _base) {
+    CHECK_STATE(_limbs);
+    CHECK_STATE(_base >= 2 && _base <= 32);
 
-    CHECK_STATE(hashHex);
+    mpz_t t;
+    mpz_init(t);
+    mpz_import(t, ECDSA_SIG_LIMBS, -1, sizeof(uint64_t), 0, 0, _limbs);
 
-    vector <string> signatureVector(3);
+    SAFE_CHAR_BUF(arr, mpz_sizeinbase(t, _base) + 2);
+    mpz_get_str(arr, _base, t);
+
+    mpz_clear(t);
+
+    return arr;
+}
+
+vector <string> ecdsaSignHash(const std::string& encryptedKeyHex, const char *hashHex, int base) {
 
-    vector<char> errMsg(BUF_LEN, 0);
-    int errStatus = 0;
-    vector<char> signatureR(BUF_LEN, 0);
-    vector<char> signatureS(BUF_LEN, 0);
     vector<uint8_t> encryptedKey(BUF_LEN, 0);
-    uint8_t signatureV = 0;
     uint64_t decLen = 0;
 
-    string pubKeyStr = "";
-
     if (!hex2carray(encryptedKeyHex.c_str(), &decLen, encryptedKey.data(),
                     BUF_LEN)) {
         throw SGXException(ECDSA_SIGN_INVALID_KEY_HEX, "Invalid encryptedKeyHex");
     }
 
+    encryptedKey.resize(decLen);
+
+    return ecdsaSignHash(encryptedKey, encryptedKeyHex, hashHex, base);
+}
+
+vector <string> ecdsaSignHash(const vector<uint8_t>& encryptedKey, const std::string& encryptedKeyHex,
+                              const char *hashHex, int base) {
+
+    CHECK_STATE(hashHex);
+
+    vector <string> signatureVector(3);
+
+    ScratchBuffer errMsg(ERR_STRING_LEN);
+    int errStatus = 0;
+    uint64_t signatureR[ECDSA_SIG_LIMBS];
+    uint64_t signatureS[ECDSA_SIG_LIMBS];
+    uint8_t signatureV = 0;
+    uint64_t decLen = encryptedKey.size();
+
+    string pubKeyStr = "";
+
     sgx_status_t status = SGX_SUCCESS;
 
-    status = trustedEcdsaSign(eid, &errStatus,
-                        errMsg.data(), encryptedKey.data(), decLen, hashHex,
-                        signatureR.data(),
-                        signatureS.data(), &signatureV, base);
+    status = ECALL(trustedEcdsaSign, shardEid(encryptedKey.data(), decLen), &errStatus,
+                                     errMsg.data(), (uint8_t *) encryptedKey.data(), decLen, hashHex,
+                                     signatureR, signatureS, &signatureV);
 
     HANDLE_TRUSTED_FUNCTION_ERROR(status, errStatus, errMsg.data());
 
 
+    string r = sigLimbsToString(signatureR, base);
+    string s = sigLimbsToString(signatureS, base);
+
     signatureVector.at(0) = to_string(signatureV);
 
     if (base == 16) {
-        signatureVector.at(1) = "0x" + string(signatureR.data());
-        signatureVector.at(2) = "0x" + string(signatureS.data());
+        signatureVector.at(1) = "0x" + r;
+        signatureVector.at(2) = "0x" + s;
     } else {
-        signatureVector.at(1) = string(signatureR.data());
-        signatureVector.at(2) = string(signatureS.data());
+        signatureVector.at(1) = r;
+        signatureVector.at(2) = s;
     }
 
-    /* Now verify signature */
+    /* Verify every thousandth signature after formatting */
+
+    static atomic<uint64_t> signCounter(0);
 
-    pubKeyStr = getECDSAPubKey(encryptedKeyHex);
+    if (++signCounter % 1000 == 0) {
+        pubKeyStr = getECDSAPubKey(encryptedKeyHex);
+
+        if (!verifyECDSASig(pubKeyStr, hashHex, r.c_str(), s.c_str(), base)) {
+            spdlog::error("failed to verify ecdsa signature");
+            throw SGXException(667, "ECDSA did not verify");
+        }
+    }
+
+    return signatureVector;
+}
 
-    static uint64_t  i = 0;
+vector<vector<string>> ecdsaSignHashBatch(const std::string& encryptedKeyHex, const vector<string>& hashesHex,
+                                          int base) {
 
-    i++;
+    CHECK_STATE(!hashesHex.empty());
+    CHECK_STATE(hashesHex.size() <= MAX_ECDSA_SIGN_BATCH_SIZE);
 
-    if (i % 1000 == 0) {
+    uint64_t numHashes = hashesHex.size();
 
-        if (!verifyECDSASig(pubKeyStr, hashHex, signatureR.data(), signatureS.data(), base)) {
+    vector<char> hashes(numHashes * ECDSA_BATCH_HASH_SLOT_LEN, 0);
+
+    for (uint64_t i = 0; i < numHashes; i++) {
+        CHECK_STATE(hashesHex[i].size() < ECDSA_BATCH_HASH_SLOT_LEN);
+        strncpy(hashes.data() + i * ECDSA_BATCH_HASH_SLOT_LEN, hashesHex[i].c_str(), ECDSA_BATCH_HASH_SLOT_LEN - 1);
+    }
+
+    ScratchBuffer errMsg(ERR_STRING_LEN);
+    int errStatus = 0;
+    vector<uint64_t> signaturesR(numHashes * ECDSA_SIG_LIMBS, 0);
+    vector<uint64_t> signaturesS(numHashes * ECDSA_SIG_LIMBS, 0);
+    vector<uint8_t> signaturesV(numHashes, 0);
+    vector<uint8_t> encryptedKey(BUF_LEN, 0);
+    uint64_t decLen = 0;
+
+    if (!hex2carray(encryptedKeyHex.c_str(), &decLen, encryptedKey.data(),
+                    BUF_LEN)) {
+        throw SGXException(ECDSA_SIGN_INVALID_KEY_HEX, "Invalid encryptedKeyHex");
+    }
+
+    sgx_status_t status = SGX_SUCCESS;
+
+    status = ECALL(trustedEcdsaSignBatch, shardEid(encryptedKey.data(), decLen), &errStatus, errMsg.data(), encryptedKey.data(), decLen,
+                                          numHashes, hashes.data(), hashes.size(),
+                                          signaturesR.data(), signaturesS.data(),
+                                          signaturesR.size() * sizeof(uint64_t), signaturesV.data());
+
+    HANDLE_TRUSTED_FUNCTION_ERROR(status, errStatus, errMsg.data());
+
+    vector<vector<string>> signatures(numHashes, vector<string>(3));
+
+    string prefix = (base == 16) ? "0x" : "";
+
+    for (uint64_t i = 0; i < numHashes; i++) {
+        signatures[i].at(0) = to_string(signaturesV[i]);
+        signatures[i].at(1) = prefix + sigLimbsToString(signaturesR.data() + i * ECDSA_SIG_LIMBS, base);
+        signatures[i].at(2) = prefix + sigLimbsToString(signaturesS.data() + i * ECDSA_SIG_LIMBS, base);
+    }
+
+    /* Verify the first signature of every thousandth batch */
+
+    static atomic<uint64_t> batchCounter(0);
+
+    if (++batchCounter % 1000 == 0) {
+        string pubKeyStr = getECDSAPubKey(encryptedKeyHex);
+
+        if (!verifyECDSASig(pubKeyStr, hashesHex[0].c_str(), sigLimbsToString(signaturesR.data(), base).c_str(),
+                            sigLimbsToString(signaturesS.data(), base).c_str(), base)) {
             spdlog::error("failed to verify ecdsa signature");
             throw SGXException(667, "ECDSA did not verify");
         }
     }
 
-    return signatureVector;
+    return signatures;
 }
 
 string encryptECDSAKey(const string& _key) {
@@ -234,13 +353,13 @@ string encryptECDSAKey(const string& _key) {
     vector<uint8_t> encryptedKey(BUF_LEN, 0);
 
     int errStatus = 0;
-    vector<char> errString(BUF_LEN, 0);
+    ScratchBuffer errString(BUF_LEN);
     uint64_t enc_len = 0;
 
     sgx_status_t status = SGX_SUCCESS;
 
-    status = trustedEncryptKey(eid, &errStatus, errString.data(), key.data(),
-                               encryptedKey.data(), &enc_len);
+    status = ECALL(trustedEncryptKey, eid, &errStatus, errString.data(), key.data(),
+                                      encryptedKey.data(), &enc_len);
 
     HANDLE_TRUSTED_FUNCTION_ERROR(status, errStatus, errString.data());
 
@@ -248,3 +367,47 @@ string encryptECDSAKey(const string& _key) {
 
     return string(hexEncrKey.begin(), hexEncrKey.end());
 }
+
+vector<string> encryptECDSAKeysBatch(const vector<string>& _keys, vector<int>& _statuses, vector<string>& _pubKeys) {
+    uint64_t numKeys = _keys.size();
+
+    CHECK_STATE(numKeys > 0 && numKeys <= MAX_KEY_IMPORT_BATCH_SIZE);
+
+    vector<char> keys(numKeys * MAX_KEY_LENGTH, 0);
+    for (uint64_t i = 0; i < numKeys; i++) {
+        CHECK_STATE(_keys[i].size() < MAX_KEY_LENGTH);
+        memcpy(keys.data() + i * MAX_KEY_LENGTH, _keys[i].data(), _keys[i].size());
+    }
+
+    vector<uint8_t> encryptedKeys(numKeys * KEY_IMPORT_ENC_KEY_SLOT_LEN, 0);
+    vector<uint64_t> encLens(numKeys, 0);
+    vector<char> pubKeys(numKeys * KEY_IMPORT_PUB_KEY_SLOT_LEN, 0);
+    _statuses.assign(numKeys, 0);
+
+    ScratchBuffer errString(ERR_STRING_LEN);
+    int errStatus = 0;
+
+    sgx_status_t status = SGX_SUCCESS;
+
+    status = ECALL(trustedEncryptKeysBatch, eid, &errStatus, errString.data(), numKeys, keys.data(), keys.size(),
+                   encryptedKeys.data(), encryptedKeys.size(), encLens.data(), _statuses.data(), 1,
+                   pubKeys.data(), pubKeys.size());
+
+    memset(keys.data(), 0, keys.size());
+
+    HANDLE_TRUSTED_FUNCTION_ERROR(status, errStatus, errString.data());
+
+    vector<string> result(numKeys);
+    _pubKeys.assign(numKeys, "");
+
+    for (uint64_t i = 0; i < numKeys; i++) {
+        if (_statuses[i] == 0) {
+            auto hex = carray2Hex(encryptedKeys.data() + i * KEY_IMPORT_ENC_KEY_SLOT_LEN, encLens[i]);
+            result[i] = string(hex.begin(), hex.end());
+            _pubKeys[i] = string(pubKeys.data() + i * KEY_IMPORT_PUB_KEY_SLOT_LEN);
+            cacheECDSAPubKey(result[i], _pubKeys[i]);
+        }
+    }
+
+    return result;
+}
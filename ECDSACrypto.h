@@ -33,9 +33,22 @@ vector<string> genECDSAKey();
 
 string getECDSAPubKey(const std::string& _encryptedKeyHex);
 
+// remembers a public key computed elsewhere, e.g. at key generation
+void cacheECDSAPubKey(const std::string& _encryptedKeyHex, const std::string& _pubKey);
+
 vector<string> ecdsaSignHash(const std::string& encryptedKeyHex, const char* hashHex, int base);
 
+// ecdsaSignHash of an already decoded encrypted key, used for key handles
+vector<string> ecdsaSignHash(const vector<uint8_t>& encryptedKey, const std::string& encryptedKeyHex,
+                             const char* hashHex, int base);
+
+vector<vector<string>> ecdsaSignHashBatch(const std::string& encryptedKeyHex, const vector<string>& hashesHex, int base);
+
 string encryptECDSAKey(const string& key);
 
+// encrypts up to MAX_KEY_IMPORT_BATCH_SIZE keys and computes their public keys in one ECALL.
+// A key that could not be encrypted gets empty results and a non zero status
+vector<string> encryptECDSAKeysBatch(const vector<string>& _keys, vector<int>& _statuses, vector<string>& _pubKeys);
+
 
 #endif //SGXD_ECDSACRYPTO_H
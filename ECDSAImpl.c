@@ -1,3 +1,4 @@
+#include "secure_enclave/Secp256k1Field.c"
 #include "secure_enclave/Point.c"
 #include "secure_enclave/DomainParameters.cpp"
 #include "secure_enclave/NumberTheory.c"
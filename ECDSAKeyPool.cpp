@@ -0,0 +1,159 @@
+/*
+    Copyright (C) 2021-Present SKALE Labs
+
+    This file is part of sgxwallet.
+
+    sgxwallet is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as published
+    by the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    sgxwallet is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with sgxwallet. If not, see <https://www.gnu.org/licenses/>.
+
+    @file ECDSAKeyPool.cpp
+    @author Stan Kladko
+    @date 2021
+*/
+
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include "sgxwallet_common.h"
+#include "sgxwallet.h"
+#include "SGXException.h"
+#include "ExitHandler.h"
+#include "ECDSACrypto.h"
+#include "third_party/spdlog/spdlog.h"
+#include "common.h"
+#include "Metrics.h"
+#include "LatencySLO.h"
+
+#include "ECDSAKeyPool.h"
+
+bool ECDSAKeyPool::enabled = false;
+atomic<bool> ECDSAKeyPool::exitRequested(false);
+shared_ptr<thread> ECDSAKeyPool::refillThread = nullptr;
+mutex ECDSAKeyPool::keysMutex;
+deque<vector<string>> ECDSAKeyPool::keys;
+uint64_t ECDSAKeyPool::hostGeneration = 0;
+atomic<uint64_t> ECDSAKeyPool::enclavePoolSize(0);
+
+vector<string> ECDSAKeyPool::take() {
+    {
+        lock_guard<mutex> lock(keysMutex);
+        if (!keys.empty()) {
+            auto key = move(keys.front());
+            keys.pop_front();
+            return key;
+        }
+    }
+
+    if (enabled) {
+        static auto &misses = Metrics::getCounter("ecdsaKeyPoolMisses");
+        misses.inc();
+    }
+
+    return genECDSAKey();
+}
+
+uint64_t ECDSAKeyPool::refillEnclave(uint64_t _count) {
+    vector<char> errMsg(BUF_LEN, 0);
+    int errStatus = 0;
+    uint64_t size = 0;
+
+    // key generation always runs in the first enclave instance, see genECDSAKey
+    sgx_status_t status = ECALL(trustedRefillEcdsaKeyPool, eid, &errStatus, errMsg.data(), _count, &size);
+
+    HANDLE_TRUSTED_FUNCTION_ERROR(status, errStatus, errMsg.data());
+
+    enclavePoolSize = size;
+
+    return size;
+}
+
+uint64_t ECDSAKeyPool::refillHost(uint64_t _count) {
+    for (uint64_t i = 0; i < _count && getPoolSize() < ECDSA_KEY_POOL_CAPACITY; i++) {
+        uint64_t generation;
+        {
+            lock_guard<mutex> lock(keysMutex);
+            generation = hostGeneration;
+        }
+        auto key = genECDSAKey();
+        lock_guard<mutex> lock(keysMutex);
+        // a key generated while clearHost ran may be sealed under the previous SEK
+        if (generation == hostGeneration) {
+            keys.push_back(move(key));
+        }
+    }
+
+    return getPoolSize();
+}
+
+void ECDSAKeyPool::clearHost() {
+    lock_guard<mutex> lock(keysMutex);
+    keys.clear();
+    hostGeneration++;
+}
+
+uint64_t ECDSAKeyPool::getPoolSize() {
+    lock_guard<mutex> lock(keysMutex);
+    return keys.size();
+}
+
+void ECDSAKeyPool::refillLoop() {
+    // lower the priority of this thread only, so refills run when the request threads are idle
+    if (setpriority(PRIO_PROCESS, syscall(SYS_gettid), ECDSA_KEY_POOL_REFILL_NICE) != 0) {
+        spdlog::warn("Could not lower the priority of the ECDSA key pool thread");
+    }
+
+    while (!exitRequested && !ExitHandler::shouldExit()) {
+        // refills use the enclave threads the sign requests need
+        if (LatencySLO::deferBackgroundWork("ECDSA key pool refill")) {
+            usleep(ECDSA_KEY_POOL_FULL_SLEEP_MS * 1000);
+            continue;
+        }
+
+        try {
+            // the enclave pool is refilled first, the host pool takes its keys from it
+            bool full = refillEnclave(ECDSA_KEY_POOL_REFILL_BATCH) >= ECDSA_ENCLAVE_KEY_POOL_CAPACITY;
+            full = refillHost(ECDSA_KEY_POOL_REFILL_BATCH) >= ECDSA_KEY_POOL_CAPACITY && full;
+
+            if (full) {
+                usleep(ECDSA_KEY_POOL_FULL_SLEEP_MS * 1000);
+            }
+        } catch (SGXException &e) {
+            spdlog::error("ECDSA key pool refill failed: {}", e.getMessage());
+            sleep(1);
+        } catch (exception &e) {
+            spdlog::error("ECDSA key pool refill failed: {}", e.what());
+            sleep(1);
+        }
+    }
+}
+
+void ECDSAKeyPool::initPool() {
+    if (!enabled) {
+        spdlog::info("ECDSA key pool disabled");
+        return;
+    }
+
+    CHECK_STATE(!refillThread);
+
+    spdlog::info("Starting ECDSA key pool refill, capacity {}", ECDSA_KEY_POOL_CAPACITY);
+    refillThread = make_shared<thread>(refillLoop);
+}
+
+void ECDSAKeyPool::exitPool() {
+    exitRequested = true;
+    if (refillThread) {
+        refillThread->join();
+        refillThread = nullptr;
+    }
+}
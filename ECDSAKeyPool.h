@@ -0,0 +1,88 @@
+/*
+    Copyright (C) 2021-Present SKALE Labs
+
+    This file is part of sgxwallet.
+
+    sgxwallet is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as published
+    by the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    sgxwallet is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with sgxwallet. If not, see <https://www.gnu.org/licenses/>.
+
+    @file ECDSAKeyPool.h
+    @author Stan Kladko
+    @date 2021
+*/
+
+#ifndef SGXWALLET_ECDSAKEYPOOL_H
+#define SGXWALLET_ECDSAKEYPOOL_H
+
+#include <atomic>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+// Low priority background thread that pregenerates ECDSA keys, so that generateECDSAKey only
+// pops a key. It keeps two pools filled: encrypted key pairs on the host, served by take(),
+// and plain key pairs in the enclave, used by trustedGenerateEcdsaKey and so also by the
+// ephemeral keys of DKG secret shares. Neither pool survives a restart.
+class ECDSAKeyPool {
+
+    static bool enabled;
+
+    static atomic<bool> exitRequested;
+
+    static shared_ptr<thread> refillThread;
+
+    static mutex keysMutex;
+
+    // results of genECDSAKey
+    static deque<vector<string>> keys;
+
+    // incremented by clearHost, keys generated before are not added to the host pool
+    static uint64_t hostGeneration;
+
+    static atomic<uint64_t> enclavePoolSize;
+
+    static void refillLoop();
+
+public:
+
+    static void setEnabled(bool _enabled) { enabled = _enabled; }
+
+    static bool isEnabled() { return enabled; }
+
+    static void initPool();
+
+    static void exitPool();
+
+    // a pregenerated key in the format of genECDSAKey, generated on the spot if the pool is empty
+    static vector<string> take();
+
+    // pregenerates up to _count key pairs in the enclave, returns the enclave pool size
+    static uint64_t refillEnclave(uint64_t _count);
+
+    // pregenerates up to _count encrypted keys on the host, returns the host pool size
+    static uint64_t refillHost(uint64_t _count);
+
+    // drops the encrypted keys of the host pool, they are sealed under the SEK of their generation time
+    static void clearHost();
+
+    static uint64_t getPoolSize();
+
+    static uint64_t getEnclavePoolSize() { return enclavePoolSize; }
+};
+
+#endif //SGXWALLET_ECDSAKEYPOOL_H
@@ -0,0 +1,119 @@
+/*
+    Copyright (C) 2021-Present SKALE Labs
+
+    This file is part of sgxwallet.
+
+    sgxwallet is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as published
+    by the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    sgxwallet is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with sgxwallet. If not, see <https://www.gnu.org/licenses/>.
+
+    @file ECDSANoncePool.cpp
+    @author Stan Kladko
+    @date 2021
+*/
+
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include "sgxwallet_common.h"
+#include "sgxwallet.h"
+#include "SGXException.h"
+#include "ExitHandler.h"
+#include "third_party/spdlog/spdlog.h"
+#include "common.h"
+#include "Metrics.h"
+#include "LatencySLO.h"
+
+#include "ECDSANoncePool.h"
+
+bool ECDSANoncePool::enabled = false;
+atomic<bool> ECDSANoncePool::exitRequested(false);
+shared_ptr<thread> ECDSANoncePool::refillThread = nullptr;
+atomic<uint64_t> ECDSANoncePool::shardPoolSizes[MAX_ENCLAVE_SHARDS];
+
+uint64_t ECDSANoncePool::refill(uint64_t _count, uint64_t _shard) {
+    CHECK_STATE(_shard < numEnclaveShards);
+
+    vector<char> errMsg(BUF_LEN, 0);
+    int errStatus = 0;
+    uint64_t size = 0;
+
+    sgx_status_t status = ECALL(trustedRefillEcdsaNoncePool, enclaveShards[_shard], &errStatus, errMsg.data(), _count,
+                                &size);
+
+    HANDLE_TRUSTED_FUNCTION_ERROR(status, errStatus, errMsg.data());
+
+    shardPoolSizes[_shard] = size;
+
+    return size;
+}
+
+uint64_t ECDSANoncePool::getPoolSize() {
+    uint64_t size = 0;
+    for (uint64_t i = 0; i < MAX_ENCLAVE_SHARDS; i++) {
+        size += shardPoolSizes[i];
+    }
+    return size;
+}
+
+void ECDSANoncePool::refillLoop() {
+    // lower the priority of this thread only, so refills run when the signing threads are idle
+    if (setpriority(PRIO_PROCESS, syscall(SYS_gettid), ECDSA_NONCE_POOL_REFILL_NICE) != 0) {
+        spdlog::warn("Could not lower the priority of the ECDSA nonce pool thread");
+    }
+
+    while (!exitRequested && !ExitHandler::shouldExit()) {
+        // refills use the enclave threads the sign requests need
+        if (LatencySLO::deferBackgroundWork("ECDSA nonce pool refill")) {
+            usleep(ECDSA_NONCE_POOL_FULL_SLEEP_MS * 1000);
+            continue;
+        }
+
+        try {
+            bool full = true;
+            for (uint64_t i = 0; i < numEnclaveShards; i++) {
+                full = refill(ECDSA_NONCE_POOL_REFILL_BATCH, i) >= ECDSA_NONCE_POOL_CAPACITY && full;
+            }
+
+            if (full) {
+                usleep(ECDSA_NONCE_POOL_FULL_SLEEP_MS * 1000);
+            }
+        } catch (SGXException &e) {
+            spdlog::error("ECDSA nonce pool refill failed: {}", e.getMessage());
+            sleep(1);
+        } catch (exception &e) {
+            spdlog::error("ECDSA nonce pool refill failed: {}", e.what());
+            sleep(1);
+        }
+    }
+}
+
+void ECDSANoncePool::initPool() {
+    if (!enabled) {
+        spdlog::info("ECDSA nonce pool disabled");
+        return;
+    }
+
+    CHECK_STATE(!refillThread);
+
+    spdlog::info("Starting ECDSA nonce pool refill, capacity {}", ECDSA_NONCE_POOL_CAPACITY);
+    refillThread = make_shared<thread>(refillLoop);
+}
+
+void ECDSANoncePool::exitPool() {
+    exitRequested = true;
+    if (refillThread) {
+        refillThread->join();
+        refillThread = nullptr;
+    }
+}
@@ -0,0 +1,68 @@
+/*
+    Copyright (C) 2021-Present SKALE Labs
+
+    This file is part of sgxwallet.
+
+    sgxwallet is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as published
+    by the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    sgxwallet is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with sgxwallet. If not, see <https://www.gnu.org/licenses/>.
+
+    @file ECDSANoncePool.h
+    @author Stan Kladko
+    @date 2021
+*/
+
+#ifndef SGXWALLET_ECDSANONCEPOOL_H
+#define SGXWALLET_ECDSANONCEPOOL_H
+
+#include <atomic>
+#include <memory>
+#include <thread>
+
+#include "sgxwallet_common.h"
+
+using namespace std;
+
+// Low priority background thread that keeps the enclave pool of precomputed ECDSA nonces
+// filled, so that signing does not compute k*G on the request path. The nonces themselves
+// never leave the enclave, the host only sees the pool size.
+class ECDSANoncePool {
+
+    static bool enabled;
+
+    static atomic<bool> exitRequested;
+
+    static shared_ptr<thread> refillThread;
+
+    static atomic<uint64_t> shardPoolSizes[MAX_ENCLAVE_SHARDS];
+
+    static void refillLoop();
+
+public:
+
+    static void setEnabled(bool _enabled) { enabled = _enabled; }
+
+    static bool isEnabled() { return enabled; }
+
+    static void initPool();
+
+    static void exitPool();
+
+    // precomputes up to _count nonces in an enclave instance, which has a pool of its own,
+    // returns the pool size of that instance
+    static uint64_t refill(uint64_t _count, uint64_t _shard = 0);
+
+    // summed over the enclave instances
+    static uint64_t getPoolSize();
+};
+
+#endif //SGXWALLET_ECDSANONCEPOOL_H
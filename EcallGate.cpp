@@ -0,0 +1,165 @@
+/*
+    Copyright (C) 2021-Present SKALE Labs
+
+    This file is part of sgxwallet.
+
+    sgxwallet is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as published
+    by the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    sgxwallet is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with sgxwallet. If not, see <https://www.gnu.org/licenses/>.
+
+    @file EcallGate.cpp
+    @author Stan Kladko
+    @date 2021
+*/
+
+#include <algorithm>
+#include <chrono>
+
+#include "sgxwallet_common.h"
+#include "third_party/spdlog/spdlog.h"
+#include "common.h"
+
+#include "Metrics.h"
+#include "EcallGate.h"
+
+EcallGate EcallGate::gates[MAX_ENCLAVE_SHARDS];
+
+uint64_t EcallGate::gateEids[MAX_ENCLAVE_SHARDS];
+
+atomic<uint64_t> EcallGate::numGates(0);
+
+atomic<uint64_t> EcallGate::waiting(0);
+
+// marks a thread that gave up waiting, it is not counted as bound
+#define UNCOUNTED_BINDING (1ull << 63)
+
+// the instances the calling thread holds a TCS of, released when the thread exits
+struct EcallGateBindings {
+    uint64_t generations[MAX_ENCLAVE_SHARDS] = {};
+
+    ~EcallGateBindings() {
+        for (uint64_t i = 0; i < MAX_ENCLAVE_SHARDS; i++) {
+            if (generations[i] != 0 && !(generations[i] & UNCOUNTED_BINDING)) {
+                EcallGate::gates[i].leave(generations[i]);
+            }
+        }
+    }
+};
+
+static thread_local EcallGateBindings bindings;
+
+EcallGate::EcallGate() : nextTicket(0), bound(0), capacity(0), generation(1) {}
+
+bool EcallGate::enter() {
+    static auto &waits = Metrics::getCounter("ecallGateWaits");
+    static auto &timeouts = Metrics::getCounter("ecallGateTimeouts");
+    static auto &waitTime = Metrics::getHistogram("ecallGateWait");
+
+    unique_lock<mutex> lock(m);
+
+    if (queue.empty() && bound < capacity) {
+        bound++;
+        return true;
+    }
+
+    auto ticket = nextTicket++;
+    queue.push_back(ticket);
+    waiting++;
+    waits.inc();
+    auto start = chrono::steady_clock::now();
+
+    bool admitted = cv.wait_for(lock, chrono::milliseconds(ECALL_GATE_MAX_WAIT_MS), [this, ticket]() {
+        return queue.front() == ticket && bound < capacity;
+    });
+
+    waiting--;
+    if (admitted) {
+        queue.pop_front();
+        bound++;
+    } else {
+        queue.erase(find(queue.begin(), queue.end(), ticket));
+        timeouts.inc();
+    }
+    lock.unlock();
+
+    // the next thread in line may find a TCS too
+    cv.notify_all();
+    waitTime.observeUs(chrono::duration_cast<chrono::microseconds>(chrono::steady_clock::now() - start).count());
+
+    return admitted;
+}
+
+void EcallGate::leave(uint64_t _generation) {
+    {
+        lock_guard<mutex> lock(m);
+        if (_generation != generation || bound == 0) {
+            return;
+        }
+        bound--;
+    }
+    cv.notify_all();
+}
+
+void EcallGate::admit(uint64_t _eid, bool _nested) {
+    if (_nested) {
+        return;
+    }
+
+    auto n = numGates.load(memory_order_acquire);
+    for (uint64_t i = 0; i < n; i++) {
+        if (gateEids[i] != _eid) {
+            continue;
+        }
+        auto &gate = gates[i];
+        auto current = gate.generation.load();
+        if ((bindings.generations[i] & ~UNCOUNTED_BINDING) != current) {
+            bindings.generations[i] = gate.enter() ? current : (current | UNCOUNTED_BINDING);
+        }
+        return;
+    }
+}
+
+void EcallGate::init(const uint64_t *_eids, uint64_t _numEids, uint64_t _capacity) {
+    CHECK_STATE(_eids);
+    CHECK_STATE(_numEids <= MAX_ENCLAVE_SHARDS);
+    CHECK_STATE(_capacity > 0);
+
+    // initEnclave recreates the instances under the init lock, with no ECALLs in flight
+    for (uint64_t i = 0; i < _numEids; i++) {
+        gateEids[i] = _eids[i];
+        {
+            lock_guard<mutex> lock(gates[i].m);
+            gates[i].capacity = _capacity;
+            gates[i].bound = 0;
+            gates[i].generation++;
+        }
+        gates[i].cv.notify_all();
+    }
+
+    numGates.store(_numEids, memory_order_release);
+
+    spdlog::info("Enclave gate admits {} threads per enclave instance", _capacity);
+}
+
+uint64_t EcallGate::getWaiting() {
+    return waiting;
+}
+
+uint64_t EcallGate::getBound() {
+    uint64_t result = 0;
+    auto n = numGates.load(memory_order_acquire);
+    for (uint64_t i = 0; i < n; i++) {
+        lock_guard<mutex> lock(gates[i].m);
+        result += gates[i].bound;
+    }
+    return result;
+}
@@ -0,0 +1,87 @@
+/*
+    Copyright (C) 2021-Present SKALE Labs
+
+    This file is part of sgxwallet.
+
+    sgxwallet is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as published
+    by the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    sgxwallet is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with sgxwallet. If not, see <https://www.gnu.org/licenses/>.
+
+    @file EcallGate.h
+    @author Stan Kladko
+    @date 2021
+*/
+
+#ifndef SGXWALLET_ECALLGATE_H
+#define SGXWALLET_ECALLGATE_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+
+using namespace std;
+
+// Admission of host threads into an enclave instance. The enclave runs with TCSPolicy 0, so a thread
+// takes a TCS of the instance on its first ECALL and keeps it until it exits, and the first ECALL of a
+// thread fails with SGX_ERROR_OUT_OF_TCS once all TCS are bound. The gate counts bound threads against
+// the TCS left after the switchless workers. A new thread that finds none free waits in arrival order
+// until a bound thread exits, for up to ECALL_GATE_MAX_WAIT_MS, and then makes its ECALL anyway.
+// Later ECALLs of a bound thread, and nested ECALLs made from an OCALL, pass without locking.
+class EcallGate {
+
+    mutex m;
+    condition_variable cv;
+    deque<uint64_t> queue;
+    uint64_t nextTicket;
+    uint64_t bound;
+    uint64_t capacity;
+    // bumped when initEnclave recreates the instance, which unbinds all threads
+    atomic<uint64_t> generation;
+
+    static EcallGate gates[];
+
+    static uint64_t gateEids[];
+
+    static atomic<uint64_t> numGates;
+
+    static atomic<uint64_t> waiting;
+
+    bool enter();
+
+    void leave(uint64_t _generation);
+
+    friend struct EcallGateBindings;
+
+public:
+
+    EcallGate();
+
+    // called before the first ECALL of every ECALL macro
+    static void admit(uint64_t _eid, bool _nested);
+
+    // called when the enclave instances are created, ECALLs made before that are not gated
+    static void init(const uint64_t *_eids, uint64_t _numEids, uint64_t _capacity);
+
+    // threads of all instances waiting for a TCS
+    static uint64_t getWaiting();
+
+    // threads bound to a TCS of any instance
+    static uint64_t getBound();
+
+    // ECALL stubs take the enclave id first
+    template<class E, class... A>
+    static uint64_t eidOf(E _eid, A &&...) { return (uint64_t) _eid; }
+};
+
+#endif //SGXWALLET_ECALLGATE_H
@@ -0,0 +1,84 @@
+/*
+    Copyright (C) 2021-Present SKALE Labs
+
+    This file is part of sgxwallet.
+
+    sgxwallet is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as published
+    by the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    sgxwallet is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with sgxwallet. If not, see <https://www.gnu.org/licenses/>.
+
+    @file EnclaveEpoch.cpp
+    @author Stan Kladko
+    @date 2021
+*/
+
+#include <thread>
+
+#include "EnclaveEpoch.h"
+
+static atomic<uint64_t> nextSlot(0);
+
+// shared lock depth of this thread, there is one EnclaveEpoch per process
+static thread_local uint64_t sharedDepth = 0;
+
+EnclaveEpoch::Slot &EnclaveEpoch::threadSlot() {
+    static thread_local uint64_t index = nextSlot.fetch_add(1, memory_order_relaxed) % NUM_SLOTS;
+    return slots[index];
+}
+
+void EnclaveEpoch::lock_shared() {
+    if (sharedDepth++ > 0) {
+        return;
+    }
+
+    auto &slot = threadSlot();
+
+    while (true) {
+        // seq_cst on both sides, so either this thread sees the flag or lock() sees the counter
+        slot.readers.fetch_add(1, memory_order_seq_cst);
+
+        if (!exclusive.load(memory_order_seq_cst)) {
+            return;
+        }
+
+        slot.readers.fetch_sub(1, memory_order_release);
+
+        while (exclusive.load(memory_order_acquire)) {
+            this_thread::yield();
+        }
+    }
+}
+
+void EnclaveEpoch::unlock_shared() {
+    if (--sharedDepth > 0) {
+        return;
+    }
+
+    threadSlot().readers.fetch_sub(1, memory_order_release);
+}
+
+void EnclaveEpoch::lock() {
+    writerMutex.lock();
+
+    exclusive.store(true, memory_order_seq_cst);
+
+    for (auto &slot : slots) {
+        while (slot.readers.load(memory_order_seq_cst) != 0) {
+            this_thread::yield();
+        }
+    }
+}
+
+void EnclaveEpoch::unlock() {
+    exclusive.store(false, memory_order_release);
+    writerMutex.unlock();
+}
@@ -0,0 +1,69 @@
+/*
+    Copyright (C) 2021-Present SKALE Labs
+
+    This file is part of sgxwallet.
+
+    sgxwallet is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as published
+    by the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    sgxwallet is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with sgxwallet. If not, see <https://www.gnu.org/licenses/>.
+
+    @file EnclaveEpoch.h
+    @author Stan Kladko
+    @date 2021
+*/
+
+#ifndef SGXWALLET_ENCLAVEEPOCH_H
+#define SGXWALLET_ENCLAVEEPOCH_H
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+
+using namespace std;
+
+// Shared/exclusive lock of the enclave lifecycle, usable with shared_lock and unique_lock.
+// A shared holder increments a counter in a cache line chosen per thread, so ECALL threads do not
+// all write the same cache line the way they do with shared_timed_mutex. The exclusive lock is
+// only taken by initEnclave: it raises a flag that shared holders check, then waits until all
+// counters are zero. Shared locking is reentrant within a thread.
+class EnclaveEpoch {
+
+public:
+
+    static constexpr uint64_t NUM_SLOTS = 64;
+
+private:
+
+    struct alignas(64) Slot {
+        atomic<uint64_t> readers{0};
+    };
+
+    Slot slots[NUM_SLOTS];
+
+    atomic<bool> exclusive{false};
+
+    mutex writerMutex;
+
+    Slot &threadSlot();
+
+public:
+
+    void lock_shared();
+
+    void unlock_shared();
+
+    void lock();
+
+    void unlock();
+};
+
+#endif //SGXWALLET_ENCLAVEEPOCH_H
@@ -0,0 +1,292 @@
+/*
+    Copyright (C) 2021-Present SKALE Labs
+
+    This file is part of sgxwallet.
+
+    sgxwallet is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as published
+    by the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    sgxwallet is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with sgxwallet. If not, see <https://www.gnu.org/licenses/>.
+
+    @file EventHttpServer.cpp
+    @author Stan Kladko
+    @date 2021
+*/
+
+
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <unistd.h>
+
+#include <gnutls/gnutls.h>
+#include <microhttpd.h>
+
+#include "sgxwallet_common.h"
+#include "third_party/spdlog/spdlog.h"
+#include "common.h"
+#include "KernelTLS.h"
+
+#include "EventHttpServer.h"
+
+#if MHD_VERSION >= 0x00097002
+typedef enum MHD_Result MHDResult;
+#else
+typedef int MHDResult;
+#endif
+
+struct EventHttpRequest {
+    string body;
+    string reply;
+    unsigned int status = MHD_HTTP_OK;
+    bool tooLarge = false;
+    // set by the worker before it resumes the connection
+    bool done = false;
+};
+
+static string readFile(const string &_fileName) {
+    ifstream in(_fileName);
+    CHECK_STATE(in.good());
+    stringstream ss;
+    ss << in.rdbuf();
+    return ss.str();
+}
+
+static MHDResult sendReply(MHD_Connection *_connection, unsigned int _status, const string &_body,
+                           const char *_contentType) {
+    auto response = MHD_create_response_from_buffer(_body.size(), (void *) _body.data(), MHD_RESPMEM_MUST_COPY);
+    if (!response) {
+        return MHD_NO;
+    }
+
+    MHD_add_response_header(response, "Content-Type", _contentType);
+    auto result = MHD_queue_response(_connection, _status, response);
+    MHD_destroy_response(response);
+
+    return result;
+}
+
+static bool isClientCertValid(MHD_Connection *_connection) {
+    auto info = MHD_get_connection_info(_connection, MHD_CONNECTION_INFO_GNUTLS_SESSION);
+    if (!info || !info->tls_session) {
+        return false;
+    }
+
+    unsigned int status = 0;
+    if (gnutls_certificate_verify_peers2((gnutls_session_t) info->tls_session, &status) != GNUTLS_E_SUCCESS) {
+        return false;
+    }
+
+    return status == 0;
+}
+
+struct EventHttpServerCallbacks {
+
+    static MHDResult handleRequest(void *_cls, MHD_Connection *_connection, const char *, const char *_method,
+                                   const char *, const char *_uploadData, size_t *_uploadDataSize, void **_conCls) {
+        auto server = (EventHttpServer *) _cls;
+        auto request = (shared_ptr<EventHttpRequest> *) *_conCls;
+
+        // the first call only has the headers
+        if (!request) {
+            if (KernelTLS::isEnabled()) {
+                auto info = MHD_get_connection_info(_connection, MHD_CONNECTION_INFO_GNUTLS_SESSION);
+                KernelTLS::countRequest(info ? info->tls_session : nullptr);
+            }
+            *_conCls = new shared_ptr<EventHttpRequest>(make_shared<EventHttpRequest>());
+            return MHD_YES;
+        }
+
+        auto &r = **request;
+
+        if (*_uploadDataSize > 0) {
+            if (r.body.size() + *_uploadDataSize > EVENT_HTTP_MAX_REQUEST_SIZE) {
+                r.tooLarge = true;
+            } else if (!r.tooLarge) {
+                r.body.append(_uploadData, *_uploadDataSize);
+            }
+            *_uploadDataSize = 0;
+            return MHD_YES;
+        }
+
+        if (r.done) {
+            return sendReply(_connection, r.status, r.reply, "application/json");
+        }
+
+        if (strcmp(_method, "POST") != 0) {
+            return sendReply(_connection, MHD_HTTP_METHOD_NOT_ALLOWED, "", "text/plain");
+        }
+
+        if (r.tooLarge) {
+            return sendReply(_connection, MHD_HTTP_REQUEST_ENTITY_TOO_LARGE, "", "text/plain");
+        }
+
+        if (server->checkCerts && !isClientCertValid(_connection)) {
+            return sendReply(_connection, MHD_HTTP_UNAUTHORIZED, "Client certificate verification failed",
+                             "text/plain");
+        }
+
+        if (!server->dispatch(_connection, *request)) {
+            return sendReply(_connection, MHD_HTTP_SERVICE_UNAVAILABLE, "", "text/plain");
+        }
+
+        return MHD_YES;
+    }
+
+    static void requestCompleted(void *, MHD_Connection *, void **_conCls, enum MHD_RequestTerminationCode) {
+        delete (shared_ptr<EventHttpRequest> *) *_conCls;
+        *_conCls = nullptr;
+    }
+};
+
+EventHttpServer::EventHttpServer(int _port, const string &_certPath, const string &_keyPath,
+                                 const string &_rootCAPath, bool _checkCerts, uint64_t _numIoThreads,
+                                 uint64_t _numWorkers)
+        : port(_port), certPath(_certPath), keyPath(_keyPath), rootCAPath(_rootCAPath), checkCerts(_checkCerts),
+          numIoThreads(_numIoThreads), numWorkers(_numWorkers), requests(0), queued(0) {
+    CHECK_STATE(numIoThreads > 0);
+    CHECK_STATE(numWorkers > 0);
+}
+
+EventHttpServer::~EventHttpServer() {
+    StopListening();
+}
+
+void EventHttpServer::workerLoop() {
+    while (true) {
+        function<void()> task;
+        {
+            unique_lock<mutex> lock(tasksMutex);
+            tasksCond.wait(lock, [this]() { return stopping || !tasks.empty(); });
+            // requests that are already suspended are still answered on shutdown
+            if (tasks.empty()) {
+                return;
+            }
+            task = move(tasks.front());
+            tasks.pop_front();
+        }
+        queued--;
+        task();
+    }
+}
+
+bool EventHttpServer::dispatch(MHD_Connection *_connection, const shared_ptr<EventHttpRequest> &_request) {
+    requests++;
+
+    lock_guard<mutex> lock(tasksMutex);
+
+    if (stopping) {
+        return false;
+    }
+
+    MHD_suspend_connection(_connection);
+
+    queued++;
+    tasks.emplace_back([this, _connection, _request]() {
+        try {
+            ProcessRequest(_request->body, _request->reply);
+        } catch (exception &e) {
+            spdlog::error("Event http request failed: {}", e.what());
+            _request->reply.clear();
+            _request->status = MHD_HTTP_INTERNAL_SERVER_ERROR;
+        }
+        _request->done = true;
+        MHD_resume_connection(_connection);
+    });
+
+    tasksCond.notify_one();
+
+    return true;
+}
+
+bool EventHttpServer::StartListening() {
+    if (daemon) {
+        return false;
+    }
+
+    bool tls = !certPath.empty();
+
+    vector<MHD_OptionItem> options;
+    options.push_back({MHD_OPTION_THREAD_POOL_SIZE, (intptr_t) numIoThreads, nullptr});
+    options.push_back({MHD_OPTION_CONNECTION_TIMEOUT, (intptr_t) EVENT_HTTP_CONNECTION_TIMEOUT_SECONDS, nullptr});
+    options.push_back({MHD_OPTION_NOTIFY_COMPLETED, (intptr_t) &EventHttpServerCallbacks::requestCompleted, nullptr});
+
+    try {
+        if (tls) {
+            cert = readFile(certPath);
+            key = readFile(keyPath);
+            options.push_back({MHD_OPTION_HTTPS_MEM_KEY, 0, (void *) key.c_str()});
+            options.push_back({MHD_OPTION_HTTPS_MEM_CERT, 0, (void *) cert.c_str()});
+            if (checkCerts) {
+                rootCA = readFile(rootCAPath);
+                options.push_back({MHD_OPTION_HTTPS_MEM_TRUST, 0, (void *) rootCA.c_str()});
+            }
+        }
+    } catch (exception &e) {
+        spdlog::error("Could not read the certs of the event http server: {}", e.what());
+        return false;
+    }
+
+    options.push_back({MHD_OPTION_END, 0, nullptr});
+
+    {
+        lock_guard<mutex> lock(tasksMutex);
+        stopping = false;
+    }
+
+    for (uint64_t i = 0; i < numWorkers; i++) {
+        workers.emplace_back(&EventHttpServer::workerLoop, this);
+    }
+
+    unsigned int flags = MHD_USE_EPOLL_INTERNALLY | MHD_USE_SUSPEND_RESUME | MHD_USE_PIPE_FOR_SHUTDOWN;
+    if (tls) {
+        flags |= MHD_USE_SSL;
+    }
+
+    daemon = MHD_start_daemon(flags, port, nullptr, nullptr, &EventHttpServerCallbacks::handleRequest, this,
+                              MHD_OPTION_ARRAY, options.data(), MHD_OPTION_END);
+
+    if (!daemon) {
+        StopListening();
+        return false;
+    }
+
+    return true;
+}
+
+bool EventHttpServer::StopListening() {
+    if (daemon) {
+        // no new connections, idle ones are closed by MHD_stop_daemon
+        auto listenSocket = MHD_quiesce_daemon(daemon);
+        if (listenSocket != MHD_INVALID_SOCKET) {
+            close(listenSocket);
+        }
+    }
+
+    {
+        lock_guard<mutex> lock(tasksMutex);
+        stopping = true;
+    }
+    tasksCond.notify_all();
+
+    // the workers answer what is queued, so no connection stays suspended
+    for (auto &&worker : workers) {
+        worker.join();
+    }
+    workers.clear();
+
+    if (daemon) {
+        MHD_stop_daemon(daemon);
+        daemon = nullptr;
+    }
+
+    return true;
+}
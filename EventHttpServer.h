@@ -0,0 +1,112 @@
+/*
+    Copyright (C) 2021-Present SKALE Labs
+
+    This file is part of sgxwallet.
+
+    sgxwallet is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as published
+    by the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    sgxwallet is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with sgxwallet. If not, see <https://www.gnu.org/licenses/>.
+
+    @file EventHttpServer.h
+    @author Stan Kladko
+    @date 2021
+*/
+
+
+#ifndef SGXWALLET_EVENTHTTPSERVER_H
+#define SGXWALLET_EVENTHTTPSERVER_H
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <jsonrpccpp/server/abstractserverconnector.h>
+
+using namespace jsonrpc;
+using namespace std;
+
+struct MHD_Daemon;
+struct MHD_Connection;
+
+struct EventHttpRequest;
+struct EventHttpServerCallbacks;
+
+// Event driven alternative to the libjson-rpc-cpp HttpServer, selected with sgxwallet -x.
+// A few libmicrohttpd I/O threads serve all connections with epoll and keep them alive, and
+// each request is suspended while one of the worker threads processes it. A slow enclave call
+// then holds a worker, not a connection thread, so a client can keep many requests in flight
+// over a few TLS connections. Client certs are checked against the root CA like in HttpServer.
+class EventHttpServer : public AbstractServerConnector {
+
+    const int port;
+
+    const string certPath;
+
+    const string keyPath;
+
+    const string rootCAPath;
+
+    const bool checkCerts;
+
+    const uint64_t numIoThreads;
+
+    const uint64_t numWorkers;
+
+    // kept for the lifetime of the daemon, which does not copy them
+    string cert;
+    string key;
+    string rootCA;
+
+    MHD_Daemon *daemon = nullptr;
+
+    mutex tasksMutex;
+    condition_variable tasksCond;
+    deque<function<void()>> tasks;
+    bool stopping = false;
+
+    vector<thread> workers;
+
+    atomic<uint64_t> requests;
+
+    atomic<uint64_t> queued;
+
+    void workerLoop();
+
+    // runs the request on a worker and resumes the suspended connection when its reply is ready,
+    // false if the server is stopping
+    bool dispatch(MHD_Connection *_connection, const shared_ptr<EventHttpRequest> &_request);
+
+    friend struct EventHttpServerCallbacks;
+
+public:
+
+    EventHttpServer(int _port, const string &_certPath, const string &_keyPath, const string &_rootCAPath,
+                    bool _checkCerts, uint64_t _numIoThreads, uint64_t _numWorkers);
+
+    ~EventHttpServer() override;
+
+    bool StartListening() override;
+
+    bool StopListening() override;
+
+    uint64_t getRequests() const { return requests; }
+
+    // requests waiting for a worker
+    uint64_t getQueued() const { return queued; }
+};
+
+#endif //SGXWALLET_EVENTHTTPSERVER_H
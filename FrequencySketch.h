@@ -0,0 +1,107 @@
+/*
+    Copyright (C) 2021-Present SKALE Labs
+
+    This file is part of sgxwallet.
+
+    sgxwallet is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as published
+    by the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    sgxwallet is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with sgxwallet. If not, see <https://www.gnu.org/licenses/>.
+
+    @file FrequencySketch.h
+    @author Stan Kladko
+    @date 2021
+*/
+
+#ifndef SGXWALLET_FREQUENCYSKETCH_H
+#define SGXWALLET_FREQUENCYSKETCH_H
+
+#include <cstdint>
+#include <cstring>
+
+// TinyLFU admission of the host and enclave key caches. A count-min sketch estimates how often a
+// key was looked up recently, in four rows of 4 bit counters. All counters are halved after every
+// 10 * WIDTH increments, so old popularity fades. A cache that is full admits a new key only if it
+// was looked up more often than the key it would evict, so a burst of one-off DKG lookups does not
+// push out the keys signed with every block. Not thread safe, callers hold the cache lock.
+template<uint32_t WIDTH>
+class FrequencySketch {
+
+    static_assert(WIDTH > 0 && WIDTH <= 65536 && (WIDTH & (WIDTH - 1)) == 0, "WIDTH has to be a power of two");
+
+    static constexpr uint32_t ROWS = 4;
+
+    static constexpr uint8_t MAX_COUNT = 15;
+
+    uint8_t counters[ROWS][WIDTH];
+
+    uint64_t increments;
+
+    static uint64_t mix(uint64_t _hash) {
+        _hash ^= _hash >> 33;
+        _hash *= 0xff51afd7ed558ccdULL;
+        _hash ^= _hash >> 33;
+        _hash *= 0xc4ceb9fe1a85ec53ULL;
+        _hash ^= _hash >> 33;
+        return _hash;
+    }
+
+    static uint32_t index(uint64_t _mixed, uint32_t _row) {
+        return (uint32_t) (_mixed >> (16 * _row)) & (WIDTH - 1);
+    }
+
+public:
+
+    FrequencySketch() { clear(); }
+
+    void clear() {
+        memset(counters, 0, sizeof(counters));
+        increments = 0;
+    }
+
+    void increment(uint64_t _hash) {
+        auto mixed = mix(_hash);
+        for (uint32_t i = 0; i < ROWS; i++) {
+            auto &c = counters[i][index(mixed, i)];
+            if (c < MAX_COUNT) {
+                c++;
+            }
+        }
+
+        if (++increments >= 10 * (uint64_t) WIDTH) {
+            for (uint32_t i = 0; i < ROWS; i++) {
+                for (uint32_t j = 0; j < WIDTH; j++) {
+                    counters[i][j] >>= 1;
+                }
+            }
+            increments /= 2;
+        }
+    }
+
+    uint32_t estimate(uint64_t _hash) const {
+        auto mixed = mix(_hash);
+        uint32_t result = MAX_COUNT;
+        for (uint32_t i = 0; i < ROWS; i++) {
+            auto c = counters[i][index(mixed, i)];
+            if (c < result) {
+                result = c;
+            }
+        }
+        return result;
+    }
+
+    // true if a new key should replace the victim in a full cache
+    bool admit(uint64_t _candidate, uint64_t _victim) const {
+        return estimate(_candidate) > estimate(_victim);
+    }
+};
+
+#endif //SGXWALLET_FREQUENCYSKETCH_H
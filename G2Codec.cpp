@@ -0,0 +1,322 @@
+/*
+    Copyright (C) 2021-Present SKALE Labs
+
+    This file is part of sgxwallet.
+
+    sgxwallet is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as published
+    by the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    sgxwallet is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with sgxwallet. If not, see <https://www.gnu.org/licenses/>.
+
+    @file G2Codec.cpp
+    @author Stan Kladko
+    @date 2021
+*/
+
+
+#include <cstring>
+
+#include <gmp.h>
+#include <libff/algebra/fields/field_utils.hpp>
+
+#include "common.h"
+#include "HexCodec.h"
+#include "CryptoTools.h"
+
+#include "G2Codec.h"
+
+using libff::alt_bn128_Fq;
+using libff::alt_bn128_Fq2;
+using libff::alt_bn128_G2;
+
+static const char HEX_DIGITS[] = "0123456789abcdef";
+
+bool hexToFq(const char *_hex, alt_bn128_Fq &_result) {
+    libff::bigint<libff::alt_bn128_q_limbs> value;
+
+    if (!hex2limbs(_hex, 64, (uint64_t *) value.data, libff::alt_bn128_q_limbs)) {
+        return false;
+    }
+
+    if (mpn_cmp(value.data, libff::alt_bn128_modulus_q.data, libff::alt_bn128_q_limbs) >= 0) {
+        return false;
+    }
+
+    _result = alt_bn128_Fq(value);
+    return true;
+}
+
+static void appendFqHex(string &_out, const alt_bn128_Fq &_x, int _flags = 0) {
+    auto value = _x.as_bigint();
+    auto start = _out.size();
+    _out.resize(start + 64);
+
+    for (int i = 0; i < 64; i++) {
+        auto limb = value.data[libff::alt_bn128_q_limbs - 1 - i / 16];
+        _out[start + i] = HEX_DIGITS[(limb >> (60 - 4 * (i % 16))) & 0x0F];
+    }
+
+    _out[start] = HEX_DIGITS[hexDigitValue(_out[start]) | _flags];
+}
+
+static bool isOdd(const alt_bn128_Fq &_x) {
+    return _x.as_bigint().data[0] & 1;
+}
+
+static bool ySign(const alt_bn128_Fq2 &_y) {
+    return _y.c1.is_zero() ? isOdd(_y.c0) : isOdd(_y.c1);
+}
+
+// q = 3 mod 4, so a square root of a square a is a^((q + 1) / 4)
+static bool sqrtFq(const alt_bn128_Fq &_a, alt_bn128_Fq &_root) {
+    static const auto exponent = []() {
+        mpz_t e;
+        mpz_init(e);
+        libff::alt_bn128_modulus_q.to_mpz(e);
+        mpz_add_ui(e, e, 1);
+        mpz_tdiv_q_2exp(e, e, 2);
+        libff::bigint<libff::alt_bn128_q_limbs> result(e);
+        mpz_clear(e);
+        return result;
+    }();
+
+    _root = _a ^ exponent;
+    return _root.squared() == _a;
+}
+
+void appendCompressedG2(string &_out, const alt_bn128_G2 &_affine) {
+    if (_affine.is_zero()) {
+        appendFqHex(_out, alt_bn128_Fq::zero(), 0x4);
+        appendFqHex(_out, alt_bn128_Fq::zero());
+        return;
+    }
+
+    appendFqHex(_out, _affine.X.c0, ySign(_affine.Y) ? 0x8 : 0);
+    appendFqHex(_out, _affine.X.c1);
+}
+
+string compressG2Batch(vector<alt_bn128_G2> _points) {
+    bool allNonZero = all_of(_points.begin(), _points.end(),
+                             [](const alt_bn128_G2 &_point) { return !_point.is_zero(); });
+
+    if (allNonZero) {
+        alt_bn128_G2::batch_to_special_all_non_zeros(_points);
+    } else {
+        for (auto &&point : _points) {
+            point.to_affine_coordinates();
+        }
+    }
+
+    string result;
+    result.reserve(_points.size() * G2_COMPRESSED_HEX_LEN);
+
+    for (auto &&point : _points) {
+        appendCompressedG2(result, point);
+    }
+
+    return result;
+}
+
+// Y^2 = a = X^3 + b'. With u^2 = -1 a square root of a0 + a1 u is y0 + y1 u, where
+// y0^2 = (a0 +- sqrt(a0^2 + a1^2)) / 2 and y1 = a1 / (2 y0)
+bool decompressG2Batch(const char *_hex, uint64_t _count, vector<alt_bn128_G2> &_points) {
+    CHECK_STATE(_hex);
+
+    static const alt_bn128_Fq half = alt_bn128_Fq(2).inverse();
+
+    _points.assign(_count, alt_bn128_G2::zero());
+
+    vector<alt_bn128_Fq2> squares(_count);
+    vector<alt_bn128_Fq> denominators(_count, alt_bn128_Fq::one());
+    vector<int> signs(_count, 0);
+    vector<bool> infinity(_count, false);
+
+    for (uint64_t i = 0; i < _count; i++) {
+        const char *encoded = _hex + i * G2_COMPRESSED_HEX_LEN;
+
+        int flags = hexDigitValue(encoded[0]);
+        if (flags < 0) {
+            return false;
+        }
+
+        char first[64];
+        memcpy(first, encoded, 64);
+        first[0] = HEX_DIGITS[flags & 0x3];
+
+        auto &point = _points[i];
+
+        if (!hexToFq(first, point.X.c0) || !hexToFq(encoded + 64, point.X.c1)) {
+            return false;
+        }
+
+        if (flags & 0x4) {
+            infinity[i] = true;
+            continue;
+        }
+
+        signs[i] = (flags & 0x8) != 0;
+
+        auto &a = squares[i];
+        a = point.X.squared() * point.X + libff::alt_bn128_twist_coeff_b;
+
+        alt_bn128_Fq norm;
+        if (!sqrtFq(a.c0.squared() + a.c1.squared(), norm)) {
+            return false;
+        }
+
+        if (!sqrtFq((a.c0 + norm) * half, point.Y.c0) && !sqrtFq((a.c0 - norm) * half, point.Y.c0)) {
+            return false;
+        }
+
+        // a is real and -a0 is a square, so y is imaginary
+        if (point.Y.c0.is_zero()) {
+            if (!sqrtFq(-a.c0, point.Y.c1)) {
+                return false;
+            }
+            continue;
+        }
+
+        denominators[i] = point.Y.c0 + point.Y.c0;
+    }
+
+    libff::batch_invert(denominators);
+
+    for (uint64_t i = 0; i < _count; i++) {
+        auto &point = _points[i];
+
+        if (infinity[i]) {
+            point = alt_bn128_G2::zero();
+            continue;
+        }
+
+        if (!point.Y.c0.is_zero()) {
+            point.Y.c1 = squares[i].c1 * denominators[i];
+        }
+
+        if (point.Y.squared() != squares[i]) {
+            return false;
+        }
+
+        if (ySign(point.Y) != (bool) signs[i]) {
+            point.Y = -point.Y;
+        }
+
+        point.Z = alt_bn128_Fq2::one();
+    }
+
+    return true;
+}
+
+const string *expandPublicShares(const string &_publicShares, int _t, string &_expanded) {
+    if (_t <= 0) {
+        return nullptr;
+    }
+
+    if (_publicShares.length() == (uint64_t) G2_HEX_LEN * _t) {
+        return &_publicShares;
+    }
+
+    vector<alt_bn128_G2> points;
+
+    if (_publicShares.length() != (uint64_t) G2_COMPRESSED_HEX_LEN * _t ||
+        !decompressG2Batch(_publicShares.data(), _t, points)) {
+        return nullptr;
+    }
+
+    _expanded.clear();
+    _expanded.reserve((uint64_t) G2_HEX_LEN * _t);
+
+    for (auto &&point : points) {
+        // the uncompressed encoding has no point at infinity, the commitment checks reject it
+        appendFqHex(_expanded, point.X.c0);
+        appendFqHex(_expanded, point.X.c1);
+        appendFqHex(_expanded, point.Y.c0);
+        appendFqHex(_expanded, point.Y.c1);
+    }
+
+    return &_expanded;
+}
+
+static bool parseDecimalFq(const string_view &_dec, alt_bn128_Fq &_result) {
+    string dec(_dec);
+    mpz_t value;
+    mpz_init(value);
+
+    bool valid = mpz_set_str(value, dec.c_str(), 10) == 0 && mpz_sgn(value) >= 0 &&
+                 mpz_sizeinbase(value, 2) <= 254;
+
+    if (valid) {
+        libff::bigint<libff::alt_bn128_q_limbs> limbs(value);
+        valid = mpn_cmp(limbs.data, libff::alt_bn128_modulus_q.data, libff::alt_bn128_q_limbs) < 0;
+        if (valid) {
+            _result = alt_bn128_Fq(limbs);
+        }
+    }
+
+    mpz_clear(value);
+    return valid;
+}
+
+static string fqToDec(const alt_bn128_Fq &_x) {
+    mpz_t value;
+    mpz_init(value);
+    _x.as_bigint().to_mpz(value);
+
+    string result(mpz_sizeinbase(value, 10) + 2, '\0');
+    mpz_get_str(&result[0], 10, value);
+    result.resize(strlen(result.c_str()));
+
+    mpz_clear(value);
+    return result;
+}
+
+string compressDecimalG2(const string &_points) {
+    string result;
+
+    StringTokenizer g2Strings(_points, ',');
+    string_view g2String, coord;
+
+    while (g2Strings.next(g2String)) {
+        alt_bn128_G2 point;
+        alt_bn128_Fq *coords[4] = {&point.X.c0, &point.X.c1, &point.Y.c0, &point.Y.c1};
+        StringTokenizer coordStrings(g2String, ':');
+
+        for (auto &&c : coords) {
+            CHECK_STATE(coordStrings.next(coord) && parseDecimalFq(coord, *c));
+        }
+
+        point.Z = alt_bn128_Fq2::one();
+        appendCompressedG2(result, point);
+    }
+
+    return result;
+}
+
+bool isCompressedG2(const string &_encoded) {
+    return !_encoded.empty() && _encoded.length() % G2_COMPRESSED_HEX_LEN == 0 &&
+           _encoded.find(':') == string::npos;
+}
+
+vector<vector<string>> decompressToDecimalG2(const string &_compressed) {
+    vector<alt_bn128_G2> points;
+
+    CHECK_STATE(isCompressedG2(_compressed));
+    CHECK_STATE(decompressG2Batch(_compressed.data(), _compressed.length() / G2_COMPRESSED_HEX_LEN, points));
+
+    vector<vector<string>> result;
+    result.reserve(points.size());
+
+    for (auto &&point : points) {
+        result.push_back({fqToDec(point.X.c0), fqToDec(point.X.c1), fqToDec(point.Y.c0), fqToDec(point.Y.c1)});
+    }
+
+    return result;
+}
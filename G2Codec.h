@@ -0,0 +1,69 @@
+/*
+    Copyright (C) 2021-Present SKALE Labs
+
+    This file is part of sgxwallet.
+
+    sgxwallet is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as published
+    by the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    sgxwallet is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with sgxwallet. If not, see <https://www.gnu.org/licenses/>.
+
+    @file G2Codec.h
+    @author Stan Kladko
+    @date 2021
+*/
+
+
+#ifndef SGXWALLET_G2CODEC_H
+#define SGXWALLET_G2CODEC_H
+
+#include <string>
+#include <vector>
+
+#include <libff/algebra/curves/alt_bn128/alt_bn128_pp.hpp>
+
+using namespace std;
+
+// DKG commitments and public keys are G2 points, sent as 256 hex digits (X.c0, X.c1, Y.c0, Y.c1)
+// or as four decimal coordinates. The compressed encoding is 128 hex digits, X.c0 and X.c1 only.
+// q < 2^254, so the top bits of X.c0 are free: 0x8 in the first digit is the sign of Y (parity of
+// Y.c1, of Y.c0 when Y.c1 is zero) and 0x4 marks the point at infinity.
+#define G2_HEX_LEN 256
+#define G2_COMPRESSED_HEX_LEN 128
+
+// parses 64 hex digits straight into a field element, rejects values that are not reduced mod q
+bool hexToFq(const char *_hex, libff::alt_bn128_Fq &_result);
+
+// appends the compressed encoding of an affine point
+void appendCompressedG2(string &_out, const libff::alt_bn128_G2 &_affine);
+
+// compresses points in any coordinates, with one field inversion for all of them
+string compressG2Batch(vector<libff::alt_bn128_G2> _points);
+
+// decompresses _count points of G2_COMPRESSED_HEX_LEN digits each into affine points. The square
+// roots need one inversion per point, which are done as one batch inversion. False if a digit is
+// invalid or a point is not on the curve, the subgroup is not checked
+bool decompressG2Batch(const char *_hex, uint64_t _count, vector<libff::alt_bn128_G2> &_points);
+
+// _t commitments of G2_HEX_LEN digits each: _publicShares itself, or its compressed encoding
+// expanded into _expanded. nullptr if the length is neither or a compressed point is not on the curve
+const string *expandPublicShares(const string &_publicShares, int _t, string &_expanded);
+
+// "X.c0:X.c1:Y.c0:Y.c1,..." decimal points, as in verification vectors and BLS public keys, to the
+// compressed encoding
+string compressDecimalG2(const string &_points);
+
+bool isCompressedG2(const string &_encoded);
+
+// decimal coordinates of compressed points
+vector<vector<string>> decompressToDecimalG2(const string &_compressed);
+
+#endif //SGXWALLET_G2CODEC_H
@@ -0,0 +1,101 @@
+/*
+    Copyright (C) 2021-Present SKALE Labs
+
+    This file is part of sgxwallet.
+
+    sgxwallet is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as published
+    by the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    sgxwallet is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with sgxwallet. If not, see <https://www.gnu.org/licenses/>.
+
+    @file GroupCommit.cpp
+    @author Stan Kladko
+    @date 2021
+*/
+
+#include <chrono>
+#include <exception>
+#include <thread>
+
+#include "common.h"
+#include "sgxwallet_common.h"
+#include "SGXException.h"
+
+#include "Metrics.h"
+#include "GroupCommit.h"
+
+atomic<uint64_t> GroupCommit::windowUs(LEVELDB_GROUP_COMMIT_DEFAULT_WINDOW_US);
+
+GroupCommit::GroupCommit(KeyValueStore &_store) :
+        store(_store),
+        syncs(Metrics::getCounter("leveldbSyncs")),
+        syncedWrites(Metrics::getCounter("leveldbSyncedWrites")) {}
+
+void GroupCommit::setWindowUs(uint64_t _windowUs) {
+    if (_windowUs > MAX_LEVELDB_GROUP_COMMIT_WINDOW_US) {
+        throw SGXException(INVALID_LEVELDB_OPTIONS, "Group commit window should not exceed " +
+                                                    to_string(MAX_LEVELDB_GROUP_COMMIT_WINDOW_US) + " us");
+    }
+
+    windowUs = _windowUs;
+}
+
+uint64_t GroupCommit::written() {
+    lock_guard<mutex> lock(m);
+    return ++writtenSeq;
+}
+
+void GroupCommit::waitDurable(uint64_t _seq) {
+    unique_lock<mutex> lock(m);
+
+    while (durableSeq < _seq) {
+        if (syncing) {
+            synced.wait(lock);
+            continue;
+        }
+
+        syncing = true;
+
+        if (lastGroupSize > 1 && windowUs > 0) {
+            lock.unlock();
+            this_thread::sleep_for(chrono::microseconds(windowUs.load()));
+            lock.lock();
+        }
+
+        auto target = writtenSeq;
+
+        lock.unlock();
+
+        exception_ptr error;
+        try {
+            store.sync();
+        } catch (...) {
+            error = current_exception();
+        }
+
+        lock.lock();
+
+        syncing = false;
+
+        if (!error) {
+            lastGroupSize = target - durableSeq;
+            syncs.inc();
+            syncedWrites.inc(lastGroupSize);
+            durableSeq = target;
+        }
+
+        synced.notify_all();
+
+        if (error) {
+            rethrow_exception(error);
+        }
+    }
+}
@@ -0,0 +1,77 @@
+/*
+    Copyright (C) 2021-Present SKALE Labs
+
+    This file is part of sgxwallet.
+
+    sgxwallet is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as published
+    by the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    sgxwallet is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with sgxwallet. If not, see <https://www.gnu.org/licenses/>.
+
+    @file GroupCommit.h
+    @author Stan Kladko
+    @date 2021
+*/
+
+#ifndef SGXWALLET_GROUPCOMMIT_H
+#define SGXWALLET_GROUPCOMMIT_H
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+
+#include "KeyValueStore.h"
+
+using namespace std;
+
+class MetricsCounter;
+
+// Makes the writes of a store durable in groups. Each write gets a sequence number, and its
+// writer waits until a sync covers it. The first waiting writer leads a group: it syncs the store
+// once for all writes done so far and wakes the writers they belong to, who return at once.
+// While writes are concurrent, the leader first waits up to the window for more writes to join.
+// A write that is not concurrent with others is synced immediately.
+class GroupCommit {
+
+    KeyValueStore &store;
+
+    MetricsCounter &syncs;
+    MetricsCounter &syncedWrites;
+
+    mutex m;
+    condition_variable synced;
+
+    uint64_t writtenSeq = 0;
+    uint64_t durableSeq = 0;
+    bool syncing = false;
+
+    // writes covered by the last sync
+    uint64_t lastGroupSize = 0;
+
+    static atomic<uint64_t> windowUs;
+
+public:
+
+    explicit GroupCommit(KeyValueStore &_store);
+
+    // call right after each write, in the order of the writes. Returns the sequence number of the write
+    uint64_t written();
+
+    // blocks until the write _seq is durable, throws if the sync fails
+    void waitDurable(uint64_t _seq);
+
+    // 0 syncs every group at once
+    static void setWindowUs(uint64_t _windowUs);
+
+    static uint64_t getWindowUs() { return windowUs; }
+};
+
+#endif //SGXWALLET_GROUPCOMMIT_H
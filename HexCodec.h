@@ -0,0 +1,162 @@
+/*
+    Copyright (C) 2021-Present SKALE Labs
+
+    This file is part of sgxwallet.
+
+    sgxwallet is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as published
+    by the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    sgxwallet is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with sgxwallet. If not, see <https://www.gnu.org/licenses/>.
+
+    @file HexCodec.h
+    @author Stan Kladko
+    @date 2021
+*/
+
+#ifndef SGXWALLET_HEXCODEC_H
+#define SGXWALLET_HEXCODEC_H
+
+// Hex encoding and decoding shared by the host and the enclave, which includes this header
+// from secure_enclave/EnclaveCommon.cpp. The main loops use GCC vector extensions, so they need
+// no intrinsics headers, which the enclave does not have. They compile to SSE2 on x86-64, and
+// to AVX2 when built with -mavx2. The tails, and compilers without vector
+// extensions, use the scalar code.
+
+#include <stdint.h>
+#include <string.h>
+
+#if defined(__GNUC__) && !defined(SGXWALLET_HEX_SCALAR)
+#define SGXWALLET_HEX_VECTOR 1
+#endif
+
+// value of a hex digit, -1 for other characters
+static inline int hexDigitValue(char _c) {
+    unsigned digit = (unsigned) (uint8_t) _c - '0';
+    unsigned letter = ((unsigned) (uint8_t) _c | 0x20) - 'a';
+    if (digit <= 9)
+        return (int) digit;
+    if (letter <= 5)
+        return (int) letter + 10;
+    return -1;
+}
+
+static inline void hexEncodeScalar(const uint8_t *_bin, uint64_t _len, char *_hex) {
+    static const char digits[] = "0123456789abcdef";
+    for (uint64_t i = 0; i < _len; i++) {
+        _hex[2 * i] = digits[_bin[i] >> 4];
+        _hex[2 * i + 1] = digits[_bin[i] & 0x0F];
+    }
+}
+
+static inline bool hexDecodeScalar(const char *_hex, uint64_t _binLen, uint8_t *_bin) {
+    int invalid = 0;
+    for (uint64_t i = 0; i < _binLen; i++) {
+        int high = hexDigitValue(_hex[2 * i]);
+        int low = hexDigitValue(_hex[2 * i + 1]);
+        invalid |= high | low;
+        _bin[i] = (uint8_t) ((high << 4) | (low & 0x0F));
+    }
+    return invalid >= 0;
+}
+
+#ifdef SGXWALLET_HEX_VECTOR
+
+typedef uint8_t hexVec16 __attribute__((vector_size(16)));
+
+#if defined(__clang__)
+#define HEX_SHUFFLE(__A__, __B__, ...) __builtin_shufflevector(__A__, __B__, __VA_ARGS__)
+#else
+#define HEX_SHUFFLE(__A__, __B__, ...) __builtin_shuffle(__A__, __B__, (hexVec16) {__VA_ARGS__})
+#endif
+
+static inline hexVec16 hexNibblesToAscii(hexVec16 _nibbles) {
+    // '0' + n, plus 'a' - '0' - 10 for the digits above 9
+    hexVec16 isLetter = (hexVec16) (_nibbles > 9);
+    return _nibbles + (uint8_t) '0' + (isLetter & (uint8_t) ('a' - '0' - 10));
+}
+
+// 16 bytes to 32 hex characters per iteration
+static inline void hexEncode(const uint8_t *_bin, uint64_t _len, char *_hex) {
+    uint64_t i = 0;
+
+    for (; i + 16 <= _len; i += 16) {
+        hexVec16 bytes;
+        memcpy(&bytes, _bin + i, 16);
+
+        hexVec16 high = hexNibblesToAscii(bytes >> 4);
+        hexVec16 low = hexNibblesToAscii(bytes & 0x0F);
+
+        hexVec16 first = HEX_SHUFFLE(high, low, 0, 16, 1, 17, 2, 18, 3, 19, 4, 20, 5, 21, 6, 22, 7, 23);
+        hexVec16 second = HEX_SHUFFLE(high, low, 8, 24, 9, 25, 10, 26, 11, 27, 12, 28, 13, 29, 14, 30, 15, 31);
+
+        memcpy(_hex + 2 * i, &first, 16);
+        memcpy(_hex + 2 * i + 16, &second, 16);
+    }
+
+    hexEncodeScalar(_bin + i, _len - i, _hex + 2 * i);
+}
+
+// digit values of 16 characters, lanes that are no hex digit are cleared in _valid
+static inline hexVec16 hexAsciiToNibbles(hexVec16 _chars, hexVec16 &_valid) {
+    hexVec16 digit = _chars - (uint8_t) '0';
+    hexVec16 letter = (_chars | 0x20) - (uint8_t) 'a';
+
+    hexVec16 isDigit = (hexVec16) (digit <= 9);
+    hexVec16 isLetter = (hexVec16) (letter <= 5);
+
+    _valid &= isDigit | isLetter;
+
+    return (digit & isDigit) | ((letter + 10) & isLetter);
+}
+
+// 32 hex characters to 16 bytes per iteration, upper and lower case digits are accepted
+static inline bool hexDecode(const char *_hex, uint64_t _binLen, uint8_t *_bin) {
+    hexVec16 valid = (hexVec16) {} - 1;
+    uint64_t i = 0;
+
+    for (; i + 16 <= _binLen; i += 16) {
+        hexVec16 first, second;
+        memcpy(&first, _hex + 2 * i, 16);
+        memcpy(&second, _hex + 2 * i + 16, 16);
+
+        first = hexAsciiToNibbles(first, valid);
+        second = hexAsciiToNibbles(second, valid);
+
+        hexVec16 high = HEX_SHUFFLE(first, second, 0, 2, 4, 6, 8, 10, 12, 14, 16, 18, 20, 22, 24, 26, 28, 30);
+        hexVec16 low = HEX_SHUFFLE(first, second, 1, 3, 5, 7, 9, 11, 13, 15, 17, 19, 21, 23, 25, 27, 29, 31);
+
+        hexVec16 bytes = (high << 4) | low;
+        memcpy(_bin + i, &bytes, 16);
+    }
+
+    uint64_t validLanes[2];
+    memcpy(validLanes, &valid, 16);
+
+    bool tailValid = hexDecodeScalar(_hex + 2 * i, _binLen - i, _bin + i);
+
+    return tailValid && validLanes[0] == UINT64_MAX && validLanes[1] == UINT64_MAX;
+}
+
+#undef HEX_SHUFFLE
+
+#else
+
+static inline void hexEncode(const uint8_t *_bin, uint64_t _len, char *_hex) {
+    hexEncodeScalar(_bin, _len, _hex);
+}
+
+static inline bool hexDecode(const char *_hex, uint64_t _binLen, uint8_t *_bin) {
+    return hexDecodeScalar(_hex, _binLen, _bin);
+}
+
+#endif
+
+#endif //SGXWALLET_HEXCODEC_H
@@ -0,0 +1,318 @@
+/*
+    Copyright (C) 2021-Present SKALE Labs
+
+    This file is part of sgxwallet.
+
+    sgxwallet is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as published
+    by the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    sgxwallet is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with sgxwallet. If not, see <https://www.gnu.org/licenses/>.
+
+    @file JsonRpcBatchHandler.cpp
+    @author Stan Kladko
+    @date 2021
+*/
+
+#include <cstring>
+#include <functional>
+#include <map>
+
+#include <json/json.h>
+
+#include "sgxwallet_common.h"
+#include "third_party/spdlog/spdlog.h"
+#include "common.h"
+
+#include "CryptoTools.h"
+#include "SGXWalletServer.hpp"
+#include "MemoryBudget.h"
+#include "Tracing.h"
+#include "TrafficRecorder.h"
+
+#include "JsonRpcBatchHandler.h"
+
+JsonRpcBatchHandler::JsonRpcBatchHandler(IClientConnectionHandler &_inner, uint64_t _maxInFlight)
+        : inner(_inner), requests(0), calls(0), maxInFlight(_maxInFlight), inFlight(0), rejected(0),
+          rateLimited(0) {
+    if (ClientRateLimiter::getRequestsPerSecond() > 0) {
+        rateLimiter = make_unique<ClientRateLimiter>(ClientRateLimiter::getRequestsPerSecond());
+    }
+}
+
+string JsonRpcBatchHandler::busyResponse(const char *_message) {
+    // the request is not parsed, so the id is unknown
+    return "{\"jsonrpc\":\"2.0\",\"id\":null,\"error\":{\"code\":" + to_string(JSON_RPC_SERVER_BUSY) +
+           ",\"message\":\"" + _message + "\"}}\n";
+}
+
+string JsonRpcBatchHandler::scanKeyName(const string &_request) {
+    static const char *keys[] = {"\"keyShareName\"", "\"keyName\"", "\"ethKeyName\""};
+
+    for (auto &&key : keys) {
+        auto pos = _request.find(key);
+        if (pos == string::npos) {
+            continue;
+        }
+
+        // clients may put whitespace around the colon
+        pos = _request.find_first_not_of(" \t\r\n", pos + strlen(key));
+        if (pos == string::npos || _request[pos] != ':') {
+            continue;
+        }
+        pos = _request.find_first_not_of(" \t\r\n", pos + 1);
+        if (pos == string::npos || _request[pos] != '"') {
+            continue;
+        }
+
+        auto end = _request.find('"', pos + 1);
+        if (end != string::npos && end > pos + 1) {
+            return _request.substr(pos + 1, end - pos - 1);
+        }
+    }
+
+    return "";
+}
+
+Json::Value JsonRpcBatchHandler::makeResponse(const Json::Value &_entry, const Json::Value &_result) {
+    Json::Value response;
+    response["jsonrpc"] = "2.0";
+    response["id"] = _entry["id"];
+    response["result"] = _result;
+    return response;
+}
+
+void JsonRpcBatchHandler::handleEntry(const Json::Value &_entry, Json::Value &_response) {
+    Json::FastWriter fastWriter;
+    string response;
+
+    inner.HandleRequest(fastWriter.write(_entry), response);
+
+    // notifications have no response
+    if (!response.empty()) {
+        Json::Reader reader;
+        reader.parse(response, _response);
+    }
+}
+
+static bool isFusable(const Json::Value &_entry, const char *_method) {
+    return _entry.isObject() && _entry.isMember("id") && !_entry["id"].isNull() &&
+           _entry["method"].isString() && _entry["method"].asString() == _method && _entry["params"].isObject();
+}
+
+static bool isBlsSign(const Json::Value &_entry) {
+    if (!isFusable(_entry, "blsSignMessageHash"))
+        return false;
+    auto &params = _entry["params"];
+    return params["keyShareName"].isString() && params["messageHash"].isString() &&
+           params["t"].isInt() && params["n"].isInt();
+}
+
+static bool isEcdsaSign(const Json::Value &_entry) {
+    if (!isFusable(_entry, "ecdsaSignMessageHash"))
+        return false;
+    auto &params = _entry["params"];
+    return params["base"].isInt() && params["keyName"].isString() && params["messageHash"].isString();
+}
+
+// any failure in a fused batch, e.g. one bad key name, makes every entry fall back to
+// a single call so that each gets its own error
+void JsonRpcBatchHandler::signBls(const vector<Json::Value> &_entries, vector<Json::Value> &_responses) {
+    Json::Value requests(Json::arrayValue);
+
+    for (auto &&entry : _entries) {
+        requests.append(entry["params"]);
+    }
+
+    auto result = SGXWalletServer::blsSignMessageHashBatchImpl(requests);
+
+    if (result["status"] != 0) {
+        for (size_t i = 0; i < _entries.size(); i++) {
+            handleEntry(_entries[i], _responses[i]);
+        }
+        return;
+    }
+
+    for (size_t i = 0; i < _entries.size(); i++) {
+        Json::Value single;
+        single["status"] = 0;
+        single["errorMessage"] = "";
+        single["signatureShare"] = result["signatureShares"][(int) i];
+        _responses[i] = makeResponse(_entries[i], single);
+    }
+}
+
+void JsonRpcBatchHandler::signEcdsa(const vector<Json::Value> &_entries, vector<Json::Value> &_responses) {
+    Json::Value hashes(Json::arrayValue);
+
+    for (auto &&entry : _entries) {
+        hashes.append(entry["params"]["messageHash"]);
+    }
+
+    auto &params = _entries.front()["params"];
+
+    auto result = SGXWalletServer::ecdsaSignMessageHashBatchImpl(params["base"].asInt(), params["keyName"].asString(),
+                                                                 hashes);
+
+    if (result["status"] != 0) {
+        for (size_t i = 0; i < _entries.size(); i++) {
+            handleEntry(_entries[i], _responses[i]);
+        }
+        return;
+    }
+
+    for (size_t i = 0; i < _entries.size(); i++) {
+        Json::Value single;
+        single["status"] = 0;
+        single["errorMessage"] = "";
+        single["signature_v"] = result["signature_v"][(int) i];
+        single["signature_r"] = result["signature_r"][(int) i];
+        single["signature_s"] = result["signature_s"][(int) i];
+        _responses[i] = makeResponse(_entries[i], single);
+    }
+}
+
+void JsonRpcBatchHandler::HandleRequest(const string &_request, string &_retValue) {
+    Json::Value batch;
+    Json::Reader reader;
+
+    requests++;
+
+    // also records rejected requests, replays should see the same arrivals
+    struct Recording {
+        const string &request;
+        const string &reply;
+        uint64_t receivedNs;
+        ~Recording() {
+            if (receivedNs > 0) {
+                TrafficRecorder::record(TRAFFIC_HTTP, string(request), receivedNs, reply.size());
+            }
+        }
+    } recording{_request, _retValue, TrafficRecorder::isEnabled() ? Tracing::nowNs() : 0};
+
+    struct InFlightGuard {
+        atomic<uint64_t> &counter;
+        ~InFlightGuard() { counter--; }
+    } guard{inFlight};
+
+    auto current = ++inFlight;
+    if ((current > maxInFlight && maxInFlight > 0) ||
+        (current > MEMORY_PRESSURE_MAX_QUEUED && MemoryBudget::isUnderPressure())) {
+        rejected++;
+        _retValue = busyResponse("Server busy, retry later");
+        return;
+    }
+
+    string keyName;
+    if (rateLimiter) {
+        keyName = scanKeyName(_request);
+    }
+
+    // libjson-rpc-cpp does not pass HTTP headers on, so the traceparent is read from the request body
+    TraceContext trace;
+    uint64_t receivedNs = 0;
+    if (Tracing::isEnabled() && Tracing::scanRequest(_request, trace)) {
+        receivedNs = Tracing::nowNs();
+    }
+
+    TraceScope traceScope(trace);
+
+    struct RequestSpan {
+        const TraceContext &trace;
+        uint64_t receivedNs;
+        ~RequestSpan() { Tracing::emitSpan(trace, "http.request", receivedNs, Tracing::nowNs()); }
+    } requestSpan{trace, receivedNs};
+
+    auto first = _request.find_first_not_of(" \t\r\n");
+
+    // single requests, malformed input and oversized batches are left to the protocol handler
+    if (first == string::npos || _request[first] != '[' || !reader.parse(_request, batch) ||
+        !batch.isArray() || batch.empty() || batch.size() > MAX_JSON_RPC_BATCH_SIZE) {
+        auto numCalls = (batch.isArray() && !batch.empty()) ? batch.size() : 1;
+        calls += numCalls;
+        if (!keyName.empty() && !rateLimiter->tryAcquire(keyName, numCalls)) {
+            rateLimited++;
+            _retValue = busyResponse("Client rate limit exceeded, retry later");
+            return;
+        }
+        inner.HandleRequest(_request, _retValue);
+        return;
+    }
+
+    calls += batch.size();
+
+    if (!keyName.empty() && !rateLimiter->tryAcquire(keyName, batch.size())) {
+        rateLimited++;
+        _retValue = busyResponse("Client rate limit exceeded, retry later");
+        return;
+    }
+
+    vector<Json::Value> responses(batch.size());
+
+    // each job fills the responses of a group of batch entries
+    vector<function<void()>> jobs;
+
+    vector<size_t> blsEntries;
+    map<pair<string, int>, vector<size_t>> ecdsaEntries;
+
+    for (int i = 0; i < (int) batch.size(); i++) {
+        if (isBlsSign(batch[i])) {
+            blsEntries.push_back(i);
+        } else if (isEcdsaSign(batch[i])) {
+            auto &params = batch[i]["params"];
+            ecdsaEntries[{params["keyName"].asString(), params["base"].asInt()}].push_back(i);
+        } else {
+            jobs.push_back([this, &batch, &responses, i]() { handleEntry(batch[i], responses[i]); });
+        }
+    }
+
+    auto addSignJobs = [&](const vector<size_t> &_indexes, size_t _maxBatch,
+                           void (JsonRpcBatchHandler::*_sign)(const vector<Json::Value> &, vector<Json::Value> &)) {
+        for (size_t begin = 0; begin < _indexes.size(); begin += _maxBatch) {
+            vector<size_t> chunk(_indexes.begin() + begin,
+                                 _indexes.begin() + min(_indexes.size(), begin + _maxBatch));
+            jobs.push_back([this, &batch, &responses, chunk, _sign]() {
+                vector<Json::Value> entries, chunkResponses(chunk.size());
+                for (auto &&index : chunk) {
+                    entries.push_back(batch[(int) index]);
+                }
+                (this->*_sign)(entries, chunkResponses);
+                for (size_t j = 0; j < chunk.size(); j++) {
+                    responses[chunk[j]] = chunkResponses[j];
+                }
+            });
+        }
+    };
+
+    addSignJobs(blsEntries, MAX_BLS_SIGN_BATCH_SIZE, &JsonRpcBatchHandler::signBls);
+
+    for (auto &&group : ecdsaEntries) {
+        addSignJobs(group.second, MAX_ECDSA_SIGN_BATCH_SIZE, &JsonRpcBatchHandler::signEcdsa);
+    }
+
+    parallelFor(jobs.size(), [&](size_t _i) { jobs[_i](); });
+
+    Json::Value result(Json::arrayValue);
+
+    for (auto &&response : responses) {
+        if (!response.isNull()) {
+            result.append(response);
+        }
+    }
+
+    // a batch of notifications only gets an empty response
+    if (result.empty()) {
+        _retValue = "";
+        return;
+    }
+
+    Json::FastWriter fastWriter;
+    _retValue = fastWriter.write(result);
+}
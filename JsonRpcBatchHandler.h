@@ -0,0 +1,99 @@
+/*
+    Copyright (C) 2021-Present SKALE Labs
+
+    This file is part of sgxwallet.
+
+    sgxwallet is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as published
+    by the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    sgxwallet is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with sgxwallet. If not, see <https://www.gnu.org/licenses/>.
+
+    @file JsonRpcBatchHandler.h
+    @author Stan Kladko
+    @date 2021
+*/
+
+#ifndef SGXWALLET_JSONRPCBATCHHANDLER_H
+#define SGXWALLET_JSONRPCBATCHHANDLER_H
+
+#include <atomic>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <jsonrpccpp/server/iclientconnectionhandler.h>
+#include <json/value.h>
+
+#include "ClientRateLimiter.h"
+
+using namespace jsonrpc;
+using namespace std;
+
+// Sits between the HTTP connector and the JSON-RPC protocol handler. Single requests pass
+// through. In JSON-RPC 2.0 batch arrays, blsSignMessageHash entries and ecdsaSignMessageHash
+// entries with the same key and base are fused into the batch sign ECALLs, and all other
+// entries are executed in parallel. When more than _maxInFlight requests are being processed,
+// new ones are answered at once with a JSON_RPC_SERVER_BUSY error so that clients can back off
+// instead of queueing behind the enclave. Under memory pressure the limit is
+// MEMORY_PRESSURE_MAX_QUEUED, see MemoryBudget.h.
+//
+// libjson-rpc-cpp does not pass the client cert on, so with rate limiting enabled requests are
+// limited per key name, since the keys of each chain belong to one client. A batch costs one token
+// per entry. Requests without a key name are not limited.
+class JsonRpcBatchHandler : public IClientConnectionHandler {
+
+    IClientConnectionHandler &inner;
+
+    atomic<uint64_t> requests;
+
+    atomic<uint64_t> calls;
+
+    // zero means no limit
+    const uint64_t maxInFlight;
+
+    atomic<uint64_t> inFlight;
+
+    atomic<uint64_t> rejected;
+
+    atomic<uint64_t> rateLimited;
+
+    // nullptr if rate limiting is disabled
+    unique_ptr<ClientRateLimiter> rateLimiter;
+
+    static string busyResponse(const char *_message);
+
+    void handleEntry(const Json::Value &_entry, Json::Value &_response);
+
+    void signBls(const vector<Json::Value> &_entries, vector<Json::Value> &_responses);
+
+    void signEcdsa(const vector<Json::Value> &_entries, vector<Json::Value> &_responses);
+
+    static Json::Value makeResponse(const Json::Value &_entry, const Json::Value &_result);
+
+public:
+
+    JsonRpcBatchHandler(IClientConnectionHandler &_inner, uint64_t _maxInFlight);
+
+    void HandleRequest(const string &_request, string &_retValue) override;
+
+    uint64_t getRequests() const { return requests; }
+
+    uint64_t getCalls() const { return calls; }
+
+    uint64_t getRejected() const { return rejected; }
+
+    uint64_t getRateLimited() const { return rateLimited; }
+
+    // the first keyShareName, keyName or ethKeyName in the raw request, empty if there is none
+    static string scanKeyName(const string &_request);
+};
+
+#endif //SGXWALLET_JSONRPCBATCHHANDLER_H
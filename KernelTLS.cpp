@@ -0,0 +1,101 @@
+/*
+    Copyright (C) 2021-Present SKALE Labs
+
+    This file is part of sgxwallet.
+
+    sgxwallet is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as published
+    by the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    sgxwallet is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with sgxwallet. If not, see <https://www.gnu.org/licenses/>.
+
+    @file KernelTLS.cpp
+    @author Stan Kladko
+    @date 2021
+*/
+
+
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <unistd.h>
+
+#include <gnutls/gnutls.h>
+#if GNUTLS_VERSION_NUMBER >= 0x030703
+#include <gnutls/socket.h>
+#endif
+
+#include "sgxwallet_common.h"
+
+#include "KernelTLS.h"
+
+bool KernelTLS::enabled = false;
+atomic<uint64_t> KernelTLS::requests(0);
+
+bool KernelTLS::isKernelSupported() {
+    ifstream file(KTLS_AVAILABLE_ULP_FILE);
+    string ulp;
+    while (file >> ulp) {
+        if (ulp == "tls") {
+            return true;
+        }
+    }
+    return false;
+}
+
+void KernelTLS::init(bool _enabled, char *_argv[]) {
+    if (!_enabled) {
+        return;
+    }
+
+    if (!gnutls_check_version("3.7.3")) {
+        cerr << "GnuTLS " << gnutls_check_version(nullptr) << " has no kernel TLS, using user space TLS" << endl;
+        return;
+    }
+
+    if (!isKernelSupported()) {
+        cerr << "Kernel TLS is not available, load the tls kernel module to use it. Using user space TLS" << endl;
+        return;
+    }
+
+    // set by the re-executed sgxwallet, or by an operator who keeps ktls = true in an own config
+    if (getenv("GNUTLS_SYSTEM_PRIORITY_FILE")) {
+        enabled = true;
+        return;
+    }
+
+    {
+        ofstream file(KTLS_CONFIG_FILE, ios::trunc);
+        file << "[global]\nktls = true\n";
+        if (!file) {
+            cerr << "Could not write " << KTLS_CONFIG_FILE << ", using user space TLS" << endl;
+            return;
+        }
+    }
+
+    setenv("GNUTLS_SYSTEM_PRIORITY_FILE", KTLS_CONFIG_FILE, 1);
+    cerr << "Restarting with kernel TLS enabled in " << KTLS_CONFIG_FILE << endl;
+    execv("/proc/self/exe", _argv);
+
+    unsetenv("GNUTLS_SYSTEM_PRIORITY_FILE");
+    cerr << "Could not restart with kernel TLS, using user space TLS" << endl;
+}
+
+void KernelTLS::countRequest(void *_session) {
+#if GNUTLS_VERSION_NUMBER >= 0x030703
+    if (enabled && _session &&
+        gnutls_transport_is_ktls_enabled((gnutls_session_t) _session) != 0) {
+        requests++;
+    }
+#else
+    (void) _session;
+#endif
+}
@@ -0,0 +1,60 @@
+/*
+    Copyright (C) 2021-Present SKALE Labs
+
+    This file is part of sgxwallet.
+
+    sgxwallet is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as published
+    by the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    sgxwallet is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with sgxwallet. If not, see <https://www.gnu.org/licenses/>.
+
+    @file KernelTLS.h
+    @author Stan Kladko
+    @date 2021
+*/
+
+
+#ifndef SGXWALLET_KERNELTLS_H
+#define SGXWALLET_KERNELTLS_H
+
+#include <atomic>
+#include <cstdint>
+
+using namespace std;
+
+// Kernel TLS (kTLS) for the https servers. libmicrohttpd leaves TLS to GnuTLS, which hands the
+// record layer of established sessions to the kernel when its system config says ktls = true.
+// GnuTLS reads that config once when it is loaded, so enabling it writes KTLS_CONFIG_FILE and
+// re-executes sgxwallet with GNUTLS_SYSTEM_PRIORITY_FILE pointing to it. Sessions whose cipher
+// the kernel does not support, and kernels without the tls module, stay in user space.
+class KernelTLS {
+
+    static bool enabled;
+
+    static atomic<uint64_t> requests;
+
+    static bool isKernelSupported();
+
+public:
+
+    // set with sgxwallet -i, call before any thread is started, does not return if it re-executes
+    static void init(bool _enabled, char *_argv[]);
+
+    // true if GnuTLS was configured to use kTLS
+    static bool isEnabled() { return enabled; }
+
+    // counts a request served on a _session that the kernel encrypts or decrypts
+    static void countRequest(void *_session);
+
+    static uint64_t getRequests() { return requests; }
+};
+
+#endif //SGXWALLET_KERNELTLS_H
@@ -0,0 +1,114 @@
+/*
+    Copyright (C) 2021-Present SKALE Labs
+
+    This file is part of sgxwallet.
+
+    sgxwallet is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as published
+    by the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    sgxwallet is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with sgxwallet. If not, see <https://www.gnu.org/licenses/>.
+
+    @file KeyHandles.cpp
+    @author Stan Kladko
+    @date 2021
+*/
+
+#include <openssl/rand.h>
+
+#include "third_party/spdlog/spdlog.h"
+#include "sgxwallet_common.h"
+#include "common.h"
+#include "SGXException.h"
+#include "CryptoTools.h"
+
+#include "KeyHandles.h"
+
+shared_timed_mutex KeyHandles::handlesMutex;
+
+unordered_map<string, shared_ptr<const KeyHandles::Key>> KeyHandles::handles;
+
+string KeyHandles::open(const string &_keyName, bool _isBls, const string &_encryptedKeyHex) {
+    auto key = make_shared<Key>();
+    key->keyName = _keyName;
+    key->isBls = _isBls;
+    key->encryptedKeyHex = _encryptedKeyHex;
+    key->encryptedKey.resize(BUF_LEN);
+
+    uint64_t len = 0;
+    if (!hex2carray(_encryptedKeyHex.c_str(), &len, key->encryptedKey.data(), key->encryptedKey.size())) {
+        throw SGXException(SIGN_FUNCTION_INVALID_HEX, string(__FUNCTION__) + ":Invalid hex encrypted key");
+    }
+    key->encryptedKey.resize(len);
+
+    unsigned char id[KEY_HANDLE_ID_BYTES];
+    CHECK_STATE(RAND_bytes(id, sizeof(id)) == 1);
+    string handle(carray2Hex(id, sizeof(id)).data());
+
+    unique_lock<shared_timed_mutex> lock(handlesMutex);
+
+    if (handles.size() >= KEY_HANDLES_MAX_ENTRIES) {
+        throw SGXException(KEY_HANDLES_LIMIT_REACHED, string(__FUNCTION__) + ":Too many open key handles");
+    }
+
+    handles.emplace(handle, key);
+
+    return handle;
+}
+
+shared_ptr<const KeyHandles::Key> KeyHandles::get(const string &_handle) {
+    shared_lock<shared_timed_mutex> lock(handlesMutex);
+
+    auto it = handles.find(_handle);
+    if (it == handles.end()) {
+        throw SGXException(INVALID_KEY_HANDLE, string(__FUNCTION__) + ":Unknown key handle");
+    }
+
+    return it->second;
+}
+
+bool KeyHandles::close(const string &_handle) {
+    unique_lock<shared_timed_mutex> lock(handlesMutex);
+    return handles.erase(_handle) > 0;
+}
+
+void KeyHandles::invalidateKey(const string &_keyName) {
+    unique_lock<shared_timed_mutex> lock(handlesMutex);
+
+    for (auto it = handles.begin(); it != handles.end();) {
+        if (it->second->keyName == _keyName) {
+            it = handles.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+void KeyHandles::invalidateKeysWithPrefix(const string &_prefix) {
+    unique_lock<shared_timed_mutex> lock(handlesMutex);
+
+    for (auto it = handles.begin(); it != handles.end();) {
+        if (it->second->keyName.rfind(_prefix, 0) == 0) {
+            it = handles.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+void KeyHandles::clear() {
+    unique_lock<shared_timed_mutex> lock(handlesMutex);
+    handles.clear();
+}
+
+uint64_t KeyHandles::size() {
+    shared_lock<shared_timed_mutex> lock(handlesMutex);
+    return handles.size();
+}
@@ -0,0 +1,77 @@
+/*
+    Copyright (C) 2021-Present SKALE Labs
+
+    This file is part of sgxwallet.
+
+    sgxwallet is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as published
+    by the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    sgxwallet is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with sgxwallet. If not, see <https://www.gnu.org/licenses/>.
+
+    @file KeyHandles.h
+    @author Stan Kladko
+    @date 2021
+*/
+
+#ifndef SGXWALLET_KEYHANDLES_H
+#define SGXWALLET_KEYHANDLES_H
+
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+using namespace std;
+
+// A key handle is a random id for a BLS or ECDSA key that was resolved with openKey.
+// It keeps the decoded encrypted key, so signing by handle skips name validation,
+// the database read and hex decoding. The enclave key cache is indexed by the
+// encrypted key, so the decrypted key is reused by the enclave as well.
+class KeyHandles {
+
+public:
+
+    struct Key {
+        string keyName;
+        bool isBls = false;
+        string encryptedKeyHex;
+        vector<uint8_t> encryptedKey;
+    };
+
+    // the handle id, throws KEY_HANDLES_LIMIT_REACHED when KEY_HANDLES_MAX_ENTRIES are open
+    static string open(const string &_keyName, bool _isBls, const string &_encryptedKeyHex);
+
+    // throws INVALID_KEY_HANDLE for unknown or closed handles
+    static shared_ptr<const Key> get(const string &_handle);
+
+    static bool close(const string &_handle);
+
+    // closes all handles of the key, called when the key is deleted
+    static void invalidateKey(const string &_keyName);
+
+    // closes the handles of all keys whose names start with _prefix
+    static void invalidateKeysWithPrefix(const string &_prefix);
+
+    // closes all handles, called when a SEK rotation drops the previous SEK
+    static void clear();
+
+    static uint64_t size();
+
+private:
+
+    static shared_timed_mutex handlesMutex;
+
+    static unordered_map<string, shared_ptr<const Key>> handles;
+};
+
+#endif //SGXWALLET_KEYHANDLES_H
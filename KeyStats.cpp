@@ -0,0 +1,165 @@
+/*
+    Copyright (C) 2021-Present SKALE Labs
+
+    This file is part of sgxwallet.
+
+    sgxwallet is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as published
+    by the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    sgxwallet is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with sgxwallet. If not, see <https://www.gnu.org/licenses/>.
+
+    @file KeyStats.cpp
+    @author Stan Kladko
+    @date 2021
+*/
+
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <unistd.h>
+
+#include "sgxwallet_common.h"
+#include "ExitHandler.h"
+#include "third_party/spdlog/spdlog.h"
+#include "common.h"
+
+#include "KeyStats.h"
+
+mutex KeyStats::statsMutex;
+unordered_map<string, KeyStats::Stats> KeyStats::stats;
+atomic<bool> KeyStats::exitRequested(false);
+shared_ptr<thread> KeyStats::saveThread = nullptr;
+
+void KeyStats::recordSign(const string &_keyName, uint64_t _latencyUs) {
+    auto nowMs = (uint64_t) chrono::duration_cast<chrono::milliseconds>(
+            chrono::system_clock::now().time_since_epoch()).count();
+
+    lock_guard<mutex> lock(statsMutex);
+
+    auto it = stats.find(_keyName);
+    if (it == stats.end()) {
+        if (stats.size() >= KEY_STATS_MAX_KEYS) {
+            return;
+        }
+        it = stats.emplace(_keyName, Stats()).first;
+    }
+
+    it->second.signs++;
+    it->second.lastUsedMs = nowMs;
+    it->second.totalLatencyUs += _latencyUs;
+}
+
+bool KeyStats::get(const string &_keyName, Stats &_stats) {
+    lock_guard<mutex> lock(statsMutex);
+
+    auto it = stats.find(_keyName);
+    if (it == stats.end()) {
+        return false;
+    }
+
+    _stats = it->second;
+    return true;
+}
+
+uint64_t KeyStats::getNumKeys() {
+    lock_guard<mutex> lock(statsMutex);
+    return stats.size();
+}
+
+void KeyStats::forgetKeysWithPrefix(const string &_prefix) {
+    lock_guard<mutex> lock(statsMutex);
+
+    for (auto it = stats.begin(); it != stats.end();) {
+        if (it->first.rfind(_prefix, 0) == 0) {
+            it = stats.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+void KeyStats::load() {
+    ifstream file(KEY_STATS_FILE);
+    string line;
+    uint64_t loaded = 0;
+
+    lock_guard<mutex> lock(statsMutex);
+
+    // "<name> <signs> <lastUsedMs> <totalLatencyUs>" lines
+    while (stats.size() < KEY_STATS_MAX_KEYS && getline(file, line)) {
+        istringstream fields(line);
+        string name;
+        Stats s;
+        if (fields >> name >> s.signs >> s.lastUsedMs >> s.totalLatencyUs) {
+            stats[name] = s;
+            loaded++;
+        }
+    }
+
+    if (loaded > 0) {
+        spdlog::info("Read sign statistics of {} keys", loaded);
+    }
+}
+
+void KeyStats::save() {
+    unordered_map<string, Stats> snapshot;
+    {
+        lock_guard<mutex> lock(statsMutex);
+        snapshot = stats;
+    }
+
+    string tmpName = string(KEY_STATS_FILE) + ".tmp";
+    {
+        ofstream file(tmpName, ios::trunc);
+        for (auto &&key: snapshot) {
+            file << key.first << " " << key.second.signs << " " << key.second.lastUsedMs << " "
+                 << key.second.totalLatencyUs << "\n";
+        }
+        if (!file.good()) {
+            spdlog::error("Could not write {}", tmpName);
+            return;
+        }
+    }
+
+    if (rename(tmpName.c_str(), KEY_STATS_FILE) != 0) {
+        spdlog::error("Could not write {}", KEY_STATS_FILE);
+    }
+}
+
+void KeyStats::saveLoop() {
+    while (!exitRequested && !ExitHandler::shouldExit()) {
+        for (uint64_t i = 0; i < KEY_STATS_SAVE_INTERVAL_SECONDS && !exitRequested && !ExitHandler::shouldExit(); i++) {
+            sleep(1);
+        }
+
+        try {
+            save();
+        } catch (exception &e) {
+            spdlog::error("Could not save key statistics: {}", e.what());
+        }
+    }
+}
+
+void KeyStats::initSaver() {
+    CHECK_STATE(!saveThread);
+    load();
+    saveThread = make_shared<thread>(saveLoop);
+}
+
+void KeyStats::exitSaver() {
+    exitRequested = true;
+    if (saveThread) {
+        saveThread->join();
+        saveThread = nullptr;
+        save();
+    }
+}
@@ -0,0 +1,90 @@
+/*
+    Copyright (C) 2021-Present SKALE Labs
+
+    This file is part of sgxwallet.
+
+    sgxwallet is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as published
+    by the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    sgxwallet is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with sgxwallet. If not, see <https://www.gnu.org/licenses/>.
+
+    @file KeyStats.h
+    @author Stan Kladko
+    @date 2021
+*/
+
+#ifndef SGXWALLET_KEYSTATS_H
+#define SGXWALLET_KEYSTATS_H
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+
+using namespace std;
+
+// Sign count, last use and average sign latency of each BLS and ECDSA key, answered by
+// getKeyStatistics of the info server. Up to KEY_STATS_MAX_KEYS keys are tracked. The counters
+// are saved to KEY_STATS_FILE every KEY_STATS_SAVE_INTERVAL_SECONDS and on exit, and read back
+// on start. Unlike the hot key counts of KeyWarmUp they do not decay.
+class KeyStats {
+
+public:
+
+    struct Stats {
+        uint64_t signs = 0;
+        // milliseconds since the epoch
+        uint64_t lastUsedMs = 0;
+        uint64_t totalLatencyUs = 0;
+    };
+
+private:
+
+    static mutex statsMutex;
+
+    static unordered_map<string, Stats> stats;
+
+    static atomic<bool> exitRequested;
+
+    static shared_ptr<thread> saveThread;
+
+    static void load();
+
+    static void saveLoop();
+
+public:
+
+    static void recordSign(const string &_keyName, uint64_t _latencyUs);
+
+    // latency from _start to now
+    static void recordSign(const string &_keyName, chrono::steady_clock::time_point _start) {
+        recordSign(_keyName, chrono::duration_cast<chrono::microseconds>(chrono::steady_clock::now() - _start).count());
+    }
+
+    // false for a key that was not signed with
+    static bool get(const string &_keyName, Stats &_stats);
+
+    static uint64_t getNumKeys();
+
+    // drops the stats of deleted keys, so they do not take slots of KEY_STATS_MAX_KEYS
+    static void forgetKeysWithPrefix(const string &_prefix);
+
+    static void save();
+
+    static void initSaver();
+
+    static void exitSaver();
+};
+
+#endif //SGXWALLET_KEYSTATS_H
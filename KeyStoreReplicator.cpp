@@ -0,0 +1,180 @@
+/*
+    Copyright (C) 2021-Present SKALE Labs
+
+    This file is part of sgxwallet.
+
+    sgxwallet is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as published
+    by the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    sgxwallet is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with sgxwallet. If not, see <https://www.gnu.org/licenses/>.
+
+    @file KeyStoreReplicator.cpp
+    @author Stan Kladko
+    @date 2021
+*/
+
+#include <ctime>
+#include <tuple>
+#include <unistd.h>
+#include <vector>
+
+#include <jsonrpccpp/client/connectors/httpclient.h>
+
+#include "sgxwallet_common.h"
+#include "SGXException.h"
+#include "ExitHandler.h"
+#include "LevelDB.h"
+#include "stubclient.h"
+#include "zmq_src/KeyOwnerIndex.h"
+#include "zmq_src/ZMQMessage.h"
+#include "third_party/spdlog/spdlog.h"
+#include "common.h"
+
+#include "KeyStoreReplicator.h"
+
+string KeyStoreReplicator::leaderHost = "";
+atomic<bool> KeyStoreReplicator::exitRequested(false);
+shared_ptr<thread> KeyStoreReplicator::replicatorThread = nullptr;
+atomic<uint64_t> KeyStoreReplicator::passes(0);
+atomic<uint64_t> KeyStoreReplicator::keysReplicated(0);
+atomic<uint64_t> KeyStoreReplicator::errors(0);
+atomic<uint64_t> KeyStoreReplicator::lastSyncTime(0);
+
+void KeyStoreReplicator::setLeaderHost(const string &_leaderHost) {
+    if (_leaderHost.find_first_of(" /:") != string::npos) {
+        throw SGXException(INVALID_REPLICATION_LEADER, string(__FUNCTION__) +
+                                                       ":Leader has to be a host name or IPv4 address");
+    }
+    leaderHost = _leaderHost;
+}
+
+bool KeyStoreReplicator::isReplicatedKey(const string &_keyName) {
+    return _keyName != "SEK" && _keyName != "SEK_NEXT" && _keyName.rfind(INDEX_NAMESPACE_PREFIX, 0) != 0;
+}
+
+uint64_t KeyStoreReplicator::importEntries(const vector<tuple<string, string, string>> &_entries) {
+    auto written = LevelDB::getLevelDb()->importValues(_entries);
+
+    // the ZMQ server loads the owners once at startup, later ones have to be added here
+    vector<pair<string, string>> owners;
+    for (auto &&entry : _entries) {
+        auto &keyName = get<0>(entry);
+        auto ownerKeyName = KeyOwnerIndex::getOwnerKeyName("");
+        if (keyName.size() > ownerKeyName.size() &&
+            keyName.compare(keyName.size() - ownerKeyName.size(), ownerKeyName.size(), ownerKeyName) == 0) {
+            owners.emplace_back(keyName.substr(0, keyName.size() - ownerKeyName.size()), get<1>(entry));
+        }
+    }
+
+    if (!owners.empty()) {
+        ZMQMessage::importKeyOwners(owners);
+    }
+
+    return written;
+}
+
+uint64_t KeyStoreReplicator::syncOnce(const string &_url, string &_cursor) {
+    jsonrpc::HttpClient client(_url);
+    StubClient c(client, jsonrpc::JSONRPC_CLIENT_V2);
+
+    uint64_t written = 0;
+    uint64_t newest = 0;
+
+    while (true) {
+        auto page = c.getReplicationPage(_cursor, REPLICATION_PAGE_SIZE);
+        if (page["status"].asInt() != 0) {
+            throw SGXException(page["status"].asInt(), page["errorMessage"].asString());
+        }
+
+        vector<tuple<string, string, string>> entries;
+        for (auto &&key : page["keys"]) {
+            auto keyName = key["keyName"].asString();
+            auto creationTime = key["creationTime"].asString();
+            CHECK_STATE(!creationTime.empty());
+            if (isReplicatedKey(keyName)) {
+                entries.emplace_back(keyName, key["value"].asString(), creationTime);
+                newest = max<uint64_t>(newest, stoull(creationTime));
+            }
+        }
+
+        if (!entries.empty()) {
+            written += importEntries(entries);
+        }
+
+        auto nextCursor = page["nextCursor"].asString();
+        if (nextCursor.empty()) {
+            break;
+        }
+        _cursor = nextCursor;
+    }
+
+    // keys written later in the same second may sort before the last one seen
+    if (newest > 0) {
+        _cursor = LevelDB::creationTimeCursor(newest > REPLICATION_OVERLAP_SECONDS ?
+                                              newest - REPLICATION_OVERLAP_SECONDS : 0);
+    }
+
+    return written;
+}
+
+void KeyStoreReplicator::replicationLoop() {
+    auto url = "http://" + leaderHost + ":" + to_string(BASE_PORT + 4);
+    string cursor;
+
+    while (!exitRequested && !ExitHandler::shouldExit()) {
+        try {
+            auto written = syncOnce(url, cursor);
+            passes++;
+            lastSyncTime = time(nullptr);
+            if (written > 0) {
+                keysReplicated += written;
+                spdlog::info("Replicated {} keys from {}", written, leaderHost);
+            }
+        } catch (SGXException &e) {
+            errors++;
+            spdlog::error("Key store replication failed: {}", e.getMessage());
+        } catch (exception &e) {
+            errors++;
+            spdlog::error("Key store replication failed: {}", e.what());
+        }
+
+        for (uint64_t i = 0; i < REPLICATION_INTERVAL_MS / 100 && !exitRequested && !ExitHandler::shouldExit(); i++) {
+            usleep(100 * 1000);
+        }
+    }
+}
+
+uint64_t KeyStoreReplicator::getLagSeconds() {
+    if (!isFollower()) {
+        return 0;
+    }
+    uint64_t now = time(nullptr);
+    return now - min<uint64_t>(now, lastSyncTime);
+}
+
+void KeyStoreReplicator::initReplicator() {
+    if (!isFollower()) {
+        return;
+    }
+
+    CHECK_STATE(!replicatorThread);
+
+    spdlog::info("Following the key store of {}", leaderHost);
+    replicatorThread = make_shared<thread>(replicationLoop);
+}
+
+void KeyStoreReplicator::exitReplicator() {
+    exitRequested = true;
+    if (replicatorThread) {
+        replicatorThread->join();
+        replicatorThread = nullptr;
+    }
+}
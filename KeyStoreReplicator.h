@@ -0,0 +1,101 @@
+/*
+    Copyright (C) 2021-Present SKALE Labs
+
+    This file is part of sgxwallet.
+
+    sgxwallet is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as published
+    by the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    sgxwallet is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with sgxwallet. If not, see <https://www.gnu.org/licenses/>.
+
+    @file KeyStoreReplicator.h
+    @author Stan Kladko
+    @date 2021
+*/
+
+#ifndef SGXWALLET_KEYSTOREREPLICATOR_H
+#define SGXWALLET_KEYSTOREREPLICATOR_H
+
+#include <atomic>
+#include <memory>
+#include <string>
+#include <thread>
+#include <tuple>
+#include <vector>
+
+using namespace std;
+
+// Cluster mode. A follower sgxwallet, started with -F <leader host>, copies the key store of the
+// leader through the getReplicationPage method of its info server. Every follower has to be
+// restored from the backup key of the leader first, so that all nodes share the SEK and can
+// decrypt each other's keys.
+//
+// Keys are pulled in creation time order. Creation times have a resolution of one second, so
+// each pass starts REPLICATION_OVERLAP_SECONDS before the newest key of the previous pass, and
+// keys that are already there are skipped. Deletes are not replicated, DKG intermediates on the
+// followers are removed by their own DKG garbage collection. The sealed SEK is bound to the
+// machine and is never replicated.
+//
+// Followers serve sign and other read only requests. Key generation, imports and DKG have to go
+// to the leader, the ZMQ server of a follower rejects them with KEY_STORE_READ_ONLY.
+class KeyStoreReplicator {
+
+    // empty unless this node is a follower
+    static string leaderHost;
+
+    static atomic<bool> exitRequested;
+
+    static shared_ptr<thread> replicatorThread;
+
+    static atomic<uint64_t> passes;
+
+    static atomic<uint64_t> keysReplicated;
+
+    static atomic<uint64_t> errors;
+
+    // time of the last pass that reached the end of the leader key store
+    static atomic<uint64_t> lastSyncTime;
+
+    static void replicationLoop();
+
+public:
+
+    static void setLeaderHost(const string &_leaderHost);
+
+    static const string &getLeaderHost() { return leaderHost; }
+
+    static bool isFollower() { return !leaderHost.empty(); }
+
+    static bool isReplicatedKey(const string &_keyName);
+
+    // copies the keys created since _cursor from the info server at _url and advances _cursor,
+    // returns the number of keys written
+    static uint64_t syncOnce(const string &_url, string &_cursor);
+
+    // writes keys copied from the leader as (keyName, value, creationTime), and hands the owner
+    // records among them to the ZMQ owner index. Returns the number of keys written
+    static uint64_t importEntries(const vector<tuple<string, string, string>> &_entries);
+
+    static void initReplicator();
+
+    static void exitReplicator();
+
+    static uint64_t getPasses() { return passes; }
+
+    static uint64_t getKeysReplicated() { return keysReplicated; }
+
+    static uint64_t getErrors() { return errors; }
+
+    // seconds since the follower was last in sync with the leader, zero on the leader
+    static uint64_t getLagSeconds();
+};
+
+#endif //SGXWALLET_KEYSTOREREPLICATOR_H
@@ -0,0 +1,100 @@
+/*
+    Copyright (C) 2021-Present SKALE Labs
+
+    This file is part of sgxwallet.
+
+    sgxwallet is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as published
+    by the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    sgxwallet is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with sgxwallet. If not, see <https://www.gnu.org/licenses/>.
+
+    @file KeyValueStore.h
+    @author Stan Kladko
+    @date 2021
+*/
+
+
+#ifndef SGXWALLET_KEYVALUESTORE_H
+#define SGXWALLET_KEYVALUESTORE_H
+
+#include <functional>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+using namespace std;
+
+// Storage engine under a LevelDB database, see LevelDBStore and MappedStore. Keys are ordered
+// bytewise. Failures throw SGXException with COULD_NOT_ACCESS_DATABASE.
+class KeyValueStore {
+
+public:
+
+    // puts and deletes applied in order, as one atomic write
+    class Batch {
+
+    public:
+
+        struct Op {
+            string key;
+            string value;
+            bool isDelete;
+        };
+
+        void put(const string &_key, const string &_value) { ops.push_back({_key, _value, false}); }
+
+        void del(const string &_key) { ops.push_back({_key, "", true}); }
+
+        void clear() { ops.clear(); }
+
+        bool empty() const { return ops.empty(); }
+
+        const vector<Op> &getOps() const { return ops; }
+
+    private:
+
+        vector<Op> ops;
+    };
+
+    // returns false to stop the scan. The views are valid during the call only, and the visitor
+    // must not call the store
+    typedef function<bool(string_view _key, string_view _value)> Visitor;
+
+    virtual ~KeyValueStore() = default;
+
+    // false if there is no such key
+    virtual bool get(const string &_key, string &_value) = 0;
+
+    // the values of _keys as of one point in time, null for missing keys
+    virtual vector<shared_ptr<string>> getMany(const vector<string> &_keys) = 0;
+
+    // applies the batch atomically, it may be lost on a crash until the next sync
+    virtual void write(const Batch &_batch) = 0;
+
+    // makes all completed writes durable
+    virtual void sync() = 0;
+
+    // visits the keys from _from on, in order
+    virtual void scan(const string &_from, const Visitor &_visitor) = 0;
+
+    // the last key before _before, false if there is none
+    virtual bool findLast(const string &_before, string &_key) = 0;
+
+    virtual uint64_t getApproximateSize() = 0;
+
+    virtual void compact() = 0;
+
+    // compacts the keys in [_begin, _end), stores without range compaction compact everything
+    virtual void compactRange(const string &_begin, const string &_end) { compact(); }
+};
+
+#endif //SGXWALLET_KEYVALUESTORE_H
@@ -0,0 +1,264 @@
+/*
+    Copyright (C) 2021-Present SKALE Labs
+
+    This file is part of sgxwallet.
+
+    sgxwallet is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as published
+    by the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    sgxwallet is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with sgxwallet. If not, see <https://www.gnu.org/licenses/>.
+
+    @file KeyWarmUp.cpp
+    @author Stan Kladko
+    @date 2021
+*/
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <ctime>
+#include <fstream>
+#include <unordered_set>
+#include <unistd.h>
+
+#include "sgxwallet_common.h"
+#include "sgxwallet.h"
+#include "SGXException.h"
+#include "ExitHandler.h"
+#include "CryptoTools.h"
+#include "LevelDB.h"
+#include "third_party/spdlog/spdlog.h"
+#include "common.h"
+#include "Metrics.h"
+
+#include "KeyWarmUp.h"
+
+bool KeyWarmUp::enabled = false;
+atomic<bool> KeyWarmUp::exitRequested(false);
+shared_ptr<thread> KeyWarmUp::saveThread = nullptr;
+mutex KeyWarmUp::countsMutex;
+unordered_map<string, uint64_t> KeyWarmUp::useCounts;
+
+static bool isSigningKey(const string &_name) {
+    return _name.rfind("BLS_KEY", 0) == 0 || _name.rfind("NEK:", 0) == 0;
+}
+
+vector<pair<string, uint64_t>> KeyWarmUp::loadHotKeys() {
+    vector<pair<string, uint64_t>> keys;
+
+    ifstream file(HOT_KEYS_FILE);
+    string line;
+
+    // "<name> <count>" lines, a line without a count is a name only
+    while (keys.size() < WARM_UP_MAX_KEYS && getline(file, line)) {
+        auto separator = line.rfind(' ');
+        auto name = line.substr(0, separator);
+        uint64_t count = 0;
+        if (separator != string::npos) {
+            count = strtoull(line.c_str() + separator + 1, nullptr, 10);
+        }
+        if (isSigningKey(name)) {
+            keys.emplace_back(name, count);
+        }
+    }
+
+    return keys;
+}
+
+vector<string> KeyWarmUp::recentKeys() {
+    auto db = LevelDB::getLevelDb();
+    vector<string> names;
+
+    string cursor = LevelDB::creationTimeCursor(time(nullptr) - WARM_UP_RECENT_KEYS_SECONDS);
+
+    // pages come oldest first, so only the last WARM_UP_MAX_KEYS names are kept
+    do {
+        string nextCursor;
+        auto page = db->getKeysCreatedSince(cursor, LEVELDB_KEYS_PAGE_SIZE, nextCursor);
+        for (auto &&entry: page) {
+            if (isSigningKey(entry.first)) {
+                names.push_back(entry.first);
+            }
+        }
+        if (names.size() > WARM_UP_MAX_KEYS) {
+            names.erase(names.begin(), names.end() - WARM_UP_MAX_KEYS);
+        }
+        cursor = nextCursor;
+    } while (!cursor.empty());
+
+    // newest first
+    return vector<string>(names.rbegin(), names.rend());
+}
+
+uint64_t KeyWarmUp::warmUpKeys() {
+    vector<string> names;
+    unordered_set<string> seen;
+
+    {
+        lock_guard<mutex> lock(countsMutex);
+        for (auto &&key: loadHotKeys()) {
+            if (seen.insert(key.first).second) {
+                names.push_back(key.first);
+                if (key.second > 0) {
+                    useCounts[key.first] += key.second;
+                }
+            }
+        }
+    }
+
+    for (auto &&name: recentKeys()) {
+        if (names.size() < WARM_UP_MAX_KEYS && seen.insert(name).second) {
+            names.push_back(name);
+        }
+    }
+
+    auto db = LevelDB::getLevelDb();
+    uint64_t warmed = 0;
+    vector<char> errMsg(BUF_LEN, 0);
+
+    for (auto &&name: names) {
+        auto value = db->readString(name);
+        if (!value) {
+            continue;
+        }
+
+        vector<uint8_t> encryptedKey(BUF_LEN, 0);
+        uint64_t decLen = 0;
+        if (!hex2carray(value->c_str(), &decLen, encryptedKey.data(), BUF_LEN)) {
+            continue;
+        }
+
+        int errStatus = 0;
+        auto status = ECALL(trustedWarmUpKey, shardEid(encryptedKey.data(), decLen), &errStatus, errMsg.data(),
+                            encryptedKey.data(), decLen);
+
+        if (status != SGX_SUCCESS || errStatus != 0) {
+            spdlog::warn("Could not warm up key {}: {}", name, errMsg.data());
+            continue;
+        }
+
+        warmed++;
+    }
+
+    spdlog::info("Warmed up {} of {} keys", warmed, names.size());
+
+    return warmed;
+}
+
+void KeyWarmUp::warmUpThread() {
+    if (!enabled) {
+        return;
+    }
+
+    for (uint64_t i = 0; i < numEnclaveShards; i++) {
+        ECALL(trustedWarmUpThread, enclaveShards[i]);
+    }
+}
+
+void KeyWarmUp::recordUse(const string &_keyName) {
+    if (!enabled) {
+        return;
+    }
+
+    lock_guard<mutex> lock(countsMutex);
+
+    auto it = useCounts.find(_keyName);
+    if (it != useCounts.end()) {
+        it->second++;
+    } else if (useCounts.size() < HOT_KEYS_MAX_TRACKED) {
+        useCounts.emplace(_keyName, 1);
+    }
+}
+
+void KeyWarmUp::saveHotKeys() {
+    if (!enabled) {
+        return;
+    }
+
+    vector<pair<string, uint64_t>> keys;
+    {
+        lock_guard<mutex> lock(countsMutex);
+        keys.assign(useCounts.begin(), useCounts.end());
+
+        for (auto it = useCounts.begin(); it != useCounts.end();) {
+            it->second /= 2;
+            it = it->second == 0 ? useCounts.erase(it) : next(it);
+        }
+    }
+
+    sort(keys.begin(), keys.end(), [](const pair<string, uint64_t> &_a, const pair<string, uint64_t> &_b) {
+        return _a.second > _b.second;
+    });
+
+    if (keys.size() > WARM_UP_MAX_KEYS) {
+        keys.resize(WARM_UP_MAX_KEYS);
+    }
+
+    // then the keys that are read without being signed with, most recently used first
+    unordered_set<string> seen;
+    for (auto &&key: keys) {
+        seen.insert(key.first);
+    }
+
+    for (auto &&name: LevelDB::getLevelDb()->getCache().getKeys(WARM_UP_MAX_KEYS)) {
+        if (keys.size() < WARM_UP_MAX_KEYS && isSigningKey(name) && seen.insert(name).second) {
+            keys.emplace_back(name, 0);
+        }
+    }
+
+    string tmpName = string(HOT_KEYS_FILE) + ".tmp";
+    {
+        ofstream file(tmpName, ios::trunc);
+        for (auto &&key: keys) {
+            file << key.first << " " << key.second << "\n";
+        }
+        if (!file.good()) {
+            spdlog::error("Could not write {}", tmpName);
+            return;
+        }
+    }
+
+    if (rename(tmpName.c_str(), HOT_KEYS_FILE) != 0) {
+        spdlog::error("Could not write {}", HOT_KEYS_FILE);
+    }
+}
+
+void KeyWarmUp::saveLoop() {
+    while (!exitRequested && !ExitHandler::shouldExit()) {
+        for (uint64_t i = 0; i < HOT_KEYS_SAVE_INTERVAL_SECONDS && !exitRequested && !ExitHandler::shouldExit(); i++) {
+            sleep(1);
+        }
+
+        try {
+            saveHotKeys();
+        } catch (exception &e) {
+            spdlog::error("Could not save hot keys: {}", e.what());
+        }
+    }
+}
+
+void KeyWarmUp::initSaver() {
+    if (!enabled) {
+        return;
+    }
+
+    CHECK_STATE(!saveThread);
+    saveThread = make_shared<thread>(saveLoop);
+}
+
+void KeyWarmUp::exitSaver() {
+    exitRequested = true;
+    if (saveThread) {
+        saveThread->join();
+        saveThread = nullptr;
+    }
+    saveHotKeys();
+}
@@ -0,0 +1,88 @@
+/*
+    Copyright (C) 2021-Present SKALE Labs
+
+    This file is part of sgxwallet.
+
+    sgxwallet is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as published
+    by the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    sgxwallet is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with sgxwallet. If not, see <https://www.gnu.org/licenses/>.
+
+    @file KeyWarmUp.h
+    @author Stan Kladko
+    @date 2021
+*/
+
+#ifndef SGXWALLET_KEYWARMUP_H
+#define SGXWALLET_KEYWARMUP_H
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+using namespace std;
+
+// Optional warm-up before the ports open, so that the first signs after a restart are not slow.
+// Up to WARM_UP_MAX_KEYS signing keys, the keys used before the restart first and then the most
+// recently created ones, are read into the database cache and decrypted into the enclave key
+// cache. Each ZMQ worker thread also touches the scratch arena of its TCS before it starts.
+//
+// Every HOT_KEYS_SAVE_INTERVAL_SECONDS and on exit, the names of the hottest keys are saved to
+// HOT_KEYS_FILE with their sign counts, followed by the other signing keys in the database cache.
+// Counts are halved after each save, so keys that are no longer used fade out. Only names are
+// saved, never key material.
+class KeyWarmUp {
+
+    static bool enabled;
+
+    static atomic<bool> exitRequested;
+
+    static shared_ptr<thread> saveThread;
+
+    static mutex countsMutex;
+
+    // sign counts, seeded from HOT_KEYS_FILE at warm-up
+    static unordered_map<string, uint64_t> useCounts;
+
+    // (name, count) pairs of HOT_KEYS_FILE, hottest first
+    static vector<pair<string, uint64_t>> loadHotKeys();
+
+    static void saveLoop();
+
+    static vector<string> recentKeys();
+
+public:
+
+    static void setEnabled(bool _enabled) { enabled = _enabled; }
+
+    static bool isEnabled() { return enabled; }
+
+    // returns the number of keys warmed up
+    static uint64_t warmUpKeys();
+
+    // called by each worker thread before it serves requests
+    static void warmUpThread();
+
+    static void recordUse(const string &_keyName);
+
+    static void saveHotKeys();
+
+    static void initSaver();
+
+    static void exitSaver();
+};
+
+#endif //SGXWALLET_KEYWARMUP_H
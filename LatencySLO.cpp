@@ -0,0 +1,107 @@
+/*
+    Copyright (C) 2021-Present SKALE Labs
+
+    This file is part of sgxwallet.
+
+    sgxwallet is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as published
+    by the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    sgxwallet is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with sgxwallet. If not, see <https://www.gnu.org/licenses/>.
+
+    @file LatencySLO.cpp
+    @author Stan Kladko
+    @date 2021
+*/
+
+
+#include "sgxwallet_common.h"
+#include "third_party/spdlog/spdlog.h"
+
+#include "LatencySLO.h"
+
+atomic<uint64_t> LatencySLO::targetUs(0);
+atomic<bool> LatencySLO::atRisk(false);
+atomic<uint64_t> LatencySLO::p99Us(0);
+atomic<uint64_t> LatencySLO::burnRateMilli(0);
+atomic<uint64_t> LatencySLO::degradations(0);
+atomic<uint64_t> LatencySLO::shed(0);
+atomic<uint64_t> LatencySLO::deferred(0);
+mutex LatencySLO::windowMutex;
+deque<HistogramSnapshot> LatencySLO::window;
+uint64_t LatencySLO::recoveringSeconds = 0;
+
+void LatencySLO::setTargetMs(uint64_t _targetMs) {
+    lock_guard<mutex> lock(windowMutex);
+    targetUs = _targetMs * 1000;
+    window.clear();
+    recoveringSeconds = 0;
+    atRisk = false;
+    p99Us = 0;
+    burnRateMilli = 0;
+}
+
+MetricsHistogram &LatencySLO::getSignLatency() {
+    static auto &signLatency = Metrics::getHistogram("zmqBlsSignLatency");
+    return signLatency;
+}
+
+void LatencySLO::update() {
+    auto target = targetUs.load();
+    if (target == 0) {
+        return;
+    }
+
+    auto current = getSignLatency().snapshot();
+
+    lock_guard<mutex> lock(windowMutex);
+
+    window.push_back(current);
+    if (window.size() > SLO_WINDOW_SECONDS + 1) {
+        window.pop_front();
+    }
+
+    auto recent = current - window.front();
+
+    auto p99 = recent.quantileUs(SLO_QUANTILE);
+    p99Us = p99;
+    burnRateMilli = recent.count == 0 ? 0 : (uint64_t) (1000.0 * recent.countAboveUs(target) / recent.count /
+                                                        (1 - SLO_QUANTILE));
+
+    // a handful of requests says little about the p99, and a quiet server is not at risk
+    bool enoughSamples = recent.count >= SLO_MIN_SAMPLES;
+
+    if (!atRisk) {
+        if (enoughSamples && p99 * 100 >= target * SLO_DEGRADE_PERCENT) {
+            atRisk = true;
+            recoveringSeconds = 0;
+            degradations++;
+            spdlog::warn("p99 BLS sign latency {} us is close to the objective of {} us, deferring low priority work",
+                         p99, target);
+        }
+    } else if (!enoughSamples || p99 * 100 < target * SLO_RECOVER_PERCENT) {
+        if (++recoveringSeconds >= SLO_RECOVER_SECONDS) {
+            atRisk = false;
+            spdlog::info("p99 BLS sign latency {} us is back below the objective of {} us", p99, target);
+        }
+    } else {
+        recoveringSeconds = 0;
+    }
+}
+
+bool LatencySLO::deferBackgroundWork(const char *_what) {
+    if (!isAtRisk()) {
+        return false;
+    }
+
+    deferred++;
+    spdlog::debug("Deferring {} to keep the BLS sign latency objective", _what);
+    return true;
+}
@@ -0,0 +1,107 @@
+/*
+    Copyright (C) 2021-Present SKALE Labs
+
+    This file is part of sgxwallet.
+
+    sgxwallet is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as published
+    by the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    sgxwallet is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with sgxwallet. If not, see <https://www.gnu.org/licenses/>.
+
+    @file LatencySLO.h
+    @author Stan Kladko
+    @date 2021
+*/
+
+
+#ifndef SGXWALLET_LATENCYSLO_H
+#define SGXWALLET_LATENCYSLO_H
+
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+
+#include "Metrics.h"
+
+using namespace std;
+
+// Defends a p99 objective for the latency of ZMQ BLS sign requests, from receipt by the router
+// thread to the queued reply, set with sgxwallet -1. Metrics calls update once a second, which
+// computes the p99 and the burn rate over the last SLO_WINDOW_SECONDS. While the p99 is above
+// SLO_DEGRADE_PERCENT of the target the objective is at risk: low priority calls fail at once
+// with SLO_SHED, background work is deferred and sign batches wait shorter. It ends after
+// SLO_RECOVER_SECONDS in a row below SLO_RECOVER_PERCENT of the target.
+class LatencySLO {
+
+    static atomic<uint64_t> targetUs;
+
+    static atomic<bool> atRisk;
+
+    static atomic<uint64_t> p99Us;
+
+    // the burn rate in thousandths
+    static atomic<uint64_t> burnRateMilli;
+
+    static atomic<uint64_t> degradations;
+
+    static atomic<uint64_t> shed;
+
+    static atomic<uint64_t> deferred;
+
+    static mutex windowMutex;
+
+    // one snapshot of the sign latency per update, oldest first
+    static deque<HistogramSnapshot> window;
+
+    static uint64_t recoveringSeconds;
+
+public:
+
+    // 0 turns the objective off
+    static void setTargetMs(uint64_t _targetMs);
+
+    static uint64_t getTargetUs() { return targetUs.load(); }
+
+    static MetricsHistogram &getSignLatency();
+
+    // called by the metrics sampler once a second
+    static void update();
+
+    static bool isAtRisk() { return atRisk.load(memory_order_relaxed); }
+
+    // p99 of the sign latency over the window
+    static uint64_t getP99Us() { return p99Us.load(); }
+
+    // share of sign requests over the target divided by the share the objective allows, above 1
+    // the error budget is used up faster than it accrues
+    static double getBurnRate() { return burnRateMilli.load() / 1000.0; }
+
+    static uint64_t getDegradations() { return degradations.load(); }
+
+    static void countShed() { shed++; }
+
+    static uint64_t getShed() { return shed.load(); }
+
+    // true while the objective is at risk, background loops then skip one round of _what
+    static bool deferBackgroundWork(const char *_what);
+
+    static uint64_t getDeferred() { return deferred.load(); }
+};
+
+#define SLO_SHED_LOW_PRIORITY \
+if (LatencySLO::isAtRisk()) { \
+    LatencySLO::countShed(); \
+    throw SGXException(SLO_SHED, string(__FUNCTION__) + ":Deferred to keep sign latency, try again later"); \
+}
+
+#endif //SGXWALLET_LATENCYSLO_H
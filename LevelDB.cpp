@@ -25,23 +25,28 @@
 #include <memory>
 #include <string>
 #include <iostream>
+#include <cstring>
+#include <ctime>
+#include <tuple>
+#include <unordered_set>
 
-#include "leveldb/db.h"
+#include <sys/stat.h>
 #include <jsonrpccpp/client.h>
 
 #include "sgxwallet_common.h"
 #include "SGXException.h"
+#include "LevelDBStore.h"
+#include "MappedStore.h"
+#include "PartitionedStore.h"
 #include "LevelDB.h"
 
 #include "ServerInit.h"
 
 #include "third_party/spdlog/spdlog.h"
 #include "common.h"
-
-using namespace leveldb;
-
-static WriteOptions writeOptions;
-static ReadOptions readOptions;
+#include "Metrics.h"
+#include "DKGTimeline.h"
+#include "Numa.h"
 
 shared_ptr<string> LevelDB::readNewStyleValue(const string& value) {
     Json::Value key_data;
@@ -51,185 +56,821 @@ shared_ptr<string> LevelDB::readNewStyleValue(const string& value) {
     return std::make_shared<string>(key_data["value"].asString());
 }
 
+static const char HEX_DIGITS[] = "0123456789abcdef";
+
+// only lower case hex is stored as bytes, so that decoding gives back the same string
+static bool isLowerCaseHex(const string &_value) {
+    if (_value.empty() || _value.size() % 2 != 0) {
+        return false;
+    }
+    for (unsigned char c : _value) {
+        if (!((c >= '0' && c <= '9') || (c >= 'a' && c <= 'f'))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static uint8_t hexDigit(char _c) {
+    return _c <= '9' ? _c - '0' : _c - 'a' + 10;
+}
+
+string LevelDB::encodeValue(const string &_value, uint64_t _timestamp) {
+    if (!isLowerCaseHex(_value)) {
+        Json::Value writerData;
+        writerData["value"] = _value;
+        writerData["timestamp"] = std::to_string(_timestamp);
+
+        Json::FastWriter fastWriter;
+        return fastWriter.write(writerData);
+    }
+
+    string output(1 + sizeof(uint64_t) + _value.size() / 2, '\0');
+    output[0] = LEVELDB_BINARY_VALUE_VERSION;
+    for (uint64_t i = 0; i < sizeof(uint64_t); i++) {
+        output[1 + i] = (char) (_timestamp >> (8 * i));
+    }
+    for (uint64_t i = 0; i < _value.size() / 2; i++) {
+        output[1 + sizeof(uint64_t) + i] = (char) ((hexDigit(_value[2 * i]) << 4) | hexDigit(_value[2 * i + 1]));
+    }
+    return output;
+}
+
+string LevelDB::decodeValue(const string &_rawValue, string *_timestamp) {
+    if (!_rawValue.empty() && _rawValue.at(0) == LEVELDB_BINARY_VALUE_VERSION &&
+        _rawValue.size() > 1 + sizeof(uint64_t)) {
+        if (_timestamp) {
+            uint64_t timestamp = 0;
+            for (uint64_t i = 0; i < sizeof(uint64_t); i++) {
+                timestamp |= (uint64_t) (uint8_t) _rawValue[1 + i] << (8 * i);
+            }
+            *_timestamp = to_string(timestamp);
+        }
+
+        string value(2 * (_rawValue.size() - 1 - sizeof(uint64_t)), '\0');
+        for (uint64_t i = 1 + sizeof(uint64_t), j = 0; i < _rawValue.size(); i++, j += 2) {
+            auto byte = (uint8_t) _rawValue[i];
+            value[j] = HEX_DIGITS[byte >> 4];
+            value[j + 1] = HEX_DIGITS[byte & 0x0F];
+        }
+        return value;
+    }
+
+    if (!_rawValue.empty() && _rawValue.at(0) == '{') {
+        Json::Value keyData;
+        Json::Reader reader;
+        reader.parse(_rawValue, keyData);
+        if (_timestamp) {
+            *_timestamp = keyData["timestamp"].asString();
+        }
+        return keyData["value"].asString();
+    }
+
+    // old style values have no timestamp
+    if (_timestamp) {
+        _timestamp->clear();
+    }
+    return _rawValue;
+}
+
 std::shared_ptr<string> LevelDB::readString(const string &_key) {
 
-    auto result = std::make_shared<string>();
+    auto cached = cache.get(_key);
+
+    if (cached) {
+        return cached;
+    }
 
-    CHECK_STATE(db)
+    METRICS_TIMER("leveldbRead")
+    PERF_STAGE("leveldbRead")
+    TRACE_SPAN("leveldb.read")
 
-    auto status = db->Get(readOptions, _key, result.get());
+    auto generation = cache.getGeneration(_key);
+
+    auto result = std::make_shared<string>();
 
-    throwExceptionOnError(status);
+    CHECK_STATE(store)
 
-    if (status.IsNotFound()) {
+    if (!store->get(_key, *result)) {
         return nullptr;
     }
 
-    if (result->at(0) == '{') {
-        return readNewStyleValue(*result);
+    *result = decodeValue(*result);
+
+    // DKG store keys are read rarely, they would only evict hot keys from the cache
+    if (!separateDKGStore || !isDKGStoreKey(_key)) {
+        cache.put(_key, *result, generation);
     }
 
     return result;
 }
 
-void LevelDB::writeString(const string &_key, const string &_value) {
-    Json::Value writerData;
-    writerData["value"] = _value;
-    writerData["timestamp"] = std::to_string(std::time(nullptr));
-
-    Json::FastWriter fastWriter;
-    std::string output = fastWriter.write(writerData);
+vector<shared_ptr<string>> LevelDB::readRawStrings(const vector<string> &_keys) {
+    METRICS_TIMER("leveldbRead")
+    PERF_STAGE("leveldbRead")
+    TRACE_SPAN("leveldb.readMany")
 
-    auto status = db->Put(writeOptions, Slice(_key), Slice(output));
+    CHECK_STATE(store)
 
-    throwExceptionOnError(status);
+    // no cache lookups, cached values could be from different points in time
+    return store->getMany(_keys);
 }
 
-void LevelDB::deleteDHDKGKey(const string &_key) {
+string LevelDB::creationTimeIndexKey(const string &_key, const string &_rawValue) {
+    string timestamp;
+    decodeValue(_rawValue, &timestamp);
 
-    string full_key = "DKG_DH_KEY_" + _key;
+    if (timestamp.empty()) {
+        // old style values have no timestamp and are not indexed
+        return "";
+    }
 
-    auto status = db->Delete(writeOptions, Slice(full_key));
+    if (timestamp.size() < CREATION_TIME_INDEX_TIMESTAMP_LEN) {
+        timestamp = string(CREATION_TIME_INDEX_TIMESTAMP_LEN - timestamp.size(), '0') + timestamp;
+    }
 
-    throwExceptionOnError(status);
+    return CREATION_TIME_INDEX_PREFIX + timestamp + ":" + _key;
+}
 
+bool LevelDB::isIndexKey(string_view _key) {
+    return _key.rfind(INDEX_NAMESPACE_PREFIX, 0) == 0;
 }
 
-void LevelDB::deleteTempNEK(const string &_key) {
+// DKG intermediates and key owner records, which are written and deleted far more often than keys
+static const vector<string> DKG_STORE_PREFIXES = {"POLY:", "VV_POLY:", "DKG_DH_KEY_", "shareG2_",
+                                                  "encryptedSecretShare:", "tmp_NEK", BLS_PUBLIC_KEYS_PREFIX};
 
-    CHECK_STATE(_key.rfind("tmp_NEK", 0) == 0);
+static const string OWNER_SUFFIX = ":OWNER";
 
-    auto status = db->Delete(writeOptions, Slice(_key));
+bool LevelDB::isDKGStoreKey(string_view _key) {
+    // an index entry is kept next to the key it indexes
+    if (_key.rfind(CREATION_TIME_INDEX_PREFIX, 0) == 0) {
+        auto separator = _key.find(':', strlen(CREATION_TIME_INDEX_PREFIX));
+        if (separator == string_view::npos) {
+            return false;
+        }
+        _key.remove_prefix(separator + 1);
+    }
 
-    throwExceptionOnError(status);
+    for (auto &&prefix: DKG_STORE_PREFIXES) {
+        if (_key.rfind(prefix, 0) == 0) {
+            return true;
+        }
+    }
+
+    return _key.size() > OWNER_SUFFIX.size() &&
+           _key.compare(_key.size() - OWNER_SUFFIX.size(), OWNER_SUFFIX.size(), OWNER_SUFFIX) == 0;
 }
 
-void LevelDB::deleteKey(const string &_key) {
+void LevelDB::batchPut(KeyValueStore::Batch &_batch, const string &_key, const string &_value, uint64_t _timestamp) {
+    auto output = encodeValue(_value, _timestamp ? _timestamp : std::time(nullptr));
 
-    auto status = db->Delete(writeOptions, Slice(_key));
+    batchDeleteIndexEntry(_batch, _key);
 
-    throwExceptionOnError(status);
+    _batch.put(_key, output);
+    _batch.put(creationTimeIndexKey(_key, output), "");
+}
 
+void LevelDB::batchDelete(KeyValueStore::Batch &_batch, const string &_key) {
+    batchDeleteIndexEntry(_batch, _key);
+    _batch.del(_key);
 }
 
-void LevelDB::throwExceptionOnError(Status _status) {
-    if (_status.IsNotFound())
+void LevelDB::batchDeleteIndexEntry(KeyValueStore::Batch &_batch, const string &_key) {
+    string oldValue;
+
+    if (store->get(_key, oldValue)) {
+        auto oldIndexKey = creationTimeIndexKey(_key, oldValue);
+        if (!oldIndexKey.empty()) {
+            _batch.del(oldIndexKey);
+        }
+    }
+}
+
+void LevelDB::commitBatch(KeyValueStore::Batch &_batch, const vector<string> &_keys, unique_lock<mutex> &_lock) {
+    if (_batch.empty()) {
         return;
+    }
 
-    if (!_status.ok()) {
-        throw SGXException(COULD_NOT_ACCESS_DATABASE, ("Could not access database database:" + _status.ToString()).c_str());
+    // writes of a DKG call are timed for its DKGTimeline, including the sync
+    auto dkgPhase = DKGTimeline::inPhase();
+    auto start = dkgPhase ? chrono::steady_clock::now() : chrono::steady_clock::time_point();
+
+    exception_ptr error;
+    uint64_t seq = 0;
+
+    try {
+        store->write(_batch);
+        seq = groupCommit->written();
+    } catch (...) {
+        error = current_exception();
+    }
+
+    for (auto &&key: _keys) {
+        cache.invalidate(key);
+    }
+
+    if (error) {
+        rethrow_exception(error);
+    }
+
+    // the write is visible to readers already, other writers may go on while it is synced
+    _lock.unlock();
+
+    groupCommit->waitDurable(seq);
+
+    if (dkgPhase) {
+        DKGTimeline::addDbUs(chrono::duration_cast<chrono::microseconds>(chrono::steady_clock::now() - start).count());
     }
 }
 
+void LevelDB::writeString(const string &_key, const string &_value) {
+    METRICS_TIMER("leveldbWrite")
+    TRACE_SPAN("leveldb.write")
+
+    KeyValueStore::Batch batch;
+
+    unique_lock<mutex> lock(writeMutex);
+
+    batchPut(batch, _key, _value);
+
+    commitBatch(batch, {_key}, lock);
+}
+
+void LevelDB::deleteDHDKGKey(const string &_key) {
+
+    string full_key = "DKG_DH_KEY_" + _key;
+
+    deleteKey(full_key);
+}
+
+void LevelDB::deleteTempNEK(const string &_key) {
+
+    CHECK_STATE(_key.rfind("tmp_NEK", 0) == 0);
+
+    deleteKey(_key);
+}
+
+void LevelDB::deleteKey(const string &_key) {
+
+    deleteKeys({_key});
+}
+
 uint64_t LevelDB::visitKeys(LevelDB::KeyVisitor *_visitor, uint64_t _maxKeysToVisit) {
 
     CHECK_STATE(_visitor);
 
     uint64_t readCounter = 0;
 
-    shared_ptr<leveldb::Iterator> it( db->NewIterator(readOptions) );
-    for (it->SeekToFirst(); it->Valid(); it->Next()) {
-        _visitor->visitDBKey(it->key().data());
-        readCounter++;
-        if (readCounter >= _maxKeysToVisit) {
-            break;
+    store->scan("", [&](string_view _key, string_view) {
+        if (isIndexKey(_key)) {
+            return true;
         }
-    }
+        _visitor->visitDBKey(string(_key).c_str());
+        readCounter++;
+        return readCounter < _maxKeysToVisit;
+    });
 
     return readCounter;
 }
 
 std::vector<string> LevelDB::writeKeysToVector1(uint64_t _maxKeysToVisit){
-  uint64_t readCounter = 0;
   std::vector<string> keys;
 
-  shared_ptr<leveldb::Iterator> it( db->NewIterator(readOptions) );
-  for (it->SeekToFirst(); it->Valid(); it->Next()) {
-    string cur_key(it->key().data(), it->key().size());
-    keys.push_back(cur_key);
-    readCounter++;
-    if (readCounter >= _maxKeysToVisit) {
-      break;
+  store->scan("", [&](string_view _key, string_view) {
+    if (isIndexKey(_key)) {
+      return true;
     }
-  }
+    keys.emplace_back(_key);
+    return keys.size() < _maxKeysToVisit;
+  });
 
   return keys;
 }
 
 void LevelDB::writeDataUnique(const string & name, const string &value) {
+  KeyValueStore::Batch batch;
+
+  unique_lock<mutex> lock(writeMutex);
+
   if (readString(name)) {
     spdlog::debug("Name {} already exists", name);
     throw SGXException(KEY_SHARE_ALREADY_EXISTS, "Data with this name already exists");
   }
 
-  writeString(name, value);
+  batchPut(batch, name, value);
+
+  commitBatch(batch, {name}, lock);
+}
+
+void LevelDB::writeBatchUnique(const vector<pair<string, string>> &_keyValues, const vector<string> &_keysToDelete) {
+    KeyValueStore::Batch batch;
+    vector<string> keys;
+
+    unique_lock<mutex> lock(writeMutex);
+
+    for (auto &&keyValue: _keyValues) {
+        if (readString(keyValue.first)) {
+            throw SGXException(KEY_NAME_ALREADY_EXISTS, string(__FUNCTION__) + ":Name already exists" + keyValue.first);
+        }
+        batchPut(batch, keyValue.first, keyValue.second);
+        keys.push_back(keyValue.first);
+    }
+
+    for (auto &&key: _keysToDelete) {
+        batchDelete(batch, key);
+        keys.push_back(key);
+    }
+
+    commitBatch(batch, keys, lock);
+}
+
+vector<bool> LevelDB::writeGroupsUnique(const vector<vector<pair<string, string>>> &_groups) {
+    KeyValueStore::Batch batch;
+    vector<string> keys;
+    unordered_set<string> batchKeys;
+    vector<bool> written(_groups.size(), false);
+
+    unique_lock<mutex> lock(writeMutex);
+
+    for (uint64_t i = 0; i < _groups.size(); i++) {
+        bool unique = true;
+        for (auto &&keyValue: _groups[i]) {
+            if (batchKeys.count(keyValue.first) || readString(keyValue.first)) {
+                unique = false;
+                break;
+            }
+        }
+
+        if (!unique) {
+            continue;
+        }
+
+        for (auto &&keyValue: _groups[i]) {
+            batchPut(batch, keyValue.first, keyValue.second);
+            batchKeys.insert(keyValue.first);
+            keys.push_back(keyValue.first);
+        }
+        written[i] = true;
+    }
+
+    if (!keys.empty()) {
+        commitBatch(batch, keys, lock);
+    }
+
+    return written;
+}
+
+uint64_t LevelDB::importValues(const vector<tuple<string, string, string>> &_entries) {
+    KeyValueStore::Batch batch;
+    vector<string> keys;
+
+    unique_lock<mutex> lock(writeMutex);
+
+    for (auto &&entry: _entries) {
+        auto &key = get<0>(entry);
+        auto &value = get<1>(entry);
+        auto &creationTime = get<2>(entry);
+
+        // entries that are already there are skipped, so an interrupted import can be repeated
+        auto existing = readString(key);
+        if (existing && *existing == value) {
+            continue;
+        }
+
+        if (creationTime.empty()) {
+            // old style values are restored as they are, without a timestamp
+            batchDeleteIndexEntry(batch, key);
+            batch.put(key, value);
+        } else {
+            batchPut(batch, key, value, std::stoull(creationTime));
+        }
+        keys.push_back(key);
+    }
+
+    commitBatch(batch, keys, lock);
+
+    return keys.size();
+}
+
+uint64_t LevelDB::replaceValues(const vector<tuple<string, string, string, string>> &_entries) {
+    KeyValueStore::Batch batch;
+    vector<string> keys;
+
+    unique_lock<mutex> lock(writeMutex);
+
+    for (auto &&entry: _entries) {
+        auto &key = get<0>(entry);
+        auto &newValue = get<2>(entry);
+        auto &creationTime = get<3>(entry);
+
+        auto existing = readString(key);
+        if (!existing || *existing != get<1>(entry)) {
+            continue;
+        }
+
+        if (creationTime.empty()) {
+            batchDeleteIndexEntry(batch, key);
+            batch.put(key, newValue);
+        } else {
+            batchPut(batch, key, newValue, std::stoull(creationTime));
+        }
+        keys.push_back(key);
+    }
+
+    commitBatch(batch, keys, lock);
+
+    return keys.size();
+}
+
+void LevelDB::deleteKeys(const vector<string> &_keys) {
+    KeyValueStore::Batch batch;
+
+    unique_lock<mutex> lock(writeMutex);
+
+    for (auto &&key: _keys) {
+        batchDelete(batch, key);
+    }
+
+    commitBatch(batch, _keys, lock);
+}
+
+vector<string> LevelDB::deleteKeysWithPrefixes(const vector<string> &_prefixes) {
+    KeyValueStore::Batch batch;
+    vector<string> keys;
+
+    unique_lock<mutex> lock(writeMutex);
+
+    for (auto &&prefix: _prefixes) {
+        CHECK_STATE(!prefix.empty() && prefix.back() != (char) 0xff);
+        store->scan(prefix, [&](string_view _key, string_view) {
+            if (_key.rfind(prefix, 0) != 0) {
+                return false;
+            }
+            if (!isIndexKey(_key)) {
+                keys.emplace_back(_key);
+            }
+            return true;
+        });
+    }
+
+    for (auto &&key: keys) {
+        batchDelete(batch, key);
+    }
+
+    commitBatch(batch, keys, lock);
+
+    if (!keys.empty()) {
+        for (auto &&prefix: _prefixes) {
+            // the first key after all keys with the prefix
+            auto end = prefix;
+            end.back()++;
+            store->compactRange(prefix, end);
+        }
+    }
+
+    return keys;
+}
+
+vector<pair<string, string>> LevelDB::getKeysPage(const string &_prefix, const string &_cursor, uint64_t _limit) {
+    vector<pair<string, string>> page;
+
+    if (_limit == 0) {
+        return page;
+    }
+
+    store->scan(_cursor.empty() ? _prefix : _cursor, [&](string_view _key, string_view _value) {
+        if (_key.rfind(_prefix, 0) != 0) {
+            return false;
+        }
+        if (!isIndexKey(_key) && _key != _cursor) {
+            page.emplace_back(string(_key), string(_value));
+        }
+        return page.size() < _limit;
+    });
+
+    return page;
+}
+
+string LevelDB::formatKeyInfo(const string &_key, const string &_rawValue) {
+    string timestampStr;
+    auto keyValue = decodeValue(_rawValue, &timestampStr);
+
+    string value;
+    if (!timestampStr.empty()) {
+        // new style keys
+        // same format as `date -d @timestamp`
+        time_t timestamp = std::stoll(timestampStr);
+        char date[64];
+        struct tm tm;
+        strftime(date, sizeof(date), "%a %b %e %H:%M:%S %Z %Y", localtime_r(&timestamp, &tm));
+
+        value = " VALUE: " + keyValue + ", TIMESTAMP: " + date + '\n' + '\n';
+    } else {
+        // old style keys
+        value = " VALUE: " + _rawValue;
+    }
+    return "KEY: " + _key + ',' + value;
 }
 
 pair<stringstream, uint64_t> LevelDB::getAllKeys() {
     stringstream keysInfo;
-
-    leveldb::Iterator *it = db->NewIterator(readOptions);
     uint64_t counter = 0;
-    for (it->SeekToFirst(); it->Valid(); it->Next()) {
-        ++counter;
-        string key = it->key().ToString();
-        string value;
-        if (it->value().ToString()[0] == '{') {
-            // new style keys
-            Json::Value key_data;
-            Json::Reader reader;
-            reader.parse(it->value().ToString().c_str(), key_data);
-
-            string timestamp_to_date_command = "date -d @" + key_data["timestamp"].asString();
-            value = " VALUE: " + key_data["value"].asString() + ", TIMESTAMP: " + exec(timestamp_to_date_command.c_str()) + '\n';
-        } else {
-            // old style keys
-            value = " VALUE: " + it->value().ToString();
+
+    string cursor;
+    while (true) {
+        auto page = getKeysPage("", cursor, LEVELDB_KEYS_PAGE_SIZE);
+        for (auto &&entry: page) {
+            keysInfo << formatKeyInfo(entry.first, entry.second);
+        }
+        counter += page.size();
+        if (page.size() < LEVELDB_KEYS_PAGE_SIZE) {
+            break;
         }
-        keysInfo << "KEY: " << key << ',' << value;
+        cursor = page.back().first;
     }
 
     return {std::move(keysInfo), counter};
 }
 
 pair<string, uint64_t> LevelDB::getLatestCreatedKey() {
-    leveldb::Iterator *it = db->NewIterator(readOptions);
-
-    int64_t latest_timestamp = 0;
-    string latest_created_key_name = "";
-    for (it->SeekToFirst(); it->Valid(); it->Next()) {
-        if (it->value().ToString()[0] == '{') {
-            // new style keys
-            Json::Value key_data;
-            Json::Reader reader;
-            reader.parse(it->value().ToString().c_str(), key_data);
-
-            if (std::stoi(key_data["timestamp"].asString()) > latest_timestamp) {
-                latest_timestamp = std::stoi(key_data["timestamp"].asString());
-                latest_created_key_name = it->key().ToString();
+    // index keys are ordered by zero padded timestamp, so the latest one is the last in the namespace
+    string indexEnd = CREATION_TIME_INDEX_PREFIX;
+    indexEnd.back()++;
+
+    string lastKey;
+
+    if (!store->findLast(indexEnd, lastKey) || lastKey.rfind(CREATION_TIME_INDEX_PREFIX, 0) != 0) {
+        return {"", 0};
+    }
+
+    auto indexKey = lastKey.substr(strlen(CREATION_TIME_INDEX_PREFIX));
+    auto separator = indexKey.find(':');
+    CHECK_STATE(separator != string::npos);
+
+    return {indexKey.substr(separator + 1), std::stoull(indexKey.substr(0, separator))};
+}
+
+vector<string> LevelDB::getKeysCreatedBefore(uint64_t _timestamp, const vector<string> &_prefixes, uint64_t _limit) {
+    vector<string> names;
+
+    if (_limit == 0) {
+        return names;
+    }
+
+    store->scan(CREATION_TIME_INDEX_PREFIX, [&](string_view _key, string_view) {
+        if (_key.rfind(CREATION_TIME_INDEX_PREFIX, 0) != 0) {
+            return false;
+        }
+
+        auto indexKey = string(_key.substr(strlen(CREATION_TIME_INDEX_PREFIX)));
+        auto separator = indexKey.find(':');
+        CHECK_STATE(separator != string::npos);
+
+        if (std::stoull(indexKey.substr(0, separator)) >= _timestamp) {
+            return false;
+        }
+
+        auto name = indexKey.substr(separator + 1);
+        for (auto &&prefix: _prefixes) {
+            if (name.rfind(prefix, 0) == 0) {
+                names.push_back(name);
+                break;
             }
-        } else {
-            // old style keys
-            // assuming server has at least one new-style key created
-            continue;
         }
+
+        return names.size() < _limit;
+    });
+
+    return names;
+}
+
+string LevelDB::creationTimeCursor(uint64_t _timestamp) {
+    auto timestamp = to_string(_timestamp);
+    if (timestamp.size() < CREATION_TIME_INDEX_TIMESTAMP_LEN) {
+        timestamp = string(CREATION_TIME_INDEX_TIMESTAMP_LEN - timestamp.size(), '0') + timestamp;
+    }
+    return CREATION_TIME_INDEX_PREFIX + timestamp;
+}
+
+vector<pair<string, string>> LevelDB::getKeysCreatedSince(const string &_cursor, uint64_t _limit,
+                                                          string &_nextCursor) {
+    vector<pair<string, string>> page;
+    _nextCursor.clear();
+
+    string cursor = _cursor.rfind(CREATION_TIME_INDEX_PREFIX, 0) == 0 ? _cursor : "";
+    string indexKey;
+
+    // the values are read after each scan, since a visitor must not call the store. A key that
+    // is deleted in between is skipped and the scan goes on from there
+    while (page.size() < _limit) {
+        vector<string> indexKeys;
+        uint64_t needed = _limit - page.size();
+
+        store->scan(cursor.empty() ? CREATION_TIME_INDEX_PREFIX : cursor, [&](string_view _key, string_view) {
+            if (_key.rfind(CREATION_TIME_INDEX_PREFIX, 0) != 0) {
+                return false;
+            }
+            if (_key != cursor) {
+                indexKeys.emplace_back(_key);
+            }
+            return indexKeys.size() < needed;
+        });
+
+        for (auto &&key: indexKeys) {
+            auto separator = key.find(':', strlen(CREATION_TIME_INDEX_PREFIX));
+            CHECK_STATE(separator != string::npos);
+
+            auto name = key.substr(separator + 1);
+
+            string value;
+            if (store->get(name, value)) {
+                page.push_back({name, value});
+            }
+            indexKey = key;
+        }
+
+        if (indexKeys.size() < needed) {
+            break;
+        }
+
+        cursor = indexKey;
+    }
+
+    if (page.size() == _limit) {
+        _nextCursor = indexKey;
     }
 
-    return {latest_created_key_name, latest_timestamp};
+    return page;
 }
 
+uint64_t LevelDB::getApproximateSize() {
+    return store->getApproximateSize();
+}
+
+void LevelDB::compact() {
+    store->compact();
+}
 
-LevelDB::LevelDB(string &filename) {
-    leveldb::Options options;
-    options.create_if_missing = true;
+void LevelDB::buildCreationTimeIndex() {
+    string version;
 
-    if (!leveldb::DB::Open(options, filename, (leveldb::DB **) &db).ok()) {
-        throw std::runtime_error("Unable to open levelDB database");
+    if (store->get(INDEX_VERSION_KEY, version)) {
+        return;
     }
 
-    if (db == nullptr) {
-        throw std::runtime_error("Null levelDB object");
+    spdlog::info("Building creation time index ...");
+
+    KeyValueStore::Batch batch;
+    uint64_t counter = 0;
+
+    store->scan("", [&](string_view _key, string_view _value) {
+        if (isIndexKey(_key)) {
+            return true;
+        }
+        auto indexKey = creationTimeIndexKey(string(_key), string(_value));
+        if (!indexKey.empty()) {
+            batch.put(indexKey, "");
+            counter++;
+        }
+        return true;
+    });
+
+    batch.put(INDEX_VERSION_KEY, "1");
+
+    store->write(batch);
+
+    spdlog::info("Indexed {} keys", counter);
+}
+
+void LevelDB::migrateToBinaryValues() {
+    string version;
+
+    if (store->get(VALUE_FORMAT_VERSION_KEY, version)) {
+        return;
+    }
+
+    spdlog::info("Converting hex values to binary ...");
+
+    uint64_t counter = 0;
+    string cursor;
+
+    // one page per batch, the batch is written after the scan of its page
+    while (true) {
+        KeyValueStore::Batch batch;
+        uint64_t scanned = 0;
+
+        store->scan(cursor, [&](string_view _key, string_view _value) {
+            if (_key == cursor && !cursor.empty()) {
+                return true;
+            }
+
+            scanned++;
+            cursor = string(_key);
+
+            if (!isIndexKey(_key) && _value.rfind('{', 0) == 0) {
+                string timestamp;
+                auto value = decodeValue(string(_value), &timestamp);
+
+                if (isLowerCaseHex(value) && !timestamp.empty()) {
+                    // the timestamp is kept, so the creation time index entry stays valid
+                    batch.put(cursor, encodeValue(value, std::stoull(timestamp)));
+                    counter++;
+                }
+            }
+
+            return scanned < LEVELDB_KEYS_PAGE_SIZE;
+        });
+
+        if (!batch.empty()) {
+            store->write(batch);
+        }
+
+        if (scanned < LEVELDB_KEYS_PAGE_SIZE) {
+            break;
+        }
     }
+
+    KeyValueStore::Batch batch;
+    batch.put(VALUE_FORMAT_VERSION_KEY, to_string(LEVELDB_BINARY_VALUE_VERSION));
+
+    store->write(batch);
+
+    spdlog::info("Converted {} values", counter);
+}
+
+unique_ptr<KeyValueStore> LevelDB::openMappedStore(const string &_fileName) {
+    auto mappedName = _fileName + ".mapped";
+
+    struct stat info;
+    if (stat(mappedName.c_str(), &info) == 0) {
+        return make_unique<MappedStore>(mappedName);
+    }
+
+    // the copy only replaces the mapped file once it is complete
+    auto tmpName = mappedName + ".tmp";
+    unlink(tmpName.c_str());
+
+    if (stat(_fileName.c_str(), &info) == 0) {
+        spdlog::info("Copying {} into {} ...", _fileName, mappedName);
+
+        LevelDBStore source(_fileName, blockCacheSizeMB, bloomFilterBitsPerKey, writeBufferSizeMB);
+        MappedStore target(tmpName);
+        KeyValueStore::Batch batch;
+        uint64_t counter = 0;
+
+        source.scan("", [&](string_view _key, string_view _value) {
+            batch.put(string(_key), string(_value));
+            if (++counter % LEVELDB_KEYS_PAGE_SIZE == 0) {
+                target.write(batch);
+                batch.clear();
+            }
+            return true;
+        });
+
+        target.write(batch);
+
+        spdlog::info("Copied {} entries", counter);
+    } else {
+        MappedStore target(tmpName);
+    }
+
+    if (rename(tmpName.c_str(), mappedName.c_str()) != 0) {
+        throw SGXException(COULD_NOT_ACCESS_DATABASE, "Could not create " + mappedName);
+    }
+
+    return make_unique<MappedStore>(mappedName);
+}
+
+unique_ptr<KeyValueStore> LevelDB::openStore(const string &_fileName, uint64_t _blockCacheSizeMB) {
+    if (storageEngine == "mapped") {
+        return openMappedStore(_fileName);
+    }
+
+    return make_unique<LevelDBStore>(_fileName, _blockCacheSizeMB, bloomFilterBitsPerKey, writeBufferSizeMB);
+}
+
+LevelDB::LevelDB(string &filename, bool _separateDKGStore) :
+        cache(LEVELDB_CACHE_MAX_ENTRIES, LEVELDB_CACHE_MAX_BYTES, Numa::getNumNodes()), separateDKGStore(_separateDKGStore) {
+    if (separateDKGStore) {
+        auto partitioned = make_unique<PartitionedStore>(openStore(filename, blockCacheSizeMB),
+                                                         openStore(filename + DKG_STORE_SUFFIX,
+                                                                   LEVELDB_DKG_STORE_BLOCK_CACHE_MB),
+                                                         isDKGStoreKey);
+        auto moved = partitioned->moveColdKeys();
+        if (moved > 0) {
+            spdlog::info("Moved {} DKG entries into {}{}", moved, filename, DKG_STORE_SUFFIX);
+        }
+        store = move(partitioned);
+    } else {
+        store = openStore(filename, blockCacheSizeMB);
+    }
+
+    groupCommit = make_unique<GroupCommit>(*store);
+
+    buildCreationTimeIndex();
+
+    migrateToBinaryValues();
 }
 
 LevelDB::~LevelDB() {
@@ -261,6 +902,42 @@ string LevelDB::sgx_data_folder;
 
 bool LevelDB::isInited = false;
 
+uint64_t LevelDB::blockCacheSizeMB = LEVELDB_DEFAULT_BLOCK_CACHE_MB;
+
+uint32_t LevelDB::bloomFilterBitsPerKey = LEVELDB_DEFAULT_BLOOM_BITS_PER_KEY;
+
+uint64_t LevelDB::writeBufferSizeMB = LEVELDB_DEFAULT_WRITE_BUFFER_MB;
+
+string LevelDB::storageEngine = "leveldb";
+
+void LevelDB::setStorageEngine(const string &_engine) {
+    CHECK_STATE(!isInited)
+
+    if (_engine != "leveldb" && _engine != "mapped") {
+        throw SGXException(INVALID_STORAGE_ENGINE, "Invalid storage engine " + _engine + ", use leveldb or mapped");
+    }
+
+    storageEngine = _engine;
+}
+
+void LevelDB::setOptionsConfig(uint64_t _blockCacheSizeMB, uint32_t _bloomFilterBitsPerKey,
+                               uint64_t _writeBufferSizeMB) {
+    CHECK_STATE(!isInited)
+
+    if (_blockCacheSizeMB > MAX_LEVELDB_BLOCK_CACHE_MB || _bloomFilterBitsPerKey > MAX_LEVELDB_BLOOM_BITS_PER_KEY ||
+        _writeBufferSizeMB == 0 || _writeBufferSizeMB > MAX_LEVELDB_WRITE_BUFFER_MB) {
+        throw SGXException(INVALID_LEVELDB_OPTIONS,
+                           "Invalid LevelDB options: block cache should not exceed " +
+                           to_string(MAX_LEVELDB_BLOCK_CACHE_MB) + " MB, bloom filter " +
+                           to_string(MAX_LEVELDB_BLOOM_BITS_PER_KEY) + " bits per key, write buffer should be 1 to " +
+                           to_string(MAX_LEVELDB_WRITE_BUFFER_MB) + " MB");
+    }
+
+    blockCacheSizeMB = _blockCacheSizeMB;
+    bloomFilterBitsPerKey = _bloomFilterBitsPerKey;
+    writeBufferSizeMB = _writeBufferSizeMB;
+}
+
 void LevelDB::initDataFolderAndDBs() {
     CHECK_STATE(!isInited)
     isInited = true;
@@ -292,7 +969,7 @@ void LevelDB::initDataFolderAndDBs() {
     spdlog::info("Opening wallet databases");
 
     auto dbName = sgx_data_folder +  WALLETDB_NAME;
-    levelDb = make_shared<LevelDB>(dbName);
+    levelDb = make_shared<LevelDB>(dbName, true);
 
     auto csr_dbname = sgx_data_folder + "CSR_DB";
     csrDb = make_shared<LevelDB>(csr_dbname);
@@ -29,35 +29,106 @@
 #include <sstream>
 #include <string>
 #include <mutex>
+#include <tuple>
 #include <vector>
+#include <string_view>
 #include "common.h"
+#include "KeyValueStore.h"
+#include "GroupCommit.h"
+#include "LevelDBCache.h"
+
+// A key database on top of a KeyValueStore, LevelDBStore by default or MappedStore with
+// sgxwallet -D mapped. Stores support concurrent reads, so reads do not take any lock.
+// Writes are serialized by writeMutex so that the check in writeDataUnique
+// can not race with another write of the same key. A write returns once it is durable,
+// concurrent writes share one sync, see GroupCommit.h.
+// Every new style value also has an empty entry under CREATION_TIME_INDEX_PREFIX,
+// written in the same batch, so the latest created key is found with one seek.
+// New style values are stored as JSON with the value and its creation timestamp, or, when the
+// value is lower case hex like encrypted keys, as LEVELDB_BINARY_VALUE_VERSION, the timestamp
+// and the decoded bytes. Readers get the same string back in both cases.
+class LevelDB {
 
-namespace leveldb {
-    class DB;
-    class Status;
-    class Slice;
-}
+    mutex writeMutex;
 
-class LevelDB {
+    unique_ptr<KeyValueStore> store;
+
+    // declared after store, so that it is destroyed before it
+    unique_ptr<GroupCommit> groupCommit;
 
-    recursive_mutex mutex;
+    LevelDBCache cache;
 
-    shared_ptr<leveldb::DB> db;
+    // DKG intermediates are kept in a store of their own, see isDKGStoreKey
+    const bool separateDKGStore;
 
     static bool isInited;
 
+    static uint64_t blockCacheSizeMB;
+
+    static uint32_t bloomFilterBitsPerKey;
+
+    static uint64_t writeBufferSizeMB;
+
+    static string storageEngine;
+
     static shared_ptr<LevelDB> levelDb;
 
     static shared_ptr<LevelDB> csrDb;
 
     static shared_ptr<LevelDB> csrStatusDb;
 
+    static string creationTimeIndexKey(const string &_key, const string &_rawValue);
+
+    static bool isIndexKey(string_view _key);
+
+    static bool isDKGStoreKey(string_view _key);
+
+    static string formatKeyInfo(const string &_key, const string &_rawValue);
+
+    static string encodeValue(const string &_value, uint64_t _timestamp);
+
+    // a zero _timestamp is the current time
+    void batchPut(KeyValueStore::Batch &_batch, const string &_key, const string &_value, uint64_t _timestamp = 0);
+
+    void batchDelete(KeyValueStore::Batch &_batch, const string &_key);
+
+    void batchDeleteIndexEntry(KeyValueStore::Batch &_batch, const string &_key);
+
+    // writes the batch, then releases _lock and waits until the batch is durable
+    void commitBatch(KeyValueStore::Batch &_batch, const vector<string> &_keys, unique_lock<mutex> &_lock);
+
+    static unique_ptr<KeyValueStore> openStore(const string &_fileName, uint64_t _blockCacheSizeMB);
+
+    // the MappedStore of _fileName, copied from the LevelDB database of the same name on first use
+    static unique_ptr<KeyValueStore> openMappedStore(const string &_fileName);
+
+    void buildCreationTimeIndex();
+
+    // rewrites hex JSON values of older versions in the binary format, once per database
+    void migrateToBinaryValues();
+
     static string sgx_data_folder;
 
 public:
 
     static void initDataFolderAndDBs();
 
+    // has to be called before initDataFolderAndDBs, applies to each database,
+    // zero bloom filter bits disable the filter
+    static void setOptionsConfig(uint64_t _blockCacheSizeMB, uint32_t _bloomFilterBitsPerKey,
+                                 uint64_t _writeBufferSizeMB);
+
+    static uint64_t getBlockCacheSizeMB() { return blockCacheSizeMB; }
+
+    static uint32_t getBloomFilterBitsPerKey() { return bloomFilterBitsPerKey; }
+
+    static uint64_t getWriteBufferSizeMB() { return writeBufferSizeMB; }
+
+    // "leveldb" or "mapped", has to be called before initDataFolderAndDBs
+    static void setStorageEngine(const string &_engine);
+
+    static const string &getStorageEngine() { return storageEngine; }
+
     static const shared_ptr<LevelDB> &getLevelDb();
 
     static const shared_ptr<LevelDB> &getCsrDb();
@@ -68,27 +139,77 @@ public:
 
     shared_ptr<string> readString(const string& _key);
 
+    // raw values of _keys read from one snapshot of the database, null for missing keys
+    vector<shared_ptr<string>> readRawStrings(const vector<string> &_keys);
+
     shared_ptr<string> readNewStyleValue(const string& value);
 
+    // the value of a raw database value in any format. _timestamp is set to the creation time,
+    // or to an empty string for old style values
+    static string decodeValue(const string &_rawValue, string *_timestamp = nullptr);
+
     pair<stringstream, uint64_t> getAllKeys();
 
     pair<string, uint64_t> getLatestCreatedKey();
 
+    // Up to _limit (key, raw value) pairs with _prefix, in key order, strictly after _cursor
+    vector<pair<string, string>> getKeysPage(const string &_prefix, const string &_cursor, uint64_t _limit);
+
+    // Up to _limit names starting with one of _prefixes and created before _timestamp, oldest first
+    vector<string> getKeysCreatedBefore(uint64_t _timestamp, const vector<string> &_prefixes, uint64_t _limit);
+
+    // Up to _limit (key, raw value) pairs in creation time order, strictly after _cursor, which is
+    // a creation time index key of an earlier page or a creationTimeCursor. Values of older
+    // versions have no creation time and are not returned. _nextCursor is set to the index key of
+    // the last pair if the page is full, and to an empty string otherwise
+    vector<pair<string, string>> getKeysCreatedSince(const string &_cursor, uint64_t _limit, string &_nextCursor);
+
+    // cursor for getKeysCreatedSince that starts at the keys created at _timestamp
+    static string creationTimeCursor(uint64_t _timestamp);
+
+    uint64_t getApproximateSize();
+
+    void compact();
+
     void writeString(const string &key1, const string &value1);
 
     void writeDataUnique(const string & Name, const string &value);
 
+    // Applies all puts and deletes as one atomic batch.
+    // Throws KEY_NAME_ALREADY_EXISTS, and writes nothing, if any put key exists.
+    void writeBatchUnique(const vector<pair<string, string>> &_keyValues, const vector<string> &_keysToDelete = {});
+
+    // writes every group of puts whose keys neither exist nor are used by an earlier group, all
+    // groups in one batch. Returns which groups were written
+    vector<bool> writeGroupsUnique(const vector<vector<pair<string, string>>> &_groups);
+
+    // writes (key, value, creation time) entries as one batch, keeping their creation times. Entries with
+    // the same value already in the database are skipped. Returns the number of written entries
+    uint64_t importValues(const vector<tuple<string, string, string>> &_entries);
+
+    // writes (key, expected value, new value, creation time) entries as one batch, keeping their
+    // creation times. Entries whose key no longer holds the expected value are skipped, so a deleted
+    // or replaced key is never written back. Returns the number of written entries
+    uint64_t replaceValues(const vector<tuple<string, string, string, string>> &_entries);
+
+    void deleteKeys(const vector<string> &_keys);
+
+    // deletes all keys that start with one of _prefixes in one batch, then compacts the ranges of
+    // the prefixes, so later scans do not step over their tombstones. Returns the deleted keys
+    vector<string> deleteKeysWithPrefixes(const vector<string> &_prefixes);
+
     void deleteDHDKGKey (const string &_key);
 
     void deleteTempNEK (const string &_key);
 
     void deleteKey(const string &_key);
 
-public:
+    const LevelDBCache &getCache() const;
 
-    void throwExceptionOnError(leveldb::Status result);
+public:
 
-    LevelDB(string& filename);
+    // with _separateDKGStore, DKG intermediates are moved into <filename>_DKG
+    LevelDB(string& filename, bool _separateDKGStore = false);
 
     class KeyVisitor {
     public:
@@ -0,0 +1,231 @@
+/*
+    Copyright (C) 2021-Present SKALE Labs
+
+    This file is part of sgxwallet.
+
+    sgxwallet is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as published
+    by the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    sgxwallet is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with sgxwallet. If not, see <https://www.gnu.org/licenses/>.
+
+    @file LevelDBCache.cpp
+    @author Stan Kladko
+    @date 2021
+*/
+
+#include <unordered_set>
+
+#include "common.h"
+#include "Numa.h"
+
+#include "LevelDBCache.h"
+
+LevelDBCache::LevelDBCache(uint64_t _maxEntries, uint64_t _maxBytes, uint64_t _numReplicas) {
+    CHECK_STATE(_numReplicas > 0);
+    CHECK_STATE(_maxEntries >= NUM_SHARDS * _numReplicas);
+    CHECK_STATE(_maxBytes >= NUM_SHARDS * _numReplicas);
+    maxShardEntries = _maxEntries / NUM_SHARDS / _numReplicas;
+    maxShardBytes = _maxBytes / NUM_SHARDS / _numReplicas;
+
+    for (uint64_t i = 0; i < _numReplicas; i++) {
+        replicas.push_back(make_unique<Replica>());
+    }
+}
+
+LevelDBCache::Replica &LevelDBCache::getReplica() {
+    return *replicas[Numa::getCurrentNode() % replicas.size()];
+}
+
+LevelDBCache::Shard &LevelDBCache::getShard(Replica &_replica, const string &_key) {
+    return _replica.shards[hash<string>()(_key) % NUM_SHARDS];
+}
+
+uint64_t LevelDBCache::sumCounters(atomic<uint64_t> Replica::*_counter) const {
+    uint64_t result = 0;
+    for (auto &&replica : replicas) {
+        result += ((*replica).*_counter).load();
+    }
+    return result;
+}
+
+uint64_t LevelDBCache::getHits() const {
+    return sumCounters(&Replica::hits);
+}
+
+uint64_t LevelDBCache::getMisses() const {
+    return sumCounters(&Replica::misses);
+}
+
+uint64_t LevelDBCache::getEvictions() const {
+    return sumCounters(&Replica::evictions);
+}
+
+uint64_t LevelDBCache::getAdmissionRejects() const {
+    return sumCounters(&Replica::admissionRejects);
+}
+
+void LevelDBCache::eraseItem(Shard &_shard, list<Item>::iterator _it) {
+    _shard.bytes -= _it->first.size() + _it->second->size();
+    _shard.items.erase(_it->first);
+    _shard.lru.erase(_it);
+}
+
+shared_ptr<string> LevelDBCache::get(const string &_key) {
+    auto &replica = getReplica();
+    auto &shard = getShard(replica, _key);
+    shared_ptr<const string> value;
+
+    {
+        lock_guard<mutex> lock(shard.m);
+        shard.frequencies.increment(hash<string>()(_key));
+        auto it = shard.items.find(_key);
+        if (it != shard.items.end()) {
+            shard.lru.splice(shard.lru.begin(), shard.lru, it->second);
+            value = it->second->second;
+        }
+    }
+
+    if (!value) {
+        replica.misses++;
+        return nullptr;
+    }
+
+    replica.hits++;
+    // callers own the returned string, so the cached value is never exposed for modification
+    return make_shared<string>(*value);
+}
+
+uint64_t LevelDBCache::getGeneration(const string &_key) {
+    auto &shard = getShard(getReplica(), _key);
+    lock_guard<mutex> lock(shard.m);
+    return shard.generation;
+}
+
+void LevelDBCache::put(const string &_key, const string &_value, uint64_t _generation) {
+    uint64_t itemBytes = _key.size() + _value.size();
+
+    auto &replica = getReplica();
+    auto &shard = getShard(replica, _key);
+
+    if (itemBytes > maxShardBytes)
+        return;
+
+    lock_guard<mutex> lock(shard.m);
+
+    // the key may have been written or deleted while the value was read from the database
+    if (shard.generation != _generation)
+        return;
+
+    auto it = shard.items.find(_key);
+    if (it != shard.items.end()) {
+        eraseItem(shard, it->second);
+    } else if (shard.items.size() >= maxShardEntries &&
+               !shard.frequencies.admit(hash<string>()(_key), hash<string>()(shard.lru.back().first))) {
+        replica.admissionRejects++;
+        return;
+    }
+
+    shard.lru.emplace_front(_key, make_shared<const string>(_value));
+    shard.items[_key] = shard.lru.begin();
+    shard.bytes += itemBytes;
+
+    while (shard.items.size() > maxShardEntries || shard.bytes > maxShardBytes) {
+        eraseItem(shard, prev(shard.lru.end()));
+        replica.evictions++;
+    }
+}
+
+void LevelDBCache::invalidate(const string &_key) {
+    for (auto &&replica : replicas) {
+        auto &shard = getShard(*replica, _key);
+        lock_guard<mutex> lock(shard.m);
+
+        shard.generation++;
+
+        auto it = shard.items.find(_key);
+        if (it != shard.items.end()) {
+            eraseItem(shard, it->second);
+        }
+    }
+}
+
+void LevelDBCache::trim(uint64_t _maxBytes) {
+    auto maxBytes = _maxBytes / NUM_SHARDS / replicas.size();
+    for (auto &&replica : replicas) {
+        for (auto &&shard : replica->shards) {
+            lock_guard<mutex> lock(shard.m);
+            while (shard.bytes > maxBytes && !shard.lru.empty()) {
+                eraseItem(shard, prev(shard.lru.end()));
+                replica->evictions++;
+            }
+        }
+    }
+}
+
+uint64_t LevelDBCache::size() const {
+    uint64_t result = 0;
+    for (auto &&replica : replicas) {
+        for (auto &&shard : replica->shards) {
+            lock_guard<mutex> lock(shard.m);
+            result += shard.items.size();
+        }
+    }
+    return result;
+}
+
+uint64_t LevelDBCache::sizeInBytes() const {
+    uint64_t result = 0;
+    for (auto &&replica : replicas) {
+        for (auto &&shard : replica->shards) {
+            lock_guard<mutex> lock(shard.m);
+            result += shard.bytes;
+        }
+    }
+    return result;
+}
+
+vector<string> LevelDBCache::getKeys(uint64_t _max) const {
+    vector<const Shard *> shards;
+    for (auto &&replica : replicas) {
+        for (auto &&shard : replica->shards) {
+            shards.push_back(&shard);
+        }
+    }
+
+    vector<vector<string>> shardKeys(shards.size());
+
+    for (uint64_t i = 0; i < shards.size(); i++) {
+        lock_guard<mutex> lock(shards[i]->m);
+        for (auto it = shards[i]->lru.begin(); it != shards[i]->lru.end() && shardKeys[i].size() < _max; it++) {
+            shardKeys[i].push_back(it->first);
+        }
+    }
+
+    // a key cached by several nodes is taken once
+    unordered_set<string> taken;
+    vector<string> keys;
+    for (uint64_t rank = 0; keys.size() < _max; rank++) {
+        bool found = false;
+        for (uint64_t i = 0; i < shards.size() && keys.size() < _max; i++) {
+            if (rank < shardKeys[i].size()) {
+                if (taken.insert(shardKeys[i][rank]).second) {
+                    keys.push_back(shardKeys[i][rank]);
+                }
+                found = true;
+            }
+        }
+        if (!found) {
+            break;
+        }
+    }
+
+    return keys;
+}
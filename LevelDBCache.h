@@ -0,0 +1,125 @@
+/*
+    Copyright (C) 2021-Present SKALE Labs
+
+    This file is part of sgxwallet.
+
+    sgxwallet is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as published
+    by the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    sgxwallet is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with sgxwallet. If not, see <https://www.gnu.org/licenses/>.
+
+    @file LevelDBCache.h
+    @author Stan Kladko
+    @date 2021
+*/
+
+#ifndef SGXWALLET_LEVELDBCACHE_H
+#define SGXWALLET_LEVELDBCACHE_H
+
+#include <array>
+#include <atomic>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "sgxwallet_common.h"
+#include "FrequencySketch.h"
+
+using namespace std;
+
+// Read-through LRU cache of decoded LevelDB values. Bounded both by the number of
+// entries and by the total size of cached values. A shard that is full of entries admits
+// a new value only if its key was read more often than the least recently used one, see
+// FrequencySketch.h. Every write or delete of a key
+// has to call invalidate. A read that raced with an invalidation of its key is not
+// cached, see getGeneration. In NUMA mode the cache is split into a replica per node, see Numa.h.
+// Threads read and fill the replica of their node, and invalidate clears a key in all of them.
+class LevelDBCache {
+
+public:
+
+    static constexpr uint64_t NUM_SHARDS = 16;
+
+    // the limits are shared by the _numReplicas replicas
+    LevelDBCache(uint64_t _maxEntries, uint64_t _maxBytes, uint64_t _numReplicas = 1);
+
+    // returns nullptr on a miss
+    shared_ptr<string> get(const string &_key);
+
+    // must be read before going to the database, and passed back to put
+    uint64_t getGeneration(const string &_key);
+
+    void put(const string &_key, const string &_value, uint64_t _generation);
+
+    void invalidate(const string &_key);
+
+    // evicts least recently used values until the cache holds at most _maxBytes
+    void trim(uint64_t _maxBytes);
+
+    uint64_t getHits() const;
+
+    uint64_t getMisses() const;
+
+    uint64_t getEvictions() const;
+
+    // values not cached because the shard was full of more frequently read keys
+    uint64_t getAdmissionRejects() const;
+
+    uint64_t size() const;
+
+    uint64_t sizeInBytes() const;
+
+    // up to _max cached keys, taking the most recently used key of each shard in turn
+    vector<string> getKeys(uint64_t _max) const;
+
+private:
+
+    typedef pair<string, shared_ptr<const string>> Item;
+
+    struct Shard {
+        mutable mutex m;
+        list<Item> lru;
+        unordered_map<string, list<Item>::iterator> items;
+        uint64_t bytes = 0;
+        uint64_t generation = 0;
+        FrequencySketch<LEVELDB_CACHE_MAX_ENTRIES / NUM_SHARDS> frequencies;
+    };
+
+    uint64_t maxShardEntries;
+
+    uint64_t maxShardBytes;
+
+    // the counters of a replica are only written by the threads of its node
+    struct Replica {
+        array<Shard, NUM_SHARDS> shards;
+        alignas(64) atomic<uint64_t> hits{0};
+        atomic<uint64_t> misses{0};
+        atomic<uint64_t> evictions{0};
+        atomic<uint64_t> admissionRejects{0};
+    };
+
+    vector<unique_ptr<Replica>> replicas;
+
+    // the replica of the node of the calling thread
+    Replica &getReplica();
+
+    static Shard &getShard(Replica &_replica, const string &_key);
+
+    uint64_t sumCounters(atomic<uint64_t> Replica::*_counter) const;
+
+    // must be called with the shard lock held
+    void eraseItem(Shard &_shard, list<Item>::iterator _it);
+};
+
+#endif //SGXWALLET_LEVELDBCACHE_H
@@ -0,0 +1,188 @@
+/*
+    Copyright (C) 2021-Present SKALE Labs
+
+    This file is part of sgxwallet.
+
+    sgxwallet is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as published
+    by the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    sgxwallet is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with sgxwallet. If not, see <https://www.gnu.org/licenses/>.
+
+    @file LevelDBStore.cpp
+    @author Stan Kladko
+    @date 2021
+*/
+
+
+#include "leveldb/db.h"
+#include "leveldb/write_batch.h"
+#include "leveldb/cache.h"
+#include "leveldb/filter_policy.h"
+
+#include "sgxwallet_common.h"
+#include "SGXException.h"
+#include "common.h"
+
+#include "LevelDBStore.h"
+
+static leveldb::WriteOptions writeOptions;
+
+static leveldb::WriteOptions makeSyncOptions() {
+    leveldb::WriteOptions options;
+    options.sync = true;
+    return options;
+}
+
+static const leveldb::WriteOptions syncOptions = makeSyncOptions();
+static leveldb::ReadOptions readOptions;
+
+static string_view toView(const leveldb::Slice &_slice) {
+    return string_view(_slice.data(), _slice.size());
+}
+
+void LevelDBStore::throwExceptionOnError(const leveldb::Status &_status) {
+    if (_status.IsNotFound())
+        return;
+
+    if (!_status.ok()) {
+        throw SGXException(COULD_NOT_ACCESS_DATABASE, ("Could not access database database:" + _status.ToString()).c_str());
+    }
+}
+
+LevelDBStore::LevelDBStore(const string &_fileName, uint64_t _blockCacheSizeMB, uint32_t _bloomFilterBitsPerKey,
+                           uint64_t _writeBufferSizeMB) {
+    leveldb::Options options;
+    options.create_if_missing = true;
+
+    blockCache.reset(leveldb::NewLRUCache(_blockCacheSizeMB * 1024 * 1024));
+    options.block_cache = blockCache.get();
+
+    if (_bloomFilterBitsPerKey > 0) {
+        filterPolicy.reset(leveldb::NewBloomFilterPolicy(_bloomFilterBitsPerKey));
+        options.filter_policy = filterPolicy.get();
+    }
+
+    options.write_buffer_size = _writeBufferSizeMB * 1024 * 1024;
+
+    leveldb::DB *result = nullptr;
+
+    if (!leveldb::DB::Open(options, _fileName, &result).ok()) {
+        throw std::runtime_error("Unable to open levelDB database");
+    }
+
+    if (result == nullptr) {
+        throw std::runtime_error("Null levelDB object");
+    }
+
+    db.reset(result);
+}
+
+LevelDBStore::~LevelDBStore() {
+}
+
+bool LevelDBStore::get(const string &_key, string &_value) {
+    auto status = db->Get(readOptions, _key, &_value);
+    throwExceptionOnError(status);
+    return status.ok();
+}
+
+vector<shared_ptr<string>> LevelDBStore::getMany(const vector<string> &_keys) {
+    vector<shared_ptr<string>> values(_keys.size());
+
+    leveldb::ReadOptions options;
+    options.snapshot = db->GetSnapshot();
+
+    try {
+        for (uint64_t i = 0; i < _keys.size(); i++) {
+            auto value = make_shared<string>();
+            auto status = db->Get(options, _keys[i], value.get());
+            throwExceptionOnError(status);
+            if (status.ok()) {
+                values[i] = value;
+            }
+        }
+    } catch (...) {
+        db->ReleaseSnapshot(options.snapshot);
+        throw;
+    }
+
+    db->ReleaseSnapshot(options.snapshot);
+    return values;
+}
+
+void LevelDBStore::write(const Batch &_batch) {
+    leveldb::WriteBatch batch;
+
+    for (auto &&op: _batch.getOps()) {
+        if (op.isDelete) {
+            batch.Delete(leveldb::Slice(op.key));
+        } else {
+            batch.Put(leveldb::Slice(op.key), leveldb::Slice(op.value));
+        }
+    }
+
+    throwExceptionOnError(db->Write(writeOptions, &batch));
+}
+
+void LevelDBStore::sync() {
+    // a synced write also syncs the log records of all earlier writes
+    leveldb::WriteBatch empty;
+    throwExceptionOnError(db->Write(syncOptions, &empty));
+}
+
+void LevelDBStore::scan(const string &_from, const Visitor &_visitor) {
+    unique_ptr<leveldb::Iterator> it(db->NewIterator(readOptions));
+
+    for (it->Seek(_from); it->Valid(); it->Next()) {
+        if (!_visitor(toView(it->key()), toView(it->value()))) {
+            break;
+        }
+    }
+
+    throwExceptionOnError(it->status());
+}
+
+bool LevelDBStore::findLast(const string &_before, string &_key) {
+    unique_ptr<leveldb::Iterator> it(db->NewIterator(readOptions));
+
+    it->Seek(_before);
+    if (it->Valid()) {
+        it->Prev();
+    } else {
+        it->SeekToLast();
+    }
+
+    throwExceptionOnError(it->status());
+
+    if (!it->Valid()) {
+        return false;
+    }
+
+    _key = it->key().ToString();
+    return true;
+}
+
+uint64_t LevelDBStore::getApproximateSize() {
+    leveldb::Range range("", "\xff");
+    uint64_t size = 0;
+    db->GetApproximateSizes(&range, 1, &size);
+    return size;
+}
+
+void LevelDBStore::compact() {
+    db->CompactRange(nullptr, nullptr);
+}
+
+void LevelDBStore::compactRange(const string &_begin, const string &_end) {
+    leveldb::Slice begin(_begin);
+    leveldb::Slice end(_end);
+    db->CompactRange(&begin, &end);
+}
@@ -0,0 +1,77 @@
+/*
+    Copyright (C) 2021-Present SKALE Labs
+
+    This file is part of sgxwallet.
+
+    sgxwallet is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as published
+    by the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    sgxwallet is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with sgxwallet. If not, see <https://www.gnu.org/licenses/>.
+
+    @file LevelDBStore.h
+    @author Stan Kladko
+    @date 2021
+*/
+
+
+#ifndef SGXWALLET_LEVELDBSTORE_H
+#define SGXWALLET_LEVELDBSTORE_H
+
+#include <memory>
+
+#include "KeyValueStore.h"
+
+namespace leveldb {
+    class DB;
+    class Status;
+    class Cache;
+    class FilterPolicy;
+}
+
+// The default engine. leveldb::DB supports concurrent reads and writes without locking.
+class LevelDBStore : public KeyValueStore {
+
+    // declared before db, so that they are destroyed after it
+    unique_ptr<leveldb::Cache> blockCache;
+
+    unique_ptr<const leveldb::FilterPolicy> filterPolicy;
+
+    unique_ptr<leveldb::DB> db;
+
+    static void throwExceptionOnError(const leveldb::Status &_status);
+
+public:
+
+    LevelDBStore(const string &_fileName, uint64_t _blockCacheSizeMB, uint32_t _bloomFilterBitsPerKey,
+                 uint64_t _writeBufferSizeMB);
+
+    ~LevelDBStore() override;
+
+    bool get(const string &_key, string &_value) override;
+
+    vector<shared_ptr<string>> getMany(const vector<string> &_keys) override;
+
+    void write(const Batch &_batch) override;
+
+    void sync() override;
+
+    void scan(const string &_from, const Visitor &_visitor) override;
+
+    bool findLast(const string &_before, string &_key) override;
+
+    uint64_t getApproximateSize() override;
+
+    void compact() override;
+
+    void compactRange(const string &_begin, const string &_end) override;
+};
+
+#endif //SGXWALLET_LEVELDBSTORE_H
@@ -29,6 +29,23 @@
 
 using namespace std;
 
+atomic<uint64_t> Log::requestLogSampleRate(1);
+atomic<uint64_t> Log::requestLogCounter(0);
+
+void Log::setRequestLogSampleRate(uint64_t _rate) {
+    CHECK_STATE(_rate > 0);
+    requestLogSampleRate = _rate;
+}
+
+bool Log::shouldLogRequest() {
+    if (!spdlog::default_logger_raw()->should_log(spdlog::level::debug)) {
+        return false;
+    }
+
+    auto rate = requestLogSampleRate.load(memory_order_relaxed);
+    return rate == 1 || requestLogCounter.fetch_add(1, memory_order_relaxed) % rate == 0;
+}
+
 void Log::setGlobalLogLevel(string &_s) {
     globalLogLevel = logLevelFromString(_s);
 }
@@ -42,6 +42,7 @@
 
 #include <boost/core/ignore_unused.hpp>
 #include "common.h"
+#include "Metrics.h"
 
 #include <shared_mutex>
 
@@ -64,10 +65,22 @@ enum level_enum {
 
 class Log {
 
+    static atomic<uint64_t> requestLogSampleRate;
+
+    static atomic<uint64_t> requestLogCounter;
+
 public:
 
     level_enum globalLogLevel;
 
+    // in debug mode only one of every _rate ZMQ requests and replies is logged in full
+    static void setRequestLogSampleRate(uint64_t _rate);
+
+    static uint64_t getRequestLogSampleRate() { return requestLogSampleRate; }
+
+    // true if debug logging is on and the current message is sampled
+    static bool shouldLogRequest();
+
     void setGlobalLogLevel(string &_s);
 
     static level_enum logLevelFromString(string &_s);
@@ -76,21 +89,14 @@ public:
 };
 
 
+// counts the call and records its latency, memory is checked by the Metrics sampler thread
 #define COUNT_STATISTICS \
-static uint64_t __COUNT__ = 0; \
-__COUNT__++; \
-if (__COUNT__ % 1000 == 0) { \
-spdlog::info(string(__FUNCTION__) +  " processed " + to_string(__COUNT__) + " requests"); \
-struct sysinfo memInfo; \
-sysinfo (&memInfo); \
-long long totalPhysMem = memInfo.totalram; \
-/*Multiply in next statement to avoid int overflow on right hand side...*/ \
-totalPhysMem *= memInfo.mem_unit; \
-int usedByCurrentProcess = getValue(); \
-if ( 0.5 * totalPhysMem < usedByCurrentProcess ) { \
-  exit(-103); \
-} \
-}
+static auto &__METHOD_METRICS__ = Metrics::getMethod(__FUNCTION__); \
+__METHOD_METRICS__.calls.inc(); \
+MetricsTimer __METHOD_TIMER__(__METHOD_METRICS__.latency); \
+PerfScope __METHOD_PERF__(__METHOD_METRICS__.perf); \
+MethodProbe __METHOD_PROBE__(__FUNCTION__); \
+AllocationScope __METHOD_ALLOCATIONS__(__METHOD_METRICS__.allocations);
 
 
 
@@ -126,6 +132,20 @@ string(__FUNCTION__) + ": server error. Please see server log.";
       return __RESULT__; \
       }
 
+// Result of the sign and verify handlers, which are called at high rates. It allocates no error
+// buffer, and invalid requests are answered with RETURN_ERROR instead of throwing. Exceptions from
+// the enclave and database layers are still caught by HANDLE_SGX_EXCEPTION.
+#define INIT_LEAN_RESULT(__RESULT__) Json::Value __RESULT__(Json::objectValue); \
+    __RESULT__["status"] = -1 * (10000 + __LINE__);
+
+#define RETURN_ERROR(__RESULT__, __STATUS__, __MESSAGE__) { \
+    auto errStr = __FUNCTION__ + string(" failed:") + __MESSAGE__; \
+    __RESULT__["status"] = __STATUS__; \
+    __RESULT__["errorMessage"] = errStr; \
+    spdlog::error(errStr); \
+    return __RESULT__; \
+    }
+
 #define RETURN_SUCCESS(__RESULT__) \
     __RESULT__["status"] = 0; \
     __RESULT__["errorMessage"] = ""; \
@@ -0,0 +1,432 @@
+/*
+    Copyright (C) 2021-Present SKALE Labs
+
+    This file is part of sgxwallet.
+
+    sgxwallet is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as published
+    by the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    sgxwallet is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with sgxwallet. If not, see <https://www.gnu.org/licenses/>.
+
+    @file MappedStore.cpp
+    @author Stan Kladko
+    @date 2021
+*/
+
+
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <zlib.h>
+
+#include "sgxwallet_common.h"
+#include "SGXException.h"
+#include "third_party/spdlog/spdlog.h"
+#include "common.h"
+
+#include "MappedStore.h"
+
+// The file starts with FILE_MAGIC and is followed by batch records. A record is RECORD_MAGIC,
+// the crc32 of its payload and the payload length, each little endian, then the payload of ops.
+// An op is its type, the key length, the value length, the key and the value.
+static const char FILE_MAGIC[] = "SGXKVS01";
+static const uint64_t FILE_HEADER_SIZE = sizeof(FILE_MAGIC) - 1;
+static const uint32_t RECORD_MAGIC = 0x52564b53;
+static const uint64_t RECORD_HEADER_SIZE = 2 * sizeof(uint32_t) + sizeof(uint64_t);
+static const uint64_t OP_HEADER_SIZE = 1 + 2 * sizeof(uint32_t);
+static const uint8_t OP_PUT = 1;
+static const uint8_t OP_DELETE = 2;
+
+template<class T>
+static void append(string &_out, T _value) {
+    _out.append((const char *) &_value, sizeof(T));
+}
+
+template<class T>
+static T decode(const char *_data) {
+    T value;
+    memcpy(&value, _data, sizeof(T));
+    return value;
+}
+
+static uint32_t checksum(const char *_data, uint64_t _size) {
+    uLong crc = crc32(0L, Z_NULL, 0);
+    while (_size > 0) {
+        auto chunk = (uInt) min<uint64_t>(_size, 1u << 30);
+        crc = crc32(crc, (const Bytef *) _data, chunk);
+        _data += chunk;
+        _size -= chunk;
+    }
+    return (uint32_t) crc;
+}
+
+static void throwAccessError(const string &_what) {
+    throw SGXException(COULD_NOT_ACCESS_DATABASE, "Could not access database:" + _what + ":" + strerror(errno));
+}
+
+MappedStore::MappedStore(const string &_fileName) : fileName(_fileName) {
+    {
+        unique_lock<shared_mutex> lock(indexMutex);
+        open();
+    }
+
+    if (fileSize > MAPPED_STORE_COMPACT_MIN_SIZE && fileSize > 2 * liveBytes) {
+        compact();
+    }
+}
+
+MappedStore::~MappedStore() {
+    close();
+}
+
+void MappedStore::open() {
+    fd = ::open(fileName.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, S_IRUSR | S_IWUSR);
+    if (fd < 0) {
+        throwAccessError("open " + fileName);
+    }
+
+    struct stat info;
+    if (fstat(fd, &info) != 0) {
+        throwAccessError("stat " + fileName);
+    }
+
+    uint64_t end = info.st_size;
+
+    if (end == 0) {
+        writeFile(fd, string(FILE_MAGIC, FILE_HEADER_SIZE), 0);
+        end = FILE_HEADER_SIZE;
+    }
+
+    remap(end);
+
+    if (end < FILE_HEADER_SIZE || memcmp(data, FILE_MAGIC, FILE_HEADER_SIZE) != 0) {
+        throw SGXException(COULD_NOT_ACCESS_DATABASE, "Could not access database:" + fileName + " is not a mapped store");
+    }
+
+    index.clear();
+    liveBytes = 0;
+
+    uint64_t offset = FILE_HEADER_SIZE;
+    while (offset < end && loadRecord(offset, end)) {
+    }
+
+    if (offset < end) {
+        spdlog::warn("Dropping {} bytes of a torn write at the end of {}", end - offset, fileName);
+        if (ftruncate(fd, offset) != 0) {
+            throwAccessError("truncate " + fileName);
+        }
+    }
+
+    fileSize = offset;
+}
+
+void MappedStore::close() {
+    if (data) {
+        munmap((void *) data, mapSize);
+        data = nullptr;
+        mapSize = 0;
+    }
+
+    if (fd >= 0) {
+        ::close(fd);
+        fd = -1;
+    }
+}
+
+void MappedStore::remap(uint64_t _minSize) {
+    if (data && _minSize <= mapSize) {
+        return;
+    }
+
+    uint64_t size = max<uint64_t>(MAPPED_STORE_MIN_MAP_SIZE, mapSize);
+    while (size < 2 * _minSize) {
+        size *= 2;
+    }
+
+    auto mapped = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+    if (mapped == MAP_FAILED) {
+        throwAccessError("mmap " + fileName);
+    }
+
+    if (data) {
+        munmap((void *) data, mapSize);
+    }
+
+    data = (const char *) mapped;
+    mapSize = size;
+}
+
+bool MappedStore::loadRecord(uint64_t &_offset, uint64_t _end) {
+    if (_end - _offset < RECORD_HEADER_SIZE) {
+        return false;
+    }
+
+    const char *record = data + _offset;
+
+    if (decode<uint32_t>(record) != RECORD_MAGIC) {
+        return false;
+    }
+
+    auto crc = decode<uint32_t>(record + sizeof(uint32_t));
+    auto payloadSize = decode<uint64_t>(record + 2 * sizeof(uint32_t));
+
+    if (payloadSize > _end - _offset - RECORD_HEADER_SIZE) {
+        return false;
+    }
+
+    const char *payload = record + RECORD_HEADER_SIZE;
+
+    if (checksum(payload, payloadSize) != crc) {
+        return false;
+    }
+
+    vector<Update> updates;
+
+    for (uint64_t i = 0; i < payloadSize;) {
+        if (payloadSize - i < OP_HEADER_SIZE) {
+            return false;
+        }
+
+        auto type = (uint8_t) payload[i];
+        uint64_t keySize = decode<uint32_t>(payload + i + 1);
+        uint64_t valueSize = decode<uint32_t>(payload + i + 1 + sizeof(uint32_t));
+        i += OP_HEADER_SIZE;
+
+        if ((type != OP_PUT && type != OP_DELETE) || keySize + valueSize > payloadSize - i) {
+            return false;
+        }
+
+        updates.push_back({string_view(payload + i, keySize), type == OP_DELETE,
+                           {_offset + RECORD_HEADER_SIZE + i + keySize, valueSize}});
+        i += keySize + valueSize;
+    }
+
+    apply(updates);
+
+    _offset += RECORD_HEADER_SIZE + payloadSize;
+
+    return true;
+}
+
+void MappedStore::apply(const vector<Update> &_updates) {
+    for (auto &&update: _updates) {
+        auto it = index.find(update.key);
+
+        if (it != index.end()) {
+            liveBytes -= OP_HEADER_SIZE + it->first.size() + it->second.size;
+            if (update.isDelete) {
+                index.erase(it);
+            } else {
+                it->second = update.value;
+            }
+        } else if (!update.isDelete) {
+            it = index.emplace(string(update.key), update.value).first;
+        }
+
+        if (!update.isDelete) {
+            liveBytes += OP_HEADER_SIZE + it->first.size() + it->second.size;
+        }
+    }
+}
+
+string MappedStore::encodeRecord(const Batch &_batch, vector<Update> &_updates) {
+    string record;
+    append<uint32_t>(record, RECORD_MAGIC);
+    append<uint32_t>(record, 0);
+    append<uint64_t>(record, 0);
+
+    for (auto &&op: _batch.getOps()) {
+        CHECK_STATE(op.key.size() <= UINT32_MAX && op.value.size() <= UINT32_MAX);
+
+        append<uint8_t>(record, op.isDelete ? OP_DELETE : OP_PUT);
+        append<uint32_t>(record, op.key.size());
+        append<uint32_t>(record, op.value.size());
+        record.append(op.key);
+        _updates.push_back({op.key, op.isDelete, {record.size(), op.value.size()}});
+        record.append(op.value);
+    }
+
+    uint64_t payloadSize = record.size() - RECORD_HEADER_SIZE;
+    auto crc = checksum(record.data() + RECORD_HEADER_SIZE, payloadSize);
+    memcpy(&record[sizeof(uint32_t)], &crc, sizeof(crc));
+    memcpy(&record[2 * sizeof(uint32_t)], &payloadSize, sizeof(payloadSize));
+
+    return record;
+}
+
+void MappedStore::writeFile(int _fd, const string &_data, uint64_t _offset) {
+    uint64_t written = 0;
+    while (written < _data.size()) {
+        auto result = pwrite(_fd, _data.data() + written, _data.size() - written, _offset + written);
+        if (result < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            throwAccessError("write");
+        }
+        written += result;
+    }
+}
+
+bool MappedStore::get(const string &_key, string &_value) {
+    shared_lock<shared_mutex> lock(indexMutex);
+
+    auto it = index.find(_key);
+    if (it == index.end()) {
+        return false;
+    }
+
+    _value.assign(data + it->second.offset, it->second.size);
+    return true;
+}
+
+vector<shared_ptr<string>> MappedStore::getMany(const vector<string> &_keys) {
+    vector<shared_ptr<string>> values(_keys.size());
+
+    // writers update the index under an exclusive lock, so one shared lock gives one snapshot
+    shared_lock<shared_mutex> lock(indexMutex);
+
+    for (uint64_t i = 0; i < _keys.size(); i++) {
+        auto it = index.find(_keys[i]);
+        if (it != index.end()) {
+            values[i] = make_shared<string>(data + it->second.offset, it->second.size);
+        }
+    }
+
+    return values;
+}
+
+void MappedStore::write(const Batch &_batch) {
+    if (_batch.empty()) {
+        return;
+    }
+
+    vector<Update> updates;
+    auto record = encodeRecord(_batch, updates);
+
+    lock_guard<mutex> lock(writeMutex);
+
+    // like a torn write, a failed write is overwritten by the next one or dropped on open
+    writeFile(fd, record, fileSize);
+
+    for (auto &&update: updates) {
+        update.value.offset += fileSize;
+    }
+
+    unique_lock<shared_mutex> indexLock(indexMutex);
+
+    remap(fileSize + record.size());
+    apply(updates);
+    fileSize += record.size();
+}
+
+void MappedStore::sync() {
+    // a duplicate stays valid if compaction replaces fd, the compacted file is synced already
+    int syncFd;
+    {
+        shared_lock<shared_mutex> indexLock(indexMutex);
+        syncFd = dup(fd);
+    }
+
+    if (syncFd < 0) {
+        throwAccessError("dup");
+    }
+
+    auto result = fdatasync(syncFd);
+    ::close(syncFd);
+
+    if (result != 0) {
+        throwAccessError("fdatasync");
+    }
+}
+
+void MappedStore::scan(const string &_from, const Visitor &_visitor) {
+    shared_lock<shared_mutex> lock(indexMutex);
+
+    for (auto it = index.lower_bound(_from); it != index.end(); it++) {
+        if (!_visitor(it->first, string_view(data + it->second.offset, it->second.size))) {
+            break;
+        }
+    }
+}
+
+bool MappedStore::findLast(const string &_before, string &_key) {
+    shared_lock<shared_mutex> lock(indexMutex);
+
+    auto it = index.lower_bound(_before);
+    if (it == index.begin()) {
+        return false;
+    }
+
+    _key = prev(it)->first;
+    return true;
+}
+
+uint64_t MappedStore::getApproximateSize() {
+    shared_lock<shared_mutex> lock(indexMutex);
+    return fileSize;
+}
+
+uint64_t MappedStore::getNumKeys() {
+    shared_lock<shared_mutex> lock(indexMutex);
+    return index.size();
+}
+
+void MappedStore::compact() {
+    lock_guard<mutex> lock(writeMutex);
+
+    Batch live;
+    {
+        shared_lock<shared_mutex> indexLock(indexMutex);
+        for (auto &&entry: index) {
+            live.put(entry.first, string(data + entry.second.offset, entry.second.size));
+        }
+    }
+
+    string content(FILE_MAGIC, FILE_HEADER_SIZE);
+    if (!live.empty()) {
+        vector<Update> updates;
+        content += encodeRecord(live, updates);
+    }
+
+    auto tmpName = fileName + ".compact";
+    int tmpFd = ::open(tmpName.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, S_IRUSR | S_IWUSR);
+    if (tmpFd < 0) {
+        throwAccessError("open " + tmpName);
+    }
+
+    try {
+        writeFile(tmpFd, content, 0);
+        if (fsync(tmpFd) != 0) {
+            throwAccessError("fsync " + tmpName);
+        }
+    } catch (...) {
+        ::close(tmpFd);
+        unlink(tmpName.c_str());
+        throw;
+    }
+
+    ::close(tmpFd);
+
+    unique_lock<shared_mutex> indexLock(indexMutex);
+
+    if (rename(tmpName.c_str(), fileName.c_str()) != 0) {
+        unlink(tmpName.c_str());
+        throwAccessError("rename " + tmpName);
+    }
+
+    close();
+    open();
+
+    spdlog::info("Compacted {} to {} bytes", fileName, fileSize);
+}
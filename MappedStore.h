@@ -0,0 +1,124 @@
+/*
+    Copyright (C) 2021-Present SKALE Labs
+
+    This file is part of sgxwallet.
+
+    sgxwallet is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as published
+    by the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    sgxwallet is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with sgxwallet. If not, see <https://www.gnu.org/licenses/>.
+
+    @file MappedStore.h
+    @author Stan Kladko
+    @date 2021
+*/
+
+
+#ifndef SGXWALLET_MAPPEDSTORE_H
+#define SGXWALLET_MAPPEDSTORE_H
+
+#include <map>
+#include <mutex>
+#include <shared_mutex>
+
+#include "KeyValueStore.h"
+
+// Read mostly engine, selected with sgxwallet -D mapped. All data is in one append only file
+// that is mapped into memory, and an in memory index maps each key to its value in the mapping.
+// A lookup is an index search and a copy out of the page cache, with no compaction running
+// behind it. Each write appends one checksummed batch record, a torn record at the end of the
+// file is dropped when the file is opened. The file is rewritten without dead records when it is
+// compacted, and when it is opened with more dead than live bytes.
+//
+// Readers share indexMutex. A writer appends its record without it and holds it exclusively only
+// to publish the record in the index. Readers never look past the records in the index, so the
+// mapping can be larger than the file.
+class MappedStore : public KeyValueStore {
+
+    struct Location {
+        uint64_t offset;
+        uint64_t size;
+    };
+
+    // one op of a batch record, the key points into the batch or the mapping
+    struct Update {
+        string_view key;
+        bool isDelete;
+        Location value;
+    };
+
+    const string fileName;
+
+    int fd = -1;
+
+    const char *data = nullptr;
+
+    uint64_t mapSize = 0;
+
+    // end of the last record in the index
+    uint64_t fileSize = 0;
+
+    // bytes of the records that are in the index
+    uint64_t liveBytes = 0;
+
+    map<string, Location, less<>> index;
+
+    shared_mutex indexMutex;
+
+    // serializes writes and compaction
+    mutex writeMutex;
+
+    // opens or creates the file and loads its records, must hold indexMutex exclusively
+    void open();
+
+    void close();
+
+    // must hold indexMutex exclusively
+    void remap(uint64_t _minSize);
+
+    // parses the batch record at _offset and applies it to the index, false if it is torn.
+    // Moves _offset past the record
+    bool loadRecord(uint64_t &_offset, uint64_t _end);
+
+    // must hold indexMutex exclusively
+    void apply(const vector<Update> &_updates);
+
+    static void writeFile(int _fd, const string &_data, uint64_t _offset);
+
+    // the value offsets of _updates are relative to the start of the record
+    static string encodeRecord(const Batch &_batch, vector<Update> &_updates);
+
+public:
+
+    explicit MappedStore(const string &_fileName);
+
+    ~MappedStore() override;
+
+    bool get(const string &_key, string &_value) override;
+
+    vector<shared_ptr<string>> getMany(const vector<string> &_keys) override;
+
+    void write(const Batch &_batch) override;
+
+    void sync() override;
+
+    void scan(const string &_from, const Visitor &_visitor) override;
+
+    bool findLast(const string &_before, string &_key) override;
+
+    uint64_t getApproximateSize() override;
+
+    void compact() override;
+
+    uint64_t getNumKeys();
+};
+
+#endif //SGXWALLET_MAPPEDSTORE_H
@@ -0,0 +1,89 @@
+/*
+    Copyright (C) 2021-Present SKALE Labs
+
+    This file is part of sgxwallet.
+
+    sgxwallet is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as published
+    by the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    sgxwallet is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with sgxwallet. If not, see <https://www.gnu.org/licenses/>.
+
+    @file MemoryBudget.cpp
+    @author Stan Kladko
+    @date 2021
+*/
+
+
+#include <malloc.h>
+
+#include "sgxwallet_common.h"
+#include "third_party/spdlog/spdlog.h"
+
+#include "MemoryBudget.h"
+
+mutex MemoryBudget::consumersMutex;
+map<string, MemoryBudget::Consumer> MemoryBudget::consumers;
+atomic<bool> MemoryBudget::underPressure(false);
+atomic<uint64_t> MemoryBudget::budgetBytes(0);
+atomic<uint64_t> MemoryBudget::shrinks(0);
+
+void MemoryBudget::addConsumer(const string &_name, const function<uint64_t()> &_getBytes,
+                               const function<void()> &_shrink) {
+    lock_guard<mutex> lock(consumersMutex);
+    consumers[_name] = {_getBytes, _shrink};
+}
+
+map<string, uint64_t> MemoryBudget::getConsumerBytes() {
+    map<string, uint64_t> result;
+
+    lock_guard<mutex> lock(consumersMutex);
+    for (auto &&consumer : consumers) {
+        result[consumer.first] = consumer.second.getBytes();
+    }
+    return result;
+}
+
+void MemoryBudget::update(uint64_t _rssBytes, uint64_t _physicalBytes) {
+    if (_rssBytes > _physicalBytes / 100 * MEMORY_EXIT_PERCENT) {
+        spdlog::error("sgxwallet uses {} of {} bytes of physical memory, exiting", _rssBytes, _physicalBytes);
+        exit(-103);
+    }
+
+    budgetBytes = _physicalBytes / 100 * MEMORY_BUDGET_PERCENT;
+
+    bool pressure = _rssBytes > budgetBytes / 100 * MEMORY_PRESSURE_PERCENT;
+
+    if (pressure != underPressure.exchange(pressure)) {
+        if (pressure) {
+            spdlog::warn("sgxwallet uses {} bytes of its {} bytes memory budget, shrinking caches and admitting "
+                         "fewer requests", _rssBytes, budgetBytes.load());
+        } else {
+            spdlog::info("sgxwallet uses {} bytes of its {} bytes memory budget, memory pressure is over",
+                         _rssBytes, budgetBytes.load());
+        }
+    }
+
+    if (!pressure) {
+        return;
+    }
+
+    {
+        lock_guard<mutex> lock(consumersMutex);
+        for (auto &&consumer : consumers) {
+            consumer.second.shrink();
+        }
+    }
+
+    // freed cache entries only lower the resident set once malloc gives the pages back
+    malloc_trim(0);
+
+    shrinks++;
+}
@@ -0,0 +1,81 @@
+/*
+    Copyright (C) 2021-Present SKALE Labs
+
+    This file is part of sgxwallet.
+
+    sgxwallet is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as published
+    by the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    sgxwallet is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with sgxwallet. If not, see <https://www.gnu.org/licenses/>.
+
+    @file MemoryBudget.h
+    @author Stan Kladko
+    @date 2021
+*/
+
+
+#ifndef SGXWALLET_MEMORYBUDGET_H
+#define SGXWALLET_MEMORYBUDGET_H
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <string>
+
+using namespace std;
+
+// Keeps sgxwallet within MEMORY_BUDGET_PERCENT of physical memory. Caches register as consumers,
+// each with its own size limit, and report the bytes they hold. When the resident set sampled by
+// Metrics goes over MEMORY_PRESSURE_PERCENT of the budget, the server is under memory pressure:
+// consumers are asked to shrink on every sample, and the ZMQ and https servers admit new requests
+// only while fewer than MEMORY_PRESSURE_MAX_QUEUED are waiting or in flight. Requests keep being
+// served meanwhile, so a running DKG slows down instead of failing. The process only exits, as a
+// last resort before the OOM killer, above MEMORY_EXIT_PERCENT of physical memory.
+class MemoryBudget {
+
+    struct Consumer {
+        function<uint64_t()> getBytes;
+        function<void()> shrink;
+    };
+
+    static mutex consumersMutex;
+
+    static map<string, Consumer> consumers;
+
+    static atomic<bool> underPressure;
+
+    static atomic<uint64_t> budgetBytes;
+
+    static atomic<uint64_t> shrinks;
+
+public:
+
+    // _shrink frees some of the memory of the consumer, it is called from the metrics sampler
+    // thread. A consumer registered again under the same name replaces the earlier one
+    static void addConsumer(const string &_name, const function<uint64_t()> &_getBytes,
+                            const function<void()> &_shrink);
+
+    // (name, bytes) of all consumers
+    static map<string, uint64_t> getConsumerBytes();
+
+    // called with each memory sample
+    static void update(uint64_t _rssBytes, uint64_t _physicalBytes);
+
+    static bool isUnderPressure() { return underPressure.load(); }
+
+    static uint64_t getBudgetBytes() { return budgetBytes.load(); }
+
+    static uint64_t getShrinks() { return shrinks.load(); }
+};
+
+#endif //SGXWALLET_MEMORYBUDGET_H
@@ -0,0 +1,442 @@
+/*
+    Copyright (C) 2021-Present SKALE Labs
+
+    This file is part of sgxwallet.
+
+    sgxwallet is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as published
+    by the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    sgxwallet is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with sgxwallet. If not, see <https://www.gnu.org/licenses/>.
+
+    @file Metrics.cpp
+    @author Stan Kladko
+    @date 2021
+*/
+
+#include <cctype>
+#include <sys/sysinfo.h>
+#include <unistd.h>
+
+#include "sgxwallet_common.h"
+#include "SGXException.h"
+#include "ExitHandler.h"
+#include "third_party/spdlog/spdlog.h"
+#include "common.h"
+
+#include "LatencySLO.h"
+#include "MemoryBudget.h"
+#include "Metrics.h"
+
+mutex Metrics::registryMutex;
+map<string, unique_ptr<MetricsCounter>> Metrics::counters;
+map<string, unique_ptr<MetricsGauge>> Metrics::gauges;
+map<string, unique_ptr<MetricsHistogram>> Metrics::histograms;
+map<string, unique_ptr<MethodMetrics>> Metrics::methods;
+map<string, unique_ptr<EcallMetrics>> Metrics::ecalls;
+map<string, unique_ptr<PerfStageMetrics>> Metrics::perfStages;
+atomic<bool> Metrics::ecallTimingEnabled(false);
+atomic<bool> Metrics::profiling(false);
+thread_local const char *Metrics::currentEcall = nullptr;
+atomic<uint64_t> Metrics::ecallsInFlight(0);
+atomic<uint64_t> Metrics::peakEcallsInFlight(0);
+atomic<uint64_t> Metrics::lastPeakEcallsInFlight(0);
+MetricsHistogram Metrics::allEcallsLatency;
+mutex Metrics::rollingMutex;
+map<string, vector<HistogramSnapshot>> Metrics::rollingWindows;
+atomic<bool> Metrics::exitRequested(false);
+shared_ptr<thread> Metrics::samplerThread = nullptr;
+
+MetricsHistogram::MetricsHistogram() : count(0), sumUs(0) {
+    for (auto &bucket : buckets) {
+        bucket.store(0, memory_order_relaxed);
+    }
+}
+
+void MetricsHistogram::observeUs(uint64_t _us) {
+    // index of the first power of two above _us
+    uint64_t i = _us == 0 ? 0 : 64 - __builtin_clzll(_us);
+    if (i >= NUM_BUCKETS) {
+        i = NUM_BUCKETS - 1;
+    }
+
+    buckets[i].fetch_add(1, memory_order_relaxed);
+    count.fetch_add(1, memory_order_relaxed);
+    sumUs.fetch_add(_us, memory_order_relaxed);
+}
+
+HistogramSnapshot MetricsHistogram::snapshot() const {
+    HistogramSnapshot result;
+    for (uint64_t i = 0; i < NUM_BUCKETS; i++) {
+        result.buckets[i] = getBucket(i);
+        result.count += result.buckets[i];
+    }
+    return result;
+}
+
+HistogramSnapshot HistogramSnapshot::operator-(const HistogramSnapshot &_older) const {
+    HistogramSnapshot result;
+    for (uint64_t i = 0; i < METRICS_HISTOGRAM_BUCKETS; i++) {
+        result.buckets[i] = buckets[i] - _older.buckets[i];
+        result.count += result.buckets[i];
+    }
+    return result;
+}
+
+uint64_t HistogramSnapshot::quantileUs(double _q) const {
+    if (count == 0) {
+        return 0;
+    }
+
+    double rank = _q * count;
+    uint64_t cumulative = 0;
+
+    for (uint64_t i = 0; i < METRICS_HISTOGRAM_BUCKETS; i++) {
+        if (buckets[i] > 0 && cumulative + buckets[i] >= rank) {
+            // bucket i holds [2^(i-1), 2^i) microseconds
+            double lower = i == 0 ? 0 : MetricsHistogram::getBucketUpperBoundUs(i - 1);
+            double upper = MetricsHistogram::getBucketUpperBoundUs(i);
+            return lower + (upper - lower) * (rank - cumulative) / buckets[i];
+        }
+        cumulative += buckets[i];
+    }
+
+    return MetricsHistogram::getBucketUpperBoundUs(METRICS_HISTOGRAM_BUCKETS - 1);
+}
+
+uint64_t HistogramSnapshot::countAboveUs(uint64_t _us) const {
+    double above = 0;
+
+    for (uint64_t i = 0; i < METRICS_HISTOGRAM_BUCKETS; i++) {
+        double lower = i == 0 ? 0 : MetricsHistogram::getBucketUpperBoundUs(i - 1);
+        double upper = MetricsHistogram::getBucketUpperBoundUs(i);
+        if (lower >= _us) {
+            above += buckets[i];
+        } else if (upper > _us) {
+            above += buckets[i] * (upper - _us) / (upper - lower);
+        }
+    }
+
+    return above;
+}
+
+template<class T>
+static T &getOrCreate(mutex &_mutex, map<string, unique_ptr<T>> &_map, const string &_name) {
+    lock_guard<mutex> lock(_mutex);
+    auto &entry = _map[_name];
+    if (!entry) {
+        entry = make_unique<T>();
+    }
+    return *entry;
+}
+
+template<class T>
+static vector<pair<string, const T *>> list(mutex &_mutex, map<string, unique_ptr<T>> &_map) {
+    lock_guard<mutex> lock(_mutex);
+    vector<pair<string, const T *>> result;
+    result.reserve(_map.size());
+    for (auto &&entry : _map) {
+        result.emplace_back(entry.first, entry.second.get());
+    }
+    return result;
+}
+
+MetricsCounter &Metrics::getCounter(const string &_name) {
+    return getOrCreate(registryMutex, counters, _name);
+}
+
+MetricsGauge &Metrics::getGauge(const string &_name) {
+    return getOrCreate(registryMutex, gauges, _name);
+}
+
+MetricsHistogram &Metrics::getHistogram(const string &_name) {
+    return getOrCreate(registryMutex, histograms, _name);
+}
+
+MethodMetrics &Metrics::getMethod(const string &_name) {
+    return getOrCreate(registryMutex, methods, _name);
+}
+
+EcallMetrics &Metrics::getEcall(const string &_name) {
+    return getOrCreate(registryMutex, ecalls, _name);
+}
+
+PerfStageMetrics &Metrics::getPerfStage(const string &_name) {
+    return getOrCreate(registryMutex, perfStages, _name);
+}
+
+vector<pair<string, const MetricsCounter *>> Metrics::listCounters() {
+    return list(registryMutex, counters);
+}
+
+vector<pair<string, const MetricsGauge *>> Metrics::listGauges() {
+    return list(registryMutex, gauges);
+}
+
+vector<pair<string, const MetricsHistogram *>> Metrics::listHistograms() {
+    return list(registryMutex, histograms);
+}
+
+vector<pair<string, const MethodMetrics *>> Metrics::listMethods() {
+    return list(registryMutex, methods);
+}
+
+vector<pair<string, const EcallMetrics *>> Metrics::listEcalls() {
+    return list(registryMutex, ecalls);
+}
+
+vector<pair<string, const PerfStageMetrics *>> Metrics::listPerfStages() {
+    return list(registryMutex, perfStages);
+}
+
+string Metrics::toPrometheusName(const string &_name) {
+    string result = "sgxwallet_";
+
+    for (size_t i = 0; i < _name.size(); i++) {
+        char c = _name[i];
+        if (isupper(c)) {
+            // processRSSBytes becomes process_rss_bytes
+            bool afterLower = i > 0 && (islower(_name[i - 1]) || isdigit(_name[i - 1]));
+            bool endsAcronym = i > 0 && isupper(_name[i - 1]) && i + 1 < _name.size() && islower(_name[i + 1]);
+            if ((afterLower || endsAcronym) && result.back() != '_') {
+                result.push_back('_');
+            }
+            result.push_back(tolower(c));
+        } else if (isalnum(c)) {
+            result.push_back(c);
+        } else if (result.back() != '_') {
+            result.push_back('_');
+        }
+    }
+
+    return result;
+}
+
+void Metrics::renderHeader(string &_out, const string &_name, const char *_type, const char *_help) {
+    _out.append("# HELP ").append(_name).append(" ").append(_help).append("\n");
+    _out.append("# TYPE ").append(_name).append(" ").append(_type).append("\n");
+}
+
+void Metrics::renderSample(string &_out, const string &_name, const string &_labels, uint64_t _value) {
+    _out.append(_name);
+    if (!_labels.empty()) {
+        _out.append("{").append(_labels).append("}");
+    }
+    _out.append(" ").append(to_string(_value)).append("\n");
+}
+
+void Metrics::renderSample(string &_out, const string &_name, const string &_labels, double _value) {
+    _out.append(_name);
+    if (!_labels.empty()) {
+        _out.append("{").append(_labels).append("}");
+    }
+    _out.append(" ").append(to_string(_value)).append("\n");
+}
+
+void Metrics::renderHistogram(string &_out, const string &_name, const string &_labels,
+                              const MetricsHistogram &_histogram) {
+    auto prefix = _labels.empty() ? string() : _labels + ",";
+    uint64_t cumulative = 0;
+
+    for (uint64_t i = 0; i < MetricsHistogram::NUM_BUCKETS; i++) {
+        cumulative += _histogram.getBucket(i);
+        auto le = i + 1 < MetricsHistogram::NUM_BUCKETS ?
+                  to_string(MetricsHistogram::getBucketUpperBoundUs(i) / 1e6) : string("+Inf");
+        renderSample(_out, _name + "_bucket", prefix + "le=\"" + le + "\"", cumulative);
+    }
+
+    renderSample(_out, _name + "_sum", _labels, _histogram.getSumUs() / 1e6);
+    renderSample(_out, _name + "_count", _labels, _histogram.getCount());
+}
+
+static void renderPerf(string &_out, const string &_prefix, const string &_label,
+                       const vector<pair<string, const PerfStageMetrics *>> &_list) {
+    static const vector<pair<const char *, MetricsCounter PerfStageMetrics::*>> COUNTERS = {
+            {"cycles", &PerfStageMetrics::cycles},
+            {"instructions", &PerfStageMetrics::instructions},
+            {"llc_misses", &PerfStageMetrics::llcMisses},
+            {"context_switches", &PerfStageMetrics::contextSwitches}};
+
+    for (auto &&counter : COUNTERS) {
+        auto name = _prefix + counter.first + "_total";
+        Metrics::renderHeader(_out, name, "counter", "User space hardware counter, while perf counting is enabled");
+        for (auto &&item : _list) {
+            Metrics::renderSample(_out, name, _label + "=\"" + item.first + "\"", (item.second->*counter.second).get());
+        }
+    }
+
+    auto name = _prefix + "samples_total";
+    Metrics::renderHeader(_out, name, "counter", "Counted runs");
+    for (auto &&item : _list) {
+        Metrics::renderSample(_out, name, _label + "=\"" + item.first + "\"", item.second->calls.get());
+    }
+}
+
+void Metrics::renderPrometheus(string &_out) {
+    auto methodList = listMethods();
+
+    if (!methodList.empty()) {
+        renderHeader(_out, "sgxwallet_method_calls_total", "counter", "JSON-RPC method calls over HTTP and ZMQ");
+        for (auto &&method : methodList) {
+            renderSample(_out, "sgxwallet_method_calls_total", "method=\"" + method.first + "\"",
+                         method.second->calls.get());
+        }
+
+        renderHeader(_out, "sgxwallet_method_allocations_total", "counter",
+                     "operator new calls of JSON-RPC methods, divide by calls for allocations per request");
+        for (auto &&method : methodList) {
+            renderSample(_out, "sgxwallet_method_allocations_total", "method=\"" + method.first + "\"",
+                         method.second->allocations.get());
+        }
+
+        renderHeader(_out, "sgxwallet_method_latency_seconds", "histogram", "JSON-RPC method latency");
+        for (auto &&method : methodList) {
+            renderHistogram(_out, "sgxwallet_method_latency_seconds", "method=\"" + method.first + "\"",
+                            method.second->latency);
+        }
+    }
+
+    if (PerfCounters::isEnabled()) {
+        vector<pair<string, const PerfStageMetrics *>> methodPerf;
+        for (auto &&method : methodList) {
+            methodPerf.emplace_back(method.first, &method.second->perf);
+        }
+        renderPerf(_out, "sgxwallet_method_perf_", "method", methodPerf);
+        renderPerf(_out, "sgxwallet_stage_perf_", "stage", listPerfStages());
+
+        renderHeader(_out, "sgxwallet_perf_unavailable_threads", "gauge",
+                     "Threads that could not open perf counters");
+        renderSample(_out, "sgxwallet_perf_unavailable_threads", "", (double) PerfCounters::getUnavailableThreads());
+    }
+
+    auto ecallList = listEcalls();
+
+    if (!ecallList.empty()) {
+        renderHeader(_out, "sgxwallet_ecall_transitions_total", "counter", "Enclave entries per trusted function");
+        for (auto &&ecall : ecallList) {
+            renderSample(_out, "sgxwallet_ecall_transitions_total", "function=\"" + ecall.first + "\"",
+                         ecall.second->calls.get());
+        }
+
+        renderHeader(_out, "sgxwallet_ecall_errors_total", "counter", "ECALLs that did not return SGX_SUCCESS");
+        for (auto &&ecall : ecallList) {
+            renderSample(_out, "sgxwallet_ecall_errors_total", "function=\"" + ecall.first + "\"",
+                         ecall.second->errors.get());
+        }
+
+        renderHeader(_out, "sgxwallet_ecall_latency_seconds", "histogram",
+                     "ECALL round trip time, including the transition, while ECALL timing is enabled");
+        for (auto &&ecall : ecallList) {
+            renderHistogram(_out, "sgxwallet_ecall_latency_seconds", "function=\"" + ecall.first + "\"",
+                            ecall.second->latency);
+        }
+    }
+
+    for (auto &&counter : listCounters()) {
+        auto name = toPrometheusName(counter.first) + "_total";
+        renderHeader(_out, name, "counter", counter.first.c_str());
+        renderSample(_out, name, "", counter.second->get());
+    }
+
+    for (auto &&gauge : listGauges()) {
+        auto name = toPrometheusName(gauge.first);
+        renderHeader(_out, name, "gauge", gauge.first.c_str());
+        renderSample(_out, name, "", (double) gauge.second->get());
+    }
+
+    for (auto &&histogram : listHistograms()) {
+        auto name = toPrometheusName(histogram.first) + "_seconds";
+        renderHeader(_out, name, "histogram", histogram.first.c_str());
+        renderHistogram(_out, name, "", *histogram.second);
+    }
+}
+
+void Metrics::sampleMemory() {
+    static auto &rssGauge = getGauge("processRSSBytes");
+    static auto &physGauge = getGauge("physicalMemoryBytes");
+
+    struct sysinfo memInfo;
+    CHECK_STATE(sysinfo(&memInfo) == 0);
+
+    int64_t totalPhysMem = memInfo.totalram;
+    totalPhysMem *= memInfo.mem_unit;
+
+    // getValue() is in KB
+    int64_t usedByCurrentProcess = getValue() * 1024LL;
+
+    rssGauge.set(usedByCurrentProcess);
+    physGauge.set(totalPhysMem);
+
+    MemoryBudget::update(usedByCurrentProcess, totalPhysMem);
+}
+
+HistogramSnapshot Metrics::getRolling(const string &_name, const MetricsHistogram &_histogram) {
+    auto current = _histogram.snapshot();
+
+    lock_guard<mutex> lock(rollingMutex);
+
+    auto it = rollingWindows.find(_name);
+    if (it == rollingWindows.end() || it->second.empty()) {
+        return current;
+    }
+
+    return current - it->second.front();
+}
+
+void Metrics::sampleRolling() {
+    auto named = listHistograms();
+
+    lock_guard<mutex> lock(rollingMutex);
+
+    auto record = [](vector<HistogramSnapshot> &_window, const MetricsHistogram &_histogram) {
+        if (_window.size() >= METRICS_ROLLING_WINDOW_SAMPLES) {
+            _window.erase(_window.begin());
+        }
+        _window.push_back(_histogram.snapshot());
+    };
+
+    for (auto &&histogram : named) {
+        record(rollingWindows[histogram.first], *histogram.second);
+    }
+
+    record(rollingWindows["allEcalls"], allEcallsLatency);
+
+    lastPeakEcallsInFlight = peakEcallsInFlight.exchange(ecallsInFlight.load());
+}
+
+void Metrics::samplerLoop() {
+    while (!exitRequested && !ExitHandler::shouldExit()) {
+        sampleRolling();
+
+        // memory is sampled more often, so that caches shrink before a burst uses up the budget
+        for (uint64_t i = 0; i < METRICS_SAMPLE_INTERVAL_SECONDS && !exitRequested && !ExitHandler::shouldExit(); i++) {
+            try {
+                sampleMemory();
+            } catch (exception &e) {
+                spdlog::error("Could not sample memory metrics: {}", e.what());
+            }
+            LatencySLO::update();
+            sleep(1);
+        }
+    }
+}
+
+void Metrics::initMetrics() {
+    CHECK_STATE(!samplerThread);
+    samplerThread = make_shared<thread>(samplerLoop);
+}
+
+void Metrics::exitMetrics() {
+    exitRequested = true;
+    if (samplerThread) {
+        samplerThread->join();
+        samplerThread = nullptr;
+    }
+}
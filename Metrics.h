@@ -0,0 +1,396 @@
+/*
+    Copyright (C) 2021-Present SKALE Labs
+
+    This file is part of sgxwallet.
+
+    sgxwallet is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as published
+    by the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    sgxwallet is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with sgxwallet. If not, see <https://www.gnu.org/licenses/>.
+
+    @file Metrics.h
+    @author Stan Kladko
+    @date 2021
+*/
+
+#ifndef SGXWALLET_METRICS_H
+#define SGXWALLET_METRICS_H
+
+#include <atomic>
+#include <chrono>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "Allocations.h"
+#include "DKGTimeline.h"
+#include "EcallGate.h"
+#include "PerfCounters.h"
+#include "Probes.h"
+#include "Tracing.h"
+
+#ifdef SGXWALLET_MOCK_ENCLAVE
+#include "MockEnclave.h"
+#define ECALL_TARGET(__ECALL__) MockEnclave::__ECALL__
+#else
+#define ECALL_TARGET(__ECALL__) __ECALL__
+#endif
+
+using namespace std;
+
+class MetricsCounter {
+
+    atomic<uint64_t> value;
+
+public:
+
+    MetricsCounter() : value(0) {}
+
+    void inc(uint64_t _n = 1) { value.fetch_add(_n, memory_order_relaxed); }
+
+    uint64_t get() const { return value.load(memory_order_relaxed); }
+};
+
+class MetricsGauge {
+
+    atomic<int64_t> value;
+
+public:
+
+    MetricsGauge() : value(0) {}
+
+    void set(int64_t _value) { value.store(_value, memory_order_relaxed); }
+
+    int64_t get() const { return value.load(memory_order_relaxed); }
+};
+
+static constexpr uint64_t METRICS_HISTOGRAM_BUCKETS = 25;
+
+// bucket counts of a histogram at one point in time, or the difference of two such points
+struct HistogramSnapshot {
+    uint64_t buckets[METRICS_HISTOGRAM_BUCKETS] = {};
+    uint64_t count = 0;
+
+    HistogramSnapshot operator-(const HistogramSnapshot &_older) const;
+
+    // estimated by linear interpolation inside the bucket, zero if the snapshot is empty
+    uint64_t quantileUs(double _q) const;
+
+    // durations longer than _us, interpolated the same way
+    uint64_t countAboveUs(uint64_t _us) const;
+};
+
+// Latency histogram with power of two buckets, bucket i counts durations below 2^i microseconds
+// and the last bucket counts everything else
+class MetricsHistogram {
+
+public:
+
+    static constexpr uint64_t NUM_BUCKETS = METRICS_HISTOGRAM_BUCKETS;
+
+private:
+
+    atomic<uint64_t> buckets[NUM_BUCKETS];
+
+    atomic<uint64_t> count;
+
+    atomic<uint64_t> sumUs;
+
+public:
+
+    MetricsHistogram();
+
+    void observeUs(uint64_t _us);
+
+    uint64_t getBucket(uint64_t _i) const { return buckets[_i].load(memory_order_relaxed); }
+
+    uint64_t getCount() const { return count.load(memory_order_relaxed); }
+
+    uint64_t getSumUs() const { return sumUs.load(memory_order_relaxed); }
+
+    HistogramSnapshot snapshot() const;
+
+    static uint64_t getBucketUpperBoundUs(uint64_t _i) { return 1ULL << _i; }
+};
+
+// hardware counter totals of a pipeline stage or method, see PerfCounters.h
+struct PerfStageMetrics {
+    MetricsCounter calls;
+    MetricsCounter cycles;
+    MetricsCounter instructions;
+    MetricsCounter llcMisses;
+    MetricsCounter contextSwitches;
+
+    void add(const PerfCounterValues &_start, const PerfCounterValues &_end) {
+        calls.inc();
+        cycles.inc(_end.cycles - _start.cycles);
+        instructions.inc(_end.instructions - _start.instructions);
+        llcMisses.inc(_end.llcMisses - _start.llcMisses);
+        contextSwitches.inc(_end.contextSwitches - _start.contextSwitches);
+    }
+};
+
+// adds the counters of the calling thread during the lifetime of a scope to a stage,
+// costs one relaxed load while counting is off
+class PerfScope {
+
+    PerfStageMetrics &stage;
+
+    PerfCounterValues start;
+
+    bool counting;
+
+public:
+
+    explicit PerfScope(PerfStageMetrics &_stage)
+            : stage(_stage), counting(PerfCounters::isEnabled() && PerfCounters::read(start)) {}
+
+    ~PerfScope() {
+        PerfCounterValues end;
+        if (counting && PerfCounters::read(end)) {
+            stage.add(start, end);
+        }
+    }
+};
+
+// adds the operator new calls of the calling thread during the lifetime of a scope to a counter
+class AllocationScope {
+
+    MetricsCounter &counter;
+
+    uint64_t start;
+
+public:
+
+    explicit AllocationScope(MetricsCounter &_counter)
+            : counter(_counter), start(Allocations::getThreadCount()) {}
+
+    ~AllocationScope() { counter.inc(Allocations::getThreadCount() - start); }
+};
+
+// calls and latency of a JSON-RPC method, shared by the HTTP and ZMQ servers
+struct MethodMetrics {
+    MetricsCounter calls;
+    MetricsHistogram latency;
+    MetricsCounter allocations;
+    PerfStageMetrics perf;
+};
+
+// enclave transitions, failed ECALLs and ECALL round trip time of a trusted function
+struct EcallMetrics {
+    MetricsCounter calls;
+    MetricsCounter errors;
+    MetricsHistogram latency;
+};
+
+// records the lifetime of a scope into a histogram
+class MetricsTimer {
+
+    MetricsHistogram &histogram;
+
+    chrono::steady_clock::time_point start;
+
+public:
+
+    explicit MetricsTimer(MetricsHistogram &_histogram)
+            : histogram(_histogram), start(chrono::steady_clock::now()) {}
+
+    ~MetricsTimer() {
+        histogram.observeUs(
+                chrono::duration_cast<chrono::microseconds>(chrono::steady_clock::now() - start).count());
+    }
+};
+
+// Registry of named metrics. Metrics are never removed, so references returned by the getters
+// stay valid. A lookup takes a lock and is meant to be done once into a function static reference,
+// see COUNT_STATISTICS and METRICS_TIMER, so the request path only pays for relaxed atomic adds.
+//
+// A background thread samples process memory into the processRSSBytes and physicalMemoryBytes gauges,
+// and passes it on to MemoryBudget.
+class Metrics {
+
+    static mutex registryMutex;
+
+    static map<string, unique_ptr<MetricsCounter>> counters;
+
+    static map<string, unique_ptr<MetricsGauge>> gauges;
+
+    static map<string, unique_ptr<MetricsHistogram>> histograms;
+
+    static map<string, unique_ptr<MethodMetrics>> methods;
+
+    static map<string, unique_ptr<EcallMetrics>> ecalls;
+
+    static map<string, unique_ptr<PerfStageMetrics>> perfStages;
+
+    static atomic<bool> ecallTimingEnabled;
+
+    static atomic<bool> profiling;
+
+    static thread_local const char *currentEcall;
+
+    static atomic<uint64_t> ecallsInFlight;
+
+    static atomic<uint64_t> peakEcallsInFlight;
+
+    static atomic<uint64_t> lastPeakEcallsInFlight;
+
+    static MetricsHistogram allEcallsLatency;
+
+    // snapshots of each named histogram taken by the sampler, oldest first
+    static mutex rollingMutex;
+
+    static map<string, vector<HistogramSnapshot>> rollingWindows;
+
+    static void sampleRolling();
+
+    static atomic<bool> exitRequested;
+
+    static shared_ptr<thread> samplerThread;
+
+    static void samplerLoop();
+
+public:
+
+    static MetricsCounter &getCounter(const string &_name);
+
+    static MetricsGauge &getGauge(const string &_name);
+
+    static MetricsHistogram &getHistogram(const string &_name);
+
+    static MethodMetrics &getMethod(const string &_name);
+
+    static EcallMetrics &getEcall(const string &_name);
+
+    static PerfStageMetrics &getPerfStage(const string &_name);
+
+    // ECALLs are always counted, timing them is switched at runtime, see the info server setEcallTiming
+    static void setEcallTimingEnabled(bool _enabled) { ecallTimingEnabled = _enabled; }
+
+    static bool isEcallTimingEnabled() { return ecallTimingEnabled.load(memory_order_relaxed); }
+
+    // ECALLs are also timed while the CPU profiler runs, see Profiler.h
+    static void setProfiling(bool _profiling) { profiling = _profiling; }
+
+    // the ECALL the calling thread is in, or nullptr. Read by the profiler signal handler
+    static const char *getCurrentEcall() { return currentEcall; }
+
+    // ECALLs currently inside the enclave, each occupies one TCS
+    static uint64_t getEcallsInFlight() { return ecallsInFlight.load(memory_order_relaxed); }
+
+    // the most ECALLs in flight at the same time during the last sampler interval
+    static uint64_t getPeakEcallsInFlight() { return lastPeakEcallsInFlight.load(memory_order_relaxed); }
+
+    static const MetricsHistogram &getAllEcallsLatency() { return allEcallsLatency; }
+
+    // the part of the histogram recorded during the last METRICS_ROLLING_WINDOW_SAMPLES sampler intervals
+    static HistogramSnapshot getRolling(const string &_name, const MetricsHistogram &_histogram);
+
+    template<class F>
+    static auto runEcall(EcallMetrics &_metrics, const char *_name, uint64_t _eid, F &&_ecall) -> decltype(_ecall()) {
+        _metrics.calls.inc();
+
+        EcallGate::admit(_eid, currentEcall != nullptr);
+
+        static auto &perfStage = getPerfStage("ecall");
+        PerfScope perfScope(perfStage);
+
+        // ECALLs of a DKG call are always timed for its DKGTimeline
+        auto dkgPhase = DKGTimeline::inPhase() && currentEcall == nullptr;
+        bool timed = isEcallTimingEnabled() || profiling.load(memory_order_relaxed) || dkgPhase;
+        auto start = timed ? chrono::steady_clock::now() : chrono::steady_clock::time_point();
+
+        auto inFlight = ecallsInFlight.fetch_add(1, memory_order_relaxed) + 1;
+        auto peak = peakEcallsInFlight.load(memory_order_relaxed);
+        while (inFlight > peak && !peakEcallsInFlight.compare_exchange_weak(peak, inFlight, memory_order_relaxed)) {
+        }
+
+        auto outerEcall = currentEcall;
+        currentEcall = _name;
+        PROBE1(ecall__entry, _name);
+        auto status = _ecall();
+        PROBE2(ecall__return, _name, (int) status);
+        currentEcall = outerEcall;
+
+        ecallsInFlight.fetch_sub(1, memory_order_relaxed);
+
+        if (timed) {
+            auto us = chrono::duration_cast<chrono::microseconds>(chrono::steady_clock::now() - start).count();
+            _metrics.latency.observeUs(us);
+            allEcallsLatency.observeUs(us);
+            if (dkgPhase) {
+                DKGTimeline::addEcallUs(us);
+            }
+        }
+        if (status != 0) {
+            _metrics.errors.inc();
+        }
+        return status;
+    }
+
+    // snapshots for exporters, sorted by name
+    static vector<pair<string, const MetricsCounter *>> listCounters();
+
+    static vector<pair<string, const MetricsGauge *>> listGauges();
+
+    static vector<pair<string, const MetricsHistogram *>> listHistograms();
+
+    static vector<pair<string, const MethodMetrics *>> listMethods();
+
+    static vector<pair<string, const EcallMetrics *>> listEcalls();
+
+    static vector<pair<string, const PerfStageMetrics *>> listPerfStages();
+
+    // appends the registry in the Prometheus text format. Names get the sgxwallet_ prefix and are
+    // converted to snake case, histograms are exported in seconds
+    static void renderPrometheus(string &_out);
+
+    static string toPrometheusName(const string &_name);
+
+    static void renderHeader(string &_out, const string &_name, const char *_type, const char *_help);
+
+    static void renderSample(string &_out, const string &_name, const string &_labels, uint64_t _value);
+
+    static void renderSample(string &_out, const string &_name, const string &_labels, double _value);
+
+    static void renderHistogram(string &_out, const string &_name, const string &_labels,
+                                const MetricsHistogram &_histogram);
+
+    // reads process memory into the gauges, every second
+    static void sampleMemory();
+
+    static void initMetrics();
+
+    static void exitMetrics();
+};
+
+// wraps a call of a generated ECALL stub, status = ECALL(trustedBlsSignMessage, eid, ...), or of
+// MockEnclave in a MOCK_ENCLAVE=1 build
+#define ECALL(__ECALL__, ...) \
+([&]() { \
+    static auto &__ECALL_METRICS__ = Metrics::getEcall(#__ECALL__); \
+    TRACE_SPAN(#__ECALL__) \
+    return Metrics::runEcall(__ECALL_METRICS__, #__ECALL__, EcallGate::eidOf(__VA_ARGS__), \
+                             [&]() { return ECALL_TARGET(__ECALL__)(__VA_ARGS__); }); \
+}())
+
+#define METRICS_TIMER(__NAME__) \
+static auto &__METRICS_HISTOGRAM__ = Metrics::getHistogram(__NAME__); \
+MetricsTimer __METRICS_TIMER__(__METRICS_HISTOGRAM__);
+
+#define PERF_STAGE(__NAME__) \
+static auto &__PERF_STAGE__ = Metrics::getPerfStage(__NAME__); \
+PerfScope __PERF_SCOPE__(__PERF_STAGE__);
+
+#endif //SGXWALLET_METRICS_H
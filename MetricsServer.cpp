@@ -0,0 +1,350 @@
+/*
+    Copyright (C) 2021-Present SKALE Labs
+
+    This file is part of sgxwallet.
+
+    sgxwallet is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as published
+    by the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    sgxwallet is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with sgxwallet. If not, see <https://www.gnu.org/licenses/>.
+
+    @file MetricsServer.cpp
+    @author Stan Kladko
+    @date 2021
+*/
+
+#include <cstring>
+
+#include <microhttpd.h>
+#include <json/writer.h>
+
+#include "sgxwallet_common.h"
+#include "SGXException.h"
+#include "LevelDB.h"
+#include "DKGGarbageCollector.h"
+#include "KeyStoreReplicator.h"
+#include "ECDSANoncePool.h"
+#include "ECDSAKeyPool.h"
+#include "SEKRotation.h"
+#include "SGXWalletServer.hpp"
+#include "zmq_src/ZMQServer.h"
+#include "zmq_src/CertVerifier.h"
+#include "third_party/spdlog/spdlog.h"
+#include "common.h"
+
+#include "ServerInit.h"
+#include "MemoryBudget.h"
+#include "LatencySLO.h"
+#include "Metrics.h"
+#include "Readiness.h"
+#include "Bulkhead.h"
+#include "DKGTimeline.h"
+#include "KernelTLS.h"
+#include "MetricsServer.h"
+
+#if MHD_VERSION >= 0x00097002
+typedef enum MHD_Result MHDResult;
+#else
+typedef int MHDResult;
+#endif
+
+bool MetricsServer::enabled = false;
+MHD_Daemon *MetricsServer::daemon = nullptr;
+
+static void renderCounter(string &_out, const char *_name, const char *_help, uint64_t _value) {
+    Metrics::renderHeader(_out, _name, "counter", _help);
+    Metrics::renderSample(_out, _name, "", _value);
+}
+
+static void renderGauge(string &_out, const char *_name, const char *_help, uint64_t _value) {
+    Metrics::renderHeader(_out, _name, "gauge", _help);
+    Metrics::renderSample(_out, _name, "", _value);
+}
+
+string MetricsServer::render() {
+    string out;
+
+    Metrics::renderPrometheus(out);
+
+    Metrics::renderHeader(out, "sgxwallet_zmq_sign_queue_depth", "gauge", "Pending sign requests per ZMQ worker queue");
+    auto depths = ZMQServer::getSignQueueDepths();
+    for (uint64_t i = 0; i < depths.size(); i++) {
+        Metrics::renderSample(out, "sgxwallet_zmq_sign_queue_depth", "queue=\"" + to_string(i) + "\"", depths[i]);
+    }
+
+    renderGauge(out, "sgxwallet_zmq_active_workers", "ZMQ worker threads taking requests",
+                ZMQServer::getActiveWorkerThreads());
+    renderCounter(out, "sgxwallet_zmq_worker_scale_ups_total", "Times the autoscaled ZMQ worker pool grew",
+                  WorkerThreadPool::getScaleUps());
+    renderCounter(out, "sgxwallet_zmq_worker_scale_downs_total", "Times the autoscaled ZMQ worker pool shrank",
+                  WorkerThreadPool::getScaleDowns());
+    renderGauge(out, "sgxwallet_zmq_slow_queue_depth", "Pending non sign ZMQ requests",
+                ZMQServer::getSlowQueueDepth());
+    renderGauge(out, "sgxwallet_zmq_enclave_stage_queue_depth", "Sign requests waiting for an enclave stage thread",
+                ZMQServer::getEnclaveStageQueueDepth());
+    renderGauge(out, "sgxwallet_zmq_cpu_stage_queue_depth", "Public requests waiting for a CPU stage thread",
+                ZMQServer::getCpuStageQueueDepth());
+    renderGauge(out, "sgxwallet_zmq_fair_queue_depth", "Sign requests waiting in the per client fair queue",
+                ZMQServer::getFairQueueDepth());
+    renderGauge(out, "sgxwallet_zmq_fair_queue_partitions", "Schain partitions with sign requests in the fair queue",
+                ZMQServer::getFairQueuePartitions());
+    renderGauge(out, "sgxwallet_zmq_dkg_sessions", "Poly names with a DKG request in processing",
+                ZMQServer::getDKGSessions());
+    renderGauge(out, "sgxwallet_zmq_outgoing_queue_depth", "ZMQ replies waiting to be sent",
+                ZMQServer::getOutgoingQueueDepth());
+    renderGauge(out, "sgxwallet_zmq_sessions", "Open ZMQ sessions", ZMQMessage::getNumSessions());
+    renderGauge(out, "sgxwallet_zmq_verified_certs", "Client certs in the verified cert cache",
+                ZMQMessage::getNumVerifiedCerts());
+    renderCounter(out, "sgxwallet_zmq_verified_cert_evictions_total",
+                  "Client certs evicted from the full verified cert cache", ZMQMessage::getVerifiedCertEvictions());
+    renderCounter(out, "sgxwallet_cert_verifications_total", "Client certs verified against the root CA",
+                  CertVerifier::getVerified());
+    renderCounter(out, "sgxwallet_cert_verification_failures_total", "Client certs that failed verification",
+                  CertVerifier::getFailed());
+    renderCounter(out, "sgxwallet_zmq_rejected_requests_total", "ZMQ requests rejected because a queue was full",
+                  ZMQServer::getRejectedRequests());
+    renderCounter(out, "sgxwallet_zmq_expired_requests_total", "ZMQ requests dropped after their deadline",
+                  ZMQServer::getExpiredRequests());
+    renderCounter(out, "sgxwallet_zmq_rate_limited_requests_total", "ZMQ requests over the client rate limit",
+                  ZMQServer::getRateLimitedRequests());
+
+    Metrics::renderHeader(out, "sgxwallet_bulkhead_in_use", "gauge", "Calls of a method class holding a concurrency slot");
+    for (int i = 0; i < Bulkhead::NUM_CLASSES; i++) {
+        auto c = (Bulkhead::Class) i;
+        Metrics::renderSample(out, "sgxwallet_bulkhead_in_use", string("class=\"") + Bulkhead::getName(c) + "\"",
+                              Bulkhead::getInUse(c));
+    }
+    Metrics::renderHeader(out, "sgxwallet_bulkhead_rejected_total", "counter",
+                          "Calls that found no free concurrency slot of their method class");
+    for (int i = 0; i < Bulkhead::NUM_CLASSES; i++) {
+        auto c = (Bulkhead::Class) i;
+        Metrics::renderSample(out, "sgxwallet_bulkhead_rejected_total", string("class=\"") + Bulkhead::getName(c) + "\"",
+                              Bulkhead::getRejected(c));
+    }
+
+    Metrics::renderHeader(out, "sgxwallet_dkg_phase_seconds", "histogram", "Wall time of DKG calls per phase");
+    for (int i = 0; i < DKGTimeline::NUM_PHASES; i++) {
+        auto phase = (DKGTimeline::Phase) i;
+        Metrics::renderHistogram(out, "sgxwallet_dkg_phase_seconds", string("phase=\"") + DKGTimeline::getName(phase) + "\"",
+                                 DKGTimeline::getLatency(phase));
+    }
+    Metrics::renderHeader(out, "sgxwallet_dkg_phase_ecall_seconds_total", "counter", "ECALL time of DKG calls per phase");
+    for (int i = 0; i < DKGTimeline::NUM_PHASES; i++) {
+        auto phase = (DKGTimeline::Phase) i;
+        Metrics::renderSample(out, "sgxwallet_dkg_phase_ecall_seconds_total",
+                              string("phase=\"") + DKGTimeline::getName(phase) + "\"",
+                              DKGTimeline::getTotalEcallUs(phase) / 1e6);
+    }
+    Metrics::renderHeader(out, "sgxwallet_dkg_phase_db_seconds_total", "counter",
+                          "Database write time of DKG calls per phase, including syncs");
+    for (int i = 0; i < DKGTimeline::NUM_PHASES; i++) {
+        auto phase = (DKGTimeline::Phase) i;
+        Metrics::renderSample(out, "sgxwallet_dkg_phase_db_seconds_total",
+                              string("phase=\"") + DKGTimeline::getName(phase) + "\"",
+                              DKGTimeline::getTotalDbUs(phase) / 1e6);
+    }
+    renderGauge(out, "sgxwallet_dkg_timeline_sessions", "Poly names kept in the DKG timeline",
+                DKGTimeline::getNumSessions());
+
+    renderCounter(out, "sgxwallet_bls_sign_cache_hits_total", "BLS sign requests answered from the result cache",
+                  SGXWalletServer::getBlsSignCacheHits());
+    renderCounter(out, "sgxwallet_bls_sign_coalesced_total", "BLS sign requests that waited for an identical one",
+                  SGXWalletServer::getBlsSignCoalesced());
+    renderGauge(out, "sgxwallet_bls_sign_cache_entries", "BLS sign results kept or being computed",
+                SGXWalletServer::getBlsSignCacheSize());
+    renderCounter(out, "sgxwallet_ecdsa_sign_cache_hits_total", "ECDSA sign requests answered from the result cache",
+                  SGXWalletServer::getEcdsaSignCacheHits());
+    renderCounter(out, "sgxwallet_ecdsa_sign_coalesced_total", "ECDSA sign requests that waited for an identical one",
+                  SGXWalletServer::getEcdsaSignCoalesced());
+    renderCounter(out, "sgxwallet_bls_public_keys_cache_hits_total",
+                  "calculateAllBLSPublicKeys requests answered from the result cache",
+                  SGXWalletServer::getBlsPublicKeysCacheHits());
+    renderCounter(out, "sgxwallet_bls_public_keys_coalesced_total",
+                  "calculateAllBLSPublicKeys requests that waited for an identical one",
+                  SGXWalletServer::getBlsPublicKeysCoalesced());
+    renderCounter(out, "sgxwallet_decryption_share_cache_hits_total",
+                  "Decryption shares answered from the share cache", Metrics::getCounter("decryptionShareCacheHits").get());
+    renderCounter(out, "sgxwallet_decryption_value_cache_hits_total",
+                  "Public decryption values that were not parsed and checked again",
+                  Metrics::getCounter("decryptionValueCacheHits").get());
+    renderCounter(out, "sgxwallet_bls_sign_batches_total", "Batch ECALLs that signed concurrent BLS sign requests",
+                  Metrics::getCounter("blsSignBatches").get());
+    renderCounter(out, "sgxwallet_bls_batched_sign_requests_total", "BLS sign requests signed in such batches",
+                  Metrics::getCounter("blsBatchedSignRequests").get());
+    renderCounter(out, "sgxwallet_ecdsa_sign_batches_total", "Batch ECALLs that signed concurrent ECDSA sign requests",
+                  Metrics::getCounter("ecdsaSignBatches").get());
+    renderCounter(out, "sgxwallet_ecdsa_batched_sign_requests_total", "ECDSA sign requests signed in such batches",
+                  Metrics::getCounter("ecdsaBatchedSignRequests").get());
+
+    renderCounter(out, "sgxwallet_http_requests_total", "HTTP JSON-RPC requests", SGXWalletServer::getHttpRequests());
+    renderCounter(out, "sgxwallet_http_calls_total", "HTTP JSON-RPC calls, counting batch elements",
+                  SGXWalletServer::getHttpCalls());
+    renderCounter(out, "sgxwallet_http_rejected_total", "HTTP JSON-RPC requests rejected as busy",
+                  SGXWalletServer::getHttpRejected());
+    renderCounter(out, "sgxwallet_http_rate_limited_total", "HTTP JSON-RPC requests over the client rate limit",
+                  SGXWalletServer::getHttpRateLimited());
+    renderGauge(out, "sgxwallet_https_ktls_enabled", "1 if GnuTLS was configured to use kernel TLS",
+                KernelTLS::isEnabled() ? 1 : 0);
+    renderCounter(out, "sgxwallet_https_ktls_requests_total", "Event https requests on kernel TLS sessions",
+                  KernelTLS::getRequests());
+
+    auto &cache = LevelDB::getLevelDb()->getCache();
+    renderCounter(out, "sgxwallet_db_cache_hits_total", "LevelDB cache hits", cache.getHits());
+    renderCounter(out, "sgxwallet_db_cache_misses_total", "LevelDB cache misses", cache.getMisses());
+    renderCounter(out, "sgxwallet_db_cache_evictions_total", "LevelDB cache evictions", cache.getEvictions());
+    renderCounter(out, "sgxwallet_db_cache_admission_rejects_total",
+                  "LevelDB values not cached because the cache held more frequently read keys",
+                  cache.getAdmissionRejects());
+    renderGauge(out, "sgxwallet_db_cache_entries", "LevelDB cache entries", cache.size());
+    renderGauge(out, "sgxwallet_db_cache_bytes", "LevelDB cache size in bytes", cache.sizeInBytes());
+    renderCounter(out, "sgxwallet_db_syncs_total", "Disk syncs of key writes", Metrics::getCounter("leveldbSyncs").get());
+    renderCounter(out, "sgxwallet_db_synced_writes_total", "Key writes made durable by these syncs",
+                  Metrics::getCounter("leveldbSyncedWrites").get());
+
+    renderGauge(out, "sgxwallet_ecalls_in_flight", "ECALLs currently inside the enclave",
+                Metrics::getEcallsInFlight());
+    renderGauge(out, "sgxwallet_ecalls_in_flight_peak", "Most ECALLs in flight during the last sampler interval",
+                Metrics::getPeakEcallsInFlight());
+    renderGauge(out, "sgxwallet_enclave_tcs", "Enclave thread control structures of all enclave instances",
+                ENCLAVE_TCS_NUM * getEnclaveShards());
+    renderGauge(out, "sgxwallet_ecall_gate_bound_threads", "Host threads bound to a TCS", EcallGate::getBound());
+    renderGauge(out, "sgxwallet_ecall_gate_waiting", "Host threads waiting for a free TCS", EcallGate::getWaiting());
+    Metrics::renderHeader(out, "sgxwallet_all_ecalls_seconds", "histogram", "Round trip time of all timed ECALLs");
+    Metrics::renderHistogram(out, "sgxwallet_all_ecalls_seconds", "", Metrics::getAllEcallsLatency());
+
+    renderGauge(out, "sgxwallet_ecdsa_nonce_pool_size", "Precomputed ECDSA nonces in the enclave",
+                ECDSANoncePool::getPoolSize());
+    renderGauge(out, "sgxwallet_ecdsa_key_pool_size", "Pregenerated encrypted ECDSA keys on the host",
+                ECDSAKeyPool::getPoolSize());
+    renderGauge(out, "sgxwallet_ecdsa_enclave_key_pool_size", "Pregenerated ECDSA key pairs in the enclave",
+                ECDSAKeyPool::getEnclavePoolSize());
+    renderCounter(out, "sgxwallet_replicated_keys_total", "Keys a cluster follower copied from the leader",
+                  KeyStoreReplicator::getKeysReplicated());
+    renderCounter(out, "sgxwallet_replication_errors_total", "Failed key store replication passes",
+                  KeyStoreReplicator::getErrors());
+    renderGauge(out, "sgxwallet_replication_lag_seconds", "Seconds since the follower was last in sync with the leader",
+                KeyStoreReplicator::getLagSeconds());
+    renderGauge(out, "sgxwallet_sek_rotation_in_progress", "One while a SEK rotation is in progress",
+                SEKRotation::isInProgress() ? 1 : 0);
+    renderCounter(out, "sgxwallet_sek_rotation_values_scanned_total", "Sealed value candidates sent to the enclave",
+                  SEKRotation::getValuesScanned());
+    renderCounter(out, "sgxwallet_sek_rotation_values_resealed_total", "Values resealed under the new SEK",
+                  SEKRotation::getValuesResealed());
+    renderCounter(out, "sgxwallet_sek_rotation_passes_total", "Passes over the database by SEK rotations",
+                  SEKRotation::getPasses());
+    renderCounter(out, "sgxwallet_sek_rotation_errors_total", "Values or passes a SEK rotation failed on",
+                  SEKRotation::getErrors());
+    renderCounter(out, "sgxwallet_dkg_gc_keys_deleted_total", "DKG intermediates deleted by garbage collection",
+                  DKGGarbageCollector::getKeysDeleted());
+
+    renderGauge(out, "sgxwallet_memory_budget_bytes", "Memory sgxwallet may use", MemoryBudget::getBudgetBytes());
+    renderGauge(out, "sgxwallet_memory_pressure", "1 while caches are shrunk and fewer requests are admitted",
+                MemoryBudget::isUnderPressure());
+    renderCounter(out, "sgxwallet_memory_shrinks_total", "Samples that shrank the caches",
+                  MemoryBudget::getShrinks());
+    Metrics::renderHeader(out, "sgxwallet_memory_consumer_bytes", "gauge", "Approximate memory held by each cache");
+    for (auto &&consumer : MemoryBudget::getConsumerBytes()) {
+        Metrics::renderSample(out, "sgxwallet_memory_consumer_bytes", "consumer=\"" + consumer.first + "\"",
+                              consumer.second);
+    }
+
+    Metrics::renderHeader(out, "sgxwallet_zmq_bls_sign_seconds", "histogram",
+                          "Time from receipt of a ZMQ BLS sign request to its queued reply");
+    Metrics::renderHistogram(out, "sgxwallet_zmq_bls_sign_seconds", "", LatencySLO::getSignLatency());
+    Metrics::renderHeader(out, "sgxwallet_slo_target_seconds", "gauge", "p99 objective of the ZMQ BLS sign latency, 0 if off");
+    Metrics::renderSample(out, "sgxwallet_slo_target_seconds", "", LatencySLO::getTargetUs() / 1e6);
+    Metrics::renderHeader(out, "sgxwallet_slo_bls_sign_p99_seconds", "gauge",
+                          "p99 of the ZMQ BLS sign latency over the objective window");
+    Metrics::renderSample(out, "sgxwallet_slo_bls_sign_p99_seconds", "", LatencySLO::getP99Us() / 1e6);
+    Metrics::renderHeader(out, "sgxwallet_slo_burn_rate", "gauge",
+                          "Rate the error budget of the objective is used at, above 1 it runs out");
+    Metrics::renderSample(out, "sgxwallet_slo_burn_rate", "", LatencySLO::getBurnRate());
+    renderGauge(out, "sgxwallet_slo_at_risk", "1 while low priority work is shed or deferred",
+                LatencySLO::isAtRisk());
+    renderCounter(out, "sgxwallet_slo_degradations_total", "Times the objective came at risk",
+                  LatencySLO::getDegradations());
+    renderCounter(out, "sgxwallet_slo_shed_total", "Low priority calls failed while the objective was at risk",
+                  LatencySLO::getShed());
+    renderCounter(out, "sgxwallet_slo_deferred_total", "Background work rounds deferred while the objective was at risk",
+                  LatencySLO::getDeferred());
+
+    return out;
+}
+
+static MHDResult handleRequest(void *, MHD_Connection *_connection, const char *_url, const char *_method,
+                               const char *, const char *, size_t *, void **) {
+    string page;
+    unsigned int status = MHD_HTTP_OK;
+    const char *contentType = "text/plain; version=0.0.4; charset=utf-8";
+
+    if (strcmp(_method, "GET") != 0) {
+        status = MHD_HTTP_METHOD_NOT_ALLOWED;
+    } else if (strcmp(_url, "/live") == 0) {
+        // answered by the daemon thread, so a hung request queue does not fail liveness
+        page = "OK\n";
+    } else if (strcmp(_url, "/ready") == 0) {
+        if (!Readiness::isReady()) {
+            status = MHD_HTTP_SERVICE_UNAVAILABLE;
+        }
+        Json::FastWriter writer;
+        page = writer.write(Readiness::getStatus());
+        contentType = "application/json";
+    } else if (strcmp(_url, "/metrics") != 0) {
+        status = MHD_HTTP_NOT_FOUND;
+    } else {
+        try {
+            page = MetricsServer::render();
+        } catch (exception &e) {
+            spdlog::error("Could not render metrics: {}", e.what());
+            status = MHD_HTTP_INTERNAL_SERVER_ERROR;
+            page.clear();
+        }
+    }
+
+    auto response = MHD_create_response_from_buffer(page.size(), (void *) page.data(), MHD_RESPMEM_MUST_COPY);
+    if (!response) {
+        return MHD_NO;
+    }
+
+    MHD_add_response_header(response, "Content-Type", contentType);
+    auto result = MHD_queue_response(_connection, status, response);
+    MHD_destroy_response(response);
+
+    return result;
+}
+
+void MetricsServer::initMetricsServer() {
+    if (!enabled) {
+        return;
+    }
+
+    CHECK_STATE(!daemon);
+
+    spdlog::info("Starting metrics server on port {} ...", BASE_PORT + 6);
+
+    daemon = MHD_start_daemon(MHD_USE_SELECT_INTERNALLY, BASE_PORT + 6, nullptr, nullptr, &handleRequest, nullptr,
+                              MHD_OPTION_END);
+
+    if (!daemon) {
+        spdlog::error("Metrics server could not start listening on port {}", BASE_PORT + 6);
+        throw SGXException(SGX_METRICS_SERVER_FAILED_TO_START, "Metrics server could not start listening.");
+    }
+
+    spdlog::info("Metrics server started on port {}", BASE_PORT + 6);
+}
+
+void MetricsServer::exitMetricsServer() {
+    if (daemon) {
+        MHD_stop_daemon(daemon);
+        daemon = nullptr;
+        spdlog::info("Metrics server stopped");
+    }
+}
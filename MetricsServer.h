@@ -0,0 +1,57 @@
+/*
+    Copyright (C) 2021-Present SKALE Labs
+
+    This file is part of sgxwallet.
+
+    sgxwallet is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as published
+    by the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    sgxwallet is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with sgxwallet. If not, see <https://www.gnu.org/licenses/>.
+
+    @file MetricsServer.h
+    @author Stan Kladko
+    @date 2021
+*/
+
+#ifndef SGXWALLET_METRICSSERVER_H
+#define SGXWALLET_METRICSSERVER_H
+
+#include <string>
+
+using namespace std;
+
+struct MHD_Daemon;
+
+// Plain HTTP endpoint on METRICS_PORT that serves GET /metrics in the Prometheus text format, and
+// the GET /live and GET /ready probes, see Readiness.h.
+// Exports the Metrics registry together with ZMQ queue depths, cache statistics and other
+// counters kept by the individual modules. Disabled unless enabled with sgxwallet -M.
+class MetricsServer {
+
+    static bool enabled;
+
+    static MHD_Daemon *daemon;
+
+public:
+
+    static void setEnabled(bool _enabled) { enabled = _enabled; }
+
+    static bool isEnabled() { return enabled; }
+
+    // the /metrics page
+    static string render();
+
+    static void initMetricsServer();
+
+    static void exitMetricsServer();
+};
+
+#endif //SGXWALLET_METRICSSERVER_H
@@ -0,0 +1,356 @@
+/*
+    Copyright (C) 2021-Present SKALE Labs
+
+    This file is part of sgxwallet.
+
+    sgxwallet is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as published
+    by the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    sgxwallet is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with sgxwallet. If not, see <https://www.gnu.org/licenses/>.
+
+    @file MockEnclave.cpp
+    @author Stan Kladko
+    @date 2021
+*/
+
+
+#include <chrono>
+#include <cstring>
+#include <string>
+
+#include <gmp.h>
+#include <openssl/rand.h>
+
+#include "libff/algebra/curves/alt_bn128/alt_bn128_init.hpp"
+#include <tools/utils.h>
+
+#include "sgxwallet_common.h"
+#include "third_party/spdlog/spdlog.h"
+
+#include "MockEnclave.h"
+
+// output buffer length of the key ECALLs in secure_enclave.edl
+#define MOCK_SMALL_BUF_SIZE 1024
+#define MOCK_ECDSA_KEY_LEN 32
+
+// the secp256k1 generator and group order, the public key and r of every mocked ECDSA signature
+static const char *SECP256K1_GX = "79be667ef9dcbbac55a06295ce870b07029bfcdb2dce28d959f2815b16f81798";
+static const char *SECP256K1_GY = "483ada7726a3c4655da4fbfc0e1108a8fd17b448a68554199c47d08ffb10d4b8";
+static const char *SECP256K1_N = "fffffffffffffffffffffffffffffffebaaedce6af48a03bbfd25e8cd0364141";
+
+atomic<uint64_t> MockEnclave::latencyUs(0);
+
+bool MockEnclave::isEnabled() {
+#ifdef SGXWALLET_MOCK_ENCLAVE
+    return true;
+#else
+    return false;
+#endif
+}
+
+void MockEnclave::spin(uint64_t _units) {
+    uint64_t latency = latencyUs;
+
+    if (latency == 0) {
+        return;
+    }
+
+    auto end = chrono::steady_clock::now() + chrono::microseconds(latency * _units);
+
+    while (chrono::steady_clock::now() < end) {
+    }
+}
+
+sgx_status_t MockEnclave::unsupported(const char *_name) {
+    spdlog::error("{} is not supported by the mock enclave", _name);
+    return SGX_ERROR_FEATURE_NOT_SUPPORTED;
+}
+
+static void setError(int *_errStatus, char *_errString, const string &_msg) {
+    *_errStatus = -1;
+    strncpy(_errString, _msg.c_str(), ERR_STRING_LEN - 1);
+    _errString[ERR_STRING_LEN - 1] = 0;
+}
+
+// the secret key is 1 and so is the nonce, so r is the x of the generator and s = hash + r,
+// normalized to the lower half of the group order as the enclave does
+static bool mockEcdsaSign(const char *_hash, uint64_t *_sigR, uint64_t *_sigS, uint8_t *_sigV) {
+    mpz_t msg, r, s, n, halfN;
+    mpz_inits(msg, r, s, n, halfN, NULL);
+
+    bool result = mpz_set_str(msg, _hash, 16) == 0;
+
+    if (result) {
+        mpz_set_str(r, SECP256K1_GX, 16);
+        mpz_set_str(n, SECP256K1_N, 16);
+        mpz_add(s, msg, r);
+        mpz_mod(s, s, n);
+
+        // the y of the generator is even
+        mpz_mul_ui(halfN, s, 2);
+        *_sigV = mpz_cmp(halfN, n) > 0 ? 1 : 0;
+
+        mpz_cdiv_q_ui(halfN, n, 2);
+        if (mpz_cmp(s, halfN) > 0) {
+            mpz_sub(s, n, s);
+        }
+
+        memset(_sigR, 0, ECDSA_SIG_LIMBS * sizeof(uint64_t));
+        memset(_sigS, 0, ECDSA_SIG_LIMBS * sizeof(uint64_t));
+        mpz_export(_sigR, NULL, -1, sizeof(uint64_t), 0, 0, r);
+        mpz_export(_sigS, NULL, -1, sizeof(uint64_t), 0, 0, s);
+    }
+
+    mpz_clears(msg, r, s, n, halfN, NULL);
+
+    return result;
+}
+
+static void mockRandomKey(uint8_t *_encryptedKey, uint64_t *_encLen) {
+    RAND_bytes(_encryptedKey, MOCK_ECDSA_KEY_LEN);
+    *_encLen = MOCK_ECDSA_KEY_LEN;
+}
+
+sgx_status_t MockEnclave::trustedEnclaveInit(sgx_enclave_id_t, uint64_t) {
+    spdlog::warn("Running with the mock enclave, signatures are made with the key 1");
+    return SGX_SUCCESS;
+}
+
+sgx_status_t MockEnclave::trustedPrecomputeTables(sgx_enclave_id_t) {
+    return SGX_SUCCESS;
+}
+
+sgx_status_t MockEnclave::trustedFlushLog(sgx_enclave_id_t, uint64_t *_gmpHeapBytes, uint64_t *_gmpHeapPeakBytes) {
+    *_gmpHeapBytes = 0;
+    *_gmpHeapPeakBytes = 0;
+    return SGX_SUCCESS;
+}
+
+sgx_status_t MockEnclave::trustedSetVerifyEncryption(sgx_enclave_id_t, uint8_t) {
+    return SGX_SUCCESS;
+}
+
+sgx_status_t MockEnclave::trustedWarmUpThread(sgx_enclave_id_t) {
+    return SGX_SUCCESS;
+}
+
+sgx_status_t MockEnclave::trustedWarmUpKey(sgx_enclave_id_t, int *_errStatus, char *, uint8_t *, uint64_t) {
+    *_errStatus = 0;
+    return SGX_SUCCESS;
+}
+
+sgx_status_t MockEnclave::trustedGenerateSEK(sgx_enclave_id_t, int *_errStatus, char *, uint8_t *_encryptedSEK,
+                                             uint64_t *_encLen, char *_hexSEK) {
+    uint8_t sek[16];
+    RAND_bytes(sek, sizeof(sek));
+
+    for (uint64_t i = 0; i < sizeof(sek); i++) {
+        snprintf(_hexSEK + 2 * i, 3, "%02x", sek[i]);
+    }
+
+    memcpy(_encryptedSEK, _hexSEK, 2 * sizeof(sek) + 1);
+    *_encLen = 2 * sizeof(sek) + 1;
+    *_errStatus = 0;
+    return SGX_SUCCESS;
+}
+
+sgx_status_t MockEnclave::trustedSetSEK(sgx_enclave_id_t, int *_errStatus, char *, uint8_t *) {
+    *_errStatus = 0;
+    return SGX_SUCCESS;
+}
+
+sgx_status_t MockEnclave::trustedSetSEKBackup(sgx_enclave_id_t, int *_errStatus, char *, uint8_t *_encryptedSEK,
+                                              uint64_t *_encLen, const char *_hexSEK) {
+    uint64_t len = strnlen(_hexSEK, MOCK_SMALL_BUF_SIZE - 1);
+    memcpy(_encryptedSEK, _hexSEK, len + 1);
+    *_encLen = len + 1;
+    *_errStatus = 0;
+    return SGX_SUCCESS;
+}
+
+sgx_status_t MockEnclave::trustedEncryptKey(sgx_enclave_id_t, int *_errStatus, char *, const char *_key,
+                                            uint8_t *_encryptedKey, uint64_t *_encLen) {
+    spin();
+
+    uint64_t len = strnlen(_key, MOCK_SMALL_BUF_SIZE - 1);
+    memcpy(_encryptedKey, _key, len + 1);
+    *_encLen = len + 1;
+    *_errStatus = 0;
+    return SGX_SUCCESS;
+}
+
+sgx_status_t MockEnclave::trustedDecryptKey(sgx_enclave_id_t, int *_errStatus, char *_errString,
+                                            uint8_t *_encryptedKey, uint64_t _encLen, char *_key) {
+    spin();
+
+    if (_encLen == 0 || _encLen > MOCK_SMALL_BUF_SIZE) {
+        setError(_errStatus, _errString, "invalid encrypted key length");
+        return SGX_SUCCESS;
+    }
+
+    memcpy(_key, _encryptedKey, _encLen);
+    _key[_encLen - 1] = 0;
+    *_errStatus = 0;
+    return SGX_SUCCESS;
+}
+
+sgx_status_t MockEnclave::trustedGenerateEcdsaKey(sgx_enclave_id_t, int *_errStatus, char *, int *,
+                                                  uint8_t *_encryptedKey, uint64_t *_encLen, char *_pubKeyX,
+                                                  char *_pubKeyY) {
+    spin();
+
+    mockRandomKey(_encryptedKey, _encLen);
+    strncpy(_pubKeyX, SECP256K1_GX, MOCK_SMALL_BUF_SIZE);
+    strncpy(_pubKeyY, SECP256K1_GY, MOCK_SMALL_BUF_SIZE);
+    *_errStatus = 0;
+    return SGX_SUCCESS;
+}
+
+sgx_status_t MockEnclave::trustedGetPublicEcdsaKey(sgx_enclave_id_t, int *_errStatus, char *, uint8_t *, uint64_t,
+                                                   char *_pubKeyX, char *_pubKeyY) {
+    spin();
+
+    strncpy(_pubKeyX, SECP256K1_GX, ECDSA_PUB_KEY_COORD_LEN);
+    strncpy(_pubKeyY, SECP256K1_GY, ECDSA_PUB_KEY_COORD_LEN);
+    *_errStatus = 0;
+    return SGX_SUCCESS;
+}
+
+sgx_status_t MockEnclave::trustedEcdsaSign(sgx_enclave_id_t, int *_errStatus, char *_errString, uint8_t *, uint64_t,
+                                           const char *_hash, uint64_t *_sigR, uint64_t *_sigS, uint8_t *_sigV) {
+    spin();
+
+    if (!mockEcdsaSign(_hash, _sigR, _sigS, _sigV)) {
+        setError(_errStatus, _errString, "invalid message hash");
+        return SGX_SUCCESS;
+    }
+
+    *_errStatus = 0;
+    return SGX_SUCCESS;
+}
+
+sgx_status_t MockEnclave::trustedEcdsaSignBatch(sgx_enclave_id_t, int *_errStatus, char *_errString, uint8_t *,
+                                                uint64_t, uint64_t _numHashes, const char *_hashes,
+                                                uint64_t _hashesLen, uint64_t *_sigsR, uint64_t *_sigsS,
+                                                uint64_t _sigsLen, uint8_t *_sigsV) {
+    if (_numHashes == 0 || _numHashes > MAX_ECDSA_SIGN_BATCH_SIZE ||
+        _hashesLen != _numHashes * ECDSA_BATCH_HASH_SLOT_LEN ||
+        _sigsLen != _numHashes * ECDSA_SIG_LIMBS * sizeof(uint64_t)) {
+        setError(_errStatus, _errString, "invalid batch");
+        return SGX_SUCCESS;
+    }
+
+    spin(_numHashes);
+
+    for (uint64_t i = 0; i < _numHashes; i++) {
+        if (_hashes[(i + 1) * ECDSA_BATCH_HASH_SLOT_LEN - 1] != 0 ||
+            !mockEcdsaSign(_hashes + i * ECDSA_BATCH_HASH_SLOT_LEN, _sigsR + i * ECDSA_SIG_LIMBS,
+                           _sigsS + i * ECDSA_SIG_LIMBS, _sigsV + i)) {
+            setError(_errStatus, _errString, "invalid message hash " + to_string(i));
+            return SGX_SUCCESS;
+        }
+    }
+
+    *_errStatus = 0;
+    return SGX_SUCCESS;
+}
+
+sgx_status_t MockEnclave::trustedRefillEcdsaNoncePool(sgx_enclave_id_t, int *_errStatus, char *, uint64_t _count,
+                                                      uint64_t *_poolSize) {
+    *_poolSize = _count;
+    *_errStatus = 0;
+    return SGX_SUCCESS;
+}
+
+sgx_status_t MockEnclave::trustedRefillEcdsaKeyPool(sgx_enclave_id_t, int *_errStatus, char *, uint64_t _count,
+                                                    uint64_t *_poolSize) {
+    *_poolSize = _count;
+    *_errStatus = 0;
+    return SGX_SUCCESS;
+}
+
+sgx_status_t MockEnclave::trustedGenerateBLSKey(sgx_enclave_id_t, int *_errStatus, char *, int *,
+                                                uint8_t *_encryptedKey, uint64_t *_encLen) {
+    spin();
+
+    mockRandomKey(_encryptedKey, _encLen);
+    *_errStatus = 0;
+    return SGX_SUCCESS;
+}
+
+// the G2 generator in the X.c0:X.c1:Y.c0:Y.c1 form of the enclave
+static const string &mockBlsPubKey() {
+    static const string pubKey = []() {
+        auto g2 = libff::alt_bn128_G2::one();
+        g2.to_affine_coordinates();
+        return libBLS::ThresholdUtils::fieldElementToString(g2.X.c0) + ":" +
+               libBLS::ThresholdUtils::fieldElementToString(g2.X.c1) + ":" +
+               libBLS::ThresholdUtils::fieldElementToString(g2.Y.c0) + ":" +
+               libBLS::ThresholdUtils::fieldElementToString(g2.Y.c1);
+    }();
+    return pubKey;
+}
+
+sgx_status_t MockEnclave::trustedGenerateBLSKeyBatch(sgx_enclave_id_t, int *_errStatus, char *, uint64_t _numKeys,
+                                                     uint8_t *_encryptedKeys, uint64_t, uint64_t *_encLens,
+                                                     char *_blsPubKeys, uint64_t) {
+    spin(_numKeys);
+
+    for (uint64_t i = 0; i < _numKeys; i++) {
+        mockRandomKey(_encryptedKeys + i * BLS_BATCH_KEY_SLOT_LEN, &_encLens[i]);
+        strncpy(_blsPubKeys + i * BLS_KEY_BATCH_PUB_KEY_SLOT_LEN, mockBlsPubKey().c_str(),
+                BLS_KEY_BATCH_PUB_KEY_SLOT_LEN);
+    }
+    *_errStatus = 0;
+    return SGX_SUCCESS;
+}
+
+sgx_status_t MockEnclave::trustedGetBlsPubKey(sgx_enclave_id_t, int *_errStatus, char *, uint8_t *, uint64_t,
+                                              char *_blsPubKey) {
+    spin();
+
+    strncpy(_blsPubKey, mockBlsPubKey().c_str(), 320);
+    *_errStatus = 0;
+    return SGX_SUCCESS;
+}
+
+sgx_status_t MockEnclave::trustedBlsSignMessage(sgx_enclave_id_t, int *_errStatus, char *, uint8_t *, uint64_t,
+                                                uint64_t *_hash, uint64_t *_signature) {
+    spin();
+
+    memcpy(_signature, _hash, BLS_G1_LIMBS * sizeof(uint64_t));
+    *_errStatus = 0;
+    return SGX_SUCCESS;
+}
+
+sgx_status_t MockEnclave::trustedBlsSignMessageBatch(sgx_enclave_id_t, int *_errStatus, char *_errString,
+                                                     uint64_t _numKeys, uint8_t *, uint64_t, uint64_t *,
+                                                     uint64_t _numHashes, uint32_t *_keyIndexes, uint64_t *_hashes,
+                                                     uint64_t _hashesLen, uint64_t *_signatures, uint64_t _sigsLen) {
+    if (_numKeys == 0 || _numKeys > _numHashes || _numHashes > MAX_BLS_SIGN_BATCH_SIZE ||
+        _hashesLen != _numHashes * BLS_G1_LIMBS || _sigsLen != _numHashes * BLS_G1_LIMBS) {
+        setError(_errStatus, _errString, "invalid batch");
+        return SGX_SUCCESS;
+    }
+
+    for (uint64_t i = 0; i < _numHashes; i++) {
+        if (_keyIndexes[i] >= _numKeys) {
+            setError(_errStatus, _errString, "invalid key index");
+            return SGX_SUCCESS;
+        }
+    }
+
+    spin(_numHashes);
+
+    memcpy(_signatures, _hashes, _sigsLen * sizeof(uint64_t));
+    *_errStatus = 0;
+    return SGX_SUCCESS;
+}
@@ -0,0 +1,164 @@
+/*
+    Copyright (C) 2021-Present SKALE Labs
+
+    This file is part of sgxwallet.
+
+    sgxwallet is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as published
+    by the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    sgxwallet is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with sgxwallet. If not, see <https://www.gnu.org/licenses/>.
+
+    @file MockEnclave.h
+    @author Stan Kladko
+    @date 2021
+*/
+
+
+#ifndef SGXWALLET_MOCKENCLAVE_H
+#define SGXWALLET_MOCKENCLAVE_H
+
+#include <atomic>
+#include <cstdint>
+
+#include <sgx_eid.h>
+#include <sgx_error.h>
+
+using namespace std;
+
+// In-process stand-in for the ECALLs of secure_enclave.edl, for profiling the host pipeline
+// (transports, parsing, batching, database, serialization) without the enclave. Built with
+// make MOCK_ENCLAVE=1, which routes the ECALL macro of Metrics.h here and skips enclave creation.
+//
+// Every mocked key is the secret key 1: BLS signatures are the hashed points themselves and the
+// public key is the G2 generator, ECDSA signatures use the nonce 1 and the public key is the
+// secp256k1 generator. Signatures verify, but they are worthless, never run this build with
+// real keys. "Encryption" is the identity.
+//
+// Each mocked ECALL busy waits for the configured latency, once per signature for the batch
+// ECALLs, so the worker thread holds its CPU as it does inside the enclave. ECALLs that the
+// signing pipeline does not use, DKG, SEK rotation and threshold decryption, fail with
+// SGX_ERROR_FEATURE_NOT_SUPPORTED.
+class MockEnclave {
+
+    static atomic<uint64_t> latencyUs;
+
+    static void spin(uint64_t _units = 1);
+
+    static sgx_status_t unsupported(const char *_name);
+
+public:
+
+    static void setLatencyUs(uint64_t _latencyUs) { latencyUs = _latencyUs; }
+
+    static uint64_t getLatencyUs() { return latencyUs; }
+
+    static bool isEnabled();
+
+    static sgx_status_t trustedEnclaveInit(sgx_enclave_id_t _eid, uint64_t _logLevel);
+
+    static sgx_status_t trustedPrecomputeTables(sgx_enclave_id_t _eid);
+
+    static sgx_status_t trustedFlushLog(sgx_enclave_id_t _eid, uint64_t *_gmpHeapBytes, uint64_t *_gmpHeapPeakBytes);
+
+    static sgx_status_t trustedSetVerifyEncryption(sgx_enclave_id_t _eid, uint8_t _verify);
+
+    static sgx_status_t trustedWarmUpThread(sgx_enclave_id_t _eid);
+
+    static sgx_status_t trustedWarmUpKey(sgx_enclave_id_t _eid, int *_errStatus, char *_errString,
+                                         uint8_t *_encryptedKey, uint64_t _encLen);
+
+    static sgx_status_t trustedGenerateSEK(sgx_enclave_id_t _eid, int *_errStatus, char *_errString,
+                                           uint8_t *_encryptedSEK, uint64_t *_encLen, char *_hexSEK);
+
+    static sgx_status_t trustedSetSEK(sgx_enclave_id_t _eid, int *_errStatus, char *_errString,
+                                      uint8_t *_encryptedSEK);
+
+    static sgx_status_t trustedSetSEKBackup(sgx_enclave_id_t _eid, int *_errStatus, char *_errString,
+                                            uint8_t *_encryptedSEK, uint64_t *_encLen, const char *_hexSEK);
+
+    static sgx_status_t trustedEncryptKey(sgx_enclave_id_t _eid, int *_errStatus, char *_errString, const char *_key,
+                                          uint8_t *_encryptedKey, uint64_t *_encLen);
+
+    static sgx_status_t trustedDecryptKey(sgx_enclave_id_t _eid, int *_errStatus, char *_errString,
+                                          uint8_t *_encryptedKey, uint64_t _encLen, char *_key);
+
+    static sgx_status_t trustedGenerateEcdsaKey(sgx_enclave_id_t _eid, int *_errStatus, char *_errString,
+                                                int *_isExportable, uint8_t *_encryptedKey, uint64_t *_encLen,
+                                                char *_pubKeyX, char *_pubKeyY);
+
+    static sgx_status_t trustedGetPublicEcdsaKey(sgx_enclave_id_t _eid, int *_errStatus, char *_errString,
+                                                 uint8_t *_encryptedKey, uint64_t _encLen, char *_pubKeyX,
+                                                 char *_pubKeyY);
+
+    static sgx_status_t trustedEcdsaSign(sgx_enclave_id_t _eid, int *_errStatus, char *_errString,
+                                         uint8_t *_encryptedKey, uint64_t _encLen, const char *_hash,
+                                         uint64_t *_sigR, uint64_t *_sigS, uint8_t *_sigV);
+
+    static sgx_status_t trustedEcdsaSignBatch(sgx_enclave_id_t _eid, int *_errStatus, char *_errString,
+                                              uint8_t *_encryptedKey, uint64_t _encLen, uint64_t _numHashes,
+                                              const char *_hashes, uint64_t _hashesLen, uint64_t *_sigsR,
+                                              uint64_t *_sigsS, uint64_t _sigsLen, uint8_t *_sigsV);
+
+    static sgx_status_t trustedRefillEcdsaNoncePool(sgx_enclave_id_t _eid, int *_errStatus, char *_errString,
+                                                    uint64_t _count, uint64_t *_poolSize);
+
+    static sgx_status_t trustedRefillEcdsaKeyPool(sgx_enclave_id_t _eid, int *_errStatus, char *_errString,
+                                                  uint64_t _count, uint64_t *_poolSize);
+
+    static sgx_status_t trustedGenerateBLSKey(sgx_enclave_id_t _eid, int *_errStatus, char *_errString,
+                                              int *_isExportable, uint8_t *_encryptedKey, uint64_t *_encLen);
+
+    static sgx_status_t trustedGenerateBLSKeyBatch(sgx_enclave_id_t _eid, int *_errStatus, char *_errString,
+                                                   uint64_t _numKeys, uint8_t *_encryptedKeys, uint64_t _encryptedLen,
+                                                   uint64_t *_encLens, char *_blsPubKeys, uint64_t _pubKeysLen);
+
+    static sgx_status_t trustedGetBlsPubKey(sgx_enclave_id_t _eid, int *_errStatus, char *_errString,
+                                            uint8_t *_encryptedKey, uint64_t _keyLen, char *_blsPubKey);
+
+    static sgx_status_t trustedBlsSignMessage(sgx_enclave_id_t _eid, int *_errStatus, char *_errString,
+                                              uint8_t *_encryptedKey, uint64_t _encLen, uint64_t *_hash,
+                                              uint64_t *_signature);
+
+    static sgx_status_t trustedBlsSignMessageBatch(sgx_enclave_id_t _eid, int *_errStatus, char *_errString,
+                                                   uint64_t _numKeys, uint8_t *_encryptedKeys, uint64_t _keysLen,
+                                                   uint64_t *_encLens, uint64_t _numHashes, uint32_t *_keyIndexes,
+                                                   uint64_t *_hashes, uint64_t _hashesLen, uint64_t *_signatures,
+                                                   uint64_t _sigsLen);
+
+#define MOCK_UNSUPPORTED(__ECALL__) \
+    template<typename... Args> \
+    static sgx_status_t __ECALL__(Args...) { return unsupported(#__ECALL__); }
+
+    MOCK_UNSUPPORTED(trustedGenerateRotationSEK)
+    MOCK_UNSUPPORTED(trustedRotateSEK)
+    MOCK_UNSUPPORTED(trustedFinishSEKRotation)
+    MOCK_UNSUPPORTED(trustedReencryptKeysBatch)
+    MOCK_UNSUPPORTED(trustedEncryptKeysBatch)
+    MOCK_UNSUPPORTED(trustedGenDkgSecret)
+    MOCK_UNSUPPORTED(trustedGenDkgSecretBatch)
+    MOCK_UNSUPPORTED(trustedDecryptDkgSecret)
+    MOCK_UNSUPPORTED(trustedGetEncryptedSecretShare)
+    MOCK_UNSUPPORTED(trustedGetEncryptedSecretShareV2)
+    MOCK_UNSUPPORTED(trustedGetEncryptedSecretSharesV2)
+    MOCK_UNSUPPORTED(trustedEraseDkgPoly)
+    MOCK_UNSUPPORTED(trustedGetPublicShares)
+    MOCK_UNSUPPORTED(trustedDkgVerify)
+    MOCK_UNSUPPORTED(trustedDkgShareG2)
+    MOCK_UNSUPPORTED(trustedDkgShareG2Batch)
+    MOCK_UNSUPPORTED(trustedCreateBlsKey)
+    MOCK_UNSUPPORTED(trustedCreateBlsKeyV2)
+    MOCK_UNSUPPORTED(trustedGetDecryptionShare)
+    MOCK_UNSUPPORTED(trustedGetDecryptionShares)
+
+#undef MOCK_UNSUPPORTED
+};
+
+#endif //SGXWALLET_MOCKENCLAVE_H
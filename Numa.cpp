@@ -0,0 +1,128 @@
+/*
+    Copyright (C) 2021-Present SKALE Labs
+
+    This file is part of sgxwallet.
+
+    sgxwallet is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as published
+    by the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    sgxwallet is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with sgxwallet. If not, see <https://www.gnu.org/licenses/>.
+
+    @file Numa.cpp
+    @author Stan Kladko
+    @date 2021
+*/
+
+
+#include <fstream>
+#include <pthread.h>
+#include <sstream>
+
+#include "sgxwallet_common.h"
+#include "third_party/spdlog/spdlog.h"
+
+#include "Numa.h"
+
+bool Numa::enabled = false;
+vector<vector<int>> Numa::nodeCpus;
+thread_local uint64_t Numa::currentNode = 0;
+
+vector<int> Numa::parseCpuList(const string &_list) {
+    vector<int> cpus;
+    stringstream ranges(_list);
+    string range;
+
+    while (getline(ranges, range, ',')) {
+        try {
+            auto dash = range.find('-');
+            int first = stoi(range.substr(0, dash));
+            int last = dash == string::npos ? first : stoi(range.substr(dash + 1));
+            for (int cpu = first; cpu <= last; cpu++) {
+                cpus.push_back(cpu);
+            }
+        } catch (...) {
+            // an empty list, or a trailing newline
+        }
+    }
+
+    return cpus;
+}
+
+void Numa::setEnabled(bool _enabled) {
+    enabled = false;
+    nodeCpus.clear();
+
+    if (!_enabled) {
+        return;
+    }
+
+    ifstream online(NUMA_NODES_DIR "online");
+    string list;
+    getline(online, list);
+
+    for (auto node : parseCpuList(list)) {
+        ifstream cpuList(string(NUMA_NODES_DIR "node") + to_string(node) + "/cpulist");
+        string cpus;
+        getline(cpuList, cpus);
+        auto nodeCpuList = parseCpuList(cpus);
+        // memory only nodes run no threads
+        if (!nodeCpuList.empty()) {
+            nodeCpus.push_back(nodeCpuList);
+        }
+    }
+
+    if (nodeCpus.size() < 2) {
+        spdlog::info("NUMA mode is set, but the machine has {} NUMA nodes with CPUs, it has no effect",
+                     nodeCpus.size());
+        nodeCpus.clear();
+        return;
+    }
+
+    enabled = true;
+    spdlog::info("NUMA mode is set, {} nodes", nodeCpus.size());
+}
+
+uint64_t Numa::getNumNodes() {
+    return enabled ? nodeCpus.size() : 1;
+}
+
+uint64_t Numa::getWorkerNode(uint64_t _worker, uint64_t _numWorkers, uint64_t _numNodes) {
+    if (_numNodes <= 1 || _numWorkers == 0) {
+        return 0;
+    }
+    return (_worker * _numNodes / _numWorkers) % _numNodes;
+}
+
+void Numa::bindCurrentThread(uint64_t _node, int64_t _cpu) {
+    if (!enabled) {
+        return;
+    }
+
+    auto &cpus = nodeCpus.at(_node % nodeCpus.size());
+
+    cpu_set_t cpuSet;
+    CPU_ZERO(&cpuSet);
+
+    if (_cpu >= 0) {
+        CPU_SET(cpus.at(_cpu % cpus.size()), &cpuSet);
+    } else {
+        for (auto cpu : cpus) {
+            CPU_SET(cpu, &cpuSet);
+        }
+    }
+
+    if (pthread_setaffinity_np(pthread_self(), sizeof(cpu_set_t), &cpuSet) != 0) {
+        spdlog::error("Could not bind thread to NUMA node {}", _node);
+        return;
+    }
+
+    currentNode = _node % nodeCpus.size();
+}
@@ -0,0 +1,72 @@
+/*
+    Copyright (C) 2021-Present SKALE Labs
+
+    This file is part of sgxwallet.
+
+    sgxwallet is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as published
+    by the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    sgxwallet is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with sgxwallet. If not, see <https://www.gnu.org/licenses/>.
+
+    @file Numa.h
+    @author Stan Kladko
+    @date 2021
+*/
+
+
+#ifndef SGXWALLET_NUMA_H
+#define SGXWALLET_NUMA_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+// NUMA mode, sgxwallet -r. The ZMQ workers are split into one group per node in contiguous
+// blocks, and each group runs on the CPUs of its node. A client is routed to the sign queues of
+// one node, and an idle worker steals from its own node before it steals across nodes. The
+// LevelDB cache keeps a replica per node, which the threads of the node read and fill, so hot
+// values are allocated by and stay with the node that uses them. Nodes are read from
+// NUMA_NODES_DIR, a machine with one node behaves as if the mode was off.
+class Numa {
+
+    static bool enabled;
+
+    // online CPUs of each node that has CPUs
+    static vector<vector<int>> nodeCpus;
+
+    static thread_local uint64_t currentNode;
+
+public:
+
+    // parses a sysfs cpu list such as "0-3,8-11"
+    static vector<int> parseCpuList(const string &_list);
+
+    static void setEnabled(bool _enabled);
+
+    static bool isEnabled() { return enabled; }
+
+    // 1 unless NUMA mode is on
+    static uint64_t getNumNodes();
+
+    // the node the calling thread was bound to, 0 for threads that were not
+    static uint64_t getCurrentNode() { return currentNode; }
+
+    // node of worker _worker of _numWorkers when they are split over _numNodes nodes
+    static uint64_t getWorkerNode(uint64_t _worker, uint64_t _numWorkers, uint64_t _numNodes);
+
+    // runs the calling thread on the CPUs of _node, or on its _cpu-th CPU if _cpu >= 0,
+    // and makes _node its current node. Does nothing unless NUMA mode is on
+    static void bindCurrentThread(uint64_t _node, int64_t _cpu = -1);
+};
+
+#endif //SGXWALLET_NUMA_H
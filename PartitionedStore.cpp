@@ -0,0 +1,264 @@
+/*
+    Copyright (C) 2021-Present SKALE Labs
+
+    This file is part of sgxwallet.
+
+    sgxwallet is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as published
+    by the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    sgxwallet is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with sgxwallet. If not, see <https://www.gnu.org/licenses/>.
+
+    @file PartitionedStore.cpp
+    @author Stan Kladko
+    @date 2021
+*/
+
+#include <unordered_set>
+
+#include "common.h"
+#include "sgxwallet_common.h"
+
+#include "PartitionedStore.h"
+
+PartitionedStore::PartitionedStore(unique_ptr<KeyValueStore> _hot, unique_ptr<KeyValueStore> _cold,
+                                   const Router &_isCold) :
+        hot(move(_hot)), cold(move(_cold)), isCold(_isCold), hotDirty(false), coldDirty(false) {
+    CHECK_STATE(hot);
+    CHECK_STATE(cold);
+    CHECK_STATE(isCold);
+}
+
+uint64_t PartitionedStore::moveColdKeys() {
+    uint64_t moved = 0;
+    string cursor;
+
+    while (true) {
+        Batch toCold;
+        Batch toDelete;
+        bool more = false;
+
+        hot->scan(cursor, [&](string_view _key, string_view _value) {
+            if (toCold.getOps().size() == LEVELDB_KEYS_PAGE_SIZE) {
+                cursor = string(_key);
+                more = true;
+                return false;
+            }
+            if (isCold(_key)) {
+                toCold.put(string(_key), string(_value));
+                toDelete.del(string(_key));
+            }
+            return true;
+        });
+
+        if (!toCold.empty()) {
+            // a key is only deleted from the hot store once it is durable in the cold one
+            cold->write(toCold);
+            cold->sync();
+            hot->write(toDelete);
+            moved += toCold.getOps().size();
+        }
+
+        if (!more) {
+            break;
+        }
+    }
+
+    if (moved > 0) {
+        hot->sync();
+    }
+
+    return moved;
+}
+
+bool PartitionedStore::get(const string &_key, string &_value) {
+    return route(_key).get(_key, _value);
+}
+
+// each store is read from its own snapshot, like batches are written to each store separately
+vector<shared_ptr<string>> PartitionedStore::getMany(const vector<string> &_keys) {
+    vector<string> hotKeys;
+    vector<string> coldKeys;
+
+    for (auto &&key: _keys) {
+        (isCold(key) ? coldKeys : hotKeys).push_back(key);
+    }
+
+    auto hotValues = hotKeys.empty() ? vector<shared_ptr<string>>() : hot->getMany(hotKeys);
+    auto coldValues = coldKeys.empty() ? vector<shared_ptr<string>>() : cold->getMany(coldKeys);
+
+    vector<shared_ptr<string>> values(_keys.size());
+    uint64_t hotIndex = 0;
+    uint64_t coldIndex = 0;
+    for (uint64_t i = 0; i < _keys.size(); i++) {
+        values[i] = isCold(_keys[i]) ? coldValues.at(coldIndex++) : hotValues.at(hotIndex++);
+    }
+
+    return values;
+}
+
+void PartitionedStore::writeTo(KeyValueStore &_store, atomic<bool> &_dirty, const Batch &_batch) {
+    if (!_batch.empty()) {
+        _store.write(_batch);
+        _dirty = true;
+    }
+}
+
+void PartitionedStore::write(const Batch &_batch) {
+    Batch hotBatch;
+    Batch coldBatch;
+    bool hasHot = false;
+    bool hasCold = false;
+
+    for (auto &&op: _batch.getOps()) {
+        (isCold(op.key) ? hasCold : hasHot) = true;
+    }
+
+    // a batch of one store stays one atomic write
+    if (!hasHot || !hasCold) {
+        writeTo(hasCold ? *cold : *hot, hasCold ? coldDirty : hotDirty, _batch);
+        return;
+    }
+
+    unordered_set<string> putKeys;
+    for (auto &&op: _batch.getOps()) {
+        if (!op.isDelete) {
+            putKeys.insert(op.key);
+        }
+    }
+
+    // deletes of keys the batch does not put are written last, after the puts of both stores
+    // are durable. A crash in between leaves keys that should have been deleted, like DKG
+    // intermediates, instead of losing a key share that should have been written
+    Batch hotDeletes;
+    Batch coldDeletes;
+
+    for (auto &&op: _batch.getOps()) {
+        bool toCold = isCold(op.key);
+        if (op.isDelete && putKeys.count(op.key) == 0) {
+            (toCold ? coldDeletes : hotDeletes).del(op.key);
+        } else if (op.isDelete) {
+            (toCold ? coldBatch : hotBatch).del(op.key);
+        } else {
+            (toCold ? coldBatch : hotBatch).put(op.key, op.value);
+        }
+    }
+
+    writeTo(*hot, hotDirty, hotBatch);
+    writeTo(*cold, coldDirty, coldBatch);
+
+    if (hotDeletes.empty() && coldDeletes.empty()) {
+        return;
+    }
+
+    sync();
+
+    writeTo(*hot, hotDirty, hotDeletes);
+    writeTo(*cold, coldDirty, coldDeletes);
+}
+
+void PartitionedStore::sync() {
+    if (coldDirty.exchange(false)) {
+        cold->sync();
+    }
+
+    if (hotDirty.exchange(false)) {
+        hot->sync();
+    }
+}
+
+bool PartitionedStore::readPage(KeyValueStore &_store, const string &_from, vector<pair<string, string>> &_page) {
+    _store.scan(_from, [&_page](string_view _key, string_view _value) {
+        _page.emplace_back(string(_key), string(_value));
+        return _page.size() < LEVELDB_KEYS_PAGE_SIZE;
+    });
+
+    return _page.size() == LEVELDB_KEYS_PAGE_SIZE;
+}
+
+void PartitionedStore::scan(const string &_from, const Visitor &_visitor) {
+    string cursor = _from;
+
+    while (true) {
+        vector<pair<string, string>> coldPage;
+        auto coldFull = readPage(*cold, cursor, coldPage);
+
+        // the rest of the range is in the hot store only, so it is visited without copies
+        if (coldPage.empty()) {
+            hot->scan(cursor, _visitor);
+            return;
+        }
+
+        vector<pair<string, string>> hotPage;
+        auto hotFull = readPage(*hot, cursor, hotPage);
+
+        // keys after the last key of a full page are not known yet, the next round starts there
+        string limit;
+        bool hasLimit = hotFull || coldFull;
+        if (hotFull) {
+            limit = hotPage.back().first;
+        }
+        if (coldFull && (!hotFull || coldPage.back().first < limit)) {
+            limit = coldPage.back().first;
+        }
+
+        size_t i = 0;
+        size_t j = 0;
+
+        while (i < hotPage.size() || j < coldPage.size()) {
+            bool fromHot = j == coldPage.size() || (i < hotPage.size() && hotPage[i].first < coldPage[j].first);
+            auto &entry = fromHot ? hotPage[i++] : coldPage[j++];
+
+            if (hasLimit && entry.first > limit) {
+                break;
+            }
+
+            if (!_visitor(entry.first, entry.second)) {
+                return;
+            }
+        }
+
+        if (!hasLimit) {
+            return;
+        }
+
+        // the smallest key after limit
+        cursor = limit + '\0';
+    }
+}
+
+bool PartitionedStore::findLast(const string &_before, string &_key) {
+    string hotKey;
+    string coldKey;
+
+    auto inHot = hot->findLast(_before, hotKey);
+    auto inCold = cold->findLast(_before, coldKey);
+
+    if (!inHot && !inCold) {
+        return false;
+    }
+
+    _key = (!inCold || (inHot && hotKey > coldKey)) ? hotKey : coldKey;
+    return true;
+}
+
+uint64_t PartitionedStore::getApproximateSize() {
+    return hot->getApproximateSize() + cold->getApproximateSize();
+}
+
+void PartitionedStore::compact() {
+    hot->compact();
+    cold->compact();
+}
+
+void PartitionedStore::compactRange(const string &_begin, const string &_end) {
+    hot->compactRange(_begin, _end);
+    cold->compactRange(_begin, _end);
+}
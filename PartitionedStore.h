@@ -0,0 +1,95 @@
+/*
+    Copyright (C) 2021-Present SKALE Labs
+
+    This file is part of sgxwallet.
+
+    sgxwallet is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as published
+    by the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    sgxwallet is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with sgxwallet. If not, see <https://www.gnu.org/licenses/>.
+
+    @file PartitionedStore.h
+    @author Stan Kladko
+    @date 2021
+*/
+
+#ifndef SGXWALLET_PARTITIONEDSTORE_H
+#define SGXWALLET_PARTITIONEDSTORE_H
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "KeyValueStore.h"
+
+using namespace std;
+
+// Two stores that look like one. Keys for which isCold is true live in the cold store, all other
+// keys in the hot store, so churn of cold keys does not evict hot keys from the block cache of the
+// hot store or trigger its compactions. Scans merge both stores in key order.
+//
+// A batch with keys of both stores is not atomic across them. Its puts are written first, hot
+// store first, and its other deletes only once the puts are durable, like moveColdKeys does.
+class PartitionedStore : public KeyValueStore {
+
+public:
+
+    typedef function<bool(string_view _key)> Router;
+
+private:
+
+    const unique_ptr<KeyValueStore> hot;
+    const unique_ptr<KeyValueStore> cold;
+    const Router isCold;
+
+    // written since the last sync
+    atomic<bool> hotDirty;
+    atomic<bool> coldDirty;
+
+    KeyValueStore &route(string_view _key) { return isCold(_key) ? *cold : *hot; }
+
+    static void writeTo(KeyValueStore &_store, atomic<bool> &_dirty, const Batch &_batch);
+
+    // copies up to LEVELDB_KEYS_PAGE_SIZE entries from _from on, true if there may be more
+    static bool readPage(KeyValueStore &_store, const string &_from, vector<pair<string, string>> &_page);
+
+public:
+
+    PartitionedStore(unique_ptr<KeyValueStore> _hot, unique_ptr<KeyValueStore> _cold, const Router &_isCold);
+
+    // moves the cold keys that are in the hot store, like all keys of a store that was not
+    // partitioned before, into the cold store. Returns the number of keys moved
+    uint64_t moveColdKeys();
+
+    bool get(const string &_key, string &_value) override;
+
+    vector<shared_ptr<string>> getMany(const vector<string> &_keys) override;
+
+    void write(const Batch &_batch) override;
+
+    void sync() override;
+
+    void scan(const string &_from, const Visitor &_visitor) override;
+
+    bool findLast(const string &_before, string &_key) override;
+
+    uint64_t getApproximateSize() override;
+
+    void compact() override;
+
+    void compactRange(const string &_begin, const string &_end) override;
+};
+
+#endif //SGXWALLET_PARTITIONEDSTORE_H
@@ -0,0 +1,126 @@
+/*
+    Copyright (C) 2021-Present SKALE Labs
+
+    This file is part of sgxwallet.
+
+    sgxwallet is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as published
+    by the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    sgxwallet is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with sgxwallet. If not, see <https://www.gnu.org/licenses/>.
+
+    @file PerfCounters.cpp
+    @author Stan Kladko
+    @date 2021
+*/
+
+
+#include <cerrno>
+#include <cstring>
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include "third_party/spdlog/spdlog.h"
+
+#include "PerfCounters.h"
+
+atomic<bool> PerfCounters::enabled(false);
+atomic<uint64_t> PerfCounters::unavailableThreads(0);
+
+static constexpr int NUM_PERF_COUNTERS = 4;
+
+static int openCounter(uint32_t _type, uint64_t _config, int _groupFd, bool _excludeKernel = true) {
+    struct perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = _type;
+    attr.config = _config;
+    attr.read_format = PERF_FORMAT_GROUP;
+    attr.exclude_kernel = _excludeKernel ? 1 : 0;
+    attr.exclude_hv = 1;
+    attr.disabled = _groupFd == -1 ? 1 : 0;
+    return (int) syscall(__NR_perf_event_open, &attr, 0, -1, _groupFd, 0);
+}
+
+// the counter group of a thread, fds[0] is the group leader
+class ThreadCounters {
+
+public:
+
+    bool opened = false;
+
+    int fds[NUM_PERF_COUNTERS] = {-1, -1, -1, -1};
+
+    // hardware counters count user space only, so that perf_event_paranoid 2 allows them.
+    // Context switches happen in the kernel, so they are only counted where that is allowed
+    bool open() {
+        opened = true;
+
+        fds[0] = openCounter(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES, -1);
+        fds[1] = openCounter(PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS, fds[0]);
+        fds[2] = openCounter(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES, fds[0]);
+        fds[3] = openCounter(PERF_TYPE_SOFTWARE, PERF_COUNT_SW_CONTEXT_SWITCHES, fds[0], false);
+        if (fds[3] < 0) {
+            fds[3] = openCounter(PERF_TYPE_SOFTWARE, PERF_COUNT_SW_CONTEXT_SWITCHES, fds[0]);
+        }
+
+        for (auto fd : fds) {
+            if (fd < 0) {
+                close();
+                return false;
+            }
+        }
+
+        return ioctl(fds[0], PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP) == 0;
+    }
+
+    ~ThreadCounters() { close(); }
+
+    void close() {
+        for (auto &fd : fds) {
+            if (fd >= 0) {
+                ::close(fd);
+            }
+            fd = -1;
+        }
+    }
+};
+
+bool PerfCounters::read(PerfCounterValues &_values) {
+    static thread_local ThreadCounters counters;
+
+    if (!counters.opened && !counters.open()) {
+        if (unavailableThreads++ == 0) {
+            spdlog::warn("Could not open perf counters: {}", strerror(errno));
+        }
+        counters.close();
+    }
+
+    if (counters.fds[0] < 0) {
+        return false;
+    }
+
+    // PERF_FORMAT_GROUP returns the number of counters, then their values in the order they were opened
+    uint64_t data[1 + NUM_PERF_COUNTERS];
+    if (::read(counters.fds[0], data, sizeof(data)) != (ssize_t) sizeof(data) || data[0] != NUM_PERF_COUNTERS) {
+        spdlog::warn("Could not read perf counters, disabling them for this thread");
+        counters.close();
+        unavailableThreads++;
+        return false;
+    }
+
+    _values.cycles = data[1];
+    _values.instructions = data[2];
+    _values.llcMisses = data[3];
+    _values.contextSwitches = data[4];
+    return true;
+}
@@ -0,0 +1,66 @@
+/*
+    Copyright (C) 2021-Present SKALE Labs
+
+    This file is part of sgxwallet.
+
+    sgxwallet is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as published
+    by the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    sgxwallet is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with sgxwallet. If not, see <https://www.gnu.org/licenses/>.
+
+    @file PerfCounters.h
+    @author Stan Kladko
+    @date 2021
+*/
+
+
+#ifndef SGXWALLET_PERFCOUNTERS_H
+#define SGXWALLET_PERFCOUNTERS_H
+
+#include <atomic>
+#include <cstdint>
+
+using namespace std;
+
+struct PerfCounterValues {
+    uint64_t cycles = 0;
+    uint64_t instructions = 0;
+    uint64_t llcMisses = 0;
+    uint64_t contextSwitches = 0;
+};
+
+// Optional hardware counters of the calling thread, read around the stages of the request
+// pipeline, see PERF_STAGE in Metrics.h. Each thread opens one perf_event group on its first
+// read, so that a read is a single syscall. Counting is off unless enabled with sgxwallet -Y,
+// and a thread whose group cannot be opened, for example because of perf_event_paranoid or in
+// a VM without a PMU, does not count.
+//
+// The CPU does not count inside a production enclave, so ECALL stages only show the host side
+// of the transitions, and the context switches and misses they cause.
+class PerfCounters {
+
+    static atomic<bool> enabled;
+
+    static atomic<uint64_t> unavailableThreads;
+
+public:
+
+    static void setEnabled(bool _enabled) { enabled = _enabled; }
+
+    static bool isEnabled() { return enabled.load(memory_order_relaxed); }
+
+    // false if the counters of this thread are not available
+    static bool read(PerfCounterValues &_values);
+
+    static uint64_t getUnavailableThreads() { return unavailableThreads; }
+};
+
+#endif //SGXWALLET_PERFCOUNTERS_H
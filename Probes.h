@@ -0,0 +1,77 @@
+/*
+    Copyright (C) 2021-Present SKALE Labs
+
+    This file is part of sgxwallet.
+
+    sgxwallet is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as published
+    by the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    sgxwallet is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with sgxwallet. If not, see <https://www.gnu.org/licenses/>.
+
+    @file Probes.h
+    @author Stan Kladko
+    @date 2021
+*/
+
+
+#ifndef SGXWALLET_PROBES_H
+#define SGXWALLET_PROBES_H
+
+// USDT probes of the sgxwallet provider, for bpftrace, bcc and perf. A probe is a single nop
+// in the code and its arguments stay in registers, so they cost nothing while nobody is attached.
+// Built without sys/sdt.h, from the systemtap-sdt-dev package, the probes are left out.
+//
+//   request__receive(id, tag, frontEnd)  the router thread accepted a ZMQ request
+//   request__enqueue(id, signLane)       the request was put into the scheduler
+//   request__dequeue(id, worker)         a worker thread took the request
+//   request__reply(id)                   the router thread sent the reply
+//   request__reject(status)              the request was refused before it was queued
+//   method__entry(name)                  a JSON-RPC method started, over HTTP or ZMQ
+//   method__return(name)                 the method returned or threw
+//   ecall__entry(name)                   an ECALL is about to enter the enclave
+//   ecall__return(name, status)          the ECALL returned
+//
+// id is the receive time of the request in nanoseconds, see IncomingRequest::receivedNs.
+
+#if defined(__has_include)
+#if __has_include(<sys/sdt.h>)
+#include <sys/sdt.h>
+#define SGXWALLET_HAVE_SDT 1
+#endif
+#endif
+
+#ifdef SGXWALLET_HAVE_SDT
+
+#define PROBE1(__NAME__, __A1__) DTRACE_PROBE1(sgxwallet, __NAME__, __A1__)
+#define PROBE2(__NAME__, __A1__, __A2__) DTRACE_PROBE2(sgxwallet, __NAME__, __A1__, __A2__)
+#define PROBE3(__NAME__, __A1__, __A2__, __A3__) DTRACE_PROBE3(sgxwallet, __NAME__, __A1__, __A2__, __A3__)
+
+#else
+
+#define PROBE1(__NAME__, __A1__)
+#define PROBE2(__NAME__, __A1__, __A2__)
+#define PROBE3(__NAME__, __A1__, __A2__, __A3__)
+
+#endif
+
+// fires method__entry and method__return around a scope, see COUNT_STATISTICS
+class MethodProbe {
+
+    const char *name;
+
+public:
+
+    explicit MethodProbe(const char *_name) : name(_name) { PROBE1(method__entry, name); }
+
+    ~MethodProbe() { PROBE1(method__return, name); }
+};
+
+#endif //SGXWALLET_PROBES_H
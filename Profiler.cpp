@@ -0,0 +1,246 @@
+/*
+    Copyright (C) 2021-Present SKALE Labs
+
+    This file is part of sgxwallet.
+
+    sgxwallet is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as published
+    by the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    sgxwallet is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with sgxwallet. If not, see <https://www.gnu.org/licenses/>.
+
+    @file Profiler.cpp
+    @author Stan Kladko
+    @date 2021
+*/
+
+
+#include <algorithm>
+#include <cerrno>
+#include <csignal>
+#include <cstring>
+#include <cxxabi.h>
+#include <dlfcn.h>
+#include <execinfo.h>
+#include <fstream>
+#include <map>
+#include <sys/time.h>
+#include <unistd.h>
+#include <unordered_map>
+#include <vector>
+
+#include "SGXException.h"
+#include "ExitHandler.h"
+#include "third_party/spdlog/spdlog.h"
+#include "common.h"
+#include "Metrics.h"
+
+#include "Profiler.h"
+
+// the handler frame and the signal trampoline
+static constexpr int SIGNAL_FRAMES = 2;
+
+bool Profiler::enabled = false;
+atomic<bool> Profiler::running(false);
+atomic<bool> Profiler::sampling(false);
+unique_ptr<Profiler::Sample[]> Profiler::samples;
+atomic<uint64_t> Profiler::numSamples(0);
+atomic<uint64_t> Profiler::droppedSamples(0);
+
+void Profiler::onSignal(int) {
+    if (!sampling.load()) {
+        return;
+    }
+
+    auto savedErrno = errno;
+
+    auto index = numSamples.fetch_add(1);
+    if (index < PROFILER_MAX_SAMPLES) {
+        auto &sample = samples[index];
+        sample.ecall = Metrics::getCurrentEcall();
+        sample.depth = backtrace(sample.frames, PROFILER_MAX_DEPTH);
+    } else {
+        droppedSamples++;
+    }
+
+    errno = savedErrno;
+}
+
+void Profiler::installHandler() {
+    static bool installed = false;
+    if (installed) {
+        return;
+    }
+
+    // the first backtrace loads libgcc, which must not happen in a signal handler
+    void *frames[1];
+    backtrace(frames, 1);
+
+    // the handler stays installed, a SIGPROF that arrives late would otherwise end the process
+    struct sigaction action;
+    memset(&action, 0, sizeof(action));
+    action.sa_handler = onSignal;
+    action.sa_flags = SA_RESTART;
+    sigemptyset(&action.sa_mask);
+    CHECK_STATE(sigaction(SIGPROF, &action, nullptr) == 0);
+
+    installed = true;
+}
+
+static string symbolize(void *_address) {
+    Dl_info info;
+    if (!dladdr(_address, &info)) {
+        info.dli_fname = nullptr;
+        info.dli_sname = nullptr;
+    }
+
+    if (info.dli_sname) {
+        int status = 0;
+        char *demangled = abi::__cxa_demangle(info.dli_sname, nullptr, nullptr, &status);
+        string name = status == 0 && demangled ? demangled : info.dli_sname;
+        free(demangled);
+        // ; separates frames and spaces end the stack in the folded format
+        replace(name.begin(), name.end(), ';', ':');
+        replace(name.begin(), name.end(), ' ', '_');
+        return name;
+    }
+
+    char buf[32];
+
+    // static functions have no dynamic symbol, addr2line resolves the module offset
+    if (info.dli_fname) {
+        string module = info.dli_fname;
+        module = module.substr(module.rfind('/') + 1);
+        snprintf(buf, sizeof(buf), "+0x%lx", (unsigned long) ((char *) _address - (char *) info.dli_fbase));
+        return module + buf;
+    }
+
+    snprintf(buf, sizeof(buf), "%p", _address);
+    return buf;
+}
+
+string Profiler::fold() {
+    auto count = min<uint64_t>(numSamples.load(), PROFILER_MAX_SAMPLES);
+
+    ifstream commFile("/proc/self/comm");
+    string root;
+    getline(commFile, root);
+    if (root.empty()) {
+        root = "sgxwallet";
+    }
+
+    unordered_map<void *, string> names;
+    map<string, uint64_t> stacks;
+
+    for (uint64_t i = 0; i < count; i++) {
+        auto &sample = samples[i];
+        string stack = root;
+        // backtrace returns the innermost frame first
+        for (int j = sample.depth - 1; j >= SIGNAL_FRAMES; j--) {
+            auto it = names.find(sample.frames[j]);
+            if (it == names.end()) {
+                it = names.emplace(sample.frames[j], symbolize(sample.frames[j])).first;
+            }
+            stack += ";" + it->second;
+        }
+        if (sample.ecall) {
+            stack += string(";[enclave]_") + sample.ecall;
+        }
+        stacks[stack]++;
+    }
+
+    vector<pair<string, uint64_t>> sorted(stacks.begin(), stacks.end());
+    sort(sorted.begin(), sorted.end(), [](const pair<string, uint64_t> &_a, const pair<string, uint64_t> &_b) {
+        return _a.second > _b.second;
+    });
+
+    string result;
+    for (auto &&stack : sorted) {
+        result += stack.first + " " + to_string(stack.second) + "\n";
+    }
+    return result;
+}
+
+Json::Value Profiler::profile(uint64_t _seconds) {
+    if (!enabled) {
+        throw SGXException(INVALID_PROFILE_REQUEST, "CPU profiling is disabled, start sgxwallet with -J");
+    }
+
+    if (_seconds == 0 || _seconds > PROFILER_MAX_SECONDS) {
+        throw SGXException(INVALID_PROFILE_REQUEST,
+                           "Profile duration has to be between 1 and " + to_string(PROFILER_MAX_SECONDS) + " seconds");
+    }
+
+    if (running.exchange(true)) {
+        throw SGXException(INVALID_PROFILE_REQUEST, "Another CPU profile is being taken");
+    }
+
+    struct RunningGuard {
+        ~RunningGuard() { running = false; }
+    } guard;
+
+    installHandler();
+
+    if (!samples) {
+        samples.reset(new Sample[PROFILER_MAX_SAMPLES]);
+    }
+    numSamples = 0;
+    droppedSamples = 0;
+
+    // (calls, wall time) of each ECALL when the profile started
+    map<string, pair<uint64_t, uint64_t>> ecallsBefore;
+    for (auto &&ecall : Metrics::listEcalls()) {
+        ecallsBefore[ecall.first] = {ecall.second->latency.getCount(), ecall.second->latency.getSumUs()};
+    }
+
+    spdlog::info("Taking a {} second CPU profile", _seconds);
+
+    Metrics::setProfiling(true);
+    sampling = true;
+
+    struct itimerval timer;
+    memset(&timer, 0, sizeof(timer));
+    timer.it_interval.tv_usec = 1000000 / PROFILER_FREQUENCY_HZ;
+    timer.it_value = timer.it_interval;
+    CHECK_STATE(setitimer(ITIMER_PROF, &timer, nullptr) == 0);
+
+    for (uint64_t i = 0; i < _seconds && !ExitHandler::shouldExit(); i++) {
+        sleep(1);
+    }
+
+    memset(&timer, 0, sizeof(timer));
+    setitimer(ITIMER_PROF, &timer, nullptr);
+    sampling = false;
+    Metrics::setProfiling(false);
+
+    Json::Value result;
+    result["seconds"] = (Json::UInt64) _seconds;
+    result["frequencyHz"] = PROFILER_FREQUENCY_HZ;
+    result["samples"] = (Json::UInt64) min<uint64_t>(numSamples.load(), PROFILER_MAX_SAMPLES);
+    result["droppedSamples"] = (Json::UInt64) droppedSamples.load();
+    result["folded"] = fold();
+
+    // ECALLs that were already being timed include the calls that started before the profile
+    result["ecalls"] = Json::arrayValue;
+    for (auto &&ecall : Metrics::listEcalls()) {
+        auto before = ecallsBefore[ecall.first];
+        auto calls = ecall.second->latency.getCount() - before.first;
+        if (calls == 0) {
+            continue;
+        }
+        Json::Value entry;
+        entry["name"] = ecall.first;
+        entry["calls"] = (Json::UInt64) calls;
+        entry["wallUs"] = (Json::UInt64) (ecall.second->latency.getSumUs() - before.second);
+        result["ecalls"].append(entry);
+    }
+
+    return result;
+}
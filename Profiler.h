@@ -0,0 +1,84 @@
+/*
+    Copyright (C) 2021-Present SKALE Labs
+
+    This file is part of sgxwallet.
+
+    sgxwallet is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as published
+    by the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    sgxwallet is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with sgxwallet. If not, see <https://www.gnu.org/licenses/>.
+
+    @file Profiler.h
+    @author Stan Kladko
+    @date 2021
+*/
+
+
+#ifndef SGXWALLET_PROFILER_H
+#define SGXWALLET_PROFILER_H
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+
+#include <json/value.h>
+
+#include "sgxwallet_common.h"
+
+using namespace std;
+
+// On demand sampling CPU profiler of all host threads, for the info server getCpuProfile.
+// ITIMER_PROF sends SIGPROF at PROFILER_FREQUENCY_HZ of process CPU time to the running thread,
+// whose stack the handler records with backtrace(). A sample taken inside an ECALL gets the
+// ECALL name as its leaf frame. Since the CPU timer does not see time an ECALL waits, the wall
+// clock time of each ECALL is also measured while the profiler runs.
+//
+// Stacks are returned in the folded format of flamegraph.pl. Disabled unless enabled with
+// sgxwallet -J, and one profile runs at a time.
+class Profiler {
+
+    struct Sample {
+        const char *ecall;
+        int depth;
+        void *frames[PROFILER_MAX_DEPTH];
+    };
+
+    static bool enabled;
+
+    static atomic<bool> running;
+
+    // written by the signal handler only while sampling is true
+    static atomic<bool> sampling;
+
+    static unique_ptr<Sample[]> samples;
+
+    static atomic<uint64_t> numSamples;
+
+    static atomic<uint64_t> droppedSamples;
+
+    static void onSignal(int _signal);
+
+    static void installHandler();
+
+    static string fold();
+
+public:
+
+    static void setEnabled(bool _enabled) { enabled = _enabled; }
+
+    static bool isEnabled() { return enabled; }
+
+    // blocks for _seconds, throws SGXException with INVALID_PROFILE_REQUEST if the profiler is
+    // disabled or already running
+    static Json::Value profile(uint64_t _seconds);
+};
+
+#endif //SGXWALLET_PROFILER_H
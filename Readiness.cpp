@@ -0,0 +1,62 @@
+/*
+    Copyright (C) 2021-Present SKALE Labs
+
+    This file is part of sgxwallet.
+
+    sgxwallet is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as published
+    by the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    sgxwallet is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with sgxwallet. If not, see <https://www.gnu.org/licenses/>.
+
+    @file Readiness.cpp
+    @author Stan Kladko
+    @date 2021
+*/
+
+
+#include "sgxwallet_common.h"
+#include "ExitHandler.h"
+#include "zmq_src/ZMQServer.h"
+
+#include "Readiness.h"
+
+atomic<uint32_t> Readiness::state(STARTING);
+
+const char *Readiness::getStateName(State _state) {
+    switch (_state) {
+        case STARTING:
+            return "starting";
+        case READY:
+            return "ready";
+        case DRAINING:
+            return "draining";
+    }
+    return "unknown";
+}
+
+bool Readiness::isReady() {
+    return getState() == READY && !ExitHandler::shouldExit() &&
+           ZMQServer::getSignQueueDepth() <= READINESS_MAX_SIGN_QUEUE_DEPTH;
+}
+
+Json::Value Readiness::getStatus() {
+    Json::Value result;
+
+    auto current = ExitHandler::shouldExit() ? DRAINING : getState();
+    result["state"] = getStateName(current);
+    result["ready"] = isReady();
+    // the same counters as getServerStatus, which goes through the request queues
+    result["zmqSignQueueDepth"] = (Json::UInt64) ZMQServer::getSignQueueDepth();
+    result["zmqSlowQueueDepth"] = (Json::UInt64) ZMQServer::getSlowQueueDepth();
+    result["zmqOutgoingQueueDepth"] = (Json::UInt64) ZMQServer::getOutgoingQueueDepth();
+
+    return result;
+}
@@ -0,0 +1,66 @@
+/*
+    Copyright (C) 2021-Present SKALE Labs
+
+    This file is part of sgxwallet.
+
+    sgxwallet is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as published
+    by the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    sgxwallet is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with sgxwallet. If not, see <https://www.gnu.org/licenses/>.
+
+    @file Readiness.h
+    @author Stan Kladko
+    @date 2021
+*/
+
+
+#ifndef SGXWALLET_READINESS_H
+#define SGXWALLET_READINESS_H
+
+#include <atomic>
+#include <cstdint>
+
+#include <json/value.h>
+
+using namespace std;
+
+// Server state for liveness and readiness probes. Answering a probe only reads atomics, it never
+// calls the enclave or the database and never waits for a lock, so probes take the same time
+// however loaded the server is. Served by getReadiness on the info server and by GET /live and
+// GET /ready on the metrics server.
+class Readiness {
+
+public:
+
+    enum State : uint32_t {
+        STARTING, READY, DRAINING
+    };
+
+private:
+
+    static atomic<uint32_t> state;
+
+public:
+
+    static void setState(State _state) { state = _state; }
+
+    static State getState() { return (State) state.load(); }
+
+    static const char *getStateName(State _state);
+
+    // READY, and no more than READINESS_MAX_SIGN_QUEUE_DEPTH sign requests waiting, so that a
+    // load balancer takes the node out of rotation before it starts rejecting requests
+    static bool isReady();
+
+    static Json::Value getStatus();
+};
+
+#endif //SGXWALLET_READINESS_H
@@ -0,0 +1,176 @@
+/*
+    Copyright (C) 2021-Present SKALE Labs
+
+    This file is part of sgxwallet.
+
+    sgxwallet is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as published
+    by the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    sgxwallet is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with sgxwallet. If not, see <https://www.gnu.org/licenses/>.
+
+    @file RequestCoalescer.cpp
+    @author Stan Kladko
+    @date 2021
+*/
+
+#include <chrono>
+
+#include "third_party/spdlog/spdlog.h"
+#include "common.h"
+
+#include "RequestCoalescer.h"
+
+RequestCoalescer::RequestCoalescer(uint64_t _maxEntries, uint64_t _ttlMs) : maxEntries(_maxEntries), ttlMs(_ttlMs),
+                                                                             nextId(0), coalesced(0), cacheHits(0) {
+    CHECK_STATE(_maxEntries > 0);
+}
+
+uint64_t RequestCoalescer::nowMs() {
+    return chrono::duration_cast<chrono::milliseconds>(chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void RequestCoalescer::removeKept(uint64_t _nowMs, bool _evict) {
+    while (!kept.empty()) {
+        auto it = entries.find(kept.front().first);
+
+        // entries that were forgotten or replaced since they were kept
+        if (it == entries.end() || it->second.id != kept.front().second || !it->second.done) {
+            kept.pop_front();
+            continue;
+        }
+
+        bool expired = it->second.expiresAtMs <= _nowMs;
+
+        if (!expired && !_evict) {
+            return;
+        }
+
+        entries.erase(it);
+        kept.pop_front();
+
+        if (!expired) {
+            return;
+        }
+    }
+}
+
+void RequestCoalescer::finish(const string &_key, uint64_t _id, bool _keep) {
+    lock_guard<mutex> lock(m);
+
+    auto it = entries.find(_key);
+    if (it == entries.end() || it->second.id != _id) {
+        return;
+    }
+
+    if (_keep) {
+        it->second.done = true;
+        it->second.expiresAtMs = nowMs() + ttlMs;
+        kept.emplace_back(_key, _id);
+    } else {
+        entries.erase(it);
+    }
+}
+
+void RequestCoalescer::forget(const string &_prefix) {
+    lock_guard<mutex> lock(m);
+
+    for (auto it = entries.begin(); it != entries.end();) {
+        if (it->first.compare(0, _prefix.size(), _prefix) == 0) {
+            it = entries.erase(it);
+        } else {
+            it++;
+        }
+    }
+}
+
+void RequestCoalescer::dropKept() {
+    lock_guard<mutex> lock(m);
+
+    auto now = nowMs();
+    while (!kept.empty()) {
+        removeKept(now, true);
+    }
+}
+
+uint64_t RequestCoalescer::getSize() {
+    lock_guard<mutex> lock(m);
+    return entries.size();
+}
+
+Json::Value RequestCoalescer::run(const string &_key, const function<Json::Value()> &_compute) {
+    shared_future<Json::Value> existing;
+    promise<Json::Value> computed;
+
+    bool owner = false;
+    bool cached = false;
+    uint64_t id = 0;
+
+    {
+        lock_guard<mutex> lock(m);
+
+        auto now = nowMs();
+        auto it = entries.find(_key);
+
+        if (it != entries.end() && (!it->second.done || it->second.expiresAtMs > now)) {
+            existing = it->second.result;
+            cached = it->second.done;
+        } else {
+            if (it != entries.end()) {
+                entries.erase(it);
+            }
+
+            removeKept(now, false);
+
+            if (entries.size() >= maxEntries) {
+                removeKept(now, true);
+            }
+
+            if (entries.size() < maxEntries) {
+                auto &entry = entries[_key];
+                entry.result = computed.get_future().share();
+                entry.id = id = nextId++;
+                owner = true;
+            }
+        }
+    }
+
+    if (existing.valid()) {
+        if (cached) {
+            cacheHits++;
+            spdlog::debug("Answered a repeated request from the result cache");
+        } else {
+            coalesced++;
+            spdlog::debug("Coalesced an identical request");
+        }
+        return existing.get();
+    }
+
+    if (!owner) {
+        return _compute();
+    }
+
+    Json::Value result;
+
+    try {
+        result = _compute();
+    } catch (...) {
+        computed.set_exception(current_exception());
+        finish(_key, id, false);
+        throw;
+    }
+
+    computed.set_value(result);
+
+    // failures are not remembered, so that a retry computes again
+    finish(_key, id, result.isMember("status") && result["status"] == 0);
+
+    return result;
+}
@@ -0,0 +1,94 @@
+/*
+    Copyright (C) 2021-Present SKALE Labs
+
+    This file is part of sgxwallet.
+
+    sgxwallet is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as published
+    by the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    sgxwallet is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with sgxwallet. If not, see <https://www.gnu.org/licenses/>.
+
+    @file RequestCoalescer.h
+    @author Stan Kladko
+    @date 2021
+*/
+
+#ifndef SGXWALLET_REQUESTCOALESCER_H
+#define SGXWALLET_REQUESTCOALESCER_H
+
+#include <atomic>
+#include <deque>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+#include <json/value.h>
+
+using namespace std;
+
+// Identical requests that arrive while one is being computed wait for it and share its
+// result instead of entering the enclave again. Successful results are also kept for
+// _ttlMs so that client retries after a timeout are answered from memory. Bounded by
+// _maxEntries, when full the oldest kept results are evicted first, and new requests are
+// computed without coalescing only while all entries are still being computed.
+class RequestCoalescer {
+
+public:
+
+    RequestCoalescer(uint64_t _maxEntries, uint64_t _ttlMs);
+
+    Json::Value run(const string &_key, const function<Json::Value()> &_compute);
+
+    // drops the entries of all keys that start with _prefix, used when a key is deleted
+    void forget(const string &_prefix);
+
+    // drops all kept results, requests being computed are not affected
+    void dropKept();
+
+    uint64_t getCoalesced() const { return coalesced; }
+
+    uint64_t getCacheHits() const { return cacheHits; }
+
+    uint64_t getSize();
+
+private:
+
+    struct Entry {
+        shared_future<Json::Value> result;
+        uint64_t id = 0;
+        bool done = false;
+        uint64_t expiresAtMs = 0;
+    };
+
+    mutex m;
+    unordered_map<string, Entry> entries;
+
+    // kept results in the order they were kept, which is also the order they expire in
+    deque<pair<string, uint64_t>> kept;
+
+    const uint64_t maxEntries;
+    const uint64_t ttlMs;
+
+    uint64_t nextId;
+
+    atomic<uint64_t> coalesced;
+    atomic<uint64_t> cacheHits;
+
+    static uint64_t nowMs();
+
+    void removeKept(uint64_t _nowMs, bool _evict);
+
+    void finish(const string &_key, uint64_t _id, bool _keep);
+};
+
+#endif //SGXWALLET_REQUESTCOALESCER_H
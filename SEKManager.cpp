@@ -30,6 +30,7 @@
 
 #include "sgxwallet_common.h"
 #include "common.h"
+#include "Metrics.h"
 #include "sgxwallet.h"
 
 #include "SGXException.h"
@@ -39,6 +40,7 @@
 #include "ServerDataChecker.h"
 #include "ServerInit.h"
 #include "SEKManager.h"
+#include "SEKRotation.h"
 
 using namespace std;
 
@@ -65,7 +67,7 @@ void create_test_key() {
 
     {
         READ_LOCK(sgxInitMutex);
-        status = trustedEncryptKey(eid, &errStatus, errMsg.data(), key.c_str(), encrypted_key, &enc_len);
+        status = ECALL(trustedEncryptKey, eid, &errStatus, errMsg.data(), key.c_str(), encrypted_key, &enc_len);
     }
 
     HANDLE_TRUSTED_FUNCTION_ERROR(status, errStatus, errMsg.data());
@@ -95,7 +97,7 @@ void validate_SEK() {
 
     {
         READ_LOCK(sgxInitMutex);
-        status = trustedDecryptKey(eid, &err_status, errMsg.data(), encr_test_key.data(), len, decr_key.data());
+        status = ECALL(trustedDecryptKey, eid, &err_status, errMsg.data(), encr_test_key.data(), len, decr_key.data());
     }
 
     HANDLE_TRUSTED_FUNCTION_ERROR(status, err_status, errMsg.data());
@@ -124,8 +126,8 @@ shared_ptr <vector<uint8_t>> check_and_set_SEK(const string &SEK) {
 
     {
         READ_LOCK(sgxInitMutex);
-        status = trustedSetSEKBackup(eid, &err_status, errMsg.data(), encrypted_SEK->data(), &l,
-                             SEK.c_str());
+        status = ECALL(trustedSetSEKBackup, eid, &err_status, errMsg.data(), encrypted_SEK->data(), &l,
+                                    SEK.c_str());
     }
 
     HANDLE_TRUSTED_FUNCTION_ERROR(status, err_status, errMsg.data());
@@ -137,6 +139,13 @@ shared_ptr <vector<uint8_t>> check_and_set_SEK(const string &SEK) {
     return encrypted_SEK;
 }
 
+void writeBackupKey(const string &_SEK) {
+    ofstream sek_file(BACKUP_PATH);
+    sek_file.clear();
+
+    sek_file << _SEK;
+}
+
 void gen_SEK() {
     vector<char> errMsg(1024, 0);
     int err_status = 0;
@@ -150,7 +159,7 @@ void gen_SEK() {
     sgx_status_t status = SGX_SUCCESS;
     {
 
-        status = trustedGenerateSEK(eid, &err_status, errMsg.data(), encrypted_SEK.data(), &enc_len, SEK);
+        status = ECALL(trustedGenerateSEK, eid, &err_status, errMsg.data(), encrypted_SEK.data(), &enc_len, SEK);
     }
 
     HANDLE_TRUSTED_FUNCTION_ERROR(status, err_status, errMsg.data());
@@ -163,10 +172,7 @@ void gen_SEK() {
 
     spdlog::info(string("Encrypted storage encryption key:") + hexEncrKey.data());
 
-    ofstream sek_file(BACKUP_PATH);
-    sek_file.clear();
-
-    sek_file << SEK;
+    writeBackupKey(SEK);
 
     cout << "ATTENTION! YOUR BACKUP KEY HAS BEEN WRITTEN INTO sgx_data/backup_key.txt \n" <<
          "PLEASE COPY IT TO THE SAFE PLACE AND THEN DELETE THE FILE MANUALLY BY RUNNING THE FOLLOWING COMMAND:\n" <<
@@ -195,7 +201,7 @@ void gen_SEK() {
 
 }
 
-void setSEK(shared_ptr <string> hex_encrypted_SEK) {
+void setSEK(shared_ptr <string> hex_encrypted_SEK, uint64_t _firstShard) {
 
     CHECK_STATE(hex_encrypted_SEK);
 
@@ -211,12 +217,12 @@ void setSEK(shared_ptr <string> hex_encrypted_SEK) {
         throw SGXException(SET_SEK_INVALID_SEK_HEX, "Invalid encrypted SEK Hex");
     }
 
-    sgx_status_t status = SGX_SUCCESS;
-    {
-        status = trustedSetSEK(eid, &err_status, errMsg.data(), encrypted_SEK);
-    }
+    // the SEK is sealed to the enclave, so every instance can unseal the same blob
+    for (uint64_t i = _firstShard; i < numEnclaveShards; i++) {
+        sgx_status_t status = ECALL(trustedSetSEK, enclaveShards[i], &err_status, errMsg.data(), encrypted_SEK);
 
-    HANDLE_TRUSTED_FUNCTION_ERROR(status, err_status, errMsg.data());
+        HANDLE_TRUSTED_FUNCTION_ERROR(status, err_status, errMsg.data());
+    }
 
     validate_SEK();
 }
@@ -272,7 +278,17 @@ void enter_SEK() {
 
 void initSEK() {
     if (enterBackupKey) {
+        if (LevelDB::getLevelDb()->readString("SEK_NEXT")) {
+            throw SGXException(SEK_ROTATION_IN_PROGRESS,
+                               "The database is in the middle of a SEK rotation, restore it from a later backup");
+        }
+
         enter_SEK();
+
+        // enter_SEK only sets the SEK of the first enclave instance
+        if (numEnclaveShards > 1) {
+            setSEK(LevelDB::getLevelDb()->readString("SEK"), 1);
+        }
     } else {
         shared_ptr <string> encrypted_SEK_ptr = LevelDB::getLevelDb()->readString("SEK");
         if (encrypted_SEK_ptr == nullptr) {
@@ -280,6 +296,7 @@ void initSEK() {
             gen_SEK();
         } else {
             setSEK(encrypted_SEK_ptr);
+            SEKRotation::resume();
         }
     }
 }
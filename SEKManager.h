@@ -32,7 +32,14 @@
 void gen_SEK();
 
 #ifdef __cplusplus
-void setSEK(std::shared_ptr<std::string> hex_encr_SEK);
+// sets the SEK in the enclave instances from _firstShard on
+void setSEK(std::shared_ptr<std::string> hex_encr_SEK, uint64_t _firstShard = 0);
+
+// writes the hex backup key to sgx_data/sgxwallet_backup_key.txt
+void writeBackupKey(const std::string &_SEK);
+
+// decrypts TEST_KEY with the SEK of the enclave, throws INVALID_SEK if it does not match
+void validate_SEK();
 #endif
 
 #ifdef __cplusplus
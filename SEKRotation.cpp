@@ -0,0 +1,357 @@
+/*
+    Copyright (C) 2021-Present SKALE Labs
+
+    This file is part of sgxwallet.
+
+    sgxwallet is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as published
+    by the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    sgxwallet is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with sgxwallet. If not, see <https://www.gnu.org/licenses/>.
+
+    @file SEKRotation.cpp
+    @author Stan Kladko
+    @date 2021
+*/
+
+#include <ctime>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include "sgxwallet_common.h"
+#include "sgxwallet.h"
+#include "SGXException.h"
+#include "ExitHandler.h"
+#include "CryptoTools.h"
+#include "LevelDB.h"
+#include "ECDSAKeyPool.h"
+#include "KeyHandles.h"
+#include "KeyStoreReplicator.h"
+#include "SEKManager.h"
+#include "third_party/spdlog/spdlog.h"
+#include "common.h"
+#include "Metrics.h"
+
+#include "SEKRotation.h"
+
+// MAC, IV, type and exportable bytes of a value sealed by AES_encrypt
+static constexpr uint64_t MIN_SEALED_VALUE_LEN = 16 + 12 + 2;
+
+mutex SEKRotation::rotationMutex;
+atomic<bool> SEKRotation::inProgress(false);
+atomic<bool> SEKRotation::exitRequested(false);
+shared_ptr<thread> SEKRotation::rotationThread = nullptr;
+atomic<uint64_t> SEKRotation::startTime(0);
+atomic<uint64_t> SEKRotation::passes(0);
+atomic<uint64_t> SEKRotation::valuesScanned(0);
+atomic<uint64_t> SEKRotation::valuesResealed(0);
+atomic<uint64_t> SEKRotation::errors(0);
+
+// lower case hex of a length that AES_encrypt can produce, other values are never sent to the enclave
+static bool isSealedValueCandidate(const string &_name, const string &_value) {
+    if (_name == "SEK" || _name == "SEK_NEXT") {
+        return false;
+    }
+
+    if (_value.size() % 2 != 0 || _value.size() < 2 * MIN_SEALED_VALUE_LEN ||
+        _value.size() > 2 * SEK_ROTATION_SLOT_LEN) {
+        return false;
+    }
+
+    for (auto c : _value) {
+        if (!((c >= '0' && c <= '9') || (c >= 'a' && c <= 'f'))) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+void SEKRotation::installSEK(const string &_hexEncryptedSEK) {
+    vector<char> errMsg(BUF_LEN, 0);
+    int errStatus = 0;
+
+    SAFE_UINT8_BUF(encryptedSEK, BUF_LEN);
+
+    uint64_t len = 0;
+
+    if (!hex2carray(_hexEncryptedSEK.c_str(), &len, encryptedSEK, BUF_LEN)) {
+        throw SGXException(SET_SEK_INVALID_SEK_HEX, "Invalid encrypted SEK Hex");
+    }
+
+    for (uint64_t i = 0; i < numEnclaveShards; i++) {
+        sgx_status_t status = ECALL(trustedRotateSEK, enclaveShards[i], &errStatus, errMsg.data(), encryptedSEK);
+
+        HANDLE_TRUSTED_FUNCTION_ERROR(status, errStatus, errMsg.data());
+    }
+}
+
+void SEKRotation::start() {
+    lock_guard<mutex> lock(rotationMutex);
+
+    if (KeyStoreReplicator::isFollower()) {
+        throw SGXException(SEK_ROTATION_NOT_ALLOWED,
+                           "Followers share the SEK of the leader, rotate it on the leader and restore the followers");
+    }
+
+    if (inProgress) {
+        throw SGXException(SEK_ROTATION_IN_PROGRESS, "A SEK rotation is already in progress");
+    }
+
+    vector<char> errMsg(BUF_LEN, 0);
+    int errStatus = 0;
+    vector<uint8_t> encryptedSEK(1024, 0);
+    uint64_t encLen = 0;
+
+    SAFE_CHAR_BUF(SEK, 65);
+
+    sgx_status_t status = ECALL(trustedGenerateRotationSEK, eid, &errStatus, errMsg.data(), encryptedSEK.data(),
+                                &encLen, SEK);
+
+    HANDLE_TRUSTED_FUNCTION_ERROR(status, errStatus, errMsg.data());
+
+    CHECK_STATE(strnlen(SEK, 33) == 32);
+
+    auto hexEncrSEK = carray2Hex(encryptedSEK.data(), encLen);
+
+    // nothing is sealed under the new SEK before its backup key is on disk
+    writeBackupKey(SEK);
+    memset(SEK, 0, sizeof(SEK));
+
+    spdlog::warn("SEK rotation started. THE NEW BACKUP KEY HAS BEEN WRITTEN INTO sgx_data/sgxwallet_backup_key.txt, "
+                 "COPY IT TO A SAFE PLACE AND DELETE THE FILE. The previous backup key stays valid until the "
+                 "rotation has finished");
+
+    LevelDB::getLevelDb()->writeDataUnique("SEK_NEXT", hexEncrSEK.data());
+
+    // from here on the rotation is resumed by the next start if anything below fails
+    startTime = time(nullptr);
+    inProgress = true;
+
+    installSEK(hexEncrSEK.data());
+
+    // pregenerated keys were sealed under the previous SEK
+    ECDSAKeyPool::clearHost();
+
+    startThread();
+}
+
+void SEKRotation::resume() {
+    auto hexEncrSEK = LevelDB::getLevelDb()->readString("SEK_NEXT");
+
+    if (!hexEncrSEK) {
+        return;
+    }
+
+    spdlog::info("Resuming SEK rotation");
+
+    installSEK(*hexEncrSEK);
+
+    startTime = time(nullptr);
+    inProgress = true;
+}
+
+uint64_t SEKRotation::reencryptPage(const vector<pair<string, string>> &_page) {
+    vector<string> names;
+    vector<string> values;
+    vector<string> creationTimes;
+    vector<uint8_t> encrypted(MAX_SEK_ROTATION_BATCH_SIZE * SEK_ROTATION_SLOT_LEN, 0);
+    vector<uint64_t> encLens;
+
+    for (auto &&entry : _page) {
+        string creationTime;
+        auto value = LevelDB::decodeValue(entry.second, &creationTime);
+
+        if (!isSealedValueCandidate(entry.first, value)) {
+            continue;
+        }
+
+        uint64_t len = 0;
+        if (!hex2carray(value.c_str(), &len, encrypted.data() + names.size() * SEK_ROTATION_SLOT_LEN,
+                        SEK_ROTATION_SLOT_LEN)) {
+            continue;
+        }
+
+        names.push_back(entry.first);
+        values.push_back(value);
+        creationTimes.push_back(creationTime);
+        encLens.push_back(len);
+    }
+
+    valuesScanned += names.size();
+
+    if (names.empty()) {
+        return 0;
+    }
+
+    uint64_t numValues = names.size();
+    vector<uint8_t> reencrypted(numValues * SEK_ROTATION_SLOT_LEN, 0);
+    vector<uint64_t> reencLens(numValues, 0);
+    vector<int> statuses(numValues, 0);
+    vector<char> errMsg(BUF_LEN, 0);
+    int errStatus = 0;
+
+    sgx_status_t status = SGX_SUCCESS;
+
+    {
+        READ_LOCK(sgxInitMutex);
+        status = ECALL(trustedReencryptKeysBatch, eid, &errStatus, errMsg.data(), numValues, encrypted.data(),
+                       numValues * SEK_ROTATION_SLOT_LEN, encLens.data(), reencrypted.data(),
+                       numValues * SEK_ROTATION_SLOT_LEN, reencLens.data(), statuses.data());
+    }
+
+    HANDLE_TRUSTED_FUNCTION_ERROR(status, errStatus, errMsg.data());
+
+    uint64_t underPreviousSEK = 0;
+    vector<tuple<string, string, string, string>> replacements;
+
+    for (uint64_t i = 0; i < numValues; i++) {
+        if (statuses[i] < 0) {
+            underPreviousSEK++;
+            errors++;
+            spdlog::error("SEK rotation could not reseal {}", names[i]);
+        } else if (reencLens[i] > 0) {
+            auto hex = carray2Hex(reencrypted.data() + i * SEK_ROTATION_SLOT_LEN, reencLens[i]);
+            replacements.emplace_back(names[i], values[i], hex.data(), creationTimes[i]);
+        }
+    }
+
+    // values that changed meanwhile are skipped here and checked again by the next pass
+    valuesResealed += LevelDB::getLevelDb()->replaceValues(replacements);
+
+    return underPreviousSEK + replacements.size();
+}
+
+uint64_t SEKRotation::reencryptPass() {
+    uint64_t underPreviousSEK = 0;
+    string cursor;
+
+    while (!exitRequested && !ExitHandler::shouldExit()) {
+        auto page = LevelDB::getLevelDb()->getKeysPage("", cursor, MAX_SEK_ROTATION_BATCH_SIZE);
+
+        if (page.empty()) {
+            break;
+        }
+
+        cursor = page.back().first;
+
+        underPreviousSEK += reencryptPage(page);
+
+        if (page.size() < MAX_SEK_ROTATION_BATCH_SIZE) {
+            break;
+        }
+
+        usleep(SEK_ROTATION_BATCH_INTERVAL_MS * 1000);
+    }
+
+    passes++;
+
+    return underPreviousSEK;
+}
+
+void SEKRotation::finish() {
+    lock_guard<mutex> lock(rotationMutex);
+
+    auto db = LevelDB::getLevelDb();
+
+    auto hexEncrSEK = db->readString("SEK_NEXT");
+    CHECK_STATE(hexEncrSEK);
+
+    // a restart between these writes resumes with SEK and SEK_NEXT equal, which finishes at once
+    db->writeString("SEK", *hexEncrSEK);
+    db->deleteKey("SEK_NEXT");
+
+    vector<char> errMsg(BUF_LEN, 0);
+    int errStatus = 0;
+
+    for (uint64_t i = 0; i < numEnclaveShards; i++) {
+        sgx_status_t status = ECALL(trustedFinishSEKRotation, enclaveShards[i], &errStatus, errMsg.data());
+
+        HANDLE_TRUSTED_FUNCTION_ERROR(status, errStatus, errMsg.data());
+    }
+
+    // handles keep the encrypted key they were opened with, which may be under the previous SEK
+    KeyHandles::clear();
+
+    spdlog::info("SEK rotation finished in {} seconds, {} values resealed in {} passes", getElapsedSeconds(),
+                 valuesResealed.load(), passes.load());
+
+    inProgress = false;
+    startTime = 0;
+}
+
+void SEKRotation::rotationLoop() {
+    // resealing only runs when the request threads leave the CPU to it
+    if (setpriority(PRIO_PROCESS, syscall(SYS_gettid), SEK_ROTATION_NICE) != 0) {
+        spdlog::warn("Could not lower the priority of the SEK rotation thread");
+    }
+
+    while (!exitRequested && !ExitHandler::shouldExit()) {
+        try {
+            auto underPreviousSEK = reencryptPass();
+
+            if (exitRequested || ExitHandler::shouldExit()) {
+                break;
+            }
+
+            if (underPreviousSEK == 0) {
+                finish();
+                break;
+            }
+        } catch (SGXException &e) {
+            errors++;
+            spdlog::error("SEK rotation pass failed: {}", e.getMessage());
+            sleep(1);
+        } catch (exception &e) {
+            errors++;
+            spdlog::error("SEK rotation pass failed: {}", e.what());
+            sleep(1);
+        }
+    }
+}
+
+void SEKRotation::startThread() {
+    // the thread of a finished rotation has returned already
+    if (rotationThread) {
+        rotationThread->join();
+    }
+
+    rotationThread = make_shared<thread>(rotationLoop);
+}
+
+void SEKRotation::initRotation() {
+    if (!inProgress) {
+        return;
+    }
+
+    lock_guard<mutex> lock(rotationMutex);
+
+    CHECK_STATE(!rotationThread);
+
+    startThread();
+}
+
+void SEKRotation::exitRotation() {
+    exitRequested = true;
+    if (rotationThread) {
+        rotationThread->join();
+        rotationThread = nullptr;
+    }
+}
+
+uint64_t SEKRotation::getElapsedSeconds() {
+    uint64_t start = startTime;
+    if (!inProgress || start == 0) {
+        return 0;
+    }
+    uint64_t now = time(nullptr);
+    return now > start ? now - start : 0;
+}
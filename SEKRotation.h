@@ -0,0 +1,106 @@
+/*
+    Copyright (C) 2021-Present SKALE Labs
+
+    This file is part of sgxwallet.
+
+    sgxwallet is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as published
+    by the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    sgxwallet is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with sgxwallet. If not, see <https://www.gnu.org/licenses/>.
+
+    @file SEKRotation.h
+    @author Stan Kladko
+    @date 2021
+*/
+
+#ifndef SGXWALLET_SEKROTATION_H
+#define SGXWALLET_SEKROTATION_H
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <tuple>
+#include <vector>
+
+using namespace std;
+
+// Online replacement of the storage encryption key, started through the startSEKRotation method of
+// the info server. A new SEK is generated, written to the backup key file and stored sealed as
+// SEK_NEXT. Every enclave instance then encrypts under the new SEK and still decrypts under the
+// previous one, so requests are served throughout.
+//
+// A low priority thread reseals the database in batches of MAX_SEK_ROTATION_BATCH_SIZE values,
+// one trustedReencryptKeysBatch call each, and sleeps SEK_ROTATION_BATCH_INTERVAL_MS between
+// batches. Values are replaced only if they did not change meanwhile. Once a full pass finds no
+// value sealed under the previous SEK, SEK_NEXT becomes SEK and the enclaves drop the previous SEK.
+// A restart during the rotation resumes it, see initSEK.
+class SEKRotation {
+
+    static mutex rotationMutex;
+
+    static atomic<bool> inProgress;
+
+    static atomic<bool> exitRequested;
+
+    static shared_ptr<thread> rotationThread;
+
+    static atomic<uint64_t> startTime;
+
+    static atomic<uint64_t> passes;
+
+    static atomic<uint64_t> valuesScanned;
+
+    static atomic<uint64_t> valuesResealed;
+
+    static atomic<uint64_t> errors;
+
+    // makes the sealed SEK in _hexEncryptedSEK the current SEK of every enclave instance
+    static void installSEK(const string &_hexEncryptedSEK);
+
+    // reseals the values of one database page, returns the number of values found under the previous SEK
+    static uint64_t reencryptPage(const vector<pair<string, string>> &_page);
+
+    static uint64_t reencryptPass();
+
+    static void finish();
+
+    static void rotationLoop();
+
+    static void startThread();
+
+public:
+
+    static void start();
+
+    // called by initSEK, continues a rotation that was interrupted by a restart
+    static void resume();
+
+    static void initRotation();
+
+    static void exitRotation();
+
+    static bool isInProgress() { return inProgress; }
+
+    // seconds since the rotation started, zero if no rotation is in progress
+    static uint64_t getElapsedSeconds();
+
+    static uint64_t getPasses() { return passes; }
+
+    static uint64_t getValuesScanned() { return valuesScanned; }
+
+    static uint64_t getValuesResealed() { return valuesResealed; }
+
+    static uint64_t getErrors() { return errors; }
+};
+
+#endif //SGXWALLET_SEKROTATION_H
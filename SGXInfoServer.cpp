@@ -35,7 +35,23 @@
 #include "LevelDB.h"
 
 #include "SGXInfoServer.h"
+#include "zmq_src/ZMQServer.h"
+#include "zmq_src/CertVerifier.h"
+#include "ServerInit.h"
+#include "DKGGarbageCollector.h"
+#include "KeyStoreReplicator.h"
+#include "SEKRotation.h"
+#include "ClientRateLimiter.h"
+#include "ECDSANoncePool.h"
 #include "LevelDB.h"
+#include "SGXWalletServer.hpp"
+#include "Metrics.h"
+#include "Readiness.h"
+#include "Profiler.h"
+#include "KeyStats.h"
+#include "DKGTimeline.h"
+#include "LatencySLO.h"
+#include "zmq_src/SchainPartitions.h"
 
 #include "Log.h"
 #include "common.h"
@@ -56,6 +72,9 @@ Json::Value SGXInfoServer::getAllKeysInfo() {
     Json::Value result;
 
     try {
+        // a full scan of the key store
+        SLO_SHED_LOW_PRIORITY
+
         auto allKeysInfo = LevelDB::getLevelDb()->getAllKeys();
         result["allKeys"] = allKeysInfo.first.str();
         result["keysNumber"] = std::to_string(allKeysInfo.second);
@@ -87,6 +106,26 @@ Json::Value SGXInfoServer::getServerConfiguration() {
         result["autoSign"] = autoSign_;
         result["checkCerts"] = checkCerts_;
         result["generateTestKeys"] = generateTestKeys_;
+        result["zmqWorkerThreads"] = (Json::UInt64) ZMQServer::getNumWorkerThreads();
+        result["pinZMQWorkerThreads"] = ZMQServer::isPinWorkerThreads();
+        result["zmqIOThreads"] = (Json::UInt64) ZMQServer::getNumIOThreads();
+        result["zmqFrontEnds"] = (Json::UInt64) ZMQServer::getNumFrontEnds();
+        result["zmqCurve"] = ZMQServer::isCurveEnabled();
+        result["zmqCurvePublicKey"] = ZMQServer::getCurvePublicKey();
+        result["switchlessEnabled"] = isSwitchlessEnabled();
+        result["switchlessTrustedWorkers"] = getSwitchlessTrustedWorkers();
+        result["switchlessUntrustedWorkers"] = getSwitchlessUntrustedWorkers();
+        result["levelDBBlockCacheMB"] = (Json::UInt64) LevelDB::getBlockCacheSizeMB();
+        result["levelDBBloomFilterBitsPerKey"] = LevelDB::getBloomFilterBitsPerKey();
+        result["levelDBWriteBufferMB"] = (Json::UInt64) LevelDB::getWriteBufferSizeMB();
+        result["ecdsaNoncePool"] = ECDSANoncePool::isEnabled();
+        result["httpServerThreads"] = (Json::UInt64) SGXWalletServer::getNumHttpThreads();
+        result["httpMaxInFlight"] = (Json::UInt64) SGXWalletServer::getMaxHttpInFlight();
+        result["adminServerThreads"] = (Json::UInt64) getAdminServerThreads();
+        result["dkgGCRetentionHours"] = (Json::UInt64) (DKGGarbageCollector::getRetentionSeconds() / 3600);
+        result["ecallTiming"] = Metrics::isEcallTimingEnabled();
+        result["clientRequestsPerSecond"] = (Json::UInt64) ClientRateLimiter::getRequestsPerSecond();
+        result["clusterLeader"] = KeyStoreReplicator::getLeaderHost();
     } HANDLE_SGX_EXCEPTION(result)
 
     RETURN_SUCCESS(result)
@@ -107,8 +146,301 @@ Json::Value SGXInfoServer::isKeyExist(const string& key) {
     RETURN_SUCCESS(result)
 }
 
-void SGXInfoServer::initInfoServer(uint32_t _logLevel, bool _autoSign, bool _checkCerts, bool _generateTestKeys) {
-    httpServer = make_shared<HttpServer>(BASE_PORT + 4);
+static vector<string> parseKeyNamesBatch(const Json::Value &_names) {
+    if (!_names.isArray() || _names.empty() || _names.size() > MAX_KEY_NAMES_BATCH_SIZE) {
+        throw SGXException(INVALID_KEY_NAMES_BATCH,
+                           "Batch has to contain between 1 and " + to_string(MAX_KEY_NAMES_BATCH_SIZE) + " key names");
+    }
+
+    vector<string> names;
+    for (auto &&name : _names) {
+        if (!name.isString()) {
+            throw SGXException(INVALID_KEY_NAMES_BATCH, "Batch key names have to be strings");
+        }
+        names.push_back(name.asString());
+    }
+    return names;
+}
+
+Json::Value SGXInfoServer::areKeysExist(const Json::Value& keyNames) {
+    Json::Value result;
+
+    try {
+        auto names = parseKeyNamesBatch(keyNames);
+        auto values = LevelDB::getLevelDb()->readRawStrings(names);
+
+        result["isExist"] = Json::arrayValue;
+        for (auto &&value : values) {
+            result["isExist"].append(value != nullptr);
+        }
+    } HANDLE_SGX_EXCEPTION(result)
+
+    RETURN_SUCCESS(result)
+}
+
+Json::Value SGXInfoServer::getKeysMetadata(const Json::Value& keyNames) {
+    Json::Value result;
+
+    try {
+        auto names = parseKeyNamesBatch(keyNames);
+        auto values = LevelDB::getLevelDb()->readRawStrings(names);
+
+        result["keys"] = Json::arrayValue;
+        for (uint64_t i = 0; i < names.size(); i++) {
+            Json::Value key;
+            key["keyName"] = names[i];
+            key["isExist"] = values[i] != nullptr;
+            // empty for missing keys and for keys written by old versions
+            string creationTime;
+            if (values[i]) {
+                LevelDB::decodeValue(*values[i], &creationTime);
+            }
+            key["creationTime"] = creationTime;
+            result["keys"].append(key);
+        }
+    } HANDLE_SGX_EXCEPTION(result)
+
+    RETURN_SUCCESS(result)
+}
+
+Json::Value SGXInfoServer::getKeyStatistics(const Json::Value& keyNames) {
+    Json::Value result;
+
+    try {
+        auto names = parseKeyNamesBatch(keyNames);
+
+        result["keys"] = Json::arrayValue;
+        for (auto &&name : names) {
+            KeyStats::Stats stats;
+            KeyStats::get(name, stats);
+
+            Json::Value key;
+            key["keyName"] = name;
+            key["signCount"] = (Json::UInt64) stats.signs;
+            key["lastUsedMs"] = (Json::UInt64) stats.lastUsedMs;
+            key["avgLatencyUs"] = (Json::UInt64) (stats.signs > 0 ? stats.totalLatencyUs / stats.signs : 0);
+            result["keys"].append(key);
+        }
+    } HANDLE_SGX_EXCEPTION(result)
+
+    RETURN_SUCCESS(result)
+}
+
+Json::Value SGXInfoServer::getDKGTimeline(const Json::Value& polyNames) {
+    Json::Value result;
+
+    try {
+        auto names = parseKeyNamesBatch(polyNames);
+
+        result["polys"] = Json::arrayValue;
+        for (auto &&name : names) {
+            Json::Value poly;
+            poly["polyName"] = name;
+
+            DKGTimeline::Session session;
+            if (DKGTimeline::get(name, session)) {
+                poly["startMs"] = (Json::UInt64) session.startMs;
+                poly["lastMs"] = (Json::UInt64) session.lastMs;
+                poly["blsKeyName"] = session.blsKeyName;
+                for (int i = 0; i < DKGTimeline::NUM_PHASES; i++) {
+                    auto &stats = session.phases[i];
+                    Json::Value phase;
+                    phase["calls"] = (Json::UInt64) stats.calls;
+                    phase["wallUs"] = (Json::UInt64) stats.wallUs;
+                    phase["ecallUs"] = (Json::UInt64) stats.ecallUs;
+                    phase["dbUs"] = (Json::UInt64) stats.dbUs;
+                    poly["phases"][DKGTimeline::getName((DKGTimeline::Phase) i)] = phase;
+                }
+            }
+            result["polys"].append(poly);
+        }
+    } HANDLE_SGX_EXCEPTION(result)
+
+    RETURN_SUCCESS(result)
+}
+
+Json::Value SGXInfoServer::getReadiness() {
+    // no HANDLE_SGX_EXCEPTION, nothing here throws
+    Json::Value result = Readiness::getStatus();
+    RETURN_SUCCESS(result)
+}
+
+Json::Value SGXInfoServer::getCacheStatistics() {
+    Json::Value result;
+
+    try {
+        auto &cache = LevelDB::getLevelDb()->getCache();
+        result["dbCacheHits"] = (Json::UInt64) cache.getHits();
+        result["dbCacheMisses"] = (Json::UInt64) cache.getMisses();
+        result["dbCacheEvictions"] = (Json::UInt64) cache.getEvictions();
+        result["dbCacheAdmissionRejects"] = (Json::UInt64) cache.getAdmissionRejects();
+        result["keyStatsKeys"] = (Json::UInt64) KeyStats::getNumKeys();
+        result["dbCacheEntries"] = (Json::UInt64) cache.size();
+        result["dbCacheBytes"] = (Json::UInt64) cache.sizeInBytes();
+        result["dbCacheMaxEntries"] = (Json::UInt64) LEVELDB_CACHE_MAX_ENTRIES;
+        result["dbCacheMaxBytes"] = (Json::UInt64) LEVELDB_CACHE_MAX_BYTES;
+        result["replicationPasses"] = (Json::UInt64) KeyStoreReplicator::getPasses();
+        result["replicatedKeys"] = (Json::UInt64) KeyStoreReplicator::getKeysReplicated();
+        result["replicationLagSeconds"] = (Json::UInt64) KeyStoreReplicator::getLagSeconds();
+        result["dkgGCRuns"] = (Json::UInt64) DKGGarbageCollector::getRuns();
+        result["dkgGCKeysDeleted"] = (Json::UInt64) DKGGarbageCollector::getKeysDeleted();
+        result["dkgGCBytesReclaimed"] = (Json::UInt64) DKGGarbageCollector::getBytesReclaimed();
+        result["ecdsaNoncePoolSize"] = (Json::UInt64) ECDSANoncePool::getPoolSize();
+        result["httpRequests"] = (Json::UInt64) SGXWalletServer::getHttpRequests();
+        result["httpCalls"] = (Json::UInt64) SGXWalletServer::getHttpCalls();
+        result["httpRejected"] = (Json::UInt64) SGXWalletServer::getHttpRejected();
+        result["httpRateLimited"] = (Json::UInt64) SGXWalletServer::getHttpRateLimited();
+        result["zmqSessions"] = (Json::UInt64) ZMQMessage::getNumSessions();
+        result["zmqVerifiedCerts"] = (Json::UInt64) ZMQMessage::getNumVerifiedCerts();
+        result["zmqVerifiedCertEvictions"] = (Json::UInt64) ZMQMessage::getVerifiedCertEvictions();
+        result["certVerifications"] = (Json::UInt64) CertVerifier::getVerified();
+        result["certVerificationsFailed"] = (Json::UInt64) CertVerifier::getFailed();
+        result["certCrlReloads"] = (Json::UInt64) CertVerifier::getCrlReloads();
+        result["zmqExpiredRequests"] = (Json::UInt64) ZMQServer::getExpiredRequests();
+        result["zmqRateLimitedRequests"] = (Json::UInt64) ZMQServer::getRateLimitedRequests();
+    } HANDLE_SGX_EXCEPTION(result)
+
+    RETURN_SUCCESS(result)
+}
+
+Json::Value SGXInfoServer::getKeysPage(const string& prefix, const string& cursor, int limit) {
+    Json::Value result;
+
+    try {
+        SLO_SHED_LOW_PRIORITY
+
+        if (limit <= 0 || limit > LEVELDB_KEYS_PAGE_SIZE) {
+            throw SGXException(INVALID_KEYS_PAGE_LIMIT, string(__FUNCTION__) + ":Invalid keys page limit");
+        }
+
+        auto page = LevelDB::getLevelDb()->getKeysPage(prefix, cursor, limit);
+
+        result["keys"] = Json::arrayValue;
+        for (auto &&entry : page) {
+            Json::Value key;
+            key["keyName"] = entry.first;
+            string creationTime;
+            key["value"] = LevelDB::decodeValue(entry.second, &creationTime);
+            key["creationTime"] = creationTime;
+            result["keys"].append(key);
+        }
+
+        // an empty cursor means there are no more keys with this prefix
+        result["nextCursor"] = page.size() == (uint64_t) limit ? page.back().first : "";
+    } HANDLE_SGX_EXCEPTION(result)
+
+    RETURN_SUCCESS(result)
+}
+
+Json::Value SGXInfoServer::getReplicationPage(const string& cursor, int limit) {
+    Json::Value result;
+
+    try {
+        if (limit <= 0 || limit > LEVELDB_KEYS_PAGE_SIZE) {
+            throw SGXException(INVALID_KEYS_PAGE_LIMIT, string(__FUNCTION__) + ":Invalid keys page limit");
+        }
+
+        string nextCursor;
+        auto page = LevelDB::getLevelDb()->getKeysCreatedSince(cursor, limit, nextCursor);
+
+        result["keys"] = Json::arrayValue;
+        for (auto &&entry : page) {
+            if (!KeyStoreReplicator::isReplicatedKey(entry.first)) {
+                continue;
+            }
+            Json::Value key;
+            key["keyName"] = entry.first;
+            string creationTime;
+            key["value"] = LevelDB::decodeValue(entry.second, &creationTime);
+            key["creationTime"] = creationTime;
+            result["keys"].append(key);
+        }
+
+        result["nextCursor"] = nextCursor;
+    } HANDLE_SGX_EXCEPTION(result)
+
+    RETURN_SUCCESS(result)
+}
+
+Json::Value SGXInfoServer::setEcallTiming(bool enabled) {
+    Json::Value result;
+
+    try {
+        Metrics::setEcallTimingEnabled(enabled);
+        spdlog::info("ECALL timing {}", enabled ? "enabled" : "disabled");
+        result["ecallTiming"] = Metrics::isEcallTimingEnabled();
+    } HANDLE_SGX_EXCEPTION(result)
+
+    RETURN_SUCCESS(result)
+}
+
+Json::Value SGXInfoServer::setSchainPartitions(const Json::Value& partitions) {
+    Json::Value result;
+
+    try {
+        SchainPartitions::setConfig(partitions);
+        result["partitions"] = SchainPartitions::getConfig();
+    } HANDLE_SGX_EXCEPTION(result)
+
+    RETURN_SUCCESS(result)
+}
+
+Json::Value SGXInfoServer::getSchainPartitions() {
+    Json::Value result;
+
+    try {
+        result["partitions"] = SchainPartitions::getConfig();
+        result["activePartitions"] = (Json::UInt64) ZMQServer::getFairQueuePartitions();
+    } HANDLE_SGX_EXCEPTION(result)
+
+    RETURN_SUCCESS(result)
+}
+
+static void sekRotationStatus(Json::Value &_result) {
+    auto elapsed = SEKRotation::getElapsedSeconds();
+    _result["inProgress"] = SEKRotation::isInProgress();
+    _result["elapsedSeconds"] = (Json::UInt64) elapsed;
+    _result["passes"] = (Json::UInt64) SEKRotation::getPasses();
+    _result["valuesScanned"] = (Json::UInt64) SEKRotation::getValuesScanned();
+    _result["valuesResealed"] = (Json::UInt64) SEKRotation::getValuesResealed();
+    _result["errors"] = (Json::UInt64) SEKRotation::getErrors();
+    _result["resealedPerSecond"] = elapsed > 0 ? (double) SEKRotation::getValuesResealed() / elapsed : 0.0;
+}
+
+Json::Value SGXInfoServer::startSEKRotation() {
+    Json::Value result;
+
+    try {
+        SEKRotation::start();
+        sekRotationStatus(result);
+    } HANDLE_SGX_EXCEPTION(result)
+
+    RETURN_SUCCESS(result)
+}
+
+Json::Value SGXInfoServer::getSEKRotationStatus() {
+    Json::Value result;
+
+    try {
+        sekRotationStatus(result);
+    } HANDLE_SGX_EXCEPTION(result)
+
+    RETURN_SUCCESS(result)
+}
+
+Json::Value SGXInfoServer::getCpuProfile(int seconds) {
+    Json::Value result;
+
+    try {
+        result = Profiler::profile(seconds < 0 ? 0 : seconds);
+    } HANDLE_SGX_EXCEPTION(result)
+
+    RETURN_SUCCESS(result)
+}
+
+void SGXInfoServer::initInfoServer(uint32_t _logLevel, bool _autoSign, bool _checkCerts, bool _generateTestKeys,
+                                   uint64_t _numThreads) {
+    httpServer = make_shared<HttpServer>(BASE_PORT + 4, "", "", "", false, _numThreads);
     server = make_shared<SGXInfoServer>(*httpServer, JSONRPC_SERVER_V2, _logLevel, _autoSign, _checkCerts, _generateTestKeys); // hybrid server (json-rpc 1.0 & 2.0)
 
     spdlog::info("Starting info server on port {} ...", BASE_PORT + 4);
@@ -26,6 +26,7 @@
 
 #include <mutex>
 
+#include "sgxwallet_common.h"
 #include "abstractinfoserver.h"
 #include <jsonrpccpp/server/connectors/httpserver.h>
 
@@ -59,7 +60,45 @@ public:
 
     virtual Json::Value isKeyExist(const string& key);
 
-    static void initInfoServer(uint32_t _logLevel, bool _autoSign, bool _checkCerts, bool _generateTestKeys);
+    // keyNames is an array of up to MAX_KEY_NAMES_BATCH_SIZE names, all read from one snapshot
+    virtual Json::Value areKeysExist(const Json::Value& keyNames);
+
+    virtual Json::Value getKeysMetadata(const Json::Value& keyNames);
+
+    // sign count, last use and average sign latency of each key, see KeyStats.h
+    virtual Json::Value getKeyStatistics(const Json::Value& keyNames);
+
+    // calls, wall, ECALL and database write time per DKG phase of each poly, see DKGTimeline.h
+    virtual Json::Value getDKGTimeline(const Json::Value& polyNames);
+
+    // answered from atomics only, without the enclave or the database, see Readiness.h
+    virtual Json::Value getReadiness();
+
+    virtual Json::Value getCacheStatistics();
+
+    virtual Json::Value getKeysPage(const string& prefix, const string& cursor, int limit);
+
+    // the keys a cluster follower copies, in creation time order, see KeyStoreReplicator.h
+    virtual Json::Value getReplicationPage(const string& cursor, int limit);
+
+    // switches timing of ECALLs exported by the metrics server, they are always counted
+    virtual Json::Value setEcallTiming(bool enabled);
+
+    // schain groups and weights of the ZMQ sign scheduling, see zmq_src/SchainPartitions.h
+    virtual Json::Value setSchainPartitions(const Json::Value& partitions);
+
+    virtual Json::Value getSchainPartitions();
+
+    // starts an online SEK rotation, the new backup key is written to sgx_data/sgxwallet_backup_key.txt
+    virtual Json::Value startSEKRotation();
+
+    virtual Json::Value getSEKRotationStatus();
+
+    // samples all host threads for the given time, see Profiler.h
+    virtual Json::Value getCpuProfile(int seconds);
+
+    static void initInfoServer(uint32_t _logLevel, bool _autoSign, bool _checkCerts, bool _generateTestKeys,
+                               uint64_t _numThreads = NUM_ADMIN_SERVER_THREADS);
 
     static int exitServer();
 
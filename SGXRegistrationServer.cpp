@@ -41,6 +41,7 @@
 #include <functional>
 
 #include "SGXRegistrationServer.h"
+#include "CertSigner.h"
 #include "LevelDB.h"
 
 #include "Log.h"
@@ -66,44 +67,20 @@ Json::Value SGXRegistrationServer::SignCertificate(const string &csr) {
     result["result"] = false;
 
     try {
-        std::lock_guard<std::mutex> lock(m);
-
         string hash = cryptlite::sha256::hash_hex(csr);
 
-        if (system("ls " CERT_DIR "/" CERT_CREATE_COMMAND) != 0) {
-            spdlog::error("cert/create_client_cert does not exist");
-            throw SGXException(FAIL_TO_CREATE_CERTIFICATE, "CLIENT CERTIFICATE GENERATION FAILED");
-        }
-
-        string csr_name = string(CERT_DIR) + "/" + hash + ".csr";
-        ofstream outfile(csr_name);
-        outfile.exceptions(std::ifstream::failbit | std::ifstream::badbit);
-        outfile << csr << endl;
-        outfile.close();
-
-        if (system(("ls " + csr_name).c_str()) != 0) {
-            spdlog::error("could not create csr file");
-            throw SGXException(FAIL_TO_CREATE_CERTIFICATE, "CLIENT CERTIFICATE GENERATION FAILED");
-        }
-
-        if (system(("openssl req -in " + csr_name).c_str()) != 0) {
+        if (!CertSigner::isValidCSR(csr)) {
             spdlog::error("Incorrect CSR format: {}", csr);
             throw SGXException(FAIL_TO_CREATE_CERTIFICATE, "Incorrect CSR format ");
         }
 
         if (autoSign) {
-            string genCert = string("cd ") + CERT_DIR + "&& ./"
-                    + CERT_CREATE_COMMAND + " " + hash ;
-
-            if (system(genCert.c_str()) == 0) {
-                spdlog::info("Client cert " + hash + " generated");
-            } else {
-                spdlog::error("Client cert generation failed: {} ", genCert);
-                throw SGXException(FAIL_TO_CREATE_CERTIFICATE, "CLIENT CERTIFICATE GENERATION FAILED");
-            }
+            auto cert = CertSigner::signCSR(csr);
+            LevelDB::getCsrStatusDb()->writeDataUnique("CSR:HASH:" + hash + "CERT:", cert);
+            spdlog::info("Client cert " + hash + " generated");
         } else {
             string db_key = "CSR:HASH:" + hash;
-            LevelDB::getCsrStatusDb()->writeDataUnique(db_key, csr);
+            LevelDB::getCsrDb()->writeDataUnique(db_key, csr);
         }
         string db_key = "CSR:HASH:" + hash + "STATUS:";
         string status = "0";
@@ -132,18 +109,20 @@ Json::Value SGXRegistrationServer::GetCertificate(const string &hash) {
         int status = atoi(status_str_ptr->c_str());
 
         if (status == 0) {
-            string crtPath = "cert/" + hash + ".crt";
+            auto cert_ptr = LevelDB::getCsrStatusDb()->readString("CSR:HASH:" + hash + "CERT:");
 
-            if (system(("ls " + crtPath).c_str()) != 0) {
-                throw SGXException(FILE_NOT_FOUND, "Certificate does not exist");
+            if (cert_ptr) {
+                cert = *cert_ptr;
+            } else {
+                // certs signed by earlier versions are files written by cert/create_client_cert
+                ifstream infile(string(CERT_DIR) + "/" + hash + ".crt");
+                if (!infile.good()) {
+                    throw SGXException(FILE_NOT_FOUND, "Certificate does not exist");
+                }
+                ostringstream ss;
+                ss << infile.rdbuf();
+                cert = ss.str();
             }
-
-            ifstream infile(crtPath);
-            infile.exceptions(std::ifstream::failbit | std::ifstream::badbit);
-            ostringstream ss;
-            ss << infile.rdbuf();
-            infile.close();
-            cert = ss.str();
         }
 
         result["status"] = status;
@@ -154,8 +133,10 @@ Json::Value SGXRegistrationServer::GetCertificate(const string &hash) {
     RETURN_SUCCESS(result)
 }
 
-void SGXRegistrationServer::initRegistrationServer(bool _autoSign) {
-    httpServer = make_shared<HttpServer>(BASE_PORT + 1);
+void SGXRegistrationServer::initRegistrationServer(bool _autoSign, uint64_t _numThreads) {
+    CertSigner::init(string(SGXDATA_FOLDER) + "cert_data/rootCA.pem", string(SGXDATA_FOLDER) + "cert_data/rootCA.key");
+
+    httpServer = make_shared<HttpServer>(BASE_PORT + 1, "", "", "", false, _numThreads);
     server = make_shared<SGXRegistrationServer>(*httpServer,
                                                 JSONRPC_SERVER_V2,
                                                 _autoSign); // hybrid server (json-rpc 1.0 & 2.0)
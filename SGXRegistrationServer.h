@@ -27,19 +27,18 @@
 
 #include <mutex>
 
+#include "sgxwallet_common.h"
 #include "abstractregserver.h"
 #include <jsonrpccpp/server/connectors/httpserver.h>
 
 
 #define CERT_DIR "cert"
-#define CERT_CREATE_COMMAND "create_client_cert"
 
 
 using namespace jsonrpc;
 using namespace std;
 
 class SGXRegistrationServer : public AbstractRegServer {
-    mutex m;
     bool autoSign;
 
     static shared_ptr <HttpServer> httpServer;
@@ -56,7 +55,7 @@ public:
 
     virtual Json::Value GetCertificate(const string &hash);
 
-    static void initRegistrationServer(bool _autoSign = false);
+    static void initRegistrationServer(bool _autoSign = false, uint64_t _numThreads = NUM_ADMIN_SERVER_THREADS);
 
     static int exitServer();
 };
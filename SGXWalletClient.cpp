@@ -0,0 +1,602 @@
+/*
+    Copyright (C) 2021-Present SKALE Labs
+
+    This file is part of sgxwallet.
+
+    sgxwallet is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as published
+    by the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    sgxwallet is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with sgxwallet. If not, see <https://www.gnu.org/licenses/>.
+
+    @file SGXWalletClient.cpp
+    @author Stan Kladko
+    @date 2021
+*/
+
+
+#include <chrono>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include <zmq.h>
+
+#include "sgxwallet_client.h"
+
+using namespace std;
+
+// Only libzmq and the standard library are used here, so the library links into skaled without
+// jsoncpp, rapidjson, spdlog or OpenSSL. The wire format is the one of ZMQClient, see ZMQMessage.h.
+
+struct sgxwallet_client {
+    void *ctx = nullptr;
+    void *socket = nullptr;
+    uint32_t timeoutMs = SGXWALLET_CLIENT_DEFAULT_TIMEOUT_MS;
+    uint64_t nextReqId = 1;
+    // ids of submitted async requests that were not received yet
+    vector<uint64_t> pending;
+    // request and reply buffers keep their capacity between calls
+    string request;
+    zmq_msg_t reply;
+    string error;
+};
+
+namespace {
+
+uint64_t nowMs() {
+    return chrono::duration_cast<chrono::milliseconds>(chrono::system_clock::now().time_since_epoch()).count();
+}
+
+int fail(sgxwallet_client *_c, int _status, const char *_message) {
+    _c->error = _message;
+    return _status;
+}
+
+// key names and hashes are plain ASCII, anything that would need escaping is refused
+bool appendQuoted(string &_out, const char *_value) {
+    if (!_value) {
+        return false;
+    }
+    for (auto p = _value; *p; p++) {
+        if (*p == '"' || *p == '\\' || (unsigned char) *p < 0x20) {
+            return false;
+        }
+    }
+    _out.append("\"").append(_value).append("\"");
+    return true;
+}
+
+bool appendString(string &_out, const char *_name, const char *_value) {
+    _out.append(",\"").append(_name).append("\":");
+    return appendQuoted(_out, _value);
+}
+
+void appendInt(string &_out, const char *_name, int64_t _value) {
+    _out.append(",\"").append(_name).append("\":").append(to_string(_value));
+}
+
+void beginRequest(sgxwallet_client *_c, const char *_type) {
+    _c->request.clear();
+    _c->request.append("{\"type\":\"").append(_type).append("\"");
+}
+
+uint64_t endRequest(sgxwallet_client *_c) {
+    auto reqId = _c->nextReqId++;
+    // the server drops the request instead of processing it after the client stopped waiting
+    appendInt(_c->request, "deadline", (int64_t) (nowMs() + _c->timeoutMs));
+    appendInt(_c->request, "reqId", (int64_t) reqId);
+    _c->request.push_back('}');
+    return reqId;
+}
+
+// Replies are flat objects written by the server, so a member is found by its quoted name.
+// Escaped quotes inside string values can not match. Returns the position of the value.
+const char *findMember(const char *_begin, const char *_end, const char *_name) {
+    auto nameLen = strlen(_name);
+    for (auto p = _begin; p + nameLen + 3 <= _end; p++) {
+        if (p[0] == '"' && memcmp(p + 1, _name, nameLen) == 0 && p[nameLen + 1] == '"' && p[nameLen + 2] == ':') {
+            return p + nameLen + 3;
+        }
+    }
+    return nullptr;
+}
+
+bool scanInt(const char *_p, const char *_end, int64_t &_value) {
+    bool negative = _p < _end && *_p == '-';
+    if (negative) {
+        _p++;
+    }
+    if (_p == _end || *_p < '0' || *_p > '9') {
+        return false;
+    }
+    uint64_t v = 0;
+    for (; _p < _end && *_p >= '0' && *_p <= '9'; _p++) {
+        v = v * 10 + (*_p - '0');
+    }
+    _value = negative ? -(int64_t) v : (int64_t) v;
+    return true;
+}
+
+// Scans the string value at _p and returns the position after its closing quote. Simple escapes
+// are decoded, \u escapes are replaced by '?'. With _skip, _outLen bytes after _skip are appended
+// and the first _skip characters are dropped, which removes the 0x of ECDSA r and s.
+const char *scanString(const char *_p, const char *_end, string &_out, size_t _skip = 0) {
+    if (_p >= _end || *_p != '"') {
+        return nullptr;
+    }
+    size_t n = 0;
+    for (_p++; _p < _end; _p++) {
+        char ch = *_p;
+        if (ch == '"') {
+            return _p + 1;
+        }
+        if (ch == '\\') {
+            if (++_p >= _end) {
+                return nullptr;
+            }
+            switch (*_p) {
+                case 'n': ch = '\n'; break;
+                case 't': ch = '\t'; break;
+                case 'r': ch = '\r'; break;
+                case 'b': ch = '\b'; break;
+                case 'f': ch = '\f'; break;
+                case 'u':
+                    if (_end - _p < 5) {
+                        return nullptr;
+                    }
+                    _p += 4;
+                    ch = '?';
+                    break;
+                default: ch = *_p; break;
+            }
+        }
+        if (n++ >= _skip) {
+            _out.push_back(ch);
+        }
+    }
+    return nullptr;
+}
+
+const char *scanArrayElement(const char *_p, const char *_end, size_t _i, string &_out, size_t _skip = 0) {
+    if (_p >= _end || *_p != '[') {
+        return nullptr;
+    }
+    _p++;
+    for (size_t i = 0; _p && _p < _end && *_p != ']'; i++) {
+        if (i == _i) {
+            return scanString(_p, _end, _out, _skip);
+        }
+        string ignored;
+        _p = scanString(_p, _end, ignored);
+        if (_p && _p < _end && *_p == ',') {
+            _p++;
+        }
+    }
+    return nullptr;
+}
+
+int copyOut(sgxwallet_client *_c, const string &_value, char *_out, size_t _outLen) {
+    if (!_out || _value.size() >= _outLen) {
+        return fail(_c, SGXWALLET_CLIENT_BUFFER_TOO_SMALL, "Result does not fit into the output buffer");
+    }
+    memcpy(_out, _value.data(), _value.size());
+    _out[_value.size()] = 0;
+    return SGXWALLET_CLIENT_OK;
+}
+
+const char *replyBegin(sgxwallet_client *_c) {
+    return (const char *) zmq_msg_data(&_c->reply);
+}
+
+const char *replyEnd(sgxwallet_client *_c) {
+    return replyBegin(_c) + zmq_msg_size(&_c->reply);
+}
+
+// status of the received reply, with the error message of the node on failure
+int replyStatus(sgxwallet_client *_c) {
+    auto begin = replyBegin(_c), end = replyEnd(_c);
+    int64_t status;
+    auto p = findMember(begin, end, "status");
+    if (!p || !scanInt(p, end, status)) {
+        return fail(_c, SGXWALLET_CLIENT_BAD_REPLY, "Reply has no status");
+    }
+    if (status != 0) {
+        _c->error.clear();
+        p = findMember(begin, end, "errorMessage");
+        if (!p || !scanString(p, end, _c->error)) {
+            _c->error = "Request failed";
+        }
+    }
+    return (int) status;
+}
+
+bool replyReqId(sgxwallet_client *_c, uint64_t &_reqId) {
+    int64_t reqId;
+    auto p = findMember(replyBegin(_c), replyEnd(_c), "reqId");
+    if (!p || !scanInt(p, replyEnd(_c), reqId) || reqId < 0) {
+        return false;
+    }
+    _reqId = (uint64_t) reqId;
+    return true;
+}
+
+// element _i of the ECDSA signature in v:r:s form, as ZMQClient returns it
+bool scanEcdsaSignature(sgxwallet_client *_c, bool _array, size_t _i, string &_out) {
+    auto begin = replyBegin(_c), end = replyEnd(_c);
+    const char *names[] = {"signature_v", "signature_r", "signature_s"};
+    _out.clear();
+    for (int j = 0; j < 3; j++) {
+        auto p = findMember(begin, end, names[j]);
+        if (j > 0) {
+            _out.push_back(':');
+        }
+        size_t skip = j > 0 ? 2 : 0;
+        if (!p || !(_array ? scanArrayElement(p, end, _i, _out, skip) : scanString(p, end, _out, skip))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+int send(sgxwallet_client *_c) {
+    if (zmq_send(_c->socket, _c->request.data(), _c->request.size(), 0) < 0) {
+        return fail(_c, SGXWALLET_CLIENT_ZMQ_ERROR, zmq_strerror(zmq_errno()));
+    }
+    return SGXWALLET_CLIENT_OK;
+}
+
+// waits for the next reply until _deadline, a reply without a reqId is not ours
+int receive(sgxwallet_client *_c, uint64_t _deadline, uint64_t &_reqId) {
+    while (true) {
+        auto now = nowMs();
+        zmq_pollitem_t item = {_c->socket, 0, ZMQ_POLLIN, 0};
+        auto rc = zmq_poll(&item, 1, (long) (_deadline > now ? _deadline - now : 0));
+        if (rc < 0 && zmq_errno() != EINTR) {
+            return fail(_c, SGXWALLET_CLIENT_ZMQ_ERROR, zmq_strerror(zmq_errno()));
+        }
+        if (rc <= 0) {
+            if (nowMs() >= _deadline) {
+                return fail(_c, SGXWALLET_CLIENT_TIMEOUT, "No reply from sgxwallet");
+            }
+            continue;
+        }
+        if (zmq_msg_recv(&_c->reply, _c->socket, 0) < 0) {
+            return fail(_c, SGXWALLET_CLIENT_ZMQ_ERROR, zmq_strerror(zmq_errno()));
+        }
+        if (replyReqId(_c, _reqId)) {
+            return SGXWALLET_CLIENT_OK;
+        }
+    }
+}
+
+// sends the request and waits for its reply, late replies of earlier requests are dropped
+int requestReply(sgxwallet_client *_c, uint64_t _reqId) {
+    if (!_c->pending.empty()) {
+        return fail(_c, SGXWALLET_CLIENT_ASYNC_PENDING, "Async requests are pending");
+    }
+    auto status = send(_c);
+    if (status != SGXWALLET_CLIENT_OK) {
+        return status;
+    }
+    auto deadline = nowMs() + _c->timeoutMs;
+    uint64_t reqId;
+    do {
+        status = receive(_c, deadline, reqId);
+        if (status != SGXWALLET_CLIENT_OK) {
+            return status;
+        }
+    } while (reqId != _reqId);
+    return replyStatus(_c);
+}
+
+bool buildBlsSign(sgxwallet_client *_c, const char *_keyShareName, const char *_messageHash, int _t, int _n) {
+    beginRequest(_c, "BLSSignReq");
+    if (!appendString(_c->request, "keyShareName", _keyShareName) ||
+        !appendString(_c->request, "messageHash", _messageHash)) {
+        return false;
+    }
+    appendInt(_c->request, "n", _n);
+    appendInt(_c->request, "t", _t);
+    return true;
+}
+
+bool buildEcdsaSign(sgxwallet_client *_c, int _base, const char *_keyName, const char *_messageHash) {
+    beginRequest(_c, "ECDSASignReq");
+    if (!appendString(_c->request, "keyName", _keyName) ||
+        !appendString(_c->request, "messageHash", _messageHash)) {
+        return false;
+    }
+    appendInt(_c->request, "base", _base);
+    return true;
+}
+
+int submit(sgxwallet_client *_c, uint64_t *_reqId) {
+    auto reqId = endRequest(_c);
+    auto status = send(_c);
+    if (status != SGXWALLET_CLIENT_OK) {
+        return status;
+    }
+    _c->pending.push_back(reqId);
+    if (_reqId) {
+        *_reqId = reqId;
+    }
+    return SGXWALLET_CLIENT_OK;
+}
+
+}
+
+extern "C" {
+
+sgxwallet_client *sgxwallet_client_new(const char *_url, const char *_curveServerKey,
+                                       const char *_curvePublicKey, const char *_curveSecretKey) {
+    if (!_url || (!_curveServerKey && (_curvePublicKey || _curveSecretKey)) ||
+        (!_curvePublicKey != !_curveSecretKey)) {
+        return nullptr;
+    }
+
+    auto c = new sgxwallet_client();
+    zmq_msg_init(&c->reply);
+    c->request.reserve(1024);
+    c->pending.reserve(64);
+
+    c->ctx = zmq_ctx_new();
+    c->socket = c->ctx ? zmq_socket(c->ctx, ZMQ_DEALER) : nullptr;
+    if (!c->socket) {
+        sgxwallet_client_free(c);
+        return nullptr;
+    }
+
+    int linger = 0;
+    zmq_setsockopt(c->socket, ZMQ_LINGER, &linger, sizeof(linger));
+
+    if (_curveServerKey) {
+        char publicBuf[41], secretBuf[41];
+        if (!_curvePublicKey) {
+            if (zmq_curve_keypair(publicBuf, secretBuf) != 0) {
+                sgxwallet_client_free(c);
+                return nullptr;
+            }
+            _curvePublicKey = publicBuf;
+            _curveSecretKey = secretBuf;
+        }
+        if (zmq_setsockopt(c->socket, ZMQ_CURVE_SERVERKEY, _curveServerKey, strlen(_curveServerKey)) != 0 ||
+            zmq_setsockopt(c->socket, ZMQ_CURVE_PUBLICKEY, _curvePublicKey, strlen(_curvePublicKey)) != 0 ||
+            zmq_setsockopt(c->socket, ZMQ_CURVE_SECRETKEY, _curveSecretKey, strlen(_curveSecretKey)) != 0) {
+            sgxwallet_client_free(c);
+            return nullptr;
+        }
+    }
+
+    if (zmq_connect(c->socket, _url) != 0) {
+        sgxwallet_client_free(c);
+        return nullptr;
+    }
+
+    return c;
+}
+
+void sgxwallet_client_free(sgxwallet_client *_client) {
+    if (!_client) {
+        return;
+    }
+    if (_client->socket) {
+        zmq_close(_client->socket);
+    }
+    if (_client->ctx) {
+        zmq_ctx_term(_client->ctx);
+    }
+    zmq_msg_close(&_client->reply);
+    delete _client;
+}
+
+void sgxwallet_client_set_timeout(sgxwallet_client *_client, uint32_t _timeoutMs) {
+    if (_client && _timeoutMs > 0) {
+        _client->timeoutMs = _timeoutMs;
+    }
+}
+
+const char *sgxwallet_client_error(const sgxwallet_client *_client) {
+    return _client ? _client->error.c_str() : "";
+}
+
+int sgxwallet_bls_sign(sgxwallet_client *_client, const char *_keyShareName, const char *_messageHash,
+                       int _t, int _n, char *_out, size_t _outLen) {
+    if (!_client) {
+        return SGXWALLET_CLIENT_INVALID_ARGUMENT;
+    }
+    if (!buildBlsSign(_client, _keyShareName, _messageHash, _t, _n)) {
+        return fail(_client, SGXWALLET_CLIENT_INVALID_ARGUMENT, "Invalid key name or hash");
+    }
+    auto status = requestReply(_client, endRequest(_client));
+    if (status != SGXWALLET_CLIENT_OK) {
+        return status;
+    }
+    string share;
+    auto p = findMember(replyBegin(_client), replyEnd(_client), "signatureShare");
+    if (!p || !scanString(p, replyEnd(_client), share)) {
+        return fail(_client, SGXWALLET_CLIENT_BAD_REPLY, "Reply has no signatureShare");
+    }
+    return copyOut(_client, share, _out, _outLen);
+}
+
+int sgxwallet_ecdsa_sign(sgxwallet_client *_client, int _base, const char *_keyName, const char *_messageHash,
+                         char *_out, size_t _outLen) {
+    if (!_client) {
+        return SGXWALLET_CLIENT_INVALID_ARGUMENT;
+    }
+    if (!buildEcdsaSign(_client, _base, _keyName, _messageHash)) {
+        return fail(_client, SGXWALLET_CLIENT_INVALID_ARGUMENT, "Invalid key name or hash");
+    }
+    auto status = requestReply(_client, endRequest(_client));
+    if (status != SGXWALLET_CLIENT_OK) {
+        return status;
+    }
+    string signature;
+    if (!scanEcdsaSignature(_client, false, 0, signature)) {
+        return fail(_client, SGXWALLET_CLIENT_BAD_REPLY, "Reply has no signature");
+    }
+    return copyOut(_client, signature, _out, _outLen);
+}
+
+int sgxwallet_bls_sign_batch(sgxwallet_client *_client, const char *const *_keyShareNames,
+                             const char *const *_messageHashes, int _t, int _n, size_t _count,
+                             char *const *_out, size_t _outLen) {
+    if (!_client) {
+        return SGXWALLET_CLIENT_INVALID_ARGUMENT;
+    }
+    if (_count == 0 || !_keyShareNames || !_messageHashes || !_out) {
+        return fail(_client, SGXWALLET_CLIENT_INVALID_ARGUMENT, "Empty batch");
+    }
+
+    beginRequest(_client, "BLSSignBatchReq");
+    _client->request.append(",\"requests\":[");
+    for (size_t i = 0; i < _count; i++) {
+        auto &r = _client->request;
+        r.append(i == 0 ? "{\"keyShareName\":" : ",{\"keyShareName\":");
+        if (!appendQuoted(r, _keyShareNames[i]) || !appendString(r, "messageHash", _messageHashes[i])) {
+            return fail(_client, SGXWALLET_CLIENT_INVALID_ARGUMENT, "Invalid key name or hash");
+        }
+        appendInt(r, "t", _t);
+        appendInt(r, "n", _n);
+        r.push_back('}');
+    }
+    _client->request.push_back(']');
+
+    auto status = requestReply(_client, endRequest(_client));
+    if (status != SGXWALLET_CLIENT_OK) {
+        return status;
+    }
+    auto p = findMember(replyBegin(_client), replyEnd(_client), "signatureShares");
+    string share;
+    for (size_t i = 0; i < _count; i++) {
+        share.clear();
+        if (!p || !scanArrayElement(p, replyEnd(_client), i, share)) {
+            return fail(_client, SGXWALLET_CLIENT_BAD_REPLY, "Reply has too few signatureShares");
+        }
+        status = copyOut(_client, share, _out[i], _outLen);
+        if (status != SGXWALLET_CLIENT_OK) {
+            return status;
+        }
+    }
+    return SGXWALLET_CLIENT_OK;
+}
+
+int sgxwallet_ecdsa_sign_batch(sgxwallet_client *_client, int _base, const char *_keyName,
+                               const char *const *_messageHashes, size_t _count,
+                               char *const *_out, size_t _outLen) {
+    if (!_client) {
+        return SGXWALLET_CLIENT_INVALID_ARGUMENT;
+    }
+    if (_count == 0 || !_messageHashes || !_out) {
+        return fail(_client, SGXWALLET_CLIENT_INVALID_ARGUMENT, "Empty batch");
+    }
+
+    beginRequest(_client, "ECDSASignBatchReq");
+    appendInt(_client->request, "base", _base);
+    if (!appendString(_client->request, "keyName", _keyName)) {
+        return fail(_client, SGXWALLET_CLIENT_INVALID_ARGUMENT, "Invalid key name");
+    }
+    _client->request.append(",\"messageHashes\":[");
+    for (size_t i = 0; i < _count; i++) {
+        if (i > 0) {
+            _client->request.push_back(',');
+        }
+        if (!appendQuoted(_client->request, _messageHashes[i])) {
+            return fail(_client, SGXWALLET_CLIENT_INVALID_ARGUMENT, "Invalid hash");
+        }
+    }
+    _client->request.push_back(']');
+
+    auto status = requestReply(_client, endRequest(_client));
+    if (status != SGXWALLET_CLIENT_OK) {
+        return status;
+    }
+    string signature;
+    for (size_t i = 0; i < _count; i++) {
+        if (!scanEcdsaSignature(_client, true, i, signature)) {
+            return fail(_client, SGXWALLET_CLIENT_BAD_REPLY, "Reply has too few signatures");
+        }
+        status = copyOut(_client, signature, _out[i], _outLen);
+        if (status != SGXWALLET_CLIENT_OK) {
+            return status;
+        }
+    }
+    return SGXWALLET_CLIENT_OK;
+}
+
+int sgxwallet_bls_sign_submit(sgxwallet_client *_client, const char *_keyShareName, const char *_messageHash,
+                              int _t, int _n, uint64_t *_reqId) {
+    if (!_client) {
+        return SGXWALLET_CLIENT_INVALID_ARGUMENT;
+    }
+    if (!buildBlsSign(_client, _keyShareName, _messageHash, _t, _n)) {
+        return fail(_client, SGXWALLET_CLIENT_INVALID_ARGUMENT, "Invalid key name or hash");
+    }
+    return submit(_client, _reqId);
+}
+
+int sgxwallet_ecdsa_sign_submit(sgxwallet_client *_client, int _base, const char *_keyName,
+                                const char *_messageHash, uint64_t *_reqId) {
+    if (!_client) {
+        return SGXWALLET_CLIENT_INVALID_ARGUMENT;
+    }
+    if (!buildEcdsaSign(_client, _base, _keyName, _messageHash)) {
+        return fail(_client, SGXWALLET_CLIENT_INVALID_ARGUMENT, "Invalid key name or hash");
+    }
+    return submit(_client, _reqId);
+}
+
+int sgxwallet_client_receive(sgxwallet_client *_client, int _timeoutMs, uint64_t *_reqId,
+                             char *_out, size_t _outLen) {
+    if (!_client || !_reqId) {
+        return SGXWALLET_CLIENT_INVALID_ARGUMENT;
+    }
+
+    auto &pending = _client->pending;
+    auto deadline = nowMs() + (_timeoutMs > 0 ? (uint64_t) _timeoutMs : 0);
+    while (true) {
+        uint64_t reqId;
+        auto status = receive(_client, deadline, reqId);
+        if (status != SGXWALLET_CLIENT_OK) {
+            return status;
+        }
+        size_t i = 0;
+        while (i < pending.size() && pending[i] != reqId) {
+            i++;
+        }
+        // the late reply of a blocking request that timed out
+        if (i == pending.size()) {
+            continue;
+        }
+        pending[i] = pending.back();
+        pending.pop_back();
+        *_reqId = reqId;
+        break;
+    }
+
+    auto status = replyStatus(_client);
+    if (status != SGXWALLET_CLIENT_OK) {
+        return status;
+    }
+
+    string result;
+    auto p = findMember(replyBegin(_client), replyEnd(_client), "signatureShare");
+    if (p ? !scanString(p, replyEnd(_client), result) : !scanEcdsaSignature(_client, false, 0, result)) {
+        return fail(_client, SGXWALLET_CLIENT_BAD_REPLY, "Reply has no signature");
+    }
+    return copyOut(_client, result, _out, _outLen);
+}
+
+size_t sgxwallet_client_pending(const sgxwallet_client *_client) {
+    return _client ? _client->pending.size() : 0;
+}
+
+}
@@ -21,8 +21,10 @@
     @date 2019
 */
 
+#include <atomic>
 #include <chrono>
 #include <iostream>
+#include <set>
 #include <thread>
 
 #include "abstractstubserver.h"
@@ -31,6 +33,8 @@
 #include <algorithm>
 #include <stdlib.h>
 #include <unistd.h>
+#include <json/json.h>
+#include <third_party/cryptlite/sha256.h>
 
 #include "sgxwallet_common.h"
 #include "sgxwallet.h"
@@ -39,26 +43,32 @@
 #include "LevelDB.h"
 #include "BLSCrypto.h"
 #include "DKGCrypto.h"
+#include "G2Codec.h"
 #include "ECDSACrypto.h"
+#include "ECDSAKeyPool.h"
 #include "TECrypto.h"
+#include "CryptoTools.h"
 
+#include "EventHttpServer.h"
 #include "SGXWalletServer.h"
 #include "SGXWalletServer.hpp"
 
 #include "ServerDataChecker.h"
+#include "KeyHandles.h"
 #include "ServerInit.h"
+#include "zmq_src/ZMQServer.h"
+#include "zmq_src/CertVerifier.h"
 
 #include "Log.h"
-
-#ifdef SGX_HW_SIM
-#define NUM_THREADS 8
-#else
-#define NUM_THREADS 200
-#endif
+#include "Metrics.h"
+#include "KeyWarmUp.h"
+#include "KeyStats.h"
+#include "Bulkhead.h"
+#include "DKGTimeline.h"
 
 using namespace std;
 
-std::shared_timed_mutex sgxInitMutex;
+EnclaveEpoch sgxInitMutex;
 
 uint64_t initTime;
 
@@ -98,7 +108,11 @@ bool isStringDec(const string &_str) {
 }
 
 shared_ptr <SGXWalletServer> SGXWalletServer::server = nullptr;
-shared_ptr <HttpServer> SGXWalletServer::httpServer = nullptr;
+shared_ptr <AbstractServerConnector> SGXWalletServer::httpServer = nullptr;
+shared_ptr <JsonRpcBatchHandler> SGXWalletServer::batchHandler = nullptr;
+uint64_t SGXWalletServer::numHttpThreads = NUM_HTTP_SERVER_THREADS;
+uint64_t SGXWalletServer::maxHttpInFlight = 0;
+bool SGXWalletServer::eventHttp = false;
 
 SGXWalletServer::SGXWalletServer(AbstractServerConnector &_connector,
                                  serverVersion_t _type)
@@ -120,8 +134,7 @@ void SGXWalletServer::printDB() {
 
 bool SGXWalletServer::verifyCert(string &_certFileName) {
     string rootCAPath = string(SGXDATA_FOLDER) + "cert_data/rootCA.pem";
-    string verifyCert = "cert/verify_client_cert " + rootCAPath + " " + _certFileName;
-    return system(verifyCert.c_str()) == 0;
+    return CertVerifier::verifyFile(rootCAPath, _certFileName);
 }
 
 void SGXWalletServer::createCertsIfNeeded() {
@@ -169,22 +182,72 @@ void SGXWalletServer::createCertsIfNeeded() {
     }
 }
 
+void SGXWalletServer::setHttpThreadsConfig(uint64_t _numThreads, uint64_t _maxInFlight) {
+    if (_numThreads == 0 || _numThreads > MAX_HTTP_SERVER_THREADS) {
+        throw SGXException(INVALID_HTTP_SERVER_THREADS_NUMBER, string(__FUNCTION__) +
+                           ":Number of http server threads has to be between 1 and " + to_string(MAX_HTTP_SERVER_THREADS));
+    }
+
+    if (_maxInFlight > _numThreads) {
+        throw SGXException(INVALID_HTTP_SERVER_THREADS_NUMBER, string(__FUNCTION__) +
+                           ":Max number of requests in flight can not exceed the number of http server threads");
+    }
+
+    numHttpThreads = _numThreads;
+    maxHttpInFlight = _maxInFlight;
+}
+
+uint64_t SGXWalletServer::getHttpRequests() {
+    return batchHandler ? batchHandler->getRequests() : 0;
+}
+
+uint64_t SGXWalletServer::getHttpCalls() {
+    return batchHandler ? batchHandler->getCalls() : 0;
+}
+
+uint64_t SGXWalletServer::getHttpRejected() {
+    return batchHandler ? batchHandler->getRejected() : 0;
+}
+
+uint64_t SGXWalletServer::getHttpRateLimited() {
+    return batchHandler ? batchHandler->getRateLimited() : 0;
+}
+
+void SGXWalletServer::installBatchHandler() {
+    CHECK_STATE(httpServer && httpServer->GetHandler());
+    batchHandler = make_shared<JsonRpcBatchHandler>(*httpServer->GetHandler(), maxHttpInFlight);
+    httpServer->SetHandler(batchHandler.get());
+}
+
+shared_ptr<AbstractServerConnector> SGXWalletServer::makeHttpServer(int _port, const string &_certPath,
+                                                                   const string &_keyPath, const string &_rootCAPath,
+                                                                   bool _checkCerts) {
+    if (eventHttp) {
+        spdlog::info("Using event driven http server with {} I/O threads", NUM_EVENT_HTTP_IO_THREADS);
+        return make_shared<EventHttpServer>(_port, _certPath, _keyPath, _rootCAPath, _checkCerts,
+                                            NUM_EVENT_HTTP_IO_THREADS, numHttpThreads);
+    }
+
+    return make_shared<HttpServer>(_port, _certPath, _keyPath, _rootCAPath, _checkCerts, numHttpThreads);
+}
+
 void SGXWalletServer::initHttpsServer(bool _checkCerts) {
     COUNT_STATISTICS
     spdlog::info("Entering {}", __FUNCTION__);
-    spdlog::info("Initing server, number of threads: {}", NUM_THREADS);
+    spdlog::info("Initing server, number of threads: {}", numHttpThreads);
 
     string certPath = string(SGXDATA_FOLDER) + "cert_data/SGXServerCert.crt";
     string keyPath = string(SGXDATA_FOLDER) + "cert_data/SGXServerCert.key";
     string rootCAPath = string(SGXDATA_FOLDER) + "cert_data/rootCA.pem";
     string keyCAPath = string(SGXDATA_FOLDER) + "cert_data/rootCA.key";
 
-    httpServer = make_shared<HttpServer>(BASE_PORT, certPath, keyPath, rootCAPath, _checkCerts,
-                                         NUM_THREADS);
+    httpServer = makeHttpServer(BASE_PORT, certPath, keyPath, rootCAPath, _checkCerts);
 
     server = make_shared<SGXWalletServer>(*httpServer,
                                           JSONRPC_SERVER_V2); // hybrid server (json-rpc 1.0 & 2.0)
 
+    installBatchHandler();
+
     spdlog::info("Starting sgx server on port {} ...", BASE_PORT);
 
     if (!server->StartListening()) {
@@ -201,10 +264,12 @@ void SGXWalletServer::initHttpServer() { //without ssl
 
     spdlog::info("Starting sgx http server on port {} ...", BASE_PORT + 3);
 
-    httpServer = make_shared<HttpServer>(BASE_PORT + 3, "", "", "", false,
-                                         NUM_THREADS);
+    httpServer = makeHttpServer(BASE_PORT + 3, "", "", "", false);
     server = make_shared<SGXWalletServer>(*httpServer,
                                           JSONRPC_SERVER_V2); // hybrid server (json-rpc 1.0 & 2.0)
+
+    installBatchHandler();
+
     if (!server->StartListening()) {
         spdlog::error("Server could not start listening");
         throw SGXException(SGX_SERVER_FAILED_TO_START, "Http server could not start listening.");
@@ -234,6 +299,7 @@ SGXWalletServer::importBLSKeyShareImpl(const string &_keyShare, const string &_k
     string encryptedKeyShareHex;
 
     try {
+        BULKHEAD(ADMIN)
         if (!checkName(_keyShareName, "BLS_KEY")) {
             throw SGXException(BLS_IMPORT_INVALID_KEY_NAME, string(__FUNCTION__) + ":Invalid BLS key name");
         }
@@ -267,71 +333,395 @@ SGXWalletServer::importBLSKeyShareImpl(const string &_keyShare, const string &_k
     RETURN_SUCCESS(result);
 }
 
-map <string, string> SGXWalletServer::blsRequests;
-recursive_mutex SGXWalletServer::blsRequestsLock;
-
-map <string, string> SGXWalletServer::ecdsaRequests;
-recursive_mutex SGXWalletServer::ecdsaRequestsLock;
+static Json::Value keyImportStatus(int _status, const string &_errorMessage) {
+    Json::Value result;
+    result["status"] = _status;
+    result["errorMessage"] = _errorMessage;
+    return result;
+}
 
-void SGXWalletServer::checkForDuplicate(map <string, string> &_map, recursive_mutex &_m,
-                                        const string &_key,
-                                        const string &_value) {
+static string stripHexPrefix(const string &_hex) {
+    if (_hex.size() >= 2 && _hex[0] == '0' && (_hex[1] == 'x' || _hex[1] == 'X')) {
+        return _hex.substr(2);
+    }
+    return _hex;
+}
 
-    LOCK(_m);
-    if (_map.count(_key) && _map.at(_key) == _value) {
-        usleep(100 * 1000);
-        spdlog::warn(string("Received an identical request from the client:") + __FUNCTION__);
+static void checkKeyImportBatch(const Json::Value &_keys, const char *_nameField, const char *_keyField,
+                                const string &_function) {
+    if (!_keys.isArray() || _keys.empty() || _keys.size() > MAX_KEY_IMPORT_BATCH_SIZE) {
+        throw SGXException(INVALID_KEY_IMPORT_BATCH, _function + ":Keys should be a non empty array of at most "
+                                                     + to_string(MAX_KEY_IMPORT_BATCH_SIZE) + " elements");
     }
-    _map[_key] = _value;
+    for (int i = 0; i < (int) _keys.size(); i++) {
+        if (!_keys[i].isObject() || !_keys[i][_nameField].isString() || !_keys[i][_keyField].isString()) {
+            throw SGXException(INVALID_KEY_IMPORT_BATCH, _function + ":Invalid key " + to_string(i));
+        }
+    }
+}
+
+Json::Value SGXWalletServer::importBLSKeyShareBatchImpl(const Json::Value &_keyShares) {
+    COUNT_STATISTICS
+    spdlog::info("Entering {}", __FUNCTION__);
+    INIT_RESULT(result)
+    result["results"] = Json::Value(Json::arrayValue);
+
+    try {
+        BULKHEAD(ADMIN)
+        checkKeyImportBatch(_keyShares, "keyShareName", "keyShare", __FUNCTION__);
+
+        vector<Json::Value> results(_keyShares.size());
+        vector<int> indexes;
+        vector<string> keys;
+
+        for (int i = 0; i < (int) _keyShares.size(); i++) {
+            auto name = _keyShares[i]["keyShareName"].asString();
+            auto key = stripHexPrefix(_keyShares[i]["keyShare"].asString());
+            if (!checkName(name, "BLS_KEY")) {
+                results[i] = keyImportStatus(BLS_IMPORT_INVALID_KEY_NAME, "Invalid BLS key name");
+            } else if (!checkHex(key)) {
+                results[i] = keyImportStatus(BLS_IMPORT_INVALID_KEY_SHARE, "Invalid BLS key share, please use hex");
+            } else {
+                indexes.push_back(i);
+                keys.push_back(key);
+            }
+        }
+
+        if (!keys.empty()) {
+            vector<int> statuses;
+            auto encryptedKeys = encryptBLSKeySharesBatch(keys, statuses);
+
+            vector<int> encrypted;
+            vector<vector<pair<string, string>>> groups;
+            for (uint64_t j = 0; j < keys.size(); j++) {
+                if (statuses[j] != 0) {
+                    results[indexes[j]] = keyImportStatus(statuses[j], "Could not encrypt BLS key share");
+                    continue;
+                }
+                encrypted.push_back(indexes[j]);
+                groups.push_back({{_keyShares[indexes[j]]["keyShareName"].asString(), encryptedKeys[j]}});
+            }
+
+            auto written = LevelDB::getLevelDb()->writeGroupsUnique(groups);
+
+            for (uint64_t j = 0; j < groups.size(); j++) {
+                if (!written[j]) {
+                    results[encrypted[j]] = keyImportStatus(KEY_SHARE_ALREADY_EXISTS,
+                                                            "Key share with this name already exists");
+                    continue;
+                }
+                results[encrypted[j]] = keyImportStatus(0, "");
+                results[encrypted[j]]["encryptedKeyShare"] = groups[j][0].second;
+            }
+        }
+
+        for (auto &&keyResult : results) {
+            result["results"].append(keyResult);
+        }
+    } HANDLE_SGX_EXCEPTION(result)
+
+    RETURN_SUCCESS(result);
+}
+
+Json::Value SGXWalletServer::importECDSAKeyBatchImpl(const Json::Value &_keys) {
+    COUNT_STATISTICS
+    spdlog::info("Entering {}", __FUNCTION__);
+    INIT_RESULT(result)
+    result["results"] = Json::Value(Json::arrayValue);
+
+    try {
+        BULKHEAD(ADMIN)
+        checkKeyImportBatch(_keys, "keyName", "key", __FUNCTION__);
+
+        vector<Json::Value> results(_keys.size());
+        vector<int> indexes;
+        vector<string> keys;
+
+        for (int i = 0; i < (int) _keys.size(); i++) {
+            auto name = _keys[i]["keyName"].asString();
+            auto key = stripHexPrefix(_keys[i]["key"].asString());
+            if (!checkECDSAKeyName(name)) {
+                results[i] = keyImportStatus(INVALID_ECDSA_IMPORT_KEY_NAME, "Invalid ECDSA import key name");
+            } else if (!checkHex(key)) {
+                results[i] = keyImportStatus(INVALID_ECDSA_IMPORT_HEX, "Invalid ECDSA key share, please use hex");
+            } else {
+                indexes.push_back(i);
+                keys.push_back(key);
+            }
+        }
+
+        if (!keys.empty()) {
+            vector<int> statuses;
+            vector<string> publicKeys;
+            auto encryptedKeys = encryptECDSAKeysBatch(keys, statuses, publicKeys);
+
+            vector<int> encrypted;
+            vector<vector<pair<string, string>>> groups;
+            for (uint64_t j = 0; j < keys.size(); j++) {
+                if (statuses[j] != 0) {
+                    results[indexes[j]] = keyImportStatus(statuses[j], "Could not encrypt ECDSA key");
+                    continue;
+                }
+                auto name = _keys[indexes[j]]["keyName"].asString();
+                encrypted.push_back(indexes[j]);
+                groups.push_back({{name, encryptedKeys[j]}, {getECDSAPubKeyName(name), publicKeys[j]}});
+            }
+
+            auto written = LevelDB::getLevelDb()->writeGroupsUnique(groups);
+
+            for (uint64_t j = 0; j < groups.size(); j++) {
+                if (!written[j]) {
+                    results[encrypted[j]] = keyImportStatus(KEY_NAME_ALREADY_EXISTS, "Name already exists");
+                    continue;
+                }
+                results[encrypted[j]] = keyImportStatus(0, "");
+                results[encrypted[j]]["encryptedKey"] = groups[j][0].second;
+                results[encrypted[j]]["publicKey"] = groups[j][1].second;
+            }
+        }
+
+        for (auto &&keyResult : results) {
+            result["results"].append(keyResult);
+        }
+    } HANDLE_SGX_EXCEPTION(result)
+
+    RETURN_SUCCESS(result);
 }
 
+RequestCoalescer SGXWalletServer::blsRequests(REQUEST_COALESCER_MAX_ENTRIES, BLS_SIGN_CACHE_TTL_MS);
+
+RequestCoalescer SGXWalletServer::ecdsaRequests(REQUEST_COALESCER_MAX_ENTRIES, REQUEST_COALESCER_TTL_MS);
+
+RequestCoalescer SGXWalletServer::blsPublicKeysRequests(BLS_PUBLIC_KEYS_CACHE_MAX_ENTRIES, BLS_PUBLIC_KEYS_CACHE_TTL_MS);
+
+bool SGXWalletServer::persistBlsPublicKeys = false;
+
+// a batch of one is signed by the single sign ECALL
+SignBatcher SGXWalletServer::blsSigns("bls", SIGN_BATCH_MAX_REQUESTS, [](const vector<SignBatcher::Request> &_requests) {
+    vector<vector<string>> signatures;
+
+    if (_requests.size() == 1) {
+        vector<char> signature(BUF_LEN, 0);
+        auto &request = _requests[0];
+        if (!bls_sign(request.encryptedKeyHex.c_str(), request.hashHex.c_str(), request.t, request.n, signature.data())) {
+            throw SGXException(COULD_NOT_BLS_SIGN, ":Could not bls sign data ");
+        }
+        signatures.push_back({string(signature.data())});
+        return signatures;
+    }
+
+    vector<string> encryptedKeys;
+    map<string, uint32_t> keyIndexes;
+    vector<tuple<uint32_t, string, size_t, size_t>> signRequests;
+
+    for (auto &&request : _requests) {
+        auto it = keyIndexes.find(request.encryptedKeyHex);
+        if (it == keyIndexes.end()) {
+            it = keyIndexes.emplace(request.encryptedKeyHex, encryptedKeys.size()).first;
+            encryptedKeys.push_back(request.encryptedKeyHex);
+        }
+        signRequests.emplace_back(it->second, request.hashHex, request.t, request.n);
+    }
+
+    vector<string> sigs;
+    bls_sign_batch(encryptedKeys, signRequests, sigs);
+
+    for (auto &&sig : sigs) {
+        signatures.push_back({sig});
+    }
+
+    return signatures;
+});
+
+// batches are grouped by key and base, see computeEcdsaSignMessageHash
+SignBatcher SGXWalletServer::ecdsaSigns("ecdsa", SIGN_BATCH_MAX_REQUESTS, [](const vector<SignBatcher::Request> &_requests) {
+    auto &first = _requests[0];
+
+    if (_requests.size() == 1) {
+        return vector<vector<string>>{ecdsaSignHash(first.encryptedKeyHex, first.hashHex.c_str(), first.base)};
+    }
+
+    vector<string> hashes;
+    for (auto &&request : _requests) {
+        hashes.push_back(request.hashHex);
+    }
+
+    return ecdsaSignHashBatch(first.encryptedKeyHex, hashes, first.base);
+});
+
 Json::Value
 SGXWalletServer::blsSignMessageHashImpl(const string &_keyShareName, const string &_messageHash, int t, int n) {
     spdlog::trace("Entering {}", __FUNCTION__);
 
     COUNT_STATISTICS
 
-    INIT_RESULT(result)
+    return blsRequests.run(_keyShareName + ":" + _messageHash + ":" + to_string(t) + ":" + to_string(n), [&]() {
+        return computeBlsSignMessageHash(_keyShareName, _messageHash, t, n);
+    });
+}
 
-    result["status"] = -1;
+Json::Value
+SGXWalletServer::computeBlsSignMessageHash(const string &_keyShareName, const string &_messageHash, int t, int n) {
+    INIT_LEAN_RESULT(result)
 
     result["signatureShare"] = "";
 
-    vector<char> signature(BUF_LEN, 0);
+    if (!checkName(_keyShareName, "BLS_KEY")) {
+        RETURN_ERROR(result, BLS_SIGN_INVALID_KS_NAME, "Invalid BLSKey name");
+    }
+
+    if (!check_n_t(t, n)) {
+        RETURN_ERROR(result, BLS_SIGN_INVALID_PARAMS, "Invalid t/n parameters");
+    }
+
+    string hashTmp = _messageHash;
+    if (hashTmp.size() > 2 && hashTmp[0] == '0' && (hashTmp[1] == 'x' || hashTmp[1] == 'X')) {
+        hashTmp.erase(hashTmp.begin(), hashTmp.begin() + 2);
+    }
 
-    shared_ptr <string> value = nullptr;
+    if (!checkHex(hashTmp)) {
+        RETURN_ERROR(result, INVALID_BLS_HEX, "Invalid bls hex");
+    }
 
-    checkForDuplicate(blsRequests, blsRequestsLock, _keyShareName, _messageHash);
+    string signature;
 
     try {
-        if (!checkName(_keyShareName, "BLS_KEY")) {
-            throw SGXException(BLS_SIGN_INVALID_KS_NAME, string(__FUNCTION__) + ":Invalid BLSKey name");
-        }
+        auto value = checkDataFromDb(_keyShareName);
 
-        if (!check_n_t(t, n)) {
-            throw SGXException(BLS_SIGN_INVALID_PARAMS, string(__FUNCTION__) + ":Invalid t/n parameters");
+        if (!value) {
+            RETURN_ERROR(result, KEY_SHARE_DOES_NOT_EXIST, "Data with this name does not exist: " + _keyShareName);
         }
 
-        string hashTmp = _messageHash;
-        if (hashTmp[0] == '0' && (hashTmp[1] == 'x' || hashTmp[1] == 'X')) {
-            hashTmp.erase(hashTmp.begin(), hashTmp.begin() + 2);
+        KeyWarmUp::recordUse(_keyShareName);
+        auto signStart = chrono::steady_clock::now();
+
+        SignBatcher::Request request;
+        request.encryptedKeyHex = *value;
+        request.hashHex = hashTmp;
+        request.t = t;
+        request.n = n;
+
+        // BLS batches may mix keys
+        signature = blsSigns.sign("", request).at(0);
+        KeyStats::recordSign(_keyShareName, signStart);
+    } HANDLE_SGX_EXCEPTION(result)
+
+
+    result["signatureShare"] = signature;
+
+    RETURN_SUCCESS(result);
+}
+
+Json::Value
+SGXWalletServer::blsSignHashedPointImpl(const string &_keyShareName, const string &_hashedPoint, const string &_hint) {
+    spdlog::trace("Entering {}", __FUNCTION__);
+
+    COUNT_STATISTICS
+
+    return blsRequests.run(_keyShareName + ":P:" + _hashedPoint + ":" + _hint, [&]() {
+        return computeBlsSignHashedPoint(_keyShareName, _hashedPoint, _hint);
+    });
+}
+
+Json::Value
+SGXWalletServer::computeBlsSignHashedPoint(const string &_keyShareName, const string &_hashedPoint, const string &_hint) {
+    INIT_LEAN_RESULT(result)
+
+    result["signatureShare"] = "";
+
+    if (!checkName(_keyShareName, "BLS_KEY")) {
+        RETURN_ERROR(result, BLS_SIGN_INVALID_KS_NAME, "Invalid BLSKey name");
+    }
+
+    vector<char> signature(BUF_LEN, 0);
+
+    try {
+        auto value = checkDataFromDb(_keyShareName);
+
+        if (!value) {
+            RETURN_ERROR(result, KEY_SHARE_DOES_NOT_EXIST, "Data with this name does not exist: " + _keyShareName);
         }
 
-        if (!checkHex(hashTmp)) {
-            throw SGXException(INVALID_BLS_HEX, string(__FUNCTION__) + ":Invalid bls hex");
+        KeyWarmUp::recordUse(_keyShareName);
+        auto signStart = chrono::steady_clock::now();
+
+        bls_sign_hashed_point(value->c_str(), _hashedPoint, _hint, signature.data());
+        KeyStats::recordSign(_keyShareName, signStart);
+    } HANDLE_SGX_EXCEPTION(result)
+
+    result["signatureShare"] = string(signature.data());
+
+    RETURN_SUCCESS(result);
+}
+
+Json::Value SGXWalletServer::blsSignMessageHashBatchImpl(const Json::Value &_requests) {
+    spdlog::trace("Entering {}", __FUNCTION__);
+
+    COUNT_STATISTICS
+
+    INIT_RESULT(result)
+
+    result["signatureShares"] = Json::Value(Json::arrayValue);
+
+    try {
+        if (!_requests.isArray() || _requests.empty() || _requests.size() > MAX_BLS_SIGN_BATCH_SIZE) {
+            throw SGXException(INVALID_BLS_SIGN_BATCH, string(__FUNCTION__) + ":Requests should be a non empty array of at most "
+                                                       + to_string(MAX_BLS_SIGN_BATCH_SIZE) + " elements");
         }
 
-        value = readFromDb(_keyShareName);
+        vector<string> encryptedKeys;
+        map<string, uint32_t> keyIndexes;
+        vector<tuple<uint32_t, string, size_t, size_t>> signRequests;
 
+        // the whole batch fails if any of the requests fails
+        for (int i = 0; i < (int) _requests.size(); i++) {
+            const Json::Value& request = _requests[i];
 
-        if (!bls_sign(value->c_str(), hashTmp.c_str(), t, n, signature.data())) {
-            throw SGXException(COULD_NOT_BLS_SIGN, ":Could not bls sign data ");
+            if (!request.isObject() || !request["keyShareName"].isString() || !request["messageHash"].isString() ||
+                !request["t"].isInt() || !request["n"].isInt()) {
+                throw SGXException(INVALID_BLS_SIGN_BATCH, string(__FUNCTION__) + ":Invalid request " + to_string(i));
+            }
+
+            auto keyShareName = request["keyShareName"].asString();
+            auto t = request["t"].asInt();
+            auto n = request["n"].asInt();
+
+            if (!checkName(keyShareName, "BLS_KEY")) {
+                throw SGXException(BLS_SIGN_INVALID_KS_NAME, string(__FUNCTION__) + ":Invalid BLSKey name");
+            }
+
+            if (!check_n_t(t, n)) {
+                throw SGXException(BLS_SIGN_INVALID_PARAMS, string(__FUNCTION__) + ":Invalid t/n parameters");
+            }
+
+            string hashTmp = request["messageHash"].asString();
+            if (hashTmp.size() > 2 && hashTmp[0] == '0' && (hashTmp[1] == 'x' || hashTmp[1] == 'X')) {
+                hashTmp.erase(hashTmp.begin(), hashTmp.begin() + 2);
+            }
+
+            if (!checkHex(hashTmp)) {
+                throw SGXException(INVALID_BLS_HEX, string(__FUNCTION__) + ":Invalid bls hex");
+            }
+
+            auto it = keyIndexes.find(keyShareName);
+
+            if (it == keyIndexes.end()) {
+                encryptedKeys.push_back(*readFromDb(keyShareName));
+                it = keyIndexes.emplace(keyShareName, encryptedKeys.size() - 1).first;
+            }
+
+            signRequests.emplace_back(it->second, hashTmp, t, n);
         }
 
-    } HANDLE_SGX_EXCEPTION(result)
+        vector<string> signatures;
 
+        bls_sign_batch(encryptedKeys, signRequests, signatures);
 
-    result["signatureShare"] = string(signature.data());
+        for (auto&& signature : signatures) {
+            result["signatureShares"].append(signature);
+        }
+
+    } HANDLE_SGX_EXCEPTION(result)
 
     RETURN_SUCCESS(result);
 }
@@ -344,6 +734,7 @@ Json::Value SGXWalletServer::importECDSAKeyImpl(const string &_keyShare,
     result["encryptedKey"] = "";
 
     try {
+        BULKHEAD(ADMIN)
         if (!checkECDSAKeyName(_keyShareName)) {
             throw SGXException(INVALID_ECDSA_IMPORT_KEY_NAME, string(__FUNCTION__) + ":Invalid ECDSA import key name");
         }
@@ -360,10 +751,12 @@ Json::Value SGXWalletServer::importECDSAKeyImpl(const string &_keyShare,
 
         string encryptedKey = encryptECDSAKey(hashTmp);
 
-        writeDataToDB(_keyShareName, encryptedKey);
+        string publicKey = getECDSAPubKey(encryptedKey);
+
+        writeBatchToDB({{_keyShareName, encryptedKey}, {getECDSAPubKeyName(_keyShareName), publicKey}});
 
         result["encryptedKey"] = encryptedKey;
-        result["publicKey"] = getECDSAPubKey(encryptedKey);
+        result["publicKey"] = publicKey;
     } HANDLE_SGX_EXCEPTION(result)
 
     RETURN_SUCCESS(result);
@@ -378,7 +771,8 @@ Json::Value SGXWalletServer::generateECDSAKeyImpl() {
     vector <string> keys;
 
     try {
-        keys = genECDSAKey();
+        BULKHEAD(ADMIN)
+        keys = ECDSAKeyPool::take();
 
         if (keys.size() == 0) {
             throw SGXException(ECDSA_GEN_EMPTY_KEY, string(__FUNCTION__) + ":key was not generated");
@@ -386,7 +780,9 @@ Json::Value SGXWalletServer::generateECDSAKeyImpl() {
 
         string keyName = "NEK:" + keys.at(2);
 
-        writeDataToDB(keyName, keys.at(0));
+        writeBatchToDB({{keyName, keys.at(0)}, {getECDSAPubKeyName(keyName), keys.at(1)}});
+
+        cacheECDSAPubKey(keys.at(0), keys.at(1));
 
         result["encryptedKey"] = keys.at(0);
         result["publicKey"] = keys.at(1);
@@ -400,45 +796,128 @@ Json::Value SGXWalletServer::generateECDSAKeyImpl() {
 Json::Value SGXWalletServer::ecdsaSignMessageHashImpl(int _base, const string &_keyName, const string &_messageHash) {
     COUNT_STATISTICS
     spdlog::trace("Entering {}", __FUNCTION__);
-    INIT_RESULT(result)
+
+    // any valid signature answers a repeated request, so identical requests share one
+    return ecdsaRequests.run(_keyName + ":" + _messageHash + ":" + to_string(_base), [&]() {
+        return computeEcdsaSignMessageHash(_base, _keyName, _messageHash);
+    });
+}
+
+Json::Value SGXWalletServer::computeEcdsaSignMessageHash(int _base, const string &_keyName, const string &_messageHash) {
+    INIT_LEAN_RESULT(result)
 
     result["signature_v"] = "";
     result["signature_r"] = "";
     result["signature_s"] = "";
 
-    vector <string> signatureVector(3);
+    string hashTmp = _messageHash;
+    if (hashTmp.size() > 2 && hashTmp[0] == '0' && (hashTmp[1] == 'x' || hashTmp[1] == 'X')) {
+        hashTmp.erase(hashTmp.begin(), hashTmp.begin() + 2);
+    }
+    auto leadingZeros = hashTmp.find_first_not_of('0');
+    hashTmp.erase(0, leadingZeros == string::npos ? hashTmp.size() : leadingZeros);
+
+    if (!checkECDSAKeyName(_keyName)) {
+        RETURN_ERROR(result, INVALID_ECDSA_SIGN_KEY_NAME, "Invalid ECDSA sign key name");
+    }
+    if (!checkHex(hashTmp)) {
+        RETURN_ERROR(result, INVALID_ECDSA_SIGN_HASH, "Invalid ECDSA sign hash");
+    }
+    if (_base <= 0 || _base > 32) {
+        RETURN_ERROR(result, INVALID_ECDSA_SIGN_BASE, "Invalid ECDSA sign base");
+    }
 
-    checkForDuplicate(ecdsaRequests, ecdsaRequestsLock, _keyName, _messageHash);
+    vector <string> signatureVector;
 
     try {
-        string hashTmp = _messageHash;
-        if (hashTmp[0] == '0' && (hashTmp[1] == 'x' || hashTmp[1] == 'X')) {
-            hashTmp.erase(hashTmp.begin(), hashTmp.begin() + 2);
+        auto encryptedKey = checkDataFromDb(_keyName);
+
+        if (!encryptedKey) {
+            RETURN_ERROR(result, KEY_SHARE_DOES_NOT_EXIST, "Data with this name does not exist: " + _keyName);
         }
-        while (hashTmp[0] == '0') {
-            hashTmp.erase(hashTmp.begin(), hashTmp.begin() + 1);
+
+        KeyWarmUp::recordUse(_keyName);
+        auto signStart = chrono::steady_clock::now();
+
+        SignBatcher::Request request;
+        request.encryptedKeyHex = *encryptedKey;
+        request.hashHex = hashTmp;
+        request.base = _base;
+
+        signatureVector = ecdsaSigns.sign(*encryptedKey + ":" + to_string(_base), request);
+        if (signatureVector.size() != 3) {
+            throw SGXException(INVALID_ECSDA_SIGN_SIGNATURE, string(__FUNCTION__) + ":Invalid ecdsa signature");
+        }
+        KeyStats::recordSign(_keyName, signStart);
+
+        result["signature_v"] = signatureVector.at(0);
+        result["signature_r"] = signatureVector.at(1);
+        result["signature_s"] = signatureVector.at(2);
+    } HANDLE_SGX_EXCEPTION(result)
+
+    RETURN_SUCCESS(result)
+}
+
+Json::Value SGXWalletServer::ecdsaSignMessageHashBatchImpl(int _base, const string &_keyName,
+                                                           const Json::Value &_messageHashes) {
+    COUNT_STATISTICS
+    spdlog::trace("Entering {}", __FUNCTION__);
+    INIT_RESULT(result)
+
+    result["signature_v"] = Json::Value(Json::arrayValue);
+    result["signature_r"] = Json::Value(Json::arrayValue);
+    result["signature_s"] = Json::Value(Json::arrayValue);
+
+    try {
+        if (!_messageHashes.isArray() || _messageHashes.empty() ||
+            _messageHashes.size() > MAX_ECDSA_SIGN_BATCH_SIZE) {
+            throw SGXException(INVALID_ECDSA_SIGN_BATCH, string(__FUNCTION__) +
+                                                         ":Message hashes should be a non empty array of at most "
+                                                         + to_string(MAX_ECDSA_SIGN_BATCH_SIZE) + " elements");
         }
 
         if (!checkECDSAKeyName(_keyName)) {
             throw SGXException(INVALID_ECDSA_SIGN_KEY_NAME, string(__FUNCTION__) + ":Invalid ECDSA sign key name");
         }
-        if (!checkHex(hashTmp)) {
-            throw SGXException(INVALID_ECDSA_SIGN_HASH, ":Invalid ECDSA sign hash");
-        }
-        if (_base <= 0 || _base > 32) {
+        if (_base <= 1 || _base > 32) {
             throw SGXException(INVALID_ECDSA_SIGN_BASE, ":Invalid ECDSA sign base");
         }
 
+        vector<string> hashes;
+
+        for (int i = 0; i < (int) _messageHashes.size(); i++) {
+            if (!_messageHashes[i].isString()) {
+                throw SGXException(INVALID_ECDSA_SIGN_BATCH, string(__FUNCTION__) + ":Invalid message hash " + to_string(i));
+            }
+
+            string hashTmp = _messageHashes[i].asString();
+            if (hashTmp.size() > 2 && hashTmp[0] == '0' && (hashTmp[1] == 'x' || hashTmp[1] == 'X')) {
+                hashTmp.erase(hashTmp.begin(), hashTmp.begin() + 2);
+            }
+            while (hashTmp.size() > 1 && hashTmp[0] == '0') {
+                hashTmp.erase(hashTmp.begin(), hashTmp.begin() + 1);
+            }
+
+            if (!checkHex(hashTmp)) {
+                throw SGXException(INVALID_ECDSA_SIGN_HASH, ":Invalid ECDSA sign hash");
+            }
+
+            hashes.push_back(hashTmp);
+        }
+
         shared_ptr <string> encryptedKey = readFromDb(_keyName, "");
 
-        signatureVector = ecdsaSignHash(encryptedKey->c_str(), hashTmp.c_str(), _base);
-        if (signatureVector.size() != 3) {
-            throw SGXException(INVALID_ECSDA_SIGN_SIGNATURE, string(__FUNCTION__) + ":Invalid ecdsa signature");
+        auto signatures = ecdsaSignHashBatch(*encryptedKey, hashes, _base);
+
+        if (signatures.size() != hashes.size()) {
+            throw SGXException(INVALID_ECSDA_SIGN_SIGNATURE, string(__FUNCTION__) + ":Invalid ecdsa signatures");
         }
 
-        result["signature_v"] = signatureVector.at(0);
-        result["signature_r"] = signatureVector.at(1);
-        result["signature_s"] = signatureVector.at(2);
+        for (auto&& signatureVector : signatures) {
+            result["signature_v"].append(signatureVector.at(0));
+            result["signature_r"].append(signatureVector.at(1));
+            result["signature_s"].append(signatureVector.at(2));
+        }
     } HANDLE_SGX_EXCEPTION(result)
 
     RETURN_SUCCESS(result)
@@ -459,8 +938,15 @@ Json::Value SGXWalletServer::getPublicECDSAKeyImpl(const string &_keyName) {
             throw SGXException(INVALID_ECDSA_GETPKEY_KEY_NAME, string(__FUNCTION__) +
                                                                ":Invalid ECDSA import key name");
         }
-        shared_ptr <string> keyStr = readFromDb(_keyName);
-        publicKey = getECDSAPubKey(keyStr->c_str());
+        auto pubKeyStr = checkDataFromDb(getECDSAPubKeyName(_keyName));
+
+        if (pubKeyStr != nullptr) {
+            publicKey = *pubKeyStr;
+        } else {
+            // keys created before public keys were stored with them
+            shared_ptr <string> keyStr = readFromDb(_keyName);
+            publicKey = getECDSAPubKey(keyStr->c_str());
+        }
         result["PublicKey"] = publicKey;
         result["publicKey"] = publicKey;
     } HANDLE_SGX_EXCEPTION(result)
@@ -476,15 +962,68 @@ Json::Value SGXWalletServer::generateDKGPolyImpl(const string &_polyName, int _t
     string encrPolyHex;
 
     try {
+        BULKHEAD(DKG)
+        DKG_PHASE(GENERATE_POLY, _polyName)
         if (!checkName(_polyName, "POLY")) {
             throw SGXException(INVALID_GEN_DKG_POLY_NAME,
                                string(__FUNCTION__) + ":Invalid gen DKG polynomial name.");
         }
-        if (_t <= 0 || _t > 32) {
+        if (_t <= 0 || _t > MAX_DKG_N) {
             throw SGXException(GENERATE_DKG_POLY_INVALID_PARAMS, string(__FUNCTION__) + ":Invalid gen dkg param t ");
         }
         encrPolyHex = gen_dkg_poly(_t);
-        writeDataToDB(_polyName, encrPolyHex);
+        // commitments are computed once and stored with the poly, see readVerificationVector
+        auto verificationVector = getVerificationVectorString(encrPolyHex, _t);
+        writeBatchToDB({{_polyName, encrPolyHex},
+                        {getVerificationVectorName(_polyName), compressDecimalG2(verificationVector)}});
+    } HANDLE_SGX_EXCEPTION(result)
+
+    RETURN_SUCCESS(result)
+}
+
+Json::Value SGXWalletServer::generateDKGPolyBatchImpl(const Json::Value &_polyNames, int _t) {
+    COUNT_STATISTICS
+    spdlog::info("Entering {}", __FUNCTION__);
+    INIT_RESULT(result)
+
+    try {
+        BULKHEAD(DKG)
+        if (!_polyNames.isArray() || _polyNames.empty() || _polyNames.size() > MAX_DKG_POLY_BATCH_SIZE) {
+            throw SGXException(INVALID_DKG_POLY_BATCH, string(__FUNCTION__) + ":Invalid number of poly names");
+        }
+        if (_t <= 0 || _t > MAX_DKG_N) {
+            throw SGXException(GENERATE_DKG_POLY_INVALID_PARAMS, string(__FUNCTION__) + ":Invalid gen dkg param t ");
+        }
+
+        set<string> polyNames;
+        for (auto &&polyName : _polyNames) {
+            if (!polyName.isString() || !checkName(polyName.asString(), "POLY")) {
+                throw SGXException(INVALID_GEN_DKG_POLY_NAME,
+                                   string(__FUNCTION__) + ":Invalid gen DKG polynomial name.");
+            }
+            if (!polyNames.insert(polyName.asString()).second) {
+                throw SGXException(INVALID_DKG_POLY_BATCH,
+                                   string(__FUNCTION__) + ":Duplicate poly name " + polyName.asString());
+            }
+        }
+
+        auto polys = genDkgPolyBatch(_polyNames.size(), _t);
+
+        vector<pair<string, string>> keyValues;
+        keyValues.reserve(2 * polys.size());
+
+        result["verificationVectors"] = Json::Value(Json::arrayValue);
+
+        for (uint64_t i = 0; i < polys.size(); i++) {
+            auto polyName = _polyNames[(Json::ArrayIndex) i].asString();
+            auto verificationVector = compressDecimalG2(polys[i].second);
+            keyValues.emplace_back(polyName, polys[i].first);
+            keyValues.emplace_back(getVerificationVectorName(polyName), verificationVector);
+            result["verificationVectors"].append(verificationVector);
+        }
+
+        // all polys of the batch are stored or none is
+        writeBatchToDB(keyValues);
     } HANDLE_SGX_EXCEPTION(result)
 
     RETURN_SUCCESS(result)
@@ -497,6 +1036,8 @@ Json::Value SGXWalletServer::getVerificationVectorImpl(const string &_polyName,
 
     vector <vector<string>> verifVector;
     try {
+        BULKHEAD(DKG)
+        DKG_PHASE(VERIFICATION_VECTOR, _polyName)
         if (!checkName(_polyName, "POLY")) {
             throw SGXException(INVALID_DKG_GETVV_POLY_NAME, string(__FUNCTION__) + ":Invalid polynomial name");
         }
@@ -504,9 +1045,7 @@ Json::Value SGXWalletServer::getVerificationVectorImpl(const string &_polyName,
             throw SGXException(INVALID_DKG_GETVV_PARAMS, string(__FUNCTION__) + ":Invalid t ");
         }
 
-        shared_ptr <string> encrPoly = readFromDb(_polyName);
-
-        verifVector = get_verif_vect(*encrPoly, _t);
+        verifVector = readVerificationVector(_polyName, _t);
 
         for (int i = 0; i < _t; i++) {
             vector <string> currentCoef = verifVector.at(i);
@@ -520,6 +1059,39 @@ Json::Value SGXWalletServer::getVerificationVectorImpl(const string &_polyName,
 
 }
 
+Json::Value SGXWalletServer::getVerificationVectorCompressedImpl(const string &_polyName, int _t) {
+    COUNT_STATISTICS
+    spdlog::info("Entering {}", __FUNCTION__);
+    INIT_RESULT(result)
+    result["verificationVector"] = "";
+
+    try {
+        BULKHEAD(DKG)
+        DKG_PHASE(VERIFICATION_VECTOR, _polyName)
+        if (!checkName(_polyName, "POLY")) {
+            throw SGXException(INVALID_DKG_GETVV_POLY_NAME, string(__FUNCTION__) + ":Invalid polynomial name");
+        }
+        if (_t <= 0) {
+            throw SGXException(INVALID_DKG_GETVV_PARAMS, string(__FUNCTION__) + ":Invalid t ");
+        }
+
+        // stored compressed by generateDKGPoly
+        auto stored = checkDataFromDb(getVerificationVectorName(_polyName));
+
+        if (stored && isCompressedG2(*stored) && stored->length() == (uint64_t) G2_COMPRESSED_HEX_LEN * _t) {
+            result["verificationVector"] = *stored;
+        } else {
+            string points;
+            for (auto &&coords : readVerificationVector(_polyName, _t)) {
+                points += coords.at(0) + ":" + coords.at(1) + ":" + coords.at(2) + ":" + coords.at(3) + ",";
+            }
+            result["verificationVector"] = compressDecimalG2(points);
+        }
+    } HANDLE_SGX_EXCEPTION(result)
+
+    RETURN_SUCCESS(result)
+}
+
 Json::Value SGXWalletServer::getSecretShareImpl(const string &_polyName, const Json::Value &_pubKeys, int _t, int _n) {
     COUNT_STATISTICS
     spdlog::info("Entering {}", __FUNCTION__);
@@ -527,6 +1099,8 @@ Json::Value SGXWalletServer::getSecretShareImpl(const string &_polyName, const J
     result["secretShare"] = "";
 
     try {
+        BULKHEAD(DKG)
+        DKG_PHASE(SECRET_SHARE, _polyName)
         if (_pubKeys.size() != (uint64_t) _n) {
             throw SGXException(INVALID_DKG_GETSS_PUB_KEY_COUNT, string(__FUNCTION__) + ":Invalid pubkey count");
         }
@@ -568,6 +1142,8 @@ Json::Value SGXWalletServer::dkgVerificationImpl(const string &_publicShares, co
     result["result"] = false;
 
     try {
+        BULKHEAD(DKG)
+        DKG_PHASE(VERIFICATION, _ethKeyName)
         if (!checkECDSAKeyName(_ethKeyName)) {
             throw SGXException(INVALID_DKG_VERIFY_ECDSA_KEY_NAME,
                                string(__FUNCTION__) + ":Invalid ECDSA key name");
@@ -580,14 +1156,16 @@ Json::Value SGXWalletServer::dkgVerificationImpl(const string &_publicShares, co
             throw SGXException(INVALID_DKG_VERIFY_SS_HEX,
                                string(__FUNCTION__) + ":Invalid Secret share");
         }
-        if (_publicShares.length() != (uint64_t) 256 * _t) {
+        string expanded;
+        auto publicShares = expandPublicShares(_publicShares, _t, expanded);
+        if (!publicShares) {
             throw SGXException(INVALID_DKG_VERIFY_PUBSHARES_LENGTH,
                                string(__FUNCTION__) + ":Invalid length of public shares");
         }
 
         shared_ptr <string> encryptedKeyHex_ptr = readFromDb(_ethKeyName);
 
-        if (verifyShares(_publicShares.c_str(), _secretShare.c_str(), encryptedKeyHex_ptr->c_str(), _t, _n, _index)) {
+        if (verifyShares(publicShares->c_str(), _secretShare.c_str(), encryptedKeyHex_ptr->c_str(), _t, _n, _index)) {
             result["result"] = true;
         }
     } HANDLE_SGX_EXCEPTION(result)
@@ -603,6 +1181,8 @@ SGXWalletServer::createBLSPrivateKeyImpl(const string &_blsKeyName, const string
     INIT_RESULT(result)
 
     try {
+        BULKHEAD(DKG)
+        DKG_PHASE(CREATE_BLS_KEY, _polyName, &_ethKeyName, &_blsKeyName)
         if (_secretShare.length() != (uint64_t) _n * 192) {
             throw SGXException(INVALID_CREATE_BLS_KEY_SECRET_SHARES_LENGTH,
                                string(__FUNCTION__) + ":Invalid secret share length");
@@ -623,32 +1203,36 @@ SGXWalletServer::createBLSPrivateKeyImpl(const string &_blsKeyName, const string
             throw SGXException(INVALID_CREATE_BLS_DKG_PARAMS,
                                string(__FUNCTION__) + ":Invalid DKG parameters: n or t ");
         }
+        if (!checkSecretSharesV2(_secretShare, _n)) {
+            throw SGXException(INVALID_CREATE_BLS_KEY_SECRET_SHARES,
+                               string(__FUNCTION__) + ":Invalid secret shares");
+        }
         vector <string> sshares_vect;
 
         shared_ptr <string> encryptedKeyHex_ptr = readFromDb(_ethKeyName);
 
         CHECK_STATE(encryptedKeyHex_ptr);
 
-        bool res = createBLSShare(_blsKeyName, _secretShare.c_str(), encryptedKeyHex_ptr->c_str());
+        // read before createBLSShare deletes it, so the enclave can drop its decrypted copy
+        auto encryptedPolyHex = checkDataFromDb(_polyName);
+
+        // the BLS key share and the removal of the DKG temporary keys are committed in one batch
+        bool res = createBLSShare(_blsKeyName, _secretShare.c_str(), encryptedKeyHex_ptr->c_str(),
+                                  getDKGTempKeyNames(_polyName, _n));
         if (res) {
             spdlog::info("BLS KEY SHARE CREATED ");
+            if (encryptedPolyHex) {
+                try {
+                    eraseDkgPoly(encryptedPolyHex->c_str());
+                } catch (SGXException &e) {
+                    spdlog::warn("Could not erase DKG poly {} from the enclave cache: {}", _polyName, e.getMessage());
+                }
+            }
         } else {
             throw SGXException(INVALID_CREATE_BLS_SHARE,
                                string(__FUNCTION__) + ":Error while creating BLS key share");
         }
 
-        for (int i = 0; i < _n; i++) {
-            string name = _polyName + "_" + to_string(i) + ":";
-            LevelDB::getLevelDb()->deleteDHDKGKey(name);
-            string shareG2_name = "shareG2_" + _polyName + "_" + to_string(i) + ":";
-            LevelDB::getLevelDb()->deleteKey(shareG2_name);
-        }
-        LevelDB::getLevelDb()->deleteKey(_polyName);
-
-
-        string encryptedSecretShareName = "encryptedSecretShare:" + _polyName;
-        LevelDB::getLevelDb()->deleteKey(encryptedSecretShareName);
-
     } HANDLE_SGX_EXCEPTION(result)
 
     RETURN_SUCCESS(result);
@@ -660,13 +1244,25 @@ Json::Value SGXWalletServer::getBLSPublicKeyShareImpl(const string &_blsKeyName)
     INIT_RESULT(result)
 
     try {
+        DKG_PHASE(BLS_PUBLIC_KEY_SHARE, _blsKeyName)
         if (!checkName(_blsKeyName, "BLS_KEY")) {
             throw SGXException(INVALID_GET_BLS_PUBKEY_NAME,
                                string(__FUNCTION__) + ":Invalid BLSKey name");
         }
-        shared_ptr <string> encryptedKeyHex_ptr = readFromDb(_blsKeyName);
+        vector <string> public_key_vect;
+
+        auto pubKeyStr = checkDataFromDb(getBLSPubKeyName(_blsKeyName));
+
+        if (pubKeyStr != nullptr) {
+            public_key_vect = splitString(pubKeyStr->c_str(), ':');
+        } else {
+            // keys created before public shares were stored with them
+            shared_ptr <string> encryptedKeyHex_ptr = readFromDb(_blsKeyName);
+            public_key_vect = getBLSPubKey(encryptedKeyHex_ptr->c_str());
+        }
+
+        CHECK_STATE(public_key_vect.size() == 4);
 
-        vector <string> public_key_vect = getBLSPubKey(encryptedKeyHex_ptr->c_str());
         for (uint8_t i = 0; i < 4; i++) {
             result["blsPublicKeyShare"][i] = public_key_vect.at(i);
         }
@@ -675,12 +1271,61 @@ Json::Value SGXWalletServer::getBLSPublicKeyShareImpl(const string &_blsKeyName)
     RETURN_SUCCESS(result);
 }
 
+// every node of a schain asks for the public keys of the same DKG round, so the results are
+// memoized by a hash of the request, malformed requests get an empty key and are not memoized
+static string blsPublicKeysRequestKey(const Json::Value &_publicShares, int _t, int _n) {
+    if (!_publicShares.isArray()) {
+        return "";
+    }
+
+    string request = to_string(_t) + ":" + to_string(_n);
+    for (auto &&share : _publicShares) {
+        if (!share.isString()) {
+            return "";
+        }
+        request += ":" + share.asString();
+    }
+
+    return cryptlite::sha256::hash_hex(request);
+}
+
 Json::Value SGXWalletServer::calculateAllBLSPublicKeysImpl(const Json::Value &publicShares, int t, int n) {
     COUNT_STATISTICS
     spdlog::info("Entering {}", __FUNCTION__);
+
+    auto key = blsPublicKeysRequestKey(publicShares, t, n);
+
+    if (key.empty()) {
+        return computeAllBLSPublicKeys(publicShares, t, n, key);
+    }
+
+    return blsPublicKeysRequests.run(key, [&]() {
+        return computeAllBLSPublicKeys(publicShares, t, n, key);
+    });
+}
+
+Json::Value
+SGXWalletServer::computeAllBLSPublicKeys(const Json::Value &publicShares, int t, int n, const string &_key) {
     INIT_RESULT(result)
 
     try {
+        if (!_key.empty() && persistBlsPublicKeys) {
+            auto stored = LevelDB::getLevelDb()->readString(BLS_PUBLIC_KEYS_PREFIX + _key);
+            Json::Value publicKeys;
+            if (stored && isCompressedG2(*stored)) {
+                for (auto &&coords : decompressToDecimalG2(*stored)) {
+                    publicKeys.append(coords[0] + ":" + coords[1] + ":" + coords[2] + ":" + coords[3]);
+                }
+            } else if (stored) {
+                // results stored as JSON before they were compressed
+                Json::Reader().parse(*stored, publicKeys);
+            }
+            if (publicKeys.isArray() && publicKeys.size() == (uint64_t) n) {
+                result["publicKeys"] = publicKeys;
+                RETURN_SUCCESS(result);
+            }
+        }
+
         if (!check_n_t(t, n)) {
             throw SGXException(INVALID_DKG_CALCULATE_ALL_PARAMS,
                                string(__FUNCTION__) + ":Invalid DKG parameters: n or t ");
@@ -702,15 +1347,23 @@ Json::Value SGXWalletServer::calculateAllBLSPublicKeysImpl(const Json::Value &pu
                                    string(__FUNCTION__) + ":Invalid public shares string");
             }
 
-            if (publicShares[i].asString().length() != (uint64_t) 256 * t) {
-                throw SGXException(INVALID_DKG_CALCULATE_ALL_STRING_PUBSHARES_SLENGTH,
-                                   string(__FUNCTION__) + ";Invalid length of public shares parts");
-            }
         }
 
+        // compressed submissions need a square root per point, so the peers are expanded in parallel
         vector <string> public_shares(n);
-        for (int i = 0; i < n; ++i) {
-            public_shares[i] = publicShares[i].asString();
+        atomic<bool> validShares(true);
+        parallelFor(n, [&](size_t i) {
+            string expanded;
+            auto expandedShares = expandPublicShares(publicShares[(int) i].asString(), t, expanded);
+            if (!expandedShares) {
+                validShares = false;
+                return;
+            }
+            public_shares[i] = *expandedShares;
+        });
+        if (!validShares) {
+            throw SGXException(INVALID_DKG_CALCULATE_ALL_STRING_PUBSHARES_SLENGTH,
+                               string(__FUNCTION__) + ";Invalid length of public shares parts");
         }
 
         vector <string> public_keys = calculateAllBlsPublicKeys(public_shares);
@@ -720,123 +1373,501 @@ Json::Value SGXWalletServer::calculateAllBLSPublicKeysImpl(const Json::Value &pu
                                string(__FUNCTION__) + ":Invalid pubkeys array size");
         }
 
+        string publicKeysList;
         for (int i = 0; i < n; ++i) {
             result["publicKeys"][i] = public_keys[i];
+            publicKeysList += public_keys[i] + ",";
+        }
+
+        if (!_key.empty() && persistBlsPublicKeys) {
+            LevelDB::getLevelDb()->writeString(BLS_PUBLIC_KEYS_PREFIX + _key, compressDecimalG2(publicKeysList));
+        }
+    } HANDLE_SGX_EXCEPTION(result)
+
+    RETURN_SUCCESS(result);
+}
+
+// The first response deletes the DKG intermediates of the poly, so repeated complaints
+// for the same index are answered from here without decrypting the DH key again
+static mutex complaintResponsesMutex;
+static map<string, Json::Value> complaintResponses;
+
+Json::Value SGXWalletServer::complaintResponseImpl(const string &_polyName, int _t, int _n, int _ind) {
+    COUNT_STATISTICS
+    spdlog::info("Entering {}", __FUNCTION__);
+    INIT_RESULT(result)
+
+    static auto &cacheHits = Metrics::getCounter("complaintResponseCacheHits");
+
+    try {
+        BULKHEAD(DKG)
+        if (!checkName(_polyName, "POLY")) {
+            throw SGXException(INVALID_COMPLAINT_RESPONSE_POLY_NAME,
+                               string(__FUNCTION__) + ":Invalid polynomial name");
+        }
+
+        string cacheKey = _polyName + "_" + to_string(_ind) + "_" + to_string(_t);
+
+        {
+            lock_guard<mutex> lock(complaintResponsesMutex);
+            auto it = complaintResponses.find(cacheKey);
+            if (it != complaintResponses.end()) {
+                cacheHits.inc();
+                for (auto &&field : {"share*G2", "dhKey", "verificationVectorMult"}) {
+                    result[field] = it->second[field];
+                }
+                RETURN_SUCCESS(result);
+            }
+        }
+
+        string shareG2_name = "shareG2_" + _polyName + "_" + to_string(_ind) + ":";
+        string DHKey = decryptDHKey(_polyName, _ind);
+
+        shared_ptr <string> shareG2_ptr = readFromDb(shareG2_name);
+        CHECK_STATE(shareG2_ptr);
+        result["share*G2"] = *shareG2_ptr;
+        result["dhKey"] = DHKey;
+
+        auto verificationVectorMult = getVerificationVectorMult(readVerificationVector(_polyName, _t), _t, _ind);
+
+        for (int i = 0; i < _t; i++) {
+            vector <string> currentCoef = verificationVectorMult.at(i);
+            for (int j = 0; j < 4; j++) {
+                result["verificationVectorMult"][i][j] = currentCoef.at(j);
+            }
+        }
+
+        {
+            lock_guard<mutex> lock(complaintResponsesMutex);
+            if (complaintResponses.size() >= COMPLAINT_RESPONSE_CACHE_MAX_ENTRIES) {
+                complaintResponses.clear();
+            }
+            complaintResponses[cacheKey] = result;
+        }
+
+        LevelDB::getLevelDb()->deleteKeys(getDKGTempKeyNames(_polyName, _n));
+    } HANDLE_SGX_EXCEPTION(result)
+
+    RETURN_SUCCESS(result);
+}
+
+Json::Value SGXWalletServer::multG2Impl(const string &_x) {
+    COUNT_STATISTICS
+    INIT_RESULT(result)
+
+    try {
+        auto xG2_vect = mult_G2(_x);
+        for (uint8_t i = 0; i < 4; i++) {
+            result["x*G2"][i] = xG2_vect.at(i);
+        }
+    } HANDLE_SGX_EXCEPTION(result)
+
+    RETURN_SUCCESS(result);
+}
+
+Json::Value SGXWalletServer::multG2BatchImpl(const Json::Value &_xs) {
+    COUNT_STATISTICS
+    INIT_RESULT(result)
+
+    try {
+        if (!_xs.isArray() || _xs.empty() || _xs.size() > MAX_MULT_G2_BATCH_SIZE) {
+            throw SGXException(INVALID_MULT_G2_BATCH, string(__FUNCTION__) + ":Invalid number of scalars");
+        }
+
+        vector<string> xs;
+        xs.reserve(_xs.size());
+
+        for (auto &&x : _xs) {
+            if (!x.isString() || !isStringDec(x.asString())) {
+                throw SGXException(INVALID_MULT_G2_BATCH, string(__FUNCTION__) + ":Scalar is not a decimal number");
+            }
+            xs.push_back(x.asString());
+        }
+
+        auto xG2s = multG2Batch(xs);
+
+        result["x*G2"] = Json::Value(Json::arrayValue);
+        for (uint64_t i = 0; i < xG2s.size(); i++) {
+            for (uint8_t j = 0; j < 4; j++) {
+                result["x*G2"][(Json::ArrayIndex) i][j] = xG2s[i].at(j);
+            }
+        }
+    } HANDLE_SGX_EXCEPTION(result)
+
+    RETURN_SUCCESS(result);
+}
+
+Json::Value SGXWalletServer::aggregateBLSSignaturesImpl(const Json::Value &_shares, const Json::Value &_signerIndices,
+                                                       int _t, int _n) {
+    COUNT_STATISTICS
+    INIT_RESULT(result)
+
+    result["signature"] = "";
+
+    try {
+        if (!check_n_t(_t, _n)) {
+            throw SGXException(INVALID_BLS_SIG_SHARES, string(__FUNCTION__) + ":Invalid t/n parameters");
+        }
+
+        if (!_shares.isArray() || !_signerIndices.isArray() || _shares.size() != (Json::ArrayIndex) _t ||
+            _signerIndices.size() != _shares.size()) {
+            throw SGXException(INVALID_BLS_SIG_SHARES, string(__FUNCTION__) + ":Need exactly t shares and signer indices");
+        }
+
+        vector<string> shares;
+        vector<size_t> signerIndices;
+
+        for (Json::ArrayIndex i = 0; i < _shares.size(); i++) {
+            if (!_shares[i].isString() || !_signerIndices[i].isUInt()) {
+                throw SGXException(INVALID_BLS_SIG_SHARES, string(__FUNCTION__) + ":Invalid share or signer index");
+            }
+            shares.push_back(_shares[i].asString());
+            signerIndices.push_back(_signerIndices[i].asUInt());
+        }
+
+        result["signature"] = aggregateBLSSignatures(shares, signerIndices, _t, _n);
+    } HANDLE_SGX_EXCEPTION(result)
+
+    RETURN_SUCCESS(result);
+}
+
+Json::Value SGXWalletServer::verifyBLSSignaturesImpl(const Json::Value &_requests) {
+    COUNT_STATISTICS
+    INIT_RESULT(result)
+
+    result["valid"] = Json::Value(Json::arrayValue);
+
+    try {
+        if (!_requests.isArray() || _requests.empty() || _requests.size() > MAX_BLS_VERIFY_BATCH_SIZE) {
+            throw SGXException(INVALID_BLS_VERIFY_BATCH, string(__FUNCTION__) + ":Requests should be a non empty array of at most "
+                                                         + to_string(MAX_BLS_VERIFY_BATCH_SIZE) + " elements");
+        }
+
+        vector<vector<string>> publicKeys;
+        vector<string> hashes;
+        vector<string> signatures;
+
+        for (int i = 0; i < (int) _requests.size(); i++) {
+            const Json::Value &request = _requests[i];
+
+            if (!request.isObject() || !request["publicKey"].isArray() || request["publicKey"].size() != 4 ||
+                !request["messageHash"].isString() || !request["signature"].isString()) {
+                throw SGXException(INVALID_BLS_VERIFY_BATCH, string(__FUNCTION__) + ":Invalid request " + to_string(i));
+            }
+
+            vector<string> publicKey;
+            for (auto &&coordinate : request["publicKey"]) {
+                if (!coordinate.isString()) {
+                    throw SGXException(INVALID_BLS_VERIFY_BATCH, string(__FUNCTION__) + ":Invalid request " + to_string(i));
+                }
+                publicKey.push_back(coordinate.asString());
+            }
+
+            string hashTmp = request["messageHash"].asString();
+            if (hashTmp.size() > 2 && hashTmp[0] == '0' && (hashTmp[1] == 'x' || hashTmp[1] == 'X')) {
+                hashTmp.erase(hashTmp.begin(), hashTmp.begin() + 2);
+            }
+
+            if (!checkHex(hashTmp)) {
+                throw SGXException(INVALID_BLS_HEX, string(__FUNCTION__) + ":Invalid bls hex");
+            }
+
+            publicKeys.push_back(publicKey);
+            hashes.push_back(hashTmp);
+            signatures.push_back(request["signature"].asString());
+        }
+
+        auto valid = bls_verify_batch(publicKeys, hashes, signatures);
+
+        for (bool v : valid) {
+            result["valid"].append(v);
         }
     } HANDLE_SGX_EXCEPTION(result)
 
     RETURN_SUCCESS(result);
 }
 
-Json::Value SGXWalletServer::complaintResponseImpl(const string &_polyName, int _t, int _n, int _ind) {
+Json::Value SGXWalletServer::isPolyExistsImpl(const string &_polyName) {
+    COUNT_STATISTICS
+    spdlog::info("Entering {}", __FUNCTION__);
+    INIT_RESULT(result)
+
+    result["IsExist"] = false;
+
+    try {
+        shared_ptr <string> poly_str_ptr = LevelDB::getLevelDb()->readString(_polyName);
+
+        if (poly_str_ptr != nullptr) {
+            result["IsExist"] = true;
+        }
+    } HANDLE_SGX_EXCEPTION(result)
+
+    RETURN_SUCCESS(result);
+}
+
+Json::Value SGXWalletServer::getServerStatusImpl() {
+    COUNT_STATISTICS
+    INIT_RESULT(result)
+
+    // queue depths let load balancers shed load before requests are rejected
+    result["zmqSignQueueDepth"] = (Json::UInt64) ZMQServer::getSignQueueDepth();
+    result["zmqSlowQueueDepth"] = (Json::UInt64) ZMQServer::getSlowQueueDepth();
+    result["zmqOutgoingQueueDepth"] = (Json::UInt64) ZMQServer::getOutgoingQueueDepth();
+    result["zmqRejectedRequests"] = (Json::UInt64) ZMQServer::getRejectedRequests();
+
+    RETURN_SUCCESS(result)
+}
+
+static Json::Value stageLatency(const HistogramSnapshot &_window) {
+    Json::Value stage;
+    stage["count"] = (Json::UInt64) _window.count;
+    stage["p50Us"] = (Json::UInt64) _window.quantileUs(0.5);
+    stage["p90Us"] = (Json::UInt64) _window.quantileUs(0.9);
+    stage["p99Us"] = (Json::UInt64) _window.quantileUs(0.99);
+    return stage;
+}
+
+Json::Value SGXWalletServer::getServerStatusExtendedImpl() {
+    COUNT_STATISTICS
+    INIT_RESULT(result)
+
+    try {
+        result["zmqSignQueueDepth"] = (Json::UInt64) ZMQServer::getSignQueueDepth();
+        result["zmqSlowQueueDepth"] = (Json::UInt64) ZMQServer::getSlowQueueDepth();
+        result["zmqOutgoingQueueDepth"] = (Json::UInt64) ZMQServer::getOutgoingQueueDepth();
+        result["zmqRejectedRequests"] = (Json::UInt64) ZMQServer::getRejectedRequests();
+
+        auto depths = ZMQServer::getSignQueueDepths();
+        result["zmqSignQueueDepths"] = Json::arrayValue;
+        for (auto depth : depths) {
+            result["zmqSignQueueDepths"].append((Json::UInt64) depth);
+        }
+        result["zmqExpiredRequests"] = (Json::UInt64) ZMQServer::getExpiredRequests();
+
+        // quantiles are derived from the power of two metrics buckets over the rolling window
+        Json::Value stages;
+        for (auto &&name : {"zmqQueueWait", "zmqParse", "leveldbRead", "zmqSerialize"}) {
+            stages[name] = stageLatency(Metrics::getRolling(name, Metrics::getHistogram(name)));
+        }
+        // ECALL latency is recorded only while ECALL timing is on, see ecallTiming
+        stages["ecall"] = stageLatency(Metrics::getRolling("allEcalls", Metrics::getAllEcallsLatency()));
+        result["stages"] = stages;
+        result["windowSeconds"] = METRICS_SAMPLE_INTERVAL_SECONDS * METRICS_ROLLING_WINDOW_SAMPLES;
+        result["ecallTiming"] = Metrics::isEcallTimingEnabled();
+
+        // every ECALL in flight occupies one of the ENCLAVE_TCS_NUM threads of an enclave instance
+        auto peak = Metrics::getPeakEcallsInFlight();
+        auto tcsNum = ENCLAVE_TCS_NUM * getEnclaveShards();
+        result["enclaveShards"] = (Json::UInt64) getEnclaveShards();
+        result["enclaveTcsNum"] = (Json::UInt64) tcsNum;
+        result["ecallsInFlight"] = (Json::UInt64) Metrics::getEcallsInFlight();
+        result["peakEcallsInFlight"] = (Json::UInt64) peak;
+        result["ecallGateWaiting"] = (Json::UInt64) EcallGate::getWaiting();
+        result["tcsUtilization"] = (double) peak / tcsNum;
+        result["enclaveGmpHeapBytes"] = (Json::Int64) Metrics::getGauge("enclaveGmpHeapBytes").get();
+        result["enclaveGmpHeapPeakBytes"] = (Json::Int64) Metrics::getGauge("enclaveGmpHeapPeakBytes").get();
+
+        // sizes that should level off under steady load, watched by sgx_soak
+        result["processRSSBytes"] = (Json::Int64) Metrics::getGauge("processRSSBytes").get();
+        result["dbApproximateBytes"] = (Json::UInt64) LevelDB::getLevelDb()->getApproximateSize();
+        result["dbCacheBytes"] = (Json::UInt64) LevelDB::getLevelDb()->getCache().sizeInBytes();
+        result["signCacheEntries"] = (Json::UInt64) (getBlsSignCacheSize() + getEcdsaSignCacheSize());
+        result["zmqSessions"] = (Json::UInt64) ZMQMessage::getNumSessions();
+        result["zmqVerifiedCerts"] = (Json::UInt64) ZMQMessage::getNumVerifiedCerts();
+        result["zmqFairQueueDepth"] = (Json::UInt64) ZMQServer::getFairQueueDepth();
+    } HANDLE_SGX_EXCEPTION(result)
+
+    RETURN_SUCCESS(result)
+}
+
+Json::Value SGXWalletServer::getServerVersionImpl() {
+    COUNT_STATISTICS
+    INIT_RESULT(result)
+    result["version"] = TOSTRING(SGXWALLET_VERSION);
+    RETURN_SUCCESS(result)
+}
+
+Json::Value SGXWalletServer::deleteBlsKeyImpl(const string &name) {
+    COUNT_STATISTICS
+    spdlog::info("Entering {}", __FUNCTION__);
+    INIT_RESULT(result)
+
+    result["deleted"] = false;
+    try {
+        if (!checkName(name, "BLS_KEY")) {
+            throw SGXException(DELETE_BLS_KEY_INVALID_KEYNAME, string(__FUNCTION__) + ":Invalid BLSKey name format");
+        }
+        shared_ptr <string> bls_ptr = LevelDB::getLevelDb()->readString(name);
+
+        if (bls_ptr != nullptr) {
+            LevelDB::getLevelDb()->deleteKeys({name, getBLSPubKeyName(name)});
+            KeyHandles::invalidateKey(name);
+            // a key imported later under the same name must not be answered with old shares
+            blsRequests.forget(name + ":");
+            result["deleted"] = true;
+        } else {
+            auto error_msg = "BLS key not found: " + name;
+            throw SGXException(DELETE_BLS_KEY_NOT_FOUND, string(__FUNCTION__) + ":" + error_msg.c_str());
+        }
+    } HANDLE_SGX_EXCEPTION(result)
+
+    RETURN_SUCCESS(result)
+}
+
+Json::Value SGXWalletServer::deleteSchainKeysImpl(const string &_schainId) {
     COUNT_STATISTICS
     spdlog::info("Entering {}", __FUNCTION__);
     INIT_RESULT(result)
 
+    result["deletedKeys"] = 0;
     try {
-        if (!checkName(_polyName, "POLY")) {
-            throw SGXException(INVALID_COMPLAINT_RESPONSE_POLY_NAME,
-                               string(__FUNCTION__) + ":Invalid polynomial name");
+        BULKHEAD(ADMIN)
+        if (!checkSchainId(_schainId)) {
+            throw SGXException(INVALID_SCHAIN_ID, string(__FUNCTION__) + ":Invalid schain id");
         }
 
-        string shareG2_name = "shareG2_" + _polyName + "_" + to_string(_ind) + ":";
-        string DHKey = decryptDHKey(_polyName, _ind);
-
-        shared_ptr <string> shareG2_ptr = readFromDb(shareG2_name);
-        CHECK_STATE(shareG2_ptr);
-        result["share*G2"] = *shareG2_ptr;
-        result["dhKey"] = DHKey;
+        auto deleted = LevelDB::getLevelDb()->deleteKeysWithPrefixes(getSchainKeyPrefixes(_schainId));
 
-        shared_ptr <string> encrPoly = readFromDb(_polyName);
-
-        auto verificationVectorMult = getVerificationVectorMult(encrPoly->c_str(), _t, _n, _ind);
+        auto blsKeyPrefix = "BLS_KEY:SCHAIN_ID:" + _schainId + ":";
+        KeyHandles::invalidateKeysWithPrefix(blsKeyPrefix);
+        // keys created later under the same names must not be answered with old shares
+        blsRequests.forget(blsKeyPrefix);
+        KeyStats::forgetKeysWithPrefix(blsKeyPrefix);
 
-        for (int i = 0; i < _t; i++) {
-            vector <string> currentCoef = verificationVectorMult.at(i);
-            for (int j = 0; j < 4; j++) {
-                result["verificationVectorMult"][i][j] = currentCoef.at(j);
+        static const string ownerSuffix = ":OWNER";
+        vector<string> ownedKeys;
+        for (auto &&key : deleted) {
+            if (key.size() > ownerSuffix.size() &&
+                key.compare(key.size() - ownerSuffix.size(), ownerSuffix.size(), ownerSuffix) == 0) {
+                ownedKeys.push_back(key.substr(0, key.size() - ownerSuffix.size()));
             }
         }
+        ZMQMessage::forgetKeyOwners(ownedKeys);
 
-        for (int i = 0; i < _n; i++) {
-            string name = _polyName + "_" + to_string(i) + ":";
-            LevelDB::getLevelDb()->deleteDHDKGKey(name);
-            string shareG2_name = "shareG2_" + _polyName + "_" + to_string(i) + ":";
-            LevelDB::getLevelDb()->deleteKey(shareG2_name);
-        }
-        LevelDB::getLevelDb()->deleteKey(_polyName);
-
-        string encryptedSecretShareName = "encryptedSecretShare:" + _polyName;
-        LevelDB::getLevelDb()->deleteKey(encryptedSecretShareName);
+        spdlog::info("Deleted {} keys of schain {}", deleted.size(), _schainId);
+        result["deletedKeys"] = (Json::UInt64) deleted.size();
     } HANDLE_SGX_EXCEPTION(result)
 
-    RETURN_SUCCESS(result);
+    RETURN_SUCCESS(result)
 }
 
-Json::Value SGXWalletServer::multG2Impl(const string &_x) {
+Json::Value SGXWalletServer::openKeyImpl(const string &_keyName) {
     COUNT_STATISTICS
+    spdlog::info("Entering {}", __FUNCTION__);
     INIT_RESULT(result)
 
+    result["keyHandle"] = "";
+
     try {
-        auto xG2_vect = mult_G2(_x);
-        for (uint8_t i = 0; i < 4; i++) {
-            result["x*G2"][i] = xG2_vect.at(i);
+        bool isBls = checkName(_keyName, "BLS_KEY");
+
+        if (!isBls && !checkECDSAKeyName(_keyName)) {
+            throw SGXException(INVALID_KEY_HANDLE, string(__FUNCTION__) + ":Invalid BLS or ECDSA key name");
         }
+
+        auto encryptedKey = readFromDb(_keyName);
+
+        result["keyHandle"] = KeyHandles::open(_keyName, isBls, *encryptedKey);
     } HANDLE_SGX_EXCEPTION(result)
 
-    RETURN_SUCCESS(result);
+    RETURN_SUCCESS(result)
 }
 
-Json::Value SGXWalletServer::isPolyExistsImpl(const string &_polyName) {
+Json::Value SGXWalletServer::closeKeyImpl(const string &_keyHandle) {
     COUNT_STATISTICS
-    spdlog::info("Entering {}", __FUNCTION__);
+    spdlog::trace("Entering {}", __FUNCTION__);
     INIT_RESULT(result)
 
-    result["IsExist"] = false;
+    result["closed"] = false;
 
     try {
-        shared_ptr <string> poly_str_ptr = LevelDB::getLevelDb()->readString(_polyName);
-
-        if (poly_str_ptr != nullptr) {
-            result["IsExist"] = true;
-        }
+        result["closed"] = KeyHandles::close(_keyHandle);
     } HANDLE_SGX_EXCEPTION(result)
 
-    RETURN_SUCCESS(result);
-}
-
-Json::Value SGXWalletServer::getServerStatusImpl() {
-    COUNT_STATISTICS
-    INIT_RESULT(result)
     RETURN_SUCCESS(result)
 }
 
-Json::Value SGXWalletServer::getServerVersionImpl() {
+Json::Value
+SGXWalletServer::blsSignMessageHashByHandleImpl(const string &_keyHandle, const string &_messageHash, int t, int n) {
     COUNT_STATISTICS
+    spdlog::trace("Entering {}", __FUNCTION__);
     INIT_RESULT(result)
-    result["version"] = TOSTRING(SGXWALLET_VERSION);
+
+    result["signatureShare"] = "";
+
+    vector<char> signature(BUF_LEN, 0);
+
+    try {
+        auto key = KeyHandles::get(_keyHandle);
+
+        if (!key->isBls) {
+            throw SGXException(INVALID_KEY_HANDLE, string(__FUNCTION__) + ":Not a BLS key handle");
+        }
+
+        if (!check_n_t(t, n)) {
+            throw SGXException(BLS_SIGN_INVALID_PARAMS, string(__FUNCTION__) + ":Invalid t/n parameters");
+        }
+
+        string hashTmp = _messageHash;
+        if (hashTmp.size() > 2 && hashTmp[0] == '0' && (hashTmp[1] == 'x' || hashTmp[1] == 'X')) {
+            hashTmp.erase(hashTmp.begin(), hashTmp.begin() + 2);
+        }
+
+        if (!checkHex(hashTmp)) {
+            throw SGXException(INVALID_BLS_HEX, string(__FUNCTION__) + ":Invalid bls hex");
+        }
+
+        if (!bls_sign_decoded(key->encryptedKey.data(), key->encryptedKey.size(), hashTmp.c_str(), t, n,
+                              signature.data())) {
+            throw SGXException(COULD_NOT_BLS_SIGN, ":Could not bls sign data ");
+        }
+    } HANDLE_SGX_EXCEPTION(result)
+
+    result["signatureShare"] = string(signature.data());
+
     RETURN_SUCCESS(result)
 }
 
-Json::Value SGXWalletServer::deleteBlsKeyImpl(const string &name) {
+Json::Value SGXWalletServer::ecdsaSignMessageHashByHandleImpl(int _base, const string &_keyHandle,
+                                                              const string &_messageHash) {
     COUNT_STATISTICS
-    spdlog::info("Entering {}", __FUNCTION__);
+    spdlog::trace("Entering {}", __FUNCTION__);
     INIT_RESULT(result)
 
-    result["deleted"] = false;
+    result["signature_v"] = "";
+    result["signature_r"] = "";
+    result["signature_s"] = "";
+
     try {
-        if (!checkName(name, "BLS_KEY")) {
-            throw SGXException(DELETE_BLS_KEY_INVALID_KEYNAME, string(__FUNCTION__) + ":Invalid BLSKey name format");
+        auto key = KeyHandles::get(_keyHandle);
+
+        if (key->isBls) {
+            throw SGXException(INVALID_KEY_HANDLE, string(__FUNCTION__) + ":Not an ECDSA key handle");
         }
-        shared_ptr <string> bls_ptr = LevelDB::getLevelDb()->readString(name);
 
-        if (bls_ptr != nullptr) {
-            LevelDB::getLevelDb()->deleteKey(name);
-            result["deleted"] = true;
-        } else {
-            auto error_msg = "BLS key not found: " + name;
-            throw SGXException(DELETE_BLS_KEY_NOT_FOUND, string(__FUNCTION__) + ":" + error_msg.c_str());
+        string hashTmp = _messageHash;
+        if (hashTmp.size() > 2 && hashTmp[0] == '0' && (hashTmp[1] == 'x' || hashTmp[1] == 'X')) {
+            hashTmp.erase(hashTmp.begin(), hashTmp.begin() + 2);
+        }
+        while (hashTmp[0] == '0') {
+            hashTmp.erase(hashTmp.begin(), hashTmp.begin() + 1);
+        }
+
+        if (!checkHex(hashTmp)) {
+            throw SGXException(INVALID_ECDSA_SIGN_HASH, ":Invalid ECDSA sign hash");
+        }
+        if (_base <= 0 || _base > 32) {
+            throw SGXException(INVALID_ECDSA_SIGN_BASE, ":Invalid ECDSA sign base");
+        }
+
+        auto signatureVector = ecdsaSignHash(key->encryptedKey, key->encryptedKeyHex, hashTmp.c_str(), _base);
+        if (signatureVector.size() != 3) {
+            throw SGXException(INVALID_ECSDA_SIGN_SIGNATURE, string(__FUNCTION__) + ":Invalid ecdsa signature");
         }
+
+        result["signature_v"] = signatureVector.at(0);
+        result["signature_r"] = signatureVector.at(1);
+        result["signature_s"] = signatureVector.at(2);
     } HANDLE_SGX_EXCEPTION(result)
 
     RETURN_SUCCESS(result)
@@ -850,6 +1881,8 @@ SGXWalletServer::getSecretShareV2Impl(const string &_polyName, const Json::Value
     result["secretShare"] = "";
 
     try {
+        BULKHEAD(DKG)
+        DKG_PHASE(SECRET_SHARE, _polyName)
         if (_pubKeys.size() != (uint64_t) _n) {
             throw SGXException(INVALID_DKG_GETSS_V2_PUBKEY_COUNT,
                                string(__FUNCTION__) + ":Invalid number of public keys");
@@ -880,8 +1913,7 @@ SGXWalletServer::getSecretShareV2Impl(const string &_polyName, const Json::Value
         if (encryptedSecretShare != nullptr) {
             result["secretShare"] = *encryptedSecretShare.get();
         } else {
-            string s = getSecretSharesV2(_polyName, encrPoly->c_str(), pubKeysStrs, _t, _n);
-            result["secretShare"] = s;
+            result["secretShare"] = getSecretSharesV2(_polyName, encrPoly->c_str(), pubKeysStrs, _t, _n);
         }
     } HANDLE_SGX_EXCEPTION(result)
 
@@ -892,10 +1924,51 @@ Json::Value SGXWalletServer::dkgVerificationV2Impl(const string &_publicShares,
                                                    const string &_secretShare, int _t, int _n, int _index) {
     COUNT_STATISTICS
     spdlog::info("Entering {}", __FUNCTION__);
-    INIT_RESULT(result)
+    INIT_LEAN_RESULT(result)
     result["result"] = false;
 
+    if (!checkECDSAKeyName(_ethKeyName)) {
+        RETURN_ERROR(result, INVALID_DKG_VV_V2_ECDSA_KEY_NAME, "Invalid ECDSA key name");
+    }
+    if (!check_n_t(_t, _n) || _index >= _n || _index < 0) {
+        RETURN_ERROR(result, INVALID_DKG_VV_V2_PARAMS, "Invalid DKG parameters: n or t ");
+    }
+    if (!checkHex(_secretShare, SECRET_SHARE_NUM_BYTES)) {
+        RETURN_ERROR(result, INVALID_DKG_VV_V2_SS_HEX, "Invalid Secret share");
+    }
+    string expanded;
+    auto publicShares = expandPublicShares(_publicShares, _t, expanded);
+    if (!publicShares) {
+        RETURN_ERROR(result, INVALID_DKG_VV_V2_SS_COUNT, "Invalid count of public shares");
+    }
+
+    try {
+        BULKHEAD(DKG)
+        DKG_PHASE(VERIFICATION, _ethKeyName)
+        auto encryptedKeyHex_ptr = checkDataFromDb(_ethKeyName);
+
+        if (!encryptedKeyHex_ptr) {
+            RETURN_ERROR(result, KEY_SHARE_DOES_NOT_EXIST, "Data with this name does not exist: " + _ethKeyName);
+        }
+
+        if (verifySharesV2(publicShares->c_str(), _secretShare.c_str(), encryptedKeyHex_ptr->c_str(), _t, _n, _index)) {
+            result["result"] = true;
+        }
+    } HANDLE_SGX_EXCEPTION(result)
+
+    RETURN_SUCCESS(result)
+}
+
+Json::Value SGXWalletServer::dkgVerificationBatchImpl(const Json::Value &_publicShares, const string &_ethKeyName,
+                                                      const Json::Value &_secretShares, int _t, int _n, int _index) {
+    COUNT_STATISTICS
+    spdlog::info("Entering {}", __FUNCTION__);
+    INIT_RESULT(result)
+    result["results"] = Json::Value(Json::arrayValue);
+
     try {
+        BULKHEAD(DKG)
+        DKG_PHASE(VERIFICATION, _ethKeyName)
         if (!checkECDSAKeyName(_ethKeyName)) {
             throw SGXException(INVALID_DKG_VV_V2_ECDSA_KEY_NAME,
                                string(__FUNCTION__) + ":Invalid ECDSA key name");
@@ -904,19 +1977,48 @@ Json::Value SGXWalletServer::dkgVerificationV2Impl(const string &_publicShares,
             throw SGXException(INVALID_DKG_VV_V2_PARAMS,
                                string(__FUNCTION__) + ":Invalid DKG parameters: n or t ");
         }
-        if (!checkHex(_secretShare, SECRET_SHARE_NUM_BYTES)) {
-            throw SGXException(INVALID_DKG_VV_V2_SS_HEX,
-                               string(__FUNCTION__) + ":Invalid Secret share");
+        if (!_publicShares.isArray() || !_secretShares.isArray() || _publicShares.empty() ||
+            _publicShares.size() != _secretShares.size() || _publicShares.size() > MAX_DKG_SHARES_BATCH_SIZE) {
+            throw SGXException(INVALID_DKG_VERIFY_BATCH, string(__FUNCTION__) +
+                                                         ":Public and secret shares should be non empty arrays of equal size of at most "
+                                                         + to_string(MAX_DKG_SHARES_BATCH_SIZE) + " elements");
+        }
+
+        vector<string> publicShares(_publicShares.size());
+        vector<string> secretShares;
+
+        for (int i = 0; i < (int) _publicShares.size(); i++) {
+            if (!_publicShares[i].isString() || !_secretShares[i].isString()) {
+                throw SGXException(INVALID_DKG_VERIFY_BATCH, string(__FUNCTION__) + ":Invalid shares " + to_string(i));
+            }
+            if (!checkHex(_secretShares[i].asString(), SECRET_SHARE_NUM_BYTES)) {
+                throw SGXException(INVALID_DKG_VV_V2_SS_HEX,
+                                   string(__FUNCTION__) + ":Invalid Secret share");
+            }
+            secretShares.push_back(_secretShares[i].asString());
         }
-        if (_publicShares.length() != (uint64_t) 256 * _t) {
+
+        atomic<bool> validShares(true);
+        parallelFor(publicShares.size(), [&](size_t i) {
+            string expanded;
+            auto expandedShares = expandPublicShares(_publicShares[(int) i].asString(), _t, expanded);
+            if (!expandedShares) {
+                validShares = false;
+                return;
+            }
+            publicShares[i] = *expandedShares;
+        });
+        if (!validShares) {
             throw SGXException(INVALID_DKG_VV_V2_SS_COUNT,
                                string(__FUNCTION__) + ":Invalid count of public shares");
         }
 
         shared_ptr <string> encryptedKeyHex_ptr = readFromDb(_ethKeyName);
 
-        if (verifySharesV2(_publicShares.c_str(), _secretShare.c_str(), encryptedKeyHex_ptr->c_str(), _t, _n, _index)) {
-            result["result"] = true;
+        auto verified = verifySharesBatch(publicShares, secretShares, encryptedKeyHex_ptr->c_str(), _t, _index);
+
+        for (auto &&isValid : verified) {
+            result["results"].append((bool) isValid);
         }
     } HANDLE_SGX_EXCEPTION(result)
 
@@ -932,6 +2034,8 @@ SGXWalletServer::createBLSPrivateKeyV2Impl(const string &_blsKeyName, const stri
     INIT_RESULT(result)
 
     try {
+        BULKHEAD(DKG)
+        DKG_PHASE(CREATE_BLS_KEY, _polyName, &_ethKeyName, &_blsKeyName)
         if (_secretShare.length() != (uint64_t) _n * 192) {
             throw SGXException(INVALID_CREATE_BLS_KEY_SECRET_SHARES_LENGTH,
                                string(__FUNCTION__) + ":Invalid secret share length");
@@ -952,31 +2056,36 @@ SGXWalletServer::createBLSPrivateKeyV2Impl(const string &_blsKeyName, const stri
             throw SGXException(INVALID_CREATE_BLS_DKG_PARAMS,
                                string(__FUNCTION__) + ":Invalid DKG parameters: n or t ");
         }
+        if (!checkSecretSharesV2(_secretShare, _n)) {
+            throw SGXException(INVALID_CREATE_BLS_KEY_SECRET_SHARES,
+                               string(__FUNCTION__) + ":Invalid secret shares");
+        }
         vector <string> sshares_vect;
 
         shared_ptr <string> encryptedKeyHex_ptr = readFromDb(_ethKeyName);
 
         CHECK_STATE(encryptedKeyHex_ptr);
 
-        bool res = createBLSShareV2(_blsKeyName, _secretShare.c_str(), encryptedKeyHex_ptr->c_str());
+        // read before createBLSShareV2 deletes it, so the enclave can drop its decrypted copy
+        auto encryptedPolyHex = checkDataFromDb(_polyName);
+
+        // the BLS key share and the removal of the DKG temporary keys are committed in one batch
+        bool res = createBLSShareV2(_blsKeyName, _secretShare.c_str(), encryptedKeyHex_ptr->c_str(),
+                                    getDKGTempKeyNames(_polyName, _n));
         if (res) {
             spdlog::info("BLS KEY SHARE CREATED ");
+            if (encryptedPolyHex) {
+                try {
+                    eraseDkgPoly(encryptedPolyHex->c_str());
+                } catch (SGXException &e) {
+                    spdlog::warn("Could not erase DKG poly {} from the enclave cache: {}", _polyName, e.getMessage());
+                }
+            }
         } else {
             throw SGXException(INVALID_CREATE_BLS_SHARE,
                                string(__FUNCTION__) + ":Error while creating BLS key share");
         }
 
-        for (int i = 0; i < _n; i++) {
-            string name = _polyName + "_" + to_string(i) + ":";
-            LevelDB::getLevelDb()->deleteDHDKGKey(name);
-            string shareG2_name = "shareG2_" + _polyName + "_" + to_string(i) + ":";
-            LevelDB::getLevelDb()->deleteKey(shareG2_name);
-        }
-        LevelDB::getLevelDb()->deleteKey(_polyName);
-
-        string encryptedSecretShareName = "encryptedSecretShare:" + _polyName;
-        LevelDB::getLevelDb()->deleteKey(encryptedSecretShareName);
-
     } HANDLE_SGX_EXCEPTION(result)
 
     RETURN_SUCCESS(result);
@@ -987,6 +2096,7 @@ Json::Value SGXWalletServer::generateBLSPrivateKeyImpl(const string& blsKeyName)
     INIT_RESULT(result)
 
     try {
+        BULKHEAD(ADMIN)
         if (!checkName(blsKeyName, "BLS_KEY")) {
             throw SGXException(GENERATE_BLS_KEY_INVALID_NAME, string(__FUNCTION__) + ":Invalid BLSKey name");
         }
@@ -1004,11 +2114,45 @@ Json::Value SGXWalletServer::generateBLSPrivateKeyImpl(const string& blsKeyName)
     RETURN_SUCCESS(result);
 }
 
+Json::Value SGXWalletServer::generateBLSPrivateKeyBatchImpl(const Json::Value& blsKeyNames) {
+    spdlog::info("Entering {}", __FUNCTION__);
+    INIT_RESULT(result)
+
+    try {
+        BULKHEAD(ADMIN)
+        if (!blsKeyNames.isArray() || blsKeyNames.empty() || blsKeyNames.size() > MAX_BLS_KEY_BATCH_SIZE) {
+            throw SGXException(INVALID_BLS_KEY_BATCH, string(__FUNCTION__) + ":Invalid number of BLS key names");
+        }
+
+        set<string> uniqueNames;
+        vector<string> names;
+        names.reserve(blsKeyNames.size());
+
+        for (auto &&blsKeyName : blsKeyNames) {
+            if (!blsKeyName.isString() || !checkName(blsKeyName.asString(), "BLS_KEY")) {
+                throw SGXException(GENERATE_BLS_KEY_INVALID_NAME, string(__FUNCTION__) + ":Invalid BLSKey name");
+            }
+            if (!uniqueNames.insert(blsKeyName.asString()).second) {
+                throw SGXException(INVALID_BLS_KEY_BATCH,
+                                   string(__FUNCTION__) + ":Duplicate BLS key name " + blsKeyName.asString());
+            }
+            names.push_back(blsKeyName.asString());
+        }
+
+        generateBLSPrivateKeysAggregatedBatch(names);
+
+        spdlog::info("{} BLS AGGREGATED KEYS CREATED ", names.size());
+    } HANDLE_SGX_EXCEPTION(result)
+
+    RETURN_SUCCESS(result);
+}
+
 Json::Value SGXWalletServer::getDecryptionSharesImpl(const std::string& blsKeyName, const Json::Value& publicDecryptionValues) {
     spdlog::info("Entering {}", __FUNCTION__);
     INIT_RESULT(result)
 
     try {
+        BULKHEAD(TE)
         if (!checkName(blsKeyName, "BLS_KEY")) {
             throw SGXException(BLS_SIGN_INVALID_KS_NAME, string(__FUNCTION__) + ":Invalid BLSKey name");
         }
@@ -1018,17 +2162,26 @@ Json::Value SGXWalletServer::getDecryptionSharesImpl(const std::string& blsKeyNa
                                string(__FUNCTION__) + ":Public decryption values should be an array");
         }
 
+        vector<string> values;
+        values.reserve(publicDecryptionValues.size());
+
         for (int i = 0; i < publicDecryptionValues.size(); ++i) {
+            if (!publicDecryptionValues[i].isString()) {
+                throw SGXException(INVALID_DECRYPTION_VALUE_FORMAT, string(__FUNCTION__) + ":Invalid publicDecryptionValue format");
+            }
             std::string publicDecryptionValue = publicDecryptionValues[i].asString();
             if ( publicDecryptionValue.length() < 7 || publicDecryptionValue.length() > 78 * 4 ) {
                 throw SGXException(INVALID_DECRYPTION_VALUE_FORMAT, string(__FUNCTION__) + ":Invalid publicDecryptionValue format");
             }
+            values.push_back(publicDecryptionValue);
+        }
 
-            shared_ptr<string> encryptedKeyHex_ptr = readFromDb(blsKeyName);
+        shared_ptr<string> encryptedKeyHex_ptr = readFromDb(blsKeyName);
 
-            vector<string> decryptionValueVector = calculateDecryptionShare(encryptedKeyHex_ptr->c_str(), publicDecryptionValue);
+        vector<vector<string>> decryptionShares = calculateDecryptionShares(*encryptedKeyHex_ptr, values);
+        for (int i = 0; i < decryptionShares.size(); ++i) {
             for (uint8_t j = 0; j < 4; ++j) {
-                result["decryptionShares"][i][j] = decryptionValueVector.at(j);
+                result["decryptionShares"][i][j] = decryptionShares[i].at(j);
             }
         }
     } HANDLE_SGX_EXCEPTION(result)
@@ -1043,6 +2196,7 @@ Json::Value SGXWalletServer::popProveImpl( const std::string& blsKeyName ) {
     vector <char> prove(BUF_LEN, 0);
 
     try {
+        BULKHEAD(ADMIN)
         if (!checkName(blsKeyName, "BLS_KEY")) {
             throw SGXException(POP_PROVE_INVALID_KEY_NAME, string(__FUNCTION__) + ":Invalid BLSKey name");
         }
@@ -1059,14 +2213,63 @@ Json::Value SGXWalletServer::popProveImpl( const std::string& blsKeyName ) {
     RETURN_SUCCESS(result)
 }
 
+Json::Value SGXWalletServer::popProveBatchImpl( const Json::Value& blsKeyNames ) {
+    spdlog::info("Entering {}", __FUNCTION__);
+    INIT_RESULT(result)
+
+    try {
+        BULKHEAD(ADMIN)
+        if (!blsKeyNames.isArray() || blsKeyNames.empty() || blsKeyNames.size() > MAX_BLS_KEY_BATCH_SIZE) {
+            throw SGXException(INVALID_BLS_KEY_BATCH, string(__FUNCTION__) + ":Invalid number of BLS key names");
+        }
+
+        vector<string> encryptedKeys;
+        vector<string> pubKeys;
+
+        for (auto &&blsKeyName : blsKeyNames) {
+            if (!blsKeyName.isString() || !checkName(blsKeyName.asString(), "BLS_KEY")) {
+                throw SGXException(POP_PROVE_INVALID_KEY_NAME, string(__FUNCTION__) + ":Invalid BLSKey name");
+            }
+
+            encryptedKeys.push_back(*readFromDb(blsKeyName.asString()));
+
+            auto pubKeyStr = checkDataFromDb(getBLSPubKeyName(blsKeyName.asString()));
+
+            if (pubKeyStr != nullptr) {
+                pubKeys.push_back(*pubKeyStr);
+            } else {
+                // keys created before public keys were stored with them
+                pubKeys.push_back(getBLSPubKeyString(encryptedKeys.back().c_str()));
+            }
+        }
+
+        auto proves = popProveBatchSGX(encryptedKeys, pubKeys);
+
+        result["popProves"] = Json::Value(Json::arrayValue);
+        for (auto &&prove : proves) {
+            result["popProves"].append(prove);
+        }
+    } HANDLE_SGX_EXCEPTION(result)
+
+    RETURN_SUCCESS(result)
+}
+
 Json::Value SGXWalletServer::generateDKGPoly(const string &_polyName, int _t) {
     return generateDKGPolyImpl(_polyName, _t);
 }
 
+Json::Value SGXWalletServer::generateDKGPolyBatch(const Json::Value &_polyNames, int _t) {
+    return generateDKGPolyBatchImpl(_polyNames, _t);
+}
+
 Json::Value SGXWalletServer::getVerificationVector(const string &_polynomeName, int _t) {
     return getVerificationVectorImpl(_polynomeName, _t);
 }
 
+Json::Value SGXWalletServer::getVerificationVectorCompressed(const string &_polyName, int _t) {
+    return getVerificationVectorCompressedImpl(_polyName, _t);
+}
+
 Json::Value SGXWalletServer::getSecretShare(const string &_polyName, const Json::Value &_publicKeys, int t, int n) {
     return getSecretShareImpl(_polyName, _publicKeys, t, n);
 }
@@ -1096,6 +2299,14 @@ Json::Value SGXWalletServer::importECDSAKey(const std::string &keyShare, const s
     return importECDSAKeyImpl(keyShare, keyShareName);
 }
 
+Json::Value SGXWalletServer::importECDSAKeyBatch(const Json::Value &_keys) {
+    return importECDSAKeyBatchImpl(_keys);
+}
+
+Json::Value SGXWalletServer::importBLSKeyShareBatch(const Json::Value &_keyShares) {
+    return importBLSKeyShareBatchImpl(_keyShares);
+}
+
 Json::Value SGXWalletServer::generateECDSAKey() {
     return generateECDSAKeyImpl();
 }
@@ -1108,6 +2319,11 @@ Json::Value SGXWalletServer::ecdsaSignMessageHash(int _base, const string &_keyS
     return ecdsaSignMessageHashImpl(_base, _keyShareName, _messageHash);
 }
 
+Json::Value
+SGXWalletServer::ecdsaSignMessageHashBatch(int _base, const string &_keyShareName, const Json::Value &_messageHashes) {
+    return ecdsaSignMessageHashBatchImpl(_base, _keyShareName, _messageHashes);
+}
+
 Json::Value
 SGXWalletServer::importBLSKeyShare(const string &_keyShare, const string &_keyShareName) {
     return importBLSKeyShareImpl(_keyShare, _keyShareName);
@@ -1126,6 +2342,19 @@ Json::Value SGXWalletServer::multG2(const string &x) {
     return multG2Impl(x);
 }
 
+Json::Value SGXWalletServer::multG2Batch(const Json::Value &_xs) {
+    return multG2BatchImpl(_xs);
+}
+
+Json::Value SGXWalletServer::aggregateBLSSignatures(const Json::Value &_shares, const Json::Value &_signerIndices,
+                                                   int _t, int _n) {
+    return aggregateBLSSignaturesImpl(_shares, _signerIndices, _t, _n);
+}
+
+Json::Value SGXWalletServer::verifyBLSSignatures(const Json::Value &_requests) {
+    return verifyBLSSignaturesImpl(_requests);
+}
+
 Json::Value SGXWalletServer::isPolyExists(const string &polyName) {
     return isPolyExistsImpl(polyName);
 }
@@ -1134,6 +2363,10 @@ Json::Value SGXWalletServer::getServerStatus() {
     return getServerStatusImpl();
 }
 
+Json::Value SGXWalletServer::getServerStatusExtended() {
+    return getServerStatusExtendedImpl();
+}
+
 Json::Value SGXWalletServer::getServerVersion() {
     return getServerVersionImpl();
 }
@@ -1142,6 +2375,30 @@ Json::Value SGXWalletServer::deleteBlsKey(const string &name) {
     return deleteBlsKeyImpl(name);
 }
 
+Json::Value SGXWalletServer::deleteSchainKeys(const string &schainId) {
+    return deleteSchainKeysImpl(schainId);
+}
+
+Json::Value SGXWalletServer::openKey(const string &keyName) {
+    return openKeyImpl(keyName);
+}
+
+Json::Value SGXWalletServer::closeKey(const string &keyHandle) {
+    return closeKeyImpl(keyHandle);
+}
+
+Json::Value SGXWalletServer::blsSignHashedPoint(const string &keyShareName, const string &hashedPoint, const string &hint) {
+    return blsSignHashedPointImpl(keyShareName, hashedPoint, hint);
+}
+
+Json::Value SGXWalletServer::blsSignMessageHashByHandle(const string &keyHandle, const string &messageHash, int t, int n) {
+    return blsSignMessageHashByHandleImpl(keyHandle, messageHash, t, n);
+}
+
+Json::Value SGXWalletServer::ecdsaSignMessageHashByHandle(int base, const string &keyHandle, const string &messageHash) {
+    return ecdsaSignMessageHashByHandleImpl(base, keyHandle, messageHash);
+}
+
 Json::Value SGXWalletServer::getSecretShareV2(const string &_polyName, const Json::Value &_publicKeys, int t, int n) {
     return getSecretShareV2Impl(_polyName, _publicKeys, t, n);
 }
@@ -1153,6 +2410,12 @@ SGXWalletServer::dkgVerificationV2(const string &_publicShares, const string &et
     return dkgVerificationV2Impl(_publicShares, ethKeyName, SecretShare, t, n, index);
 }
 
+Json::Value
+SGXWalletServer::dkgVerificationBatch(const Json::Value &_publicShares, const string &ethKeyName,
+                                      const Json::Value &_secretShares, int t, int n, int index) {
+    return dkgVerificationBatchImpl(_publicShares, ethKeyName, _secretShares, t, n, index);
+}
+
 Json::Value
 SGXWalletServer::createBLSPrivateKeyV2(const string &blsKeyName, const string &ethKeyName, const string &polyName,
                                        const string &SecretShare, int t, int n) {
@@ -1163,6 +2426,10 @@ Json::Value SGXWalletServer::generateBLSPrivateKey(const string& blsKeyName) {
     return generateBLSPrivateKeyImpl(blsKeyName);
 }
 
+Json::Value SGXWalletServer::generateBLSPrivateKeyBatch(const Json::Value& blsKeyNames) {
+    return generateBLSPrivateKeyBatchImpl(blsKeyNames);
+}
+
 Json::Value SGXWalletServer::getDecryptionShares(const std::string& blsKeyName, const Json::Value& publicDecryptionValues) {
     return getDecryptionSharesImpl(blsKeyName, publicDecryptionValues);
 }
@@ -1171,6 +2438,10 @@ Json::Value SGXWalletServer::popProve( const std::string& blsKeyName ) {
     return popProveImpl( blsKeyName );
 }
 
+Json::Value SGXWalletServer::popProveBatch( const Json::Value& blsKeyNames ) {
+    return popProveBatchImpl( blsKeyNames );
+}
+
 shared_ptr <string> SGXWalletServer::readFromDb(const string &name, const string &prefix) {
     auto dataStr = checkDataFromDb(prefix + name);
 
@@ -1197,6 +2468,63 @@ void SGXWalletServer::writeKeyShare(const string &_keyShareName, const string &_
     LevelDB::getLevelDb()->writeString(_keyShareName, _value);
 }
 
+void SGXWalletServer::writeBatchToDB(const vector<pair<string, string>> &_keyValues,
+                                     const vector<string> &_keysToDelete) {
+    LevelDB::getLevelDb()->writeBatchUnique(_keyValues, _keysToDelete);
+}
+
+vector<string> SGXWalletServer::getDKGTempKeyNames(const string &_polyName, int _n) {
+    vector<string> names;
+    for (int i = 0; i < _n; i++) {
+        names.push_back("DKG_DH_KEY_" + _polyName + "_" + to_string(i) + ":");
+        names.push_back("shareG2_" + _polyName + "_" + to_string(i) + ":");
+    }
+    names.push_back(_polyName);
+    names.push_back(getVerificationVectorName(_polyName));
+    names.push_back("encryptedSecretShare:" + _polyName);
+    return names;
+}
+
+string SGXWalletServer::getVerificationVectorName(const string &_polyName) {
+    return "VV_" + _polyName;
+}
+
+vector<vector<string>> SGXWalletServer::readVerificationVector(const string &_polyName, int _t) {
+    static auto &misses = Metrics::getCounter("verificationVectorMisses");
+
+    auto stored = checkDataFromDb(getVerificationVectorName(_polyName));
+
+    if (stored) {
+        // compressed since G2Codec, decimal before
+        auto verificationVector = isCompressedG2(*stored) ? decompressToDecimalG2(*stored)
+                                                          : parseVerificationVector(*stored);
+        if (verificationVector.size() == (uint64_t) _t) {
+            return verificationVector;
+        }
+    }
+
+    // polys generated by older versions, or asked for with another t
+    misses.inc();
+    shared_ptr <string> encrPoly = readFromDb(_polyName);
+    return get_verif_vect(*encrPoly, _t);
+}
+
+string SGXWalletServer::getBLSPubKeyName(const string &_blsKeyName) {
+    return "BLS_PUBKEY:" + _blsKeyName;
+}
+
+string SGXWalletServer::getECDSAPubKeyName(const string &_keyName) {
+    return "ECDSA_PUBKEY:" + _keyName;
+}
+
+vector<string> SGXWalletServer::getSchainKeyPrefixes(const string &_schainId) {
+    auto schain = "SCHAIN_ID:" + _schainId + ":";
+    // owner records are suffixed, so they are deleted with their keys
+    return {"BLS_KEY:" + schain, getBLSPubKeyName("BLS_KEY:" + schain), "POLY:" + schain,
+            getVerificationVectorName("POLY:" + schain), "DKG_DH_KEY_POLY:" + schain, "shareG2_POLY:" + schain,
+            "encryptedSecretShare:POLY:" + schain};
+}
+
 void SGXWalletServer::writeDataToDB(const string &name, const string &value) {
     if (LevelDB::getLevelDb()->readString(name) != nullptr) {
         throw SGXException(KEY_NAME_ALREADY_EXISTS, string(__FUNCTION__) + ":Name already exists" + name);
@@ -31,6 +31,9 @@
 #include <jsonrpccpp/server/connectors/httpserver.h>
 
 #include "abstractstubserver.h"
+#include "RequestCoalescer.h"
+#include "SignBatcher.h"
+#include "JsonRpcBatchHandler.h"
 
 using namespace jsonrpc;
 using namespace std;
@@ -41,15 +44,38 @@ using namespace std;
 
 class SGXWalletServer : public AbstractStubServer {
     static shared_ptr<SGXWalletServer> server;
-    static shared_ptr<HttpServer> httpServer;
+    static shared_ptr<AbstractServerConnector> httpServer;
+    static shared_ptr<JsonRpcBatchHandler> batchHandler;
+    static uint64_t numHttpThreads;
+    static uint64_t maxHttpInFlight;
+    static bool eventHttp;
 
-    static map<string,string> blsRequests;
-    static recursive_mutex blsRequestsLock;
-    static map<string,string> ecdsaRequests;
-    static recursive_mutex ecdsaRequestsLock;
+    static void installBatchHandler();
 
-    static void checkForDuplicate(map <string, string> &_map, recursive_mutex &_m, const string &_key,
-    const string &_value);
+    // the libjson-rpc-cpp HttpServer, or the EventHttpServer with sgxwallet -x
+    static shared_ptr<AbstractServerConnector> makeHttpServer(int _port, const string &_certPath,
+                                                              const string &_keyPath, const string &_rootCAPath,
+                                                              bool _checkCerts);
+
+    static RequestCoalescer blsRequests;
+    static RequestCoalescer ecdsaRequests;
+    static RequestCoalescer blsPublicKeysRequests;
+
+    static bool persistBlsPublicKeys;
+
+    static SignBatcher blsSigns;
+    static SignBatcher ecdsaSigns;
+
+    static Json::Value
+    computeAllBLSPublicKeys(const Json::Value &publicShares, int t, int n, const string &_key);
+
+    static Json::Value
+    computeBlsSignMessageHash(const string &_keyShareName, const string &_messageHash, int t, int n);
+
+    static Json::Value
+    computeBlsSignHashedPoint(const string &_keyShareName, const string &_hashedPoint, const string &_hint);
+
+    static Json::Value computeEcdsaSignMessageHash(int _base, const string &_keyName, const string &_messageHash);
 
 public:
 
@@ -70,17 +96,31 @@ public:
     virtual Json::Value importECDSAKey(const std::string& keyShare,
                                        const std::string& keyShareName);
 
+    virtual Json::Value importBLSKeyShareBatch(const Json::Value &_keyShares);
+
+    virtual Json::Value importECDSAKeyBatch(const Json::Value &_keys);
+
     virtual Json::Value generateECDSAKey();
 
     virtual Json::Value
     ecdsaSignMessageHash(int _base, const string &_keyShareName, const string &_messageHash);
 
+    virtual Json::Value
+    ecdsaSignMessageHashBatch(int _base, const string &_keyShareName, const Json::Value &_messageHashes);
+
     virtual Json::Value getPublicECDSAKey(const string &_keyName);
 
     virtual Json::Value generateDKGPoly(const string &_polyName, int _t);
 
+    // up to MAX_DKG_POLY_BATCH_SIZE polys in one ECALL and one database write, returns the
+    // verification vector of each in compressed form, see getVerificationVectorCompressed
+    virtual Json::Value generateDKGPolyBatch(const Json::Value &_polyNames, int _t);
+
     virtual Json::Value getVerificationVector(const string &_polynomeName, int _t);
 
+    // the commitments as one string of compressed points, see G2Codec.h, usable as public shares
+    virtual Json::Value getVerificationVectorCompressed(const string &_polyName, int _t);
+
     virtual Json::Value getSecretShare(const string &_polyName, const Json::Value &_publicKeys, int t, int n);
 
     virtual Json::Value
@@ -93,6 +133,9 @@ public:
 
     virtual Json::Value generateBLSPrivateKey( const string& blsKeyName );
 
+    // up to MAX_BLS_KEY_BATCH_SIZE keys in one ECALL and one database write
+    virtual Json::Value generateBLSPrivateKeyBatch( const Json::Value& blsKeyNames );
+
     virtual Json::Value getBLSPublicKeyShare(const string &blsKeyName);
 
     virtual Json::Value calculateAllBLSPublicKeys(const Json::Value& publicShares, int t, int n);
@@ -101,30 +144,78 @@ public:
 
     virtual Json::Value multG2(const string &x);
 
+    virtual Json::Value multG2Batch(const Json::Value &_xs);
+
+    virtual Json::Value aggregateBLSSignatures(const Json::Value &_shares, const Json::Value &_signerIndices, int _t,
+                                               int _n);
+
+    virtual Json::Value verifyBLSSignatures(const Json::Value &_requests);
+
     virtual Json::Value isPolyExists(const string &polyName);
 
     virtual Json::Value getServerStatus();
 
+    virtual Json::Value getServerStatusExtended();
+
     virtual Json::Value getServerVersion();
 
     virtual Json::Value deleteBlsKey( const std::string& name );
 
+    // deletes all BLS keys and DKG data of a retired schain in one batch
+    virtual Json::Value deleteSchainKeys( const std::string& schainId );
+
+    virtual Json::Value openKey(const std::string& keyName);
+
+    virtual Json::Value closeKey(const std::string& keyHandle);
+
+    virtual Json::Value blsSignMessageHashByHandle(const std::string& keyHandle, const std::string& messageHash, int t, int n);
+
+    virtual Json::Value blsSignHashedPoint(const std::string& keyShareName, const std::string& hashedPoint,
+                                           const std::string& hint);
+
+    virtual Json::Value ecdsaSignMessageHashByHandle(int base, const std::string& keyHandle, const std::string& messageHash);
+
     virtual Json::Value getSecretShareV2(const string &_polyName, const Json::Value &_publicKeys, int t, int n);
 
     virtual Json::Value dkgVerificationV2(const string &_publicShares, const string &ethKeyName, const string &SecretShare, int t, int n, int index);
 
+    virtual Json::Value dkgVerificationBatch(const Json::Value &_publicShares, const string &ethKeyName, const Json::Value &_secretShares, int t, int n, int index);
+
     virtual Json::Value createBLSPrivateKeyV2(const std::string& blsKeyName, const std::string& ethKeyName, const std::string& polyName, const std::string & SecretShare, int t, int n);
 
     virtual Json::Value getDecryptionShares(const std::string& blsKeyName, const Json::Value& publicDecryptionValues);
 
     virtual Json::Value popProve( const std::string& blsKeyName );
 
+    // the PoPs of up to MAX_BLS_KEY_BATCH_SIZE keys, signed in one ECALL, in the order of blsKeyNames
+    virtual Json::Value popProveBatch( const Json::Value& blsKeyNames );
+
     static shared_ptr<string> readFromDb(const string &name, const string &prefix = "");
 
     static shared_ptr <string> checkDataFromDb(const string &name, const string &prefix = "");
 
     static void writeDataToDB(const string &Name, const string &value);
 
+    static void writeBatchToDB(const vector<pair<string, string>> &_keyValues,
+                               const vector<string> &_keysToDelete = {});
+
+    static vector<string> getDKGTempKeyNames(const string &_polyName, int _n);
+
+    // name of the verification vector stored with each poly
+    static string getVerificationVectorName(const string &_polyName);
+
+    // the stored verification vector, computed in the enclave only if the poly has none
+    static vector<vector<string>> readVerificationVector(const string &_polyName, int _t);
+
+    // name of the "x0:x1:y0:y1" public key share stored with each BLS key
+    static string getBLSPubKeyName(const string &_blsKeyName);
+
+    // name of the hex public key stored with each ECDSA key
+    static string getECDSAPubKeyName(const string &_keyName);
+
+    // prefixes of the names of all keys, DKG data and owner records of a schain
+    static vector<string> getSchainKeyPrefixes(const string &_schainId);
+
     static void writeKeyShare(const string &_keyShareName, const string &_value);
 
     static Json::Value
@@ -135,16 +226,28 @@ public:
 
     static Json::Value importECDSAKeyImpl(const string &_keyShare, const string &_keyShareName);
 
+    // import many keys with one ECALL and one database write, the results array holds the
+    // status of every key in request order
+    static Json::Value importBLSKeyShareBatchImpl(const Json::Value &_keyShares);
+
+    static Json::Value importECDSAKeyBatchImpl(const Json::Value &_keys);
+
     static Json::Value generateECDSAKeyImpl();
 
     static Json::Value ecdsaSignMessageHashImpl(int _base, const string &keyName, const string &_messageHash);
 
+    static Json::Value ecdsaSignMessageHashBatchImpl(int _base, const string &keyName, const Json::Value &_messageHashes);
+
     static Json::Value getPublicECDSAKeyImpl(const string &_keyName);
 
     static Json::Value generateDKGPolyImpl(const string &_polyName, int _t);
 
+    static Json::Value generateDKGPolyBatchImpl(const Json::Value &_polyNames, int _t);
+
     static Json::Value getVerificationVectorImpl(const string &_polyName, int _t);
 
+    static Json::Value getVerificationVectorCompressedImpl(const string &_polyName, int _t);
+
     static Json::Value getSecretShareImpl(const string &_polyName, const Json::Value &_pubKeys, int _t, int _n);
 
     static Json::Value
@@ -163,28 +266,107 @@ public:
 
     static Json::Value multG2Impl(const string &_x);
 
+    static Json::Value multG2BatchImpl(const Json::Value &_xs);
+
+    static Json::Value aggregateBLSSignaturesImpl(const Json::Value &_shares, const Json::Value &_signerIndices,
+                                                  int _t, int _n);
+
+    static Json::Value verifyBLSSignaturesImpl(const Json::Value &_requests);
+
     static Json::Value isPolyExistsImpl(const string &_polyName);
 
     static Json::Value getServerStatusImpl();
 
+    // getServerStatus plus per worker queue depths, rolling stage latencies and enclave TCS utilization
+    static Json::Value getServerStatusExtendedImpl();
+
     static Json::Value getServerVersionImpl();
 
     static Json::Value deleteBlsKeyImpl(const std::string& name);
 
+    static Json::Value deleteSchainKeysImpl(const std::string& _schainId);
+
+    // resolves a BLS or ECDSA key once, see KeyHandles.h
+    static Json::Value openKeyImpl(const std::string& _keyName);
+
+    static Json::Value closeKeyImpl(const std::string& _keyHandle);
+
+    static Json::Value blsSignMessageHashByHandleImpl(const std::string& _keyHandle, const std::string& _messageHash, int t, int n);
+
+    // signs a G1 point hashed by the client, so the server skips the hash to G1
+    static Json::Value blsSignHashedPointImpl(const std::string& _keyShareName, const std::string& _hashedPoint,
+                                              const std::string& _hint);
+
+    static Json::Value ecdsaSignMessageHashByHandleImpl(int _base, const std::string& _keyHandle, const std::string& _messageHash);
+
     static Json::Value getSecretShareV2Impl(const string &_polyName, const Json::Value &_pubKeys, int _t, int _n);
 
     static Json::Value dkgVerificationV2Impl(const string &_publicShares, const string &_ethKeyName, const string &_secretShare, int _t, int _n, int _index);
 
+    static Json::Value dkgVerificationBatchImpl(const Json::Value &_publicShares, const string &_ethKeyName, const Json::Value &_secretShares, int _t, int _n, int _index);
+
     static Json::Value createBLSPrivateKeyV2Impl(const std::string& blsKeyName, const std::string& ethKeyName, const std::string& polyName, const std::string & SecretShare, int t, int n);
 
     static Json::Value generateBLSPrivateKeyImpl( const string& blsKeyName );
 
+    static Json::Value generateBLSPrivateKeyBatchImpl( const Json::Value& blsKeyNames );
+
     static Json::Value getDecryptionSharesImpl(const std::string& KeyName, const Json::Value& publicDecryptionValues);
 
     static Json::Value popProveImpl( const std::string& blsKeyName );
 
+    static Json::Value popProveBatchImpl( const Json::Value& blsKeyNames );
+
+    static Json::Value blsSignMessageHashBatchImpl(const Json::Value& _requests);
+
     static void printDB();
 
+    // zero _maxInFlight disables fast rejection of requests above the limit
+    static void setHttpThreadsConfig(uint64_t _numThreads, uint64_t _maxInFlight);
+
+    static uint64_t getNumHttpThreads() { return numHttpThreads; }
+
+    static uint64_t getMaxHttpInFlight() { return maxHttpInFlight; }
+
+    static void setEventHttp(bool _eventHttp) { eventHttp = _eventHttp; }
+
+    static bool isEventHttp() { return eventHttp; }
+
+    // HTTP requests received and JSON-RPC calls they carried, batch arrays carry many calls
+    static uint64_t getHttpRequests();
+
+    static uint64_t getHttpCalls();
+
+    static uint64_t getHttpRejected();
+
+    static uint64_t getHttpRateLimited();
+
+    // sign requests answered from the result cache, and those that waited for an identical one
+    static uint64_t getBlsSignCacheHits() { return blsRequests.getCacheHits(); }
+
+    static uint64_t getBlsSignCoalesced() { return blsRequests.getCoalesced(); }
+
+    static uint64_t getBlsSignCacheSize() { return blsRequests.getSize(); }
+
+    static uint64_t getEcdsaSignCacheHits() { return ecdsaRequests.getCacheHits(); }
+
+    static uint64_t getEcdsaSignCoalesced() { return ecdsaRequests.getCoalesced(); }
+
+    static uint64_t getEcdsaSignCacheSize() { return ecdsaRequests.getSize(); }
+
+    static uint64_t getBlsPublicKeysCacheHits() { return blsPublicKeysRequests.getCacheHits(); }
+
+    static uint64_t getBlsPublicKeysCoalesced() { return blsPublicKeysRequests.getCoalesced(); }
+
+    // also keeps the public keys of each DKG round in LevelDB, so that they survive a restart
+    static void setPersistBlsPublicKeys(bool _persist) { persistBlsPublicKeys = _persist; }
+
+    // drops the kept results of both sign caches, used under memory pressure
+    static void dropKeptSignResults() {
+        blsRequests.dropKept();
+        ecdsaRequests.dropKept();
+    }
+
     static void initHttpServer();
 
     static void initHttpsServer(bool _checkCerts);
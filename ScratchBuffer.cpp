@@ -0,0 +1,59 @@
+/*
+    Copyright (C) 2021-Present SKALE Labs
+
+    This file is part of sgxwallet.
+
+    sgxwallet is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as published
+    by the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    sgxwallet is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with sgxwallet. If not, see <https://www.gnu.org/licenses/>.
+
+    @file ScratchBuffer.cpp
+    @author Stan Kladko
+    @date 2021
+*/
+
+
+#include "sgxwallet_common.h"
+
+#include "ScratchBuffer.h"
+
+vector<vector<char>> &ScratchBuffer::getPool() {
+    static thread_local vector<vector<char>> pool = []() {
+        vector<vector<char>> p;
+        p.reserve(SCRATCH_BUFFER_POOL_SIZE);
+        return p;
+    }();
+    return pool;
+}
+
+ScratchBuffer::ScratchBuffer(size_t _size) {
+    auto &pool = getPool();
+
+    // the most recently returned buffer is the one still in the CPU cache
+    for (auto it = pool.rbegin(); it != pool.rend(); ++it) {
+        if (it->capacity() >= _size) {
+            buffer.swap(*it);
+            pool.erase(next(it).base());
+            break;
+        }
+    }
+
+    buffer.assign(_size, 0);
+}
+
+ScratchBuffer::~ScratchBuffer() {
+    auto &pool = getPool();
+
+    if (buffer.capacity() <= SCRATCH_BUFFER_MAX_POOLED_LEN && pool.size() < SCRATCH_BUFFER_POOL_SIZE) {
+        pool.push_back(move(buffer));
+    }
+}
@@ -0,0 +1,58 @@
+/*
+    Copyright (C) 2021-Present SKALE Labs
+
+    This file is part of sgxwallet.
+
+    sgxwallet is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as published
+    by the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    sgxwallet is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with sgxwallet. If not, see <https://www.gnu.org/licenses/>.
+
+    @file ScratchBuffer.h
+    @author Stan Kladko
+    @date 2021
+*/
+
+
+#ifndef SGXWALLET_SCRATCHBUFFER_H
+#define SGXWALLET_SCRATCHBUFFER_H
+
+#include <cstddef>
+#include <vector>
+
+using namespace std;
+
+// A zeroed char buffer for the error messages and outputs of an ECALL. The memory is taken
+// from a pool of the calling thread and given back when the buffer goes out of scope, so a
+// request reuses the buffers of earlier requests on the same thread instead of allocating them.
+// Buffers larger than SCRATCH_BUFFER_MAX_POOLED_LEN are not kept.
+class ScratchBuffer {
+
+    vector<char> buffer;
+
+    static vector<vector<char>> &getPool();
+
+public:
+
+    explicit ScratchBuffer(size_t _size);
+
+    ~ScratchBuffer();
+
+    ScratchBuffer(const ScratchBuffer &) = delete;
+
+    ScratchBuffer &operator=(const ScratchBuffer &) = delete;
+
+    char *data() { return buffer.data(); }
+
+    size_t size() const { return buffer.size(); }
+};
+
+#endif //SGXWALLET_SCRATCHBUFFER_H
@@ -21,53 +21,72 @@
     @date 2019
 */
 
-#include <vector>
-#include "ServerDataChecker.h"
-#include <gmp.h>
+#include <array>
+#include <string_view>
 
-#include <iostream>
+#include "ServerDataChecker.h"
 
 #include "third_party/spdlog/spdlog.h"
 #include "common.h"
+#include "sgxwallet_common.h"
+
+// the checks run on every sign request, so they scan the name once and do not allocate
+
+static constexpr array<bool, 256> makeCharTable(bool _hex) {
+    array<bool, 256> table = {};
+    for (int c = '0'; c <= '9'; c++) table[c] = true;
+    if (_hex) {
+        for (int c = 'a'; c <= 'f'; c++) table[c] = true;
+        for (int c = 'A'; c <= 'F'; c++) table[c] = true;
+    }
+    return table;
+}
+
+static constexpr auto HEX_CHARS = makeCharTable(true);
+
+static constexpr auto DEC_CHARS = makeCharTable(false);
+
+static bool isAll(string_view _s, const array<bool, 256> &_table) {
+    for (unsigned char c : _s) {
+        if (!_table[c]) return false;
+    }
+    return true;
+}
 
-vector<string> SplitString(const string& str, const string& delim = ":"){
-    vector<string> tokens;
-    size_t prev = 0, pos = 0;
-    do {
-        pos = str.find(delim, prev);
-        if (pos == string::npos) pos = str.length();
-        string token = str.substr(prev, pos-prev);
-        if (!token.empty()) tokens.push_back(token);
-        prev = pos + delim.length();
-    } while (pos < str.length() && prev < str.length());
-
-    return tokens;
+// splits on ':' skipping empty parts like the old SplitString, returns false on more than N parts
+template<size_t N>
+static bool splitName(string_view _name, array<string_view, N> &_parts, size_t &_numParts) {
+    _numParts = 0;
+    size_t prev = 0;
+    while (prev < _name.size()) {
+        auto pos = _name.find(':', prev);
+        if (pos == string_view::npos) pos = _name.size();
+        if (pos > prev) {
+            if (_numParts == N) return false;
+            _parts[_numParts++] = _name.substr(prev, pos - prev);
+        }
+        prev = pos + 1;
+    }
+    return true;
 }
 
 bool checkECDSAKeyName(const string& keyName) {
-  vector<string> parts = SplitString(keyName);
-  if (parts.size() != 2) {
+  array<string_view, 2> parts;
+  size_t numParts;
+  if (!splitName(keyName, parts, numParts) || numParts != 2) {
     spdlog::info("ECDSAKeyName num parts != 2");
     return false;
   }
-  if (parts.at(0) != "NEK") {
+  if (parts[0] != "NEK") {
       spdlog::info("key doesn't start from NEK");
       return false;
   }
-  if ( parts.at(1).length() > 64 || parts.at(1).length() < 1){
+  if ( parts[1].length() > 64 || parts[1].length() < 1){
       spdlog::info("wrong key length");
       return false;
   }
 
-  mpz_t num;
-  mpz_init(num);
-  if ( mpz_set_str(num, parts.at(1).c_str(), 16) == -1){
-    mpz_clear(num);
-    return false;
-  }
-  mpz_clear(num);
-
-  return true;
+  return isAll(parts[1], HEX_CHARS);
 }
 
 bool checkHex(const string& hex, const uint32_t sizeInBytes){
@@ -76,84 +95,73 @@ bool checkHex(const string& hex, const uint32_t sizeInBytes){
     return false;
   }
 
-  mpz_t num;
-  mpz_init(num);
-
-  if (mpz_set_str(num, hex.c_str(), 16) == -1) {
+  if (!isAll(hex, HEX_CHARS)) {
     spdlog::error("key is not hex {}", hex);
-    mpz_clear(num);
     return false;
   }
-  mpz_clear(num);
 
   return true;
 }
 
 bool checkName (const string& Name, const string& prefix){
-    vector<string> parts = SplitString(Name);
-    if ( parts.size() != 7) {
+    array<string_view, 7> parts;
+    size_t numParts;
+    if (!splitName(Name, parts, numParts) || numParts != 7) {
         spdlog::info("parts.size() != 7");
         return false;
     }
-    if ( parts.at(0) != prefix ) {
+    if ( parts[0] != prefix ) {
         spdlog::info("parts.at(0) != prefix");
         return false;
     }
-    if ( parts.at(1) != "SCHAIN_ID"){
+    if ( parts[1] != "SCHAIN_ID"){
         spdlog::info("parts.at(1) != SCHAIN_ID");
         return false;
     }
-    if ( parts.at(3) != "NODE_ID"){
+    if ( parts[3] != "NODE_ID"){
         spdlog::info("parts.at(3) != Node_ID");
         return false;
     }
-    if ( parts.at(5) != "DKG_ID"){
+    if ( parts[5] != "DKG_ID"){
         spdlog::info("parts.at(1) != DKG_ID");
         return false;
     }
 
-    if ( parts.at(2).length() > 78 || parts.at(2).length() < 1){
+    if ( parts[2].length() > 78 || parts[2].length() < 1){
         spdlog::info("parts.at(2).length() > 78");
         return false;
     }
-    if (parts.at(4).length() > 5 || parts.at(4).length() < 1){
+    if (parts[4].length() > 5 || parts[4].length() < 1){
         spdlog::info("parts.at(4).length() > 5");
         return false;
     }
-    if ( parts.at(6).length() > 78 || parts.at(6).length() < 1){
+    if ( parts[6].length() > 78 || parts[6].length() < 1){
         spdlog::info("parts.at(6).length() > 78");
         return false;
     }
 
-    mpz_t num;
-    mpz_init(num);
-
-    if ( mpz_set_str(num, parts.at(2).c_str(), 10) == -1) {
-        mpz_clear(num);
+    if (!isAll(parts[2], DEC_CHARS)) {
         spdlog::info("parts.at(2) is not decimal number");
         return false;
     }
-    mpz_clear(num);
-    mpz_init(num);
 
-    if ( mpz_set_str(num, parts.at(4).c_str(), 10) == -1){
-        mpz_clear(num);
+    if (!isAll(parts[4], DEC_CHARS)) {
         spdlog::info("parts.at(4) is not decimal number");
         return false;
     }
-    mpz_clear(num);
-    mpz_init(num);
 
-    if ( mpz_set_str(num, parts.at(6).c_str(),10) == -1){
-        mpz_clear(num);
+    if (!isAll(parts[6], DEC_CHARS)) {
         spdlog::info("parts.at(6) is not decimal number");
         return false;
     }
-    mpz_clear(num);
 
     return true;
 }
 
+bool checkSchainId(const string& schainId) {
+    return schainId.length() >= 1 && schainId.length() <= 78 && isAll(schainId, DEC_CHARS);
+}
+
 bool check_n_t ( const int t, const int n){
   if (t > n){
     return false;
@@ -163,7 +171,7 @@ bool check_n_t ( const int t, const int n){
     return false;
   }
 
-  if (n > 32){
+  if (n > MAX_DKG_N){
     return false;
   }
 
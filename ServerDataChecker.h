@@ -34,6 +34,9 @@ bool checkPolyName (const std::string& polyName);
 
 bool checkName (const std::string& Name, const std::string& prefix);
 
+// the SCHAIN_ID part of a key name, see checkName
+bool checkSchainId(const std::string& schainId);
+
 bool check_n_t ( const int t, const int n);
 
 #endif // SGXD_SERVERDATACHECKER_H
@@ -21,10 +21,16 @@
     @date 2019
 */
 
+#include <chrono>
+#include <functional>
+#include <future>
 #include <memory>
 #include <iostream>
 
 #include <unistd.h>
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/file.h>
 #include <stdio.h>
 #include <limits.h>
 #include <sys/types.h>
@@ -37,8 +43,11 @@
 #include <jsonrpccpp/server/connectors/httpserver.h>
 
 #include "third_party/spdlog/spdlog.h"
+#include "third_party/spdlog/async.h"
+#include "third_party/spdlog/sinks/stdout_color_sinks.h"
 #include <gmp.h>
 #include <sgx_urts.h>
+#include <sgx_uswitchless.h>
 #include <unistd.h>
 
 
@@ -58,13 +67,130 @@
 #include "BLSCrypto.h"
 #include "ServerInit.h"
 #include "SGXException.h"
+#include "ExitRequestedException.h"
 #include "zmq_src/ZMQServer.h"
+#include "DKGGarbageCollector.h"
+#include "SEKRotation.h"
+#include "KeyStoreReplicator.h"
+#include "ECDSANoncePool.h"
+#include "ECDSAKeyPool.h"
+#include "Metrics.h"
+#include "EcallGate.h"
+#include "MetricsServer.h"
+#include "TrafficRecorder.h"
+#include "Tracing.h"
+#include "KeyWarmUp.h"
+#include "KeyStats.h"
+#include "Readiness.h"
+#include "MemoryBudget.h"
+#include "MockEnclave.h"
 #include "SGXWalletServer.hpp"
 
 uint32_t enclaveLogLevel = 0;
 
+uint32_t switchlessUntrustedWorkers = 0;
+uint32_t switchlessTrustedWorkers = 0;
+uint64_t adminServerThreads = NUM_ADMIN_SERVER_THREADS;
+bool standbyMode = false;
+
+bool verifyEncryption = false;
+
+static int instanceLockFd = -1;
+
+static atomic<bool> enclaveLogExitRequested(false);
+static shared_ptr<thread> enclaveLogThread = nullptr;
+static shared_ptr<thread> enclavePrecomputeThread = nullptr;
+
 using namespace std;
 
+void initLogging() {
+    static once_flag once;
+
+    // formatting and writing move to the logger thread, request threads never block on a full queue
+    call_once(once, []() {
+        auto level = spdlog::default_logger()->level();
+        spdlog::init_thread_pool(LOG_ASYNC_QUEUE_SIZE, 1);
+        auto logger = spdlog::create_async_nb<spdlog::sinks::stdout_color_sink_mt>("sgxwallet");
+        logger->set_level(level);
+        logger->flush_on(spdlog::level::err);
+        spdlog::set_default_logger(logger);
+    });
+}
+
+static void flushEnclaveLog() {
+    static auto &heapBytes = Metrics::getGauge("enclaveGmpHeapBytes");
+    static auto &heapPeakBytes = Metrics::getGauge("enclaveGmpHeapPeakBytes");
+
+    // summed over the enclave instances
+    uint64_t totalHeap = 0;
+    uint64_t totalHeapPeak = 0;
+
+    for (uint64_t i = 0; i < numEnclaveShards; i++) {
+        uint64_t heap = 0;
+        uint64_t heapPeak = 0;
+
+        if (ECALL(trustedFlushLog, enclaveShards[i], &heap, &heapPeak) == SGX_SUCCESS) {
+            totalHeap += heap;
+            totalHeapPeak += heapPeak;
+        }
+    }
+
+    heapBytes.set(totalHeap);
+    heapPeakBytes.set(totalHeapPeak);
+}
+
+static void enclaveLogLoop() {
+    Metrics::getGauge("enclaveHeapMaxBytes").set(ENCLAVE_HEAP_MAX_SIZE * numEnclaveShards);
+
+    while (!enclaveLogExitRequested && !ExitHandler::shouldExit()) {
+        usleep(ENCLAVE_LOG_FLUSH_INTERVAL_MS * 1000);
+        READ_LOCK(sgxInitMutex);
+        flushEnclaveLog();
+    }
+}
+
+void initEnclaveLogFlusher() {
+    CHECK_STATE(!enclaveLogThread);
+    enclaveLogThread = make_shared<thread>(enclaveLogLoop);
+}
+
+void exitEnclaveLogFlusher() {
+    enclaveLogExitRequested = true;
+    if (enclaveLogThread) {
+        enclaveLogThread->join();
+        enclaveLogThread = nullptr;
+        flushEnclaveLog();
+    }
+    spdlog::default_logger()->flush();
+}
+
+void initEnclavePrecompute() {
+    CHECK_STATE(!enclavePrecomputeThread);
+
+    enclavePrecomputeThread = make_shared<thread>([]() {
+        auto start = chrono::steady_clock::now();
+
+        READ_LOCK(sgxInitMutex);
+
+        for (uint64_t i = 0; i < numEnclaveShards; i++) {
+            if (ECALL(trustedPrecomputeTables, enclaveShards[i]) != SGX_SUCCESS) {
+                spdlog::error("trustedPrecomputeTables failed, ECDSA keeps using generic point multiplication");
+                return;
+            }
+        }
+
+        spdlog::info("Enclave curve tables precomputed in {} ms",
+                     chrono::duration_cast<chrono::milliseconds>(chrono::steady_clock::now() - start).count());
+    });
+}
+
+void exitEnclavePrecompute() {
+    if (enclavePrecomputeThread) {
+        enclavePrecomputeThread->join();
+        enclavePrecomputeThread = nullptr;
+    }
+}
+
 void systemHealthCheck() {
     string ulimit;
     try {
@@ -103,9 +229,134 @@ void initUserSpace() {
 
 }
 
+void setAdminServerThreads(uint64_t _numThreads) {
+    if (_numThreads == 0 || _numThreads > MAX_HTTP_SERVER_THREADS) {
+        throw SGXException(INVALID_HTTP_SERVER_THREADS_NUMBER, "Number of admin server threads has to be between 1 and " +
+                                                               to_string(MAX_HTTP_SERVER_THREADS));
+    }
+
+    adminServerThreads = _numThreads;
+}
+
+uint64_t getAdminServerThreads() {
+    return adminServerThreads;
+}
+
+void setEnclaveShards(uint64_t _numShards) {
+    if (_numShards == 0 || _numShards > MAX_ENCLAVE_SHARDS) {
+        throw SGXException(INVALID_ENCLAVE_SHARDS_NUMBER, "Number of enclave instances has to be between 1 and " +
+                                                          to_string(MAX_ENCLAVE_SHARDS));
+    }
+
+    numEnclaveShards = _numShards;
+}
+
+uint64_t getEnclaveShards() {
+    return numEnclaveShards;
+}
+
+void setStandbyMode(bool _standby) {
+    standbyMode = _standby;
+}
+
+bool isStandbyMode() {
+    return standbyMode;
+}
+
+void setVerifyEncryption(bool _verify) {
+    verifyEncryption = _verify;
+}
+
+bool isVerifyEncryption() {
+    return verifyEncryption;
+}
+
+void acquireInstanceLock() {
+    CHECK_STATE(instanceLockFd < 0);
+
+    if (mkdir(SGXDATA_FOLDER, 0700) != 0 && errno != EEXIST) {
+        throw SGXException(ERROR_CREATING_SGX_DATA_FOLDER, "Could not create sgx_data folder.");
+    }
+
+    // the lock is released by the kernel when the holder exits or crashes, and it is kept
+    // open for the life of the process
+    instanceLockFd = open(INSTANCE_LOCK_FILE, O_RDWR | O_CREAT | O_CLOEXEC, 0600);
+    CHECK_STATE2(instanceLockFd >= 0, SGX_INSTANCE_ALREADY_RUNNING);
+
+    if (flock(instanceLockFd, LOCK_EX | LOCK_NB) == 0) {
+        return;
+    }
+
+    if (!standbyMode) {
+        throw SGXException(SGX_INSTANCE_ALREADY_RUNNING,
+                           "Another sgxwallet is using " INSTANCE_LOCK_FILE ", start this one with -S to run it as a standby");
+    }
+
+    spdlog::info("Standby mode: waiting for the serving sgxwallet to exit");
+
+    while (flock(instanceLockFd, LOCK_EX | LOCK_NB) != 0) {
+        if (ExitHandler::shouldExit()) {
+            throw ExitRequestedException();
+        }
+        usleep(STANDBY_POLL_INTERVAL_MS * 1000);
+    }
+
+    spdlog::info("Standby mode: the serving sgxwallet is gone, taking over");
+}
+
+void setSwitchlessConfig(uint32_t _untrustedWorkers, uint32_t _trustedWorkers) {
+    if (_untrustedWorkers > MAX_SWITCHLESS_WORKERS || _trustedWorkers > MAX_SWITCHLESS_WORKERS) {
+        throw SGXException(INVALID_SWITCHLESS_CONFIG, "Number of switchless workers should not exceed " +
+                                                      to_string(MAX_SWITCHLESS_WORKERS));
+    }
+
+    switchlessUntrustedWorkers = _untrustedWorkers;
+    switchlessTrustedWorkers = _trustedWorkers;
+}
+
+bool isSwitchlessEnabled() {
+    return switchlessTrustedWorkers > 0;
+}
+
+uint32_t getSwitchlessUntrustedWorkers() {
+    return switchlessUntrustedWorkers;
+}
+
+uint32_t getSwitchlessTrustedWorkers() {
+    return switchlessTrustedWorkers;
+}
+
+static sgx_status_t createEnclave(sgx_enclave_id_t *_eid) {
+#ifdef SGXWALLET_MOCK_ENCLAVE
+    // any nonzero id, MockEnclave ignores it
+    static sgx_enclave_id_t mockEid = 0;
+    *_eid = ++mockEid;
+    return SGX_SUCCESS;
+#else
+    if (!isSwitchlessEnabled()) {
+        return sgx_create_enclave_search(ENCLAVE_NAME, SGX_DEBUG_FLAG, &token, &updated, _eid, 0);
+    }
+
+    // trustedBlsSignMessage, trustedEcdsaSign and trustedGetPublicEcdsaKey are served
+    // by trusted worker threads; other ECALLs keep using regular transitions
+    sgx_uswitchless_config_t switchlessConfig = SGX_USWITCHLESS_CONFIG_INITIALIZER;
+    switchlessConfig.num_uworkers = switchlessUntrustedWorkers;
+    switchlessConfig.num_tworkers = switchlessTrustedWorkers;
+
+    const void *enclaveExFeatures[32] = {0};
+    enclaveExFeatures[SGX_CREATE_ENCLAVE_EX_SWITCHLESS_BIT_IDX] = &switchlessConfig;
+
+    spdlog::info("Creating enclave in switchless mode: {} untrusted, {} trusted workers",
+                 switchlessUntrustedWorkers, switchlessTrustedWorkers);
+
+    return sgx_create_enclave_search_ex(ENCLAVE_NAME, SGX_DEBUG_FLAG, &token, &updated, _eid, 0,
+                                        SGX_CREATE_ENCLAVE_EX_SWITCHLESS, enclaveExFeatures);
+#endif
+}
+
 uint64_t initEnclave() {
 
-#ifndef SGX_HW_SIM
+#if !defined(SGX_HW_SIM) && !defined(SGXWALLET_MOCK_ENCLAVE)
     unsigned long support;
     support = get_sgx_support();
     if (!SGX_OK(support)) {
@@ -122,31 +373,52 @@ uint64_t initEnclave() {
 
         WRITE_LOCK(sgxInitMutex);
 
-        if (eid != 0) {
-            if (sgx_destroy_enclave(eid) != SGX_SUCCESS) {
+        for (uint64_t i = 0; i < MAX_ENCLAVE_SHARDS; i++) {
+            if (enclaveShards[i] != 0 && !MockEnclave::isEnabled() &&
+                sgx_destroy_enclave(enclaveShards[i]) != SGX_SUCCESS) {
                 spdlog::error("Could not destroy enclave");
             }
+            enclaveShards[i] = 0;
         }
 
         eid = 0;
         updated = 0;
 
-        status = sgx_create_enclave_search(ENCLAVE_NAME, SGX_DEBUG_FLAG, &token,
-                                           &updated, &eid, 0);
+        // enclave creation time grows with the heap and stack sizes of the enclave profile
+        auto createStart = chrono::steady_clock::now();
+
+        // every instance has its own TCS pool, heap and key cache
+        for (uint64_t i = 0; i < numEnclaveShards && status == SGX_SUCCESS; i++) {
+            status = createEnclave(&enclaveShards[i]);
+
+            if (status != SGX_SUCCESS) {
+                if (status == SGX_ERROR_ENCLAVE_FILE_ACCESS) {
+                    spdlog::error("sgx_create_enclave: {}: file not found", ENCLAVE_NAME);
+                    spdlog::error("Did you forget to set LD_LIBRARY_PATH?");
+                } else {
+                    spdlog::error("sgx_create_enclave_search failed {} {}", ENCLAVE_NAME, status);
+                }
+                throw SGXException(COULD_NOT_INIT_ENCLAVE, "Error initing enclave. Please re-check your enviroment.");
+            }
 
-        if (status != SGX_SUCCESS) {
-            if (status == SGX_ERROR_ENCLAVE_FILE_ACCESS) {
-                spdlog::error("sgx_create_enclave: {}: file not found", ENCLAVE_NAME);
-                spdlog::error("Did you forget to set LD_LIBRARY_PATH?");
-            } else {
-                spdlog::error("sgx_create_enclave_search failed {} {}", ENCLAVE_NAME, status);
+            status = ECALL(trustedEnclaveInit, enclaveShards[i], enclaveLogLevel);
+
+            if (status == SGX_SUCCESS) {
+                status = ECALL(trustedSetVerifyEncryption, enclaveShards[i], verifyEncryption);
             }
-            throw SGXException(COULD_NOT_INIT_ENCLAVE, "Error initing enclave. Please re-check your enviroment.");
         }
 
-        spdlog::info("Enclave created and started successfully");
+        eid = enclaveShards[0];
+
+        // trusted switchless workers keep a TCS of every instance for themselves
+        uint64_t eids[MAX_ENCLAVE_SHARDS];
+        for (uint64_t i = 0; i < numEnclaveShards; i++) {
+            eids[i] = enclaveShards[i];
+        }
+        EcallGate::init(eids, numEnclaveShards, ENCLAVE_TCS_NUM - switchlessTrustedWorkers);
 
-        status = trustedEnclaveInit(eid, enclaveLogLevel);
+        spdlog::info("{} enclave instance(s) created and started successfully in {} ms", numEnclaveShards,
+                     chrono::duration_cast<chrono::milliseconds>(chrono::steady_clock::now() - createStart).count());
     }
 
     if (status != SGX_SUCCESS) {
@@ -159,6 +431,19 @@ uint64_t initEnclave() {
     return SGX_SUCCESS;
 }
 
+// the caches that shrink when the memory budget runs low, see MemoryBudget.h. Each still has its own
+// limit, LEVELDB_CACHE_MAX_BYTES and REQUEST_COALESCER_MAX_ENTRIES
+static void addMemoryConsumers() {
+    MemoryBudget::addConsumer("dbCache", []() { return LevelDB::getLevelDb()->getCache().sizeInBytes(); }, []() {
+        auto &cache = LevelDB::getLevelDb()->getCache();
+        cache.trim(cache.sizeInBytes() / 2);
+    });
+    MemoryBudget::addConsumer("signCache", []() {
+        return (SGXWalletServer::getBlsSignCacheSize() + SGXWalletServer::getEcdsaSignCacheSize()) *
+               REQUEST_COALESCER_ENTRY_BYTES;
+    }, []() { SGXWalletServer::dropKeptSignResults(); });
+}
+
 void initAll(uint32_t _logLevel, bool _checkCert,
              bool _checkZMQSig, bool _autoSign, bool _generateTestKeys, bool _checkKeyOwnership) {
 
@@ -178,40 +463,118 @@ void initAll(uint32_t _logLevel, bool _checkCert,
         CHECK_STATE(sgxServerInited != 1)
         sgxServerInited = 1;
 
-        uint64_t counter = 0;
+        initLogging();
+        Tracing::initTracing();
+        TrafficRecorder::initTrafficRecorder();
+
+        auto startupStart = chrono::steady_clock::now();
+        mutex breakdownMutex;
+        string breakdown;
+
+        auto timeStage = [&](const char *_name, const function<void()> &_stage) {
+            auto start = chrono::steady_clock::now();
+            _stage();
+            auto ms = chrono::duration_cast<chrono::milliseconds>(chrono::steady_clock::now() - start).count();
+            spdlog::info("Startup stage {} took {} ms", _name, ms);
+            lock_guard<mutex> lock(breakdownMutex);
+            breakdown += string(breakdown.empty() ? "" : ", ") + _name + " " + to_string(ms) + " ms";
+        };
+
+        chrono::steady_clock::time_point takeoverStart;
+
+        // the host libff init, database open and system health check do not need the enclave.
+        // A standby instance stays here until the serving instance exits
+        auto userSpace = async(launch::async, [&]() {
+            timeStage(standbyMode ? "waitForPrimary" : "acquireInstanceLock", acquireInstanceLock);
+            takeoverStart = chrono::steady_clock::now();
+            timeStage("initUserSpace", initUserSpace);
+        });
+
+        timeStage("initEnclave", []() {
+            uint64_t counter = 0;
+
+            uint64_t initResult = 0;
+            while ((initResult = initEnclave()) != 0 && counter < 10) {
+                sleep(1);
+                counter++;
+            }
+
+            if (initResult != 0) {
+                spdlog::error("Coult not init enclave");
+            }
+        });
 
-        uint64_t initResult = 0;
-        while ((initResult = initEnclave()) != 0 && counter < 10) {
-            sleep(1);
-            counter++;
+        // a standby instance has all the time it needs before it takes over
+        if (standbyMode) {
+            initEnclavePrecompute();
         }
 
-        if (initResult != 0) {
-            spdlog::error("Coult not init enclave");
+        userSpace.get();
+
+        initEnclaveLogFlusher();
+        timeStage("initSEK", initSEK);
+
+        // a cold first consensus round after a restart costs more than a later port opening
+        if (KeyWarmUp::isEnabled()) {
+            timeStage("warmUp", []() {
+                if (!standbyMode) {
+                    initEnclavePrecompute();
+                }
+                KeyWarmUp::warmUpKeys();
+                // joins the table precomputation
+                exitEnclavePrecompute();
+            });
         }
 
-        initUserSpace();
-        initSEK();
+        timeStage("initServers", [&]() {
+            SGXWalletServer::createCertsIfNeeded();
 
-        SGXWalletServer::createCertsIfNeeded();
+            if (useHTTPS) {
+                spdlog::info("Initing JSON-RPC server over HTTPS");
+                spdlog::info("Check client cert: {}", _checkCert);
+                SGXWalletServer::initHttpsServer(_checkCert);
+                spdlog::info("Inited JSON-RPC server over HTTPS");
+            } else {
+                spdlog::info("Initing JSON-RPC server over HTTP");
+                SGXWalletServer::initHttpServer();
+                spdlog::info("Inited JSON-RPC server over HTTP");
+            }
 
-        if (useHTTPS) {
-            spdlog::info("Initing JSON-RPC server over HTTPS");
-            spdlog::info("Check client cert: {}", _checkCert);
-            SGXWalletServer::initHttpsServer(_checkCert);
-            spdlog::info("Inited JSON-RPC server over HTTPS");
+            SGXRegistrationServer::initRegistrationServer(_autoSign, adminServerThreads);
+            CSRManagerServer::initCSRManagerServer(adminServerThreads);
+            SGXInfoServer::initInfoServer(_logLevel, _checkCert, _autoSign, _generateTestKeys, adminServerThreads);
+            ZMQServer::initZMQServer(_checkZMQSig, _checkKeyOwnership);
+            DKGGarbageCollector::initGC();
+            KeyStoreReplicator::initReplicator();
+            ECDSANoncePool::initPool();
+            ECDSAKeyPool::initPool();
+            SEKRotation::initRotation();
+            KeyWarmUp::initSaver();
+            KeyStats::initSaver();
+            addMemoryConsumers();
+            Metrics::initMetrics();
+            MetricsServer::initMetricsServer();
+        });
+
+        // requests are served meanwhile, the tables only speed up ECDSA
+        if (!standbyMode) {
+            if (!KeyWarmUp::isEnabled()) {
+                initEnclavePrecompute();
+            }
         } else {
-            spdlog::info("Initing JSON-RPC server over HTTP");
-            SGXWalletServer::initHttpServer();
-            spdlog::info("Inited JSON-RPC server over HTTP");
+            spdlog::info("Standby takeover completed in {} ms",
+                         chrono::duration_cast<chrono::milliseconds>(chrono::steady_clock::now() - takeoverStart).count());
         }
 
-        SGXRegistrationServer::initRegistrationServer(_autoSign);
-        CSRManagerServer::initCSRManagerServer();
-        SGXInfoServer::initInfoServer(_logLevel, _checkCert, _autoSign, _generateTestKeys);
-        ZMQServer::initZMQServer(_checkZMQSig, _checkKeyOwnership);
+        spdlog::info("Startup finished in {} ms: {}",
+                     chrono::duration_cast<chrono::milliseconds>(chrono::steady_clock::now() - startupStart).count(),
+                     breakdown);
+
+        Readiness::setState(Readiness::READY);
 
         sgxServerInited = true;
+    } catch (ExitRequestedException &) {
+        spdlog::info("Exit requested during startup");
     } catch (SGXException &_e) {
         spdlog::error(_e.getMessage());
         ExitHandler::exitHandler(SIGTERM, ExitHandler::ec_initing_user_space);
@@ -228,9 +591,23 @@ void initAll(uint32_t _logLevel, bool _checkCert,
 };
 
 void exitAll() {
+    Readiness::setState(Readiness::DRAINING);
+    exitEnclavePrecompute();
+    KeyWarmUp::exitSaver();
+    KeyStats::exitSaver();
     SGXWalletServer::exitServer();
     SGXRegistrationServer::exitServer();
     CSRManagerServer::exitServer();
     SGXInfoServer::exitServer();
     ZMQServer::exitZMQServer();
+    DKGGarbageCollector::exitGC();
+    KeyStoreReplicator::exitReplicator();
+    ECDSANoncePool::exitPool();
+    ECDSAKeyPool::exitPool();
+    SEKRotation::exitRotation();
+    MetricsServer::exitMetricsServer();
+    Metrics::exitMetrics();
+    exitEnclaveLogFlusher();
+    TrafficRecorder::exitTrafficRecorder();
+    Tracing::exitTracing();
 }
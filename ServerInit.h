@@ -36,12 +36,58 @@ EXTERNC void initAll(uint32_t  _logLevel, bool _checkCert, bool _checkZMQSig, bo
 
 void exitAll();
 
+// replaces the default spdlog logger with a non blocking async logger, called by initAll
+void initLogging();
+
+// periodically writes the log lines buffered in the enclave and samples the enclave heap gauges
+void initEnclaveLogFlusher();
+
+void exitEnclaveLogFlusher();
+
+// builds the enclave curve tables in the background once the servers are up
+void initEnclavePrecompute();
+
+void exitEnclavePrecompute();
+
 EXTERNC void initUserSpace();
 
 EXTERNC uint64_t initEnclave();
 
+// zero trusted workers means switchless ECALLs are disabled
+EXTERNC void setSwitchlessConfig(uint32_t _untrustedWorkers, uint32_t _trustedWorkers);
+
+EXTERNC bool isSwitchlessEnabled();
+
+EXTERNC uint32_t getSwitchlessUntrustedWorkers();
+
+EXTERNC uint32_t getSwitchlessTrustedWorkers();
+
 EXTERNC void exitZMQServer();
 
+// threads of each of the registration, CSR manager and info servers
+EXTERNC void setAdminServerThreads(uint64_t _numThreads);
+
+EXTERNC uint64_t getAdminServerThreads();
+
+// enclave instances to create, keys are spread over them by shardEid
+EXTERNC void setEnclaveShards(uint64_t _numShards);
+
+EXTERNC uint64_t getEnclaveShards();
+
+// a standby instance creates its enclave and waits for the serving instance to exit before it
+// opens the databases and the ports
+EXTERNC void setStandbyMode(bool _standby);
+
+EXTERNC bool isStandbyMode();
+
+// paranoid mode, every newly encrypted key is decrypted again in the enclave and compared
+EXTERNC void setVerifyEncryption(bool _verify);
+
+EXTERNC bool isVerifyEncryption();
+
+// takes the INSTANCE_LOCK_FILE lock, throws if another instance holds it unless in standby mode
+void acquireInstanceLock();
+
 
 
 #endif //SGXWALLET_SERVERINIT_H
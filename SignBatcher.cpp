@@ -0,0 +1,172 @@
+/*
+    Copyright (C) 2021-Present SKALE Labs
+
+    This file is part of sgxwallet.
+
+    sgxwallet is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as published
+    by the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    sgxwallet is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with sgxwallet. If not, see <https://www.gnu.org/licenses/>.
+
+    @file SignBatcher.cpp
+    @author Stan Kladko
+    @date 2021
+*/
+
+
+#include <chrono>
+
+#include "third_party/spdlog/spdlog.h"
+#include "common.h"
+#include "sgxwallet_common.h"
+
+#include "Metrics.h"
+#include "LatencySLO.h"
+#include "SignBatcher.h"
+
+atomic<uint64_t> SignBatcher::maxWindowUs(SIGN_BATCH_DEFAULT_MAX_WINDOW_US);
+
+SignBatcher::SignBatcher(const string &_name, uint64_t _maxBatchSize, const BatchSigner &_signer) :
+        name(_name), maxBatchSize(_maxBatchSize), signer(_signer),
+        batches(Metrics::getCounter(_name + "SignBatches")),
+        batchedRequests(Metrics::getCounter(_name + "BatchedSignRequests")),
+        inFlight(0), windowUs(0), leaders(0) {
+    CHECK_STATE(_maxBatchSize > 0);
+    CHECK_STATE(_signer);
+}
+
+void SignBatcher::setMaxWindowUs(uint64_t _maxWindowUs) {
+    maxWindowUs = _maxWindowUs;
+}
+
+uint64_t SignBatcher::currentMaxWindowUs() {
+    auto window = maxWindowUs.load();
+    return LatencySLO::isAtRisk() ? window / SLO_SIGN_BATCH_WINDOW_DIVISOR : window;
+}
+
+vector<string> SignBatcher::signAlone(const Request &_request) {
+    auto results = signer({_request});
+    CHECK_STATE(results.size() == 1);
+    return results[0];
+}
+
+void SignBatcher::adapt(uint64_t _windowUs, uint64_t _batchSize) {
+    if (_batchSize > 1) {
+        windowUs = min(max<uint64_t>(2 * _windowUs, SIGN_BATCH_MIN_WINDOW_US), currentMaxWindowUs());
+    } else {
+        windowUs = (_windowUs / 2 < SIGN_BATCH_MIN_WINDOW_US) ? 0 : _windowUs / 2;
+    }
+}
+
+vector<string> SignBatcher::lead(const string &_group, const shared_ptr<Batch> &_batch, unique_lock<mutex> &_lock) {
+    auto maxWindow = currentMaxWindowUs();
+    uint64_t window = min(windowUs.load(), maxWindow);
+
+    // a zero window is probed now and then under concurrency, so that it can grow again
+    if (window == 0 && inFlight > 1 && ++leaders % SIGN_BATCH_PROBE_INTERVAL == 0) {
+        window = min<uint64_t>(SIGN_BATCH_MIN_WINDOW_US, maxWindow);
+    }
+
+    if (window > 0 && inFlight > 1) {
+        open[_group] = _batch;
+
+        _batch->full.wait_for(_lock, chrono::microseconds(window), [&]() {
+            return _batch->requests.size() >= maxBatchSize;
+        });
+
+        // a follower that filled the batch has already closed it
+        auto it = open.find(_group);
+        if (it != open.end() && it->second == _batch) {
+            open.erase(it);
+        }
+    } else {
+        window = 0;
+    }
+
+    _lock.unlock();
+
+    auto size = _batch->requests.size();
+
+    if (window > 0) {
+        adapt(window, size);
+    }
+
+    if (size == 1) {
+        return signAlone(_batch->requests[0]);
+    }
+
+    vector<vector<string>> signatures;
+
+    try {
+        signatures = signer(_batch->requests);
+        CHECK_STATE(signatures.size() == size);
+    } catch (...) {
+        // signed one by one instead, so that a bad request fails alone
+        spdlog::warn("{} sign batch of {} requests failed, signing them one by one", name, size);
+        for (auto &&result : _batch->results) {
+            result.set_value({});
+        }
+        return signAlone(_batch->requests[0]);
+    }
+
+    batches.inc();
+    batchedRequests.inc(size);
+
+    for (uint64_t i = 1; i < size; i++) {
+        _batch->results[i - 1].set_value(move(signatures[i]));
+    }
+
+    return signatures[0];
+}
+
+vector<string> SignBatcher::sign(const string &_group, const Request &_request) {
+    if (maxWindowUs == 0 || maxBatchSize < 2) {
+        return signAlone(_request);
+    }
+
+    struct InFlight {
+        atomic<uint64_t> &count;
+        explicit InFlight(atomic<uint64_t> &_count) : count(_count) { count++; }
+        ~InFlight() { count--; }
+    } inFlightGuard(inFlight);
+
+    future<vector<string>> result;
+
+    {
+        unique_lock<mutex> lock(m);
+
+        auto it = open.find(_group);
+
+        if (it == open.end()) {
+            auto batch = make_shared<Batch>();
+            batch->requests.push_back(_request);
+            return lead(_group, batch, lock);
+        }
+
+        auto batch = it->second;
+        batch->requests.push_back(_request);
+        batch->results.emplace_back();
+        result = batch->results.back().get_future();
+
+        if (batch->requests.size() >= maxBatchSize) {
+            open.erase(it);
+            batch->full.notify_one();
+        }
+    }
+
+    auto signature = result.get();
+
+    if (signature.empty()) {
+        return signAlone(_request);
+    }
+
+    return signature;
+}
@@ -0,0 +1,108 @@
+/*
+    Copyright (C) 2021-Present SKALE Labs
+
+    This file is part of sgxwallet.
+
+    sgxwallet is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as published
+    by the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    sgxwallet is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with sgxwallet. If not, see <https://www.gnu.org/licenses/>.
+
+    @file SignBatcher.h
+    @author Stan Kladko
+    @date 2021
+*/
+
+
+#ifndef SGXWALLET_SIGNBATCHER_H
+#define SGXWALLET_SIGNBATCHER_H
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+using namespace std;
+
+class MetricsCounter;
+
+// Concurrent sign requests of the same group are signed by one batch ECALL. The first request
+// of a batch leads it: it waits up to the current window for more requests, signs them all and
+// hands every follower its result. The window adapts to load, it grows while batches collect
+// more than one request and shrinks back to zero while they do not. A request that arrives
+// while no other sign request is in flight never waits.
+class SignBatcher {
+
+public:
+
+    struct Request {
+        string encryptedKeyHex;
+        string hashHex;
+        size_t t = 0;
+        size_t n = 0;
+        int base = 0;
+    };
+
+    // signs the requests of a batch, returns one result per request in the same order
+    typedef function<vector<vector<string>>(const vector<Request> &)> BatchSigner;
+
+    SignBatcher(const string &_name, uint64_t _maxBatchSize, const BatchSigner &_signer);
+
+    vector<string> sign(const string &_group, const Request &_request);
+
+    uint64_t getWindowUs() const { return windowUs; }
+
+    // 0 turns batching off, every request is then signed on its own
+    static void setMaxWindowUs(uint64_t _maxWindowUs);
+
+    static uint64_t getMaxWindowUs() { return maxWindowUs; }
+
+private:
+
+    struct Batch {
+        vector<Request> requests;
+        // result of request i + 1, an empty result tells the follower to sign alone
+        vector<promise<vector<string>>> results;
+        condition_variable full;
+    };
+
+    const string name;
+    const uint64_t maxBatchSize;
+    const BatchSigner signer;
+
+    MetricsCounter &batches;
+    MetricsCounter &batchedRequests;
+
+    mutex m;
+    unordered_map<string, shared_ptr<Batch>> open;
+
+    atomic<uint64_t> inFlight;
+    atomic<uint64_t> windowUs;
+    atomic<uint64_t> leaders;
+
+    static atomic<uint64_t> maxWindowUs;
+
+    // shorter while the latency objective is at risk, see LatencySLO.h
+    static uint64_t currentMaxWindowUs();
+
+    vector<string> signAlone(const Request &_request);
+
+    vector<string> lead(const string &_group, const shared_ptr<Batch> &_batch, unique_lock<mutex> &_lock);
+
+    void adapt(uint64_t _windowUs, uint64_t _batchSize);
+};
+
+#endif //SGXWALLET_SIGNBATCHER_H
@@ -21,7 +21,12 @@
     @date 2021
 */
 
+#include <algorithm>
+#include <array>
 #include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <libff/algebra/curves/alt_bn128/alt_bn128_pp.hpp>
 #include "leveldb/db.h"
 #include <jsonrpccpp/server/connectors/httpserver.h>
 
@@ -32,6 +37,7 @@
 #include "SGXException.h"
 #include "third_party/spdlog/spdlog.h"
 #include "common.h"
+#include "Metrics.h"
 #include "SGXWalletServer.h"
 
 #include "TECrypto.h"
@@ -59,8 +65,8 @@ vector<string> calculateDecryptionShare(const string& encryptedKeyShare,
 
     sgx_status_t status = SGX_SUCCESS;
 
-    status = trustedGetDecryptionShare(eid, &errStatus, errMsg.data(), encryptedKey,
-                                    publicDecryptionValue.data(), sz, decryptionShare);
+    status = ECALL(trustedGetDecryptionShare, shardEid(encryptedKey, sz), &errStatus, errMsg.data(), encryptedKey,
+                                           publicDecryptionValue.data(), sz, decryptionShare);
 
     HANDLE_TRUSTED_FUNCTION_ERROR(status, errStatus, errMsg.data());
 
@@ -68,3 +74,182 @@ vector<string> calculateDecryptionShare(const string& encryptedKeyShare,
 
     return *splittedShare;
 }
+
+// parses "x0:x1:y0:y1" into BLS_G2_LIMBS limbs, libff reduces the coordinates mod q
+static void decryptionValueToLimbs(const string &_value, uint64_t *_limbs) {
+    size_t start = 0;
+
+    for (int j = 0; j < 4; j++) {
+        size_t end = (j < 3) ? _value.find(':', start) : _value.size();
+
+        if (end == string::npos || end == start || (j == 3 && _value.find(':', start) != string::npos)) {
+            BOOST_THROW_EXCEPTION(invalid_argument("Invalid public decryption value"));
+        }
+
+        auto coord = libff::alt_bn128_Fq(_value.substr(start, end - start).c_str()).as_bigint();
+        start = end + 1;
+
+        for (int i = 0; i < BLS_FQ_LIMBS; i++) {
+            _limbs[j * BLS_FQ_LIMBS + i] = coord.data[i];
+        }
+    }
+}
+
+static vector<string> limbsToDecryptionShare(const uint64_t *_limbs) {
+    vector<string> result;
+
+    mpz_t t;
+    mpz_init(t);
+
+    for (int j = 0; j < 4; j++) {
+        mpz_import(t, BLS_FQ_LIMBS, -1, sizeof(uint64_t), 0, 0, _limbs + j * BLS_FQ_LIMBS);
+
+        SAFE_CHAR_BUF(arr, mpz_sizeinbase(t, 10) + 2);
+        mpz_get_str(arr, 10, t);
+
+        result.push_back(arr);
+    }
+
+    mpz_clear(t);
+
+    return result;
+}
+
+typedef array<uint64_t, BLS_G2_LIMBS> DecryptionValueLimbs;
+
+// Rounds of an encrypted mempool ask many nodes for shares of the same values within seconds.
+// Values that parsed to a point on the curve are kept as limbs, and shares are kept per
+// encrypted key and value. Both caches are cleared when full, the enclave still checks every
+// value it is given.
+static mutex decryptionCachesMutex;
+static unordered_map<string, DecryptionValueLimbs> validDecryptionValues;
+static unordered_map<string, vector<string>> decryptionShares;
+
+static void checkDecryptionValueOnCurve(const uint64_t *_limbs) {
+    libff::alt_bn128_Fq coords[4];
+
+    for (int j = 0; j < 4; j++) {
+        libff::bigint<libff::alt_bn128_q_limbs> coord;
+        for (int i = 0; i < BLS_FQ_LIMBS; i++) {
+            coord.data[i] = _limbs[j * BLS_FQ_LIMBS + i];
+        }
+        coords[j] = libff::alt_bn128_Fq(coord);
+    }
+
+    libff::alt_bn128_G2 point(libff::alt_bn128_Fq2(coords[0], coords[1]), libff::alt_bn128_Fq2(coords[2], coords[3]),
+                              libff::alt_bn128_Fq2::one());
+
+    if (!point.is_well_formed()) {
+        BOOST_THROW_EXCEPTION(invalid_argument("Public decryption value is not on the curve"));
+    }
+}
+
+vector<vector<string>> calculateDecryptionShares(const string& encryptedKeyShare,
+                                                 const vector<string>& publicDecryptionValues) {
+    static auto &shareHits = Metrics::getCounter("decryptionShareCacheHits");
+    static auto &valueHits = Metrics::getCounter("decryptionValueCacheHits");
+
+    uint64_t count = publicDecryptionValues.size();
+
+    vector<vector<string>> ret(count);
+
+    // values without a cached share, and which of them still have to be parsed and checked
+    vector<uint64_t> misses;
+    vector<uint64_t> unchecked;
+
+    vector<uint64_t> values;
+
+    {
+        lock_guard<mutex> lock(decryptionCachesMutex);
+
+        for (uint64_t i = 0; i < count; i++) {
+            auto share = decryptionShares.find(encryptedKeyShare + ":" + publicDecryptionValues[i]);
+            if (share != decryptionShares.end()) {
+                ret[i] = share->second;
+                continue;
+            }
+
+            values.resize((misses.size() + 1) * BLS_G2_LIMBS, 0);
+
+            auto limbs = validDecryptionValues.find(publicDecryptionValues[i]);
+            if (limbs != validDecryptionValues.end()) {
+                copy(limbs->second.begin(), limbs->second.end(), values.end() - BLS_G2_LIMBS);
+                valueHits.inc();
+            } else {
+                unchecked.push_back(misses.size());
+            }
+
+            misses.push_back(i);
+        }
+    }
+
+    shareHits.inc(count - misses.size());
+
+    if (misses.empty()) {
+        return ret;
+    }
+
+    // string to field conversion is the expensive part of the host work
+    parallelFor(unchecked.size(), [&](size_t k) {
+        auto limbs = values.data() + unchecked[k] * BLS_G2_LIMBS;
+        decryptionValueToLimbs(publicDecryptionValues[misses[unchecked[k]]], limbs);
+        checkDecryptionValueOnCurve(limbs);
+    }, DECRYPTION_SHARES_MIN_VALUES_PER_THREAD);
+
+    size_t sz = 0;
+
+    SAFE_UINT8_BUF(encryptedKey, BUF_LEN);
+
+    bool result = hex2carray(encryptedKeyShare.data(), &sz, encryptedKey, BUF_LEN);
+
+    if (!result) {
+        BOOST_THROW_EXCEPTION(invalid_argument("Invalid hex encrypted key"));
+    }
+
+    uint64_t missCount = misses.size();
+
+    vector<uint64_t> shares(missCount * BLS_G2_LIMBS, 0);
+
+    {
+        READ_LOCK(sgxInitMutex);
+
+        for (uint64_t offset = 0; offset < missCount; offset += MAX_DECRYPTION_SHARES_BATCH_SIZE) {
+            uint64_t batchSize = std::min<uint64_t>(MAX_DECRYPTION_SHARES_BATCH_SIZE, missCount - offset);
+
+            vector<char> errMsg(BUF_LEN, 0);
+
+            int errStatus = 0;
+
+            sgx_status_t status = SGX_SUCCESS;
+
+            status = ECALL(trustedGetDecryptionShares, shardEid(encryptedKey, sz), &errStatus, errMsg.data(), encryptedKey,
+                                                       sz, values.data() + offset * BLS_G2_LIMBS, batchSize * BLS_G2_LIMBS,
+                                                       shares.data() + offset * BLS_G2_LIMBS);
+
+            HANDLE_TRUSTED_FUNCTION_ERROR(status, errStatus, errMsg.data());
+        }
+    }
+
+    parallelFor(missCount, [&](size_t k) {
+        ret[misses[k]] = limbsToDecryptionShare(shares.data() + k * BLS_G2_LIMBS);
+    }, DECRYPTION_SHARES_MIN_VALUES_PER_THREAD);
+
+    lock_guard<mutex> lock(decryptionCachesMutex);
+
+    if (validDecryptionValues.size() + unchecked.size() > DECRYPTION_VALUE_CACHE_MAX_ENTRIES) {
+        validDecryptionValues.clear();
+    }
+    for (auto &&k : unchecked) {
+        auto &limbs = validDecryptionValues[publicDecryptionValues[misses[k]]];
+        copy(values.begin() + k * BLS_G2_LIMBS, values.begin() + (k + 1) * BLS_G2_LIMBS, limbs.begin());
+    }
+
+    if (decryptionShares.size() + missCount > DECRYPTION_SHARE_CACHE_MAX_ENTRIES) {
+        decryptionShares.clear();
+    }
+    for (auto &&i : misses) {
+        decryptionShares[encryptedKeyShare + ":" + publicDecryptionValues[i]] = ret[i];
+    }
+
+    return ret;
+}
@@ -38,4 +38,9 @@
 std::vector<std::string> calculateDecryptionShare(const std::string& encryptedKeyShare,
                                                   const std::string& publicDecryptionValue);
 
+// decryption shares of all values, the key is decrypted once per MAX_DECRYPTION_SHARES_BATCH_SIZE values.
+// Each value and each share is four ':' separated decimal G2 coordinates
+std::vector<std::vector<std::string>> calculateDecryptionShares(const std::string& encryptedKeyShare,
+                                                                const std::vector<std::string>& publicDecryptionValues);
+
 #endif // SGXWALLET_TECRYPTO_H
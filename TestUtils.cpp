@@ -49,6 +49,8 @@
 #include "BLSPublicKey.h"
 #include "SEKManager.h"
 #include <thread>
+#include <fstream>
+#include <algorithm>
 #include "common.h"
 #include "stubclient.h"
 #include "SGXRegistrationServer.h"
@@ -922,6 +924,69 @@ void TestUtils::doZMQBLS(shared_ptr<ZMQClient> _zmqClient, StubClient &c, int n,
         cerr << i << endl;
 }
 
+Json::Value TestUtils::runPerfScenario(const string &_name, const function<void()> &_scenario, int _numThreads,
+                                       int _iterations) {
+    CHECK_STATE(_numThreads > 0 && _iterations > 0);
+
+    vector<vector<double>> latencies(_numThreads);
+    vector<thread> threads;
+
+    auto begin = chrono::steady_clock::now();
+
+    for (int i = 0; i < _numThreads; i++) {
+        threads.emplace_back([&, i]() {
+            for (int j = 0; j < _iterations; j++) {
+                auto start = chrono::steady_clock::now();
+                _scenario();
+                latencies[i].push_back(
+                        chrono::duration<double, milli>(chrono::steady_clock::now() - start).count());
+            }
+        });
+    }
+
+    for (auto &&t : threads) {
+        t.join();
+    }
+
+    auto durationMs = chrono::duration<double, milli>(chrono::steady_clock::now() - begin).count();
+
+    vector<double> all;
+    for (auto &&l : latencies) {
+        all.insert(all.end(), l.begin(), l.end());
+    }
+    sort(all.begin(), all.end());
+
+    auto percentile = [&](double _p) {
+        return all[min(all.size() - 1, (size_t) (_p * all.size()))];
+    };
+
+    Json::Value result;
+    result["name"] = _name;
+    result["version"] = SGXWalletServer::getVersion();
+    result["threads"] = _numThreads;
+    result["iterations"] = _iterations;
+    result["operations"] = (Json::UInt64) all.size();
+    result["durationMs"] = durationMs;
+    result["throughputPerSec"] = all.size() * 1000.0 / durationMs;
+    result["latencyMs"]["p50"] = percentile(0.5);
+    result["latencyMs"]["p90"] = percentile(0.9);
+    result["latencyMs"]["p99"] = percentile(0.99);
+    result["latencyMs"]["max"] = all.back();
+
+    auto dir = getenv("SGX_PERF_RESULTS_DIR");
+    string fileName = string(dir ? dir : ".") + "/" + _name + ".json";
+
+    ofstream out(fileName);
+    CHECK_STATE(out.good());
+    out << result.toStyledString();
+
+    cerr << _name << ": " << result["throughputPerSec"].asDouble() << " ops/s, p50 "
+         << result["latencyMs"]["p50"].asDouble() << " ms, p99 " << result["latencyMs"]["p99"].asDouble()
+         << " ms, written to " << fileName << endl;
+
+    return result;
+}
+
 int sessionKeyRecoverDH(const char *skey_str, const char *sshare, char *common_key) {
 
     int ret = -1;
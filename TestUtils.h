@@ -34,6 +34,7 @@
 #include <gmp.h>
 #include <sgx_urts.h>
 #include <stdio.h>
+#include <functional>
 #include <jsonrpccpp/client/connectors/httpclient.h>
 #include <sgx_tcrypto.h>
 #include "stubclient.h"
@@ -86,6 +87,11 @@ public:
 
     static void sendRPCRequestZMQ();
 
+    // runs _scenario _iterations times on each of _numThreads threads and writes throughput and latency
+    // percentiles to $SGX_PERF_RESULTS_DIR/<_name>.json, compare runs with scripts/compare_perf.py
+    static Json::Value runPerfScenario(const string &_name, const function<void()> &_scenario, int _numThreads,
+                                       int _iterations);
+
 };
 
 int sessionKeyRecoverDH(const char *skey_str, const char *sshare, char *common_key);
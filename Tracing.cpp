@@ -0,0 +1,163 @@
+/*
+    Copyright (C) 2021-Present SKALE Labs
+
+    This file is part of sgxwallet.
+
+    sgxwallet is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as published
+    by the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    sgxwallet is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with sgxwallet. If not, see <https://www.gnu.org/licenses/>.
+
+    @file Tracing.cpp
+    @author Stan Kladko
+    @date 2021
+*/
+
+#include <chrono>
+#include <cstdio>
+#include <random>
+
+#include "third_party/spdlog/spdlog.h"
+#include "third_party/spdlog/async.h"
+#include "third_party/spdlog/sinks/basic_file_sink.h"
+
+#include "sgxwallet_common.h"
+#include "SGXException.h"
+#include "common.h"
+
+#include "Tracing.h"
+
+bool Tracing::enabled = false;
+shared_ptr<spdlog::logger> Tracing::exporter = nullptr;
+thread_local TraceContext Tracing::current;
+
+TraceContext TraceContext::child() const {
+    TraceContext result = *this;
+    result.parentSpanId = spanId;
+    result.spanId = Tracing::newId();
+    return result;
+}
+
+string TraceContext::toTraceparent() const {
+    char buf[64];
+    snprintf(buf, sizeof(buf), "00-%016llx%016llx-%016llx-01", (unsigned long long) traceIdHigh,
+             (unsigned long long) traceIdLow, (unsigned long long) spanId);
+    return buf;
+}
+
+static bool parseHex(const char *_hex, int _digits, uint64_t &_value) {
+    uint64_t value = 0;
+
+    for (int i = 0; i < _digits; i++) {
+        char c = _hex[i];
+        int digit;
+        if (c >= '0' && c <= '9') {
+            digit = c - '0';
+        } else if (c >= 'a' && c <= 'f') {
+            digit = c - 'a' + 10;
+        } else {
+            return false;
+        }
+        value = (value << 4) | digit;
+    }
+
+    _value = value;
+    return true;
+}
+
+bool Tracing::parseTraceparent(const char *_value, size_t _len, TraceContext &_remote) {
+    // 00-<32 hex trace id>-<16 hex parent span id>-<2 hex flags>
+    if (_len < TRACEPARENT_LEN || _value[0] != '0' || _value[1] != '0' || _value[2] != '-' || _value[35] != '-' ||
+        _value[52] != '-') {
+        return false;
+    }
+
+    TraceContext result;
+    uint64_t flags = 0;
+
+    if (!parseHex(_value + 3, 16, result.traceIdHigh) || !parseHex(_value + 19, 16, result.traceIdLow) ||
+        !parseHex(_value + 36, 16, result.spanId) || !parseHex(_value + 53, 2, flags)) {
+        return false;
+    }
+
+    // only sampled traces are recorded
+    if (!result.isActive() || result.spanId == 0 || (flags & 1) == 0) {
+        return false;
+    }
+
+    _remote = result;
+    return true;
+}
+
+bool Tracing::scanRequest(const string &_msg, TraceContext &_context) {
+    static const string key = "\"traceparent\":\"";
+
+    auto pos = _msg.find(key);
+    if (pos == string::npos) {
+        return false;
+    }
+
+    pos += key.size();
+
+    TraceContext remote;
+    if (!parseTraceparent(_msg.data() + pos, _msg.size() - pos, remote)) {
+        return false;
+    }
+
+    _context = remote.child();
+    return true;
+}
+
+uint64_t Tracing::newId() {
+    static thread_local mt19937_64 generator(random_device{}());
+
+    uint64_t id;
+    do {
+        id = generator();
+    } while (id == 0);
+
+    return id;
+}
+
+uint64_t Tracing::nowNs() {
+    return chrono::duration_cast<chrono::nanoseconds>(chrono::system_clock::now().time_since_epoch()).count();
+}
+
+void Tracing::emitSpan(const TraceContext &_span, const char *_name, uint64_t _startNs, uint64_t _endNs) {
+    if (!exporter || !_span.isActive()) {
+        return;
+    }
+
+    exporter->info("{{\"traceId\":\"{:016x}{:016x}\",\"spanId\":\"{:016x}\",\"parentSpanId\":\"{:016x}\","
+                   "\"name\":\"{}\",\"startTimeUnixNano\":{},\"endTimeUnixNano\":{}}}",
+                   _span.traceIdHigh, _span.traceIdLow, _span.spanId, _span.parentSpanId, _name, _startNs, _endNs);
+}
+
+void Tracing::initTracing() {
+    if (!enabled) {
+        return;
+    }
+
+    CHECK_STATE(!exporter);
+
+    // spans go through their own async logger, so writing them never blocks a request thread
+    exporter = spdlog::create_async_nb<spdlog::sinks::basic_file_sink_mt>("traces", TRACE_FILE);
+    exporter->set_pattern("%v");
+    exporter->set_level(spdlog::level::info);
+
+    spdlog::info("Request tracing enabled, spans are written to {}", TRACE_FILE);
+}
+
+void Tracing::exitTracing() {
+    if (exporter) {
+        exporter->flush();
+    }
+}
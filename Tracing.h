@@ -0,0 +1,138 @@
+/*
+    Copyright (C) 2021-Present SKALE Labs
+
+    This file is part of sgxwallet.
+
+    sgxwallet is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as published
+    by the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    sgxwallet is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with sgxwallet. If not, see <https://www.gnu.org/licenses/>.
+
+    @file Tracing.h
+    @author Stan Kladko
+    @date 2021
+*/
+
+#ifndef SGXWALLET_TRACING_H
+#define SGXWALLET_TRACING_H
+
+#include <cstdint>
+#include <memory>
+#include <string>
+
+using namespace std;
+
+namespace spdlog {
+class logger;
+}
+
+// W3C trace context of one span. Inactive (all zero) unless the request carried a sampled traceparent
+struct TraceContext {
+    uint64_t traceIdHigh = 0;
+    uint64_t traceIdLow = 0;
+    uint64_t spanId = 0;
+    uint64_t parentSpanId = 0;
+
+    bool isActive() const { return traceIdHigh != 0 || traceIdLow != 0; }
+
+    // a new span of the same trace below this one
+    TraceContext child() const;
+
+    string toTraceparent() const;
+};
+
+// Optional request tracing, enabled with sgxwallet -X. Clients pass a W3C traceparent as the
+// "traceparent" member of a ZMQ or JSON-RPC request, and the stages of the request are written
+// as spans, one OTLP JSON object per line, to TRACE_FILE. Requests without a traceparent are not
+// traced, so the cost when tracing is on but unused is one string search per request.
+class Tracing {
+
+    static bool enabled;
+
+    static shared_ptr<spdlog::logger> exporter;
+
+    static thread_local TraceContext current;
+
+public:
+
+    static void setEnabled(bool _enabled) { enabled = _enabled; }
+
+    static bool isEnabled() { return enabled; }
+
+    static const TraceContext &getCurrent() { return current; }
+
+    static void setCurrent(const TraceContext &_context) { current = _context; }
+
+    // parses a traceparent header value, fails for malformed values and unsampled traces
+    static bool parseTraceparent(const char *_value, size_t _len, TraceContext &_remote);
+
+    // finds "traceparent" in a raw JSON request, _context is the server span below the remote one
+    static bool scanRequest(const string &_msg, TraceContext &_context);
+
+    static uint64_t newId();
+
+    static uint64_t nowNs();
+
+    static void emitSpan(const TraceContext &_span, const char *_name, uint64_t _startNs, uint64_t _endNs);
+
+    static void initTracing();
+
+    static void exitTracing();
+};
+
+// makes _context current on this thread for the lifetime of the scope
+class TraceScope {
+
+    TraceContext saved;
+
+public:
+
+    explicit TraceScope(const TraceContext &_context) : saved(Tracing::getCurrent()) {
+        Tracing::setCurrent(_context);
+    }
+
+    ~TraceScope() { Tracing::setCurrent(saved); }
+};
+
+// a span below the current one, which is the current span while the scope lives.
+// Does nothing if the thread is not serving a traced request
+class TraceSpan {
+
+    const char *name;
+
+    TraceContext context;
+
+    TraceContext saved;
+
+    uint64_t startNs = 0;
+
+public:
+
+    explicit TraceSpan(const char *_name) : name(_name) {
+        if (Tracing::getCurrent().isActive()) {
+            saved = Tracing::getCurrent();
+            context = saved.child();
+            Tracing::setCurrent(context);
+            startNs = Tracing::nowNs();
+        }
+    }
+
+    ~TraceSpan() {
+        if (context.isActive()) {
+            Tracing::emitSpan(context, name, startNs, Tracing::nowNs());
+            Tracing::setCurrent(saved);
+        }
+    }
+};
+
+#define TRACE_SPAN(__NAME__) TraceSpan __TRACE_SPAN__(__NAME__);
+
+#endif //SGXWALLET_TRACING_H
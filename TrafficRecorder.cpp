@@ -0,0 +1,297 @@
+/*
+    Copyright (C) 2021-Present SKALE Labs
+
+    This file is part of sgxwallet.
+
+    sgxwallet is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as published
+    by the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    sgxwallet is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with sgxwallet. If not, see <https://www.gnu.org/licenses/>.
+
+    @file TrafficRecorder.cpp
+    @author Stan Kladko
+    @date 2021
+*/
+
+
+#include <cstring>
+#include <map>
+#include <random>
+
+#include <json/reader.h>
+#include <openssl/sha.h>
+
+#include "third_party/spdlog/spdlog.h"
+
+#include "sgxwallet_common.h"
+#include "SGXException.h"
+#include "common.h"
+#include "Tracing.h"
+#include "TrafficRecorder.h"
+
+string TrafficRecorder::fileName = "";
+atomic<bool> TrafficRecorder::enabled(false);
+uint64_t TrafficRecorder::startNs = 0;
+mutex TrafficRecorder::queueMutex;
+condition_variable TrafficRecorder::queueCond;
+deque<TrafficRecorder::Pending> TrafficRecorder::queue;
+atomic<uint64_t> TrafficRecorder::recorded(0);
+atomic<uint64_t> TrafficRecorder::dropped(0);
+atomic<bool> TrafficRecorder::exitRequested(false);
+shared_ptr<thread> TrafficRecorder::writerThread = nullptr;
+
+void TrafficRecorder::record(TrafficTransport _transport, string &&_request, uint64_t _receivedNs,
+                             uint64_t _replyBytes) {
+    if (!isEnabled()) {
+        return;
+    }
+
+    lock_guard<mutex> lock(queueMutex);
+
+    if (queue.size() >= TRAFFIC_RECORDER_MAX_QUEUED) {
+        dropped++;
+        return;
+    }
+
+    queue.push_back({move(_request), _receivedNs, Tracing::nowNs(), _replyBytes, _transport});
+    queueCond.notify_one();
+}
+
+static const char *KEY_NAME_FIELDS[] = {"keyShareName", "keyName", "ethKeyName", "blsKeyName"};
+
+static const char *BATCH_FIELDS[] = {"requests", "messageHashes", "keyShares", "keys"};
+
+// ZMQ requests have their fields at the top level, JSON-RPC requests in params
+static vector<const Json::Value *> fieldScopes(const Json::Value &_entry) {
+    vector<const Json::Value *> scopes;
+    if (_entry.isObject()) {
+        scopes.push_back(&_entry);
+        if (_entry.isMember("params") && _entry["params"].isObject()) {
+            scopes.push_back(&_entry["params"]);
+        }
+    }
+    return scopes;
+}
+
+static string getMethod(const Json::Value &_entry) {
+    for (auto &&field : {"method", "type"}) {
+        if (_entry.isObject() && _entry.isMember(field) && _entry[field].isString()) {
+            return _entry[field].asString().substr(0, 255);
+        }
+    }
+    return "invalid";
+}
+
+static string getKeyName(const Json::Value &_entry) {
+    for (auto scope : fieldScopes(_entry)) {
+        for (auto &&field : KEY_NAME_FIELDS) {
+            if (scope->isMember(field) && (*scope)[field].isString()) {
+                return (*scope)[field].asString();
+            }
+        }
+        // the BLS batch of the ZMQ API has a key name per entry, the first one stands for all
+        if (scope->isMember("requests") && (*scope)["requests"].isArray() && !(*scope)["requests"].empty()) {
+            auto &first = (*scope)["requests"][0];
+            if (first.isObject() && first.isMember("keyShareName") && first["keyShareName"].isString()) {
+                return first["keyShareName"].asString();
+            }
+        }
+    }
+    return "";
+}
+
+static uint64_t getBatchSize(const Json::Value &_entry) {
+    for (auto scope : fieldScopes(_entry)) {
+        for (auto &&field : BATCH_FIELDS) {
+            if (scope->isMember(field) && (*scope)[field].isArray()) {
+                return (*scope)[field].size();
+            }
+        }
+    }
+    return 1;
+}
+
+static uint64_t hashKeyName(const string &_salt, const string &_keyName) {
+    if (_keyName.empty()) {
+        return 0;
+    }
+
+    auto salted = _salt + _keyName;
+    unsigned char digest[SHA256_DIGEST_LENGTH];
+    SHA256((const unsigned char *) salted.data(), salted.size(), digest);
+
+    uint64_t hash;
+    memcpy(&hash, digest, sizeof(hash));
+    return hash == 0 ? 1 : hash;
+}
+
+void TrafficRecorder::writerLoop(FILE *_file) {
+    // a new salt per recording, so that key hashes cannot be matched across logs
+    random_device device;
+    string salt;
+    for (int i = 0; i < 16; i++) {
+        salt.push_back((char) device());
+    }
+
+    map<string, uint8_t> methodIds;
+    uint64_t bytesWritten = strlen(TRAFFIC_LOG_MAGIC);
+
+    auto getMethodId = [&](const string &_name) -> uint8_t {
+        auto it = methodIds.find(_name);
+        if (it != methodIds.end()) {
+            return it->second;
+        }
+
+        // clients may send any method name over JSON-RPC, all beyond the first 255 are "other"
+        auto name = methodIds.size() < 255 ? _name : string("other");
+        it = methodIds.find(name);
+        if (it != methodIds.end()) {
+            return it->second;
+        }
+
+        uint8_t id = methodIds.size();
+        methodIds[name] = id;
+        uint8_t len = name.size();
+        fputc('M', _file);
+        fputc(id, _file);
+        fputc(len, _file);
+        fwrite(name.data(), 1, len, _file);
+        bytesWritten += 3 + len;
+        return id;
+    };
+
+    Json::Reader reader;
+    deque<Pending> batch;
+
+    while (true) {
+        {
+            unique_lock<mutex> lock(queueMutex);
+            queueCond.wait_for(lock, chrono::milliseconds(100), []() { return !queue.empty() || exitRequested; });
+            batch.swap(queue);
+        }
+
+        if (batch.empty()) {
+            if (exitRequested) {
+                break;
+            }
+            continue;
+        }
+
+        for (auto &&pending : batch) {
+            Json::Value request;
+            vector<const Json::Value *> entries;
+            Json::Value invalid;
+
+            // entries of a JSON-RPC batch array are recorded one by one
+            if (reader.parse(pending.request, request) && request.isArray() && !request.empty()) {
+                for (auto &&entry : request) {
+                    entries.push_back(&entry);
+                }
+            } else {
+                entries.push_back(request.isObject() ? &request : &invalid);
+            }
+
+            for (auto entry : entries) {
+                TrafficRecord record{};
+                record.arrivalUs = pending.receivedNs > startNs ? (pending.receivedNs - startNs) / 1000 : 0;
+                record.keyHash = hashKeyName(salt, getKeyName(*entry));
+                record.requestBytes = pending.request.size() / entries.size();
+                record.replyBytes = pending.replyBytes / entries.size();
+                record.serviceUs = pending.doneNs > pending.receivedNs ? (pending.doneNs - pending.receivedNs) / 1000
+                                                                       : 0;
+                record.batchSize = min<uint64_t>(getBatchSize(*entry), UINT16_MAX);
+                record.method = getMethodId(getMethod(*entry));
+                record.transport = pending.transport;
+
+                fputc('R', _file);
+                fwrite(&record, sizeof(record), 1, _file);
+                bytesWritten += 1 + sizeof(record);
+                recorded++;
+            }
+        }
+
+        batch.clear();
+        fflush(_file);
+
+        if (bytesWritten >= TRAFFIC_RECORDER_MAX_BYTES && enabled) {
+            spdlog::warn("Traffic log {} reached {} bytes, recording stopped", fileName, bytesWritten);
+            enabled = false;
+        }
+    }
+
+    fclose(_file);
+}
+
+void TrafficRecorder::readLog(const string &_fileName, vector<string> &_methods, vector<TrafficRecord> &_records) {
+    auto file = fopen(_fileName.c_str(), "rb");
+    CHECK_STATE2(file, FILE_NOT_FOUND);
+
+    unique_ptr<FILE, int (*)(FILE *)> closer(file, fclose);
+
+    char magic[8];
+    CHECK_STATE(fread(magic, 1, sizeof(magic), file) == sizeof(magic) &&
+                memcmp(magic, TRAFFIC_LOG_MAGIC, sizeof(magic)) == 0);
+
+    _methods.clear();
+    _records.clear();
+
+    int type;
+    while ((type = fgetc(file)) != EOF) {
+        if (type == 'M') {
+            int id = fgetc(file);
+            int len = fgetc(file);
+            CHECK_STATE(id != EOF && len != EOF);
+            string name(len, 0);
+            CHECK_STATE(fread(&name[0], 1, len, file) == (size_t) len);
+            if (_methods.size() <= (size_t) id) {
+                _methods.resize(id + 1);
+            }
+            _methods[id] = name;
+        } else {
+            CHECK_STATE(type == 'R');
+            TrafficRecord record;
+            CHECK_STATE(fread(&record, sizeof(record), 1, file) == 1);
+            CHECK_STATE(record.method < _methods.size());
+            _records.push_back(record);
+        }
+    }
+}
+
+void TrafficRecorder::initTrafficRecorder() {
+    if (fileName.empty()) {
+        return;
+    }
+
+    CHECK_STATE(!writerThread);
+
+    auto file = fopen(fileName.c_str(), "wb");
+    if (!file) {
+        throw SGXException(FILE_NOT_FOUND, "Could not create traffic log " + fileName);
+    }
+    fwrite(TRAFFIC_LOG_MAGIC, 1, strlen(TRAFFIC_LOG_MAGIC), file);
+
+    startNs = Tracing::nowNs();
+    exitRequested = false;
+    writerThread = make_shared<thread>(writerLoop, file);
+    enabled = true;
+
+    spdlog::info("Recording request metadata to {}", fileName);
+}
+
+void TrafficRecorder::exitTrafficRecorder() {
+    enabled = false;
+    exitRequested = true;
+    queueCond.notify_one();
+    if (writerThread) {
+        writerThread->join();
+        writerThread = nullptr;
+    }
+}
@@ -0,0 +1,130 @@
+/*
+    Copyright (C) 2021-Present SKALE Labs
+
+    This file is part of sgxwallet.
+
+    sgxwallet is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as published
+    by the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    sgxwallet is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with sgxwallet. If not, see <https://www.gnu.org/licenses/>.
+
+    @file TrafficRecorder.h
+    @author Stan Kladko
+    @date 2021
+*/
+
+
+#ifndef SGXWALLET_TRAFFICRECORDER_H
+#define SGXWALLET_TRAFFICRECORDER_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+enum TrafficTransport : uint8_t {
+    TRAFFIC_ZMQ = 0, TRAFFIC_HTTP = 1
+};
+
+// one request of a traffic log, little endian
+#pragma pack(push, 1)
+struct TrafficRecord {
+    // since the start of the recording
+    uint64_t arrivalUs;
+    // truncated SHA-256 of a per recording salt and the key name, 0 if there is no key name
+    uint64_t keyHash;
+    uint32_t requestBytes;
+    uint32_t replyBytes;
+    // from receive until the reply was ready
+    uint32_t serviceUs;
+    // entries of a batch request, 1 otherwise
+    uint16_t batchSize;
+    // index into the method names of the log
+    uint8_t method;
+    uint8_t transport;
+};
+#pragma pack(pop)
+
+static_assert(sizeof(TrafficRecord) == 32, "TrafficRecord is 32 bytes");
+
+// Records the metadata of ZMQ and JSON-RPC requests to a binary log for sgx_replay, enabled with
+// sgxwallet -o. The request path only copies the raw request into a queue. A writer thread parses
+// it, keeps the method, hashed key name, batch size and sizes, and drops everything else, so no
+// hashes, key shares or other parameters reach the log. Requests are dropped while
+// TRAFFIC_RECORDER_MAX_QUEUED are waiting, and recording stops at TRAFFIC_RECORDER_MAX_BYTES.
+//
+// The log starts with TRAFFIC_LOG_MAGIC, followed by entries of a type byte and a body. 'M' is
+// a method name, one byte of id, one byte of length and the name, and comes before the first
+// record of the method. 'R' is a TrafficRecord.
+class TrafficRecorder {
+
+    struct Pending {
+        string request;
+        uint64_t receivedNs;
+        uint64_t doneNs;
+        uint64_t replyBytes;
+        uint8_t transport;
+    };
+
+    static string fileName;
+
+    static atomic<bool> enabled;
+
+    static uint64_t startNs;
+
+    static mutex queueMutex;
+
+    static condition_variable queueCond;
+
+    static deque<Pending> queue;
+
+    static atomic<uint64_t> recorded;
+
+    static atomic<uint64_t> dropped;
+
+    static atomic<bool> exitRequested;
+
+    static shared_ptr<thread> writerThread;
+
+    static void writerLoop(FILE *_file);
+
+public:
+
+    static constexpr const char *TRAFFIC_LOG_MAGIC = "SGXTRAF1";
+
+    static void setFileName(const string &_fileName) { fileName = _fileName; }
+
+    static bool isEnabled() { return enabled.load(memory_order_relaxed); }
+
+    // _receivedNs is a Tracing::nowNs time
+    static void record(TrafficTransport _transport, string &&_request, uint64_t _receivedNs, uint64_t _replyBytes);
+
+    static uint64_t getRecorded() { return recorded; }
+
+    static uint64_t getDropped() { return dropped; }
+
+    // reads a log written by the recorder, throws if it is not a traffic log
+    static void readLog(const string &_fileName, vector<string> &_methods, vector<TrafficRecord> &_records);
+
+    static void initTrafficRecorder();
+
+    static void exitTrafficRecorder();
+};
+
+#endif //SGXWALLET_TRAFFICRECORDER_H
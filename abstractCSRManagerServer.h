@@ -33,6 +33,7 @@ public:
     {
         this->bindAndAddMethod(jsonrpc::Procedure("getUnsignedCSRs", jsonrpc::PARAMS_BY_NAME, jsonrpc::JSON_OBJECT, NULL), &abstractCSRManagerServer::getUnsignedCSRsI);
         this->bindAndAddMethod(jsonrpc::Procedure("signByHash", jsonrpc::PARAMS_BY_NAME, jsonrpc::JSON_OBJECT,"hash",jsonrpc::JSON_STRING, "status", jsonrpc::JSON_INTEGER, NULL), &abstractCSRManagerServer::signByHashI);
+        this->bindAndAddMethod(jsonrpc::Procedure("signByHashBatch", jsonrpc::PARAMS_BY_NAME, jsonrpc::JSON_OBJECT,"hashes",jsonrpc::JSON_ARRAY, "status", jsonrpc::JSON_INTEGER, NULL), &abstractCSRManagerServer::signByHashBatchI);
     }
 
     inline virtual void getUnsignedCSRsI(const Json::Value &request, Json::Value &response)
@@ -44,9 +45,14 @@ public:
     {
         response = this->signByHash( request["hash"].asString(), request["status"].asInt());
     }
+    inline virtual void signByHashBatchI(const Json::Value &request, Json::Value &response)
+    {
+        response = this->signByHashBatch(request["hashes"], request["status"].asInt());
+    }
 
     virtual Json::Value getUnsignedCSRs() = 0;
     virtual Json::Value signByHash(const std::string& hash, int status) = 0;
+    virtual Json::Value signByHashBatch(const Json::Value& hashes, int status) = 0;
 
 };
 
@@ -36,6 +36,20 @@ public:
     this->bindAndAddMethod(jsonrpc::Procedure("getLatestCreatedKey", jsonrpc::PARAMS_BY_NAME, jsonrpc::JSON_OBJECT, NULL), &AbstractInfoServer::getLatestCreatedKeyI);
     this->bindAndAddMethod(jsonrpc::Procedure("getServerConfiguration", jsonrpc::PARAMS_BY_NAME, jsonrpc::JSON_OBJECT, NULL), &AbstractInfoServer::getServerConfigurationI);
     this->bindAndAddMethod(jsonrpc::Procedure("isKeyExist", jsonrpc::PARAMS_BY_NAME, jsonrpc::JSON_OBJECT,"keyName",jsonrpc::JSON_STRING, NULL), &AbstractInfoServer::isKeyExistI);
+    this->bindAndAddMethod(jsonrpc::Procedure("areKeysExist", jsonrpc::PARAMS_BY_NAME, jsonrpc::JSON_OBJECT,"keyNames",jsonrpc::JSON_ARRAY, NULL), &AbstractInfoServer::areKeysExistI);
+    this->bindAndAddMethod(jsonrpc::Procedure("getKeysMetadata", jsonrpc::PARAMS_BY_NAME, jsonrpc::JSON_OBJECT,"keyNames",jsonrpc::JSON_ARRAY, NULL), &AbstractInfoServer::getKeysMetadataI);
+    this->bindAndAddMethod(jsonrpc::Procedure("getKeyStatistics", jsonrpc::PARAMS_BY_NAME, jsonrpc::JSON_OBJECT,"keyNames",jsonrpc::JSON_ARRAY, NULL), &AbstractInfoServer::getKeyStatisticsI);
+    this->bindAndAddMethod(jsonrpc::Procedure("getDKGTimeline", jsonrpc::PARAMS_BY_NAME, jsonrpc::JSON_OBJECT,"polyNames",jsonrpc::JSON_ARRAY, NULL), &AbstractInfoServer::getDKGTimelineI);
+    this->bindAndAddMethod(jsonrpc::Procedure("getReadiness", jsonrpc::PARAMS_BY_NAME, jsonrpc::JSON_OBJECT, NULL), &AbstractInfoServer::getReadinessI);
+    this->bindAndAddMethod(jsonrpc::Procedure("getCacheStatistics", jsonrpc::PARAMS_BY_NAME, jsonrpc::JSON_OBJECT, NULL), &AbstractInfoServer::getCacheStatisticsI);
+    this->bindAndAddMethod(jsonrpc::Procedure("getKeysPage", jsonrpc::PARAMS_BY_NAME, jsonrpc::JSON_OBJECT,"prefix",jsonrpc::JSON_STRING,"cursor",jsonrpc::JSON_STRING,"limit",jsonrpc::JSON_INTEGER, NULL), &AbstractInfoServer::getKeysPageI);
+    this->bindAndAddMethod(jsonrpc::Procedure("getReplicationPage", jsonrpc::PARAMS_BY_NAME, jsonrpc::JSON_OBJECT,"cursor",jsonrpc::JSON_STRING,"limit",jsonrpc::JSON_INTEGER, NULL), &AbstractInfoServer::getReplicationPageI);
+    this->bindAndAddMethod(jsonrpc::Procedure("setEcallTiming", jsonrpc::PARAMS_BY_NAME, jsonrpc::JSON_OBJECT,"enabled",jsonrpc::JSON_BOOLEAN, NULL), &AbstractInfoServer::setEcallTimingI);
+    this->bindAndAddMethod(jsonrpc::Procedure("setSchainPartitions", jsonrpc::PARAMS_BY_NAME, jsonrpc::JSON_OBJECT,"partitions",jsonrpc::JSON_OBJECT, NULL), &AbstractInfoServer::setSchainPartitionsI);
+    this->bindAndAddMethod(jsonrpc::Procedure("getSchainPartitions", jsonrpc::PARAMS_BY_NAME, jsonrpc::JSON_OBJECT, NULL), &AbstractInfoServer::getSchainPartitionsI);
+    this->bindAndAddMethod(jsonrpc::Procedure("startSEKRotation", jsonrpc::PARAMS_BY_NAME, jsonrpc::JSON_OBJECT, NULL), &AbstractInfoServer::startSEKRotationI);
+    this->bindAndAddMethod(jsonrpc::Procedure("getSEKRotationStatus", jsonrpc::PARAMS_BY_NAME, jsonrpc::JSON_OBJECT, NULL), &AbstractInfoServer::getSEKRotationStatusI);
+    this->bindAndAddMethod(jsonrpc::Procedure("getCpuProfile", jsonrpc::PARAMS_BY_NAME, jsonrpc::JSON_OBJECT,"seconds",jsonrpc::JSON_INTEGER, NULL), &AbstractInfoServer::getCpuProfileI);
   }
 
   inline virtual void getAllKeysInfoI(const Json::Value &request, Json::Value &response)
@@ -58,11 +72,99 @@ public:
     response = this->isKeyExist(request["keyName"].asString());
   }
 
+  inline virtual void areKeysExistI(const Json::Value &request, Json::Value &response)
+  {
+    response = this->areKeysExist(request["keyNames"]);
+  }
+
+  inline virtual void getKeysMetadataI(const Json::Value &request, Json::Value &response)
+  {
+    response = this->getKeysMetadata(request["keyNames"]);
+  }
+
+  inline virtual void getKeyStatisticsI(const Json::Value &request, Json::Value &response)
+  {
+    response = this->getKeyStatistics(request["keyNames"]);
+  }
+
+  inline virtual void getDKGTimelineI(const Json::Value &request, Json::Value &response)
+  {
+    response = this->getDKGTimeline(request["polyNames"]);
+  }
+
+  inline virtual void getReadinessI(const Json::Value &request, Json::Value &response)
+  {
+      (void)request;
+      response = this->getReadiness();
+  }
+
+  inline virtual void getCacheStatisticsI(const Json::Value &request, Json::Value &response)
+  {
+      response = this->getCacheStatistics();
+  }
+
+  inline virtual void getKeysPageI(const Json::Value &request, Json::Value &response)
+  {
+      response = this->getKeysPage(request["prefix"].asString(), request["cursor"].asString(), request["limit"].asInt());
+  }
+
+  inline virtual void getReplicationPageI(const Json::Value &request, Json::Value &response)
+  {
+      response = this->getReplicationPage(request["cursor"].asString(), request["limit"].asInt());
+  }
+
+  inline virtual void setEcallTimingI(const Json::Value &request, Json::Value &response)
+  {
+      response = this->setEcallTiming(request["enabled"].asBool());
+  }
+
+  inline virtual void setSchainPartitionsI(const Json::Value &request, Json::Value &response)
+  {
+      response = this->setSchainPartitions(request["partitions"]);
+  }
+
+  inline virtual void getSchainPartitionsI(const Json::Value &request, Json::Value &response)
+  {
+      (void)request;
+      response = this->getSchainPartitions();
+  }
+
+  inline virtual void startSEKRotationI(const Json::Value &request, Json::Value &response)
+  {
+      (void)request;
+      response = this->startSEKRotation();
+  }
+
+  inline virtual void getSEKRotationStatusI(const Json::Value &request, Json::Value &response)
+  {
+      (void)request;
+      response = this->getSEKRotationStatus();
+  }
+
+  inline virtual void getCpuProfileI(const Json::Value &request, Json::Value &response)
+  {
+      response = this->getCpuProfile(request["seconds"].asInt());
+  }
+
 
   virtual Json::Value getAllKeysInfo() = 0;
   virtual Json::Value getLatestCreatedKey() = 0;
   virtual Json::Value getServerConfiguration() = 0;
   virtual Json::Value isKeyExist(const std::string& key) = 0;
+  virtual Json::Value areKeysExist(const Json::Value& keyNames) = 0;
+  virtual Json::Value getKeysMetadata(const Json::Value& keyNames) = 0;
+  virtual Json::Value getKeyStatistics(const Json::Value& keyNames) = 0;
+  virtual Json::Value getDKGTimeline(const Json::Value& polyNames) = 0;
+  virtual Json::Value getReadiness() = 0;
+  virtual Json::Value getCacheStatistics() = 0;
+  virtual Json::Value getKeysPage(const std::string& prefix, const std::string& cursor, int limit) = 0;
+  virtual Json::Value getReplicationPage(const std::string& cursor, int limit) = 0;
+  virtual Json::Value setEcallTiming(bool enabled) = 0;
+  virtual Json::Value setSchainPartitions(const Json::Value& partitions) = 0;
+  virtual Json::Value getSchainPartitions() = 0;
+  virtual Json::Value startSEKRotation() = 0;
+  virtual Json::Value getSEKRotationStatus() = 0;
+  virtual Json::Value getCpuProfile(int seconds) = 0;
 
 };
 
@@ -40,12 +40,17 @@ class AbstractStubServer : public jsonrpc::AbstractServer<AbstractStubServer>
           this->bindAndAddMethod(jsonrpc::Procedure("blsSignMessageHash", jsonrpc::PARAMS_BY_NAME, jsonrpc::JSON_OBJECT, "keyShareName",jsonrpc::JSON_STRING,"messageHash",jsonrpc::JSON_STRING,"t",jsonrpc::JSON_INTEGER, "n",jsonrpc::JSON_INTEGER, NULL), &AbstractStubServer::blsSignMessageHashI);
 
           this->bindAndAddMethod(jsonrpc::Procedure("importECDSAKey", jsonrpc::PARAMS_BY_NAME, jsonrpc::JSON_OBJECT,"key",jsonrpc::JSON_STRING,"keyName",jsonrpc::JSON_STRING, NULL), &AbstractStubServer::importECDSAKeyI);
+          this->bindAndAddMethod(jsonrpc::Procedure("importBLSKeyShareBatch", jsonrpc::PARAMS_BY_NAME, jsonrpc::JSON_OBJECT, "keyShares",jsonrpc::JSON_ARRAY, NULL), &AbstractStubServer::importBLSKeyShareBatchI);
+          this->bindAndAddMethod(jsonrpc::Procedure("importECDSAKeyBatch", jsonrpc::PARAMS_BY_NAME, jsonrpc::JSON_OBJECT, "keys",jsonrpc::JSON_ARRAY, NULL), &AbstractStubServer::importECDSAKeyBatchI);
           this->bindAndAddMethod(jsonrpc::Procedure("generateECDSAKey", jsonrpc::PARAMS_BY_NAME, jsonrpc::JSON_OBJECT,  NULL), &AbstractStubServer::generateECDSAKeyI);
           this->bindAndAddMethod(jsonrpc::Procedure("getPublicECDSAKey", jsonrpc::PARAMS_BY_NAME, jsonrpc::JSON_OBJECT, "keyName",jsonrpc::JSON_STRING, NULL), &AbstractStubServer::getPublicECDSAKeyI);
           this->bindAndAddMethod(jsonrpc::Procedure("ecdsaSignMessageHash", jsonrpc::PARAMS_BY_NAME, jsonrpc::JSON_OBJECT, "base",jsonrpc::JSON_INTEGER,"keyName",jsonrpc::JSON_STRING,"messageHash",jsonrpc::JSON_STRING, NULL), &AbstractStubServer::ecdsaSignMessageHashI);
+          this->bindAndAddMethod(jsonrpc::Procedure("ecdsaSignMessageHashBatch", jsonrpc::PARAMS_BY_NAME, jsonrpc::JSON_OBJECT, "base",jsonrpc::JSON_INTEGER,"keyName",jsonrpc::JSON_STRING,"messageHashes",jsonrpc::JSON_ARRAY, NULL), &AbstractStubServer::ecdsaSignMessageHashBatchI);
 
           this->bindAndAddMethod(jsonrpc::Procedure("generateDKGPoly", jsonrpc::PARAMS_BY_NAME, jsonrpc::JSON_OBJECT, "polyName",jsonrpc::JSON_STRING,"t",jsonrpc::JSON_INTEGER, NULL), &AbstractStubServer::generateDKGPolyI);
+          this->bindAndAddMethod(jsonrpc::Procedure("generateDKGPolyBatch", jsonrpc::PARAMS_BY_NAME, jsonrpc::JSON_OBJECT, "polyNames",jsonrpc::JSON_ARRAY,"t",jsonrpc::JSON_INTEGER, NULL), &AbstractStubServer::generateDKGPolyBatchI);
           this->bindAndAddMethod(jsonrpc::Procedure("getVerificationVector", jsonrpc::PARAMS_BY_NAME, jsonrpc::JSON_OBJECT, "polyName", jsonrpc::JSON_STRING, "t", jsonrpc::JSON_INTEGER, NULL), &AbstractStubServer::getVerificationVectorI);
+          this->bindAndAddMethod(jsonrpc::Procedure("getVerificationVectorCompressed", jsonrpc::PARAMS_BY_NAME, jsonrpc::JSON_OBJECT, "polyName", jsonrpc::JSON_STRING, "t", jsonrpc::JSON_INTEGER, NULL), &AbstractStubServer::getVerificationVectorCompressedI);
           this->bindAndAddMethod(jsonrpc::Procedure("getSecretShare", jsonrpc::PARAMS_BY_NAME, jsonrpc::JSON_OBJECT, "polyName",jsonrpc::JSON_STRING,"publicKeys",jsonrpc::JSON_ARRAY, "n",jsonrpc::JSON_INTEGER,"t",jsonrpc::JSON_INTEGER, NULL), &AbstractStubServer::getSecretShareI);
           this->bindAndAddMethod(jsonrpc::Procedure("dkgVerification", jsonrpc::PARAMS_BY_NAME, jsonrpc::JSON_OBJECT, "publicShares",jsonrpc::JSON_STRING, "ethKeyName",jsonrpc::JSON_STRING, "secretShare",jsonrpc::JSON_STRING,"t",jsonrpc::JSON_INTEGER, "n",jsonrpc::JSON_INTEGER, "index",jsonrpc::JSON_INTEGER, NULL), &AbstractStubServer::dkgVerificationI);
           this->bindAndAddMethod(jsonrpc::Procedure("createBLSPrivateKey", jsonrpc::PARAMS_BY_NAME, jsonrpc::JSON_OBJECT, "blsKeyName",jsonrpc::JSON_STRING, "ethKeyName",jsonrpc::JSON_STRING, "polyName", jsonrpc::JSON_STRING, "secretShare",jsonrpc::JSON_STRING,"t", jsonrpc::JSON_INTEGER,"n",jsonrpc::JSON_INTEGER, NULL), &AbstractStubServer::createBLSPrivateKeyI);
@@ -53,20 +58,33 @@ class AbstractStubServer : public jsonrpc::AbstractServer<AbstractStubServer>
           this->bindAndAddMethod(jsonrpc::Procedure("calculateAllBLSPublicKeys", jsonrpc::PARAMS_BY_NAME, jsonrpc::JSON_OBJECT, "publicShares", jsonrpc::JSON_ARRAY, "n", jsonrpc::JSON_INTEGER, "t", jsonrpc::JSON_INTEGER, NULL), &AbstractStubServer::calculateAllBLSPublicKeysI);
           this->bindAndAddMethod(jsonrpc::Procedure("complaintResponse", jsonrpc::PARAMS_BY_NAME, jsonrpc::JSON_OBJECT, "polyName",jsonrpc::JSON_STRING,"t",jsonrpc::JSON_INTEGER, "n",jsonrpc::JSON_INTEGER, "ind",jsonrpc::JSON_INTEGER, NULL), &AbstractStubServer::complaintResponseI);
           this->bindAndAddMethod(jsonrpc::Procedure("multG2", jsonrpc::PARAMS_BY_NAME, jsonrpc::JSON_OBJECT, "x",jsonrpc::JSON_STRING, NULL), &AbstractStubServer::multG2I);
+          this->bindAndAddMethod(jsonrpc::Procedure("multG2Batch", jsonrpc::PARAMS_BY_NAME, jsonrpc::JSON_OBJECT, "xs",jsonrpc::JSON_ARRAY, NULL), &AbstractStubServer::multG2BatchI);
+          this->bindAndAddMethod(jsonrpc::Procedure("aggregateBLSSignatures", jsonrpc::PARAMS_BY_NAME, jsonrpc::JSON_OBJECT, "shares",jsonrpc::JSON_ARRAY, "signerIndices",jsonrpc::JSON_ARRAY, "t",jsonrpc::JSON_INTEGER, "n",jsonrpc::JSON_INTEGER, NULL), &AbstractStubServer::aggregateBLSSignaturesI);
+          this->bindAndAddMethod(jsonrpc::Procedure("verifyBLSSignatures", jsonrpc::PARAMS_BY_NAME, jsonrpc::JSON_OBJECT, "requests",jsonrpc::JSON_ARRAY, NULL), &AbstractStubServer::verifyBLSSignaturesI);
           this->bindAndAddMethod(jsonrpc::Procedure("isPolyExists", jsonrpc::PARAMS_BY_NAME, jsonrpc::JSON_OBJECT, "polyName",jsonrpc::JSON_STRING, NULL), &AbstractStubServer::isPolyExistsI);
 
           this->bindAndAddMethod(jsonrpc::Procedure("getServerStatus", jsonrpc::PARAMS_BY_NAME, jsonrpc::JSON_OBJECT,  NULL), &AbstractStubServer::getServerStatusI);
+          this->bindAndAddMethod(jsonrpc::Procedure("getServerStatusExtended", jsonrpc::PARAMS_BY_NAME, jsonrpc::JSON_OBJECT,  NULL), &AbstractStubServer::getServerStatusExtendedI);
           this->bindAndAddMethod(jsonrpc::Procedure("getServerVersion", jsonrpc::PARAMS_BY_NAME, jsonrpc::JSON_OBJECT,  NULL), &AbstractStubServer::getServerVersionI);
           this->bindAndAddMethod(jsonrpc::Procedure("deleteBlsKey", jsonrpc::PARAMS_BY_NAME, jsonrpc::JSON_OBJECT, "blsKeyName", jsonrpc::JSON_STRING, NULL), &AbstractStubServer::deleteBlsKeyI);
+          this->bindAndAddMethod(jsonrpc::Procedure("deleteSchainKeys", jsonrpc::PARAMS_BY_NAME, jsonrpc::JSON_OBJECT, "schainId", jsonrpc::JSON_STRING, NULL), &AbstractStubServer::deleteSchainKeysI);
+          this->bindAndAddMethod(jsonrpc::Procedure("openKey", jsonrpc::PARAMS_BY_NAME, jsonrpc::JSON_OBJECT, "keyName", jsonrpc::JSON_STRING, NULL), &AbstractStubServer::openKeyI);
+          this->bindAndAddMethod(jsonrpc::Procedure("closeKey", jsonrpc::PARAMS_BY_NAME, jsonrpc::JSON_OBJECT, "keyHandle", jsonrpc::JSON_STRING, NULL), &AbstractStubServer::closeKeyI);
+          this->bindAndAddMethod(jsonrpc::Procedure("blsSignMessageHashByHandle", jsonrpc::PARAMS_BY_NAME, jsonrpc::JSON_OBJECT, "keyHandle",jsonrpc::JSON_STRING,"messageHash",jsonrpc::JSON_STRING,"t",jsonrpc::JSON_INTEGER, "n",jsonrpc::JSON_INTEGER, NULL), &AbstractStubServer::blsSignMessageHashByHandleI);
+          this->bindAndAddMethod(jsonrpc::Procedure("blsSignHashedPoint", jsonrpc::PARAMS_BY_NAME, jsonrpc::JSON_OBJECT, "keyShareName",jsonrpc::JSON_STRING,"hashedPoint",jsonrpc::JSON_STRING,"hint",jsonrpc::JSON_STRING, NULL), &AbstractStubServer::blsSignHashedPointI);
+          this->bindAndAddMethod(jsonrpc::Procedure("ecdsaSignMessageHashByHandle", jsonrpc::PARAMS_BY_NAME, jsonrpc::JSON_OBJECT, "base",jsonrpc::JSON_INTEGER,"keyHandle",jsonrpc::JSON_STRING,"messageHash",jsonrpc::JSON_STRING, NULL), &AbstractStubServer::ecdsaSignMessageHashByHandleI);
 
           this->bindAndAddMethod(jsonrpc::Procedure("getSecretShareV2", jsonrpc::PARAMS_BY_NAME, jsonrpc::JSON_OBJECT, "polyName",jsonrpc::JSON_STRING,"publicKeys",jsonrpc::JSON_ARRAY, "n",jsonrpc::JSON_INTEGER,"t",jsonrpc::JSON_INTEGER, NULL), &AbstractStubServer::getSecretShareV2I);
           this->bindAndAddMethod(jsonrpc::Procedure("dkgVerificationV2", jsonrpc::PARAMS_BY_NAME, jsonrpc::JSON_OBJECT, "publicShares",jsonrpc::JSON_STRING, "ethKeyName",jsonrpc::JSON_STRING, "secretShare",jsonrpc::JSON_STRING,"t",jsonrpc::JSON_INTEGER, "n",jsonrpc::JSON_INTEGER, "index",jsonrpc::JSON_INTEGER, NULL), &AbstractStubServer::dkgVerificationV2I);
+          this->bindAndAddMethod(jsonrpc::Procedure("dkgVerificationBatch", jsonrpc::PARAMS_BY_NAME, jsonrpc::JSON_OBJECT, "publicShares",jsonrpc::JSON_ARRAY, "ethKeyName",jsonrpc::JSON_STRING, "secretShares",jsonrpc::JSON_ARRAY,"t",jsonrpc::JSON_INTEGER, "n",jsonrpc::JSON_INTEGER, "index",jsonrpc::JSON_INTEGER, NULL), &AbstractStubServer::dkgVerificationBatchI);
           this->bindAndAddMethod(jsonrpc::Procedure("createBLSPrivateKeyV2", jsonrpc::PARAMS_BY_NAME, jsonrpc::JSON_OBJECT, "blsKeyName",jsonrpc::JSON_STRING, "ethKeyName",jsonrpc::JSON_STRING, "polyName", jsonrpc::JSON_STRING, "secretShare",jsonrpc::JSON_STRING,"t", jsonrpc::JSON_INTEGER,"n",jsonrpc::JSON_INTEGER, NULL), &AbstractStubServer::createBLSPrivateKeyV2I);
 
           this->bindAndAddMethod(jsonrpc::Procedure("getDecryptionShares", jsonrpc::PARAMS_BY_NAME, jsonrpc::JSON_OBJECT, "blsKeyName",jsonrpc::JSON_STRING,"publicDecryptionValues",jsonrpc::JSON_ARRAY, NULL), &AbstractStubServer::getDecryptionSharesI);
 
           this->bindAndAddMethod(jsonrpc::Procedure("popProve", jsonrpc::PARAMS_BY_NAME, jsonrpc::JSON_OBJECT, "blsKeyName",jsonrpc::JSON_STRING, NULL), &AbstractStubServer::popProveI);
           this->bindAndAddMethod(jsonrpc::Procedure("generateBLSPrivateKey", jsonrpc::PARAMS_BY_NAME, jsonrpc::JSON_OBJECT, "blsKeyName",jsonrpc::JSON_STRING, NULL), &AbstractStubServer::generateBLSPrivateKeyI);
+          this->bindAndAddMethod(jsonrpc::Procedure("popProveBatch", jsonrpc::PARAMS_BY_NAME, jsonrpc::JSON_OBJECT, "blsKeyNames",jsonrpc::JSON_ARRAY, NULL), &AbstractStubServer::popProveBatchI);
+          this->bindAndAddMethod(jsonrpc::Procedure("generateBLSPrivateKeyBatch", jsonrpc::PARAMS_BY_NAME, jsonrpc::JSON_OBJECT, "blsKeyNames",jsonrpc::JSON_ARRAY, NULL), &AbstractStubServer::generateBLSPrivateKeyBatchI);
         }
 
         inline virtual void importBLSKeyShareI(const Json::Value &request, Json::Value &response)
@@ -77,11 +95,23 @@ class AbstractStubServer : public jsonrpc::AbstractServer<AbstractStubServer>
         {
             response = this->blsSignMessageHash(request["keyShareName"].asString(), request["messageHash"].asString(), request["t"].asInt(), request["n"].asInt());
         }
+        inline virtual void verifyBLSSignaturesI(const Json::Value &request, Json::Value &response)
+        {
+            response = this->verifyBLSSignatures(request["requests"]);
+        }
 
         inline virtual void importECDSAKeyI(const Json::Value &request, Json::Value &response)
         {
             response = this->importECDSAKey( request["key"].asString(), request["keyName"].asString());
         }
+        inline virtual void importBLSKeyShareBatchI(const Json::Value &request, Json::Value &response)
+        {
+            response = this->importBLSKeyShareBatch(request["keyShares"]);
+        }
+        inline virtual void importECDSAKeyBatchI(const Json::Value &request, Json::Value &response)
+        {
+            response = this->importECDSAKeyBatch(request["keys"]);
+        }
         inline virtual void generateECDSAKeyI(const Json::Value &request, Json::Value &response)
         {
           (void)request;
@@ -95,15 +125,27 @@ class AbstractStubServer : public jsonrpc::AbstractServer<AbstractStubServer>
         {
             response = this->ecdsaSignMessageHash(request["base"].asInt(), request["keyName"].asString(), request["messageHash"].asString());
         }
+        inline virtual void ecdsaSignMessageHashBatchI(const Json::Value &request, Json::Value &response)
+        {
+            response = this->ecdsaSignMessageHashBatch(request["base"].asInt(), request["keyName"].asString(), request["messageHashes"]);
+        }
 
         inline virtual void generateDKGPolyI(const Json::Value &request, Json::Value &response)
         {
             response = this->generateDKGPoly(request["polyName"].asString(), request["t"].asInt());
         }
+        inline virtual void generateDKGPolyBatchI(const Json::Value &request, Json::Value &response)
+        {
+            response = this->generateDKGPolyBatch(request["polyNames"], request["t"].asInt());
+        }
         inline virtual void getVerificationVectorI(const Json::Value &request, Json::Value &response)
         {
             response = this->getVerificationVector(request["polyName"].asString(), request["t"].asInt());
         }
+        inline virtual void getVerificationVectorCompressedI(const Json::Value &request, Json::Value &response)
+        {
+            response = this->getVerificationVectorCompressed(request["polyName"].asString(), request["t"].asInt());
+        }
         inline virtual void getSecretShareI(const Json::Value &request, Json::Value &response)
         {
             response = this->getSecretShare(request["polyName"].asString(), request["publicKeys"], request["t"].asInt(),request["n"].asInt());
@@ -131,6 +173,14 @@ class AbstractStubServer : public jsonrpc::AbstractServer<AbstractStubServer>
         {
             response = this->multG2(request["x"].asString());
         }
+        inline virtual void multG2BatchI(const Json::Value &request, Json::Value &response)
+        {
+            response = this->multG2Batch(request["xs"]);
+        }
+        inline virtual void aggregateBLSSignaturesI(const Json::Value &request, Json::Value &response)
+        {
+            response = this->aggregateBLSSignatures(request["shares"], request["signerIndices"], request["t"].asInt(), request["n"].asInt());
+        }
         inline virtual void isPolyExistsI(const Json::Value &request, Json::Value &response)
         {
             response = this->isPolyExists(request["polyName"].asString());
@@ -142,6 +192,12 @@ class AbstractStubServer : public jsonrpc::AbstractServer<AbstractStubServer>
           response = this->getServerStatus();
         }
 
+        inline virtual void getServerStatusExtendedI(const Json::Value &request, Json::Value &response)
+        {
+          (void)request;
+          response = this->getServerStatusExtended();
+        }
+
         inline virtual void getServerVersionI(const Json::Value &request, Json::Value &response)
         {
           (void)request;
@@ -151,6 +207,29 @@ class AbstractStubServer : public jsonrpc::AbstractServer<AbstractStubServer>
         inline virtual void deleteBlsKeyI(const Json::Value& request, Json::Value& response) {
             response = this->deleteBlsKey(request["blsKeyName"].asString());
         }
+        inline virtual void deleteSchainKeysI(const Json::Value& request, Json::Value& response) {
+            response = this->deleteSchainKeys(request["schainId"].asString());
+        }
+
+        inline virtual void openKeyI(const Json::Value& request, Json::Value& response) {
+            response = this->openKey(request["keyName"].asString());
+        }
+
+        inline virtual void closeKeyI(const Json::Value& request, Json::Value& response) {
+            response = this->closeKey(request["keyHandle"].asString());
+        }
+
+        inline virtual void blsSignMessageHashByHandleI(const Json::Value& request, Json::Value& response) {
+            response = this->blsSignMessageHashByHandle(request["keyHandle"].asString(), request["messageHash"].asString(), request["t"].asInt(), request["n"].asInt());
+        }
+
+        inline virtual void blsSignHashedPointI(const Json::Value& request, Json::Value& response) {
+            response = this->blsSignHashedPoint(request["keyShareName"].asString(), request["hashedPoint"].asString(), request["hint"].asString());
+        }
+
+        inline virtual void ecdsaSignMessageHashByHandleI(const Json::Value& request, Json::Value& response) {
+            response = this->ecdsaSignMessageHashByHandle(request["base"].asInt(), request["keyHandle"].asString(), request["messageHash"].asString());
+        }
 
         inline virtual void getSecretShareV2I(const Json::Value &request, Json::Value &response)
         {
@@ -160,6 +239,10 @@ class AbstractStubServer : public jsonrpc::AbstractServer<AbstractStubServer>
         {
             response = this->dkgVerificationV2(request["publicShares"].asString(), request["ethKeyName"].asString(), request["secretShare"].asString(), request["t"].asInt(), request["n"].asInt(), request["index"].asInt());
         }
+        inline virtual void dkgVerificationBatchI(const Json::Value &request, Json::Value &response)
+        {
+            response = this->dkgVerificationBatch(request["publicShares"], request["ethKeyName"].asString(), request["secretShares"], request["t"].asInt(), request["n"].asInt(), request["index"].asInt());
+        }
         inline virtual void createBLSPrivateKeyV2I(const Json::Value &request, Json::Value &response)
         {
             response = this->createBLSPrivateKeyV2(request["blsKeyName"].asString(), request["ethKeyName"].asString(), request["polyName"].asString(),request["secretShare"].asString(),request["t"].asInt(), request["n"].asInt());
@@ -180,15 +263,30 @@ class AbstractStubServer : public jsonrpc::AbstractServer<AbstractStubServer>
             response = this->generateBLSPrivateKey(request["blsKeyName"].asString());
         }
 
+        inline virtual void popProveBatchI(const Json::Value &request, Json::Value &response)
+        {
+            response = this->popProveBatch(request["blsKeyNames"]);
+        }
+
+        inline virtual void generateBLSPrivateKeyBatchI(const Json::Value &request, Json::Value &response)
+        {
+            response = this->generateBLSPrivateKeyBatch(request["blsKeyNames"]);
+        }
+
         virtual Json::Value importBLSKeyShare(const std::string& keyShare, const std::string& keyShareName) = 0;
         virtual Json::Value blsSignMessageHash(const std::string& keyShareName, const std::string& messageHash, int t, int n ) = 0;
         virtual Json::Value importECDSAKey(const std::string& keyShare, const std::string& keyShareName) = 0;
+        virtual Json::Value importBLSKeyShareBatch(const Json::Value& keyShares) = 0;
+        virtual Json::Value importECDSAKeyBatch(const Json::Value& keys) = 0;
         virtual Json::Value generateECDSAKey() = 0;
         virtual Json::Value getPublicECDSAKey(const std::string& keyName) = 0;
         virtual Json::Value ecdsaSignMessageHash(int base, const std::string& keyName, const std::string& messageHash) = 0;
+        virtual Json::Value ecdsaSignMessageHashBatch(int base, const std::string& keyName, const Json::Value& messageHashes) = 0;
 
         virtual Json::Value generateDKGPoly(const std::string& polyName, int t) = 0;
+        virtual Json::Value generateDKGPolyBatch(const Json::Value& polyNames, int t) = 0;
         virtual Json::Value getVerificationVector(const std::string& polyName, int t) = 0;
+        virtual Json::Value getVerificationVectorCompressed(const std::string& polyName, int t) = 0;
         virtual Json::Value getSecretShare(const std::string& polyName, const Json::Value& publicKeys, int t, int n) = 0;
         virtual Json::Value dkgVerification( const std::string& publicShares, const std::string& ethKeyName, const std::string& SecretShare, int t, int n, int index) = 0;
         virtual Json::Value createBLSPrivateKey(const std::string& blsKeyName, const std::string& ethKeyName, const std::string& polyName, const std::string& SecretShare, int t, int n) = 0;
@@ -196,20 +294,33 @@ class AbstractStubServer : public jsonrpc::AbstractServer<AbstractStubServer>
         virtual Json::Value calculateAllBLSPublicKeys(const Json::Value& publicShares, int t, int n) = 0;
         virtual Json::Value complaintResponse(const std::string& polyName, int t, int n, int ind) = 0;
         virtual Json::Value multG2(const std::string & x) = 0;
+        virtual Json::Value multG2Batch(const Json::Value& xs) = 0;
+        virtual Json::Value aggregateBLSSignatures(const Json::Value& shares, const Json::Value& signerIndices, int t, int n) = 0;
+        virtual Json::Value verifyBLSSignatures(const Json::Value& requests) = 0;
         virtual Json::Value isPolyExists(const std::string& polyName) = 0;
 
         virtual Json::Value getServerStatus() = 0;
+        virtual Json::Value getServerStatusExtended() = 0;
         virtual Json::Value getServerVersion() = 0;
         virtual Json::Value deleteBlsKey(const std::string& name) = 0;
+        virtual Json::Value deleteSchainKeys(const std::string& schainId) = 0;
+        virtual Json::Value openKey(const std::string& keyName) = 0;
+        virtual Json::Value closeKey(const std::string& keyHandle) = 0;
+        virtual Json::Value blsSignMessageHashByHandle(const std::string& keyHandle, const std::string& messageHash, int t, int n) = 0;
+        virtual Json::Value blsSignHashedPoint(const std::string& keyShareName, const std::string& hashedPoint, const std::string& hint) = 0;
+        virtual Json::Value ecdsaSignMessageHashByHandle(int base, const std::string& keyHandle, const std::string& messageHash) = 0;
 
         virtual Json::Value getSecretShareV2(const std::string& polyName, const Json::Value& publicKeys, int t, int n) = 0;
         virtual Json::Value dkgVerificationV2( const std::string& publicShares, const std::string& ethKeyName, const std::string& SecretShare, int t, int n, int index) = 0;
+        virtual Json::Value dkgVerificationBatch( const Json::Value& publicShares, const std::string& ethKeyName, const Json::Value& secretShares, int t, int n, int index) = 0;
         virtual Json::Value createBLSPrivateKeyV2(const std::string& blsKeyName, const std::string& ethKeyName, const std::string& polyName, const std::string & SecretShare, int t, int n) = 0;
         
         virtual Json::Value getDecryptionShares(const std::string& KeyName, const Json::Value& publicDecryptionValues) = 0;
 
         virtual Json::Value popProve(const std::string& blsKeyName) = 0;
         virtual Json::Value generateBLSPrivateKey(const std::string& blsKeyName) = 0;
+        virtual Json::Value popProveBatch(const Json::Value& blsKeyNames) = 0;
+        virtual Json::Value generateBLSPrivateKeyBatch(const Json::Value& blsKeyNames) = 0;
 };
 
 #endif //JSONRPC_CPP_STUB_ABSTRACTSTUBSERVER_H_
@@ -154,12 +154,15 @@ inline string exec( const char* cmd ) {
 
 #include <shared_mutex>
 
-extern std::shared_timed_mutex sgxInitMutex;
+#include "EnclaveEpoch.h"
+
+// READ_LOCK it around ECALLs that must not race with enclave re-creation, WRITE_LOCK is only taken by initEnclave
+extern EnclaveEpoch sgxInitMutex;
 extern uint64_t initTime;
 
 #define LOCK(__X__) std::lock_guard<std::recursive_mutex> __LOCK__(__X__);
-#define READ_LOCK(__X__) std::shared_lock<std::shared_timed_mutex> __LOCK__(__X__);
-#define WRITE_LOCK(__X__) std::unique_lock<std::shared_timed_mutex> __LOCK__(__X__);
+#define READ_LOCK(__X__) std::shared_lock<EnclaveEpoch> __LOCK__(__X__);
+#define WRITE_LOCK(__X__) std::unique_lock<EnclaveEpoch> __LOCK__(__X__);
 
 
 #endif //SGXWALLET_COMMON_H
@@ -1,2 +1,3 @@
 #!/bin/bash
 jsonrpcstub spec.json --cpp-server=AbstractStubServer --cpp-client=StubClient
+python3 scripts/generate_request_codecs.py spec.json zmq_src/RequestCodecs.h
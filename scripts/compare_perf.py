@@ -0,0 +1,66 @@
+#!/usr/bin/env python3
+
+# Copyright (C) 2021-Present SKALE Labs
+#
+# This file is part of sgxwallet.
+#
+# sgxwallet is free software: you can redistribute it and/or modify
+# it under the terms of the GNU Affero General Public License as published
+# by the Free Software Foundation, either version 3 of the License, or
+# (at your option) any later version.
+#
+# sgxwallet is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU Affero General Public License for more details.
+#
+# You should have received a copy of the GNU Affero General Public License
+# along with sgxwallet.  If not, see <https://www.gnu.org/licenses/>.
+#
+#    @file  compare_perf.py
+#    @author Stan Kladko
+#    @date 2021
+#
+
+# Compares the JSON results written by the testw perf cases against a stored baseline.
+# Usage: compare_perf.py <results_dir> <baseline_dir> [tolerance_percent]
+# Exits with 1 if throughput dropped or p99 latency grew by more than the tolerance.
+
+import json, os, sys
+
+if len(sys.argv) < 3:
+    print("Usage: compare_perf.py <results_dir> <baseline_dir> [tolerance_percent]")
+    sys.exit(2)
+
+resultsDir = sys.argv[1]
+baselineDir = sys.argv[2]
+tolerance = float(sys.argv[3]) if len(sys.argv) > 3 else 10.0
+
+regressions = 0
+
+for fileName in sorted(os.listdir(resultsDir)):
+    if not fileName.endswith(".json"):
+        continue
+
+    baselineFile = os.path.join(baselineDir, fileName)
+    if not os.path.exists(baselineFile):
+        print("No baseline for " + fileName + ", skipping")
+        continue
+
+    with open(os.path.join(resultsDir, fileName)) as f:
+        result = json.load(f)
+    with open(baselineFile) as f:
+        baseline = json.load(f)
+
+    throughputChange = 100.0 * (result["throughputPerSec"] / baseline["throughputPerSec"] - 1)
+    p99Change = 100.0 * (result["latencyMs"]["p99"] / baseline["latencyMs"]["p99"] - 1)
+
+    regressed = throughputChange < -tolerance or p99Change > tolerance
+    if regressed:
+        regressions += 1
+
+    print("%s: %s vs %s, throughput %+.1f%%, p99 latency %+.1f%%%s" %
+          (result["name"], result["version"], baseline["version"], throughputChange, p99Change,
+           " REGRESSION" if regressed else ""))
+
+sys.exit(1 if regressions > 0 else 0)
@@ -0,0 +1,204 @@
+#!/usr/bin/env python3
+
+# Copyright (C) 2021-Present SKALE Labs
+#
+# This file is part of sgxwallet.
+#
+# sgxwallet is free software: you can redistribute it and/or modify
+# it under the terms of the GNU Affero General Public License as published
+# by the Free Software Foundation, either version 3 of the License, or
+# (at your option) any later version.
+#
+# sgxwallet is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU Affero General Public License for more details.
+#
+# You should have received a copy of the GNU Affero General Public License
+# along with sgxwallet.  If not, see <https://www.gnu.org/licenses/>.
+#
+#    @file  generate_request_codecs.py
+#    @author Stan Kladko
+#    @date 2021
+#
+
+# Generates zmq_src/RequestCodecs.h from spec.json, one params struct per method.
+# Usage: generate_request_codecs.py [spec.json] [RequestCodecs.h]
+
+import json, re, sys
+
+specFile = sys.argv[1] if len(sys.argv) > 1 else "spec.json"
+outFile = sys.argv[2] if len(sys.argv) > 2 else "zmq_src/RequestCodecs.h"
+
+# spec.json is read by jsonrpcstub, which accepts trailing commas
+with open(specFile) as f:
+    spec = json.loads(re.sub(r",(\s*[\]}])", r"\1", f.read()))
+
+# field type, C++ type, default, getter
+TYPES = {
+    str: ("FIELD_STRING", "std::string_view", "", "getString"),
+    bool: ("FIELD_BOOL", "bool", " = false", "getBool"),
+    int: ("FIELD_INT", "int64_t", " = 0", "getInt"),
+    list: ("FIELD_ARRAY", "const rapidjson::Value *", " = nullptr", "getArray"),
+    dict: ("FIELD_OBJECT", "const rapidjson::Value *", " = nullptr", "getObject"),
+}
+
+HEADER = """/*
+    Copyright (C) 2021-Present SKALE Labs
+
+    This file is part of sgxwallet.
+
+    sgxwallet is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as published
+    by the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    sgxwallet is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with sgxwallet.  If not, see <https://www.gnu.org/licenses/>.
+
+    @file RequestCodecs.h
+    @author Stan Kladko
+    @date 2021
+*/
+
+// Generated from spec.json by scripts/generate_request_codecs.py, do not edit.
+// Each struct parses the params of one method in one pass over the members of a request,
+// string fields point into the request document.
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+#include <json/value.h>
+
+#include "document.h"
+
+#include "common.h"
+#include "SGXException.h"
+
+namespace codec {
+
+enum FieldType {
+    FIELD_STRING, FIELD_INT, FIELD_BOOL, FIELD_ARRAY, FIELD_OBJECT
+};
+
+struct Field {
+    const char *name;
+    FieldType type;
+};
+
+inline std::string_view getString(const rapidjson::Value &_v) {
+    CHECK_STATE(_v.IsString());
+    return std::string_view(_v.GetString(), _v.GetStringLength());
+}
+
+inline int64_t getInt(const rapidjson::Value &_v) {
+    CHECK_STATE(_v.IsInt64());
+    return _v.GetInt64();
+}
+
+inline bool getBool(const rapidjson::Value &_v) {
+    CHECK_STATE(_v.IsBool());
+    return _v.GetBool();
+}
+
+inline const rapidjson::Value *getArray(const rapidjson::Value &_v) {
+    CHECK_STATE(_v.IsArray());
+    return &_v;
+}
+
+inline const rapidjson::Value *getObject(const rapidjson::Value &_v) {
+    CHECK_STATE(_v.IsObject());
+    return &_v;
+}
+
+inline void checkFields(uint64_t _found, const Field *_fields, size_t _numFields) {
+    for (size_t i = 0; i < _numFields; i++) {
+        if (!(_found & (1ull << i))) {
+            BOOST_THROW_EXCEPTION(SGXException(-100, std::string("Missing request field ") + _fields[i].name));
+        }
+    }
+}
+
+}
+"""
+
+
+def structName(method):
+    return method[0].upper() + method[1:] + "Params"
+
+
+def generate(method, params):
+    fields = list(params.items())
+    assert len(fields) <= 64, method
+    for name, value in fields:
+        assert type(value) in TYPES, (method, name)
+
+    out = []
+    out.append("struct %s {" % structName(method))
+    out.append("    static constexpr const char *METHOD = \"%s\";" % method)
+    out.append("    static constexpr codec::Field FIELDS[] = {")
+    out.append(",\n".join("            {\"%s\", codec::%s}" % (name, TYPES[type(value)][0]) for name, value in fields))
+    out.append("    };")
+    out.append("    static constexpr size_t NUM_FIELDS = %d;" % len(fields))
+    out.append("")
+    for name, value in fields:
+        _, cppType, default, _ = TYPES[type(value)]
+        sep = "" if cppType.endswith("*") else " "
+        out.append("    %s%s%s%s;" % (cppType, sep, name, default))
+    out.append("")
+    out.append("    void parse(const rapidjson::Value &_d) {")
+    out.append("        CHECK_STATE(_d.IsObject());")
+    out.append("        uint64_t found = 0;")
+    out.append("        for (auto it = _d.MemberBegin(); it != _d.MemberEnd(); ++it) {")
+    out.append("            std::string_view name(it->name.GetString(), it->name.GetStringLength());")
+    out.append("            switch (name.size()) {")
+    byLength = {}
+    for i, (name, value) in enumerate(fields):
+        byLength.setdefault(len(name), []).append((i, name, value))
+    for length in sorted(byLength):
+        out.append("                case %d:" % length)
+        for j, (i, name, value) in enumerate(byLength[length]):
+            keyword = "if" if j == 0 else "} else if"
+            out.append("                    %s (name == \"%s\") {" % (keyword, name))
+            out.append("                        %s = codec::%s(it->value);" % (name, TYPES[type(value)][3]))
+            out.append("                        found |= 1ull << %d;" % i)
+        out.append("                    }")
+        out.append("                    break;")
+    out.append("                default:")
+    out.append("                    break;")
+    out.append("            }")
+    out.append("        }")
+    out.append("        codec::checkFields(found, FIELDS, NUM_FIELDS);")
+    out.append("    }")
+
+    # array and object params are built by the client itself
+    if all(type(value) in (str, bool, int) for _, value in fields):
+        out.append("")
+        out.append("    void write(Json::Value &_p) const {")
+        for name, value in fields:
+            if type(value) is str:
+                out.append("        _p[\"%s\"] = std::string(%s);" % (name, name))
+            elif type(value) is int:
+                out.append("        _p[\"%s\"] = (Json::Int64) %s;" % (name, name))
+            else:
+                out.append("        _p[\"%s\"] = %s;" % (name, name))
+        out.append("    }")
+
+    out.append("};")
+    return "\n".join(out)
+
+
+structs = [generate(m["name"], m["params"]) for m in spec if m.get("params")]
+
+with open(outFile, "w") as f:
+    f.write(HEADER)
+    for s in structs:
+        f.write("\n" + s + "\n")
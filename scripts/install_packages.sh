@@ -1,5 +1,5 @@
 #!/bin/bash
 sudo apt update
 sudo apt install -y build-essential make gcc g++ yasm  python libprotobuf10 flex bison automake
-sudo apt install -y ccache cmake ccache autoconf texinfo libgcrypt20-dev libgnutls28-dev libtool pkg-config
+sudo apt install -y ccache cmake ccache autoconf texinfo libgcrypt20-dev libgnutls28-dev libtool pkg-config systemtap-sdt-dev
 sudo apt install -y ocaml ocamlbuild
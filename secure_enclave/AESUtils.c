@@ -25,13 +25,89 @@
 #include "sgx_tcrypto.h"
 #include "stdlib.h"
 #include <string.h>
+#include "sgx_thread.h"
 
 #include "AESUtils.h"
 
 sgx_aes_gcm_128bit_key_t AES_key[1024];
 
+// AES_key[513] holds the previous SEK while a SEK rotation is in progress. Both keys are
+// copied out under sek_mutex, so a rotation never exposes a half written key
+static sgx_thread_mutex_t sek_mutex = SGX_THREAD_MUTEX_INITIALIZER;
+static int previous_sek_set = 0;
+
+static int load_SEK(sgx_aes_gcm_128bit_key_t current, sgx_aes_gcm_128bit_key_t previous) {
+    sgx_thread_mutex_lock(&sek_mutex);
+    memcpy(current, AES_key[512], sizeof(sgx_aes_gcm_128bit_key_t));
+    int hasPrevious = previous_sek_set;
+    if (previous && hasPrevious)
+        memcpy(previous, AES_key[513], sizeof(sgx_aes_gcm_128bit_key_t));
+    sgx_thread_mutex_unlock(&sek_mutex);
+    return hasPrevious;
+}
+
+int AES_rotate_SEK(const uint8_t *newSEK) {
+    int status = 0;
+    sgx_thread_mutex_lock(&sek_mutex);
+    if (!previous_sek_set) {
+        memcpy(AES_key[513], AES_key[512], sizeof(sgx_aes_gcm_128bit_key_t));
+        memcpy(AES_key[512], newSEK, sizeof(sgx_aes_gcm_128bit_key_t));
+        previous_sek_set = 1;
+    } else if (memcmp(AES_key[512], newSEK, sizeof(sgx_aes_gcm_128bit_key_t)) != 0) {
+        // the keys still sealed under the previous SEK would be lost
+        status = -1;
+    }
+    sgx_thread_mutex_unlock(&sek_mutex);
+    return status;
+}
+
+void AES_drop_previous_SEK() {
+    sgx_thread_mutex_lock(&sek_mutex);
+    memset(AES_key[513], 0, sizeof(sgx_aes_gcm_128bit_key_t));
+    previous_sek_set = 0;
+    sgx_thread_mutex_unlock(&sek_mutex);
+}
+
 #define SAFE_CHAR_BUF(__X__, __Y__)  ;char __X__ [ __Y__ ]; memset(__X__, 0, __Y__);
 
+// Sealed format: MAC | IV | AES-GCM(type | exportable | message), message includes its terminating zero
+
+static int AES_encrypt_with_iv(const char *message, uint64_t len, uint8_t *encr_message, uint64_t encrBufLen,
+                               unsigned char type, unsigned char exportable, const uint8_t *iv,
+                               uint64_t *resultLen) {
+    if (2 + len + SGX_AESGCM_MAC_SIZE + SGX_AESGCM_IV_SIZE > encrBufLen ) {
+        LOG_ERROR("Output buffer too small");
+        return -4;
+    }
+
+    SAFE_CHAR_BUF(fullMessage, len + 2);
+
+    fullMessage[0] = type;
+    fullMessage[1] = exportable;
+
+    memcpy(fullMessage + 2, message, len);
+
+    len = len + 2;
+
+    memcpy(encr_message + SGX_AESGCM_MAC_SIZE, iv, SGX_AESGCM_IV_SIZE);
+
+    sgx_aes_gcm_128bit_key_t key;
+    load_SEK(key, NULL);
+
+    sgx_status_t status = sgx_rijndael128GCM_encrypt(&key, (uint8_t*)fullMessage, len,
+                                                     encr_message + SGX_AESGCM_MAC_SIZE + SGX_AESGCM_IV_SIZE,
+                                                     encr_message + SGX_AESGCM_MAC_SIZE, SGX_AESGCM_IV_SIZE,
+                                                     NULL, 0,
+                                                     (sgx_aes_gcm_128bit_tag_t *) encr_message);
+
+    memset(fullMessage, 0, len);
+    memset(key, 0, sizeof(key));
+
+    *resultLen = len + SGX_AESGCM_MAC_SIZE + SGX_AESGCM_IV_SIZE;
+
+    return status;
+}
+
 int AES_encrypt(char *message, uint8_t *encr_message, uint64_t encrBufLen, unsigned char type,
                 unsigned char exportable, uint64_t* resultLen) {
     if (!type) {
@@ -54,38 +130,56 @@ int AES_encrypt(char *message, uint8_t *encr_message, uint64_t encrBufLen, unsig
         return -3;
     }
 
-    uint64_t len = strlen(message) + 1;
+    uint8_t iv[SGX_AESGCM_IV_SIZE];
+    sgx_read_rand(iv, SGX_AESGCM_IV_SIZE);
 
-    if (2 + len + SGX_AESGCM_MAC_SIZE + SGX_AESGCM_IV_SIZE > encrBufLen ) {
-        LOG_ERROR("Output buffer too small");
-        return -4;
-    }
+    return AES_encrypt_with_iv(message, strlen(message) + 1, encr_message, encrBufLen, type, exportable, iv,
+                               resultLen);
+}
 
-    SAFE_CHAR_BUF(fullMessage, len + 2);
+int AES_encrypt_batch(const char *messages, uint64_t msgSlotLen, const uint64_t *msgLens, uint64_t count,
+                      uint8_t *encr_messages, uint64_t encrSlotLen, unsigned char type, unsigned char exportable,
+                      uint64_t *resultLens, int *statuses) {
+    if (!type || !messages || !msgLens || !encr_messages || !resultLens || !statuses) {
+        LOG_ERROR("Null argument in AES_encrypt_batch");
+        return -1;
+    }
 
-    fullMessage[0] = type;
-    fullMessage[1] = exportable;
+    if (count == 0 || count > AES_BATCH_MAX_COUNT) {
+        LOG_ERROR("Invalid count in AES_encrypt_batch");
+        return -2;
+    }
 
-    strncpy(fullMessage + 2, message, len );
+    uint8_t ivs[AES_BATCH_MAX_COUNT * SGX_AESGCM_IV_SIZE];
+    sgx_read_rand(ivs, count * SGX_AESGCM_IV_SIZE);
 
-    len = len + 2;
-    message = fullMessage;
+    for (uint64_t i = 0; i < count; i++) {
+        resultLens[i] = 0;
 
-    sgx_read_rand(encr_message + SGX_AESGCM_MAC_SIZE, SGX_AESGCM_IV_SIZE);
+        if (msgLens[i] == 0 || msgLens[i] > msgSlotLen) {
+            statuses[i] = -5;
+            continue;
+        }
 
-    sgx_status_t status = sgx_rijndael128GCM_encrypt(&(AES_key[512]), (uint8_t*)message, len,
-                                                     encr_message + SGX_AESGCM_MAC_SIZE + SGX_AESGCM_IV_SIZE,
-                                                     encr_message + SGX_AESGCM_MAC_SIZE, SGX_AESGCM_IV_SIZE,
-                                                     NULL, 0,
-                                                     (sgx_aes_gcm_128bit_tag_t *) encr_message);
+        statuses[i] = AES_encrypt_with_iv(messages + i * msgSlotLen, msgLens[i], encr_messages + i * encrSlotLen,
+                                          encrSlotLen, type, exportable, ivs + i * SGX_AESGCM_IV_SIZE,
+                                          resultLens + i);
+        if (statuses[i] != 0)
+            resultLens[i] = 0;
+    }
 
-    *resultLen = len + SGX_AESGCM_MAC_SIZE + SGX_AESGCM_IV_SIZE;
+    memset(ivs, 0, sizeof(ivs));
 
-    return status;
+    return 0;
 }
 
 int AES_decrypt(uint8_t *encrMessage, uint64_t length, char *message, uint64_t msgLen,
                 uint8_t *type, uint8_t* exportable){
+    return AES_decrypt_ex(encrMessage, length, message, msgLen, type, exportable, NULL);
+}
+
+int AES_decrypt_ex(uint8_t *encrMessage, uint64_t length, char *message, uint64_t msgLen,
+                   uint8_t *type, uint8_t* exportable, int *previousSEK) {
 
     if (!message) {
         LOG_ERROR("Null message in AES_decrypt");
@@ -108,7 +202,7 @@ int AES_decrypt(uint8_t *encrMessage, uint64_t length, char *message, uint64_t m
     }
 
 
-    if (length < SGX_AESGCM_MAC_SIZE + SGX_AESGCM_IV_SIZE) {
+    if (length < SGX_AESGCM_MAC_SIZE + SGX_AESGCM_IV_SIZE + 2) {
         LOG_ERROR("length < SGX_AESGCM_MAC_SIZE - SGX_AESGCM_IV_SIZE");
         return -5;
     }
@@ -120,18 +214,38 @@ int AES_decrypt(uint8_t *encrMessage, uint64_t length, char *message, uint64_t m
         return -6;
     }
 
-    sgx_status_t status = sgx_rijndael128GCM_decrypt(&(AES_key[512]),
-                                                    encrMessage + SGX_AESGCM_MAC_SIZE + SGX_AESGCM_IV_SIZE, len,
-                                                    (unsigned char*) message,
-                                                    encrMessage + SGX_AESGCM_MAC_SIZE, SGX_AESGCM_IV_SIZE,
-                                                    NULL, 0,
-                                                    (sgx_aes_gcm_128bit_tag_t *)encrMessage);
+    sgx_aes_gcm_128bit_key_t keys[2];
+    int numKeys = 1 + load_SEK(keys[0], keys[1]);
+
+    sgx_status_t status = SGX_ERROR_UNEXPECTED;
+
+    int i = 0;
+    for (; i < numKeys; i++) {
+        status = sgx_rijndael128GCM_decrypt(&keys[i],
+                                            encrMessage + SGX_AESGCM_MAC_SIZE + SGX_AESGCM_IV_SIZE, len,
+                                            (unsigned char*) message,
+                                            encrMessage + SGX_AESGCM_MAC_SIZE, SGX_AESGCM_IV_SIZE,
+                                            NULL, 0,
+                                            (sgx_aes_gcm_128bit_tag_t *)encrMessage);
+        if (status == SGX_SUCCESS)
+            break;
+    }
+
+    memset(keys, 0, sizeof(keys));
+
+    if (previousSEK)
+        *previousSEK = (i == 1);
 
+    if (status != SGX_SUCCESS) {
+        memset(message, 0, len);
+        return status;
+    }
+
+    // the length of the plaintext is known, so the header is dropped with one move
     *type = message[0];
     *exportable = message[1];
-    for (int i = 2; i < strlen(message) + 1; i++) {
-        message[i - 2 ] = message[i];
-    }
+    memmove(message, message + 2, len - 2);
+    memset(message + len - 2, 0, 2);
 
     return status;
 }
@@ -28,9 +28,31 @@ extern sgx_aes_gcm_128bit_key_t AES_key[1024];
 
 int AES_encrypt(char *message, uint8_t *encr_message, uint64_t encrLen,
                 unsigned char type, unsigned char exportable, uint64_t* resultLen);
+
+// encrypts count messages with one sgx_read_rand call for all IVs. Message i has msgLens[i] bytes,
+// its terminating zero included, at messages + i * msgSlotLen and is sealed into
+// encr_messages + i * encrSlotLen. A message that fails only sets its own status,
+// the result is non zero for invalid arguments
+int AES_encrypt_batch(const char *messages, uint64_t msgSlotLen, const uint64_t *msgLens, uint64_t count,
+                      uint8_t *encr_messages, uint64_t encrSlotLen, unsigned char type, unsigned char exportable,
+                      uint64_t *resultLens, int *statuses);
+
 int AES_decrypt(uint8_t *encr_message, uint64_t length, char *message, uint64_t msgLen,
                 uint8_t *type, uint8_t* exportable) ;
 
+// AES_decrypt that also accepts the previous SEK during a rotation, *previousSEK is set
+// if the message was sealed under it
+int AES_decrypt_ex(uint8_t *encr_message, uint64_t length, char *message, uint64_t msgLen,
+                   uint8_t *type, uint8_t* exportable, int *previousSEK);
+
+// makes newSEK the current SEK and keeps the current one as the previous SEK. Fails if another
+// rotation is in progress, repeating the current one is a no op
+int AES_rotate_SEK(const uint8_t *newSEK);
+
+void AES_drop_previous_SEK();
+
+
+#define AES_BATCH_MAX_COUNT 256
 
 #define ECDSA '1'
 #define BLS '2'
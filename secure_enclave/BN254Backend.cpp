@@ -0,0 +1,168 @@
+/*
+    Copyright (C) 2021-Present SKALE Labs
+
+    This file is part of sgxwallet.
+
+    sgxwallet is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as published
+    by the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    sgxwallet is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with sgxwallet.  If not, see <https://www.gnu.org/licenses/>.
+
+    @file BN254Backend.cpp
+    @author Stan Kladko
+    @date 2021
+*/
+
+#define GMP_WITH_SGX 1
+
+#include <string.h>
+#include <cstdint>
+
+#include "../SCIPR/libff/algebra/curves/alt_bn128/alt_bn128_init.hpp"
+#include "../SCIPR/libff/algebra/curves/alt_bn128/alt_bn128_pp.hpp"
+
+#ifdef SGXWALLET_BN254_MCL
+#include <mcl/bn.hpp>
+#endif
+
+#include "EnclaveConstants.h"
+#include "EnclaveCommon.h"
+#include "G1Mult.h"
+#include "BN254Backend.h"
+
+using namespace std;
+
+static void fqToLimbs(const libff::alt_bn128_Fq &_fq, uint64_t *_limbs) {
+    auto value = _fq.as_bigint();
+
+    for (int i = 0; i < BLS_FQ_LIMBS; i++) {
+        _limbs[i] = value.data[i];
+    }
+}
+
+// the GLV multiplier, or the generic libff multiplication until g1_glv_init has checked it
+static bool libffG1Mul(const libff::alt_bn128_Fr &_k, const libff::alt_bn128_Fq &_x, const libff::alt_bn128_Fq &_y,
+                       uint64_t *_result) {
+    libff::alt_bn128_Fq x, y;
+
+    if (!g1_glv_mul(_k, _x, _y, x, y)) {
+        libff::alt_bn128_G1 point(_x, _y, libff::alt_bn128_Fq::one());
+
+        libff::alt_bn128_G1 product = _k.as_bigint() * point;
+
+        product.to_affine_coordinates();
+
+        x = product.X;
+        y = product.Y;
+    }
+
+    fqToLimbs(x, _result);
+    fqToLimbs(y, _result + BLS_FQ_LIMBS);
+
+    return true;
+}
+
+#ifdef SGXWALLET_BN254_MCL
+
+// mcl is set up for the alt_bn128 curve of libff and Ethereum, BN_SNARK1. Its static assembly
+// is used, the JIT of mcl cannot run in an enclave
+static bool mclReady = false;
+
+const char *bn254_backend_name() {
+    return "mcl";
+}
+
+void bn254_backend_init() {
+    if (__atomic_load_n(&mclReady, __ATOMIC_ACQUIRE)) {
+        return;
+    }
+
+    bool ok = false;
+    mcl::bn::initPairing(&ok, mcl::BN_SNARK1);
+
+    if (!ok) {
+        LOG_ERROR("Could not init mcl, using libff for BLS signing");
+        g1_glv_init();
+        return;
+    }
+
+    __atomic_store_n(&mclReady, true, __ATOMIC_RELEASE);
+}
+
+// little endian limbs of libff are the little endian serialization of mcl
+static bool fqToMcl(const libff::alt_bn128_Fq &_fq, mcl::bn::Fp &_fp) {
+    uint64_t limbs[BLS_FQ_LIMBS];
+    fqToLimbs(_fq, limbs);
+    bool ok = false;
+    _fp.setArray(&ok, limbs, BLS_FQ_LIMBS);
+    return ok;
+}
+
+bool bn254_g1_mul(const libff::alt_bn128_Fr &_k, const libff::alt_bn128_Fq &_x, const libff::alt_bn128_Fq &_y,
+                  uint64_t *_result) {
+    if (!__atomic_load_n(&mclReady, __ATOMIC_ACQUIRE)) {
+        return libffG1Mul(_k, _x, _y, _result);
+    }
+
+    mcl::bn::Fp x, y;
+    mcl::bn::Fr k;
+    bool ok = false;
+
+    auto scalar = _k.as_bigint();
+    k.setArray(&ok, scalar.data, libff::alt_bn128_r_limbs);
+    if (!ok || !fqToMcl(_x, x) || !fqToMcl(_y, y)) {
+        return false;
+    }
+
+    mcl::bn::G1 point, product;
+    point.set(&ok, x, y);
+    if (!ok) {
+        return false;
+    }
+
+    mcl::bn::G1::mulCT(product, point, k);
+    product.normalize();
+
+    if (product.isZero()) {
+        return false;
+    }
+
+    uint8_t bytes[BLS_FQ_LIMBS * sizeof(uint64_t)];
+
+    if (product.x.serialize(bytes, sizeof(bytes), mcl::IoSerialize) != sizeof(bytes)) {
+        return false;
+    }
+    memcpy(_result, bytes, sizeof(bytes));
+
+    if (product.y.serialize(bytes, sizeof(bytes), mcl::IoSerialize) != sizeof(bytes)) {
+        return false;
+    }
+    memcpy(_result + BLS_FQ_LIMBS, bytes, sizeof(bytes));
+
+    return true;
+}
+
+#else
+
+const char *bn254_backend_name() {
+    return "libff";
+}
+
+void bn254_backend_init() {
+    g1_glv_init();
+}
+
+bool bn254_g1_mul(const libff::alt_bn128_Fr &_k, const libff::alt_bn128_Fq &_x, const libff::alt_bn128_Fq &_y,
+                  uint64_t *_result) {
+    return libffG1Mul(_k, _x, _y, _result);
+}
+
+#endif
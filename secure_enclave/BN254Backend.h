@@ -0,0 +1,45 @@
+/*
+    Copyright (C) 2021-Present SKALE Labs
+
+    This file is part of sgxwallet.
+
+    sgxwallet is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as published
+    by the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    sgxwallet is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with sgxwallet.  If not, see <https://www.gnu.org/licenses/>.
+
+    @file BN254Backend.h
+    @author Stan Kladko
+    @date 2021
+*/
+
+#ifndef SGXWALLET_BN254BACKEND_H
+#define SGXWALLET_BN254BACKEND_H
+
+#include <stdint.h>
+
+#include "../SCIPR/libff/algebra/curves/alt_bn128/alt_bn128_pp.hpp"
+
+// Curve arithmetic of the BLS sign ECALLs. Keys and points are parsed with libff everywhere,
+// the multiplication is done by the backend selected at build time with BN254_BACKEND in
+// Makefile.am: libff (default, see G1Mult.h) or mcl, which defines SGXWALLET_BN254_MCL.
+
+// name of the compiled in backend
+const char *bn254_backend_name();
+
+// has to be called after libff is initialized
+void bn254_backend_init();
+
+// _result = _k * (_x, _y) as affine x and y limbs, BLS_FQ_LIMBS each
+bool bn254_g1_mul(const libff::alt_bn128_Fr &_k, const libff::alt_bn128_Fq &_x, const libff::alt_bn128_Fq &_y,
+                  uint64_t *_result);
+
+#endif //SGXWALLET_BN254BACKEND_H
@@ -164,6 +164,71 @@ int session_key_recover(const char *skey_str, const char *sshare, char *common_k
     return ret;
 }
 
+int session_keys_recover(const char *skey_str, const char *sshares, int num_shares, char *common_keys) {
+
+    int ret = -1;
+
+    mpz_t skey;
+    mpz_init(skey);
+    point pub_keys[MAX_DKG_SHARES_BATCH_SIZE];
+    point session_keys[MAX_DKG_SHARES_BATCH_SIZE];
+    int num_points = 0;
+
+    if (!skey_str || !sshares || !common_keys) {
+        LOG_ERROR("session_keys_recover: Null argument");
+        goto clean;
+    }
+
+    if (num_shares <= 0 || num_shares > MAX_DKG_SHARES_BATCH_SIZE) {
+        LOG_ERROR("session_keys_recover: Invalid number of shares");
+        goto clean;
+    }
+
+    if (mpz_set_str(skey, skey_str, 16) == -1) {
+        goto clean;
+    }
+
+    for (; num_points < num_shares; num_points++) {
+        pub_keys[num_points] = point_init();
+        session_keys[num_points] = point_init();
+
+        SAFE_CHAR_BUF(pb_keyB_x, 65);
+        SAFE_CHAR_BUF(pb_keyB_y, 65);
+        strncpy(pb_keyB_x, sshares + 192 * num_points + 64, 64);
+        strncpy(pb_keyB_y, sshares + 192 * num_points + 128, 64);
+
+        point_set_hex(pub_keys[num_points], pb_keyB_x, pb_keyB_y);
+    }
+
+    point_multiplication_batch(session_keys, skey, pub_keys, num_shares, curve);
+
+    for (int i = 0; i < num_shares; i++) {
+        char *common_key = common_keys + i * ECDSA_SKEY_LEN;
+
+        SAFE_CHAR_BUF(arr_x, BUF_LEN);
+        mpz_get_str(arr_x, 16, session_keys[i]->x);
+        int n_zeroes = 64 - strlen(arr_x);
+        for (int j = 0; j < n_zeroes; j++) {
+            common_key[j] = '0';
+        }
+        strncpy(common_key + n_zeroes, arr_x, strlen(arr_x));
+        common_key[64] = 0;
+    }
+
+    ret = 0;
+
+    clean:
+    if (skey->_mp_d)
+        memset(skey->_mp_d, 0, skey->_mp_alloc * sizeof(mp_limb_t));
+    mpz_clear(skey);
+    for (int i = 0; i < num_points; i++) {
+        point_clear(pub_keys[i]);
+        point_clear(session_keys[i]);
+    }
+
+    return ret;
+}
+
 int xor_encrypt(char *key, char *message, char *cypher) {
 
     int ret = -1;
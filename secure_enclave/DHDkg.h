@@ -28,6 +28,10 @@ int gen_session_key(char* skey, char* pub_keyB, char* common_key);
 
 int session_key_recover(const char *skey_str, const char* sshare, char* common_key);
 
+// recovers the common keys of num_shares concatenated 192 char shares with one parse of skey,
+// common key i is written null terminated to common_keys + i * ECDSA_SKEY_LEN
+int session_keys_recover(const char *skey_str, const char* sshares, int num_shares, char* common_keys);
+
 int xor_encrypt(char* key, char* message, char* cypher);
 
 int xor_encrypt_v2(char* key, char* message, char* cypher);
@@ -41,6 +41,7 @@
 #include <stdio.h>
 #include "EnclaveCommon.h"
 #include "DHDkg.h"
+#include "G2Mult.h"
 
 
 using namespace std;
@@ -385,7 +386,7 @@ int calc_secret_shareG2(const char *s_share, char *s_shareG2) {
 
         libff::alt_bn128_Fr secret_share(share_str);
 
-        libff::alt_bn128_G2 secret_shareG2 = secret_share * libff::alt_bn128_G2::one();
+        libff::alt_bn128_G2 secret_shareG2 = g2_fixed_base_mul(secret_share);
 
         secret_shareG2.to_affine_coordinates();
 
@@ -429,7 +430,7 @@ int calc_public_shares(const char *decrypted_coeffs, char *public_shares,
             return ret;
         }
         for (size_t i = 0; i < _t; ++i) {
-            libff::alt_bn128_G2 pub_share = poly.at(i) * libff::alt_bn128_G2::one();
+            libff::alt_bn128_G2 pub_share = g2_fixed_base_mul(poly.at(i));
             pub_share.to_affine_coordinates();
             string pub_share_str = ConvertG2ToString(pub_share);
             result += pub_share_str + ",";
@@ -479,41 +480,50 @@ string ConvertHexToDec(string hex_str) {
     return ret;
 }
 
+// parses _t hex encoded G2 commitments, returns 2 on malformed hex and 3 if a point is not in G2
+static int parsePublicShares(const string &pub_shares_str, int _t, vector <libff::alt_bn128_G2> &pub_shares) {
+    uint64_t share_length = 256;
+    uint8_t coord_length = 64;
+
+    for (int i = 0; i < _t; i++) {
+        libff::alt_bn128_G2 pub_share;
+
+        uint64_t pos0 = share_length * i;
+        string x_c0_str = ConvertHexToDec(pub_shares_str.substr(pos0, coord_length));
+        string x_c1_str = ConvertHexToDec(pub_shares_str.substr(pos0 + coord_length, coord_length));
+        string y_c0_str = ConvertHexToDec(pub_shares_str.substr(pos0 + 2 * coord_length, coord_length));
+        string y_c1_str = ConvertHexToDec(pub_shares_str.substr(pos0 + 3 * coord_length, coord_length));
+        if (x_c0_str == "" || x_c1_str == "" || y_c0_str == "" || y_c1_str == "") {
+            return 2;
+        }
+        pub_share.X.c0 = libff::alt_bn128_Fq(x_c0_str.c_str());
+        pub_share.X.c1 = libff::alt_bn128_Fq(x_c1_str.c_str());
+        pub_share.Y.c0 = libff::alt_bn128_Fq(y_c0_str.c_str());
+        pub_share.Y.c1 = libff::alt_bn128_Fq(y_c1_str.c_str());
+        pub_share.Z = libff::alt_bn128_Fq2::one();
+
+        if ( !isG2( pub_share ) ) {
+            return 3;
+        }
+        pub_shares.push_back(pub_share);
+    }
+
+    return 0;
+}
+
 int Verification(char *public_shares, mpz_t decr_secret_share, int _t, int ind) {
 
     string pub_shares_str = public_shares;
     vector <libff::alt_bn128_G2> pub_shares;
-    uint64_t share_length = 256;
-    uint8_t coord_length = 64;
     int ret = 0;
 
     CHECK_ARG_CLEAN(public_shares);
 
     try {
 
-        for (int i = 0; i < _t; i++) {
-            libff::alt_bn128_G2 pub_share;
-
-            uint64_t pos0 = share_length * i;
-            string x_c0_str = ConvertHexToDec(pub_shares_str.substr(pos0, coord_length));
-            string x_c1_str = ConvertHexToDec(pub_shares_str.substr(pos0 + coord_length, coord_length));
-            string y_c0_str = ConvertHexToDec(pub_shares_str.substr(pos0 + 2 * coord_length, coord_length));
-            string y_c1_str = ConvertHexToDec(pub_shares_str.substr(pos0 + 3 * coord_length, coord_length));
-            if (x_c0_str == "" || x_c1_str == "" || y_c0_str == "" || y_c1_str == "") {
-                ret = 2;
-                return ret;
-            }
-            pub_share.X.c0 = libff::alt_bn128_Fq(x_c0_str.c_str());
-            pub_share.X.c1 = libff::alt_bn128_Fq(x_c1_str.c_str());
-            pub_share.Y.c0 = libff::alt_bn128_Fq(y_c0_str.c_str());
-            pub_share.Y.c1 = libff::alt_bn128_Fq(y_c1_str.c_str());
-            pub_share.Z = libff::alt_bn128_Fq2::one();
-
-            if ( !isG2( pub_share ) ) {
-                ret = 3;
-                return ret;
-            }
-            pub_shares.push_back(pub_share);
+        ret = parsePublicShares(pub_shares_str, _t, pub_shares);
+        if (ret != 0) {
+            return ret;
         }
 
         libff::alt_bn128_G2 val = libff::alt_bn128_G2::zero();
@@ -526,7 +536,7 @@ int Verification(char *public_shares, mpz_t decr_secret_share, int _t, int ind)
 
         libff::alt_bn128_Fr sshare(tmp);
 
-        libff::alt_bn128_G2 val2 = sshare * libff::alt_bn128_G2::one();
+        libff::alt_bn128_G2 val2 = g2_fixed_base_mul(sshare);
 
         memset(public_shares, 0, strlen(public_shares));
         strncpy(public_shares, tmp, strlen(tmp));
@@ -538,7 +548,7 @@ int Verification(char *public_shares, mpz_t decr_secret_share, int _t, int ind)
         strncpy(public_shares + ConvertToString(val.X.c0).length() + 1, ConvertToString(val2.X.c0).c_str(),
                 ConvertToString(val2.X.c0).length());
 
-        ret = (val == sshare * libff::alt_bn128_G2::one());
+        ret = (val == val2);
 
     } catch (exception &e) {
         LOG_ERROR(e.what());
@@ -553,6 +563,59 @@ int Verification(char *public_shares, mpz_t decr_secret_share, int _t, int ind)
     return ret;
 }
 
+static void fqToLimbs(const libff::alt_bn128_Fq &_fq, uint64_t *_limbs) {
+    auto value = _fq.as_bigint();
+
+    for (int i = 0; i < BLS_FQ_LIMBS; i++) {
+        _limbs[i] = value.data[i];
+    }
+}
+
+int calc_share_g2_images(mpz_t *decr_secret_shares, uint64_t num_shares, const int *decrypted, uint64_t *images) {
+    int ret = 1;
+
+    CHECK_ARG_CLEAN(decr_secret_shares);
+    CHECK_ARG_CLEAN(decrypted);
+    CHECK_ARG_CLEAN(images);
+
+    try {
+        vector <libff::alt_bn128_G2> points(num_shares, libff::alt_bn128_G2::zero());
+
+        for (uint64_t i = 0; i < num_shares; i++) {
+            if (decrypted[i] != 1) {
+                continue;
+            }
+
+            SAFE_CHAR_BUF(arr, BUF_LEN);
+            libff::alt_bn128_Fr sshare(mpz_get_str(arr, 10, decr_secret_shares[i]));
+            memset(arr, 0, BUF_LEN);
+
+            points[i] = g2_fixed_base_mul(sshare);
+        }
+
+        for (auto &&point : points) {
+            point.to_affine_coordinates();
+        }
+
+        for (uint64_t i = 0; i < num_shares; i++) {
+            uint64_t *image = images + i * BLS_G2_LIMBS;
+            fqToLimbs(points[i].X.c0, image);
+            fqToLimbs(points[i].X.c1, image + BLS_FQ_LIMBS);
+            fqToLimbs(points[i].Y.c0, image + 2 * BLS_FQ_LIMBS);
+            fqToLimbs(points[i].Y.c1, image + 3 * BLS_FQ_LIMBS);
+        }
+
+        ret = 0;
+    } catch (exception &e) {
+        LOG_ERROR(e.what());
+    } catch (...) {
+        LOG_ERROR("Unknown throwable");
+    }
+
+    clean:
+    return ret;
+}
+
 int calc_bls_public_key(char *skey_hex, char *pub_key) {
     mpz_t skey;
     mpz_init(skey);
@@ -574,7 +637,7 @@ int calc_bls_public_key(char *skey_hex, char *pub_key) {
 
         libff::alt_bn128_Fr bls_skey(skey_dec);
 
-        libff::alt_bn128_G2 public_key = bls_skey * libff::alt_bn128_G2::one();
+        libff::alt_bn128_G2 public_key = g2_fixed_base_mul(bls_skey);
         public_key.to_affine_coordinates();
 
         string result = ConvertG2ToString(public_key);
@@ -49,6 +49,11 @@ EXTERNC int calc_public_shares(const char* decrypted_coeffs, char * public_share
 
 EXTERNC int Verification ( char * public_shares, mpz_t decr_secret_share, int _t, int ind);
 
+// writes s_i * G2 of every share as BLS_G2_LIMBS affine limbs, for the host to compare with the
+// commitments. Images of shares with decrypted[i] != 1 are not meaningful
+EXTERNC int calc_share_g2_images(mpz_t *decr_secret_shares, uint64_t num_shares, const int *decrypted,
+                                 uint64_t *images);
+
 EXTERNC int calc_bls_public_key(char* skey, char* pub_key);
 
 EXTERNC int calc_secret_shareG2(const char* s_share, char * s_shareG2);
@@ -0,0 +1,118 @@
+/*
+    Copyright (C) 2021-Present SKALE Labs
+
+    This file is part of sgxwallet.
+
+    sgxwallet is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as published
+    by the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    sgxwallet is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with sgxwallet.  If not, see <https://www.gnu.org/licenses/>.
+
+    @file Drbg.c
+    @author Stan Kladko
+    @date 2021
+*/
+
+
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <sgx_tcrypto.h>
+#include <sgx_trts.h>
+
+#include "EnclaveConstants.h"
+#include "Drbg.h"
+
+typedef struct {
+    sgx_aes_ctr_128bit_key_t key;
+    uint8_t counter[16];
+    uint8_t buffer[DRBG_BUFFER_SIZE];
+    uint64_t available;
+    uint64_t sinceReseed;
+    bool seeded;
+} drbg_state;
+
+static __thread drbg_state *state = NULL;
+
+static const uint8_t zeros[DRBG_BUFFER_SIZE];
+
+// mixes fresh entropy into key and counter, the old state is kept so a reseed never loses entropy
+static int drbg_reseed(drbg_state *_s) {
+    uint8_t seed[sizeof(_s->key) + sizeof(_s->counter)];
+
+    if (sgx_read_rand(seed, sizeof(seed)) != SGX_SUCCESS)
+        return -1;
+
+    for (uint64_t i = 0; i < sizeof(_s->key); i++)
+        _s->key[i] ^= seed[i];
+    for (uint64_t i = 0; i < sizeof(_s->counter); i++)
+        _s->counter[i] ^= seed[sizeof(_s->key) + i];
+
+    memset(seed, 0, sizeof(seed));
+    _s->sinceReseed = 0;
+    _s->seeded = true;
+    return 0;
+}
+
+static int drbg_refill(drbg_state *_s) {
+    if (!_s->seeded || _s->sinceReseed >= DRBG_RESEED_INTERVAL) {
+        if (drbg_reseed(_s) != 0)
+            return -1;
+    }
+
+    if (sgx_aes_ctr_encrypt((const sgx_aes_ctr_128bit_key_t *) &_s->key, zeros, DRBG_BUFFER_SIZE, _s->counter, 128,
+                            _s->buffer) != SGX_SUCCESS)
+        return -1;
+
+    sgx_aes_ctr_128bit_key_t nextKey;
+
+    if (sgx_aes_ctr_encrypt((const sgx_aes_ctr_128bit_key_t *) &_s->key, zeros, sizeof(nextKey), _s->counter, 128,
+                            nextKey) != SGX_SUCCESS) {
+        memset(_s->buffer, 0, DRBG_BUFFER_SIZE);
+        return -1;
+    }
+
+    memcpy(_s->key, nextKey, sizeof(nextKey));
+    memset(nextKey, 0, sizeof(nextKey));
+
+    _s->available = DRBG_BUFFER_SIZE;
+    _s->sinceReseed += DRBG_BUFFER_SIZE;
+    return 0;
+}
+
+int drbg_generate(uint8_t *_out, uint64_t _size) {
+    if (!_out)
+        return -1;
+
+    if (!state) {
+        state = (drbg_state *) calloc(1, sizeof(drbg_state));
+        if (!state)
+            return -1;
+    }
+
+    while (_size > 0) {
+        if (state->available == 0 && drbg_refill(state) != 0)
+            return -1;
+
+        uint64_t n = _size < state->available ? _size : state->available;
+        uint8_t *src = state->buffer + DRBG_BUFFER_SIZE - state->available;
+
+        memcpy(_out, src, n);
+        memset(src, 0, n);
+
+        state->available -= n;
+        _out += n;
+        _size -= n;
+    }
+
+    return 0;
+}
@@ -0,0 +1,41 @@
+/*
+    Copyright (C) 2021-Present SKALE Labs
+
+    This file is part of sgxwallet.
+
+    sgxwallet is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as published
+    by the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    sgxwallet is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with sgxwallet.  If not, see <https://www.gnu.org/licenses/>.
+
+    @file Drbg.h
+    @author Stan Kladko
+    @date 2021
+*/
+
+
+#ifndef SGXWALLET_DRBG_H
+#define SGXWALLET_DRBG_H
+
+#include <stdint.h>
+
+// Per thread AES-128 CTR DRBG. Like the scratch arena the state is thread local, so with
+// TCSPolicy 0 every TCS draws from its own generator and threads never share a cache line.
+//
+// The generator is seeded from sgx_read_rand on first use and reseeded every
+// DRBG_RESEED_INTERVAL output bytes. Output is generated DRBG_BUFFER_SIZE bytes at a time, and
+// the key is replaced by fresh keystream after each refill, so a later state leak does not
+// reveal earlier output. Handed out bytes are wiped from the buffer.
+
+// fills _out with _size random bytes, returns 0 on success and -1 if sgx_read_rand or AES failed
+int drbg_generate(uint8_t *_out, uint64_t _size);
+
+#endif //SGXWALLET_DRBG_H
@@ -29,18 +29,18 @@
 #include "../SCIPR/libff/algebra/curves/alt_bn128/alt_bn128_init.hpp"
 #include "../SCIPR/libff/algebra/curves/alt_bn128/alt_bn128_pp.hpp"
 
+#include "sgx_thread.h"
 #include "secure_enclave_t.h"
 
 #include "EnclaveConstants.h"
 #include "EnclaveCommon.h"
+#include "Point.h"
+#include "BN254Backend.h"
+#include "G2Mult.h"
 
-using namespace std;
-
-thread_local uint8_t decryptedDkgPoly[DKG_BUFER_LENGTH];
+#include "../HexCodec.h"
 
-uint8_t *getThreadLocalDecryptedDkgPoly() {
-    return decryptedDkgPoly;
-}
+using namespace std;
 
 
 string *stringFromKey(libff::alt_bn128_Fr *_key) {
@@ -193,96 +193,129 @@ void enclave_init() {
     LOG_INFO("Inited libff");
 }
 
-bool enclave_sign(const char *_keyString, const char *_hashXString, const char *_hashYString,
-                  char *sig) {
-
-    bool ret = false;
-
-    libff::alt_bn128_Fr* key = nullptr;
-    string * r = nullptr;
+void enclave_precompute() {
+    if (inited != 1) {
+        LOG_ERROR("enclave_precompute called before enclave_init");
+        return;
+    }
 
+    LOG_INFO("Precomputing curve generator table");
+    point_fixed_base_init(curve);
+    point_glv_init(curve);
+    bn254_backend_init();
+    g2_fixed_base_init();
+    LOG_INFO("Precomputed curve tables");
+    LOG_INFO((string("BN254 backend ") + bn254_backend_name()).c_str());
+}
 
+void *enclave_parse_bls_key(const char *_keyString) {
     if (!_keyString) {
         LOG_ERROR("Null key string");
-        goto clean;
+        return nullptr;
     }
 
-    if (!_hashXString) {
-        LOG_ERROR("Null hashX");
-        goto clean;
+    try {
+        return keyFromString(_keyString);
+    } catch (exception &e) {
+        LOG_ERROR(e.what());
+    } catch (...) {
+        LOG_ERROR("Unknown throwable");
     }
 
-    if (!_hashYString) {
-        LOG_ERROR("Null hashY");
-        goto clean;
+    return nullptr;
+}
+
+void enclave_free_bls_key(void *_key) {
+    auto key = (libff::alt_bn128_Fr *) _key;
+    SAFE_DELETE(key);
+}
+
+// rejects limbs that are not a canonical field element instead of silently reducing them
+static bool fqFromLimbs(const uint64_t *_limbs, libff::alt_bn128_Fq &_fq) {
+    libff::bigint<libff::alt_bn128_q_limbs> value;
+
+    for (int i = 0; i < BLS_FQ_LIMBS; i++) {
+        value.data[i] = _limbs[i];
     }
 
-    if (!sig) {
-        LOG_ERROR("Null sig");
-        goto clean;
+    if (mpn_cmp(value.data, libff::alt_bn128_modulus_q.data, libff::alt_bn128_q_limbs) >= 0) {
+        return false;
     }
 
-    try {
-        key = keyFromString(_keyString);
+    _fq = libff::alt_bn128_Fq(value);
+    return true;
+}
 
-        if (!key) {
-            LOG_ERROR("Null key");
-            goto clean;
-        }
+bool enclave_sign_with_key(void *_key, const uint64_t *_hash, uint64_t *_sig) {
+
+    static_assert(libff::alt_bn128_q_limbs == BLS_FQ_LIMBS && sizeof(mp_limb_t) == sizeof(uint64_t),
+                  "BLS_FQ_LIMBS has to match the alt_bn128 limb layout");
 
-        libff::alt_bn128_Fq hashX(_hashXString);
-        libff::alt_bn128_Fq hashY(_hashYString);
-        libff::alt_bn128_Fq hashZ = 1;
+    auto key = (libff::alt_bn128_Fr *) _key;
 
-        libff::alt_bn128_G1 hash(hashX, hashY, hashZ);
+    if (!key) {
+        LOG_ERROR("Null key");
+        return false;
+    }
 
-        libff::alt_bn128_G1 sign = key->as_bigint() * hash;
+    if (!_hash) {
+        LOG_ERROR("Null hash");
+        return false;
+    }
 
-        sign.to_affine_coordinates();
+    if (!_sig) {
+        LOG_ERROR("Null sig");
+        return false;
+    }
 
-        r = stringFromG1(&sign);
+    try {
+        libff::alt_bn128_Fq hashX, hashY;
 
-        memset(sig, 0, BUF_LEN);
+        if (!fqFromLimbs(_hash, hashX) || !fqFromLimbs(_hash + BLS_FQ_LIMBS, hashY)) {
+            LOG_ERROR("Hash coordinate is not a field element");
+            return false;
+        }
 
-        strncpy(sig, r->c_str(), BUF_LEN);
+        if (!bn254_g1_mul(*key, hashX, hashY, _sig)) {
+            LOG_ERROR("Could not multiply the hash point");
+            return false;
+        }
 
-        ret = true;
+        return true;
 
     } catch (exception &e) {
         LOG_ERROR(e.what());
-        goto clean;
     } catch (...) {
         LOG_ERROR("Unknown throwable");
-        goto clean;
     }
 
-    clean:
+    return false;
+}
+
+bool enclave_sign(const char *_keyString, const uint64_t *_hash, uint64_t *_sig) {
+
+    void *key = enclave_parse_bls_key(_keyString);
+
+    if (!key) {
+        LOG_ERROR("Null key");
+        return false;
+    }
+
+    bool ret = enclave_sign_with_key(key, _hash, _sig);
+
+    enclave_free_bls_key(key);
 
-    SAFE_DELETE(key);
-    SAFE_DELETE(r);
     return ret;
 }
 
 void carray2Hex(const unsigned char *d, int _len, char *_hexArray) {
-    char hexval[16] = {'0', '1', '2', '3', '4', '5', '6', '7',
-                       '8', '9', 'a', 'b', 'c', 'd', 'e', 'f'};
-
-    for (int j = 0; j < _len; j++) {
-        _hexArray[j * 2] = hexval[((d[j] >> 4) & 0xF)];
-        _hexArray[j * 2 + 1] = hexval[(d[j]) & 0x0F];
-    }
+    hexEncode(d, _len, _hexArray);
 
     _hexArray[_len * 2] = 0;
 }
 
 int char2int(char _input) {
-    if (_input >= '0' && _input <= '9')
-        return _input - '0';
-    if (_input >= 'A' && _input <= 'F')
-        return _input - 'A' + 10;
-    if (_input >= 'a' && _input <= 'f')
-        return _input - 'a' + 10;
-    return -1;
+    return hexDigitValue(_input);
 }
 
 bool hex2carray2(const char *_hex, uint64_t *_bin_len,
@@ -294,18 +327,7 @@ bool hex2carray2(const char *_hex, uint64_t *_bin_len,
 
     *_bin_len = len / 2;
 
-    for (int i = 0; i < len / 2; i++) {
-        int high = char2int((char) _hex[i * 2]);
-        int low = char2int((char) _hex[i * 2 + 1]);
-
-        if (high < 0 || low < 0) {
-            return false;
-        }
-
-        _bin[i] = (unsigned char) (high * 16 + low);
-    }
-
-    return true;
+    return hexDecode(_hex, len / 2, _bin);
 }
 
 bool hex2carray(const char *_hex, uint64_t *_bin_len,
@@ -317,18 +339,7 @@ bool hex2carray(const char *_hex, uint64_t *_bin_len,
 
     *_bin_len = len / 2;
 
-    for (int i = 0; i < len / 2; i++) {
-        int high = char2int((char) _hex[i * 2]);
-        int low = char2int((char) _hex[i * 2 + 1]);
-
-        if (high < 0 || low < 0) {
-            return false;
-        }
-
-        _bin[i] = (unsigned char) (high * 16 + low);
-    }
-
-    return true;
+    return hexDecode(_hex, len / 2, _bin);
 }
 
 enum log_level {
@@ -337,18 +348,64 @@ enum log_level {
 
 uint32_t globalLogLevel_ = 2;
 
+// Log lines are collected here and written with one OCALL when the buffer fills up, when a warning
+// or an error is logged, or when the host calls trustedFlushLog
+static char logBuffer[ENCLAVE_LOG_BUFFER_SIZE];
+static uint64_t logBufferLen = 0;
+static sgx_thread_mutex_t logMutex = SGX_THREAD_MUTEX_INITIALIZER;
+
+#define ENCLAVE_LOG_PREFIX "***ENCLAVE_LOG***:"
+
+static void flushLogLocked() {
+    if (logBufferLen == 0)
+        return;
+
+    logBuffer[logBufferLen] = 0;
+    oc_printf(logBuffer);
+    logBufferLen = 0;
+}
+
+void flushLog() {
+    sgx_thread_mutex_lock(&logMutex);
+    flushLogLocked();
+    sgx_thread_mutex_unlock(&logMutex);
+}
+
 void logMsg(log_level _level, const char *_msg) {
     if (_level < globalLogLevel_)
         return;
 
     if (!_msg) {
-        oc_printf("Null msg in logMsg");
-        return;
+        _msg = "Null msg in logMsg";
+    }
+
+    uint64_t prefixLen = sizeof(ENCLAVE_LOG_PREFIX) - 1;
+    uint64_t msgLen = strlen(_msg);
+    uint64_t lineLen = prefixLen + msgLen + 1;
+
+    sgx_thread_mutex_lock(&logMutex);
+
+    // keep one byte for the terminating zero
+    if (logBufferLen + lineLen >= ENCLAVE_LOG_BUFFER_SIZE) {
+        flushLogLocked();
+    }
+
+    if (lineLen >= ENCLAVE_LOG_BUFFER_SIZE) {
+        oc_printf(ENCLAVE_LOG_PREFIX);
+        oc_printf(_msg);
+        oc_printf("\n");
+    } else {
+        memcpy(logBuffer + logBufferLen, ENCLAVE_LOG_PREFIX, prefixLen);
+        memcpy(logBuffer + logBufferLen + prefixLen, _msg, msgLen);
+        logBuffer[logBufferLen + lineLen - 1] = '\n';
+        logBufferLen += lineLen;
+    }
+
+    if (_level >= L_WARNING) {
+        flushLogLocked();
     }
 
-    oc_printf("***ENCLAVE_LOG***:");
-    oc_printf(_msg);
-    oc_printf("\n");
+    sgx_thread_mutex_unlock(&logMutex);
 }
 
 
@@ -362,9 +419,11 @@ void LOG_WARN(const char *_msg) {
 void LOG_ERROR(const char *_msg) {
     logMsg(L_ERROR, _msg);
 };
+#ifndef NDEBUG
 void LOG_DEBUG(const char *_msg) {
     logMsg(L_DEBUG, _msg);
 };
 void LOG_TRACE(const char *_msg) {
     logMsg(L_TRACE, _msg);
 };
+#endif
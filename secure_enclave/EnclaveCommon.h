@@ -37,7 +37,15 @@
 
 EXTERNC void check_key(int *errStatus, char *err_string, const char* _keyString);
 
-EXTERNC bool enclave_sign(const char *_keyString, const char* _hashXString, const char* _hashYString, char* _sig);
+// _hash and _sig are BLS_G1_LIMBS limbs, see BLS_FQ_LIMBS
+EXTERNC bool enclave_sign(const char *_keyString, const uint64_t* _hash, uint64_t* _sig);
+
+// parses a hex BLS key once so that it can be used for many signatures, free with enclave_free_bls_key
+EXTERNC void* enclave_parse_bls_key(const char *_keyString);
+
+EXTERNC void enclave_free_bls_key(void* _key);
+
+EXTERNC bool enclave_sign_with_key(void* _key, const uint64_t* _hash, uint64_t* _sig);
 
 EXTERNC int char2int(char _input);
 
@@ -48,19 +56,28 @@ EXTERNC bool hex2carray2(const char * _hex, uint64_t  *_bin_len,
                          uint8_t* _bin, const int _max_length );
 EXTERNC void enclave_init();
 
-void get_global_random(unsigned char* _randBuff, uint64_t size);
+// builds the secp256k1 fixed base and GLV tables and the G2 generator table, ECDSA, DKG
+// and BLS public keys work without them but slower
+EXTERNC void enclave_precompute();
 
-EXTERNC uint8_t* getThreadLocalDecryptedDkgPoly();
+void get_global_random(unsigned char* _randBuff, uint64_t size);
 
 EXTERNC void LOG_INFO(const char* msg);
 EXTERNC void LOG_WARN(const char* _msg);
 EXTERNC void LOG_ERROR(const char* _msg);
+// release and prerelease builds define NDEBUG, there debug and trace lines are compiled out,
+// so the per ECALL trace lines cost nothing even at -v
+#ifdef NDEBUG
+#define LOG_DEBUG(__X__) ((void) 0)
+#define LOG_TRACE(__X__) ((void) 0)
+#else
 EXTERNC void LOG_DEBUG(const char* _msg);
 EXTERNC void LOG_TRACE(const char* _msg);
+#endif
 
-extern uint32_t globalLogLevel_;
+EXTERNC void flushLog();
 
-extern unsigned char* globalRandom;
+extern uint32_t globalLogLevel_;
 
 extern domain_parameters curve;
 
@@ -36,8 +36,13 @@
 
 #define ADD_ENTROPY_SIZE 32
 
-#define DKG_BUFER_LENGTH 2496//3060
-#define DKG_MAX_SEALED_LEN 3100
+// every DKG buffer is sized from the largest committee, keep in sync with sgxwallet_common.h
+// and secure_enclave.edl. A poly coefficient is at most 77 decimal digits and ':'
+#define MAX_DKG_N 128
+#define DKG_BUFER_LENGTH (MAX_DKG_N * 78 + 1)
+#define DKG_MAX_SEALED_LEN (DKG_BUFER_LENGTH + 128)
+// a verification vector coefficient is four decimal Fq, three ':' and ','
+#define DKG_PUBLIC_SHARES_LEN (MAX_DKG_N * 320 + 1)
 
 #define SECRET_SHARE_NUM_BYTES 96
 
@@ -48,6 +53,76 @@
 #define ECDSA_ENCR_LEN 93
 #define ECDSA_BIN_LEN 33
 
+#define MAX_BLS_SIGN_BATCH_SIZE 256
+#define BLS_BATCH_KEY_SLOT_LEN 256
+
+// G1 points and signatures cross the enclave boundary as affine X then Y,
+// each BLS_FQ_LIMBS little endian 64 bit limbs
+#define BLS_FQ_LIMBS 4
+#define BLS_G1_LIMBS 8
+#define BLS_G2_LIMBS 16
+
+// fixed slot sizes of the arrays passed to trustedGetEncryptedSecretSharesV2
+#define MAX_DKG_SHARES_BATCH_SIZE MAX_DKG_N
+#define DKG_BATCH_PUB_KEY_SLOT_LEN 129
+#define DKG_BATCH_SKEY_SLOT_LEN 256
+#define DKG_BATCH_SHARE_SLOT_LEN 193
+#define DKG_BATCH_SHARE_G2_SLOT_LEN 320
+
+// exact buffer sizes of the sign ECALLs, see secure_enclave.edl
+#define ERR_STRING_LEN 256
+#define ECDSA_PUB_KEY_COORD_LEN 65
+// r and s are returned as little endian 64 bit limbs
+#define ECDSA_SIG_LIMBS 4
+
+#define MAX_ECDSA_SIGN_BATCH_SIZE 256
+#define ECDSA_BATCH_HASH_SLOT_LEN 80
+
+// one signature of every ECDSA_SELF_CHECK_INTERVAL per thread is verified in the background, see signature_sample
+#define ECDSA_SELF_CHECK_INTERVAL 1000
+
+// fixed slot sizes of the arrays passed to trustedEncryptKeysBatch, keys are MAX_KEY_LENGTH slots
+#define MAX_KEY_IMPORT_BATCH_SIZE 256
+#define KEY_IMPORT_ENC_KEY_SLOT_LEN 256
+#define KEY_IMPORT_PUB_KEY_SLOT_LEN 129
+
+// trustedReencryptKeysBatch, a slot fits the largest sealed value, a DKG polynomial
+#define MAX_SEK_ROTATION_BATCH_SIZE 32
+#define SEK_ROTATION_SLOT_LEN DKG_MAX_SEALED_LEN
+
+// trustedGenDkgSecretBatch, one DKG_MAX_SEALED_LEN slot per poly and a commitments slot sized by t
+#define MAX_DKG_POLY_BATCH_SIZE 32
+#define DKG_PUBLIC_SHARES_SLOT_LEN(__T__) ((__T__) * 320 + 1)
+
+// trustedGenerateBLSKeyBatch, keys are sealed into BLS_BATCH_KEY_SLOT_LEN slots
+#define MAX_BLS_KEY_BATCH_SIZE 64
+#define BLS_KEY_BATCH_PUB_KEY_SLOT_LEN 320
+
+// precomputed ECDSA nonces, see signature_nonce_pool_refill
+#define NONCE_POOL_CAPACITY 1024
+#define NONCE_POOL_REFILL_BATCH 32
+
+// pregenerated ECDSA key pairs, see signature_key_pool_refill
+#define KEY_POOL_CAPACITY 256
+#define KEY_POOL_REFILL_BATCH 16
+
+// decrypted key cache, see KeyCache.h
+#define KEY_CACHE_SIZE 128
+#define KEY_CACHE_HEX_LEN 128
+#define KEY_CACHE_SKETCH_WIDTH 1024
+#define DKG_POLY_CACHE_SIZE 16
+#define MAX_DECRYPTION_SHARES_BATCH_SIZE 64
+
+// per TCS scratch arena for ECALL buffers, see ScratchArena.h
+#define SCRATCH_ARENA_SIZE 16384
+
+// per TCS random generator, see Drbg.h
+#define DRBG_BUFFER_SIZE 512
+#define DRBG_RESEED_INTERVAL (1 << 20)
+
+// enclave log lines are batched into one OCALL, see logMsg
+#define ENCLAVE_LOG_BUFFER_SIZE 4096
+
 #define UNKNOWN_ERROR -1
 #define PLAINTEXT_KEY_TOO_LONG -2
 #define UNPADDED_KEY -3
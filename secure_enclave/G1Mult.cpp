@@ -0,0 +1,316 @@
+/*
+    Copyright (C) 2021-Present SKALE Labs
+
+    This file is part of sgxwallet.
+
+    sgxwallet is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as published
+    by the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    sgxwallet is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with sgxwallet.  If not, see <https://www.gnu.org/licenses/>.
+
+    @file G1Mult.cpp
+    @author Stan Kladko
+    @date 2021
+*/
+
+#define GMP_WITH_SGX 1
+
+#include <string.h>
+#include <cstdint>
+
+#include "../SCIPR/libff/algebra/curves/alt_bn128/alt_bn128_init.hpp"
+#include "../SCIPR/libff/algebra/curves/alt_bn128/alt_bn128_pp.hpp"
+
+#include "EnclaveCommon.h"
+#include "G1Mult.h"
+
+using namespace std;
+
+typedef libff::alt_bn128_Fq Fq;
+typedef libff::alt_bn128_Fr Fr;
+typedef libff::bigint<libff::alt_bn128_r_limbs> ScalarBigint;
+
+// homogeneous projective coordinates, x = X / Z and y = Y / Z, zero is (0 : 1 : 0)
+struct G1Projective {
+    Fq X, Y, Z;
+};
+
+static const int WINDOW_BITS = 4;
+static const int TABLE_SIZE = 1 << WINDOW_BITS;
+// the halves of the split scalar have at most 126 bits
+static const int NUM_WINDOWS = 128 / WINDOW_BITS;
+
+// The GLV lattice basis is a1 = b2 = 9931322734385697763, b1 = -147946756881789319000765030803803410728 and
+// a2 = 147946756881789319010696353538189108491. These are round(2^384 * b2 / r) and round(2^384 * -b1 / r)
+static const mp_limb_t G1_LIMBS[4] = {0x8fa7d32d2fafba64ULL, 0x6eb9c714773a6ef2ULL, 0xd91d232ec7e0b3d7ULL,
+                                      0x0000000000000002ULL};
+static const mp_limb_t G2_LIMBS[5] = {0x869375169b9bdffaULL, 0xa5e38cfb5eaa26d9ULL, 0x7a7bd9d4391eb18dULL,
+                                      0x4ccef014a773d2cfULL, 0x0000000000000002ULL};
+
+static bool glvReady = false;
+static Fq glvBeta, curveB3;
+static Fr glvLambda, glvMinusB1, glvB2;
+static ScalarBigint halfR;
+static libff::bigint<libff::alt_bn128_q_limbs> qMinus2;
+
+// all ones if _a == _b, zero otherwise
+static inline uint64_t eqMask(uint64_t _a, uint64_t _b) {
+    uint64_t x = _a ^ _b;
+    return ((x | (0 - x)) >> 63) - 1;
+}
+
+static inline void fqSelect(Fq &_dst, const Fq &_src, uint64_t _mask) {
+    for (int i = 0; i < libff::alt_bn128_q_limbs; i++) {
+        _dst.mont_repr.data[i] ^= (_dst.mont_repr.data[i] ^ _src.mont_repr.data[i]) & _mask;
+    }
+}
+
+static inline void fqCondNegate(Fq &_a, uint64_t _mask) {
+    Fq minus = -_a;
+    fqSelect(_a, minus, _mask);
+}
+
+// complete addition for a = 0, algorithm 7 of Renes, Costello and Batina 2016
+static void g1Add(G1Projective &_r, const G1Projective &_p, const G1Projective &_q) {
+    Fq t0 = _p.X * _q.X;
+    Fq t1 = _p.Y * _q.Y;
+    Fq t2 = _p.Z * _q.Z;
+    Fq t3 = (_p.X + _p.Y) * (_q.X + _q.Y);
+    Fq t4 = t0 + t1;
+    t3 = t3 - t4;
+    t4 = (_p.Y + _p.Z) * (_q.Y + _q.Z);
+    Fq x3 = t1 + t2;
+    t4 = t4 - x3;
+    x3 = (_p.X + _p.Z) * (_q.X + _q.Z);
+    Fq y3 = t0 + t2;
+    y3 = x3 - y3;
+    x3 = t0 + t0;
+    t0 = x3 + t0;
+    t2 = curveB3 * t2;
+    Fq z3 = t1 + t2;
+    t1 = t1 - t2;
+    y3 = curveB3 * y3;
+    x3 = t4 * y3;
+    t2 = t3 * t1;
+    x3 = t2 - x3;
+    y3 = y3 * t0;
+    t1 = t1 * z3;
+    y3 = t1 + y3;
+    t0 = t0 * t3;
+    z3 = z3 * t4;
+    z3 = z3 + t0;
+
+    _r.X = x3;
+    _r.Y = y3;
+    _r.Z = z3;
+}
+
+// complete doubling for a = 0, algorithm 9 of Renes, Costello and Batina 2016
+static void g1Double(G1Projective &_r, const G1Projective &_p) {
+    Fq t0 = _p.Y.squared();
+    Fq z3 = t0 + t0;
+    z3 = z3 + z3;
+    z3 = z3 + z3;
+    Fq t1 = _p.Y * _p.Z;
+    Fq t2 = _p.Z.squared();
+    t2 = curveB3 * t2;
+    Fq x3 = t2 * z3;
+    Fq y3 = t0 + t2;
+    z3 = t1 * z3;
+    t1 = t2 + t2;
+    t2 = t1 + t2;
+    t0 = t0 - t2;
+    y3 = t0 * y3;
+    y3 = x3 + y3;
+    t1 = _p.X * _p.Y;
+    x3 = t0 * t1;
+    x3 = x3 + x3;
+
+    _r.X = x3;
+    _r.Y = y3;
+    _r.Z = z3;
+}
+
+// reads every entry, so the memory access does not depend on the digit
+static void tableSelect(G1Projective &_r, const G1Projective *_table, uint64_t _digit) {
+    _r.X = Fq::zero();
+    _r.Y = Fq::zero();
+    _r.Z = Fq::zero();
+
+    for (uint64_t j = 0; j < TABLE_SIZE; j++) {
+        uint64_t mask = eqMask(j, _digit);
+        for (int i = 0; i < libff::alt_bn128_q_limbs; i++) {
+            _r.X.mont_repr.data[i] |= _table[j].X.mont_repr.data[i] & mask;
+            _r.Y.mont_repr.data[i] |= _table[j].Y.mont_repr.data[i] & mask;
+            _r.Z.mont_repr.data[i] |= _table[j].Z.mont_repr.data[i] & mask;
+        }
+    }
+}
+
+// round(_k * _g / 2^384), the result has at most 128 bits
+static ScalarBigint roundedQuotient(const ScalarBigint &_k, const mp_limb_t *_g, mp_size_t _gLimbs) {
+    mp_limb_t product[9] = {0};
+
+    mpn_mul(product, _g, _gLimbs, _k.data, libff::alt_bn128_r_limbs);
+
+    // adding bit 383 rounds to nearest
+    uint64_t carry = product[5] >> 63;
+
+    ScalarBigint result;
+    for (int i = 0; i < libff::alt_bn128_r_limbs; i++) {
+        uint64_t limb = i < 3 ? product[6 + i] : 0;
+        result.data[i] = limb + carry;
+        carry = result.data[i] < carry;
+    }
+    return result;
+}
+
+// |_v| of the representative in (-r/2, r/2), _negative is all ones if _v is negative
+static ScalarBigint centered(const Fr &_v, uint64_t &_negative) {
+    ScalarBigint value = _v.as_bigint();
+    ScalarBigint minus, unused;
+
+    _negative = -(uint64_t) mpn_sub_n(unused.data, halfR.data, value.data, libff::alt_bn128_r_limbs);
+    mpn_sub_n(minus.data, libff::alt_bn128_modulus_r.data, value.data, libff::alt_bn128_r_limbs);
+
+    for (int i = 0; i < libff::alt_bn128_r_limbs; i++) {
+        value.data[i] ^= (value.data[i] ^ minus.data[i]) & _negative;
+    }
+    return value;
+}
+
+static inline uint64_t windowDigit(const ScalarBigint &_k, int _window) {
+    int bit = _window * WINDOW_BITS;
+    return (_k.data[bit / 64] >> (bit % 64)) & (TABLE_SIZE - 1);
+}
+
+static bool g1GlvMulUnchecked(const Fr &_k, const Fq &_x, const Fq &_y, Fq &_resultX, Fq &_resultY) {
+    // k = k1 + lambda * k2 with c1 = round(b2 * k / r), c2 = round(-b1 * k / r),
+    // k2 = -c1 * b1 - c2 * b2 and k1 = k - lambda * k2
+    ScalarBigint k = _k.as_bigint();
+    Fr c1(roundedQuotient(k, G1_LIMBS, 4));
+    Fr c2(roundedQuotient(k, G2_LIMBS, 5));
+
+    Fr k2 = c1 * glvMinusB1 - c2 * glvB2;
+    Fr k1 = _k - glvLambda * k2;
+
+    uint64_t negative1, negative2;
+    ScalarBigint m1 = centered(k1, negative1);
+    ScalarBigint m2 = centered(k2, negative2);
+
+    // cannot happen for a correct split, the windows cover 128 bits
+    if ((m1.data[2] | m1.data[3] | m2.data[2] | m2.data[3]) != 0) {
+        return false;
+    }
+
+    // table1[j] = j * (+-P), table2[j] = j * (+-phi(P)) = phi(table1[j]) with the sign fixed up
+    G1Projective table1[TABLE_SIZE], table2[TABLE_SIZE];
+
+    table1[0].X = Fq::zero();
+    table1[0].Y = Fq::one();
+    table1[0].Z = Fq::zero();
+    table1[1].X = _x;
+    table1[1].Y = _y;
+    table1[1].Z = Fq::one();
+    fqCondNegate(table1[1].Y, negative1);
+
+    for (int j = 2; j < TABLE_SIZE; j++) {
+        if (j % 2 == 0) {
+            g1Double(table1[j], table1[j / 2]);
+        } else {
+            g1Add(table1[j], table1[j - 1], table1[1]);
+        }
+    }
+
+    for (int j = 0; j < TABLE_SIZE; j++) {
+        table2[j].X = glvBeta * table1[j].X;
+        table2[j].Y = table1[j].Y;
+        table2[j].Z = table1[j].Z;
+        fqCondNegate(table2[j].Y, negative1 ^ negative2);
+    }
+
+    G1Projective r, entry;
+    r.X = Fq::zero();
+    r.Y = Fq::one();
+    r.Z = Fq::zero();
+
+    for (int i = NUM_WINDOWS - 1; i >= 0; i--) {
+        for (int d = 0; d < WINDOW_BITS; d++) {
+            g1Double(r, r);
+        }
+        tableSelect(entry, table1, windowDigit(m1, i));
+        g1Add(r, r, entry);
+        tableSelect(entry, table2, windowDigit(m2, i));
+        g1Add(r, r, entry);
+    }
+
+    if (r.Z.is_zero()) {
+        return false;
+    }
+
+    // Fermat inversion, its running time does not depend on Z
+    Fq zInv = r.Z ^ qMinus2;
+    _resultX = r.X * zInv;
+    _resultY = r.Y * zInv;
+
+    return true;
+}
+
+void g1_glv_init() {
+    if (__atomic_load_n(&glvReady, __ATOMIC_ACQUIRE)) {
+        return;
+    }
+
+    glvBeta = Fq("2203960485148121921418603742825762020974279258880205651966");
+    curveB3 = Fq(9);
+    glvLambda = Fr("4407920970296243842393367215006156084916469457145843978461");
+    glvMinusB1 = Fr("147946756881789319000765030803803410728");
+    glvB2 = Fr("9931322734385697763");
+    halfR = ScalarBigint("10944121435919637611123202872628637544274182200208017171849102093287904247808");
+    qMinus2 = libff::alt_bn128_modulus_q;
+    mpn_sub_1(qMinus2.data, qMinus2.data, libff::alt_bn128_q_limbs, 2);
+
+    // compares with libff on scalars that exercise both signs of the split halves
+    const char *scalars[] = {
+            "1",
+            "2",
+            "4407920970296243842393367215006156084916469457145843978461",
+            "10944121435919637611123202872628637544274182200208017171849102093287904247808",
+            "21888242871839275222246405745257275088548364400416034343698204186575808495616",
+            "15132376222941642752478938693096917590141230299350098404760990838043322372509"
+    };
+
+    auto g = libff::alt_bn128_G1::G1_one;
+    g.to_affine_coordinates();
+
+    for (auto &&s : scalars) {
+        Fr k(s);
+        Fq x, y;
+
+        auto expected = k.as_bigint() * g;
+        expected.to_affine_coordinates();
+
+        if (!g1GlvMulUnchecked(k, g.X, g.Y, x, y) || x != expected.X || y != expected.Y) {
+            LOG_ERROR("GLV G1 multiplication does not match libff, using libff for BLS signing");
+            return;
+        }
+    }
+
+    __atomic_store_n(&glvReady, true, __ATOMIC_RELEASE);
+}
+
+bool g1_glv_mul(const Fr &_k, const Fq &_x, const Fq &_y, Fq &_resultX, Fq &_resultY) {
+    if (!__atomic_load_n(&glvReady, __ATOMIC_ACQUIRE)) {
+        return false;
+    }
+
+    return g1GlvMulUnchecked(_k, _x, _y, _resultX, _resultY);
+}
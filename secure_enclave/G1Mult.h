@@ -0,0 +1,42 @@
+/*
+    Copyright (C) 2021-Present SKALE Labs
+
+    This file is part of sgxwallet.
+
+    sgxwallet is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as published
+    by the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    sgxwallet is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with sgxwallet.  If not, see <https://www.gnu.org/licenses/>.
+
+    @file G1Mult.h
+    @author Stan Kladko
+    @date 2021
+*/
+
+#ifndef SGXWALLET_G1MULT_H
+#define SGXWALLET_G1MULT_H
+
+#include "../SCIPR/libff/algebra/curves/alt_bn128/alt_bn128_pp.hpp"
+
+// Scalar multiplication on alt_bn128 G1 for BLS signing. The GLV endomorphism
+// (x, y) -> (beta * x, y) = lambda * P splits the scalar into two halves of at most 128 bits,
+// which are multiplied with a fixed 4 bit window and complete projective formulas.
+// Every scalar takes the same sequence of point operations and table reads, the field
+// operations are the ones of libff.
+
+// sets up the constants and checks the multiplier against libff, until then g1_glv_mul fails
+void g1_glv_init();
+
+// _k * (_x, _y) in affine coordinates, false if the multiplier is not ready or the result is zero
+bool g1_glv_mul(const libff::alt_bn128_Fr &_k, const libff::alt_bn128_Fq &_x, const libff::alt_bn128_Fq &_y,
+                libff::alt_bn128_Fq &_resultX, libff::alt_bn128_Fq &_resultY);
+
+#endif //SGXWALLET_G1MULT_H
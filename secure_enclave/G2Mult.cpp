@@ -0,0 +1,213 @@
+/*
+    Copyright (C) 2021-Present SKALE Labs
+
+    This file is part of sgxwallet.
+
+    sgxwallet is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as published
+    by the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    sgxwallet is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with sgxwallet.  If not, see <https://www.gnu.org/licenses/>.
+
+    @file G2Mult.cpp
+    @author Stan Kladko
+    @date 2021
+*/
+
+#define GMP_WITH_SGX 1
+
+#include <string.h>
+#include <cstdint>
+
+#include "../SCIPR/libff/algebra/curves/alt_bn128/alt_bn128_init.hpp"
+#include "../SCIPR/libff/algebra/curves/alt_bn128/alt_bn128_pp.hpp"
+
+#include "sgx_thread.h"
+
+#include "EnclaveCommon.h"
+#include "G2Mult.h"
+
+using namespace std;
+
+typedef libff::alt_bn128_Fq2 Fq2;
+typedef libff::alt_bn128_Fr Fr;
+typedef libff::bigint<libff::alt_bn128_r_limbs> ScalarBigint;
+
+// homogeneous projective coordinates, x = X / Z and y = Y / Z, zero is (0 : 1 : 0)
+struct G2Projective {
+    Fq2 X, Y, Z;
+};
+
+static const int WINDOW_BITS = 4;
+static const int TABLE_SIZE = 1 << WINDOW_BITS;
+static const int NUM_WINDOWS = libff::alt_bn128_r_limbs * 64 / WINDOW_BITS;
+
+// set with release order once the table is complete, multiplications read it with acquire
+static bool tableReady = false;
+// held while the table is built, so concurrent inits do not write it at the same time
+static sgx_thread_mutex_t tableMutex = SGX_THREAD_MUTEX_INITIALIZER;
+// table[i * TABLE_SIZE + j] = j * 16^i * G2
+static G2Projective *table = nullptr;
+static Fq2 twistB3;
+
+// all ones if _a == _b, zero otherwise
+static inline uint64_t eqMask(uint64_t _a, uint64_t _b) {
+    uint64_t x = _a ^ _b;
+    return ((x | (0 - x)) >> 63) - 1;
+}
+
+// complete addition for a = 0, algorithm 7 of Renes, Costello and Batina 2016 on the twist
+static void g2Add(G2Projective &_r, const G2Projective &_p, const G2Projective &_q) {
+    Fq2 t0 = _p.X * _q.X;
+    Fq2 t1 = _p.Y * _q.Y;
+    Fq2 t2 = _p.Z * _q.Z;
+    Fq2 t3 = (_p.X + _p.Y) * (_q.X + _q.Y);
+    Fq2 t4 = t0 + t1;
+    t3 = t3 - t4;
+    t4 = (_p.Y + _p.Z) * (_q.Y + _q.Z);
+    Fq2 x3 = t1 + t2;
+    t4 = t4 - x3;
+    x3 = (_p.X + _p.Z) * (_q.X + _q.Z);
+    Fq2 y3 = t0 + t2;
+    y3 = x3 - y3;
+    x3 = t0 + t0;
+    t0 = x3 + t0;
+    t2 = twistB3 * t2;
+    Fq2 z3 = t1 + t2;
+    t1 = t1 - t2;
+    y3 = twistB3 * y3;
+    x3 = t4 * y3;
+    t2 = t3 * t1;
+    x3 = t2 - x3;
+    y3 = y3 * t0;
+    t1 = t1 * z3;
+    y3 = t1 + y3;
+    t0 = t0 * t3;
+    z3 = z3 * t4;
+    z3 = z3 + t0;
+
+    _r.X = x3;
+    _r.Y = y3;
+    _r.Z = z3;
+}
+
+static inline void fqOr(libff::alt_bn128_Fq &_dst, const libff::alt_bn128_Fq &_src, uint64_t _mask) {
+    for (int i = 0; i < libff::alt_bn128_q_limbs; i++) {
+        _dst.mont_repr.data[i] |= _src.mont_repr.data[i] & _mask;
+    }
+}
+
+// reads every entry of the window, so the memory access does not depend on the digit
+static void tableSelect(G2Projective &_r, const G2Projective *_window, uint64_t _digit) {
+    _r.X = Fq2::zero();
+    _r.Y = Fq2::zero();
+    _r.Z = Fq2::zero();
+
+    for (uint64_t j = 0; j < TABLE_SIZE; j++) {
+        uint64_t mask = eqMask(j, _digit);
+        fqOr(_r.X.c0, _window[j].X.c0, mask);
+        fqOr(_r.X.c1, _window[j].X.c1, mask);
+        fqOr(_r.Y.c0, _window[j].Y.c0, mask);
+        fqOr(_r.Y.c1, _window[j].Y.c1, mask);
+        fqOr(_r.Z.c0, _window[j].Z.c0, mask);
+        fqOr(_r.Z.c1, _window[j].Z.c1, mask);
+    }
+}
+
+static libff::alt_bn128_G2 g2FixedBaseMulUnchecked(const Fr &_k) {
+    ScalarBigint k = _k.as_bigint();
+
+    G2Projective r, entry;
+    r.X = Fq2::zero();
+    r.Y = Fq2::one();
+    r.Z = Fq2::zero();
+
+    for (int i = 0; i < NUM_WINDOWS; i++) {
+        int bit = i * WINDOW_BITS;
+        tableSelect(entry, table + i * TABLE_SIZE, (k.data[bit / 64] >> (bit % 64)) & (TABLE_SIZE - 1));
+        g2Add(r, r, entry);
+    }
+
+    // (X : Y : Z) is (X * Z, Y * Z^2, Z) in Jacobian coordinates, no inversion needed
+    return libff::alt_bn128_G2(r.X * r.Z, r.Y * r.Z.squared(), r.Z);
+}
+
+// builds the table and checks it against libff, false if it does not match
+static bool buildTable() {
+    twistB3 = libff::alt_bn128_Fq(3) * libff::alt_bn128_twist_coeff_b;
+
+    if (!table) {
+        table = new G2Projective[NUM_WINDOWS * TABLE_SIZE];
+    }
+
+    auto base = libff::alt_bn128_G2::one();
+
+    for (int i = 0; i < NUM_WINDOWS; i++) {
+        base.to_affine_coordinates();
+
+        G2Projective *window = table + i * TABLE_SIZE;
+        window[0].X = Fq2::zero();
+        window[0].Y = Fq2::one();
+        window[0].Z = Fq2::zero();
+        window[1].X = base.X;
+        window[1].Y = base.Y;
+        window[1].Z = Fq2::one();
+
+        for (int j = 2; j < TABLE_SIZE; j++) {
+            g2Add(window[j], window[j - 1], window[1]);
+        }
+
+        for (int d = 0; d < WINDOW_BITS; d++) {
+            base = base.dbl();
+        }
+    }
+
+    // compares with libff, including scalars with a zero and a full top window
+    const char *scalars[] = {
+            "0",
+            "1",
+            "16",
+            "12345678901234567890",
+            "10944121435919637611123202872628637544274182200208017171849102093287904247808",
+            "21888242871839275222246405745257275088548364400416034343698204186575808495616"
+    };
+
+    for (auto &&s : scalars) {
+        Fr k(s);
+        if (g2FixedBaseMulUnchecked(k) != k * libff::alt_bn128_G2::one()) {
+            LOG_ERROR("G2 fixed base table does not match libff, using libff for G2 multiplication");
+            return false;
+        }
+    }
+
+    return true;
+}
+
+void g2_fixed_base_init() {
+    if (__atomic_load_n(&tableReady, __ATOMIC_ACQUIRE)) {
+        return;
+    }
+
+    sgx_thread_mutex_lock(&tableMutex);
+
+    if (!__atomic_load_n(&tableReady, __ATOMIC_ACQUIRE) && buildTable()) {
+        __atomic_store_n(&tableReady, true, __ATOMIC_RELEASE);
+    }
+
+    sgx_thread_mutex_unlock(&tableMutex);
+}
+
+libff::alt_bn128_G2 g2_fixed_base_mul(const Fr &_k) {
+    if (!__atomic_load_n(&tableReady, __ATOMIC_ACQUIRE)) {
+        return _k * libff::alt_bn128_G2::one();
+    }
+
+    return g2FixedBaseMulUnchecked(_k);
+}
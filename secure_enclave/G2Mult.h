@@ -0,0 +1,41 @@
+/*
+    Copyright (C) 2021-Present SKALE Labs
+
+    This file is part of sgxwallet.
+
+    sgxwallet is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as published
+    by the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    sgxwallet is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with sgxwallet.  If not, see <https://www.gnu.org/licenses/>.
+
+    @file G2Mult.h
+    @author Stan Kladko
+    @date 2021
+*/
+
+#ifndef SGXWALLET_G2MULT_H
+#define SGXWALLET_G2MULT_H
+
+#include "../SCIPR/libff/algebra/curves/alt_bn128/alt_bn128_pp.hpp"
+#include "../SCIPR/libff/algebra/curves/alt_bn128/alt_bn128_g2.hpp"
+
+// Multiplication of the alt_bn128 G2 generator for BLS public keys and DKG shares. A table of
+// j * 16^i * G2 for each 4 bit window i turns a product into 64 complete projective additions
+// without doublings. Every scalar reads every table entry, the field operations are the ones
+// of libff.
+
+// builds the table and checks it against libff, until then g2_fixed_base_mul uses libff
+void g2_fixed_base_init();
+
+// _k * G2 generator in the Jacobian coordinates of libff
+libff::alt_bn128_G2 g2_fixed_base_mul(const libff::alt_bn128_Fr &_k);
+
+#endif //SGXWALLET_G2MULT_H
@@ -0,0 +1,359 @@
+/*
+    Copyright (C) 2021-Present SKALE Labs
+
+    This file is part of sgxwallet.
+
+    sgxwallet is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as published
+    by the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    sgxwallet is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with sgxwallet.  If not, see <https://www.gnu.org/licenses/>.
+
+    @file KeyCache.cpp
+    @author Stan Kladko
+    @date 2021
+*/
+
+#define GMP_WITH_SGX 1
+
+#include <string.h>
+#include <cstdint>
+
+#include "../SCIPR/libff/algebra/curves/alt_bn128/alt_bn128_init.hpp"
+
+#include "sgx_tcrypto.h"
+#include "sgx_thread.h"
+
+#include "../FrequencySketch.h"
+
+#include "EnclaveConstants.h"
+#include "EnclaveCommon.h"
+#include "KeyCache.h"
+
+using namespace std;
+
+enum KeyCacheType {
+    KEY_CACHE_EMPTY = 0, KEY_CACHE_BLS, KEY_CACHE_ECDSA, KEY_CACHE_HEX
+};
+
+typedef struct {
+    uint8_t type;
+    sgx_sha256_hash_t digest;
+    uint64_t lastUsed;
+    libff::alt_bn128_Fr *blsKey;
+    mpz_t ecdsaKey;
+    char hexKey[KEY_CACHE_HEX_LEN];
+} KeyCacheEntry;
+
+typedef struct {
+    bool used;
+    sgx_sha256_hash_t digest;
+    uint64_t lastUsed;
+    char poly[DKG_BUFER_LENGTH];
+} PolyCacheEntry;
+
+static KeyCacheEntry entries[KEY_CACHE_SIZE];
+
+static PolyCacheEntry polyEntries[DKG_POLY_CACHE_SIZE];
+
+static uint64_t useCounter = 0;
+
+// lookups of all key types, a full cache admits a key only if it is looked up more often than the victim
+static FrequencySketch<KEY_CACHE_SKETCH_WIDTH> keyFrequencies;
+
+static sgx_thread_mutex_t cacheMutex = SGX_THREAD_MUTEX_INITIALIZER;
+
+static bool digestOf(const uint8_t *_encryptedKey, uint64_t _encLen, sgx_sha256_hash_t *_digest) {
+    if (!_encryptedKey || _encLen == 0 || _encLen > UINT32_MAX)
+        return false;
+    return sgx_sha256_msg(_encryptedKey, (uint32_t) _encLen, _digest) == SGX_SUCCESS;
+}
+
+static uint64_t sketchHash(const sgx_sha256_hash_t *_digest) {
+    uint64_t result;
+    memcpy(&result, *_digest, sizeof(result));
+    return result;
+}
+
+static void wipeEntry(KeyCacheEntry *_entry) {
+    if (_entry->blsKey) {
+        memset((void *) _entry->blsKey, 0, sizeof(libff::alt_bn128_Fr));
+        SAFE_DELETE(_entry->blsKey);
+    }
+
+    if (_entry->type == KEY_CACHE_ECDSA) {
+        if (_entry->ecdsaKey->_mp_d)
+            memset(_entry->ecdsaKey->_mp_d, 0, _entry->ecdsaKey->_mp_alloc * sizeof(mp_limb_t));
+        mpz_clear(_entry->ecdsaKey);
+    }
+
+    memset(_entry->hexKey, 0, KEY_CACHE_HEX_LEN);
+    memset(_entry->digest, 0, sizeof(sgx_sha256_hash_t));
+    _entry->lastUsed = 0;
+    _entry->type = KEY_CACHE_EMPTY;
+}
+
+// must be called with cacheMutex held
+static KeyCacheEntry *findEntry(uint8_t _type, const sgx_sha256_hash_t *_digest) {
+    for (int i = 0; i < KEY_CACHE_SIZE; i++) {
+        if (entries[i].type == _type && memcmp(entries[i].digest, *_digest, sizeof(sgx_sha256_hash_t)) == 0) {
+            entries[i].lastUsed = ++useCounter;
+            return &entries[i];
+        }
+    }
+    return nullptr;
+}
+
+// must be called with cacheMutex held, evicts the least recently used entry if the cache is full.
+// Returns nullptr if the cache is full and the key is looked up less often than that entry
+static KeyCacheEntry *newEntry(uint8_t _type, const sgx_sha256_hash_t *_digest) {
+    KeyCacheEntry *victim = findEntry(_type, _digest);
+
+    if (!victim) {
+        // empty entries have lastUsed == 0 so they are picked first
+        victim = &entries[0];
+        for (int i = 1; i < KEY_CACHE_SIZE; i++) {
+            if (entries[i].lastUsed < victim->lastUsed) {
+                victim = &entries[i];
+            }
+        }
+
+        if (victim->type != KEY_CACHE_EMPTY &&
+            !keyFrequencies.admit(sketchHash(_digest), sketchHash(&victim->digest))) {
+            return nullptr;
+        }
+    }
+
+    wipeEntry(victim);
+
+    victim->type = _type;
+    memcpy(victim->digest, *_digest, sizeof(sgx_sha256_hash_t));
+    victim->lastUsed = ++useCounter;
+
+    return victim;
+}
+
+static void wipePolyEntry(PolyCacheEntry *_entry) {
+    memset(_entry->poly, 0, DKG_BUFER_LENGTH);
+    memset(_entry->digest, 0, sizeof(sgx_sha256_hash_t));
+    _entry->lastUsed = 0;
+    _entry->used = false;
+}
+
+// must be called with cacheMutex held
+static PolyCacheEntry *findPolyEntry(const sgx_sha256_hash_t *_digest) {
+    for (int i = 0; i < DKG_POLY_CACHE_SIZE; i++) {
+        if (polyEntries[i].used && memcmp(polyEntries[i].digest, *_digest, sizeof(sgx_sha256_hash_t)) == 0) {
+            polyEntries[i].lastUsed = ++useCounter;
+            return &polyEntries[i];
+        }
+    }
+    return nullptr;
+}
+
+void key_cache_clear() {
+    sgx_thread_mutex_lock(&cacheMutex);
+    for (int i = 0; i < KEY_CACHE_SIZE; i++) {
+        wipeEntry(&entries[i]);
+    }
+    for (int i = 0; i < DKG_POLY_CACHE_SIZE; i++) {
+        wipePolyEntry(&polyEntries[i]);
+    }
+    useCounter = 0;
+    keyFrequencies.clear();
+    sgx_thread_mutex_unlock(&cacheMutex);
+}
+
+void *key_cache_get_bls(const uint8_t *_encryptedKey, uint64_t _encLen) {
+    sgx_sha256_hash_t digest;
+
+    if (!digestOf(_encryptedKey, _encLen, &digest))
+        return nullptr;
+
+    libff::alt_bn128_Fr *ret = nullptr;
+
+    sgx_thread_mutex_lock(&cacheMutex);
+
+    keyFrequencies.increment(sketchHash(&digest));
+    auto entry = findEntry(KEY_CACHE_BLS, &digest);
+
+    if (entry) {
+        try {
+            ret = new libff::alt_bn128_Fr(*entry->blsKey);
+        } catch (...) {
+            LOG_ERROR("Could not copy cached BLS key");
+        }
+    }
+
+    sgx_thread_mutex_unlock(&cacheMutex);
+
+    return ret;
+}
+
+void key_cache_put_bls(const uint8_t *_encryptedKey, uint64_t _encLen, const void *_key) {
+    sgx_sha256_hash_t digest;
+
+    if (!_key || !digestOf(_encryptedKey, _encLen, &digest))
+        return;
+
+    sgx_thread_mutex_lock(&cacheMutex);
+
+    auto entry = newEntry(KEY_CACHE_BLS, &digest);
+
+    if (entry) {
+        try {
+            entry->blsKey = new libff::alt_bn128_Fr(*(const libff::alt_bn128_Fr *) _key);
+        } catch (...) {
+            LOG_ERROR("Could not cache BLS key");
+            wipeEntry(entry);
+        }
+    }
+
+    sgx_thread_mutex_unlock(&cacheMutex);
+}
+
+bool key_cache_get_ecdsa(const uint8_t *_encryptedKey, uint64_t _encLen, mpz_t _key) {
+    sgx_sha256_hash_t digest;
+
+    if (!digestOf(_encryptedKey, _encLen, &digest))
+        return false;
+
+    sgx_thread_mutex_lock(&cacheMutex);
+
+    keyFrequencies.increment(sketchHash(&digest));
+    auto entry = findEntry(KEY_CACHE_ECDSA, &digest);
+
+    if (entry) {
+        mpz_set(_key, entry->ecdsaKey);
+    }
+
+    sgx_thread_mutex_unlock(&cacheMutex);
+
+    return entry != nullptr;
+}
+
+void key_cache_put_ecdsa(const uint8_t *_encryptedKey, uint64_t _encLen, mpz_t _key) {
+    sgx_sha256_hash_t digest;
+
+    if (!digestOf(_encryptedKey, _encLen, &digest))
+        return;
+
+    sgx_thread_mutex_lock(&cacheMutex);
+
+    auto entry = newEntry(KEY_CACHE_ECDSA, &digest);
+    if (entry) {
+        mpz_init_set(entry->ecdsaKey, _key);
+    }
+
+    sgx_thread_mutex_unlock(&cacheMutex);
+}
+
+bool key_cache_get_hex(const uint8_t *_encryptedKey, uint64_t _encLen, char *_keyHex) {
+    sgx_sha256_hash_t digest;
+
+    if (!_keyHex || !digestOf(_encryptedKey, _encLen, &digest))
+        return false;
+
+    sgx_thread_mutex_lock(&cacheMutex);
+
+    keyFrequencies.increment(sketchHash(&digest));
+    auto entry = findEntry(KEY_CACHE_HEX, &digest);
+
+    if (entry) {
+        memcpy(_keyHex, entry->hexKey, KEY_CACHE_HEX_LEN);
+    }
+
+    sgx_thread_mutex_unlock(&cacheMutex);
+
+    return entry != nullptr;
+}
+
+void key_cache_put_hex(const uint8_t *_encryptedKey, uint64_t _encLen, const char *_keyHex) {
+    sgx_sha256_hash_t digest;
+
+    if (!_keyHex || strnlen(_keyHex, KEY_CACHE_HEX_LEN) >= KEY_CACHE_HEX_LEN ||
+        !digestOf(_encryptedKey, _encLen, &digest))
+        return;
+
+    sgx_thread_mutex_lock(&cacheMutex);
+
+    auto entry = newEntry(KEY_CACHE_HEX, &digest);
+    if (entry) {
+        strncpy(entry->hexKey, _keyHex, KEY_CACHE_HEX_LEN);
+    }
+
+    sgx_thread_mutex_unlock(&cacheMutex);
+}
+
+bool poly_cache_get(const uint8_t *_encryptedPoly, uint64_t _encLen, char *_poly) {
+    sgx_sha256_hash_t digest;
+
+    if (!_poly || !digestOf(_encryptedPoly, _encLen, &digest))
+        return false;
+
+    sgx_thread_mutex_lock(&cacheMutex);
+
+    auto entry = findPolyEntry(&digest);
+
+    if (entry) {
+        memcpy(_poly, entry->poly, DKG_BUFER_LENGTH);
+    }
+
+    sgx_thread_mutex_unlock(&cacheMutex);
+
+    return entry != nullptr;
+}
+
+void poly_cache_put(const uint8_t *_encryptedPoly, uint64_t _encLen, const char *_poly) {
+    sgx_sha256_hash_t digest;
+
+    if (!_poly || !digestOf(_encryptedPoly, _encLen, &digest))
+        return;
+
+    sgx_thread_mutex_lock(&cacheMutex);
+
+    auto victim = findPolyEntry(&digest);
+
+    if (!victim) {
+        // unused entries have lastUsed == 0 so they are picked first
+        victim = &polyEntries[0];
+        for (int i = 1; i < DKG_POLY_CACHE_SIZE; i++) {
+            if (polyEntries[i].lastUsed < victim->lastUsed) {
+                victim = &polyEntries[i];
+            }
+        }
+    }
+
+    wipePolyEntry(victim);
+
+    victim->used = true;
+    memcpy(victim->digest, digest, sizeof(sgx_sha256_hash_t));
+    memcpy(victim->poly, _poly, DKG_BUFER_LENGTH);
+    victim->lastUsed = ++useCounter;
+
+    sgx_thread_mutex_unlock(&cacheMutex);
+}
+
+void poly_cache_erase(const uint8_t *_encryptedPoly, uint64_t _encLen) {
+    sgx_sha256_hash_t digest;
+
+    if (!digestOf(_encryptedPoly, _encLen, &digest))
+        return;
+
+    sgx_thread_mutex_lock(&cacheMutex);
+
+    auto entry = findPolyEntry(&digest);
+
+    if (entry) {
+        wipePolyEntry(entry);
+    }
+
+    sgx_thread_mutex_unlock(&cacheMutex);
+}
@@ -0,0 +1,67 @@
+/*
+    Copyright (C) 2021-Present SKALE Labs
+
+    This file is part of sgxwallet.
+
+    sgxwallet is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as published
+    by the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    sgxwallet is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with sgxwallet.  If not, see <https://www.gnu.org/licenses/>.
+
+    @file KeyCache.h
+    @author Stan Kladko
+    @date 2021
+*/
+
+#ifndef SGXWALLET_KEYCACHE_H
+#define SGXWALLET_KEYCACHE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <sgx_tgmp.h>
+
+#ifdef __cplusplus
+#define EXTERNC extern "C"
+#else
+#define EXTERNC
+#endif
+
+// Decrypted keys indexed by the sha256 of their AES-GCM ciphertext.
+// All entries are zeroized on eviction and on key_cache_clear,
+// which has to be called whenever the SEK changes.
+// A full cache evicts the least recently used key, but only for a key
+// that was looked up more often, see FrequencySketch.h.
+
+EXTERNC void key_cache_clear();
+
+// returns a copy of the cached BLS key (free with enclave_free_bls_key) or NULL on a miss
+EXTERNC void* key_cache_get_bls(const uint8_t* _encryptedKey, uint64_t _encLen);
+
+EXTERNC void key_cache_put_bls(const uint8_t* _encryptedKey, uint64_t _encLen, const void* _key);
+
+EXTERNC bool key_cache_get_ecdsa(const uint8_t* _encryptedKey, uint64_t _encLen, mpz_t _key);
+
+EXTERNC void key_cache_put_ecdsa(const uint8_t* _encryptedKey, uint64_t _encLen, mpz_t _key);
+
+// plaintext hex keys, _keyHex has to hold at least KEY_CACHE_HEX_LEN bytes
+EXTERNC bool key_cache_get_hex(const uint8_t* _encryptedKey, uint64_t _encLen, char* _keyHex);
+
+EXTERNC void key_cache_put_hex(const uint8_t* _encryptedKey, uint64_t _encLen, const char* _keyHex);
+
+// decrypted DKG polynomials of DKG_BUFER_LENGTH bytes, indexed the same way. An entry lives
+// until poly_cache_erase, which the host calls once the BLS key of the DKG is created
+EXTERNC bool poly_cache_get(const uint8_t* _encryptedPoly, uint64_t _encLen, char* _poly);
+
+EXTERNC void poly_cache_put(const uint8_t* _encryptedPoly, uint64_t _encLen, const char* _poly);
+
+EXTERNC void poly_cache_erase(const uint8_t* _encryptedPoly, uint64_t _encLen);
+
+#endif //SGXWALLET_KEYCACHE_H
@@ -26,6 +26,7 @@
 #include <string.h>
 #include <assert.h>
 #include <stdbool.h>
+#include <stdint.h>
 
 #define SAFE_FREE(__X__) if (__X__) {free(__X__); __X__ = NULL;}
 #define SAFE_DELETE(__X__) if (__X__) {delete(__X__); __X__ = NULL;}
@@ -38,6 +39,7 @@
 #endif
 
 #include "NumberTheory.h"
+#include "Secp256k1Field.h"
 
 #include "DomainParameters.h"
 #include "Point.h"
@@ -102,6 +104,121 @@ void point_copy(point R, point P)
 	point_set(R, P);
 }
 
+/*
+Jacobian coordinates (X, Y, Z) represent the affine point (X/Z², Y/Z³). Doubling and
+adding a point in affine coordinates to a jacobian point need no modular inversion,
+so scalar multiplication only does one, when the result is converted back to affine.
+*/
+typedef struct jacobian_point_s
+{
+	mpz_t X;
+	mpz_t Y;
+	mpz_t Z;
+	bool infinity;
+	mpz_t t1, t2, t3, t4, t5, t6;
+} jacobian_point;
+
+#define MAX_MULTI_SCALARS 4
+#define WNAF_MAX_LEN (POINT_WORKSPACE_BITS + 2)
+
+/*The same in the fixed limb secp256k1 field, see Secp256k1Field.h*/
+typedef struct field_jacobian_s
+{
+	field_element X;
+	field_element Y;
+	field_element Z;
+	bool infinity;
+} field_jacobian;
+
+typedef struct field_affine_s
+{
+	field_element x;
+	field_element y;
+	bool infinity;
+} field_affine;
+
+#define FIELD_TABLE_SIZE (MAX_MULTI_SCALARS * WNAF_TABLE_SIZE)
+
+/*
+Scratch variables of the point arithmetic, one set per thread. They are initialized with
+POINT_WORKSPACE_BITS of limbs on first use and never released, so that point operations do not
+go through the GMP allocation hooks, and so the enclave heap, on every call. Each function below
+uses its own members, so that functions calling each other never share a variable.
+*/
+typedef struct point_workspace_s
+{
+	bool ready;
+	//point_addition
+	mpz_t add_s, add_t1, add_t2, add_t3, add_t4, add_t5;
+	point add_iQ;
+	//point_doubling
+	mpz_t dbl_s, dbl_t1, dbl_t2, dbl_t3, dbl_t4, dbl_t5;
+	//scalar multiplications
+	jacobian_point J;
+	point x, twice, neg, lambdaP, lambdaQ;
+	point table[MAX_MULTI_SCALARS][WNAF_TABLE_SIZE];
+	int8_t naf[MAX_MULTI_SCALARS][WNAF_MAX_LEN];
+	mpz_t k, scalars[MAX_MULTI_SCALARS];
+	//glv_split
+	mpz_t glv_k, glv_c1, glv_c2;
+	//secp256k1 field multiplications, the table of scalar i starts at i * WNAF_TABLE_SIZE
+	field_jacobian field_J;
+	field_jacobian field_jtwice[MAX_MULTI_SCALARS];
+	field_affine field_twice[MAX_MULTI_SCALARS];
+	field_jacobian field_jtable[FIELD_TABLE_SIZE];
+	field_affine field_table[FIELD_TABLE_SIZE];
+	field_element field_prefix[FIELD_TABLE_SIZE];
+} point_workspace;
+
+static __thread point_workspace workspace;
+
+static void workspace_mpz_init(mpz_t v)
+{
+	mpz_init2(v, POINT_WORKSPACE_BITS);
+}
+
+static point workspace_point_init()
+{
+	point p = point_init();
+	mpz_realloc2(p->x, POINT_WORKSPACE_BITS);
+	mpz_realloc2(p->y, POINT_WORKSPACE_BITS);
+	return p;
+}
+
+static point_workspace* get_workspace()
+{
+	point_workspace* w = &workspace;
+	if(w->ready)
+		return w;
+
+	workspace_mpz_init(w->add_s); workspace_mpz_init(w->add_t1); workspace_mpz_init(w->add_t2);
+	workspace_mpz_init(w->add_t3); workspace_mpz_init(w->add_t4); workspace_mpz_init(w->add_t5);
+	w->add_iQ = workspace_point_init();
+	workspace_mpz_init(w->dbl_s); workspace_mpz_init(w->dbl_t1); workspace_mpz_init(w->dbl_t2);
+	workspace_mpz_init(w->dbl_t3); workspace_mpz_init(w->dbl_t4); workspace_mpz_init(w->dbl_t5);
+
+	workspace_mpz_init(w->J.X); workspace_mpz_init(w->J.Y); workspace_mpz_init(w->J.Z);
+	workspace_mpz_init(w->J.t1); workspace_mpz_init(w->J.t2); workspace_mpz_init(w->J.t3);
+	workspace_mpz_init(w->J.t4); workspace_mpz_init(w->J.t5); workspace_mpz_init(w->J.t6);
+
+	w->x = workspace_point_init();
+	w->twice = workspace_point_init();
+	w->neg = workspace_point_init();
+	w->lambdaP = workspace_point_init();
+	w->lambdaQ = workspace_point_init();
+	for(int i = 0; i < MAX_MULTI_SCALARS; i++)
+	{
+		for(int j = 0; j < WNAF_TABLE_SIZE; j++)
+			w->table[i][j] = workspace_point_init();
+		workspace_mpz_init(w->scalars[i]);
+	}
+	workspace_mpz_init(w->k);
+	workspace_mpz_init(w->glv_k); workspace_mpz_init(w->glv_c1); workspace_mpz_init(w->glv_c2);
+
+	w->ready = true;
+	return w;
+}
+
 /*Addition of point P + Q = result*/
 void point_addition(point result, point P, point Q, domain_parameters curve)
 {
@@ -119,11 +236,13 @@ void point_addition(point result, point P, point Q, domain_parameters curve)
 	{
 		point_doubling(result, Q, curve);
 	}else{
+		point_workspace* w = get_workspace();
+
 		//Calculate the inverse point
-		point iQ = point_init();
+		point iQ = w->add_iQ;
 		point_inverse(iQ, Q, curve);
+		iQ->infinity = Q->infinity;
 		bool is_inverse = point_cmp(iQ,P);
-		point_clear(iQ);
 
 		//If it is the inverse
 		if(is_inverse)
@@ -131,14 +250,13 @@ void point_addition(point result, point P, point Q, domain_parameters curve)
 			//result must be point at infinity
 			point_at_infinity(result);
 		}else{
-			//Initialize slope variable
-			mpz_t s;mpz_init(s);
-			//Initialize temporary variables
-			mpz_t t1;mpz_init(t1);
-			mpz_t t2;mpz_init(t2);
-			mpz_t t3;mpz_init(t3);
-			mpz_t t4;mpz_init(t4);
-			mpz_t t5;mpz_init(t5);
+			//Slope and temporary variables from the thread workspace
+			mpz_ptr s = w->add_s;
+			mpz_ptr t1 = w->add_t1;
+			mpz_ptr t2 = w->add_t2;
+			mpz_ptr t3 = w->add_t3;
+			mpz_ptr t4 = w->add_t4;
+			mpz_ptr t5 = w->add_t5;
 		/*
 		Modulo algebra rules:
 		(b1 + b2) mod  n = (b2 mod n) + (b1 mod n) mod n
@@ -170,13 +288,8 @@ void point_addition(point result, point P, point Q, domain_parameters curve)
 			mpz_sub(t3, t2, P->y);				//t3 = t2 - Py
 			mpz_mod(result->y, t3, curve->p);	//Ry = t3 mod p
 
-			//Clear variables, release memory
-			mpz_clear(t1);
-			mpz_clear(t2);
-			mpz_clear(t3);
-			mpz_clear(t4);
-			mpz_clear(t5);
-			mpz_clear(s);
+			//result may be a reused workspace point
+			result->infinity = false;
 		}	
 	}
 }
@@ -205,14 +318,15 @@ void point_doubling(point R, point P, domain_parameters curve)
 	{
 		R->infinity = true;
 	}else{
-		//Initialize slope variable
-		mpz_t s;mpz_init(s);
-		//Initialize temporary variables
-		mpz_t t1;mpz_init(t1);
-		mpz_t t2;mpz_init(t2);
-		mpz_t t3;mpz_init(t3);
-		mpz_t t4;mpz_init(t4);
-		mpz_t t5;mpz_init(t5);
+		point_workspace* w = get_workspace();
+
+		//Slope and temporary variables from the thread workspace
+		mpz_ptr s = w->dbl_s;
+		mpz_ptr t1 = w->dbl_t1;
+		mpz_ptr t2 = w->dbl_t2;
+		mpz_ptr t3 = w->dbl_t3;
+		mpz_ptr t4 = w->dbl_t4;
+		mpz_ptr t5 = w->dbl_t5;
 
 		//Calculate slope
 		//s = (3*Px² + a) / (2*Py) mod p
@@ -242,13 +356,8 @@ void point_doubling(point R, point P, domain_parameters curve)
 		mpz_sub(t3, t2, P->y);				//t3 = t2 - Py
 		mpz_mod(R->y, t3, curve->p);	//Ry = t3 mod p
 
-		//Clear variables, release memory
-		mpz_clear(t1);
-		mpz_clear(t2);
-		mpz_clear(t3);
-		mpz_clear(t4);
-		mpz_clear(t5);
-		mpz_clear(s);
+		//R may be a reused workspace point
+		R->infinity = false;
 	}
 }
 
@@ -264,6 +373,568 @@ bool point_cmp(point P, point Q)
 		return !mpz_cmp(P->x,Q->x) && !mpz_cmp(P->y,Q->y);
 }
 
+/*Set J = 2J*/
+static void jacobian_doubling(jacobian_point *J, domain_parameters curve)
+{
+	if(J->infinity || mpz_sgn(J->Y) == 0)
+	{
+		J->infinity = true;
+		return;
+	}
+
+	//S = 4*X*Y² mod p
+	mpz_mul(J->t1, J->Y, J->Y);
+	mpz_mod(J->t1, J->t1, curve->p);		//t1 = Y²
+	mpz_mul(J->t2, J->X, J->t1);
+	mpz_mul_ui(J->t2, J->t2, 4);
+	mpz_mod(J->t2, J->t2, curve->p);		//t2 = S
+
+	//M = 3*X² + a*Z⁴ mod p
+	mpz_mul(J->t3, J->X, J->X);
+	mpz_mul_ui(J->t3, J->t3, 3);
+	if(mpz_sgn(curve->a) != 0)
+	{
+		mpz_mul(J->t4, J->Z, J->Z);
+		mpz_mod(J->t4, J->t4, curve->p);
+		mpz_mul(J->t4, J->t4, J->t4);
+		mpz_mul(J->t4, J->t4, curve->a);
+		mpz_add(J->t3, J->t3, J->t4);
+	}
+	mpz_mod(J->t3, J->t3, curve->p);		//t3 = M
+
+	//Z' = 2*Y*Z mod p
+	mpz_mul(J->Z, J->Y, J->Z);
+	mpz_mul_ui(J->Z, J->Z, 2);
+	mpz_mod(J->Z, J->Z, curve->p);
+
+	//X' = M² - 2*S mod p
+	mpz_mul(J->X, J->t3, J->t3);
+	mpz_submul_ui(J->X, J->t2, 2);
+	mpz_mod(J->X, J->X, curve->p);
+
+	//Y' = M*(S - X') - 8*Y⁴ mod p
+	mpz_sub(J->t2, J->t2, J->X);
+	mpz_mul(J->Y, J->t3, J->t2);
+	mpz_mul(J->t1, J->t1, J->t1);
+	mpz_submul_ui(J->Y, J->t1, 8);
+	mpz_mod(J->Y, J->Y, curve->p);
+}
+
+/*Set J = J + P, where P is in affine coordinates*/
+static void jacobian_add_affine(jacobian_point *J, point P, domain_parameters curve)
+{
+	if(P->infinity)
+		return;
+
+	if(J->infinity)
+	{
+		mpz_set(J->X, P->x);
+		mpz_set(J->Y, P->y);
+		mpz_set_ui(J->Z, 1);
+		J->infinity = false;
+		return;
+	}
+
+	//U2 = Px*Z² mod p, S2 = Py*Z³ mod p
+	mpz_mul(J->t1, J->Z, J->Z);
+	mpz_mod(J->t1, J->t1, curve->p);		//t1 = Z²
+	mpz_mul(J->t2, P->x, J->t1);
+	mpz_mod(J->t2, J->t2, curve->p);		//t2 = U2
+	mpz_mul(J->t3, J->t1, J->Z);
+	mpz_mul(J->t3, J->t3, P->y);
+	mpz_mod(J->t3, J->t3, curve->p);		//t3 = S2
+
+	//H = U2 - X, r = S2 - Y
+	mpz_sub(J->t2, J->t2, J->X);
+	mpz_mod(J->t2, J->t2, curve->p);		//t2 = H
+	mpz_sub(J->t3, J->t3, J->Y);
+	mpz_mod(J->t3, J->t3, curve->p);		//t3 = r
+
+	if(mpz_sgn(J->t2) == 0)
+	{
+		//Same x coordinate, either the same point or its inverse
+		if(mpz_sgn(J->t3) == 0)
+			jacobian_doubling(J, curve);
+		else
+			J->infinity = true;
+		return;
+	}
+
+	mpz_mul(J->t4, J->t2, J->t2);
+	mpz_mod(J->t4, J->t4, curve->p);		//t4 = H²
+	mpz_mul(J->t5, J->t4, J->t2);
+	mpz_mod(J->t5, J->t5, curve->p);		//t5 = H³
+	mpz_mul(J->t6, J->X, J->t4);
+	mpz_mod(J->t6, J->t6, curve->p);		//t6 = V = X*H²
+
+	//Z' = Z*H mod p
+	mpz_mul(J->Z, J->Z, J->t2);
+	mpz_mod(J->Z, J->Z, curve->p);
+
+	//X' = r² - H³ - 2*V mod p
+	mpz_mul(J->X, J->t3, J->t3);
+	mpz_sub(J->X, J->X, J->t5);
+	mpz_submul_ui(J->X, J->t6, 2);
+	mpz_mod(J->X, J->X, curve->p);
+
+	//Y' = r*(V - X') - Y*H³ mod p
+	mpz_sub(J->t6, J->t6, J->X);
+	mpz_mul(J->t6, J->t3, J->t6);
+	mpz_mul(J->t5, J->Y, J->t5);
+	mpz_sub(J->Y, J->t6, J->t5);
+	mpz_mod(J->Y, J->Y, curve->p);
+}
+
+/*Set R to the affine representation of J, the only inversion of a multiplication*/
+static void jacobian_to_affine(point R, jacobian_point *J, domain_parameters curve)
+{
+	if(J->infinity)
+	{
+		point_at_infinity(R);
+		return;
+	}
+
+	number_theory_inverse(J->t1, J->Z, curve->p);	//t1 = Z^-1
+	mpz_mul(J->t2, J->t1, J->t1);
+	mpz_mod(J->t2, J->t2, curve->p);			//t2 = Z^-2
+	mpz_mul(R->x, J->X, J->t2);
+	mpz_mod(R->x, R->x, curve->p);
+	mpz_mul(J->t2, J->t2, J->t1);
+	mpz_mod(J->t2, J->t2, curve->p);			//t2 = Z^-3
+	mpz_mul(R->y, J->Y, J->t2);
+	mpz_mod(R->y, R->y, curve->p);
+	R->infinity = false;
+}
+
+/*
+The jacobian arithmetic above on field_element coordinates, for secp256k1 only (a = 0). All
+temporaries are on the stack, nothing goes through GMP until the result is converted back.
+*/
+//enabled by point_glv_init like the endomorphism, published with release/acquire
+static bool field_ready = false;
+
+/*Set J = 2J*/
+static void field_jacobian_doubling(field_jacobian *J)
+{
+	if(J->infinity || field_is_zero(&J->Y))
+	{
+		J->infinity = true;
+		return;
+	}
+
+	field_element t1, t2, t3;
+
+	//S = 4*X*Y²
+	field_sqr(&t1, &J->Y);			//t1 = Y²
+	field_mul(&t2, &J->X, &t1);
+	field_mul_ui(&t2, &t2, 4);		//t2 = S
+
+	//M = 3*X²
+	field_sqr(&t3, &J->X);
+	field_mul_ui(&t3, &t3, 3);		//t3 = M
+
+	//Z' = 2*Y*Z
+	field_mul(&J->Z, &J->Y, &J->Z);
+	field_add(&J->Z, &J->Z, &J->Z);
+
+	//X' = M² - 2*S
+	field_sqr(&J->X, &t3);
+	field_sub(&J->X, &J->X, &t2);
+	field_sub(&J->X, &J->X, &t2);
+
+	//Y' = M*(S - X') - 8*Y⁴
+	field_sub(&t2, &t2, &J->X);
+	field_mul(&J->Y, &t3, &t2);
+	field_sqr(&t1, &t1);
+	field_mul_ui(&t1, &t1, 8);
+	field_sub(&J->Y, &J->Y, &t1);
+}
+
+/*Set J = J + P*/
+static void field_jacobian_add_affine(field_jacobian *J, const field_affine *P)
+{
+	if(P->infinity)
+		return;
+
+	if(J->infinity)
+	{
+		J->X = P->x;
+		J->Y = P->y;
+		field_set_ui(&J->Z, 1);
+		J->infinity = false;
+		return;
+	}
+
+	field_element t1, t2, t3, t4, t5, t6;
+
+	//U2 = Px*Z², S2 = Py*Z³
+	field_sqr(&t1, &J->Z);			//t1 = Z²
+	field_mul(&t2, &P->x, &t1);		//t2 = U2
+	field_mul(&t3, &t1, &J->Z);
+	field_mul(&t3, &t3, &P->y);		//t3 = S2
+
+	//H = U2 - X, r = S2 - Y
+	field_sub(&t2, &t2, &J->X);		//t2 = H
+	field_sub(&t3, &t3, &J->Y);		//t3 = r
+
+	if(field_is_zero(&t2))
+	{
+		//Same x coordinate, either the same point or its inverse
+		if(field_is_zero(&t3))
+			field_jacobian_doubling(J);
+		else
+			J->infinity = true;
+		return;
+	}
+
+	field_sqr(&t4, &t2);			//t4 = H²
+	field_mul(&t5, &t4, &t2);		//t5 = H³
+	field_mul(&t6, &J->X, &t4);		//t6 = V = X*H²
+
+	//Z' = Z*H
+	field_mul(&J->Z, &J->Z, &t2);
+
+	//X' = r² - H³ - 2*V
+	field_sqr(&J->X, &t3);
+	field_sub(&J->X, &J->X, &t5);
+	field_sub(&J->X, &J->X, &t6);
+	field_sub(&J->X, &J->X, &t6);
+
+	//Y' = r*(V - X') - Y*H³
+	field_sub(&t6, &t6, &J->X);
+	field_mul(&t6, &t3, &t6);
+	field_mul(&t5, &J->Y, &t5);
+	field_sub(&J->Y, &t6, &t5);
+}
+
+/*r = a^-1 mod p with GMP on workspace variables, a multiplication needs at most three. Like
+number_theory_inverse its time depends on a*/
+static void field_inverse(field_element *r, const field_element *a, domain_parameters curve)
+{
+	jacobian_point* J = &get_workspace()->J;
+	field_get_mpz(J->t1, a);
+	mpz_invert(J->t2, J->t1, curve->p);
+	if(!field_set_mpz(r, J->t2))
+		field_set_ui(r, 0);
+}
+
+/*Set R[i] to the affine representation of J[i] with one inversion for all, Montgomery's trick*/
+static void field_batch_to_affine(field_affine *R, const field_jacobian *J, int count, field_element *prefix,
+                                  domain_parameters curve)
+{
+	field_element acc, inv, zinv, zinv2;
+
+	//prefix[i] = product of the Z of the points before i
+	field_set_ui(&acc, 1);
+	for(int i = 0; i < count; i++)
+	{
+		prefix[i] = acc;
+		if(!J[i].infinity)
+			field_mul(&acc, &acc, &J[i].Z);
+	}
+
+	field_inverse(&inv, &acc, curve);
+
+	for(int i = count - 1; i >= 0; i--)
+	{
+		if(J[i].infinity)
+		{
+			R[i].infinity = true;
+			continue;
+		}
+
+		field_mul(&zinv, &inv, &prefix[i]);	//zinv = Z^-1
+		field_mul(&inv, &inv, &J[i].Z);
+		field_sqr(&zinv2, &zinv);
+		field_mul(&R[i].x, &J[i].X, &zinv2);
+		field_mul(&zinv2, &zinv2, &zinv);
+		field_mul(&R[i].y, &J[i].Y, &zinv2);
+		R[i].infinity = false;
+	}
+}
+
+static void field_jacobian_set_affine(field_jacobian *J, const field_affine *P)
+{
+	J->X = P->x;
+	J->Y = P->y;
+	field_set_ui(&J->Z, 1);
+	J->infinity = P->infinity;
+}
+
+/*Set R to the affine representation of J*/
+static void field_jacobian_to_point(point R, const field_jacobian *J, field_element *prefix, domain_parameters curve)
+{
+	field_affine A;
+	field_batch_to_affine(&A, J, 1, prefix, curve);
+
+	if(A.infinity)
+	{
+		point_at_infinity(R);
+		return;
+	}
+
+	field_get_mpz(R->x, &A.x);
+	field_get_mpz(R->y, &A.y);
+	R->infinity = false;
+}
+
+/*
+Interleaved wNAF multiplication R = sum(scalars[i] * points[i]). Every scalar is recoded into
+signed odd digits with at most one nonzero digit in any WNAF_WINDOW_BITS consecutive ones, so
+all scalars share one chain of doublings and each needs about bits / (WNAF_WINDOW_BITS + 1) additions.
+Scalars must be less than 2^POINT_WORKSPACE_BITS.
+*/
+static int wnaf_recode(int8_t *naf, mpz_t scalar, mpz_t k)
+{
+	int len = 0;
+
+	mpz_set(k, scalar);
+	while(mpz_sgn(k) > 0 && len < WNAF_MAX_LEN)
+	{
+		int digit = 0;
+		if(mpz_odd_p(k))
+		{
+			digit = (int) mpz_fdiv_ui(k, 1 << WNAF_WINDOW_BITS);
+			if(digit >= (1 << (WNAF_WINDOW_BITS - 1)))
+				digit -= 1 << WNAF_WINDOW_BITS;
+			if(digit > 0)
+				mpz_sub_ui(k, k, digit);
+			else
+				mpz_add_ui(k, k, -digit);
+		}
+		naf[len++] = (int8_t) digit;
+		mpz_fdiv_q_2exp(k, k, 1);
+	}
+
+	return len;
+}
+
+/*multi_scalar_multiplication in the secp256k1 field, returns false if a coordinate is not a field element*/
+static bool field_multi_scalar_multiplication(point R, int count, mpz_t *scalars, point *points,
+                                              domain_parameters curve)
+{
+	point_workspace* w = get_workspace();
+	int len[MAX_MULTI_SCALARS];
+	int max_len = 0;
+
+	for(int i = 0; i < count; i++)
+	{
+		field_affine base;
+		base.infinity = points[i]->infinity;
+		if(!base.infinity && (!field_set_mpz(&base.x, points[i]->x) || !field_set_mpz(&base.y, points[i]->y)))
+			return false;
+
+		//A negative scalar multiplies the inverse point
+		if(mpz_sgn(scalars[i]) < 0)
+			field_neg(&base.y, &base.y);
+
+		field_jacobian_set_affine(&w->field_jtable[i * WNAF_TABLE_SIZE], &base);
+
+		//twice = 2 * base, the twice of all scalars share one inversion
+		field_jacobian_set_affine(&w->field_jtwice[i], &base);
+		field_jacobian_doubling(&w->field_jtwice[i]);
+	}
+
+	field_batch_to_affine(w->field_twice, w->field_jtwice, count, w->field_prefix, curve);
+
+	//table[j] = (2j + 1) * base, the whole table is converted to affine with one inversion
+	for(int i = 0; i < count; i++)
+	{
+		field_jacobian* table = &w->field_jtable[i * WNAF_TABLE_SIZE];
+		for(int j = 1; j < WNAF_TABLE_SIZE; j++)
+		{
+			table[j] = table[j - 1];
+			field_jacobian_add_affine(&table[j], &w->field_twice[i]);
+		}
+
+		mpz_abs(w->k, scalars[i]);
+		len[i] = wnaf_recode(w->naf[i], w->k, w->k);
+		if(len[i] > max_len)
+			max_len = len[i];
+	}
+
+	field_batch_to_affine(w->field_table, w->field_jtable, count * WNAF_TABLE_SIZE, w->field_prefix, curve);
+
+	field_jacobian* J = &w->field_J;
+	J->infinity = true;
+
+	for(int bit = max_len - 1; bit >= 0; bit--)
+	{
+		field_jacobian_doubling(J);
+		for(int i = 0; i < count; i++)
+		{
+			if(bit >= len[i] || w->naf[i][bit] == 0)
+				continue;
+			int digit = w->naf[i][bit];
+			if(digit > 0)
+			{
+				field_jacobian_add_affine(J, &w->field_table[i * WNAF_TABLE_SIZE + (digit - 1) / 2]);
+			}else{
+				field_affine neg = w->field_table[i * WNAF_TABLE_SIZE + (-digit - 1) / 2];
+				field_neg(&neg.y, &neg.y);
+				field_jacobian_add_affine(J, &neg);
+			}
+		}
+	}
+
+	field_jacobian_to_point(R, J, w->field_prefix, curve);
+	return true;
+}
+
+static void multi_scalar_multiplication(point R, int count, mpz_t *scalars, point *points, domain_parameters curve)
+{
+	point_workspace* w = get_workspace();
+	int len[MAX_MULTI_SCALARS];
+	int max_len = 0;
+
+	if(__atomic_load_n(&field_ready, __ATOMIC_ACQUIRE) && field_multi_scalar_multiplication(R, count, scalars, points, curve))
+		return;
+
+	for(int i = 0; i < count; i++)
+	{
+		//A negative scalar multiplies the inverse point
+		point* table = w->table[i];
+		if(mpz_sgn(scalars[i]) < 0)
+			point_inverse(table[0], points[i], curve);
+		else
+			point_copy(table[0], points[i]);
+		table[0]->infinity = points[i]->infinity;
+
+		//table[j] = (2j + 1) * points[i]
+		point_doubling(w->twice, table[0], curve);
+		w->twice->infinity = table[0]->infinity;
+		for(int j = 1; j < WNAF_TABLE_SIZE; j++)
+			point_addition(table[j], table[j - 1], w->twice, curve);
+
+		mpz_abs(w->k, scalars[i]);
+		len[i] = wnaf_recode(w->naf[i], w->k, w->k);
+		if(len[i] > max_len)
+			max_len = len[i];
+	}
+
+	jacobian_point* J = &w->J;
+	J->infinity = true;
+
+	for(int bit = max_len - 1; bit >= 0; bit--)
+	{
+		jacobian_doubling(J, curve);
+		for(int i = 0; i < count; i++)
+		{
+			if(bit >= len[i] || w->naf[i][bit] == 0)
+				continue;
+			int digit = w->naf[i][bit];
+			if(digit > 0)
+			{
+				jacobian_add_affine(J, w->table[i][(digit - 1) / 2], curve);
+			}else{
+				point_inverse(w->neg, w->table[i][(-digit - 1) / 2], curve);
+				w->neg->infinity = w->table[i][(-digit - 1) / 2]->infinity;
+				jacobian_add_affine(J, w->neg, curve);
+			}
+		}
+	}
+
+	jacobian_to_affine(R, J, curve);
+}
+
+/*
+GLV endomorphism of secp256k1: (x, y) -> (beta*x, y) equals lambda*P. A scalar k is split into
+k1 + k2*lambda mod n with k1 and k2 of about 128 bits, which halves the doublings of a multiplication.
+Constants are from the GLV paper, as used in libsecp256k1.
+*/
+//the tables are built by trustedPrecomputeTables while other threads already sign, so readiness is published
+//with release/acquire and callers fall back to the generic code until then
+static bool glv_ready = false;
+static mpz_t glv_beta, glv_a1, glv_minus_b1, glv_a2, glv_half_n;
+
+static bool is_secp256k1(domain_parameters curve)
+{
+	mpz_t secp256k1_p, secp256k1_n;
+	mpz_init_set_str(secp256k1_p, "FFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFEFFFFFC2F", 16);
+	mpz_init_set_str(secp256k1_n, "FFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFEBAAEDCE6AF48A03BBFD25E8CD0364141", 16);
+	bool result = !mpz_cmp(curve->p, secp256k1_p) && !mpz_cmp(curve->n, secp256k1_n) && !mpz_sgn(curve->a);
+	mpz_clear(secp256k1_p);
+	mpz_clear(secp256k1_n);
+	return result;
+}
+
+void point_glv_init(domain_parameters curve)
+{
+	if(__atomic_load_n(&glv_ready, __ATOMIC_ACQUIRE))
+		return;
+
+	if(!is_secp256k1(curve))
+		return;
+
+	mpz_init_set_str(glv_beta, "7AE96A2B657C07106E64479EAC3434E99CF0497512F58995C1396C28719501EE", 16);
+	mpz_init_set_str(glv_a1, "3086D221A7D46BCDE86C90E49284EB15", 16);
+	mpz_init_set_str(glv_minus_b1, "E4437ED6010E88286F547FA90ABFE4C3", 16);
+	mpz_init_set_str(glv_a2, "114CA50F7A8E2F3F657C1108D9D44CFD8", 16);
+	mpz_init(glv_half_n);
+	mpz_fdiv_q_2exp(glv_half_n, curve->n, 1);
+
+	__atomic_store_n(&glv_ready, true, __ATOMIC_RELEASE);
+	__atomic_store_n(&field_ready, true, __ATOMIC_RELEASE);
+}
+
+/*Split k mod n into k1 + k2*lambda*/
+static void glv_split(mpz_t k1, mpz_t k2, mpz_t multiplier, domain_parameters curve)
+{
+	point_workspace* w = get_workspace();
+	mpz_ptr k = w->glv_k;
+	mpz_ptr c1 = w->glv_c1;
+	mpz_ptr c2 = w->glv_c2;
+
+	mpz_mod(k, multiplier, curve->n);
+
+	//c1 = round(a1*k/n), c2 = round(-b1*k/n)
+	mpz_mul(c1, glv_a1, k);
+	mpz_add(c1, c1, glv_half_n);
+	mpz_fdiv_q(c1, c1, curve->n);
+	mpz_mul(c2, glv_minus_b1, k);
+	mpz_add(c2, c2, glv_half_n);
+	mpz_fdiv_q(c2, c2, curve->n);
+
+	//k1 = k - c1*a1 - c2*a2, k2 = -c1*b1 - c2*a1
+	mpz_set(k1, k);
+	mpz_submul(k1, c1, glv_a1);
+	mpz_submul(k1, c2, glv_a2);
+	mpz_mul(k2, c1, glv_minus_b1);
+	mpz_submul(k2, c2, glv_a1);
+}
+
+/*Set R = (beta*Px, Py) = lambda*P*/
+static void glv_endomorphism(point R, point P, domain_parameters curve)
+{
+	mpz_mul(R->x, P->x, glv_beta);
+	mpz_mod(R->x, R->x, curve->p);
+	mpz_set(R->y, P->y);
+	R->infinity = P->infinity;
+}
+
+/*Set R = u1*P + u2*Q in a single interleaved pass (Shamir's trick)*/
+void point_linear_combination(point R, mpz_t u1, point P, mpz_t u2, point Q, domain_parameters curve)
+{
+	point_workspace* w = get_workspace();
+
+	if(!__atomic_load_n(&glv_ready, __ATOMIC_ACQUIRE))
+	{
+		mpz_set(w->scalars[0], u1);
+		mpz_set(w->scalars[1], u2);
+		point points[2] = {P, Q};
+		multi_scalar_multiplication(R, 2, w->scalars, points, curve);
+		return;
+	}
+
+	glv_split(w->scalars[0], w->scalars[1], u1, curve);
+	glv_split(w->scalars[2], w->scalars[3], u2, curve);
+	glv_endomorphism(w->lambdaP, P, curve);
+	glv_endomorphism(w->lambdaQ, Q, curve);
+
+	point points[4] = {P, w->lambdaP, Q, w->lambdaQ};
+	multi_scalar_multiplication(R, 4, w->scalars, points, curve);
+}
+
 /*Perform scalar multiplication to P, with the factor multiplier, over the curve curve*/
 void point_multiplication(point R, mpz_t multiplier, point P, domain_parameters curve)
 {
@@ -271,40 +942,183 @@ void point_multiplication(point R, mpz_t multiplier, point P, domain_parameters
 	if(P->infinity)
 	{
 		R->infinity = true;
+		return;
+	}
+
+	point_workspace* w = get_workspace();
+
+	if(__atomic_load_n(&glv_ready, __ATOMIC_ACQUIRE) && mpz_sgn(multiplier) >= 0)
+	{
+		glv_split(w->scalars[0], w->scalars[1], multiplier, curve);
+		glv_endomorphism(w->lambdaP, P, curve);
+
+		point points[2] = {P, w->lambdaP};
+		multi_scalar_multiplication(R, 2, w->scalars, points, curve);
 	}else{
-		//Initializing variables
-		point x = point_init();
+		//P is copied, so that R may alias it
+		point x = w->x;
 		point_copy(x, P);
-		point t = point_init();
-		point_copy(t, x);
 
-		//Set R = point at infinity
-		point_at_infinity(R);
+		jacobian_point* J = &w->J;
+		J->infinity = true;
 
 /*
-Loops through the integer bit per bit, if a bit is 1 then x is added to the result. Looping through the multiplier in this manner allows us to use as many point doubling operations as possible. No reason to say 5P=P+P+P+P+P, when you might as well just use 5P=2(2P)+P.
-This is not the most effecient method of point multiplication, but it's faster than P+P+P+... which is not computational feasiable.
+Left to right double-and-add in jacobian coordinates: the accumulator is doubled for every
+bit of the multiplier and P is added for every bit that is 1.
 */
-		int bits = mpz_sizeinbase(multiplier, 2);
-		long int bit = 0;
-		while(bit <= bits)
+		long int bit = mpz_sizeinbase(multiplier, 2);
+		while(bit >= 0)
 		{
+			jacobian_doubling(J, curve);
 			if(mpz_tstbit(multiplier, bit))
+				jacobian_add_affine(J, x, curve);
+			bit--;
+		}
+
+		jacobian_to_affine(R, J, curve);
+	}
+}
+
+/*Set R[i] = multiplier * P[i] for count points, the multiplier is split only once*/
+void point_multiplication_batch(point *R, mpz_t multiplier, point *P, int count, domain_parameters curve)
+{
+	if(!__atomic_load_n(&glv_ready, __ATOMIC_ACQUIRE) || mpz_sgn(multiplier) < 0)
+	{
+		for(int i = 0; i < count; i++)
+			point_multiplication(R[i], multiplier, P[i], curve);
+		return;
+	}
+
+	point_workspace* w = get_workspace();
+	mpz_t scalars[2];
+	mpz_init(scalars[0]);
+	mpz_init(scalars[1]);
+
+	glv_split(scalars[0], scalars[1], multiplier, curve);
+
+	for(int i = 0; i < count; i++)
+	{
+		if(P[i]->infinity)
+		{
+			R[i]->infinity = true;
+			continue;
+		}
+
+		glv_endomorphism(w->lambdaP, P[i], curve);
+
+		point points[2] = {P[i], w->lambdaP};
+		multi_scalar_multiplication(R[i], 2, scalars, points, curve);
+	}
+
+	//the halves of a secret multiplier are secret too
+	for(int i = 0; i < 2; i++)
+	{
+		if(scalars[i]->_mp_d)
+			memset(scalars[i]->_mp_d, 0, scalars[i]->_mp_alloc * sizeof(mp_limb_t));
+		mpz_clear(scalars[i]);
+	}
+}
+
+static point fixed_base_table[FIXED_BASE_WINDOWS][FIXED_BASE_WINDOW_SIZE - 1];
+static bool fixed_base_table_ready = false;
+
+//the same table in the secp256k1 field, set before fixed_base_table_ready if curve is secp256k1
+static field_affine fixed_base_field_table[FIXED_BASE_WINDOWS][FIXED_BASE_WINDOW_SIZE - 1];
+static bool fixed_base_field_table_ready = false;
+
+/*Precompute the generator table of the curve curve, called once from enclave_init*/
+void point_fixed_base_init(domain_parameters curve)
+{
+	if(__atomic_load_n(&fixed_base_table_ready, __ATOMIC_ACQUIRE))
+		return;
+
+	//base = 2^(4i) * G for the current window i
+	point base = point_init();
+	point_copy(base, curve->G);
+
+	for(int i = 0; i < FIXED_BASE_WINDOWS; i++)
+	{
+		fixed_base_table[i][0] = point_init();
+		point_copy(fixed_base_table[i][0], base);
+		for(int j = 1; j < FIXED_BASE_WINDOW_SIZE - 1; j++)
+		{
+			fixed_base_table[i][j] = point_init();
+			point_addition(fixed_base_table[i][j], fixed_base_table[i][j - 1], base, curve);
+		}
+		//2^(4(i+1)) * G = 15 * base + base
+		point next = point_init();
+		point_addition(next, fixed_base_table[i][FIXED_BASE_WINDOW_SIZE - 2], base, curve);
+		point_copy(base, next);
+		point_clear(next);
+	}
+
+	point_clear(base);
+
+	if(is_secp256k1(curve))
+	{
+		bool valid = true;
+		for(int i = 0; i < FIXED_BASE_WINDOWS; i++)
+		{
+			for(int j = 0; j < FIXED_BASE_WINDOW_SIZE - 1; j++)
 			{
-				point_addition(t, x, R, curve);
-				point_copy(R, t);
+				point P = fixed_base_table[i][j];
+				fixed_base_field_table[i][j].infinity = P->infinity;
+				valid = valid && (P->infinity || (field_set_mpz(&fixed_base_field_table[i][j].x, P->x) &&
+				                                  field_set_mpz(&fixed_base_field_table[i][j].y, P->y)));
 			}
-			point_doubling(t, x, curve);
-			point_copy(x, t);
-			bit++;
 		}
-
-		//Release temporary variables
-		point_clear(x);
-		point_clear(t);
+		fixed_base_field_table_ready = valid;
 	}
+
+	__atomic_store_n(&fixed_base_table_ready, true, __ATOMIC_RELEASE);
 }
 
+/*Set R = multiplier * G using the precomputed table, falls back to point_multiplication if there is none*/
+void point_fixed_base_multiplication(point R, mpz_t multiplier, domain_parameters curve)
+{
+	if(!__atomic_load_n(&fixed_base_table_ready, __ATOMIC_ACQUIRE) || mpz_sgn(multiplier) < 0 ||
+	   mpz_sizeinbase(multiplier, 2) > FIXED_BASE_SCALAR_BITS)
+	{
+		point_multiplication(R, multiplier, curve->G, curve);
+		return;
+	}
+
+	if(fixed_base_field_table_ready)
+	{
+		point_workspace* w = get_workspace();
+		field_jacobian* J = &w->field_J;
+		J->infinity = true;
+
+		for(int i = 0; i < FIXED_BASE_WINDOWS; i++)
+		{
+			int digit = 0;
+			for(int b = FIXED_BASE_WINDOW_BITS - 1; b >= 0; b--)
+				digit = (digit << 1) | mpz_tstbit(multiplier, i * FIXED_BASE_WINDOW_BITS + b);
+
+			if(digit)
+				field_jacobian_add_affine(J, &fixed_base_field_table[i][digit - 1]);
+		}
+
+		field_jacobian_to_point(R, J, w->field_prefix, curve);
+		return;
+	}
+
+	jacobian_point* J = &get_workspace()->J;
+	J->infinity = true;
+
+	//One table lookup and at most one addition per window, no doublings
+	for(int i = 0; i < FIXED_BASE_WINDOWS; i++)
+	{
+		int digit = 0;
+		for(int b = FIXED_BASE_WINDOW_BITS - 1; b >= 0; b--)
+			digit = (digit << 1) | mpz_tstbit(multiplier, i * FIXED_BASE_WINDOW_BITS + b);
+
+		if(digit)
+			jacobian_add_affine(J, fixed_base_table[i][digit - 1], curve);
+	}
+
+	jacobian_to_affine(R, J, curve);
+}
 
 /*Compress a point to hexadecimal string
  *This function is implemented as specified in SEC 1: Elliptic Curve Cryptography, section 2.3.3.*/
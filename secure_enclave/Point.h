@@ -60,6 +60,34 @@ EXTERNC void point_doubling(point R, point P, domain_parameters curve);
 /*Perform scalar multiplication to P, with the factor multiplier, over the curve curve*/
 EXTERNC void point_multiplication(point R, mpz_t multiplier, point P, domain_parameters curve);
 
+/*Fixed base comb for the curve generator: table[i][j] = (j + 1) * 2^(4i) * G*/
+#define FIXED_BASE_WINDOW_BITS 4
+#define FIXED_BASE_WINDOW_SIZE (1 << FIXED_BASE_WINDOW_BITS)
+#define FIXED_BASE_SCALAR_BITS 256
+#define FIXED_BASE_WINDOWS (FIXED_BASE_SCALAR_BITS / FIXED_BASE_WINDOW_BITS)
+
+/*Precompute the generator table of the curve curve, also in the secp256k1 field, called once from enclave_init*/
+EXTERNC void point_fixed_base_init(domain_parameters curve);
+
+/*Set R = multiplier * G using the precomputed table, falls back to point_multiplication if there is none*/
+EXTERNC void point_fixed_base_multiplication(point R, mpz_t multiplier, domain_parameters curve);
+
+/*Bits preallocated for every variable of the per thread point workspace*/
+#define POINT_WORKSPACE_BITS 1024
+
+/*Width of the signed window of the variable base wNAF multiplier*/
+#define WNAF_WINDOW_BITS 5
+#define WNAF_TABLE_SIZE (1 << (WNAF_WINDOW_BITS - 2))
+
+/*Enable the GLV endomorphism and the fixed limb field arithmetic of Secp256k1Field.h in point_multiplication if curve is secp256k1, called once from enclave_init*/
+EXTERNC void point_glv_init(domain_parameters curve);
+
+/*Set R[i] = multiplier * P[i] for count points, the multiplier is split only once*/
+EXTERNC void point_multiplication_batch(point *R, mpz_t multiplier, point *P, int count, domain_parameters curve);
+
+/*Set R = u1*P + u2*Q in a single interleaved pass (Shamir's trick)*/
+EXTERNC void point_linear_combination(point R, mpz_t u1, point P, mpz_t u2, point Q, domain_parameters curve);
+
 /*Set point from strings of a base from 2-62*/
 EXTERNC int point_set_str(point p, const char *x, const char *y, int base);
 
@@ -0,0 +1,61 @@
+/*
+    Copyright (C) 2021-Present SKALE Labs
+
+    This file is part of sgxwallet.
+
+    sgxwallet is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as published
+    by the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    sgxwallet is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with sgxwallet.  If not, see <https://www.gnu.org/licenses/>.
+
+    @file ScratchArena.c
+    @author Stan Kladko
+    @date 2021
+*/
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "EnclaveConstants.h"
+#include "ScratchArena.h"
+
+static __thread uint8_t *arena = NULL;
+static __thread uint64_t arenaUsed = 0;
+
+void *scratch_alloc(uint64_t _size) {
+    if (!arena) {
+        arena = (uint8_t *) calloc(1, SCRATCH_ARENA_SIZE);
+        if (!arena)
+            return NULL;
+    }
+
+    // 16 byte aligned, so buffers can hold limbs
+    _size = (_size + 15) & ~(uint64_t) 15;
+
+    if (_size > SCRATCH_ARENA_SIZE - arenaUsed)
+        return NULL;
+
+    void *result = arena + arenaUsed;
+    arenaUsed += _size;
+    return result;
+}
+
+uint64_t scratch_mark() {
+    return arenaUsed;
+}
+
+void scratch_release(uint64_t *_mark) {
+    if (!arena || *_mark >= arenaUsed)
+        return;
+
+    memset(arena + *_mark, 0, arenaUsed - *_mark);
+    arenaUsed = *_mark;
+}
@@ -0,0 +1,51 @@
+/*
+    Copyright (C) 2021-Present SKALE Labs
+
+    This file is part of sgxwallet.
+
+    sgxwallet is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as published
+    by the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    sgxwallet is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with sgxwallet.  If not, see <https://www.gnu.org/licenses/>.
+
+    @file ScratchArena.h
+    @author Stan Kladko
+    @date 2021
+*/
+
+#ifndef SGXWALLET_SCRATCHARENA_H
+#define SGXWALLET_SCRATCHARENA_H
+
+#include <stdint.h>
+
+// Per thread scratch memory for ECALL buffers. The enclave runs with TCSPolicy 0, so each host
+// thread is bound to one TCS for its lifetime and the thread local arena of that TCS is reused by
+// all of its ECALLs. Hot ECALLs then work in the same warm SCRATCH_ARENA_SIZE bytes instead of
+// clearing fresh stack buffers on each call.
+//
+// Free arena memory is always zero: scratch_release wipes everything allocated after the mark,
+// so buffers come out zeroed without a memset and secrets do not outlive their ECALL.
+
+// zeroed memory from the arena of the calling thread, NULL if the arena could not be allocated or is full
+void *scratch_alloc(uint64_t _size);
+
+uint64_t scratch_mark();
+
+// wipes and frees all allocations made after *_mark
+void scratch_release(uint64_t *_mark);
+
+// releases the allocations of the enclosing scope when it is left, including by goto clean
+#define SCRATCH_SCOPE uint64_t __scratchMark__ __attribute__((cleanup(scratch_release))) = scratch_mark();
+
+// SAFE_CHAR_BUF in the arena, a full arena is reported through CHECK_STATE
+#define SCRATCH_CHAR_BUF(__X__, __Y__) ;char *__X__ = (char *) scratch_alloc(__Y__); CHECK_STATE(__X__)
+
+#endif //SGXWALLET_SCRATCHARENA_H
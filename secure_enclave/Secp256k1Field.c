@@ -0,0 +1,280 @@
+/*
+    Copyright (C) 2019-Present SKALE Labs
+
+    This file is part of sgxwallet.
+
+    sgxwallet is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as published
+    by the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    sgxwallet is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with sgxwallet.  If not, see <https://www.gnu.org/licenses/>.
+
+    @file Secp256k1Field.c
+    @author Stan Kladko
+    @date 2021
+*/
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef USER_SPACE
+#include <gmp.h>
+#else
+#include <../tgmp-build/include/sgx_tgmp.h>
+#endif
+
+#include "Secp256k1Field.h"
+
+typedef unsigned __int128 uint128_t;
+
+//2^256 mod p
+#define FIELD_C 0x1000003D1ULL
+
+static const field_element field_p = {{0xFFFFFFFEFFFFFC2FULL, 0xFFFFFFFFFFFFFFFFULL,
+                                       0xFFFFFFFFFFFFFFFFULL, 0xFFFFFFFFFFFFFFFFULL}};
+
+/*r = t + carry*2^256 mod p for carry < 2^35, and t < 2^256*/
+static void field_reduce(field_element *r, const uint64_t t[4], uint64_t carry)
+{
+	uint64_t c[4] = {t[0], t[1], t[2], t[3]};
+	uint128_t acc;
+
+	//Fold the carry twice, the second fold adds at most FIELD_C to a small value
+	for(int fold = 0; fold < 2; fold++)
+	{
+		acc = (uint128_t) carry * FIELD_C;
+		for(int i = 0; i < 4; i++)
+		{
+			acc += c[i];
+			c[i] = (uint64_t) acc;
+			acc >>= 64;
+		}
+		carry = (uint64_t) acc;
+	}
+
+	//c >= p exactly when c + FIELD_C carries out of 256 bits, then that sum is c - p
+	uint64_t d[4];
+	acc = (uint128_t) c[0] + FIELD_C;
+	d[0] = (uint64_t) acc;
+	acc >>= 64;
+	for(int i = 1; i < 4; i++)
+	{
+		acc += c[i];
+		d[i] = (uint64_t) acc;
+		acc >>= 64;
+	}
+
+	uint64_t mask = -(uint64_t) acc;
+	for(int i = 0; i < 4; i++)
+		r->n[i] = (d[i] & mask) | (c[i] & ~mask);
+}
+
+bool field_set_mpz(field_element *r, mpz_t a)
+{
+	if(mpz_sgn(a) < 0 || mpz_sizeinbase(a, 2) > 256)
+		return false;
+
+	memset(r->n, 0, sizeof(r->n));
+	mpz_export(r->n, NULL, -1, sizeof(uint64_t), 0, 0, a);
+
+	for(int i = 3; i >= 0; i--)
+	{
+		if(r->n[i] != field_p.n[i])
+			return r->n[i] < field_p.n[i];
+	}
+
+	return false;
+}
+
+void field_get_mpz(mpz_t r, const field_element *a)
+{
+	mpz_import(r, 4, -1, sizeof(uint64_t), 0, 0, a->n);
+}
+
+void field_set_ui(field_element *r, uint64_t a)
+{
+	r->n[0] = a;
+	r->n[1] = r->n[2] = r->n[3] = 0;
+}
+
+bool field_is_zero(const field_element *a)
+{
+	return (a->n[0] | a->n[1] | a->n[2] | a->n[3]) == 0;
+}
+
+bool field_equal(const field_element *a, const field_element *b)
+{
+	return ((a->n[0] ^ b->n[0]) | (a->n[1] ^ b->n[1]) | (a->n[2] ^ b->n[2]) | (a->n[3] ^ b->n[3])) == 0;
+}
+
+void field_add(field_element *r, const field_element *a, const field_element *b)
+{
+	uint64_t t[4];
+	uint128_t acc = 0;
+
+	for(int i = 0; i < 4; i++)
+	{
+		acc += (uint128_t) a->n[i] + b->n[i];
+		t[i] = (uint64_t) acc;
+		acc >>= 64;
+	}
+
+	field_reduce(r, t, (uint64_t) acc);
+}
+
+void field_sub(field_element *r, const field_element *a, const field_element *b)
+{
+	uint64_t t[4];
+	uint64_t borrow = 0;
+
+	for(int i = 0; i < 4; i++)
+	{
+		uint128_t d = (uint128_t) a->n[i] - b->n[i] - borrow;
+		t[i] = (uint64_t) d;
+		borrow = (uint64_t) (d >> 64) & 1;
+	}
+
+	//On a borrow t = a - b + 2^256, and a - b + p = t - FIELD_C, which does not borrow again
+	uint64_t c = FIELD_C & -borrow;
+	for(int i = 0; i < 4; i++)
+	{
+		uint128_t d = (uint128_t) t[i] - c;
+		r->n[i] = (uint64_t) d;
+		c = (uint64_t) (d >> 64) & 1;
+	}
+}
+
+void field_neg(field_element *r, const field_element *a)
+{
+	field_element zero = {{0, 0, 0, 0}};
+	field_sub(r, &zero, a);
+}
+
+/*Add a*b to the 192 bit accumulator (hi, acc)*/
+static inline void field_muladd(uint128_t *acc, uint64_t *hi, uint64_t a, uint64_t b)
+{
+	uint128_t p = (uint128_t) a * b;
+	*acc += p;
+	*hi += *acc < p;
+}
+
+/*Shift the accumulator by one limb and return the limb shifted out*/
+static inline uint64_t field_column(uint128_t *acc, uint64_t *hi)
+{
+	uint64_t limb = (uint64_t) *acc;
+	*acc = (*acc >> 64) | ((uint128_t) *hi << 64);
+	*hi = 0;
+	return limb;
+}
+
+/*r = t mod p for the 512 bit product t, the upper half is folded with FIELD_C*/
+static void field_reduce_product(field_element *r, const uint64_t t[8])
+{
+	uint64_t low[4];
+	uint128_t acc = 0;
+
+	for(int i = 0; i < 4; i++)
+	{
+		acc += (uint128_t) t[i + 4] * FIELD_C + t[i];
+		low[i] = (uint64_t) acc;
+		acc >>= 64;
+	}
+
+	field_reduce(r, low, (uint64_t) acc);
+}
+
+void field_mul(field_element *r, const field_element *a, const field_element *b)
+{
+	const uint64_t *x = a->n, *y = b->n;
+	uint64_t t[8];
+	uint128_t acc = 0;
+	uint64_t hi = 0;
+
+	//Product scanning, one column of the 256 x 256 bit product at a time
+	field_muladd(&acc, &hi, x[0], y[0]);
+	t[0] = field_column(&acc, &hi);
+	field_muladd(&acc, &hi, x[0], y[1]);
+	field_muladd(&acc, &hi, x[1], y[0]);
+	t[1] = field_column(&acc, &hi);
+	field_muladd(&acc, &hi, x[0], y[2]);
+	field_muladd(&acc, &hi, x[1], y[1]);
+	field_muladd(&acc, &hi, x[2], y[0]);
+	t[2] = field_column(&acc, &hi);
+	field_muladd(&acc, &hi, x[0], y[3]);
+	field_muladd(&acc, &hi, x[1], y[2]);
+	field_muladd(&acc, &hi, x[2], y[1]);
+	field_muladd(&acc, &hi, x[3], y[0]);
+	t[3] = field_column(&acc, &hi);
+	field_muladd(&acc, &hi, x[1], y[3]);
+	field_muladd(&acc, &hi, x[2], y[2]);
+	field_muladd(&acc, &hi, x[3], y[1]);
+	t[4] = field_column(&acc, &hi);
+	field_muladd(&acc, &hi, x[2], y[3]);
+	field_muladd(&acc, &hi, x[3], y[2]);
+	t[5] = field_column(&acc, &hi);
+	field_muladd(&acc, &hi, x[3], y[3]);
+	t[6] = field_column(&acc, &hi);
+	t[7] = (uint64_t) acc;
+
+	field_reduce_product(r, t);
+}
+
+void field_mul_ui(field_element *r, const field_element *a, uint32_t b)
+{
+	uint64_t t[4];
+	uint128_t acc = 0;
+
+	for(int i = 0; i < 4; i++)
+	{
+		acc += (uint128_t) a->n[i] * b;
+		t[i] = (uint64_t) acc;
+		acc >>= 64;
+	}
+
+	field_reduce(r, t, (uint64_t) acc);
+}
+
+void field_sqr(field_element *r, const field_element *a)
+{
+	const uint64_t *x = a->n;
+	uint64_t t[8];
+	uint128_t acc = 0;
+	uint64_t hi = 0;
+
+	//As field_mul, the products of two different limbs are added twice
+	field_muladd(&acc, &hi, x[0], x[0]);
+	t[0] = field_column(&acc, &hi);
+	field_muladd(&acc, &hi, x[0], x[1]);
+	field_muladd(&acc, &hi, x[0], x[1]);
+	t[1] = field_column(&acc, &hi);
+	field_muladd(&acc, &hi, x[0], x[2]);
+	field_muladd(&acc, &hi, x[0], x[2]);
+	field_muladd(&acc, &hi, x[1], x[1]);
+	t[2] = field_column(&acc, &hi);
+	field_muladd(&acc, &hi, x[0], x[3]);
+	field_muladd(&acc, &hi, x[0], x[3]);
+	field_muladd(&acc, &hi, x[1], x[2]);
+	field_muladd(&acc, &hi, x[1], x[2]);
+	t[3] = field_column(&acc, &hi);
+	field_muladd(&acc, &hi, x[1], x[3]);
+	field_muladd(&acc, &hi, x[1], x[3]);
+	field_muladd(&acc, &hi, x[2], x[2]);
+	t[4] = field_column(&acc, &hi);
+	field_muladd(&acc, &hi, x[2], x[3]);
+	field_muladd(&acc, &hi, x[2], x[3]);
+	t[5] = field_column(&acc, &hi);
+	field_muladd(&acc, &hi, x[3], x[3]);
+	t[6] = field_column(&acc, &hi);
+	t[7] = (uint64_t) acc;
+
+	field_reduce_product(r, t);
+}
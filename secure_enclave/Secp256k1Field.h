@@ -0,0 +1,77 @@
+/*
+    Copyright (C) 2019-Present SKALE Labs
+
+    This file is part of sgxwallet.
+
+    sgxwallet is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as published
+    by the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    sgxwallet is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with sgxwallet.  If not, see <https://www.gnu.org/licenses/>.
+
+    @file Secp256k1Field.h
+    @author Stan Kladko
+    @date 2021
+*/
+
+#ifndef SGXWALLET_SECP256K1FIELD_H
+#define SGXWALLET_SECP256K1FIELD_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+#define EXTERNC extern "C"
+#else
+#define EXTERNC
+#endif
+
+/*
+Elements of the secp256k1 prime field p = 2^256 - 2^32 - 977 in four little endian 64 bit limbs,
+always fully reduced. The operations work on the stack, never allocate and take the same time
+for every value. A product is reduced by folding its upper half with 2^256 = 2^32 + 977 mod p.
+Inversions are left to GMP, see field_inverse in Point.c.
+*/
+typedef struct field_element_s
+{
+	uint64_t n[4];
+} field_element;
+
+/*Set r from a GMP integer, returns false unless 0 <= a < p*/
+EXTERNC bool field_set_mpz(field_element *r, mpz_t a);
+
+/*Set the GMP integer r to a*/
+EXTERNC void field_get_mpz(mpz_t r, const field_element *a);
+
+EXTERNC void field_set_ui(field_element *r, uint64_t a);
+
+EXTERNC bool field_is_zero(const field_element *a);
+
+EXTERNC bool field_equal(const field_element *a, const field_element *b);
+
+/*r = a + b mod p*/
+EXTERNC void field_add(field_element *r, const field_element *a, const field_element *b);
+
+/*r = a - b mod p*/
+EXTERNC void field_sub(field_element *r, const field_element *a, const field_element *b);
+
+/*r = -a mod p*/
+EXTERNC void field_neg(field_element *r, const field_element *a);
+
+/*r = a * b mod p*/
+EXTERNC void field_mul(field_element *r, const field_element *a, const field_element *b);
+
+/*r = a * b mod p for a small b*/
+EXTERNC void field_mul_ui(field_element *r, const field_element *a, uint32_t b);
+
+/*r = a² mod p*/
+EXTERNC void field_sqr(field_element *r, const field_element *a);
+
+#endif
@@ -39,6 +39,7 @@
 #else
 
 #include <../tgmp-build/include/sgx_tgmp.h>
+#include "sgx_thread.h"
 
 #endif
 
@@ -46,6 +47,7 @@
 #include "Point.h"
 #include "NumberTheory.h"
 #include "Signature.h"
+#include "EnclaveConstants.h"
 
 /*Initialize a signature*/
 signature signature_init() {
@@ -98,61 +100,325 @@ bool signature_cmp(signature sig1, signature sig2) {
     return !mpz_cmp(sig1->r, sig2->r) && !mpz_cmp(sig1->s, sig2->s);
 }
 
+/*
+Per thread scratch variables of signing and verification, preallocated with POINT_WORKSPACE_BITS
+of limbs on first use and never released, so that signatures do no enclave heap traffic.
+*/
+typedef struct signature_workspace_s {
+    bool ready;
+    point Q, x;
+    mpz_t k, r, t1, t2, t3, t4, t5, s, n_div_2, seed, s_mul_2;
+    mpz_t w, u1, u2, t;
+    mpz_t pool_k, pool_r;
+} signature_workspace;
+
+static __thread signature_workspace sig_workspace;
+
+static signature_workspace *get_signature_workspace() {
+    signature_workspace *ws = &sig_workspace;
+    if (ws->ready)
+        return ws;
+
+    mpz_ptr vars[] = {ws->k, ws->r, ws->t1, ws->t2, ws->t3, ws->t4, ws->t5, ws->s, ws->n_div_2,
+                      ws->seed, ws->s_mul_2, ws->w, ws->u1, ws->u2, ws->t, ws->pool_k, ws->pool_r};
+    for (size_t i = 0; i < sizeof(vars) / sizeof(vars[0]); i++)
+        mpz_init2(vars[i], POINT_WORKSPACE_BITS);
+
+    ws->Q = point_init();
+    ws->x = point_init();
+
+    ws->ready = true;
+    return ws;
+}
+
 /*Generates a public key for a private key*/
 void signature_extract_public_key(point public_key, mpz_t private_key, domain_parameters curve) {
-    point_multiplication(public_key, private_key, curve->G, curve);
+    point_fixed_base_multiplication(public_key, private_key, curve);
 }
 
 #ifndef USER_SPACE
 
-/*Generate signature for a message*/
-void signature_sign(signature sig, mpz_t message, mpz_t private_key, domain_parameters curve) {
-    //message must not have a bit length longer than that of n
-    if (mpz_sizeinbase(message, 2) > mpz_sizeinbase(curve->n, 2)) {
-        LOG_ERROR("mpz_sizeinbase(message, 2) > mpz_sizeinbase(curve->n, 2))");
+/*Zero all limbs of x, mpz_set_ui alone leaves the old high limbs in memory*/
+static void wipe_mpz(mpz_t x) {
+    memset(x->_mp_d, 0, x->_mp_alloc * sizeof(mp_limb_t));
+    x->_mp_size = 0;
+}
+
+/*Draw a fresh nonce k and compute r = (kG).x mod n and the parity of (kG).y, retrying while r = 0*/
+static void generate_nonce(mpz_t k, mpz_t r, unsigned *y_parity, domain_parameters curve) {
+    signature_workspace *ws = get_signature_workspace();
+
+    SAFE_CHAR_BUF(rand_char, 32);
+
+    do {
+        get_global_random(rand_char, 32);
+        mpz_import(ws->seed, 32, 1, sizeof(rand_char[0]), 0, 0, rand_char);
+        mpz_mod(k, ws->seed, curve->p);
+        point_fixed_base_multiplication(ws->Q, k, curve);
+        mpz_mod(r, ws->Q->x, curve->n);
+    } while (!mpz_sgn(r));
+
+    *y_parity = mpz_tstbit(ws->Q->y, 0);
+
+    memset(rand_char, 0, sizeof(rand_char));
+    wipe_mpz(ws->seed);
+}
+
+/*
+Pool of precomputed (k, r) pairs, refilled by trustedRefillEcdsaNoncePool while the host is idle.
+An entry is copied out and wiped under the pool mutex, so every nonce signs at most one message.
+The pool lives only in enclave memory and starts empty after each enclave restart.
+*/
+typedef struct nonce_pool_entry_s {
+    mpz_t k;
+    mpz_t r;
+    unsigned y_parity;
+} nonce_pool_entry;
+
+static nonce_pool_entry nonce_pool[NONCE_POOL_CAPACITY];
+
+static uint64_t nonce_pool_count = 0;
+
+static bool nonce_pool_ready = false;
+
+static sgx_thread_mutex_t nonce_pool_mutex = SGX_THREAD_MUTEX_INITIALIZER;
+
+/*Must be called with nonce_pool_mutex held*/
+static void nonce_pool_init() {
+    if (nonce_pool_ready)
         return;
+    for (uint64_t i = 0; i < NONCE_POOL_CAPACITY; i++) {
+        mpz_init2(nonce_pool[i].k, 256);
+        mpz_init2(nonce_pool[i].r, 256);
+    }
+    nonce_pool_ready = true;
+}
+
+/*Move the most recently added nonce out of the pool, returns false if the pool is empty*/
+static bool nonce_pool_take(mpz_t k, mpz_t r, unsigned *y_parity) {
+    bool found = false;
+
+    sgx_thread_mutex_lock(&nonce_pool_mutex);
+    if (nonce_pool_count > 0) {
+        nonce_pool_entry *entry = &nonce_pool[--nonce_pool_count];
+        mpz_set(k, entry->k);
+        mpz_set(r, entry->r);
+        *y_parity = entry->y_parity;
+        wipe_mpz(entry->k);
+        wipe_mpz(entry->r);
+        entry->y_parity = 0;
+        found = true;
     }
+    sgx_thread_mutex_unlock(&nonce_pool_mutex);
 
-    //Initializing variables
-    point Q = point_init();
-    mpz_t k, x, r, t1, t2, t3, t4, t5, s, n_div_2, rem, neg, seed,  s_mul_2;
-    mpz_init(k);
-    mpz_init(x);
-    mpz_init(r);
-    mpz_init(t1);
-    mpz_init(t2);
-    mpz_init(t3);
-    mpz_init(s);
-    mpz_init(t4);
-    mpz_init(t5);
-    mpz_init(n_div_2);
-    mpz_init(rem);
-    mpz_init(neg);
-    mpz_init(seed);
-    mpz_init(s_mul_2);
+    return found;
+}
+
+uint64_t signature_nonce_pool_size() {
+    sgx_thread_mutex_lock(&nonce_pool_mutex);
+    uint64_t size = nonce_pool_count;
+    sgx_thread_mutex_unlock(&nonce_pool_mutex);
+    return size;
+}
+
+/*Add up to count nonces to the pool, the expensive k*G is computed without holding the mutex*/
+uint64_t signature_nonce_pool_refill(uint64_t count, domain_parameters curve) {
+    signature_workspace *ws = get_signature_workspace();
+
+    for (uint64_t i = 0; i < count; i++) {
+        if (signature_nonce_pool_size() >= NONCE_POOL_CAPACITY)
+            break;
+
+        unsigned y_parity = 0;
+        generate_nonce(ws->pool_k, ws->pool_r, &y_parity, curve);
+
+        sgx_thread_mutex_lock(&nonce_pool_mutex);
+        nonce_pool_init();
+        if (nonce_pool_count < NONCE_POOL_CAPACITY) {
+            nonce_pool_entry *entry = &nonce_pool[nonce_pool_count++];
+            mpz_set(entry->k, ws->pool_k);
+            mpz_set(entry->r, ws->pool_r);
+            entry->y_parity = y_parity;
+        }
+        sgx_thread_mutex_unlock(&nonce_pool_mutex);
+
+        wipe_mpz(ws->pool_k);
+    }
+
+    return signature_nonce_pool_size();
+}
+
+/*
+Pool of pregenerated ECDSA key pairs for trustedGenerateEcdsaKey, which also makes the ephemeral
+keys of DKG shares, refilled by trustedRefillEcdsaKeyPool. Like the nonce pool it lives only in enclave
+memory and an entry is wiped when it is taken, the keys are encrypted only after they leave the pool.
+*/
+typedef struct key_pool_entry_s {
+    mpz_t skey;
+    point pub_key;
+} key_pool_entry;
+
+static key_pool_entry key_pool[KEY_POOL_CAPACITY];
+
+static uint64_t key_pool_count = 0;
+
+static bool key_pool_ready = false;
+
+static sgx_thread_mutex_t key_pool_mutex = SGX_THREAD_MUTEX_INITIALIZER;
+
+/*Must be called with key_pool_mutex held*/
+static void key_pool_init() {
+    if (key_pool_ready)
+        return;
+    for (uint64_t i = 0; i < KEY_POOL_CAPACITY; i++) {
+        mpz_init2(key_pool[i].skey, 256);
+        key_pool[i].pub_key = point_init();
+    }
+    key_pool_ready = true;
+}
+
+bool signature_key_pool_take(mpz_t skey, point pub_key) {
+    bool found = false;
+
+    sgx_thread_mutex_lock(&key_pool_mutex);
+    if (key_pool_count > 0) {
+        key_pool_entry *entry = &key_pool[--key_pool_count];
+        mpz_set(skey, entry->skey);
+        point_copy(pub_key, entry->pub_key);
+        wipe_mpz(entry->skey);
+        found = true;
+    }
+    sgx_thread_mutex_unlock(&key_pool_mutex);
+
+    return found;
+}
+
+uint64_t signature_key_pool_size() {
+    sgx_thread_mutex_lock(&key_pool_mutex);
+    uint64_t size = key_pool_count;
+    sgx_thread_mutex_unlock(&key_pool_mutex);
+    return size;
+}
+
+/*Add up to count key pairs to the pool, the expensive d*G is computed without holding the mutex*/
+uint64_t signature_key_pool_refill(uint64_t count, domain_parameters curve) {
+    signature_workspace *ws = get_signature_workspace();
 
     SAFE_CHAR_BUF(rand_char, 32);
 
-    get_global_random(rand_char, 32);
+    for (uint64_t i = 0; i < count; i++) {
+        if (signature_key_pool_size() >= KEY_POOL_CAPACITY)
+            break;
+
+        get_global_random(rand_char, 32);
+        mpz_import(ws->seed, 32, 1, sizeof(rand_char[0]), 0, 0, rand_char);
+        mpz_mod(ws->pool_k, ws->seed, curve->p);
+        point_fixed_base_multiplication(ws->Q, ws->pool_k, curve);
+
+        sgx_thread_mutex_lock(&key_pool_mutex);
+        key_pool_init();
+        if (key_pool_count < KEY_POOL_CAPACITY) {
+            key_pool_entry *entry = &key_pool[key_pool_count++];
+            mpz_set(entry->skey, ws->pool_k);
+            point_copy(entry->pub_key, ws->Q);
+        }
+        sgx_thread_mutex_unlock(&key_pool_mutex);
+
+        wipe_mpz(ws->pool_k);
+        wipe_mpz(ws->seed);
+    }
+
+    memset(rand_char, 0, sizeof(rand_char));
+
+    return signature_key_pool_size();
+}
+
+/*
+Sampled self check of the signer. Every ECDSA_SELF_CHECK_INTERVAL-th signature of a thread is copied
+here and verified later by signature_check_sample, which the host calls from its background log flush,
+so no sign request waits for a verification. A failed check is sticky and makes every later sign fail.
+*/
+static mpz_t sample_message, sample_key;
+
+static signature sample_sig = NULL;
+
+static bool sample_pending = false;
+
+static volatile bool self_check_failed = false;
+
+static __thread uint64_t sign_counter = 0;
+
+static sgx_thread_mutex_t sample_mutex = SGX_THREAD_MUTEX_INITIALIZER;
+
+void signature_sample(mpz_t message, signature sig, mpz_t private_key) {
+    if (++sign_counter % ECDSA_SELF_CHECK_INTERVAL != 0)
+        return;
+
+    // a signer never waits here, the sample is skipped while a check is running
+    if (sgx_thread_mutex_trylock(&sample_mutex) != 0)
+        return;
+
+    if (!sample_sig) {
+        mpz_init2(sample_message, 256);
+        mpz_init2(sample_key, 256);
+        sample_sig = signature_init();
+    }
+
+    if (!sample_pending) {
+        mpz_set(sample_message, message);
+        mpz_set(sample_key, private_key);
+        mpz_set(sample_sig->r, sig->r);
+        mpz_set(sample_sig->s, sig->s);
+        sample_sig->v = sig->v;
+        sample_pending = true;
+    }
+
+    sgx_thread_mutex_unlock(&sample_mutex);
+}
+
+bool signature_check_sample(domain_parameters curve) {
+    sgx_thread_mutex_lock(&sample_mutex);
+
+    if (sample_pending) {
+        point public_key = point_init();
+        signature_extract_public_key(public_key, sample_key, curve);
 
-    signature_sign_start:
+        if (!signature_verify(sample_message, sample_sig, public_key, curve)) {
+            LOG_ERROR("ECDSA self check failed, signing is disabled");
+            self_check_failed = true;
+        }
 
+        point_clear(public_key);
+        wipe_mpz(sample_key);
+        sample_pending = false;
+    }
 
-    get_global_random(rand_char, 32);
+    sgx_thread_mutex_unlock(&sample_mutex);
 
-    mpz_import(seed, 32, 1, sizeof(rand_char[0]), 0, 0, rand_char);
+    return !self_check_failed;
+}
 
-    mpz_mod(k, seed, curve->p);
+bool signature_self_check_failed() {
+    return self_check_failed;
+}
 
-    //Calculate x
-    point_multiplication(Q, k, curve->G, curve);
-    mpz_set(x, Q->x);
+/*Generate signature for a message*/
+void signature_sign(signature sig, mpz_t message, mpz_t private_key, domain_parameters curve) {
+    //message must not have a bit length longer than that of n
+    if (mpz_sizeinbase(message, 2) > mpz_sizeinbase(curve->n, 2)) {
+        LOG_ERROR("mpz_sizeinbase(message, 2) > mpz_sizeinbase(curve->n, 2))");
+        return;
+    }
 
-    //Calculate r
-    mpz_mod(r, x, curve->n);
-    if (!mpz_sgn(r))    //Start over if r=0, note haven't been tested memory might die :)
-        goto signature_sign_start;
+    //Variables from the thread workspace
+    signature_workspace *ws = get_signature_workspace();
+    mpz_ptr k = ws->k, r = ws->r, t1 = ws->t1, t2 = ws->t2, t3 = ws->t3, t4 = ws->t4, t5 = ws->t5, s = ws->s,
+            n_div_2 = ws->n_div_2, s_mul_2 = ws->s_mul_2;
 
+    //Take k and r from the pool, compute them inline if it is empty or disabled
+    unsigned y_parity = 0;
+    if (!nonce_pool_take(k, r, &y_parity))
+        generate_nonce(k, r, &y_parity, curve);
 
     //Calculate s
     //s = k¯¹(e+d*r) mod n = (k¯¹ mod n) * ((e+d*r) mod n) mod n
@@ -166,45 +432,31 @@ void signature_sign(signature sig, mpz_t message, mpz_t private_key, domain_para
 
     //Calculate v
 
-    mpz_mod_ui(rem, Q->y, 2);
-
     mpz_mul_ui(s_mul_2, s, 2);
 
     unsigned b = 0;
     if (mpz_cmp(s_mul_2, curve->n) > 0) {
         b = 1;
     }
-    sig->v = mpz_get_ui(rem) ^ b;
+    sig->v = y_parity ^ b;
 
     mpz_cdiv_q_ui(n_div_2, curve->n, 2);
 
     if (mpz_cmp(s, n_div_2) > 0) {
-        mpz_sub(neg, curve->n, s);
-        mpz_set(s, neg);
+        mpz_sub(s, curve->n, s);
     }
 
     //Set signature
     mpz_set(sig->r, r);
     mpz_set(sig->s, s);
 
-
-    point_clear(Q);
-    mpz_clear(k);
-    mpz_clear(s);
-    mpz_clear(r);
-    mpz_clear(x);
-    mpz_clear(rem);
-    mpz_clear(neg);
-    mpz_clear(t1);
-    mpz_clear(t2);
-    mpz_clear(t3);
-    mpz_clear(t4);
-    mpz_clear(t5);
-    mpz_clear(seed);
-    mpz_clear(n_div_2);
-    mpz_clear(s_mul_2);
-
-
+    //Nonce and intermediates stay in the workspace, so wipe the secret ones
+    wipe_mpz(k);
+    wipe_mpz(t1);
+    wipe_mpz(t2);
+    wipe_mpz(t3);
+    wipe_mpz(t4);
+    wipe_mpz(t5);
 }
 
 #endif
@@ -214,29 +466,16 @@ void signature_sign(signature sig, mpz_t message, mpz_t private_key, domain_para
 /*Verify the integrity of a message using it's signature*/
 bool signature_verify(mpz_t message, signature sig, point public_key, domain_parameters curve) {
 
-    //Initialize variables
-    mpz_t one, w, u1, u2, t, tt2;
-    mpz_init(one);
-    mpz_init(w);
-    mpz_init(u1);
-    mpz_init(u2);
-    mpz_init(t);
-    mpz_init(tt2);
+    //Variables from the thread workspace
+    signature_workspace *ws = get_signature_workspace();
+    mpz_ptr w = ws->w, u1 = ws->u1, u2 = ws->u2, t = ws->t, tt2 = ws->t1;
+    point x = ws->x;
 
-    mpz_set_ui(one, 1);
-
-    point x = point_init();
-    point t1 = point_init();
-    point t2 = point_init();
-
-    bool result = false;
-
-
-    if (mpz_cmp(sig->r, one) < 0 &&
+    if (mpz_cmp_ui(sig->r, 1) < 0 &&
         mpz_cmp(curve->n, sig->r) <= 0 &&
-        mpz_cmp(sig->s, one) < 0 &&
+        mpz_cmp_ui(sig->s, 1) < 0 &&
         mpz_cmp(curve->n, sig->s) <= 0) {
-        goto clean;
+        return false;
     }
 
     //w = s¯¹ mod n
@@ -252,31 +491,11 @@ bool signature_verify(mpz_t message, signature sig, point public_key, domain_par
     mpz_mod(u2, t, curve->n);
 
     //x = u1*G+u2*Q
-    point_multiplication(t1, u1, curve->G, curve);
-    point_multiplication(t2, u2, public_key, curve);
-    point_addition(x, t1, t2, curve);
+    point_linear_combination(x, u1, curve->G, u2, public_key, curve);
 
     //Get the result, by comparing x value with r and verifying that x is NOT at infinity
-
-    result = mpz_cmp(sig->r, x->x) == 0 && !x->infinity;
-
-
-    clean:
-
-
-    point_clear(x);
-    point_clear(t1);
-    point_clear(t2);
-
-    mpz_clear(one);
-    mpz_clear(w);
-    mpz_clear(u1);
-    mpz_clear(u2);
-    mpz_clear(t);
-    mpz_clear(tt2);
-
-    return result;
-
+    return mpz_cmp(sig->r, x->x) == 0 && !x->infinity;
 }
 
 
+
@@ -70,6 +70,30 @@ EXTERNC void signature_extract_public_key(point public_key, mpz_t private_key, d
 /*Generate signature for a message*/
 EXTERNC void signature_sign(signature sig, mpz_t message, mpz_t private_key, domain_parameters curve);
 
+/*Precompute up to count nonces for signature_sign into the enclave nonce pool, returns the pool size*/
+EXTERNC uint64_t signature_nonce_pool_refill(uint64_t count, domain_parameters curve);
+
+/*Number of precomputed nonces left in the pool*/
+EXTERNC uint64_t signature_nonce_pool_size();
+
+/*Pregenerate up to count ECDSA key pairs into the enclave key pool, returns the pool size*/
+EXTERNC uint64_t signature_key_pool_refill(uint64_t count, domain_parameters curve);
+
+/*Move a pregenerated key pair out of the pool, returns false if the pool is empty*/
+EXTERNC bool signature_key_pool_take(mpz_t skey, point pub_key);
+
+/*Number of pregenerated key pairs left in the pool*/
+EXTERNC uint64_t signature_key_pool_size();
+
+/*Keep every ECDSA_SELF_CHECK_INTERVAL-th signature of the calling thread for signature_check_sample*/
+EXTERNC void signature_sample(mpz_t message, signature sig, mpz_t private_key);
+
+/*Verify the pending sample, returns false once any sample failed*/
+EXTERNC bool signature_check_sample(domain_parameters curve);
+
+/*True after a sample failed, signing must then be refused*/
+EXTERNC bool signature_self_check_failed();
+
 /*Verify the integrity of a message using it's signature*/
 EXTERNC bool signature_verify(mpz_t message, signature sig, point public_key, domain_parameters curve);
 
@@ -208,4 +208,109 @@ EXTERNC int getDecryptionShare(char* skey_hex, char* decryptionValue, char* decr
     return ret;
 }
 
+static bool fqFromLimbs(const uint64_t *_limbs, libff::alt_bn128_Fq &_fq) {
+    libff::bigint<libff::alt_bn128_q_limbs> value;
+
+    for (int i = 0; i < BLS_FQ_LIMBS; i++) {
+        value.data[i] = _limbs[i];
+    }
+
+    if (mpn_cmp(value.data, libff::alt_bn128_modulus_q.data, libff::alt_bn128_q_limbs) >= 0) {
+        return false;
+    }
+
+    _fq = libff::alt_bn128_Fq(value);
+    return true;
+}
+
+static void fqToLimbs(const libff::alt_bn128_Fq &_fq, uint64_t *_limbs) {
+    auto value = _fq.as_bigint();
+
+    for (int i = 0; i < BLS_FQ_LIMBS; i++) {
+        _limbs[i] = value.data[i];
+    }
+}
+
+EXTERNC int getDecryptionShares(const char *skey_hex, const uint64_t *values, uint64_t _count, uint64_t *shares) {
+    mpz_t skey;
+    mpz_init(skey);
+
+    int ret = 1;
+
+    CHECK_ARG_CLEAN(skey_hex);
+    CHECK_ARG_CLEAN(values);
+    CHECK_ARG_CLEAN(shares);
+
+    try {
+        if (mpz_set_str(skey, skey_hex, 16) == -1) {
+            goto clean;
+        }
+
+        SAFE_CHAR_BUF(skey_dec, BUF_LEN);
+        mpz_get_str(skey_dec, 10, skey);
+
+        libff::alt_bn128_Fr bls_skey(skey_dec);
+        auto multiplier = bls_skey.as_bigint();
+
+        std::vector<libff::alt_bn128_G2> share_points(_count);
+
+        for (uint64_t i = 0; i < _count; i++) {
+            const uint64_t *value = values + i * BLS_G2_LIMBS;
+
+            libff::alt_bn128_G2 decryption_value;
+            decryption_value.Z = libff::alt_bn128_Fq2::one();
+
+            if (!fqFromLimbs(value, decryption_value.X.c0) ||
+                !fqFromLimbs(value + BLS_FQ_LIMBS, decryption_value.X.c1) ||
+                !fqFromLimbs(value + 2 * BLS_FQ_LIMBS, decryption_value.Y.c0) ||
+                !fqFromLimbs(value + 3 * BLS_FQ_LIMBS, decryption_value.Y.c1)) {
+                LOG_ERROR("Decryption value coordinate is not a field element");
+                goto clean;
+            }
+
+            if (!decryption_value.is_well_formed()) {
+                goto clean;
+            }
+
+            share_points[i] = multiplier * decryption_value;
+        }
+
+        // one inversion for all shares unless one of them is zero
+        bool all_non_zero = true;
+        for (auto &&point : share_points) {
+            all_non_zero = all_non_zero && !point.is_zero();
+        }
+
+        if (all_non_zero) {
+            libff::alt_bn128_G2::batch_to_special_all_non_zeros(share_points);
+        } else {
+            for (auto &&point : share_points) {
+                point.to_affine_coordinates();
+            }
+        }
+
+        for (uint64_t i = 0; i < _count; i++) {
+            uint64_t *share = shares + i * BLS_G2_LIMBS;
+            fqToLimbs(share_points[i].X.c0, share);
+            fqToLimbs(share_points[i].X.c1, share + BLS_FQ_LIMBS);
+            fqToLimbs(share_points[i].Y.c0, share + 2 * BLS_FQ_LIMBS);
+            fqToLimbs(share_points[i].Y.c1, share + 3 * BLS_FQ_LIMBS);
+        }
+
+        memset(skey_dec, 0, BUF_LEN);
+
+        ret = 0;
+    } catch (std::exception &e) {
+        LOG_ERROR(e.what());
+    } catch (...) {
+        LOG_ERROR("Unknown throwable");
+    }
+
+    clean:
+    if (skey->_mp_d)
+        memset(skey->_mp_d, 0, skey->_mp_alloc * sizeof(mp_limb_t));
+    mpz_clear(skey);
+    return ret;
+}
+
 #endif
@@ -39,4 +39,8 @@
 
 EXTERNC int getDecryptionShare(char* secret, char* decryptionValue, char* decryption_share);
 
+// computes _count decryption shares with one parse of the key, values and shares are
+// BLS_G2_LIMBS limbs each (X.c0, X.c1, Y.c0, Y.c1), shares are affine
+EXTERNC int getDecryptionShares(const char* skey_hex, const uint64_t* values, uint64_t _count, uint64_t* shares);
+
 #endif
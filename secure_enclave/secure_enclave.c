@@ -59,6 +59,9 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #include "EnclaveConstants.h"
 #include "EnclaveCommon.h"
+#include "KeyCache.h"
+#include "ScratchArena.h"
+#include "Drbg.h"
 #include "SIGNED_ENCLAVE_VERSION"
 
 
@@ -99,6 +102,8 @@ LOG_ERROR(errString); \
 goto clean; \
 };
 
+void *(*gmp_alloc_func)(size_t);
+
 void *(*gmp_realloc_func)(void *, size_t, size_t);
 
 void *(*oc_realloc_func)(void *, size_t, size_t);
@@ -107,12 +112,12 @@ void (*gmp_free_func)(void *, size_t);
 
 void (*oc_free_func)(void *, size_t);
 
+void *allocate_function(size_t);
+
 void *reallocate_function(void *, size_t, size_t);
 
 void free_function(void *, size_t);
 
-unsigned char *globalRandom = NULL;
-
 
 #define CALL_ONCE \
     static volatile bool called = false;\
@@ -122,6 +127,37 @@ unsigned char *globalRandom = NULL;
         abort(); \
     } else {called = true;};
 
+// called by the host once the servers are up, until then ECDSA uses the generic multiplication code
+void trustedPrecomputeTables() {
+    enclave_precompute();
+}
+
+// enclave heap used by GMP numbers, updated by the GMP memory hooks below
+static volatile uint64_t gmpHeapBytes = 0;
+
+static volatile uint64_t gmpHeapPeakBytes = 0;
+
+static void trackGmpHeap(int64_t _delta) {
+    uint64_t bytes = __atomic_add_fetch(&gmpHeapBytes, (uint64_t) _delta, __ATOMIC_RELAXED);
+    uint64_t peak = __atomic_load_n(&gmpHeapPeakBytes, __ATOMIC_RELAXED);
+    while (bytes > peak &&
+           !__atomic_compare_exchange_n(&gmpHeapPeakBytes, &peak, bytes, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+    }
+}
+
+// the host calls this periodically anyway, so heap statistics are returned with it instead of a separate ECALL
+void trustedFlushLog(uint64_t *gmpHeapBytesOut, uint64_t *gmpHeapPeakBytesOut) {
+    // the sampled ECDSA self check runs here, off the sign path, see signature_sample
+    signature_check_sample(curve);
+
+    flushLog();
+
+    if (gmpHeapBytesOut)
+        *gmpHeapBytesOut = __atomic_load_n(&gmpHeapBytes, __ATOMIC_RELAXED);
+    if (gmpHeapPeakBytesOut)
+        *gmpHeapPeakBytesOut = __atomic_load_n(&gmpHeapPeakBytes, __ATOMIC_RELAXED);
+}
+
 void trustedEnclaveInit(uint64_t _logLevel) {
     CALL_ONCE
     LOG_INFO(__FUNCTION__);
@@ -133,8 +169,8 @@ void trustedEnclaveInit(uint64_t _logLevel) {
 
     LOG_INFO("Setting memory functions");
 
-    mp_get_memory_functions(NULL, &gmp_realloc_func, &gmp_free_func);
-    mp_set_memory_functions(NULL, oc_realloc_func, oc_free_func);
+    mp_get_memory_functions(&gmp_alloc_func, &gmp_realloc_func, &gmp_free_func);
+    mp_set_memory_functions(&allocate_function, oc_realloc_func, oc_free_func);
 
     LOG_INFO("Calling enclave init");
 
@@ -142,16 +178,16 @@ void trustedEnclaveInit(uint64_t _logLevel) {
 
     LOG_INFO("Reading random");
 
-    globalRandom = calloc(32,1);
-
-    int ret = sgx_read_rand(globalRandom, 32);
+    unsigned char probe[32];
 
-    if(ret != SGX_SUCCESS)
+    if (drbg_generate(probe, sizeof(probe)) != 0)
     {
         LOG_ERROR("sgx_read_rand failed. Aboring enclave.");
         abort();
     }
 
+    memset(probe, 0, sizeof(probe));
+
     LOG_INFO("Successfully inited enclave. Signed enclave version:" SIGNED_ENCLAVE_VERSION );
 #ifdef SGX_DEBUG
     LOG_INFO("SECURITY WARNING: sgxwallet is running in INSECURE DEBUG MODE! NEVER USE IN PRODUCTION!");
@@ -165,12 +201,20 @@ void trustedEnclaveInit(uint64_t _logLevel) {
     LOG_INFO("SECURITY WARNING: sgxwallet is running in INSECURE SIMULATION MODE! NEVER USE IN PRODUCTION!");
 #endif
 
+    flushLog();
+}
+
+void *allocate_function(size_t sz) {
+    void *ptr = gmp_alloc_func(sz);
+    trackGmpHeap(sz);
+    return ptr;
 }
 
 void free_function(void *ptr, size_t sz) {
-    if (sgx_is_within_enclave(ptr, sz))
+    if (sgx_is_within_enclave(ptr, sz)) {
         gmp_free_func(ptr, sz);
-    else {
+        trackGmpHeap(-(int64_t) sz);
+    } else {
         sgx_status_t status;
 
         status = oc_free(ptr, sz);
@@ -184,7 +228,9 @@ void *reallocate_function(void *ptr, size_t osize, size_t nsize) {
     sgx_status_t status;
 
     if (sgx_is_within_enclave(ptr, osize)) {
-        return gmp_realloc_func(ptr, osize, nsize);
+        void *result = gmp_realloc_func(ptr, osize, nsize);
+        trackGmpHeap((int64_t) nsize - (int64_t) osize);
+        return result;
     }
 
     status = oc_realloc(&nptr, ptr, osize, nsize);
@@ -203,33 +249,65 @@ void *reallocate_function(void *ptr, size_t osize, size_t nsize) {
     return (void *) nptr;
 }
 
-volatile uint64_t counter;
+// The sign ECALLs get a [user_check] error buffer of ERR_STRING_LEN bytes and fill it only on
+// failure, so successful calls do not copy the error string out of the enclave
+static void copyErrorStringOut(int _errStatus, const char *_errString, char *_errStringOut) {
+    if (_errStatus == 0 || !_errStringOut)
+        return;
 
-void get_global_random(unsigned char *_randBuff, uint64_t _size) {
-    char errString[BUF_LEN];
-    int status;
-    int *errStatus = &status;
+    if (!sgx_is_outside_enclave(_errStringOut, ERR_STRING_LEN))
+        abort();
 
-    INIT_ERROR_STATE
+    uint64_t len = strnlen(_errString, ERR_STRING_LEN - 1);
+    memcpy(_errStringOut, _errString, len);
+    _errStringOut[len] = 0;
+}
+
+// paranoid mode, see trustedSetVerifyEncryption
+static volatile bool verifyEncryption = false;
+
+void trustedSetVerifyEncryption(uint8_t _verify) {
+    verifyEncryption = _verify != 0;
+}
+
+// In paranoid mode a newly encrypted secret is decrypted again and compared with the plaintext.
+// Otherwise the GCM tag, which every later AES_decrypt checks, is trusted.
+static int checkEncryption(const char *_plaintext, uint8_t *_encrypted, uint64_t _encLen, uint64_t _maxLen) {
+    if (!verifyEncryption)
+        return 0;
+
+    SAFE_CHAR_BUF(decrypted, _maxLen);
+
+    uint8_t type = 0;
+    uint8_t exportable = 0;
+
+    int status = AES_decrypt(_encrypted, _encLen, decrypted, _maxLen, &type, &exportable);
 
-    CHECK_STATE(_size <= 32)
-    CHECK_STATE(_randBuff);
+    if (status == 0 && strncmp(_plaintext, decrypted, _maxLen) != 0)
+        status = -8;
 
-    counter++;
-    sgx_sha_state_handle_t shaStateHandle;
-    CHECK_STATE(sgx_sha256_init(&shaStateHandle) == SGX_SUCCESS);
-    CHECK_STATE(sgx_sha256_update(globalRandom, 32, shaStateHandle) == SGX_SUCCESS);
-    CHECK_STATE(sgx_sha256_update(&counter, sizeof(counter), shaStateHandle) == SGX_SUCCESS);
-    CHECK_STATE(sgx_sha256_get_hash(shaStateHandle, (sgx_sha256_hash_t *)globalRandom) == SGX_SUCCESS);
-    CHECK_STATE(sgx_sha256_close(shaStateHandle) == SGX_SUCCESS);
+    memset(decrypted, 0, _maxLen);
 
-    memcpy(_randBuff, globalRandom, _size);
+    return status;
 }
 
-void sealHexSEK(int *errStatus, char *errString,
-                        uint8_t *encrypted_sek, uint64_t *enc_len, char *sek_hex) {
-    CALL_ONCE
-    LOG_INFO(__FUNCTION__);
+// every TCS draws from its own DRBG, see Drbg.h. Without randomness no key or nonce is safe, so a
+// failing generator aborts the enclave like a failing sgx_read_rand at init
+void get_global_random(unsigned char *_randBuff, uint64_t _size) {
+    if (!_randBuff) {
+        LOG_ERROR("Null buffer in get_global_random");
+        return;
+    }
+
+    if (drbg_generate(_randBuff, _size) != 0) {
+        LOG_ERROR("DRBG failed. Aborting enclave.");
+        abort();
+    }
+}
+
+static void sealSEK(int *errStatus, char *errString,
+                    uint8_t *encrypted_sek, uint64_t *enc_len, char *sek_hex) {
+    LOG_DEBUG(__FUNCTION__);
     INIT_ERROR_STATE
 
     CHECK_STATE(encrypted_sek);
@@ -267,14 +345,20 @@ void sealHexSEK(int *errStatus, char *errString,
 
     SET_SUCCESS
     clean:
-    LOG_INFO(__FUNCTION__ );
-    LOG_INFO("SGX call completed");
+    LOG_DEBUG(__FUNCTION__ );
+    LOG_DEBUG("SGX call completed");
+}
+
+void sealHexSEK(int *errStatus, char *errString,
+                        uint8_t *encrypted_sek, uint64_t *enc_len, char *sek_hex) {
+    CALL_ONCE
+    sealSEK(errStatus, errString, encrypted_sek, enc_len, sek_hex);
 }
 
 void trustedGenerateSEK(int *errStatus, char *errString,
                         uint8_t *encrypted_sek, uint64_t *enc_len, char *sek_hex) {
     CALL_ONCE
-    LOG_INFO(__FUNCTION__);
+    LOG_DEBUG(__FUNCTION__);
     INIT_ERROR_STATE
 
     CHECK_STATE(encrypted_sek);
@@ -284,6 +368,7 @@ void trustedGenerateSEK(int *errStatus, char *errString,
 
     carray2Hex((uint8_t*) SEK_raw, SGX_AESGCM_KEY_SIZE, sek_hex);
     memcpy(AES_key[512], SEK_raw, SGX_AESGCM_KEY_SIZE);
+    key_cache_clear();
 
     sealHexSEK(errStatus, errString, encrypted_sek, enc_len, sek_hex);
 
@@ -295,13 +380,13 @@ void trustedGenerateSEK(int *errStatus, char *errString,
 
     SET_SUCCESS
     clean:
-    LOG_INFO(__FUNCTION__ );
-    LOG_INFO("SGX call completed");
+    LOG_DEBUG(__FUNCTION__ );
+    LOG_DEBUG("SGX call completed");
 }
 
 void trustedSetSEK(int *errStatus, char *errString, uint8_t *encrypted_sek) {
     CALL_ONCE
-    LOG_INFO(__FUNCTION__);
+    LOG_DEBUG(__FUNCTION__);
     INIT_ERROR_STATE
     CHECK_STATE(encrypted_sek);
     SAFE_CHAR_BUF(aes_key_hex, BUF_LEN);
@@ -326,16 +411,19 @@ void trustedSetSEK(int *errStatus, char *errString, uint8_t *encrypted_sek) {
 
     hex2carray(aes_key_hex, &len, (uint8_t *) (AES_key[512]));
 
+    // cached keys were decrypted under the previous SEK
+    key_cache_clear();
+
     SET_SUCCESS
     clean:
-    LOG_INFO(__FUNCTION__ );
-    LOG_INFO("SGX call completed");
+    LOG_DEBUG(__FUNCTION__ );
+    LOG_DEBUG("SGX call completed");
 }
 
 void trustedSetSEKBackup(int *errStatus, char *errString,
                           uint8_t *encrypted_sek, uint64_t *enc_len, const char *sek_hex) {
     CALL_ONCE
-    LOG_INFO(__FUNCTION__);
+    LOG_DEBUG(__FUNCTION__);
     INIT_ERROR_STATE
 
     CHECK_STATE(encrypted_sek);
@@ -343,6 +431,7 @@ void trustedSetSEKBackup(int *errStatus, char *errString,
 
     uint64_t len;
     hex2carray(sek_hex, &len, (uint8_t *) (AES_key[512]));
+    key_cache_clear();
 
     sealHexSEK(errStatus, errString, encrypted_sek, enc_len, (char *)sek_hex);
 
@@ -355,13 +444,180 @@ void trustedSetSEKBackup(int *errStatus, char *errString,
     SET_SUCCESS
     clean:
     ;
-    LOG_INFO(__FUNCTION__ );
-    LOG_INFO("SGX call completed");
+    LOG_DEBUG(__FUNCTION__ );
+    LOG_DEBUG("SGX call completed");
+}
+
+void trustedGenerateRotationSEK(int *errStatus, char *errString,
+                                uint8_t *encrypted_sek, uint64_t *enc_len, char *sek_hex) {
+    LOG_DEBUG(__FUNCTION__);
+    INIT_ERROR_STATE
+
+    CHECK_STATE(encrypted_sek);
+    CHECK_STATE(sek_hex);
+
+    // the new SEK is only sealed here, trustedRotateSEK installs it in every enclave instance
+    RANDOM_CHAR_BUF(SEK_raw, SGX_AESGCM_KEY_SIZE);
+
+    carray2Hex((uint8_t*) SEK_raw, SGX_AESGCM_KEY_SIZE, sek_hex);
+    memset(SEK_raw, 0, SGX_AESGCM_KEY_SIZE);
+
+    sealSEK(errStatus, errString, encrypted_sek, enc_len, sek_hex);
+
+    if (*errStatus != 0) {
+        LOG_ERROR("sealSEK failed");
+        LOG_ERROR(errString);
+        goto clean;
+    }
+
+    SET_SUCCESS
+    clean:
+    ;
+}
+
+void trustedRotateSEK(int *errStatus, char *errString, uint8_t *encrypted_sek) {
+    LOG_DEBUG(__FUNCTION__);
+    INIT_ERROR_STATE
+    CHECK_STATE(encrypted_sek);
+    SAFE_CHAR_BUF(aes_key_hex, BUF_LEN);
+    SAFE_CHAR_BUF(newSEK, SGX_AESGCM_KEY_SIZE);
+
+    uint32_t dec_len = BUF_LEN;
+
+    sgx_status_t status = sgx_unseal_data(
+            (const sgx_sealed_data_t *) encrypted_sek, NULL, 0,
+            (uint8_t *)aes_key_hex, &dec_len);
+
+    CHECK_STATUS2("sgx unseal of the new SEK failed with status %d");
+
+    CHECK_STATE_CLEAN(strnlen(aes_key_hex, 33) == 32);
+
+    uint64_t len;
+    CHECK_STATE_CLEAN(hex2carray(aes_key_hex, &len, (uint8_t *) newSEK) && len == SGX_AESGCM_KEY_SIZE);
+
+    // keys sealed under the current SEK stay readable until trustedFinishSEKRotation
+    status = AES_rotate_SEK((uint8_t *) newSEK);
+
+    CHECK_STATUS2("another SEK rotation is in progress, status %d");
+
+    SET_SUCCESS
+    clean:
+    memset(aes_key_hex, 0, BUF_LEN);
+    memset(newSEK, 0, SGX_AESGCM_KEY_SIZE);
+}
+
+void trustedFinishSEKRotation(int *errStatus, char *errString) {
+    LOG_DEBUG(__FUNCTION__);
+    INIT_ERROR_STATE
+
+    AES_drop_previous_SEK();
+
+    // entries of values sealed under the previous SEK would still be served
+    key_cache_clear();
+
+    SET_SUCCESS
+}
+
+static void trustedReencryptKeysBatchImpl(int *errStatus, char *errString, uint64_t num_keys,
+                                          const uint8_t *encrypted_keys, uint64_t encrypted_keys_len,
+                                          const uint64_t *enc_lens, uint8_t *reencrypted_keys,
+                                          uint64_t reencrypted_keys_len, uint64_t *reenc_lens, int *key_statuses) {
+    LOG_DEBUG(__FUNCTION__);
+
+    INIT_ERROR_STATE
+
+    CHECK_STATE(encrypted_keys);
+    CHECK_STATE(enc_lens);
+    CHECK_STATE(reencrypted_keys);
+    CHECK_STATE(reenc_lens);
+    CHECK_STATE(key_statuses);
+    CHECK_STATE(num_keys > 0 && num_keys <= MAX_SEK_ROTATION_BATCH_SIZE);
+    CHECK_STATE(encrypted_keys_len == num_keys * SEK_ROTATION_SLOT_LEN);
+    CHECK_STATE(reencrypted_keys_len == num_keys * SEK_ROTATION_SLOT_LEN);
+
+    SAFE_CHAR_BUF(plaintext, SEK_ROTATION_SLOT_LEN);
+    SAFE_CHAR_BUF(decrypted, SEK_ROTATION_SLOT_LEN);
+
+    for (uint64_t i = 0; i < num_keys; i++) {
+        // a zero length means the value is already sealed under the current SEK
+        reenc_lens[i] = 0;
+
+        uint8_t type = 0;
+        uint8_t exportable = 0;
+        int previousSEK = 0;
+
+        uint64_t encLen = enc_lens[i];
+
+        if (encLen > SEK_ROTATION_SLOT_LEN) {
+            key_statuses[i] = 1;
+            continue;
+        }
+
+        // values that are not sealed under either SEK get status 1 and are left alone
+        if (AES_decrypt_ex((uint8_t *) encrypted_keys + i * SEK_ROTATION_SLOT_LEN, encLen, plaintext,
+                           SEK_ROTATION_SLOT_LEN, &type, &exportable, &previousSEK) != 0) {
+            key_statuses[i] = 1;
+            continue;
+        }
+
+        key_statuses[i] = 0;
+
+        uint64_t msgLen = encLen - SGX_AESGCM_MAC_SIZE - SGX_AESGCM_IV_SIZE - 2;
+
+        if (previousSEK) {
+            uint8_t *out = reencrypted_keys + i * SEK_ROTATION_SLOT_LEN;
+
+            // AES_encrypt seals up to the terminating zero, which has to be the last byte
+            if (msgLen == 0 || strnlen(plaintext, msgLen) != msgLen - 1) {
+                key_statuses[i] = -1;
+            } else {
+                key_statuses[i] = AES_encrypt(plaintext, out, SEK_ROTATION_SLOT_LEN, type, exportable,
+                                              reenc_lens + i);
+            }
+
+            // a value is only replaced if it reads back under the new SEK
+            if (key_statuses[i] == 0) {
+                uint8_t checkType = 0;
+                uint8_t checkExportable = 0;
+                int checkPrevious = 1;
+                key_statuses[i] = AES_decrypt_ex(out, reenc_lens[i], decrypted, SEK_ROTATION_SLOT_LEN, &checkType,
+                                                 &checkExportable, &checkPrevious);
+                if (key_statuses[i] == 0 && (checkPrevious || checkType != type || checkExportable != exportable ||
+                                             memcmp(plaintext, decrypted, msgLen) != 0)) {
+                    key_statuses[i] = -1;
+                }
+            }
+
+            // -1 marks a value under the previous SEK that could not be resealed
+            if (key_statuses[i] != 0) {
+                key_statuses[i] = -1;
+                reenc_lens[i] = 0;
+            }
+        }
+
+        memset(plaintext, 0, SEK_ROTATION_SLOT_LEN);
+        memset(decrypted, 0, SEK_ROTATION_SLOT_LEN);
+    }
+
+    SET_SUCCESS
+
+    clean:
+    ;
+}
+
+void trustedReencryptKeysBatch(int *errStatus, char *errString, uint64_t num_keys,
+                               const uint8_t *encrypted_keys, uint64_t encrypted_keys_len, const uint64_t *enc_lens,
+                               uint8_t *reencrypted_keys, uint64_t reencrypted_keys_len, uint64_t *reenc_lens,
+                               int *key_statuses) {
+    char localErrString[BUF_LEN];
+    trustedReencryptKeysBatchImpl(errStatus, localErrString, num_keys, encrypted_keys, encrypted_keys_len, enc_lens,
+                                  reencrypted_keys, reencrypted_keys_len, reenc_lens, key_statuses);
+    copyErrorStringOut(*errStatus, localErrString, errString);
 }
 
 void trustedGenerateEcdsaKey(int *errStatus, char *errString, int *is_exportable,
                                 uint8_t *encryptedPrivateKey, uint64_t *enc_len, char *pub_key_x, char *pub_key_y) {
-    LOG_INFO(__FUNCTION__);
+    LOG_DEBUG(__FUNCTION__);
     INIT_ERROR_STATE
 
     CHECK_STATE(encryptedPrivateKey);
@@ -377,11 +633,13 @@ void trustedGenerateEcdsaKey(int *errStatus, char *errString, int *is_exportable
 
     point Pkey = point_init();
 
-    mpz_import(seed, 32, 1, sizeof(rand_char[0]), 0, 0, rand_char);
+    if (!signature_key_pool_take(skey, Pkey)) {
+        mpz_import(seed, 32, 1, sizeof(rand_char[0]), 0, 0, rand_char);
 
-    mpz_mod(skey, seed, curve->p);
+        mpz_mod(skey, seed, curve->p);
 
-    signature_extract_public_key(Pkey, skey, curve);
+        signature_extract_public_key(Pkey, skey, curve);
+    }
 
     SAFE_CHAR_BUF(arr_x, BUF_LEN);
     mpz_get_str(arr_x, ECDSA_SKEY_BASE, Pkey->x);
@@ -421,10 +679,7 @@ void trustedGenerateEcdsaKey(int *errStatus, char *errString, int *is_exportable
     }
     CHECK_STATUS("ecdsa private key encryption failed");
 
-    uint8_t type = 0;
-    uint8_t exportable = 0;
-
-    status = AES_decrypt(encryptedPrivateKey, *enc_len, skey_str, BUF_LEN, &type, &exportable);
+    status = checkEncryption(skey_str, encryptedPrivateKey, *enc_len, BUF_LEN);
 
     CHECK_STATUS2("ecdsa private key decr failed with status %d");
 
@@ -433,11 +688,11 @@ void trustedGenerateEcdsaKey(int *errStatus, char *errString, int *is_exportable
     mpz_clear(seed);
     mpz_clear(skey);
     point_clear(Pkey);
-    LOG_INFO(__FUNCTION__ );
-    LOG_INFO("SGX call completed");
+    LOG_DEBUG(__FUNCTION__ );
+    LOG_DEBUG("SGX call completed");
 }
 
-void trustedGetPublicEcdsaKey(int *errStatus, char *errString,
+static void trustedGetPublicEcdsaKeyImpl(int *errStatus, char *errString,
                                  uint8_t *encryptedPrivateKey, uint64_t enc_len, char *pub_key_x, char *pub_key_y) {
     LOG_DEBUG(__FUNCTION__);
     INIT_ERROR_STATE
@@ -457,15 +712,21 @@ void trustedGetPublicEcdsaKey(int *errStatus, char *errString,
     uint8_t type = 0;
     uint8_t exportable = 0;
 
-    int status = AES_decrypt(encryptedPrivateKey, enc_len, skey, BUF_LEN,
+    int status = 0;
+
+    if (!key_cache_get_ecdsa(encryptedPrivateKey, enc_len, privateKeyMpz)) {
+        status = AES_decrypt(encryptedPrivateKey, enc_len, skey, BUF_LEN,
                              &type, &exportable);
-    CHECK_STATUS2("AES_decrypt failed with status %d");
+        CHECK_STATUS2("AES_decrypt failed with status %d");
+
+        skey[enc_len - SGX_AESGCM_MAC_SIZE - SGX_AESGCM_IV_SIZE] = '\0';
 
-    skey[enc_len - SGX_AESGCM_MAC_SIZE - SGX_AESGCM_IV_SIZE] = '\0';
+        status = mpz_set_str(privateKeyMpz, skey, ECDSA_SKEY_BASE);
 
-    status = mpz_set_str(privateKeyMpz, skey, ECDSA_SKEY_BASE);
+        CHECK_STATUS("mpz_set_str failed for private key");
 
-    CHECK_STATUS("mpz_set_str failed for private key");
+        key_cache_put_ecdsa(encryptedPrivateKey, enc_len, privateKeyMpz);
+    }
 
     signature_extract_public_key(pKey, privateKeyMpz, curve);
 
@@ -481,35 +742,54 @@ void trustedGetPublicEcdsaKey(int *errStatus, char *errString,
 
     SAFE_CHAR_BUF(arr_x, BUF_LEN);
     mpz_get_str(arr_x, ECDSA_SKEY_BASE, pKey->x);
+    CHECK_STATE_CLEAN(strlen(arr_x) < ECDSA_PUB_KEY_COORD_LEN);
 
-    int n_zeroes = 64 - strlen(arr_x);
+    int n_zeroes = ECDSA_PUB_KEY_COORD_LEN - 1 - strlen(arr_x);
     for (int i = 0; i < n_zeroes; i++) {
         pub_key_x[i] = '0';
     }
 
-    strncpy(pub_key_x + n_zeroes, arr_x, 1024 - n_zeroes);
+    strncpy(pub_key_x + n_zeroes, arr_x, ECDSA_PUB_KEY_COORD_LEN - n_zeroes);
 
     SAFE_CHAR_BUF(arr_y, BUF_LEN);
     mpz_get_str(arr_y, ECDSA_SKEY_BASE, pKey->y);
+    CHECK_STATE_CLEAN(strlen(arr_y) < ECDSA_PUB_KEY_COORD_LEN);
 
-    n_zeroes = 64 - strlen(arr_y);
+    n_zeroes = ECDSA_PUB_KEY_COORD_LEN - 1 - strlen(arr_y);
     for (int i = 0; i < n_zeroes; i++) {
         pub_key_y[i] = '0';
     }
-    strncpy(pub_key_y + n_zeroes, arr_y, 1024 - n_zeroes);
+    strncpy(pub_key_y + n_zeroes, arr_y, ECDSA_PUB_KEY_COORD_LEN - n_zeroes);
 
     SET_SUCCESS
     clean:
     mpz_clear(privateKeyMpz);
+    memset(skey, 0, BUF_LEN);
     point_clear(pKey);
     point_clear(pKey_test);
 
 }
 
-static uint64_t sigCounter = 0;
+void trustedGetPublicEcdsaKey(int *errStatus, char *errString,
+                              uint8_t *encryptedPrivateKey, uint64_t enc_len, char *pub_key_x, char *pub_key_y) {
+    char localErrString[BUF_LEN];
+    trustedGetPublicEcdsaKeyImpl(errStatus, localErrString, encryptedPrivateKey, enc_len, pub_key_x, pub_key_y);
+    copyErrorStringOut(*errStatus, localErrString, errString);
+}
+
+// r and s leave the enclave as ECDSA_SIG_LIMBS little endian limbs, the host formats them
+static int sigToLimbs(mpz_t _x, uint64_t *_limbs) {
+    if (mpz_sizeinbase(_x, 2) > 64 * ECDSA_SIG_LIMBS)
+        return -1;
 
-void trustedEcdsaSign(int *errStatus, char *errString, uint8_t *encryptedPrivateKey, uint64_t enc_len,
-                         const char *hash, char *sigR, char *sigS, uint8_t *sig_v, int base) {
+    memset(_limbs, 0, ECDSA_SIG_LIMBS * sizeof(uint64_t));
+    mpz_export(_limbs, NULL, -1, sizeof(uint64_t), 0, 0, _x);
+    return 0;
+}
+
+static void trustedEcdsaSignImpl(int *errStatus, char *errString, uint8_t *encryptedPrivateKey, uint64_t enc_len,
+                         const char *hash, uint64_t *sigR, uint64_t *sigS, uint8_t *sig_v) {
+    SCRATCH_SCOPE
     LOG_DEBUG(__FUNCTION__);
 
     INIT_ERROR_STATE
@@ -519,7 +799,13 @@ void trustedEcdsaSign(int *errStatus, char *errString, uint8_t *encryptedPrivate
     CHECK_STATE(sigR);
     CHECK_STATE(sigS);
 
-    SAFE_CHAR_BUF(skey, BUF_LEN);
+    if (signature_self_check_failed()) {
+        *errStatus = -2;
+        snprintf(errString, BUF_LEN, "signing disabled after a failed self check");
+        return;
+    }
+
+    SCRATCH_CHAR_BUF(skey, BUF_LEN);
 
     mpz_t privateKeyMpz;
     mpz_init(privateKeyMpz);
@@ -531,18 +817,24 @@ void trustedEcdsaSign(int *errStatus, char *errString, uint8_t *encryptedPrivate
     uint8_t type = 0;
     uint8_t exportable = 0;
 
-    int status = AES_decrypt(encryptedPrivateKey, enc_len, skey, BUF_LEN,
+    int status = 0;
+
+    if (!key_cache_get_ecdsa(encryptedPrivateKey, enc_len, privateKeyMpz)) {
+        status = AES_decrypt(encryptedPrivateKey, enc_len, skey, BUF_LEN,
                              &type, &exportable);
 
-    CHECK_STATUS2("aes decrypt failed with status %d");
+        CHECK_STATUS2("aes decrypt failed with status %d");
 
-    skey[enc_len - SGX_AESGCM_MAC_SIZE - SGX_AESGCM_IV_SIZE] = '\0';
+        skey[enc_len - SGX_AESGCM_MAC_SIZE - SGX_AESGCM_IV_SIZE] = '\0';
 
-    if (mpz_set_str(privateKeyMpz, skey, ECDSA_SKEY_BASE) == -1) {
-        *errStatus = -1;
-        snprintf(errString, BUF_LEN, "invalid secret key");
-        LOG_ERROR(errString);
-        goto clean;
+        if (mpz_set_str(privateKeyMpz, skey, ECDSA_SKEY_BASE) == -1) {
+            *errStatus = -1;
+            snprintf(errString, BUF_LEN, "invalid secret key");
+            LOG_ERROR(errString);
+            goto clean;
+        }
+
+        key_cache_put_ecdsa(encryptedPrivateKey, enc_len, privateKeyMpz);
     }
 
     if (mpz_set_str(msgMpz, hash, 16) == -1) {
@@ -554,38 +846,109 @@ void trustedEcdsaSign(int *errStatus, char *errString, uint8_t *encryptedPrivate
 
     signature_sign(sign, msgMpz, privateKeyMpz, curve);
 
-    sigCounter++;
+    signature_sample(msgMpz, sign, privateKeyMpz);
+
+    CHECK_STATE_CLEAN(sigToLimbs(sign->r, sigR) == 0);
+    CHECK_STATE_CLEAN(sigToLimbs(sign->s, sigS) == 0);
+
+    *sig_v = sign->v;
+
+    SET_SUCCESS
+    clean:
+
+    mpz_clear(privateKeyMpz);
+    mpz_clear(msgMpz);
+    if (sign)
+        signature_free(sign);
+    LOG_DEBUG(__FUNCTION__ );
+    LOG_DEBUG("SGX call completed");
+}
+
+void trustedEcdsaSign(int *errStatus, char *errString, uint8_t *encryptedPrivateKey, uint64_t enc_len,
+                      const char *hash, uint64_t *sigR, uint64_t *sigS, uint8_t *sig_v) {
+    char localErrString[BUF_LEN];
+    trustedEcdsaSignImpl(errStatus, localErrString, encryptedPrivateKey, enc_len, hash, sigR, sigS, sig_v);
+    copyErrorStringOut(*errStatus, localErrString, errString);
+}
+
+static void trustedEcdsaSignBatchImpl(int *errStatus, char *errString, uint8_t *encryptedPrivateKey, uint64_t enc_len,
+                           uint64_t num_hashes, const char *hashes, uint64_t hashes_len,
+                           uint64_t *sigs_r, uint64_t *sigs_s, uint64_t sigs_len, uint8_t *sigs_v) {
+    SCRATCH_SCOPE
+    LOG_DEBUG(__FUNCTION__);
+
+    INIT_ERROR_STATE
+
+    CHECK_STATE(encryptedPrivateKey);
+    CHECK_STATE(hashes);
+    CHECK_STATE(sigs_r);
+    CHECK_STATE(sigs_s);
+    CHECK_STATE(sigs_v);
+    CHECK_STATE(num_hashes > 0 && num_hashes <= MAX_ECDSA_SIGN_BATCH_SIZE);
+    CHECK_STATE(hashes_len == num_hashes * ECDSA_BATCH_HASH_SLOT_LEN);
+    CHECK_STATE(sigs_len == num_hashes * ECDSA_SIG_LIMBS * sizeof(uint64_t));
+
+    if (signature_self_check_failed()) {
+        *errStatus = -2;
+        snprintf(errString, BUF_LEN, "signing disabled after a failed self check");
+        return;
+    }
+
+    for (uint64_t i = 0; i < num_hashes; i++) {
+        CHECK_STATE(hashes[(i + 1) * ECDSA_BATCH_HASH_SLOT_LEN - 1] == 0);
+    }
+
+    SCRATCH_CHAR_BUF(skey, BUF_LEN);
+
+    mpz_t privateKeyMpz;
+    mpz_init(privateKeyMpz);
+    mpz_t msgMpz;
+    mpz_init(msgMpz);
+    signature sign = NULL;
+    sign = signature_init();
+
+    uint8_t type = 0;
+    uint8_t exportable = 0;
 
-    if (sigCounter % 1000 == 0) {
+    // the key is decrypted and parsed at most once for the whole batch
+    int status = 0;
+
+    if (!key_cache_get_ecdsa(encryptedPrivateKey, enc_len, privateKeyMpz)) {
+        status = AES_decrypt(encryptedPrivateKey, enc_len, skey, BUF_LEN,
+                             &type, &exportable);
 
-        point Pkey = point_init();
+        CHECK_STATUS2("aes decrypt failed with status %d");
 
-        signature_extract_public_key(Pkey, privateKeyMpz, curve);
+        skey[enc_len - SGX_AESGCM_MAC_SIZE - SGX_AESGCM_IV_SIZE] = '\0';
 
-        if (!signature_verify(msgMpz, sign, Pkey, curve)) {
-            *errStatus = -2;
-            snprintf(errString, BUF_LEN, "signature is not verified! ");
+        if (mpz_set_str(privateKeyMpz, skey, ECDSA_SKEY_BASE) == -1) {
+            *errStatus = -1;
+            snprintf(errString, BUF_LEN, "invalid secret key");
             LOG_ERROR(errString);
-            point_clear(Pkey);
             goto clean;
         }
 
-        point_clear(Pkey);
+        key_cache_put_ecdsa(encryptedPrivateKey, enc_len, privateKeyMpz);
     }
 
-    SAFE_CHAR_BUF(arrM, BUF_LEN);
-    mpz_get_str(arrM, 16, msgMpz);
-    snprintf(errString, BUF_LEN, "message is %s ", arrM);
+    for (uint64_t i = 0; i < num_hashes; i++) {
 
-    SAFE_CHAR_BUF(arrR, BUF_LEN);
-    mpz_get_str(arrR, base, sign->r);
-    strncpy(sigR, arrR, 1024);
+        if (mpz_set_str(msgMpz, hashes + i * ECDSA_BATCH_HASH_SLOT_LEN, 16) == -1) {
+            *errStatus = -1;
+            snprintf(errString, BUF_LEN, "invalid message hash %d", (int) i);
+            LOG_ERROR(errString);
+            goto clean;
+        }
 
-    SAFE_CHAR_BUF(arrS, BUF_LEN);
-    mpz_get_str(arrS, base, sign->s);
-    strncpy(sigS, arrS, 1024);
+        signature_sign(sign, msgMpz, privateKeyMpz, curve);
 
-    *sig_v = sign->v;
+        signature_sample(msgMpz, sign, privateKeyMpz);
+
+        CHECK_STATE_CLEAN(sigToLimbs(sign->r, sigs_r + i * ECDSA_SIG_LIMBS) == 0);
+        CHECK_STATE_CLEAN(sigToLimbs(sign->s, sigs_s + i * ECDSA_SIG_LIMBS) == 0);
+
+        sigs_v[i] = sign->v;
+    }
 
     SET_SUCCESS
     clean:
@@ -594,10 +957,142 @@ void trustedEcdsaSign(int *errStatus, char *errString, uint8_t *encryptedPrivate
     mpz_clear(msgMpz);
     if (sign)
         signature_free(sign);
-    LOG_DEBUG(__FUNCTION__ );
     LOG_DEBUG("SGX call completed");
 }
 
+void trustedEcdsaSignBatch(int *errStatus, char *errString, uint8_t *encryptedPrivateKey, uint64_t enc_len,
+                           uint64_t num_hashes, const char *hashes, uint64_t hashes_len,
+                           uint64_t *sigs_r, uint64_t *sigs_s, uint64_t sigs_len, uint8_t *sigs_v) {
+    char localErrString[BUF_LEN];
+    trustedEcdsaSignBatchImpl(errStatus, localErrString, encryptedPrivateKey, enc_len, num_hashes, hashes, hashes_len,
+                              sigs_r, sigs_s, sigs_len, sigs_v);
+    copyErrorStringOut(*errStatus, localErrString, errString);
+}
+
+void trustedRefillEcdsaNoncePool(int *errStatus, char *errString, uint64_t count, uint64_t *pool_size) {
+    LOG_DEBUG(__FUNCTION__);
+
+    INIT_ERROR_STATE
+
+    CHECK_STATE(pool_size);
+    CHECK_STATE(count <= NONCE_POOL_REFILL_BATCH);
+
+    *pool_size = signature_nonce_pool_refill(count, curve);
+
+    SET_SUCCESS
+}
+
+void trustedRefillEcdsaKeyPool(int *errStatus, char *errString, uint64_t count, uint64_t *pool_size) {
+    LOG_DEBUG(__FUNCTION__);
+
+    INIT_ERROR_STATE
+
+    CHECK_STATE(pool_size);
+    CHECK_STATE(count <= KEY_POOL_REFILL_BATCH);
+
+    *pool_size = signature_key_pool_refill(count, curve);
+
+    SET_SUCCESS
+}
+
+// A key that can not be imported only fails its own status
+static void trustedEncryptKeysBatchImpl(int *errStatus, char *errString, uint64_t num_keys,
+                                        const char *keys, uint64_t keys_len,
+                                        uint8_t *encrypted_keys, uint64_t encrypted_keys_len, uint64_t *enc_lens,
+                                        int *key_statuses, uint8_t ecdsa, char *pub_keys, uint64_t pub_keys_len) {
+    LOG_DEBUG(__FUNCTION__);
+
+    INIT_ERROR_STATE
+
+    CHECK_STATE(keys);
+    CHECK_STATE(encrypted_keys);
+    CHECK_STATE(enc_lens);
+    CHECK_STATE(key_statuses);
+    CHECK_STATE(num_keys > 0 && num_keys <= MAX_KEY_IMPORT_BATCH_SIZE);
+    CHECK_STATE(keys_len == num_keys * MAX_KEY_LENGTH);
+    CHECK_STATE(encrypted_keys_len == num_keys * KEY_IMPORT_ENC_KEY_SLOT_LEN);
+    CHECK_STATE(!ecdsa || (pub_keys && pub_keys_len == num_keys * KEY_IMPORT_PUB_KEY_SLOT_LEN));
+
+    mpz_t privateKeyMpz;
+    mpz_init(privateKeyMpz);
+    point pKey = point_init();
+
+    // lengths of the keys to encrypt, zero for keys that are rejected
+    uint64_t keyLens[MAX_KEY_IMPORT_BATCH_SIZE];
+
+    for (uint64_t i = 0; i < num_keys; i++) {
+        const char *key = keys + i * MAX_KEY_LENGTH;
+
+        keyLens[i] = 0;
+
+        if (key[MAX_KEY_LENGTH - 1] != 0 || key[0] == 0) {
+            continue;
+        }
+
+        if (ecdsa) {
+            if (mpz_set_str(privateKeyMpz, key, ECDSA_SKEY_BASE) == -1 || mpz_sgn(privateKeyMpz) == 0) {
+                continue;
+            }
+
+            signature_extract_public_key(pKey, privateKeyMpz, curve);
+
+            char *pubKey = pub_keys + i * KEY_IMPORT_PUB_KEY_SLOT_LEN;
+            uint64_t coordLen = ECDSA_PUB_KEY_COORD_LEN - 1;
+
+            if (mpz_sizeinbase(pKey->x, ECDSA_SKEY_BASE) > coordLen ||
+                mpz_sizeinbase(pKey->y, ECDSA_SKEY_BASE) > coordLen) {
+                continue;
+            }
+
+            SAFE_CHAR_BUF(coord, BUF_LEN);
+
+            mpz_get_str(coord, ECDSA_SKEY_BASE, pKey->x);
+            uint64_t zeroes = coordLen - strlen(coord);
+            memset(pubKey, '0', zeroes);
+            memcpy(pubKey + zeroes, coord, coordLen - zeroes);
+
+            mpz_get_str(coord, ECDSA_SKEY_BASE, pKey->y);
+            zeroes = coordLen - strlen(coord);
+            memset(pubKey + coordLen, '0', zeroes);
+            memcpy(pubKey + coordLen + zeroes, coord, coordLen - zeroes);
+
+            pubKey[2 * coordLen] = 0;
+        }
+
+        keyLens[i] = strlen(key) + 1;
+    }
+
+    // all keys are sealed in one pass, a rejected key keeps a non zero status
+    CHECK_STATE_CLEAN(AES_encrypt_batch(keys, MAX_KEY_LENGTH, keyLens, num_keys, encrypted_keys,
+                                        KEY_IMPORT_ENC_KEY_SLOT_LEN, DKG, EXPORTABLE, enc_lens, key_statuses) == 0);
+
+    for (uint64_t i = 0; i < num_keys; i++) {
+        if (key_statuses[i] == 0)
+            key_statuses[i] = checkEncryption(keys + i * MAX_KEY_LENGTH,
+                                              encrypted_keys + i * KEY_IMPORT_ENC_KEY_SLOT_LEN, enc_lens[i],
+                                              MAX_KEY_LENGTH);
+        if (key_statuses[i] != 0)
+            enc_lens[i] = 0;
+    }
+
+    SET_SUCCESS
+
+    clean:
+
+    mpz_clear(privateKeyMpz);
+    point_clear(pKey);
+}
+
+void trustedEncryptKeysBatch(int *errStatus, char *errString, uint64_t num_keys,
+                             const char *keys, uint64_t keys_len,
+                             uint8_t *encrypted_keys, uint64_t encrypted_keys_len, uint64_t *enc_lens,
+                             int *key_statuses, uint8_t ecdsa, char *pub_keys, uint64_t pub_keys_len) {
+    char localErrString[BUF_LEN];
+    trustedEncryptKeysBatchImpl(errStatus, localErrString, num_keys, keys, keys_len, encrypted_keys,
+                                encrypted_keys_len, enc_lens, key_statuses, ecdsa, pub_keys, pub_keys_len);
+    copyErrorStringOut(*errStatus, localErrString, errString);
+}
+
 void trustedDecryptKey(int *errStatus, char *errString, uint8_t *encryptedPrivateKey,
                           uint64_t enc_len, char *key) {
 
@@ -647,13 +1142,14 @@ void trustedDecryptKey(int *errStatus, char *errString, uint8_t *encryptedPrivat
 
 void trustedEncryptKey(int *errStatus, char *errString, const char *key,
                           uint8_t *encryptedPrivateKey, uint64_t *enc_len) {
-    LOG_INFO(__FUNCTION__);
+    LOG_DEBUG(__FUNCTION__);
 
     *errString = 0;
     *errStatus = UNKNOWN_ERROR;
 
     CHECK_STATE(key);
     CHECK_STATE(encryptedPrivateKey);
+    CHECK_STATE(strnlen(key, MAX_KEY_LENGTH) < MAX_KEY_LENGTH);
 
     *errStatus = UNKNOWN_ERROR;
 
@@ -662,93 +1158,235 @@ void trustedEncryptKey(int *errStatus, char *errString, const char *key,
 
     CHECK_STATUS2("AES encrypt failed with status %d");
 
-    SAFE_CHAR_BUF(decryptedKey, BUF_LEN);
+    status = checkEncryption(key, encryptedPrivateKey, *enc_len, MAX_KEY_LENGTH);
+
+    CHECK_STATUS2("Decrypted key does not match original key, status %d");
+
+    SET_SUCCESS
+    clean:
+    ;
+    LOG_DEBUG(__FUNCTION__ );
+    LOG_DEBUG("SGX call completed");
+}
+
+
+static void trustedBlsSignMessageImpl(int *errStatus, char *errString, uint8_t *encryptedPrivateKey,
+                              uint64_t enc_len, uint64_t *hash, uint64_t *signature) {
+    SCRATCH_SCOPE
+    LOG_DEBUG(__FUNCTION__);
+    INIT_ERROR_STATE
+
+    CHECK_STATE(encryptedPrivateKey);
+    CHECK_STATE(hash);
+    CHECK_STATE(signature);
+
+    SCRATCH_CHAR_BUF(key, BUF_LEN);
 
     uint8_t type = 0;
     uint8_t exportable = 0;
 
-    status = AES_decrypt(encryptedPrivateKey, *enc_len, decryptedKey, BUF_LEN,
-                         &type, &exportable);
+    int status = 0;
 
-    CHECK_STATUS2("trustedDecryptKey failed with status %d");
+    void *parsedKey = key_cache_get_bls(encryptedPrivateKey, enc_len);
 
-    uint64_t decryptedKeyLen = strnlen(decryptedKey, MAX_KEY_LENGTH);
+    if (!parsedKey) {
+        status = AES_decrypt(encryptedPrivateKey, enc_len, key, BUF_LEN, &type, &exportable);
 
-    if (decryptedKeyLen == MAX_KEY_LENGTH) {
-        snprintf(errString, BUF_LEN, "Decrypted key is not null terminated");
-        LOG_ERROR(errString);
-        goto clean;
-    }
+        CHECK_STATUS("AES decrypt failed")
+
+        parsedKey = enclave_parse_bls_key(key);
 
-    *errStatus = -8;
+        CHECK_STATE_CLEAN(parsedKey);
 
-    if (strncmp(key, decryptedKey, MAX_KEY_LENGTH) != 0) {
-        snprintf(errString, BUF_LEN, "Decrypted key does not match original key");
-        LOG_ERROR(key);
-        LOG_ERROR(decryptedKey);
+        key_cache_put_bls(encryptedPrivateKey, enc_len, parsedKey);
+    }
+
+    if (!enclave_sign_with_key(parsedKey, hash, signature)) {
+        strncpy(errString, "Enclave failed to create bls signature", BUF_LEN);
         LOG_ERROR(errString);
+        *errStatus = -1;
         goto clean;
     }
 
     SET_SUCCESS
+
     clean:
     ;
-    LOG_INFO(__FUNCTION__ );
-    LOG_INFO("SGX call completed");
+    enclave_free_bls_key(parsedKey);
+    LOG_DEBUG("SGX call completed");
 }
 
-
 void trustedBlsSignMessage(int *errStatus, char *errString, uint8_t *encryptedPrivateKey,
-                              uint64_t enc_len, char *_hashX,
-                              char *_hashY, char *signature) {
+                           uint64_t enc_len, uint64_t *hash, uint64_t *signature) {
+    char localErrString[BUF_LEN];
+    trustedBlsSignMessageImpl(errStatus, localErrString, encryptedPrivateKey, enc_len, hash, signature);
+    copyErrorStringOut(*errStatus, localErrString, errString);
+}
+
+static void trustedBlsSignMessageBatchImpl(int *errStatus, char *errString, uint64_t num_keys,
+                                uint8_t *encrypted_keys, uint64_t keys_len, uint64_t *enc_lens,
+                                uint64_t num_hashes, uint32_t *key_indexes,
+                                uint64_t *hashes, uint64_t hashes_len,
+                                uint64_t *signatures, uint64_t sigs_len) {
+    SCRATCH_SCOPE
     LOG_DEBUG(__FUNCTION__);
     INIT_ERROR_STATE
 
-    CHECK_STATE(encryptedPrivateKey);
-    CHECK_STATE(_hashX);
-    CHECK_STATE(_hashY);
-    CHECK_STATE(signature);
+    CHECK_STATE(encrypted_keys);
+    CHECK_STATE(enc_lens);
+    CHECK_STATE(key_indexes);
+    CHECK_STATE(hashes);
+    CHECK_STATE(signatures);
+    CHECK_STATE(num_keys > 0 && num_keys <= num_hashes);
+    CHECK_STATE(num_hashes > 0 && num_hashes <= MAX_BLS_SIGN_BATCH_SIZE);
+    CHECK_STATE(keys_len == num_keys * BLS_BATCH_KEY_SLOT_LEN);
+    CHECK_STATE(hashes_len == num_hashes * BLS_G1_LIMBS);
+    CHECK_STATE(sigs_len == num_hashes * BLS_G1_LIMBS);
+
+    for (uint64_t i = 0; i < num_hashes; i++) {
+        CHECK_STATE(key_indexes[i] < num_keys);
+    }
+
+    SCRATCH_CHAR_BUF(key, BUF_LEN);
 
-    SAFE_CHAR_BUF(key, BUF_LEN);SAFE_CHAR_BUF(sig, BUF_LEN);
+    void *parsedKey = NULL;
 
     uint8_t type = 0;
     uint8_t exportable = 0;
 
-    int status = AES_decrypt(encryptedPrivateKey, enc_len, key, BUF_LEN, &type, &exportable);
+    int status = 0;
 
-    CHECK_STATUS("AES decrypt failed")
+    // each distinct key is decrypted and parsed once for all hashes that use it
+    for (uint64_t k = 0; k < num_keys; k++) {
 
-    if (!enclave_sign(key, _hashX, _hashY, sig)) {
-        strncpy(errString, "Enclave failed to create bls signature", BUF_LEN);
-        LOG_ERROR(errString);
-        *errStatus = -1;
-        goto clean;
-    }
+        CHECK_STATE_CLEAN(enc_lens[k] <= BLS_BATCH_KEY_SLOT_LEN);
 
-    strncpy(signature, sig, BUF_LEN);
+        uint8_t *encryptedKey = encrypted_keys + k * BLS_BATCH_KEY_SLOT_LEN;
 
-    if (strnlen(signature, BUF_LEN) < 10) {
-        strncpy(errString, "Signature too short", BUF_LEN);
-        LOG_ERROR(errString);
-        *errStatus = -1;
-        goto clean;
+        parsedKey = key_cache_get_bls(encryptedKey, enc_lens[k]);
+
+        if (!parsedKey) {
+            status = AES_decrypt(encryptedKey, enc_lens[k], key, BUF_LEN,
+                                 &type, &exportable);
+
+            CHECK_STATUS("AES decrypt failed")
+
+            parsedKey = enclave_parse_bls_key(key);
+
+            CHECK_STATE_CLEAN(parsedKey);
+
+            key_cache_put_bls(encryptedKey, enc_lens[k], parsedKey);
+        }
+
+        for (uint64_t i = 0; i < num_hashes; i++) {
+            if (key_indexes[i] != k)
+                continue;
+
+            if (!enclave_sign_with_key(parsedKey, hashes + i * BLS_G1_LIMBS, signatures + i * BLS_G1_LIMBS)) {
+                strncpy(errString, "Enclave failed to create bls signature", BUF_LEN);
+                LOG_ERROR(errString);
+                *errStatus = -1;
+                goto clean;
+            }
+        }
+
+        enclave_free_bls_key(parsedKey);
+        parsedKey = NULL;
+        memset(key, 0, BUF_LEN);
     }
 
     SET_SUCCESS
 
+    clean:
+    ;
+    enclave_free_bls_key(parsedKey);
     LOG_DEBUG("SGX call completed");
+}
+
+void trustedBlsSignMessageBatch(int *errStatus, char *errString, uint64_t num_keys,
+                                uint8_t *encrypted_keys, uint64_t keys_len, uint64_t *enc_lens,
+                                uint64_t num_hashes, uint32_t *key_indexes,
+                                uint64_t *hashes, uint64_t hashes_len,
+                                uint64_t *signatures, uint64_t sigs_len) {
+    char localErrString[BUF_LEN];
+    trustedBlsSignMessageBatchImpl(errStatus, localErrString, num_keys, encrypted_keys, keys_len, enc_lens,
+                                   num_hashes, key_indexes, hashes, hashes_len, signatures, sigs_len);
+    copyErrorStringOut(*errStatus, localErrString, errString);
+}
+
+// decrypts a BLS or ECDSA key into the key cache, so that the first sign with it after a restart is fast.
+// Other keys are ignored
+static void trustedWarmUpKeyImpl(int *errStatus, char *errString, uint8_t *encryptedKey, uint64_t enc_len) {
+    SCRATCH_SCOPE
+    LOG_DEBUG(__FUNCTION__);
+    INIT_ERROR_STATE
+
+    CHECK_STATE(encryptedKey);
+    CHECK_STATE(enc_len > SGX_AESGCM_MAC_SIZE + SGX_AESGCM_IV_SIZE && enc_len <= BUF_LEN);
+
+    SCRATCH_CHAR_BUF(key, BUF_LEN);
+
+    mpz_t privateKeyMpz;
+    mpz_init(privateKeyMpz);
+
+    void *parsedKey = NULL;
+
+    uint8_t type = 0;
+    uint8_t exportable = 0;
+
+    int status = AES_decrypt(encryptedKey, enc_len, key, BUF_LEN, &type, &exportable);
+
+    CHECK_STATUS("AES decrypt failed")
+
+    if (type == BLS) {
+        parsedKey = key_cache_get_bls(encryptedKey, enc_len);
+        if (!parsedKey) {
+            parsedKey = enclave_parse_bls_key(key);
+            CHECK_STATE_CLEAN(parsedKey);
+            key_cache_put_bls(encryptedKey, enc_len, parsedKey);
+        }
+    } else if (type == ECDSA) {
+        if (!key_cache_get_ecdsa(encryptedKey, enc_len, privateKeyMpz)) {
+            key[enc_len - SGX_AESGCM_MAC_SIZE - SGX_AESGCM_IV_SIZE] = '\0';
+            status = mpz_set_str(privateKeyMpz, key, ECDSA_SKEY_BASE);
+            CHECK_STATUS("mpz_set_str failed for private key");
+            key_cache_put_ecdsa(encryptedKey, enc_len, privateKeyMpz);
+        }
+    }
+
+    SET_SUCCESS
 
     clean:
     ;
+    enclave_free_bls_key(parsedKey);
+    mpz_clear(privateKeyMpz);
     LOG_DEBUG("SGX call completed");
 }
 
+void trustedWarmUpKey(int *errStatus, char *errString, uint8_t *encryptedKey, uint64_t enc_len) {
+    char localErrString[BUF_LEN];
+    trustedWarmUpKeyImpl(errStatus, localErrString, encryptedKey, enc_len);
+    copyErrorStringOut(*errStatus, localErrString, errString);
+}
+
+// touches the scratch arena and the random generator of the TCS of the calling thread
+void trustedWarmUpThread() {
+    uint64_t mark = scratch_mark();
+    scratch_alloc(SCRATCH_ARENA_SIZE - mark);
+    scratch_release(&mark);
+
+    uint8_t random[32];
+    drbg_generate(random, sizeof(random));
+    memset(random, 0, sizeof(random));
+}
+
 void
 trustedGenDkgSecret(int *errStatus, char *errString, uint8_t *encrypted_dkg_secret, uint64_t *enc_len, size_t _t) {
-    LOG_INFO(__FUNCTION__);
+    LOG_DEBUG(__FUNCTION__);
     INIT_ERROR_STATE
 
     CHECK_STATE(encrypted_dkg_secret);
+    CHECK_STATE(_t > 0 && _t <= MAX_DKG_N);
 
     SAFE_CHAR_BUF(dkg_secret, DKG_BUFER_LENGTH);
 
@@ -756,51 +1394,95 @@ trustedGenDkgSecret(int *errStatus, char *errString, uint8_t *encrypted_dkg_secr
 
     CHECK_STATUS("gen_dkg_poly failed")
 
-    status = AES_encrypt(dkg_secret, encrypted_dkg_secret, 3 * BUF_LEN,
+    status = AES_encrypt(dkg_secret, encrypted_dkg_secret, DKG_MAX_SEALED_LEN,
                          DKG, EXPORTABLE, enc_len);
 
     CHECK_STATUS("SGX AES encrypt DKG poly failed");
 
-    SAFE_CHAR_BUF(decr_dkg_secret, DKG_BUFER_LENGTH);
+    status = checkEncryption(dkg_secret, encrypted_dkg_secret, *enc_len, DKG_BUFER_LENGTH);
 
-    uint8_t type = 0;
-    uint8_t exportable = 0;
+    CHECK_STATUS("encrypted poly is not equal to decrypted poly");
 
-    status = AES_decrypt(encrypted_dkg_secret, *enc_len, decr_dkg_secret,
-                         DKG_BUFER_LENGTH, &type, &exportable);
+    SET_SUCCESS
+    clean:
+    memset(dkg_secret, 0, DKG_BUFER_LENGTH);
+    LOG_DEBUG(__FUNCTION__ );
+    LOG_DEBUG("SGX call completed");
+}
 
-    CHECK_STATUS("aes decrypt dkg poly failed");
+// generates the polys one after another in one buffer, each is sealed into its own slot
+static void trustedGenDkgSecretBatchImpl(int *errStatus, char *errString, uint64_t num_polys,
+                                         uint8_t *encrypted_dkg_secrets, uint64_t encrypted_len, uint64_t *enc_lens,
+                                         char *public_shares, uint64_t public_shares_len, size_t _t) {
+    LOG_DEBUG(__FUNCTION__);
+    INIT_ERROR_STATE
 
-    if (strcmp(dkg_secret, decr_dkg_secret) != 0) {
-        snprintf(errString, BUF_LEN,
-                 "encrypted poly is not equal to decrypted poly");
-        LOG_ERROR(errString);
-        *errStatus = -333;
-        goto clean;
+    CHECK_STATE(encrypted_dkg_secrets);
+    CHECK_STATE(enc_lens);
+    CHECK_STATE(public_shares);
+    CHECK_STATE(num_polys > 0 && num_polys <= MAX_DKG_POLY_BATCH_SIZE);
+    CHECK_STATE(_t > 0 && _t <= MAX_DKG_N);
+    CHECK_STATE(encrypted_len == num_polys * DKG_MAX_SEALED_LEN);
+    CHECK_STATE(public_shares_len == num_polys * DKG_PUBLIC_SHARES_SLOT_LEN(_t));
+
+    SAFE_CHAR_BUF(dkg_secret, DKG_BUFER_LENGTH);
+
+    int status = 0;
+
+    for (uint64_t i = 0; i < num_polys; i++) {
+        uint8_t *encrypted_dkg_secret = encrypted_dkg_secrets + i * DKG_MAX_SEALED_LEN;
+
+        memset(dkg_secret, 0, DKG_BUFER_LENGTH);
+
+        status = gen_dkg_poly(dkg_secret, _t);
+
+        CHECK_STATUS("gen_dkg_poly failed")
+
+        // the commitments are computed from the plain poly, so it is not decrypted again for them
+        status = calc_public_shares(dkg_secret, public_shares + i * DKG_PUBLIC_SHARES_SLOT_LEN(_t), _t);
+
+        CHECK_STATUS("calc_public_shares failed")
+
+        status = AES_encrypt(dkg_secret, encrypted_dkg_secret, DKG_MAX_SEALED_LEN, DKG, EXPORTABLE, &enc_lens[i]);
+
+        CHECK_STATUS("SGX AES encrypt DKG poly failed");
+
+        status = checkEncryption(dkg_secret, encrypted_dkg_secret, enc_lens[i], DKG_BUFER_LENGTH);
+
+        CHECK_STATUS("encrypted poly is not equal to decrypted poly");
     }
 
     SET_SUCCESS
     clean:
-    ;
-    LOG_INFO(__FUNCTION__ );
-    LOG_INFO("SGX call completed");
+    memset(dkg_secret, 0, DKG_BUFER_LENGTH);
+    LOG_DEBUG("SGX call completed");
+}
+
+void trustedGenDkgSecretBatch(int *errStatus, char *errString, uint64_t num_polys, uint8_t *encrypted_dkg_secrets,
+                              uint64_t encrypted_len, uint64_t *enc_lens, char *public_shares,
+                              uint64_t public_shares_len, size_t _t) {
+    char localErrString[BUF_LEN];
+    trustedGenDkgSecretBatchImpl(errStatus, localErrString, num_polys, encrypted_dkg_secrets, encrypted_len, enc_lens,
+                                 public_shares, public_shares_len, _t);
+    copyErrorStringOut(*errStatus, localErrString, errString);
 }
 
 void
 trustedDecryptDkgSecret(int *errStatus, char *errString, uint8_t *encrypted_dkg_secret,
                            uint64_t enc_len,
                            uint8_t *decrypted_dkg_secret) {
-    LOG_INFO(__FUNCTION__);
+    LOG_DEBUG(__FUNCTION__);
     INIT_ERROR_STATE
 
     CHECK_STATE(encrypted_dkg_secret);
     CHECK_STATE(decrypted_dkg_secret);
+    CHECK_STATE(enc_len <= DKG_MAX_SEALED_LEN);
 
     uint8_t  type;
     uint8_t  exportable;
 
     int status = AES_decrypt(encrypted_dkg_secret, enc_len, (char *) decrypted_dkg_secret,
-                             3072, &type, &exportable);
+                             DKG_BUFER_LENGTH, &type, &exportable);
 
     CHECK_STATUS2("aes decrypt data - encrypted_dkg_secret failed with status %d")
 
@@ -808,32 +1490,44 @@ trustedDecryptDkgSecret(int *errStatus, char *errString, uint8_t *encrypted_dkg_
 
     clean:
     ;
-    LOG_INFO(__FUNCTION__ );
-    LOG_INFO("SGX call completed");
+    LOG_DEBUG(__FUNCTION__ );
+    LOG_DEBUG("SGX call completed");
 }
 
 
-void trustedSetEncryptedDkgPoly(int *errStatus, char *errString, uint8_t *encrypted_poly, uint64_t enc_len) {
-    LOG_INFO(__FUNCTION__);
+// decrypts the poly into _decryptedPoly (DKG_BUFER_LENGTH bytes), the poly is AES decrypted
+// once per DKG and served from the poly cache afterwards
+static void getDecryptedDkgPoly(int *errStatus, char *errString, uint8_t *encrypted_poly, uint64_t enc_len,
+                                char *_decryptedPoly) {
+    LOG_DEBUG(__FUNCTION__);
     INIT_ERROR_STATE
 
     CHECK_STATE(encrypted_poly);
+    CHECK_STATE(_decryptedPoly);
+    CHECK_STATE(enc_len <= DKG_MAX_SEALED_LEN);
+
+    if (poly_cache_get(encrypted_poly, enc_len, _decryptedPoly)) {
+        SET_SUCCESS
+        return;
+    }
 
-    memset(getThreadLocalDecryptedDkgPoly(), 0, DKG_BUFER_LENGTH);
+    memset(_decryptedPoly, 0, DKG_BUFER_LENGTH);
 
     uint8_t type = 0;
     uint8_t exportable = 0;
 
-    int status = AES_decrypt(encrypted_poly, enc_len, (char *) getThreadLocalDecryptedDkgPoly(),
+    int status = AES_decrypt(encrypted_poly, enc_len, _decryptedPoly,
                              DKG_BUFER_LENGTH, &type, &exportable);
 
     CHECK_STATUS2("sgx_unseal_data - encrypted_poly failed with status %d")
 
+    poly_cache_put(encrypted_poly, enc_len, _decryptedPoly);
+
     SET_SUCCESS
     clean:
     ;
-    LOG_INFO(__FUNCTION__ );
-    LOG_INFO("SGX call completed");
+    LOG_DEBUG(__FUNCTION__ );
+    LOG_DEBUG("SGX call completed");
 }
 
 
@@ -843,7 +1537,7 @@ void trustedGetEncryptedSecretShare(int *errStatus, char *errString,
                                        char *result_str, char *s_shareG2, char *pub_keyB, uint8_t _t, uint8_t _n,
                                        uint8_t ind) {
 
-    LOG_INFO(__FUNCTION__);
+    LOG_DEBUG(__FUNCTION__);
     INIT_ERROR_STATE
 
     uint64_t enc_len;
@@ -856,9 +1550,11 @@ void trustedGetEncryptedSecretShare(int *errStatus, char *errString,
 
     LOG_DEBUG(__FUNCTION__);
 
-    trustedSetEncryptedDkgPoly(&status, errString, _encrypted_poly, _enc_len);
+    SAFE_CHAR_BUF(decryptedPoly, DKG_BUFER_LENGTH);
 
-    CHECK_STATUS2("trustedSetEncryptedDkgPoly failed with status %d ");
+    getDecryptedDkgPoly(&status, errString, _encrypted_poly, _enc_len, decryptedPoly);
+
+    CHECK_STATUS2("getDecryptedDkgPoly failed with status %d ");
 
     SAFE_CHAR_BUF(skey, BUF_LEN);
 
@@ -889,7 +1585,7 @@ void trustedGetEncryptedSecretShare(int *errStatus, char *errString,
 
     SAFE_CHAR_BUF(s_share, BUF_LEN);
 
-    status = calc_secret_share(getThreadLocalDecryptedDkgPoly(), s_share, _t, _n, ind);
+    status = calc_secret_share(decryptedPoly, s_share, _t, _n, ind);
     CHECK_STATUS("calc secret share failed")
 
 
@@ -908,17 +1604,16 @@ void trustedGetEncryptedSecretShare(int *errStatus, char *errString,
     SET_SUCCESS
 
     clean:
-    ;
-    LOG_INFO(__FUNCTION__ );
-    LOG_INFO("SGX call completed");
+    memset(decryptedPoly, 0, DKG_BUFER_LENGTH);
+    LOG_DEBUG(__FUNCTION__ );
+    LOG_DEBUG("SGX call completed");
 }
 
-void trustedGetEncryptedSecretShareV2(int *errStatus, char *errString,
-                                      uint8_t *_encryptedPoly,  uint64_t _encLen,
+// computes one V2 share from the already decrypted poly
+static void getEncryptedSecretShareV2(int *errStatus, char *errString, const char *decryptedPoly,
                                       uint8_t *encryptedSkey, uint64_t *decLen,
                                       char *resultStr, char *secretShareG2, char *pubKeyB, uint8_t _t, uint8_t _n,
                                       uint8_t ind) {
-    LOG_INFO(__FUNCTION__);
     INIT_ERROR_STATE
 
     uint64_t encLen;
@@ -929,12 +1624,6 @@ void trustedGetEncryptedSecretShareV2(int *errStatus, char *errString,
     CHECK_STATE(secretShareG2);
     CHECK_STATE(pubKeyB);
 
-    LOG_DEBUG(__FUNCTION__);
-
-    trustedSetEncryptedDkgPoly(&status, errString, _encryptedPoly, _encLen);
-
-    CHECK_STATUS2("trustedSetEncryptedDkgPoly failed with status %d ");
-
     SAFE_CHAR_BUF(skey, BUF_LEN);
 
     SAFE_CHAR_BUF(pubKeyX, BUF_LEN);
@@ -965,7 +1654,7 @@ void trustedGetEncryptedSecretShareV2(int *errStatus, char *errString,
 
     SAFE_CHAR_BUF(s_share, BUF_LEN);
 
-    status = calc_secret_share(getThreadLocalDecryptedDkgPoly(), s_share, _t, _n, ind);
+    status = calc_secret_share(decryptedPoly, s_share, _t, _n, ind);
     CHECK_STATUS("calc secret share failed")
 
     status = calc_secret_shareG2(s_share, secretShareG2);
@@ -988,23 +1677,126 @@ void trustedGetEncryptedSecretShareV2(int *errStatus, char *errString,
     SET_SUCCESS
 
     clean:
-    ;
-    LOG_INFO(__FUNCTION__ );
-    LOG_INFO("SGX call completed");
+    memset(skey, 0, BUF_LEN);
+    memset(s_share, 0, BUF_LEN);
+}
+
+void trustedGetEncryptedSecretShareV2(int *errStatus, char *errString,
+                                      uint8_t *_encryptedPoly,  uint64_t _encLen,
+                                      uint8_t *encryptedSkey, uint64_t *decLen,
+                                      char *resultStr, char *secretShareG2, char *pubKeyB, uint8_t _t, uint8_t _n,
+                                      uint8_t ind) {
+    SCRATCH_SCOPE
+    LOG_DEBUG(__FUNCTION__);
+    INIT_ERROR_STATE
+
+    int status;
+
+    SCRATCH_CHAR_BUF(decryptedPoly, DKG_BUFER_LENGTH);
+
+    getDecryptedDkgPoly(&status, errString, _encryptedPoly, _encLen, decryptedPoly);
+
+    CHECK_STATUS2("getDecryptedDkgPoly failed with status %d ");
+
+    getEncryptedSecretShareV2(errStatus, errString, decryptedPoly, encryptedSkey, decLen, resultStr, secretShareG2,
+                              pubKeyB, _t, _n, ind);
+
+    clean:
+    LOG_DEBUG(__FUNCTION__ );
+    LOG_DEBUG("SGX call completed");
+}
+
+void trustedGetEncryptedSecretSharesV2(int *errStatus, char *errString,
+                                       uint8_t *_encryptedPoly, uint64_t _encLen, uint64_t num_shares,
+                                       const char *pub_keys, uint64_t pub_keys_len,
+                                       uint8_t *encrypted_skeys, uint64_t skeys_len, uint64_t *dec_lens,
+                                       char *result_strs, uint64_t shares_len,
+                                       char *s_shares_g2, uint64_t shares_g2_len, uint8_t _t) {
+    SCRATCH_SCOPE
+    LOG_DEBUG(__FUNCTION__);
+    INIT_ERROR_STATE
+
+    CHECK_STATE(pub_keys);
+    CHECK_STATE(encrypted_skeys);
+    CHECK_STATE(dec_lens);
+    CHECK_STATE(result_strs);
+    CHECK_STATE(s_shares_g2);
+    CHECK_STATE(num_shares > 0 && num_shares <= MAX_DKG_SHARES_BATCH_SIZE);
+    CHECK_STATE(pub_keys_len == num_shares * DKG_BATCH_PUB_KEY_SLOT_LEN);
+    CHECK_STATE(skeys_len == num_shares * DKG_BATCH_SKEY_SLOT_LEN);
+    CHECK_STATE(shares_len == num_shares * DKG_BATCH_SHARE_SLOT_LEN);
+    CHECK_STATE(shares_g2_len == num_shares * DKG_BATCH_SHARE_G2_SLOT_LEN);
+
+    for (uint64_t i = 0; i < num_shares; i++) {
+        CHECK_STATE(pub_keys[(i + 1) * DKG_BATCH_PUB_KEY_SLOT_LEN - 1] == 0);
+    }
+
+    int status;
+
+    // the poly is decrypted once for all shares
+    SCRATCH_CHAR_BUF(decryptedPoly, DKG_BUFER_LENGTH);
+
+    getDecryptedDkgPoly(&status, errString, _encryptedPoly, _encLen, decryptedPoly);
+
+    CHECK_STATUS2("getDecryptedDkgPoly failed with status %d ");
+
+    uint8_t encryptedSkey[BUF_LEN];
+
+    for (uint64_t i = 0; i < num_shares; i++) {
+        uint64_t decLen = 0;
+
+        getEncryptedSecretShareV2(errStatus, errString, decryptedPoly, encryptedSkey, &decLen,
+                                  result_strs + i * DKG_BATCH_SHARE_SLOT_LEN,
+                                  s_shares_g2 + i * DKG_BATCH_SHARE_G2_SLOT_LEN,
+                                  (char *) pub_keys + i * DKG_BATCH_PUB_KEY_SLOT_LEN, _t, (uint8_t) num_shares,
+                                  (uint8_t) (i + 1));
+
+        if (*errStatus != 0)
+            goto clean;
+
+        CHECK_STATE_CLEAN(decLen <= DKG_BATCH_SKEY_SLOT_LEN);
+        CHECK_STATE_CLEAN(result_strs[(i + 1) * DKG_BATCH_SHARE_SLOT_LEN - 1] == 0);
+        CHECK_STATE_CLEAN(s_shares_g2[(i + 1) * DKG_BATCH_SHARE_G2_SLOT_LEN - 1] == 0);
+
+        memcpy(encrypted_skeys + i * DKG_BATCH_SKEY_SLOT_LEN, encryptedSkey, decLen);
+        dec_lens[i] = decLen;
+    }
+
+    SET_SUCCESS
+
+    clean:
+    LOG_DEBUG(__FUNCTION__ );
+    LOG_DEBUG("SGX call completed");
+}
+
+void trustedEraseDkgPoly(int *errStatus, char *errString, uint8_t *encrypted_poly, uint64_t enc_len) {
+    LOG_DEBUG(__FUNCTION__);
+    INIT_ERROR_STATE
+
+    CHECK_STATE(encrypted_poly);
+
+    poly_cache_erase(encrypted_poly, enc_len);
+
+    SET_SUCCESS
+
+    LOG_DEBUG(__FUNCTION__ );
+    LOG_DEBUG("SGX call completed");
 }
 
 void trustedGetPublicShares(int *errStatus, char *errString, uint8_t *encrypted_dkg_secret, uint64_t enc_len,
                                char *public_shares,
                                unsigned _t) {
-    LOG_INFO(__FUNCTION__);
+    SCRATCH_SCOPE
+    LOG_DEBUG(__FUNCTION__);
 
     INIT_ERROR_STATE
 
     CHECK_STATE(encrypted_dkg_secret);
     CHECK_STATE(public_shares);
-    CHECK_STATE(_t > 0)
+    CHECK_STATE(_t > 0 && _t <= MAX_DKG_N)
+    CHECK_STATE(enc_len <= DKG_MAX_SEALED_LEN);
 
-    SAFE_CHAR_BUF(decrypted_dkg_secret, DKG_MAX_SEALED_LEN);
+    SCRATCH_CHAR_BUF(decrypted_dkg_secret, DKG_MAX_SEALED_LEN);
 
     uint8_t type = 0;
     uint8_t exportable = 0;
@@ -1021,12 +1813,12 @@ void trustedGetPublicShares(int *errStatus, char *errString, uint8_t *encrypted_
 
     clean:
     ;
-    LOG_INFO("SGX call completed");
+    LOG_DEBUG("SGX call completed");
 }
 
 void trustedDkgVerify(int *errStatus, char *errString, const char *public_shares, const char *s_share,
                          uint8_t *encryptedPrivateKey, uint64_t enc_len, unsigned _t, int _ind, int *result) {
-    LOG_INFO(__FUNCTION__);
+    LOG_DEBUG(__FUNCTION__);
 
     INIT_ERROR_STATE
 
@@ -1072,19 +1864,44 @@ void trustedDkgVerify(int *errStatus, char *errString, const char *public_shares
     clean:
 
     mpz_clear(s);
-    LOG_INFO(__FUNCTION__ );
-    LOG_INFO("SGX call completed");
+    LOG_DEBUG(__FUNCTION__ );
+    LOG_DEBUG("SGX call completed");
 }
 
-void trustedDkgVerifyV2(int *errStatus, char *errString, const char *publicShares, const char *secretShare,
-                         uint8_t *encryptedPrivateKey, uint64_t encLen, unsigned _t, int _ind, int *result) {
-    LOG_INFO(__FUNCTION__);
+// recovers one V2 secret share into s, *decrypted is 1 if it decrypts
+static void decryptShareV2(const char *skey, const char *secretShare, mpz_t s, int *decrypted) {
+    SAFE_CHAR_BUF(encrSshare, BUF_LEN);
+    strncpy(encrSshare, secretShare, ECDSA_SKEY_LEN - 1);
+
+    SAFE_CHAR_BUF(commonKey, BUF_LEN);
+    SAFE_CHAR_BUF(derivedKey, BUF_LEN);
+    SAFE_CHAR_BUF(decrSshare, BUF_LEN);
+
+    *decrypted = 0;
+
+    if (session_key_recover(skey, secretShare, commonKey) == 0 &&
+        hash_key(commonKey, derivedKey, ECDSA_BIN_LEN - 1, true) == 0) {
+        derivedKey[ECDSA_BIN_LEN - 1] = 0;
+        if (xor_decrypt_v2(derivedKey, encrSshare, decrSshare) == 0 &&
+            mpz_set_str(s, decrSshare, 16) == 0) {
+            *decrypted = 1;
+        }
+    }
+
+    memset(commonKey, 0, BUF_LEN);
+    memset(derivedKey, 0, BUF_LEN);
+    memset(decrSshare, 0, BUF_LEN);
+}
+
+void trustedDkgShareG2(int *errStatus, char *errString, const char *secretShare,
+                       uint8_t *encryptedPrivateKey, uint64_t encLen, uint64_t *shareG2) {
+    LOG_DEBUG(__FUNCTION__);
 
     INIT_ERROR_STATE
 
-    CHECK_STATE(publicShares);
     CHECK_STATE(secretShare);
     CHECK_STATE(encryptedPrivateKey);
+    CHECK_STATE(shareG2);
 
     SAFE_CHAR_BUF(skey,BUF_LEN);
 
@@ -1097,47 +1914,89 @@ void trustedDkgVerifyV2(int *errStatus, char *errString, const char *publicShare
     int status = AES_decrypt(encryptedPrivateKey, encLen, skey, BUF_LEN,
                              &type, &exportable);
 
-    CHECK_STATUS2("AES_decrypt failed (in trustedDkgVerifyAES) with status %d");
+    CHECK_STATUS2("AES_decrypt failed (in trustedDkgShareG2) with status %d");
 
-    SAFE_CHAR_BUF(encrSshare, BUF_LEN);
+    int decrypted = 0;
 
-    strncpy(encrSshare, secretShare, ECDSA_SKEY_LEN - 1);
+    decryptShareV2(skey, secretShare, s, &decrypted);
 
-    SAFE_CHAR_BUF(commonKey, BUF_LEN);
+    status = !decrypted;
 
-    status = session_key_recover(skey, secretShare, commonKey);
+    CHECK_STATUS("could not decrypt secret share");
 
-    CHECK_STATUS("session_key_recover failed");
+    status = calc_share_g2_images(&s, 1, &decrypted, shareG2);
 
-    SAFE_CHAR_BUF(derivedKey, BUF_LEN);
-    status = hash_key(commonKey, derivedKey, ECDSA_BIN_LEN - 1, true);
-    CHECK_STATUS("hash key failed")
-    derivedKey[ECDSA_BIN_LEN - 1] = 0;
+    CHECK_STATUS("calc_share_g2_images failed");
 
-    SAFE_CHAR_BUF(decrSshare, BUF_LEN);
+    SET_SUCCESS
+    clean:
 
-    status = xor_decrypt_v2(derivedKey, encrSshare, decrSshare);
+    mpz_clear(s);
+    memset(skey, 0, BUF_LEN);
+    LOG_DEBUG(__FUNCTION__ );
+    LOG_DEBUG("SGX call completed");
+}
 
-    CHECK_STATUS("xor_decrypt failed")
+void trustedDkgShareG2Batch(int *errStatus, char *errString, const char *secretShares, uint64_t secretSharesLen,
+                            uint64_t numShares, uint8_t *encryptedPrivateKey, uint64_t encLen,
+                            uint64_t *shareG2s, uint64_t shareG2sLen, int *decrypted) {
+    LOG_DEBUG(__FUNCTION__);
 
-    status = mpz_set_str(s, decrSshare, 16);
-    CHECK_STATUS("invalid decr secret share");
+    INIT_ERROR_STATE
+
+    CHECK_STATE(secretShares);
+    CHECK_STATE(encryptedPrivateKey);
+    CHECK_STATE(shareG2s);
+    CHECK_STATE(decrypted);
+    CHECK_STATE(numShares > 0 && numShares <= MAX_DKG_SHARES_BATCH_SIZE);
+    CHECK_STATE(secretSharesLen == numShares * DKG_BATCH_SHARE_SLOT_LEN);
+    CHECK_STATE(shareG2sLen == numShares * BLS_G2_LIMBS * sizeof(uint64_t));
+
+    for (uint64_t i = 0; i < numShares; i++) {
+        CHECK_STATE(secretShares[(i + 1) * DKG_BATCH_SHARE_SLOT_LEN - 1] == 0);
+    }
+
+    SAFE_CHAR_BUF(skey, BUF_LEN);
+
+    mpz_t s[MAX_DKG_SHARES_BATCH_SIZE];
+    for (uint64_t i = 0; i < numShares; i++) {
+        mpz_init(s[i]);
+    }
+
+    uint8_t type = 0;
+    uint8_t exportable = 0;
+
+    // the receiver key is decrypted once, only the DH keys differ per dealer
+    int status = AES_decrypt(encryptedPrivateKey, encLen, skey, BUF_LEN,
+                             &type, &exportable);
+
+    CHECK_STATUS2("AES_decrypt failed (in trustedDkgShareG2Batch) with status %d");
+
+    // a share that does not decrypt fails only its own dealer
+    for (uint64_t i = 0; i < numShares; i++) {
+        decryptShareV2(skey, secretShares + i * DKG_BATCH_SHARE_SLOT_LEN, s[i], &decrypted[i]);
+    }
 
-    *result = Verification(publicShares, s, _t, _ind);
+    status = calc_share_g2_images(s, numShares, decrypted, shareG2s);
+
+    CHECK_STATUS("calc_share_g2_images failed");
 
     SET_SUCCESS
     clean:
 
-    mpz_clear(s);
-    LOG_INFO(__FUNCTION__ );
-    LOG_INFO("SGX call completed");
+    for (uint64_t i = 0; i < numShares; i++) {
+        mpz_clear(s[i]);
+    }
+    memset(skey, 0, BUF_LEN);
+    LOG_DEBUG(__FUNCTION__ );
+    LOG_DEBUG("SGX call completed");
 }
 
 void trustedCreateBlsKey(int *errStatus, char *errString, const char *s_shares,
                             uint8_t *encryptedPrivateKey, uint64_t key_len, uint8_t *encr_bls_key,
                             uint64_t *enc_bls_key_len) {
 
-    LOG_INFO(__FUNCTION__);
+    LOG_DEBUG(__FUNCTION__);
 
     INIT_ERROR_STATE
 
@@ -1169,6 +2028,7 @@ void trustedCreateBlsKey(int *errStatus, char *errString, const char *s_shares,
     skey[ECDSA_SKEY_LEN - 1] = 0;
 
     int num_shares = strlen(s_shares) / 192;
+    CHECK_STATE_CLEAN(num_shares > 0 && num_shares <= MAX_DKG_N);
 
     for (int i = 0; i < num_shares; i++) { SAFE_CHAR_BUF(encr_sshare, 65);
         strncpy(encr_sshare, s_shares + 192 * i, 64);
@@ -1232,15 +2092,15 @@ void trustedCreateBlsKey(int *errStatus, char *errString, const char *s_shares,
     mpz_clear(bls_key);
     mpz_clear(sum);
     mpz_clear(q);
-    LOG_INFO(__FUNCTION__ );
-    LOG_INFO("SGX call completed");
+    LOG_DEBUG(__FUNCTION__ );
+    LOG_DEBUG("SGX call completed");
 }
 
 void trustedCreateBlsKeyV2(int *errStatus, char *errString, const char *secretShares,
                             uint8_t *encryptedPrivateKey, uint64_t keyLen, uint8_t *encrBlsKey,
                             uint64_t *encBlsKeyLen) {
 
-    LOG_INFO(__FUNCTION__);
+    LOG_DEBUG(__FUNCTION__);
 
     INIT_ERROR_STATE
 
@@ -1250,6 +2110,11 @@ void trustedCreateBlsKeyV2(int *errStatus, char *errString, const char *secretSh
 
     SAFE_CHAR_BUF(skey, BUF_LEN);
 
+    SAFE_CHAR_BUF(commonKeys, MAX_DKG_SHARES_BATCH_SIZE * ECDSA_SKEY_LEN);
+
+    mpz_t decryptedSecretShare;
+    mpz_init(decryptedSecretShare);
+
     mpz_t sum;
     mpz_init(sum);
     mpz_set_ui(sum, 0);
@@ -1272,25 +2137,19 @@ void trustedCreateBlsKeyV2(int *errStatus, char *errString, const char *secretSh
 
     int numShares = strlen(secretShares) / 192;
 
-    for (int i = 0; i < numShares; i++) {
-        SAFE_CHAR_BUF(encrSecretShare, 65);
-        strncpy(encrSecretShare, secretShares + 192 * i, 64);
-        encrSecretShare[64] = 0;
-
-        SAFE_CHAR_BUF(secretShare, 193);
-        strncpy(secretShare, secretShares + 192 * i, 192);
-        secretShare[192] = 0;
+    CHECK_STATE_CLEAN(numShares > 0 && numShares <= MAX_DKG_SHARES_BATCH_SIZE);
 
-        SAFE_CHAR_BUF(commonKey, 65);
+    // all common keys are recovered with one parse of skey and one split of the multiplier
+    status = session_keys_recover(skey, secretShares, numShares, commonKeys);
 
-        status = session_key_recover(skey, secretShare, commonKey);
+    CHECK_STATUS("session_keys_recover failed");
 
-        CHECK_STATUS("session_key_recover failed");
-
-        commonKey[64] = 0;
+    for (int i = 0; i < numShares; i++) {
+        SAFE_CHAR_BUF(encrSecretShare, 65);
+        memcpy(encrSecretShare, secretShares + 192 * i, 64);
 
         SAFE_CHAR_BUF(derivedKey, BUF_LEN);
-        status = hash_key(commonKey, derivedKey, ECDSA_BIN_LEN - 1, true);
+        status = hash_key(commonKeys + i * ECDSA_SKEY_LEN, derivedKey, ECDSA_BIN_LEN - 1, true);
         CHECK_STATUS("hash key failed")
         derivedKey[ECDSA_BIN_LEN - 1] = 0;
 
@@ -1298,23 +2157,24 @@ void trustedCreateBlsKeyV2(int *errStatus, char *errString, const char *secretSh
 
         status = xor_decrypt_v2(derivedKey, encrSecretShare, decrSecretShare);
 
+        memset(derivedKey, 0, BUF_LEN);
+
         CHECK_STATUS("xor_decrypt failed");
 
         decrSecretShare[64] = 0;
 
-        mpz_t decryptedSecretShare;
-        mpz_init(decryptedSecretShare);
-        if (mpz_set_str(decryptedSecretShare, decrSecretShare, 16) == -1) {
+        status = mpz_set_str(decryptedSecretShare, decrSecretShare, 16);
+
+        memset(decrSecretShare, 0, 65);
+
+        if (status == -1) {
             *errStatus = 111;
             snprintf(errString, BUF_LEN, "invalid decrypted secret share");
             LOG_ERROR(errString);
-
-            mpz_clear(decryptedSecretShare);
             goto clean;
         }
 
-        mpz_addmul_ui(sum, decryptedSecretShare, 1);
-        mpz_clear(decryptedSecretShare);
+        mpz_add(sum, sum, decryptedSecretShare);
     }
 
     mpz_mod(blsKey, sum, q);
@@ -1338,11 +2198,14 @@ void trustedCreateBlsKeyV2(int *errStatus, char *errString, const char *secretSh
     SET_SUCCESS
     clean:
 
+    memset(skey, 0, BUF_LEN);
+    memset(commonKeys, 0, MAX_DKG_SHARES_BATCH_SIZE * ECDSA_SKEY_LEN);
+    mpz_clear(decryptedSecretShare);
     mpz_clear(blsKey);
     mpz_clear(sum);
     mpz_clear(q);
-    LOG_INFO(__FUNCTION__ );
-    LOG_INFO("SGX call completed");
+    LOG_DEBUG(__FUNCTION__ );
+    LOG_DEBUG("SGX call completed");
 }
 
 void
@@ -1360,12 +2223,18 @@ trustedGetBlsPubKey(int *errStatus, char *errString, uint8_t *encryptedPrivateKe
     uint8_t type = 0;
     uint8_t exportable = 0;
 
-    int status = AES_decrypt(encryptedPrivateKey, key_len, skey_hex, BUF_LEN,
+    int status = 0;
+
+    if (!key_cache_get_hex(encryptedPrivateKey, key_len, skey_hex)) {
+        status = AES_decrypt(encryptedPrivateKey, key_len, skey_hex, BUF_LEN,
                              &type, &exportable);
 
-    CHECK_STATUS2("AES decrypt failed %d");
+        CHECK_STATUS2("AES decrypt failed %d");
+
+        skey_hex[ECDSA_SKEY_LEN - 1] = 0;
 
-    skey_hex[ECDSA_SKEY_LEN - 1] = 0;
+        key_cache_put_hex(encryptedPrivateKey, key_len, skey_hex);
+    }
 
     status = calc_bls_public_key(skey_hex, bls_pub_key);
 
@@ -1375,6 +2244,7 @@ trustedGetBlsPubKey(int *errStatus, char *errString, uint8_t *encryptedPrivateKe
 
     clean:
     ;
+    memset(skey_hex, 0, BUF_LEN);
 }
 
 void trustedGetDecryptionShare( int *errStatus, char* errString, uint8_t* encryptedPrivateKey,
@@ -1392,12 +2262,18 @@ void trustedGetDecryptionShare( int *errStatus, char* errString, uint8_t* encryp
     uint8_t type = 0;
     uint8_t exportable = 0;
 
-    int status = AES_decrypt(encryptedPrivateKey, key_len, skey_hex, BUF_LEN,
+    int status = 0;
+
+    if (!key_cache_get_hex(encryptedPrivateKey, key_len, skey_hex)) {
+        status = AES_decrypt(encryptedPrivateKey, key_len, skey_hex, BUF_LEN,
                              &type, &exportable);
 
-    CHECK_STATUS2("AES decrypt failed %d");
+        CHECK_STATUS2("AES decrypt failed %d");
 
-    skey_hex[ECDSA_SKEY_LEN - 1] = 0;
+        skey_hex[ECDSA_SKEY_LEN - 1] = 0;
+
+        key_cache_put_hex(encryptedPrivateKey, key_len, skey_hex);
+    }
 
     status = getDecryptionShare(skey_hex, public_decryption_value, decryption_share);
 
@@ -1407,14 +2283,58 @@ void trustedGetDecryptionShare( int *errStatus, char* errString, uint8_t* encryp
 
     clean:
     ;
+    memset(skey_hex, 0, BUF_LEN);
 }
 
-void trustedGenerateBLSKey(int *errStatus, char *errString, int *isExportable,
-                           uint8_t *encryptedPrivateKey, uint64_t *encLen) {
-    LOG_INFO(__FUNCTION__);
+void trustedGetDecryptionShares(int *errStatus, char *errString, uint8_t *encryptedPrivateKey, uint64_t key_len,
+                                uint64_t *public_decryption_values, uint64_t values_len,
+                                uint64_t *decryption_shares) {
+    LOG_DEBUG(__FUNCTION__);
+
     INIT_ERROR_STATE
 
     CHECK_STATE(encryptedPrivateKey);
+    CHECK_STATE(public_decryption_values);
+    CHECK_STATE(decryption_shares);
+    CHECK_STATE(values_len > 0 && values_len % BLS_G2_LIMBS == 0);
+    CHECK_STATE(values_len / BLS_G2_LIMBS <= MAX_DECRYPTION_SHARES_BATCH_SIZE);
+
+    SAFE_CHAR_BUF(skey_hex, BUF_LEN);
+
+    uint8_t type = 0;
+    uint8_t exportable = 0;
+
+    int status = 0;
+
+    // the key is decrypted once for the whole batch
+    if (!key_cache_get_hex(encryptedPrivateKey, key_len, skey_hex)) {
+        status = AES_decrypt(encryptedPrivateKey, key_len, skey_hex, BUF_LEN,
+                             &type, &exportable);
+
+        CHECK_STATUS2("AES decrypt failed %d");
+
+        skey_hex[ECDSA_SKEY_LEN - 1] = 0;
+
+        key_cache_put_hex(encryptedPrivateKey, key_len, skey_hex);
+    }
+
+    status = getDecryptionShares(skey_hex, public_decryption_values, values_len / BLS_G2_LIMBS,
+                                 decryption_shares);
+
+    CHECK_STATUS("could not calculate decryption shares");
+
+    SET_SUCCESS
+
+    clean:
+    ;
+    memset(skey_hex, 0, BUF_LEN);
+}
+
+// derives a fresh BLS private key from enclave randomness, as 64 hex digits
+static void gen_bls_key_hex(int *errStatus, char *errString, char *blsKey) {
+    INIT_ERROR_STATE
+
+    CHECK_STATE(blsKey);
 
     RANDOM_CHAR_BUF(randChar, 32);
 
@@ -1495,8 +2415,6 @@ void trustedGenerateBLSKey(int *errStatus, char *errString, int *isExportable,
 
     mpz_mod(skey, seed, q);
 
-    SAFE_CHAR_BUF(blsKey, BLS_KEY_LENGTH);
-
     SAFE_CHAR_BUF(arrSkeyStr, BUF_LEN);
 
     if (mpz_get_str(arrSkeyStr, 16, skey) == -1) {
@@ -1514,7 +2432,31 @@ void trustedGenerateBLSKey(int *errStatus, char *errString, int *isExportable,
     strncpy(blsKey + nZeroes, arrSkeyStr, 65 - nZeroes);
     blsKey[BLS_KEY_LENGTH - 1] = 0;
 
-    int status;
+    SET_SUCCESS
+    clean:
+
+    mpz_clear(seed);
+    mpz_clear(skey);
+    mpz_clear(q);
+}
+
+void trustedGenerateBLSKey(int *errStatus, char *errString, int *isExportable,
+                           uint8_t *encryptedPrivateKey, uint64_t *encLen) {
+    LOG_DEBUG(__FUNCTION__);
+    INIT_ERROR_STATE
+
+    CHECK_STATE(encryptedPrivateKey);
+
+    SAFE_CHAR_BUF(blsKey, BLS_KEY_LENGTH);
+
+    int status = 0;
+
+    gen_bls_key_hex(errStatus, errString, blsKey);
+
+    if (*errStatus != 0) {
+        goto clean;
+    }
+
     if (isExportable) {
         status = AES_encrypt(blsKey, encryptedPrivateKey, BUF_LEN, BLS, EXPORTABLE, encLen);
     } else {
@@ -1526,9 +2468,62 @@ void trustedGenerateBLSKey(int *errStatus, char *errString, int *isExportable,
     SET_SUCCESS
     clean:
 
-    mpz_clear(seed);
-    mpz_clear(skey);
-    mpz_clear(q);
-    LOG_INFO(__FUNCTION__ );
-    LOG_INFO("SGX call completed");
+    memset(blsKey, 0, BLS_KEY_LENGTH);
+    LOG_DEBUG(__FUNCTION__ );
+    LOG_DEBUG("SGX call completed");
+}
+
+// generates the keys one after another, each is sealed into its own slot together with its public key
+static void trustedGenerateBLSKeyBatchImpl(int *errStatus, char *errString, uint64_t num_keys,
+                                           uint8_t *encrypted_keys, uint64_t encrypted_len, uint64_t *enc_lens,
+                                           char *bls_pub_keys, uint64_t pub_keys_len) {
+    LOG_DEBUG(__FUNCTION__);
+    INIT_ERROR_STATE
+
+    CHECK_STATE(encrypted_keys);
+    CHECK_STATE(enc_lens);
+    CHECK_STATE(bls_pub_keys);
+    CHECK_STATE(num_keys > 0 && num_keys <= MAX_BLS_KEY_BATCH_SIZE);
+    CHECK_STATE(encrypted_len == num_keys * BLS_BATCH_KEY_SLOT_LEN);
+    CHECK_STATE(pub_keys_len == num_keys * BLS_KEY_BATCH_PUB_KEY_SLOT_LEN);
+
+    SAFE_CHAR_BUF(blsKey, BLS_KEY_LENGTH);
+
+    int status = 0;
+
+    for (uint64_t i = 0; i < num_keys; i++) {
+        memset(blsKey, 0, BLS_KEY_LENGTH);
+
+        gen_bls_key_hex(errStatus, errString, blsKey);
+
+        if (*errStatus != 0) {
+            goto clean;
+        }
+
+        // the public key is computed from the plain key, so the key is not decrypted again for it
+        status = calc_bls_public_key(blsKey, bls_pub_keys + i * BLS_KEY_BATCH_PUB_KEY_SLOT_LEN);
+
+        CHECK_STATUS("could not calculate bls public key");
+
+        // sealed like the keys of trustedGenerateBLSKey
+        status = AES_encrypt(blsKey, encrypted_keys + i * BLS_BATCH_KEY_SLOT_LEN, BLS_BATCH_KEY_SLOT_LEN, BLS,
+                             EXPORTABLE, &enc_lens[i]);
+
+        CHECK_STATUS2("aes encrypt bls private key failed with status %d ");
+    }
+
+    SET_SUCCESS
+    clean:
+
+    memset(blsKey, 0, BLS_KEY_LENGTH);
+    LOG_DEBUG("SGX call completed");
+}
+
+void trustedGenerateBLSKeyBatch(int *errStatus, char *errString, uint64_t num_keys, uint8_t *encrypted_keys,
+                                uint64_t encrypted_len, uint64_t *enc_lens, char *bls_pub_keys,
+                                uint64_t pub_keys_len) {
+    char localErrString[BUF_LEN];
+    trustedGenerateBLSKeyBatchImpl(errStatus, localErrString, num_keys, encrypted_keys, encrypted_len, enc_lens,
+                                   bls_pub_keys, pub_keys_len);
+    copyErrorStringOut(*errStatus, localErrString, errString);
 }
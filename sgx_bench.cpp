@@ -0,0 +1,353 @@
+/*
+    Copyright (C) 2021-Present SKALE Labs
+
+    This file is part of sgxwallet.
+
+    sgxwallet is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as published
+    by the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    sgxwallet is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with sgxwallet.  If not, see <https://www.gnu.org/licenses/>.
+
+    @file sgx_bench.cpp
+    @author Stan Kladko
+    @date 2021
+*/
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <thread>
+#include <unistd.h>
+
+#include <jsonrpccpp/client/connectors/httpclient.h>
+
+#include "sgxwallet_common.h"
+#include "stubclient.h"
+#include "zmq_src/ZMQClient.h"
+#include "common.h"
+
+// Load generator for the sign APIs of a running sgxwallet.
+//
+// Closed loop: each thread sends the next request as soon as the previous one completes.
+// Open loop (-r): requests are scheduled at a fixed total rate independent of the server,
+// and latency is measured from the scheduled send time, so queueing delay is not hidden
+// when the server falls behind.
+
+struct BenchOptions {
+    bool useZMQ = true;
+    bool ecdsa = false;
+    bool sign = false;
+    string url = "http://localhost:" + to_string(BASE_PORT + 3);
+    string zmqIp = "127.0.0.1";
+    string certFile = "./sgx_data/cert_data/rootCA.pem";
+    string certKeyFile = "./sgx_data/cert_data/rootCA.key";
+    uint64_t threads = 10;
+    uint64_t keys = 1;
+    uint64_t batch = 1;
+    uint64_t durationSeconds = 30;
+    uint64_t rate = 0;
+};
+
+static BenchOptions options;
+
+static shared_ptr<ZMQClient> zmqClient;
+
+static vector<string> keyNames;
+
+static atomic<uint64_t> errors(0);
+
+static string randomHex(mt19937_64 &_rand, uint64_t _bytes) {
+    static const char digits[] = "0123456789abcdef";
+    string result;
+    result.reserve(2 * _bytes);
+    for (uint64_t i = 0; i < 2 * _bytes; i++) {
+        result.push_back(digits[_rand() & 0xF]);
+    }
+    return result;
+}
+
+static void printUsage() {
+    cerr << "sgx_bench: load generator for sgxwallet sign APIs\n\n";
+    cerr << "   -z  Use the ZMQ API (default) \n";
+    cerr << "   -u  url Use the JSON-RPC API at url, https urls use the HTTPS server. Default is " << options.url << " \n";
+    cerr << "   -i  ip ZMQ server ip, or ipc://path for a server started with -I. Default is " << options.zmqIp << " \n";
+    cerr << "   -e  Benchmark ECDSA signing instead of BLS signing \n";
+    cerr << "   -s  Sign ZMQ requests with the client certificate given by -C and -K \n";
+    cerr << "   -C  file Client certificate. Default is " << options.certFile << " \n";
+    cerr << "   -K  file Client certificate key. Default is " << options.certKeyFile << " \n";
+    cerr << "   -c  number Concurrency, number of client threads. Default is " << options.threads << " \n";
+    cerr << "   -k  number Number of keys to sign with. Default is " << options.keys << " \n";
+    cerr << "   -b  number Hashes per batch request, 1 sends single sign requests. Default is " << options.batch << " \n";
+    cerr << "   -d  seconds Duration of the run. Default is " << options.durationSeconds << " \n";
+    cerr << "   -r  number Open loop mode with this many requests per second in total. Default is 0 (closed loop) \n";
+}
+
+static void createKeys(StubClient *_c) {
+    mt19937_64 rand(random_device{}());
+
+    for (uint64_t i = 0; i < options.keys; i++) {
+        if (options.ecdsa) {
+            if (zmqClient) {
+                keyNames.push_back(zmqClient->generateECDSAKey().second);
+            } else {
+                auto result = _c->generateECDSAKey();
+                CHECK_STATE(result["status"] == 0);
+                keyNames.push_back(result["keyName"].asString());
+            }
+        } else {
+            auto name = "BLS_KEY:SCHAIN_ID:" + to_string(rand() % 1000000000) + ":NODE_ID:0:DKG_ID:" + to_string(i);
+            auto share = "0x" + randomHex(rand, 31);
+            if (zmqClient) {
+                CHECK_STATE(zmqClient->importBLSKeyShare(share, name));
+            } else {
+                CHECK_STATE(_c->importBLSKeyShare(share, name)["status"] == 0);
+            }
+            keyNames.push_back(name);
+        }
+    }
+}
+
+// one request, returns the number of signatures. Every hash is random, so identical
+// requests are never coalesced or answered from the result cache of the server
+static uint64_t doRequest(StubClient *_c, mt19937_64 &_rand) {
+    auto &keyName = keyNames.at(_rand() % keyNames.size());
+
+    vector<string> hashes;
+    for (uint64_t i = 0; i < options.batch; i++) {
+        hashes.push_back(randomHex(_rand, 32));
+    }
+
+    if (zmqClient) {
+        if (options.ecdsa) {
+            if (options.batch == 1) {
+                zmqClient->ecdsaSignMessageHash(16, keyName, hashes.front());
+            } else {
+                CHECK_STATE(zmqClient->ecdsaSignMessageHashBatch(16, keyName, hashes).size() == options.batch);
+            }
+        } else {
+            if (options.batch == 1) {
+                zmqClient->blsSignMessageHash(keyName, hashes.front(), 1, 1);
+            } else {
+                vector<tuple<string, string, int, int>> requests;
+                for (auto &&hash : hashes) {
+                    requests.emplace_back(keyName, hash, 1, 1);
+                }
+                CHECK_STATE(zmqClient->blsSignMessageHashBatch(requests).size() == options.batch);
+            }
+        }
+        return options.batch;
+    }
+
+    Json::Value result;
+
+    if (options.ecdsa && options.batch > 1) {
+        Json::Value hashArray(Json::arrayValue);
+        for (auto &&hash : hashes) {
+            hashArray.append(hash);
+        }
+        result = _c->ecdsaSignMessageHashBatch(16, keyName, hashArray);
+    } else if (options.ecdsa) {
+        result = _c->ecdsaSignMessageHash(16, keyName, hashes.front());
+    } else {
+        result = _c->blsSignMessageHash(keyName, hashes.front(), 1, 1);
+    }
+
+    CHECK_STATE(result["status"] == 0);
+    return options.ecdsa ? options.batch : 1;
+}
+
+static void benchThread(uint64_t _index, chrono::steady_clock::time_point _start, vector<uint64_t> &_latenciesUs,
+                        uint64_t &_signatures) {
+    mt19937_64 rand(random_device{}() + _index);
+
+    shared_ptr<jsonrpc::HttpClient> httpClient;
+    shared_ptr<StubClient> c;
+
+    if (!zmqClient) {
+        httpClient = make_shared<jsonrpc::HttpClient>(options.url);
+        c = make_shared<StubClient>(*httpClient, jsonrpc::JSONRPC_CLIENT_V2);
+    }
+
+    auto end = _start + chrono::seconds(options.durationSeconds);
+
+    // in open loop mode the threads take turns, thread i sends requests i, i + threads, ...
+    chrono::nanoseconds interval(options.rate > 0 ? 1000000000 / options.rate * options.threads : 0);
+    auto scheduled = _start + (options.rate > 0 ? chrono::nanoseconds(1000000000 / options.rate * _index)
+                                                : chrono::nanoseconds(0));
+
+    while (true) {
+        auto now = chrono::steady_clock::now();
+
+        if (options.rate > 0) {
+            if (scheduled >= end) {
+                break;
+            }
+            if (scheduled > now) {
+                this_thread::sleep_until(scheduled);
+            }
+        } else {
+            if (now >= end) {
+                break;
+            }
+            scheduled = now;
+        }
+
+        try {
+            _signatures += doRequest(c.get(), rand);
+            _latenciesUs.push_back(
+                    chrono::duration_cast<chrono::microseconds>(chrono::steady_clock::now() - scheduled).count());
+        } catch (exception &e) {
+            if (errors++ == 0) {
+                cerr << "Request failed: " << e.what() << endl;
+            }
+        }
+
+        scheduled += interval;
+    }
+}
+
+static uint64_t percentile(const vector<uint64_t> &_sorted, double _p) {
+    if (_sorted.empty()) {
+        return 0;
+    }
+    auto index = (uint64_t) (_p * (_sorted.size() - 1));
+    return _sorted.at(index);
+}
+
+int main(int argc, char *argv[]) {
+    int opt;
+
+    try {
+        while ((opt = getopt(argc, argv, "zu:i:esC:K:c:k:b:d:r:h")) != -1) {
+            switch (opt) {
+                case 'z':
+                    options.useZMQ = true;
+                    break;
+                case 'u':
+                    options.useZMQ = false;
+                    options.url = optarg;
+                    break;
+                case 'i':
+                    options.zmqIp = optarg;
+                    break;
+                case 'e':
+                    options.ecdsa = true;
+                    break;
+                case 's':
+                    options.sign = true;
+                    break;
+                case 'C':
+                    options.certFile = optarg;
+                    break;
+                case 'K':
+                    options.certKeyFile = optarg;
+                    break;
+                case 'c':
+                    options.threads = stoull(optarg);
+                    break;
+                case 'k':
+                    options.keys = stoull(optarg);
+                    break;
+                case 'b':
+                    options.batch = stoull(optarg);
+                    break;
+                case 'd':
+                    options.durationSeconds = stoull(optarg);
+                    break;
+                case 'r':
+                    options.rate = stoull(optarg);
+                    break;
+                default:
+                    printUsage();
+                    exit(1);
+            }
+        }
+    } catch (...) {
+        printUsage();
+        exit(1);
+    }
+
+    if (options.threads == 0 || options.keys == 0 || options.batch == 0 || options.rate > 1000000000) {
+        printUsage();
+        exit(1);
+    }
+
+    if (!options.useZMQ && !options.ecdsa && options.batch > 1) {
+        cerr << "BLS batch signing is only available over ZMQ" << endl;
+        exit(1);
+    }
+
+    if (options.ecdsa && options.batch > MAX_ECDSA_SIGN_BATCH_SIZE) {
+        cerr << "ECDSA batch size should not exceed " << MAX_ECDSA_SIGN_BATCH_SIZE << endl;
+        exit(1);
+    }
+
+    shared_ptr<jsonrpc::HttpClient> httpClient;
+    shared_ptr<StubClient> c;
+
+    if (options.useZMQ) {
+        string empty;
+        zmqClient = make_shared<ZMQClient>(options.zmqIp, BASE_PORT + 5, options.sign,
+                                           options.sign ? options.certFile : empty,
+                                           options.sign ? options.certKeyFile : empty);
+    } else {
+        httpClient = make_shared<jsonrpc::HttpClient>(options.url);
+        c = make_shared<StubClient>(*httpClient, jsonrpc::JSONRPC_CLIENT_V2);
+    }
+
+    try {
+        createKeys(c.get());
+    } catch (exception &e) {
+        cerr << "Could not create benchmark keys: " << e.what() << endl;
+        exit(2);
+    }
+
+    cerr << "Running " << (options.rate > 0 ? "open" : "closed") << " loop " << (options.ecdsa ? "ECDSA" : "BLS")
+         << " benchmark over " << (options.useZMQ ? "ZMQ" : options.url) << " for " << options.durationSeconds
+         << " seconds with " << options.threads << " threads, " << options.keys << " keys and batch size "
+         << options.batch << endl;
+
+    vector<vector<uint64_t>> latencies(options.threads);
+    vector<uint64_t> signatures(options.threads, 0);
+    vector<thread> threads;
+
+    auto start = chrono::steady_clock::now();
+
+    for (uint64_t i = 0; i < options.threads; i++) {
+        threads.emplace_back(benchThread, i, start, ref(latencies.at(i)), ref(signatures.at(i)));
+    }
+
+    for (auto &&t : threads) {
+        t.join();
+    }
+
+    auto seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+    vector<uint64_t> all;
+    uint64_t totalSignatures = 0;
+    for (uint64_t i = 0; i < options.threads; i++) {
+        all.insert(all.end(), latencies.at(i).begin(), latencies.at(i).end());
+        totalSignatures += signatures.at(i);
+    }
+    sort(all.begin(), all.end());
+
+    cout << "requests: " << all.size() << ", errors: " << errors << endl;
+    cout << "throughput: " << all.size() / seconds << " requests/s, " << totalSignatures / seconds
+         << " signatures/s" << endl;
+    cout << "latency ms: p50 " << percentile(all, 0.5) / 1000.0 << ", p99 " << percentile(all, 0.99) / 1000.0
+         << ", p999 " << percentile(all, 0.999) / 1000.0 << ", max " << (all.empty() ? 0 : all.back()) / 1000.0
+         << endl;
+
+    return errors > 0 ? 3 : 0;
+}
@@ -0,0 +1,436 @@
+/*
+    Copyright (C) 2021-Present SKALE Labs
+
+    This file is part of sgxwallet.
+
+    sgxwallet is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as published
+    by the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    sgxwallet is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with sgxwallet.  If not, see <https://www.gnu.org/licenses/>.
+
+    @file sgx_dbbench.cpp
+    @author Stan Kladko
+    @date 2021
+*/
+
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <thread>
+#include <unistd.h>
+
+#include "experimental/filesystem"
+
+#include "sgxwallet_common.h"
+#include "LevelDB.h"
+#include "common.h"
+
+// Benchmark of the LevelDB wrapper, without an enclave or a server.
+//
+// A database at -f is filled with -n keys shaped like a production node: BLS key shares,
+// NEK ECDSA keys, DKG_DH_KEY and shareG2 DKG intermediates and OWNER records, with values of
+// the same sizes and encodings. The tool then runs readString hits and misses with each reader
+// count of -c, writeDataUnique with -W writers, and the full scans visitKeys, getAllKeys and
+// getLatestCreatedKey. Hits pick keys from a Zipf distribution with exponent -z, so the read
+// cache sees the skew of a node whose schains sign at different rates.
+
+struct DBBenchOptions {
+    uint64_t keys = 100000;
+    vector<uint64_t> readers = {1, 4, 16, 64};
+    uint64_t durationSeconds = 5;
+    uint64_t writes = 1000;
+    uint64_t writers = 1;
+    uint64_t scans = 3;
+    double zipf = 1.0;
+    string engine = "leveldb";
+    string folder = "./dbbench_data/";
+    bool keep = false;
+};
+
+static DBBenchOptions options;
+
+// key kinds in production proportions, in percent
+enum KeyKind {
+    BLS_KEY, NEK, DKG_DH_KEY, SHARE_G2, OWNER
+};
+
+static const uint64_t KIND_PERCENT[] = {40, 20, 15, 15, 10};
+
+static const char *KIND_NAMES[] = {"BLS_KEY", "NEK", "DKG_DH_KEY", "shareG2", "OWNER"};
+
+static vector<string> keyNames;
+
+static vector<string> missNames;
+
+// latencies of one thread, a uniform sample of at most MAX_SAMPLES of them once there are more
+struct Samples {
+    static constexpr uint64_t MAX_SAMPLES = 65536;
+
+    uint64_t count = 0;
+    vector<uint64_t> latenciesNs;
+
+    void add(uint64_t _ns, mt19937_64 &_rand) {
+        count++;
+        if (latenciesNs.size() < MAX_SAMPLES) {
+            latenciesNs.push_back(_ns);
+        } else if (_rand() % count < MAX_SAMPLES) {
+            latenciesNs[_rand() % MAX_SAMPLES] = _ns;
+        }
+    }
+};
+
+static string randomHex(mt19937_64 &_rand, uint64_t _bytes) {
+    static const char digits[] = "0123456789abcdef";
+    string result;
+    result.reserve(2 * _bytes);
+    for (uint64_t i = 0; i < 2 * _bytes; i++) {
+        result.push_back(digits[_rand() & 0xF]);
+    }
+    return result;
+}
+
+static string randomDecimal(mt19937_64 &_rand, uint64_t _digits) {
+    string result;
+    result.reserve(_digits);
+    for (uint64_t i = 0; i < _digits; i++) {
+        result.push_back('0' + _rand() % 10);
+    }
+    return result;
+}
+
+static KeyKind kindOf(uint64_t _i) {
+    auto slot = _i % 100;
+    for (int kind = 0; kind < OWNER; kind++) {
+        if (slot < KIND_PERCENT[kind]) {
+            return (KeyKind) kind;
+        }
+        slot -= KIND_PERCENT[kind];
+    }
+    return OWNER;
+}
+
+// _i numbers the keys of all kinds, names differ in their numbers, so the sets of hits and
+// misses do not overlap
+static pair<string, string> makeEntry(mt19937_64 &_rand, uint64_t _i) {
+    auto schain = to_string(_i / 16 % 100000);
+    auto node = to_string(_i % 16);
+    auto dkg = to_string(_i / 1600000);
+    auto poly = "POLY:SCHAIN_ID:" + schain + ":NODE_ID:" + node + ":DKG_ID:" + dkg + "_" + to_string(_i);
+
+    switch (kindOf(_i)) {
+        case BLS_KEY:
+            return {"BLS_KEY:SCHAIN_ID:" + schain + ":NODE_ID:" + node + ":DKG_ID:" + dkg + ":" + to_string(_i),
+                    randomHex(_rand, 160)};
+        case NEK:
+            return {"NEK:" + randomHex(_rand, 28) + to_string(_i), randomHex(_rand, 160)};
+        case DKG_DH_KEY:
+            return {"DKG_DH_KEY_" + poly + ":", randomHex(_rand, 160)};
+        case SHARE_G2:
+            // four decimal G2 coordinates, stored as JSON like other non hex values
+            return {"shareG2_" + poly + ":", randomDecimal(_rand, 77) + ":" + randomDecimal(_rand, 77) + ":" +
+                                             randomDecimal(_rand, 77) + ":" + randomDecimal(_rand, 77)};
+        default:
+            return {"BLS_KEY:SCHAIN_ID:" + schain + ":NODE_ID:" + node + ":DKG_ID:" + dkg + ":" + to_string(_i) +
+                    ":OWNER", randomHex(_rand, 32)};
+    }
+}
+
+static void fill(LevelDB &_db) {
+    mt19937_64 rand(1);
+    keyNames.reserve(options.keys);
+
+    vector<pair<string, string>> batch;
+    for (uint64_t i = 0; i < options.keys; i++) {
+        auto entry = makeEntry(rand, 2 * i);
+        keyNames.push_back(entry.first);
+        batch.push_back(move(entry));
+        if (batch.size() == 1000 || i + 1 == options.keys) {
+            _db.writeBatchUnique(batch);
+            batch.clear();
+        }
+    }
+
+    // hits of a Zipf distribution should not favour one key kind
+    shuffle(keyNames.begin(), keyNames.end(), rand);
+
+    // names of the kinds and shapes of the keys, but with odd numbers
+    for (uint64_t i = 0; i < min(options.keys, (uint64_t) 100000); i++) {
+        missNames.push_back(makeEntry(rand, 2 * i + 1).first);
+    }
+}
+
+// cumulative Zipf weights of the ranks 1 .. n, sampled with a binary search
+static vector<double> zipfCdf() {
+    vector<double> cdf(options.keys);
+    double sum = 0;
+    for (uint64_t i = 0; i < options.keys; i++) {
+        sum += 1.0 / pow((double) (i + 1), options.zipf);
+        cdf[i] = sum;
+    }
+    for (auto &&p : cdf) {
+        p /= sum;
+    }
+    return cdf;
+}
+
+static uint64_t percentile(const vector<uint64_t> &_sorted, double _p) {
+    if (_sorted.empty()) {
+        return 0;
+    }
+    return _sorted.at((uint64_t) (_p * (_sorted.size() - 1)));
+}
+
+static void report(const string &_name, const vector<Samples> &_samples, double _seconds) {
+    uint64_t count = 0;
+    vector<uint64_t> all;
+    for (auto &&samples : _samples) {
+        count += samples.count;
+        all.insert(all.end(), samples.latenciesNs.begin(), samples.latenciesNs.end());
+    }
+    sort(all.begin(), all.end());
+    cout << _name << " threads " << _samples.size() << ": " << (uint64_t) (count / _seconds) << " ops/s, us p50 "
+         << percentile(all, 0.5) / 1000.0 << ", p99 " << percentile(all, 0.99) / 1000.0
+         << ", max " << (all.empty() ? 0 : all.back()) / 1000.0 << endl;
+}
+
+static void readRun(LevelDB &_db, const vector<double> &_cdf, bool _hits, uint64_t _threads) {
+    vector<Samples> samples(_threads);
+    vector<thread> threads;
+    atomic<uint64_t> wrong(0);
+
+    auto start = chrono::steady_clock::now();
+    auto end = start + chrono::seconds(options.durationSeconds);
+
+    for (uint64_t t = 0; t < _threads; t++) {
+        threads.emplace_back([&, t]() {
+            mt19937_64 rand(100 + t);
+            uniform_real_distribution<double> uniform(0, 1);
+            while (chrono::steady_clock::now() < end) {
+                const string *name;
+                if (_hits) {
+                    auto rank = lower_bound(_cdf.begin(), _cdf.end(), uniform(rand)) - _cdf.begin();
+                    name = &keyNames[min((uint64_t) rank, options.keys - 1)];
+                } else {
+                    name = &missNames[rand() % missNames.size()];
+                }
+                auto opStart = chrono::steady_clock::now();
+                auto value = _db.readString(*name);
+                samples[t].add(chrono::duration_cast<chrono::nanoseconds>(
+                        chrono::steady_clock::now() - opStart).count(), rand);
+                if ((value != nullptr) != _hits) {
+                    wrong++;
+                }
+            }
+        });
+    }
+
+    for (auto &&t : threads) {
+        t.join();
+    }
+
+    auto seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+    CHECK_STATE(wrong == 0);
+
+    report(_hits ? "readString hit" : "readString miss", samples, seconds);
+}
+
+static void writeRun(LevelDB &_db) {
+    vector<Samples> samples(options.writers);
+    vector<thread> threads;
+    atomic<uint64_t> next(0);
+
+    auto start = chrono::steady_clock::now();
+
+    for (uint64_t t = 0; t < options.writers; t++) {
+        threads.emplace_back([&, t]() {
+            mt19937_64 rand(200 + t);
+            while (true) {
+                auto i = next++;
+                if (i >= options.writes) {
+                    break;
+                }
+                // numbered after the misses, so the names are new
+                auto entry = makeEntry(rand, 2 * (options.keys + i) + 1);
+                auto opStart = chrono::steady_clock::now();
+                _db.writeDataUnique(entry.first, entry.second);
+                samples[t].add(chrono::duration_cast<chrono::nanoseconds>(
+                        chrono::steady_clock::now() - opStart).count(), rand);
+            }
+        });
+    }
+
+    for (auto &&t : threads) {
+        t.join();
+    }
+
+    auto seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+    report("writeDataUnique", samples, seconds);
+}
+
+class CountingVisitor : public LevelDB::KeyVisitor {
+public:
+    uint64_t count = 0;
+
+    void visitDBKey(const char *) override {
+        count++;
+    }
+};
+
+template<typename F>
+static void scanRun(const string &_name, F &&_scan) {
+    vector<uint64_t> latencies;
+    for (uint64_t i = 0; i < options.scans; i++) {
+        auto opStart = chrono::steady_clock::now();
+        _scan();
+        latencies.push_back(chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - opStart).count());
+    }
+    sort(latencies.begin(), latencies.end());
+    cout << _name << ": ms p50 " << percentile(latencies, 0.5) / 1e6 << ", max " << latencies.back() / 1e6 << endl;
+}
+
+static vector<uint64_t> parseList(const string &_list) {
+    vector<uint64_t> result;
+    stringstream stream(_list);
+    string item;
+    while (getline(stream, item, ',')) {
+        result.push_back(stoull(item));
+    }
+    return result;
+}
+
+static void printUsage() {
+    cerr << "sgx_dbbench: benchmark of the sgxwallet key database\n\n";
+    cerr << "   -n  number Keys in the database. Default is " << options.keys << " \n";
+    cerr << "   -c  list Comma separated reader thread counts. Default is 1,4,16,64 \n";
+    cerr << "   -d  seconds Duration of each read run. Default is " << options.durationSeconds << " \n";
+    cerr << "   -w  number writeDataUnique calls. Default is " << options.writes << " \n";
+    cerr << "   -W  number Concurrent writers. Default is " << options.writers << " \n";
+    cerr << "   -s  number Runs of each full scan. Default is " << options.scans << " \n";
+    cerr << "   -z  exponent Zipf exponent of the read hits, 0 reads all keys equally often. Default is "
+         << options.zipf << " \n";
+    cerr << "   -D  engine Storage engine, leveldb or mapped. Default is " << options.engine << " \n";
+    cerr << "   -f  folder Database folder, deleted before and after the run. Default is " << options.folder << " \n";
+    cerr << "   -k  Keep the database after the run \n";
+}
+
+int main(int argc, char *argv[]) {
+    int opt;
+
+    try {
+        while ((opt = getopt(argc, argv, "n:c:d:w:W:s:z:D:f:kh")) != -1) {
+            switch (opt) {
+                case 'n':
+                    options.keys = stoull(optarg);
+                    break;
+                case 'c':
+                    options.readers = parseList(optarg);
+                    break;
+                case 'd':
+                    options.durationSeconds = stoull(optarg);
+                    break;
+                case 'w':
+                    options.writes = stoull(optarg);
+                    break;
+                case 'W':
+                    options.writers = stoull(optarg);
+                    break;
+                case 's':
+                    options.scans = stoull(optarg);
+                    break;
+                case 'z':
+                    options.zipf = stod(optarg);
+                    break;
+                case 'D':
+                    options.engine = optarg;
+                    break;
+                case 'f':
+                    options.folder = string(optarg) + "/";
+                    break;
+                case 'k':
+                    options.keep = true;
+                    break;
+                default:
+                    printUsage();
+                    exit(1);
+            }
+        }
+    } catch (...) {
+        printUsage();
+        exit(1);
+    }
+
+    if (options.keys == 0 || options.readers.empty() || options.writers == 0 || options.scans == 0 ||
+        options.zipf < 0 || find(options.readers.begin(), options.readers.end(), 0) != options.readers.end()) {
+        printUsage();
+        exit(1);
+    }
+
+    try {
+        LevelDB::setStorageEngine(options.engine);
+
+        experimental::filesystem::remove_all(options.folder);
+        experimental::filesystem::create_directories(options.folder);
+
+        {
+            auto dbName = options.folder + WALLETDB_NAME;
+            // with a separate DKG store, as in sgx_data
+            LevelDB db(dbName, true);
+
+            auto fillStart = chrono::steady_clock::now();
+            fill(db);
+            cerr << "Filled " << options.keys << " keys in "
+                 << chrono::duration<double>(chrono::steady_clock::now() - fillStart).count() << " s";
+            for (int kind = 0; kind <= OWNER; kind++) {
+                cerr << (kind == 0 ? ": " : ", ") << KIND_PERCENT[kind] << "% " << KIND_NAMES[kind];
+            }
+            cerr << endl;
+
+            auto cdf = zipfCdf();
+
+            for (auto &&readers : options.readers) {
+                readRun(db, cdf, true, readers);
+            }
+            for (auto &&readers : options.readers) {
+                readRun(db, cdf, false, readers);
+            }
+
+            writeRun(db);
+
+            scanRun("visitKeys", [&db]() {
+                CountingVisitor visitor;
+                db.visitKeys(&visitor, UINT64_MAX);
+                CHECK_STATE(visitor.count >= options.keys);
+            });
+            scanRun("getAllKeys", [&db]() {
+                CHECK_STATE(db.getAllKeys().second >= options.keys);
+            });
+            scanRun("getLatestCreatedKey", [&db]() {
+                db.getLatestCreatedKey();
+            });
+        }
+
+        if (!options.keep) {
+            experimental::filesystem::remove_all(options.folder);
+        }
+    } catch (exception &e) {
+        cerr << "Benchmark failed: " << e.what() << endl;
+        exit(2);
+    }
+
+    return 0;
+}
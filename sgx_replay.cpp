@@ -0,0 +1,397 @@
+/*
+    Copyright (C) 2021-Present SKALE Labs
+
+    This file is part of sgxwallet.
+
+    sgxwallet is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as published
+    by the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    sgxwallet is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with sgxwallet.  If not, see <https://www.gnu.org/licenses/>.
+
+    @file sgx_replay.cpp
+    @author Stan Kladko
+    @date 2021
+*/
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <random>
+#include <thread>
+#include <unistd.h>
+
+#include <jsonrpccpp/client/connectors/httpclient.h>
+
+#include "sgxwallet_common.h"
+#include "stubclient.h"
+#include "zmq_src/ZMQClient.h"
+#include "common.h"
+#include "Metrics.h"
+#include "TrafficRecorder.h"
+
+// Replays a traffic log of sgxwallet -o against a test instance. Requests are sent open loop at
+// their recorded arrival times divided by the speed factor, over the transport they arrived on,
+// and latency is measured from the scheduled send time. The log has no parameters, so every key
+// hash of the log is mapped to a new key on the test instance and every request signs a fresh
+// random hash. Methods that cannot be replayed without their parameters, such as the DKG steps,
+// are counted and skipped.
+
+enum ReplayOp {
+    OP_SKIP, OP_BLS_SIGN, OP_BLS_SIGN_BATCH, OP_ECDSA_SIGN, OP_ECDSA_SIGN_BATCH, OP_BLS_PUBLIC, OP_ECDSA_PUBLIC,
+    OP_STATUS, OP_VERSION
+};
+
+// ZMQ type and JSON-RPC method names of each replayed request
+static const map<string, ReplayOp> REPLAY_OPS = {
+        {"BLSSignReq", OP_BLS_SIGN}, {"blsSignMessageHash", OP_BLS_SIGN},
+        {"BLSSignBatchReq", OP_BLS_SIGN_BATCH},
+        {"ECDSASignReq", OP_ECDSA_SIGN}, {"ecdsaSignMessageHash", OP_ECDSA_SIGN},
+        {"ECDSASignBatchReq", OP_ECDSA_SIGN_BATCH}, {"ecdsaSignMessageHashBatch", OP_ECDSA_SIGN_BATCH},
+        {"getBLSPublicReq", OP_BLS_PUBLIC}, {"getBLSPublicKeyShare", OP_BLS_PUBLIC},
+        {"getPublicECDSAReq", OP_ECDSA_PUBLIC}, {"getPublicECDSAKey", OP_ECDSA_PUBLIC},
+        {"getServerStatusReq", OP_STATUS}, {"getServerStatus", OP_STATUS},
+        {"getServerVersionReq", OP_VERSION}, {"getServerVersion", OP_VERSION}};
+
+struct ReplayOptions {
+    string logFile;
+    double speed = 1;
+    string url = "http://localhost:" + to_string(BASE_PORT + 3);
+    string zmqIp = "127.0.0.1";
+    string certFile = "./sgx_data/cert_data/rootCA.pem";
+    string certKeyFile = "./sgx_data/cert_data/rootCA.key";
+    uint64_t threads = 16;
+};
+
+static ReplayOptions options;
+
+static vector<string> methods;
+
+static vector<TrafficRecord> records;
+
+static vector<ReplayOp> methodOps;
+
+// key name on the test instance for each key hash of the log
+static map<uint64_t, string> keyNames;
+
+static shared_ptr<ZMQClient> zmqClient;
+
+// per method of the log
+struct MethodStats {
+    MetricsHistogram replayed;
+    MetricsHistogram recorded;
+    MetricsCounter errors;
+    MetricsCounter skipped;
+};
+
+static vector<unique_ptr<MethodStats>> stats;
+
+static mutex queueMutex;
+
+static condition_variable queueCond;
+
+static deque<pair<uint64_t, chrono::steady_clock::time_point>> queue;
+
+static bool dispatchDone = false;
+
+static atomic<uint64_t> errors(0);
+
+static string randomHex(mt19937_64 &_rand, uint64_t _bytes) {
+    static const char digits[] = "0123456789abcdef";
+    string result;
+    result.reserve(2 * _bytes);
+    for (uint64_t i = 0; i < 2 * _bytes; i++) {
+        result.push_back(digits[_rand() & 0xF]);
+    }
+    return result;
+}
+
+static void printUsage() {
+    cerr << "sgx_replay: replays a traffic log recorded with sgxwallet -o\n\n";
+    cerr << "   -f  file Traffic log \n";
+    cerr << "   -x  factor Replay speed, 2 sends the requests twice as fast as recorded. Default is "
+         << options.speed << " \n";
+    cerr << "   -u  url JSON-RPC API for requests recorded over HTTP. Default is " << options.url << " \n";
+    cerr << "   -i  ip ZMQ server ip. Default is " << options.zmqIp << " \n";
+    cerr << "   -C  file Client certificate. Default is " << options.certFile << " \n";
+    cerr << "   -K  file Client certificate key. Default is " << options.certKeyFile << " \n";
+    cerr << "   -c  number Client threads. Default is " << options.threads << " \n";
+}
+
+static bool isBlsOp(ReplayOp _op) {
+    return _op == OP_BLS_SIGN || _op == OP_BLS_SIGN_BATCH || _op == OP_BLS_PUBLIC;
+}
+
+static bool isEcdsaOp(ReplayOp _op) {
+    return _op == OP_ECDSA_SIGN || _op == OP_ECDSA_SIGN_BATCH || _op == OP_ECDSA_PUBLIC;
+}
+
+// one test key per key hash, of the type of the first request that used it
+static void createKeys() {
+    mt19937_64 rand(random_device{}());
+
+    for (auto &&record : records) {
+        auto op = methodOps.at(record.method);
+        if (record.keyHash == 0 || keyNames.count(record.keyHash) > 0 || !(isBlsOp(op) || isEcdsaOp(op))) {
+            continue;
+        }
+
+        if (isBlsOp(op)) {
+            auto name = "BLS_KEY:SCHAIN_ID:" + to_string(rand() % 1000000000) + ":NODE_ID:0:DKG_ID:" +
+                        to_string(keyNames.size());
+            CHECK_STATE(zmqClient->importBLSKeyShare("0x" + randomHex(rand, 31), name));
+            keyNames[record.keyHash] = name;
+        } else {
+            keyNames[record.keyHash] = zmqClient->generateECDSAKey().second;
+        }
+    }
+}
+
+static void replayOne(const TrafficRecord &_record, StubClient &_c, mt19937_64 &_rand) {
+    auto op = methodOps.at(_record.method);
+    auto it = keyNames.find(_record.keyHash);
+    // requests recorded without a key name are sent without one, and fail as they did when recorded
+    auto keyName = it != keyNames.end() ? it->second : string();
+    bool zmq = _record.transport == TRAFFIC_ZMQ;
+    uint64_t batch = max<uint64_t>(_record.batchSize, 1);
+
+    switch (op) {
+        case OP_BLS_SIGN:
+            if (zmq) {
+                zmqClient->blsSignMessageHash(keyName, randomHex(_rand, 32), 1, 1);
+            } else {
+                CHECK_STATE(_c.blsSignMessageHash(keyName, randomHex(_rand, 32), 1, 1)["status"] == 0);
+            }
+            break;
+        case OP_BLS_SIGN_BATCH: {
+            vector<tuple<string, string, int, int>> requests;
+            for (uint64_t i = 0; i < batch; i++) {
+                requests.emplace_back(keyName, randomHex(_rand, 32), 1, 1);
+            }
+            CHECK_STATE(zmqClient->blsSignMessageHashBatch(requests).size() == batch);
+            break;
+        }
+        case OP_ECDSA_SIGN:
+            if (zmq) {
+                zmqClient->ecdsaSignMessageHash(16, keyName, randomHex(_rand, 32));
+            } else {
+                CHECK_STATE(_c.ecdsaSignMessageHash(16, keyName, randomHex(_rand, 32))["status"] == 0);
+            }
+            break;
+        case OP_ECDSA_SIGN_BATCH: {
+            vector<string> hashes;
+            Json::Value hashArray(Json::arrayValue);
+            for (uint64_t i = 0; i < batch; i++) {
+                hashes.push_back(randomHex(_rand, 32));
+                hashArray.append(hashes.back());
+            }
+            if (zmq) {
+                CHECK_STATE(zmqClient->ecdsaSignMessageHashBatch(16, keyName, hashes).size() == batch);
+            } else {
+                CHECK_STATE(_c.ecdsaSignMessageHashBatch(16, keyName, hashArray)["status"] == 0);
+            }
+            break;
+        }
+        case OP_BLS_PUBLIC:
+            if (zmq) {
+                zmqClient->getBLSPublicKey(keyName);
+            } else {
+                CHECK_STATE(_c.getBLSPublicKeyShare(keyName)["status"] == 0);
+            }
+            break;
+        case OP_ECDSA_PUBLIC:
+            if (zmq) {
+                zmqClient->getECDSAPublicKey(keyName);
+            } else {
+                CHECK_STATE(_c.getPublicECDSAKey(keyName)["status"] == 0);
+            }
+            break;
+        case OP_STATUS:
+            if (zmq) {
+                zmqClient->getServerStatus();
+            } else {
+                CHECK_STATE(_c.getServerStatus()["status"] == 0);
+            }
+            break;
+        case OP_VERSION:
+            if (zmq) {
+                zmqClient->getServerVersion();
+            } else {
+                CHECK_STATE(_c.getServerVersion()["status"] == 0);
+            }
+            break;
+        case OP_SKIP:
+            break;
+    }
+}
+
+static void replayThread(uint64_t _index) {
+    mt19937_64 rand(random_device{}() + _index);
+    jsonrpc::HttpClient httpClient(options.url);
+    StubClient c(httpClient, jsonrpc::JSONRPC_CLIENT_V2);
+
+    while (true) {
+        pair<uint64_t, chrono::steady_clock::time_point> item;
+        {
+            unique_lock<mutex> lock(queueMutex);
+            queueCond.wait(lock, []() { return !queue.empty() || dispatchDone; });
+            if (queue.empty()) {
+                return;
+            }
+            item = queue.front();
+            queue.pop_front();
+        }
+
+        auto &record = records.at(item.first);
+        auto &methodStats = *stats.at(record.method);
+
+        try {
+            replayOne(record, c, rand);
+            methodStats.replayed.observeUs(
+                    chrono::duration_cast<chrono::microseconds>(chrono::steady_clock::now() - item.second).count());
+        } catch (exception &e) {
+            methodStats.errors.inc();
+            if (errors++ < 10) {
+                cerr << methods.at(record.method) << " failed: " << e.what() << endl;
+            }
+        }
+    }
+}
+
+int main(int argc, char *argv[]) {
+    int opt;
+
+    try {
+        while ((opt = getopt(argc, argv, "f:x:u:i:C:K:c:h")) != -1) {
+            switch (opt) {
+                case 'f':
+                    options.logFile = optarg;
+                    break;
+                case 'x':
+                    options.speed = stod(optarg);
+                    break;
+                case 'u':
+                    options.url = optarg;
+                    break;
+                case 'i':
+                    options.zmqIp = optarg;
+                    break;
+                case 'C':
+                    options.certFile = optarg;
+                    break;
+                case 'K':
+                    options.certKeyFile = optarg;
+                    break;
+                case 'c':
+                    options.threads = stoull(optarg);
+                    break;
+                default:
+                    printUsage();
+                    exit(1);
+            }
+        }
+    } catch (...) {
+        printUsage();
+        exit(1);
+    }
+
+    if (options.logFile.empty() || options.speed <= 0 || options.threads == 0) {
+        printUsage();
+        exit(1);
+    }
+
+    try {
+        TrafficRecorder::readLog(options.logFile, methods, records);
+    } catch (exception &e) {
+        cerr << "Could not read traffic log " << options.logFile << ": " << e.what() << endl;
+        exit(2);
+    }
+
+    for (auto &&method : methods) {
+        auto it = REPLAY_OPS.find(method);
+        methodOps.push_back(it != REPLAY_OPS.end() ? it->second : OP_SKIP);
+        stats.push_back(make_unique<MethodStats>());
+    }
+
+    // requests are recorded when they complete, so the log is not in arrival order
+    stable_sort(records.begin(), records.end(), [](const TrafficRecord &_a, const TrafficRecord &_b) {
+        return _a.arrivalUs < _b.arrivalUs;
+    });
+
+    try {
+        zmqClient = make_shared<ZMQClient>(options.zmqIp, BASE_PORT + 5, true, options.certFile,
+                                           options.certKeyFile);
+        createKeys();
+    } catch (exception &e) {
+        cerr << "Could not create replay keys: " << e.what() << endl;
+        exit(2);
+    }
+
+    auto recordedSeconds = records.empty() ? 0 : records.back().arrivalUs / 1e6;
+    cerr << "Replaying " << records.size() << " requests recorded over " << recordedSeconds << " seconds at "
+         << options.speed << "x with " << keyNames.size() << " keys" << endl;
+
+    vector<thread> threads;
+    for (uint64_t i = 0; i < options.threads; i++) {
+        threads.emplace_back(replayThread, i);
+    }
+
+    auto start = chrono::steady_clock::now();
+
+    for (uint64_t i = 0; i < records.size(); i++) {
+        auto &record = records[i];
+        auto &methodStats = *stats.at(record.method);
+        methodStats.recorded.observeUs(record.serviceUs);
+
+        if (methodOps.at(record.method) == OP_SKIP) {
+            methodStats.skipped.inc();
+            continue;
+        }
+
+        auto scheduled = start + chrono::microseconds((uint64_t) (record.arrivalUs / options.speed));
+        this_thread::sleep_until(scheduled);
+
+        lock_guard<mutex> lock(queueMutex);
+        queue.emplace_back(i, scheduled);
+        queueCond.notify_one();
+    }
+
+    {
+        lock_guard<mutex> lock(queueMutex);
+        dispatchDone = true;
+    }
+    queueCond.notify_all();
+
+    for (auto &&t : threads) {
+        t.join();
+    }
+
+    auto seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+    cout << "method,requests,errors,skipped,replayP50Ms,replayP99Ms,recordedP50Ms,recordedP99Ms" << endl;
+    for (uint64_t i = 0; i < methods.size(); i++) {
+        auto &methodStats = *stats[i];
+        auto replayed = methodStats.replayed.snapshot();
+        auto recorded = methodStats.recorded.snapshot();
+        cout << methods[i] << "," << recorded.count << "," << methodStats.errors.get() << ","
+             << methodStats.skipped.get() << "," << replayed.quantileUs(0.5) / 1000.0 << ","
+             << replayed.quantileUs(0.99) / 1000.0 << "," << recorded.quantileUs(0.5) / 1000.0 << ","
+             << recorded.quantileUs(0.99) / 1000.0 << endl;
+    }
+
+    cerr << "Replayed in " << seconds << " seconds, " << errors << " errors" << endl;
+
+    return errors > 0 ? 3 : 0;
+}
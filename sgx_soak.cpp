@@ -0,0 +1,388 @@
+/*
+    Copyright (C) 2021-Present SKALE Labs
+
+    This file is part of sgxwallet.
+
+    sgxwallet is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as published
+    by the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    sgxwallet is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with sgxwallet.  If not, see <https://www.gnu.org/licenses/>.
+
+    @file sgx_soak.cpp
+    @author Stan Kladko
+    @date 2021
+*/
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <thread>
+#include <unistd.h>
+
+#include <jsonrpccpp/client/connectors/httpclient.h>
+
+#include "sgxwallet_common.h"
+#include "stubclient.h"
+#include "zmq_src/ZMQClient.h"
+#include "common.h"
+#include "DKGCrypto.h"
+#include "Metrics.h"
+#include "TestUtils.h"
+
+// Soak test for a running sgxwallet. Client threads send a mix of BLS and ECDSA signing and
+// threshold decryption requests over ZMQ for hours, and a DKG thread runs a full DKG over
+// JSON-RPC every few minutes and deletes the resulting BLS keys again.
+//
+// Every -s seconds the server side sizes of getServerStatusExtended and the client side p99
+// latencies of the interval are sampled and printed as CSV. The median of the first
+// SOAK_WINDOW samples after warm-up is the baseline. The run fails as soon as the median of
+// the last SOAK_WINDOW samples of a series exceeds its baseline by more than the allowed
+// growth plus a fixed slack, which keeps small baselines from failing on noise.
+
+static constexpr uint64_t SOAK_WINDOW = 5;
+
+struct SoakOptions {
+    string url = "http://localhost:" + to_string(BASE_PORT + 3);
+    string zmqIp = "127.0.0.1";
+    string certFile = "./sgx_data/cert_data/rootCA.pem";
+    string certKeyFile = "./sgx_data/cert_data/rootCA.key";
+    uint64_t threads = 4;
+    uint64_t durationSeconds = 4 * 3600;
+    uint64_t warmUpSeconds = 600;
+    uint64_t sampleSeconds = 60;
+    uint64_t dkgIntervalSeconds = 300;
+    uint64_t maxMemoryGrowthPercent = 20;
+    uint64_t maxDbGrowthPercent = 50;
+    uint64_t maxLatencyGrowthPercent = 100;
+};
+
+static SoakOptions options;
+
+static shared_ptr<ZMQClient> zmqClient;
+
+static vector<string> blsKeyNames;
+
+static vector<string> ecdsaKeyNames;
+
+static vector<Json::Value> decryptionValues;
+
+static MetricsHistogram blsLatency;
+
+static MetricsHistogram ecdsaLatency;
+
+static MetricsHistogram teLatency;
+
+static MetricsHistogram dkgLatency;
+
+static atomic<uint64_t> requests(0);
+
+static atomic<uint64_t> errors(0);
+
+static atomic<bool> exitRequested(false);
+
+// one sampled quantity, drift is checked against the median of its first window
+struct Series {
+    const char *name;
+    uint64_t maxGrowthPercent;
+    double slack;
+    vector<double> values;
+
+    static double median(vector<double> _window) {
+        sort(_window.begin(), _window.end());
+        return _window.at(_window.size() / 2);
+    }
+
+    // the samples before _warmUp are not part of the baseline
+    bool drifted(uint64_t _warmUp, double &_baseline, double &_current) const {
+        if (values.size() < _warmUp + 2 * SOAK_WINDOW) {
+            return false;
+        }
+        _baseline = median(vector<double>(values.begin() + _warmUp, values.begin() + _warmUp + SOAK_WINDOW));
+        _current = median(vector<double>(values.end() - SOAK_WINDOW, values.end()));
+        return _current > _baseline * (1 + maxGrowthPercent / 100.0) + slack;
+    }
+};
+
+static string randomHex(mt19937_64 &_rand, uint64_t _bytes) {
+    static const char digits[] = "0123456789abcdef";
+    string result;
+    result.reserve(2 * _bytes);
+    for (uint64_t i = 0; i < 2 * _bytes; i++) {
+        result.push_back(digits[_rand() & 0xF]);
+    }
+    return result;
+}
+
+static void printUsage() {
+    cerr << "sgx_soak: long running mixed load test for sgxwallet, fails on memory or latency drift\n\n";
+    cerr << "   -u  url JSON-RPC API for DKG and status polls. Default is " << options.url << " \n";
+    cerr << "   -i  ip ZMQ server ip. Default is " << options.zmqIp << " \n";
+    cerr << "   -C  file Client certificate. Default is " << options.certFile << " \n";
+    cerr << "   -K  file Client certificate key. Default is " << options.certKeyFile << " \n";
+    cerr << "   -c  number Client threads. Default is " << options.threads << " \n";
+    cerr << "   -d  seconds Duration of the run. Default is " << options.durationSeconds << " \n";
+    cerr << "   -w  seconds Warm-up, not part of the baselines. Default is " << options.warmUpSeconds << " \n";
+    cerr << "   -s  seconds Sample interval. Default is " << options.sampleSeconds << " \n";
+    cerr << "   -g  seconds Interval between DKG runs, 0 disables DKG. Default is " << options.dkgIntervalSeconds
+         << " \n";
+    cerr << "   -m  percent Allowed growth of process RSS, enclave heap and cache sizes. Default is "
+         << options.maxMemoryGrowthPercent << " \n";
+    cerr << "   -D  percent Allowed growth of the database. Default is " << options.maxDbGrowthPercent << " \n";
+    cerr << "   -l  percent Allowed growth of p99 latencies. Default is " << options.maxLatencyGrowthPercent << " \n";
+}
+
+static void createKeys() {
+    mt19937_64 rand(random_device{}());
+
+    for (int i = 0; i < 4; i++) {
+        auto name = "BLS_KEY:SCHAIN_ID:" + to_string(rand() % 1000000000) + ":NODE_ID:0:DKG_ID:" + to_string(i);
+        CHECK_STATE(zmqClient->importBLSKeyShare("0x" + randomHex(rand, 31), name));
+        blsKeyNames.push_back(name);
+        ecdsaKeyNames.push_back(zmqClient->generateECDSAKey().second);
+    }
+
+    libff::init_alt_bn128_params();
+    for (int i = 0; i < 16; i++) {
+        auto value = libff::alt_bn128_G2::random_element();
+        value.to_affine_coordinates();
+        Json::Value values;
+        values["publicDecryptionValues"][0] = convertG2ToString(value);
+        decryptionValues.push_back(values);
+    }
+}
+
+template<class F>
+static void timed(MetricsHistogram &_histogram, F &&_request) {
+    auto start = chrono::steady_clock::now();
+    try {
+        _request();
+        _histogram.observeUs(
+                chrono::duration_cast<chrono::microseconds>(chrono::steady_clock::now() - start).count());
+        requests++;
+    } catch (exception &e) {
+        if (errors++ < 10) {
+            cerr << "Request failed: " << e.what() << endl;
+        }
+    }
+}
+
+// mostly BLS signatures like a validator node, with some ECDSA signatures and decryption shares
+static void clientThread(uint64_t _index) {
+    mt19937_64 rand(random_device{}() + _index);
+
+    while (!exitRequested) {
+        auto op = rand() % 100;
+        if (op < 80) {
+            auto &keyName = blsKeyNames.at(rand() % blsKeyNames.size());
+            auto hash = randomHex(rand, 32);
+            timed(blsLatency, [&]() { zmqClient->blsSignMessageHash(keyName, hash, 1, 1); });
+        } else if (op < 98) {
+            auto &keyName = ecdsaKeyNames.at(rand() % ecdsaKeyNames.size());
+            auto hash = randomHex(rand, 32);
+            timed(ecdsaLatency, [&]() { zmqClient->ecdsaSignMessageHash(16, keyName, hash); });
+        } else {
+            auto &keyName = blsKeyNames.at(rand() % blsKeyNames.size());
+            auto &values = decryptionValues.at(rand() % decryptionValues.size());
+            timed(teLatency, [&]() { CHECK_STATE(zmqClient->getDecryptionShares(keyName, values).size() == 1); });
+        }
+    }
+}
+
+static void dkgThread() {
+    jsonrpc::HttpClient httpClient(options.url);
+    StubClient c(httpClient, jsonrpc::JSONRPC_CLIENT_V2);
+
+    mt19937_64 rand(random_device{}());
+    auto next = chrono::steady_clock::now();
+
+    while (!exitRequested) {
+        if (chrono::steady_clock::now() < next) {
+            this_thread::sleep_for(chrono::milliseconds(100));
+            continue;
+        }
+        next += chrono::seconds(options.dkgIntervalSeconds);
+
+        vector<string> ecdsaNames;
+        vector<string> blsNames;
+        timed(dkgLatency, [&]() {
+            TestUtils::doDKGV2(c, 2, 2, ecdsaNames, blsNames, rand() % 1000000000, rand() % 1000000000);
+        });
+        for (auto &&name : blsNames) {
+            c.deleteBlsKey(name);
+        }
+    }
+}
+
+int main(int argc, char *argv[]) {
+    int opt;
+
+    try {
+        while ((opt = getopt(argc, argv, "u:i:C:K:c:d:w:s:g:m:D:l:h")) != -1) {
+            switch (opt) {
+                case 'u':
+                    options.url = optarg;
+                    break;
+                case 'i':
+                    options.zmqIp = optarg;
+                    break;
+                case 'C':
+                    options.certFile = optarg;
+                    break;
+                case 'K':
+                    options.certKeyFile = optarg;
+                    break;
+                case 'c':
+                    options.threads = stoull(optarg);
+                    break;
+                case 'd':
+                    options.durationSeconds = stoull(optarg);
+                    break;
+                case 'w':
+                    options.warmUpSeconds = stoull(optarg);
+                    break;
+                case 's':
+                    options.sampleSeconds = stoull(optarg);
+                    break;
+                case 'g':
+                    options.dkgIntervalSeconds = stoull(optarg);
+                    break;
+                case 'm':
+                    options.maxMemoryGrowthPercent = stoull(optarg);
+                    break;
+                case 'D':
+                    options.maxDbGrowthPercent = stoull(optarg);
+                    break;
+                case 'l':
+                    options.maxLatencyGrowthPercent = stoull(optarg);
+                    break;
+                default:
+                    printUsage();
+                    exit(1);
+            }
+        }
+    } catch (...) {
+        printUsage();
+        exit(1);
+    }
+
+    if (options.threads == 0 || options.sampleSeconds == 0 ||
+        options.durationSeconds < options.warmUpSeconds + 2 * SOAK_WINDOW * options.sampleSeconds) {
+        cerr << "The run should be longer than the warm-up plus " << 2 * SOAK_WINDOW << " samples" << endl;
+        printUsage();
+        exit(1);
+    }
+
+    jsonrpc::HttpClient httpClient(options.url);
+    StubClient c(httpClient, jsonrpc::JSONRPC_CLIENT_V2);
+
+    try {
+        zmqClient = make_shared<ZMQClient>(options.zmqIp, BASE_PORT + 5, true, options.certFile,
+                                           options.certKeyFile);
+        createKeys();
+    } catch (exception &e) {
+        cerr << "Could not create soak test keys: " << e.what() << endl;
+        exit(2);
+    }
+
+    // slack is in the unit of the series, bytes, entries or microseconds
+    vector<Series> series = {
+            {"processRSSBytes", options.maxMemoryGrowthPercent, 64e6},
+            {"enclaveGmpHeapBytes", options.maxMemoryGrowthPercent, 1e6},
+            {"dbApproximateBytes", options.maxDbGrowthPercent, 16e6},
+            {"signCacheEntries", options.maxMemoryGrowthPercent, 1000},
+            {"zmqSessions", options.maxMemoryGrowthPercent, 100},
+            {"zmqVerifiedCerts", options.maxMemoryGrowthPercent, 100},
+            {"blsP99Us", options.maxLatencyGrowthPercent, 2000},
+            {"ecdsaP99Us", options.maxLatencyGrowthPercent, 2000},
+            {"teP99Us", options.maxLatencyGrowthPercent, 5000}};
+
+    cerr << "Soaking " << options.zmqIp << " for " << options.durationSeconds << " seconds with "
+         << options.threads << " threads" << endl;
+
+    cout << "elapsedSeconds,requests,errors";
+    for (auto &&s : series) {
+        cout << "," << s.name;
+    }
+    cout << endl;
+
+    vector<thread> threads;
+    for (uint64_t i = 0; i < options.threads; i++) {
+        threads.emplace_back(clientThread, i);
+    }
+    if (options.dkgIntervalSeconds > 0) {
+        threads.emplace_back(dkgThread);
+    }
+
+    auto start = chrono::steady_clock::now();
+    auto warmUpSamples = options.warmUpSeconds / options.sampleSeconds;
+    HistogramSnapshot lastBls, lastEcdsa, lastTe;
+    int result = 0;
+
+    for (uint64_t sample = 1; sample * options.sampleSeconds <= options.durationSeconds; sample++) {
+        this_thread::sleep_until(start + chrono::seconds(sample * options.sampleSeconds));
+
+        Json::Value status;
+        try {
+            status = c.getServerStatusExtended();
+            CHECK_STATE(status["status"] == 0);
+        } catch (exception &e) {
+            cerr << "Could not get the server status: " << e.what() << endl;
+            result = 2;
+            break;
+        }
+
+        auto bls = blsLatency.snapshot(), ecdsa = ecdsaLatency.snapshot(), te = teLatency.snapshot();
+        vector<double> values = {
+                status["processRSSBytes"].asDouble(), status["enclaveGmpHeapBytes"].asDouble(),
+                status["dbApproximateBytes"].asDouble(), status["signCacheEntries"].asDouble(),
+                status["zmqSessions"].asDouble(), status["zmqVerifiedCerts"].asDouble(),
+                (double) (bls - lastBls).quantileUs(0.99), (double) (ecdsa - lastEcdsa).quantileUs(0.99),
+                (double) (te - lastTe).quantileUs(0.99)};
+        lastBls = bls;
+        lastEcdsa = ecdsa;
+        lastTe = te;
+
+        cout << sample * options.sampleSeconds << "," << requests << "," << errors;
+        for (uint64_t i = 0; i < series.size(); i++) {
+            series[i].values.push_back(values[i]);
+            cout << "," << (uint64_t) values[i];
+        }
+        cout << endl;
+
+        for (auto &&s : series) {
+            double baseline, current;
+            if (s.drifted(warmUpSamples, baseline, current)) {
+                cerr << s.name << " drifted from " << baseline << " to " << current << endl;
+                result = 4;
+            }
+        }
+        if (result != 0) {
+            break;
+        }
+    }
+
+    exitRequested = true;
+    for (auto &&t : threads) {
+        t.join();
+    }
+
+    if (result == 0 && errors > requests / 1000) {
+        cerr << errors << " of " << requests + errors << " requests failed" << endl;
+        result = 3;
+    }
+
+    cerr << (result == 0 ? "Soak test passed" : "Soak test failed") << ", " << requests << " requests, "
+         << errors << " errors, DKG p99 " << dkgLatency.snapshot().quantileUs(0.99) / 1000 << " ms" << endl;
+
+    return result;
+}
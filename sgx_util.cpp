@@ -21,11 +21,16 @@
     @date 2019
 */
 
+#include <atomic>
+#include <fstream>
 #include <iostream>
 #include <cstring>
+#include <thread>
 #include <jsonrpccpp/client/connectors/httpclient.h>
 #include "stubclient.h"
 #include "common.h"
+#include "sgxwallet_common.h"
+#include "LevelDB.h"
 
 #include <unistd.h>
 
@@ -45,6 +50,19 @@ void sign_by_hash(std::string & hash, int status){
     exit(0);
 }
 
+void sign_all_unsigned(){
+    jsonrpc::HttpClient client("http://localhost:1028");
+    StubClient c(client, jsonrpc::JSONRPC_CLIENT_V2);
+    std::cout << "Client inited" << std::endl;
+    Json::Value hashes = c.getUnsignedCSRs()["hashes"];
+    if (hashes.empty()) {
+        std::cout << "No unsigned csrs" << std::endl;
+        exit(0);
+    }
+    std::cout << c.signByHashBatch(hashes, 0) << std::endl;
+    exit(0);
+}
+
 void getNumberOfKeysCreated() {
     jsonrpc::HttpClient client("http://localhost:1030");
     StubClient c(client, jsonrpc::JSONRPC_CLIENT_V2);
@@ -62,6 +80,156 @@ void getAllKeysInfo() {
     exit(0);
 }
 
+void streamKeys(const std::string& prefix) {
+    jsonrpc::HttpClient client("http://localhost:1030");
+    StubClient c(client, jsonrpc::JSONRPC_CLIENT_V2);
+    std::cout << "Info client inited" << std::endl;
+    uint64_t total = 0;
+    std::string cursor;
+    do {
+        Json::Value page = c.getKeysPage(prefix, cursor, LEVELDB_KEYS_PAGE_SIZE);
+        if (page["status"].asInt() != 0) {
+            std::cerr << page["errorMessage"].asString() << std::endl;
+            exit(1);
+        }
+        for (auto &&key : page["keys"]) {
+            std::cout << "KEY: " << key["keyName"].asString() << ", VALUE: " << key["value"].asString()
+                      << ", TIMESTAMP: " << key["creationTime"].asString() << std::endl;
+        }
+        total += page["keys"].size();
+        cursor = page["nextCursor"].asString();
+    } while (!cursor.empty());
+    std::cout << "TOTAL KEYS WITH PREFIX '" << prefix << "': " << total << std::endl;
+    exit(0);
+}
+
+// Streams all keys of a running server into _file, one JSON object per line. Keys are encrypted
+// with the SEK, so the file can only be used together with the backup key. If _file exists the
+// export continues after its last complete line.
+void exportKeys(const std::string& _file) {
+    std::string cursor;
+    uint64_t total = 0;
+
+    {
+        std::ifstream in(_file);
+        std::string line;
+        uint64_t validLength = 0;
+        Json::Reader reader;
+        while (std::getline(in, line)) {
+            Json::Value entry;
+            if (in.eof() || !reader.parse(line, entry) || !entry["keyName"].isString()) {
+                break;
+            }
+            cursor = entry["keyName"].asString();
+            validLength += line.size() + 1;
+            total++;
+        }
+        if (in.is_open()) {
+            // drops a line that was cut off when a previous export was interrupted
+            if (truncate(_file.c_str(), validLength) != 0) {
+                std::cerr << "Could not truncate " << _file << std::endl;
+                exit(1);
+            }
+        }
+    }
+
+    if (total > 0) {
+        std::cerr << "Resuming export after " << total << " keys" << std::endl;
+    }
+
+    jsonrpc::HttpClient client("http://localhost:1030");
+    StubClient c(client, jsonrpc::JSONRPC_CLIENT_V2);
+    std::ofstream out(_file, std::ios::app);
+    Json::FastWriter writer;
+
+    do {
+        Json::Value page = c.getKeysPage("", cursor, LEVELDB_KEYS_PAGE_SIZE);
+        if (page["status"].asInt() != 0) {
+            std::cerr << page["errorMessage"].asString() << std::endl;
+            exit(1);
+        }
+        for (auto &&key : page["keys"]) {
+            out << writer.write(key);
+        }
+        out.flush();
+        total += page["keys"].size();
+        cursor = page["nextCursor"].asString();
+        std::cerr << "Exported " << total << " keys" << std::endl;
+    } while (!cursor.empty());
+
+    std::cout << "TOTAL KEYS EXPORTED: " << total << std::endl;
+    exit(0);
+}
+
+// Writes the keys of an export into sgx_data of the current directory. Has to run while sgxwallet
+// is stopped. Lines are parsed and written in batches by one thread per core. Keys already in the
+// database are skipped, so an interrupted import is resumed by running it again.
+void importKeys(const std::string& _file) {
+    std::ifstream in(_file);
+    if (!in.is_open()) {
+        std::cerr << "Could not open " << _file << std::endl;
+        exit(1);
+    }
+
+    std::vector<std::string> lines;
+    std::string line;
+    while (std::getline(in, line)) {
+        if (!line.empty()) {
+            lines.push_back(line);
+        }
+    }
+
+    LevelDB::initDataFolderAndDBs();
+
+    uint64_t numBatches = (lines.size() + LEVELDB_KEYS_PAGE_SIZE - 1) / LEVELDB_KEYS_PAGE_SIZE;
+    std::atomic<uint64_t> nextBatch(0);
+    std::atomic<uint64_t> processed(0);
+    std::atomic<uint64_t> written(0);
+    std::atomic<bool> failed(false);
+    std::mutex outputMutex;
+
+    auto worker = [&]() {
+        Json::Reader reader;
+        for (uint64_t i = nextBatch++; i < numBatches && !failed; i = nextBatch++) {
+            try {
+                std::vector<std::tuple<std::string, std::string, std::string>> entries;
+                for (uint64_t j = i * LEVELDB_KEYS_PAGE_SIZE; j < std::min<uint64_t>(lines.size(), (i + 1) * LEVELDB_KEYS_PAGE_SIZE); j++) {
+                    Json::Value entry;
+                    if (!reader.parse(lines[j], entry) || !entry["keyName"].isString() || !entry["value"].isString()) {
+                        throw std::invalid_argument("Invalid line " + std::to_string(j + 1));
+                    }
+                    entries.emplace_back(entry["keyName"].asString(), entry["value"].asString(),
+                                         entry["creationTime"].asString());
+                }
+                written += LevelDB::getLevelDb()->importValues(entries);
+                processed += entries.size();
+
+                std::lock_guard<std::mutex> lock(outputMutex);
+                std::cerr << "Imported " << processed << " of " << lines.size() << " keys" << std::endl;
+            } catch (std::exception &e) {
+                std::lock_guard<std::mutex> lock(outputMutex);
+                std::cerr << "Import failed: " << e.what() << std::endl;
+                failed = true;
+            }
+        }
+    };
+
+    std::vector<std::thread> threads;
+    for (uint64_t i = 0; i < std::max(1u, std::thread::hardware_concurrency()); i++) {
+        threads.emplace_back(worker);
+    }
+    for (auto &&thread : threads) {
+        thread.join();
+    }
+
+    if (failed) {
+        exit(1);
+    }
+
+    std::cout << "TOTAL KEYS IMPORTED: " << written << ", ALREADY PRESENT: " << lines.size() - written << std::endl;
+    exit(0);
+}
+
 void getLatestCreatedKey() {
     jsonrpc::HttpClient client("http://localhost:1030");
     StubClient c(client, jsonrpc::JSONRPC_CLIENT_V2);
@@ -120,6 +288,68 @@ void isKeyExists(const std::string& key) {
     exit(0);
 }
 
+// Reads key names from stdin, one per line, and prints the creation time of each existing key,
+// checking up to MAX_KEY_NAMES_BATCH_SIZE names per request
+void areKeysExist() {
+    jsonrpc::HttpClient client("http://localhost:1030");
+    StubClient c(client, jsonrpc::JSONRPC_CLIENT_V2);
+    std::cerr << "Info client inited, reading key names from stdin" << std::endl;
+
+    uint64_t total = 0;
+    uint64_t missing = 0;
+    std::string line;
+    bool more = true;
+    while (more) {
+        Json::Value names(Json::arrayValue);
+        while (names.size() < MAX_KEY_NAMES_BATCH_SIZE && (more = (bool) std::getline(std::cin, line))) {
+            if (!line.empty()) {
+                names.append(line);
+            }
+        }
+        if (names.empty()) {
+            break;
+        }
+
+        Json::Value response = c.getKeysMetadata(names);
+        if (response["status"].asInt() != 0) {
+            std::cerr << response["errorMessage"].asString() << std::endl;
+            exit(1);
+        }
+        for (auto &&key : response["keys"]) {
+            if (key["isExist"].asBool()) {
+                std::cout << key["keyName"].asString() << " EXISTS, TIMESTAMP: " << key["creationTime"].asString()
+                          << std::endl;
+            } else {
+                std::cout << key["keyName"].asString() << " DOES NOT EXIST" << std::endl;
+                missing++;
+            }
+        }
+        total += names.size();
+    }
+    std::cout << "CHECKED " << total << " KEYS, " << missing << " DO NOT EXIST" << std::endl;
+    exit(missing == 0 ? 0 : 2);
+}
+
+// Prints a CPU profile of the running server in the folded format, see docs/performance.md
+void getCpuProfile(int _seconds) {
+    jsonrpc::HttpClient client("http://localhost:1030");
+    client.SetTimeout((_seconds + 10) * 1000);
+    StubClient c(client, jsonrpc::JSONRPC_CLIENT_V2);
+    std::cerr << "Info client inited, profiling for " << _seconds << " seconds" << std::endl;
+
+    Json::Value profile = c.getCpuProfile(_seconds);
+    if (profile["status"].asInt() != 0) {
+        std::cerr << profile["errorMessage"].asString() << std::endl;
+        exit(1);
+    }
+    std::cout << profile["folded"].asString();
+    for (auto &&ecall : profile["ecalls"]) {
+        std::cerr << "ECALL " << ecall["name"].asString() << ": " << ecall["calls"].asUInt64() << " calls, "
+                  << ecall["wallUs"].asUInt64() << " us" << std::endl;
+    }
+    exit(0);
+}
+
 int main(int argc, char *argv[]) {
   int opt;
 
@@ -133,17 +363,23 @@ int main(int argc, char *argv[]) {
     std::cout << " -p print all unsigned csr hashes " << std::endl;
     std::cout << " -s [hash] sign csr by hash" << std::endl;
     std::cout << " -r [hash] reject csr by hash" << std::endl;
+    std::cout << " -S sign all unsigned csrs" << std::endl;
     std::cout << " -a print all keys" << std::endl;
+    std::cout << " -k [prefix] stream keys starting with prefix page by page" << std::endl;
     std::cout << " -l print latest created key" << std::endl;
     std::cout << " -n print number of keys stored in database" << std::endl;
     std::cout << " -c print server's config" << std::endl;
     std::cout << " -i [name] check if key with such name presents in database" << std::endl;
+    std::cout << " -f [seconds] print a CPU profile of the server in the folded stack format" << std::endl;
+    std::cout << " -b check key names read from stdin, one per line, exits with 2 if any is missing" << std::endl;
+    std::cout << " -e [file] export all keys of the running server into file, resumes an existing file" << std::endl;
+    std::cout << " -m [file] import keys from an export into ./sgx_data, sgxwallet has to be stopped" << std::endl;
     exit(0);
   }
 
   std::string hash;
   std::string key;
-  while ((opt = getopt(argc, argv, "ps:r:alci:n")) != -1) {
+  while ((opt = getopt(argc, argv, "ps:r:Salci:bnk:e:m:f:")) != -1) {
       switch (opt) {
           case 'p': print_hashes();
                     break;
@@ -153,9 +389,14 @@ int main(int argc, char *argv[]) {
           case 'r': hash = optarg;
                     sign_by_hash(hash, 2);
                     break;
+          case 'S': sign_all_unsigned();
+                    break;
           case 'a':
                     getAllKeysInfo();
                     break;
+          case 'k': key = optarg;
+                    streamKeys(key);
+                    break;
           case 'l':
                     getLatestCreatedKey();
                     break;
@@ -165,9 +406,21 @@ int main(int argc, char *argv[]) {
           case 'i': key = optarg;
                     isKeyExists(key);
                     break;
+          case 'f':
+                    getCpuProfile(atoi(optarg));
+                    break;
+          case 'b':
+                    areKeysExist();
+                    break;
           case 'n':
                     getNumberOfKeysCreated();
                     break;
+          case 'e': key = optarg;
+                    exportKeys(key);
+                    break;
+          case 'm': key = optarg;
+                    importKeys(key);
+                    break;
           case '?': // fprintf(stderr, "unknown flag\n");
                     exit(1);
       }
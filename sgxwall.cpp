@@ -31,12 +31,33 @@
 
 #include "SEKManager.h"
 #include "SGXWalletServer.h"
+#include "SGXWalletServer.hpp"
 
 #include <fstream>
 
 #include "TestUtils.h"
 
 #include "zmq_src/ZMQServer.h"
+#include "DKGGarbageCollector.h"
+#include "ECDSANoncePool.h"
+#include "ECDSAKeyPool.h"
+#include "SignBatcher.h"
+#include "LatencySLO.h"
+#include "LevelDB.h"
+#include "GroupCommit.h"
+#include "KeyWarmUp.h"
+#include "KernelTLS.h"
+#include "Numa.h"
+#include "Profiler.h"
+#include "PerfCounters.h"
+#include "MockEnclave.h"
+#include "TrafficRecorder.h"
+#include "MetricsServer.h"
+#include "ClientRateLimiter.h"
+#include "Bulkhead.h"
+#include "KeyStoreReplicator.h"
+#include "Tracing.h"
+#include "Log.h"
 
 #include "testw.h"
 #include "sgxwall.h"
@@ -48,6 +69,7 @@ void SGXWallet::printUsage() {
     cerr << "\nDebug flags:\n\n";
     cerr << "   -v  Verbose mode: turn on debug output\n";
     cerr << "   -V Detailed verbose mode: turn on debug and trace outputs\n";
+    cerr << "   -L  number In verbose mode log only one of every number zmq requests and replies in full. Default is 1 \n";
     cerr << "\nBackup, restore, update flags:\n\n";
     cerr << "   -b  filename Restore from back up or software update. You will need to put backup key into a file in sgx_data dir. \n";
     cerr << "   -y  Do not ask user to acknowledge receipt of the backup key \n";
@@ -56,6 +78,50 @@ void SGXWallet::printUsage() {
     cerr << "   -c  Disable client authentication using certificates. Insecure!\n";
     cerr << "   -s  Sign client certificates without human confirmation. Insecure! \n";
     cerr << "   -e  Only owner of the key can access it.\n";
+    cerr << "   -I  Also listen for zmq requests on " << ZMQ_IPC_ENDPOINT << " for clients on the same host\n";
+    cerr << "   -Z  Encrypt the zmq port with CurveZMQ. Clients registered their curve key do not sign requests\n";
+    cerr << "\nPerformance flags:\n\n";
+    cerr << "   -H  number Number of https server threads, each serves one connection at a time. Default is " << NUM_HTTP_SERVER_THREADS << " \n";
+    cerr << "   -x  Serve the https port with " << NUM_EVENT_HTTP_IO_THREADS << " event driven I/O threads that keep connections open, the -H threads only process requests \n";
+    cerr << "   -i  Let the kernel encrypt established https sessions (kTLS) where the kernel and GnuTLS support it \n";
+    cerr << "   -Q  number Reject https requests at once when this many are being processed. Default is 0 (no limit) \n";
+    cerr << "   -R  number Requests per second each client may make to the https and zmq ports. Default is 0 (no limit) \n";
+    cerr << "   -G  number Client certs kept verified in memory by the zmq server. Default is " << VERIFIED_CERT_CACHE_SIZE << " \n";
+    cerr << "   -A  number Number of threads of each of the registration, CSR manager and info servers. Default is " << NUM_ADMIN_SERVER_THREADS << " \n";
+    cerr << "   -w  number Number of zmq worker threads. 0 means one thread per CPU core. Default is 16 \n";
+    cerr << "       min,max grows and shrinks the zmq worker threads between min and max with the load \n";
+    cerr << "   -j  number Number of zmq enclave stage threads, which sign the requests workers parsed and verified. Default is 0 (workers sign) \n";
+    cerr << "   -z  dkg,te,admin Concurrent DKG, TE and key management calls allowed, 0 means no limit. Sign calls are not limited. Default is "
+         << BULKHEAD_DKG_LIMIT << "," << BULKHEAD_TE_LIMIT << "," << BULKHEAD_ADMIN_LIMIT << " \n";
+    cerr << "   -p  Pin zmq worker threads to CPU cores \n";
+    cerr << "   -r  NUMA mode: one group of zmq workers per NUMA node, clients are routed to a node and the key cache is kept per node \n";
+    cerr << "   -O  number Number of zmq I/O threads. Default is 1 \n";
+    cerr << "   -f  number Number of zmq front end sockets, each with a router thread. Front ends after the first listen on ports " << ZMQ_EXTRA_FRONT_END_BASE_PORT << " and up. Default is 1 \n";
+    cerr << "   -t  number Number of trusted switchless workers. Enables switchless sign ECALLs. Default is 0 (disabled) \n";
+    cerr << "   -u  number Number of untrusted switchless workers. Used together with -t. Default is 1 \n";
+    cerr << "   -C  number LevelDB block cache size per database in MB. Default is 32 \n";
+    cerr << "   -B  number LevelDB bloom filter bits per key. 0 disables the filter. Default is 10 \n";
+    cerr << "   -W  number LevelDB write buffer size in MB. Default is 8 \n";
+    cerr << "   -l  microseconds Longest time a key write waits for concurrent writes to share its disk sync. Default is " << LEVELDB_GROUP_COMMIT_DEFAULT_WINDOW_US << " \n";
+    cerr << "   -D  engine Key storage engine, leveldb or mapped. mapped copies the LevelDB keys on first use. Default is leveldb \n";
+    cerr << "   -E  number Number of enclave instances, keys are spread over them. Default is 1 \n";
+    cerr << "   -m  microseconds Longest time a sign request waits for concurrent sign requests to be batched with. 0 disables batching. Default is " << SIGN_BATCH_DEFAULT_MAX_WINDOW_US << " \n";
+    cerr << "   -1  milliseconds p99 objective of the zmq BLS sign latency, low priority calls and background work are deferred while it is at risk. Default is 0 (off) \n";
+    cerr << "   -N  Precompute ECDSA nonces in the enclave in a low priority background thread \n";
+    cerr << "   -U  Warm up the recently used and created keys and the enclave before opening the ports \n";
+    cerr << "   -J  Allow CPU profiles of the running server with getCpuProfile on the info server \n";
+    cerr << "   -o  file Record anonymized request metadata to file, replay it with sgx_replay \n";
+    cerr << "   -k  microseconds Busy wait of each mocked ECALL, per signature for batches. Only in a MOCK_ENCLAVE=1 build. Default is 0 \n";
+    cerr << "   -q  Keep the calculateAllBLSPublicKeys results of each DKG round in LevelDB, so that they survive a restart \n";
+    cerr << "   -Y  Count cycles, instructions, cache misses and context switches per method and pipeline stage \n";
+    cerr << "   -K  Pregenerate ECDSA keys in a low priority background thread \n";
+    cerr << "   -g  hours  Delete DKG intermediates of DKG rounds older than this. Default is 0 (disabled) \n";
+    cerr << "   -P  Paranoid mode: decrypt and compare every newly encrypted key in the enclave \n";
+    cerr << "   -F  host Cluster follower: copy the key store of the sgxwallet at host and serve read only requests\n";
+    cerr << "   -S  Standby: create the enclave now and take over the ports once the running sgxwallet exits \n";
+    cerr << "\nMonitoring flags:\n\n";
+    cerr << "   -M  Serve Prometheus metrics at http://<host>:" << BASE_PORT + 6 << "/metrics and the /live and /ready probes \n";
+    cerr << "   -X  Trace requests that carry a W3C traceparent, spans are written to " << TRACE_FILE << " \n";
 }
 
 
@@ -102,6 +168,48 @@ int main(int argc, char *argv[]) {
     bool autoSignClientCertOption = false;
     bool generateTestKeys = false;
     bool checkKeyOwnership = false;
+    uint64_t zmqWorkerThreads = NUM_ZMQ_WORKER_THREADS;
+    uint64_t zmqMinWorkerThreads = 0;
+    uint64_t zmqEnclaveStageThreads = 0;
+    uint64_t bulkheadLimits[Bulkhead::NUM_CLASSES] = {BULKHEAD_DKG_LIMIT, BULKHEAD_TE_LIMIT, BULKHEAD_ADMIN_LIMIT};
+    uint64_t zmqIOThreads = 1;
+    uint64_t zmqFrontEnds = 1;
+    bool pinZMQWorkerThreads = false;
+    uint32_t switchlessTrustedWorkers = 0;
+    uint32_t switchlessUntrustedWorkers = 1;
+    uint64_t dkgGCRetentionHours = 0;
+    uint64_t levelDBBlockCacheMB = LEVELDB_DEFAULT_BLOCK_CACHE_MB;
+    uint32_t levelDBBloomBitsPerKey = LEVELDB_DEFAULT_BLOOM_BITS_PER_KEY;
+    uint64_t levelDBWriteBufferMB = LEVELDB_DEFAULT_WRITE_BUFFER_MB;
+    bool ecdsaNoncePool = false;
+    bool ecdsaKeyPool = false;
+    uint64_t httpServerThreads = NUM_HTTP_SERVER_THREADS;
+    uint64_t httpMaxInFlight = 0;
+    uint64_t adminServerThreads = NUM_ADMIN_SERVER_THREADS;
+    bool zmqCurve = false;
+    bool zmqIpc = false;
+    bool metricsServer = false;
+    bool tracing = false;
+    uint64_t requestLogSampleRate = 1;
+    bool standby = false;
+    bool verifyEncryption = false;
+    bool eventHttp = false;
+    bool kernelTLS = false;
+    bool numa = false;
+    string storageEngine = "leveldb";
+    bool warmUp = false;
+    bool cpuProfiling = false;
+    bool perfCounters = false;
+    string trafficLog;
+    uint64_t mockEnclaveLatencyUs = 0;
+    bool persistBlsPublicKeys = false;
+    uint64_t enclaveShards = 1;
+    uint64_t clientRequestsPerSecond = 0;
+    string leaderHost = "";
+    uint64_t verifiedCertCacheSize = VERIFIED_CERT_CACHE_SIZE;
+    uint64_t signBatchMaxWindowUs = SIGN_BATCH_DEFAULT_MAX_WINDOW_US;
+    uint64_t sloTargetMs = 0;
+    uint64_t groupCommitWindowUs = LEVELDB_GROUP_COMMIT_DEFAULT_WINDOW_US;
 
     std::signal(SIGABRT, SGXWallet::signalHandler);
 
@@ -112,7 +220,7 @@ int main(int argc, char *argv[]) {
         exit(-21);
     }
 
-    while ((opt = getopt(argc, argv, "cshd0abyvVneT")) != -1) {
+    while ((opt = getopt(argc, argv, "cshd0abyvVneTNKZMXSPIixrw:pt:u:g:C:B:W:H:Q:A:L:E:R:F:G:O:f:m:D:l:UJYo:k:qj:z:1:")) != -1) {
         switch (opt) {
             case 'h':
                 SGXWallet::printUsage();
@@ -155,6 +263,263 @@ int main(int argc, char *argv[]) {
             case 'T':
                 generateTestKeys = true;
                 break;
+            case 'N':
+                ecdsaNoncePool = true;
+                break;
+            case 'K':
+                ecdsaKeyPool = true;
+                break;
+            case 'Z':
+                zmqCurve = true;
+                break;
+            case 'I':
+                zmqIpc = true;
+                break;
+            case 'M':
+                metricsServer = true;
+                break;
+            case 'X':
+                tracing = true;
+                break;
+            case 'S':
+                standby = true;
+                break;
+            case 'P':
+                verifyEncryption = true;
+                break;
+            case 'x':
+                eventHttp = true;
+                break;
+            case 'i':
+                kernelTLS = true;
+                break;
+            case 'r':
+                numa = true;
+                break;
+            case 'D':
+                storageEngine = optarg;
+                break;
+            case 'U':
+                warmUp = true;
+                break;
+            case 'J':
+                cpuProfiling = true;
+                break;
+            case 'Y':
+                perfCounters = true;
+                break;
+            case 'o':
+                trafficLog = optarg;
+                break;
+            case 'q':
+                persistBlsPublicKeys = true;
+                break;
+            case 'k':
+                if (!MockEnclave::isEnabled()) {
+                    cerr << "-k needs a MOCK_ENCLAVE=1 build" << endl;
+                    exit(-24);
+                }
+                try {
+                    mockEnclaveLatencyUs = stoull(optarg);
+                } catch (...) {
+                    SGXWallet::printUsage();
+                    exit(-24);
+                }
+                break;
+            case 'w':
+                try {
+                    // min,max autoscales the pool
+                    string workers = optarg;
+                    auto comma = workers.find(',');
+                    if (comma != string::npos) {
+                        zmqMinWorkerThreads = stoull(workers.substr(0, comma));
+                        if (zmqMinWorkerThreads == 0) {
+                            throw invalid_argument(workers);
+                        }
+                    }
+                    zmqWorkerThreads = stoull(workers.substr(comma == string::npos ? 0 : comma + 1));
+                } catch (...) {
+                    SGXWallet::printUsage();
+                    exit(-24);
+                }
+                break;
+            case 'j':
+                try {
+                    zmqEnclaveStageThreads = stoull(optarg);
+                } catch (...) {
+                    SGXWallet::printUsage();
+                    exit(-24);
+                }
+                break;
+            case 'z': {
+                string limits = optarg;
+                size_t start = 0;
+                for (int i = 0; i < Bulkhead::NUM_CLASSES; i++) {
+                    auto end = limits.find(',', start);
+                    if ((end == string::npos) != (i == Bulkhead::NUM_CLASSES - 1)) {
+                        SGXWallet::printUsage();
+                        exit(-24);
+                    }
+                    try {
+                        bulkheadLimits[i] = stoull(limits.substr(start, end - start));
+                    } catch (...) {
+                        SGXWallet::printUsage();
+                        exit(-24);
+                    }
+                    start = end + 1;
+                }
+                break;
+            }
+            case 'p':
+                pinZMQWorkerThreads = true;
+                break;
+            case 'O':
+                try {
+                    zmqIOThreads = stoull(optarg);
+                } catch (...) {
+                    SGXWallet::printUsage();
+                    exit(-24);
+                }
+                break;
+            case 'f':
+                try {
+                    zmqFrontEnds = stoull(optarg);
+                } catch (...) {
+                    SGXWallet::printUsage();
+                    exit(-24);
+                }
+                break;
+            case 't':
+                try {
+                    switchlessTrustedWorkers = stoul(optarg);
+                } catch (...) {
+                    SGXWallet::printUsage();
+                    exit(-24);
+                }
+                break;
+            case 'u':
+                try {
+                    switchlessUntrustedWorkers = stoul(optarg);
+                } catch (...) {
+                    SGXWallet::printUsage();
+                    exit(-24);
+                }
+                break;
+            case 'g':
+                try {
+                    dkgGCRetentionHours = stoull(optarg);
+                } catch (...) {
+                    SGXWallet::printUsage();
+                    exit(-24);
+                }
+                break;
+            case 'C':
+                try {
+                    levelDBBlockCacheMB = stoull(optarg);
+                } catch (...) {
+                    SGXWallet::printUsage();
+                    exit(-24);
+                }
+                break;
+            case 'B':
+                try {
+                    levelDBBloomBitsPerKey = stoul(optarg);
+                } catch (...) {
+                    SGXWallet::printUsage();
+                    exit(-24);
+                }
+                break;
+            case 'W':
+                try {
+                    levelDBWriteBufferMB = stoull(optarg);
+                } catch (...) {
+                    SGXWallet::printUsage();
+                    exit(-24);
+                }
+                break;
+            case 'H':
+                try {
+                    httpServerThreads = stoull(optarg);
+                } catch (...) {
+                    SGXWallet::printUsage();
+                    exit(-24);
+                }
+                break;
+            case 'Q':
+                try {
+                    httpMaxInFlight = stoull(optarg);
+                } catch (...) {
+                    SGXWallet::printUsage();
+                    exit(-24);
+                }
+                break;
+            case 'A':
+                try {
+                    adminServerThreads = stoull(optarg);
+                } catch (...) {
+                    SGXWallet::printUsage();
+                    exit(-24);
+                }
+                break;
+            case 'L':
+                try {
+                    requestLogSampleRate = stoull(optarg);
+                } catch (...) {
+                    SGXWallet::printUsage();
+                    exit(-24);
+                }
+                break;
+            case 'E':
+                try {
+                    enclaveShards = stoull(optarg);
+                } catch (...) {
+                    SGXWallet::printUsage();
+                    exit(-24);
+                }
+                break;
+            case 'R':
+                try {
+                    clientRequestsPerSecond = stoull(optarg);
+                } catch (...) {
+                    SGXWallet::printUsage();
+                    exit(-24);
+                }
+                break;
+            case 'F':
+                leaderHost = optarg;
+                break;
+            case 'm':
+                try {
+                    signBatchMaxWindowUs = stoull(optarg);
+                } catch (...) {
+                    SGXWallet::printUsage();
+                    exit(-24);
+                }
+                break;
+            case '1':
+                try {
+                    sloTargetMs = stoull(optarg);
+                } catch (...) {
+                    SGXWallet::printUsage();
+                    exit(-24);
+                }
+                break;
+            case 'l':
+                try {
+                    groupCommitWindowUs = stoull(optarg);
+                } catch (...) {
+                    SGXWallet::printUsage();
+                    exit(-24);
+                }
+                break;
+            case 'G':
+                try {
+                    verifiedCertCacheSize = stoull(optarg);
+                } catch (...) {
+                    SGXWallet::printUsage();
+                    exit(-24);
+                }
+                break;
             default:
                 SGXWallet::printUsage();
                 exit(-23);
@@ -162,6 +527,8 @@ int main(int argc, char *argv[]) {
         }
     }
 
+    KernelTLS::init(kernelTLS, argv);
+
     uint64_t logLevel = L_INFO;
 
     if (printDebugInfoOption) {
@@ -184,6 +551,47 @@ int main(int argc, char *argv[]) {
         enclaveLogLevel = L_TRACE;
     }
 
+    try {
+        ZMQServer::setWorkerThreadsConfig(zmqWorkerThreads, pinZMQWorkerThreads, zmqMinWorkerThreads);
+        Numa::setEnabled(numa);
+        ZMQServer::setEnclaveStageThreads(zmqEnclaveStageThreads);
+        Bulkhead::setLimits(bulkheadLimits[Bulkhead::DKG], bulkheadLimits[Bulkhead::TE],
+                            bulkheadLimits[Bulkhead::ADMIN]);
+        ZMQServer::setIOThreadsConfig(zmqIOThreads, zmqFrontEnds);
+        ZMQServer::setCurveEnabled(zmqCurve);
+        ZMQServer::setIpcEnabled(zmqIpc);
+        MetricsServer::setEnabled(metricsServer);
+        Tracing::setEnabled(tracing);
+        TrafficRecorder::setFileName(trafficLog);
+        setSwitchlessConfig(switchlessUntrustedWorkers, switchlessTrustedWorkers);
+        DKGGarbageCollector::setRetentionHours(dkgGCRetentionHours);
+        LevelDB::setOptionsConfig(levelDBBlockCacheMB, levelDBBloomBitsPerKey, levelDBWriteBufferMB);
+        LevelDB::setStorageEngine(storageEngine);
+        GroupCommit::setWindowUs(groupCommitWindowUs);
+        ECDSANoncePool::setEnabled(ecdsaNoncePool);
+        ECDSAKeyPool::setEnabled(ecdsaKeyPool);
+        KeyWarmUp::setEnabled(warmUp);
+        Profiler::setEnabled(cpuProfiling);
+        PerfCounters::setEnabled(perfCounters);
+        MockEnclave::setLatencyUs(mockEnclaveLatencyUs);
+        SGXWalletServer::setPersistBlsPublicKeys(persistBlsPublicKeys);
+        SignBatcher::setMaxWindowUs(signBatchMaxWindowUs);
+        LatencySLO::setTargetMs(sloTargetMs);
+        SGXWalletServer::setHttpThreadsConfig(httpServerThreads, httpMaxInFlight);
+        SGXWalletServer::setEventHttp(eventHttp);
+        ClientRateLimiter::setRequestsPerSecond(clientRequestsPerSecond);
+        KeyStoreReplicator::setLeaderHost(leaderHost);
+        ZMQMessage::setVerifiedCertCacheSize(verifiedCertCacheSize);
+        setAdminServerThreads(adminServerThreads);
+        setStandbyMode(standby);
+        setVerifyEncryption(verifyEncryption);
+        setEnclaveShards(enclaveShards);
+        Log::setRequestLogSampleRate(requestLogSampleRate);
+    } catch (SGXException &e) {
+        cerr << e.getMessage() << endl;
+        exit(-25);
+    }
+
     cerr << "Calling initAll ..." << endl;
     initAll(enclaveLogLevel, checkClientCertOption, checkClientCertOption, autoSignClientCertOption, generateTestKeys, checkKeyOwnership);
     cerr << "Completed initAll." << endl;
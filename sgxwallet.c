@@ -37,4 +37,6 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 sgx_launch_token_t token = {0};
 sgx_enclave_id_t eid = 0;
+sgx_enclave_id_t enclaveShards[MAX_ENCLAVE_SHARDS] = {0};
+uint64_t numEnclaveShards = 1;
 int updated = 0;
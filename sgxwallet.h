@@ -45,6 +45,26 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include <sgx_urts.h>
 
 extern sgx_enclave_id_t eid;
+
+// enclave instances, eid is the first one and serves everything that is not bound to a key
+extern sgx_enclave_id_t enclaveShards[MAX_ENCLAVE_SHARDS];
+extern uint64_t numEnclaveShards;
+
+// the instance that serves a key, picked by an FNV-1a hash of the encrypted key, so every key is
+// decrypted and cached by one instance only
+static inline sgx_enclave_id_t shardEid(const uint8_t *_encryptedKey, uint64_t _len) {
+    if (numEnclaveShards <= 1) {
+        return eid;
+    }
+
+    uint64_t hash = 14695981039346656037ULL;
+    for (uint64_t i = 0; i < _len; i++) {
+        hash ^= _encryptedKey[i];
+        hash *= 1099511628211ULL;
+    }
+
+    return enclaveShards[hash % numEnclaveShards];
+}
 extern int updated;
 extern sgx_launch_token_t token;
 
@@ -0,0 +1,113 @@
+/*
+    Copyright (C) 2021-Present SKALE Labs
+
+    This file is part of sgxwallet.
+
+    sgxwallet is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as published
+    by the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    sgxwallet is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with sgxwallet. If not, see <https://www.gnu.org/licenses/>.
+
+    @file sgxwallet_client.h
+    @author Stan Kladko
+    @date 2021
+*/
+
+
+#ifndef SGXWALLET_CLIENT_H
+#define SGXWALLET_CLIENT_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// C interface of libsgxwalletclient, a sign-only ZMQ client for embedding, for example into skaled.
+// It depends on libzmq only. Requests are written straight into a buffer of the client handle that
+// keeps its capacity between requests, and replies are scanned in place, so a sign allocates
+// nothing after the first few calls.
+//
+// Requests are not signed. The node must either not check client certs, or the handle must use a
+// CurveZMQ key pair that the node has registered, see sgxwallet -Z. Use ZMQClient for key
+// generation, DKG and signed requests.
+//
+// A handle must not be used by several threads at once. Use one handle per thread.
+
+#define SGXWALLET_CLIENT_OK 0
+#define SGXWALLET_CLIENT_INVALID_ARGUMENT -10001
+#define SGXWALLET_CLIENT_TIMEOUT -10002
+#define SGXWALLET_CLIENT_ZMQ_ERROR -10003
+#define SGXWALLET_CLIENT_BAD_REPLY -10004
+#define SGXWALLET_CLIENT_BUFFER_TOO_SMALL -10005
+#define SGXWALLET_CLIENT_ASYNC_PENDING -10006
+
+#define SGXWALLET_CLIENT_DEFAULT_TIMEOUT_MS 10000
+
+// large enough for a BLS signature share or an ECDSA signature
+#define SGXWALLET_CLIENT_SIGNATURE_MAX 512
+
+typedef struct sgxwallet_client sgxwallet_client;
+
+// _url is a zmq endpoint such as tcp://127.0.0.1:1031 or ipc://<sgx_data>/zmq.ipc.
+// _curveServerKey, _curvePublicKey and _curveSecretKey are z85 keys of 40 characters, or NULL.
+// With a server key only, a new key pair is generated. Returns NULL on failure.
+sgxwallet_client *sgxwallet_client_new(const char *_url, const char *_curveServerKey,
+                                       const char *_curvePublicKey, const char *_curveSecretKey);
+
+void sgxwallet_client_free(sgxwallet_client *_client);
+
+void sgxwallet_client_set_timeout(sgxwallet_client *_client, uint32_t _timeoutMs);
+
+// error message of the last failed call, valid until the next call on the handle
+const char *sgxwallet_client_error(const sgxwallet_client *_client);
+
+// The sign calls return SGXWALLET_CLIENT_OK, one of the SGXWALLET_CLIENT_ codes above, or the
+// negative status the node replied with. Results are NUL terminated and at most _outLen bytes.
+
+int sgxwallet_bls_sign(sgxwallet_client *_client, const char *_keyShareName, const char *_messageHash,
+                       int _t, int _n, char *_out, size_t _outLen);
+
+int sgxwallet_ecdsa_sign(sgxwallet_client *_client, int _base, const char *_keyName, const char *_messageHash,
+                         char *_out, size_t _outLen);
+
+// _count entries in one request, _out holds _count buffers of _outLen bytes each
+int sgxwallet_bls_sign_batch(sgxwallet_client *_client, const char *const *_keyShareNames,
+                             const char *const *_messageHashes, int _t, int _n, size_t _count,
+                             char *const *_out, size_t _outLen);
+
+int sgxwallet_ecdsa_sign_batch(sgxwallet_client *_client, int _base, const char *_keyName,
+                               const char *const *_messageHashes, size_t _count,
+                               char *const *_out, size_t _outLen);
+
+// Async signing. Submit sends the request and returns its id in _reqId without waiting. Receive
+// waits up to _timeoutMs for the next reply, in completion order, and returns its id together with
+// its status and result. The blocking calls above fail with SGXWALLET_CLIENT_ASYNC_PENDING while
+// submitted requests have not been received.
+
+int sgxwallet_bls_sign_submit(sgxwallet_client *_client, const char *_keyShareName, const char *_messageHash,
+                              int _t, int _n, uint64_t *_reqId);
+
+int sgxwallet_ecdsa_sign_submit(sgxwallet_client *_client, int _base, const char *_keyName,
+                                const char *_messageHash, uint64_t *_reqId);
+
+int sgxwallet_client_receive(sgxwallet_client *_client, int _timeoutMs, uint64_t *_reqId,
+                             char *_out, size_t _outLen);
+
+// number of submitted requests that have not been received
+size_t sgxwallet_client_pending(const sgxwallet_client *_client);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif //SGXWALLET_CLIENT_H
@@ -67,6 +67,51 @@ extern bool autoconfirm;
 #define ECDSA_ENCR_LEN 93
 #define ECDSA_BIN_LEN 33
 
+// fixed slot sizes of the arrays passed to trustedBlsSignMessageBatch
+#define BLS_BATCH_KEY_SLOT_LEN 256
+
+// G1 points and signatures cross the enclave boundary as affine X then Y,
+// each BLS_FQ_LIMBS little endian 64 bit limbs
+#define BLS_FQ_LIMBS 4
+#define BLS_G1_LIMBS 8
+#define BLS_G2_LIMBS 16
+
+// DKG buffer sizes, must match secure_enclave/EnclaveConstants.h
+#define MAX_DKG_N 128
+#define DKG_BUFER_LENGTH (MAX_DKG_N * 78 + 1)
+#define DKG_MAX_SEALED_LEN (DKG_BUFER_LENGTH + 128)
+#define DKG_PUBLIC_SHARES_LEN (MAX_DKG_N * 320 + 1)
+
+// fixed slot sizes of the arrays passed to trustedGetEncryptedSecretSharesV2
+#define MAX_DKG_SHARES_BATCH_SIZE MAX_DKG_N
+#define DKG_BATCH_PUB_KEY_SLOT_LEN 129
+#define DKG_BATCH_SKEY_SLOT_LEN 256
+#define DKG_BATCH_SHARE_SLOT_LEN 193
+#define DKG_BATCH_SHARE_G2_SLOT_LEN 320
+
+// generateDKGPolyBatch, must match secure_enclave/EnclaveConstants.h
+#define MAX_DKG_POLY_BATCH_SIZE 32
+#define DKG_PUBLIC_SHARES_SLOT_LEN(__T__) ((__T__) * 320 + 1)
+
+// generateBLSPrivateKeyBatch and popProveBatch, must match secure_enclave/EnclaveConstants.h
+#define MAX_BLS_KEY_BATCH_SIZE 64
+#define BLS_KEY_BATCH_PUB_KEY_SLOT_LEN 320
+
+#define MAX_DECRYPTION_SHARES_BATCH_SIZE 64
+#define DECRYPTION_SHARES_MIN_VALUES_PER_THREAD 8
+
+// getDecryptionShares caches of checked public decryption values and of shares per key and value
+#define DECRYPTION_VALUE_CACHE_MAX_ENTRIES 16384
+#define DECRYPTION_SHARE_CACHE_MAX_ENTRIES 16384
+
+// exact buffer sizes of the sign ECALLs, see secure_enclave.edl
+#define ERR_STRING_LEN 256
+#define ECDSA_PUB_KEY_COORD_LEN 65
+#define ECDSA_SIG_LIMBS 4
+
+// fixed slot sizes of the arrays passed to trustedEcdsaSignBatch
+#define ECDSA_BATCH_HASH_SLOT_LEN 80
+
 
 #define PLAINTEXT_KEY_TOO_LONG -2
 #define UNPADDED_KEY -3
@@ -191,13 +236,369 @@ extern bool autoconfirm;
 #define COULD_NOT_CREATE_POP_PROVE -118
 #define GENERATE_BLS_KEY_INVALID_NAME -119
 #define INVALID_CREATE_BLS_AGGREGATED_KEY -120
+#define INVALID_ZMQ_WORKER_THREADS_NUMBER -121
+#define INVALID_BLS_SIGN_BATCH -122
+#define INVALID_ECDSA_SIGN_BATCH -123
+#define INVALID_SWITCHLESS_CONFIG -124
+#define INVALID_KEYS_PAGE_LIMIT -125
+#define INVALID_DKG_GC_RETENTION -126
+#define INVALID_LEVELDB_OPTIONS -127
+#define INVALID_DKG_VERIFY_BATCH -128
+#define INVALID_HTTP_SERVER_THREADS_NUMBER -129
+#define ZMQ_CLIENT_REQUEST_ABORTED -130
+#define ZMQ_UNKNOWN_SESSION -131
+#define ZMQ_REQUEST_EXPIRED -132
+#define ZMQ_SERVER_OVERLOADED -133
+#define SGX_METRICS_SERVER_FAILED_TO_START -134
+#define SGX_INSTANCE_ALREADY_RUNNING -135
+#define INVALID_ENCLAVE_SHARDS_NUMBER -136
+#define INVALID_KEY_HANDLE -137
+#define KEY_HANDLES_LIMIT_REACHED -138
+#define INVALID_KEY_IMPORT_BATCH -139
+#define INVALID_MULT_G2_BATCH -140
+#define CLIENT_RATE_LIMITED -141
+#define INVALID_CLIENT_RATE_LIMIT -142
+#define KEY_STORE_READ_ONLY -143
+#define INVALID_REPLICATION_LEADER -144
+#define INVALID_CERT_CACHE_SIZE -145
+#define INVALID_CSR_BATCH -146
+#define INVALID_ZMQ_FRONT_END_CONFIG -147
+#define ZMQ_CLIENT_RETRIES_EXHAUSTED -148
+#define INVALID_BLS_SIG_SHARES -149
+#define INVALID_BLS_VERIFY_BATCH -150
+#define SEK_ROTATION_IN_PROGRESS -151
+#define SEK_ROTATION_NOT_ALLOWED -152
+#define INVALID_BLS_HASHED_POINT -153
+#define INVALID_STORAGE_ENGINE -154
+#define INVALID_KEY_NAMES_BATCH -155
+#define INVALID_PROFILE_REQUEST -156
+#define ZMQ_UNKNOWN_CERT -157
+#define BULKHEAD_FULL -158
+#define INVALID_SCHAIN_PARTITIONS -159
+#define INVALID_DKG_POLY_BATCH -160
+#define INVALID_BLS_KEY_BATCH -161
+#define INVALID_SCHAIN_ID -162
+#define INVALID_CREATE_BLS_KEY_SECRET_SHARES -163
+#define SLO_SHED -164
 
 #define SGX_ENCLAVE_ERROR -666
 
 #define MAX_CSR_NUM 1000
+#define CLIENT_CERT_VALIDITY_DAYS 3650
+
+// caps of the read cache in front of each LevelDB database
+#define LEVELDB_CACHE_MAX_ENTRIES 65536
+#define LEVELDB_CACHE_MAX_BYTES (64 * 1024 * 1024)
+
+// secondary indexes live under INDEX_NAMESPACE_PREFIX and are hidden from key listings
+#define INDEX_NAMESPACE_PREFIX "__INDEX__:"
+#define INDEX_VERSION_KEY "__INDEX__:VERSION"
+#define CREATION_TIME_INDEX_PREFIX "__INDEX__:CT:"
+#define CREATION_TIME_INDEX_TIMESTAMP_LEN 20
+
+// first byte of values stored as bytes instead of hex, see LevelDB.h
+#define LEVELDB_BINARY_VALUE_VERSION 1
+#define VALUE_FORMAT_VERSION_KEY "__INDEX__:VALUE_FORMAT"
+
+#define LEVELDB_KEYS_PAGE_SIZE 1000
+// areKeysExist and getKeysMetadata of the info server
+#define MAX_KEY_NAMES_BATCH_SIZE LEVELDB_KEYS_PAGE_SIZE
+
+// identical BLS and ECDSA sign requests share one computation, see RequestCoalescer.h
+#define REQUEST_COALESCER_MAX_ENTRIES 65536
+#define REQUEST_COALESCER_TTL_MS 10000
+// BLS shares are deterministic, so repeated BLS sign requests are answered from memory for longer
+#define BLS_SIGN_CACHE_TTL_MS 600000
+// rough size of a kept result, for the memory budget
+#define REQUEST_COALESCER_ENTRY_BYTES 512
+
+// calculateAllBLSPublicKeys results of recent DKG rounds, public keys do not change for a round
+#define BLS_PUBLIC_KEYS_CACHE_MAX_ENTRIES 256
+#define BLS_PUBLIC_KEYS_CACHE_TTL_MS 86400000
+#define BLS_PUBLIC_KEYS_PREFIX "BLS_PUBKEYS:"
+
+// default concurrency limits of DKG, TE and key management calls, see Bulkhead.h
+#define BULKHEAD_DKG_LIMIT 4
+#define BULKHEAD_TE_LIMIT 2
+#define BULKHEAD_ADMIN_LIMIT 4
+#define BULKHEAD_MAX_WAIT_MS 2000
+
+// concurrent BLS and ECDSA sign requests are signed by batch ECALLs, see SignBatcher.h
+#define SIGN_BATCH_DEFAULT_MAX_WINDOW_US 500
+#define SIGN_BATCH_MIN_WINDOW_US 100
+#define SIGN_BATCH_PROBE_INTERVAL 16
+#define SIGN_BATCH_MAX_REQUESTS 64
+
+// HMAC authenticated ZMQ sessions, see zmq_src/ZMQSessionCache.h
+#define ZMQ_SESSION_ID_BYTES 16
+#define ZMQ_SESSION_KEY_BYTES 32
+#define ZMQ_SESSION_TTL_SECONDS 3600
+#define ZMQ_SESSION_CACHE_MAX_ENTRIES 65536
+
+// handles of keys resolved with openKey, see KeyHandles.h
+#define KEY_HANDLE_ID_BYTES 16
+#define KEY_HANDLES_MAX_ENTRIES 65536
+
+// zmq I/O threads and ROUTER front ends, see ZMQFrontEnd in zmq_src/ZMQServer.h
+#define MAX_ZMQ_IO_THREADS 16
+#define MAX_ZMQ_FRONT_ENDS 8
+#define ZMQ_EXTRA_FRONT_END_BASE_PORT (BASE_PORT + 7)
+
+// socket file of the zmq server for clients on the same host, see the -I flag
+#define ZMQ_IPC_ENDPOINT "ipc://" SGXDATA_FOLDER "zmq.ipc"
+
+// ZMTP heartbeats, a peer that stays silent for ZMQ_HEARTBEAT_TIMEOUT_MS is disconnected
+#define ZMQ_HEARTBEAT_IVL_MS 1000
+#define ZMQ_HEARTBEAT_TIMEOUT_MS 3000
+// reconnect interval of ZMQ clients, doubled after each failed attempt up to the max
+#define ZMQ_RECONNECT_IVL_MS 100
+#define ZMQ_RECONNECT_IVL_MAX_MS 2000
+
+// ZMQ admission control, requests beyond these queue depths are rejected with ZMQ_SERVER_OVERLOADED
+#define ZMQ_MAX_SIGN_QUEUE_DEPTH 4096
+#define ZMQ_MAX_SLOW_QUEUE_DEPTH 1024
+// a server with more sign requests waiting is reported as not ready, see Readiness.h
+#define READINESS_MAX_SIGN_QUEUE_DEPTH (ZMQ_MAX_SIGN_QUEUE_DEPTH / 2)
+#define ZMQ_MAX_OUTGOING_QUEUE_DEPTH 8192
+// replies the router sends from one reply ring before it moves to the next
+#define ZMQ_REPLY_BURST_SIZE 32
+
+// key store replication of cluster followers, see KeyStoreReplicator.h
+#define REPLICATION_PAGE_SIZE LEVELDB_KEYS_PAGE_SIZE
+#define REPLICATION_INTERVAL_MS 1000
+#define REPLICATION_OVERLAP_SECONDS 2
+
+// in process client cert verification, see zmq_src/CertVerifier.h and zmq_src/VerifiedCertCache.h
+#define VERIFIED_CERT_CACHE_SIZE 4096
+#define MAX_VERIFIED_CERT_CACHE_SIZE (1024 * 1024)
+// verified certs are checked again after this time, so that a new CRL applies to them
+#define VERIFIED_CERT_TTL_SECONDS 3600
+#define CERT_CRL_CHECK_INTERVAL_SECONDS 60
+
+// per client token buckets and fair queuing, see ClientRateLimiter.h and zmq_src/FairQueue.h
+#define CLIENT_RATE_LIMITER_MAX_ENTRIES 65536
+#define MAX_CLIENT_REQUESTS_PER_SECOND 1000000
+#define ZMQ_FAIR_QUEUE_QUANTUM_BYTES 8192
+#define ZMQ_MAX_CLIENT_BACKLOG 1024
+// schain groups and weights of the fair queue, see SchainPartitions.h
+#define MAX_SCHAIN_PARTITIONS 256
+#define MAX_SCHAIN_PARTITION_WEIGHT 1000
+// sign requests handed to the scheduler per worker thread, the rest wait in the fair queue
+#define ZMQ_SIGN_DISPATCH_PER_WORKER 2
+// requests queued per thread of the CPU stage, which runs requests that need no enclave
+#define ZMQ_CPU_STAGE_QUEUE_PER_THREAD 4
+
+// worker pool autoscaling, see WorkerThreadPool.h. The pool grows by half when the scheduler
+// holds its dispatch limit or the p99 queue wait of the last interval is above the grow
+// threshold, and shrinks by one worker after ZMQ_AUTOSCALE_SHRINK_INTERVALS quiet intervals
+#define ZMQ_AUTOSCALE_INTERVAL_MS 1000
+#define ZMQ_AUTOSCALE_GROW_P99_US 10000
+#define ZMQ_AUTOSCALE_SHRINK_P99_US 1000
+#define ZMQ_AUTOSCALE_SHRINK_INTERVALS 30
+
+// initial memory of the per worker thread allocator used to parse ZMQ requests
+#define ZMQ_REQUEST_POOL_BUFFER_SIZE (64 * 1024)
+
+// per database LevelDB options, set with sgxwallet -C, -B and -W
+#define LEVELDB_DEFAULT_BLOCK_CACHE_MB 32
+#define LEVELDB_DEFAULT_BLOOM_BITS_PER_KEY 10
+#define LEVELDB_DEFAULT_WRITE_BUFFER_MB 8
+#define MAX_LEVELDB_BLOCK_CACHE_MB 4096
+#define MAX_LEVELDB_BLOOM_BITS_PER_KEY 32
+#define MAX_LEVELDB_WRITE_BUFFER_MB 1024
+
+// storage engine of sgxwallet -D mapped, see MappedStore.h
+#define MAPPED_STORE_MIN_MAP_SIZE (64ull * 1024 * 1024)
+#define MAPPED_STORE_COMPACT_MIN_SIZE (1024 * 1024)
+
+// DKG intermediates of the wallet database live in a database of their own, see LevelDB::isDKGStoreKey
+#define DKG_STORE_SUFFIX "_DKG"
+#define LEVELDB_DKG_STORE_BLOCK_CACHE_MB 8
+
+// startup warm-up of sgxwallet -U, see KeyWarmUp.h. WARM_UP_MAX_KEYS matches the enclave KEY_CACHE_SIZE
+#define WARM_UP_MAX_KEYS 128
+#define WARM_UP_RECENT_KEYS_SECONDS (7 * 24 * 3600)
+#define HOT_KEYS_FILE SGXDATA_FOLDER "hot_keys.txt"
+#define HOT_KEYS_SAVE_INTERVAL_SECONDS 60
+#define HOT_KEYS_MAX_TRACKED 1024
+
+// per key sign statistics, see KeyStats.h
+#define KEY_STATS_FILE SGXDATA_FOLDER "key_stats.txt"
+#define KEY_STATS_SAVE_INTERVAL_SECONDS 60
+#define KEY_STATS_MAX_KEYS 65536
+
+// DKG phase durations per poly name, see DKGTimeline.h
+#define DKG_TIMELINE_MAX_SESSIONS 1024
+
+// time a synced key write waits for concurrent writes to join its sync, set with sgxwallet -l
+#define LEVELDB_GROUP_COMMIT_DEFAULT_WINDOW_US 2000
+#define MAX_LEVELDB_GROUP_COMMIT_WINDOW_US 100000
+
+// garbage collection of abandoned DKG intermediates, see DKGGarbageCollector.h
+#define MAX_DKG_GC_RETENTION_HOURS (24 * 365)
+#define DKG_GC_BATCH_SIZE 1000
+#define DKG_GC_INTERVAL_SECONDS 3600
+
+// interval of the Metrics memory sampler
+#define METRICS_SAMPLE_INTERVAL_SECONDS 10
+
+// CPU profiles of the info server getCpuProfile, see Profiler.h. Samples take 400 bytes
+#define PROFILER_FREQUENCY_HZ 99
+#define PROFILER_MAX_SECONDS 60
+#define PROFILER_MAX_SAMPLES 65536
+#define PROFILER_MAX_DEPTH 48
+
+// percentages of physical memory, and of the budget for the pressure limit, see MemoryBudget.h
+#define MEMORY_BUDGET_PERCENT 50
+#define MEMORY_PRESSURE_PERCENT 80
+#define MEMORY_EXIT_PERCENT 90
+#define MEMORY_PRESSURE_MAX_QUEUED 256
+
+// BLS sign latency objective of sgxwallet -1, see LatencySLO.h
+#define SLO_QUANTILE 0.99
+#define SLO_WINDOW_SECONDS 10
+#define SLO_MIN_SAMPLES 100
+#define SLO_DEGRADE_PERCENT 80
+#define SLO_RECOVER_PERCENT 60
+#define SLO_RECOVER_SECONDS 30
+// sign batches wait at most this fraction of -m while the objective is at risk
+#define SLO_SIGN_BATCH_WINDOW_DIVISOR 4
+
+// request metadata recorded with sgxwallet -o, see TrafficRecorder.h
+#define TRAFFIC_RECORDER_MAX_QUEUED 65536
+#define TRAFFIC_RECORDER_MAX_BYTES (1024ULL * 1024 * 1024)
+
+// buffers kept by each thread for reuse, see ScratchBuffer.h
+#define SCRATCH_BUFFER_POOL_SIZE 8
+#define SCRATCH_BUFFER_MAX_POOLED_LEN (4 * BUF_LEN)
+// stage latency quantiles of getServerStatusExtended cover this many sampler intervals
+#define METRICS_ROLLING_WINDOW_SAMPLES 6
+
+// messages queued for the async logger thread, the oldest are dropped when the queue is full
+#define LOG_ASYNC_QUEUE_SIZE 8192
+// interval of trustedFlushLog calls, enclave warnings and errors are written immediately
+#define ENCLAVE_LOG_FLUSH_INTERVAL_MS 500
+
+// spans of traced requests, see Tracing.h
+#define TRACE_FILE SGXDATA_FOLDER "traces.jsonl"
+#define TRACEPARENT_LEN 55
+
+// held by the serving sgxwallet, a standby instance (-S) takes over as soon as it is released
+#define INSTANCE_LOCK_FILE SGXDATA_FOLDER "sgxwallet.lock"
+#define STANDBY_POLL_INTERVAL_MS 10
+
+// GnuTLS config written by sgxwallet -i, see KernelTLS.h
+#define KTLS_CONFIG_FILE SGXDATA_FOLDER "gnutls_ktls.conf"
+#define KTLS_AVAILABLE_ULP_FILE "/proc/sys/net/ipv4/tcp_available_ulp"
+
+// NUMA nodes and their CPUs, see Numa.h
+#define NUMA_NODES_DIR "/sys/devices/system/node/"
+
+#define MAX_BLS_SIGN_BATCH_SIZE 256
+
+// longest try and increment counter accepted in the hint of blsSignHashedPoint
+#define BLS_HINT_COUNTER_MAX_DIGITS 20
+
+// BLS sign batches hash to G1 on up to one thread per this many hashes
+#define BLS_HASH_MIN_PARALLEL_BATCH 8
+#define BLS_CONTEXT_CACHE_MAX_ENTRIES 64
+
+// verifyBLSSignatures, Miller loops and hashes run on up to one thread per this many pairs
+#define MAX_BLS_VERIFY_BATCH_SIZE 256
+#define BLS_VERIFY_MIN_PARALLEL_BATCH 4
+
+// host caches of BLS and ECDSA public keys and BLS PoPs, keyed by the encrypted key
+#define BLS_PUBKEY_CACHE_MAX_ENTRIES 1024
+#define ECDSA_PUBKEY_CACHE_MAX_ENTRIES 1024
+
+// ZMQClient caches of public keys and verification vectors, see ZMQClient::enableKeyCache
+#define ZMQ_CLIENT_KEY_CACHE_MAX_ENTRIES 4096
+
+// complaint responses, keyed by poly name, index and t
+#define COMPLAINT_RESPONSE_CACHE_MAX_ENTRIES 1024
+
+// Lagrange coefficients of the signer sets seen by aggregateBLSSignatures
+#define LAGRANGE_COEFFS_CACHE_MAX_ENTRIES 1024
+
+#define MAX_ECDSA_SIGN_BATCH_SIZE 256
+
+// multG2Batch, the generator table has 256 / MULT_G2_WINDOW_SIZE windows of 2^MULT_G2_WINDOW_SIZE points
+#define MAX_MULT_G2_BATCH_SIZE 1024
+#define MULT_G2_WINDOW_SIZE 5
+#define MULT_G2_MIN_PARALLEL_BATCH 8
+
+// bulk key import, must match secure_enclave/EnclaveConstants.h
+#define MAX_KEY_IMPORT_BATCH_SIZE 256
+#define KEY_IMPORT_ENC_KEY_SLOT_LEN 256
+#define KEY_IMPORT_PUB_KEY_SLOT_LEN 129
+
+// online SEK rotation, see SEKRotation.h. Batch and slot sizes must match secure_enclave/EnclaveConstants.h
+#define MAX_SEK_ROTATION_BATCH_SIZE 32
+#define SEK_ROTATION_SLOT_LEN DKG_MAX_SEALED_LEN
+#define SEK_ROTATION_BATCH_INTERVAL_MS 50
+#define SEK_ROTATION_NICE 19
+
+// larger JSON-RPC batch arrays are processed sequentially by libjson-rpc-cpp, see JsonRpcBatchHandler.h
+#define MAX_JSON_RPC_BATCH_SIZE 4096
+
+// enclave pool of precomputed ECDSA nonces, enabled with sgxwallet -N,
+// capacity and batch must match NONCE_POOL_* in secure_enclave/EnclaveConstants.h
+#define ECDSA_NONCE_POOL_CAPACITY 1024
+#define ECDSA_NONCE_POOL_REFILL_BATCH 32
+#define ECDSA_NONCE_POOL_FULL_SLEEP_MS 100
+#define ECDSA_NONCE_POOL_REFILL_NICE 19
+
+// pregenerated ECDSA keys, enabled with sgxwallet -K, the enclave capacity and batch
+// must match KEY_POOL_* in secure_enclave/EnclaveConstants.h
+#define ECDSA_KEY_POOL_CAPACITY 256
+#define ECDSA_ENCLAVE_KEY_POOL_CAPACITY 256
+#define ECDSA_KEY_POOL_REFILL_BATCH 16
+#define ECDSA_KEY_POOL_FULL_SLEEP_MS 100
+#define ECDSA_KEY_POOL_REFILL_NICE 19
 
 #define BASE_PORT 1026
 
+// must match TCSNum and HeapMaxSize of the enclave config, the build sets both from ENCLAVE_PROFILE
+#ifndef ENCLAVE_TCS_NUM
+#define ENCLAVE_TCS_NUM 256
+#endif
+
+#ifndef ENCLAVE_HEAP_MAX_SIZE
+#define ENCLAVE_HEAP_MAX_SIZE 0x10000000
+#endif
+
+// libmicrohttpd threads of the signing server, each serves one connection at a time
+#ifdef SGX_HW_SIM
+#define NUM_HTTP_SERVER_THREADS 8
+#elif ENCLAVE_TCS_NUM < 256
+// leaves TCS for the ZMQ workers and background threads of smaller enclaves
+#define NUM_HTTP_SERVER_THREADS (ENCLAVE_TCS_NUM / 2)
+#else
+#define NUM_HTTP_SERVER_THREADS 200
+#endif
+#define MAX_HTTP_SERVER_THREADS 1024
+
+// I/O threads of the event driven signing server of sgxwallet -x, its requests are processed by
+// the NUM_HTTP_SERVER_THREADS (-H) workers
+#define NUM_EVENT_HTTP_IO_THREADS 4
+#define EVENT_HTTP_MAX_REQUEST_SIZE (16 * 1024 * 1024)
+#define EVENT_HTTP_CONNECTION_TIMEOUT_SECONDS 60
+
+// threads of each of the registration, CSR manager and info servers, the libjson-rpc-cpp default
+#define NUM_ADMIN_SERVER_THREADS 50
+
+// JSON-RPC error returned without processing when the signing server has too many requests in flight
+#define JSON_RPC_SERVER_BUSY -32000
+
+// upper bound for each of the switchless trusted and untrusted worker pools
+#define MAX_SWITCHLESS_WORKERS 32
+
+// enclave instances of one sgxwallet process, see -E
+#define MAX_ENCLAVE_SHARDS 8
+
+// how long a thread waits for a TCS of an enclave instance, see EcallGate.h
+#define ECALL_GATE_MAX_WAIT_MS 30000
+
 #define WALLETDB_NAME "sgxwallet.db"
 #define ENCLAVE_NAME "secure_enclave.signed.so"
 #define SGXDATA_FOLDER "sgx_data/"
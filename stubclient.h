@@ -51,6 +51,28 @@ class StubClient : public jsonrpc::Client
                 throw jsonrpc::JsonRpcException(jsonrpc::Errors::ERROR_CLIENT_INVALID_RESPONSE, result.toStyledString());
         }
 
+        Json::Value importBLSKeyShareBatch(const Json::Value& keyShares)
+        {
+            Json::Value p;
+            p["keyShares"] = keyShares;
+            Json::Value result = this->CallMethod("importBLSKeyShareBatch",p);
+            if (result.isObject())
+                return result;
+            else
+                throw jsonrpc::JsonRpcException(jsonrpc::Errors::ERROR_CLIENT_INVALID_RESPONSE, result.toStyledString());
+        }
+
+        Json::Value importECDSAKeyBatch(const Json::Value& keys)
+        {
+            Json::Value p;
+            p["keys"] = keys;
+            Json::Value result = this->CallMethod("importECDSAKeyBatch",p);
+            if (result.isObject())
+                return result;
+            else
+                throw jsonrpc::JsonRpcException(jsonrpc::Errors::ERROR_CLIENT_INVALID_RESPONSE, result.toStyledString());
+        }
+
         Json::Value generateECDSAKey() 
         {
           Json::Value p;
@@ -86,6 +108,19 @@ class StubClient : public jsonrpc::Client
                 throw jsonrpc::JsonRpcException(jsonrpc::Errors::ERROR_CLIENT_INVALID_RESPONSE, result.toStyledString());
         }
 
+        Json::Value ecdsaSignMessageHashBatch(int base, const std::string& keyName, const Json::Value& messageHashes)
+        {
+            Json::Value p;
+            p["base"] = base;
+            p["keyName"] = keyName;
+            p["messageHashes"] = messageHashes;
+            Json::Value result = this->CallMethod("ecdsaSignMessageHashBatch",p);
+            if (result.isObject())
+                return result;
+            else
+                throw jsonrpc::JsonRpcException(jsonrpc::Errors::ERROR_CLIENT_INVALID_RESPONSE, result.toStyledString());
+        }
+
         Json::Value generateDKGPoly(const std::string& polyName, int t) 
         {
             Json::Value p;
@@ -98,6 +133,18 @@ class StubClient : public jsonrpc::Client
                 throw jsonrpc::JsonRpcException(jsonrpc::Errors::ERROR_CLIENT_INVALID_RESPONSE, result.toStyledString());
         }
 
+        Json::Value generateDKGPolyBatch(const Json::Value& polyNames, int t)
+        {
+            Json::Value p;
+            p["polyNames"] = polyNames;
+            p["t"] = t;
+            Json::Value result = this->CallMethod("generateDKGPolyBatch",p);
+            if (result.isObject())
+                return result;
+            else
+                throw jsonrpc::JsonRpcException(jsonrpc::Errors::ERROR_CLIENT_INVALID_RESPONSE, result.toStyledString());
+        }
+
         Json::Value getVerificationVector(const std::string& polyName, int t) 
         {
             Json::Value p;
@@ -110,6 +157,18 @@ class StubClient : public jsonrpc::Client
                 throw jsonrpc::JsonRpcException(jsonrpc::Errors::ERROR_CLIENT_INVALID_RESPONSE, result.toStyledString());
         }
 
+        Json::Value getVerificationVectorCompressed(const std::string& polyName, int t)
+        {
+            Json::Value p;
+            p["polyName"] = polyName;
+            p["t"] = t;
+            Json::Value result = this->CallMethod("getVerificationVectorCompressed",p);
+            if (result.isObject())
+                return result;
+            else
+                throw jsonrpc::JsonRpcException(jsonrpc::Errors::ERROR_CLIENT_INVALID_RESPONSE, result.toStyledString());
+        }
+
         Json::Value getSecretShare(const std::string& polyName, const Json::Value& publicKeys, int t, int n) 
         {
             Json::Value p;
@@ -170,6 +229,22 @@ class StubClient : public jsonrpc::Client
               throw jsonrpc::JsonRpcException(jsonrpc::Errors::ERROR_CLIENT_INVALID_RESPONSE, result.toStyledString());
         }
 
+        Json::Value dkgVerificationBatch(const Json::Value& publicShares, const std::string& ethKeyName, const Json::Value& secretShares, int t, int n, int index)
+        {
+            Json::Value p;
+            p["ethKeyName"] = ethKeyName;
+            p["secretShares"] = secretShares;
+            p["index"] = index;
+            p["n"] = n;
+            p["publicShares"] = publicShares;
+            p["t"] = t;
+            Json::Value result = this->CallMethod("dkgVerificationBatch",p);
+            if (result.isObject())
+              return result;
+            else
+              throw jsonrpc::JsonRpcException(jsonrpc::Errors::ERROR_CLIENT_INVALID_RESPONSE, result.toStyledString());
+        }
+
         Json::Value createBLSPrivateKey(const std::string & blsKeyName, const std::string& ethKeyName, const std::string& polyName, const std::string& SecretShare, int t, int n) 
         {
           Json::Value p;
@@ -213,6 +288,17 @@ class StubClient : public jsonrpc::Client
               throw jsonrpc::JsonRpcException(jsonrpc::Errors::ERROR_CLIENT_INVALID_RESPONSE, result.toStyledString());
         }
 
+        Json::Value generateBLSPrivateKeyBatch(const Json::Value& blsKeyNames) {
+            Json::Value p;
+            p["blsKeyNames"] = blsKeyNames;
+
+            Json::Value result = this->CallMethod("generateBLSPrivateKeyBatch", p);
+            if (result.isObject())
+              return result;
+            else
+              throw jsonrpc::JsonRpcException(jsonrpc::Errors::ERROR_CLIENT_INVALID_RESPONSE, result.toStyledString());
+        }
+
         Json::Value getBLSPublicKeyShare(const std::string & blsKeyName) 
         {
             Json::Value p;
@@ -277,6 +363,17 @@ class StubClient : public jsonrpc::Client
               throw jsonrpc::JsonRpcException(jsonrpc::Errors::ERROR_CLIENT_INVALID_RESPONSE, result.toStyledString());
         }
 
+        Json::Value popProveBatch(const Json::Value& blsKeyNames) {
+            Json::Value p;
+            p["blsKeyNames"] = blsKeyNames;
+
+            Json::Value result = this->CallMethod("popProveBatch", p);
+            if (result.isObject())
+              return result;
+            else
+              throw jsonrpc::JsonRpcException(jsonrpc::Errors::ERROR_CLIENT_INVALID_RESPONSE, result.toStyledString());
+        }
+
         Json::Value multG2(const std::string & x) 
         {
             Json::Value p;
@@ -289,6 +386,45 @@ class StubClient : public jsonrpc::Client
                 throw jsonrpc::JsonRpcException(jsonrpc::Errors::ERROR_CLIENT_INVALID_RESPONSE, result.toStyledString());
         }
 
+        Json::Value multG2Batch(const Json::Value& xs)
+        {
+            Json::Value p;
+            p["xs"] = xs;
+
+            Json::Value result = this->CallMethod("multG2Batch",p);
+            if (result.isObject())
+                return result;
+            else
+                throw jsonrpc::JsonRpcException(jsonrpc::Errors::ERROR_CLIENT_INVALID_RESPONSE, result.toStyledString());
+        }
+
+        Json::Value aggregateBLSSignatures(const Json::Value& shares, const Json::Value& signerIndices, int t, int n)
+        {
+            Json::Value p;
+            p["shares"] = shares;
+            p["signerIndices"] = signerIndices;
+            p["t"] = t;
+            p["n"] = n;
+
+            Json::Value result = this->CallMethod("aggregateBLSSignatures",p);
+            if (result.isObject())
+                return result;
+            else
+                throw jsonrpc::JsonRpcException(jsonrpc::Errors::ERROR_CLIENT_INVALID_RESPONSE, result.toStyledString());
+        }
+
+        Json::Value verifyBLSSignatures(const Json::Value& requests)
+        {
+            Json::Value p;
+            p["requests"] = requests;
+
+            Json::Value result = this->CallMethod("verifyBLSSignatures",p);
+            if (result.isObject())
+                return result;
+            else
+                throw jsonrpc::JsonRpcException(jsonrpc::Errors::ERROR_CLIENT_INVALID_RESPONSE, result.toStyledString());
+        }
+
         Json::Value isPolyExists(const std::string & polyName) 
         {
             Json::Value p;
@@ -313,6 +449,85 @@ class StubClient : public jsonrpc::Client
                 throw jsonrpc::JsonRpcException(jsonrpc::Errors::ERROR_CLIENT_INVALID_RESPONSE, result.toStyledString());
         }
 
+        Json::Value deleteSchainKeys(const std::string & schainId)
+        {
+            Json::Value p;
+            p["schainId"] = schainId;
+
+            Json::Value result = this->CallMethod("deleteSchainKeys",p);
+            if (result.isObject())
+                return result;
+            else
+                throw jsonrpc::JsonRpcException(jsonrpc::Errors::ERROR_CLIENT_INVALID_RESPONSE, result.toStyledString());
+        }
+
+        Json::Value openKey(const std::string & keyName)
+        {
+            Json::Value p;
+            p["keyName"] = keyName;
+
+            Json::Value result = this->CallMethod("openKey",p);
+            if (result.isObject())
+                return result;
+            else
+                throw jsonrpc::JsonRpcException(jsonrpc::Errors::ERROR_CLIENT_INVALID_RESPONSE, result.toStyledString());
+        }
+
+        Json::Value closeKey(const std::string & keyHandle)
+        {
+            Json::Value p;
+            p["keyHandle"] = keyHandle;
+
+            Json::Value result = this->CallMethod("closeKey",p);
+            if (result.isObject())
+                return result;
+            else
+                throw jsonrpc::JsonRpcException(jsonrpc::Errors::ERROR_CLIENT_INVALID_RESPONSE, result.toStyledString());
+        }
+
+        Json::Value blsSignMessageHashByHandle(const std::string & keyHandle, const std::string & messageHash, int t, int n)
+        {
+            Json::Value p;
+            p["keyHandle"] = keyHandle;
+            p["messageHash"] = messageHash;
+            p["n"] = n;
+            p["t"] = t;
+
+            Json::Value result = this->CallMethod("blsSignMessageHashByHandle",p);
+            if (result.isObject())
+                return result;
+            else
+                throw jsonrpc::JsonRpcException(jsonrpc::Errors::ERROR_CLIENT_INVALID_RESPONSE, result.toStyledString());
+        }
+
+        Json::Value blsSignHashedPoint(const std::string & keyShareName, const std::string & hashedPoint, const std::string & hint)
+        {
+            Json::Value p;
+            p["keyShareName"] = keyShareName;
+            p["hashedPoint"] = hashedPoint;
+            p["hint"] = hint;
+
+            Json::Value result = this->CallMethod("blsSignHashedPoint",p);
+            if (result.isObject())
+                return result;
+            else
+                throw jsonrpc::JsonRpcException(jsonrpc::Errors::ERROR_CLIENT_INVALID_RESPONSE, result.toStyledString());
+        }
+
+        Json::Value ecdsaSignMessageHashByHandle(int base, const std::string & keyHandle, const std::string & messageHash)
+        {
+            Json::Value p;
+            p["base"] = base;
+            p["keyHandle"] = keyHandle;
+            p["messageHash"] = messageHash;
+
+            Json::Value result = this->CallMethod("ecdsaSignMessageHashByHandle",p);
+            if (result.isObject())
+                return result;
+            else
+                throw jsonrpc::JsonRpcException(jsonrpc::Errors::ERROR_CLIENT_INVALID_RESPONSE, result.toStyledString());
+        }
+
         Json::Value getServerStatus()
         {
             Json::Value p;
@@ -324,6 +539,17 @@ class StubClient : public jsonrpc::Client
                 throw jsonrpc::JsonRpcException(jsonrpc::Errors::ERROR_CLIENT_INVALID_RESPONSE, result.toStyledString());
         }
 
+        Json::Value getServerStatusExtended()
+        {
+            Json::Value p;
+            p = Json::nullValue;
+            Json::Value result = this->CallMethod("getServerStatusExtended",p);
+            if (result.isObject())
+                return result;
+            else
+                throw jsonrpc::JsonRpcException(jsonrpc::Errors::ERROR_CLIENT_INVALID_RESPONSE, result.toStyledString());
+        }
+
         Json::Value getServerVersion() {
             Json::Value p;
             p = Json::nullValue;
@@ -360,6 +586,18 @@ class StubClient : public jsonrpc::Client
                 throw jsonrpc::JsonRpcException(jsonrpc::Errors::ERROR_CLIENT_INVALID_RESPONSE, result.toStyledString());
         }
 
+        Json::Value signByHashBatch(const Json::Value& hashes, int status)
+        {
+            Json::Value p;
+            p["hashes"] = hashes;
+            p["status"] = status;
+            Json::Value result = this->CallMethod("signByHashBatch",p);
+            if (result.isObject())
+                return result;
+            else
+                throw jsonrpc::JsonRpcException(jsonrpc::Errors::ERROR_CLIENT_INVALID_RESPONSE, result.toStyledString());
+        }
+
 
         /// InfoServer
 
@@ -396,6 +634,97 @@ class StubClient : public jsonrpc::Client
                 throw jsonrpc::JsonRpcException(jsonrpc::Errors::ERROR_CLIENT_INVALID_RESPONSE, result.toStyledString());
         }
 
+        Json::Value getCacheStatistics()
+        {
+            Json::Value p;
+            p = Json::nullValue;
+            Json::Value result = this->CallMethod("getCacheStatistics", p);
+            if (result.isObject())
+                return result;
+            else
+                throw jsonrpc::JsonRpcException(jsonrpc::Errors::ERROR_CLIENT_INVALID_RESPONSE, result.toStyledString());
+        }
+
+        Json::Value getCpuProfile(int seconds)
+        {
+            Json::Value p;
+            p["seconds"] = seconds;
+            Json::Value result = this->CallMethod("getCpuProfile", p);
+            if (result.isObject())
+                return result;
+            else
+                throw jsonrpc::JsonRpcException(jsonrpc::Errors::ERROR_CLIENT_INVALID_RESPONSE, result.toStyledString());
+        }
+
+        Json::Value getReadiness()
+        {
+            Json::Value p;
+            p = Json::nullValue;
+            Json::Value result = this->CallMethod("getReadiness", p);
+            if (result.isObject())
+                return result;
+            else
+                throw jsonrpc::JsonRpcException(jsonrpc::Errors::ERROR_CLIENT_INVALID_RESPONSE, result.toStyledString());
+        }
+
+        Json::Value getKeysPage(const std::string& prefix, const std::string& cursor, int limit)
+        {
+            Json::Value p;
+            p["prefix"] = prefix;
+            p["cursor"] = cursor;
+            p["limit"] = limit;
+            Json::Value result = this->CallMethod("getKeysPage", p);
+            if (result.isObject())
+                return result;
+            else
+                throw jsonrpc::JsonRpcException(jsonrpc::Errors::ERROR_CLIENT_INVALID_RESPONSE, result.toStyledString());
+        }
+
+        Json::Value getReplicationPage(const std::string& cursor, int limit)
+        {
+            Json::Value p;
+            p["cursor"] = cursor;
+            p["limit"] = limit;
+            Json::Value result = this->CallMethod("getReplicationPage", p);
+            if (result.isObject())
+                return result;
+            else
+                throw jsonrpc::JsonRpcException(jsonrpc::Errors::ERROR_CLIENT_INVALID_RESPONSE, result.toStyledString());
+        }
+
+        Json::Value setEcallTiming(bool enabled)
+        {
+            Json::Value p;
+            p["enabled"] = enabled;
+            Json::Value result = this->CallMethod("setEcallTiming", p);
+            if (result.isObject())
+                return result;
+            else
+                throw jsonrpc::JsonRpcException(jsonrpc::Errors::ERROR_CLIENT_INVALID_RESPONSE, result.toStyledString());
+        }
+
+        Json::Value setSchainPartitions(const Json::Value& partitions)
+        {
+            Json::Value p;
+            p["partitions"] = partitions;
+            Json::Value result = this->CallMethod("setSchainPartitions", p);
+            if (result.isObject())
+                return result;
+            else
+                throw jsonrpc::JsonRpcException(jsonrpc::Errors::ERROR_CLIENT_INVALID_RESPONSE, result.toStyledString());
+        }
+
+        Json::Value getSchainPartitions()
+        {
+            Json::Value p;
+            p = Json::nullValue;
+            Json::Value result = this->CallMethod("getSchainPartitions", p);
+            if (result.isObject())
+                return result;
+            else
+                throw jsonrpc::JsonRpcException(jsonrpc::Errors::ERROR_CLIENT_INVALID_RESPONSE, result.toStyledString());
+        }
+
         Json::Value isKeyExist(const std::string& key)
         {
             Json::Value p;
@@ -407,6 +736,50 @@ class StubClient : public jsonrpc::Client
                 throw jsonrpc::JsonRpcException(jsonrpc::Errors::ERROR_CLIENT_INVALID_RESPONSE, result.toStyledString());
         }
 
+        Json::Value areKeysExist(const Json::Value& keyNames)
+        {
+            Json::Value p;
+            p["keyNames"] = keyNames;
+            Json::Value result = this->CallMethod("areKeysExist", p);
+            if (result.isObject())
+                return result;
+            else
+                throw jsonrpc::JsonRpcException(jsonrpc::Errors::ERROR_CLIENT_INVALID_RESPONSE, result.toStyledString());
+        }
+
+        Json::Value getKeysMetadata(const Json::Value& keyNames)
+        {
+            Json::Value p;
+            p["keyNames"] = keyNames;
+            Json::Value result = this->CallMethod("getKeysMetadata", p);
+            if (result.isObject())
+                return result;
+            else
+                throw jsonrpc::JsonRpcException(jsonrpc::Errors::ERROR_CLIENT_INVALID_RESPONSE, result.toStyledString());
+        }
+
+        Json::Value getKeyStatistics(const Json::Value& keyNames)
+        {
+            Json::Value p;
+            p["keyNames"] = keyNames;
+            Json::Value result = this->CallMethod("getKeyStatistics", p);
+            if (result.isObject())
+                return result;
+            else
+                throw jsonrpc::JsonRpcException(jsonrpc::Errors::ERROR_CLIENT_INVALID_RESPONSE, result.toStyledString());
+        }
+
+        Json::Value getDKGTimeline(const Json::Value& polyNames)
+        {
+            Json::Value p;
+            p["polyNames"] = polyNames;
+            Json::Value result = this->CallMethod("getDKGTimeline", p);
+            if (result.isObject())
+                return result;
+            else
+                throw jsonrpc::JsonRpcException(jsonrpc::Errors::ERROR_CLIENT_INVALID_RESPONSE, result.toStyledString());
+        }
+
 };
 
 #endif //JSONRPC_CPP_STUB_STUBCLIENT_H_
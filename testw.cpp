@@ -40,11 +40,15 @@
 #include "CryptoTools.h"
 #include "ServerInit.h"
 #include "DKGCrypto.h"
+#include "G2Codec.h"
 #include "SGXException.h"
 #include "LevelDB.h"
+#include "MappedStore.h"
+#include "Metrics.h"
 #include "SGXWalletServer.hpp"
 
 #define CATCH_CONFIG_MAIN
+#define CATCH_CONFIG_ENABLE_BENCHMARKING
 
 #include "catch.hpp"
 #include "stubclient.h"
@@ -52,17 +56,40 @@
 #include "BLSSigShareSet.h"
 #include "BLSPublicKeyShare.h"
 #include "BLSPublicKey.h"
+#include <tools/utils.h>
 #include "SEKManager.h"
+#include "ServerDataChecker.h"
 #include <thread>
+#include <chrono>
+#include <atomic>
+#include <random>
+#include <map>
 #include "common.h"
 
 #include "SGXRegistrationServer.h"
+#include "SGXInfoServer.h"
+#include "DKGGarbageCollector.h"
+#include "SEKRotation.h"
+#include "ECDSANoncePool.h"
+#include "ECDSAKeyPool.h"
+#include "KeyWarmUp.h"
+#include "Readiness.h"
+#include "MemoryBudget.h"
+#include "LatencySLO.h"
+#include "Profiler.h"
+#include "ScratchBuffer.h"
+#include "ECDSACrypto.h"
 #include "SGXWalletServer.h"
 #include "zmq_src/ZMQClient.h"
 #include "zmq_src/ZMQServer.h"
+#include "zmq_src/CertVerifier.h"
+#include "JsonRpcBatchHandler.h"
+#include "KeyStoreReplicator.h"
+#include "PartitionedStore.h"
 #include "sgxwallet.h"
 #include "TestUtils.h"
 #include "testw.h"
+#include "experimental/filesystem"
 
 #define PRINT_SRC_LINE cerr << "Executing line " <<  to_string(__LINE__) << endl;
 
@@ -111,6 +138,22 @@ public:
     }
 };
 
+class TestFixtureSwitchless {
+public:
+    TestFixtureSwitchless() {
+        TestUtils::resetDB();
+        setOptions(L_INFO, false, true);
+        setSwitchlessConfig(1, 2);
+        initAll(L_INFO, false, false, true, false, true);
+    }
+
+    ~TestFixtureSwitchless() {
+        ZMQServer::exitZMQServer();
+        TestUtils::destroyEnclave();
+        setSwitchlessConfig(0, 0);
+    }
+};
+
 class TestFixtureNoResetFromBackup {
 public:
     TestFixtureNoResetFromBackup() {
@@ -155,22 +198,78 @@ TEST_CASE_METHOD(TestFixture, "ECDSA AES keygen and signature test", "[ecdsa-aes
     REQUIRE(errStatus == SGX_SUCCESS);
 
     string hex = SAMPLE_HEX_HASH;
-    vector<char> signatureR(BUF_LEN, 0);
-    vector<char> signatureS(BUF_LEN, 0);
+    uint64_t signatureR[ECDSA_SIG_LIMBS];
+    uint64_t signatureS[ECDSA_SIG_LIMBS];
     uint8_t signatureV = 0;
 
     for (int i = 0; i < 50; i++) {
         PRINT_SRC_LINE
         status = trustedEcdsaSign(eid, &errStatus, errMsg.data(), encrPrivKey.data(), encLen,
-                                  hex.data(),
-                                  signatureR.data(),
-                                  signatureS.data(), &signatureV, 16);
+                                  hex.data(), signatureR, signatureS, &signatureV);
         REQUIRE(status == SGX_SUCCESS);
         REQUIRE(errStatus == SGX_SUCCESS);
     }
 
 }
 
+TEST_CASE_METHOD(TestFixture, "ECDSA signing consumes precomputed nonces once", "[ecdsa-nonce-pool]") {
+    auto sizeBefore = ECDSANoncePool::refill(0);
+    auto sizeAfter = ECDSANoncePool::refill(ECDSA_NONCE_POOL_REFILL_BATCH);
+    REQUIRE(sizeAfter >= sizeBefore);
+    REQUIRE(sizeAfter <= ECDSA_NONCE_POOL_CAPACITY);
+
+    auto keys = genECDSAKey();
+    string hash = SAMPLE_HEX_HASH;
+
+    auto sig1 = ecdsaSignHash(keys.at(0), hash.c_str(), 16);
+    auto sig2 = ecdsaSignHash(keys.at(0), hash.c_str(), 16);
+
+    // the same message signed twice has to use two different nonces
+    REQUIRE(sig1.at(1) != sig2.at(1));
+    REQUIRE(ECDSANoncePool::refill(0) + 2 == sizeAfter);
+}
+
+TEST_CASE_METHOD(TestFixture, "ECDSA keys come from the key pools", "[ecdsa-key-pool]") {
+    auto enclaveSize = ECDSAKeyPool::refillEnclave(ECDSA_KEY_POOL_REFILL_BATCH);
+    REQUIRE(enclaveSize > 0);
+    REQUIRE(enclaveSize <= ECDSA_ENCLAVE_KEY_POOL_CAPACITY);
+
+    auto hostSize = ECDSAKeyPool::refillHost(2);
+    REQUIRE(hostSize >= 2);
+    REQUIRE(ECDSAKeyPool::getEnclavePoolSize() + 2 >= enclaveSize);
+
+    auto keys1 = ECDSAKeyPool::take();
+    auto keys2 = ECDSAKeyPool::take();
+    REQUIRE(ECDSAKeyPool::getPoolSize() + 2 == hostSize);
+    REQUIRE(keys1.at(1) != keys2.at(1));
+
+    // the public key computed in the pool matches the one of the encrypted key
+    REQUIRE(getECDSAPubKey(keys1.at(0)) == keys1.at(1));
+
+    string hash = SAMPLE_HEX_HASH;
+    REQUIRE_NOTHROW(ecdsaSignHash(keys1.at(0), hash.c_str(), 16));
+}
+
+TEST_CASE_METHOD(TestFixture, "Keys signed with are warmed up after a restart", "[key-warm-up]") {
+    auto ecdsaKey = SGXWalletServer::generateECDSAKeyImpl();
+    REQUIRE(ecdsaKey["status"] == 0);
+    auto keyName = ecdsaKey["keyName"].asString();
+
+    KeyWarmUp::setEnabled(true);
+    REQUIRE(SGXWalletServer::ecdsaSignMessageHashImpl(16, keyName, SAMPLE_HASH)["status"] == 0);
+    KeyWarmUp::saveHotKeys();
+
+    ifstream file(HOT_KEYS_FILE);
+    string contents((istreambuf_iterator<char>(file)), istreambuf_iterator<char>());
+    REQUIRE(contents.find(keyName + " 1\n") != string::npos);
+
+    REQUIRE(KeyWarmUp::warmUpKeys() >= 1);
+    REQUIRE_NOTHROW(KeyWarmUp::warmUpThread());
+    KeyWarmUp::setEnabled(false);
+
+    REQUIRE(SGXWalletServer::ecdsaSignMessageHashImpl(16, keyName, SAMPLE_HASH)["status"] == 0);
+}
+
 TEST_CASE_METHOD(TestFixture, "ECDSA AES key gen", "[ecdsa-aes-key-gen]") {
     vector<char> errMsg(BUF_LEN, 0);
     int errStatus = 0;
@@ -291,6 +390,28 @@ TEST_CASE_METHOD(TestFixture, "ECDSA key gen API", "[ecdsa-key-gen-api]") {
     }
 }
 
+TEST_CASE_METHOD(TestFixture, "ECDSA batch sign API", "[ecdsa-sign-batch-api]") {
+    HttpClient client(RPC_ENDPOINT);
+    StubClient c(client, JSONRPC_CLIENT_V2);
+
+    auto keyName = genECDSAKeyAPI(c);
+
+    string sh = SAMPLE_HASH;
+    Json::Value hashes(Json::arrayValue);
+    for (int i = 0; i < 10; i++) {
+        hashes.append(sh.substr(0, sh.size() - 8) + to_string(10000000 + i));
+    }
+
+    Json::Value sigs = c.ecdsaSignMessageHashBatch(16, keyName, hashes);
+    REQUIRE(sigs["status"].asInt() == 0);
+    REQUIRE(sigs["signature_v"].size() == hashes.size());
+    REQUIRE(sigs["signature_r"].size() == hashes.size());
+    REQUIRE(sigs["signature_s"].size() == hashes.size());
+
+    Json::Value emptyBatch = c.ecdsaSignMessageHashBatch(16, keyName, Json::Value(Json::arrayValue));
+    REQUIRE(emptyBatch["status"].asInt() == INVALID_ECDSA_SIGN_BATCH);
+}
+
 TEST_CASE_METHOD(TestFixture, "BLS key encrypt", "[bls-key-encrypt]") {
     auto key = TestUtils::encryptTestKey();
     REQUIRE(key);
@@ -298,7 +419,7 @@ TEST_CASE_METHOD(TestFixture, "BLS key encrypt", "[bls-key-encrypt]") {
 }
 
 TEST_CASE_METHOD(TestFixture, "DKG AES gen test", "[dkg-aes-gen]") {
-    vector <uint8_t> encryptedDKGSecret(BUF_LEN, 0);
+    vector <uint8_t> encryptedDKGSecret(DKG_MAX_SEALED_LEN, 0);
     vector<char> errMsg(BUF_LEN, 0);
 
     int errStatus = 0;
@@ -309,7 +430,7 @@ TEST_CASE_METHOD(TestFixture, "DKG AES gen test", "[dkg-aes-gen]") {
     REQUIRE(status == SGX_SUCCESS);
     REQUIRE(errStatus == SGX_SUCCESS);
 
-    vector<char> secret(BUF_LEN, 0);
+    vector<char> secret(DKG_BUFER_LENGTH, 0);
     vector<char> errMsg1(BUF_LEN, 0);
 
     status = trustedDecryptDkgSecret(eid, &errStatus, errMsg1.data(), encryptedDKGSecret.data(),
@@ -322,7 +443,7 @@ TEST_CASE_METHOD(TestFixture, "DKG AES gen test", "[dkg-aes-gen]") {
 }
 
 TEST_CASE_METHOD(TestFixture, "DKG AES public shares test", "[dkg-aes-pub-shares]") {
-    vector <uint8_t> encryptedDKGSecret(BUF_LEN, 0);
+    vector <uint8_t> encryptedDKGSecret(DKG_MAX_SEALED_LEN, 0);
     vector<char> errMsg(BUF_LEN, 0);
 
     int errStatus = 0;
@@ -337,7 +458,7 @@ TEST_CASE_METHOD(TestFixture, "DKG AES public shares test", "[dkg-aes-pub-shares
     vector<char> errMsg1(BUF_LEN, 0);
 
     char colon = ':';
-    vector<char> pubShares(10000, 0);
+    vector<char> pubShares(DKG_PUBLIC_SHARES_LEN, 0);
     PRINT_SRC_LINE
     status = trustedGetPublicShares(eid, &errStatus, errMsg1.data(),
                                     encryptedDKGSecret.data(), encLen, pubShares.data(), t);
@@ -352,7 +473,7 @@ TEST_CASE_METHOD(TestFixture, "DKG AES public shares test", "[dkg-aes-pub-shares
         pubSharesG2.push_back(TestUtils::vectStringToG2(coeffStr));
     }
 
-    vector<char> secret(BUF_LEN, 0);
+    vector<char> secret(DKG_BUFER_LENGTH, 0);
     PRINT_SRC_LINE
     status = trustedDecryptDkgSecret(eid, &errStatus, errMsg1.data(), encryptedDKGSecret.data(), encLen,
                                      (uint8_t *) secret.data());
@@ -377,7 +498,7 @@ TEST_CASE_METHOD(TestFixture, "DKG AES encrypted secret shares test", "[dkg-aes-
     int errStatus = 0;
     uint64_t encLen = 0;
 
-    vector <uint8_t> encryptedDKGSecret(BUF_LEN, 0);
+    vector <uint8_t> encryptedDKGSecret(DKG_MAX_SEALED_LEN, 0);
     PRINT_SRC_LINE
     auto status = trustedGenDkgSecret(eid, &errStatus, errMsg.data(), encryptedDKGSecret.data(), &encLen, 2);
     REQUIRE(status == SGX_SUCCESS);
@@ -407,7 +528,7 @@ TEST_CASE_METHOD(TestFixture, "DKG AES encrypted secret shares version 2 test",
     int errStatus = 0;
     uint64_t encLen = 0;
 
-    vector <uint8_t> encryptedDKGSecret(BUF_LEN, 0);
+    vector <uint8_t> encryptedDKGSecret(DKG_MAX_SEALED_LEN, 0);
     PRINT_SRC_LINE
     auto status = trustedGenDkgSecret(eid, &errStatus, errMsg.data(), encryptedDKGSecret.data(), &encLen, 2);
     REQUIRE(status == SGX_SUCCESS);
@@ -527,6 +648,118 @@ TEST_CASE_METHOD(TestFixture, "Delete Bls Key", "[delete-bls-key]") {
     REQUIRE(c.deleteBlsKey(name)["deleted"] == true);
 }
 
+TEST_CASE_METHOD(TestFixture, "Delete schain keys", "[delete-schain-keys]") {
+    HttpClient client(RPC_ENDPOINT);
+    StubClient c(client, JSONRPC_CLIENT_V2);
+
+    Json::Value names;
+    for (int i = 0; i < 3; i++) {
+        names.append("BLS_KEY:SCHAIN_ID:123456792:NODE_ID:0:DKG_ID:" + to_string(i));
+    }
+    REQUIRE(c.generateBLSPrivateKeyBatch(names)["status"] == 0);
+
+    string polyName = "POLY:SCHAIN_ID:123456792:NODE_ID:0:DKG_ID:0";
+    REQUIRE(c.generateDKGPoly(polyName, 2)["status"] == 0);
+
+    string otherName = "BLS_KEY:SCHAIN_ID:1234567920:NODE_ID:0:DKG_ID:0";
+    REQUIRE(c.importBLSKeyShare("0xe632f7fde2c90a073ec43eaa90dca7b82476bf28815450a11191484934b9c3f",
+                                otherName)["status"] == 0);
+
+    REQUIRE(c.deleteSchainKeys("1a")["status"] != 0);
+
+    auto response = c.deleteSchainKeys("123456792");
+    REQUIRE(response["status"] == 0);
+    REQUIRE(response["deletedKeys"].asUInt64() >= 4);
+
+    auto db = LevelDB::getLevelDb();
+    for (auto &&name : names) {
+        REQUIRE(db->readString(name.asString()) == nullptr);
+        REQUIRE(c.getBLSPublicKeyShare(name.asString())["status"] != 0);
+    }
+    REQUIRE(db->readString(polyName) == nullptr);
+
+    // a schain id that only shares the digits keeps its keys
+    REQUIRE(c.getBLSPublicKeyShare(otherName)["status"] == 0);
+    REQUIRE(c.deleteSchainKeys("123456792")["deletedKeys"] == 0);
+    REQUIRE(c.deleteBlsKey(otherName)["deleted"] == true);
+}
+
+TEST_CASE_METHOD(TestFixture, "Sign by key handle", "[key-handles]") {
+    HttpClient client(RPC_ENDPOINT);
+    StubClient c(client, JSONRPC_CLIENT_V2);
+
+    auto ecdsaHandle = c.openKey(genECDSAKeyAPI(c));
+    REQUIRE(ecdsaHandle["status"] == 0);
+    REQUIRE(c.ecdsaSignMessageHashByHandle(16, ecdsaHandle["keyHandle"].asString(), SAMPLE_HASH)["status"] == 0);
+    REQUIRE(c.blsSignMessageHashByHandle(ecdsaHandle["keyHandle"].asString(), SAMPLE_HASH, 1, 1)["status"] ==
+            INVALID_KEY_HANDLE);
+    REQUIRE(c.closeKey(ecdsaHandle["keyHandle"].asString())["closed"] == true);
+    REQUIRE(c.ecdsaSignMessageHashByHandle(16, ecdsaHandle["keyHandle"].asString(), SAMPLE_HASH)["status"] ==
+            INVALID_KEY_HANDLE);
+
+    std::string name = "BLS_KEY:SCHAIN_ID:123456790:NODE_ID:0:DKG_ID:0";
+    REQUIRE(c.importBLSKeyShare("0xe632f7fde2c90a073ec43eaa90dca7b82476bf28815450a11191484934b9c3f", name)["status"] == 0);
+
+    auto blsHandle = c.openKey(name);
+    REQUIRE(blsHandle["status"] == 0);
+    REQUIRE(c.blsSignMessageHashByHandle(blsHandle["keyHandle"].asString(), SAMPLE_HASH, 1, 1)["signatureShare"] ==
+            c.blsSignMessageHash(name, SAMPLE_HASH, 1, 1)["signatureShare"]);
+
+    REQUIRE(c.deleteBlsKey(name)["deleted"] == true);
+    REQUIRE(c.blsSignMessageHashByHandle(blsHandle["keyHandle"].asString(), SAMPLE_HASH, 1, 1)["status"] ==
+            INVALID_KEY_HANDLE);
+}
+
+TEST_CASE_METHOD(TestFixture, "ZMQ client retries", "[zmq-client-retries]") {
+    // nothing listens on this port, so every attempt times out
+    string empty = "";
+    auto client = make_shared<ZMQClient>(ZMQ_IP, ZMQ_PORT + 100, false, empty, empty);
+    client->setRetryPolicy(1, 1500);
+
+    REQUIRE_THROWS_AS(client->blsSignMessageHash("BLS_KEY:SCHAIN_ID:1:NODE_ID:0:DKG_ID:0", SAMPLE_HASH, 1, 1),
+                      SGXException);
+}
+
+TEST_CASE_METHOD(TestFixture, "ZMQ hedged sign requests", "[zmq-hedged-sign]") {
+    // the second endpoint is down, so hedged requests go to the same server and the late
+    // duplicate reply has to be dropped by reqId
+    vector<pair<string, uint16_t>> endpoints = {{ZMQ_IP, ZMQ_PORT}, {ZMQ_IP, ZMQ_PORT + 100}};
+    auto client = make_shared<ZMQClient>(endpoints, true, "./sgx_data/cert_data/rootCA.pem",
+                                         "./sgx_data/cert_data/rootCA.key");
+
+    REQUIRE_THROWS(client->setHedgePercentile(1));
+    client->setHedgePercentile(0.000001);
+
+    std::string name = "BLS_KEY:SCHAIN_ID:123456790:NODE_ID:0:DKG_ID:0";
+    string key_str = "0xe632f7fde2c90a073ec43eaa90dca7b82476bf28815450a11191484934b9c3f";
+    REQUIRE(client->importBLSKeyShare(key_str, name));
+
+    auto sigShare = client->blsSignMessageHash(name, SAMPLE_HASH, 1, 1);
+    for (int i = 0; i < 10; i++) {
+        REQUIRE(client->blsSignMessageHash(name, SAMPLE_HASH, 1, 1) == sigShare);
+    }
+
+    REQUIRE(client->deleteBLSKey(name));
+}
+
+TEST_CASE_METHOD(TestFixture, "ZMQ client key cache", "[zmq-client-key-cache]") {
+    auto client = make_shared<ZMQClient>(ZMQ_IP, ZMQ_PORT, true, "./sgx_data/cert_data/rootCA.pem",
+                                         "./sgx_data/cert_data/rootCA.key");
+    client->enableKeyCache(true);
+
+    std::string name = "BLS_KEY:SCHAIN_ID:123456791:NODE_ID:0:DKG_ID:0";
+    string key_str = "0xe632f7fde2c90a073ec43eaa90dca7b82476bf28815450a11191484934b9c3f";
+    REQUIRE(client->importBLSKeyShare(key_str, name));
+
+    auto publicKey = client->getBLSPublicKey(name);
+    REQUIRE(client->getBLSPublicKey(name) == publicKey);
+    REQUIRE(client->getKeyCacheHits() == 1);
+
+    // deleting the key drops it from the cache, so the lookup goes to the server again
+    REQUIRE(client->deleteBLSKey(name));
+    REQUIRE_THROWS(client->getBLSPublicKey(name));
+}
+
 TEST_CASE_METHOD(TestFixture, "Delete Bls Key Zmq", "[delete-bls-key-zmq]") {
     auto client = make_shared<ZMQClient>(ZMQ_IP, ZMQ_PORT, true, "./sgx_data/cert_data/rootCA.pem",
                                          "./sgx_data/cert_data/rootCA.key");
@@ -545,6 +778,279 @@ TEST_CASE_METHOD(TestFixture, "Delete Bls Key Zmq", "[delete-bls-key-zmq]") {
     REQUIRE(client->deleteBLSKey(name));
 }
 
+TEST_CASE("Key name checks", "[key-name-checks]") {
+    REQUIRE(checkName("BLS_KEY:SCHAIN_ID:1:NODE_ID:12:DKG_ID:0", "BLS_KEY"));
+    REQUIRE(checkName("POLY:SCHAIN_ID:1:NODE_ID:12:DKG_ID:0", "POLY"));
+    REQUIRE(!checkName("POLY:SCHAIN_ID:1:NODE_ID:12:DKG_ID:0", "BLS_KEY"));
+    REQUIRE(!checkName("BLS_KEY:SCHAIN_ID:1:NODE_ID:123456:DKG_ID:0", "BLS_KEY"));
+    REQUIRE(!checkName("BLS_KEY:SCHAIN_ID:1a:NODE_ID:12:DKG_ID:0", "BLS_KEY"));
+    REQUIRE(!checkName("BLS_KEY:SCHAIN_ID:1:NODE_ID:12:DKG_ID:0:1", "BLS_KEY"));
+
+    REQUIRE(checkECDSAKeyName("NEK:abcDEF0123"));
+    REQUIRE(!checkECDSAKeyName("NEK:abcdefg"));
+    REQUIRE(!checkECDSAKeyName("NEK:" + string(65, 'a')));
+    REQUIRE(!checkECDSAKeyName("BLS_KEY:abc"));
+
+    REQUIRE(checkHex(string(64, 'F')));
+    REQUIRE(!checkHex(string(66, 'f')));
+    REQUIRE(!checkHex(""));
+    REQUIRE(!checkHex("12 4"));
+}
+
+TEST_CASE("DKG sessions keep order per poly name", "[dkg-sessions]") {
+    RequestScheduler scheduler(4, 4, 16, 16);
+
+    auto request = [](const string &_session) {
+        IncomingRequest element;
+        element.msg = make_shared<string>(_session);
+        element.session = _session;
+        return element;
+    };
+
+    for (auto &session : {"POLY:1", "POLY:1", "POLY:2"}) {
+        auto element = request(session);
+        REQUIRE(scheduler.enqueueSlow(element));
+    }
+
+    IncomingRequest first, second, next;
+    bool isSlowLane = false;
+
+    // the second POLY:1 request is parked behind the first one
+    REQUIRE(scheduler.dequeue(0, first, isSlowLane, 10));
+    REQUIRE(isSlowLane);
+    REQUIRE(scheduler.dequeue(1, second, isSlowLane, 10));
+    REQUIRE(first.session == "POLY:1");
+    REQUIRE(second.session == "POLY:2");
+    REQUIRE(!scheduler.dequeue(2, next, isSlowLane, 10));
+    REQUIRE(scheduler.getSlowParked() == 1);
+    REQUIRE(scheduler.getActiveSessions() == 2);
+
+    scheduler.slowLaneDone(first);
+    REQUIRE(scheduler.dequeue(2, next, isSlowLane, 10));
+    REQUIRE(next.session == "POLY:1");
+
+    scheduler.slowLaneDone(next);
+    scheduler.slowLaneDone(second);
+    REQUIRE(scheduler.getActiveSessions() == 0);
+    REQUIRE(scheduler.getSlowPending() == 0);
+
+    string polyName;
+    REQUIRE(ZMQMessage::scanPolyName("{\"type\":\"generateDKGPolyReq\",\"polyName\":\"POLY:1\",\"t\":1}", polyName));
+    REQUIRE(polyName == "POLY:1");
+    REQUIRE(!ZMQMessage::scanPolyName("{\"type\":\"getServerStatusReq\"}", polyName));
+}
+
+TEST_CASE("Sign requests stay on the NUMA node of the client", "[numa-scheduler]") {
+    // workers 0 and 1 on node 0, 2 and 3 on node 1
+    RequestScheduler scheduler(4, 2, 16, 16, 2);
+
+    REQUIRE(scheduler.getHomeQueue(0) == 0);
+    REQUIRE(scheduler.getHomeQueue(1) == 2);
+    REQUIRE(scheduler.getHomeQueue(2) == 1);
+    REQUIRE(scheduler.getHomeQueue(3) == 3);
+
+    auto request = [](const string &_name) {
+        IncomingRequest element;
+        element.msg = make_shared<string>(_name);
+        return element;
+    };
+
+    auto remote = request("remote");
+    REQUIRE(scheduler.enqueueSign(3, remote));
+    auto local = request("local");
+    REQUIRE(scheduler.enqueueSign(2, local));
+
+    // an idle worker steals from its own node first
+    IncomingRequest next;
+    bool isSlowLane = false;
+    REQUIRE(scheduler.dequeue(0, next, isSlowLane, 10));
+    REQUIRE(*next.msg == "local");
+    REQUIRE(scheduler.dequeue(0, next, isSlowLane, 10));
+    REQUIRE(*next.msg == "remote");
+}
+
+TEST_CASE("Autoscaled workers park and resume", "[worker-autoscale]") {
+    // activated in the order 0, 2, 1, 3
+    RequestScheduler scheduler(4, 2, 16, 16, 2);
+
+    scheduler.setActiveWorkers(2);
+    REQUIRE(scheduler.isWorkerActive(2));
+    REQUIRE(!scheduler.isWorkerActive(1));
+    REQUIRE(scheduler.getHomeQueue(2) == 0);
+    REQUIRE(scheduler.getHomeQueue(3) == 2);
+
+    auto element = IncomingRequest();
+    element.msg = make_shared<string>("sign");
+    REQUIRE(scheduler.enqueueSign(3, element));
+    scheduler.setActiveWorkers(1);
+
+    // parked workers take nothing, the active one steals the queue left behind
+    IncomingRequest next;
+    bool isSlowLane = false;
+    REQUIRE(!scheduler.dequeue(2, next, isSlowLane, 10));
+    REQUIRE(scheduler.getHomeQueue(1) == 0);
+    REQUIRE(scheduler.dequeue(0, next, isSlowLane, 10));
+    REQUIRE(*next.msg == "sign");
+
+    uint64_t quiet = 0;
+    REQUIRE(WorkerThreadPool::getTargetThreads(4, 2, 16, 8, 0, quiet) == 6);
+    REQUIRE(WorkerThreadPool::getTargetThreads(4, 2, 16, 0, ZMQ_AUTOSCALE_GROW_P99_US + 1, quiet) == 6);
+    REQUIRE(WorkerThreadPool::getTargetThreads(15, 2, 16, 30, 0, quiet) == 16);
+    for (uint64_t i = 1; i < ZMQ_AUTOSCALE_SHRINK_INTERVALS; i++) {
+        REQUIRE(WorkerThreadPool::getTargetThreads(4, 2, 16, 0, 0, quiet) == 4);
+    }
+    REQUIRE(WorkerThreadPool::getTargetThreads(4, 2, 16, 0, 0, quiet) == 3);
+    REQUIRE(quiet == 0);
+}
+
+TEST_CASE("Fair queuing and client rate limits", "[client-fairness]") {
+    FairQueue queue(100, 3, 8);
+
+    auto request = [](const string &_client) {
+        IncomingRequest element;
+        element.msg = make_shared<string>(_client + string(40, ' '));
+        return element;
+    };
+
+    // the noisy client gets no more than its backlog and does not delay the quiet one
+    for (int i = 0; i < 5; i++) {
+        auto element = request("noisy");
+        REQUIRE(queue.push("noisy", element) == (i < 3));
+    }
+    auto quiet = request("quiet");
+    REQUIRE(queue.push("quiet", quiet));
+    REQUIRE(queue.size() == 4);
+
+    vector<string> order;
+    IncomingRequest next;
+    while (queue.pop(next)) {
+        order.push_back(next.msg->substr(0, next.msg->find(' ')));
+    }
+    REQUIRE(order == vector<string>{"noisy", "noisy", "quiet", "noisy"});
+    REQUIRE(queue.size() == 0);
+
+    // a partition of weight 3 gets three times the share of a partition of weight 1
+    FairQueue partitioned(40, 100, 100);
+    for (int i = 0; i < 20; i++) {
+        auto heavy = request("heavy");
+        REQUIRE(partitioned.push("a", heavy, "SCHAIN:1", 1));
+        auto light = request("light");
+        REQUIRE(partitioned.push("b", light, "GROUP:vip", 3));
+    }
+    REQUIRE(partitioned.getNumPartitions() == 2);
+    uint64_t light = 0;
+    for (int i = 0; i < 8; i++) {
+        REQUIRE(partitioned.pop(next));
+        light += next.msg->rfind("light", 0) == 0;
+    }
+    REQUIRE(light == 6);
+
+    string schainId;
+    REQUIRE(ZMQMessage::scanSchainId(
+            "{\"keyShareName\":\"BLS_KEY:SCHAIN_ID:7:NODE_ID:1:DKG_ID:0\",\"type\":\"BLSSignReq\"}", schainId));
+    REQUIRE(schainId == "7");
+    REQUIRE(!ZMQMessage::scanSchainId("{\"keyName\":\"NEK:01\"}", schainId));
+
+    ClientRateLimiter limiter(2);
+    REQUIRE(limiter.tryAcquire("a"));
+    REQUIRE(limiter.tryAcquire("a"));
+    REQUIRE(!limiter.tryAcquire("a"));
+    REQUIRE(limiter.tryAcquire("b", 2));
+    REQUIRE(!limiter.tryAcquire("b"));
+
+    REQUIRE(JsonRpcBatchHandler::scanKeyName(
+            "{\"method\":\"ecdsaSignMessageHash\",\"params\":{\"keyName\" : \"NEK:01\"}}") == "NEK:01");
+    REQUIRE(JsonRpcBatchHandler::scanKeyName("{\"method\":\"getServerStatus\"}").empty());
+}
+
+TEST_CASE("Verified cert cache expiry", "[verified-cert-cache]") {
+    VerifiedCertCache cache(VerifiedCertCache::NUM_SHARDS);
+    auto handles = make_shared<const VerifiedCertCache::CertKeys>(EVP_PKEY_new(), X509_new());
+    auto now = (int64_t) time(nullptr);
+
+    cache.put("expired", handles, now - 1);
+    REQUIRE(!cache.get("expired"));
+    REQUIRE(!cache.exists("expired"));
+
+    cache.put("expired", handles, now + 60);
+    REQUIRE(cache.get("expired") == handles);
+
+    // a shard holds one entry, so the other certs of its shard evict each other
+    for (int i = 0; i < 100; i++) {
+        cache.put("cert" + to_string(i), make_shared<const VerifiedCertCache::CertKeys>(EVP_PKEY_new(), X509_new()),
+                  now + 60);
+    }
+    REQUIRE(cache.size() <= VerifiedCertCache::NUM_SHARDS);
+    REQUIRE(cache.getEvictions() >= 100 + 1 - VerifiedCertCache::NUM_SHARDS);
+
+    cache.clear();
+    REQUIRE(cache.size() == 0);
+    REQUIRE(!cache.exists("expired"));
+
+    REQUIRE_THROWS_AS(cache.setMaxSize(VerifiedCertCache::NUM_SHARDS - 1), SGXException);
+    REQUIRE(!CertVerifier::verifyFile(string(SGXDATA_FOLDER) + "cert_data/rootCA.pem", "/tmp/no_such_cert"));
+
+    // the cache no longer holds the handles, the test does
+    REQUIRE(handles.use_count() == 1);
+}
+
+TEST_CASE_METHOD(TestFixture, "multG2 batch", "[mult-g2-batch]") {
+    HttpClient client(RPC_ENDPOINT);
+    StubClient c(client, JSONRPC_CLIENT_V2);
+
+    Json::Value xs(Json::arrayValue);
+    for (auto &&x : {"0", "1", "2", "12345678901234567890", "0", "21888242871839275222246405745257275088548364400416034343698204186575808495616"}) {
+        xs.append(x);
+    }
+
+    auto batch = c.multG2Batch(xs);
+    REQUIRE(batch["status"] == 0);
+    REQUIRE(batch["x*G2"].size() == xs.size());
+
+    for (Json::ArrayIndex i = 0; i < xs.size(); i++) {
+        auto single = c.multG2(xs[i].asString());
+        REQUIRE(single["status"] == 0);
+        REQUIRE(batch["x*G2"][i] == single["x*G2"]);
+    }
+
+    Json::Value invalid(Json::arrayValue);
+    invalid.append("0x12");
+    REQUIRE(c.multG2Batch(invalid)["status"] != 0);
+    REQUIRE(c.multG2Batch(Json::Value(Json::arrayValue))["status"] != 0);
+}
+
+TEST_CASE("Hex codec and tokenizer", "[hex-codec]") {
+    for (uint64_t len = 0; len < 80; len++) {
+        vector<uint8_t> bin(len), decoded(len);
+        string expected;
+        for (uint64_t i = 0; i < len; i++) {
+            bin[i] = (uint8_t) (i * 73 + len);
+            expected += "0123456789abcdef"[bin[i] >> 4];
+            expected += "0123456789abcdef"[bin[i] & 0x0F];
+        }
+
+        auto hex = carray2Hex(bin.data(), len);
+        REQUIRE(string(hex.data()) == expected);
+
+        auto upper = expected;
+        transform(upper.begin(), upper.end(), upper.begin(), ::toupper);
+
+        uint64_t decodedLen = 0;
+        REQUIRE(hex2carray(upper.c_str(), &decodedLen, decoded.data(), len));
+        REQUIRE(decodedLen == len);
+        REQUIRE(decoded == bin);
+
+        for (uint64_t i = 0; i < 2 * len; i += 7) {
+            auto invalid = expected;
+            invalid[i] = 'g';
+            REQUIRE(!hex2carray(invalid.c_str(), &decodedLen, decoded.data(), len));
+        }
+    }
+
+    REQUIRE(splitString("::a:bc::d:", ':') == vector<string>({"a", "bc", "d"}));
+    REQUIRE(splitString("", ':').empty());
+}
+
 TEST_CASE_METHOD(TestFixture, "Import ECDSA Key", "[import-ecdsa-key]") {
     HttpClient client(RPC_ENDPOINT);
     StubClient c(client, JSONRPC_CLIENT_V2);
@@ -576,6 +1082,50 @@ TEST_CASE_METHOD(TestFixture, "Import ECDSA Key Zmq", "[import-ecdsa-key-zmq]")
     REQUIRE_NOTHROW(client->ecdsaSignMessageHash(16, name, SAMPLE_HASH));
 }
 
+TEST_CASE_METHOD(TestFixture, "Import key batches", "[import-key-batch]") {
+    HttpClient client(RPC_ENDPOINT);
+    StubClient c(client, JSONRPC_CLIENT_V2);
+
+    string key_str = "0xe632f7fde2c90a073ec43eaa90dca7b82476bf28815450a11191484934b9c3f";
+
+    Json::Value keys(Json::arrayValue);
+    for (auto &&name : {"NEK:abcdef01", "NEK:abcdef01", "NEK:abcdefg", "NEK:abcdef02"}) {
+        Json::Value key;
+        key["keyName"] = name;
+        key["key"] = key_str;
+        keys.append(key);
+    }
+    keys[3]["key"] = "1234x";
+
+    auto response = c.importECDSAKeyBatch(keys);
+    REQUIRE(response["status"] == 0);
+    REQUIRE(response["results"].size() == 4);
+    REQUIRE(response["results"][0]["status"] == 0);
+    REQUIRE(response["results"][1]["status"] == KEY_NAME_ALREADY_EXISTS);
+    REQUIRE(response["results"][2]["status"] == INVALID_ECDSA_IMPORT_KEY_NAME);
+    REQUIRE(response["results"][3]["status"] == INVALID_ECDSA_IMPORT_HEX);
+    REQUIRE(response["results"][0]["publicKey"] == c.getPublicECDSAKey("NEK:abcdef01")["publicKey"]);
+    REQUIRE(c.ecdsaSignMessageHash(16, "NEK:abcdef01", SAMPLE_HASH)["status"] == 0);
+
+    Json::Value keyShares(Json::arrayValue);
+    for (int i = 0; i < 3; i++) {
+        Json::Value share;
+        share["keyShareName"] = "BLS_KEY:SCHAIN_ID:123456791:NODE_ID:" + to_string(i) + ":DKG_ID:0";
+        share["keyShare"] = key_str;
+        keyShares.append(share);
+    }
+
+    response = c.importBLSKeyShareBatch(keyShares);
+    REQUIRE(response["status"] == 0);
+    for (int i = 0; i < 3; i++) {
+        REQUIRE(response["results"][i]["status"] == 0);
+        REQUIRE(c.blsSignMessageHash(keyShares[i]["keyShareName"].asString(), SAMPLE_HASH, 1, 1)["status"] == 0);
+    }
+    REQUIRE(c.importBLSKeyShareBatch(keyShares)["results"][0]["status"] == KEY_SHARE_ALREADY_EXISTS);
+
+    REQUIRE(c.importBLSKeyShareBatch(Json::Value(Json::arrayValue))["status"] == INVALID_KEY_IMPORT_BATCH);
+}
+
 TEST_CASE_METHOD(TestFixture, "Backup Key", "[backup-key]") {
     HttpClient client(RPC_ENDPOINT);
     StubClient c(client, JSONRPC_CLIENT_V2);
@@ -617,118 +1167,833 @@ TEST_CASE_METHOD(TestFixture, "Get ServerVersionZmq", "[get-server-version-zmq]"
     sleep(3);
 }
 
-TEST_CASE_METHOD(TestFixtureHTTPS, "Cert request sign", "[cert-sign]") {
-
-    PRINT_SRC_LINE
+TEST_CASE_METHOD(TestFixture, "LevelDB read cache is invalidated on writes", "[leveldb-cache]") {
+    auto db = LevelDB::getLevelDb();
+    string name = "TEST_CACHE_KEY";
 
-    REQUIRE_NOTHROW(SGXRegistrationServer::getServer());
+    db->writeString(name, "value1");
+    REQUIRE(*db->readString(name) == "value1");
+    REQUIRE(*db->readString(name) == "value1");
 
-    PRINT_SRC_LINE
+    auto hits = db->getCache().getHits();
 
-    string csrFile = "insecure-samples/yourdomain.csr";
+    REQUIRE(*db->readString(name) == "value1");
+    REQUIRE(db->getCache().getHits() == hits + 1);
 
-    ifstream infile(csrFile);
-    infile.exceptions(std::ifstream::failbit | std::ifstream::badbit);
-    ostringstream ss;
-    ss << infile.rdbuf();
-    infile.close();
+    db->writeString(name, "value2");
+    REQUIRE(*db->readString(name) == "value2");
 
-    PRINT_SRC_LINE
+    db->deleteKey(name);
+    REQUIRE(db->readString(name) == nullptr);
+}
 
-    auto result = SGXRegistrationServer::getServer()->SignCertificate(ss.str());
+TEST_CASE_METHOD(TestFixture, "LevelDB stores hex values as bytes", "[leveldb-binary-values]") {
+    auto db = LevelDB::getLevelDb();
+    string hex = "00ff10ab" + string(120, 'e');
 
-    REQUIRE(result["status"] == 0);
+    db->writeString("TEST_BINARY_KEY_1", hex);
+    db->writeString("TEST_BINARY_KEY_2", "00FF10AB");
+    REQUIRE(*db->readString("TEST_BINARY_KEY_1") == hex);
+    REQUIRE(*db->readString("TEST_BINARY_KEY_2") == "00FF10AB");
 
-    PRINT_SRC_LINE
-    result = SGXRegistrationServer::getServer()->SignCertificate("Haha");
+    auto page = db->getKeysPage("TEST_BINARY_KEY_", "", 2);
+    REQUIRE(page.size() == 2);
+    REQUIRE(page.at(0).second.size() == 1 + sizeof(uint64_t) + hex.size() / 2);
+    REQUIRE(LevelDB::decodeValue(page.at(0).second) == hex);
+    REQUIRE(db->getLatestCreatedKey().first.rfind("TEST_BINARY_KEY_", 0) == 0);
 
-    REQUIRE(result["status"] != 0);
+    db->deleteKeys({"TEST_BINARY_KEY_1", "TEST_BINARY_KEY_2"});
 }
 
-TEST_CASE_METHOD(TestFixture, "DKG API V2 test", "[dkg-api-v2]") {
-    HttpClient client(RPC_ENDPOINT);
-    StubClient c(client, JSONRPC_CLIENT_V2);
+TEST_CASE_METHOD(TestFixture, "LevelDB batch writes are atomic", "[leveldb-batch]") {
+    auto db = LevelDB::getLevelDb();
 
-    string polyName = SAMPLE_POLY_NAME;
+    db->writeBatchUnique({{"TEST_BATCH_KEY_1", "value1"}, {"TEST_BATCH_KEY_2", "value2"}});
+    REQUIRE(*db->readString("TEST_BATCH_KEY_1") == "value1");
+    REQUIRE(*db->readString("TEST_BATCH_KEY_2") == "value2");
 
-    PRINT_SRC_LINE
-    Json::Value genPoly = c.generateDKGPoly(polyName, 2);
-    REQUIRE(genPoly["status"].asInt() == 0);
+    REQUIRE_THROWS_AS(db->writeBatchUnique({{"TEST_BATCH_KEY_3", "value3"}, {"TEST_BATCH_KEY_1", "value1"}}),
+                      SGXException);
+    REQUIRE(db->readString("TEST_BATCH_KEY_3") == nullptr);
 
-    Json::Value publicKeys;
-    publicKeys.append(SAMPLE_DKG_PUB_KEY_1);
-    publicKeys.append(SAMPLE_DKG_PUB_KEY_2);
+    db->writeBatchUnique({{"TEST_BATCH_KEY_3", "value3"}}, {"TEST_BATCH_KEY_1", "TEST_BATCH_KEY_2"});
+    REQUIRE(db->readString("TEST_BATCH_KEY_1") == nullptr);
+    REQUIRE(db->readString("TEST_BATCH_KEY_2") == nullptr);
+    REQUIRE(*db->readString("TEST_BATCH_KEY_3") == "value3");
 
-    // wrongName
-    Json::Value genPolyWrongName = c.generateDKGPoly("poly", 2);
-    REQUIRE(genPolyWrongName["status"].asInt() != 0);
+    db->deleteKeys({"TEST_BATCH_KEY_3"});
+    REQUIRE(db->readString("TEST_BATCH_KEY_3") == nullptr);
+}
 
-    Json::Value verifVectWrongName = c.getVerificationVector("poly", 2);
-    REQUIRE(verifVectWrongName["status"].asInt() != 0);
+TEST_CASE_METHOD(TestFixture, "Mapped store survives reopen and compaction", "[mapped-store]") {
+    string fileName = "/tmp/sgxwallet_test_mapped_store";
+    remove(fileName.c_str());
+
+    {
+        MappedStore store(fileName);
+        KeyValueStore::Batch batch;
+        batch.put("TEST_MAPPED_KEY_1", "value1");
+        batch.put("TEST_MAPPED_KEY_2", "value2");
+        batch.put("TEST_MAPPED_KEY_3", "value3");
+        store.write(batch);
+
+        KeyValueStore::Batch deletes;
+        deletes.del("TEST_MAPPED_KEY_2");
+        store.write(deletes);
+    }
 
-    Json::Value secretSharesWrongName = c.getSecretShareV2("poly", publicKeys, 2, 2);
-    REQUIRE(secretSharesWrongName["status"].asInt() != 0);
+    MappedStore store(fileName);
+    string value;
+    REQUIRE(store.get("TEST_MAPPED_KEY_1", value));
+    REQUIRE(value == "value1");
+    REQUIRE(!store.get("TEST_MAPPED_KEY_2", value));
+    REQUIRE(store.getNumKeys() == 2);
+
+    string last;
+    REQUIRE(store.findLast("TEST_MAPPED_KEY_3", last));
+    REQUIRE(last == "TEST_MAPPED_KEY_1");
+
+    auto sizeBefore = store.getApproximateSize();
+    store.compact();
+    REQUIRE(store.getApproximateSize() < sizeBefore);
+
+    vector<string> keys;
+    store.scan("TEST_MAPPED_KEY_", [&keys](string_view _key, string_view) {
+        keys.emplace_back(_key);
+        return true;
+    });
+    REQUIRE(keys == vector<string>{"TEST_MAPPED_KEY_1", "TEST_MAPPED_KEY_3"});
+
+    remove(fileName.c_str());
+}
 
-    // wrong_t
-    Json::Value genPolyWrong_t = c.generateDKGPoly(polyName, 33);
-    REQUIRE(genPolyWrong_t["status"].asInt() != 0);
+TEST_CASE_METHOD(TestFixture, "Concurrent key writes share disk syncs", "[leveldb-group-commit]") {
+    auto db = LevelDB::getLevelDb();
+    auto syncsBefore = Metrics::getCounter("leveldbSyncs").get();
+    auto writesBefore = Metrics::getCounter("leveldbSyncedWrites").get();
 
-    Json::Value verifVectWrong_t = c.getVerificationVector(polyName, 1);
-    REQUIRE(verifVectWrong_t["status"].asInt() != 0);
+    vector<thread> threads;
+    for (int i = 0; i < 16; i++) {
+        threads.emplace_back([db, i]() {
+            for (int j = 0; j < 20; j++) {
+                db->writeDataUnique("TEST_GROUP_COMMIT_KEY_" + to_string(i) + "_" + to_string(j), "value");
+            }
+        });
+    }
 
-    Json::Value secretSharesWrong_t = c.getSecretShareV2(polyName, publicKeys, 3, 3);
-    REQUIRE(secretSharesWrong_t["status"].asInt() != 0);
+    for (auto &&t: threads) {
+        t.join();
+    }
 
-    Json::Value publicKeys1;
-    publicKeys1.append(SAMPLE_DKG_PUB_KEY_1);
-    Json::Value secretSharesWrong_n = c.getSecretShareV2(polyName, publicKeys1, 2, 1);
-    REQUIRE(secretSharesWrong_n["status"].asInt() != 0);
+    auto syncs = Metrics::getCounter("leveldbSyncs").get() - syncsBefore;
+    REQUIRE(Metrics::getCounter("leveldbSyncedWrites").get() - writesBefore >= 320);
+    REQUIRE(syncs > 0);
+    REQUIRE(syncs < 320);
 
-    //wrong number of publicKeys
-    Json::Value secretSharesWrongPkeys = c.getSecretShareV2(polyName, publicKeys, 2, 3);
-    REQUIRE(secretSharesWrongPkeys["status"].asInt() != 0);
+    vector<string> keys;
+    for (int i = 0; i < 16; i++) {
+        for (int j = 0; j < 20; j++) {
+            keys.push_back("TEST_GROUP_COMMIT_KEY_" + to_string(i) + "_" + to_string(j));
+        }
+    }
+    db->deleteKeys(keys);
+}
 
-    //wrong verif
-    Json::Value Skeys = c.getSecretShareV2(polyName, publicKeys, 2, 2);
-    REQUIRE_NOTHROW(c.getSecretShare(polyName, publicKeys, 2, 2));
-    REQUIRE(Skeys == c.getSecretShare(polyName, publicKeys, 2, 2));
+TEST_CASE_METHOD(TestFixture, "LevelDB creation time index and paged listing", "[leveldb-index]") {
+    auto db = LevelDB::getLevelDb();
 
-    Json::Value verifVect = c.getVerificationVector(polyName, 2);
-    REQUIRE_NOTHROW(c.getVerificationVector(polyName, 2));
-    REQUIRE(verifVect == c.getVerificationVector(polyName, 2));
+    db->writeString("TEST_INDEX_KEY_1", "value1");
+    sleep(1);
+    db->writeString("TEST_INDEX_KEY_2", "value2");
+    REQUIRE(db->getLatestCreatedKey().first == "TEST_INDEX_KEY_2");
 
-    Json::Value verificationWrongSkeys = c.dkgVerificationV2("", "", "", 2, 2, 1);
-    REQUIRE(verificationWrongSkeys["status"].asInt() != 0);
+    auto page = db->getKeysPage("TEST_INDEX_KEY_", "", 1);
+    REQUIRE(page.size() == 1);
+    REQUIRE(page.at(0).first == "TEST_INDEX_KEY_1");
+    page = db->getKeysPage("TEST_INDEX_KEY_", page.at(0).first, 10);
+    REQUIRE(page.size() == 1);
+    REQUIRE(page.at(0).first == "TEST_INDEX_KEY_2");
+
+    REQUIRE(db->getAllKeys().first.str().find(INDEX_NAMESPACE_PREFIX) == string::npos);
+
+    db->deleteKey("TEST_INDEX_KEY_2");
+    REQUIRE(db->getLatestCreatedKey().first != "TEST_INDEX_KEY_2");
+    db->deleteKey("TEST_INDEX_KEY_1");
 }
 
-TEST_CASE_METHOD(TestFixture, "DKG API V2 ZMQ test", "[dkg-api-v2-zmq]") {
-    auto client = make_shared<ZMQClient>(ZMQ_IP, ZMQ_PORT, true, "./sgx_data/cert_data/rootCA.pem",
-                                         "./sgx_data/cert_data/rootCA.key");
+// in memory store whose writes can be made to fail
+class TestStore : public KeyValueStore {
+public:
+    map<string, string> values;
+    bool failWrites = false;
 
-    string polyName = SAMPLE_POLY_NAME;
+    bool get(const string &_key, string &_value) override {
+        auto it = values.find(_key);
+        if (it == values.end()) {
+            return false;
+        }
+        _value = it->second;
+        return true;
+    }
 
-    PRINT_SRC_LINE
-    REQUIRE(client->generateDKGPoly(polyName, 2));
+    vector<shared_ptr<string>> getMany(const vector<string> &_keys) override {
+        vector<shared_ptr<string>> result;
+        for (auto &&key : _keys) {
+            string value;
+            result.push_back(get(key, value) ? make_shared<string>(value) : nullptr);
+        }
+        return result;
+    }
 
-    Json::Value publicKeys;
-    publicKeys.append(SAMPLE_DKG_PUB_KEY_1);
-    publicKeys.append(SAMPLE_DKG_PUB_KEY_2);
+    void write(const Batch &_batch) override {
+        if (failWrites) {
+            throw SGXException(COULD_NOT_ACCESS_DATABASE, "Test write failure");
+        }
+        for (auto &&op : _batch.getOps()) {
+            if (op.isDelete) {
+                values.erase(op.key);
+            } else {
+                values[op.key] = op.value;
+            }
+        }
+    }
 
-    // wrongName
-    REQUIRE(!client->generateDKGPoly("poly", 2));
+    void sync() override {}
 
-    REQUIRE_THROWS(client->getVerificationVector("poly", 2));
+    void scan(const string &_from, const Visitor &_visitor) override {
+        for (auto it = values.lower_bound(_from); it != values.end() && _visitor(it->first, it->second); it++);
+    }
 
-    REQUIRE_THROWS(client->getSecretShare("poly", publicKeys, 2, 2));
+    bool findLast(const string &, string &) override { return false; }
 
-    // wrong_t
-    REQUIRE(!client->generateDKGPoly(polyName, 33));
+    uint64_t getApproximateSize() override { return 0; }
 
-    REQUIRE_THROWS(client->getVerificationVector(polyName, 0));
+    void compact() override {}
+};
 
-    REQUIRE_THROWS(client->getSecretShare(polyName, publicKeys, 3, 3));
+TEST_CASE("Partitioned store writes puts before cross store deletes", "[partitioned-store]") {
+    auto hotStore = new TestStore();
+    auto coldStore = new TestStore();
+    PartitionedStore store(unique_ptr<KeyValueStore>(hotStore), unique_ptr<KeyValueStore>(coldStore),
+                           [](string_view _key) { return _key.rfind("DKG_", 0) == 0; });
+
+    coldStore->values["DKG_TEMP_1"] = "temp1";
+    coldStore->values["DKG_TEMP_2"] = "temp2";
+
+    // like createBLSShare, the key share goes to the hot store and the intermediates are deleted
+    KeyValueStore::Batch batch;
+    batch.del("DKG_TEMP_1");
+    batch.put("BLS_KEY_1", "share");
+    batch.del("DKG_TEMP_2");
+
+    hotStore->failWrites = true;
+    REQUIRE_THROWS(store.write(batch));
+    REQUIRE(coldStore->values.size() == 2);
+    REQUIRE(hotStore->values.empty());
+
+    hotStore->failWrites = false;
+    store.write(batch);
+    REQUIRE(coldStore->values.empty());
+    REQUIRE(hotStore->values["BLS_KEY_1"] == "share");
+}
 
-    Json::Value publicKeys1;
+TEST_CASE_METHOD(TestFixture, "Follower copies the key store of the leader", "[key-store-replication]") {
+    auto db = LevelDB::getLevelDb();
+    db->writeString("TEST_REPLICA_KEY_1", "value1");
+    db->writeString("TEST_REPLICA_KEY_2", "value2");
+
+    string nextCursor;
+    auto page = db->getKeysCreatedSince(LevelDB::creationTimeCursor(time(nullptr) - 10), 1000, nextCursor);
+    vector<string> names;
+    for (auto &&entry : page) {
+        names.push_back(entry.first);
+    }
+    REQUIRE(find(names.begin(), names.end(), "TEST_REPLICA_KEY_1") != names.end());
+    REQUIRE(find(names.begin(), names.end(), "TEST_REPLICA_KEY_2") != names.end());
+
+    REQUIRE(!KeyStoreReplicator::isReplicatedKey("SEK"));
+    REQUIRE(KeyStoreReplicator::isReplicatedKey("NEK:01"));
+
+    // this server is its own leader, so every key is already there and nothing is written
+    string cursor;
+    REQUIRE(KeyStoreReplicator::syncOnce("http://localhost:" + to_string(BASE_PORT + 4), cursor) == 0);
+    REQUIRE(cursor.rfind(CREATION_TIME_INDEX_PREFIX, 0) == 0);
+
+    db->deleteKeys({"TEST_REPLICA_KEY_1", "TEST_REPLICA_KEY_2"});
+}
+
+TEST_CASE_METHOD(TestFixture, "Follower takes key owners from the leader", "[key-store-replication-owners]") {
+    auto ownedKey = SGXWalletServer::generateECDSAKeyImpl();
+    REQUIRE(ownedKey["status"] == 0);
+    auto ownedName = ownedKey["keyName"].asString();
+    auto unownedKey = SGXWalletServer::generateECDSAKeyImpl();
+    REQUIRE(unownedKey["status"] == 0);
+    auto unownedName = unownedKey["keyName"].asString();
+
+    // the ZMQ server has loaded the owners already, as on a follower that started earlier
+    KeyStoreReplicator::setLeaderHost("localhost");
+
+    auto ownerKeyName = KeyOwnerIndex::getOwnerKeyName(ownedName);
+    auto otherClient = cryptlite::sha256::hash_hex(string("another client"));
+    REQUIRE(KeyStoreReplicator::importEntries({make_tuple(ownerKeyName, otherClient, to_string(time(nullptr)))}) == 1);
+
+    auto client = make_shared<ZMQClient>(ZMQ_IP, ZMQ_PORT, true, "./sgx_data/cert_data/rootCA.pem",
+                                         "./sgx_data/cert_data/rootCA.key");
+    REQUIRE_THROWS(client->ecdsaSignMessageHash(16, ownedName, SAMPLE_HASH));
+    REQUIRE(*LevelDB::getLevelDb()->readString(ownerKeyName) == otherClient);
+
+    // a key whose owner record has not arrived yet is not claimed by the first client
+    REQUIRE_THROWS(client->ecdsaSignMessageHash(16, unownedName, SAMPLE_HASH));
+    REQUIRE(LevelDB::getLevelDb()->readString(KeyOwnerIndex::getOwnerKeyName(unownedName)) == nullptr);
+
+    KeyStoreReplicator::setLeaderHost("");
+}
+
+TEST_CASE_METHOD(TestFixture, "Info server returns keys in pages", "[info-keys-page]") {
+    auto db = LevelDB::getLevelDb();
+    for (int i = 0; i < 5; i++) {
+        db->writeString("TEST_PAGE_KEY_" + to_string(i), "value" + to_string(i));
+    }
+
+    auto server = SGXInfoServer::getServer();
+    REQUIRE(server->getKeysPage("TEST_PAGE_KEY_", "", 0)["status"] == INVALID_KEYS_PAGE_LIMIT);
+
+    vector<string> names;
+    string cursor;
+    do {
+        auto page = server->getKeysPage("TEST_PAGE_KEY_", cursor, 2);
+        REQUIRE(page["status"] == 0);
+        REQUIRE(page["keys"].size() <= 2);
+        for (auto &&key : page["keys"]) {
+            names.push_back(key["keyName"].asString());
+        }
+        cursor = page["nextCursor"].asString();
+    } while (!cursor.empty());
+
+    REQUIRE(names.size() == 5);
+    REQUIRE(names.front() == "TEST_PAGE_KEY_0");
+    REQUIRE(names.back() == "TEST_PAGE_KEY_4");
+
+    for (int i = 0; i < 5; i++) {
+        db->deleteKey("TEST_PAGE_KEY_" + to_string(i));
+    }
+}
+
+TEST_CASE_METHOD(TestFixture, "Info server checks keys in batches", "[info-keys-batch]") {
+    auto db = LevelDB::getLevelDb();
+    db->writeString("TEST_BATCH_KEY_0", "value0");
+    db->writeString("POLY:SCHAIN_ID:1:NODE_ID:1:DKG_ID:TEST_BATCH", "value1");
+
+    auto server = SGXInfoServer::getServer();
+    REQUIRE(server->areKeysExist(Json::Value(Json::arrayValue))["status"] == INVALID_KEY_NAMES_BATCH);
+
+    Json::Value names(Json::arrayValue);
+    names.append("TEST_BATCH_KEY_0");
+    names.append("TEST_BATCH_KEY_MISSING");
+    names.append("POLY:SCHAIN_ID:1:NODE_ID:1:DKG_ID:TEST_BATCH");
+
+    auto exist = server->areKeysExist(names);
+    REQUIRE(exist["status"] == 0);
+    REQUIRE(exist["isExist"].size() == 3);
+    REQUIRE(exist["isExist"][0].asBool());
+    REQUIRE(!exist["isExist"][1].asBool());
+    REQUIRE(exist["isExist"][2].asBool());
+
+    auto metadata = server->getKeysMetadata(names);
+    REQUIRE(metadata["status"] == 0);
+    REQUIRE(metadata["keys"][0]["keyName"] == "TEST_BATCH_KEY_0");
+    REQUIRE(!metadata["keys"][0]["creationTime"].asString().empty());
+    REQUIRE(!metadata["keys"][1]["isExist"].asBool());
+    REQUIRE(metadata["keys"][1]["creationTime"].asString().empty());
+
+    db->deleteKeys({"TEST_BATCH_KEY_0", "POLY:SCHAIN_ID:1:NODE_ID:1:DKG_ID:TEST_BATCH"});
+}
+
+TEST_CASE_METHOD(TestFixture, "Info server reports readiness", "[readiness]") {
+    auto status = SGXInfoServer::getServer()->getReadiness();
+    REQUIRE(status["status"] == 0);
+    REQUIRE(status["state"] == "ready");
+    REQUIRE(status["ready"].asBool());
+    REQUIRE(status.isMember("zmqSignQueueDepth"));
+
+    Readiness::setState(Readiness::DRAINING);
+    REQUIRE(!Readiness::isReady());
+    REQUIRE(Readiness::getStatus()["state"] == "draining");
+    Readiness::setState(Readiness::READY);
+}
+
+TEST_CASE_METHOD(TestFixture, "Info server takes CPU profiles", "[cpu-profile]") {
+    auto server = SGXInfoServer::getServer();
+    REQUIRE(server->getCpuProfile(1)["status"] == INVALID_PROFILE_REQUEST);
+
+    Profiler::setEnabled(true);
+    REQUIRE(server->getCpuProfile(0)["status"] == INVALID_PROFILE_REQUEST);
+
+    // the CPU timer only fires while the process is busy
+    atomic<bool> done(false);
+    thread busy([&]() {
+        while (!done) {
+            SGXWalletServer::getServerStatusImpl();
+        }
+    });
+
+    auto profile = server->getCpuProfile(1);
+    done = true;
+    busy.join();
+    Profiler::setEnabled(false);
+
+    REQUIRE(profile["status"] == 0);
+    REQUIRE(profile["samples"].asUInt64() > 0);
+    REQUIRE(!profile["folded"].asString().empty());
+    REQUIRE(profile["ecalls"].isArray());
+}
+
+TEST_CASE("Scratch buffers are zeroed and reused", "[scratch-buffer]") {
+    {
+        ScratchBuffer warm(BUF_LEN);
+        strncpy(warm.data(), "not zero", BUF_LEN);
+    }
+
+    auto allocations = Allocations::getThreadCount();
+    for (int i = 0; i < 100; i++) {
+        ScratchBuffer errMsg(BUF_LEN);
+        REQUIRE(errMsg.size() == BUF_LEN);
+        REQUIRE(errMsg.data()[0] == 0);
+        errMsg.data()[0] = 'x';
+    }
+    REQUIRE(Allocations::getThreadCount() == allocations);
+}
+
+TEST_CASE("Perf counters add up per stage", "[perf-counters]") {
+    PerfCounterValues values;
+    PerfCounters::setEnabled(true);
+    if (!PerfCounters::read(values)) {
+        PerfCounters::setEnabled(false);
+        WARN("perf counters are not available");
+        return;
+    }
+
+    auto &stage = Metrics::getPerfStage("testPerfStage");
+    auto calls = stage.calls.get();
+    auto instructions = stage.instructions.get();
+    {
+        PERF_STAGE("testPerfStage")
+        SGXWalletServer::getServerStatusImpl();
+    }
+    PerfCounters::setEnabled(false);
+
+    REQUIRE(stage.calls.get() == calls + 1);
+    REQUIRE(stage.instructions.get() > instructions);
+
+    // counting is off, the scope does not add
+    {
+        PERF_STAGE("testPerfStage")
+    }
+    REQUIRE(stage.calls.get() == calls + 1);
+}
+
+TEST_CASE("Memory budget shrinks consumers under pressure", "[memory-budget]") {
+    LevelDBCache cache(LEVELDB_CACHE_MAX_ENTRIES, LEVELDB_CACHE_MAX_BYTES);
+    for (int i = 0; i < 100; i++) {
+        auto key = "TEST_BUDGET_KEY_" + to_string(i);
+        cache.put(key, string(1000, 'a'), cache.getGeneration(key));
+    }
+
+    MemoryBudget::addConsumer("testCache", [&]() { return cache.sizeInBytes(); }, [&]() { cache.trim(0); });
+
+    // budget of 500 bytes, pressure above 400
+    MemoryBudget::update(300, 1000);
+    REQUIRE(!MemoryBudget::isUnderPressure());
+    REQUIRE(cache.size() == 100);
+    REQUIRE(MemoryBudget::getConsumerBytes()["testCache"] == cache.sizeInBytes());
+
+    MemoryBudget::update(450, 1000);
+    REQUIRE(MemoryBudget::isUnderPressure());
+    REQUIRE(cache.size() == 0);
+
+    MemoryBudget::update(300, 1000);
+    REQUIRE(!MemoryBudget::isUnderPressure());
+
+    MemoryBudget::addConsumer("testCache", []() { return 0; }, []() {});
+}
+
+TEST_CASE_METHOD(TestFixture, "Latency objective defers low priority work", "[latency-slo]") {
+    LatencySLO::setTargetMs(20);
+    LatencySLO::update();
+    REQUIRE(!LatencySLO::isAtRisk());
+
+    for (int i = 0; i < 200; i++) {
+        LatencySLO::getSignLatency().observeUs(50000);
+    }
+    LatencySLO::update();
+    REQUIRE(LatencySLO::isAtRisk());
+    REQUIRE(LatencySLO::getP99Us() >= 20000);
+    REQUIRE(LatencySLO::getBurnRate() > 1);
+
+    auto shed = LatencySLO::getShed();
+    REQUIRE(SGXInfoServer::getServer()->getKeysPage("TEST_PAGE_KEY_", "", 2)["status"] == SLO_SHED);
+    REQUIRE(LatencySLO::getShed() == shed + 1);
+    REQUIRE(LatencySLO::deferBackgroundWork("test"));
+
+    LatencySLO::setTargetMs(0);
+    REQUIRE(!LatencySLO::isAtRisk());
+    REQUIRE(SGXInfoServer::getServer()->getKeysPage("TEST_PAGE_KEY_", "", 2)["status"] == 0);
+}
+
+TEST_CASE_METHOD(TestFixture, "DKG garbage collection removes stale intermediates", "[dkg-gc]") {
+    string polyName = "POLY:SCHAIN_ID:1:NODE_ID:1:DKG_ID:100";
+    REQUIRE(SGXWalletServer::generateDKGPolyImpl(polyName, 2)["status"] == 0);
+    auto ecdsaKey = SGXWalletServer::generateECDSAKeyImpl();
+    REQUIRE(ecdsaKey["status"] == 0);
+
+    auto db = LevelDB::getLevelDb();
+    REQUIRE(db->readString(polyName) != nullptr);
+
+    REQUIRE(DKGGarbageCollector::collect(time(nullptr) + 10) >= 1);
+    REQUIRE(db->readString(polyName) == nullptr);
+    REQUIRE(db->readString(ecdsaKey["keyName"].asString()) != nullptr);
+}
+
+TEST_CASE_METHOD(TestFixture, "Online SEK rotation reseals keys", "[sek-rotation]") {
+    auto ecdsaKey = SGXWalletServer::generateECDSAKeyImpl();
+    REQUIRE(ecdsaKey["status"] == 0);
+    auto keyName = ecdsaKey["keyName"].asString();
+
+    auto db = LevelDB::getLevelDb();
+    auto sealed = db->readString(keyName);
+    REQUIRE(sealed);
+
+    auto handle = SGXWalletServer::openKeyImpl(keyName);
+    REQUIRE(handle["status"] == 0);
+    auto keyHandle = handle["keyHandle"].asString();
+    REQUIRE(SGXWalletServer::ecdsaSignMessageHashByHandleImpl(16, keyHandle, SAMPLE_HASH)["status"] == 0);
+
+    auto server = SGXInfoServer::getServer();
+    REQUIRE(server->startSEKRotation()["status"] == 0);
+    REQUIRE(server->startSEKRotation()["status"] == SEK_ROTATION_IN_PROGRESS);
+
+    // keys under both SEKs are served while the rotation runs
+    REQUIRE(SGXWalletServer::ecdsaSignMessageHashImpl(16, keyName, SAMPLE_HASH)["status"] == 0);
+
+    for (int i = 0; i < 600 && SEKRotation::isInProgress(); i++) {
+        usleep(100 * 1000);
+    }
+
+    REQUIRE(!SEKRotation::isInProgress());
+    REQUIRE(db->readString("SEK_NEXT") == nullptr);
+    REQUIRE(*db->readString(keyName) != *sealed);
+    REQUIRE(server->getSEKRotationStatus()["valuesResealed"].asUInt64() >= 2);
+    REQUIRE(SGXWalletServer::ecdsaSignMessageHashImpl(16, keyName, SAMPLE_HASH)["status"] == 0);
+
+    // the handle held the key under the previous SEK, so it is closed and has to be opened again
+    REQUIRE(SGXWalletServer::ecdsaSignMessageHashByHandleImpl(16, keyHandle, SAMPLE_HASH)["status"] ==
+            INVALID_KEY_HANDLE);
+    keyHandle = SGXWalletServer::openKeyImpl(keyName)["keyHandle"].asString();
+    REQUIRE(SGXWalletServer::ecdsaSignMessageHashByHandleImpl(16, keyHandle, SAMPLE_HASH)["status"] == 0);
+}
+
+TEST_CASE_METHOD(TestFixture, "LevelDB concurrent reads and unique writes", "[leveldb-read-perf]") {
+    auto db = LevelDB::getLevelDb();
+    int numKeys = 1000;
+    int readsPerThread = 100000;
+
+    for (int i = 0; i < numKeys; i++) {
+        db->writeString("TEST_READ_PERF_KEY:" + to_string(i), string(1024, 'a'));
+    }
+
+    for (int numThreads : {1, 4, 16}) {
+        vector<thread> readers;
+        auto begin = chrono::steady_clock::now();
+        for (int j = 0; j < numThreads; j++) {
+            readers.push_back(thread([db, j, numKeys, readsPerThread]() {
+                for (int i = 0; i < readsPerThread; i++) {
+                    CHECK_STATE(db->readString("TEST_READ_PERF_KEY:" + to_string((i + j) % numKeys)));
+                }
+            }));
+        }
+        for (auto &t : readers) {
+            t.join();
+        }
+        auto ms = chrono::duration_cast<chrono::milliseconds>(chrono::steady_clock::now() - begin).count();
+        cerr << numThreads << " threads: " << (uint64_t) numThreads * readsPerThread << " reads in " << ms << " ms"
+             << endl;
+    }
+
+    string uniqueName = "TEST_UNIQUE_WRITE_KEY";
+    db->deleteKey(uniqueName);
+    atomic<int> successes(0);
+    vector<thread> writers;
+    for (int j = 0; j < 16; j++) {
+        writers.push_back(thread([db, &uniqueName, &successes]() {
+            try {
+                db->writeDataUnique(uniqueName, "value");
+                successes++;
+            } catch (SGXException &e) {
+            }
+        }));
+    }
+    for (auto &t : writers) {
+        t.join();
+    }
+    REQUIRE(successes == 1);
+
+    db->deleteKey(uniqueName);
+    for (int i = 0; i < numKeys; i++) {
+        db->deleteKey("TEST_READ_PERF_KEY:" + to_string(i));
+    }
+}
+
+TEST_CASE_METHOD(TestFixtureHTTPS, "Cert request sign", "[cert-sign]") {
+
+    PRINT_SRC_LINE
+
+    REQUIRE_NOTHROW(SGXRegistrationServer::getServer());
+
+    PRINT_SRC_LINE
+
+    string csrFile = "insecure-samples/yourdomain.csr";
+
+    ifstream infile(csrFile);
+    infile.exceptions(std::ifstream::failbit | std::ifstream::badbit);
+    ostringstream ss;
+    ss << infile.rdbuf();
+    infile.close();
+
+    PRINT_SRC_LINE
+
+    auto result = SGXRegistrationServer::getServer()->SignCertificate(ss.str());
+
+    REQUIRE(result["status"] == 0);
+
+    // the fixture signs automatically, the cert is in the CSR status db at once
+    auto certResult = SGXRegistrationServer::getServer()->GetCertificate(result["hash"].asString());
+    REQUIRE(certResult["status"] == 0);
+
+    string certFile = "/tmp/sgx_wallet_test_cert.crt";
+    ofstream outfile(certFile);
+    outfile << certResult["cert"].asString();
+    outfile.close();
+    REQUIRE(CertVerifier::verifyFile(string(SGXDATA_FOLDER) + "cert_data/rootCA.pem", certFile));
+    remove(certFile.c_str());
+
+    PRINT_SRC_LINE
+    result = SGXRegistrationServer::getServer()->SignCertificate("Haha");
+
+    REQUIRE(result["status"] != 0);
+}
+
+// writes a CRL of the test root CA that revokes _certPem
+void writeTestCRL(const string &_certPem, const string &_crlPath) {
+    string certData = string(SGXDATA_FOLDER) + "cert_data/";
+
+    auto fp = fopen((certData + "rootCA.pem").c_str(), "r");
+    REQUIRE(fp);
+    auto ca = PEM_read_X509(fp, nullptr, nullptr, nullptr);
+    fclose(fp);
+
+    fp = fopen((certData + "rootCA.key").c_str(), "r");
+    REQUIRE(fp);
+    auto caKey = PEM_read_PrivateKey(fp, nullptr, nullptr, nullptr);
+    fclose(fp);
+
+    auto bio = BIO_new_mem_buf(_certPem.data(), _certPem.size());
+    auto cert = PEM_read_bio_X509(bio, nullptr, nullptr, nullptr);
+    BIO_free(bio);
+
+    REQUIRE(ca);
+    REQUIRE(caKey);
+    REQUIRE(cert);
+
+    auto lastUpdate = X509_gmtime_adj(ASN1_TIME_new(), -60);
+    auto nextUpdate = X509_gmtime_adj(ASN1_TIME_new(), 3600);
+
+    auto crl = X509_CRL_new();
+    X509_CRL_set_version(crl, 1);
+    X509_CRL_set_issuer_name(crl, X509_get_subject_name(ca));
+    X509_CRL_set1_lastUpdate(crl, lastUpdate);
+    X509_CRL_set1_nextUpdate(crl, nextUpdate);
+
+    auto revoked = X509_REVOKED_new();
+    X509_REVOKED_set_serialNumber(revoked, X509_get_serialNumber(cert));
+    X509_REVOKED_set_revocationDate(revoked, lastUpdate);
+    X509_CRL_add0_revoked(crl, revoked);
+    X509_CRL_sort(crl);
+    REQUIRE(X509_CRL_sign(crl, caKey, EVP_sha256()) > 0);
+
+    fp = fopen(_crlPath.c_str(), "w");
+    REQUIRE(fp);
+    REQUIRE(PEM_write_X509_CRL(fp, crl) == 1);
+    fclose(fp);
+
+    X509_CRL_free(crl);
+    ASN1_TIME_free(lastUpdate);
+    ASN1_TIME_free(nextUpdate);
+    X509_free(cert);
+    EVP_PKEY_free(caKey);
+    X509_free(ca);
+}
+
+TEST_CASE_METHOD(TestFixtureHTTPS, "Revoked cert is refused on all ZMQ auth paths", "[zmq-cert-revocation]") {
+    string caFile = string(SGXDATA_FOLDER) + "cert_data/rootCA.pem";
+    string crlFile = string(SGXDATA_FOLDER) + "cert_data/rootCA.crl";
+
+    ifstream infile("insecure-samples/yourdomain.csr");
+    infile.exceptions(std::ifstream::failbit | std::ifstream::badbit);
+    ostringstream ss;
+    ss << infile.rdbuf();
+    infile.close();
+
+    auto result = SGXRegistrationServer::getServer()->SignCertificate(ss.str());
+    REQUIRE(result["status"] == 0);
+    auto certResult = SGXRegistrationServer::getServer()->GetCertificate(result["hash"].asString());
+    REQUIRE(certResult["status"] == 0);
+    string cert = certResult["cert"].asString();
+
+    string certFile = "/tmp/sgx_wallet_revoked_cert.crt";
+    ofstream outfile(certFile);
+    outfile << cert;
+    outfile.close();
+
+    // sessions are on by default, so this request opens one
+    auto client = make_shared<ZMQClient>(ZMQ_IP, ZMQ_PORT, true, certFile, "insecure-samples/yourdomain.key");
+    REQUIRE_NOTHROW(client->getServerStatus());
+
+    // a curve key registered to the cert, stored like bindings of older versions
+    string curveUserId = "revocationTestCurveUser";
+    auto curveKeyName = ZMQMessage::getCurveKeyName(curveUserId);
+    LevelDB::getLevelDb()->writeString(curveKeyName, cert);
+
+    string req = string("{\"type\":\"") + ZMQMessage::GET_SERVER_STATUS_REQ + "\"}";
+    REQUIRE_NOTHROW(ZMQMessage::parse(req.c_str(), req.size(), true, true, false, curveUserId));
+
+    writeTestCRL(cert, crlFile);
+    CertVerifier::init(caFile, crlFile);
+
+    // the session of the revoked cert is dropped, and a new one is refused
+    REQUIRE_THROWS(client->getServerStatus());
+
+    // the curve key is unregistered
+    REQUIRE_THROWS(ZMQMessage::parse(req.c_str(), req.size(), true, true, false, curveUserId));
+    REQUIRE(!LevelDB::getLevelDb()->readString(curveKeyName));
+
+    remove(crlFile.c_str());
+    CertVerifier::init(caFile, crlFile);
+    remove(certFile.c_str());
+}
+
+TEST_CASE_METHOD(TestFixture, "DKG API V2 test", "[dkg-api-v2]") {
+    HttpClient client(RPC_ENDPOINT);
+    StubClient c(client, JSONRPC_CLIENT_V2);
+
+    string polyName = SAMPLE_POLY_NAME;
+
+    PRINT_SRC_LINE
+    Json::Value genPoly = c.generateDKGPoly(polyName, 2);
+    REQUIRE(genPoly["status"].asInt() == 0);
+
+    Json::Value publicKeys;
+    publicKeys.append(SAMPLE_DKG_PUB_KEY_1);
+    publicKeys.append(SAMPLE_DKG_PUB_KEY_2);
+
+    // wrongName
+    Json::Value genPolyWrongName = c.generateDKGPoly("poly", 2);
+    REQUIRE(genPolyWrongName["status"].asInt() != 0);
+
+    Json::Value verifVectWrongName = c.getVerificationVector("poly", 2);
+    REQUIRE(verifVectWrongName["status"].asInt() != 0);
+
+    Json::Value secretSharesWrongName = c.getSecretShareV2("poly", publicKeys, 2, 2);
+    REQUIRE(secretSharesWrongName["status"].asInt() != 0);
+
+    // wrong_t
+    Json::Value genPolyWrong_t = c.generateDKGPoly(polyName, 33);
+    REQUIRE(genPolyWrong_t["status"].asInt() != 0);
+
+    Json::Value verifVectWrong_t = c.getVerificationVector(polyName, 1);
+    REQUIRE(verifVectWrong_t["status"].asInt() != 0);
+
+    Json::Value secretSharesWrong_t = c.getSecretShareV2(polyName, publicKeys, 3, 3);
+    REQUIRE(secretSharesWrong_t["status"].asInt() != 0);
+
+    Json::Value publicKeys1;
+    publicKeys1.append(SAMPLE_DKG_PUB_KEY_1);
+    Json::Value secretSharesWrong_n = c.getSecretShareV2(polyName, publicKeys1, 2, 1);
+    REQUIRE(secretSharesWrong_n["status"].asInt() != 0);
+
+    //wrong number of publicKeys
+    Json::Value secretSharesWrongPkeys = c.getSecretShareV2(polyName, publicKeys, 2, 3);
+    REQUIRE(secretSharesWrongPkeys["status"].asInt() != 0);
+
+    //wrong verif
+    Json::Value Skeys = c.getSecretShareV2(polyName, publicKeys, 2, 2);
+    REQUIRE_NOTHROW(c.getSecretShare(polyName, publicKeys, 2, 2));
+    REQUIRE(Skeys == c.getSecretShare(polyName, publicKeys, 2, 2));
+
+    Json::Value verifVect = c.getVerificationVector(polyName, 2);
+    REQUIRE_NOTHROW(c.getVerificationVector(polyName, 2));
+    REQUIRE(verifVect == c.getVerificationVector(polyName, 2));
+
+    // stored by generateDKGPoly and equal to the commitments computed in the enclave
+    REQUIRE(SGXWalletServer::checkDataFromDb(SGXWalletServer::getVerificationVectorName(polyName)));
+    REQUIRE(SGXWalletServer::readVerificationVector(polyName, 2) ==
+            get_verif_vect(*SGXWalletServer::readFromDb(polyName), 2));
+
+    // the same commitments in half the length, accepted as public shares
+    Json::Value compressedVV = c.getVerificationVectorCompressed(polyName, 2);
+    REQUIRE(compressedVV["status"].asInt() == 0);
+    string compressed = compressedVV["verificationVector"].asString();
+    REQUIRE(compressed.length() == 2 * G2_COMPRESSED_HEX_LEN);
+    REQUIRE(decompressToDecimalG2(compressed) == SGXWalletServer::readVerificationVector(polyName, 2));
+    string expanded;
+    REQUIRE(expandPublicShares(compressed, 2, expanded));
+    REQUIRE(expanded.length() == 2 * G2_HEX_LEN);
+
+    // several polys in one call, stored like generateDKGPoly stores them
+    Json::Value batchNames;
+    batchNames.append("POLY:SCHAIN_ID:1:NODE_ID:1:DKG_ID:2");
+    batchNames.append("POLY:SCHAIN_ID:1:NODE_ID:1:DKG_ID:3");
+    Json::Value polyBatch = c.generateDKGPolyBatch(batchNames, 2);
+    REQUIRE(polyBatch["status"].asInt() == 0);
+    REQUIRE(polyBatch["verificationVectors"].size() == 2);
+    for (int i = 0; i < 2; i++) {
+        REQUIRE(decompressToDecimalG2(polyBatch["verificationVectors"][i].asString()) ==
+                SGXWalletServer::readVerificationVector(batchNames[i].asString(), 2));
+    }
+    batchNames.append(batchNames[0]);
+    REQUIRE(c.generateDKGPolyBatch(batchNames, 2)["status"].asInt() != 0);
+
+    Json::Value verificationWrongSkeys = c.dkgVerificationV2("", "", "", 2, 2, 1);
+    REQUIRE(verificationWrongSkeys["status"].asInt() != 0);
+}
+
+TEST_CASE_METHOD(TestFixture, "DKG API V2 ZMQ test", "[dkg-api-v2-zmq]") {
+    auto client = make_shared<ZMQClient>(ZMQ_IP, ZMQ_PORT, true, "./sgx_data/cert_data/rootCA.pem",
+                                         "./sgx_data/cert_data/rootCA.key");
+
+    string polyName = SAMPLE_POLY_NAME;
+
+    PRINT_SRC_LINE
+    REQUIRE(client->generateDKGPoly(polyName, 2));
+
+    Json::Value publicKeys;
+    publicKeys.append(SAMPLE_DKG_PUB_KEY_1);
+    publicKeys.append(SAMPLE_DKG_PUB_KEY_2);
+
+    // wrongName
+    REQUIRE(!client->generateDKGPoly("poly", 2));
+
+    REQUIRE_THROWS(client->getVerificationVector("poly", 2));
+
+    REQUIRE_THROWS(client->getSecretShare("poly", publicKeys, 2, 2));
+
+    // wrong_t
+    REQUIRE(!client->generateDKGPoly(polyName, 33));
+
+    REQUIRE_THROWS(client->getVerificationVector(polyName, 0));
+
+    REQUIRE_THROWS(client->getSecretShare(polyName, publicKeys, 3, 3));
+
+    Json::Value publicKeys1;
     publicKeys1.append(SAMPLE_DKG_PUB_KEY_1);
     REQUIRE_THROWS(client->getSecretShare(polyName, publicKeys1, 2, 1));
 
@@ -842,9 +2107,32 @@ TEST_CASE_METHOD(TestFixture, "AES_DKG V2 test", "[aes-dkg-v2]") {
             REQUIRE(res);
         }
 
+    for (int j = 0; j < n; j++) {
+        Json::Value batchPubShares, batchSecretShares;
+        for (int i = 0; i < n; i++) {
+            batchPubShares.append(pubShares[i]);
+            batchSecretShares.append(secretShares[i]["secretShare"].asString().substr(192 * j, 192));
+        }
+        // a corrupted share fails only its own dealer
+        batchPubShares[n] = pubShares[0];
+        batchSecretShares[n] = secretShares[0]["secretShare"].asString().substr(192 * ((j + 1) % n), 192);
+
+        Json::Value verif = c.dkgVerificationBatch(batchPubShares, ethKeys[j]["keyName"].asString(),
+                                                   batchSecretShares, t, n, j);
+        REQUIRE(verif["status"] == 0);
+        REQUIRE(verif["results"].size() == (uint64_t) n + 1);
+        for (int i = 0; i < n; i++) {
+            REQUIRE(verif["results"][i].asBool());
+        }
+        REQUIRE(!verif["results"][n].asBool());
+    }
+
     Json::Value complaintResponse = c.complaintResponse(polyNames[1], t, n, 0);
     REQUIRE(complaintResponse["status"] == 0);
 
+    // a repeated complaint is answered from the cache after the DKG intermediates are deleted
+    REQUIRE(c.complaintResponse(polyNames[1], t, n, 0) == complaintResponse);
+
     string dhKey = complaintResponse["dhKey"].asString();
     string shareG2 = complaintResponse["share*G2"].asString();
     string secretShare = secretShares[1]["secretShare"].asString().substr(0, 192);
@@ -914,6 +2202,12 @@ TEST_CASE_METHOD(TestFixture, "AES_DKG V2 test", "[aes-dkg-v2]") {
 
     map <size_t, shared_ptr<BLSPublicKeyShare>> coeffs_pkeys_map;
 
+    // the DH public keys of the dealers are checked on the host before the enclave is entered
+    string badShares = secShares[0];
+    badShares[191] = badShares[191] == '0' ? '1' : '0';
+    REQUIRE(c.createBLSPrivateKeyV2("BLS_KEY" + polyNames[0].substr(4), ethKeys[0]["keyName"].asString(), polyNames[0],
+                                    badShares, t, n)["status"] == INVALID_CREATE_BLS_KEY_SECRET_SHARES);
+
     for (int i = 0; i < t; i++) {
         string endName = polyNames[i].substr(4);
         string blsName = "BLS_KEY" + polyNames[i].substr(4);
@@ -1197,6 +2491,16 @@ TEST_CASE_METHOD(TestFixture, "Many threads ecdsa dkg v2 bls zmq", "[many-thread
     }
 }
 
+TEST_CASE_METHOD(TestFixture, "Many threads ecdsa dkg v2 bls perf", "[many-threads-crypto-v2-perf]") {
+    auto result = TestUtils::runPerfScenario("many-threads-crypto-v2", TestUtils::sendRPCRequestV2, 4, 5);
+    REQUIRE(result["operations"].asInt() == 20);
+}
+
+TEST_CASE_METHOD(TestFixture, "Many threads ecdsa dkg v2 bls zmq perf", "[many-threads-crypto-v2-zmq-perf]") {
+    auto result = TestUtils::runPerfScenario("many-threads-crypto-v2-zmq", TestUtils::sendRPCRequestZMQ, 4, 5);
+    REQUIRE(result["operations"].asInt() == 20);
+}
+
 TEST_CASE_METHOD(TestFixture, "First run", "[first-run]") {
 
     HttpClient client(RPC_ENDPOINT);
@@ -1287,6 +2591,32 @@ TEST_CASE_METHOD(TestFixture, "Test decryption share for threshold encryption",
     REQUIRE( share2 == key * decryption_value2 );
 }
 
+TEST_CASE_METHOD(TestFixture, "Cached decryption shares", "[te-decryption-share-cache]") {
+    HttpClient client(RPC_ENDPOINT);
+    StubClient c(client, JSONRPC_CLIENT_V2);
+
+    std::string name = "BLS_KEY:SCHAIN_ID:123456789:NODE_ID:0:DKG_ID:0";
+    c.importBLSKeyShare("0xe632f7fde2c90a073ec43eaa90dca7b82476bf28815450a11191484934b9c3f", name);
+
+    libff::alt_bn128_G2 decryption_value = libff::alt_bn128_G2::random_element();
+    decryption_value.to_affine_coordinates();
+
+    Json::Value publicDecryptionValues;
+    publicDecryptionValues["publicDecryptionValues"][0] = convertG2ToString( decryption_value, ':' );
+
+    auto first = c.getDecryptionShares( name, publicDecryptionValues );
+    REQUIRE(first["status"] == 0);
+
+    auto hits = Metrics::getCounter("decryptionShareCacheHits").get();
+    REQUIRE(c.getDecryptionShares( name, publicDecryptionValues )["decryptionShares"] == first["decryptionShares"]);
+    REQUIRE(Metrics::getCounter("decryptionShareCacheHits").get() == hits + 1);
+
+    // a point off the curve is rejected before the ECALL
+    decryption_value.Y.c0 += libff::alt_bn128_Fq::one();
+    publicDecryptionValues["publicDecryptionValues"][0] = convertG2ToString( decryption_value, ':' );
+    REQUIRE(c.getDecryptionShares( name, publicDecryptionValues )["status"] != 0);
+}
+
 TEST_CASE_METHOD(TestFixture, "Test decryption share for threshold encryption via zmq", "[te-decryption-share-zmq]") {
     auto client = make_shared<ZMQClient>(ZMQ_IP, ZMQ_PORT, true, "./sgx_data/cert_data/rootCA.pem",
                                          "./sgx_data/cert_data/rootCA.key");
@@ -1430,6 +2760,278 @@ TEST_CASE_METHOD(TestFixture, "Test message signing for bls aggregated signature
     REQUIRE( !signature.empty() );
 }
 
+TEST_CASE_METHOD(TestFixture, "Test batch message signing via zmq", "[bls-sign-batch-zmq]") {
+    auto client = make_shared<ZMQClient>(ZMQ_IP, ZMQ_PORT, true, "./sgx_data/cert_data/rootCA.pem",
+                                         "./sgx_data/cert_data/rootCA.key");
+
+    std::string name = "BLS_KEY:SCHAIN_ID:123456789:NODE_ID:0:DKG_ID:0";
+    REQUIRE( client->generateBLSPrivateKey(name) );
+
+    string sh = SAMPLE_HASH;
+    vector<tuple<string, string, int, int>> requests;
+    for (int i = 0; i < 10; i++) {
+        requests.emplace_back(name, sh.substr(0, sh.size() - 8) + to_string(10000000 + i), 1, 1);
+    }
+
+    auto signatures = client->blsSignMessageHashBatch(requests);
+    REQUIRE( signatures.size() == requests.size() );
+
+    for (uint64_t i = 0; i < requests.size(); i++) {
+        REQUIRE( signatures[i] == client->blsSignMessageHash(name, get<1>(requests[i]), 1, 1) );
+    }
+}
+
+TEST_CASE_METHOD(TestFixture, "BLS sign of a client hashed point", "[bls-sign-hashed-point]") {
+    HttpClient htp(RPC_ENDPOINT);
+    StubClient c(htp, JSONRPC_CLIENT_V2);
+    auto zmqClient = make_shared<ZMQClient>(ZMQ_IP, ZMQ_PORT, true, "./sgx_data/cert_data/rootCA.pem",
+                                            "./sgx_data/cert_data/rootCA.key");
+
+    std::string name = "BLS_KEY:SCHAIN_ID:123456796:NODE_ID:0:DKG_ID:0";
+    REQUIRE(c.importBLSKeyShare("0xe632f7fde2c90a073ec43eaa90dca7b82476bf28815450a11191484934b9c3f", name)["status"] == 0);
+
+    auto hash = make_shared<array<uint8_t, 32>>();
+    uint64_t binLen = 0;
+    REQUIRE(hex2carray(SAMPLE_HASH, &binLen, hash->data(), hash->size()));
+
+    libBLS::Bls bls(1, 1);
+    auto hashWithHint = bls.HashtoG1withHint(hash);
+    hashWithHint.first.to_affine_coordinates();
+    auto hashedPoint = libBLS::ThresholdUtils::fieldElementToString(hashWithHint.first.X) + ":" +
+                       libBLS::ThresholdUtils::fieldElementToString(hashWithHint.first.Y);
+
+    auto expected = c.blsSignMessageHash(name, SAMPLE_HASH, 1, 1)["signatureShare"].asString();
+
+    auto response = c.blsSignHashedPoint(name, hashedPoint, hashWithHint.second);
+    REQUIRE(response["status"] == 0);
+    REQUIRE(response["signatureShare"].asString() == expected);
+    REQUIRE(zmqClient->blsSignHashedPoint(name, hashedPoint, hashWithHint.second) == expected);
+
+    REQUIRE(c.blsSignHashedPoint(name, "1:1", hashWithHint.second)["status"] == INVALID_BLS_HASHED_POINT);
+    REQUIRE(c.blsSignHashedPoint(name, hashedPoint, "x")["status"] == INVALID_BLS_HASHED_POINT);
+
+    REQUIRE(c.deleteBlsKey(name)["deleted"] == true);
+}
+
+TEST_CASE_METHOD(TestFixture, "Repeated BLS sign requests are cached", "[bls-sign-cache]") {
+    HttpClient client(RPC_ENDPOINT);
+    StubClient c(client, JSONRPC_CLIENT_V2);
+
+    std::string name = "BLS_KEY:SCHAIN_ID:123456795:NODE_ID:0:DKG_ID:0";
+    REQUIRE(c.importBLSKeyShare("0xe632f7fde2c90a073ec43eaa90dca7b82476bf28815450a11191484934b9c3f", name)["status"] == 0);
+
+    auto signature = c.blsSignMessageHash(name, SAMPLE_HASH, 1, 1)["signatureShare"];
+    auto hits = SGXWalletServer::getBlsSignCacheHits();
+    REQUIRE(c.blsSignMessageHash(name, SAMPLE_HASH, 1, 1)["signatureShare"] == signature);
+    REQUIRE(SGXWalletServer::getBlsSignCacheHits() == hits + 1);
+
+    // another key under the same name has to be signed with, not answered from the cache
+    REQUIRE(c.deleteBlsKey(name)["deleted"] == true);
+    REQUIRE(c.importBLSKeyShare(TestUtils::stringFromFr(libff::alt_bn128_Fr("2"), 16), name)["status"] == 0);
+    REQUIRE(c.blsSignMessageHash(name, SAMPLE_HASH, 1, 1)["signatureShare"] != signature);
+    REQUIRE(SGXWalletServer::getBlsSignCacheHits() == hits + 1);
+
+    REQUIRE(c.deleteBlsKey(name)["deleted"] == true);
+}
+
+TEST_CASE_METHOD(TestFixture, "Concurrent sign requests are batched", "[sign-batching]") {
+    HttpClient client(RPC_ENDPOINT);
+    StubClient c(client, JSONRPC_CLIENT_V2);
+
+    // the reference signatures are made under another name, so that the request coalescer does not answer
+    std::string name = "BLS_KEY:SCHAIN_ID:123456793:NODE_ID:0:DKG_ID:0";
+    std::string referenceName = "BLS_KEY:SCHAIN_ID:123456794:NODE_ID:0:DKG_ID:0";
+    REQUIRE(c.importBLSKeyShare("0xe632f7fde2c90a073ec43eaa90dca7b82476bf28815450a11191484934b9c3f", name)["status"] == 0);
+    REQUIRE(c.importBLSKeyShare("0xe632f7fde2c90a073ec43eaa90dca7b82476bf28815450a11191484934b9c3f",
+                                referenceName)["status"] == 0);
+    auto ecdsaName = genECDSAKeyAPI(c);
+
+    string sh = SAMPLE_HASH;
+    vector<string> hashes;
+    vector<string> expected;
+
+    auto maxWindowUs = SignBatcher::getMaxWindowUs();
+    SignBatcher::setMaxWindowUs(0);
+    for (int i = 0; i < 64; i++) {
+        hashes.push_back(sh.substr(0, sh.size() - 8) + to_string(10000000 + i));
+        expected.push_back(c.blsSignMessageHash(referenceName, hashes.back(), 1, 1)["signatureShare"].asString());
+    }
+    SignBatcher::setMaxWindowUs(SIGN_BATCH_DEFAULT_MAX_WINDOW_US);
+
+    vector<thread> threads;
+    atomic<uint64_t> failures(0);
+
+    for (int j = 0; j < 16; j++) {
+        threads.emplace_back([&, j]() {
+            HttpClient threadClient(RPC_ENDPOINT);
+            StubClient tc(threadClient, JSONRPC_CLIENT_V2);
+            for (int i = j; i < (int) hashes.size(); i += 16) {
+                if (tc.blsSignMessageHash(name, hashes[i], 1, 1)["signatureShare"].asString() != expected[i] ||
+                    tc.ecdsaSignMessageHash(16, ecdsaName, hashes[i])["status"] != 0) {
+                    failures++;
+                }
+            }
+        });
+    }
+
+    for (auto &&t : threads) {
+        t.join();
+    }
+
+    SignBatcher::setMaxWindowUs(maxWindowUs);
+
+    REQUIRE(failures == 0);
+    REQUIRE(c.deleteBlsKey(name)["deleted"] == true);
+    REQUIRE(c.deleteBlsKey(referenceName)["deleted"] == true);
+}
+
+TEST_CASE_METHOD(TestFixture, "BLS sign test vectors", "[bls-sign-vectors]") {
+    // enclave signatures have to equal key * H(m) computed by libff on the host for every BN254_BACKEND
+    HttpClient htp(RPC_ENDPOINT);
+    StubClient c(htp, JSONRPC_CLIENT_V2);
+
+    std::string name = "BLS_KEY:SCHAIN_ID:123456792:NODE_ID:0:DKG_ID:0";
+
+    vector<string> keys = {"1", "2", "6507625568967977077291849236396320012317305261598035438182864059942098934847",
+                           "10944121435919637611123202872628637544274182200208017171849102093287904247809",
+                           "21888242871839275222246405745257275088548364400416034343698204186575808495616"};
+    vector<string> hashes = {SAMPLE_HASH, "0000000000000000000000000000000000000000000000000000000000000001",
+                             "ffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffff"};
+
+    libBLS::Bls bls(1, 1);
+
+    for (auto &&keyDec : keys) {
+        libff::alt_bn128_Fr key(keyDec.c_str());
+        auto response = c.importBLSKeyShare(TestUtils::stringFromFr(key, 16), name);
+        REQUIRE(response["status"] == 0);
+
+        for (auto &&hashHex : hashes) {
+            auto hash = make_shared<array<uint8_t, 32>>();
+            uint64_t binLen = 0;
+            REQUIRE(hex2carray(hashHex.c_str(), &binLen, hash->data(), hash->size()));
+
+            auto expected = key * bls.HashtoG1withHint(hash).first;
+
+            response = c.blsSignMessageHash(name, hashHex, 1, 1);
+            REQUIRE(response["status"] == 0);
+            BLSSigShare sig(make_shared<string>(response["signatureShare"].asString()), 1, 1, 1);
+            REQUIRE(*sig.getSigShare() == expected);
+        }
+
+        REQUIRE(c.deleteBlsKey(name)["deleted"] == true);
+    }
+}
+
+TEST_CASE_METHOD(TestFixture, "Aggregate BLS signature shares", "[aggregate-bls-signatures]") {
+    HttpClient htp(RPC_ENDPOINT);
+    StubClient c(htp, JSONRPC_CLIENT_V2);
+
+    int t = 2, n = 3;
+
+    // key shares of the poly 7 + 5 x, so the common key is 7
+    vector<string> names(n);
+    for (int i = 0; i < n; i++) {
+        names[i] = "BLS_KEY:SCHAIN_ID:123456793:NODE_ID:" + to_string(i) + ":DKG_ID:0";
+        libff::alt_bn128_Fr key(7 + 5 * (i + 1));
+        REQUIRE(c.importBLSKeyShare(TestUtils::stringFromFr(key, 16), names[i])["status"] == 0);
+    }
+
+    auto hash = make_shared<array<uint8_t, 32>>();
+    uint64_t binLen = 0;
+    REQUIRE(hex2carray(SAMPLE_HASH, &binLen, hash->data(), hash->size()));
+    auto expected = libff::alt_bn128_Fr(7) * libBLS::Bls(t, n).HashtoG1withHint(hash).first;
+
+    vector<vector<int>> signerSets = {{1, 2}, {1, 3}, {3, 2}, {1, 3}};
+
+    for (auto &&signers : signerSets) {
+        Json::Value shares(Json::arrayValue), signerIndices(Json::arrayValue);
+        BLSSigShareSet sigShareSet(t, n);
+
+        for (auto &&signer : signers) {
+            auto share = c.blsSignMessageHash(names[signer - 1], SAMPLE_HASH, t, n)["signatureShare"].asString();
+            shares.append(share);
+            signerIndices.append(signer);
+            sigShareSet.addSigShare(make_shared<BLSSigShare>(make_shared<string>(share), signer, t, n));
+        }
+
+        auto response = c.aggregateBLSSignatures(shares, signerIndices, t, n);
+        REQUIRE(response["status"] == 0);
+
+        BLSSigShare aggregated(make_shared<string>(response["signature"].asString()), 1, t, n);
+        REQUIRE(*aggregated.getSigShare() == expected);
+        REQUIRE(*aggregated.getSigShare() == *sigShareSet.merge()->getSig());
+    }
+
+    Json::Value one(Json::arrayValue), duplicate(Json::arrayValue), twoShares(Json::arrayValue);
+    one.append(1);
+    duplicate.append(2);
+    duplicate.append(2);
+    twoShares.append("1:2:1:1");
+    twoShares.append("1:2:1:1");
+    REQUIRE(c.aggregateBLSSignatures(twoShares, one, t, n)["status"] != 0);
+    REQUIRE(c.aggregateBLSSignatures(twoShares, duplicate, t, n)["status"] != 0);
+
+    Json::Value offCurve(Json::arrayValue), two(Json::arrayValue);
+    offCurve.append("1:3:1:1");
+    offCurve.append("1:2:1:1");
+    two.append(1);
+    two.append(2);
+    REQUIRE(c.aggregateBLSSignatures(offCurve, two, t, n)["status"] != 0);
+
+    for (auto &&name : names) {
+        REQUIRE(c.deleteBlsKey(name)["deleted"] == true);
+    }
+}
+
+TEST_CASE_METHOD(TestFixture, "Verify BLS signatures in a batch", "[verify-bls-signatures]") {
+    HttpClient htp(RPC_ENDPOINT);
+    StubClient c(htp, JSONRPC_CLIENT_V2);
+
+    vector<string> names = {"BLS_KEY:SCHAIN_ID:123456794:NODE_ID:0:DKG_ID:0",
+                            "BLS_KEY:SCHAIN_ID:123456794:NODE_ID:1:DKG_ID:0"};
+    vector<string> hashes = {SAMPLE_HASH, "0000000000000000000000000000000000000000000000000000000000000001",
+                             "ffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffff"};
+
+    Json::Value requests(Json::arrayValue);
+
+    for (auto &&name : names) {
+        auto key = libff::alt_bn128_Fr::random_element();
+        REQUIRE(c.importBLSKeyShare(TestUtils::stringFromFr(key, 16), name)["status"] == 0);
+        auto publicKey = c.getBLSPublicKeyShare(name)["blsPublicKeyShare"];
+
+        for (auto &&hash : hashes) {
+            Json::Value request;
+            request["publicKey"] = publicKey;
+            request["messageHash"] = hash;
+            request["signature"] = c.blsSignMessageHash(name, hash, 1, 1)["signatureShare"];
+            requests.append(request);
+        }
+    }
+
+    auto response = c.verifyBLSSignatures(requests);
+    REQUIRE(response["status"] == 0);
+    REQUIRE(response["valid"].size() == requests.size());
+    for (auto &&valid : response["valid"]) {
+        REQUIRE(valid.asBool());
+    }
+
+    // a signature of another hash, the other signatures stay valid
+    requests[4]["signature"] = requests[3]["signature"];
+    response = c.verifyBLSSignatures(requests);
+    REQUIRE(response["status"] == 0);
+    for (Json::ArrayIndex i = 0; i < requests.size(); i++) {
+        REQUIRE(response["valid"][i].asBool() == (i != 4));
+    }
+
+    requests[0]["signature"] = "1:3:1:1";
+    REQUIRE(c.verifyBLSSignatures(requests)["status"] != 0);
+    REQUIRE(c.verifyBLSSignatures(Json::Value(Json::arrayValue))["status"] != 0);
+
+    for (auto &&name : names) {
+        REQUIRE(c.deleteBlsKey(name)["deleted"] == true);
+    }
+}
+
 TEST_CASE_METHOD(TestFixture, "Test pop prove for bls aggregated signatures scheme", "[bls-aggregated-pop-prove]") {
     HttpClient htp(RPC_ENDPOINT);
     StubClient c(htp, JSONRPC_CLIENT_V2);
@@ -1456,6 +3058,46 @@ TEST_CASE_METHOD(TestFixture, "Test pop prove for bls aggregated signatures sche
     REQUIRE( popProveLocal == popProveEnclave );
 }
 
+TEST_CASE_METHOD(TestFixture, "Test batch key generation and pop prove for bls aggregated signatures scheme", "[bls-aggregated-batch]") {
+    HttpClient htp(RPC_ENDPOINT);
+    StubClient c(htp, JSONRPC_CLIENT_V2);
+
+    std::string name = "BLS_KEY:SCHAIN_ID:123456789:NODE_ID:0:DKG_ID:0";
+
+    libff::alt_bn128_Fr key = libff::alt_bn128_Fr::random_element();
+    while (key == libff::alt_bn128_Fr::zero()) {
+        key = libff::alt_bn128_Fr::random_element();
+    }
+
+    REQUIRE(c.importBLSKeyShare(TestUtils::stringFromFr(key, 16), name)["status"] == 0);
+
+    Json::Value names;
+    for (int i = 1; i <= 3; i++) {
+        names.append("BLS_KEY:SCHAIN_ID:123456789:NODE_ID:0:DKG_ID:" + to_string(i));
+    }
+    REQUIRE(c.generateBLSPrivateKeyBatch(names)["status"] == 0);
+    // the names exist now, so the whole batch is rejected
+    REQUIRE(c.generateBLSPrivateKeyBatch(names)["status"] != 0);
+
+    for (auto &&generated : names) {
+        REQUIRE(c.getBLSPublicKeyShare(generated.asString())["status"] == 0);
+    }
+
+    names.append(name);
+    auto response = c.popProveBatch(names);
+    REQUIRE(response["status"] == 0);
+    REQUIRE(response["popProves"].size() == 4);
+
+    shared_ptr<string> sigSharePtr = make_shared<string>(response["popProves"][3].asString());
+    BLSSigShare sig(sigSharePtr, 1, 1, 1);
+    REQUIRE(libBLS::Bls::PopProve(key) == *sig.getSigShare());
+
+    // the same proofs one by one
+    for (int i = 0; i < 4; i++) {
+        REQUIRE(c.popProve(names[i].asString())["popProve"] == response["popProves"][i]);
+    }
+}
+
 TEST_CASE_METHOD(TestFixture, "Test pop prove for bls aggregated signatures scheme via zmq", "[bls-aggregated-pop-prove-zmq]") {
     auto client = make_shared<ZMQClient>(ZMQ_IP, ZMQ_PORT, true, "./sgx_data/cert_data/rootCA.pem",
                                          "./sgx_data/cert_data/rootCA.key");
@@ -1519,4 +3161,373 @@ TEST_CASE_METHOD(TestFixtureZMQSign, "ZMQ-ecdsa", "[zmq-ecdsa]") {
 
 }
 
+TEST_CASE_METHOD(TestFixtureZMQSign, "ZMQ cert fingerprint", "[zmq-cert-fingerprint]") {
+    // a client of several endpoints signs every request instead of starting a session
+    auto client = make_shared<ZMQClient>(vector<pair<string, uint16_t>>{{ZMQ_IP, ZMQ_PORT}, {ZMQ_IP, ZMQ_PORT}},
+                                         true, "./sgx_data/cert_data/rootCA.pem", "./sgx_data/cert_data/rootCA.key");
+    client->enableCertFingerprint(true);
+
+    auto keyName = client->generateECDSAKey().second;
+    string sh = SAMPLE_HASH;
+
+    // the first request sends the cert, the next ones only its hash
+    for (int i = 0; i < 10; i++) {
+        auto hash = sh.substr(0, sh.size() - 8) + to_string(10000000 + i);
+        REQUIRE(client->ecdsaSignMessageHash(16, keyName, hash).size() > 10);
+    }
+}
+
+void signThroughput(const string& _mode) {
+    string blsName = "BLS_KEY:SCHAIN_ID:123456789:NODE_ID:0:DKG_ID:0";
+    REQUIRE(SGXWalletServer::generateBLSPrivateKeyImpl(blsName)["status"] == 0);
+
+    auto ecdsaKey = SGXWalletServer::generateECDSAKeyImpl();
+    REQUIRE(ecdsaKey["status"] == 0);
+    string ecdsaName = ecdsaKey["keyName"].asString();
+
+    string sh = SAMPLE_HASH;
+    int count = 1000;
+
+    auto begin = chrono::steady_clock::now();
+    for (int i = 0; i < count; i++) {
+        auto hash = sh.substr(0, sh.size() - 8) + to_string(10000000 + i);
+        REQUIRE(SGXWalletServer::blsSignMessageHashImpl(blsName, hash, 1, 1)["status"] == 0);
+    }
+    auto blsMs = chrono::duration_cast<chrono::milliseconds>(chrono::steady_clock::now() - begin).count();
+
+    begin = chrono::steady_clock::now();
+    for (int i = 0; i < count; i++) {
+        auto hash = sh.substr(0, sh.size() - 8) + to_string(10000000 + i);
+        REQUIRE(SGXWalletServer::ecdsaSignMessageHashImpl(16, ecdsaName, hash)["status"] == 0);
+    }
+    auto ecdsaMs = chrono::duration_cast<chrono::milliseconds>(chrono::steady_clock::now() - begin).count();
+
+    cerr << _mode << ": " << count << " BLS signatures in " << blsMs << " ms, "
+         << count << " ECDSA signatures in " << ecdsaMs << " ms" << endl;
+}
+
+TEST_CASE_METHOD(TestFixture, "Sign throughput with regular ECALLs", "[sign-perf]") {
+    signThroughput("regular");
+}
+
+TEST_CASE_METHOD(TestFixtureSwitchless, "Sign throughput with switchless ECALLs", "[sign-perf-switchless]") {
+    REQUIRE(isSwitchlessEnabled());
+    signThroughput("switchless");
+}
+
+string fqToPaddedHex(const libff::alt_bn128_Fq &_fq) {
+    mpz_t t;
+    mpz_init(t);
+    _fq.as_bigint().to_mpz(t);
+
+    vector<char> arr(mpz_sizeinbase(t, 16) + 2, 0);
+    mpz_get_str(arr.data(), 16, t);
+    mpz_clear(t);
+
+    string hex(arr.data());
+    return string(64 - hex.size(), '0') + hex;
+}
+
+// n participants with t random G2 commitments each, in the layout of getVerificationVectorMult
+vector<string> randomPublicShares(size_t _n, size_t _t) {
+    vector<string> shares(_n);
+
+    for (auto &&share : shares) {
+        for (size_t j = 0; j < _t; j++) {
+            auto point = libff::alt_bn128_G2::random_element();
+            point.to_affine_coordinates();
+            share += fqToPaddedHex(point.X.c0) + fqToPaddedHex(point.X.c1) +
+                     fqToPaddedHex(point.Y.c0) + fqToPaddedHex(point.Y.c1);
+        }
+    }
+
+    return shares;
+}
+
+TEST_CASE_METHOD(TestFixture, "Enclave crypto microbenchmarks", "[.][crypto-bench]") {
+    vector<char> errMsg(BUF_LEN, 0);
+    int errStatus = 0;
+    int exportable = 0;
+
+    vector<uint8_t> encrBlsKey(BUF_LEN, 0);
+    uint64_t encBlsLen = 0;
+    REQUIRE(trustedGenerateBLSKey(eid, &errStatus, errMsg.data(), &exportable, encrBlsKey.data(), &encBlsLen) == 0);
+    REQUIRE(errStatus == 0);
+
+    vector<uint8_t> encrEcdsaKey(BUF_LEN, 0);
+    vector<char> pubKeyX(BUF_LEN, 0);
+    vector<char> pubKeyY(BUF_LEN, 0);
+    uint64_t encEcdsaLen = 0;
+    REQUIRE(trustedGenerateEcdsaKey(eid, &errStatus, errMsg.data(), &exportable, encrEcdsaKey.data(), &encEcdsaLen,
+                                    pubKeyX.data(), pubKeyY.data()) == 0);
+    REQUIRE(errStatus == 0);
+
+    vector<uint8_t> encrDKGSecret(DKG_MAX_SEALED_LEN, 0);
+    uint64_t encDKGLen = 0;
+    REQUIRE(trustedGenDkgSecret(eid, &errStatus, errMsg.data(), encrDKGSecret.data(), &encDKGLen, 2) == 0);
+    REQUIRE(errStatus == 0);
+
+    auto hash = make_shared<array<uint8_t, 32>>();
+    uint64_t binLen = 0;
+    REQUIRE(hex2carray(SAMPLE_HASH, &binLen, hash->data(), hash->size()));
+
+    libBLS::Bls bls(1, 1);
+    uint64_t hashLimbs[BLS_G1_LIMBS];
+    g1ToLimbs(bls.HashtoG1withHint(hash).first, hashLimbs);
+    uint64_t signature[BLS_G1_LIMBS];
+
+    string hexHash = SAMPLE_HEX_HASH;
+    uint64_t signatureR[ECDSA_SIG_LIMBS];
+    uint64_t signatureS[ECDSA_SIG_LIMBS];
+    uint8_t signatureV = 0;
+
+    string pubKeyB = SAMPLE_PUBLIC_KEY_B;
+    vector<uint8_t> encrPRDHKey(BUF_LEN, 0);
+    uint64_t encPRDHLen = 0;
+    vector<char> share(BUF_LEN, 0);
+    vector<char> shareG2(BUF_LEN, 0);
+
+    auto decryptionValue = libff::alt_bn128_G2::random_element();
+    decryptionValue.to_affine_coordinates();
+    auto decryptionValueStr = convertG2ToString(decryptionValue);
+    vector<char> decryptionValueBuf(BUF_LEN, 0);
+    strncpy(decryptionValueBuf.data(), decryptionValueStr.c_str(), BUF_LEN - 1);
+    vector<char> decryptionShare(BUF_LEN, 0);
+
+    string aesKey = SAMPLE_AES_KEY;
+    vector<char> aesKeyBuf(BUF_LEN, 0);
+    strncpy(aesKeyBuf.data(), aesKey.c_str(), BUF_LEN - 1);
+    vector<uint8_t> encrAesKey(BUF_LEN, 0);
+    uint64_t encAesLen = 0;
+    vector<char> decrAesKey(BUF_LEN, 0);
+    REQUIRE(trustedEncryptKey(eid, &errStatus, errMsg.data(), aesKeyBuf.data(), encrAesKey.data(), &encAesLen) == 0);
+
+    // secret shares of one polynomial, all encrypted to the ECDSA key above
+    string polyName = SAMPLE_POLY_NAME;
+    REQUIRE(SGXWalletServer::generateDKGPolyImpl(polyName, 11)["status"] == 0);
+
+    auto ecdsaKey = SGXWalletServer::generateECDSAKeyImpl();
+    REQUIRE(ecdsaKey["status"] == 0);
+
+    Json::Value pubKeys;
+    for (int i = 0; i < 16; i++) {
+        pubKeys.append(ecdsaKey["publicKey"].asString());
+    }
+    auto sharesResponse = SGXWalletServer::getSecretShareV2Impl(polyName, pubKeys, 11, 16);
+    REQUIRE(sharesResponse["status"] == 0);
+
+    vector<char> secretShares(BUF_LEN, 0);
+    strncpy(secretShares.data(), sharesResponse["secretShare"].asCString(), BUF_LEN - 1);
+
+    vector<uint8_t> encrShareKey(BUF_LEN, 0);
+    uint64_t encShareKeyLen = 0;
+    REQUIRE(hex2carray(ecdsaKey["encryptedKey"].asCString(), &encShareKeyLen, encrShareKey.data(), BUF_LEN));
+
+    vector<uint8_t> encrCreatedBlsKey(BUF_LEN, 0);
+    uint64_t encCreatedBlsLen = 0;
+
+    BENCHMARK("trustedBlsSignMessage") {
+        return trustedBlsSignMessage(eid, &errStatus, errMsg.data(), encrBlsKey.data(), encBlsLen, hashLimbs,
+                                     signature);
+    };
+
+    BENCHMARK("trustedEcdsaSign") {
+        return trustedEcdsaSign(eid, &errStatus, errMsg.data(), encrEcdsaKey.data(), encEcdsaLen, hexHash.data(),
+                                signatureR, signatureS, &signatureV);
+    };
+
+    BENCHMARK("trustedGetEncryptedSecretShareV2") {
+        return trustedGetEncryptedSecretShareV2(eid, &errStatus, errMsg.data(), encrDKGSecret.data(), encDKGLen,
+                                                encrPRDHKey.data(), &encPRDHLen, share.data(), shareG2.data(),
+                                                (char *) pubKeyB.data(), 2, 2, 1);
+    };
+
+    BENCHMARK("trustedCreateBlsKeyV2 16 shares") {
+        return trustedCreateBlsKeyV2(eid, &errStatus, errMsg.data(), secretShares.data(), encrShareKey.data(),
+                                     encShareKeyLen, encrCreatedBlsKey.data(), &encCreatedBlsLen);
+    };
+
+    BENCHMARK("trustedGetDecryptionShare") {
+        return trustedGetDecryptionShare(eid, &errStatus, errMsg.data(), encrBlsKey.data(),
+                                         decryptionValueBuf.data(), encBlsLen, decryptionShare.data());
+    };
+
+    BENCHMARK("trustedEncryptKey") {
+        return trustedEncryptKey(eid, &errStatus, errMsg.data(), aesKeyBuf.data(), encrAesKey.data(), &encAesLen);
+    };
+
+    REQUIRE(trustedSetVerifyEncryption(eid, 1) == 0);
+
+    BENCHMARK("trustedEncryptKey paranoid") {
+        return trustedEncryptKey(eid, &errStatus, errMsg.data(), aesKeyBuf.data(), encrAesKey.data(), &encAesLen);
+    };
+
+    REQUIRE(trustedSetVerifyEncryption(eid, 0) == 0);
+    REQUIRE(errStatus == 0);
+
+    BENCHMARK("trustedDecryptKey") {
+        return trustedDecryptKey(eid, &errStatus, errMsg.data(), encrAesKey.data(), encAesLen, decrAesKey.data());
+    };
+
+    REQUIRE(errStatus == 0);
+
+    BENCHMARK("HashtoG1withHint") {
+        return bls.HashtoG1withHint(hash);
+    };
+
+    vector<uint8_t> blob(BUF_LEN);
+    for (uint64_t i = 0; i < blob.size(); i++) {
+        blob[i] = (uint8_t) (i * 37);
+    }
+    auto blobHex = carray2Hex(blob.data(), blob.size());
+    uint64_t blobLen = 0;
+
+    BENCHMARK("carray2Hex") {
+        return carray2Hex(blob.data(), blob.size());
+    };
+
+    BENCHMARK("hex2carray") {
+        return hex2carray(blobHex.data(), &blobLen, blob.data(), blob.size());
+    };
+
+    auto verificationVector = SGXWalletServer::readFromDb(SGXWalletServer::getVerificationVectorName(polyName));
+
+    BENCHMARK("splitString") {
+        return splitString(verificationVector->c_str(), ':').size();
+    };
+
+    BENCHMARK("StringTokenizer") {
+        StringTokenizer tokenizer(*verificationVector, ':');
+        string_view token;
+        uint64_t count = 0;
+        while (tokenizer.next(token)) {
+            count++;
+        }
+        return count;
+    };
+
+    for (size_t n : {4, 8, 16, 32, 64, 128}) {
+        size_t t = (2 * n + 1) / 3;
+        auto publicShares = randomPublicShares(n, t);
+
+        BENCHMARK("calculateAllBlsPublicKeys n=" + to_string(n)) {
+            return calculateAllBlsPublicKeys(publicShares);
+        };
+    }
+}
+
+TEST_CASE_METHOD(TestFixture, "DKG cost as the committee grows", "[.][dkg-scale-bench]") {
+    auto ecdsaKey = SGXWalletServer::generateECDSAKeyImpl();
+    REQUIRE(ecdsaKey["status"] == 0);
+
+    for (int n : {16, 64, MAX_DKG_N}) {
+        int t = (2 * n + 1) / 3;
+        string polyName = "POLY:SCHAIN_ID:1:NODE_ID:1:DKG_ID:" + to_string(n);
+        REQUIRE(SGXWalletServer::generateDKGPolyImpl(polyName, t)["status"] == 0);
+
+        auto encryptedPolyHex = SGXWalletServer::readFromDb(polyName);
+        vector<string> pubKeys(n, ecdsaKey["publicKey"].asString());
+
+        REQUIRE(get_verif_vect(*encryptedPolyHex, t).size() == (uint64_t) t);
+        REQUIRE(getSecretSharesV2(polyName, encryptedPolyHex->c_str(), pubKeys, t, n).size() == (uint64_t) n * 192);
+
+        BENCHMARK("gen_dkg_poly n=" + to_string(n)) {
+            return gen_dkg_poly(t);
+        };
+
+        BENCHMARK("getVerificationVectorString n=" + to_string(n)) {
+            return getVerificationVectorString(*encryptedPolyHex, t);
+        };
+
+        BENCHMARK("getSecretSharesV2 n=" + to_string(n)) {
+            return getSecretSharesV2(polyName, encryptedPolyHex->c_str(), pubKeys, t, n);
+        };
+    }
+}
+
+// Fills the database up to each size with copies of a few real key shares, so every name can be
+// signed with, and times what grows with the number of keys. Results go to SGX_PERF_RESULTS_DIR.
+TEST_CASE_METHOD(TestFixture, "Startup, enumeration and sign latency with a million keys", "[.][million-keys-bench]") {
+    auto db = LevelDB::getLevelDb();
+    mt19937_64 rand(1);
+
+    auto randomHex = [&rand](uint64_t _bytes) {
+        static const char digits[] = "0123456789abcdef";
+        string hex;
+        for (uint64_t i = 0; i < 2 * _bytes; i++) {
+            hex.push_back(digits[rand() & 0xF]);
+        }
+        return hex;
+    };
+
+    vector<string> encryptedKeys;
+    for (int i = 0; i < 128; i++) {
+        auto name = "BLS_KEY:SCHAIN_ID:1:NODE_ID:" + to_string(i) + ":DKG_ID:1";
+        REQUIRE(SGXWalletServer::importBLSKeyShareImpl("0x" + randomHex(31), name)["status"] == 0);
+        encryptedKeys.push_back(*SGXWalletServer::readFromDb(name));
+    }
+
+    auto keyName = [](uint64_t _i) {
+        return "BLS_KEY:SCHAIN_ID:" + to_string(_i + 2) + ":NODE_ID:0:DKG_ID:0";
+    };
+
+    uint64_t numKeys = 0;
+
+    for (uint64_t target : {1000, 100000, 1000000}) {
+        vector<pair<string, string>> batch;
+        for (; numKeys < target; numKeys++) {
+            batch.emplace_back(keyName(numKeys), encryptedKeys[numKeys % encryptedKeys.size()]);
+            if (batch.size() == 1000) {
+                db->writeBatchUnique(batch);
+                batch.clear();
+            }
+        }
+        db->writeBatchUnique(batch);
+
+        auto prefix = "million-keys-" + to_string(target) + "-";
+
+        // a copy stands in for the database of a restarted sgxwallet, the open one is locked
+        auto copyName = LevelDB::getSgxDataFolder() + "million_keys_copy.db";
+        auto dbName = LevelDB::getSgxDataFolder() + WALLETDB_NAME;
+        for (auto &&suffix : {string(), string(DKG_STORE_SUFFIX)}) {
+            experimental::filesystem::remove_all(copyName + suffix);
+            experimental::filesystem::copy(dbName + suffix, copyName + suffix);
+            experimental::filesystem::remove(copyName + suffix + "/LOCK");
+        }
+        TestUtils::runPerfScenario(prefix + "open", [&copyName]() {
+            LevelDB copy(copyName, true);
+        }, 1, 1);
+        for (auto &&suffix : {string(), string(DKG_STORE_SUFFIX)}) {
+            experimental::filesystem::remove_all(copyName + suffix);
+        }
+
+        TestUtils::runPerfScenario(prefix + "initSEK", initSEK, 1, 3);
+        TestUtils::runPerfScenario(prefix + "validate_SEK", validate_SEK, 1, 3);
+
+        auto keys = TestUtils::runPerfScenario(prefix + "getAllKeysInfo", [&db, target]() {
+            CHECK_STATE(db->getAllKeys().second >= target);
+        }, 1, 3);
+
+        TestUtils::runPerfScenario(prefix + "getLatestCreatedKey", [&db]() {
+            CHECK_STATE(!db->getLatestCreatedKey().first.empty());
+        }, 1, 10);
+
+        mutex randMutex;
+        auto sign = TestUtils::runPerfScenario(prefix + "sign", [&]() {
+            string name, hash;
+            {
+                lock_guard<mutex> lock(randMutex);
+                name = keyName(rand() % numKeys);
+                hash = randomHex(32);
+            }
+            CHECK_STATE(SGXWalletServer::blsSignMessageHashImpl(name, hash, 1, 1)["status"] == 0);
+        }, 4, 250);
+        REQUIRE(sign["operations"].asInt() == 1000);
+
+        cerr << target << " keys: RSS " << getValue() / 1024 << " MB, getAllKeysInfo p50 "
+             << keys["latencyMs"]["p50"].asDouble() << " ms, sign p99 " << sign["latencyMs"]["p99"].asDouble()
+             << " ms" << endl;
+    }
+}
+
 TEST_CASE_METHOD(TestFixtureNoResetFromBackup, "Backup restore", "[backup-restore]") {}
@@ -59,6 +59,20 @@ int file_in_searchpath (const char *file, char *search, char *fullpath,
 sgx_status_t sgx_create_enclave_search (const char *filename, const int debug,
 	sgx_launch_token_t *token, int *updated, sgx_enclave_id_t *eid,
 	sgx_misc_attribute_t *attr)
+{
+	return sgx_create_enclave_search_ex(filename, debug, token, updated, eid,
+		attr, 0, NULL);
+}
+
+/*
+ * Same as sgx_create_enclave_search, but passes the extended features
+ * (e.g. the switchless configuration) to sgx_create_enclave_ex.
+ */
+
+sgx_status_t sgx_create_enclave_search_ex (const char *filename,
+	const int debug, sgx_launch_token_t *token, int *updated,
+	sgx_enclave_id_t *eid, sgx_misc_attribute_t *attr,
+	const uint32_t ex_features, const void **ex_features_p)
 {
 	struct stat sb;
 	char epath[PATH_MAX];	/* includes NULL */
@@ -66,27 +80,32 @@ sgx_status_t sgx_create_enclave_search (const char *filename, const int debug,
 	/* Is filename an absolute path? */
 
 	if ( filename[0] == '/' ) 
-		return sgx_create_enclave(filename, debug, token, updated, eid, attr);
+		return sgx_create_enclave_ex(filename, debug, token, updated, eid,
+			attr, ex_features, ex_features_p);
 
 	/* Is the enclave in the current working directory? */
 
 	if ( stat(filename, &sb) == 0 )
-		return sgx_create_enclave(filename, debug, token, updated, eid, attr);
+		return sgx_create_enclave_ex(filename, debug, token, updated, eid,
+			attr, ex_features, ex_features_p);
 
 	/* Search the paths in LD_LBRARY_PATH */
 
 	if ( file_in_searchpath(filename, getenv("LD_LIBRARY_PATH"), epath, PATH_MAX) )
-		return sgx_create_enclave(epath, debug, token, updated, eid, attr);
+		return sgx_create_enclave_ex(epath, debug, token, updated, eid,
+			attr, ex_features, ex_features_p);
 		
 	/* Search the paths in DT_RUNPATH */
 
 	if ( file_in_searchpath(filename, getenv("DT_RUNPATH"), epath, PATH_MAX) )
-		return sgx_create_enclave(epath, debug, token, updated, eid, attr);
+		return sgx_create_enclave_ex(epath, debug, token, updated, eid,
+			attr, ex_features, ex_features_p);
 
 	/* Standard system library paths */
 
 	if ( file_in_searchpath(filename, DEF_LIB_SEARCHPATH, epath, PATH_MAX) )
-		return sgx_create_enclave(epath, debug, token, updated, eid, attr);
+		return sgx_create_enclave_ex(epath, debug, token, updated, eid,
+			attr, ex_features, ex_features_p);
 
 	/*
 	 * If we've made it this far then we don't know where else to look.
@@ -96,7 +115,8 @@ sgx_status_t sgx_create_enclave_search (const char *filename, const int debug,
 	 * get reported to the calling function.
 	 */
 
-	return sgx_create_enclave(filename, debug, token, updated, eid, attr);
+	return sgx_create_enclave_ex(filename, debug, token, updated, eid,
+		attr, ex_features, ex_features_p);
 }
 
 int file_in_searchpath (const char *file, char *search, char *fullpath, 
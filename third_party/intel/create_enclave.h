@@ -49,6 +49,17 @@ sgx_status_t sgx_create_enclave_search (
 	sgx_misc_attribute_t *attr
 );
 
+sgx_status_t sgx_create_enclave_search_ex (
+	const char *filename,
+	const int debug,
+	sgx_launch_token_t *token,
+	int *updated,
+	sgx_enclave_id_t *eid,
+	sgx_misc_attribute_t *attr,
+	const uint32_t ex_features,
+	const void **ex_features_p
+);
+
 #ifdef __cplusplus
 };
 #endif
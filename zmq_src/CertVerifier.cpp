@@ -0,0 +1,185 @@
+/*
+    Copyright (C) 2021-Present SKALE Labs
+
+    This file is part of sgxwallet.
+
+    sgxwallet is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as published
+    by the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    sgxwallet is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with sgxwallet. If not, see <https://www.gnu.org/licenses/>.
+
+    @file CertVerifier.cpp
+    @author Stan Kladko
+    @date 2021
+*/
+
+#include <sys/stat.h>
+#include <unistd.h>
+#include <ctime>
+
+#include <openssl/pem.h>
+
+#include "common.h"
+#include "sgxwallet_common.h"
+#include "SGXException.h"
+#include "third_party/spdlog/spdlog.h"
+
+#include "CertVerifier.h"
+
+shared_timed_mutex CertVerifier::storeMutex;
+X509_STORE *CertVerifier::store = nullptr;
+string CertVerifier::caPath;
+string CertVerifier::crlPath;
+int64_t CertVerifier::crlMTime = 0;
+atomic<int64_t> CertVerifier::nextCrlCheck(0);
+atomic<uint64_t> CertVerifier::verified(0);
+atomic<uint64_t> CertVerifier::failed(0);
+atomic<uint64_t> CertVerifier::crlReloads(0);
+atomic<uint64_t> CertVerifier::storeGeneration(0);
+
+int64_t CertVerifier::getMTime(const string &_path) {
+    struct stat st;
+    if (_path.empty() || stat(_path.c_str(), &st) != 0) {
+        return 0;
+    }
+    return st.st_mtime;
+}
+
+X509_STORE *CertVerifier::loadStore(const string &_caPath, const string &_crlPath) {
+    auto result = X509_STORE_new();
+    CHECK_STATE(result);
+
+    if (X509_STORE_load_locations(result, _caPath.c_str(), nullptr) != 1) {
+        X509_STORE_free(result);
+        throw SGXException(FAIL_TO_VERIFY_CERTIFICATE, "Could not load root CA from " + _caPath);
+    }
+
+    if (!_crlPath.empty() && access(_crlPath.c_str(), F_OK) == 0) {
+        auto lookup = X509_STORE_add_lookup(result, X509_LOOKUP_file());
+        if (!lookup || X509_load_crl_file(lookup, _crlPath.c_str(), X509_FILETYPE_PEM) <= 0) {
+            X509_STORE_free(result);
+            throw SGXException(FAIL_TO_VERIFY_CERTIFICATE, "Could not load CRL from " + _crlPath);
+        }
+        X509_STORE_set_flags(result, X509_V_FLAG_CRL_CHECK);
+        spdlog::info("Loaded CRL from {}", _crlPath);
+    }
+
+    return result;
+}
+
+void CertVerifier::init(const string &_caPath, const string &_crlPath) {
+    auto newStore = loadStore(_caPath, _crlPath);
+
+    unique_lock<shared_timed_mutex> lock(storeMutex);
+    if (store) {
+        X509_STORE_free(store);
+    }
+    store = newStore;
+    caPath = _caPath;
+    crlPath = _crlPath;
+    crlMTime = getMTime(_crlPath);
+    nextCrlCheck = time(nullptr) + CERT_CRL_CHECK_INTERVAL_SECONDS;
+    storeGeneration++;
+}
+
+bool CertVerifier::isInited() {
+    shared_lock<shared_timed_mutex> lock(storeMutex);
+    return store != nullptr;
+}
+
+bool CertVerifier::checkRevocations() {
+    auto now = (int64_t) time(nullptr);
+    auto next = nextCrlCheck.load();
+
+    // one thread per interval looks at the file
+    if (now < next || !nextCrlCheck.compare_exchange_strong(next, now + CERT_CRL_CHECK_INTERVAL_SECONDS)) {
+        return false;
+    }
+
+    string ca, crl;
+    {
+        shared_lock<shared_timed_mutex> lock(storeMutex);
+        if (!store || getMTime(crlPath) == crlMTime) {
+            return false;
+        }
+        ca = caPath;
+        crl = crlPath;
+    }
+
+    try {
+        init(ca, crl);
+    } catch (SGXException &e) {
+        // keep the old store, the file may be in the middle of being replaced
+        spdlog::error("Could not reload CRL: {}", e.getMessage());
+        return false;
+    }
+
+    crlReloads++;
+    return true;
+}
+
+bool CertVerifier::verify(X509 *_cert, int64_t &_expiresAt) {
+    CHECK_STATE(_cert);
+
+    auto ctx = X509_STORE_CTX_new();
+    CHECK_STATE(ctx);
+
+    int result;
+    {
+        shared_lock<shared_timed_mutex> lock(storeMutex);
+        CHECK_STATE(store);
+        CHECK_STATE(X509_STORE_CTX_init(ctx, store, _cert, nullptr) == 1);
+        result = X509_verify_cert(ctx);
+    }
+
+    if (result != 1) {
+        spdlog::error("Client cert verification failed: {}",
+                      X509_verify_cert_error_string(X509_STORE_CTX_get_error(ctx)));
+    }
+
+    X509_STORE_CTX_free(ctx);
+
+    if (result != 1) {
+        failed++;
+        return false;
+    }
+
+    int days = 0, seconds = 0;
+    CHECK_STATE(ASN1_TIME_diff(&days, &seconds, nullptr, X509_get0_notAfter(_cert)) == 1);
+    _expiresAt = (int64_t) time(nullptr) + (int64_t) days * 86400 + seconds;
+
+    verified++;
+    return true;
+}
+
+bool CertVerifier::verifyFile(const string &_caPath, const string &_certPath) {
+    auto fp = fopen(_certPath.c_str(), "r");
+    if (!fp) {
+        return false;
+    }
+    auto cert = PEM_read_X509(fp, nullptr, nullptr, nullptr);
+    fclose(fp);
+    if (!cert) {
+        return false;
+    }
+
+    auto caStore = loadStore(_caPath, "");
+    auto ctx = X509_STORE_CTX_new();
+    CHECK_STATE(ctx);
+
+    bool result = X509_STORE_CTX_init(ctx, caStore, cert, nullptr) == 1 && X509_verify_cert(ctx) == 1;
+
+    X509_STORE_CTX_free(ctx);
+    X509_STORE_free(caStore);
+    X509_free(cert);
+
+    return result;
+}
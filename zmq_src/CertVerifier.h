@@ -0,0 +1,93 @@
+/*
+    Copyright (C) 2021-Present SKALE Labs
+
+    This file is part of sgxwallet.
+
+    sgxwallet is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as published
+    by the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    sgxwallet is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with sgxwallet. If not, see <https://www.gnu.org/licenses/>.
+
+    @file CertVerifier.h
+    @author Stan Kladko
+    @date 2021
+*/
+
+#pragma once
+
+#include <atomic>
+#include <shared_mutex>
+#include <string>
+
+#include <openssl/x509.h>
+#include <openssl/x509_vfy.h>
+
+using namespace std;
+
+// Verifies client certs against the root CA in process, with an X509_STORE that is loaded once.
+//
+// If a CRL file exists next to the root CA, it is loaded into the store and every cert is checked
+// against it. The file is looked at again every CERT_CRL_CHECK_INTERVAL_SECONDS. When it changed,
+// the store is rebuilt and checkRevocations returns true, so callers can drop certs they verified
+// with the old CRL.
+class CertVerifier {
+
+    static shared_timed_mutex storeMutex;
+
+    static X509_STORE *store;
+
+    static string caPath;
+
+    static string crlPath;
+
+    // modification time of the CRL file the store was built with, 0 if there was none
+    static int64_t crlMTime;
+
+    static atomic<int64_t> nextCrlCheck;
+
+    static atomic<uint64_t> verified;
+
+    static atomic<uint64_t> failed;
+
+    static atomic<uint64_t> crlReloads;
+
+    // incremented every time the store is built
+    static atomic<uint64_t> storeGeneration;
+
+    static X509_STORE *loadStore(const string &_caPath, const string &_crlPath);
+
+    static int64_t getMTime(const string &_path);
+
+public:
+
+    static void init(const string &_caPath, const string &_crlPath);
+
+    // true if the cert chains up to the root CA and is not revoked. _expiresAt is set to the
+    // notAfter time of the cert, in seconds since the epoch
+    static bool verify(X509 *_cert, int64_t &_expiresAt);
+
+    // verifies a PEM cert file against a PEM root CA file, without a CRL
+    static bool verifyFile(const string &_caPath, const string &_certPath);
+
+    // rebuilds the store if the CRL file changed, returns true if it did
+    static bool checkRevocations();
+
+    static bool isInited();
+
+    static uint64_t getVerified() { return verified.load(); }
+
+    static uint64_t getFailed() { return failed.load(); }
+
+    static uint64_t getCrlReloads() { return crlReloads.load(); }
+
+    // changes when init or a CRL reload replaces the store, so certs verified before can be dropped
+    static uint64_t getStoreGeneration() { return storeGeneration.load(); }
+};
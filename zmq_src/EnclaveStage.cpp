@@ -0,0 +1,108 @@
+/*
+    Copyright (C) 2021-Present SKALE Labs
+
+    This file is part of sgxwallet.
+
+    sgxwallet is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as published
+    by the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    sgxwallet is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with sgxwallet. If not, see <https://www.gnu.org/licenses/>.
+
+    @file EnclaveStage.cpp
+    @author Stan Kladko
+    @date 2021
+*/
+
+#include "common.h"
+#include "third_party/spdlog/spdlog.h"
+
+#include "EnclaveStage.h"
+
+EnclaveStage::EnclaveStage(uint64_t _numThreads, uint64_t _capacity, const function<void(uint64_t)> &_initThread,
+                           const string &_name)
+        : capacity(_capacity), name(_name), stopped(false) {
+    CHECK_STATE(_numThreads > 0);
+    CHECK_STATE(_capacity > 0);
+
+    for (uint64_t i = 0; i < _numThreads; i++) {
+        threads.emplace_back(&EnclaveStage::loop, this, i, _initThread);
+    }
+
+    spdlog::info("Started {} ZMQ {} stage threads", _numThreads, name);
+}
+
+EnclaveStage::~EnclaveStage() {
+    stop();
+}
+
+bool EnclaveStage::post(function<void()> &_task) {
+    {
+        lock_guard<mutex> lock(m);
+        if (stopped || tasks.size() >= capacity) {
+            return false;
+        }
+        tasks.push_back(move(_task));
+    }
+
+    cond.notify_one();
+    return true;
+}
+
+void EnclaveStage::stop() {
+    {
+        lock_guard<mutex> lock(m);
+        if (stopped) {
+            return;
+        }
+        stopped = true;
+        tasks.clear();
+    }
+
+    cond.notify_all();
+
+    for (auto &&t : threads) {
+        if (t.joinable()) {
+            t.join();
+        }
+    }
+}
+
+uint64_t EnclaveStage::getQueued() {
+    lock_guard<mutex> lock(m);
+    return tasks.size();
+}
+
+void EnclaveStage::loop(uint64_t _threadIndex, function<void(uint64_t)> _initThread) {
+    if (_initThread) {
+        _initThread(_threadIndex);
+    }
+
+    while (true) {
+        function<void()> task;
+
+        {
+            unique_lock<mutex> lock(m);
+            cond.wait(lock, [this]() { return stopped || !tasks.empty(); });
+            if (stopped) {
+                return;
+            }
+            task = move(tasks.front());
+            tasks.pop_front();
+        }
+
+        // the task handles the errors of its request and sends the reply
+        try {
+            task();
+        } catch (exception &e) {
+            spdlog::error("Exception in ZMQ {} stage: {}", name, e.what());
+        }
+    }
+}
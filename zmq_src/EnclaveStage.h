@@ -0,0 +1,79 @@
+/*
+    Copyright (C) 2021-Present SKALE Labs
+
+    This file is part of sgxwallet.
+
+    sgxwallet is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as published
+    by the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    sgxwallet is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with sgxwallet. If not, see <https://www.gnu.org/licenses/>.
+    @file EnclaveStage.h
+    @author Stan Kladko
+    @date 2021
+*/
+
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+// Threads that run the enclave part of ZMQ sign requests.
+//
+// Workers parse requests and verify their signatures, then hand the rest of the request,
+// the key lookup and the ECALL, to a stage thread together with sending the reply, and take
+// the next request. Host work of many requests then overlaps with ECALLs on a few threads,
+// and only the stage threads enter the enclave for sign requests. The queue is bounded, a
+// worker that finds it full processes the request itself.
+//
+// The same pool runs the CPU stage of the ZMQ server, which processes requests that need no
+// enclave, see ZMQMessage::isPublicRequest. Its threads never take a TCS.
+class EnclaveStage {
+
+public:
+
+    // _initThread is called on each stage thread with its index before it takes tasks,
+    // _name is used in the log
+    EnclaveStage(uint64_t _numThreads, uint64_t _capacity, const function<void(uint64_t)> &_initThread,
+                 const string &_name = "enclave");
+
+    ~EnclaveStage();
+
+    // takes _task and returns true, or returns false and leaves _task alone if the queue is full
+    bool post(function<void()> &_task);
+
+    // tasks still queued are dropped
+    void stop();
+
+    uint64_t getQueued();
+
+private:
+
+    const uint64_t capacity;
+
+    const string name;
+
+    mutex m;
+    condition_variable cond;
+    deque<function<void()>> tasks;
+    bool stopped;
+
+    vector<thread> threads;
+
+    void loop(uint64_t _threadIndex, function<void(uint64_t)> _initThread);
+};
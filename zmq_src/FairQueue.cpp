@@ -0,0 +1,135 @@
+/*
+    Copyright (C) 2021-Present SKALE Labs
+
+    This file is part of sgxwallet.
+
+    sgxwallet is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as published
+    by the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    sgxwallet is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with sgxwallet. If not, see <https://www.gnu.org/licenses/>.
+
+    @file FairQueue.cpp
+    @author Stan Kladko
+    @date 2021
+*/
+
+#include "common.h"
+
+#include "FairQueue.h"
+
+FairQueue::FairQueue(uint64_t _quantum, uint64_t _maxPerClient, uint64_t _maxTotal)
+        : quantum(_quantum), maxPerClient(_maxPerClient), maxTotal(_maxTotal), total(0), numPartitions(0) {
+    CHECK_STATE(_quantum > 0);
+    CHECK_STATE(_maxPerClient > 0);
+}
+
+bool FairQueue::push(const string &_clientId, IncomingRequest &_element, const string &_partition,
+                     uint64_t _weight) {
+    CHECK_STATE(_element.msg);
+    CHECK_STATE(_weight > 0);
+
+    if (total >= maxTotal) {
+        return false;
+    }
+
+    auto &partition = partitions[_partition];
+    auto &client = partition.clients[_clientId];
+
+    if (client.requests.size() >= maxPerClient) {
+        return false;
+    }
+
+    if (partition.active.empty()) {
+        activePartitions.push_back(_partition);
+        numPartitions++;
+    }
+
+    if (client.requests.empty()) {
+        partition.active.push_back(_clientId);
+    }
+
+    // weights may be changed at runtime, the latest one applies from the next round
+    partition.weight = _weight;
+
+    client.requests.push_back(move(_element));
+    total++;
+
+    return true;
+}
+
+FairQueue::ClientQueue &FairQueue::nextClient(Partition &_partition) {
+    while (true) {
+        CHECK_STATE(!_partition.active.empty());
+        auto it = _partition.clients.find(_partition.active.front());
+        CHECK_STATE(it != _partition.clients.end() && !it->second.requests.empty());
+
+        auto &client = it->second;
+
+        if (client.newRound) {
+            client.deficit += quantum;
+            client.newRound = false;
+        }
+
+        if (client.requests.front().msg->size() <= client.deficit) {
+            return client;
+        }
+
+        // the rest of the deficit is kept for the next round
+        client.newRound = true;
+        _partition.active.push_back(move(_partition.active.front()));
+        _partition.active.pop_front();
+    }
+}
+
+bool FairQueue::pop(IncomingRequest &_element) {
+    while (!activePartitions.empty()) {
+        auto it = partitions.find(activePartitions.front());
+        CHECK_STATE(it != partitions.end() && !it->second.active.empty());
+
+        auto &partition = it->second;
+
+        if (partition.newRound) {
+            partition.deficit += quantum * partition.weight;
+            partition.newRound = false;
+        }
+
+        auto &client = nextClient(partition);
+        uint64_t cost = client.requests.front().msg->size();
+
+        if (cost > partition.deficit) {
+            partition.newRound = true;
+            activePartitions.push_back(move(activePartitions.front()));
+            activePartitions.pop_front();
+            continue;
+        }
+
+        partition.deficit -= cost;
+        client.deficit -= cost;
+        _element = move(client.requests.front());
+        client.requests.pop_front();
+        total--;
+
+        if (client.requests.empty()) {
+            partition.clients.erase(partition.active.front());
+            partition.active.pop_front();
+        }
+
+        if (partition.active.empty()) {
+            partitions.erase(it);
+            activePartitions.pop_front();
+            numPartitions--;
+        }
+
+        return true;
+    }
+
+    return false;
+}
@@ -0,0 +1,93 @@
+/*
+    Copyright (C) 2021-Present SKALE Labs
+
+    This file is part of sgxwallet.
+
+    sgxwallet is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as published
+    by the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    sgxwallet is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with sgxwallet. If not, see <https://www.gnu.org/licenses/>.
+
+    @file FairQueue.h
+    @author Stan Kladko
+    @date 2021
+*/
+
+#pragma once
+
+#include <atomic>
+#include <deque>
+#include <string>
+#include <unordered_map>
+
+#include "RequestScheduler.h"
+
+using namespace std;
+
+// Deficit round robin over the sign requests of ZMQ clients, used by the router thread only.
+//
+// Requests wait here until the scheduler has room for them, so when the server is saturated each
+// client gets an equal share of the sign workers, whatever the number of requests it sends. The
+// cost of a request is its size in bytes, which makes a batch sign request of many hashes count
+// for more than a single sign request. Each client gets quantum bytes per round.
+//
+// Clients are scheduled within partitions, see SchainPartitions.h. The partitions are served in
+// deficit round robin order too, with weight * quantum bytes per round, and the clients of a
+// partition share what it gets. With a single partition this is plain per client fair queuing.
+class FairQueue {
+
+    struct ClientQueue {
+        deque<IncomingRequest> requests;
+        uint64_t deficit = 0;
+        bool newRound = true;
+    };
+
+    struct Partition {
+        unordered_map<string, ClientQueue> clients;
+        // clients with queued requests in round robin order
+        deque<string> active;
+        uint64_t weight = 1;
+        uint64_t deficit = 0;
+        bool newRound = true;
+    };
+
+    const uint64_t quantum;
+    const uint64_t maxPerClient;
+    const uint64_t maxTotal;
+
+    unordered_map<string, Partition> partitions;
+
+    // partitions with queued requests in round robin order
+    deque<string> activePartitions;
+
+    // read by the metrics threads
+    atomic<uint64_t> total;
+
+    atomic<uint64_t> numPartitions;
+
+    // moves the client that is served next to the front of the partition and returns it
+    ClientQueue &nextClient(Partition &_partition);
+
+public:
+
+    FairQueue(uint64_t _quantum, uint64_t _maxPerClient, uint64_t _maxTotal);
+
+    // returns false without queueing the request if the client or the queue is full
+    bool push(const string &_clientId, IncomingRequest &_element, const string &_partition = "",
+              uint64_t _weight = 1);
+
+    bool pop(IncomingRequest &_element);
+
+    uint64_t size() const { return total.load(); }
+
+    // partitions with queued requests
+    uint64_t getNumPartitions() const { return numPartitions.load(); }
+};
@@ -0,0 +1,151 @@
+/*
+    Copyright (C) 2021-Present SKALE Labs
+
+    This file is part of sgxwallet.
+
+    sgxwallet is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as published
+    by the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    sgxwallet is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with sgxwallet. If not, see <https://www.gnu.org/licenses/>.
+
+    @file KeyOwnerIndex.cpp
+    @author Stan Kladko
+    @date 2021
+*/
+
+#include "third_party/spdlog/spdlog.h"
+#include <third_party/cryptlite/sha256.h>
+
+#include "common.h"
+#include "sgxwallet_common.h"
+#include "SGXException.h"
+#include "LevelDB.h"
+
+#include "KeyOwnerIndex.h"
+
+static const string OWNER_SUFFIX = ":OWNER";
+
+static constexpr uint64_t OWNER_SCAN_PAGE_SIZE = 10000;
+
+static bool isCertHash(const string &_value) {
+    return _value.size() == 64 && _value.find_first_not_of("0123456789abcdef") == string::npos;
+}
+
+KeyOwnerIndex::Shard &KeyOwnerIndex::getShard(const string &_keyName) {
+    return shards[hash<string>()(_keyName) % NUM_SHARDS];
+}
+
+const KeyOwnerIndex::Shard &KeyOwnerIndex::getShard(const string &_keyName) const {
+    return shards[hash<string>()(_keyName) % NUM_SHARDS];
+}
+
+void KeyOwnerIndex::load() {
+    auto &db = LevelDB::getLevelDb();
+    CHECK_STATE(db);
+
+    uint64_t loaded = 0;
+    uint64_t legacy = 0;
+
+    // owner records are suffixed, not prefixed, so the whole database is scanned once
+    string cursor;
+
+    while (true) {
+        auto page = db->getKeysPage("", cursor, OWNER_SCAN_PAGE_SIZE);
+
+        if (page.empty()) {
+            break;
+        }
+
+        cursor = page.back().first;
+
+        for (auto &&entry : page) {
+            auto &key = entry.first;
+
+            if (key.size() <= OWNER_SUFFIX.size() ||
+                key.compare(key.size() - OWNER_SUFFIX.size(), OWNER_SUFFIX.size(), OWNER_SUFFIX) != 0) {
+                continue;
+            }
+
+            auto value = LevelDB::decodeValue(entry.second);
+
+            // records of older versions keep the full PEM. They are hashed in memory only and
+            // stay as they are, so that an older version still matches their owners
+            if (!isCertHash(value)) {
+                value = cryptlite::sha256::hash_hex(value);
+                legacy++;
+            }
+
+            auto keyName = key.substr(0, key.size() - OWNER_SUFFIX.size());
+            auto &shard = getShard(keyName);
+            unique_lock<shared_timed_mutex> lock(shard.m);
+            shard.owners[keyName] = value;
+            loaded++;
+        }
+    }
+
+    spdlog::info("Loaded {} key owners, {} of them with the full owner cert", loaded, legacy);
+}
+
+string KeyOwnerIndex::get(const string &_keyName) const {
+    auto &shard = getShard(_keyName);
+    shared_lock<shared_timed_mutex> lock(shard.m);
+    auto it = shard.owners.find(_keyName);
+    if (it == shard.owners.end())
+        return "";
+    return it->second;
+}
+
+bool KeyOwnerIndex::exists(const string &_keyName) const {
+    auto &shard = getShard(_keyName);
+    shared_lock<shared_timed_mutex> lock(shard.m);
+    return shard.owners.count(_keyName) > 0;
+}
+
+void KeyOwnerIndex::add(const string &_keyName, const string &_certHash) {
+    CHECK_STATE(isCertHash(_certHash));
+
+    auto &shard = getShard(_keyName);
+
+    // the lock is held over the write, so concurrent first requests for a key can not both own it
+    unique_lock<shared_timed_mutex> lock(shard.m);
+
+    if (shard.owners.count(_keyName) > 0) {
+        throw SGXException(KEY_NAME_ALREADY_EXISTS, string(__FUNCTION__) + ":Name already exists" + _keyName);
+    }
+
+    LevelDB::getLevelDb()->writeDataUnique(getOwnerKeyName(_keyName), _certHash);
+
+    shard.owners.emplace(_keyName, _certHash);
+}
+
+void KeyOwnerIndex::set(const string &_keyName, const string &_owner) {
+    // a leader that has not loaded its owners yet still keeps the PEM of older versions
+    auto certHash = isCertHash(_owner) ? _owner : cryptlite::sha256::hash_hex(_owner);
+
+    auto &shard = getShard(_keyName);
+    unique_lock<shared_timed_mutex> lock(shard.m);
+    shard.owners[_keyName] = certHash;
+}
+
+void KeyOwnerIndex::remove(const string &_keyName) {
+    auto &shard = getShard(_keyName);
+    unique_lock<shared_timed_mutex> lock(shard.m);
+    shard.owners.erase(_keyName);
+}
+
+uint64_t KeyOwnerIndex::size() const {
+    uint64_t result = 0;
+    for (auto &&shard : shards) {
+        shared_lock<shared_timed_mutex> lock(shard.m);
+        result += shard.owners.size();
+    }
+    return result;
+}
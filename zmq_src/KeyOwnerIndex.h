@@ -0,0 +1,77 @@
+/*
+    Copyright (C) 2021-Present SKALE Labs
+
+    This file is part of sgxwallet.
+
+    sgxwallet is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as published
+    by the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    sgxwallet is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with sgxwallet. If not, see <https://www.gnu.org/licenses/>.
+
+    @file KeyOwnerIndex.h
+    @author Stan Kladko
+    @date 2021
+*/
+
+#pragma once
+
+#include <array>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <unordered_map>
+
+using namespace std;
+
+// In-memory copy of the <keyName>:OWNER records, which map a key to the sha256 hash
+// of the PEM of the cert that created it. Loaded from LevelDB at startup, so ownership
+// checks of ZMQ requests do not read the database. Shards are locked independently.
+class KeyOwnerIndex {
+
+public:
+
+    static constexpr uint64_t NUM_SHARDS = 16;
+
+    static string getOwnerKeyName(const string &_keyName) { return _keyName + ":OWNER"; }
+
+    // scans the database for owner records. Records of older versions that keep the full PEM
+    // are hashed in memory, the database is not changed
+    void load();
+
+    // empty if the key has no owner
+    string get(const string &_keyName) const;
+
+    bool exists(const string &_keyName) const;
+
+    // writes the owner record, throws KEY_NAME_ALREADY_EXISTS if the key already has an owner
+    void add(const string &_keyName, const string &_certHash);
+
+    // takes an owner record that is already in the database, replicated from the leader
+    void set(const string &_keyName, const string &_owner);
+
+    // forgets the owner of a key, the owner record has to be deleted by the caller
+    void remove(const string &_keyName);
+
+    uint64_t size() const;
+
+private:
+
+    struct Shard {
+        mutable shared_timed_mutex m;
+        unordered_map<string, string> owners;
+    };
+
+    array<Shard, NUM_SHARDS> shards;
+
+    Shard &getShard(const string &_keyName);
+
+    const Shard &getShard(const string &_keyName) const;
+};
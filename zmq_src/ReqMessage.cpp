@@ -24,57 +24,113 @@
 
 #include "SGXWalletServer.hpp"
 
+#include "LevelDB.h"
+#include "ZMQClient.h"
 #include "ReqMessage.h"
 
 #include "third_party/spdlog/spdlog.h"
 
 Json::Value ECDSASignReqMessage::process() {
+    auto params = getParams<EcdsaSignMessageHashParams>();
+    string keyName(params.keyName);
+    if (checkKeyOwnership) {
+        if (!isKeyRegistered(keyName)) {
+            addKeyByOwner(keyName, getCertHash());
+        } else {
+            if (!isKeyByOwner(keyName, getCertHash())) {
+                spdlog::error("Cert {} try to access key {} which does not belong to it", getStringRapid("cert"), keyName);
+                throw std::invalid_argument("Only owner of the key can access it");
+            }
+        }
+    }
+    auto result = SGXWalletServer::ecdsaSignMessageHashImpl(params.base, keyName, string(params.messageHash));
+    result["type"] = ZMQMessage::ECDSA_SIGN_RSP;
+    return result;
+}
+
+Json::Value ECDSASignBatchReqMessage::process() {
     auto base = getInt64Rapid("base");
     auto keyName = getStringRapid("keyName");
-    auto hash = getStringRapid("messageHash");
+    auto hashes = getJsonValueRapid("messageHashes");
     if (checkKeyOwnership) {
         if (!isKeyRegistered(keyName)) {
-            addKeyByOwner(keyName, getStringRapid("cert"));
+            addKeyByOwner(keyName, getCertHash());
         } else {
-            if (!isKeyByOwner(keyName, getStringRapid("cert"))) {
+            if (!isKeyByOwner(keyName, getCertHash())) {
                 spdlog::error("Cert {} try to access key {} which does not belong to it", getStringRapid("cert"), keyName);
                 throw std::invalid_argument("Only owner of the key can access it");
             }
         }
     }
-    auto result = SGXWalletServer::ecdsaSignMessageHashImpl(base, keyName, hash);
-    result["type"] = ZMQMessage::ECDSA_SIGN_RSP;
+    auto result = SGXWalletServer::ecdsaSignMessageHashBatchImpl(base, keyName, hashes);
+    result["type"] = ZMQMessage::ECDSA_SIGN_BATCH_RSP;
     return result;
 }
 
 Json::Value BLSSignReqMessage::process() {
-    auto keyName = getStringRapid("keyShareName");
-    auto hash = getStringRapid("messageHash");
-    auto t = getInt64Rapid("t");
-    auto n = getInt64Rapid("n");
+    auto params = getParams<BlsSignMessageHashParams>();
+    string keyName(params.keyShareName);
     if (checkKeyOwnership) {
         if (!isKeyRegistered(keyName)) {
-            addKeyByOwner(keyName, getStringRapid("cert"));
+            addKeyByOwner(keyName, getCertHash());
         } else {
-            if (!isKeyByOwner(keyName, getStringRapid("cert"))) {
+            if (!isKeyByOwner(keyName, getCertHash())) {
                 spdlog::error("Cert {} try to access key {} which does not belong to it", getStringRapid("cert"), keyName);
                 throw std::invalid_argument("Only owner of the key can access it");
             }
         }
     }
-    auto result = SGXWalletServer::blsSignMessageHashImpl(keyName, hash, t, n);
+    auto result = SGXWalletServer::blsSignMessageHashImpl(keyName, string(params.messageHash), params.t, params.n);
     result["type"] = ZMQMessage::BLS_SIGN_RSP;
     return result;
 }
 
+Json::Value BLSSignHashedPointReqMessage::process() {
+    auto params = getParams<BlsSignHashedPointParams>();
+    string keyName(params.keyShareName);
+    if (checkKeyOwnership) {
+        if (!isKeyRegistered(keyName)) {
+            addKeyByOwner(keyName, getCertHash());
+        } else {
+            if (!isKeyByOwner(keyName, getCertHash())) {
+                spdlog::error("Cert {} try to access key {} which does not belong to it", getStringRapid("cert"), keyName);
+                throw std::invalid_argument("Only owner of the key can access it");
+            }
+        }
+    }
+    auto result = SGXWalletServer::blsSignHashedPointImpl(keyName, string(params.hashedPoint), string(params.hint));
+    result["type"] = ZMQMessage::BLS_SIGN_HASHED_POINT_RSP;
+    return result;
+}
+
+Json::Value BLSSignBatchReqMessage::process() {
+    auto requests = getJsonValueRapid("requests");
+    if (checkKeyOwnership && requests.isArray()) {
+        auto cert = getStringRapid("cert");
+        for (uint64_t i = 0; i < requests.size(); i++) {
+            auto keyName = requests[(int) i]["keyShareName"].asString();
+            if (!isKeyRegistered(keyName)) {
+                addKeyByOwner(keyName, getCertHash());
+            } else {
+                if (!isKeyByOwner(keyName, getCertHash())) {
+                    spdlog::error("Cert {} try to access key {} which does not belong to it", cert, keyName);
+                    throw std::invalid_argument("Only owner of the key can access it");
+                }
+            }
+        }
+    }
+    auto result = SGXWalletServer::blsSignMessageHashBatchImpl(requests);
+    result["type"] = ZMQMessage::BLS_SIGN_BATCH_RSP;
+    return result;
+}
+
 Json::Value importBLSReqMessage::process() {
     auto keyName = getStringRapid("keyShareName");
     auto keyShare = getStringRapid("keyShare");
     auto result = SGXWalletServer::importBLSKeyShareImpl(keyShare, keyName);
     if (checkKeyOwnership && result["status"] == 0) {
         spdlog::info("Cert {} creates key {}", getStringRapid("cert"), keyName);
-        auto cert = getStringRapid("cert");
-        addKeyByOwner(keyName, cert);
+        addKeyByOwner(keyName, getCertHash());
     }
     result["type"] = ZMQMessage::IMPORT_BLS_RSP;
     return result;
@@ -87,19 +143,51 @@ Json::Value importECDSAReqMessage::process() {
     if (checkKeyOwnership && result["status"] == 0) {
         auto cert = getStringRapid("cert");
         spdlog::info("Cert {} creates key {}", cert, keyName);
-        addKeyByOwner(keyName, cert);
+        addKeyByOwner(keyName, getCertHash());
     }
     result["type"] = ZMQMessage::IMPORT_ECDSA_RSP;
     return result;
 }
 
+Json::Value importBLSBatchReqMessage::process() {
+    auto keyShares = getJsonValueRapid("keyShares");
+    auto result = SGXWalletServer::importBLSKeyShareBatchImpl(keyShares);
+    if (checkKeyOwnership && result["status"] == 0) {
+        for (int i = 0; i < (int) result["results"].size(); i++) {
+            if (result["results"][i]["status"] == 0) {
+                auto keyName = keyShares[i]["keyShareName"].asString();
+                spdlog::info("Cert {} creates key {}", getStringRapid("cert"), keyName);
+                addKeyByOwner(keyName, getCertHash());
+            }
+        }
+    }
+    result["type"] = ZMQMessage::IMPORT_BLS_BATCH_RSP;
+    return result;
+}
+
+Json::Value importECDSABatchReqMessage::process() {
+    auto keys = getJsonValueRapid("keys");
+    auto result = SGXWalletServer::importECDSAKeyBatchImpl(keys);
+    if (checkKeyOwnership && result["status"] == 0) {
+        for (int i = 0; i < (int) result["results"].size(); i++) {
+            if (result["results"][i]["status"] == 0) {
+                auto keyName = keys[i]["keyName"].asString();
+                spdlog::info("Cert {} creates key {}", getStringRapid("cert"), keyName);
+                addKeyByOwner(keyName, getCertHash());
+            }
+        }
+    }
+    result["type"] = ZMQMessage::IMPORT_ECDSA_BATCH_RSP;
+    return result;
+}
+
 Json::Value generateECDSAReqMessage::process() {
     auto result = SGXWalletServer::generateECDSAKeyImpl();
     string keyName = result["keyName"].asString();
     if (checkKeyOwnership && result["status"] == 0) {
         auto cert = getStringRapid("cert");
         spdlog::info("Cert {} creates key {}", cert, keyName);
-        addKeyByOwner(keyName, cert);
+        addKeyByOwner(keyName, getCertHash());
     }
     result["type"] = ZMQMessage::GENERATE_ECDSA_RSP;
     return result;
@@ -107,7 +195,7 @@ Json::Value generateECDSAReqMessage::process() {
 
 Json::Value getPublicECDSAReqMessage::process() {
     auto keyName = getStringRapid("keyName");
-    if (checkKeyOwnership && !isKeyByOwner(keyName, getStringRapid("cert"))) {
+    if (checkKeyOwnership && !isKeyByOwner(keyName, getCertHash())) {
         spdlog::error("Cert {} try to access key {} which does not belong to it", getStringRapid("cert"), keyName);
         throw std::invalid_argument("Only owner of the key can access it");
     }
@@ -123,15 +211,30 @@ Json::Value generateDKGPolyReqMessage::process() {
     if (checkKeyOwnership && result["status"] == 0) {
         auto cert = getStringRapid("cert");
         spdlog::info("Cert {} creates key {}", cert, polyName);
-        addKeyByOwner(polyName, cert);
+        addKeyByOwner(polyName, getCertHash());
     }
     result["type"] = ZMQMessage::GENERATE_DKG_POLY_RSP;
     return result;
 }
 
+Json::Value generateDKGPolyBatchReqMessage::process() {
+    auto polyNames = getJsonValueRapid("polyNames");
+    auto t = getInt64Rapid("t");
+    auto result = SGXWalletServer::generateDKGPolyBatchImpl(polyNames, t);
+    if (checkKeyOwnership && result["status"] == 0) {
+        auto cert = getStringRapid("cert");
+        for (auto &&polyName : polyNames) {
+            spdlog::info("Cert {} creates key {}", cert, polyName.asString());
+            addKeyByOwner(polyName.asString(), getCertHash());
+        }
+    }
+    result["type"] = ZMQMessage::GENERATE_DKG_POLY_BATCH_RSP;
+    return result;
+}
+
 Json::Value getVerificationVectorReqMessage::process() {
     auto polyName = getStringRapid("polyName");
-    if (checkKeyOwnership && !isKeyByOwner(polyName, getStringRapid("cert"))) {
+    if (checkKeyOwnership && !isKeyByOwner(polyName, getCertHash())) {
         spdlog::error("Cert {} try to access key {} which does not belong to it", getStringRapid("cert"), polyName);
         throw std::invalid_argument("Only owner of the key can access it");
     }
@@ -146,7 +249,7 @@ Json::Value getSecretShareReqMessage::process() {
     auto t = getInt64Rapid("t");
     auto n = getInt64Rapid("n");
     auto pubKeys = getJsonValueRapid("publicKeys");
-    if (checkKeyOwnership && !isKeyByOwner(polyName, getStringRapid("cert"))) {
+    if (checkKeyOwnership && !isKeyByOwner(polyName, getCertHash())) {
         spdlog::error("Cert {} try to access key {} which does not belong to it", getStringRapid("cert"), polyName);
         throw std::invalid_argument("Only owner of the key can access it");
     }
@@ -162,7 +265,7 @@ Json::Value dkgVerificationReqMessage::process() {
     auto idx = getInt64Rapid("index");
     auto pubShares = getStringRapid("publicShares");
     auto secretShare = getStringRapid("secretShare");
-    if (checkKeyOwnership && !isKeyByOwner(ethKeyName, getStringRapid("cert"))) {
+    if (checkKeyOwnership && !isKeyByOwner(ethKeyName, getCertHash())) {
         spdlog::error("Cert {} try to access key {} which does not belong to it", getStringRapid("cert"), ethKeyName);
         throw std::invalid_argument("Only owner of the key can access it");
     }
@@ -171,6 +274,22 @@ Json::Value dkgVerificationReqMessage::process() {
     return result;
 }
 
+Json::Value dkgVerificationBatchReqMessage::process() {
+    auto ethKeyName = getStringRapid("ethKeyName");
+    auto t = getInt64Rapid("t");
+    auto n = getInt64Rapid("n");
+    auto idx = getInt64Rapid("index");
+    auto pubShares = getJsonValueRapid("publicShares");
+    auto secretShares = getJsonValueRapid("secretShares");
+    if (checkKeyOwnership && !isKeyByOwner(ethKeyName, getCertHash())) {
+        spdlog::error("Cert {} try to access key {} which does not belong to it", getStringRapid("cert"), ethKeyName);
+        throw std::invalid_argument("Only owner of the key can access it");
+    }
+    auto result = SGXWalletServer::dkgVerificationBatchImpl(pubShares, ethKeyName, secretShares, t, n, idx);
+    result["type"] = ZMQMessage::DKG_VERIFY_BATCH_RSP;
+    return result;
+}
+
 Json::Value createBLSPrivateKeyReqMessage::process() {
     auto blsKeyName = getStringRapid("blsKeyName");
     auto ethKeyName = getStringRapid("ethKeyName");
@@ -178,7 +297,7 @@ Json::Value createBLSPrivateKeyReqMessage::process() {
     auto secretShare = getStringRapid("secretShare");
     auto t = getInt64Rapid("t");
     auto n = getInt64Rapid("n");
-    if (checkKeyOwnership && (!isKeyByOwner(ethKeyName, getStringRapid("cert")) || !isKeyByOwner(polyName, getStringRapid("cert")))) {
+    if (checkKeyOwnership && (!isKeyByOwner(ethKeyName, getCertHash()) || !isKeyByOwner(polyName, getCertHash()))) {
         spdlog::error("Cert {} try to access keys {} {} which do not belong to it", getStringRapid("cert"), ethKeyName ,polyName);
         throw std::invalid_argument("Only owner of the key can access it");
     }
@@ -186,7 +305,7 @@ Json::Value createBLSPrivateKeyReqMessage::process() {
     if (checkKeyOwnership && result["status"] == 0) {
         auto cert = getStringRapid("cert");
         spdlog::info("Cert {} creates key {}", cert, blsKeyName);
-        addKeyByOwner(blsKeyName, cert);
+        addKeyByOwner(blsKeyName, getCertHash());
     }
     result["type"] = ZMQMessage::CREATE_BLS_PRIVATE_RSP;
     return result;
@@ -194,7 +313,7 @@ Json::Value createBLSPrivateKeyReqMessage::process() {
 
 Json::Value getBLSPublicReqMessage::process() {
     auto blsKeyName = getStringRapid("blsKeyName");
-    if (checkKeyOwnership && !isKeyByOwner(blsKeyName, getStringRapid("cert"))) {
+    if (checkKeyOwnership && !isKeyByOwner(blsKeyName, getCertHash())) {
         spdlog::error("Cert {} try to access key {} which does not belong to it", getStringRapid("cert"), blsKeyName);
         throw std::invalid_argument("Only owner of the key can access it");
     }
@@ -217,7 +336,7 @@ Json::Value complaintResponseReqMessage::process() {
     auto t = getInt64Rapid("t");
     auto n = getInt64Rapid("n");
     auto idx = getInt64Rapid("ind");
-    if (checkKeyOwnership && !isKeyByOwner(polyName, getStringRapid("cert"))) {
+    if (checkKeyOwnership && !isKeyByOwner(polyName, getCertHash())) {
         spdlog::error("Cert {} try to access key {} which does not belong to it", getStringRapid("cert"), polyName);
         throw std::invalid_argument("Only owner of the key can access it");
     }
@@ -233,6 +352,30 @@ Json::Value multG2ReqMessage::process() {
     return result;
 }
 
+Json::Value multG2BatchReqMessage::process() {
+    auto xs = getJsonValueRapid("xs");
+    auto result = SGXWalletServer::multG2BatchImpl(xs);
+    result["type"] = ZMQMessage::MULT_G2_BATCH_RSP;
+    return result;
+}
+
+Json::Value aggregateBLSSignaturesReqMessage::process() {
+    auto shares = getJsonValueRapid("shares");
+    auto signerIndices = getJsonValueRapid("signerIndices");
+    auto t = getInt64Rapid("t");
+    auto n = getInt64Rapid("n");
+    auto result = SGXWalletServer::aggregateBLSSignaturesImpl(shares, signerIndices, t, n);
+    result["type"] = ZMQMessage::AGGREGATE_BLS_SIGNATURES_RSP;
+    return result;
+}
+
+Json::Value verifyBLSSignaturesReqMessage::process() {
+    auto requests = getJsonValueRapid("requests");
+    auto result = SGXWalletServer::verifyBLSSignaturesImpl(requests);
+    result["type"] = ZMQMessage::VERIFY_BLS_SIGNATURES_RSP;
+    return result;
+}
+
 Json::Value isPolyExistsReqMessage::process() {
     auto polyName = getStringRapid("polyName");
     auto result = SGXWalletServer::isPolyExistsImpl(polyName);
@@ -241,7 +384,8 @@ Json::Value isPolyExistsReqMessage::process() {
 }
 
 Json::Value getServerStatusReqMessage::process() {
-    auto result = SGXWalletServer::getServerStatusImpl();
+    // the extended status only adds fields, so existing ZMQ clients keep working
+    auto result = SGXWalletServer::getServerStatusExtendedImpl();
     result["type"] = ZMQMessage::GET_SERVER_STATUS_RSP;
     return result;
 }
@@ -254,7 +398,7 @@ Json::Value getServerVersionReqMessage::process() {
 
 Json::Value deleteBLSKeyReqMessage::process() {
     auto blsKeyName = getStringRapid("blsKeyName");
-    if (checkKeyOwnership && !isKeyByOwner(blsKeyName, getStringRapid("cert"))) {
+    if (checkKeyOwnership && !isKeyByOwner(blsKeyName, getCertHash())) {
         spdlog::error("Cert {} try to access key {} which does not belong to it", getStringRapid("cert"), blsKeyName);
         throw std::invalid_argument("Only owner of the key can access it");
     }
@@ -266,7 +410,7 @@ Json::Value deleteBLSKeyReqMessage::process() {
 Json::Value GetDecryptionShareReqMessage::process() {
     auto blsKeyName = getStringRapid("blsKeyName");
     auto publicDecryptionValues = getJsonValueRapid("publicDecryptionValues");
-    if (checkKeyOwnership && !isKeyByOwner(blsKeyName, getStringRapid("cert"))) {
+    if (checkKeyOwnership && !isKeyByOwner(blsKeyName, getCertHash())) {
         throw std::invalid_argument("Only owner of the key can access it");
     }
     auto result = SGXWalletServer::getDecryptionSharesImpl(blsKeyName, publicDecryptionValues);
@@ -280,7 +424,7 @@ Json::Value generateBLSPrivateKeyReqMessage::process() {
     if (checkKeyOwnership && result["status"] == 0) {
         auto cert = getStringRapid("cert");
         spdlog::info("Cert {} creates key {}", cert, blsKeyName);
-        addKeyByOwner(blsKeyName, cert);
+        addKeyByOwner(blsKeyName, getCertHash());
     }
     result["type"] = ZMQMessage::GENERATE_BLS_PRIVATE_KEY_RSP;
     return result;
@@ -289,10 +433,105 @@ Json::Value generateBLSPrivateKeyReqMessage::process() {
 
 Json::Value popProveReqMessage::process() {
     auto blsKeyName = getStringRapid("blsKeyName");
-    if (checkKeyOwnership && !isKeyByOwner(blsKeyName, getStringRapid("cert"))) {
+    if (checkKeyOwnership && !isKeyByOwner(blsKeyName, getCertHash())) {
         throw std::invalid_argument("Only owner of the key can access it");
     }
     auto result = SGXWalletServer::popProveImpl(blsKeyName);
     result["type"] = ZMQMessage::POP_PROVE_RSP;
     return result;
 }
+
+Json::Value generateBLSPrivateKeyBatchReqMessage::process() {
+    auto blsKeyNames = getJsonValueRapid("blsKeyNames");
+    auto result = SGXWalletServer::generateBLSPrivateKeyBatchImpl(blsKeyNames);
+    if (checkKeyOwnership && result["status"] == 0) {
+        auto cert = getStringRapid("cert");
+        for (auto &&blsKeyName : blsKeyNames) {
+            spdlog::info("Cert {} creates key {}", cert, blsKeyName.asString());
+            addKeyByOwner(blsKeyName.asString(), getCertHash());
+        }
+    }
+    result["type"] = ZMQMessage::GENERATE_BLS_PRIVATE_KEY_BATCH_RSP;
+    return result;
+}
+
+Json::Value popProveBatchReqMessage::process() {
+    auto blsKeyNames = getJsonValueRapid("blsKeyNames");
+    if (checkKeyOwnership) {
+        for (auto &&blsKeyName : blsKeyNames) {
+            if (!blsKeyName.isString() || !isKeyByOwner(blsKeyName.asString(), getCertHash())) {
+                throw std::invalid_argument("Only owner of the key can access it");
+            }
+        }
+    }
+    auto result = SGXWalletServer::popProveBatchImpl(blsKeyNames);
+    result["type"] = ZMQMessage::POP_PROVE_BATCH_RSP;
+    return result;
+}
+
+Json::Value startSessionReqMessage::process() {
+    auto cert = make_shared<string>(getStringRapid("cert"));
+
+    auto verified = getVerifiedCert(getCertHash(), *cert);
+    if (!verified) {
+        throw SGXException(FAIL_TO_VERIFY_CERTIFICATE, string(__FUNCTION__) + ":Cert is expired or revoked");
+    }
+
+    string sessionKey;
+    auto sessionId = sessions.create(cert, verified->notAfter, sessionKey);
+    auto session = sessions.get(sessionId);
+    CHECK_STATE(session);
+
+    // the session key is encrypted to the cert, so only the holder of the cert key can use the session
+    auto handles = ZMQClient::readPublicKeyFromCertStr(*cert);
+    string encryptedSessionKey;
+    try {
+        encryptedSessionKey = ZMQClient::encryptSessionKey(handles.first, sessionKey);
+    } catch (...) {
+        EVP_PKEY_free(handles.first);
+        X509_free(handles.second);
+        throw;
+    }
+    EVP_PKEY_free(handles.first);
+    X509_free(handles.second);
+
+    Json::Value result;
+    result["status"] = 0;
+    result["errorMessage"] = "";
+    result["sessionId"] = sessionId;
+    result["encryptedSessionKey"] = encryptedSessionKey;
+    // the client renews by this, so it is the time left, which is shorter than the TTL near notAfter
+    result["sessionTTL"] = (Json::UInt64) (session->expiresAt - time(nullptr));
+    result["type"] = ZMQMessage::START_SESSION_RSP;
+    return result;
+}
+
+Json::Value registerCurveKeyReqMessage::process() {
+    // the key is taken from the connection, so a client can only register its own curve key
+    auto curveUserId = getStringRapid("curveUserId");
+    auto cert = getStringRapid("cert");
+
+    auto keyName = getCurveKeyName(curveUserId);
+    auto registeredCert = LevelDB::getLevelDb()->readString(keyName);
+
+    int64_t registeredNotAfter = 0;
+    if (registeredCert && decodeCurveBinding(*registeredCert, registeredNotAfter) != cert) {
+        throw std::invalid_argument("Curve key is registered to another cert");
+    }
+
+    // the notAfter of the cert is kept with the binding, which is deleted once the cert expires
+    auto handles = getVerifiedCert(getCertHash(), cert);
+    if (!handles) {
+        throw SGXException(FAIL_TO_VERIFY_CERTIFICATE, string(__FUNCTION__) + ":Could not verify cert");
+    }
+
+    if (!registeredCert || registeredNotAfter == 0) {
+        LevelDB::getLevelDb()->writeString(keyName, encodeCurveBinding(cert, handles->notAfter));
+    }
+
+    Json::Value result;
+    result["status"] = 0;
+    result["errorMessage"] = "";
+    result["type"] = ZMQMessage::REGISTER_CURVE_KEY_RSP;
+    return result;
+}
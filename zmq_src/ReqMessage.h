@@ -43,6 +43,31 @@ public:
 };
 
 
+class ECDSASignBatchReqMessage : public ZMQMessage {
+public:
+
+    ECDSASignBatchReqMessage(shared_ptr <rapidjson::Document> &_d) : ZMQMessage(_d) {};
+
+    virtual Json::Value process();
+};
+
+
+class BLSSignHashedPointReqMessage : public ZMQMessage {
+public:
+    BLSSignHashedPointReqMessage(shared_ptr<rapidjson::Document>& _d) : ZMQMessage(_d) {};
+
+    virtual Json::Value process();
+};
+
+
+class BLSSignBatchReqMessage : public ZMQMessage {
+public:
+    BLSSignBatchReqMessage(shared_ptr<rapidjson::Document>& _d) : ZMQMessage(_d) {};
+
+    virtual Json::Value process();
+};
+
+
 class importBLSReqMessage : public ZMQMessage {
 public:
     importBLSReqMessage(shared_ptr<rapidjson::Document>& _d) : ZMQMessage(_d) {};
@@ -59,6 +84,22 @@ public:
 };
 
 
+class importBLSBatchReqMessage : public ZMQMessage {
+public:
+    importBLSBatchReqMessage(shared_ptr<rapidjson::Document>& _d) : ZMQMessage(_d) {};
+
+    virtual Json::Value process();
+};
+
+
+class importECDSABatchReqMessage : public ZMQMessage {
+public:
+    importECDSABatchReqMessage(shared_ptr<rapidjson::Document>& _d) : ZMQMessage(_d) {};
+
+    virtual Json::Value process();
+};
+
+
 class generateECDSAReqMessage : public ZMQMessage {
 public:
     generateECDSAReqMessage(shared_ptr<rapidjson::Document>& _d) : ZMQMessage(_d) {};
@@ -83,6 +124,14 @@ public:
 };
 
 
+class generateDKGPolyBatchReqMessage : public ZMQMessage {
+public:
+    generateDKGPolyBatchReqMessage(shared_ptr<rapidjson::Document>& _d) : ZMQMessage(_d) {};
+
+    virtual Json::Value process();
+};
+
+
 class getVerificationVectorReqMessage : public ZMQMessage {
 public:
     getVerificationVectorReqMessage(shared_ptr<rapidjson::Document>& _d) : ZMQMessage(_d) {};
@@ -107,6 +156,14 @@ public:
 };
 
 
+class dkgVerificationBatchReqMessage : public ZMQMessage {
+public:
+    dkgVerificationBatchReqMessage(shared_ptr<rapidjson::Document>& _d) : ZMQMessage(_d) {};
+
+    virtual Json::Value process();
+};
+
+
 class createBLSPrivateKeyReqMessage : public ZMQMessage {
 public:
     createBLSPrivateKeyReqMessage(shared_ptr<rapidjson::Document>& _d) : ZMQMessage(_d) {};
@@ -147,6 +204,30 @@ public:
 };
 
 
+class multG2BatchReqMessage : public ZMQMessage {
+public:
+    multG2BatchReqMessage(shared_ptr<rapidjson::Document>& _d) : ZMQMessage(_d) {};
+
+    virtual Json::Value process();
+};
+
+
+class aggregateBLSSignaturesReqMessage : public ZMQMessage {
+public:
+    aggregateBLSSignaturesReqMessage(shared_ptr<rapidjson::Document>& _d) : ZMQMessage(_d) {};
+
+    virtual Json::Value process();
+};
+
+
+class verifyBLSSignaturesReqMessage : public ZMQMessage {
+public:
+    verifyBLSSignaturesReqMessage(shared_ptr<rapidjson::Document>& _d) : ZMQMessage(_d) {};
+
+    virtual Json::Value process();
+};
+
+
 class isPolyExistsReqMessage : public ZMQMessage {
 public:
     isPolyExistsReqMessage(shared_ptr<rapidjson::Document>& _d) : ZMQMessage(_d) {};
@@ -199,4 +280,32 @@ public:
     virtual Json::Value process();
 };
 
+class generateBLSPrivateKeyBatchReqMessage : public ZMQMessage {
+public:
+    generateBLSPrivateKeyBatchReqMessage(shared_ptr<rapidjson::Document>& _d) : ZMQMessage(_d) {};
+
+    virtual Json::Value process();
+};
+
+class popProveBatchReqMessage : public ZMQMessage {
+public:
+    popProveBatchReqMessage(shared_ptr<rapidjson::Document>& _d) : ZMQMessage(_d) {};
+
+    virtual Json::Value process();
+};
+
+class startSessionReqMessage : public ZMQMessage {
+public:
+    startSessionReqMessage(shared_ptr<rapidjson::Document>& _d) : ZMQMessage(_d) {};
+
+    virtual Json::Value process();
+};
+
+class registerCurveKeyReqMessage : public ZMQMessage {
+public:
+    registerCurveKeyReqMessage(shared_ptr<rapidjson::Document>& _d) : ZMQMessage(_d) {};
+
+    virtual Json::Value process();
+};
+
 #endif //SGXWALLET_REQMESSAGE_H
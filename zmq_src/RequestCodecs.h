@@ -0,0 +1,1576 @@
+/*
+    Copyright (C) 2021-Present SKALE Labs
+
+    This file is part of sgxwallet.
+
+    sgxwallet is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as published
+    by the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    sgxwallet is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with sgxwallet.  If not, see <https://www.gnu.org/licenses/>.
+
+    @file RequestCodecs.h
+    @author Stan Kladko
+    @date 2021
+*/
+
+// Generated from spec.json by scripts/generate_request_codecs.py, do not edit.
+// Each struct parses the params of one method in one pass over the members of a request,
+// string fields point into the request document.
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+#include <json/value.h>
+
+#include "document.h"
+
+#include "common.h"
+#include "SGXException.h"
+
+namespace codec {
+
+enum FieldType {
+    FIELD_STRING, FIELD_INT, FIELD_BOOL, FIELD_ARRAY, FIELD_OBJECT
+};
+
+struct Field {
+    const char *name;
+    FieldType type;
+};
+
+inline std::string_view getString(const rapidjson::Value &_v) {
+    CHECK_STATE(_v.IsString());
+    return std::string_view(_v.GetString(), _v.GetStringLength());
+}
+
+inline int64_t getInt(const rapidjson::Value &_v) {
+    CHECK_STATE(_v.IsInt64());
+    return _v.GetInt64();
+}
+
+inline bool getBool(const rapidjson::Value &_v) {
+    CHECK_STATE(_v.IsBool());
+    return _v.GetBool();
+}
+
+inline const rapidjson::Value *getArray(const rapidjson::Value &_v) {
+    CHECK_STATE(_v.IsArray());
+    return &_v;
+}
+
+inline const rapidjson::Value *getObject(const rapidjson::Value &_v) {
+    CHECK_STATE(_v.IsObject());
+    return &_v;
+}
+
+inline void checkFields(uint64_t _found, const Field *_fields, size_t _numFields) {
+    for (size_t i = 0; i < _numFields; i++) {
+        if (!(_found & (1ull << i))) {
+            BOOST_THROW_EXCEPTION(SGXException(-100, std::string("Missing request field ") + _fields[i].name));
+        }
+    }
+}
+
+}
+
+struct ImportBLSKeyShareParams {
+    static constexpr const char *METHOD = "importBLSKeyShare";
+    static constexpr codec::Field FIELDS[] = {
+            {"keyShareName", codec::FIELD_STRING},
+            {"keyShare", codec::FIELD_STRING}
+    };
+    static constexpr size_t NUM_FIELDS = 2;
+
+    std::string_view keyShareName;
+    std::string_view keyShare;
+
+    void parse(const rapidjson::Value &_d) {
+        CHECK_STATE(_d.IsObject());
+        uint64_t found = 0;
+        for (auto it = _d.MemberBegin(); it != _d.MemberEnd(); ++it) {
+            std::string_view name(it->name.GetString(), it->name.GetStringLength());
+            switch (name.size()) {
+                case 8:
+                    if (name == "keyShare") {
+                        keyShare = codec::getString(it->value);
+                        found |= 1ull << 1;
+                    }
+                    break;
+                case 12:
+                    if (name == "keyShareName") {
+                        keyShareName = codec::getString(it->value);
+                        found |= 1ull << 0;
+                    }
+                    break;
+                default:
+                    break;
+            }
+        }
+        codec::checkFields(found, FIELDS, NUM_FIELDS);
+    }
+
+    void write(Json::Value &_p) const {
+        _p["keyShareName"] = std::string(keyShareName);
+        _p["keyShare"] = std::string(keyShare);
+    }
+};
+
+struct BlsSignMessageHashParams {
+    static constexpr const char *METHOD = "blsSignMessageHash";
+    static constexpr codec::Field FIELDS[] = {
+            {"keyShareName", codec::FIELD_STRING},
+            {"messageHash", codec::FIELD_STRING},
+            {"n", codec::FIELD_INT},
+            {"t", codec::FIELD_INT}
+    };
+    static constexpr size_t NUM_FIELDS = 4;
+
+    std::string_view keyShareName;
+    std::string_view messageHash;
+    int64_t n = 0;
+    int64_t t = 0;
+
+    void parse(const rapidjson::Value &_d) {
+        CHECK_STATE(_d.IsObject());
+        uint64_t found = 0;
+        for (auto it = _d.MemberBegin(); it != _d.MemberEnd(); ++it) {
+            std::string_view name(it->name.GetString(), it->name.GetStringLength());
+            switch (name.size()) {
+                case 1:
+                    if (name == "n") {
+                        n = codec::getInt(it->value);
+                        found |= 1ull << 2;
+                    } else if (name == "t") {
+                        t = codec::getInt(it->value);
+                        found |= 1ull << 3;
+                    }
+                    break;
+                case 11:
+                    if (name == "messageHash") {
+                        messageHash = codec::getString(it->value);
+                        found |= 1ull << 1;
+                    }
+                    break;
+                case 12:
+                    if (name == "keyShareName") {
+                        keyShareName = codec::getString(it->value);
+                        found |= 1ull << 0;
+                    }
+                    break;
+                default:
+                    break;
+            }
+        }
+        codec::checkFields(found, FIELDS, NUM_FIELDS);
+    }
+
+    void write(Json::Value &_p) const {
+        _p["keyShareName"] = std::string(keyShareName);
+        _p["messageHash"] = std::string(messageHash);
+        _p["n"] = (Json::Int64) n;
+        _p["t"] = (Json::Int64) t;
+    }
+};
+
+struct ImportECDSAKeyParams {
+    static constexpr const char *METHOD = "importECDSAKey";
+    static constexpr codec::Field FIELDS[] = {
+            {"keyName", codec::FIELD_STRING},
+            {"key", codec::FIELD_STRING}
+    };
+    static constexpr size_t NUM_FIELDS = 2;
+
+    std::string_view keyName;
+    std::string_view key;
+
+    void parse(const rapidjson::Value &_d) {
+        CHECK_STATE(_d.IsObject());
+        uint64_t found = 0;
+        for (auto it = _d.MemberBegin(); it != _d.MemberEnd(); ++it) {
+            std::string_view name(it->name.GetString(), it->name.GetStringLength());
+            switch (name.size()) {
+                case 3:
+                    if (name == "key") {
+                        key = codec::getString(it->value);
+                        found |= 1ull << 1;
+                    }
+                    break;
+                case 7:
+                    if (name == "keyName") {
+                        keyName = codec::getString(it->value);
+                        found |= 1ull << 0;
+                    }
+                    break;
+                default:
+                    break;
+            }
+        }
+        codec::checkFields(found, FIELDS, NUM_FIELDS);
+    }
+
+    void write(Json::Value &_p) const {
+        _p["keyName"] = std::string(keyName);
+        _p["key"] = std::string(key);
+    }
+};
+
+struct ImportBLSKeyShareBatchParams {
+    static constexpr const char *METHOD = "importBLSKeyShareBatch";
+    static constexpr codec::Field FIELDS[] = {
+            {"keyShares", codec::FIELD_ARRAY}
+    };
+    static constexpr size_t NUM_FIELDS = 1;
+
+    const rapidjson::Value *keyShares = nullptr;
+
+    void parse(const rapidjson::Value &_d) {
+        CHECK_STATE(_d.IsObject());
+        uint64_t found = 0;
+        for (auto it = _d.MemberBegin(); it != _d.MemberEnd(); ++it) {
+            std::string_view name(it->name.GetString(), it->name.GetStringLength());
+            switch (name.size()) {
+                case 9:
+                    if (name == "keyShares") {
+                        keyShares = codec::getArray(it->value);
+                        found |= 1ull << 0;
+                    }
+                    break;
+                default:
+                    break;
+            }
+        }
+        codec::checkFields(found, FIELDS, NUM_FIELDS);
+    }
+};
+
+struct ImportECDSAKeyBatchParams {
+    static constexpr const char *METHOD = "importECDSAKeyBatch";
+    static constexpr codec::Field FIELDS[] = {
+            {"keys", codec::FIELD_ARRAY}
+    };
+    static constexpr size_t NUM_FIELDS = 1;
+
+    const rapidjson::Value *keys = nullptr;
+
+    void parse(const rapidjson::Value &_d) {
+        CHECK_STATE(_d.IsObject());
+        uint64_t found = 0;
+        for (auto it = _d.MemberBegin(); it != _d.MemberEnd(); ++it) {
+            std::string_view name(it->name.GetString(), it->name.GetStringLength());
+            switch (name.size()) {
+                case 4:
+                    if (name == "keys") {
+                        keys = codec::getArray(it->value);
+                        found |= 1ull << 0;
+                    }
+                    break;
+                default:
+                    break;
+            }
+        }
+        codec::checkFields(found, FIELDS, NUM_FIELDS);
+    }
+};
+
+struct GetPublicECDSAKeyParams {
+    static constexpr const char *METHOD = "getPublicECDSAKey";
+    static constexpr codec::Field FIELDS[] = {
+            {"keyName", codec::FIELD_STRING}
+    };
+    static constexpr size_t NUM_FIELDS = 1;
+
+    std::string_view keyName;
+
+    void parse(const rapidjson::Value &_d) {
+        CHECK_STATE(_d.IsObject());
+        uint64_t found = 0;
+        for (auto it = _d.MemberBegin(); it != _d.MemberEnd(); ++it) {
+            std::string_view name(it->name.GetString(), it->name.GetStringLength());
+            switch (name.size()) {
+                case 7:
+                    if (name == "keyName") {
+                        keyName = codec::getString(it->value);
+                        found |= 1ull << 0;
+                    }
+                    break;
+                default:
+                    break;
+            }
+        }
+        codec::checkFields(found, FIELDS, NUM_FIELDS);
+    }
+
+    void write(Json::Value &_p) const {
+        _p["keyName"] = std::string(keyName);
+    }
+};
+
+struct EcdsaSignMessageHashParams {
+    static constexpr const char *METHOD = "ecdsaSignMessageHash";
+    static constexpr codec::Field FIELDS[] = {
+            {"keyName", codec::FIELD_STRING},
+            {"messageHash", codec::FIELD_STRING},
+            {"base", codec::FIELD_INT}
+    };
+    static constexpr size_t NUM_FIELDS = 3;
+
+    std::string_view keyName;
+    std::string_view messageHash;
+    int64_t base = 0;
+
+    void parse(const rapidjson::Value &_d) {
+        CHECK_STATE(_d.IsObject());
+        uint64_t found = 0;
+        for (auto it = _d.MemberBegin(); it != _d.MemberEnd(); ++it) {
+            std::string_view name(it->name.GetString(), it->name.GetStringLength());
+            switch (name.size()) {
+                case 4:
+                    if (name == "base") {
+                        base = codec::getInt(it->value);
+                        found |= 1ull << 2;
+                    }
+                    break;
+                case 7:
+                    if (name == "keyName") {
+                        keyName = codec::getString(it->value);
+                        found |= 1ull << 0;
+                    }
+                    break;
+                case 11:
+                    if (name == "messageHash") {
+                        messageHash = codec::getString(it->value);
+                        found |= 1ull << 1;
+                    }
+                    break;
+                default:
+                    break;
+            }
+        }
+        codec::checkFields(found, FIELDS, NUM_FIELDS);
+    }
+
+    void write(Json::Value &_p) const {
+        _p["keyName"] = std::string(keyName);
+        _p["messageHash"] = std::string(messageHash);
+        _p["base"] = (Json::Int64) base;
+    }
+};
+
+struct EcdsaSignMessageHashBatchParams {
+    static constexpr const char *METHOD = "ecdsaSignMessageHashBatch";
+    static constexpr codec::Field FIELDS[] = {
+            {"keyName", codec::FIELD_STRING},
+            {"messageHashes", codec::FIELD_ARRAY},
+            {"base", codec::FIELD_INT}
+    };
+    static constexpr size_t NUM_FIELDS = 3;
+
+    std::string_view keyName;
+    const rapidjson::Value *messageHashes = nullptr;
+    int64_t base = 0;
+
+    void parse(const rapidjson::Value &_d) {
+        CHECK_STATE(_d.IsObject());
+        uint64_t found = 0;
+        for (auto it = _d.MemberBegin(); it != _d.MemberEnd(); ++it) {
+            std::string_view name(it->name.GetString(), it->name.GetStringLength());
+            switch (name.size()) {
+                case 4:
+                    if (name == "base") {
+                        base = codec::getInt(it->value);
+                        found |= 1ull << 2;
+                    }
+                    break;
+                case 7:
+                    if (name == "keyName") {
+                        keyName = codec::getString(it->value);
+                        found |= 1ull << 0;
+                    }
+                    break;
+                case 13:
+                    if (name == "messageHashes") {
+                        messageHashes = codec::getArray(it->value);
+                        found |= 1ull << 1;
+                    }
+                    break;
+                default:
+                    break;
+            }
+        }
+        codec::checkFields(found, FIELDS, NUM_FIELDS);
+    }
+};
+
+struct OpenKeyParams {
+    static constexpr const char *METHOD = "openKey";
+    static constexpr codec::Field FIELDS[] = {
+            {"keyName", codec::FIELD_STRING}
+    };
+    static constexpr size_t NUM_FIELDS = 1;
+
+    std::string_view keyName;
+
+    void parse(const rapidjson::Value &_d) {
+        CHECK_STATE(_d.IsObject());
+        uint64_t found = 0;
+        for (auto it = _d.MemberBegin(); it != _d.MemberEnd(); ++it) {
+            std::string_view name(it->name.GetString(), it->name.GetStringLength());
+            switch (name.size()) {
+                case 7:
+                    if (name == "keyName") {
+                        keyName = codec::getString(it->value);
+                        found |= 1ull << 0;
+                    }
+                    break;
+                default:
+                    break;
+            }
+        }
+        codec::checkFields(found, FIELDS, NUM_FIELDS);
+    }
+
+    void write(Json::Value &_p) const {
+        _p["keyName"] = std::string(keyName);
+    }
+};
+
+struct CloseKeyParams {
+    static constexpr const char *METHOD = "closeKey";
+    static constexpr codec::Field FIELDS[] = {
+            {"keyHandle", codec::FIELD_STRING}
+    };
+    static constexpr size_t NUM_FIELDS = 1;
+
+    std::string_view keyHandle;
+
+    void parse(const rapidjson::Value &_d) {
+        CHECK_STATE(_d.IsObject());
+        uint64_t found = 0;
+        for (auto it = _d.MemberBegin(); it != _d.MemberEnd(); ++it) {
+            std::string_view name(it->name.GetString(), it->name.GetStringLength());
+            switch (name.size()) {
+                case 9:
+                    if (name == "keyHandle") {
+                        keyHandle = codec::getString(it->value);
+                        found |= 1ull << 0;
+                    }
+                    break;
+                default:
+                    break;
+            }
+        }
+        codec::checkFields(found, FIELDS, NUM_FIELDS);
+    }
+
+    void write(Json::Value &_p) const {
+        _p["keyHandle"] = std::string(keyHandle);
+    }
+};
+
+struct BlsSignMessageHashByHandleParams {
+    static constexpr const char *METHOD = "blsSignMessageHashByHandle";
+    static constexpr codec::Field FIELDS[] = {
+            {"keyHandle", codec::FIELD_STRING},
+            {"messageHash", codec::FIELD_STRING},
+            {"t", codec::FIELD_INT},
+            {"n", codec::FIELD_INT}
+    };
+    static constexpr size_t NUM_FIELDS = 4;
+
+    std::string_view keyHandle;
+    std::string_view messageHash;
+    int64_t t = 0;
+    int64_t n = 0;
+
+    void parse(const rapidjson::Value &_d) {
+        CHECK_STATE(_d.IsObject());
+        uint64_t found = 0;
+        for (auto it = _d.MemberBegin(); it != _d.MemberEnd(); ++it) {
+            std::string_view name(it->name.GetString(), it->name.GetStringLength());
+            switch (name.size()) {
+                case 1:
+                    if (name == "t") {
+                        t = codec::getInt(it->value);
+                        found |= 1ull << 2;
+                    } else if (name == "n") {
+                        n = codec::getInt(it->value);
+                        found |= 1ull << 3;
+                    }
+                    break;
+                case 9:
+                    if (name == "keyHandle") {
+                        keyHandle = codec::getString(it->value);
+                        found |= 1ull << 0;
+                    }
+                    break;
+                case 11:
+                    if (name == "messageHash") {
+                        messageHash = codec::getString(it->value);
+                        found |= 1ull << 1;
+                    }
+                    break;
+                default:
+                    break;
+            }
+        }
+        codec::checkFields(found, FIELDS, NUM_FIELDS);
+    }
+
+    void write(Json::Value &_p) const {
+        _p["keyHandle"] = std::string(keyHandle);
+        _p["messageHash"] = std::string(messageHash);
+        _p["t"] = (Json::Int64) t;
+        _p["n"] = (Json::Int64) n;
+    }
+};
+
+struct BlsSignHashedPointParams {
+    static constexpr const char *METHOD = "blsSignHashedPoint";
+    static constexpr codec::Field FIELDS[] = {
+            {"keyShareName", codec::FIELD_STRING},
+            {"hashedPoint", codec::FIELD_STRING},
+            {"hint", codec::FIELD_STRING}
+    };
+    static constexpr size_t NUM_FIELDS = 3;
+
+    std::string_view keyShareName;
+    std::string_view hashedPoint;
+    std::string_view hint;
+
+    void parse(const rapidjson::Value &_d) {
+        CHECK_STATE(_d.IsObject());
+        uint64_t found = 0;
+        for (auto it = _d.MemberBegin(); it != _d.MemberEnd(); ++it) {
+            std::string_view name(it->name.GetString(), it->name.GetStringLength());
+            switch (name.size()) {
+                case 4:
+                    if (name == "hint") {
+                        hint = codec::getString(it->value);
+                        found |= 1ull << 2;
+                    }
+                    break;
+                case 11:
+                    if (name == "hashedPoint") {
+                        hashedPoint = codec::getString(it->value);
+                        found |= 1ull << 1;
+                    }
+                    break;
+                case 12:
+                    if (name == "keyShareName") {
+                        keyShareName = codec::getString(it->value);
+                        found |= 1ull << 0;
+                    }
+                    break;
+                default:
+                    break;
+            }
+        }
+        codec::checkFields(found, FIELDS, NUM_FIELDS);
+    }
+
+    void write(Json::Value &_p) const {
+        _p["keyShareName"] = std::string(keyShareName);
+        _p["hashedPoint"] = std::string(hashedPoint);
+        _p["hint"] = std::string(hint);
+    }
+};
+
+struct EcdsaSignMessageHashByHandleParams {
+    static constexpr const char *METHOD = "ecdsaSignMessageHashByHandle";
+    static constexpr codec::Field FIELDS[] = {
+            {"keyHandle", codec::FIELD_STRING},
+            {"messageHash", codec::FIELD_STRING},
+            {"base", codec::FIELD_INT}
+    };
+    static constexpr size_t NUM_FIELDS = 3;
+
+    std::string_view keyHandle;
+    std::string_view messageHash;
+    int64_t base = 0;
+
+    void parse(const rapidjson::Value &_d) {
+        CHECK_STATE(_d.IsObject());
+        uint64_t found = 0;
+        for (auto it = _d.MemberBegin(); it != _d.MemberEnd(); ++it) {
+            std::string_view name(it->name.GetString(), it->name.GetStringLength());
+            switch (name.size()) {
+                case 4:
+                    if (name == "base") {
+                        base = codec::getInt(it->value);
+                        found |= 1ull << 2;
+                    }
+                    break;
+                case 9:
+                    if (name == "keyHandle") {
+                        keyHandle = codec::getString(it->value);
+                        found |= 1ull << 0;
+                    }
+                    break;
+                case 11:
+                    if (name == "messageHash") {
+                        messageHash = codec::getString(it->value);
+                        found |= 1ull << 1;
+                    }
+                    break;
+                default:
+                    break;
+            }
+        }
+        codec::checkFields(found, FIELDS, NUM_FIELDS);
+    }
+
+    void write(Json::Value &_p) const {
+        _p["keyHandle"] = std::string(keyHandle);
+        _p["messageHash"] = std::string(messageHash);
+        _p["base"] = (Json::Int64) base;
+    }
+};
+
+struct GenerateDKGPolyParams {
+    static constexpr const char *METHOD = "generateDKGPoly";
+    static constexpr codec::Field FIELDS[] = {
+            {"polyName", codec::FIELD_STRING},
+            {"t", codec::FIELD_INT}
+    };
+    static constexpr size_t NUM_FIELDS = 2;
+
+    std::string_view polyName;
+    int64_t t = 0;
+
+    void parse(const rapidjson::Value &_d) {
+        CHECK_STATE(_d.IsObject());
+        uint64_t found = 0;
+        for (auto it = _d.MemberBegin(); it != _d.MemberEnd(); ++it) {
+            std::string_view name(it->name.GetString(), it->name.GetStringLength());
+            switch (name.size()) {
+                case 1:
+                    if (name == "t") {
+                        t = codec::getInt(it->value);
+                        found |= 1ull << 1;
+                    }
+                    break;
+                case 8:
+                    if (name == "polyName") {
+                        polyName = codec::getString(it->value);
+                        found |= 1ull << 0;
+                    }
+                    break;
+                default:
+                    break;
+            }
+        }
+        codec::checkFields(found, FIELDS, NUM_FIELDS);
+    }
+
+    void write(Json::Value &_p) const {
+        _p["polyName"] = std::string(polyName);
+        _p["t"] = (Json::Int64) t;
+    }
+};
+
+struct GenerateDKGPolyBatchParams {
+    static constexpr const char *METHOD = "generateDKGPolyBatch";
+    static constexpr codec::Field FIELDS[] = {
+            {"polyNames", codec::FIELD_ARRAY},
+            {"t", codec::FIELD_INT}
+    };
+    static constexpr size_t NUM_FIELDS = 2;
+
+    const rapidjson::Value *polyNames = nullptr;
+    int64_t t = 0;
+
+    void parse(const rapidjson::Value &_d) {
+        CHECK_STATE(_d.IsObject());
+        uint64_t found = 0;
+        for (auto it = _d.MemberBegin(); it != _d.MemberEnd(); ++it) {
+            std::string_view name(it->name.GetString(), it->name.GetStringLength());
+            switch (name.size()) {
+                case 1:
+                    if (name == "t") {
+                        t = codec::getInt(it->value);
+                        found |= 1ull << 1;
+                    }
+                    break;
+                case 9:
+                    if (name == "polyNames") {
+                        polyNames = codec::getArray(it->value);
+                        found |= 1ull << 0;
+                    }
+                    break;
+                default:
+                    break;
+            }
+        }
+        codec::checkFields(found, FIELDS, NUM_FIELDS);
+    }
+};
+
+struct GetVerificationVectorParams {
+    static constexpr const char *METHOD = "getVerificationVector";
+    static constexpr codec::Field FIELDS[] = {
+            {"polyName", codec::FIELD_STRING},
+            {"n", codec::FIELD_INT},
+            {"t", codec::FIELD_INT}
+    };
+    static constexpr size_t NUM_FIELDS = 3;
+
+    std::string_view polyName;
+    int64_t n = 0;
+    int64_t t = 0;
+
+    void parse(const rapidjson::Value &_d) {
+        CHECK_STATE(_d.IsObject());
+        uint64_t found = 0;
+        for (auto it = _d.MemberBegin(); it != _d.MemberEnd(); ++it) {
+            std::string_view name(it->name.GetString(), it->name.GetStringLength());
+            switch (name.size()) {
+                case 1:
+                    if (name == "n") {
+                        n = codec::getInt(it->value);
+                        found |= 1ull << 1;
+                    } else if (name == "t") {
+                        t = codec::getInt(it->value);
+                        found |= 1ull << 2;
+                    }
+                    break;
+                case 8:
+                    if (name == "polyName") {
+                        polyName = codec::getString(it->value);
+                        found |= 1ull << 0;
+                    }
+                    break;
+                default:
+                    break;
+            }
+        }
+        codec::checkFields(found, FIELDS, NUM_FIELDS);
+    }
+
+    void write(Json::Value &_p) const {
+        _p["polyName"] = std::string(polyName);
+        _p["n"] = (Json::Int64) n;
+        _p["t"] = (Json::Int64) t;
+    }
+};
+
+struct GetVerificationVectorCompressedParams {
+    static constexpr const char *METHOD = "getVerificationVectorCompressed";
+    static constexpr codec::Field FIELDS[] = {
+            {"polyName", codec::FIELD_STRING},
+            {"t", codec::FIELD_INT}
+    };
+    static constexpr size_t NUM_FIELDS = 2;
+
+    std::string_view polyName;
+    int64_t t = 0;
+
+    void parse(const rapidjson::Value &_d) {
+        CHECK_STATE(_d.IsObject());
+        uint64_t found = 0;
+        for (auto it = _d.MemberBegin(); it != _d.MemberEnd(); ++it) {
+            std::string_view name(it->name.GetString(), it->name.GetStringLength());
+            switch (name.size()) {
+                case 1:
+                    if (name == "t") {
+                        t = codec::getInt(it->value);
+                        found |= 1ull << 1;
+                    }
+                    break;
+                case 8:
+                    if (name == "polyName") {
+                        polyName = codec::getString(it->value);
+                        found |= 1ull << 0;
+                    }
+                    break;
+                default:
+                    break;
+            }
+        }
+        codec::checkFields(found, FIELDS, NUM_FIELDS);
+    }
+
+    void write(Json::Value &_p) const {
+        _p["polyName"] = std::string(polyName);
+        _p["t"] = (Json::Int64) t;
+    }
+};
+
+struct GetSecretShareParams {
+    static constexpr const char *METHOD = "getSecretShare";
+    static constexpr codec::Field FIELDS[] = {
+            {"polyName", codec::FIELD_STRING},
+            {"publicKeys", codec::FIELD_ARRAY},
+            {"n", codec::FIELD_INT},
+            {"t", codec::FIELD_INT}
+    };
+    static constexpr size_t NUM_FIELDS = 4;
+
+    std::string_view polyName;
+    const rapidjson::Value *publicKeys = nullptr;
+    int64_t n = 0;
+    int64_t t = 0;
+
+    void parse(const rapidjson::Value &_d) {
+        CHECK_STATE(_d.IsObject());
+        uint64_t found = 0;
+        for (auto it = _d.MemberBegin(); it != _d.MemberEnd(); ++it) {
+            std::string_view name(it->name.GetString(), it->name.GetStringLength());
+            switch (name.size()) {
+                case 1:
+                    if (name == "n") {
+                        n = codec::getInt(it->value);
+                        found |= 1ull << 2;
+                    } else if (name == "t") {
+                        t = codec::getInt(it->value);
+                        found |= 1ull << 3;
+                    }
+                    break;
+                case 8:
+                    if (name == "polyName") {
+                        polyName = codec::getString(it->value);
+                        found |= 1ull << 0;
+                    }
+                    break;
+                case 10:
+                    if (name == "publicKeys") {
+                        publicKeys = codec::getArray(it->value);
+                        found |= 1ull << 1;
+                    }
+                    break;
+                default:
+                    break;
+            }
+        }
+        codec::checkFields(found, FIELDS, NUM_FIELDS);
+    }
+};
+
+struct GetSecretShareV2Params {
+    static constexpr const char *METHOD = "getSecretShareV2";
+    static constexpr codec::Field FIELDS[] = {
+            {"polyName", codec::FIELD_STRING},
+            {"publicKeys", codec::FIELD_ARRAY},
+            {"n", codec::FIELD_INT},
+            {"t", codec::FIELD_INT}
+    };
+    static constexpr size_t NUM_FIELDS = 4;
+
+    std::string_view polyName;
+    const rapidjson::Value *publicKeys = nullptr;
+    int64_t n = 0;
+    int64_t t = 0;
+
+    void parse(const rapidjson::Value &_d) {
+        CHECK_STATE(_d.IsObject());
+        uint64_t found = 0;
+        for (auto it = _d.MemberBegin(); it != _d.MemberEnd(); ++it) {
+            std::string_view name(it->name.GetString(), it->name.GetStringLength());
+            switch (name.size()) {
+                case 1:
+                    if (name == "n") {
+                        n = codec::getInt(it->value);
+                        found |= 1ull << 2;
+                    } else if (name == "t") {
+                        t = codec::getInt(it->value);
+                        found |= 1ull << 3;
+                    }
+                    break;
+                case 8:
+                    if (name == "polyName") {
+                        polyName = codec::getString(it->value);
+                        found |= 1ull << 0;
+                    }
+                    break;
+                case 10:
+                    if (name == "publicKeys") {
+                        publicKeys = codec::getArray(it->value);
+                        found |= 1ull << 1;
+                    }
+                    break;
+                default:
+                    break;
+            }
+        }
+        codec::checkFields(found, FIELDS, NUM_FIELDS);
+    }
+};
+
+struct DkgVerificationParams {
+    static constexpr const char *METHOD = "dkgVerification";
+    static constexpr codec::Field FIELDS[] = {
+            {"publicShares", codec::FIELD_STRING},
+            {"ethKeyName", codec::FIELD_STRING},
+            {"secretShare", codec::FIELD_STRING},
+            {"n", codec::FIELD_INT},
+            {"t", codec::FIELD_INT},
+            {"index", codec::FIELD_INT}
+    };
+    static constexpr size_t NUM_FIELDS = 6;
+
+    std::string_view publicShares;
+    std::string_view ethKeyName;
+    std::string_view secretShare;
+    int64_t n = 0;
+    int64_t t = 0;
+    int64_t index = 0;
+
+    void parse(const rapidjson::Value &_d) {
+        CHECK_STATE(_d.IsObject());
+        uint64_t found = 0;
+        for (auto it = _d.MemberBegin(); it != _d.MemberEnd(); ++it) {
+            std::string_view name(it->name.GetString(), it->name.GetStringLength());
+            switch (name.size()) {
+                case 1:
+                    if (name == "n") {
+                        n = codec::getInt(it->value);
+                        found |= 1ull << 3;
+                    } else if (name == "t") {
+                        t = codec::getInt(it->value);
+                        found |= 1ull << 4;
+                    }
+                    break;
+                case 5:
+                    if (name == "index") {
+                        index = codec::getInt(it->value);
+                        found |= 1ull << 5;
+                    }
+                    break;
+                case 10:
+                    if (name == "ethKeyName") {
+                        ethKeyName = codec::getString(it->value);
+                        found |= 1ull << 1;
+                    }
+                    break;
+                case 11:
+                    if (name == "secretShare") {
+                        secretShare = codec::getString(it->value);
+                        found |= 1ull << 2;
+                    }
+                    break;
+                case 12:
+                    if (name == "publicShares") {
+                        publicShares = codec::getString(it->value);
+                        found |= 1ull << 0;
+                    }
+                    break;
+                default:
+                    break;
+            }
+        }
+        codec::checkFields(found, FIELDS, NUM_FIELDS);
+    }
+
+    void write(Json::Value &_p) const {
+        _p["publicShares"] = std::string(publicShares);
+        _p["ethKeyName"] = std::string(ethKeyName);
+        _p["secretShare"] = std::string(secretShare);
+        _p["n"] = (Json::Int64) n;
+        _p["t"] = (Json::Int64) t;
+        _p["index"] = (Json::Int64) index;
+    }
+};
+
+struct DkgVerificationV2Params {
+    static constexpr const char *METHOD = "dkgVerificationV2";
+    static constexpr codec::Field FIELDS[] = {
+            {"publicShares", codec::FIELD_STRING},
+            {"ethKeyName", codec::FIELD_STRING},
+            {"secretShare", codec::FIELD_STRING},
+            {"n", codec::FIELD_INT},
+            {"t", codec::FIELD_INT},
+            {"index", codec::FIELD_INT}
+    };
+    static constexpr size_t NUM_FIELDS = 6;
+
+    std::string_view publicShares;
+    std::string_view ethKeyName;
+    std::string_view secretShare;
+    int64_t n = 0;
+    int64_t t = 0;
+    int64_t index = 0;
+
+    void parse(const rapidjson::Value &_d) {
+        CHECK_STATE(_d.IsObject());
+        uint64_t found = 0;
+        for (auto it = _d.MemberBegin(); it != _d.MemberEnd(); ++it) {
+            std::string_view name(it->name.GetString(), it->name.GetStringLength());
+            switch (name.size()) {
+                case 1:
+                    if (name == "n") {
+                        n = codec::getInt(it->value);
+                        found |= 1ull << 3;
+                    } else if (name == "t") {
+                        t = codec::getInt(it->value);
+                        found |= 1ull << 4;
+                    }
+                    break;
+                case 5:
+                    if (name == "index") {
+                        index = codec::getInt(it->value);
+                        found |= 1ull << 5;
+                    }
+                    break;
+                case 10:
+                    if (name == "ethKeyName") {
+                        ethKeyName = codec::getString(it->value);
+                        found |= 1ull << 1;
+                    }
+                    break;
+                case 11:
+                    if (name == "secretShare") {
+                        secretShare = codec::getString(it->value);
+                        found |= 1ull << 2;
+                    }
+                    break;
+                case 12:
+                    if (name == "publicShares") {
+                        publicShares = codec::getString(it->value);
+                        found |= 1ull << 0;
+                    }
+                    break;
+                default:
+                    break;
+            }
+        }
+        codec::checkFields(found, FIELDS, NUM_FIELDS);
+    }
+
+    void write(Json::Value &_p) const {
+        _p["publicShares"] = std::string(publicShares);
+        _p["ethKeyName"] = std::string(ethKeyName);
+        _p["secretShare"] = std::string(secretShare);
+        _p["n"] = (Json::Int64) n;
+        _p["t"] = (Json::Int64) t;
+        _p["index"] = (Json::Int64) index;
+    }
+};
+
+struct DkgVerificationBatchParams {
+    static constexpr const char *METHOD = "dkgVerificationBatch";
+    static constexpr codec::Field FIELDS[] = {
+            {"publicShares", codec::FIELD_ARRAY},
+            {"ethKeyName", codec::FIELD_STRING},
+            {"secretShares", codec::FIELD_ARRAY},
+            {"n", codec::FIELD_INT},
+            {"t", codec::FIELD_INT},
+            {"index", codec::FIELD_INT}
+    };
+    static constexpr size_t NUM_FIELDS = 6;
+
+    const rapidjson::Value *publicShares = nullptr;
+    std::string_view ethKeyName;
+    const rapidjson::Value *secretShares = nullptr;
+    int64_t n = 0;
+    int64_t t = 0;
+    int64_t index = 0;
+
+    void parse(const rapidjson::Value &_d) {
+        CHECK_STATE(_d.IsObject());
+        uint64_t found = 0;
+        for (auto it = _d.MemberBegin(); it != _d.MemberEnd(); ++it) {
+            std::string_view name(it->name.GetString(), it->name.GetStringLength());
+            switch (name.size()) {
+                case 1:
+                    if (name == "n") {
+                        n = codec::getInt(it->value);
+                        found |= 1ull << 3;
+                    } else if (name == "t") {
+                        t = codec::getInt(it->value);
+                        found |= 1ull << 4;
+                    }
+                    break;
+                case 5:
+                    if (name == "index") {
+                        index = codec::getInt(it->value);
+                        found |= 1ull << 5;
+                    }
+                    break;
+                case 10:
+                    if (name == "ethKeyName") {
+                        ethKeyName = codec::getString(it->value);
+                        found |= 1ull << 1;
+                    }
+                    break;
+                case 12:
+                    if (name == "publicShares") {
+                        publicShares = codec::getArray(it->value);
+                        found |= 1ull << 0;
+                    } else if (name == "secretShares") {
+                        secretShares = codec::getArray(it->value);
+                        found |= 1ull << 2;
+                    }
+                    break;
+                default:
+                    break;
+            }
+        }
+        codec::checkFields(found, FIELDS, NUM_FIELDS);
+    }
+};
+
+struct CreateBLSPrivateKeyParams {
+    static constexpr const char *METHOD = "createBLSPrivateKey";
+    static constexpr codec::Field FIELDS[] = {
+            {"blsKeyName", codec::FIELD_STRING},
+            {"ethKeyName", codec::FIELD_STRING},
+            {"polyName", codec::FIELD_STRING},
+            {"secretShare", codec::FIELD_STRING},
+            {"n", codec::FIELD_INT},
+            {"t", codec::FIELD_INT}
+    };
+    static constexpr size_t NUM_FIELDS = 6;
+
+    std::string_view blsKeyName;
+    std::string_view ethKeyName;
+    std::string_view polyName;
+    std::string_view secretShare;
+    int64_t n = 0;
+    int64_t t = 0;
+
+    void parse(const rapidjson::Value &_d) {
+        CHECK_STATE(_d.IsObject());
+        uint64_t found = 0;
+        for (auto it = _d.MemberBegin(); it != _d.MemberEnd(); ++it) {
+            std::string_view name(it->name.GetString(), it->name.GetStringLength());
+            switch (name.size()) {
+                case 1:
+                    if (name == "n") {
+                        n = codec::getInt(it->value);
+                        found |= 1ull << 4;
+                    } else if (name == "t") {
+                        t = codec::getInt(it->value);
+                        found |= 1ull << 5;
+                    }
+                    break;
+                case 8:
+                    if (name == "polyName") {
+                        polyName = codec::getString(it->value);
+                        found |= 1ull << 2;
+                    }
+                    break;
+                case 10:
+                    if (name == "blsKeyName") {
+                        blsKeyName = codec::getString(it->value);
+                        found |= 1ull << 0;
+                    } else if (name == "ethKeyName") {
+                        ethKeyName = codec::getString(it->value);
+                        found |= 1ull << 1;
+                    }
+                    break;
+                case 11:
+                    if (name == "secretShare") {
+                        secretShare = codec::getString(it->value);
+                        found |= 1ull << 3;
+                    }
+                    break;
+                default:
+                    break;
+            }
+        }
+        codec::checkFields(found, FIELDS, NUM_FIELDS);
+    }
+
+    void write(Json::Value &_p) const {
+        _p["blsKeyName"] = std::string(blsKeyName);
+        _p["ethKeyName"] = std::string(ethKeyName);
+        _p["polyName"] = std::string(polyName);
+        _p["secretShare"] = std::string(secretShare);
+        _p["n"] = (Json::Int64) n;
+        _p["t"] = (Json::Int64) t;
+    }
+};
+
+struct CreateBLSPrivateKeyV2Params {
+    static constexpr const char *METHOD = "createBLSPrivateKeyV2";
+    static constexpr codec::Field FIELDS[] = {
+            {"blsKeyName", codec::FIELD_STRING},
+            {"ethKeyName", codec::FIELD_STRING},
+            {"polyName", codec::FIELD_STRING},
+            {"secretShare", codec::FIELD_STRING},
+            {"n", codec::FIELD_INT},
+            {"t", codec::FIELD_INT}
+    };
+    static constexpr size_t NUM_FIELDS = 6;
+
+    std::string_view blsKeyName;
+    std::string_view ethKeyName;
+    std::string_view polyName;
+    std::string_view secretShare;
+    int64_t n = 0;
+    int64_t t = 0;
+
+    void parse(const rapidjson::Value &_d) {
+        CHECK_STATE(_d.IsObject());
+        uint64_t found = 0;
+        for (auto it = _d.MemberBegin(); it != _d.MemberEnd(); ++it) {
+            std::string_view name(it->name.GetString(), it->name.GetStringLength());
+            switch (name.size()) {
+                case 1:
+                    if (name == "n") {
+                        n = codec::getInt(it->value);
+                        found |= 1ull << 4;
+                    } else if (name == "t") {
+                        t = codec::getInt(it->value);
+                        found |= 1ull << 5;
+                    }
+                    break;
+                case 8:
+                    if (name == "polyName") {
+                        polyName = codec::getString(it->value);
+                        found |= 1ull << 2;
+                    }
+                    break;
+                case 10:
+                    if (name == "blsKeyName") {
+                        blsKeyName = codec::getString(it->value);
+                        found |= 1ull << 0;
+                    } else if (name == "ethKeyName") {
+                        ethKeyName = codec::getString(it->value);
+                        found |= 1ull << 1;
+                    }
+                    break;
+                case 11:
+                    if (name == "secretShare") {
+                        secretShare = codec::getString(it->value);
+                        found |= 1ull << 3;
+                    }
+                    break;
+                default:
+                    break;
+            }
+        }
+        codec::checkFields(found, FIELDS, NUM_FIELDS);
+    }
+
+    void write(Json::Value &_p) const {
+        _p["blsKeyName"] = std::string(blsKeyName);
+        _p["ethKeyName"] = std::string(ethKeyName);
+        _p["polyName"] = std::string(polyName);
+        _p["secretShare"] = std::string(secretShare);
+        _p["n"] = (Json::Int64) n;
+        _p["t"] = (Json::Int64) t;
+    }
+};
+
+struct GetBLSPublicKeyShareParams {
+    static constexpr const char *METHOD = "getBLSPublicKeyShare";
+    static constexpr codec::Field FIELDS[] = {
+            {"blsKeyName", codec::FIELD_STRING}
+    };
+    static constexpr size_t NUM_FIELDS = 1;
+
+    std::string_view blsKeyName;
+
+    void parse(const rapidjson::Value &_d) {
+        CHECK_STATE(_d.IsObject());
+        uint64_t found = 0;
+        for (auto it = _d.MemberBegin(); it != _d.MemberEnd(); ++it) {
+            std::string_view name(it->name.GetString(), it->name.GetStringLength());
+            switch (name.size()) {
+                case 10:
+                    if (name == "blsKeyName") {
+                        blsKeyName = codec::getString(it->value);
+                        found |= 1ull << 0;
+                    }
+                    break;
+                default:
+                    break;
+            }
+        }
+        codec::checkFields(found, FIELDS, NUM_FIELDS);
+    }
+
+    void write(Json::Value &_p) const {
+        _p["blsKeyName"] = std::string(blsKeyName);
+    }
+};
+
+struct ComplaintResponseParams {
+    static constexpr const char *METHOD = "complaintResponse";
+    static constexpr codec::Field FIELDS[] = {
+            {"polyName", codec::FIELD_STRING},
+            {"n", codec::FIELD_INT},
+            {"t", codec::FIELD_INT},
+            {"ind", codec::FIELD_INT}
+    };
+    static constexpr size_t NUM_FIELDS = 4;
+
+    std::string_view polyName;
+    int64_t n = 0;
+    int64_t t = 0;
+    int64_t ind = 0;
+
+    void parse(const rapidjson::Value &_d) {
+        CHECK_STATE(_d.IsObject());
+        uint64_t found = 0;
+        for (auto it = _d.MemberBegin(); it != _d.MemberEnd(); ++it) {
+            std::string_view name(it->name.GetString(), it->name.GetStringLength());
+            switch (name.size()) {
+                case 1:
+                    if (name == "n") {
+                        n = codec::getInt(it->value);
+                        found |= 1ull << 1;
+                    } else if (name == "t") {
+                        t = codec::getInt(it->value);
+                        found |= 1ull << 2;
+                    }
+                    break;
+                case 3:
+                    if (name == "ind") {
+                        ind = codec::getInt(it->value);
+                        found |= 1ull << 3;
+                    }
+                    break;
+                case 8:
+                    if (name == "polyName") {
+                        polyName = codec::getString(it->value);
+                        found |= 1ull << 0;
+                    }
+                    break;
+                default:
+                    break;
+            }
+        }
+        codec::checkFields(found, FIELDS, NUM_FIELDS);
+    }
+
+    void write(Json::Value &_p) const {
+        _p["polyName"] = std::string(polyName);
+        _p["n"] = (Json::Int64) n;
+        _p["t"] = (Json::Int64) t;
+        _p["ind"] = (Json::Int64) ind;
+    }
+};
+
+struct MultG2Params {
+    static constexpr const char *METHOD = "multG2";
+    static constexpr codec::Field FIELDS[] = {
+            {"x", codec::FIELD_STRING}
+    };
+    static constexpr size_t NUM_FIELDS = 1;
+
+    std::string_view x;
+
+    void parse(const rapidjson::Value &_d) {
+        CHECK_STATE(_d.IsObject());
+        uint64_t found = 0;
+        for (auto it = _d.MemberBegin(); it != _d.MemberEnd(); ++it) {
+            std::string_view name(it->name.GetString(), it->name.GetStringLength());
+            switch (name.size()) {
+                case 1:
+                    if (name == "x") {
+                        x = codec::getString(it->value);
+                        found |= 1ull << 0;
+                    }
+                    break;
+                default:
+                    break;
+            }
+        }
+        codec::checkFields(found, FIELDS, NUM_FIELDS);
+    }
+
+    void write(Json::Value &_p) const {
+        _p["x"] = std::string(x);
+    }
+};
+
+struct MultG2BatchParams {
+    static constexpr const char *METHOD = "multG2Batch";
+    static constexpr codec::Field FIELDS[] = {
+            {"xs", codec::FIELD_ARRAY}
+    };
+    static constexpr size_t NUM_FIELDS = 1;
+
+    const rapidjson::Value *xs = nullptr;
+
+    void parse(const rapidjson::Value &_d) {
+        CHECK_STATE(_d.IsObject());
+        uint64_t found = 0;
+        for (auto it = _d.MemberBegin(); it != _d.MemberEnd(); ++it) {
+            std::string_view name(it->name.GetString(), it->name.GetStringLength());
+            switch (name.size()) {
+                case 2:
+                    if (name == "xs") {
+                        xs = codec::getArray(it->value);
+                        found |= 1ull << 0;
+                    }
+                    break;
+                default:
+                    break;
+            }
+        }
+        codec::checkFields(found, FIELDS, NUM_FIELDS);
+    }
+};
+
+struct AggregateBLSSignaturesParams {
+    static constexpr const char *METHOD = "aggregateBLSSignatures";
+    static constexpr codec::Field FIELDS[] = {
+            {"shares", codec::FIELD_ARRAY},
+            {"signerIndices", codec::FIELD_ARRAY},
+            {"t", codec::FIELD_INT},
+            {"n", codec::FIELD_INT}
+    };
+    static constexpr size_t NUM_FIELDS = 4;
+
+    const rapidjson::Value *shares = nullptr;
+    const rapidjson::Value *signerIndices = nullptr;
+    int64_t t = 0;
+    int64_t n = 0;
+
+    void parse(const rapidjson::Value &_d) {
+        CHECK_STATE(_d.IsObject());
+        uint64_t found = 0;
+        for (auto it = _d.MemberBegin(); it != _d.MemberEnd(); ++it) {
+            std::string_view name(it->name.GetString(), it->name.GetStringLength());
+            switch (name.size()) {
+                case 1:
+                    if (name == "t") {
+                        t = codec::getInt(it->value);
+                        found |= 1ull << 2;
+                    } else if (name == "n") {
+                        n = codec::getInt(it->value);
+                        found |= 1ull << 3;
+                    }
+                    break;
+                case 6:
+                    if (name == "shares") {
+                        shares = codec::getArray(it->value);
+                        found |= 1ull << 0;
+                    }
+                    break;
+                case 13:
+                    if (name == "signerIndices") {
+                        signerIndices = codec::getArray(it->value);
+                        found |= 1ull << 1;
+                    }
+                    break;
+                default:
+                    break;
+            }
+        }
+        codec::checkFields(found, FIELDS, NUM_FIELDS);
+    }
+};
+
+struct VerifyBLSSignaturesParams {
+    static constexpr const char *METHOD = "verifyBLSSignatures";
+    static constexpr codec::Field FIELDS[] = {
+            {"requests", codec::FIELD_ARRAY}
+    };
+    static constexpr size_t NUM_FIELDS = 1;
+
+    const rapidjson::Value *requests = nullptr;
+
+    void parse(const rapidjson::Value &_d) {
+        CHECK_STATE(_d.IsObject());
+        uint64_t found = 0;
+        for (auto it = _d.MemberBegin(); it != _d.MemberEnd(); ++it) {
+            std::string_view name(it->name.GetString(), it->name.GetStringLength());
+            switch (name.size()) {
+                case 8:
+                    if (name == "requests") {
+                        requests = codec::getArray(it->value);
+                        found |= 1ull << 0;
+                    }
+                    break;
+                default:
+                    break;
+            }
+        }
+        codec::checkFields(found, FIELDS, NUM_FIELDS);
+    }
+};
+
+struct IsPolyExistsParams {
+    static constexpr const char *METHOD = "isPolyExists";
+    static constexpr codec::Field FIELDS[] = {
+            {"polyName", codec::FIELD_STRING}
+    };
+    static constexpr size_t NUM_FIELDS = 1;
+
+    std::string_view polyName;
+
+    void parse(const rapidjson::Value &_d) {
+        CHECK_STATE(_d.IsObject());
+        uint64_t found = 0;
+        for (auto it = _d.MemberBegin(); it != _d.MemberEnd(); ++it) {
+            std::string_view name(it->name.GetString(), it->name.GetStringLength());
+            switch (name.size()) {
+                case 8:
+                    if (name == "polyName") {
+                        polyName = codec::getString(it->value);
+                        found |= 1ull << 0;
+                    }
+                    break;
+                default:
+                    break;
+            }
+        }
+        codec::checkFields(found, FIELDS, NUM_FIELDS);
+    }
+
+    void write(Json::Value &_p) const {
+        _p["polyName"] = std::string(polyName);
+    }
+};
+
+struct CalculateAllBLSPublicKeysParams {
+    static constexpr const char *METHOD = "calculateAllBLSPublicKeys";
+    static constexpr codec::Field FIELDS[] = {
+            {"publicShares", codec::FIELD_STRING},
+            {"n", codec::FIELD_INT},
+            {"t", codec::FIELD_INT}
+    };
+    static constexpr size_t NUM_FIELDS = 3;
+
+    std::string_view publicShares;
+    int64_t n = 0;
+    int64_t t = 0;
+
+    void parse(const rapidjson::Value &_d) {
+        CHECK_STATE(_d.IsObject());
+        uint64_t found = 0;
+        for (auto it = _d.MemberBegin(); it != _d.MemberEnd(); ++it) {
+            std::string_view name(it->name.GetString(), it->name.GetStringLength());
+            switch (name.size()) {
+                case 1:
+                    if (name == "n") {
+                        n = codec::getInt(it->value);
+                        found |= 1ull << 1;
+                    } else if (name == "t") {
+                        t = codec::getInt(it->value);
+                        found |= 1ull << 2;
+                    }
+                    break;
+                case 12:
+                    if (name == "publicShares") {
+                        publicShares = codec::getString(it->value);
+                        found |= 1ull << 0;
+                    }
+                    break;
+                default:
+                    break;
+            }
+        }
+        codec::checkFields(found, FIELDS, NUM_FIELDS);
+    }
+
+    void write(Json::Value &_p) const {
+        _p["publicShares"] = std::string(publicShares);
+        _p["n"] = (Json::Int64) n;
+        _p["t"] = (Json::Int64) t;
+    }
+};
@@ -0,0 +1,259 @@
+/*
+    Copyright (C) 2021-Present SKALE Labs
+
+    This file is part of sgxwallet.
+
+    sgxwallet is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as published
+    by the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    sgxwallet is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with sgxwallet. If not, see <https://www.gnu.org/licenses/>.
+
+    @file RequestScheduler.cpp
+    @author Stan Kladko
+    @date 2021
+*/
+
+#include "common.h"
+#include "Numa.h"
+
+#include "RequestScheduler.h"
+
+RequestScheduler::RequestScheduler(uint64_t _numWorkers, uint64_t _maxSlowLaneWorkers, uint64_t _maxSignPending,
+                                   uint64_t _maxSlowPending, uint64_t _numNodes)
+        : numWorkers(_numWorkers), numNodes(max<uint64_t>(min(_numNodes, _numWorkers), 1)), maxSlowLaneWorkers(_maxSlowLaneWorkers), maxSignPending(_maxSignPending),
+          maxSlowPending(_maxSlowPending), signQueues(_numWorkers), activeWorkers(_numWorkers), signPending(0),
+          slowPending(0), slowParked(0), slowLaneBusy(0) {
+    CHECK_STATE(_numWorkers > 0);
+    CHECK_STATE(_maxSlowLaneWorkers > 0);
+    CHECK_STATE(_maxSlowLaneWorkers <= _numWorkers);
+    CHECK_STATE(_maxSignPending > 0);
+    CHECK_STATE(_maxSlowPending > 0);
+
+    nodeWorkers.resize(numNodes);
+    for (uint64_t i = 0; i < numWorkers; i++) {
+        nodeWorkers.at(Numa::getWorkerNode(i, numWorkers, numNodes)).push_back(i);
+    }
+
+    // the own node round robin from the worker, then the queues of the other nodes
+    stealOrders.resize(numWorkers);
+    for (uint64_t i = 0; i < numWorkers; i++) {
+        auto node = Numa::getWorkerNode(i, numWorkers, numNodes);
+        for (uint64_t j = 0; j < numWorkers; j++) {
+            auto queue = (i + j) % numWorkers;
+            if (Numa::getWorkerNode(queue, numWorkers, numNodes) == node) {
+                stealOrders[i].push_back(queue);
+            }
+        }
+        for (uint64_t j = 0; j < numWorkers; j++) {
+            auto queue = (i + j) % numWorkers;
+            if (Numa::getWorkerNode(queue, numWorkers, numNodes) != node) {
+                stealOrders[i].push_back(queue);
+            }
+        }
+    }
+
+    // one worker of each node in turn, so a smaller pool still covers all nodes
+    activationRank.resize(numWorkers);
+    for (uint64_t j = 0; activationOrder.size() < numWorkers; j++) {
+        for (auto &workers : nodeWorkers) {
+            if (j < workers.size()) {
+                activationRank[workers[j]] = activationOrder.size();
+                activationOrder.push_back(workers[j]);
+            }
+        }
+    }
+
+    activeNodeWorkers.resize(numWorkers);
+    for (uint64_t n = 1; n <= numWorkers; n++) {
+        auto &nodes = activeNodeWorkers[n - 1];
+        nodes.resize(numNodes);
+        for (uint64_t node = 0; node < numNodes; node++) {
+            for (auto worker : nodeWorkers[node]) {
+                if (activationRank[worker] < n) {
+                    nodes[node].push_back(worker);
+                }
+            }
+            if (nodes[node].empty()) {
+                nodes[node].assign(activationOrder.begin(), activationOrder.begin() + n);
+            }
+        }
+    }
+}
+
+void RequestScheduler::setActiveWorkers(uint64_t _numActive) {
+    CHECK_STATE(_numActive > 0 && _numActive <= numWorkers);
+    {
+        lock_guard<mutex> lock(parkMutex);
+        activeWorkers = _numActive;
+    }
+    parkCond.notify_all();
+    // wakes active workers to steal what is left in the queues of parked ones
+    notifyAll();
+}
+
+uint64_t RequestScheduler::getHomeQueue(uint64_t _clientHash) const {
+    auto &workers = activeNodeWorkers[activeWorkers.load() - 1][_clientHash % numNodes];
+    return workers[(_clientHash / numNodes) % workers.size()];
+}
+
+void RequestScheduler::notifyWorker() {
+    // taking the lock guarantees that a worker checking isWorkAvailable() does not miss the wakeup
+    lock_guard<mutex> lock(wakeMutex);
+    wakeCond.notify_one();
+}
+
+void RequestScheduler::notifyAll() {
+    lock_guard<mutex> lock(wakeMutex);
+    wakeCond.notify_all();
+}
+
+// the capacity is per lane and not per sign queue, since idle workers steal from any sign queue.
+// Only the router thread enqueues, so the check cannot be raced past the limit
+bool RequestScheduler::enqueueSign(uint64_t _clientHash, IncomingRequest &_element) {
+    if (signPending >= maxSignPending) {
+        return false;
+    }
+    CHECK_STATE(signQueues.at(getHomeQueue(_clientHash)).enqueue(_element));
+    signPending++;
+    notifyWorker();
+    return true;
+}
+
+bool RequestScheduler::enqueueSlow(IncomingRequest &_element) {
+    if (slowPending + slowParked >= maxSlowPending) {
+        return false;
+    }
+    CHECK_STATE(slowQueue.enqueue(_element));
+    slowPending++;
+    notifyWorker();
+    return true;
+}
+
+uint64_t RequestScheduler::getSlowLaneLimit() const {
+    return max<uint64_t>(maxSlowLaneWorkers * activeWorkers.load() / numWorkers, 1);
+}
+
+bool RequestScheduler::isWorkAvailable() {
+    return signPending > 0 || (slowPending > 0 && slowLaneBusy < getSlowLaneLimit());
+}
+
+bool RequestScheduler::tryDequeueSign(uint64_t _workerIndex, IncomingRequest &_element) {
+    // own queue first, then steal from the neighbours
+    for (auto queue : stealOrders.at(_workerIndex)) {
+        if (signQueues[queue].try_dequeue(_element)) {
+            signPending--;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool RequestScheduler::tryDequeueSlow(IncomingRequest &_element) {
+    auto busy = slowLaneBusy.load();
+    auto limit = getSlowLaneLimit();
+
+    do {
+        if (busy >= limit)
+            return false;
+    } while (!slowLaneBusy.compare_exchange_weak(busy, busy + 1));
+
+    // a ready request already owns its session
+    if (readyQueue.try_dequeue(_element)) {
+        slowPending--;
+        return true;
+    }
+
+    while (slowQueue.try_dequeue(_element)) {
+        slowPending--;
+        if (startSession(_element)) {
+            return true;
+        }
+    }
+
+    slowLaneBusy--;
+    return false;
+}
+
+bool RequestScheduler::startSession(IncomingRequest &_element) {
+    if (_element.session.empty()) {
+        return true;
+    }
+
+    lock_guard<mutex> lock(sessionMutex);
+
+    auto it = activeSessions.find(_element.session);
+
+    if (it == activeSessions.end()) {
+        activeSessions.emplace(_element.session, deque<IncomingRequest>());
+        return true;
+    }
+
+    it->second.push_back(move(_element));
+    slowParked++;
+    return false;
+}
+
+void RequestScheduler::slowLaneDone(const IncomingRequest &_element) {
+    if (!_element.session.empty()) {
+        lock_guard<mutex> lock(sessionMutex);
+
+        auto it = activeSessions.find(_element.session);
+        CHECK_STATE(it != activeSessions.end());
+
+        if (it->second.empty()) {
+            activeSessions.erase(it);
+        } else {
+            // the session stays active and passes to the next request
+            CHECK_STATE(readyQueue.enqueue(move(it->second.front())));
+            it->second.pop_front();
+            slowParked--;
+            slowPending++;
+        }
+    }
+
+    CHECK_STATE(slowLaneBusy > 0);
+    slowLaneBusy--;
+    if (slowPending > 0)
+        notifyWorker();
+}
+
+uint64_t RequestScheduler::getActiveSessions() {
+    lock_guard<mutex> lock(sessionMutex);
+    return activeSessions.size();
+}
+
+bool RequestScheduler::dequeue(uint64_t _workerIndex, IncomingRequest &_element, bool &_isSlowLane,
+                               uint64_t _timeoutMs) {
+    auto deadline = chrono::steady_clock::now() + chrono::milliseconds(_timeoutMs);
+
+    if (!isWorkerActive(_workerIndex)) {
+        unique_lock<mutex> lock(parkMutex);
+        parkCond.wait_until(lock, deadline, [this, _workerIndex]() { return isWorkerActive(_workerIndex); });
+        return false;
+    }
+
+    while (true) {
+        if (tryDequeueSign(_workerIndex, _element)) {
+            _isSlowLane = false;
+            return true;
+        }
+
+        if (tryDequeueSlow(_element)) {
+            _isSlowLane = true;
+            return true;
+        }
+
+        unique_lock<mutex> lock(wakeMutex);
+        if (!wakeCond.wait_until(lock, deadline, [this]() { return isWorkAvailable(); })) {
+            return false;
+        }
+    }
+}
@@ -0,0 +1,183 @@
+/*
+    Copyright (C) 2021-Present SKALE Labs
+
+    This file is part of sgxwallet.
+
+    sgxwallet is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as published
+    by the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    sgxwallet is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with sgxwallet. If not, see <https://www.gnu.org/licenses/>.
+
+    @file RequestScheduler.h
+    @author Stan Kladko
+    @date 2021
+*/
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <zmq.hpp>
+
+#include "third_party/concurrentqueue.h"
+#include "Tracing.h"
+
+using namespace std;
+using namespace moodycamel;
+
+// the request, the ROUTER identity of the client, the CurveZMQ key of its
+// connection, which is empty when CurveZMQ is disabled, the request tag
+// found by the router, the trace of traced requests and the DKG session,
+// which is the poly name of DKG requests and empty otherwise
+struct IncomingRequest {
+    shared_ptr<string> msg;
+    shared_ptr<zmq::message_t> identity;
+    string curveUserId;
+    int requestTag = -1;
+    TraceContext trace;
+    uint64_t receivedNs = 0;
+    string session;
+    // index of the ZMQ front end that received the request, which sends the reply
+    uint64_t frontEnd = 0;
+};
+
+// Work-stealing scheduler for ZMQ worker threads.
+//
+// Sign requests go to the home queue of a worker picked by the client identity, which keeps
+// a client on the same thread while the server is not saturated. An idle worker steals sign
+// requests from the other queues. With NUMA nodes, see Numa.h, the client identity picks a node
+// first and a worker of that node second, and workers steal from their own node first. ZMQ clients use REQ sockets, so a client never has more
+// than one request in flight and no per-client ordering has to be preserved across workers.
+//
+// All other requests (DKG, key generation, admin calls) go to a separate slow lane. Sign work
+// always has priority, and at most maxSlowLaneWorkers threads process the slow lane at a time,
+// so slow calls cannot starve signing.
+//
+// DKG requests of different poly names run in parallel on the slow lane workers, while the
+// requests of one poly name are processed one at a time in arrival order. A request whose session
+// is being processed is parked until the running request of that session is done.
+//
+// Each lane has a capacity. Requests beyond it are not queued, so the caller can reject them
+// instead of letting memory and latency grow without limit.
+//
+// Only the first activeWorkers workers of the activation order, which takes the nodes in turn,
+// dequeue requests and have clients routed to them, the others are parked. Active workers still
+// steal from the queues of parked ones, so nothing is left behind when the pool shrinks.
+class RequestScheduler {
+
+    uint64_t numWorkers;
+    uint64_t numNodes;
+    uint64_t maxSlowLaneWorkers;
+    int64_t maxSignPending;
+    int64_t maxSlowPending;
+
+    vector<ConcurrentQueue<IncomingRequest>> signQueues;
+
+    // the workers of each node, and the queues each worker tries in order, its own queue first
+    vector<vector<uint64_t>> nodeWorkers;
+    vector<vector<uint64_t>> stealOrders;
+
+    // the workers in the order they are activated, and the position of each worker in it
+    vector<uint64_t> activationOrder;
+    vector<uint64_t> activationRank;
+
+    // the active workers of each node for each number of active workers minus one, a node
+    // without active workers gets all of them
+    vector<vector<vector<uint64_t>>> activeNodeWorkers;
+
+    atomic<uint64_t> activeWorkers;
+
+    mutex parkMutex;
+    condition_variable parkCond;
+    ConcurrentQueue<IncomingRequest> slowQueue;
+
+    // parked requests whose session became free, they are dequeued before slowQueue
+    ConcurrentQueue<IncomingRequest> readyQueue;
+
+    // sessions with a request in processing, and the parked requests of each of them
+    mutex sessionMutex;
+    map<string, deque<IncomingRequest>> activeSessions;
+
+    // signed, since a worker may dequeue an element before the producer increments the counter
+    atomic<int64_t> signPending;
+    // requests in slowQueue and readyQueue, parked requests are counted by slowParked
+    atomic<int64_t> slowPending;
+    atomic<int64_t> slowParked;
+    atomic<uint64_t> slowLaneBusy;
+
+    mutex wakeMutex;
+    condition_variable wakeCond;
+
+    bool isWorkAvailable();
+
+    // maxSlowLaneWorkers scaled down with the number of active workers
+    uint64_t getSlowLaneLimit() const;
+
+    bool tryDequeueSign(uint64_t _workerIndex, IncomingRequest &_element);
+
+    bool tryDequeueSlow(IncomingRequest &_element);
+
+    // marks the session of the request as active, or parks the request if it already is
+    bool startSession(IncomingRequest &_element);
+
+    void notifyWorker();
+
+public:
+
+    // workers are split over _numNodes as by Numa::getWorkerNode
+    RequestScheduler(uint64_t _numWorkers, uint64_t _maxSlowLaneWorkers, uint64_t _maxSignPending,
+                     uint64_t _maxSlowPending, uint64_t _numNodes = 1);
+
+    // the sign queue of a client
+    uint64_t getHomeQueue(uint64_t _clientHash) const;
+
+    // parks or activates workers, 1 <= _numActive <= numWorkers
+    void setActiveWorkers(uint64_t _numActive);
+
+    uint64_t getActiveWorkers() const { return activeWorkers.load(); }
+
+    bool isWorkerActive(uint64_t _workerIndex) const {
+        return activationRank.at(_workerIndex) < activeWorkers.load();
+    }
+
+    // return false without queueing the request if the lane is full
+    bool enqueueSign(uint64_t _clientHash, IncomingRequest &_element);
+
+    bool enqueueSlow(IncomingRequest &_element);
+
+    // waits up to _timeoutMs for work, a parked worker only waits. On success _isSlowLane tells whether the request came from
+    // the slow lane, in which case slowLaneDone() has to be called with it after processing
+    bool dequeue(uint64_t _workerIndex, IncomingRequest &_element, bool &_isSlowLane, uint64_t _timeoutMs);
+
+    // releases the slow lane worker and makes the next parked request of the session ready
+    void slowLaneDone(const IncomingRequest &_element);
+
+    void notifyAll();
+
+    int64_t getSignPending() const { return signPending.load(); }
+
+    int64_t getSlowPending() const { return slowPending.load() + slowParked.load(); }
+
+    int64_t getSlowParked() const { return slowParked.load(); }
+
+    uint64_t getActiveSessions();
+
+    uint64_t getNumSignQueues() const { return numWorkers; }
+
+    uint64_t getSignQueueDepth(uint64_t _workerIndex) const { return signQueues.at(_workerIndex).size_approx(); }
+};
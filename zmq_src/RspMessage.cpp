@@ -39,10 +39,40 @@ string ECDSASignRspMessage::getSignature() {
     return ret;
 }
 
+Json::Value ECDSASignBatchRspMessage::process() {
+    assert(false);
+}
+
+vector<string> ECDSASignBatchRspMessage::getSignatures() {
+    auto v = getJsonValueRapid("signature_v");
+    auto r = getJsonValueRapid("signature_r");
+    auto s = getJsonValueRapid("signature_s");
+
+    CHECK_STATE(v.isArray() && r.isArray() && s.isArray());
+    CHECK_STATE(v.size() == r.size() && v.size() == s.size());
+
+    vector<string> ret;
+    ret.reserve(v.size());
+
+    for (int i = 0; i < (int) v.size(); i++) {
+        ret.push_back(v[i].asString() + ":" + r[i].asString().substr( 2 ) + ":" + s[i].asString().substr( 2 ));
+    }
+
+    return ret;
+}
+
 Json::Value BLSSignRspMessage::process() {
     assert(false);
 }
 
+Json::Value BLSSignHashedPointRspMessage::process() {
+    assert(false);
+}
+
+Json::Value BLSSignBatchRspMessage::process() {
+    assert(false);
+}
+
 Json::Value importBLSRspMessage::process() {
     assert(false);
 }
@@ -51,6 +81,44 @@ Json::Value importECDSARspMessage::process() {
     assert(false);
 }
 
+Json::Value importBLSBatchRspMessage::process() {
+    assert(false);
+}
+
+vector<int> importBLSBatchRspMessage::getStatuses() {
+    auto results = getJsonValueRapid("results");
+
+    CHECK_STATE(results.isArray());
+
+    vector<int> ret;
+    ret.reserve(results.size());
+
+    for (int i = 0; i < (int) results.size(); i++) {
+        ret.push_back(results[i]["status"].asInt());
+    }
+
+    return ret;
+}
+
+Json::Value importECDSABatchRspMessage::process() {
+    assert(false);
+}
+
+vector<pair<int, string>> importECDSABatchRspMessage::getResults() {
+    auto results = getJsonValueRapid("results");
+
+    CHECK_STATE(results.isArray());
+
+    vector<pair<int, string>> ret;
+    ret.reserve(results.size());
+
+    for (int i = 0; i < (int) results.size(); i++) {
+        ret.push_back({results[i]["status"].asInt(), results[i]["publicKey"].asString()});
+    }
+
+    return ret;
+}
+
 Json::Value generateECDSARspMessage::process() {
     assert(false);
 }
@@ -63,6 +131,10 @@ Json::Value generateDKGPolyRspMessage::process() {
     assert(false);
 }
 
+Json::Value generateDKGPolyBatchRspMessage::process() {
+    assert(false);
+}
+
 Json::Value getVerificationVectorRspMessage::process() {
     assert(false);
 }
@@ -75,6 +147,25 @@ Json::Value dkgVerificationRspMessage::process() {
     assert(false);
 }
 
+Json::Value dkgVerificationBatchRspMessage::process() {
+    assert(false);
+}
+
+vector<bool> dkgVerificationBatchRspMessage::getResults() {
+    auto results = getJsonValueRapid("results");
+
+    CHECK_STATE(results.isArray());
+
+    vector<bool> ret;
+    ret.reserve(results.size());
+
+    for (int i = 0; i < (int) results.size(); i++) {
+        ret.push_back(results[i].asBool());
+    }
+
+    return ret;
+}
+
 Json::Value createBLSPrivateKeyRspMessage::process() {
     assert(false);
 }
@@ -95,6 +186,18 @@ Json::Value multG2RspMessage::process() {
     assert(false);
 }
 
+Json::Value multG2BatchRspMessage::process() {
+    assert(false);
+}
+
+Json::Value aggregateBLSSignaturesRspMessage::process() {
+    assert(false);
+}
+
+Json::Value verifyBLSSignaturesRspMessage::process() {
+    assert(false);
+}
+
 Json::Value isPolyExistsRspMessage::process() {
     assert(false);
 }
@@ -122,3 +225,19 @@ Json::Value generateBLSPrivateKeyRspMessage::process() {
 Json::Value popProveRspMessage::process() {
     assert(false);
 }
+
+Json::Value generateBLSPrivateKeyBatchRspMessage::process() {
+    assert(false);
+}
+
+Json::Value popProveBatchRspMessage::process() {
+    assert(false);
+}
+
+Json::Value startSessionRspMessage::process() {
+    assert(false);
+}
+
+Json::Value registerCurveKeyRspMessage::process() {
+    assert(false);
+}
@@ -28,6 +28,8 @@
 
 class ECDSASignRspMessage : public ZMQMessage {
 public:
+    static constexpr int TAG = ENUM_ECDSA_SIGN_RSP;
+
     ECDSASignRspMessage(shared_ptr <rapidjson::Document> &_d) : ZMQMessage(_d) {};
 
     virtual Json::Value process();
@@ -36,8 +38,22 @@ public:
 };
 
 
+class ECDSASignBatchRspMessage : public ZMQMessage {
+public:
+    static constexpr int TAG = ENUM_ECDSA_SIGN_BATCH_RSP;
+
+    ECDSASignBatchRspMessage(shared_ptr <rapidjson::Document> &_d) : ZMQMessage(_d) {};
+
+    virtual Json::Value process();
+
+    vector<string> getSignatures();
+};
+
+
 class BLSSignRspMessage : public ZMQMessage {
 public:
+    static constexpr int TAG = ENUM_BLS_SIGN_RSP;
+
     BLSSignRspMessage(shared_ptr<rapidjson::Document>& _d) : ZMQMessage(_d) {};
 
     virtual Json::Value process();
@@ -48,8 +64,38 @@ public:
 };
 
 
+class BLSSignHashedPointRspMessage : public ZMQMessage {
+public:
+    static constexpr int TAG = ENUM_BLS_SIGN_HASHED_POINT_RSP;
+
+    BLSSignHashedPointRspMessage(shared_ptr<rapidjson::Document>& _d) : ZMQMessage(_d) {};
+
+    virtual Json::Value process();
+
+    string getSigShare() {
+        return getStringRapid("signatureShare");
+    }
+};
+
+
+class BLSSignBatchRspMessage : public ZMQMessage {
+public:
+    static constexpr int TAG = ENUM_BLS_SIGN_BATCH_RSP;
+
+    BLSSignBatchRspMessage(shared_ptr<rapidjson::Document>& _d) : ZMQMessage(_d) {};
+
+    virtual Json::Value process();
+
+    Json::Value getSigShares() {
+        return getJsonValueRapid("signatureShares");
+    }
+};
+
+
 class importBLSRspMessage : public ZMQMessage {
 public:
+    static constexpr int TAG = ENUM_IMPORT_BLS_RSP;
+
     importBLSRspMessage(shared_ptr<rapidjson::Document>& _d) : ZMQMessage(_d) {};
 
     virtual Json::Value process();
@@ -58,6 +104,8 @@ public:
 
 class importECDSARspMessage : public ZMQMessage {
 public:
+    static constexpr int TAG = ENUM_IMPORT_ECDSA_RSP;
+
     importECDSARspMessage(shared_ptr<rapidjson::Document>& _d) : ZMQMessage(_d) {};
 
     virtual Json::Value process();
@@ -68,8 +116,36 @@ public:
 };
 
 
+class importBLSBatchRspMessage : public ZMQMessage {
+public:
+    static constexpr int TAG = ENUM_IMPORT_BLS_BATCH_RSP;
+
+    importBLSBatchRspMessage(shared_ptr<rapidjson::Document>& _d) : ZMQMessage(_d) {};
+
+    virtual Json::Value process();
+
+    // import status of every key share
+    vector<int> getStatuses();
+};
+
+
+class importECDSABatchRspMessage : public ZMQMessage {
+public:
+    static constexpr int TAG = ENUM_IMPORT_ECDSA_BATCH_RSP;
+
+    importECDSABatchRspMessage(shared_ptr<rapidjson::Document>& _d) : ZMQMessage(_d) {};
+
+    virtual Json::Value process();
+
+    // import status and public key of every key, the public key is empty if the import failed
+    vector<pair<int, string>> getResults();
+};
+
+
 class generateECDSARspMessage : public ZMQMessage {
 public:
+    static constexpr int TAG = ENUM_GENERATE_ECDSA_RSP;
+
     generateECDSARspMessage(shared_ptr<rapidjson::Document>& _d) : ZMQMessage(_d) {};
 
     virtual Json::Value process();
@@ -86,6 +162,8 @@ public:
 
 class getPublicECDSARspMessage : public ZMQMessage {
 public:
+    static constexpr int TAG = ENUM_GET_PUBLIC_ECDSA_RSP;
+
     getPublicECDSARspMessage(shared_ptr<rapidjson::Document>& _d) : ZMQMessage(_d) {};
 
     virtual Json::Value process();
@@ -98,14 +176,32 @@ public:
 
 class generateDKGPolyRspMessage : public ZMQMessage {
 public:
+    static constexpr int TAG = ENUM_GENERATE_DKG_POLY_RSP;
+
     generateDKGPolyRspMessage(shared_ptr<rapidjson::Document>& _d) : ZMQMessage(_d) {};
 
     virtual Json::Value process();
 };
 
 
+class generateDKGPolyBatchRspMessage : public ZMQMessage {
+public:
+    static constexpr int TAG = ENUM_GENERATE_DKG_POLY_BATCH_RSP;
+
+    generateDKGPolyBatchRspMessage(shared_ptr<rapidjson::Document>& _d) : ZMQMessage(_d) {};
+
+    virtual Json::Value process();
+
+    Json::Value getVerificationVectors() {
+        return getJsonValueRapid("verificationVectors");
+    }
+};
+
+
 class getVerificationVectorRspMessage : public ZMQMessage {
 public:
+    static constexpr int TAG = ENUM_GET_VV_RSP;
+
     getVerificationVectorRspMessage(shared_ptr<rapidjson::Document>& _d) : ZMQMessage(_d) {};
 
     virtual Json::Value process();
@@ -118,6 +214,8 @@ public:
 
 class getSecretShareRspMessage : public ZMQMessage {
 public:
+    static constexpr int TAG = ENUM_GET_SECRET_SHARE_RSP;
+
     getSecretShareRspMessage(shared_ptr<rapidjson::Document>& _d) : ZMQMessage(_d) {};
 
     virtual Json::Value process();
@@ -130,6 +228,8 @@ public:
 
 class dkgVerificationRspMessage : public ZMQMessage {
 public:
+    static constexpr int TAG = ENUM_DKG_VERIFY_RSP;
+
     dkgVerificationRspMessage(shared_ptr<rapidjson::Document>& _d) : ZMQMessage(_d) {};
 
     virtual Json::Value process();
@@ -140,8 +240,22 @@ public:
 };
 
 
+class dkgVerificationBatchRspMessage : public ZMQMessage {
+public:
+    static constexpr int TAG = ENUM_DKG_VERIFY_BATCH_RSP;
+
+    dkgVerificationBatchRspMessage(shared_ptr<rapidjson::Document>& _d) : ZMQMessage(_d) {};
+
+    virtual Json::Value process();
+
+    vector<bool> getResults();
+};
+
+
 class createBLSPrivateKeyRspMessage : public ZMQMessage {
 public:
+    static constexpr int TAG = ENUM_CREATE_BLS_PRIVATE_RSP;
+
     createBLSPrivateKeyRspMessage(shared_ptr<rapidjson::Document>& _d) : ZMQMessage(_d) {};
 
     virtual Json::Value process();
@@ -150,6 +264,8 @@ public:
 
 class getBLSPublicRspMessage : public ZMQMessage {
 public:
+    static constexpr int TAG = ENUM_GET_BLS_PUBLIC_RSP;
+
     getBLSPublicRspMessage(shared_ptr<rapidjson::Document>& _d) : ZMQMessage(_d) {};
 
     virtual Json::Value process();
@@ -162,6 +278,8 @@ public:
 
 class getAllBLSPublicKeysRspMessage : public ZMQMessage {
 public:
+    static constexpr int TAG = ENUM_GET_ALL_BLS_PUBLIC_RSP;
+
     getAllBLSPublicKeysRspMessage(shared_ptr<rapidjson::Document>& _d) : ZMQMessage(_d) {};
 
     virtual Json::Value process();
@@ -174,6 +292,8 @@ public:
 
 class complaintResponseRspMessage : public ZMQMessage {
 public:
+    static constexpr int TAG = ENUM_COMPLAINT_RESPONSE_RSP;
+
     complaintResponseRspMessage(shared_ptr<rapidjson::Document>& _d) : ZMQMessage(_d) {};
 
     virtual Json::Value process();
@@ -194,6 +314,8 @@ public:
 
 class multG2RspMessage : public ZMQMessage {
 public:
+    static constexpr int TAG = ENUM_MULT_G2_RSP;
+
     multG2RspMessage(shared_ptr<rapidjson::Document>& _d) : ZMQMessage(_d) {};
 
     virtual Json::Value process();
@@ -204,8 +326,52 @@ public:
 };
 
 
+class multG2BatchRspMessage : public ZMQMessage {
+public:
+    static constexpr int TAG = ENUM_MULT_G2_BATCH_RSP;
+
+    multG2BatchRspMessage(shared_ptr<rapidjson::Document>& _d) : ZMQMessage(_d) {};
+
+    virtual Json::Value process();
+
+    Json::Value getResult() {
+        return getJsonValueRapid("x*G2");
+    }
+};
+
+
+class aggregateBLSSignaturesRspMessage : public ZMQMessage {
+public:
+    static constexpr int TAG = ENUM_AGGREGATE_BLS_SIGNATURES_RSP;
+
+    aggregateBLSSignaturesRspMessage(shared_ptr<rapidjson::Document>& _d) : ZMQMessage(_d) {};
+
+    virtual Json::Value process();
+
+    string getSignature() {
+        return getStringRapid("signature");
+    }
+};
+
+
+class verifyBLSSignaturesRspMessage : public ZMQMessage {
+public:
+    static constexpr int TAG = ENUM_VERIFY_BLS_SIGNATURES_RSP;
+
+    verifyBLSSignaturesRspMessage(shared_ptr<rapidjson::Document>& _d) : ZMQMessage(_d) {};
+
+    virtual Json::Value process();
+
+    Json::Value getValid() {
+        return getJsonValueRapid("valid");
+    }
+};
+
+
 class isPolyExistsRspMessage : public ZMQMessage {
 public:
+    static constexpr int TAG = ENUM_IS_POLY_EXISTS_RSP;
+
     isPolyExistsRspMessage(shared_ptr<rapidjson::Document>& _d) : ZMQMessage(_d) {};
 
     virtual Json::Value process();
@@ -218,6 +384,8 @@ public:
 
 class getServerStatusRspMessage : public ZMQMessage {
 public:
+    static constexpr int TAG = ENUM_GET_SERVER_STATUS_RSP;
+
     getServerStatusRspMessage(shared_ptr<rapidjson::Document>& _d) : ZMQMessage(_d) {};
 
     virtual Json::Value process();
@@ -226,6 +394,8 @@ public:
 
 class getServerVersionRspMessage : public ZMQMessage {
 public:
+    static constexpr int TAG = ENUM_GET_SERVER_VERSION_RSP;
+
     getServerVersionRspMessage(shared_ptr<rapidjson::Document>& _d) : ZMQMessage(_d) {};
 
     virtual Json::Value process();
@@ -238,6 +408,8 @@ public:
 
 class deleteBLSKeyRspMessage : public ZMQMessage {
 public:
+    static constexpr int TAG = ENUM_DELETE_BLS_KEY_RSP;
+
     deleteBLSKeyRspMessage(shared_ptr<rapidjson::Document>& _d) : ZMQMessage(_d) {};
 
     virtual Json::Value process();
@@ -250,6 +422,8 @@ public:
 
 class GetDecryptionShareRspMessage : public ZMQMessage {
 public:
+    static constexpr int TAG = ENUM_GET_DECRYPTION_SHARE_RSP;
+
     GetDecryptionShareRspMessage(shared_ptr<rapidjson::Document>& _d) : ZMQMessage(_d) {};
 
     virtual Json::Value process();
@@ -261,6 +435,8 @@ public:
 
 class generateBLSPrivateKeyRspMessage : public ZMQMessage {
 public:
+    static constexpr int TAG = ENUM_GENERATE_BLS_PRIVATE_KEY_RSP;
+
     generateBLSPrivateKeyRspMessage(shared_ptr<rapidjson::Document>& _d) : ZMQMessage(_d) {};
 
     virtual Json::Value process();
@@ -268,6 +444,8 @@ public:
 
 class popProveRspMessage : public ZMQMessage {
 public:
+    static constexpr int TAG = ENUM_POP_PROVE_RSP;
+
     popProveRspMessage(shared_ptr<rapidjson::Document>& _d) : ZMQMessage(_d) {};
 
     virtual Json::Value process();
@@ -277,4 +455,56 @@ public:
     }
 };
 
+class generateBLSPrivateKeyBatchRspMessage : public ZMQMessage {
+public:
+    static constexpr int TAG = ENUM_GENERATE_BLS_PRIVATE_KEY_BATCH_RSP;
+
+    generateBLSPrivateKeyBatchRspMessage(shared_ptr<rapidjson::Document>& _d) : ZMQMessage(_d) {};
+
+    virtual Json::Value process();
+};
+
+class popProveBatchRspMessage : public ZMQMessage {
+public:
+    static constexpr int TAG = ENUM_POP_PROVE_BATCH_RSP;
+
+    popProveBatchRspMessage(shared_ptr<rapidjson::Document>& _d) : ZMQMessage(_d) {};
+
+    virtual Json::Value process();
+
+    Json::Value getPopProves() {
+        return getJsonValueRapid("popProves");
+    }
+};
+
+class startSessionRspMessage : public ZMQMessage {
+public:
+    static constexpr int TAG = ENUM_START_SESSION_RSP;
+
+    startSessionRspMessage(shared_ptr<rapidjson::Document>& _d) : ZMQMessage(_d) {};
+
+    virtual Json::Value process();
+
+    string getSessionId() {
+        return getStringRapid("sessionId");
+    }
+
+    string getEncryptedSessionKey() {
+        return getStringRapid("encryptedSessionKey");
+    }
+
+    uint64_t getSessionTTL() {
+        return getInt64Rapid("sessionTTL");
+    }
+};
+
+class registerCurveKeyRspMessage : public ZMQMessage {
+public:
+    static constexpr int TAG = ENUM_REGISTER_CURVE_KEY_RSP;
+
+    registerCurveKeyRspMessage(shared_ptr<rapidjson::Document>& _d) : ZMQMessage(_d) {};
+
+    virtual Json::Value process();
+};
+
 #endif //SGXWALLET_RSPMESSAGE_H
@@ -0,0 +1,126 @@
+/*
+    Copyright (C) 2021-Present SKALE Labs
+
+    This file is part of sgxwallet.
+
+    sgxwallet is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as published
+    by the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    sgxwallet is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with sgxwallet. If not, see <https://www.gnu.org/licenses/>.
+
+    @file SchainPartitions.cpp
+    @author Stan Kladko
+    @date 2021
+*/
+
+#include "sgxwallet_common.h"
+#include "SGXException.h"
+#include "third_party/spdlog/spdlog.h"
+#include "common.h"
+
+#include "ZMQMessage.h"
+#include "SchainPartitions.h"
+
+shared_ptr<const SchainPartitions::Config> SchainPartitions::config = nullptr;
+
+static uint64_t parseWeight(const Json::Value &_weight) {
+    if (!_weight.isUInt64() || _weight.asUInt64() == 0 || _weight.asUInt64() > MAX_SCHAIN_PARTITION_WEIGHT) {
+        throw SGXException(INVALID_SCHAIN_PARTITIONS, "Partition weights have to be between 1 and " +
+                                                      to_string(MAX_SCHAIN_PARTITION_WEIGHT));
+    }
+    return _weight.asUInt64();
+}
+
+void SchainPartitions::setConfig(const Json::Value &_config) {
+    if (!_config.isObject()) {
+        throw SGXException(INVALID_SCHAIN_PARTITIONS, "Schain partitions have to be an object");
+    }
+
+    if (_config.empty()) {
+        atomic_store(&config, shared_ptr<const Config>());
+        spdlog::info("Schain partitions cleared");
+        return;
+    }
+
+    auto newConfig = make_shared<Config>();
+    newConfig->json = _config;
+
+    if (_config.isMember("perSchain")) {
+        if (!_config["perSchain"].isBool()) {
+            throw SGXException(INVALID_SCHAIN_PARTITIONS, "perSchain has to be a boolean");
+        }
+        newConfig->perSchain = _config["perSchain"].asBool();
+    }
+
+    if (_config.isMember("defaultWeight")) {
+        newConfig->defaultWeight = parseWeight(_config["defaultWeight"]);
+    }
+
+    if (_config.isMember("groups")) {
+        auto &groups = _config["groups"];
+        if (!groups.isArray() || groups.size() > MAX_SCHAIN_PARTITIONS) {
+            throw SGXException(INVALID_SCHAIN_PARTITIONS, "groups has to be an array of at most " +
+                                                          to_string(MAX_SCHAIN_PARTITIONS) + " groups");
+        }
+        for (auto &&group : groups) {
+            if (!group.isObject() || !group["name"].isString() || group["name"].asString().empty() ||
+                !group["schains"].isArray()) {
+                throw SGXException(INVALID_SCHAIN_PARTITIONS, "A group needs a name and an array of schains");
+            }
+            // "SCHAIN:" names are the per schain partitions
+            auto name = "GROUP:" + group["name"].asString();
+            if (newConfig->weights.count(name)) {
+                throw SGXException(INVALID_SCHAIN_PARTITIONS, "Duplicate group " + group["name"].asString());
+            }
+            newConfig->weights[name] = group.isMember("weight") ? parseWeight(group["weight"]) : 1;
+            for (auto &&schain : group["schains"]) {
+                if (!schain.isString() || !newConfig->groups.emplace(schain.asString(), name).second) {
+                    throw SGXException(INVALID_SCHAIN_PARTITIONS, "Schains have to be strings listed in one group");
+                }
+            }
+        }
+    }
+
+    atomic_store(&config, shared_ptr<const Config>(newConfig));
+
+    spdlog::info("Schain partitions set: {} groups, per schain partitions {}", newConfig->weights.size(),
+                 newConfig->perSchain ? "on" : "off");
+}
+
+Json::Value SchainPartitions::getConfig() {
+    auto current = atomic_load(&config);
+    return current ? current->json : Json::Value(Json::objectValue);
+}
+
+void SchainPartitions::classify(const string &_msg, string &_partition, uint64_t &_weight) {
+    _partition.clear();
+    _weight = 1;
+
+    auto current = atomic_load(&config);
+    if (!current) {
+        return;
+    }
+
+    _weight = current->defaultWeight;
+
+    string schainId;
+    if (!ZMQMessage::scanSchainId(_msg, schainId)) {
+        return;
+    }
+
+    auto group = current->groups.find(schainId);
+    if (group != current->groups.end()) {
+        _partition = group->second;
+        _weight = current->weights.at(group->second);
+    } else if (current->perSchain) {
+        _partition = "SCHAIN:" + schainId;
+    }
+}
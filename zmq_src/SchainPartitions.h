@@ -0,0 +1,73 @@
+/*
+    Copyright (C) 2021-Present SKALE Labs
+
+    This file is part of sgxwallet.
+
+    sgxwallet is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as published
+    by the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    sgxwallet is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with sgxwallet. If not, see <https://www.gnu.org/licenses/>.
+
+    @file SchainPartitions.h
+    @author Stan Kladko
+    @date 2021
+*/
+
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+
+#include <json/value.h>
+
+using namespace std;
+
+// Assignment of ZMQ sign requests to the scheduling partitions of the fair queue, set at runtime
+// with setSchainPartitions of the info server. The schain of a request is the SCHAIN_ID of its BLS
+// key name. The configuration is an object
+//
+//     {"perSchain": true, "defaultWeight": 1,
+//      "groups": [{"name": "heavy", "weight": 1, "schains": ["1", "2"]}, ...]}
+//
+// An schain listed in a group is scheduled in the partition of the group. Any other schain gets a
+// partition of its own with defaultWeight if perSchain is set, and shares the default partition
+// otherwise. Requests without an schain, such as ECDSA signs, are always in the default partition.
+// Each partition gets a share of the sign workers in proportion to its weight. An empty object
+// goes back to a single partition.
+class SchainPartitions {
+
+public:
+
+    struct Config {
+        bool perSchain = false;
+        uint64_t defaultWeight = 1;
+        // schain id to group name
+        unordered_map<string, string> groups;
+        unordered_map<string, uint64_t> weights;
+        Json::Value json;
+    };
+
+private:
+
+    static shared_ptr<const Config> config;
+
+public:
+
+    // throws SGXException with INVALID_SCHAIN_PARTITIONS on a malformed configuration
+    static void setConfig(const Json::Value &_config);
+
+    static Json::Value getConfig();
+
+    // the partition of a raw request, the default partition is ""
+    static void classify(const string &_msg, string &_partition, uint64_t &_weight);
+};
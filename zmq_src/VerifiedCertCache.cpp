@@ -0,0 +1,116 @@
+/*
+    Copyright (C) 2021-Present SKALE Labs
+
+    This file is part of sgxwallet.
+
+    sgxwallet is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as published
+    by the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    sgxwallet is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with sgxwallet. If not, see <https://www.gnu.org/licenses/>.
+
+    @file VerifiedCertCache.cpp
+    @author Stan Kladko
+    @date 2021
+*/
+
+#include <ctime>
+
+#include "common.h"
+#include "sgxwallet_common.h"
+#include "SGXException.h"
+
+#include "VerifiedCertCache.h"
+
+VerifiedCertCache::CertKeys::CertKeys(EVP_PKEY *_publicKey, X509 *_cert, const string &_pem)
+        : publicKey(_publicKey), cert(_cert), pem(_pem) {
+}
+
+VerifiedCertCache::CertKeys::~CertKeys() {
+    EVP_PKEY_free(publicKey);
+    X509_free(cert);
+}
+
+VerifiedCertCache::VerifiedCertCache(uint64_t _maxSize) : evictions(0) {
+    setMaxSize(_maxSize);
+}
+
+void VerifiedCertCache::setMaxSize(uint64_t _maxSize) {
+    if (_maxSize < NUM_SHARDS || _maxSize > MAX_VERIFIED_CERT_CACHE_SIZE) {
+        throw SGXException(INVALID_CERT_CACHE_SIZE, string(__FUNCTION__) +
+                           ":Verified cert cache size has to be between " + to_string(NUM_SHARDS) + " and " +
+                           to_string(MAX_VERIFIED_CERT_CACHE_SIZE));
+    }
+    maxShardSize = _maxSize / NUM_SHARDS;
+}
+
+VerifiedCertCache::Shard &VerifiedCertCache::getShard(const string &_certHash) {
+    return shards[hash<string>()(_certHash) % NUM_SHARDS];
+}
+
+const VerifiedCertCache::Shard &VerifiedCertCache::getShard(const string &_certHash) const {
+    return shards[hash<string>()(_certHash) % NUM_SHARDS];
+}
+
+VerifiedCertCache::CertHandles VerifiedCertCache::get(const string &_certHash) const {
+    auto &shard = getShard(_certHash);
+    shared_lock<shared_timed_mutex> lock(shard.m);
+    auto it = shard.items.find(_certHash);
+    if (it == shard.items.end() || it->second.expiresAt <= (int64_t) time(nullptr))
+        return nullptr;
+    return it->second.handles;
+}
+
+bool VerifiedCertCache::exists(const string &_certHash) const {
+    return get(_certHash) != nullptr;
+}
+
+void VerifiedCertCache::put(const string &_certHash, const CertHandles &_handles, int64_t _expiresAt) {
+    CHECK_STATE(_handles);
+    CHECK_STATE(_handles->publicKey);
+    CHECK_STATE(_handles->cert);
+
+    auto &shard = getShard(_certHash);
+    unique_lock<shared_timed_mutex> lock(shard.m);
+
+    // an expired entry is renewed in place, it keeps its position in the insertion order
+    auto it = shard.items.find(_certHash);
+    if (it != shard.items.end()) {
+        it->second = {_handles, _expiresAt};
+        return;
+    }
+
+    shard.items.emplace(_certHash, Entry{_handles, _expiresAt});
+
+    shard.insertionOrder.push_back(_certHash);
+
+    while (shard.items.size() > maxShardSize) {
+        shard.items.erase(shard.insertionOrder.front());
+        shard.insertionOrder.pop_front();
+        evictions++;
+    }
+}
+
+void VerifiedCertCache::clear() {
+    for (auto &&shard : shards) {
+        unique_lock<shared_timed_mutex> lock(shard.m);
+        shard.items.clear();
+        shard.insertionOrder.clear();
+    }
+}
+
+uint64_t VerifiedCertCache::size() const {
+    uint64_t result = 0;
+    for (auto &&shard : shards) {
+        shared_lock<shared_timed_mutex> lock(shard.m);
+        result += shard.items.size();
+    }
+    return result;
+}
@@ -0,0 +1,115 @@
+/*
+    Copyright (C) 2021-Present SKALE Labs
+
+    This file is part of sgxwallet.
+
+    sgxwallet is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as published
+    by the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    sgxwallet is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with sgxwallet. If not, see <https://www.gnu.org/licenses/>.
+
+    @file VerifiedCertCache.h
+    @author Stan Kladko
+    @date 2021
+*/
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <unordered_map>
+
+#include <openssl/evp.h>
+#include <openssl/x509.h>
+
+using namespace std;
+
+// Read-mostly cache of verified client certs keyed by the sha256 hash of the PEM.
+// Entries are spread over independently locked shards so that concurrent lookups
+// from different threads do not contend on a single lock. An entry expires at the time
+// given to put, after which the cert has to be verified again.
+//
+// Handles are reference counted, so a cert that is evicted or cleared while another thread
+// still verifies a signature with it is freed once that thread releases its handle.
+class VerifiedCertCache {
+
+public:
+
+    // owns the parsed public key and cert, pem is kept for requests that carry only its hash
+    struct CertKeys {
+        EVP_PKEY *const publicKey;
+        X509 *const cert;
+        const string pem;
+        // notAfter of the cert in seconds since the epoch, set once it is verified
+        int64_t notAfter = 0;
+
+        CertKeys(EVP_PKEY *_publicKey, X509 *_cert, const string &_pem = "");
+
+        ~CertKeys();
+
+        CertKeys(const CertKeys &) = delete;
+
+        CertKeys &operator=(const CertKeys &) = delete;
+    };
+
+    typedef shared_ptr<const CertKeys> CertHandles;
+
+    static constexpr uint64_t NUM_SHARDS = 16;
+
+    explicit VerifiedCertCache(uint64_t _maxSize);
+
+    // returns nullptr if the hash is not in the cache or its entry expired
+    CertHandles get(const string &_certHash) const;
+
+    bool exists(const string &_certHash) const;
+
+    // _expiresAt is in seconds since the epoch
+    void put(const string &_certHash, const CertHandles &_handles, int64_t _expiresAt);
+
+    // drops all entries, for example after the CRL changed
+    void clear();
+
+    // takes effect as new certs are put
+    void setMaxSize(uint64_t _maxSize);
+
+    uint64_t size() const;
+
+    // entries dropped because their shard was full
+    uint64_t getEvictions() const { return evictions; }
+
+private:
+
+    struct Entry {
+        CertHandles handles;
+        int64_t expiresAt;
+    };
+
+    struct Shard {
+        mutable shared_timed_mutex m;
+        unordered_map<string, Entry> items;
+        deque<string> insertionOrder;
+    };
+
+    atomic<uint64_t> maxShardSize;
+
+    array<Shard, NUM_SHARDS> shards;
+
+    atomic<uint64_t> evictions;
+
+    Shard &getShard(const string &_certHash);
+
+    const Shard &getShard(const string &_certHash) const;
+};
@@ -27,38 +27,113 @@
 
 
 
+#include <pthread.h>
+
 #include "common.h"
 #include "sgxwallet_common.h"
 #include "third_party/spdlog/spdlog.h"
+#include "Metrics.h"
+#include "Numa.h"
 #include "ZMQServer.h"
 #include "WorkerThreadPool.h"
 
 
-WorkerThreadPool::WorkerThreadPool(uint64_t _numThreads, ZMQServer *_agent) : joined(false) {
+atomic<uint64_t> WorkerThreadPool::scaleUps(0);
+atomic<uint64_t> WorkerThreadPool::scaleDowns(0);
+
+WorkerThreadPool::WorkerThreadPool(uint64_t _numThreads, ZMQServer *_agent, uint64_t _minThreads) : joined(false) {
     CHECK_STATE(_numThreads > 0);
     CHECK_STATE(_agent);
+    CHECK_STATE(_minThreads <= _numThreads);
 
     spdlog::info("Creating thread pool. Threads count:" + to_string(_numThreads));
 
     this->agent = _agent;
     this->numThreads = _numThreads;;
 
+    if (_minThreads > 0 && _minThreads < _numThreads) {
+        minThreads = _minThreads;
+        // start small, the load of the first intervals grows the pool
+        agent->getScheduler().setActiveWorkers(minThreads);
+        spdlog::info("Autoscaling ZMQ workers between {} and {}", minThreads, numThreads);
+    }
 
     for (uint64_t i = 0; i < (uint64_t) numThreads; i++) {
         createThread(i);
     }
 
+    if (minThreads > 0) {
+        scalerThread = make_shared<thread>(&WorkerThreadPool::scalerLoop, this);
+    }
+
     spdlog::info("Created thread pool");
 
 }
 
+uint64_t WorkerThreadPool::getTargetThreads(uint64_t _active, uint64_t _min, uint64_t _max, int64_t _pending,
+                                            uint64_t _p99WaitUs, uint64_t &_quietIntervals) {
+    CHECK_STATE(_min > 0 && _min <= _active && _active <= _max);
+
+    // the router stops dispatching at this depth, so reaching it means the fair queue is filling
+    if (_pending >= (int64_t) (_active * ZMQ_SIGN_DISPATCH_PER_WORKER) || _p99WaitUs > ZMQ_AUTOSCALE_GROW_P99_US) {
+        _quietIntervals = 0;
+        return min(_max, _active + max<uint64_t>(_active / 2, 1));
+    }
+
+    if (_pending > 0 || _p99WaitUs > ZMQ_AUTOSCALE_SHRINK_P99_US) {
+        _quietIntervals = 0;
+        return _active;
+    }
+
+    if (++_quietIntervals < ZMQ_AUTOSCALE_SHRINK_INTERVALS || _active == _min) {
+        return _active;
+    }
+
+    _quietIntervals = 0;
+    return _active - 1;
+}
+
+void WorkerThreadPool::scalerLoop() {
+    auto &scheduler = agent->getScheduler();
+    auto &queueWait = Metrics::getHistogram("zmqQueueWait");
+    auto previous = queueWait.snapshot();
+    uint64_t quietIntervals = 0;
+
+    unique_lock<mutex> lock(scalerMutex);
+
+    while (!scalerCond.wait_for(lock, chrono::milliseconds(ZMQ_AUTOSCALE_INTERVAL_MS), [this]() { return joined.load(); })) {
+        auto current = queueWait.snapshot();
+        auto p99 = (current - previous).quantileUs(0.99);
+        previous = current;
+
+        auto pending = scheduler.getSignPending() + scheduler.getSlowPending() - scheduler.getSlowParked();
+        auto active = scheduler.getActiveWorkers();
+        auto target = getTargetThreads(active, minThreads, numThreads, pending, p99, quietIntervals);
+
+        if (target == active)
+            continue;
+
+        (target > active ? scaleUps : scaleDowns)++;
+        scheduler.setActiveWorkers(target);
+        spdlog::info("ZMQ workers scaled from {} to {}, pending requests {}, p99 queue wait {} us", active, target,
+                     pending, p99);
+    }
+}
+
 
 void WorkerThreadPool::joinAll() {
 
     spdlog::info("Joining worker threads ...");
 
-    if (joined.exchange(true))
-        return;
+    {
+        lock_guard<mutex> lock(scalerMutex);
+        if (joined.exchange(true))
+            return;
+    }
+    scalerCond.notify_all();
+
+    if (scalerThread && scalerThread->joinable())
+        scalerThread->join();
 
     for (auto &&thread : threadpool) {
         if (thread->joinable())
@@ -83,5 +158,17 @@ void WorkerThreadPool::createThread(uint64_t _threadNumber) {
     this->threadpool.push_back(
             make_shared< thread >( ZMQServer::workerThreadMessageProcessLoop, agent, _threadNumber ) );
 
+    // in NUMA mode workers bind themselves to the CPUs of their node
+    if (ZMQServer::isPinWorkerThreads() && !Numa::isEnabled()) {
+        auto numCores = thread::hardware_concurrency();
+        CHECK_STATE(numCores > 0);
+        cpu_set_t cpuSet;
+        CPU_ZERO(&cpuSet);
+        CPU_SET(_threadNumber % numCores, &cpuSet);
+        if (pthread_setaffinity_np(threadpool.back()->native_handle(), sizeof(cpu_set_t), &cpuSet) != 0) {
+            spdlog::error("Could not pin ZMQ worker thread {} to core {}", _threadNumber, _threadNumber % numCores);
+        }
+    }
+
     spdlog::info("Started ZMQ worker thread " + to_string(_threadNumber) );
 }
@@ -26,12 +26,29 @@
 class Agent;
 class ZMQServer;
 
+// The ZMQ worker threads. With a minimum below numThreads the pool autoscales: all threads are
+// created at start, since each one owns a sign queue and a reply ring, and a scaler thread
+// activates and parks them in the scheduler between the two bounds, driven by the queue depth
+// and the p99 queue wait of the last ZMQ_AUTOSCALE_INTERVAL_MS. numThreads stays below the
+// enclave TCS, see ZMQServer::setWorkerThreadsConfig, so a parked thread keeps its TCS.
 class WorkerThreadPool {
 
     void createThread( uint64_t threadNumber );
 
     recursive_mutex m;
 
+    uint64_t minThreads = 0;
+
+    shared_ptr<thread> scalerThread;
+
+    mutex scalerMutex;
+    condition_variable scalerCond;
+
+    static atomic<uint64_t> scaleUps;
+    static atomic<uint64_t> scaleDowns;
+
+    void scalerLoop();
+
 protected:
 
     atomic_bool joined;
@@ -42,7 +59,8 @@ protected:
 
 public:
 
-    WorkerThreadPool(uint64_t _numThreads, ZMQServer *_agent);
+    // _minThreads == 0 or _minThreads == _numThreads disables autoscaling
+    WorkerThreadPool(uint64_t _numThreads, ZMQServer *_agent, uint64_t _minThreads = 0);
 
     virtual ~WorkerThreadPool();
 
@@ -50,4 +68,13 @@ public:
 
     bool isJoined() const;
 
+    // the number of active threads after one interval. _quietIntervals counts the intervals in
+    // a row without load and is reset when the pool is resized
+    static uint64_t getTargetThreads(uint64_t _active, uint64_t _min, uint64_t _max, int64_t _pending,
+                                     uint64_t _p99WaitUs, uint64_t &_quietIntervals);
+
+    static uint64_t getScaleUps() { return scaleUps; }
+
+    static uint64_t getScaleDowns() { return scaleDowns; }
+
 };
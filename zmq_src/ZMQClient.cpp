@@ -22,50 +22,136 @@
 */
 
 #include "sys/random.h"
+#include <sys/eventfd.h>
 #include <sys/types.h>
 #include <sys/syscall.h>
+#include <unistd.h>
 
 
+#include <cctype>
+#include <climits>
 #include <fstream>
 #include <streambuf>
-#include <regex>
+#include <third_party/cryptlite/sha256.h>
+#include <chrono>
 
 #include "sgxwallet_common.h"
 #include "common.h"
+#include "SGXException.h"
 #include "CryptoTools.h"
 #include "ReqMessage.h"
 #include "RspMessage.h"
 #include "ZMQClient.h"
+#include "Tracing.h"
 
 
-shared_ptr <ZMQMessage> ZMQClient::doRequestReply(Json::Value &_req) {
+string ZMQClient::serializeRequest(Json::Value &_req) {
+    // lets the server drop the request instead of processing it after we stopped waiting
+    _req["deadline"] = (Json::UInt64) (ZMQMessage::getEpochMs() + requestTimeoutMs);
+
+    // continues the trace of the calling thread on the server
+    if (Tracing::getCurrent().isActive()) {
+        _req["traceparent"] = Tracing::getCurrent().toTraceparent();
+    }
+
+    if (!sign || curveRegistered) {
+        Json::FastWriter fastWriter;
+        fastWriter.omitEndingLineFeed();
+        string reqStr = fastWriter.write(_req);
+        CHECK_STATE(reqStr.front() == '{');
+        CHECK_STATE(reqStr.at(reqStr.size() - 1) == '}');
+        return reqStr;
+    }
+
+    string id, macKey;
+
+    if (!useSessions || !getSession(id, macKey)) {
+        return serializeSignedRequest(_req);
+    }
+
+    _req.removeMember("cert");
+    _req["sessionId"] = id;
+
     Json::FastWriter fastWriter;
+    fastWriter.omitEndingLineFeed();
 
-    if (sign) {
-        CHECK_STATE(!certificate.empty());
-        CHECK_STATE(!key.empty());
+    string reqStr = fastWriter.write(_req);
 
-        _req["cert"] = certificate;
+    CHECK_STATE(reqStr.front() == '{');
+    CHECK_STATE(reqStr.at(reqStr.size() - 1) == '}');
+
+    // like the signature, the MAC is appended as the last member of the serialized request
+    auto msgMac = macString(macKey, reqStr);
+    reqStr.pop_back();
+    reqStr.append(",\"msgMac\":\"").append(msgMac).append("\"}");
+
+    return reqStr;
+}
+
+string ZMQClient::serializeSignedRequest(Json::Value &_req) {
+    Json::FastWriter fastWriter;
+    fastWriter.omitEndingLineFeed();
 
-        string msgToSign = fastWriter.write(_req);
+    CHECK_STATE(!certificate.empty());
+    CHECK_STATE(!key.empty());
 
-        _req["msgSig"] = signString(pkey, msgToSign);
+    _req.removeMember("sessionId");
+
+    if (certFingerprint && certAccepted) {
+        _req.removeMember("cert");
+        _req["certHash"] = certHash;
+    } else {
+        _req.removeMember("certHash");
+        _req["cert"] = certificate;
     }
 
     string reqStr = fastWriter.write(_req);
 
-    reqStr = reqStr.substr(0, reqStr.size() - 1);
     CHECK_STATE(reqStr.front() == '{');
     CHECK_STATE(reqStr.at(reqStr.size() - 1) == '}');
 
+    // the request is serialized once and the signature is appended as the last member,
+    // so the server can verify the received bytes without re-serializing them
+    auto msgSig = signString(pkey, stripWhitespace(reqStr));
+    reqStr.pop_back();
+    reqStr.append(",\"msgSig\":\"").append(msgSig).append("\"}");
+
+    return reqStr;
+}
+
+shared_ptr <ZMQMessage> ZMQClient::doRequestReply(Json::Value &_req) {
+    // replies of hedged and resent requests to several nodes are matched by reqId
+    if (urls.size() > 1) {
+        _req["reqId"] = (Json::UInt64) nextReqId++;
+    }
+
+    auto reqStr = serializeRequest(_req);
+
     auto resultStr = doZmqRequestReply(reqStr);
 
+    // the server restarted or expired the session, start a new one and resend once
+    if (sign && ZMQMessage::isUnknownSessionReply(resultStr)) {
+        resetSession();
+        reqStr = serializeRequest(_req);
+        resultStr = doZmqRequestReply(reqStr);
+    }
+
+    // the node has not seen the cert or dropped it, resend once with the full cert
+    if (sign && certFingerprint) {
+        if (ZMQMessage::isUnknownCertReply(resultStr)) {
+            certAccepted = false;
+            reqStr = serializeRequest(_req);
+            resultStr = doZmqRequestReply(reqStr);
+        }
+        certAccepted = !ZMQMessage::isUnknownCertReply(resultStr);
+    }
+
     try {
         CHECK_STATE(resultStr.size() > 5)
         CHECK_STATE(resultStr.front() == '{')
         CHECK_STATE(resultStr.back() == '}')
 
-        return ZMQMessage::parse(resultStr.c_str(), resultStr.size(), false, false, false);
+        return ZMQMessage::parse(make_shared<string>(move(resultStr)), false, false, false);
     } catch (std::exception &e) {
         spdlog::error(string("Error in doRequestReply:") + e.what());
         throw;
@@ -75,45 +161,129 @@ shared_ptr <ZMQMessage> ZMQClient::doRequestReply(Json::Value &_req) {
     }
 }
 
-string ZMQClient::doZmqRequestReply(string &_req) {
-    stringstream request;
+atomic<uint64_t> ZMQClient::clientCounter(0);
 
-    shared_ptr <zmq::socket_t> clientSocket = nullptr;
+// sockets of this thread for each client, keyed by clientId * 2 + balanced, filled on first use and by reconnect
+static thread_local map<uint64_t, zmq::socket_t *> threadSockets;
 
-    {
-        lock_guard <recursive_mutex> m(mutex);
-        if (!clientSockets.count(getProcessID()))
-            reconnect();
-        clientSocket = clientSockets.at(getProcessID());
-        CHECK_STATE(clientSocket);
+// monitors of threadSockets, same keys
+static thread_local map<uint64_t, zmq::socket_t *> threadMonitors;
+
+static uint64_t nowMs();
+
+bool ZMQClient::isBalanced(const string &_req) const {
+    return urls.size() > 1 && ZMQMessage::isSignRequest(ZMQMessage::scanRequestTag(_req));
+}
+
+zmq::socket_t &ZMQClient::getThreadSocket(bool _balanced) {
+    auto it = threadSockets.find(clientId * 2 + _balanced);
+
+    if (it == threadSockets.end()) {
+        reconnect(_balanced);
+        it = threadSockets.find(clientId * 2 + _balanced);
+        CHECK_STATE(it != threadSockets.end());
     }
-    CHECK_STATE(clientSocket);
 
+    CHECK_STATE(it->second);
+    return *it->second;
+}
+
+zmq::socket_t &ZMQClient::getThreadMonitor(bool _balanced) {
+    // getThreadSocket creates the monitor together with the socket
+    getThreadSocket(_balanced);
+
+    auto it = threadMonitors.find(clientId * 2 + _balanced);
+    CHECK_STATE(it != threadMonitors.end());
+    CHECK_STATE(it->second);
+    return *it->second;
+}
+
+string ZMQClient::doZmqRequestReply(string &_req) {
     spdlog::debug("ZMQ client sending: \n {}", _req);
 
-    s_send(*clientSocket, _req);
+    auto balanced = isBalanced(_req);
+    // resending other requests early could repeat their side effects, they wait for the timeout
+    auto idempotent = ZMQMessage::isSignRequest(ZMQMessage::scanRequestTag(_req));
+
+    uint64_t reqId = 0;
+    auto hasReqId = ZMQMessage::getReqId(_req, reqId);
+
+    s_send(getThreadSocket(balanced), _req);
+
+    uint64_t retries = 0;
+    auto sentAt = nowMs();
+    auto deadline = sentAt + requestTimeoutMs;
+    auto hedgeAt = balanced && hedgePercentile > 0 ? sentAt + getHedgeDelayMs() : UINT64_MAX;
 
     while (true) {
-        //  Poll socket for a reply, with timeout
+        auto &clientSocket = getThreadSocket(balanced);
+        auto &monitor = getThreadMonitor(balanced);
+        //  Poll socket for a reply and monitor for a lost connection, with timeout
         zmq::pollitem_t items[] = {
-                {static_cast<void *>(*clientSocket), 0, ZMQ_POLLIN, 0}};
-        zmq::poll(&items[0], 1, REQUEST_TIMEOUT);
+                {static_cast<void *>(clientSocket), 0, ZMQ_POLLIN, 0},
+                {static_cast<void *>(monitor), 0, ZMQ_POLLIN, 0}};
+        auto now = nowMs();
+        auto wakeAt = min(deadline, hedgeAt);
+        zmq::poll(&items[0], 2, (long) (wakeAt > now ? wakeAt - now : 0));
         //  If we got a reply, process it
         if (items[0].revents & ZMQ_POLLIN) {
-            string reply = s_recv(*clientSocket);
+            string reply = s_recv(clientSocket);
             CHECK_STATE(reply.size() > 5);
             spdlog::debug("ZMQ client received reply:{}", reply);
             CHECK_STATE(reply.front() == '{');
             CHECK_STATE(reply.back() == '}');
 
+            // the late reply of an earlier hedged request
+            uint64_t replyReqId = 0;
+            if (hasReqId && (!ZMQMessage::getReqId(reply, replyReqId) || replyReqId != reqId)) {
+                continue;
+            }
+
+            if (balanced) {
+                signLatency.observeUs((nowMs() - sentAt) * 1000);
+            }
+
             return reply;
+        }
+
+        if (nowMs() >= hedgeAt) {
+            // DEALER sends round robin, so the duplicate goes to the next connected node
+            hedgedRequests++;
+            hedgeAt = UINT64_MAX;
+            s_send(clientSocket, _req);
+        }
+
+        bool lost = (items[1].revents & ZMQ_POLLIN) && peerDisconnected(monitor) && idempotent;
+
+        if (!lost && nowMs() < deadline) {
+            continue;
+        }
+
+        if (maxRetries > 0 && ++retries > maxRetries) {
+            throw SGXException(ZMQ_CLIENT_RETRIES_EXHAUSTED, "No response from ZMQ server after " +
+                                                              to_string(maxRetries.load()) + " retries");
+        }
+
+        if (lost) {
+            spdlog::error("W: connection to server lost, resending...");
         } else {
             spdlog::error("W: no response from server, retrying...");
-            reconnect();
-            //  Send request again, on new socket
-            s_send(*clientSocket, _req);
         }
+        reconnect(balanced);
+        //  Send request again, on new socket, a balanced socket also fails over to the next node
+        s_send(getThreadSocket(balanced), _req);
+        deadline = nowMs() + requestTimeoutMs;
+    }
+}
+
+uint64_t ZMQClient::getHedgeDelayMs() const {
+    auto snapshot = signLatency.snapshot();
+
+    if (snapshot.count < HEDGE_MIN_SAMPLES) {
+        return HEDGE_DEFAULT_DELAY_MS;
     }
+
+    return max<uint64_t>(snapshot.quantileUs(hedgePercentile) / 1000, HEDGE_MIN_DELAY_MS);
 }
 
 string ZMQClient::readFileIntoString(const string &_fileName) {
@@ -122,12 +292,98 @@ string ZMQClient::readFileIntoString(const string &_fileName) {
     return str;
 }
 
+string ZMQClient::stripWhitespace(const char* _str, size_t _size) {
+    CHECK_STATE(_str);
+
+    string result;
+    result.reserve(_size);
+
+    for (size_t i = 0; i < _size; i++) {
+        if (!isspace((unsigned char) _str[i])) {
+            result.push_back(_str[i]);
+        }
+    }
+
+    return result;
+}
+
+string ZMQClient::stripWhitespace(const string& _str) {
+    return stripWhitespace(_str.data(), _str.size());
+}
+
+string ZMQClient::macString(const string &_key, const string &_str) {
+    CHECK_STATE(!_key.empty());
+
+    unsigned char mac[EVP_MAX_MD_SIZE];
+    unsigned int macLen = 0;
+
+    CHECK_STATE(HMAC(EVP_sha256(), _key.data(), _key.size(), (const unsigned char *) _str.data(), _str.size(),
+                     mac, &macLen));
+
+    return string(carray2Hex(mac, macLen).data());
+}
+
+string ZMQClient::encryptSessionKey(EVP_PKEY *_pubkey, const string &_key) {
+    CHECK_STATE(_pubkey);
+    CHECK_STATE(!_key.empty());
+
+    auto ctx = EVP_PKEY_CTX_new(_pubkey, nullptr);
+    CHECK_STATE(ctx);
+
+    size_t outLen = 0;
+    vector<unsigned char> out;
+
+    bool ok = EVP_PKEY_encrypt_init(ctx) == 1 &&
+              EVP_PKEY_CTX_set_rsa_padding(ctx, RSA_PKCS1_OAEP_PADDING) == 1 &&
+              EVP_PKEY_encrypt(ctx, nullptr, &outLen, (const unsigned char *) _key.data(), _key.size()) == 1;
+
+    if (ok) {
+        out.resize(outLen);
+        ok = EVP_PKEY_encrypt(ctx, out.data(), &outLen, (const unsigned char *) _key.data(), _key.size()) == 1;
+    }
+
+    EVP_PKEY_CTX_free(ctx);
+
+    CHECK_STATE(ok);
+
+    return string(carray2Hex(out.data(), outLen).data());
+}
+
+string ZMQClient::decryptSessionKey(EVP_PKEY *_pkey, const string &_encryptedKey) {
+    CHECK_STATE(_pkey);
+
+    vector<unsigned char> in(1024, 0);
+    uint64_t inLen = 0;
+
+    CHECK_STATE2(hex2carray(_encryptedKey.c_str(), &inLen, in.data(), in.size()), ZMQ_COULD_NOT_PARSE);
+
+    auto ctx = EVP_PKEY_CTX_new(_pkey, nullptr);
+    CHECK_STATE(ctx);
+
+    size_t outLen = 0;
+    vector<unsigned char> out;
+
+    bool ok = EVP_PKEY_decrypt_init(ctx) == 1 &&
+              EVP_PKEY_CTX_set_rsa_padding(ctx, RSA_PKCS1_OAEP_PADDING) == 1 &&
+              EVP_PKEY_decrypt(ctx, nullptr, &outLen, in.data(), inLen) == 1;
+
+    if (ok) {
+        out.resize(outLen);
+        ok = EVP_PKEY_decrypt(ctx, out.data(), &outLen, in.data(), inLen) == 1;
+    }
+
+    EVP_PKEY_CTX_free(ctx);
+
+    CHECK_STATE(ok);
+
+    return string((char *) out.data(), outLen);
+}
+
 void ZMQClient::verifySig(EVP_PKEY* _pubkey, const string& _str, const string& _sig) {
     CHECK_STATE(_pubkey);
     CHECK_STATE(!_str.empty());
 
-    static std::regex r("\\s+");
-    auto msgToSign = std::regex_replace(_str, r, "");
+    auto &msgToSign = _str;
 
     vector<uint8_t> binSig(256,0);
 
@@ -161,8 +417,7 @@ string ZMQClient::signString(EVP_PKEY* _pkey, const string& _str) {
     CHECK_STATE(_pkey);
     CHECK_STATE(!_str.empty());
 
-    static std::regex r("\\s+");
-    auto msgToSign = std::regex_replace(_str, r, "");
+    auto &msgToSign = _str;
 
     EVP_MD_CTX *mdctx = NULL;
     int ret = 0;
@@ -212,8 +467,20 @@ pair<EVP_PKEY*, X509*> ZMQClient::readPublicKeyFromCertStr(const string& _certSt
 };
 
 ZMQClient::ZMQClient(const string &ip, uint16_t port, bool _sign, const string &_certFileName,
+                     const string &_certKeyName)
+        : ZMQClient(vector<pair<string, uint16_t>>{{ip, port}}, _sign, _certFileName, _certKeyName) {}
+
+ZMQClient::ZMQClient(const vector<pair<string, uint16_t>> &_endpoints, bool _sign, const string &_certFileName,
                      const string &_certKeyName) : ctx(1), sign(_sign),
-                                                   certKeyName(_certKeyName), certFileName(_certFileName) {
+                                                   certKeyName(_certKeyName), certFileName(_certFileName),
+                                                   clientId(clientCounter++), maxRetries(0),
+                                                   requestTimeoutMs(REQUEST_TIMEOUT), monitorCounter(0),
+                                                   hedgePercentile(0), hedgedRequests(0),
+                                                   keyCacheEnabled(false), keyCacheHits(0),
+                                                   certFingerprint(false), certAccepted(false),
+                                                   useSessions(true), curveRegistered(false),
+                                                   asyncExitRequested(false),
+                                                   nextReqId(0) {
     spdlog::info("Initing ZMQClient. Sign:{} ", _sign);
 
     if (sign) {
@@ -222,6 +489,7 @@ ZMQClient::ZMQClient(const string &ip, uint16_t port, bool _sign, const string &
 
         certificate = readFileIntoString(_certFileName);
         CHECK_STATE(!certificate.empty());
+        certHash = cryptlite::sha256::hash_hex(certificate);
 
         key = readFileIntoString(_certKeyName);
         CHECK_STATE(!key.empty());
@@ -250,18 +518,23 @@ ZMQClient::ZMQClient(const string &ip, uint16_t port, bool _sign, const string &
     certFileName = _certFileName;
     certKeyName = _certKeyName;
 
-    url = "tcp://" + ip + ":" + to_string(port);
-}
-
-void ZMQClient::reconnect() {
-    lock_guard< recursive_mutex > lock( mutex );
+    CHECK_STATE(!_endpoints.empty());
 
-    auto pid = getProcessID();
+    for (auto &&endpoint : _endpoints) {
+        // an ipc:// host is a socket file of a server on this host, the port is not used
+        if (endpoint.first.rfind("ipc://", 0) == 0) {
+            urls.push_back(endpoint.first);
+        } else {
+            urls.push_back("tcp://" + endpoint.first + ":" + to_string(endpoint.second));
+        }
+    }
 
-    if ( clientSockets.count( pid ) > 0 ) {
-        clientSockets.erase( pid );
+    if (urls.size() > 1) {
+        useSessions = false;
     }
+}
 
+shared_ptr <zmq::socket_t> ZMQClient::createSocket(bool _balanced) {
     uint64_t randNumber;
     CHECK_STATE(getrandom( &randNumber, sizeof(uint64_t), 0 ) == sizeof(uint64_t));
 
@@ -272,95 +545,663 @@ void ZMQClient::reconnect() {
     //  Configure socket to not wait at close time
     int linger = 0;
     clientSocket->setsockopt( ZMQ_LINGER, &linger, sizeof( linger ) );
-    clientSocket->connect( url );
-    clientSockets.insert( { pid, clientSocket } );
+    // heartbeats detect a dead or hung server long before the request timeout
+    int heartbeatIvl = ZMQ_HEARTBEAT_IVL_MS;
+    int heartbeatTimeout = ZMQ_HEARTBEAT_TIMEOUT_MS;
+    int heartbeatTtl = ZMQ_HEARTBEAT_TIMEOUT_MS;
+    clientSocket->setsockopt(ZMQ_HEARTBEAT_IVL, &heartbeatIvl, sizeof(heartbeatIvl));
+    clientSocket->setsockopt(ZMQ_HEARTBEAT_TIMEOUT, &heartbeatTimeout, sizeof(heartbeatTimeout));
+    clientSocket->setsockopt(ZMQ_HEARTBEAT_TTL, &heartbeatTtl, sizeof(heartbeatTtl));
+    int reconnectIvl = ZMQ_RECONNECT_IVL_MS;
+    int reconnectIvlMax = ZMQ_RECONNECT_IVL_MAX_MS;
+    clientSocket->setsockopt(ZMQ_RECONNECT_IVL, &reconnectIvl, sizeof(reconnectIvl));
+    clientSocket->setsockopt(ZMQ_RECONNECT_IVL_MAX, &reconnectIvlMax, sizeof(reconnectIvlMax));
+    if (!curveServerKey.empty()) {
+        clientSocket->setsockopt(ZMQ_CURVE_SERVERKEY, curveServerKey.c_str(), curveServerKey.size());
+        clientSocket->setsockopt(ZMQ_CURVE_PUBLICKEY, curvePublicKey.c_str(), curvePublicKey.size());
+        clientSocket->setsockopt(ZMQ_CURVE_SECRETKEY, curveSecretKey.c_str(), curveSecretKey.size());
+    }
+    if (_balanced) {
+        // do not queue requests for nodes that are not connected
+        int immediate = 1;
+        clientSocket->setsockopt(ZMQ_IMMEDIATE, &immediate, sizeof(immediate));
+        for (auto &&url : urls) {
+            clientSocket->connect(url);
+        }
+    } else {
+        clientSocket->connect(urls.front());
+    }
+    return clientSocket;
+}
+
+shared_ptr <zmq::socket_t> ZMQClient::createMonitor(zmq::socket_t &_socket) {
+    string endpoint = "inproc://zmq-client-monitor-" + to_string(clientId) + "-" + to_string(monitorCounter++);
+
+    CHECK_STATE(zmq_socket_monitor(static_cast<void *>(_socket), endpoint.c_str(), ZMQ_EVENT_DISCONNECTED) == 0);
+
+    auto monitor = make_shared<zmq::socket_t>(ctx, ZMQ_PAIR);
+    int linger = 0;
+    monitor->setsockopt(ZMQ_LINGER, &linger, sizeof(linger));
+    monitor->connect(endpoint);
+    return monitor;
+}
+
+bool ZMQClient::peerDisconnected(zmq::socket_t &_monitor) {
+    bool disconnected = false;
+
+    while (true) {
+        // an event is a frame with the 16 bit event id and a 32 bit value, followed by the endpoint
+        zmq::message_t event;
+        if (!_monitor.recv(&event, ZMQ_DONTWAIT)) {
+            return disconnected;
+        }
+
+        if (event.size() >= sizeof(uint16_t)) {
+            uint16_t id;
+            memcpy(&id, event.data(), sizeof(id));
+            disconnected = disconnected || id == ZMQ_EVENT_DISCONNECTED;
+        }
+
+        while (event.more()) {
+            _monitor.recv(&event);
+        }
+    }
+}
+
+void ZMQClient::setRetryPolicy(uint64_t _maxRetries, uint64_t _requestTimeoutMs) {
+    // the server gets the timeout as the deadline of the request
+    CHECK_STATE(_requestTimeoutMs > 1000);
+    maxRetries = _maxRetries;
+    requestTimeoutMs = _requestTimeoutMs;
+}
+
+void ZMQClient::setHedgePercentile(double _percentile) {
+    CHECK_STATE(_percentile >= 0 && _percentile < 1);
+    hedgePercentile = _percentile;
+}
+
+void ZMQClient::enableCertFingerprint(bool _enabled) {
+    certFingerprint = _enabled;
+    certAccepted = false;
+}
+
+void ZMQClient::enableKeyCache(bool _enabled) {
+    keyCacheEnabled = _enabled;
+    if (!_enabled) {
+        clearKeyCache();
+    }
+}
+
+void ZMQClient::clearKeyCache() {
+    lock_guard<std::mutex> lock(keyCacheMutex);
+    blsPublicKeys.clear();
+    ecdsaPublicKeys.clear();
+    verificationVectors.clear();
+    allBlsPublicKeys.clear();
+}
+
+void ZMQClient::forgetName(const string &_name) {
+    lock_guard<std::mutex> lock(keyCacheMutex);
+    blsPublicKeys.erase(_name);
+    ecdsaPublicKeys.erase(_name);
+    verificationVectors.erase(verificationVectors.lower_bound({_name, INT_MIN}),
+                              verificationVectors.upper_bound({_name, INT_MAX}));
+}
+
+void ZMQClient::enableCurve(const string &_serverPublicKey) {
+    CHECK_STATE(_serverPublicKey.size() == 40);
+
+    {
+        lock_guard<recursive_mutex> lock(mutex);
+        CHECK_STATE(clientSockets.empty());
+    }
+
+    {
+        lock_guard<std::mutex> lock(asyncMutex);
+        CHECK_STATE(!asyncThread);
+    }
+
+    char publicBuf[41], secretBuf[41];
+    CHECK_STATE(zmq_curve_keypair(publicBuf, secretBuf) == 0);
+
+    curvePublicKey = publicBuf;
+    curveSecretKey = secretBuf;
+    curveServerKey = _serverPublicKey;
+
+    if (sign && urls.size() == 1) {
+        Json::Value p;
+        p["type"] = ZMQMessage::REGISTER_CURVE_KEY_REQ;
+        auto result = doRequestReply(p);
+        CHECK_STATE(result);
+        CHECK_STATE(result->getStatus() == 0);
+        curveRegistered = true;
+    }
+}
+
+void ZMQClient::reconnect(bool _balanced) {
+    auto clientSocket = createSocket(_balanced);
+    auto monitor = createMonitor(*clientSocket);
+
+    {
+        lock_guard< recursive_mutex > lock( mutex );
+        // the old socket of this thread and its monitor, if any, are closed here
+        clientMonitors[{getProcessID(), _balanced}] = monitor;
+        clientSockets[{getProcessID(), _balanced}] = clientSocket;
+    }
+
+    threadSockets[clientId * 2 + _balanced] = clientSocket.get();
+    threadMonitors[clientId * 2 + _balanced] = monitor.get();
+}
+
+static uint64_t nowMs() {
+    return chrono::duration_cast<chrono::milliseconds>(chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+bool ZMQClient::getSession(string &_sessionId, string &_sessionKey) {
+    lock_guard<std::mutex> lock(sessionMutex);
+
+    if (sessionId.empty() || nowMs() >= sessionRenewAtMs) {
+        startSession();
+    }
+
+    if (sessionId.empty()) {
+        return false;
+    }
+
+    _sessionId = sessionId;
+    _sessionKey = sessionKey;
+    return true;
+}
+
+void ZMQClient::startSession() {
+    sessionId.clear();
+    sessionKey.clear();
+
+    try {
+        Json::Value p;
+        p["type"] = ZMQMessage::START_SESSION_REQ;
+
+        auto reqStr = serializeSignedRequest(p);
+        auto resultStr = doZmqRequestReply(reqStr);
+
+        auto result = ZMQMessage::responseCast<startSessionRspMessage>(
+                ZMQMessage::parse(make_shared<string>(move(resultStr)), false, false, false));
+
+        CHECK_STATE(result);
+        CHECK_STATE(result->getStatus() == 0);
+
+        auto newKey = decryptSessionKey(pkey, result->getEncryptedSessionKey());
+        CHECK_STATE(newKey.size() == ZMQ_SESSION_KEY_BYTES);
+
+        // renew well before the server expires the session
+        sessionRenewAtMs = nowMs() + result->getSessionTTL() * 1000 / 2;
+        sessionKey = newKey;
+        sessionId = result->getSessionId();
+    } catch (exception &e) {
+        spdlog::warn("Could not start ZMQ session, falling back to signed requests: {}", e.what());
+        useSessions = false;
+    }
+}
+
+void ZMQClient::resetSession() {
+    lock_guard<std::mutex> lock(sessionMutex);
+    sessionId.clear();
+    sessionKey.clear();
+}
+
+future<shared_ptr<ZMQMessage>> ZMQClient::doRequestReplyAsync(Json::Value &_req) {
+    auto request = make_shared<AsyncRequest>();
+
+    uint64_t reqId = nextReqId++;
+
+    // reqId is part of the signed message
+    _req["reqId"] = (Json::UInt64) reqId;
+    request->request = serializeRequest(_req);
+
+    auto reply = request->reply.get_future();
+
+    {
+        lock_guard<std::mutex> lock(asyncMutex);
+
+        CHECK_STATE2(!asyncExitRequested, ZMQ_CLIENT_REQUEST_ABORTED);
+
+        if (!asyncThread) {
+            asyncEventFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+            CHECK_STATE(asyncEventFd >= 0);
+            asyncThread = make_shared<thread>(&ZMQClient::asyncLoop, this);
+        }
+
+        asyncPending[reqId] = request;
+        asyncOutgoing.push_back(reqId);
+    }
+
+    uint64_t one = 1;
+    if (write(asyncEventFd, &one, sizeof(one)) != sizeof(one)) {
+        spdlog::debug("Could not write to async eventfd");
+    }
+
+    return async(launch::deferred, [this](future<string> _reply) {
+        auto replyStr = make_shared<string>(_reply.get());
+        // the request fails, but the next ones start a new session or send the full cert
+        if (sign && ZMQMessage::isUnknownSessionReply(*replyStr)) {
+            resetSession();
+        }
+        if (sign && ZMQMessage::isUnknownCertReply(*replyStr)) {
+            certAccepted = false;
+        }
+        return ZMQMessage::parse(replyStr, false, false, false);
+    }, move(reply));
+}
+
+void ZMQClient::asyncLoop() {
+    // only sign requests are pipelined
+    auto socket = createSocket(urls.size() > 1);
+    auto monitor = createMonitor(*socket);
+
+    while (!asyncExitRequested) {
+        zmq_pollitem_t items[3];
+        items[0].socket = static_cast<void *>(*socket);
+        items[0].fd = 0;
+        items[0].events = ZMQ_POLLIN;
+        items[0].revents = 0;
+        items[1].socket = nullptr;
+        items[1].fd = asyncEventFd;
+        items[1].events = ZMQ_POLLIN;
+        items[1].revents = 0;
+        items[2].socket = static_cast<void *>(*monitor);
+        items[2].fd = 0;
+        items[2].events = ZMQ_POLLIN;
+        items[2].revents = 0;
+
+        zmq_poll(items, 3, ASYNC_POLL_TIMEOUT_MS);
+
+        // everything in flight is a sign request, so a lost connection resends at once
+        bool lost = (items[2].revents & ZMQ_POLLIN) && peerDisconnected(*monitor);
+
+        if (items[1].revents & ZMQ_POLLIN) {
+            uint64_t counter;
+            if (read(asyncEventFd, &counter, sizeof(counter)) != sizeof(counter)) {
+                spdlog::debug("Could not read from async eventfd");
+            }
+        }
+
+        vector<string> toSend;
+
+        {
+            lock_guard<std::mutex> lock(asyncMutex);
+            auto now = nowMs();
+            for (auto &&reqId : asyncOutgoing) {
+                auto it = asyncPending.find(reqId);
+                if (it != asyncPending.end()) {
+                    it->second->sentAtMs = now;
+                    toSend.push_back(it->second->request);
+                }
+            }
+            asyncOutgoing.clear();
+        }
+
+        for (auto &&request : toSend) {
+            s_send(*socket, request);
+        }
+
+        while (true) {
+            zmq::message_t msg;
+            if (!socket->recv(&msg, ZMQ_DONTWAIT)) {
+                break;
+            }
+
+            string reply((char *) msg.data(), msg.size());
+            uint64_t reqId;
+
+            if (!ZMQMessage::getReqId(reply, reqId)) {
+                spdlog::error("ZMQ client received a reply without reqId: {}", reply);
+                continue;
+            }
+
+            shared_ptr<AsyncRequest> request = nullptr;
+
+            {
+                lock_guard<std::mutex> lock(asyncMutex);
+                auto it = asyncPending.find(reqId);
+                if (it != asyncPending.end()) {
+                    request = it->second;
+                    asyncPending.erase(it);
+                }
+            }
+
+            // duplicates of retried requests are dropped
+            if (request) {
+                request->reply.set_value(reply);
+            }
+        }
+
+        // like the blocking client, a timeout means a new socket and resending everything in flight
+        lock_guard<std::mutex> lock(asyncMutex);
+
+        auto now = nowMs();
+        bool timedOut = lost && !asyncPending.empty();
+
+        for (auto &&pending : asyncPending) {
+            if (pending.second->sentAtMs > 0 && pending.second->sentAtMs + requestTimeoutMs < now) {
+                timedOut = true;
+                break;
+            }
+        }
+
+        if (timedOut) {
+            spdlog::error("W: no response from server, retrying {} requests...", asyncPending.size());
+            monitor = nullptr;
+            socket = createSocket(urls.size() > 1);
+            monitor = createMonitor(*socket);
+            asyncOutgoing.clear();
+            for (auto &&pending : asyncPending) {
+                asyncOutgoing.push_back(pending.first);
+            }
+        }
+    }
+
+    abortAsyncRequests();
+}
+
+void ZMQClient::abortAsyncRequests() {
+    lock_guard<std::mutex> lock(asyncMutex);
+
+    for (auto &&pending : asyncPending) {
+        pending.second->reply.set_exception(make_exception_ptr(
+                SGXException(ZMQ_CLIENT_REQUEST_ABORTED, "ZMQ client destroyed before the reply arrived")));
+    }
+
+    asyncPending.clear();
+    asyncOutgoing.clear();
+}
+
+ZMQClient::~ZMQClient() {
+    asyncExitRequested = true;
+
+    if (asyncThread) {
+        asyncThread->join();
+        close(asyncEventFd);
+    }
 }
 
 string ZMQClient::blsSignMessageHash(const std::string &keyShareName, const std::string &messageHash, int t, int n) {
     Json::Value p;
     p["type"] = ZMQMessage::BLS_SIGN_REQ;
-    p["keyShareName"] = keyShareName;
-    p["messageHash"] = messageHash;
-    p["n"] = n;
-    p["t"] = t;
-    auto result = dynamic_pointer_cast<BLSSignRspMessage>(doRequestReply(p));
+    BlsSignMessageHashParams{keyShareName, messageHash, n, t}.write(p);
+    auto result = ZMQMessage::responseCast<BLSSignRspMessage>(doRequestReply(p));
+    CHECK_STATE(result);
+    CHECK_STATE(result->getStatus() == 0);
+
+    return result->getSigShare();
+}
+
+string ZMQClient::blsSignHashedPoint(const std::string &keyShareName, const std::string &hashedPoint,
+                                     const std::string &hint) {
+    Json::Value p;
+    p["type"] = ZMQMessage::BLS_SIGN_HASHED_POINT_REQ;
+    BlsSignHashedPointParams{keyShareName, hashedPoint, hint}.write(p);
+    auto result = ZMQMessage::responseCast<BLSSignHashedPointRspMessage>(doRequestReply(p));
     CHECK_STATE(result);
     CHECK_STATE(result->getStatus() == 0);
 
     return result->getSigShare();
 }
 
+vector<string> ZMQClient::blsSignMessageHashBatch(const vector<tuple<string, string, int, int>>& requests) {
+    Json::Value p;
+    p["type"] = ZMQMessage::BLS_SIGN_BATCH_REQ;
+    p["requests"] = Json::Value(Json::arrayValue);
+    for (auto&& request : requests) {
+        Json::Value entry;
+        entry["keyShareName"] = get<0>(request);
+        entry["messageHash"] = get<1>(request);
+        entry["t"] = get<2>(request);
+        entry["n"] = get<3>(request);
+        p["requests"].append(entry);
+    }
+    auto result = ZMQMessage::responseCast<BLSSignBatchRspMessage>(doRequestReply(p));
+    CHECK_STATE(result);
+    CHECK_STATE(result->getStatus() == 0);
+
+    auto sigShares = result->getSigShares();
+    CHECK_STATE(sigShares.isArray());
+    CHECK_STATE(sigShares.size() == requests.size());
+
+    vector<string> ret;
+    ret.reserve(sigShares.size());
+    for (uint64_t i = 0; i < sigShares.size(); i++) {
+        ret.push_back(sigShares[(int) i].asString());
+    }
+
+    return ret;
+}
+
+future<string> ZMQClient::blsSignMessageHashAsync(const std::string &keyShareName, const std::string &messageHash,
+                                                  int t, int n) {
+    Json::Value p;
+    p["type"] = ZMQMessage::BLS_SIGN_REQ;
+    BlsSignMessageHashParams{keyShareName, messageHash, n, t}.write(p);
+
+    return async(launch::deferred, [](future<shared_ptr<ZMQMessage>> _reply) {
+        auto result = ZMQMessage::responseCast<BLSSignRspMessage>(_reply.get());
+        CHECK_STATE(result);
+        CHECK_STATE(result->getStatus() == 0);
+        return result->getSigShare();
+    }, doRequestReplyAsync(p));
+}
+
+future<string> ZMQClient::ecdsaSignMessageHashAsync(int base, const std::string &keyName,
+                                                    const std::string &messageHash) {
+    Json::Value p;
+    p["type"] = ZMQMessage::ECDSA_SIGN_REQ;
+    EcdsaSignMessageHashParams{keyName, messageHash, base}.write(p);
+
+    return async(launch::deferred, [](future<shared_ptr<ZMQMessage>> _reply) {
+        auto result = ZMQMessage::responseCast<ECDSASignRspMessage>(_reply.get());
+        CHECK_STATE(result);
+        CHECK_STATE(result->getStatus() == 0);
+        return result->getSignature();
+    }, doRequestReplyAsync(p));
+}
+
 string ZMQClient::ecdsaSignMessageHash(int base, const std::string &keyName, const std::string &messageHash) {
     Json::Value p;
     p["type"] = ZMQMessage::ECDSA_SIGN_REQ;
+    EcdsaSignMessageHashParams{keyName, messageHash, base}.write(p);
+    auto result = ZMQMessage::responseCast<ECDSASignRspMessage>(doRequestReply(p));
+    CHECK_STATE(result);
+    CHECK_STATE(result->getStatus() == 0);
+    return result->getSignature();
+}
+
+vector<string> ZMQClient::ecdsaSignMessageHashBatch(int base, const std::string &keyName,
+                                                    const vector<string> &messageHashes) {
+    Json::Value p;
+    p["type"] = ZMQMessage::ECDSA_SIGN_BATCH_REQ;
     p["base"] = base;
     p["keyName"] = keyName;
-    p["messageHash"] = messageHash;
-    auto result = dynamic_pointer_cast<ECDSASignRspMessage>(doRequestReply(p));
+    p["messageHashes"] = Json::Value(Json::arrayValue);
+    for (auto&& hash : messageHashes) {
+        p["messageHashes"].append(hash);
+    }
+    auto result = ZMQMessage::responseCast<ECDSASignBatchRspMessage>(doRequestReply(p));
     CHECK_STATE(result);
     CHECK_STATE(result->getStatus() == 0);
-    return result->getSignature();
+
+    auto signatures = result->getSignatures();
+    CHECK_STATE(signatures.size() == messageHashes.size());
+
+    return signatures;
 }
 
 bool ZMQClient::importBLSKeyShare(const std::string& keyShare, const std::string& keyName) {
+    forgetName(keyName);
+
     Json::Value p;
     p["type"] = ZMQMessage::IMPORT_BLS_REQ;
     p["keyShareName"] = keyName;
     p["keyShare"] = keyShare;
-    auto result = dynamic_pointer_cast<importBLSRspMessage>(doRequestReply(p));
+    auto result = ZMQMessage::responseCast<importBLSRspMessage>(doRequestReply(p));
     CHECK_STATE(result);
     return result->getStatus() == 0;
 }
 
 string ZMQClient::importECDSAKey(const std::string& keyShare, const std::string& keyName) {
+    forgetName(keyName);
+
     Json::Value p;
     p["type"] = ZMQMessage::IMPORT_ECDSA_REQ;
     p["keyName"] = keyName;
     p["key"] = keyShare;
-    auto result = dynamic_pointer_cast<importECDSARspMessage>(doRequestReply(p));
+    auto result = ZMQMessage::responseCast<importECDSARspMessage>(doRequestReply(p));
     CHECK_STATE(result);
     CHECK_STATE(result->getStatus() == 0);
     return result->getECDSAPublicKey();
 }
 
+vector<int> ZMQClient::importBLSKeyShareBatch(const vector<pair<string, string>>& keyShares) {
+    Json::Value p;
+    p["type"] = ZMQMessage::IMPORT_BLS_BATCH_REQ;
+    p["keyShares"] = Json::Value(Json::arrayValue);
+    for (auto&& keyShare : keyShares) {
+        forgetName(keyShare.first);
+        Json::Value share;
+        share["keyShareName"] = keyShare.first;
+        share["keyShare"] = keyShare.second;
+        p["keyShares"].append(share);
+    }
+    auto result = ZMQMessage::responseCast<importBLSBatchRspMessage>(doRequestReply(p));
+    CHECK_STATE(result);
+    CHECK_STATE(result->getStatus() == 0);
+
+    auto statuses = result->getStatuses();
+    CHECK_STATE(statuses.size() == keyShares.size());
+
+    return statuses;
+}
+
+vector<pair<int, string>> ZMQClient::importECDSAKeyBatch(const vector<pair<string, string>>& keys) {
+    Json::Value p;
+    p["type"] = ZMQMessage::IMPORT_ECDSA_BATCH_REQ;
+    p["keys"] = Json::Value(Json::arrayValue);
+    for (auto&& key : keys) {
+        forgetName(key.first);
+        Json::Value k;
+        k["keyName"] = key.first;
+        k["key"] = key.second;
+        p["keys"].append(k);
+    }
+    auto result = ZMQMessage::responseCast<importECDSABatchRspMessage>(doRequestReply(p));
+    CHECK_STATE(result);
+    CHECK_STATE(result->getStatus() == 0);
+
+    auto results = result->getResults();
+    CHECK_STATE(results.size() == keys.size());
+
+    return results;
+}
+
 pair<string, string> ZMQClient::generateECDSAKey() {
     Json::Value p;
     p["type"] = ZMQMessage::GENERATE_ECDSA_REQ;
-    auto result = dynamic_pointer_cast<generateECDSARspMessage>(doRequestReply(p));
+    auto result = ZMQMessage::responseCast<generateECDSARspMessage>(doRequestReply(p));
     CHECK_STATE(result);
     CHECK_STATE(result->getStatus() == 0);
     return {result->getECDSAPublicKey(), result->getKeyName()};
 }
 
 string ZMQClient::getECDSAPublicKey(const string& keyName) {
+    if (keyCacheEnabled) {
+        lock_guard<std::mutex> lock(keyCacheMutex);
+        auto it = ecdsaPublicKeys.find(keyName);
+        if (it != ecdsaPublicKeys.end()) {
+            keyCacheHits++;
+            return it->second;
+        }
+    }
+
     Json::Value p;
     p["type"] = ZMQMessage::GET_PUBLIC_ECDSA_REQ;
     p["keyName"] = keyName;
-    auto result = dynamic_pointer_cast<getPublicECDSARspMessage>(doRequestReply(p));
+    auto result = ZMQMessage::responseCast<getPublicECDSARspMessage>(doRequestReply(p));
     CHECK_STATE(result);
     CHECK_STATE(result->getStatus() == 0);
-    return result->getECDSAPublicKey();
+    auto publicKey = result->getECDSAPublicKey();
+
+    if (keyCacheEnabled) {
+        lock_guard<std::mutex> lock(keyCacheMutex);
+        if (ecdsaPublicKeys.size() >= ZMQ_CLIENT_KEY_CACHE_MAX_ENTRIES) {
+            ecdsaPublicKeys.clear();
+        }
+        ecdsaPublicKeys[keyName] = publicKey;
+    }
+
+    return publicKey;
 }
 
 bool ZMQClient::generateDKGPoly(const string& polyName, int t) {
+    forgetName(polyName);
+
     Json::Value p;
     p["type"] = ZMQMessage::GENERATE_DKG_POLY_REQ;
     p["polyName"] = polyName;
     p["t"] = t;
-    auto result = dynamic_pointer_cast<generateDKGPolyRspMessage>(doRequestReply(p));
+    auto result = ZMQMessage::responseCast<generateDKGPolyRspMessage>(doRequestReply(p));
     CHECK_STATE(result);
     return result->getStatus() == 0;
 }
 
+vector<string> ZMQClient::generateDKGPolyBatch(const vector<string>& polyNames, int t) {
+    Json::Value p;
+    p["type"] = ZMQMessage::GENERATE_DKG_POLY_BATCH_REQ;
+    p["polyNames"] = Json::Value(Json::arrayValue);
+    for (auto&& polyName : polyNames) {
+        forgetName(polyName);
+        p["polyNames"].append(polyName);
+    }
+    p["t"] = t;
+    auto result = ZMQMessage::responseCast<generateDKGPolyBatchRspMessage>(doRequestReply(p));
+    CHECK_STATE(result);
+    CHECK_STATE(result->getStatus() == 0);
+
+    auto verificationVectors = result->getVerificationVectors();
+    CHECK_STATE(verificationVectors.size() == polyNames.size());
+
+    vector<string> vectors;
+    for (auto&& verificationVector : verificationVectors) {
+        vectors.push_back(verificationVector.asString());
+    }
+    return vectors;
+}
+
 Json::Value ZMQClient::getVerificationVector(const string& polyName, int t) {
+    if (keyCacheEnabled) {
+        lock_guard<std::mutex> lock(keyCacheMutex);
+        auto it = verificationVectors.find({polyName, t});
+        if (it != verificationVectors.end()) {
+            keyCacheHits++;
+            return it->second;
+        }
+    }
+
     Json::Value p;
     p["type"] = ZMQMessage::GET_VV_REQ;
     p["polyName"] = polyName;
     p["t"] = t;
-    auto result = dynamic_pointer_cast<getVerificationVectorRspMessage>(doRequestReply(p));
+    auto result = ZMQMessage::responseCast<getVerificationVectorRspMessage>(doRequestReply(p));
     CHECK_STATE(result);
     CHECK_STATE(result->getStatus() == 0);
-    return result->getVerificationVector();
+    auto verificationVector = result->getVerificationVector();
+
+    if (keyCacheEnabled) {
+        lock_guard<std::mutex> lock(keyCacheMutex);
+        if (verificationVectors.size() >= ZMQ_CLIENT_KEY_CACHE_MAX_ENTRIES) {
+            verificationVectors.clear();
+        }
+        verificationVectors[{polyName, t}] = verificationVector;
+    }
+
+    return verificationVector;
 }
 
 string ZMQClient::getSecretShare(const string& polyName, const Json::Value& pubKeys, int t, int n) {
@@ -370,7 +1211,7 @@ string ZMQClient::getSecretShare(const string& polyName, const Json::Value& pubK
     p["publicKeys"] = pubKeys;
     p["t"] = t;
     p["n"] = n;
-    auto result = dynamic_pointer_cast<getSecretShareRspMessage>(doRequestReply(p));
+    auto result = ZMQMessage::responseCast<getSecretShareRspMessage>(doRequestReply(p));
     CHECK_STATE(result);
     CHECK_STATE(result->getStatus() == 0);
     return result->getSecretShare();
@@ -386,14 +1227,42 @@ bool ZMQClient::dkgVerification(const string& publicShares, const string& ethKey
     p["t"] = t;
     p["n"] = n;
     p["index"] = idx;
-    auto result = dynamic_pointer_cast<dkgVerificationRspMessage>(doRequestReply(p));
+    auto result = ZMQMessage::responseCast<dkgVerificationRspMessage>(doRequestReply(p));
     CHECK_STATE(result);
     CHECK_STATE(result->getStatus() == 0);
     return result->isCorrect();
 }
 
+vector<bool> ZMQClient::dkgVerificationBatch(const vector<string>& publicShares, const string& ethKeyName,
+                                             const vector<string>& secretShares, int t, int n, int idx) {
+    Json::Value p;
+    p["type"] = ZMQMessage::DKG_VERIFY_BATCH_REQ;
+    p["ethKeyName"] = ethKeyName;
+    p["publicShares"] = Json::Value(Json::arrayValue);
+    p["secretShares"] = Json::Value(Json::arrayValue);
+    for (auto&& share : publicShares) {
+        p["publicShares"].append(share);
+    }
+    for (auto&& share : secretShares) {
+        p["secretShares"].append(share);
+    }
+    p["t"] = t;
+    p["n"] = n;
+    p["index"] = idx;
+    auto result = ZMQMessage::responseCast<dkgVerificationBatchRspMessage>(doRequestReply(p));
+    CHECK_STATE(result);
+    CHECK_STATE(result->getStatus() == 0);
+
+    auto results = result->getResults();
+    CHECK_STATE(results.size() == publicShares.size());
+
+    return results;
+}
+
 bool ZMQClient::createBLSPrivateKey(const string& blsKeyName, const string& ethKeyName, const string& polyName,
                                     const string& secretShare, int t, int n) {
+    forgetName(blsKeyName);
+
     Json::Value p;
     p["type"] = ZMQMessage::CREATE_BLS_PRIVATE_REQ;
     p["ethKeyName"] = ethKeyName;
@@ -402,19 +1271,38 @@ bool ZMQClient::createBLSPrivateKey(const string& blsKeyName, const string& ethK
     p["secretShare"] = secretShare;
     p["t"] = t;
     p["n"] = n;
-    auto result = dynamic_pointer_cast<createBLSPrivateKeyRspMessage>(doRequestReply(p));
+    auto result = ZMQMessage::responseCast<createBLSPrivateKeyRspMessage>(doRequestReply(p));
     CHECK_STATE(result);
     return result->getStatus() == 0;
 }
 
 Json::Value ZMQClient::getBLSPublicKey(const string& blsKeyName) {
+    if (keyCacheEnabled) {
+        lock_guard<std::mutex> lock(keyCacheMutex);
+        auto it = blsPublicKeys.find(blsKeyName);
+        if (it != blsPublicKeys.end()) {
+            keyCacheHits++;
+            return it->second;
+        }
+    }
+
     Json::Value p;
     p["type"] = ZMQMessage::GET_BLS_PUBLIC_REQ;
     p["blsKeyName"] = blsKeyName;
-    auto result = dynamic_pointer_cast<getBLSPublicRspMessage>(doRequestReply(p));
+    auto result = ZMQMessage::responseCast<getBLSPublicRspMessage>(doRequestReply(p));
     CHECK_STATE(result);
     CHECK_STATE(result->getStatus() == 0);
-    return result->getBLSPublicKey();
+    auto publicKey = result->getBLSPublicKey();
+
+    if (keyCacheEnabled) {
+        lock_guard<std::mutex> lock(keyCacheMutex);
+        if (blsPublicKeys.size() >= ZMQ_CLIENT_KEY_CACHE_MAX_ENTRIES) {
+            blsPublicKeys.clear();
+        }
+        blsPublicKeys[blsKeyName] = publicKey;
+    }
+
+    return publicKey;
 }
 
 Json::Value ZMQClient::getAllBlsPublicKeys(const Json::Value& publicShares, int n, int t) {
@@ -423,10 +1311,34 @@ Json::Value ZMQClient::getAllBlsPublicKeys(const Json::Value& publicShares, int
     p["publicShares"] = publicShares["publicShares"];
     p["t"] = t;
     p["n"] = n;
-    auto result = dynamic_pointer_cast<getAllBLSPublicKeysRspMessage>(doRequestReply(p));
+
+    // the public keys are a function of the shares, t and n
+    string cacheKey;
+    if (keyCacheEnabled) {
+        Json::FastWriter fastWriter;
+        cacheKey = fastWriter.write(p);
+        lock_guard<std::mutex> lock(keyCacheMutex);
+        auto it = allBlsPublicKeys.find(cacheKey);
+        if (it != allBlsPublicKeys.end()) {
+            keyCacheHits++;
+            return it->second;
+        }
+    }
+
+    auto result = ZMQMessage::responseCast<getAllBLSPublicKeysRspMessage>(doRequestReply(p));
     CHECK_STATE(result);
     CHECK_STATE(result->getStatus() == 0);
-    return result->getPublicKeys();
+    auto publicKeys = result->getPublicKeys();
+
+    if (!cacheKey.empty()) {
+        lock_guard<std::mutex> lock(keyCacheMutex);
+        if (allBlsPublicKeys.size() >= ZMQ_CLIENT_KEY_CACHE_MAX_ENTRIES) {
+            allBlsPublicKeys.clear();
+        }
+        allBlsPublicKeys[cacheKey] = publicKeys;
+    }
+
+    return publicKeys;
 }
 
 tuple<string, string, Json::Value> ZMQClient::complaintResponse(const string& polyName, int t, int n, int idx) {
@@ -436,7 +1348,7 @@ tuple<string, string, Json::Value> ZMQClient::complaintResponse(const string& po
     p["t"] = t;
     p["n"] = n;
     p["ind"] = idx;
-    auto result = dynamic_pointer_cast<complaintResponseRspMessage>(doRequestReply(p));
+    auto result = ZMQMessage::responseCast<complaintResponseRspMessage>(doRequestReply(p));
     CHECK_STATE(result);
     CHECK_STATE(result->getStatus() == 0);
     return {result->getDHKey(), result->getShare(), result->getVerificationVectorMult()};
@@ -446,17 +1358,86 @@ Json::Value ZMQClient::multG2(const string& x) {
     Json::Value p;
     p["type"] = ZMQMessage::MULT_G2_REQ;
     p["x"] = x;
-    auto result = dynamic_pointer_cast<multG2RspMessage>(doRequestReply(p));
+    auto result = ZMQMessage::responseCast<multG2RspMessage>(doRequestReply(p));
     CHECK_STATE(result);
     CHECK_STATE(result->getStatus() == 0);
     return result->getResult();
 }
 
+Json::Value ZMQClient::multG2Batch(const vector<string>& xs) {
+    Json::Value p;
+    p["type"] = ZMQMessage::MULT_G2_BATCH_REQ;
+    p["xs"] = Json::Value(Json::arrayValue);
+    for (auto&& x : xs) {
+        p["xs"].append(x);
+    }
+    auto result = ZMQMessage::responseCast<multG2BatchRspMessage>(doRequestReply(p));
+    CHECK_STATE(result);
+    CHECK_STATE(result->getStatus() == 0);
+
+    auto xG2s = result->getResult();
+    CHECK_STATE(xG2s.size() == xs.size());
+
+    return xG2s;
+}
+
+string ZMQClient::aggregateBLSSignatures(const vector<string>& shares, const vector<size_t>& signerIndices, int t,
+                                         int n) {
+    CHECK_STATE(shares.size() == signerIndices.size());
+
+    Json::Value p;
+    p["type"] = ZMQMessage::AGGREGATE_BLS_SIGNATURES_REQ;
+    p["shares"] = Json::Value(Json::arrayValue);
+    p["signerIndices"] = Json::Value(Json::arrayValue);
+    for (uint64_t i = 0; i < shares.size(); i++) {
+        p["shares"].append(shares[i]);
+        p["signerIndices"].append((Json::UInt) signerIndices[i]);
+    }
+    p["t"] = t;
+    p["n"] = n;
+    auto result = ZMQMessage::responseCast<aggregateBLSSignaturesRspMessage>(doRequestReply(p));
+    CHECK_STATE(result);
+    CHECK_STATE(result->getStatus() == 0);
+
+    return result->getSignature();
+}
+
+vector<bool> ZMQClient::verifyBLSSignatures(const vector<tuple<vector<string>, string, string>>& requests) {
+    Json::Value p;
+    p["type"] = ZMQMessage::VERIFY_BLS_SIGNATURES_REQ;
+    p["requests"] = Json::Value(Json::arrayValue);
+    for (auto&& request : requests) {
+        Json::Value entry;
+        entry["publicKey"] = Json::Value(Json::arrayValue);
+        for (auto&& coordinate : get<0>(request)) {
+            entry["publicKey"].append(coordinate);
+        }
+        entry["messageHash"] = get<1>(request);
+        entry["signature"] = get<2>(request);
+        p["requests"].append(entry);
+    }
+    auto result = ZMQMessage::responseCast<verifyBLSSignaturesRspMessage>(doRequestReply(p));
+    CHECK_STATE(result);
+    CHECK_STATE(result->getStatus() == 0);
+
+    auto valid = result->getValid();
+    CHECK_STATE(valid.isArray());
+    CHECK_STATE(valid.size() == requests.size());
+
+    vector<bool> ret;
+    ret.reserve(valid.size());
+    for (uint64_t i = 0; i < valid.size(); i++) {
+        ret.push_back(valid[(int) i].asBool());
+    }
+
+    return ret;
+}
+
 bool ZMQClient::isPolyExists(const string& polyName) {
     Json::Value p;
     p["type"] = ZMQMessage::IS_POLY_EXISTS_REQ;
     p["polyName"] = polyName;
-    auto result = dynamic_pointer_cast<isPolyExistsRspMessage>(doRequestReply(p));
+    auto result = ZMQMessage::responseCast<isPolyExistsRspMessage>(doRequestReply(p));
     CHECK_STATE(result);
     CHECK_STATE(result->getStatus() == 0);
     return result->isExists();
@@ -465,7 +1446,7 @@ bool ZMQClient::isPolyExists(const string& polyName) {
 void ZMQClient::getServerStatus() {
     Json::Value p;
     p["type"] = ZMQMessage::GET_SERVER_STATUS_REQ;
-    auto result = dynamic_pointer_cast<getServerStatusRspMessage>(doRequestReply(p));
+    auto result = ZMQMessage::responseCast<getServerStatusRspMessage>(doRequestReply(p));
     CHECK_STATE(result);
     CHECK_STATE(result->getStatus() == 0);
 }
@@ -473,17 +1454,19 @@ void ZMQClient::getServerStatus() {
 string ZMQClient::getServerVersion() {
     Json::Value p;
     p["type"] = ZMQMessage::GET_SERVER_VERSION_REQ;
-    auto result = dynamic_pointer_cast<getServerVersionRspMessage>(doRequestReply(p));
+    auto result = ZMQMessage::responseCast<getServerVersionRspMessage>(doRequestReply(p));
     CHECK_STATE(result);
     CHECK_STATE(result->getStatus() == 0);
     return result->getVersion();
 }
 
 bool ZMQClient::deleteBLSKey(const string& blsKeyName) {
+    forgetName(blsKeyName);
+
     Json::Value p;
     p["type"] = ZMQMessage::DELETE_BLS_KEY_REQ;
     p["blsKeyName"] = blsKeyName;
-    auto result = dynamic_pointer_cast<deleteBLSKeyRspMessage>(doRequestReply(p));
+    auto result = ZMQMessage::responseCast<deleteBLSKeyRspMessage>(doRequestReply(p));
     CHECK_STATE(result);
     CHECK_STATE(result->getStatus() == 0);
     return result->isSuccessful();
@@ -494,17 +1477,19 @@ Json::Value ZMQClient::getDecryptionShares(const string& blsKeyName, const Json:
     p["type"] = ZMQMessage::GET_DECRYPTION_SHARE_REQ;
     p["blsKeyName"] = blsKeyName;
     p["publicDecryptionValues"] = publicDecryptionValues["publicDecryptionValues"];
-    auto result = dynamic_pointer_cast<GetDecryptionShareRspMessage>(doRequestReply(p));
+    auto result = ZMQMessage::responseCast<GetDecryptionShareRspMessage>(doRequestReply(p));
     CHECK_STATE(result);
     CHECK_STATE(result->getStatus() == 0);
     return result->getShare();
 }
 
 bool ZMQClient::generateBLSPrivateKey(const string& blsKeyName) {
+    forgetName(blsKeyName);
+
     Json::Value p;
     p["blsKeyName"] = blsKeyName;
     p["type"] = ZMQMessage::GENERATE_BLS_PRIVATE_KEY_REQ;
-    auto result = dynamic_pointer_cast<generateBLSPrivateKeyRspMessage>(doRequestReply(p));
+    auto result = ZMQMessage::responseCast<generateBLSPrivateKeyRspMessage>(doRequestReply(p));
     CHECK_STATE(result);
     return result->getStatus() == 0;
 }
@@ -513,12 +1498,46 @@ std::string ZMQClient::popProve(const string& blsKeyName) {
     Json::Value p;
     p["blsKeyName"] = blsKeyName;
     p["type"] = ZMQMessage::POP_PROVE_REQ;
-    auto result = dynamic_pointer_cast<popProveRspMessage>(doRequestReply(p));
+    auto result = ZMQMessage::responseCast<popProveRspMessage>(doRequestReply(p));
     CHECK_STATE(result);
     CHECK_STATE(result->getStatus() == 0);
     return result->getPopProve();
 }
 
+bool ZMQClient::generateBLSPrivateKeyBatch(const vector<string>& blsKeyNames) {
+    Json::Value p;
+    p["type"] = ZMQMessage::GENERATE_BLS_PRIVATE_KEY_BATCH_REQ;
+    p["blsKeyNames"] = Json::Value(Json::arrayValue);
+    for (auto&& blsKeyName : blsKeyNames) {
+        forgetName(blsKeyName);
+        p["blsKeyNames"].append(blsKeyName);
+    }
+    auto result = ZMQMessage::responseCast<generateBLSPrivateKeyBatchRspMessage>(doRequestReply(p));
+    CHECK_STATE(result);
+    return result->getStatus() == 0;
+}
+
+vector<string> ZMQClient::popProveBatch(const vector<string>& blsKeyNames) {
+    Json::Value p;
+    p["type"] = ZMQMessage::POP_PROVE_BATCH_REQ;
+    p["blsKeyNames"] = Json::Value(Json::arrayValue);
+    for (auto&& blsKeyName : blsKeyNames) {
+        p["blsKeyNames"].append(blsKeyName);
+    }
+    auto result = ZMQMessage::responseCast<popProveBatchRspMessage>(doRequestReply(p));
+    CHECK_STATE(result);
+    CHECK_STATE(result->getStatus() == 0);
+
+    auto popProves = result->getPopProves();
+    CHECK_STATE(popProves.size() == blsKeyNames.size());
+
+    vector<string> proves;
+    for (auto&& prove : popProves) {
+        proves.push_back(prove.asString());
+    }
+    return proves;
+}
+
 uint64_t ZMQClient::getProcessID() {
     return syscall(__NR_gettid);
 }
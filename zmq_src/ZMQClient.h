@@ -29,14 +29,28 @@
 #include <openssl/err.h>
 #include <openssl/sha.h>
 #include <openssl/rand.h>
+#include <openssl/hmac.h>
+#include <openssl/rsa.h>
+
+#include <atomic>
+#include <deque>
+#include <future>
+#include <thread>
 
 #include "third_party/spdlog/spdlog.h"
 #include <zmq.hpp>
 #include "zhelpers.hpp"
 #include <jsonrpccpp/client.h>
 #include "ZMQMessage.h"
+#include "Metrics.h"
 
 #define REQUEST_TIMEOUT     10000    //  msecs, (> 1000!)
+#define ASYNC_POLL_TIMEOUT_MS 100
+
+// hedged sign requests, see ZMQClient::setHedgePercentile
+#define HEDGE_MIN_SAMPLES 100
+#define HEDGE_DEFAULT_DELAY_MS 50
+#define HEDGE_MIN_DELAY_MS 2
 
 class ZMQClient {
 private:
@@ -51,51 +65,248 @@ private:
     string certificate = "";
     string key = "";
 
+    // sha256 of the cert, sent instead of the cert once a server has verified it
+    string certHash = "";
+    atomic<bool> certFingerprint;
+    atomic<bool> certAccepted;
+
     recursive_mutex mutex;
 
     zmq::context_t ctx;
 
-    string url;
+    // the first endpoint is the cluster leader, see KeyStoreReplicator.h
+    vector<string> urls;
+
+    // Every thread gets its own DEALER socket, so threads never see each other's replies.
+    // The sockets are owned here, under mutex, so that they are closed before ctx. Threads
+    // check out their socket through a thread_local cache without taking the mutex.
+    // Each thread has a leader socket, and with several endpoints also a balanced socket
+    // connected to all of them, keyed by (thread id, balanced)
+    map<pair<uint64_t, bool>, shared_ptr <zmq::socket_t>> clientSockets;
+
+    // PAIR sockets receiving the disconnect events of clientSockets, same keys
+    map<pair<uint64_t, bool>, shared_ptr <zmq::socket_t>> clientMonitors;
+
+    // distinguishes clients in the thread_local cache, never reused
+    const uint64_t clientId;
+
+    static atomic<uint64_t> clientCounter;
+
+    zmq::socket_t &getThreadSocket(bool _balanced);
 
-    // generate random identity
+    zmq::socket_t &getThreadMonitor(bool _balanced);
 
-    map<uint64_t , shared_ptr <zmq::socket_t>> clientSockets;
+    // 0 retries forever
+    atomic<uint64_t> maxRetries;
+
+    atomic<uint64_t> requestTimeoutMs;
+
+    // unique inproc endpoints of the socket monitors
+    atomic<uint64_t> monitorCounter;
+
+    // latency percentile after which a balanced sign request is duplicated, 0 disables hedging
+    atomic<double> hedgePercentile;
+
+    atomic<uint64_t> hedgedRequests;
+
+    // round trip time of balanced sign requests, the hedge delay is taken from it
+    MetricsHistogram signLatency;
+
+    uint64_t getHedgeDelayMs() const;
+
+    // sign requests are spread over all endpoints, everything else goes to the leader
+    bool isBalanced(const string &_req) const;
 
     shared_ptr <ZMQMessage> doRequestReply(Json::Value &_req);
 
     string doZmqRequestReply(string &_req);
 
+    string serializeRequest(Json::Value &_req);
+
+    // serializes a request authenticated with the cert and an RSA signature
+    string serializeSignedRequest(Json::Value &_req);
+
+    // Signed clients authenticate once with startSessionReq and then send an HMAC under
+    // the session key instead of the cert and signature. Sessions are turned off if
+    // the server does not support them.
+    atomic<bool> useSessions;
+    std::mutex sessionMutex;
+    string sessionId;
+    string sessionKey;
+    uint64_t sessionRenewAtMs = 0;
+
+    // returns false if requests have to be signed instead
+    bool getSession(string &_sessionId, string &_sessionKey);
+
+    void startSession();
+
+    void resetSession();
+
+    // CurveZMQ keys, empty unless enableCurve was called
+    string curveServerKey;
+    string curvePublicKey;
+    string curveSecretKey;
+
+    // the server knows the cert of the curve key, so requests are not signed
+    atomic<bool> curveRegistered;
+
+    // a balanced socket connects to every endpoint. DEALER sends its messages round robin to the
+    // endpoints that are connected, so a node that is down is skipped until it is back
+    shared_ptr <zmq::socket_t> createSocket(bool _balanced);
+
+    // a PAIR socket that receives ZMQ_EVENT_DISCONNECTED of _socket
+    shared_ptr <zmq::socket_t> createMonitor(zmq::socket_t &_socket);
+
+    // drains the monitor, true if a connection of the monitored socket was lost
+    static bool peerDisconnected(zmq::socket_t &_monitor);
+
+    // Pipelined requests share one DEALER socket owned by asyncThread. Callers queue
+    // requests and wake the thread through asyncEventFd, replies are matched by reqId.
+    struct AsyncRequest {
+        string request;
+        promise<string> reply;
+        uint64_t sentAtMs = 0;
+    };
+
+    std::mutex asyncMutex;
+    map<uint64_t, shared_ptr<AsyncRequest>> asyncPending;
+    deque<uint64_t> asyncOutgoing;
+    shared_ptr<thread> asyncThread;
+    int asyncEventFd = -1;
+    atomic<bool> asyncExitRequested;
+    atomic<uint64_t> nextReqId;
+
+    void asyncLoop();
+
+    void abortAsyncRequests();
+
     uint64_t getProcessID();
 
     static string readFileIntoString(const string& _fileName);
 
+    // Public keys and verification vectors never change for a key or poly name, so they can
+    // be kept on the client. Entries are dropped when this client deletes, imports or creates
+    // a key or poly of the same name, each map is cleared when it is full
+    atomic<bool> keyCacheEnabled;
+    std::mutex keyCacheMutex;
+    map<string, Json::Value> blsPublicKeys;
+    map<string, string> ecdsaPublicKeys;
+    map<pair<string, int>, Json::Value> verificationVectors;
+    // keyed by the serialized request
+    map<string, Json::Value> allBlsPublicKeys;
+    atomic<uint64_t> keyCacheHits;
+
+    // drops the cached public keys and verification vectors of a key or poly name
+    void forgetName(const string& _name);
+
 public:
 
     ZMQClient(const string &ip, uint16_t port, bool _sign, const string&  _certPathName,
               const string& _certKeyName);
 
-    void reconnect();
+    // (ip, port) of the nodes of an sgxwallet cluster, the leader first. Sessions are per node,
+    // so a client of several endpoints signs every request
+    ZMQClient(const vector<pair<string, uint16_t>> &_endpoints, bool _sign, const string&  _certPathName,
+              const string& _certKeyName);
+
+    ~ZMQClient();
+
+    // sends the request and returns at once, many requests can be in flight at the same time.
+    // Replies are parsed on get(), requests still pending when the client is destroyed fail
+    // with ZMQ_CLIENT_REQUEST_ABORTED
+    future<shared_ptr<ZMQMessage>> doRequestReplyAsync(Json::Value &_req);
+
+    void reconnect(bool _balanced = false);
+
+    // A request is resent on a new socket when no reply arrives within _requestTimeoutMs.
+    // Sign requests have no side effects, so they are also resent as soon as heartbeats or
+    // the OS report the connection as lost. After _maxRetries resends the request fails
+    // with ZMQ_CLIENT_RETRIES_EXHAUSTED, 0 retries forever. Pipelined requests use the same
+    // timeout and are retried until the client is destroyed
+    void setRetryPolicy(uint64_t _maxRetries, uint64_t _requestTimeoutMs);
+
+    // With several endpoints, a sign request that got no reply after the _percentile latency
+    // of earlier sign requests is sent once more, on the balanced socket that sends it to the next
+    // node. The first reply wins, the other is dropped by its reqId. 0 turns hedging off
+    void setHedgePercentile(double _percentile);
+
+    uint64_t getHedgedRequests() const { return hedgedRequests; }
+
+    // caches the results of getBLSPublicKey, getECDSAPublicKey, getVerificationVector and
+    // getAllBlsPublicKeys. Keys deleted or replaced by another client stay in the cache
+    void enableKeyCache(bool _enabled);
+
+    void clearKeyCache();
+
+    uint64_t getKeyCacheHits() const { return keyCacheHits; }
+
+    // Signed requests carry only the hash of the cert after the first reply, servers keep
+    // verified certs by their hash. A server that does not know the hash, for example after
+    // a restart, replies ZMQ_UNKNOWN_CERT and the request is resent with the full cert.
+    // Needs servers that support it, sessions avoid sending the cert already
+    void enableCertFingerprint(bool _enabled);
+
+    // encrypts the connection with CurveZMQ, has to be called before the first request.
+    // A signing client registers its curve key to its cert and stops signing requests. Clients
+    // of several endpoints keep signing, since the followers learn of the key only after it has
+    // been replicated. All nodes of a cluster have to use the same curve key pair
+    void enableCurve(const string& _serverPublicKey);
 
     static pair<EVP_PKEY*, X509*> readPublicKeyFromCertStr(const string& _cert);
 
+    // signatures cover the whitespace-free form of the message, this keeps signatures
+    // compatible with servers that verify the re-serialized request
+    static string stripWhitespace(const char* _str, size_t _size);
+
+    static string stripWhitespace(const string& _str);
+
     static string signString(EVP_PKEY* _pkey, const string& _str);
 
     static void verifySig(EVP_PKEY* _pubkey, const string& _str, const string& _sig);
 
+    // hex HMAC-SHA256 of a session request
+    static string macString(const string& _key, const string& _str);
+
+    static string encryptSessionKey(EVP_PKEY* _pubkey, const string& _key);
+
+    static string decryptSessionKey(EVP_PKEY* _pkey, const string& _encryptedKey);
+
     string blsSignMessageHash(const std::string &keyShareName, const std::string &messageHash, int t, int n);
 
+    // each request is (keyShareName, messageHash, t, n), signature shares are returned in the same order
+    // signs a G1 point "X:Y" the client hashed with HashtoG1withHint, hint is the counter it returned
+    string blsSignHashedPoint(const std::string &keyShareName, const std::string &hashedPoint, const std::string &hint);
+
+    vector<string> blsSignMessageHashBatch(const vector<tuple<string, string, int, int>>& requests);
+
+    future<string> blsSignMessageHashAsync(const std::string &keyShareName, const std::string &messageHash, int t, int n);
+
     string ecdsaSignMessageHash(int base, const std::string &keyName, const std::string &messageHash);
 
+    future<string> ecdsaSignMessageHashAsync(int base, const std::string &keyName, const std::string &messageHash);
+
+    // signs all hashes with one key, signatures are returned in the same order
+    vector<string> ecdsaSignMessageHashBatch(int base, const std::string &keyName, const vector<string> &messageHashes);
+
     bool importBLSKeyShare(const std::string& keyShare, const std::string& keyName);
 
     string importECDSAKey(const std::string& keyShare, const std::string& keyName);
 
+    // (key name, key share) pairs, returns the import status of every share
+    vector<int> importBLSKeyShareBatch(const vector<pair<string, string>>& keyShares);
+
+    // (key name, key) pairs, returns the import status and public key of every key
+    vector<pair<int, string>> importECDSAKeyBatch(const vector<pair<string, string>>& keys);
+
     pair<string, string> generateECDSAKey();
 
     string getECDSAPublicKey(const string& keyName);
 
     bool generateDKGPoly(const string& polyName, int t);
 
+    // the compressed verification vector of each poly, in the order of polyNames
+    vector<string> generateDKGPolyBatch(const vector<string>& polyNames, int t);
+
     Json::Value getVerificationVector(const string& polyName, int t);
 
     string getSecretShare(const string& polyName, const Json::Value& pubKeys, int t, int n);
@@ -103,12 +314,21 @@ public:
     bool dkgVerification(const string& publicShares, const string& ethKeyName,
                         const string& secretShare, int t, int n, int idx);
 
+    // verifies the shares received from all dealers, result i is true if the share of dealer i is valid
+    vector<bool> dkgVerificationBatch(const vector<string>& publicShares, const string& ethKeyName,
+                                      const vector<string>& secretShares, int t, int n, int idx);
+
     bool createBLSPrivateKey(const string& blsKeyName, const string& ethKeyName, const string& polyName,
                             const string& secretShare, int t, int n);
 
     string popProve(const string& blsKeyName);
 
     bool generateBLSPrivateKey(const string& blsKeyName);
+
+    bool generateBLSPrivateKeyBatch(const vector<string>& blsKeyNames);
+
+    // the PoP of each key, in the order of blsKeyNames
+    vector<string> popProveBatch(const vector<string>& blsKeyNames);
     
     Json::Value getBLSPublicKey(const string& blsKeyName);
 
@@ -118,6 +338,15 @@ public:
 
     Json::Value multG2(const string& x);
 
+    // x * G2 for every scalar, in the order of xs
+    Json::Value multG2Batch(const vector<string>& xs);
+
+    // threshold signature from t signature shares, signerIndices are the 1-based indices of the signers
+    string aggregateBLSSignatures(const vector<string>& shares, const vector<size_t>& signerIndices, int t, int n);
+
+    // each request is (publicKey, messageHash, signature), result i is true if signature i is valid
+    vector<bool> verifyBLSSignatures(const vector<tuple<vector<string>, string, string>>& requests);
+
     bool isPolyExists(const string& polyName);
 
     void getServerStatus();
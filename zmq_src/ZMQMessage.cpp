@@ -24,11 +24,20 @@
 #include "common.h"
 #include "sgxwallet_common.h"
 #include <third_party/cryptlite/sha256.h>
+#include <cctype>
+#include <chrono>
+#include <ctime>
+#include <cstring>
+#include <unordered_map>
 #include <iostream>
 #include <fstream>
 
+#include <openssl/crypto.h>
+
 #include "ZMQClient.h"
+#include "CertVerifier.h"
 #include "LevelDB.h"
+#include "KeyStoreReplicator.h"
 #include "SGXWalletServer.hpp"
 #include "ReqMessage.h"
 #include "RspMessage.h"
@@ -67,6 +76,13 @@ bool ZMQMessage::getBoolRapid(const char *_name) {
     return a.GetBool();
 }
 
+string_view ZMQMessage::getStringViewRapid(const char *_name) {
+    CHECK_STATE(_name);
+    CHECK_STATE(d->HasMember(_name));
+    CHECK_STATE((*d)[_name].IsString());
+    return string_view((*d)[_name].GetString(), (*d)[_name].GetStringLength());
+}
+
 string ZMQMessage::getStringRapid(const char *_name) {
     CHECK_STATE(_name);
     CHECK_STATE(d->HasMember(_name));
@@ -74,301 +90,629 @@ string ZMQMessage::getStringRapid(const char *_name) {
     return (*d)[_name].GetString();
 };
 
+// Message types and factories are indexed by the Requests and Responses tags,
+// their order has to match the enums
+
+template<class T>
+static shared_ptr<ZMQMessage> makeMessage(shared_ptr<rapidjson::Document> &_d) {
+    return make_shared<T>(_d);
+}
+
+typedef shared_ptr<ZMQMessage> (*MessageFactory)(shared_ptr<rapidjson::Document> &);
+
+static constexpr const char *requestTypes[] = {
+    ZMQMessage::BLS_SIGN_REQ, ZMQMessage::ECDSA_SIGN_REQ, ZMQMessage::IMPORT_BLS_REQ,
+    ZMQMessage::IMPORT_ECDSA_REQ, ZMQMessage::GENERATE_ECDSA_REQ, ZMQMessage::GET_PUBLIC_ECDSA_REQ,
+    ZMQMessage::GENERATE_DKG_POLY_REQ, ZMQMessage::GET_VV_REQ, ZMQMessage::GET_SECRET_SHARE_REQ,
+    ZMQMessage::DKG_VERIFY_REQ, ZMQMessage::CREATE_BLS_PRIVATE_REQ, ZMQMessage::GET_BLS_PUBLIC_REQ,
+    ZMQMessage::GET_ALL_BLS_PUBLIC_REQ, ZMQMessage::COMPLAINT_RESPONSE_REQ, ZMQMessage::MULT_G2_REQ,
+    ZMQMessage::IS_POLY_EXISTS_REQ, ZMQMessage::GET_SERVER_STATUS_REQ, ZMQMessage::GET_SERVER_VERSION_REQ,
+    ZMQMessage::DELETE_BLS_KEY_REQ, ZMQMessage::GET_DECRYPTION_SHARE_REQ,
+    ZMQMessage::GENERATE_BLS_PRIVATE_KEY_REQ, ZMQMessage::POP_PROVE_REQ, ZMQMessage::BLS_SIGN_BATCH_REQ,
+    ZMQMessage::ECDSA_SIGN_BATCH_REQ, ZMQMessage::DKG_VERIFY_BATCH_REQ, ZMQMessage::START_SESSION_REQ,
+    ZMQMessage::REGISTER_CURVE_KEY_REQ, ZMQMessage::IMPORT_BLS_BATCH_REQ, ZMQMessage::IMPORT_ECDSA_BATCH_REQ,
+    ZMQMessage::MULT_G2_BATCH_REQ, ZMQMessage::AGGREGATE_BLS_SIGNATURES_REQ,
+    ZMQMessage::VERIFY_BLS_SIGNATURES_REQ, ZMQMessage::BLS_SIGN_HASHED_POINT_REQ,
+    ZMQMessage::GENERATE_DKG_POLY_BATCH_REQ, ZMQMessage::GENERATE_BLS_PRIVATE_KEY_BATCH_REQ,
+    ZMQMessage::POP_PROVE_BATCH_REQ
+};
+
+static const MessageFactory requestFactories[] = {
+    makeMessage<BLSSignReqMessage>, makeMessage<ECDSASignReqMessage>, makeMessage<importBLSReqMessage>,
+    makeMessage<importECDSAReqMessage>, makeMessage<generateECDSAReqMessage>,
+    makeMessage<getPublicECDSAReqMessage>, makeMessage<generateDKGPolyReqMessage>,
+    makeMessage<getVerificationVectorReqMessage>, makeMessage<getSecretShareReqMessage>,
+    makeMessage<dkgVerificationReqMessage>, makeMessage<createBLSPrivateKeyReqMessage>,
+    makeMessage<getBLSPublicReqMessage>, makeMessage<getAllBLSPublicKeysReqMessage>,
+    makeMessage<complaintResponseReqMessage>, makeMessage<multG2ReqMessage>,
+    makeMessage<isPolyExistsReqMessage>, makeMessage<getServerStatusReqMessage>,
+    makeMessage<getServerVersionReqMessage>, makeMessage<deleteBLSKeyReqMessage>,
+    makeMessage<GetDecryptionShareReqMessage>, makeMessage<generateBLSPrivateKeyReqMessage>,
+    makeMessage<popProveReqMessage>, makeMessage<BLSSignBatchReqMessage>,
+    makeMessage<ECDSASignBatchReqMessage>, makeMessage<dkgVerificationBatchReqMessage>,
+    makeMessage<startSessionReqMessage>, makeMessage<registerCurveKeyReqMessage>,
+    makeMessage<importBLSBatchReqMessage>, makeMessage<importECDSABatchReqMessage>,
+    makeMessage<multG2BatchReqMessage>, makeMessage<aggregateBLSSignaturesReqMessage>,
+    makeMessage<verifyBLSSignaturesReqMessage>, makeMessage<BLSSignHashedPointReqMessage>,
+    makeMessage<generateDKGPolyBatchReqMessage>, makeMessage<generateBLSPrivateKeyBatchReqMessage>,
+    makeMessage<popProveBatchReqMessage>
+};
+
+static_assert(sizeof(requestTypes) / sizeof(requestTypes[0]) == ZMQMessage::NUM_REQUESTS, "Request types do not match Requests");
+static_assert(sizeof(requestFactories) / sizeof(requestFactories[0]) == ZMQMessage::NUM_REQUESTS,
+              "Request factories do not match Requests");
+
+static constexpr const char *responseTypes[] = {
+    ZMQMessage::BLS_SIGN_RSP, ZMQMessage::ECDSA_SIGN_RSP, ZMQMessage::IMPORT_BLS_RSP,
+    ZMQMessage::IMPORT_ECDSA_RSP, ZMQMessage::GENERATE_ECDSA_RSP, ZMQMessage::GET_PUBLIC_ECDSA_RSP,
+    ZMQMessage::GENERATE_DKG_POLY_RSP, ZMQMessage::GET_VV_RSP, ZMQMessage::GET_SECRET_SHARE_RSP,
+    ZMQMessage::DKG_VERIFY_RSP, ZMQMessage::CREATE_BLS_PRIVATE_RSP, ZMQMessage::GET_BLS_PUBLIC_RSP,
+    ZMQMessage::GET_ALL_BLS_PUBLIC_RSP, ZMQMessage::COMPLAINT_RESPONSE_RSP, ZMQMessage::MULT_G2_RSP,
+    ZMQMessage::IS_POLY_EXISTS_RSP, ZMQMessage::GET_SERVER_STATUS_RSP, ZMQMessage::GET_SERVER_VERSION_RSP,
+    ZMQMessage::DELETE_BLS_KEY_RSP, ZMQMessage::GET_DECRYPTION_SHARE_RSP,
+    ZMQMessage::GENERATE_BLS_PRIVATE_KEY_RSP, ZMQMessage::POP_PROVE_RSP, ZMQMessage::BLS_SIGN_BATCH_RSP,
+    ZMQMessage::ECDSA_SIGN_BATCH_RSP, ZMQMessage::DKG_VERIFY_BATCH_RSP, ZMQMessage::START_SESSION_RSP,
+    ZMQMessage::REGISTER_CURVE_KEY_RSP, ZMQMessage::IMPORT_BLS_BATCH_RSP, ZMQMessage::IMPORT_ECDSA_BATCH_RSP,
+    ZMQMessage::MULT_G2_BATCH_RSP, ZMQMessage::AGGREGATE_BLS_SIGNATURES_RSP,
+    ZMQMessage::VERIFY_BLS_SIGNATURES_RSP, ZMQMessage::BLS_SIGN_HASHED_POINT_RSP,
+    ZMQMessage::GENERATE_DKG_POLY_BATCH_RSP, ZMQMessage::GENERATE_BLS_PRIVATE_KEY_BATCH_RSP,
+    ZMQMessage::POP_PROVE_BATCH_RSP
+};
+
+static const MessageFactory responseFactories[] = {
+    makeMessage<BLSSignRspMessage>, makeMessage<ECDSASignRspMessage>, makeMessage<importBLSRspMessage>,
+    makeMessage<importECDSARspMessage>, makeMessage<generateECDSARspMessage>,
+    makeMessage<getPublicECDSARspMessage>, makeMessage<generateDKGPolyRspMessage>,
+    makeMessage<getVerificationVectorRspMessage>, makeMessage<getSecretShareRspMessage>,
+    makeMessage<dkgVerificationRspMessage>, makeMessage<createBLSPrivateKeyRspMessage>,
+    makeMessage<getBLSPublicRspMessage>, makeMessage<getAllBLSPublicKeysRspMessage>,
+    makeMessage<complaintResponseRspMessage>, makeMessage<multG2RspMessage>,
+    makeMessage<isPolyExistsRspMessage>, makeMessage<getServerStatusRspMessage>,
+    makeMessage<getServerVersionRspMessage>, makeMessage<deleteBLSKeyRspMessage>,
+    makeMessage<GetDecryptionShareRspMessage>, makeMessage<generateBLSPrivateKeyRspMessage>,
+    makeMessage<popProveRspMessage>, makeMessage<BLSSignBatchRspMessage>,
+    makeMessage<ECDSASignBatchRspMessage>, makeMessage<dkgVerificationBatchRspMessage>,
+    makeMessage<startSessionRspMessage>, makeMessage<registerCurveKeyRspMessage>,
+    makeMessage<importBLSBatchRspMessage>, makeMessage<importECDSABatchRspMessage>,
+    makeMessage<multG2BatchRspMessage>, makeMessage<aggregateBLSSignaturesRspMessage>,
+    makeMessage<verifyBLSSignaturesRspMessage>, makeMessage<BLSSignHashedPointRspMessage>,
+    makeMessage<generateDKGPolyBatchRspMessage>, makeMessage<generateBLSPrivateKeyBatchRspMessage>,
+    makeMessage<popProveBatchRspMessage>
+};
+
+static_assert(sizeof(responseTypes) / sizeof(responseTypes[0]) == ZMQMessage::NUM_RESPONSES,
+              "Response types do not match Responses");
+static_assert(sizeof(responseFactories) / sizeof(responseFactories[0]) == ZMQMessage::NUM_RESPONSES,
+              "Response factories do not match Responses");
+
+static unordered_map<string_view, int> makeTagTable(const char *const *_types, int _numTypes) {
+    unordered_map<string_view, int> tags;
+    for (int i = 0; i < _numTypes; i++) {
+        tags[_types[i]] = i;
+    }
+    return tags;
+}
+
+int ZMQMessage::getRequestTag(string_view _type) {
+    static const auto tags = makeTagTable(requestTypes, NUM_REQUESTS);
+    auto it = tags.find(_type);
+    return it == tags.end() ? -1 : it->second;
+}
+
+int ZMQMessage::getResponseTag(string_view _type) {
+    static const auto tags = makeTagTable(responseTypes, NUM_RESPONSES);
+    auto it = tags.find(_type);
+    return it == tags.end() ? -1 : it->second;
+}
+
 shared_ptr <ZMQMessage> ZMQMessage::parse(const char *_msg,
                                           size_t _size, bool _isRequest,
-                                          bool _verifySig, bool _checkKeyOwnership) {
+                                          bool _verifySig, bool _checkKeyOwnership,
+                                          const string &_curveUserId) {
     CHECK_STATE(_msg);
-    CHECK_STATE2(_size > 5, ZMQ_INVALID_MESSAGE_SIZE);
-    // CHECK NULL TERMINATED
-    CHECK_STATE(_msg[_size] == 0);
-    CHECK_STATE2(_msg[_size - 1] == '}', ZMQ_INVALID_MESSAGE);
-    CHECK_STATE2(_msg[0] == '{', ZMQ_INVALID_MESSAGE);
+    return parse(make_shared<string>(_msg, _size), _isRequest, _verifySig, _checkKeyOwnership, _curveUserId);
+}
+
+shared_ptr <ZMQMessage> ZMQMessage::parse(const shared_ptr<string> &_buffer, bool _isRequest,
+                                          bool _verifySig, bool _checkKeyOwnership,
+                                          const string &_curveUserId, int _requestTag, bool _pooled) {
+    CHECK_STATE(_buffer);
+    auto size = _buffer->size();
+    CHECK_STATE2(size > 5, ZMQ_INVALID_MESSAGE_SIZE);
+    CHECK_STATE2(_buffer->back() == '}', ZMQ_INVALID_MESSAGE);
+    CHECK_STATE2(_buffer->front() == '{', ZMQ_INVALID_MESSAGE);
+
+    // hash of the cert of a signed request, reused by the key ownership checks
+    string certHash;
+
+    if (_verifySig) {
+        checkCertStore();
+    }
+
+    VerifiedCertCache::CertHandles curveCert = nullptr;
+
+    if (!_curveUserId.empty() && _verifySig) {
+        curveCert = getCurveCert(_curveUserId, certHash);
+    }
 
-    auto d = make_shared<rapidjson::Document>();
+    // signatures and MACs are checked over the received bytes, which in situ parsing overwrites,
+    // so only then the message is copied
+    string received;
 
-    d->Parse(_msg);
+    if (_verifySig && !curveCert) {
+        received = *_buffer;
+    }
+
+    const char *receivedMsg = received.c_str();
+
+    // Server workers parse requests with a per thread allocator, which is reset for every request
+    // instead of allocating new chunks. A request does not outlive the processing of the request.
+    static thread_local char requestPoolBuffer[ZMQ_REQUEST_POOL_BUFFER_SIZE];
+    static thread_local rapidjson::MemoryPoolAllocator<> requestPool(requestPoolBuffer, sizeof(requestPoolBuffer));
+
+    shared_ptr<rapidjson::Document> d;
+
+    if (_isRequest && _pooled) {
+        requestPool.Clear();
+        d = make_shared<rapidjson::Document>(&requestPool);
+    } else {
+        d = make_shared<rapidjson::Document>();
+    }
+
+    // string values point into _buffer, which is kept by the message
+    d->ParseInsitu(&(*_buffer)[0]);
 
     CHECK_STATE2(!d->HasParseError(), ZMQ_COULD_NOT_PARSE);
     CHECK_STATE2(d->IsObject(), ZMQ_COULD_NOT_PARSE);
 
     CHECK_STATE2(d->HasMember("type"), ZMQ_NO_TYPE_IN_MESSAGE);
     CHECK_STATE2((*d)["type"].IsString(), ZMQ_NO_TYPE_IN_MESSAGE);
-    string type = (*d)["type"].GetString();
+    string_view type((*d)["type"].GetString(), (*d)["type"].GetStringLength());
 
-    if (_verifySig) {
-        CHECK_STATE2(d->HasMember("cert"),ZMQ_NO_CERT_IN_MESSAGE);
+    // the router already found the tag of the request in its scan of the raw message
+    int tag = -1;
+
+    if (_isRequest) {
+        tag = (_requestTag >= 0 && _requestTag < NUM_REQUESTS && type == requestTypes[_requestTag]) ?
+              _requestTag : getRequestTag(type);
+        if (tag < 0) {
+            BOOST_THROW_EXCEPTION(SGXException(-301, "Incorrect zmq message type: " + string(type)));
+        }
+    } else {
+        tag = getResponseTag(type);
+        if (tag < 0) {
+            BOOST_THROW_EXCEPTION(InvalidStateException("Incorrect zmq message request type: " + string(type),
+                                                        __CLASS_NAME__));
+        }
+    }
+
+    // only the server sets curveUserId, registerCurveKeyReq binds it to the cert of the request
+    d->RemoveMember("curveUserId");
+
+    if (!_curveUserId.empty()) {
+        rapidjson::Value curveUserId(_curveUserId.c_str(), d->GetAllocator());
+        d->AddMember("curveUserId", curveUserId, d->GetAllocator());
+    }
+
+    if (curveCert) {
+        // libzmq authenticated the connection with the client key, which is registered to this cert
+        d->RemoveMember("msgSig");
+        setCert(d, curveCert->pem);
+    } else if (_verifySig && d->HasMember("sessionId")) {
+        verifySessionMac(receivedMsg, size, d);
+    } else if (_verifySig) {
+        // a client that sent its cert before may send only the hash of it
+        bool hashOnly = !d->HasMember("cert") && d->HasMember("certHash");
+
+        CHECK_STATE2(hashOnly || d->HasMember("cert"), ZMQ_NO_CERT_IN_MESSAGE);
         CHECK_STATE2(d->HasMember("msgSig"), ZMQ_NO_SIG_IN_MESSAGE);
-        CHECK_STATE2((*d)["cert"].IsString(), ZMQ_NO_CERT_IN_MESSAGE);
+        CHECK_STATE2(hashOnly || (*d)["cert"].IsString(), ZMQ_NO_CERT_IN_MESSAGE);
         CHECK_STATE2((*d)["msgSig"].IsString(), ZMQ_NO_SIG_IN_MESSAGE);
 
-        auto cert = make_shared<string>((*d)["cert"].GetString());
-        string hash = cryptlite::sha256::hash_hex(*cert);
+        shared_ptr<string> cert;
 
-        auto filepath = "/tmp/sgx_wallet_cert_hash_" + hash;
+        if (hashOnly) {
+            CHECK_STATE2((*d)["certHash"].IsString(), ZMQ_UNKNOWN_CERT);
+            certHash = (*d)["certHash"].GetString();
+        } else {
+            cert = make_shared<string>((*d)["cert"].GetString());
+            certHash = cryptlite::sha256::hash_hex(*cert);
+        }
 
-        std::ofstream outFile(filepath);
+        // held until the signature is verified, even if the cert is evicted meanwhile
+        auto handles = verifiedCerts.get(certHash);
 
-        outFile << *cert;
+        // the client resends the full cert
+        CHECK_STATE2(handles || !hashOnly, ZMQ_UNKNOWN_CERT);
 
-        outFile.close();
+        // the cert is only checked against the root CA on a cache miss or after its entry expired
+        if (!handles) {
+            handles = getVerifiedCert(certHash, *cert);
+            CHECK_STATE(handles);
+        }
 
-        static recursive_mutex m;
+        auto msgSig = make_shared<string>((*d)["msgSig"].GetString());
 
-        EVP_PKEY *publicKey = nullptr;
+        d->RemoveMember("msgSig");
 
-        {
-            lock_guard <recursive_mutex> lock(m);
+        string msgToVerify;
 
-            if (!verifiedCerts.exists(*cert)) {
-                CHECK_STATE(SGXWalletServer::verifyCert(filepath));
-                auto handles = ZMQClient::readPublicKeyFromCertStr(*cert);
-                CHECK_STATE(handles.first);
-                CHECK_STATE(handles.second);
-                verifiedCerts.put(*cert, handles);
-                remove(cert->c_str());
-            }
+        // current clients append the signature as the last member, so the signed bytes are
+        // the received message up to it. Older clients put it anywhere and need re-serialization
+        static const string SIG_SUFFIX_START = ",\"msgSig\":\"";
+        auto suffixLen = SIG_SUFFIX_START.size() + msgSig->size() + 2;
 
-            publicKey = verifiedCerts.get(*cert).first;
+        if (size > suffixLen &&
+            memcmp(receivedMsg + size - suffixLen, SIG_SUFFIX_START.data(), SIG_SUFFIX_START.size()) == 0 &&
+            memcmp(receivedMsg + size - msgSig->size() - 2, msgSig->data(), msgSig->size()) == 0 &&
+            receivedMsg[size - 2] == '"') {
+            msgToVerify = ZMQClient::stripWhitespace(receivedMsg, size - suffixLen);
+            msgToVerify.push_back('}');
+        } else {
+            rapidjson::StringBuffer buffer;
+            rapidjson::Writer<rapidjson::StringBuffer> w(buffer);
+            d->Accept(w);
+            msgToVerify = ZMQClient::stripWhitespace(buffer.GetString(), buffer.GetSize());
+        }
 
-            CHECK_STATE(publicKey);
+        // no global lock is held here, so verification of concurrent requests scales with cores
+        ZMQClient::verifySig(handles->publicKey, msgToVerify, *msgSig );
 
-            auto msgSig = make_shared<string>((*d)["msgSig"].GetString());
+        // key ownership checks and logs read the cert of the request
+        if (hashOnly) {
+            d->RemoveMember("certHash");
+            setCert(d, handles->pem);
+        }
+    }
 
-            d->RemoveMember("msgSig");
+    auto ret = _isRequest ? buildRequest(tag, d, _checkKeyOwnership) : buildResponse(tag, d, _checkKeyOwnership);
 
-            rapidjson::StringBuffer buffer;
+    CHECK_STATE(ret);
+    ret->buffer = _buffer;
+    ret->certHash = certHash;
 
-            rapidjson::Writer<rapidjson::StringBuffer> w(buffer);
+    return ret;
+}
 
-            d->Accept(w);
+void ZMQMessage::checkCertStore() {
+    CertVerifier::checkRevocations();
 
-            auto msgToVerify = buffer.GetString();
+    // sessions were opened with certs that the new store may revoke
+    auto generation = CertVerifier::getStoreGeneration();
+    if (certStoreGeneration.exchange(generation) != generation) {
+        verifiedCerts.clear();
+        sessions.clear();
+    }
+}
 
-            ZMQClient::verifySig(publicKey, msgToVerify, *msgSig );
+VerifiedCertCache::CertHandles ZMQMessage::getVerifiedCert(const string &_certHash, const string &_cert) {
+    auto handles = verifiedCerts.get(_certHash);
+    if (handles) {
+        return handles;
+    }
 
-        }
+    auto parsed = ZMQClient::readPublicKeyFromCertStr(_cert);
+    auto keys = make_shared<VerifiedCertCache::CertKeys>(parsed.first, parsed.second, _cert);
+    CHECK_STATE(keys->publicKey);
+    CHECK_STATE(keys->cert);
+
+    auto generation = CertVerifier::getStoreGeneration();
+
+    int64_t notAfter = 0;
+    if (!CertVerifier::verify(keys->cert, notAfter)) {
+        return nullptr;
     }
+    keys->notAfter = notAfter;
 
-    if (_isRequest) {
-        return buildRequest(type, d, _checkKeyOwnership);
-    } else {
-        return buildResponse(type, d, _checkKeyOwnership);
+    // a cert verified with a store that was replaced meanwhile is not cached
+    if (CertVerifier::getStoreGeneration() == generation) {
+        auto expiresAt = min(notAfter, (int64_t) time(nullptr) + VERIFIED_CERT_TTL_SECONDS);
+        verifiedCerts.put(_certHash, keys, expiresAt);
     }
+
+    return keys;
 }
 
-shared_ptr <ZMQMessage> ZMQMessage::buildRequest(string &_type, shared_ptr <rapidjson::Document> _d,
-                                                bool _checkKeyOwnership) {
-    Requests r;
-    try {
-        int t = requests.at( _type );
-        r = static_cast<Requests>(t);
-    } catch ( std::out_of_range& ) {
-        BOOST_THROW_EXCEPTION(SGXException(-301, "Incorrect zmq message type: " + string(_type)));
+string ZMQMessage::encodeCurveBinding(const string &_cert, int64_t _notAfter) {
+    return to_string(_notAfter) + ":" + _cert;
+}
+
+string ZMQMessage::decodeCurveBinding(const string &_binding, int64_t &_notAfter) {
+    _notAfter = 0;
+
+    // bindings of older versions hold only the PEM, which does not start with a digit
+    auto separator = _binding.find(':');
+    if (_binding.empty() || !isdigit(_binding.front()) || separator == string::npos) {
+        return _binding;
     }
 
-    shared_ptr<ZMQMessage> ret = nullptr;
-
-    switch (r) {
-        case ENUM_BLS_SIGN_REQ:
-            ret = make_shared<BLSSignReqMessage>(_d);
-            break;
-        case ENUM_ECDSA_SIGN_REQ:
-            ret = make_shared<ECDSASignReqMessage>(_d);
-            break;
-        case ENUM_IMPORT_BLS_REQ:
-            ret = make_shared<importBLSReqMessage>(_d);
-            break;
-        case ENUM_IMPORT_ECDSA_REQ:
-            ret = make_shared<importECDSAReqMessage>(_d);
-            break;
-        case ENUM_GENERATE_ECDSA_REQ:
-            ret = make_shared<generateECDSAReqMessage>(_d);
-            break;
+    _notAfter = stoll(_binding.substr(0, separator));
+    return _binding.substr(separator + 1);
+}
+
+VerifiedCertCache::CertHandles ZMQMessage::getCurveCert(const string &_curveUserId, string &_certHash) {
+    auto keyName = getCurveKeyName(_curveUserId);
+    auto binding = LevelDB::getLevelDb()->readString(keyName);
+
+    if (!binding) {
+        return nullptr;
+    }
+
+    int64_t notAfter = 0;
+    auto cert = decodeCurveBinding(*binding, notAfter);
+    _certHash = cryptlite::sha256::hash_hex(cert);
+
+    // an expired cert is not parsed again, a revoked one fails the verification
+    auto handles = (notAfter == 0 || notAfter > (int64_t) time(nullptr)) ? getVerifiedCert(_certHash, cert) : nullptr;
+
+    if (!handles) {
+        spdlog::warn("Deleting the curve key registration of {}, its cert no longer verifies", _curveUserId);
+        LevelDB::getLevelDb()->deleteKey(keyName);
+        throw SGXException(FAIL_TO_VERIFY_CERTIFICATE, string(__FUNCTION__) +
+                                                       ":Cert of the curve key is expired or revoked");
+    }
+
+    return handles;
+}
+
+void ZMQMessage::verifySessionMac(const char *_msg, size_t _size, shared_ptr<rapidjson::Document> &_d) {
+    CHECK_STATE2((*_d)["sessionId"].IsString(), ZMQ_UNKNOWN_SESSION);
+    CHECK_STATE2(_d->HasMember("msgMac"), ZMQ_NO_SIG_IN_MESSAGE);
+    CHECK_STATE2((*_d)["msgMac"].IsString(), ZMQ_NO_SIG_IN_MESSAGE);
+
+    auto session = sessions.get((*_d)["sessionId"].GetString());
+    CHECK_STATE2(session, ZMQ_UNKNOWN_SESSION);
+
+    string msgMac = (*_d)["msgMac"].GetString();
+
+    // the MAC covers the received message up to the msgMac member, which clients append last
+    static const string MAC_SUFFIX_START = ",\"msgMac\":\"";
+    auto suffixLen = MAC_SUFFIX_START.size() + msgMac.size() + 2;
+
+    CHECK_STATE2(_size > suffixLen &&
+                 memcmp(_msg + _size - suffixLen, MAC_SUFFIX_START.data(), MAC_SUFFIX_START.size()) == 0 &&
+                 memcmp(_msg + _size - msgMac.size() - 2, msgMac.data(), msgMac.size()) == 0 &&
+                 _msg[_size - 2] == '"', ZMQ_COULD_NOT_VERIFY_SIG);
+
+    string msgToVerify(_msg, _size - suffixLen);
+    msgToVerify.push_back('}');
+
+    auto expectedMac = ZMQClient::macString(session->key, msgToVerify);
+
+    CHECK_STATE2(expectedMac.size() == msgMac.size() &&
+                 CRYPTO_memcmp(expectedMac.data(), msgMac.data(), msgMac.size()) == 0,
+                 ZMQ_COULD_NOT_VERIFY_SIG);
+
+    // key ownership is checked against the cert the session was started with,
+    // a cert sent along with a session request is ignored
+    _d->RemoveMember("msgMac");
+    setCert(_d, *session->cert);
+}
+
+void ZMQMessage::setCert(shared_ptr<rapidjson::Document> &_d, const string &_cert) {
+    _d->RemoveMember("cert");
+    rapidjson::Value cert(_cert.c_str(), _d->GetAllocator());
+    _d->AddMember("cert", cert, _d->GetAllocator());
+}
+
+bool ZMQMessage::isUnknownSessionReply(const string &_msg) {
+    static const string unknownSessionStatus = "\"status\":" + to_string(ZMQ_UNKNOWN_SESSION);
+    return _msg.find(unknownSessionStatus) != string::npos;
+}
+
+bool ZMQMessage::isUnknownCertReply(const string &_msg) {
+    static const string unknownCertStatus = "\"status\":" + to_string(ZMQ_UNKNOWN_CERT);
+    return _msg.find(unknownCertStatus) != string::npos;
+}
+
+int ZMQMessage::scanRequestTag(const string &_msg) {
+    static const string typeKey = "\"type\":\"";
+
+    auto begin = _msg.find(typeKey);
+    if (begin == string::npos) {
+        return -1;
+    }
+
+    begin += typeKey.size();
+
+    auto end = _msg.find('"', begin);
+    if (end == string::npos) {
+        return -1;
+    }
+
+    return getRequestTag(string_view(_msg.data() + begin, end - begin));
+}
+
+bool ZMQMessage::isSignRequest(int _tag) {
+    return _tag == ENUM_BLS_SIGN_REQ || _tag == ENUM_ECDSA_SIGN_REQ || _tag == ENUM_BLS_SIGN_BATCH_REQ ||
+           _tag == ENUM_ECDSA_SIGN_BATCH_REQ || _tag == ENUM_BLS_SIGN_HASHED_POINT_REQ;
+}
+
+bool ZMQMessage::isBlsSignRequest(int _tag) {
+    return _tag == ENUM_BLS_SIGN_REQ || _tag == ENUM_BLS_SIGN_BATCH_REQ || _tag == ENUM_BLS_SIGN_HASHED_POINT_REQ;
+}
+
+bool ZMQMessage::isReadOnlyRequest(int _tag) {
+    switch (_tag) {
         case ENUM_GET_PUBLIC_ECDSA_REQ:
-            ret = make_shared<getPublicECDSAReqMessage>(_d);
-            break;
-        case ENUM_GENERATE_DKG_POLY_REQ:
-            ret = make_shared<generateDKGPolyReqMessage>(_d);
-            break;
-        case ENUM_GET_VV_REQ:
-            ret = make_shared<getVerificationVectorReqMessage>(_d);
-            break;
-        case ENUM_GET_SECRET_SHARE_REQ:
-            ret = make_shared<getSecretShareReqMessage>(_d);
-            break;
-        case ENUM_DKG_VERIFY_REQ:
-            ret = make_shared<dkgVerificationReqMessage>(_d);
-            break;
-        case ENUM_CREATE_BLS_PRIVATE_REQ:
-            ret = make_shared<createBLSPrivateKeyReqMessage>(_d);
-            break;
         case ENUM_GET_BLS_PUBLIC_REQ:
-            ret = make_shared<getBLSPublicReqMessage>(_d);
-            break;
         case ENUM_GET_ALL_BLS_PUBLIC_REQ:
-            ret = make_shared<getAllBLSPublicKeysReqMessage>(_d);
-            break;
-        case ENUM_COMPLAINT_RESPONSE_REQ:
-            ret = make_shared<complaintResponseReqMessage>(_d);
-            break;
         case ENUM_MULT_G2_REQ:
-            ret = make_shared<multG2ReqMessage>(_d);
-            break;
+        case ENUM_MULT_G2_BATCH_REQ:
+        case ENUM_AGGREGATE_BLS_SIGNATURES_REQ:
+        case ENUM_VERIFY_BLS_SIGNATURES_REQ:
         case ENUM_IS_POLY_EXISTS_REQ:
-            ret = make_shared<isPolyExistsReqMessage>(_d);
-            break;
         case ENUM_GET_SERVER_STATUS_REQ:
-            ret = make_shared<getServerStatusReqMessage>(_d);
-            break;
         case ENUM_GET_SERVER_VERSION_REQ:
-            ret = make_shared<getServerVersionReqMessage>(_d);
-            break;
-        case ENUM_DELETE_BLS_KEY_REQ:
-            ret = make_shared<deleteBLSKeyReqMessage>(_d);
-            break;
         case ENUM_GET_DECRYPTION_SHARE_REQ:
-            ret = make_shared<GetDecryptionShareReqMessage>(_d);
-            break;
-        case ENUM_GENERATE_BLS_PRIVATE_KEY_REQ:
-            ret = make_shared<generateBLSPrivateKeyReqMessage>(_d);
-            break;
         case ENUM_POP_PROVE_REQ:
-            ret = make_shared<popProveReqMessage>(_d);
-            break;
+        case ENUM_POP_PROVE_BATCH_REQ:
+        case ENUM_START_SESSION_REQ:
+            return true;
+        default:
+            return isSignRequest(_tag);
+    }
+}
+
+bool ZMQMessage::isPublicRequest(int _tag) {
+    switch (_tag) {
+        case ENUM_GET_ALL_BLS_PUBLIC_REQ:
+        case ENUM_MULT_G2_REQ:
+        case ENUM_MULT_G2_BATCH_REQ:
+        case ENUM_AGGREGATE_BLS_SIGNATURES_REQ:
+        case ENUM_VERIFY_BLS_SIGNATURES_REQ:
+            return true;
         default:
-            break;
+            return false;
     }
+}
+
+bool ZMQMessage::scanPolyName(const string &_msg, string &_polyName) {
+    static const string polyNameKey = "\"polyName\":\"";
+
+    auto begin = _msg.find(polyNameKey);
+    if (begin == string::npos) {
+        return false;
+    }
+
+    begin += polyNameKey.size();
 
+    auto end = _msg.find('"', begin);
+    if (end == string::npos || end == begin) {
+        return false;
+    }
+
+    _polyName.assign(_msg, begin, end - begin);
+    return true;
+}
+
+bool ZMQMessage::scanSchainId(const string &_msg, string &_schainId) {
+    static const string schainIdKey = ":SCHAIN_ID:";
+
+    auto begin = _msg.find(schainIdKey);
+    if (begin == string::npos) {
+        return false;
+    }
+
+    begin += schainIdKey.size();
+
+    auto end = _msg.find_first_of(":\"", begin);
+    if (end == string::npos || end == begin) {
+        return false;
+    }
+
+    _schainId.assign(_msg, begin, end - begin);
+    return true;
+}
+
+static bool scanUInt64(const string &_msg, const string &_key, uint64_t &_value) {
+    auto pos = _msg.find(_key);
+    if (pos == string::npos) {
+        return false;
+    }
+
+    pos += _key.size();
+
+    uint64_t value = 0;
+    uint64_t digits = 0;
+
+    for (; pos < _msg.size() && isdigit(_msg[pos]) && digits < 19; pos++, digits++) {
+        value = value * 10 + (_msg[pos] - '0');
+    }
+
+    if (digits == 0) {
+        return false;
+    }
+
+    _value = value;
+    return true;
+}
+
+bool ZMQMessage::getReqId(const string &_msg, uint64_t &_reqId) {
+    static const string reqIdKey = "\"reqId\":";
+    return scanUInt64(_msg, reqIdKey, _reqId);
+}
+
+bool ZMQMessage::getDeadline(const string &_msg, uint64_t &_deadlineMs) {
+    static const string deadlineKey = "\"deadline\":";
+    return scanUInt64(_msg, deadlineKey, _deadlineMs);
+}
+
+uint64_t ZMQMessage::getEpochMs() {
+    return chrono::duration_cast<chrono::milliseconds>(chrono::system_clock::now().time_since_epoch()).count();
+}
+
+shared_ptr <ZMQMessage> ZMQMessage::buildRequest(int _tag, shared_ptr <rapidjson::Document> _d,
+                                                bool _checkKeyOwnership) {
+    CHECK_STATE(_tag >= 0 && _tag < NUM_REQUESTS);
+
+    auto ret = requestFactories[_tag](_d);
+
+    ret->tag = _tag;
     ret->setCheckKeyOwnership(_checkKeyOwnership);
 
     return ret;
 }
 
-shared_ptr <ZMQMessage> ZMQMessage::buildResponse(string &_type, shared_ptr <rapidjson::Document> _d,
+shared_ptr <ZMQMessage> ZMQMessage::buildResponse(int _tag, shared_ptr <rapidjson::Document> _d,
                                                 bool _checkKeyOwnership) {
-    Responses r;
-    try {
-        int t = responses.at( _type );
-        r = static_cast<Responses>(t);
-    } catch ( std::out_of_range& ) {
-        BOOST_THROW_EXCEPTION(InvalidStateException("Incorrect zmq message request type: " + string(_type),
-                                                    __CLASS_NAME__)
-        );
-    }
+    CHECK_STATE(_tag >= 0 && _tag < NUM_RESPONSES);
 
-    shared_ptr<ZMQMessage> ret = nullptr;
-
-    switch (r) {
-        case ENUM_BLS_SIGN_RSP:
-            ret = make_shared<BLSSignRspMessage>(_d);
-            break;
-        case ENUM_ECDSA_SIGN_RSP:
-            ret = make_shared<ECDSASignRspMessage>(_d);
-            break;
-        case ENUM_IMPORT_BLS_RSP:
-            ret = make_shared<importBLSRspMessage>(_d);
-            break;
-        case ENUM_IMPORT_ECDSA_RSP:
-            ret = make_shared<importECDSARspMessage>(_d);
-            break;
-        case ENUM_GENERATE_ECDSA_RSP:
-            ret = make_shared<generateECDSARspMessage>(_d);
-            break;
-        case ENUM_GET_PUBLIC_ECDSA_RSP:
-            ret = make_shared<getPublicECDSARspMessage>(_d);
-            break;
-        case ENUM_GENERATE_DKG_POLY_RSP:
-            ret = make_shared<generateDKGPolyRspMessage>(_d);
-            break;
-        case ENUM_GET_VV_RSP:
-            ret = make_shared<getVerificationVectorRspMessage>(_d);
-            break;
-        case ENUM_GET_SECRET_SHARE_RSP:
-            ret = make_shared<getSecretShareRspMessage>(_d);
-            break;
-        case ENUM_DKG_VERIFY_RSP:
-            ret = make_shared<dkgVerificationRspMessage>(_d);
-            break;
-        case ENUM_CREATE_BLS_PRIVATE_RSP:
-            ret = make_shared<createBLSPrivateKeyRspMessage>(_d);
-            break;
-        case ENUM_GET_BLS_PUBLIC_RSP:
-            ret = make_shared<getBLSPublicRspMessage>(_d);
-            break;
-        case ENUM_GET_ALL_BLS_PUBLIC_RSP:
-            ret = make_shared<getAllBLSPublicKeysRspMessage>(_d);
-            break;
-        case ENUM_COMPLAINT_RESPONSE_RSP:
-            ret = make_shared<complaintResponseRspMessage>(_d);
-            break;
-        case ENUM_MULT_G2_RSP:
-            ret = make_shared<multG2RspMessage>(_d);
-            break;
-        case ENUM_IS_POLY_EXISTS_RSP:
-            ret = make_shared<isPolyExistsRspMessage>(_d);
-            break;
-        case ENUM_GET_SERVER_STATUS_RSP:
-            ret = make_shared<getServerStatusRspMessage>(_d);
-            break;
-        case ENUM_GET_SERVER_VERSION_RSP:
-            ret = make_shared<getServerVersionRspMessage>(_d);
-            break;
-        case ENUM_DELETE_BLS_KEY_RSP:
-            ret = make_shared<deleteBLSKeyRspMessage>(_d);
-            break;
-        case ENUM_GET_DECRYPTION_SHARE_RSP:
-            ret = make_shared<GetDecryptionShareRspMessage>(_d);
-            break;
-        case ENUM_GENERATE_BLS_PRIVATE_KEY_RSP:
-            ret = make_shared<generateBLSPrivateKeyRspMessage>(_d);
-            break;
-        case ENUM_POP_PROVE_RSP:
-            ret = make_shared<popProveRspMessage>(_d);
-            break;
-        default:
-            break;
-    }
+    auto ret = responseFactories[_tag](_d);
 
+    ret->tag = _tag;
     ret->setCheckKeyOwnership(_checkKeyOwnership);
 
     return ret;
 }
 
-std::map<string, string> ZMQMessage::keysByOwners;
+KeyOwnerIndex ZMQMessage::keyOwners;
+
+void ZMQMessage::initKeyOwners() {
+    keyOwners.load();
+}
+
+void ZMQMessage::forgetKeyOwners(const vector<string>& keyNames) {
+    for (auto&& keyName : keyNames) {
+        keyOwners.remove(keyName);
+    }
+}
+
+void ZMQMessage::importKeyOwners(const vector<pair<string, string>>& owners) {
+    for (auto&& owner : owners) {
+        keyOwners.set(owner.first, owner.second);
+    }
+}
 
-bool ZMQMessage::isKeyByOwner(const string& keyName, const string& cert) {
-    auto value = LevelDB::getLevelDb()->readString(keyName  + ":OWNER");
-    return value && *value == cert;
+const string& ZMQMessage::getCertHash() {
+    if (certHash.empty()) {
+        auto cert = getStringViewRapid("cert");
+        certHash = cryptlite::sha256::hash_hex(string(cert));
+    }
+    return certHash;
 }
 
-void ZMQMessage::addKeyByOwner(const string& keyName, const string& cert) {
-    SGXWalletServer::writeDataToDB(keyName + ":OWNER", cert);
+bool ZMQMessage::isKeyByOwner(const string& keyName, const string& certHash) {
+    return keyOwners.get(keyName) == certHash;
+}
+
+void ZMQMessage::addKeyByOwner(const string& keyName, const string& certHash) {
+    // owners on a follower come from the leader only, otherwise a client could claim a key
+    // whose owner record has not been replicated yet
+    if (KeyStoreReplicator::isFollower()) {
+        throw SGXException(KEY_STORE_READ_ONLY, string(__FUNCTION__) + ":Key owner is not replicated yet " + keyName);
+    }
+    keyOwners.add(keyName, certHash);
 }
 
 bool ZMQMessage::isKeyRegistered(const string& keyName) {
-    return LevelDB::getLevelDb()->readString(keyName  + ":OWNER") != nullptr;
+    return keyOwners.exists(keyName);
 }
 
-cache::lru_cache<string, pair < EVP_PKEY * , X509 *>> ZMQMessage::verifiedCerts(256);
+VerifiedCertCache ZMQMessage::verifiedCerts(VERIFIED_CERT_CACHE_SIZE);
+
+atomic<uint64_t> ZMQMessage::certStoreGeneration(0);
+
+ZMQSessionCache ZMQMessage::sessions(ZMQ_SESSION_CACHE_MAX_ENTRIES, ZMQ_SESSION_TTL_SECONDS);
 
-const std::map<string, int> ZMQMessage::requests{
-    {BLS_SIGN_REQ, 0}, {ECDSA_SIGN_REQ, 1}, {IMPORT_BLS_REQ, 2}, {IMPORT_ECDSA_REQ, 3},
-    {GENERATE_ECDSA_REQ, 4}, {GET_PUBLIC_ECDSA_REQ, 5}, {GENERATE_DKG_POLY_REQ, 6},
-    {GET_VV_REQ, 7}, {GET_SECRET_SHARE_REQ, 8}, {DKG_VERIFY_REQ, 9},
-    {CREATE_BLS_PRIVATE_REQ, 10}, {GET_BLS_PUBLIC_REQ, 11}, {GET_ALL_BLS_PUBLIC_REQ, 12},
-    {COMPLAINT_RESPONSE_REQ, 13}, {MULT_G2_REQ, 14}, {IS_POLY_EXISTS_REQ, 15},
-    {GET_SERVER_STATUS_REQ, 16}, {GET_SERVER_VERSION_REQ, 17}, {DELETE_BLS_KEY_REQ, 18},
-    {GET_DECRYPTION_SHARE_REQ, 19}, {GENERATE_BLS_PRIVATE_KEY_REQ, 20},
-    {POP_PROVE_REQ, 21}
-};
 
-const std::map<string, int> ZMQMessage::responses {
-    {BLS_SIGN_RSP, 0}, {ECDSA_SIGN_RSP, 1}, {IMPORT_BLS_RSP, 2}, {IMPORT_ECDSA_RSP, 3},
-    {GENERATE_ECDSA_RSP, 4}, {GET_PUBLIC_ECDSA_RSP, 5}, {GENERATE_DKG_POLY_RSP, 6},
-    {GET_VV_RSP, 7}, {GET_SECRET_SHARE_RSP, 8}, {DKG_VERIFY_RSP, 9},
-    {CREATE_BLS_PRIVATE_RSP, 10}, {GET_BLS_PUBLIC_RSP, 11}, {GET_ALL_BLS_PUBLIC_RSP, 12},
-    {COMPLAINT_RESPONSE_RSP, 13}, {MULT_G2_RSP, 14}, {IS_POLY_EXISTS_RSP, 15},
-    {GET_SERVER_STATUS_RSP, 16}, {GET_SERVER_VERSION_RSP, 17}, {DELETE_BLS_KEY_RSP, 18},
-    {GET_DECRYPTION_SHARE_RSP, 19}, {GENERATE_BLS_PRIVATE_KEY_RSP, 20},
-    {POP_PROVE_RSP, 21}
-};
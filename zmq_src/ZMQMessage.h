@@ -23,6 +23,9 @@
 
 #pragma once
 
+#include <atomic>
+#include <string_view>
+#include <vector>
 
 #include <openssl/pem.h>
 #include <openssl/evp.h>
@@ -30,7 +33,10 @@
 #include <openssl/sha.h>
 #include <openssl/rand.h>
 
-#include "third_party/lrucache.hpp"
+#include "KeyOwnerIndex.h"
+#include "RequestCodecs.h"
+#include "VerifiedCertCache.h"
+#include "ZMQSessionCache.h"
 
 #include "abstractstubserver.h"
 
@@ -38,6 +44,7 @@
 #include "stringbuffer.h"
 #include "writer.h"
 
+#include "sgxwallet_common.h"
 #include "SGXException.h"
 
 using namespace std;
@@ -46,19 +53,68 @@ class ZMQMessage {
 
     shared_ptr<rapidjson::Document> d;
 
-    static cache::lru_cache<string, pair<EVP_PKEY*, X509*>> verifiedCerts;
+    // the received message, string values of d point into it
+    shared_ptr<string> buffer;
+
+    // Requests or Responses value of the message type
+    int tag = -1;
+
+    // sha256 hash of the cert of the request, computed on first use
+    string certHash;
+
+    static VerifiedCertCache verifiedCerts;
+
+    // the CertVerifier store generation that verifiedCerts and sessions were verified with
+    static atomic<uint64_t> certStoreGeneration;
+
+    // reloads a changed CRL and drops the verified certs and sessions of an older store.
+    // Called before any of the curve, session and signature checks
+    static void checkCertStore();
+
+    // checks the HMAC of a session request and replaces its cert with the cert of the session
+    static void verifySessionMac(const char *_msg, size_t _size, shared_ptr<rapidjson::Document> &_d);
+
+    // binds a curve key to a cert, see registerCurveKeyReq
+    static string encodeCurveBinding(const string &_cert, int64_t _notAfter);
+
+    // the cert of a binding and its notAfter, zero for bindings of older versions
+    static string decodeCurveBinding(const string &_binding, int64_t &_notAfter);
+
+    // the cert registered to the curve key of a connection. A binding whose cert no longer
+    // verifies is deleted, and the request fails
+    static VerifiedCertCache::CertHandles getCurveCert(const string &_curveUserId, string &_certHash);
+
+    // replaces the cert of the request with the cert it was authenticated with
+    static void setCert(shared_ptr<rapidjson::Document> &_d, const string &_cert);
 
 protected:
     bool checkKeyOwnership = true;
 
-    static std::map<string, string> keysByOwners;
+    static KeyOwnerIndex keyOwners;
+
+    // the sha256 hash of the PEM of the cert, as kept in the owner records
+    const string& getCertHash();
 
-    static bool isKeyByOwner(const string& keyName, const string& cert);
+    static bool isKeyByOwner(const string& keyName, const string& certHash);
 
-    static void addKeyByOwner(const string& keyName, const string& cert);
+    static void addKeyByOwner(const string& keyName, const string& certHash);
 
     static bool isKeyRegistered(const std::string& keyName);
 
+    static ZMQSessionCache sessions;
+
+    // the handles of a cert that chains up to the root CA, is not revoked and has not expired.
+    // It is only verified on a cache miss. Returns nullptr if it does not verify
+    static VerifiedCertCache::CertHandles getVerifiedCert(const string &_certHash, const string &_cert);
+
+    // typed params of a spec.json method, parsed in one pass over the request
+    template<class P>
+    P getParams() {
+        P params;
+        params.parse(*d);
+        return params;
+    }
+
 public:
 
     static constexpr const char *BLS_SIGN_REQ = "BLSSignReq";
@@ -105,25 +161,66 @@ public:
     static constexpr const char *GENERATE_BLS_PRIVATE_KEY_RSP = "generateBLSPrivateKeyRsp";
     static constexpr const char *POP_PROVE_REQ = "popProveReq";
     static constexpr const char *POP_PROVE_RSP = "popProveRsp";
+    static constexpr const char *BLS_SIGN_BATCH_REQ = "BLSSignBatchReq";
+    static constexpr const char *BLS_SIGN_BATCH_RSP = "BLSSignBatchRsp";
+    static constexpr const char *ECDSA_SIGN_BATCH_REQ = "ECDSASignBatchReq";
+    static constexpr const char *ECDSA_SIGN_BATCH_RSP = "ECDSASignBatchRsp";
+    static constexpr const char *DKG_VERIFY_BATCH_REQ = "dkgVerificationBatchReq";
+    static constexpr const char *DKG_VERIFY_BATCH_RSP = "dkgVerificationBatchRsp";
+    static constexpr const char *START_SESSION_REQ = "startSessionReq";
+    static constexpr const char *START_SESSION_RSP = "startSessionRsp";
+    static constexpr const char *REGISTER_CURVE_KEY_REQ = "registerCurveKeyReq";
+    static constexpr const char *REGISTER_CURVE_KEY_RSP = "registerCurveKeyRsp";
+    static constexpr const char *IMPORT_BLS_BATCH_REQ = "importBLSBatchReq";
+    static constexpr const char *IMPORT_BLS_BATCH_RSP = "importBLSBatchRsp";
+    static constexpr const char *IMPORT_ECDSA_BATCH_REQ = "importECDSABatchReq";
+    static constexpr const char *IMPORT_ECDSA_BATCH_RSP = "importECDSABatchRsp";
+    static constexpr const char *MULT_G2_BATCH_REQ = "multG2BatchReq";
+    static constexpr const char *MULT_G2_BATCH_RSP = "multG2BatchRsp";
+    static constexpr const char *AGGREGATE_BLS_SIGNATURES_REQ = "aggregateBLSSignaturesReq";
+    static constexpr const char *AGGREGATE_BLS_SIGNATURES_RSP = "aggregateBLSSignaturesRsp";
+    static constexpr const char *VERIFY_BLS_SIGNATURES_REQ = "verifyBLSSignaturesReq";
+    static constexpr const char *VERIFY_BLS_SIGNATURES_RSP = "verifyBLSSignaturesRsp";
+    static constexpr const char *BLS_SIGN_HASHED_POINT_REQ = "BLSSignHashedPointReq";
+    static constexpr const char *BLS_SIGN_HASHED_POINT_RSP = "BLSSignHashedPointRsp";
+    static constexpr const char *GENERATE_DKG_POLY_BATCH_REQ = "generateDKGPolyBatchReq";
+    static constexpr const char *GENERATE_DKG_POLY_BATCH_RSP = "generateDKGPolyBatchRsp";
+    static constexpr const char *GENERATE_BLS_PRIVATE_KEY_BATCH_REQ = "generateBLSPrivateKeyBatchReq";
+    static constexpr const char *GENERATE_BLS_PRIVATE_KEY_BATCH_RSP = "generateBLSPrivateKeyBatchRsp";
+    static constexpr const char *POP_PROVE_BATCH_REQ = "popProveBatchReq";
+    static constexpr const char *POP_PROVE_BATCH_RSP = "popProveBatchRsp";
 
-    static const std::map<string, int> requests;
-    static const std::map<string, int> responses;
 
     enum Requests { ENUM_BLS_SIGN_REQ, ENUM_ECDSA_SIGN_REQ, ENUM_IMPORT_BLS_REQ, ENUM_IMPORT_ECDSA_REQ, ENUM_GENERATE_ECDSA_REQ, ENUM_GET_PUBLIC_ECDSA_REQ,
                     ENUM_GENERATE_DKG_POLY_REQ, ENUM_GET_VV_REQ, ENUM_GET_SECRET_SHARE_REQ, ENUM_DKG_VERIFY_REQ, ENUM_CREATE_BLS_PRIVATE_REQ,
                     ENUM_GET_BLS_PUBLIC_REQ, ENUM_GET_ALL_BLS_PUBLIC_REQ, ENUM_COMPLAINT_RESPONSE_REQ, ENUM_MULT_G2_REQ, ENUM_IS_POLY_EXISTS_REQ,
                     ENUM_GET_SERVER_STATUS_REQ, ENUM_GET_SERVER_VERSION_REQ, ENUM_DELETE_BLS_KEY_REQ, ENUM_GET_DECRYPTION_SHARE_REQ,
-                    ENUM_GENERATE_BLS_PRIVATE_KEY_REQ, ENUM_POP_PROVE_REQ };
+                    ENUM_GENERATE_BLS_PRIVATE_KEY_REQ, ENUM_POP_PROVE_REQ, ENUM_BLS_SIGN_BATCH_REQ,
+                    ENUM_ECDSA_SIGN_BATCH_REQ, ENUM_DKG_VERIFY_BATCH_REQ, ENUM_START_SESSION_REQ,
+                    ENUM_REGISTER_CURVE_KEY_REQ, ENUM_IMPORT_BLS_BATCH_REQ, ENUM_IMPORT_ECDSA_BATCH_REQ,
+                    ENUM_MULT_G2_BATCH_REQ, ENUM_AGGREGATE_BLS_SIGNATURES_REQ,
+                    ENUM_VERIFY_BLS_SIGNATURES_REQ, ENUM_BLS_SIGN_HASHED_POINT_REQ,
+                    ENUM_GENERATE_DKG_POLY_BATCH_REQ, ENUM_GENERATE_BLS_PRIVATE_KEY_BATCH_REQ,
+                    ENUM_POP_PROVE_BATCH_REQ, NUM_REQUESTS };
     enum Responses { ENUM_BLS_SIGN_RSP, ENUM_ECDSA_SIGN_RSP, ENUM_IMPORT_BLS_RSP, ENUM_IMPORT_ECDSA_RSP, ENUM_GENERATE_ECDSA_RSP, ENUM_GET_PUBLIC_ECDSA_RSP,
                     ENUM_GENERATE_DKG_POLY_RSP, ENUM_GET_VV_RSP, ENUM_GET_SECRET_SHARE_RSP, ENUM_DKG_VERIFY_RSP, ENUM_CREATE_BLS_PRIVATE_RSP,
                     ENUM_GET_BLS_PUBLIC_RSP, ENUM_GET_ALL_BLS_PUBLIC_RSP, ENUM_COMPLAINT_RESPONSE_RSP, ENUM_MULT_G2_RSP, ENUM_IS_POLY_EXISTS_RSP,
                     ENUM_GET_SERVER_STATUS_RSP, ENUM_GET_SERVER_VERSION_RSP, ENUM_DELETE_BLS_KEY_RSP, ENUM_GET_DECRYPTION_SHARE_RSP,
-                    ENUM_GENERATE_BLS_PRIVATE_KEY_RSP, ENUM_POP_PROVE_RSP };
+                    ENUM_GENERATE_BLS_PRIVATE_KEY_RSP, ENUM_POP_PROVE_RSP, ENUM_BLS_SIGN_BATCH_RSP,
+                    ENUM_ECDSA_SIGN_BATCH_RSP, ENUM_DKG_VERIFY_BATCH_RSP, ENUM_START_SESSION_RSP,
+                    ENUM_REGISTER_CURVE_KEY_RSP, ENUM_IMPORT_BLS_BATCH_RSP, ENUM_IMPORT_ECDSA_BATCH_RSP,
+                    ENUM_MULT_G2_BATCH_RSP, ENUM_AGGREGATE_BLS_SIGNATURES_RSP,
+                    ENUM_VERIFY_BLS_SIGNATURES_RSP, ENUM_BLS_SIGN_HASHED_POINT_RSP,
+                    ENUM_GENERATE_DKG_POLY_BATCH_RSP, ENUM_GENERATE_BLS_PRIVATE_KEY_BATCH_RSP,
+                    ENUM_POP_PROVE_BATCH_RSP, NUM_RESPONSES };
 
     explicit ZMQMessage(shared_ptr<rapidjson::Document> &_d) : d(_d) {};
 
     string getStringRapid(const char *_name);
 
+    // valid as long as the message exists
+    string_view getStringViewRapid(const char *_name);
+
     uint64_t getInt64Rapid(const char *_name);
 
     Json::Value getJsonValueRapid(const char *_name);
@@ -142,12 +239,96 @@ public:
         return strRequest;
     }
 
+    // _curveUserId is the CurveZMQ key of the connection the request came from, if any.
+    // Requests from a key registered to a cert are not signed.
     static shared_ptr <ZMQMessage> parse(const char* _msg, size_t _size, bool _isRequest,
-                                         bool _verifySig, bool _checkKeyOwnership);
+                                         bool _verifySig, bool _checkKeyOwnership,
+                                         const string& _curveUserId = "");
+
+    // parses _buffer in situ, so string values are not copied. _buffer is overwritten.
+    // Requests use an allocator of the calling thread and have to be released before the
+    // thread parses the next request, unless _pooled is false.
+    // _requestTag is the result of scanRequestTag, if known
+    static shared_ptr <ZMQMessage> parse(const shared_ptr<string>& _buffer, bool _isRequest,
+                                         bool _verifySig, bool _checkKeyOwnership,
+                                         const string& _curveUserId = "", int _requestTag = -1,
+                                         bool _pooled = true);
+
+    static string getCurveKeyName(const string& _curveUserId) { return "CURVE_KEY:" + _curveUserId; }
+
+    // loads the key owners from the database, called before the ZMQ server starts
+    static void initKeyOwners();
+
+    // drops the owners of keys whose owner records were deleted from the database
+    static void forgetKeyOwners(const vector<string>& keyNames);
+
+    // takes the owner records a follower copied from the leader, as (keyName, owner) pairs
+    static void importKeyOwners(const vector<pair<string, string>>& owners);
+
+    // returns -1 for unknown types
+    static int getRequestTag(string_view _type);
+
+    static int getResponseTag(string_view _type);
+
+    // cheap scan of the raw message for its request tag, used for queue selection
+    // before the message is parsed. Returns -1 if there is no known type.
+    static int scanRequestTag(const string& _msg);
+
+    static bool isSignRequest(int _tag);
+
+    // the requests measured by the latency objective, see LatencySLO.h
+    static bool isBlsSignRequest(int _tag);
+
+    // requests that do not write to the key store, the only ones served by cluster followers
+    static bool isReadOnlyRequest(int _tag);
+
+    // requests computed from public data on the host only, which never enter the enclave
+    static bool isPublicRequest(int _tag);
+
+    // cheap scan for the "polyName" of DKG requests, returns false if there is none
+    static bool scanPolyName(const string& _msg, string& _polyName);
+
+    // cheap scan for the SCHAIN_ID of the first BLS key name, returns false if there is none
+    static bool scanSchainId(const string& _msg, string& _schainId);
+
+    int getTag() const { return tag; }
+
+    // checked cast of a response to its message class, without RTTI
+    template<class T>
+    static shared_ptr<T> responseCast(const shared_ptr<ZMQMessage> &_msg) {
+        if (!_msg || _msg->tag != T::TAG) {
+            throw SGXException(ZMQ_INVALID_MESSAGE, "Unexpected zmq response type");
+        }
+        return static_pointer_cast<T>(_msg);
+    }
+
+    // cheap scan for the optional "reqId" that pipelining clients put into requests and
+    // the server copies into replies, returns false if there is none
+    static bool getReqId(const string& _msg, uint64_t& _reqId);
+
+    // cheap scan for the optional "deadline", in milliseconds since the epoch, after which
+    // the client no longer waits for the reply
+    static bool getDeadline(const string& _msg, uint64_t& _deadlineMs);
+
+    static uint64_t getEpochMs();
+
+    // cheap check for the error reply to a request with an unknown or expired session
+    static bool isUnknownSessionReply(const string& _msg);
+
+    // cheap check for the error reply to a request that carried only the hash of an unknown cert
+    static bool isUnknownCertReply(const string& _msg);
+
+    static uint64_t getNumSessions() { return sessions.size(); }
+
+    static uint64_t getNumVerifiedCerts() { return verifiedCerts.size(); }
+
+    static uint64_t getVerifiedCertEvictions() { return verifiedCerts.getEvictions(); }
+
+    static void setVerifiedCertCacheSize(uint64_t _size) { verifiedCerts.setMaxSize(_size); }
 
-    static shared_ptr<ZMQMessage> buildRequest(string& type, shared_ptr<rapidjson::Document> _d,
+    static shared_ptr<ZMQMessage> buildRequest(int _tag, shared_ptr<rapidjson::Document> _d,
                                                 bool _checkKeyOwnership);
-    static shared_ptr<ZMQMessage> buildResponse(string& type, shared_ptr<rapidjson::Document> _d,
+    static shared_ptr<ZMQMessage> buildResponse(int _tag, shared_ptr<rapidjson::Document> _d,
                                                 bool _checkKeyOwnership);
 
     virtual Json::Value process() = 0;
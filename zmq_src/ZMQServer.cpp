@@ -21,10 +21,16 @@
     @date 2019
 */
 
+#include <algorithm>
+#include <cstring>
 #include <fstream>
 #include <streambuf>
 
-#include <boost/functional/hash.hpp>
+#include <fcntl.h>
+#include <sys/eventfd.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
 
 #include "third_party/spdlog/spdlog.h"
 
@@ -33,22 +39,82 @@
 
 #include "SGXException.h"
 #include "ExitRequestedException.h"
+#include "KeyStoreReplicator.h"
+#include "Log.h"
+#include "TrafficRecorder.h"
+#include "Metrics.h"
 #include "ReqMessage.h"
 #include "ZMQMessage.h"
 #include "ZMQServer.h"
+#include "SchainPartitions.h"
+#include "CertVerifier.h"
+#include "KeyWarmUp.h"
+#include "MemoryBudget.h"
+#include "LatencySLO.h"
+#include "Numa.h"
 
 
 using namespace std;
 
 shared_ptr <ZMQServer> ZMQServer::zmqServer = nullptr;
 
+ZMQFrontEnd::ZMQFrontEnd(uint64_t _index, zmq::context_t &_ctx, uint64_t _numReplyRings)
+        : index(_index),
+          port(_index == 0 ? BASE_PORT + 5 : ZMQ_EXTRA_FRONT_END_BASE_PORT + _index - 1),
+          fairQueue(ZMQ_FAIR_QUEUE_QUANTUM_BYTES, ZMQ_MAX_CLIENT_BACKLOG, ZMQ_MAX_SIGN_QUEUE_DEPTH) {
+    socket = make_shared<zmq::socket_t>(_ctx, ZMQ_ROUTER);
+
+    int linger = 0;
+    zmq_setsockopt(*socket, ZMQ_LINGER, &linger, sizeof(linger));
+
+    // drops the connections of clients that went away without closing them
+    int heartbeatIvl = ZMQ_HEARTBEAT_IVL_MS;
+    int heartbeatTimeout = ZMQ_HEARTBEAT_TIMEOUT_MS;
+    zmq_setsockopt(*socket, ZMQ_HEARTBEAT_IVL, &heartbeatIvl, sizeof(heartbeatIvl));
+    zmq_setsockopt(*socket, ZMQ_HEARTBEAT_TIMEOUT, &heartbeatTimeout, sizeof(heartbeatTimeout));
+
+    outgoingEventFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    CHECK_STATE(outgoingEventFd >= 0);
+
+    CHECK_STATE(_numReplyRings > 0);
+    for (uint64_t i = 0; i < _numReplyRings; i++) {
+        replyRings.push_back(make_unique<ReaderWriterQueue<OutgoingReply>>());
+    }
+}
+
+uint64_t ZMQFrontEnd::getOutgoingQueueDepth() const {
+    uint64_t depth = 0;
+    for (auto &&ring : replyRings) {
+        depth += ring->size_approx();
+    }
+    return depth;
+}
+
+ZMQFrontEnd::~ZMQFrontEnd() {
+    if (outgoingEventFd >= 0) {
+        close(outgoingEventFd);
+    }
+}
+
 ZMQServer::ZMQServer(bool _checkSignature, bool _checkKeyOwnership, const string &_caCertFile)
-        : incomingQueue(NUM_ZMQ_WORKER_THREADS), checkSignature(_checkSignature), checkKeyOwnership(_checkKeyOwnership),
-          caCertFile(_caCertFile), ctx(make_shared<zmq::context_t>(1)) {
+        : scheduler(numWorkerThreads, min(NUM_ZMQ_SLOW_LANE_THREADS, max<uint64_t>(numWorkerThreads / 2, 1)),
+                    ZMQ_MAX_SIGN_QUEUE_DEPTH, ZMQ_MAX_SLOW_QUEUE_DEPTH, Numa::getNumNodes()),
+          checkSignature(_checkSignature), checkKeyOwnership(_checkKeyOwnership),
+          caCertFile(_caCertFile), ctx(make_shared<zmq::context_t>((int) numIOThreads)) {
+
+    CHECK_STATE(numWorkerThreads > 1);
+
+    if (ClientRateLimiter::getRequestsPerSecond() > 0) {
+        rateLimiter = make_unique<ClientRateLimiter>(ClientRateLimiter::getRequestsPerSecond());
+    }
 
-    CHECK_STATE(NUM_ZMQ_WORKER_THREADS > 1);
+    // one per core, they never enter the enclave and so are not bounded by the TCS
+    numCpuStageThreads = max<uint64_t>(thread::hardware_concurrency(), 2);
 
-    socket = make_shared<zmq::socket_t>(*ctx, ZMQ_ROUTER);
+    for (uint64_t i = 0; i < numFrontEnds; i++) {
+        frontEnds.push_back(make_unique<ZMQFrontEnd>(i, *ctx,
+                                                     numWorkerThreads + numEnclaveStageThreads + numCpuStageThreads));
+    }
 
     if (_checkSignature) {
         CHECK_STATE(!_caCertFile.empty());
@@ -58,42 +124,185 @@ ZMQServer::ZMQServer(bool _checkSignature, bool _checkKeyOwnership, const string
         CHECK_STATE(!caCert.empty())
     }
 
-    int linger = 0;
+    if (numEnclaveStageThreads > 0) {
+        // the rings after those of the workers
+        enclaveStage = make_unique<EnclaveStage>(numEnclaveStageThreads,
+                                                 numEnclaveStageThreads * ZMQ_SIGN_DISPATCH_PER_WORKER,
+                                                 [](uint64_t _threadIndex) {
+                                                     replyRing = numWorkerThreads + _threadIndex;
+                                                     Numa::bindCurrentThread(Numa::getWorkerNode(
+                                                             _threadIndex, numEnclaveStageThreads,
+                                                             Numa::getNumNodes()));
+                                                     KeyWarmUp::warmUpThread();
+                                                 });
+    }
 
-    zmq_setsockopt(*socket, ZMQ_LINGER, &linger, sizeof(linger));
+    // the rings after those of the enclave stage
+    cpuStage = make_unique<EnclaveStage>(numCpuStageThreads, numCpuStageThreads * ZMQ_CPU_STAGE_QUEUE_PER_THREAD,
+                                         [this](uint64_t _threadIndex) {
+                                             replyRing = numWorkerThreads + numEnclaveStageThreads + _threadIndex;
+                                             Numa::bindCurrentThread(Numa::getWorkerNode(
+                                                     _threadIndex, numCpuStageThreads, Numa::getNumNodes()));
+                                         }, "cpu");
 
-    threadPool = make_shared<WorkerThreadPool>(NUM_ZMQ_WORKER_THREADS, this);
+    threadPool = make_shared<WorkerThreadPool>(numWorkerThreads, this, minWorkerThreads);
 
 }
 
 void ZMQServer::initListenSocket() {
 
-    auto port = BASE_PORT + 5;
+    spdlog::info("Starting zmq server on port {} with {} front ends and {} I/O threads ...", BASE_PORT + 5,
+                 numFrontEnds, numIOThreads);
 
-    spdlog::info("Starting zmq server on port {} ...", port);
+    if (curveEnabled) {
+        loadOrCreateCurveKeys();
 
-    try {
-        CHECK_STATE(socket);
-        socket->bind("tcp://*:" + to_string(port));
-    } catch (...) {
-        spdlog::error("Zmq server task could not bind to port:{}", port);
-        throw SGXException(ZMQ_COULD_NOT_BIND_FRONT_END, "Server task could not bind.");
+        // libzmq asks the ZAP handler of the context to authenticate every CurveZMQ handshake
+        zapSocket = make_shared<zmq::socket_t>(*ctx, ZMQ_REP);
+        zapSocket->bind("inproc://zeromq.zap.01");
+        zapThread = make_shared<thread>(&ZMQServer::zapHandlerLoop, this);
+
+        int curveServer = 1;
+        for (auto &&frontEnd : frontEnds) {
+            auto &socket = frontEnd->socket;
+            CHECK_STATE(zmq_setsockopt(*socket, ZMQ_CURVE_SERVER, &curveServer, sizeof(curveServer)) == 0);
+            CHECK_STATE(zmq_setsockopt(*socket, ZMQ_CURVE_SECRETKEY, curveSecretKey.c_str(), curveSecretKey.size()) == 0);
+            CHECK_STATE(zmq_setsockopt(*socket, ZMQ_ZAP_DOMAIN, "sgxwallet", 9) == 0);
+        }
+
+        spdlog::info("ZMQ server uses CurveZMQ, server public key {}", curvePublicKey);
+    }
+
+    for (auto &&frontEnd : frontEnds) {
+        try {
+            CHECK_STATE(frontEnd->socket);
+            frontEnd->socket->bind("tcp://*:" + to_string(frontEnd->port));
+        } catch (...) {
+            spdlog::error("Zmq server task could not bind to port:{}", frontEnd->port);
+            throw SGXException(ZMQ_COULD_NOT_BIND_FRONT_END, "Server task could not bind.");
+        }
+    }
+
+    // the first router socket serves both endpoints, so requests over ipc are checked as over tcp
+    if (ipcEnabled) {
+        try {
+            frontEnds.front()->socket->bind(ZMQ_IPC_ENDPOINT);
+        } catch (...) {
+            spdlog::error("Zmq server task could not bind to {}", ZMQ_IPC_ENDPOINT);
+            throw SGXException(ZMQ_COULD_NOT_BIND_FRONT_END, "Server task could not bind.");
+        }
+        spdlog::info("ZMQ server also listens on {}", ZMQ_IPC_ENDPOINT);
     }
 
     spdlog::info("ZMQ server socket created and bound.");
 
 }
 
+void ZMQServer::loadOrCreateCurveKeys() {
+    auto keyFile = string(SGXDATA_FOLDER) + "zmq_curve.key";
+
+    string publicKey, secretKey;
+
+    ifstream in(keyFile);
+
+    if (in >> publicKey >> secretKey) {
+        CHECK_STATE(publicKey.size() == 40);
+        CHECK_STATE(secretKey.size() == 40);
+    } else {
+        char publicBuf[41], secretBuf[41];
+        CHECK_STATE(zmq_curve_keypair(publicBuf, secretBuf) == 0);
+        publicKey = publicBuf;
+        secretKey = secretBuf;
+
+        // created readable by the owner only, so the secret key is never readable by others,
+        // and an existing file is not overwritten
+        auto content = publicKey + "\n" + secretKey + "\n";
+        int fd = open(keyFile.c_str(), O_WRONLY | O_CREAT | O_EXCL, S_IRUSR | S_IWUSR);
+        CHECK_STATE(fd >= 0);
+        bool written = write(fd, content.data(), content.size()) == (ssize_t) content.size() && fsync(fd) == 0;
+        close(fd);
+        CHECK_STATE(written);
+
+        spdlog::info("Created ZMQ curve key pair in {}", keyFile);
+    }
+
+    curvePublicKey = publicKey;
+    curveSecretKey = secretKey;
+}
+
+void ZMQServer::zapHandlerLoop() {
+    // every client with a valid CurveZMQ handshake is accepted, its key is the user id of
+    // the connection. Requests are authenticated by the cert registered to the key, or
+    // by the usual signature if no cert is registered.
+    while (!isExitRequested) {
+        try {
+            zmq::pollitem_t items[] = {{static_cast<void *>(*zapSocket), 0, ZMQ_POLLIN, 0}};
+            zmq::poll(&items[0], 1, OUTGOING_POLL_TIMEOUT_MS);
+
+            if (!(items[0].revents & ZMQ_POLLIN)) {
+                continue;
+            }
+
+            // version, request id, domain, address, identity, mechanism, credentials
+            vector<string> frames;
+            bool more = true;
+
+            while (more) {
+                zmq::message_t frame;
+                CHECK_STATE(zapSocket->recv(&frame));
+                frames.emplace_back((char *) frame.data(), frame.size());
+                more = frame.more();
+            }
+
+            string status = "400";
+            string userId = "";
+
+            if (frames.size() >= 7 && frames[0] == "1.0" && frames[5] == "CURVE" && frames[6].size() == 32) {
+                char z85[41];
+                CHECK_STATE(zmq_z85_encode(z85, (const uint8_t *) frames[6].data(), 32));
+                userId = z85;
+                status = "200";
+            }
+
+            s_sendmore(*zapSocket, "1.0");
+            s_sendmore(*zapSocket, frames.size() > 1 ? frames[1] : "");
+            s_sendmore(*zapSocket, status);
+            s_sendmore(*zapSocket, status == "200" ? "OK" : "Invalid CURVE handshake");
+            s_sendmore(*zapSocket, userId);
+            s_send(*zapSocket, "");
+        } catch (...) {
+            if (isExitRequested) {
+                break;
+            }
+            spdlog::error("Exception in ZAP handler");
+        }
+    }
+
+    zapSocket->close();
+}
+
 void ZMQServer::run() {
 
 
     zmqServer->initListenSocket();
 
-    spdlog::info("Started zmq read loop.");
+    for (uint64_t i = 1; i < frontEnds.size(); i++) {
+        auto &frontEnd = *frontEnds[i];
+        frontEnd.routerThread = make_shared<thread>([this, &frontEnd]() { routerLoop(frontEnd); });
+    }
+
+    routerLoop(*frontEnds.front());
+}
+
+void ZMQServer::routerLoop(ZMQFrontEnd &_frontEnd) {
+
+    spdlog::info("Started zmq read loop on port {}.", _frontEnd.port);
+
+    Numa::bindCurrentThread(_frontEnd.index);
 
     while (!isExitRequested) {
         try {
-            zmqServer->doOneServerLoop();
+            doOneServerLoop(_frontEnd);
         } catch (ExitRequestedException &e) {
             spdlog::info("Exit requested. Exiting server loop");
             break;
@@ -103,10 +312,77 @@ void ZMQServer::run() {
         }
     }
 
-    spdlog::info("Exited zmq server loop");
+    spdlog::info("Exited zmq server loop on port {}", _frontEnd.port);
 }
 
 atomic<bool> ZMQServer::isExitRequested(false);
+atomic<uint64_t> ZMQServer::expiredRequests(0);
+atomic<uint64_t> ZMQServer::rejectedRequests(0);
+atomic<uint64_t> ZMQServer::rateLimitedRequests(0);
+
+uint64_t ZMQServer::getSignQueueDepth() {
+    auto server = zmqServer;
+    return server ? max<int64_t>(server->scheduler.getSignPending(), 0) : 0;
+}
+
+uint64_t ZMQServer::getActiveWorkerThreads() {
+    auto server = zmqServer;
+    return server ? server->scheduler.getActiveWorkers() : 0;
+}
+
+uint64_t ZMQServer::getSlowQueueDepth() {
+    auto server = zmqServer;
+    return server ? max<int64_t>(server->scheduler.getSlowPending(), 0) : 0;
+}
+
+uint64_t ZMQServer::getFairQueuePartitions() {
+    uint64_t partitions = 0;
+    auto server = zmqServer;
+    if (server) {
+        for (auto &&frontEnd : server->frontEnds) {
+            partitions += frontEnd->fairQueue.getNumPartitions();
+        }
+    }
+    return partitions;
+}
+
+uint64_t ZMQServer::getFairQueueDepth() {
+    uint64_t depth = 0;
+    auto server = zmqServer;
+    if (server) {
+        for (auto &&frontEnd : server->frontEnds) {
+            depth += frontEnd->fairQueue.size();
+        }
+    }
+    return depth;
+}
+
+uint64_t ZMQServer::getDKGSessions() {
+    auto server = zmqServer;
+    return server ? server->scheduler.getActiveSessions() : 0;
+}
+
+vector<uint64_t> ZMQServer::getSignQueueDepths() {
+    vector<uint64_t> depths;
+    auto server = zmqServer;
+    if (server) {
+        for (uint64_t i = 0; i < server->scheduler.getNumSignQueues(); i++) {
+            depths.push_back(server->scheduler.getSignQueueDepth(i));
+        }
+    }
+    return depths;
+}
+
+uint64_t ZMQServer::getOutgoingQueueDepth() {
+    uint64_t depth = 0;
+    auto server = zmqServer;
+    if (server) {
+        for (auto &&frontEnd : server->frontEnds) {
+            depth += frontEnd->getOutgoingQueueDepth();
+        }
+    }
+    return depth;
+}
 
 void ZMQServer::exitZMQServer() {
     // if already exited do not exit
@@ -118,20 +394,130 @@ void ZMQServer::exitZMQServer() {
 
     spdlog::info("Exiting ZMQServer");
     spdlog::info("Joining worker thread pool threads ...");
+    zmqServer->scheduler.notifyAll();
+    for (auto &&frontEnd : zmqServer->frontEnds) {
+        zmqServer->notifyOutgoingMessage(*frontEnd);
+    }
     zmqServer->threadPool->joinAll();
     spdlog::info("Joined worker thread pool threads");
+    if (zmqServer->enclaveStage) {
+        zmqServer->enclaveStage->stop();
+    }
+    if (zmqServer->cpuStage) {
+        zmqServer->cpuStage->stop();
+    }
     spdlog::info("Shutting down ZMQ contect");
     zmqServer->ctx->shutdown();
     spdlog::info("Shut down ZMQ contect");
-    spdlog::info("Closing ZMQ server socket ...");
-    zmqServer->socket->close();
-    spdlog::info("Closed ZMQ server socket");
+    if (zmqServer->zapThread) {
+        zmqServer->zapThread->join();
+    }
+    for (auto &&frontEnd : zmqServer->frontEnds) {
+        if (frontEnd->routerThread && frontEnd->routerThread->joinable()) {
+            frontEnd->routerThread->join();
+        }
+    }
+    spdlog::info("Closing ZMQ server sockets ...");
+    for (auto &&frontEnd : zmqServer->frontEnds) {
+        frontEnd->socket->close();
+    }
+    spdlog::info("Closed ZMQ server sockets");
     spdlog::info("Closing ZMQ context ...");
     zmqServer->ctx->close();
     spdlog::info("Closed ZMQ context.");
     spdlog::info("Exited zmq server.");
 }
 
+uint64_t ZMQServer::numWorkerThreads = NUM_ZMQ_WORKER_THREADS;
+
+uint64_t ZMQServer::minWorkerThreads = 0;
+
+bool ZMQServer::pinWorkerThreads = false;
+
+uint64_t ZMQServer::numEnclaveStageThreads = 0;
+
+thread_local int64_t ZMQServer::replyRing = -1;
+
+uint64_t ZMQServer::numIOThreads = 1;
+
+uint64_t ZMQServer::numFrontEnds = 1;
+
+bool ZMQServer::curveEnabled = false;
+bool ZMQServer::ipcEnabled = false;
+
+string ZMQServer::curvePublicKey = "";
+
+void ZMQServer::setWorkerThreadsConfig(uint64_t _numThreads, bool _pinThreads, uint64_t _minThreads) {
+    if (_numThreads == 0) {
+        _numThreads = max<uint64_t>(thread::hardware_concurrency(), 2);
+    }
+
+    // every worker thread may be inside the enclave at the same time
+    if (_numThreads < 2 || _numThreads >= ENCLAVE_TCS_NUM) {
+        throw SGXException(INVALID_ZMQ_WORKER_THREADS_NUMBER, string(__FUNCTION__) +
+                           ":Number of zmq worker threads has to be between 2 and " + to_string(ENCLAVE_TCS_NUM - 1));
+    }
+
+    if (_minThreads > _numThreads) {
+        throw SGXException(INVALID_ZMQ_WORKER_THREADS_NUMBER, string(__FUNCTION__) +
+                           ":Minimum number of zmq worker threads is above the maximum " + to_string(_numThreads));
+    }
+
+    numWorkerThreads = _numThreads;
+    pinWorkerThreads = _pinThreads;
+    minWorkerThreads = _minThreads < _numThreads ? _minThreads : 0;
+
+    spdlog::info("ZMQ worker threads set to {}, pinning to cores is set to {}", numWorkerThreads, pinWorkerThreads);
+    if (minWorkerThreads > 0) {
+        spdlog::info("ZMQ worker threads autoscale from {}", minWorkerThreads);
+    }
+}
+
+void ZMQServer::setEnclaveStageThreads(uint64_t _numThreads) {
+    if (_numThreads > 0 && numWorkerThreads + _numThreads >= ENCLAVE_TCS_NUM) {
+        throw SGXException(INVALID_ZMQ_WORKER_THREADS_NUMBER, string(__FUNCTION__) +
+                           ":Number of zmq worker and enclave stage threads has to be below " +
+                           to_string(ENCLAVE_TCS_NUM));
+    }
+
+    numEnclaveStageThreads = _numThreads;
+
+    spdlog::info("ZMQ enclave stage threads set to {}", numEnclaveStageThreads);
+}
+
+uint64_t ZMQServer::getEnclaveStageQueueDepth() {
+    auto server = zmqServer;
+    if (!server || !server->enclaveStage) {
+        return 0;
+    }
+    return server->enclaveStage->getQueued();
+}
+
+uint64_t ZMQServer::getCpuStageQueueDepth() {
+    auto server = zmqServer;
+    if (!server || !server->cpuStage) {
+        return 0;
+    }
+    return server->cpuStage->getQueued();
+}
+
+void ZMQServer::setIOThreadsConfig(uint64_t _numIOThreads, uint64_t _numFrontEnds) {
+    if (_numIOThreads == 0 || _numIOThreads > MAX_ZMQ_IO_THREADS) {
+        throw SGXException(INVALID_ZMQ_FRONT_END_CONFIG, string(__FUNCTION__) +
+                           ":Number of zmq I/O threads has to be between 1 and " + to_string(MAX_ZMQ_IO_THREADS));
+    }
+
+    if (_numFrontEnds == 0 || _numFrontEnds > MAX_ZMQ_FRONT_ENDS) {
+        throw SGXException(INVALID_ZMQ_FRONT_END_CONFIG, string(__FUNCTION__) +
+                           ":Number of zmq front ends has to be between 1 and " + to_string(MAX_ZMQ_FRONT_ENDS));
+    }
+
+    numIOThreads = _numIOThreads;
+    numFrontEnds = _numFrontEnds;
+
+    spdlog::info("ZMQ I/O threads set to {}, front ends set to {}", numIOThreads, numFrontEnds);
+}
+
 void ZMQServer::initZMQServer(bool _checkSignature, bool _checkKeyOwnership) {
     static bool initedServer = false;
     CHECK_STATE(!initedServer)
@@ -146,9 +532,14 @@ void ZMQServer::initZMQServer(bool _checkSignature, bool _checkKeyOwnership) {
         rootCAPath = string(SGXDATA_FOLDER) + "cert_data/rootCA.pem";
         spdlog::info("Reading root CA from {}", rootCAPath);
         CHECK_STATE(access(rootCAPath.c_str(), F_OK) == 0);
+        CertVerifier::init(rootCAPath, string(SGXDATA_FOLDER) + "cert_data/rootCA.crl");
         spdlog::info("Read CA.", rootCAPath);
     };
 
+    if (_checkKeyOwnership) {
+        ZMQMessage::initKeyOwners();
+    }
+
     spdlog::info("Initing zmq server ...");
 
     zmqServer = make_shared<ZMQServer>(_checkSignature, _checkKeyOwnership, rootCAPath);
@@ -179,33 +570,86 @@ void ZMQServer::checkForExit() {
 }
 
 
-void ZMQServer::sendMessagesInOutgoingMessageQueueIfAny() {
-    pair <Json::Value, shared_ptr<zmq::message_t>> element;
+void ZMQServer::sendMessagesInOutgoingMessageQueueIfAny(ZMQFrontEnd &_frontEnd) {
+    OutgoingReply element;
+
+    auto numRings = _frontEnd.replyRings.size();
+
+    // replies enqueued after this are signalled again
+    _frontEnd.outgoingNotified.exchange(false);
 
-    // send all items in outgoing queue
-    while (outgoingQueue.try_dequeue(element)) {
-        sendToClient(element.first, element.second);
+    // up to ZMQ_REPLY_BURST_SIZE replies of each ring per round, so a busy worker does not hold
+    // back the replies of the others. The round starts at another ring each time
+    for (bool sent = true; sent;) {
+        sent = false;
+        for (uint64_t i = 0; i < numRings; i++) {
+            auto &ring = *_frontEnd.replyRings[(_frontEnd.nextRing + i) % numRings];
+            for (uint64_t k = 0; k < ZMQ_REPLY_BURST_SIZE && ring.try_dequeue(element); k++) {
+                sent = true;
+
+                sendToClient(_frontEnd, element.reply, element.identity);
+                PROBE1(request__reply, element.receivedNs);
+
+                if (element.trace.isActive()) {
+                    auto sentNs = Tracing::nowNs();
+                    Tracing::emitSpan(element.trace.child(), "zmq.reply", element.enqueuedNs, sentNs);
+                    Tracing::emitSpan(element.trace, "zmq.request", element.receivedNs, sentNs);
+                }
+            }
+        }
     }
-}
 
-void ZMQServer::waitForIncomingAndProcessOutgoingMessages()  {
-    zmq_pollitem_t items[1];
-    items[0].socket = *socket;
-    items[0].events = ZMQ_POLLIN;
+    _frontEnd.nextRing = (_frontEnd.nextRing + 1) % numRings;
+}
 
-    int pollResult = 0;
+void ZMQServer::notifyOutgoingMessage(ZMQFrontEnd &_frontEnd) {
+    uint64_t one = 1;
+    // eventfd counter saturation is impossible here, so the write can only fail on shutdown
+    if (write(_frontEnd.outgoingEventFd, &one, sizeof(one)) != sizeof(one)) {
+        spdlog::debug("Could not write to outgoing eventfd");
+    }
+}
 
+void ZMQServer::waitForIncomingAndProcessOutgoingMessages(ZMQFrontEnd &_frontEnd)  {
+    zmq_pollitem_t items[2];
+    items[0].socket = *_frontEnd.socket;
+    items[0].fd = 0;
+    items[0].events = ZMQ_POLLIN;
+    items[0].revents = 0;
+    items[1].socket = nullptr;
+    items[1].fd = _frontEnd.outgoingEventFd;
+    items[1].events = ZMQ_POLLIN;
+    items[1].revents = 0;
+
+    // workers write to outgoingEventFd after each reply, so the loop sleeps until there is
+    // either an incoming request or an outgoing reply. The timeout is only used to check for exit.
     do {
         checkForExit();
-        pollResult = zmq_poll(items, 1, 1);
 
-        sendMessagesInOutgoingMessageQueueIfAny();
+        if (zmq_poll(items, 2, OUTGOING_POLL_TIMEOUT_MS) < 0) {
+            checkForExit();
+            continue;
+        }
+
+        if (items[1].revents & ZMQ_POLLIN) {
+            uint64_t counter;
+            if (read(_frontEnd.outgoingEventFd, &counter, sizeof(counter)) != sizeof(counter)) {
+                spdlog::debug("Could not read from outgoing eventfd");
+            }
+        }
+
+        sendMessagesInOutgoingMessageQueueIfAny(_frontEnd);
+
+        // replies free workers
+        dispatchSignRequests(_frontEnd);
 
-    } while (pollResult == 0);
+    } while (!(items[0].revents & ZMQ_POLLIN));
 
 }
 
-pair <string, shared_ptr<zmq::message_t>> ZMQServer::receiveMessage() {
+pair <string, shared_ptr<zmq::message_t>> ZMQServer::receiveMessage(ZMQFrontEnd &_frontEnd, string &_curveUserId) {
+
+    auto &socket = _frontEnd.socket;
 
     auto identity = make_shared<zmq::message_t>();
 
@@ -222,8 +666,6 @@ pair <string, shared_ptr<zmq::message_t>> ZMQServer::receiveMessage() {
         spdlog::error("Error: zmq_msg_more(identity) returned false.");
         throw SGXException(ZMQ_SERVER_ERROR, "Error: zmq_msg_more(identity) returned false.");
     }
-    auto id = string((char *) identity->data(), identity->size());
-    spdlog::debug("Received identity via ZMQ server: {}", id);
 
     auto reqMsg = make_shared<zmq::message_t>();
 
@@ -235,30 +677,140 @@ pair <string, shared_ptr<zmq::message_t>> ZMQServer::receiveMessage() {
     }
 
     auto result = string((char *) reqMsg->data(), reqMsg->size());
-    spdlog::debug("Received request via ZMQ server: {}", result);
+
+    if (Log::shouldLogRequest()) {
+        spdlog::debug("Received request via ZMQ server from {}: {}",
+                      string((char *) identity->data(), identity->size()), result);
+    }
+
+    _curveUserId = "";
+
+    if (curveEnabled) {
+        try {
+            _curveUserId = reqMsg->gets("User-Id");
+        } catch (...) {
+            spdlog::debug("ZMQ request without User-Id");
+        }
+    }
 
     return {result, identity};
 }
 
-void ZMQServer::sendToClient(Json::Value &_result, shared_ptr <zmq::message_t> &_identity) {
-    string replyStr;
-    try {
-        Json::FastWriter fastWriter;
-        fastWriter.omitEndingLineFeed();
+static void writeJsonValue(rapidjson::Writer<rapidjson::StringBuffer> &_w, const Json::Value &_value) {
+    switch (_value.type()) {
+        case Json::nullValue:
+            _w.Null();
+            break;
+        case Json::intValue:
+            _w.Int64(_value.asInt64());
+            break;
+        case Json::uintValue:
+            _w.Uint64(_value.asUInt64());
+            break;
+        case Json::realValue:
+            CHECK_STATE(_w.Double(_value.asDouble()));
+            break;
+        case Json::stringValue: {
+            const char *begin = nullptr;
+            const char *end = nullptr;
+            CHECK_STATE(_value.getString(&begin, &end));
+            _w.String(begin, end - begin);
+            break;
+        }
+        case Json::booleanValue:
+            _w.Bool(_value.asBool());
+            break;
+        case Json::arrayValue:
+            _w.StartArray();
+            for (auto &&item : _value) {
+                writeJsonValue(_w, item);
+            }
+            _w.EndArray();
+            break;
+        case Json::objectValue:
+            _w.StartObject();
+            for (auto it = _value.begin(); it != _value.end(); ++it) {
+                auto name = it.name();
+                _w.Key(name.c_str(), name.size());
+                writeJsonValue(_w, *it);
+            }
+            _w.EndObject();
+            break;
+    }
+}
+
+uint64_t ZMQServer::getClientHash(const zmq::message_t &_identity) {
+    // generated ROUTER identities are a zero byte followed by a 32 bit connection counter,
+    // so the first 8 bytes already identify the connection. Longer custom identities are
+    // folded in 8 byte words
+    auto data = (const uint8_t *) _identity.data();
+    auto size = _identity.size();
 
-        replyStr = fastWriter.write(_result);
+    uint64_t hash = size;
+
+    for (size_t i = 0; i < size; i += 8) {
+        uint64_t word = 0;
+        memcpy(&word, data + i, min<size_t>(8, size - i));
+        hash = (hash ^ word) * 0x9E3779B97F4A7C15ULL;
+    }
 
-        CHECK_STATE(replyStr.size() > 2);
-        CHECK_STATE(replyStr.front() == '{');
-        CHECK_STATE(replyStr.back() == '}');
+    return hash ^ (hash >> 32);
+}
+
+string ZMQServer::getClientId(const string &_curveUserId, const zmq::message_t &_identity) {
+    if (!_curveUserId.empty()) {
+        return _curveUserId;
+    }
+    return string((const char *) _identity.data(), _identity.size());
+}
+
+string ZMQServer::serializeReply(const Json::Value &_result) {
+    // written straight into a per thread buffer, which keeps its capacity between replies
+    static thread_local rapidjson::StringBuffer buffer;
+
+    buffer.Clear();
+    rapidjson::Writer<rapidjson::StringBuffer> w(buffer);
+    writeJsonValue(w, _result);
+
+    string replyStr(buffer.GetString(), buffer.GetSize());
+
+    CHECK_STATE(replyStr.size() > 2);
+    CHECK_STATE(replyStr.front() == '{');
+    CHECK_STATE(replyStr.back() == '}');
+
+    return replyStr;
+}
+
+static void freeReply(void *, void *_hint) {
+    delete (string *) _hint;
+}
+
+// the reply buffer is handed over to libzmq instead of being copied
+static zmq::message_t makeReplyMessage(string &_replyStr) {
+    auto reply = new string(move(_replyStr));
+    return zmq::message_t((void *) reply->data(), reply->size(), freeReply, reply);
+}
+
+void ZMQServer::sendToClient(ZMQFrontEnd &_frontEnd, string &_replyStr, shared_ptr <zmq::message_t> &_identity) {
+    auto replyMsg = makeReplyMessage(_replyStr);
+    sendToClient(_frontEnd, replyMsg, _identity);
+}
+
+void ZMQServer::sendToClient(ZMQFrontEnd &_frontEnd, zmq::message_t &_reply, shared_ptr <zmq::message_t> &_identity) {
+    auto &socket = _frontEnd.socket;
+
+    try {
+        if (Log::shouldLogRequest()) {
+            spdlog::debug("Send response to client: {}", string((char *) _reply.data(), _reply.size()));
+        }
 
         if (!socket->send(*_identity, ZMQ_SNDMORE)) {
             exit(-15);
         }
-        if (!s_send(*socket, replyStr)) {
+
+        if (!socket->send(_reply)) {
             exit(-16);
         }
-        spdlog::debug("Send response to client: {}", replyStr);
     } catch (ExitRequestedException) {
         throw;
     } catch (exception &e) {
@@ -273,46 +825,80 @@ void ZMQServer::sendToClient(Json::Value &_result, shared_ptr <zmq::message_t> &
 
 }
 
-void ZMQServer::doOneServerLoop() {
+void ZMQServer::doOneServerLoop(ZMQFrontEnd &_frontEnd) {
 
     Json::Value result;
     result["status"] = ZMQ_SERVER_ERROR;
 
     shared_ptr <zmq::message_t> identity = make_shared<zmq::message_t>();
     string msgStr;
+    string curveUserId;
 
     try {
 
-        waitForIncomingAndProcessOutgoingMessages();
+        waitForIncomingAndProcessOutgoingMessages(_frontEnd);
 
-        tie(msgStr, identity) = receiveMessage();
+        tie(msgStr, identity) = receiveMessage(_frontEnd, curveUserId);
 
         {
+            // parsing and signature verification are done by the worker threads,
+            // the router thread only picks a lane based on a cheap scan of the raw message
 
-            auto msg = ZMQMessage::parse(
-                    msgStr.c_str(), msgStr.size(), true, checkSignature, checkKeyOwnership);
-
-            CHECK_STATE2(msg, ZMQ_COULD_NOT_PARSE);
+            int requestTag = ZMQMessage::scanRequestTag(msgStr);
+            bool isSign = ZMQMessage::isSignRequest(requestTag);
+            // public requests skip the workers, which hold the TCS, unless the CPU stage is full
+            bool isPublic = ZMQMessage::isPublicRequest(requestTag);
 
-            uint64_t index = 0;
+            auto clientId = getClientId(curveUserId, *identity);
 
-            if ((dynamic_pointer_cast<BLSSignReqMessage>(msg)) ||
-                dynamic_pointer_cast<ECDSASignReqMessage>(msg)) {
+            IncomingRequest element{make_shared<string>(move(msgStr)), identity, move(curveUserId), requestTag};
+            element.frontEnd = _frontEnd.index;
 
-                boost::hash <std::string> string_hash;
+            if (rateLimiter && !rateLimiter->tryAcquire(clientId)) {
+                rejectRequest(_frontEnd, *element.msg, identity, CLIENT_RATE_LIMITED);
+                return;
+            }
 
-                auto hash = string_hash(string((const char *) identity->data()));
+            // the key store of a follower is a copy of the leader's
+            if (KeyStoreReplicator::isFollower() && !ZMQMessage::isReadOnlyRequest(requestTag)) {
+                rejectRequest(_frontEnd, *element.msg, identity, KEY_STORE_READ_ONLY);
+                return;
+            }
 
-                index = hash % (NUM_ZMQ_WORKER_THREADS - 1);
+            // DKG requests of one poly name are kept in order
+            string partition;
+            uint64_t partitionWeight = 1;
+            if (!isSign) {
+                ZMQMessage::scanPolyName(*element.msg, element.session);
             } else {
-                index = NUM_ZMQ_WORKER_THREADS - 1;
+                SchainPartitions::classify(*element.msg, partition, partitionWeight);
+            }
+
+            // also feeds the zmqQueueWait stage histogram, so it is set for every request
+            element.receivedNs = Tracing::nowNs();
+            PROBE3(request__receive, element.receivedNs, requestTag, _frontEnd.index);
+
+            if (Tracing::isEnabled()) {
+                Tracing::scanRequest(*element.msg, element.trace);
             }
 
-            auto element = pair < shared_ptr < ZMQMessage >, shared_ptr<zmq::message_t>>
-            (msg, identity);
+            // under memory pressure the queues are kept short, see MemoryBudget.h
+            bool pressured = MemoryBudget::isUnderPressure() &&
+                             max<int64_t>(scheduler.getSignPending() + scheduler.getSlowPending(), 0) +
+                             _frontEnd.fairQueue.size() >= MEMORY_PRESSURE_MAX_QUEUED;
 
+            // replies that pile up mean the router cannot keep up, so new work is not admitted either
+            bool admitted = !pressured && _frontEnd.getOutgoingQueueDepth() < ZMQ_MAX_OUTGOING_QUEUE_DEPTH &&
+                            (isSign ? _frontEnd.fairQueue.push(clientId, element, partition, partitionWeight)
+                                    : (isPublic && postToCpuStage(element)) || scheduler.enqueueSlow(element));
 
-            incomingQueue.at(index).enqueue(element);
+            if (!admitted) {
+                rejectRequest(_frontEnd, *element.msg, identity);
+            } else if (!isSign) {
+                PROBE2(request__enqueue, element.receivedNs, 0);
+            }
+
+            dispatchSignRequests(_frontEnd);
         }
 
     } catch (ExitRequestedException&) {
@@ -323,19 +909,74 @@ void ZMQServer::doOneServerLoop() {
         spdlog::error("Exception in zmq server :{}", e.what());
         spdlog::error("ID:" + string((char *) identity->data(), identity->size()));
         spdlog::error("Client request :" + msgStr);
-        sendToClient(result, identity);
+        auto replyStr = serializeReply(result);
+        sendToClient(_frontEnd, replyStr, identity);
     } catch (...) {
         checkForExit();
         spdlog::error("Error in zmq server ");
         result["errorMessage"] = "Error in zmq server ";
         spdlog::error("ID:" + string((char *) identity->data(), identity->size()));
         spdlog::error("Client request :" + msgStr);
-        sendToClient(result, identity);
+        auto replyStr = serializeReply(result);
+        sendToClient(_frontEnd, replyStr, identity);
     }
 
 
 }
 
+void ZMQServer::dispatchSignRequests(ZMQFrontEnd &_frontEnd) {
+    IncomingRequest element;
+
+    while (scheduler.getSignPending() < (int64_t) (scheduler.getActiveWorkers() * ZMQ_SIGN_DISPATCH_PER_WORKER) &&
+           _frontEnd.fairQueue.pop(element)) {
+        if (!scheduler.enqueueSign(getClientHash(*element.identity), element)) {
+            rejectRequest(_frontEnd, *element.msg, element.identity);
+        } else {
+            PROBE2(request__enqueue, element.receivedNs, 1);
+        }
+    }
+}
+
+void ZMQServer::rejectRequest(ZMQFrontEnd &_frontEnd, const string &_msg, shared_ptr <zmq::message_t> &_identity,
+                              int _status) {
+    PROBE1(request__reject, _status);
+
+    Json::Value result;
+    result["status"] = _status;
+
+    if (_status == CLIENT_RATE_LIMITED) {
+        rateLimitedRequests++;
+        result["errorMessage"] = "Client rate limit exceeded, try again later";
+    } else if (_status == KEY_STORE_READ_ONLY) {
+        result["errorMessage"] = "This sgxwallet is a cluster follower, send key store writes to the leader";
+    } else {
+        rejectedRequests++;
+        result["errorMessage"] = "Server overloaded, try again later";
+    }
+
+    uint64_t reqId = 0;
+    if (ZMQMessage::getReqId(_msg, reqId)) {
+        result["reqId"] = (Json::UInt64) reqId;
+    }
+
+    auto replyStr = serializeReply(result);
+    sendToClient(_frontEnd, replyStr, _identity);
+
+    if (TrafficRecorder::isEnabled()) {
+        TrafficRecorder::record(TRAFFIC_ZMQ, string(_msg), Tracing::nowNs(), replyStr.size());
+    }
+}
+
+// in situ parsing ends string values with a zero in place of the closing quote
+static string restoreParsedRequest(const shared_ptr<string> &_msg) {
+    if (!_msg) {
+        return "";
+    }
+    string result = *_msg;
+    replace(result.begin(), result.end(), '\0', '"');
+    return result;
+}
+
 void ZMQServer::workerThreadProcessNextMessage(uint64_t _threadNumber) {
 
 
@@ -343,11 +984,11 @@ void ZMQServer::workerThreadProcessNextMessage(uint64_t _threadNumber) {
     result["status"] = ZMQ_SERVER_ERROR;
     string msgStr;
 
-    pair <shared_ptr<ZMQMessage>, shared_ptr<zmq::message_t>> element;
+    IncomingRequest element;
+    bool isSlowLane = false;
 
     try {
-        while (!incomingQueue.at(_threadNumber)
-                .wait_dequeue_timed(element, std::chrono::milliseconds(1000))) {
+        while (!scheduler.dequeue(_threadNumber, element, isSlowLane, 1000)) {
             checkForExit();
         }
     } catch (ExitRequestedException) {
@@ -364,31 +1005,199 @@ void ZMQServer::workerThreadProcessNextMessage(uint64_t _threadNumber) {
         spdlog::error("Client request :" + msgStr);
     }
 
+    processRequest(element, isSlowLane, true, _threadNumber, result);
+}
+
+void ZMQServer::processRequest(IncomingRequest &_element, bool _isSlowLane, bool _mayStage, uint64_t _threadNumber,
+                               Json::Value &_result) {
+    uint64_t reqId = 0;
+    bool hasReqId = false;
+    string recordedRequest;
+
     try {
-        result = element.first->process();
+        CHECK_STATE(_element.msg);
+
+        PROBE2(request__dequeue, _element.receivedNs, _threadNumber);
+
+        static auto &queueWait = Metrics::getHistogram("zmqQueueWait");
+        auto dequeuedNs = Tracing::nowNs();
+        queueWait.observeUs(dequeuedNs > _element.receivedNs ? (dequeuedNs - _element.receivedNs) / 1000 : 0);
+
+        if (_element.trace.isActive()) {
+            Tracing::emitSpan(_element.trace.child(), "zmq.queue", _element.receivedNs, dequeuedNs);
+        }
+
+        TraceScope traceScope(_element.trace);
+        TRACE_SPAN("zmq.process")
+
+        // read before the request is parsed in place
+        hasReqId = ZMQMessage::getReqId(*_element.msg, reqId);
+
+        if (TrafficRecorder::isEnabled()) {
+            recordedRequest = *_element.msg;
+        }
+
+        // the client has already given up, so the request is dropped without parsing it
+        // or spending enclave time on it, and without logging under overload
+        uint64_t deadlineMs = 0;
+        if (ZMQMessage::getDeadline(*_element.msg, deadlineMs) && deadlineMs < ZMQMessage::getEpochMs()) {
+            expiredRequests++;
+            _result["status"] = ZMQ_REQUEST_EXPIRED;
+            _result["errorMessage"] = "Request deadline expired before processing";
+        } else {
+            shared_ptr<ZMQMessage> msg;
+
+            // a request processed on another thread cannot use the allocator of this one
+            bool staged = enclaveStage && !_isSlowLane && _mayStage;
+
+            {
+                // parsing includes signature and key ownership checks
+                METRICS_TIMER("zmqParse")
+                PERF_STAGE("zmqParse")
+                msg = ZMQMessage::parse(_element.msg, true, checkSignature, checkKeyOwnership, _element.curveUserId,
+                                        _element.requestTag, !staged);
+            }
+
+            CHECK_STATE2(msg, ZMQ_COULD_NOT_PARSE);
+
+            if (staged && postToEnclaveStage(_element, msg, hasReqId, reqId, recordedRequest)) {
+                return;
+            }
+
+            _result = msg->process();
+        }
     } catch (ExitRequestedException) {
         throw;
     } catch (exception &e) {
         checkForExit();
-        result["errorMessage"] = string(e.what());
-        spdlog::error("Exception in zmq server :{}", e.what());
-        spdlog::error("ID:" + string((char *) element.second->data(), element.second->size()));
-        spdlog::error("Client request :" + msgStr);
+        setRequestError(e, _element, _result);
     } catch (...) {
         checkForExit();
-        spdlog::error("Error in zmq server ");
-        result["errorMessage"] = "Error in zmq server ";
-        spdlog::error("ID:" + string((char *) element.second->data(), element.second->size()));
-        spdlog::error("Client request :" + msgStr);
+        setRequestError(_element, _result);
+    }
+
+    if (_isSlowLane) {
+        scheduler.slowLaneDone(_element);
+    }
+
+    sendReply(_element, _result, hasReqId, reqId, recordedRequest);
+}
+
+bool ZMQServer::postToCpuStage(IncomingRequest &_element) {
+    CHECK_STATE(cpuStage);
+
+    function<void()> task = [this, element = _element]() mutable {
+        Json::Value result;
+        result["status"] = ZMQ_SERVER_ERROR;
+        try {
+            processRequest(element, false, false, replyRing, result);
+        } catch (ExitRequestedException &) {
+        }
+    };
+
+    return cpuStage->post(task);
+}
+
+bool ZMQServer::postToEnclaveStage(IncomingRequest &_element, const shared_ptr<ZMQMessage> &_msg, bool _hasReqId,
+                                   uint64_t _reqId, string &_recordedRequest) {
+    CHECK_STATE(enclaveStage);
+
+    function<void()> task = [this, element = _element, msg = _msg, _hasReqId, _reqId,
+                             recordedRequest = _recordedRequest]() mutable {
+        Json::Value result;
+        result["status"] = ZMQ_SERVER_ERROR;
+
+        try {
+            TraceScope traceScope(element.trace);
+            TRACE_SPAN("zmq.enclaveStage")
+            result = msg->process();
+        } catch (exception &e) {
+            setRequestError(e, element, result);
+        } catch (...) {
+            setRequestError(element, result);
+        }
+
+        sendReply(element, result, _hasReqId, _reqId, recordedRequest);
+    };
+
+    return enclaveStage->post(task);
+}
+
+void ZMQServer::setRequestError(const exception &_e, const IncomingRequest &_element, Json::Value &_result) {
+    auto sgxException = dynamic_cast<const SGXException *>(&_e);
+    if (sgxException && sgxException->getStatus() == ZMQ_UNKNOWN_SESSION) {
+        // tells the client to start a new session and resend
+        _result["status"] = ZMQ_UNKNOWN_SESSION;
+    } else if (sgxException && sgxException->getStatus() == ZMQ_UNKNOWN_CERT) {
+        // tells the client to resend with the full cert
+        _result["status"] = ZMQ_UNKNOWN_CERT;
     }
+    _result["errorMessage"] = string(_e.what());
+    spdlog::error("Exception in zmq server :{}", _e.what());
+    spdlog::error("ID:" + string((char *) _element.identity->data(), _element.identity->size()));
+    spdlog::error("Client request :" + restoreParsedRequest(_element.msg));
+}
 
-    pair <Json::Value, shared_ptr<zmq::message_t>> fullResult(result, element.second);
+void ZMQServer::setRequestError(const IncomingRequest &_element, Json::Value &_result) {
+    spdlog::error("Error in zmq server ");
+    _result["errorMessage"] = "Error in zmq server ";
+    spdlog::error("ID:" + string((char *) _element.identity->data(), _element.identity->size()));
+    spdlog::error("Client request :" + restoreParsedRequest(_element.msg));
+}
 
-    outgoingQueue.enqueue(fullResult);
+void ZMQServer::sendReply(IncomingRequest &_element, Json::Value &_result, bool _hasReqId, uint64_t _reqId,
+                          string &_recordedRequest) {
+    // lets pipelining clients match replies that complete out of order
+    if (_hasReqId) {
+        _result["reqId"] = (Json::UInt64) _reqId;
+    }
+
+    // replies are serialized here, so the router thread only sends them
+    string replyStr;
+
+    try {
+        METRICS_TIMER("zmqSerialize")
+        PERF_STAGE("zmqSerialize")
+        replyStr = serializeReply(_result);
+    } catch (exception &e) {
+        spdlog::error("Could not serialize zmq reply :{}", e.what());
+        replyStr = "{\"status\":" + to_string(ZMQ_SERVER_ERROR) + ",\"errorMessage\":\"Could not serialize reply\"}";
+    }
+
+    if (!_recordedRequest.empty()) {
+        TrafficRecorder::record(TRAFFIC_ZMQ, move(_recordedRequest), _element.receivedNs, replyStr.size());
+    }
+
+    OutgoingReply reply{makeReplyMessage(replyStr), _element.identity, _element.trace, _element.receivedNs};
+
+    if (reply.trace.isActive()) {
+        reply.enqueuedNs = Tracing::nowNs();
+    }
+
+    CHECK_STATE(_element.frontEnd < frontEnds.size());
+    auto &frontEnd = *frontEnds[_element.frontEnd];
+
+    CHECK_STATE(replyRing >= 0 && (uint64_t) replyRing < frontEnd.replyRings.size());
+    frontEnd.replyRings[replyRing]->enqueue(move(reply));
+
+    if (_element.receivedNs > 0 && ZMQMessage::isBlsSignRequest(_element.requestTag)) {
+        auto queuedNs = Tracing::nowNs();
+        LatencySLO::getSignLatency().observeUs(
+                queuedNs > _element.receivedNs ? (queuedNs - _element.receivedNs) / 1000 : 0);
+    }
+
+    if (!frontEnd.outgoingNotified.exchange(true)) {
+        notifyOutgoingMessage(frontEnd);
+    }
 }
 
 void ZMQServer::workerThreadMessageProcessLoop(ZMQServer *_agent, uint64_t _threadNumber) {
     CHECK_STATE(_agent);
+    // before the warm up, which fills the cache replica of the node
+    Numa::bindCurrentThread(Numa::getWorkerNode(_threadNumber, numWorkerThreads, Numa::getNumNodes()),
+                            pinWorkerThreads ? (int64_t) _threadNumber : -1);
+    KeyWarmUp::warmUpThread();
+    replyRing = _threadNumber;
     _agent->waitOnGlobalStartBarrier();
     // do work forever until told to exit
     while (!isExitRequested) {
@@ -34,6 +34,10 @@
 #include "zhelpers.hpp"
 
 #include "Agent.h"
+#include "ClientRateLimiter.h"
+#include "EnclaveStage.h"
+#include "FairQueue.h"
+#include "RequestScheduler.h"
 #include "WorkerThreadPool.h"
 #include "ZMQMessage.h"
 
@@ -41,26 +45,161 @@ using namespace moodycamel;
 
 static const uint64_t NUM_ZMQ_WORKER_THREADS = 16;
 
+// max number of worker threads processing DKG and other non-sign requests at the same time,
+// DKG sessions of different poly names run in parallel up to this limit
+static const uint64_t NUM_ZMQ_SLOW_LANE_THREADS = 8;
+
+// the router loop does not spin, the timeout only bounds the time to notice an exit request
+static const long OUTGOING_POLL_TIMEOUT_MS = 100;
+
+// a reply serialized by a worker into a message that libzmq takes without a copy, and for
+// traced requests the server span and stage times
+struct OutgoingReply {
+    zmq::message_t reply;
+    shared_ptr<zmq::message_t> identity;
+    TraceContext trace;
+    uint64_t receivedNs = 0;
+    uint64_t enqueuedNs = 0;
+};
+
+
+// A ROUTER socket with its own router thread. Front end 0 listens on BASE_PORT + 5, front end
+// k > 0 on ZMQ_EXTRA_FRONT_END_BASE_PORT + k - 1. All front ends feed the same scheduler, and
+// the reply to a request is sent by the front end that received it.
+struct ZMQFrontEnd {
+    uint64_t index;
+
+    uint16_t port;
+
+    shared_ptr<zmq::socket_t> socket;
+
+    // serialized replies, one single producer ring per worker, enclave stage and CPU stage thread,
+    // which the router thread drains round robin
+    vector<unique_ptr<ReaderWriterQueue<OutgoingReply>>> replyRings;
+
+    // ring the next drain starts at, router thread only
+    uint64_t nextRing = 0;
+
+    // signalled by worker threads when a reply is put into a ring
+    int outgoingEventFd = -1;
+
+    // set by the first reply after the router took the replies, so a burst of replies
+    // writes outgoingEventFd once
+    atomic<bool> outgoingNotified{false};
+
+    // sign requests waiting for room in the scheduler, router thread only
+    FairQueue fairQueue;
+
+    // nullptr for front end 0, which runs on serverThread
+    shared_ptr<std::thread> routerThread;
+
+    ZMQFrontEnd(uint64_t _index, zmq::context_t &_ctx, uint64_t _numReplyRings);
+
+    uint64_t getOutgoingQueueDepth() const;
+
+    ~ZMQFrontEnd();
+};
 
 class ZMQServer : public Agent{
 
-    uint64_t workerThreads;
+    static uint64_t numWorkerThreads;
+
+    // lower bound of the autoscaled pool, 0 if the pool has a fixed size
+    static uint64_t minWorkerThreads;
+
+    static bool pinWorkerThreads;
+
+    static uint64_t numIOThreads;
+
+    static uint64_t numFrontEnds;
+
+    static bool curveEnabled;
+
+    static bool ipcEnabled;
+
+    static string curvePublicKey;
+
+    string curveSecretKey;
+
+    // answers ZAP requests of CurveZMQ handshakes, see zapHandlerLoop
+    shared_ptr<zmq::socket_t> zapSocket;
+
+    shared_ptr<std::thread> zapThread;
+
+    void loadOrCreateCurveKeys();
+
+    void zapHandlerLoop();
 
     string caCertFile;
     string caCert;
 
-    ConcurrentQueue<pair<Json::Value, shared_ptr<zmq::message_t>>> outgoingQueue;
+    void notifyOutgoingMessage(ZMQFrontEnd &_frontEnd);
+
+    RequestScheduler scheduler;
+
+    // nullptr if rate limiting is disabled
+    unique_ptr<ClientRateLimiter> rateLimiter;
+
+    // nullptr unless enclave stage threads are set, see EnclaveStage.h
+    unique_ptr<EnclaveStage> enclaveStage;
+
+    static uint64_t numEnclaveStageThreads;
+
+    // threads of requests computed without the enclave, see ZMQMessage::isPublicRequest
+    unique_ptr<EnclaveStage> cpuStage;
+
+    uint64_t numCpuStageThreads = 0;
+
+    // reply ring of the calling worker or stage thread, -1 on other threads
+    static thread_local int64_t replyRing;
+
+    // parses, processes and answers a dequeued request, _mayStage lets a sign request continue
+    // on the enclave stage
+    void processRequest(IncomingRequest &_element, bool _isSlowLane, bool _mayStage, uint64_t _threadNumber,
+                        Json::Value &_result);
+
+    // processes a public request and sends its reply on the CPU stage, false if the stage is full
+    bool postToCpuStage(IncomingRequest &_element);
+
+    // processes a parsed sign request and sends its reply on the enclave stage,
+    // false if the stage is full
+    bool postToEnclaveStage(IncomingRequest &_element, const shared_ptr<ZMQMessage> &_msg, bool _hasReqId,
+                            uint64_t _reqId, string &_recordedRequest);
+
+    // the error reply of a request that failed
+    void setRequestError(const exception &_e, const IncomingRequest &_element, Json::Value &_result);
+
+    void setRequestError(const IncomingRequest &_element, Json::Value &_result);
 
-    vector<BlockingReaderWriterQueue<pair<shared_ptr<ZMQMessage>, shared_ptr<zmq::message_t>>>> incomingQueue;
+    // serializes the reply and hands it to the front end that received the request
+    void sendReply(IncomingRequest &_element, Json::Value &_result, bool _hasReqId, uint64_t _reqId,
+                   string &_recordedRequest);
+
+    // moves sign requests from the fair queue of the front end to the scheduler while it has
+    // fewer than ZMQ_SIGN_DISPATCH_PER_WORKER requests per worker
+    void dispatchSignRequests(ZMQFrontEnd &_frontEnd);
 
     bool checkKeyOwnership = true;
 
     shared_ptr<zmq::context_t> ctx;
-    shared_ptr<zmq::socket_t> socket;
+
+    vector<unique_ptr<ZMQFrontEnd>> frontEnds;
+
+    void routerLoop(ZMQFrontEnd &_frontEnd);
 
     static atomic<bool> isExitRequested;
 
-    void doOneServerLoop();
+    static atomic<uint64_t> expiredRequests;
+
+    static atomic<uint64_t> rejectedRequests;
+
+    static atomic<uint64_t> rateLimitedRequests;
+
+    // replies to a request that was not admitted, from the router thread
+    void rejectRequest(ZMQFrontEnd &_frontEnd, const string& _msg, shared_ptr<zmq::message_t>& _identity,
+                       int _status = ZMQ_SERVER_OVERLOADED);
+
+    void doOneServerLoop(ZMQFrontEnd &_frontEnd);
 
 public:
 
@@ -80,6 +219,82 @@ public:
 
     void initListenSocket();
 
+    // _numThreads == 0 means one worker thread per CPU core. With _minThreads > 0 the pool
+    // autoscales between _minThreads and _numThreads, see WorkerThreadPool.h
+    static void setWorkerThreadsConfig(uint64_t _numThreads, bool _pinThreads, uint64_t _minThreads = 0);
+
+    static uint64_t getNumWorkerThreads() { return numWorkerThreads; }
+
+    static uint64_t getMinWorkerThreads() { return minWorkerThreads; }
+
+    // workers taking requests, zero if the server is not running
+    static uint64_t getActiveWorkerThreads();
+
+    RequestScheduler &getScheduler() { return scheduler; }
+
+    // Threads that enter the enclave for sign requests parsed by the workers, 0 lets the
+    // workers process sign requests themselves. Workers and stage threads share the TCS
+    static void setEnclaveStageThreads(uint64_t _numThreads);
+
+    static uint64_t getNumEnclaveStageThreads() { return numEnclaveStageThreads; }
+
+    // sign requests waiting for an enclave stage thread
+    static uint64_t getEnclaveStageQueueDepth();
+
+    // public requests waiting for a CPU stage thread
+    static uint64_t getCpuStageQueueDepth();
+
+    // libzmq I/O threads of the context, and ROUTER front ends each with a router thread
+    static void setIOThreadsConfig(uint64_t _numIOThreads, uint64_t _numFrontEnds);
+
+    static uint64_t getNumIOThreads() { return numIOThreads; }
+
+    static uint64_t getNumFrontEnds() { return numFrontEnds; }
+
+    // requests dropped because their deadline passed before a worker picked them up
+    static uint64_t getExpiredRequests() { return expiredRequests; }
+
+    // requests rejected with ZMQ_SERVER_OVERLOADED because a queue was full
+    static uint64_t getRejectedRequests() { return rejectedRequests; }
+
+    // requests rejected with CLIENT_RATE_LIMITED, see sgxwallet -R
+    static uint64_t getRateLimitedRequests() { return rateLimitedRequests; }
+
+    // queue depth gauges, zero if the server is not running
+    static uint64_t getSignQueueDepth();
+
+    static uint64_t getSlowQueueDepth();
+
+    // sign requests waiting in the fair queue for a worker
+    static uint64_t getFairQueueDepth();
+
+    // schain partitions with waiting sign requests, summed over the front ends
+    static uint64_t getFairQueuePartitions();
+
+    // poly names with a DKG request in processing
+    static uint64_t getDKGSessions();
+
+    // depth of the home sign queue of each worker
+    static vector<uint64_t> getSignQueueDepths();
+
+    static uint64_t getOutgoingQueueDepth();
+
+    static bool isPinWorkerThreads() { return pinWorkerThreads; }
+
+    // CurveZMQ encryption of the zmq port. The server key pair is kept in SGXDATA_FOLDER,
+    // clients that registered their curve key to a cert do not sign requests
+    static void setCurveEnabled(bool _enabled) { curveEnabled = _enabled; }
+
+    static bool isCurveEnabled() { return curveEnabled; }
+
+    // also listen on ZMQ_IPC_ENDPOINT, for clients on the same host
+    static void setIpcEnabled(bool _enabled) { ipcEnabled = _enabled; }
+
+    static bool isIpcEnabled() { return ipcEnabled; }
+
+    // z85 encoded, empty until the server is started
+    static string getCurvePublicKey() { return curvePublicKey; }
+
     static void initZMQServer(bool _checkSignature, bool _checkKeyOwnership);
     static void exitZMQServer();
 
@@ -89,13 +304,26 @@ public:
 
     void checkForExit();
 
-    void waitForIncomingAndProcessOutgoingMessages();
+    void waitForIncomingAndProcessOutgoingMessages(ZMQFrontEnd &_frontEnd);
+
+    // _curveUserId is set to the client curve key if CurveZMQ is enabled
+    pair<string, shared_ptr<zmq::message_t>>  receiveMessage(ZMQFrontEnd &_frontEnd, string& _curveUserId);
+
+    static string serializeReply(const Json::Value& _result);
+
+    // cheap sticky hash of a ROUTER identity, used to keep a client on the same sign worker
+    static uint64_t getClientHash(const zmq::message_t& _identity);
+
+    // the client for rate limiting and fair queuing, the CurveZMQ key, which is registered to
+    // a cert, or the ROUTER identity if CurveZMQ is disabled
+    static string getClientId(const string& _curveUserId, const zmq::message_t& _identity);
 
-    pair<string, shared_ptr<zmq::message_t>>  receiveMessage();
+    // takes the buffer of _replyStr
+    void sendToClient(ZMQFrontEnd &_frontEnd, string& _replyStr,  shared_ptr<zmq::message_t>& _identity);
 
-    void sendToClient(Json::Value& _result,  shared_ptr<zmq::message_t>& _identity);
+    void sendToClient(ZMQFrontEnd &_frontEnd, zmq::message_t& _reply,  shared_ptr<zmq::message_t>& _identity);
 
-    void sendMessagesInOutgoingMessageQueueIfAny();
+    void sendMessagesInOutgoingMessageQueueIfAny(ZMQFrontEnd &_frontEnd);
 
 };
 
@@ -0,0 +1,96 @@
+/*
+    Copyright (C) 2021-Present SKALE Labs
+
+    This file is part of sgxwallet.
+
+    sgxwallet is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as published
+    by the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    sgxwallet is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with sgxwallet. If not, see <https://www.gnu.org/licenses/>.
+
+    @file ZMQSessionCache.cpp
+    @author Stan Kladko
+    @date 2021
+*/
+
+#include <algorithm>
+#include <ctime>
+
+#include <openssl/rand.h>
+
+#include "sgxwallet_common.h"
+#include "common.h"
+#include "CryptoTools.h"
+
+#include "ZMQSessionCache.h"
+
+ZMQSessionCache::ZMQSessionCache(uint64_t _maxSize, uint64_t _ttlSeconds) : maxSize(_maxSize),
+                                                                              ttlSeconds(_ttlSeconds) {
+    CHECK_STATE(_maxSize > 0);
+    CHECK_STATE(_ttlSeconds > 0);
+}
+
+string ZMQSessionCache::create(const shared_ptr<string> &_cert, int64_t _certNotAfter, string &_key) {
+    CHECK_STATE(_cert);
+    CHECK_STATE(_certNotAfter > time(nullptr));
+
+    unsigned char id[ZMQ_SESSION_ID_BYTES];
+    unsigned char key[ZMQ_SESSION_KEY_BYTES];
+
+    CHECK_STATE(RAND_bytes(id, sizeof(id)) == 1);
+    CHECK_STATE(RAND_bytes(key, sizeof(key)) == 1);
+
+    string sessionId(carray2Hex(id, sizeof(id)).data());
+
+    auto session = make_shared<Session>();
+    session->key = string((char *) key, sizeof(key));
+    session->cert = _cert;
+    session->expiresAt = min<uint64_t>(time(nullptr) + ttlSeconds, _certNotAfter);
+
+    {
+        unique_lock<shared_timed_mutex> lock(m);
+
+        // sessions are evicted in creation order
+        while (sessions.size() >= maxSize && !insertionOrder.empty()) {
+            sessions.erase(insertionOrder.front());
+            insertionOrder.pop_front();
+        }
+
+        sessions[sessionId] = session;
+        insertionOrder.push_back(sessionId);
+    }
+
+    _key = session->key;
+
+    return sessionId;
+}
+
+shared_ptr<ZMQSessionCache::Session> ZMQSessionCache::get(const string &_sessionId) const {
+    shared_lock<shared_timed_mutex> lock(m);
+
+    auto it = sessions.find(_sessionId);
+    if (it == sessions.end() || it->second->expiresAt < (uint64_t) time(nullptr)) {
+        return nullptr;
+    }
+
+    return it->second;
+}
+
+uint64_t ZMQSessionCache::size() const {
+    shared_lock<shared_timed_mutex> lock(m);
+    return sessions.size();
+}
+
+void ZMQSessionCache::clear() {
+    unique_lock<shared_timed_mutex> lock(m);
+    sessions.clear();
+    insertionOrder.clear();
+}
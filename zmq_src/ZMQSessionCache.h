@@ -0,0 +1,74 @@
+/*
+    Copyright (C) 2021-Present SKALE Labs
+
+    This file is part of sgxwallet.
+
+    sgxwallet is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as published
+    by the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    sgxwallet is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with sgxwallet. If not, see <https://www.gnu.org/licenses/>.
+
+    @file ZMQSessionCache.h
+    @author Stan Kladko
+    @date 2021
+*/
+
+#pragma once
+
+#include <deque>
+#include <memory>
+#include <shared_mutex>
+#include <string>
+#include <unordered_map>
+
+using namespace std;
+
+// Authenticated ZMQ sessions. A client proves its cert once with a signed
+// startSessionReq and then authenticates requests with an HMAC under the
+// session key, so the cert and RSA signature are not sent with every request.
+class ZMQSessionCache {
+
+public:
+
+    struct Session {
+        string key;
+        shared_ptr<string> cert;
+        uint64_t expiresAt = 0;
+    };
+
+    ZMQSessionCache(uint64_t _maxSize, uint64_t _ttlSeconds);
+
+    // creates a session for a verified cert and returns its id, the raw session key is written to _key.
+    // The session never outlives the cert, _certNotAfter is in seconds since the epoch
+    string create(const shared_ptr<string> &_cert, int64_t _certNotAfter, string &_key);
+
+    // returns nullptr if the session does not exist or has expired
+    shared_ptr<Session> get(const string &_sessionId) const;
+
+    uint64_t getTTLSeconds() const { return ttlSeconds; }
+
+    uint64_t size() const;
+
+    // drops all sessions, called when the CRL changes so revoked certs have to start over
+    void clear();
+
+private:
+
+    mutable shared_timed_mutex m;
+
+    unordered_map<string, shared_ptr<Session>> sessions;
+
+    deque<string> insertionOrder;
+
+    const uint64_t maxSize;
+
+    const uint64_t ttlSeconds;
+};